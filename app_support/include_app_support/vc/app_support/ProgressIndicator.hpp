@@ -2,15 +2,40 @@
 
 /** @file */
 
+#include <array>
+#include <cstdio>
 #include <iterator>
 #include <memory>
+#include <string>
 
 #include <indicators/cursor_control.hpp>
 #include <indicators/progress_bar.hpp>
 
+#include "vc/core/util/ProgressCounter.hpp"
+
 namespace volcart
 {
 
+/**
+ * Format a throughput in items per second, e.g. "12.3k it/s"
+ *
+ * @ingroup Support
+ */
+inline auto FormatRate(double rate) -> std::string
+{
+    const char* suffix = "";
+    if (rate >= 1e6) {
+        rate /= 1e6;
+        suffix = "M";
+    } else if (rate >= 1e3) {
+        rate /= 1e3;
+        suffix = "k";
+    }
+    std::array<char, 32> buf{};
+    std::snprintf(buf.data(), buf.size(), "%.1f%s it/s", rate, suffix);
+    return buf.data();
+}
+
 /**
  * Make a new ProgressBar with project defined default formatting
  *
@@ -275,10 +300,19 @@ inline auto ReportProgress(
     if (useColors) {
         progressBar->set_option(ForegroundColor{indicators::Color::yellow});
     }
-    // Connect to progress updates
-    p.progressUpdated.connect([progressBar, iters, showIters](auto p) {
+    // Restart the throughput measurement when the algorithm starts
+    auto counter = std::make_shared<ProgressCounter>(iters);
+    p.progressStarted.connect([counter, iters]() { counter->reset(iters); });
+    // Connect to progress updates. Redrawing the bar is much more expensive
+    // than the update, so only redraw it periodically.
+    p.progressUpdated.connect([progressBar, counter, iters, showIters](auto p) {
+        counter->set(p);
+        if (not counter->shouldReport()) {
+            return;
+        }
         if (showIters) {
-            auto post = std::to_string(p) + "/" + std::to_string(iters);
+            auto post = std::to_string(p) + "/" + std::to_string(iters) +
+                        " (" + FormatRate(counter->rate()) + ")";
             progressBar->set_option(PostfixText{post});
         }
         progressBar->set_progress(p);
@@ -0,0 +1,193 @@
+#pragma once
+
+/** @file */
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+#include <opencv2/core.hpp>
+
+#include "vc/core/types/Volume.hpp"
+#include "vc/core/types/VolumePkg.hpp"
+
+namespace volcart
+{
+
+/**
+ * @brief Predicted memory use of one stage of a job
+ *
+ * @ingroup Support
+ */
+struct StageEstimate {
+    /** Stage name */
+    std::string name;
+    /** Bytes allocated by the stage which are held until the job finishes */
+    std::uint64_t retainedBytes{0};
+    /** Bytes allocated by the stage which are released when it finishes */
+    std::uint64_t scratchBytes{0};
+    /** Whether the stage reads the volume and fills the slice cache */
+    bool readsVolume{false};
+    /**
+     * Predicted memory in use while the stage runs, including the retained
+     * bytes of every earlier stage and the slice cache. Set by
+     * ResourceEstimator::compute().
+     */
+    std::uint64_t peakBytes{0};
+};
+
+/**
+ * @brief Memory scale factor learned from the profiles of past jobs
+ *
+ * @ingroup Support
+ */
+struct ResourceCalibration {
+    /** Ratio of measured to predicted peak memory */
+    double factor{1};
+    /** Number of past jobs the factor was learned from. 0 if uncalibrated. */
+    std::size_t runs{0};
+};
+
+/**
+ * @brief Predicted resources of a job
+ *
+ * @ingroup Support
+ */
+struct ResourceEstimate {
+    /** Job name */
+    std::string name;
+    /** Stages in execution order */
+    std::vector<StageEstimate> stages;
+    /** Predicted peak memory of the job, including the slice cache */
+    std::uint64_t peakBytes{0};
+    /** Predicted size of the slice cache once the job has read its data */
+    std::uint64_t cacheBytes{0};
+    /** Number of slices which intersect the region read from the volume */
+    std::size_t slicesTouched{0};
+    /** Number of blocks or chunks read. 0 for Volume::Format::Slices. */
+    std::size_t blocksTouched{0};
+    /** Decoded size of the slices or blocks which are read */
+    std::uint64_t decodedBytes{0};
+    /** On-disk size of the slices or blocks which are read */
+    std::uint64_t readBytes{0};
+    /**
+     * Whether the decoded data does not fit in the slice cache, in which
+     * case some of it may be read more than once
+     */
+    bool exceedsCache{false};
+    /** Calibration applied to the memory predictions */
+    ResourceCalibration calibration;
+
+    /** @brief Get the estimate as JSON */
+    [[nodiscard]] auto metadata() const -> nlohmann::json;
+
+    /** @brief Get a human-readable table of the estimate */
+    [[nodiscard]] auto summary() const -> std::string;
+};
+
+/**
+ * @brief Predicts the peak memory and volume reads of a job before it runs
+ *
+ * Schedulers need to know how much memory a job will use before starting
+ * it. This class combines the memory of each stage of a job, as predicted by
+ * the application from its inputs and options, with the region of the volume
+ * which the job reads. Stages run one after another: the retained bytes of a
+ * stage stay allocated until the job finishes, while its scratch bytes are
+ * only used while the stage runs. Once a stage reads the volume, the slice
+ * cache holds every decoded slice or block of the region, up to the cache
+ * capacity.
+ *
+ * The per-element sizes used to predict stage memory are approximations.
+ * Past jobs which recorded both their estimate and their measured memory
+ * (see RenderCalibration()) provide a factor which scales the predictions to
+ * the memory actually used on this system.
+ *
+ * @ingroup Support
+ */
+class ResourceEstimator
+{
+public:
+    /** Bytes per vertex of an ITKMesh, including its normal */
+    static constexpr std::uint64_t MESH_VERTEX_BYTES{64};
+    /** Bytes per face of an ITKMesh */
+    static constexpr std::uint64_t MESH_FACE_BYTES{112};
+    /**
+     * Bytes per pixel of a PerPixelMap: six doubles, the mask, the cell map,
+     * and the barycentric map
+     */
+    static constexpr std::uint64_t PPM_PIXEL_BYTES{77};
+    /** Maximum number of files which are measured to estimate the I/O */
+    static constexpr std::size_t MAX_MEASURED_FILES{65536};
+
+    /** @brief Set the volume which the job reads */
+    void setVolume(Volume::Pointer volume);
+
+    /**
+     * @brief Set the capacity of the slice cache in bytes
+     *
+     * If 0 (default), the cache is assumed to hold every slice which is read.
+     */
+    void setCacheBytes(std::size_t bytes);
+
+    /**
+     * @brief Set the bounding box of the voxels which the job reads
+     *
+     * The region is clipped to the volume. Format::Slices volumes always read
+     * whole slices.
+     */
+    void setRegion(const cv::Vec3d& min, const cv::Vec3d& max);
+
+    /** @brief Set the memory calibration */
+    void setCalibration(const ResourceCalibration& c);
+
+    /** @brief Append a stage */
+    void addStage(
+        std::string name,
+        std::uint64_t retainedBytes,
+        std::uint64_t scratchBytes = 0,
+        bool readsVolume = false);
+
+    /** @brief Compute the estimate */
+    [[nodiscard]] auto compute() const -> ResourceEstimate;
+
+    /** @brief Predicted size of an ITKMesh */
+    static auto MeshBytes(std::size_t vertices, std::size_t faces)
+        -> std::uint64_t;
+
+    /** @brief Predicted size of a PerPixelMap */
+    static auto PPMBytes(std::size_t height, std::size_t width)
+        -> std::uint64_t;
+
+private:
+    /** Volume */
+    Volume::Pointer volume_;
+    /** Slice cache capacity. 0 for unbounded. */
+    std::size_t cacheBytes_{0};
+    /** Whether a region is set */
+    bool hasRegion_{false};
+    /** Region minimum */
+    cv::Vec3d min_;
+    /** Region maximum */
+    cv::Vec3d max_;
+    /** Memory calibration */
+    ResourceCalibration calibration_;
+    /** Stages */
+    std::vector<StageEstimate> stages_;
+};
+
+/**
+ * @brief Learn a memory calibration from the renders in a VolumePkg
+ *
+ * Uses every Render whose profile recorded both an estimate (see
+ * ResourceEstimate::metadata()) and the per-node memory of a
+ * GraphProfiler. The measured peak memory of a render is the total growth of
+ * the peak resident set size over its nodes. The factor is the median ratio
+ * of measured to uncalibrated predicted peak memory, clamped to [0.25, 4].
+ *
+ * @ingroup Support
+ */
+auto RenderCalibration(VolumePkg& vpkg) -> ResourceCalibration;
+
+}  // namespace volcart
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <map>
+
 #include <QMutex>
 #include <QThread>
 #include <QWaitCondition>
@@ -9,6 +11,19 @@
 namespace volcart::gui
 {
 
+/**
+ * @brief Loads 8-bit display copies of volume slices in the background
+ *
+ * fetchSlice() requests a slice, which is emitted with fetchedSlice() once it
+ * has been loaded and quantized. While idle, the thread prefetches the slices
+ * ahead of the requested slice in the direction of the last slice change,
+ * and a few slices behind it, into a small cache of quantized slices. Stepping
+ * through the volume is then served from the cache. A new request interrupts
+ * prefetching.
+ *
+ * Emitted images may be shared with the cache and must not be modified in
+ * place.
+ */
 class FetchSliceThread : public QThread
 {
     // clang-format off
@@ -16,12 +31,24 @@ class FetchSliceThread : public QThread
     // clang-format on
 
 public:
+    /** Default number of slices prefetched in the scroll direction */
+    static constexpr int DEFAULT_PREFETCH_AHEAD{8};
+    /** Default number of slices prefetched against the scroll direction */
+    static constexpr int DEFAULT_PREFETCH_BEHIND{2};
+
     explicit FetchSliceThread(
         volcart::Volume::Pointer volume, QObject* parent = nullptr);
     ~FetchSliceThread() override;
 
     void fetchSlice(int sliceIdx);
 
+    /**
+     * @brief Set the number of slices to prefetch around the requested slice
+     *
+     * Set both to 0 to disable prefetching.
+     */
+    void setPrefetchCount(int ahead, int behind);
+
 signals:
     void fetchedSlice(const cv::Mat& mat);
 
@@ -29,11 +56,24 @@ protected:
     void run() override;
 
 private:
+    /** Get a quantized slice from the cache, loading it if needed */
+    auto get_slice_(int sliceIdx) -> cv::Mat;
+    /** Drop cached slices outside of the prefetch window */
+    void trim_cache_(int sliceIdx, int direction, int ahead, int behind);
+    /** Whether a new request or abort is pending */
+    auto interrupted_() -> bool;
+
     QMutex mutex_;
     QWaitCondition condition_;
     bool restart_ = false;
     bool abort_ = false;
     volcart::Volume::Pointer volume_;
-    int sliceIdx_;
+    int sliceIdx_ = 0;
+    /** Direction of the last slice change: 1 or -1 */
+    int direction_ = 1;
+    int prefetchAhead_ = DEFAULT_PREFETCH_AHEAD;
+    int prefetchBehind_ = DEFAULT_PREFETCH_BEHIND;
+    /** Quantized slices. Only accessed by the thread. */
+    std::map<int, cv::Mat> cache_;
 };
-}  // namespace volcart::gui
\ No newline at end of file
+}  // namespace volcart::gui
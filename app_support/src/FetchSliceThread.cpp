@@ -1,5 +1,8 @@
 #include "vc/gui_support/FetchSliceThread.hpp"
 
+#include <algorithm>
+#include <vector>
+
 #include "vc/core/util/ImageConversion.hpp"
 
 namespace vcg = volcart::gui;
@@ -23,6 +26,9 @@ void vcg::FetchSliceThread::fetchSlice(int sliceIdx)
 {
     QMutexLocker locker(&mutex_);
 
+    if (sliceIdx != sliceIdx_) {
+        direction_ = (sliceIdx > sliceIdx_) ? 1 : -1;
+    }
     sliceIdx_ = sliceIdx;
 
     if (!isRunning()) {
@@ -33,29 +39,91 @@ void vcg::FetchSliceThread::fetchSlice(int sliceIdx)
     }
 }
 
+void vcg::FetchSliceThread::setPrefetchCount(int ahead, int behind)
+{
+    QMutexLocker locker(&mutex_);
+    prefetchAhead_ = std::max(ahead, 0);
+    prefetchBehind_ = std::max(behind, 0);
+}
+
 void vcg::FetchSliceThread::run()
 {
     forever
     {
+        mutex_.lock();
         if (abort_) {
+            mutex_.unlock();
             return;
         }
-
-        mutex_.lock();
         const int sliceIdx = sliceIdx_;
+        const int direction = direction_;
+        const int ahead = prefetchAhead_;
+        const int behind = prefetchBehind_;
+        restart_ = false;
         mutex_.unlock();
 
-        if (!restart_) {
-            const auto slice = volume_->getSliceDataCopy(sliceIdx);
-            auto src = volcart::QuantizeImage(slice, CV_8U, false);
-            emit fetchedSlice(src);
+        // Requested slice
+        emit fetchedSlice(get_slice_(sliceIdx));
+        trim_cache_(sliceIdx, direction, ahead, behind);
+
+        // Prefetch the nearest slices first, alternating between the scroll
+        // direction and the opposite direction
+        std::vector<int> prefetch;
+        for (int i = 1; i <= std::max(ahead, behind); i++) {
+            if (i <= ahead) {
+                prefetch.push_back(sliceIdx + i * direction);
+            }
+            if (i <= behind) {
+                prefetch.push_back(sliceIdx - i * direction);
+            }
+        }
+        for (auto idx : prefetch) {
+            if (interrupted_()) {
+                break;
+            }
+            if (idx >= 0 && idx < volume_->numSlices()) {
+                get_slice_(idx);
+            }
         }
 
         mutex_.lock();
-        if (!restart_) {
+        if (!restart_ && !abort_) {
             condition_.wait(&mutex_);
         }
-        restart_ = false;
         mutex_.unlock();
     }
 }
+
+auto vcg::FetchSliceThread::get_slice_(int sliceIdx) -> cv::Mat
+{
+    auto it = cache_.find(sliceIdx);
+    if (it != cache_.end()) {
+        return it->second;
+    }
+    // QuantizeImage() copies the slice when converting it, and displayed
+    // slices are never modified, so the cached slice doesn't need a copy
+    const auto slice = volume_->getSliceView(sliceIdx);
+    auto quantized = volcart::QuantizeImage(slice, CV_8U, false);
+    cache_[sliceIdx] = quantized;
+    return quantized;
+}
+
+void vcg::FetchSliceThread::trim_cache_(
+    int sliceIdx, int direction, int ahead, int behind)
+{
+    const auto low = sliceIdx - ((direction > 0) ? behind : ahead);
+    const auto high = sliceIdx + ((direction > 0) ? ahead : behind);
+    for (auto it = cache_.begin(); it != cache_.end();) {
+        if (it->first < low || it->first > high) {
+            it = cache_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+auto vcg::FetchSliceThread::interrupted_() -> bool
+{
+    QMutexLocker locker(&mutex_);
+    return restart_ || abort_;
+}
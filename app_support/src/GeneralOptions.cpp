@@ -13,6 +13,9 @@ auto GetGeneralOpts() -> po::options_description
             "Default: 50% of the total system memory.")
         ("progress", po::value<bool>()->default_value(true),
             "When enabled, show algorithm progress bars.")
+        ("threads", po::value<std::size_t>()->default_value(0), "Number of "
+            "worker threads shared by all parallel algorithms. If 0, uses one "
+            "thread per CPU core.")
         ("log-level", po::value<std::string>()->default_value("info"),
          "Options: off, critical, error, warn, info, debug");
     // clang-format on
@@ -0,0 +1,310 @@
+#include "vc/app_support/ResourceEstimate.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <iomanip>
+#include <sstream>
+#include <utility>
+
+#include "vc/core/filesystem.hpp"
+#include "vc/core/util/Logging.hpp"
+
+using namespace volcart;
+namespace fs = volcart::filesystem;
+
+namespace
+{
+// Bounds of the calibration factor
+constexpr double MIN_CALIBRATION{0.25};
+constexpr double MAX_CALIBRATION{4};
+
+auto ToMB(std::uint64_t bytes) -> double
+{
+    return static_cast<double>(bytes) / (1024. * 1024.);
+}
+
+auto VoxelBytes(Volume::VoxelType t) -> std::uint64_t
+{
+    switch (t) {
+        case Volume::VoxelType::UInt8:
+            return 1;
+        case Volume::VoxelType::UInt16:
+            return 2;
+        case Volume::VoxelType::Float32:
+            return 4;
+    }
+    return 2;
+}
+
+// Total on-disk size of n files. If there are too many files to measure,
+// measures an evenly spaced sample and scales its size. Missing files are
+// empty.
+auto FileBytes(
+    std::size_t n,
+    const std::function<fs::path(std::size_t)>& path) -> std::uint64_t
+{
+    auto stride = std::max<std::size_t>(
+        1, (n + ResourceEstimator::MAX_MEASURED_FILES - 1) /
+               ResourceEstimator::MAX_MEASURED_FILES);
+    std::uint64_t bytes{0};
+    std::size_t measured{0};
+    for (std::size_t i = 0; i < n; i += stride) {
+        auto p = path(i);
+        if (fs::exists(p)) {
+            bytes += fs::file_size(p);
+        }
+        measured++;
+    }
+    if (measured == 0) {
+        return 0;
+    }
+    return static_cast<std::uint64_t>(
+        static_cast<double>(bytes) * static_cast<double>(n) /
+        static_cast<double>(measured));
+}
+}  // namespace
+
+auto ResourceEstimate::metadata() const -> nlohmann::json
+{
+    auto stagesMeta = nlohmann::json::array();
+    for (const auto& s : stages) {
+        stagesMeta.push_back(
+            {{"stage", s.name},
+             {"retainedBytes", s.retainedBytes},
+             {"scratchBytes", s.scratchBytes},
+             {"readsVolume", s.readsVolume},
+             {"peakBytes", s.peakBytes}});
+    }
+    return {
+        {"name", name},
+        {"stages", stagesMeta},
+        {"peakBytes", peakBytes},
+        {"cacheBytes", cacheBytes},
+        {"slicesTouched", slicesTouched},
+        {"blocksTouched", blocksTouched},
+        {"decodedBytes", decodedBytes},
+        {"readBytes", readBytes},
+        {"exceedsCache", exceedsCache},
+        {"calibration",
+         {{"factor", calibration.factor}, {"runs", calibration.runs}}}};
+}
+
+auto ResourceEstimate::summary() const -> std::string
+{
+    std::size_t width{5};
+    for (const auto& s : stages) {
+        width = std::max(width, s.name.size());
+    }
+
+    std::stringstream ss;
+    ss << std::fixed << std::setprecision(1) << std::left;
+    ss << std::setw(width) << "Stage" << std::right << std::setw(16)
+       << "Retained (MB)" << std::setw(15) << "Scratch (MB)" << std::setw(12)
+       << "Peak (MB)" << "\n";
+    for (const auto& s : stages) {
+        ss << std::left << std::setw(width) << s.name << std::right
+           << std::setw(16) << ToMB(s.retainedBytes) << std::setw(15)
+           << ToMB(s.scratchBytes) << std::setw(12) << ToMB(s.peakBytes)
+           << "\n";
+    }
+
+    ss << "Peak memory: " << ToMB(peakBytes) << " MB (";
+    if (calibration.runs > 0) {
+        ss << std::setprecision(2) << "calibrated by " << calibration.factor
+           << " from " << calibration.runs << " past runs";
+    } else {
+        ss << "uncalibrated";
+    }
+    ss << ")\n" << std::setprecision(1);
+    ss << "Slice cache: " << ToMB(cacheBytes) << " MB\n";
+    ss << "Volume reads: " << slicesTouched << " slices";
+    if (blocksTouched > 0) {
+        ss << ", " << blocksTouched << " blocks";
+    }
+    ss << ", " << ToMB(decodedBytes) << " MB decoded, " << ToMB(readBytes)
+       << " MB on disk";
+    if (exceedsCache) {
+        ss << "\nThe data read exceeds the slice cache. Some slices may be "
+              "read more than once.";
+    }
+    return ss.str();
+}
+
+void ResourceEstimator::setVolume(Volume::Pointer volume)
+{
+    volume_ = std::move(volume);
+}
+
+void ResourceEstimator::setCacheBytes(std::size_t bytes)
+{
+    cacheBytes_ = bytes;
+}
+
+void ResourceEstimator::setRegion(const cv::Vec3d& min, const cv::Vec3d& max)
+{
+    min_ = min;
+    max_ = max;
+    hasRegion_ = true;
+}
+
+void ResourceEstimator::setCalibration(const ResourceCalibration& c)
+{
+    calibration_ = c;
+}
+
+void ResourceEstimator::addStage(
+    std::string name,
+    std::uint64_t retainedBytes,
+    std::uint64_t scratchBytes,
+    bool readsVolume)
+{
+    StageEstimate s;
+    s.name = std::move(name);
+    s.retainedBytes = retainedBytes;
+    s.scratchBytes = scratchBytes;
+    s.readsVolume = readsVolume;
+    stages_.emplace_back(std::move(s));
+}
+
+auto ResourceEstimator::compute() const -> ResourceEstimate
+{
+    ResourceEstimate est;
+    est.calibration = calibration_;
+
+    // Region of the volume which is read
+    if (volume_ and hasRegion_) {
+        const auto w = volume_->sliceWidth();
+        const auto h = volume_->sliceHeight();
+        const auto d = volume_->numSlices();
+        auto valid = w > 0 and h > 0 and d > 0 and min_[2] <= max_[2] and
+                     max_[2] >= 0 and min_[2] < d;
+        if (valid) {
+            auto clip = [](double v, int size) {
+                auto i = static_cast<int>(std::floor(v));
+                return std::clamp(i, 0, size - 1);
+            };
+            cv::Vec3i lo{clip(min_[0], w), clip(min_[1], h), clip(min_[2], d)};
+            cv::Vec3i hi{clip(max_[0], w), clip(max_[1], h), clip(max_[2], d)};
+            const auto vb = VoxelBytes(volume_->voxelType());
+            est.slicesTouched = static_cast<std::size_t>(hi[2] - lo[2] + 1);
+            if (volume_->format() == Volume::Format::Slices) {
+                est.decodedBytes = est.slicesTouched *
+                                   static_cast<std::uint64_t>(w) *
+                                   static_cast<std::uint64_t>(h) * vb;
+                est.readBytes =
+                    FileBytes(est.slicesTouched, [&](std::size_t i) {
+                        return volume_->getSlicePath(
+                            lo[2] + static_cast<int>(i));
+                    });
+            } else {
+                auto shape = volume_->blockShape();
+                cv::Vec3i first;
+                cv::Vec3i count;
+                for (int i = 0; i < 3; i++) {
+                    first[i] = lo[i] / shape[i];
+                    count[i] = hi[i] / shape[i] - first[i] + 1;
+                }
+                est.blocksTouched = static_cast<std::size_t>(count[0]) *
+                                    static_cast<std::size_t>(count[1]) *
+                                    static_cast<std::size_t>(count[2]);
+                est.decodedBytes = est.blocksTouched *
+                                   static_cast<std::uint64_t>(shape[0]) *
+                                   static_cast<std::uint64_t>(shape[1]) *
+                                   static_cast<std::uint64_t>(shape[2]) * vb;
+
+                // Zarr chunks are not stored as individual files in every
+                // store, so assume they are read uncompressed
+                if (volume_->format() == Volume::Format::Blocks) {
+                    est.readBytes =
+                        FileBytes(est.blocksTouched, [&](std::size_t i) {
+                            auto x = static_cast<int>(i) % count[0];
+                            auto y = static_cast<int>(i) / count[0] % count[1];
+                            auto z = static_cast<int>(i) / count[0] / count[1];
+                            return volume_->getBlockPath(
+                                first[0] + x, first[1] + y, first[2] + z);
+                        });
+                } else {
+                    est.readBytes = est.decodedBytes;
+                }
+            }
+
+            est.cacheBytes = est.decodedBytes;
+            if (cacheBytes_ > 0 and est.decodedBytes > cacheBytes_) {
+                est.cacheBytes = cacheBytes_;
+                est.exceedsCache = true;
+            }
+        }
+    }
+
+    // Memory in use while each stage runs
+    std::uint64_t retained{0};
+    std::uint64_t cache{0};
+    for (auto s : stages_) {
+        if (s.readsVolume) {
+            cache = est.cacheBytes;
+        }
+        retained += s.retainedBytes;
+        auto bytes = static_cast<double>(retained + s.scratchBytes + cache);
+        s.peakBytes = static_cast<std::uint64_t>(bytes * calibration_.factor);
+        est.peakBytes = std::max(est.peakBytes, s.peakBytes);
+        est.stages.emplace_back(std::move(s));
+    }
+    return est;
+}
+
+auto ResourceEstimator::MeshBytes(std::size_t vertices, std::size_t faces)
+    -> std::uint64_t
+{
+    return vertices * MESH_VERTEX_BYTES + faces * MESH_FACE_BYTES;
+}
+
+auto ResourceEstimator::PPMBytes(std::size_t height, std::size_t width)
+    -> std::uint64_t
+{
+    return static_cast<std::uint64_t>(height) * width * PPM_PIXEL_BYTES;
+}
+
+auto volcart::RenderCalibration(VolumePkg& vpkg) -> ResourceCalibration
+{
+    std::vector<double> ratios;
+    for (const auto& id : vpkg.renderIDs()) {
+        nlohmann::json profile;
+        try {
+            profile = vpkg.render(id)->profile();
+        } catch (const std::exception& e) {
+            Logger()->debug("Skipping render {}: {}", id, e.what());
+            continue;
+        }
+        if (not profile.contains("estimate") or
+            not profile.contains("nodes")) {
+            continue;
+        }
+
+        // Measured peak memory
+        std::uint64_t measured{0};
+        for (const auto& node : profile["nodes"]) {
+            measured += node.value("peakRSSDeltaBytes", std::uint64_t{0});
+        }
+
+        // Predicted peak memory, without the calibration of that render
+        const auto& est = profile["estimate"];
+        auto predicted = est.value("peakBytes", 0.0);
+        if (est.contains("calibration")) {
+            predicted /= est["calibration"].value("factor", 1.0);
+        }
+        if (measured > 0 and predicted > 0) {
+            ratios.push_back(static_cast<double>(measured) / predicted);
+        }
+    }
+
+    ResourceCalibration c;
+    if (ratios.empty()) {
+        return c;
+    }
+    auto mid = ratios.begin() + static_cast<std::ptrdiff_t>(ratios.size() / 2);
+    std::nth_element(ratios.begin(), mid, ratios.end());
+    c.factor = std::clamp(*mid, MIN_CALIBRATION, MAX_CALIBRATION);
+    c.runs = ratios.size();
+    return c;
+}
@@ -0,0 +1,141 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <string>
+
+#include <opencv2/core.hpp>
+
+#include "vc/app_support/ResourceEstimate.hpp"
+#include "vc/core/filesystem.hpp"
+#include "vc/core/types/Volume.hpp"
+
+using namespace volcart;
+namespace fs = volcart::filesystem;
+
+namespace
+{
+constexpr int WIDTH{20};
+constexpr int HEIGHT{20};
+constexpr int SLICES{40};
+
+auto TestVolume(const fs::path& volPath) -> Volume::Pointer
+{
+    fs::remove_all(volPath);
+    fs::create_directory(volPath);
+
+    auto vol = Volume::New(volPath, "ResourceEstimate", "ResourceEstimate");
+    vol->setSliceWidth(WIDTH);
+    vol->setSliceHeight(HEIGHT);
+    vol->setNumberOfSlices(SLICES);
+    vol->saveMetadata();
+    cv::RNG rng(1234);
+    for (int z = 0; z < SLICES; z++) {
+        cv::Mat slice(HEIGHT, WIDTH, CV_16UC1);
+        rng.fill(slice, cv::RNG::UNIFORM, 0, 65535);
+        vol->setSliceData(z, slice);
+    }
+    return vol;
+}
+}  // namespace
+
+TEST(ResourceEstimate, StagePeaks)
+{
+    ResourceEstimator e;
+    e.addStage("Mesh", 100, 50);
+    e.addStage("PPM", 200);
+    e.addStage("Texture", 300, 400);
+    auto est = e.compute();
+
+    ASSERT_EQ(est.stages.size(), 3U);
+    EXPECT_EQ(est.stages[0].name, "Mesh");
+    EXPECT_EQ(est.stages[0].peakBytes, 150U);
+    EXPECT_EQ(est.stages[1].peakBytes, 300U);
+    EXPECT_EQ(est.stages[2].peakBytes, 1000U);
+    EXPECT_EQ(est.peakBytes, 1000U);
+    EXPECT_EQ(est.slicesTouched, 0U);
+    EXPECT_EQ(est.cacheBytes, 0U);
+    EXPECT_FALSE(est.exceedsCache);
+}
+
+TEST(ResourceEstimate, VolumeReads)
+{
+    auto vol = TestVolume("vc_app_support_ResourceEstimate");
+    ResourceEstimator e;
+    e.setVolume(vol);
+    e.setRegion({2, 3, 5}, {10, 12, 14});
+    e.addStage("Mesh", 100);
+    e.addStage("Texture", 200, 0, true);
+    auto est = e.compute();
+
+    // Whole slices are read from Format::Slices volumes
+    constexpr std::uint64_t SLICE_BYTES{WIDTH * HEIGHT * 2};
+    EXPECT_EQ(est.slicesTouched, 10U);
+    EXPECT_EQ(est.blocksTouched, 0U);
+    EXPECT_EQ(est.decodedBytes, 10 * SLICE_BYTES);
+    EXPECT_EQ(est.cacheBytes, est.decodedBytes);
+    EXPECT_FALSE(est.exceedsCache);
+
+    std::uint64_t readBytes{0};
+    for (int z = 5; z <= 14; z++) {
+        readBytes += fs::file_size(vol->getSlicePath(z));
+    }
+    EXPECT_EQ(est.readBytes, readBytes);
+
+    // The cache is only counted once a stage reads the volume
+    EXPECT_EQ(est.stages[0].peakBytes, 100U);
+    EXPECT_EQ(est.stages[1].peakBytes, 300 + est.cacheBytes);
+    EXPECT_EQ(est.peakBytes, est.stages[1].peakBytes);
+
+    // A smaller cache bounds the cached bytes
+    e.setCacheBytes(SLICE_BYTES * 4);
+    est = e.compute();
+    EXPECT_EQ(est.cacheBytes, SLICE_BYTES * 4);
+    EXPECT_TRUE(est.exceedsCache);
+    EXPECT_EQ(est.peakBytes, 300 + SLICE_BYTES * 4);
+}
+
+TEST(ResourceEstimate, RegionIsClipped)
+{
+    auto vol = TestVolume("vc_app_support_ResourceEstimateClip");
+    ResourceEstimator e;
+    e.setVolume(vol);
+    e.setRegion({-5, -5, -10}, {100, 100, 100});
+    auto est = e.compute();
+    EXPECT_EQ(est.slicesTouched, static_cast<std::size_t>(SLICES));
+    EXPECT_EQ(est.decodedBytes, std::uint64_t{WIDTH * HEIGHT * 2 * SLICES});
+
+    // Regions outside of the volume read nothing
+    e.setRegion({0, 0, SLICES + 10}, {10, 10, SLICES + 20});
+    est = e.compute();
+    EXPECT_EQ(est.slicesTouched, 0U);
+    EXPECT_EQ(est.decodedBytes, 0U);
+    EXPECT_EQ(est.readBytes, 0U);
+}
+
+TEST(ResourceEstimate, Calibration)
+{
+    ResourceEstimator e;
+    e.addStage("Mesh", 100, 50);
+    e.setCalibration({2, 3});
+    auto est = e.compute();
+    EXPECT_EQ(est.peakBytes, 300U);
+    EXPECT_EQ(est.calibration.runs, 3U);
+
+    auto meta = est.metadata();
+    EXPECT_EQ(meta["peakBytes"].get<std::uint64_t>(), 300U);
+    EXPECT_DOUBLE_EQ(meta["calibration"]["factor"].get<double>(), 2);
+    EXPECT_EQ(meta["stages"].size(), 1U);
+    EXPECT_EQ(meta["stages"][0]["stage"].get<std::string>(), "Mesh");
+    EXPECT_NE(est.summary().find("calibrated by 2.00"), std::string::npos);
+}
+
+TEST(ResourceEstimate, ElementSizes)
+{
+    EXPECT_EQ(
+        ResourceEstimator::MeshBytes(10, 20),
+        10 * ResourceEstimator::MESH_VERTEX_BYTES +
+            20 * ResourceEstimator::MESH_FACE_BYTES);
+    EXPECT_EQ(
+        ResourceEstimator::PPMBytes(100, 200),
+        100 * 200 * ResourceEstimator::PPM_PIXEL_BYTES);
+}
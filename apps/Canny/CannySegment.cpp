@@ -2,16 +2,26 @@
 #pragma ide diagnostic ignored "readability-identifier-length"
 #pragma clang diagnostic ignored "-Wunknown-pragmas"
 #pragma ide diagnostic ignored "cppcoreguidelines-avoid-magic-numbers"
+#include <algorithm>
 #include <iostream>
+#include <limits>
+#include <mutex>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include <QApplication>
 #include <boost/program_options.hpp>
+#include <opencv2/core/ocl.hpp>
 #include <opencv2/imgcodecs.hpp>
 #include <vtkAppendPolyData.h>
+#include <vtkCellArray.h>
+#include <vtkCellArrayIterator.h>
 #include <vtkCleanPolyData.h>
 #include <vtkCutter.h>
 #include <vtkLine.h>
+#include <vtkPlane.h>
 #include <vtkPointData.h>
 #include <vtkProbeFilter.h>
 #include <vtkSmartPointer.h>
@@ -27,6 +37,7 @@
 #include "vc/core/util/ImageConversion.hpp"
 #include "vc/core/util/Iteration.hpp"
 #include "vc/core/util/String.hpp"
+#include "vc/core/util/ThreadPool.hpp"
 #include "vc/meshing/ITK2VTK.hpp"
 
 namespace fs = volcart::filesystem;
@@ -37,6 +48,280 @@ namespace vcm = volcart::meshing;
 using vc::range;
 using vc::range2D;
 
+namespace
+{
+// Intersects a mesh with z-planes to find the mesh normals in each slice
+class MeshRayCaster
+{
+public:
+    MeshRayCaster() = default;
+
+    // VTK filters are not thread-safe, so the mesh must not be shared with
+    // other casters
+    explicit MeshRayCaster(vtkSmartPointer<vtkPolyData> mesh)
+        : mesh_{std::move(mesh)},
+          plane_{vtkSmartPointer<vtkPlane>::New()},
+          cutter_{vtkSmartPointer<vtkCutter>::New()}
+    {
+        plane_->SetNormal(0, 0, 1);
+        cutter_->SetInputData(mesh_);
+        cutter_->SetCutFunction(plane_);
+    }
+
+    // Get rays from the intersection of the mesh with the plane at z. Rays
+    // start on the intersection and point along the mesh normals projected
+    // into the plane.
+    void rays(
+        int z,
+        bool invert,
+        std::vector<cv::Vec2d>& rayOrigins,
+        std::vector<cv::Vec2d>& rayBases) const
+    {
+        if (mesh_ == nullptr) {
+            throw std::logic_error("Mesh ray caster not initialized");
+        }
+
+        // update plane Z
+        plane_->SetOrigin(0, 0, static_cast<double>(z));
+        cutter_->Update();
+
+        // get cutter output
+        const vtkSmartPointer<vtkPolyData> cutterOutput = cutter_->GetOutput();
+
+        // vtk list of points
+        auto points = vtkSmartPointer<vtkPoints>::New();
+
+        // go through line segments
+        for (auto i = 0; i < cutterOutput->GetNumberOfCells(); ++i) {
+            // get cell
+            const vtkSmartPointer<vtkCell> cell = cutterOutput->GetCell(i);
+
+            // get points as cv::Vec3d
+            const cv::Vec3d p0{cell->GetPoints()->GetPoint(0)};
+            const cv::Vec3d p1{cell->GetPoints()->GetPoint(1)};
+
+            const auto length = cv::norm(p1 - p0);
+            const cv::Vec3d step = (p1 - p0) / length;
+
+            for (auto t = 0; t < static_cast<int>(length); ++t) {
+                auto p = p0 + step * t;
+                points->InsertNextPoint(p.val);
+            }
+        }
+
+        // if zero points, skip
+        if (points->GetNumberOfPoints() == 0) {
+            return;
+        }
+
+        // create polydata
+        const auto pointsPolyData = vtkSmartPointer<vtkPolyData>::New();
+        pointsPolyData->SetPoints(points);
+
+        // use probe filter
+        const auto probeFilter = vtkSmartPointer<vtkProbeFilter>::New();
+        probeFilter->SetInputData(pointsPolyData);
+        probeFilter->SetSourceData(mesh_);
+        probeFilter->Update();
+
+        // get probe output
+        const vtkSmartPointer<vtkDataSet> probeOutput =
+            probeFilter->GetOutput();
+
+        // get normal vectors
+        const vtkSmartPointer<vtkDataArray> normals =
+            probeOutput->GetPointData()->GetNormals();
+        if (normals == nullptr) {
+            throw std::runtime_error("Input mesh has no normals");
+        }
+
+        // go through points and normals
+        for (auto i = 0; i < probeOutput->GetNumberOfPoints(); ++i) {
+            // get point
+            cv::Vec3d p{probeOutput->GetPoint(i)};
+            // get normal
+            cv::Vec3d n{normals->GetTuple(i)};
+            // check if normal is all zeros
+            if (n[0] == 0 && n[1] == 0 && n[2] == 0) {
+                continue;
+            }
+            // project normal to xy plane
+            n[2] = 0;
+            // normalize
+            n = n / cv::norm(n);
+            // invert normal if needed
+            if (invert) {
+                n = -n;
+            }
+            // add point to ray origins after converting to 2d
+            rayOrigins.push_back({p[0], p[1]});
+            // add normal to ray bases after converting to 2d
+            rayBases.push_back({n[0], n[1]});
+        }
+    }
+
+private:
+    vtkSmartPointer<vtkPolyData> mesh_;
+    vtkSmartPointer<vtkPlane> plane_;
+    vtkSmartPointer<vtkCutter> cutter_;
+};
+
+// Copy the faces of a mesh which intersect the slab zMin <= z <= zMax, along
+// with their points and point data. Only reads the mesh, so it may be called
+// concurrently on the same mesh.
+auto ExtractSlab(vtkPolyData* mesh, double zMin, double zMax)
+    -> vtkSmartPointer<vtkPolyData>
+{
+    auto points = vtkSmartPointer<vtkPoints>::New();
+    auto polys = vtkSmartPointer<vtkCellArray>::New();
+    auto slab = vtkSmartPointer<vtkPolyData>::New();
+    slab->GetPointData()->CopyAllocate(mesh->GetPointData());
+
+    std::unordered_map<vtkIdType, vtkIdType> ids;
+    std::vector<vtkIdType> cell;
+    auto it = vtk::TakeSmartPointer(mesh->GetPolys()->NewIterator());
+    for (it->GoToFirstCell(); not it->IsDoneWithTraversal();
+         it->GoToNextCell()) {
+        vtkIdType n{0};
+        const vtkIdType* pts{nullptr};
+        it->GetCurrentCell(n, pts);
+
+        // Skip faces outside of the slab
+        auto lo = std::numeric_limits<double>::max();
+        auto hi = std::numeric_limits<double>::lowest();
+        for (vtkIdType i = 0; i < n; i++) {
+            double p[3];
+            mesh->GetPoint(pts[i], p);
+            lo = std::min(lo, p[2]);
+            hi = std::max(hi, p[2]);
+        }
+        if (hi < zMin or lo > zMax) {
+            continue;
+        }
+
+        cell.clear();
+        for (vtkIdType i = 0; i < n; i++) {
+            auto [id, inserted] = ids.try_emplace(pts[i], ids.size());
+            if (inserted) {
+                double p[3];
+                mesh->GetPoint(pts[i], p);
+                points->InsertNextPoint(p);
+                slab->GetPointData()->CopyData(
+                    mesh->GetPointData(), pts[i], id->second);
+            }
+            cell.push_back(id->second);
+        }
+        polys->InsertNextCell(n, cell.data());
+    }
+    slab->SetPoints(points);
+    slab->SetPolys(polys);
+    return slab;
+}
+
+// Find the surface points in the Canny edges of slice z
+auto SegmentSlice(
+    const cv::Mat& processed,
+    int z,
+    const vc::CannySettings& cannySettings,
+    const MeshRayCaster& caster) -> std::vector<cv::Vec3d>
+{
+    std::vector<cv::Vec3d> surface;
+
+    // Keep all edges
+    if (cannySettings.projectionFrom == 'N') {
+        for (const auto pt : range2D(processed.rows, processed.cols)) {
+            const auto& x = pt.second;
+            const auto& y = pt.first;
+            if (processed.at<uint8_t>(y, x) > 0) {
+                surface.emplace_back(
+                    static_cast<double>(x), static_cast<double>(y),
+                    static_cast<double>(z));
+            }
+        }
+        return surface;
+    }
+
+    // Build the set of rays that will be projected to find the edges
+    std::vector<cv::Vec2d> rayBases;
+    std::vector<cv::Vec2d> rayOrigins;
+
+    if (cannySettings.projectionFrom == 'L') {
+        for (auto y : range(processed.rows)) {
+            rayOrigins.push_back({0, static_cast<double>(y)});
+            rayBases.push_back({1, 0});
+        }
+    } else if (cannySettings.projectionFrom == 'R') {
+        for (auto y : range(processed.rows)) {
+            rayOrigins.push_back({static_cast<double>(processed.cols - 1), static_cast<double>(y)});
+            rayBases.push_back({-1, 0});
+        }
+    } else if (cannySettings.projectionFrom == 'T') {
+        for (auto x : range(processed.cols)) {
+            rayOrigins.push_back({static_cast<double>(x), 0});
+            rayBases.push_back({0, 1});
+        }
+    } else if (cannySettings.projectionFrom == 'B') {
+        for (auto x : range(processed.cols)) {
+            rayOrigins.push_back({static_cast<double>(x), static_cast<double>(processed.rows - 1)});
+            rayBases.push_back({0, -1});
+        }
+    } else if (cannySettings.projectionFrom == 'M' || cannySettings.projectionFrom == 'I') {
+        caster.rays(
+            z, cannySettings.projectionFrom == 'I', rayOrigins, rayBases);
+    }
+
+    cv::Vec3d first;
+    cv::Vec3d last;
+    for (auto r : range(rayBases.size())) {
+        const auto& rayBasis = rayBases[r];
+        const auto& rayOrigin = rayOrigins[r];
+
+        // Get the first
+        auto haveFirst = false;
+
+        auto pt = rayOrigin;
+        int xI = static_cast<int>(pt[0]);
+        int yI = static_cast<int>(pt[1]);
+        while (
+            xI >= 0
+            && xI < processed.cols
+            && yI >= 0
+            && yI < processed.rows
+        ) {
+            // if point is on detected edge
+            if (!haveFirst && processed.at<uint8_t>(yI, xI) != 0) {
+                // set first
+                first = {pt[0], pt[1], static_cast<double>(z)};
+                last = first;
+                haveFirst = true;
+                continue;
+            }
+
+            if (cannySettings.midpoint && haveFirst && processed.at<uint8_t>(yI, xI) != 0) {
+                last = {pt[0], pt[1], static_cast<double>(z)};
+            }
+
+            if (!cannySettings.midpoint && haveFirst) {
+                break;
+            }
+
+            // move point along ray
+            pt += rayBasis * 0.5;
+            xI = static_cast<int>(pt[0]);
+            yI = static_cast<int>(pt[1]);
+        }
+
+        if (!haveFirst) {
+            continue;
+        }
+
+        surface.emplace_back((first + last) / 2);
+    }
+
+    return surface;
+}
+}  // namespace
+
 auto main(int argc, char* argv[]) -> int
 {
     ///// Parse the command line options /////
@@ -48,7 +333,12 @@ auto main(int argc, char* argv[]) -> int
         ("volume", po::value<std::string>(),
            "Volume to use for segmentation. Default: First volume")
         ("output-file,o", po::value<std::string>()->required(),
-           "Output mesh path (PLY)");
+           "Output mesh path (PLY)")
+        ("threads", po::value<std::size_t>()->default_value(0),
+           "Number of slices to segment in parallel. If 0, uses one thread "
+           "per CPU core.")
+        ("opencl", "Run the Canny filters on an OpenCL device if one is "
+           "available");
 
     po::options_description segOpts("Segmentation Options");
     segOpts.add_options()
@@ -87,6 +377,8 @@ auto main(int argc, char* argv[]) -> int
         return EXIT_FAILURE;
     }
 
+    vc::ThreadPool::SetGlobalThreads(parsed["threads"].as<std::size_t>());
+
     // Canny values
     vc::CannySettings cannySettings;
 
@@ -140,6 +432,13 @@ auto main(int argc, char* argv[]) -> int
     cannySettings.zMin = 0;
     cannySettings.zMax = volume->numSlices() - 1;
 
+    // Canny runs on cv::UMat images when OpenCL is enabled
+    cv::ocl::setUseOpenCL(parsed.count("opencl") > 0);
+    if (parsed.count("opencl") > 0 and not cv::ocl::useOpenCL()) {
+        std::cerr << "WARNING: No OpenCL device available. Running Canny on "
+                     "the CPU.\n";
+    }
+
     if (parsed.count("mask") > 0) {
         cannySettings.mask =
             cv::imread(parsed["mask"].as<std::string>(), CV_8UC1);
@@ -181,12 +480,7 @@ auto main(int argc, char* argv[]) -> int
         vtkMesh = meshes[0];
     }
 
-    vtkSmartPointer<vtkCutter> cutter;
-    vtkSmartPointer<vtkPlane> plane;
     if (vtkMesh != nullptr) {
-        cutter = vtkSmartPointer<vtkCutter>::New();
-        plane = vtkSmartPointer<vtkPlane>::New();
-
         auto zMin = static_cast<int>(std::floor(vtkMesh->GetBounds()[4]));
         auto zMax = static_cast<int>(std::ceil(vtkMesh->GetBounds()[5]));
 
@@ -203,17 +497,6 @@ auto main(int argc, char* argv[]) -> int
 
         cannySettings.zMin = zMin;
         cannySettings.zMax = zMax;
-
-        plane->SetOrigin(
-            static_cast<double>(volume->sliceWidth()) / 2,
-            static_cast<double>(volume->sliceHeight()) / 2,
-            0
-        );
-        plane->SetNormal(0, 0, 1);
-
-        cutter->SetInputData(vtkMesh);
-        cutter->SetCutFunction(plane);
-        cutter->Update();
     }
     /**************************************************************************/
 
@@ -237,196 +520,62 @@ auto main(int argc, char* argv[]) -> int
         return EXIT_FAILURE;
     }
 
+    // A mesh without normals cannot seed the projection
+    if ((cannySettings.projectionFrom == 'M' ||
+         cannySettings.projectionFrom == 'I') &&
+        vtkMesh->GetPointData()->GetNormals() == nullptr) {
+        std::cerr << "Error: Input mesh has no normals\n";
+        return EXIT_FAILURE;
+    }
+
     // Segment
+    // Slices are independent, so each worker segments a contiguous range of
+    // z-indices into its own point sets. The sets are merged in z order
+    // afterward so that the output does not depend on the thread count.
     std::cout << "Segmenting surface..." << std::endl;
-    auto mesh = vc::ITKMesh::New();
-    cv::Vec3d first;
-    cv::Vec3d middle;
-    cv::Vec3d last;
     auto zMin = static_cast<int>(cannySettings.zMin);
     auto zMax = static_cast<int>(cannySettings.zMax);
-    for (const auto& z : ProgressWrap(range(zMin, zMax), "Slice:")) {
-        // Get the slice
-        auto slice =
-            vc::QuantizeImage(volume->getSliceDataCopy(z), CV_8UC1, false);
-
-        auto processed = vc::Canny(slice, cannySettings);
-
-        // Keep all edges
-        if (cannySettings.projectionFrom == 'N') {
-            for (const auto pt : range2D(processed.rows, processed.cols)) {
-                const auto& x = pt.second;
-                const auto& y = pt.first;
-                if (processed.at<uint8_t>(y, x) > 0) {
-                    middle = {
-                        static_cast<double>(x), static_cast<double>(y),
-                        static_cast<double>(z)};
-                    mesh->SetPoint(mesh->GetNumberOfPoints(), middle.val);
-                }
-            }
-            continue;
+    const auto numZ = static_cast<std::size_t>(zMax - zMin);
+    std::vector<std::vector<cv::Vec3d>> slicePoints(numZ);
+    auto bar = vc::NewProgressBar(numZ, "Slice:");
+    std::mutex barMutex;
+    const auto useMesh = cannySettings.projectionFrom == 'M' ||
+                         cannySettings.projectionFrom == 'I';
+    vc::ParallelChunks(numZ, 0, [&](auto begin, auto end) {
+        // VTK filters are not thread-safe, so each worker cuts its own copy
+        // of the part of the seed mesh within its slices
+        MeshRayCaster caster;
+        if (useMesh) {
+            caster = MeshRayCaster(ExtractSlab(
+                vtkMesh, zMin + static_cast<double>(begin),
+                zMin + static_cast<double>(end) - 1));
         }
 
-        // Build the set of rays that will be projected to find the edges
-        std::vector<cv::Vec2d> rayBases;
-        std::vector<cv::Vec2d> rayOrigins;
-
-        if (cannySettings.projectionFrom == 'L') {
-            for (auto y : range(processed.rows)) {
-                rayOrigins.push_back({0, static_cast<double>(y)});
-                rayBases.push_back({1, 0});
-            }
-        } else if (cannySettings.projectionFrom == 'R') {
-            for (auto y : range(processed.rows)) {
-                rayOrigins.push_back({static_cast<double>(processed.cols - 1), static_cast<double>(y)});
-                rayBases.push_back({-1, 0});
-            }
-        } else if (cannySettings.projectionFrom == 'T') {
-            for (auto x : range(processed.cols)) {
-                rayOrigins.push_back({static_cast<double>(x), 0});
-                rayBases.push_back({0, 1});
-            }
-        } else if (cannySettings.projectionFrom == 'B') {
-            for (auto x : range(processed.cols)) {
-                rayOrigins.push_back({static_cast<double>(x), static_cast<double>(processed.rows - 1)});
-                rayBases.push_back({0, -1});
-            }
-        } else if (cannySettings.projectionFrom == 'M' || cannySettings.projectionFrom == 'I') {
-            if (plane == nullptr || cutter == nullptr) {
-                std::cerr << "Error: Projection from mesh requested but mesh "
-                             "cutter not initialized\n";
-                return EXIT_FAILURE;
-            }
-            // update plane Z
-            plane->SetOrigin(0, 0, static_cast<double>(z));
-            cutter->Update();
-
-            // get cutter output
-            const vtkSmartPointer<vtkPolyData> cutterOutput =
-                cutter->GetOutput();
-
-            // vtk list of points
-            auto points = vtkSmartPointer<vtkPoints>::New();
-
-            // go through line segments
-            for (auto i = 0; i < cutterOutput->GetNumberOfCells(); ++i) {
-                // get cell
-                const vtkSmartPointer<vtkCell> cell = cutterOutput->GetCell(i);
-
-                // get points as cv::Vec3d
-                const cv::Vec3d p0{cell->GetPoints()->GetPoint(0)};
-                const cv::Vec3d p1{cell->GetPoints()->GetPoint(1)};
-
-                const auto length = cv::norm(p1 - p0);
-                const cv::Vec3d step = (p1 - p0) / length;
-
-                for (auto t = 0; t < static_cast<int>(length); ++t) {
-                    auto p = p0 + step * t;
-                    points->InsertNextPoint(p.val);
-                }
-            }
-
-            // if zero points, skip
-            if (points->GetNumberOfPoints() == 0) {
-                continue;
+        for (auto i = begin; i < end; i++) {
+            const auto z = zMin + static_cast<int>(i);
+            auto slice =
+                vc::QuantizeImage(volume->getSliceView(z), CV_8UC1, false);
+            cv::Mat processed;
+            if (cv::ocl::useOpenCL()) {
+                vc::Canny(slice.getUMat(cv::ACCESS_READ), cannySettings)
+                    .copyTo(processed);
+            } else {
+                processed = vc::Canny(slice, cannySettings);
             }
+            slicePoints[i] = SegmentSlice(processed, z, cannySettings, caster);
 
-            // create polydata
-            const auto pointsPolyData = vtkSmartPointer<vtkPolyData>::New();
-            pointsPolyData->SetPoints(points);
-
-            // use probe filter
-            const auto probeFilter = vtkSmartPointer<vtkProbeFilter>::New();
-            probeFilter->SetInputData(pointsPolyData);
-            probeFilter->SetSourceData(vtkMesh);
-            probeFilter->Update();
-
-            // get probe output
-            const vtkSmartPointer<vtkDataSet> probeOutput =
-                probeFilter->GetOutput();
-
-            // get normal vectors
-            const vtkSmartPointer<vtkDataArray> normals =
-                probeOutput->GetPointData()->GetNormals();
-
-            // check if normals exist
-            if (normals == nullptr) {
-                std::cerr << "Error: Input mesh has no normals\n";
-                return EXIT_FAILURE;
-            }
-
-            // go through points and normals
-            for (auto i = 0; i < probeOutput->GetNumberOfPoints(); ++i) {
-                // get point
-                cv::Vec3d p{probeOutput->GetPoint(i)};
-                // get normal
-                cv::Vec3d n{normals->GetTuple(i)};
-                // check if normal is all zeros
-                if (n[0] == 0 && n[1] == 0 && n[2] == 0) {
-                    continue;
-                }
-                // project normal to xy plane
-                n[2] = 0;
-                // normalize
-                n = n / cv::norm(n);
-                // invert normal if needed
-                if (cannySettings.projectionFrom == 'I') {
-                    n = -n;
-                }
-                // add point to ray origins after converting to 2d
-                rayOrigins.push_back({p[0], p[1]});
-                // add normal to ray bases after converting to 2d
-                rayBases.push_back({n[0], n[1]});
-            }
+            const std::lock_guard<std::mutex> lock(barMutex);
+            bar->tick();
         }
+    });
 
-        for (auto r : range(rayBases.size())) {
-            const auto& rayBasis = rayBases[r];
-            const auto& rayOrigin = rayOrigins[r];
-
-            // Get the first
-            auto haveFirst = false;
-
-            auto pt = rayOrigin;
-            int xI = static_cast<int>(pt[0]);
-            int yI = static_cast<int>(pt[1]);
-            while (
-                xI >= 0
-                && xI < processed.cols
-                && yI >= 0
-                && yI < processed.rows
-            ) {
-                // if point is on detected edge
-                if (!haveFirst && processed.at<uint8_t>(yI, xI) != 0) {
-                    // set first
-                    first = {pt[0], pt[1], static_cast<double>(z)};
-                    last = first;
-                    haveFirst = true;
-                    continue;
-                }
-
-                if (cannySettings.midpoint && haveFirst && processed.at<uint8_t>(yI, xI) != 0) {
-                    last = {pt[0], pt[1], static_cast<double>(z)};
-                }
-
-                if (!cannySettings.midpoint && haveFirst) {
-                    break;
-                }
-
-                // move point along ray
-                pt += rayBasis * 0.5;
-                xI = static_cast<int>(pt[0]);
-                yI = static_cast<int>(pt[1]);
-            }
-
-            if (!haveFirst) {
-                continue;
-            }
-
-            middle = (first + last) / 2;
-            mesh->SetPoint(mesh->GetNumberOfPoints(), middle.val);
+    auto mesh = vc::ITKMesh::New();
+    for (const auto& points : slicePoints) {
+        for (const auto& p : points) {
+            mesh->SetPoint(mesh->GetNumberOfPoints(), p.val);
         }
     }
+    slicePoints.clear();
 
     // Write mesh
     std::cout << "Writing mesh..." << std::endl;
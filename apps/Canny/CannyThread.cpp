@@ -1,7 +1,26 @@
 #include "CannyThread.hpp"
 
 #include <utility>
-#include <vc/core/util/ImageConversion.hpp>
+
+#include <opencv2/core/ocl.hpp>
+#include <opencv2/imgproc.hpp>
+
+namespace
+{
+// Blend the Canny edges of a grayscale image with the image
+template <class Image>
+auto EdgeOverlay(const Image& gray, const volcart::CannySettings& settings)
+    -> cv::Mat
+{
+    Image edges = volcart::Canny(gray, settings);
+    Image blend;
+    cv::addWeighted(gray, 0.5, edges, 0.5, 0, blend);
+    cv::cvtColor(blend, blend, cv::COLOR_GRAY2BGR);
+    cv::Mat result;
+    blend.copyTo(result);
+    return result;
+}
+}  // namespace
 
 CannyThread::CannyThread(QObject* parent) : QThread(parent) {}
 
@@ -19,7 +38,14 @@ void CannyThread::runCanny(cv::Mat& mat, volcart::CannySettings settings)
     QMutexLocker locker(&mutex_);
 
     if (!mat.empty()) {
-        mat_ = mat.clone();
+        // The viewer passes the same slice for every change of the settings,
+        // so only copy it when it changes. Holding a reference to the source
+        // keeps its buffer from being reused by the next slice.
+        if (mat.data != source_.data || mat.size() != source_.size()) {
+            source_ = mat;
+            mat_ = mat.clone();
+            sliceVersion_++;
+        }
         settings_ = std::move(settings);
 
         if (!isRunning()) {
@@ -41,17 +67,26 @@ void CannyThread::run()
 
         mutex_.lock();
         cv::Mat src = mat_;
+        auto version = sliceVersion_;
         volcart::CannySettings settings = settings_;
         mutex_.unlock();
 
         if (!restart_) {
-            cv::cvtColor(src, src, cv::COLOR_BGR2GRAY);
-            // Get the canny edges
-            cv::Mat dst = volcart::Canny(src, settings);
-            // Draw them on the slice
-            src = volcart::ColorConvertImage(src, dst.channels());
-            cv::addWeighted(src, 0.5, dst, 0.5, 0, dst);
-            cv::cvtColor(dst, dst, cv::COLOR_GRAY2BGR);
+            // Convert and upload each slice once
+            const auto useOpenCL = cv::ocl::useOpenCL();
+            if (version != grayVersion_ ||
+                (useOpenCL && grayDevice_.empty())) {
+                cv::cvtColor(src, gray_, cv::COLOR_BGR2GRAY);
+                grayDevice_.release();
+                if (useOpenCL) {
+                    gray_.copyTo(grayDevice_);
+                }
+                grayVersion_ = version;
+            }
+
+            // Draw the canny edges on the slice
+            cv::Mat dst = useOpenCL ? EdgeOverlay(grayDevice_, settings)
+                                    : EdgeOverlay(gray_, settings);
             // Emit that pixmap to be rendered
             emit ranCanny(dst);
         }
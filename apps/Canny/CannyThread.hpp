@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstdint>
+
 #include <QMutex>
 #include <QThread>
 #include <QWaitCondition>
@@ -32,4 +34,15 @@ private:
 
     cv::Mat mat_;
     volcart::CannySettings settings_;
+    // Slice passed to runCanny(), of which mat_ is a copy
+    cv::Mat source_;
+    // Incremented when a new slice is passed to runCanny()
+    std::uint64_t sliceVersion_{0};
+
+    // Grayscale copy of the slice, used only by run(). When OpenCL is
+    // enabled, it is uploaded to the device once per slice and reused for
+    // every change of the settings.
+    cv::Mat gray_;
+    cv::UMat grayDevice_;
+    std::uint64_t grayVersion_{0};
 };
\ No newline at end of file
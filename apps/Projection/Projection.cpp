@@ -2,9 +2,12 @@
 #pragma clang diagnostic ignored "-Wunknown-pragmas"
 #pragma ide diagnostic ignored "cppcoreguidelines-avoid-magic-numbers"
 
+#include <algorithm>
+#include <cmath>
 #include <iomanip>
 #include <iostream>
-#include <map>
+#include <mutex>
+#include <vector>
 
 #include <QApplication>
 #include <boost/program_options.hpp>
@@ -23,16 +26,27 @@
 #include "vc/core/filesystem.hpp"
 #include "vc/core/io/ImageIO.hpp"
 #include "vc/core/io/MeshIO.hpp"
+#include "vc/core/types/FlatMesh.hpp"
 #include "vc/core/types/VolumePkg.hpp"
-#include "vc/core/util/Iteration.hpp"
 #include "vc/core/util/Logging.hpp"
+#include "vc/core/util/ThreadPool.hpp"
 #include "vc/meshing/ITK2VTK.hpp"
+#include "vc/meshing/MeshSliceSweep.hpp"
 
 namespace po = boost::program_options;
 namespace fs = volcart::filesystem;
 namespace vc = volcart;
 namespace vcm = volcart::meshing;
 
+namespace
+{
+// Truncate a point to pixel coordinates, as the VTK pipeline did
+auto ToPixel(const cv::Vec2d& p) -> cv::Point
+{
+    return {static_cast<int>(p[0]), static_cast<int>(p[1])};
+}
+}  // namespace
+
 auto main(int argc, char* argv[]) -> int
 {
     ///// Parse the command line options /////
@@ -47,7 +61,10 @@ auto main(int argc, char* argv[]) -> int
         ("volume", po::value<std::string>(),
              "Volume to use for texturing. Default: First volume")
         ("output-dir,o", po::value<std::string>()->required(),
-             "Output directory");
+             "Output directory")
+        ("threads", po::value<std::size_t>()->default_value(0),
+             "Number of z-indices to project in parallel. If 0, uses one "
+             "thread per CPU core.");
 
     po::options_description visOptions("Visualization Options");
     visOptions.add_options()
@@ -85,6 +102,8 @@ auto main(int argc, char* argv[]) -> int
         return EXIT_FAILURE;
     }
 
+    vc::ThreadPool::SetGlobalThreads(parsed["threads"].as<std::size_t>());
+
     // Get options
     vc::ProjectionSettings projectionSettings;
     auto meshPaths = parsed["input-mesh"].as<std::vector<std::string>>();
@@ -150,10 +169,13 @@ auto main(int argc, char* argv[]) -> int
     // Get meshes
     std::cout << "Loading meshes..." << std::endl;
     std::vector<vtkSmartPointer<vtkPolyData>> meshes;
+    std::vector<vc::FlatMesh> flatMeshes;
     for (const auto& meshPath : meshPaths) {
         auto meshFile = vc::ReadMesh(meshPath);
         auto vtkMesh = vcm::ITK2VTK(meshFile.mesh);
         meshes.push_back(vtkMesh);
+
+        flatMeshes.push_back(vc::ToFlatMesh(meshFile.mesh));
     }
 
     // Combine meshes if we have multiple
@@ -214,51 +236,54 @@ auto main(int argc, char* argv[]) -> int
         QApplication::exec();
     }
 
+    // Sort the triangles for sweeping the slice plane through the meshes
+    const vcm::MeshSliceSweep sweep(flatMeshes);
+    flatMeshes.clear();
+    const auto zMin = projectionSettings.zMin;
+    const auto zMax = projectionSettings.zMax;
+    const auto numZ = static_cast<std::size_t>(zMax - zMin);
+
     // Iterate over every z-index in the range between zMin and zMax
-    // Cut the mesh and draw its corresponding intersection onto a new output
-    // image
-    cv::Mat outputImg;
-    std::vector<cv::Point> contour;
-    for (const auto& zIdx : vc::ProgressWrap(
-             vc::range(projectionSettings.zMin, projectionSettings.zMax),
-             "vc::projection::Projecting:")) {
-        // Cut the mesh and get the intersection
-        cutPlane->SetOrigin(width / 2.0, height / 2.0, zIdx);
-        stripper->Update();
-        auto* intersection = stripper->GetOutput();
-
-        // Setup the output image
-        if (projectionSettings.intersectOnly) {
-            outputImg = cv::Mat::zeros(height, width, CV_8UC3);
-        } else {
-            outputImg = volume->getSliceDataCopy(zIdx);
-            outputImg.convertTo(outputImg, CV_8U, MAX_8BPC / MAX_16BPC);
-            cv::cvtColor(outputImg, outputImg, cv::COLOR_GRAY2BGR);
-        }
+    // Intersect the mesh with the slice plane and draw the intersection onto
+    // a new output image. Every z-index is independent, so the slices are
+    // drawn, encoded, and written in parallel. Each thread sweeps its own
+    // contiguous range of z-indices.
+    auto bar = vc::NewProgressBar(numZ, "vc::projection::Projecting:");
+    std::mutex barMutex;
+    vc::ParallelChunks(numZ, 0, [&](auto begin, auto end) {
+        auto chunkSweep = sweep;
+        for (auto i = begin; i < end; i++) {
+            const auto zIdx = zMin + static_cast<int>(i);
 
-        // Draw the intersections
-        for (auto cId = 0; cId < intersection->GetNumberOfCells(); ++cId) {
-            auto* inputCell = intersection->GetCell(cId);
+            // Setup the output image
+            cv::Mat outputImg;
+            if (projectionSettings.intersectOnly) {
+                outputImg = cv::Mat::zeros(height, width, CV_8UC3);
+            } else {
+                volume->getSliceView(zIdx).mat().convertTo(
+                    outputImg, CV_8U, MAX_8BPC / MAX_16BPC);
+                cv::cvtColor(outputImg, outputImg, cv::COLOR_GRAY2BGR);
+            }
 
-            contour.clear();
-            for (auto pIt = 0; pIt < inputCell->GetNumberOfPoints(); ++pIt) {
-                auto pId = inputCell->GetPointId(pIt);
-                contour.emplace_back(cv::Point(
-                    static_cast<int>(intersection->GetPoint(pId)[0]),
-                    static_cast<int>(intersection->GetPoint(pId)[1])));
+            // Draw the intersections
+            for (const auto& s : chunkSweep.intersect(zIdx)) {
+                cv::line(
+                    outputImg, ToPixel(s[0]), ToPixel(s[1]),
+                    projectionSettings.color, projectionSettings.thickness,
+                    cv::LINE_AA);
             }
 
-            cv::polylines(
-                outputImg, contour, false, projectionSettings.color,
-                projectionSettings.thickness, cv::LINE_AA);
-        }
+            // Save the output to the provided directory
+            std::stringstream filename;
+            filename << std::setw(padding) << std::setfill('0') << zIdx
+                     << ".png";
+            auto path = outputDir / filename.str();
+            vc::WriteImage(path, outputImg);
 
-        // Save the output to the provided directory
-        std::stringstream filename;
-        filename << std::setw(padding) << std::setfill('0') << zIdx << ".png";
-        auto path = outputDir / filename.str();
-        vc::WriteImage(path, outputImg);
-    }
+            const std::lock_guard<std::mutex> lock(barMutex);
+            bar->tick();
+        }
+    });
 
     return EXIT_SUCCESS;
 }
@@ -0,0 +1,579 @@
+#include "CObliqueSliceViewer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <exception>
+#include <limits>
+
+#include <QKeyEvent>
+#include <QMouseEvent>
+#include <QOpenGLShaderProgram>
+#include <QOpenGLVertexArrayObject>
+#include <QSurfaceFormat>
+#include <QVector2D>
+#include <QVector3D>
+#include <QWheelEvent>
+
+#include "vc/core/util/Logging.hpp"
+
+namespace vc = volcart;
+
+using namespace ChaoVis;
+
+namespace
+{
+// Fraction of the visible plane's size added to every side of a brick, so
+// that small pans don't read a new brick
+constexpr double BRICK_MARGIN{0.125};
+// Voxels added to every side of a brick, so that moving along the normal
+// doesn't immediately read a new brick
+constexpr int BRICK_PADDING{8};
+// Range of the scale
+constexpr double MIN_SCALE{1.0 / 1024.0};
+constexpr double MAX_SCALE{64.0};
+// Zoom factor of one wheel step
+constexpr double ZOOM_STEP{1.15};
+// Plane rotation per dragged pixel
+constexpr double RADIANS_PER_PIXEL{0.005};
+// Voxels sampled when estimating the window of a brick
+constexpr std::size_t WINDOW_SAMPLES{1 << 20};
+
+// Draws a triangle covering the viewport, without any vertex buffers
+constexpr auto VERTEX_SHADER = R"(#version 330 core
+out vec2 ndc;
+void main()
+{
+    ndc = vec2(float((gl_VertexID & 1) << 2), float((gl_VertexID & 2) << 1))
+          - 1.0;
+    gl_Position = vec4(ndc, 0.0, 1.0);
+}
+)";
+
+// Samples the plane from the brick. Positions are in texture coordinates of
+// the brick.
+constexpr auto FRAGMENT_SHADER = R"(#version 330 core
+in vec2 ndc;
+out vec4 color;
+uniform sampler3D brick;
+uniform vec3 center;
+uniform vec3 xStep;
+uniform vec3 yStep;
+uniform vec2 window;
+void main()
+{
+    vec3 pos = center + ndc.x * xStep + ndc.y * yStep;
+    if (any(lessThan(pos, vec3(0.0))) || any(greaterThan(pos, vec3(1.0)))) {
+        color = vec4(0.0, 0.0, 0.0, 1.0);
+        return;
+    }
+    float v = texture(brick, pos).r;
+    v = clamp((v - window.x) / max(window.y - window.x, 1e-6), 0.0, 1.0);
+    color = vec4(v, v, v, 1.0);
+}
+)";
+
+// Window from the 0.5th to the 99.5th percentile of a sample of the voxels
+auto EstimateWindow(const std::vector<std::uint16_t>& voxels)
+    -> std::array<std::uint16_t, 2>
+{
+    if (voxels.empty()) {
+        return {0, 65535};
+    }
+
+    const auto stride =
+        std::max<std::size_t>(1, voxels.size() / WINDOW_SAMPLES);
+    std::vector<std::size_t> hist(65536, 0);
+    std::size_t count{0};
+    for (std::size_t i = 0; i < voxels.size(); i += stride) {
+        hist[voxels[i]]++;
+        count++;
+    }
+
+    auto percentile = [&](double p) {
+        const auto target = static_cast<std::size_t>(p * count);
+        std::size_t sum{0};
+        for (std::size_t v = 0; v < hist.size(); v++) {
+            sum += hist[v];
+            if (sum > target) {
+                return static_cast<std::uint16_t>(v);
+            }
+        }
+        return std::uint16_t{65535};
+    };
+    auto low = percentile(0.005);
+    auto high = percentile(0.995);
+    if (high <= low) {
+        high = static_cast<std::uint16_t>(std::min(65535, low + 1));
+        low = static_cast<std::uint16_t>(high - 1);
+    }
+    return {low, high};
+}
+
+inline auto ToQVector(const cv::Vec3d& v) -> QVector3D
+{
+    return {
+        static_cast<float>(v[0]), static_cast<float>(v[1]),
+        static_cast<float>(v[2])};
+}
+}  // namespace
+
+auto CObliqueSliceViewer::Region::empty() const -> bool
+{
+    return extent[0] <= 0 or extent[1] <= 0 or extent[2] <= 0;
+}
+
+auto CObliqueSliceViewer::Region::contains(const Region& r) const -> bool
+{
+    if (r.level != level) {
+        return false;
+    }
+    for (int i = 0; i < 3; i++) {
+        if (r.origin[i] < origin[i] or
+            r.origin[i] + r.extent[i] > origin[i] + extent[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+CObliqueSliceViewer::CObliqueSliceViewer(QWidget* parent)
+    : QOpenGLWidget(parent)
+{
+    // 3D textures and the shaders need OpenGL 3.3
+    auto fmt = format();
+    fmt.setVersion(3, 3);
+    fmt.setProfile(QSurfaceFormat::CoreProfile);
+    setFormat(fmt);
+
+    setFocusPolicy(Qt::StrongFocus);
+    setMinimumSize(256, 256);
+}
+
+CObliqueSliceViewer::~CObliqueSliceViewer()
+{
+    // The loader posts its brick to this widget before finishing. Posted
+    // events are dropped when the widget is destroyed.
+    if (loader_.valid()) {
+        loader_.wait();
+    }
+    makeCurrent();
+    cleanup_gl_();
+    doneCurrent();
+}
+
+void CObliqueSliceViewer::setVolume(vc::Volume::Pointer volume)
+{
+    if (volume == volume_) {
+        return;
+    }
+
+    volume_ = std::move(volume);
+    generation_++;
+    pending_.reset();
+    brickRegion_ = Region{};
+    textureRegion_ = Region{};
+    if (volume_ != nullptr) {
+        const auto w = static_cast<double>(volume_->sliceWidth());
+        const auto h = static_cast<double>(volume_->sliceHeight());
+        const auto d = static_cast<double>(volume_->numSlices());
+        center_ = {w / 2, h / 2, std::floor(d / 2)};
+        xAxis_ = {1, 0, 0};
+        yAxis_ = {0, 1, 0};
+        scale_ = std::clamp(
+            std::min(width() / w, height() / h), MIN_SCALE, MAX_SCALE);
+    }
+    view_changed_();
+}
+
+auto CObliqueSliceViewer::volume() const -> vc::Volume::Pointer
+{
+    return volume_;
+}
+
+void CObliqueSliceViewer::setPlane(
+    const cv::Vec3d& center,
+    const cv::Vec3d& xAxis,
+    const cv::Vec3d& yAxis)
+{
+    center_ = center;
+    xAxis_ = cv::normalize(xAxis);
+    yAxis_ = cv::normalize(yAxis - yAxis.dot(xAxis_) * xAxis_);
+    view_changed_();
+}
+
+void CObliqueSliceViewer::setCenter(const cv::Vec3d& center)
+{
+    center_ = center;
+    view_changed_();
+}
+
+auto CObliqueSliceViewer::center() const -> cv::Vec3d { return center_; }
+
+auto CObliqueSliceViewer::normal() const -> cv::Vec3d
+{
+    return xAxis_.cross(yAxis_);
+}
+
+void CObliqueSliceViewer::setScale(double scale)
+{
+    scale_ = std::clamp(scale, MIN_SCALE, MAX_SCALE);
+    view_changed_();
+}
+
+auto CObliqueSliceViewer::scale() const -> double { return scale_; }
+
+void CObliqueSliceViewer::setWindow(std::uint16_t low, std::uint16_t high)
+{
+    window_ = {low, high};
+    update();
+}
+
+void CObliqueSliceViewer::initializeGL()
+{
+    initializeOpenGLFunctions();
+
+    // The context is recreated when the widget is reparented, e.g. when its
+    // dock is floated. The texture has to be uploaded again.
+    connect(
+        context(), &QOpenGLContext::aboutToBeDestroyed, this, [this]() {
+            makeCurrent();
+            cleanup_gl_();
+            doneCurrent();
+        });
+    brickRegion_ = Region{};
+    textureRegion_ = Region{};
+
+    glGetIntegerv(GL_MAX_3D_TEXTURE_SIZE, &maxTextureSize_);
+
+    program_ = std::make_unique<QOpenGLShaderProgram>();
+    if (not program_->addShaderFromSourceCode(
+            QOpenGLShader::Vertex, VERTEX_SHADER) or
+        not program_->addShaderFromSourceCode(
+            QOpenGLShader::Fragment, FRAGMENT_SHADER) or
+        not program_->link()) {
+        vc::Logger()->error(
+            "Failed to build oblique slice shaders: {}",
+            program_->log().toStdString());
+        program_.reset();
+        return;
+    }
+
+    vao_ = std::make_unique<QOpenGLVertexArrayObject>();
+    vao_->create();
+
+    glGenTextures(1, &texture_);
+    glBindTexture(GL_TEXTURE_3D, texture_);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+
+    update_brick_();
+}
+
+void CObliqueSliceViewer::resizeGL(int /*w*/, int /*h*/) { update_brick_(); }
+
+void CObliqueSliceViewer::paintGL()
+{
+    glClearColor(0, 0, 0, 1);
+    glClear(GL_COLOR_BUFFER_BIT);
+    if (program_ == nullptr or volume_ == nullptr) {
+        return;
+    }
+
+    upload_brick_();
+    if (textureRegion_.empty()) {
+        return;
+    }
+
+    // Map full-resolution positions to texture coordinates. Voxel i of the
+    // brick is at the center of texel i.
+    const auto ls = vc::Volume::levelScale(textureRegion_.level);
+    const auto& origin = textureRegion_.origin;
+    const auto& extent = textureRegion_.extent;
+    cv::Vec3d center;
+    cv::Vec3d xStep;
+    cv::Vec3d yStep;
+    for (int i = 0; i < 3; i++) {
+        center[i] = (center_[i] / ls - origin[i] + 0.5) / extent[i];
+        xStep[i] = xAxis_[i] * width() / (2 * scale_ * ls * extent[i]);
+        // Normalized device coordinates point up
+        yStep[i] = -yAxis_[i] * height() / (2 * scale_ * ls * extent[i]);
+    }
+    const auto window = window_.value_or(textureWindow_);
+
+    program_->bind();
+    program_->setUniformValue("brick", 0);
+    program_->setUniformValue("center", ToQVector(center));
+    program_->setUniformValue("xStep", ToQVector(xStep));
+    program_->setUniformValue("yStep", ToQVector(yStep));
+    program_->setUniformValue(
+        "window", QVector2D(window[0] / 65535.F, window[1] / 65535.F));
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_3D, texture_);
+    const QOpenGLVertexArrayObject::Binder binder(vao_.get());
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    program_->release();
+}
+
+void CObliqueSliceViewer::mousePressEvent(QMouseEvent* event)
+{
+    lastPos_ = event->position();
+    event->accept();
+}
+
+void CObliqueSliceViewer::mouseMoveEvent(QMouseEvent* event)
+{
+    const auto delta = event->position() - lastPos_;
+    lastPos_ = event->position();
+    if (volume_ == nullptr) {
+        return;
+    }
+
+    if (event->buttons() & Qt::LeftButton) {
+        center_ -= (delta.x() * xAxis_ + delta.y() * yAxis_) / scale_;
+        view_changed_();
+    } else if (event->buttons() & Qt::RightButton) {
+        rotate_(yAxis_, delta.x() * RADIANS_PER_PIXEL);
+        rotate_(xAxis_, delta.y() * RADIANS_PER_PIXEL);
+        view_changed_();
+    }
+    event->accept();
+}
+
+void CObliqueSliceViewer::wheelEvent(QWheelEvent* event)
+{
+    // Some platforms turn Shift+wheel into a horizontal scroll
+    auto angle = event->angleDelta().y();
+    if (angle == 0) {
+        angle = event->angleDelta().x();
+    }
+    const auto steps = angle / 120.0;
+
+    if (event->modifiers() & Qt::ShiftModifier) {
+        move_(steps);
+    } else {
+        setScale(scale_ * std::pow(ZOOM_STEP, steps));
+    }
+    event->accept();
+}
+
+void CObliqueSliceViewer::keyPressEvent(QKeyEvent* event)
+{
+    if (event->key() == Qt::Key_PageUp) {
+        move_(1);
+    } else if (event->key() == Qt::Key_PageDown) {
+        move_(-1);
+    } else {
+        QOpenGLWidget::keyPressEvent(event);
+    }
+}
+
+auto CObliqueSliceViewer::visible_region_(std::size_t level, double margin)
+    const -> Region
+{
+    // Bounds of the visible rectangle of the plane in the level
+    const auto ls = vc::Volume::levelScale(level);
+    const auto hw = width() / (2 * scale_);
+    const auto hh = height() / (2 * scale_);
+    cv::Vec3d lo = cv::Vec3d::all(std::numeric_limits<double>::max());
+    cv::Vec3d hi = cv::Vec3d::all(std::numeric_limits<double>::lowest());
+    for (auto sx : {-1, 1}) {
+        for (auto sy : {-1, 1}) {
+            auto p = (center_ + sx * hw * xAxis_ + sy * hh * yAxis_) / ls;
+            for (int i = 0; i < 3; i++) {
+                lo[i] = std::min(lo[i], p[i]);
+                hi[i] = std::max(hi[i], p[i]);
+            }
+        }
+    }
+
+    // Grow the bounds and clip them to the level. The upper bound includes
+    // the neighbor needed for interpolation.
+    const auto lvl = volume_->level(level);
+    const cv::Vec3i dims{
+        lvl->sliceWidth(), lvl->sliceHeight(), lvl->numSlices()};
+    const auto padding = margin > 0 ? BRICK_PADDING : 0;
+    Region r;
+    r.level = level;
+    for (int i = 0; i < 3; i++) {
+        const auto grow = margin * (hi[i] - lo[i]) + padding;
+        auto a = static_cast<int>(std::floor(lo[i] - grow));
+        auto b = static_cast<int>(std::ceil(hi[i] + grow)) + 1;
+        a = std::clamp(a, 0, dims[i]);
+        b = std::clamp(b, 0, dims[i]);
+        r.origin[i] = a;
+        r.extent[i] = b - a;
+    }
+    return r;
+}
+
+auto CObliqueSliceViewer::wanted_region_() const -> Region
+{
+    const auto fits = [this](const Region& r) {
+        std::size_t voxels{1};
+        for (int i = 0; i < 3; i++) {
+            if (r.extent[i] > maxTextureSize_) {
+                return false;
+            }
+            voxels *= static_cast<std::size_t>(r.extent[i]);
+        }
+        return voxels <= MAX_BRICK_VOXELS;
+    };
+
+    const auto last = volume_->numLevels() - 1;
+    auto level = volume_->levelForSamplingInterval(1.0 / scale_);
+    auto r = visible_region_(level, BRICK_MARGIN);
+    while (not fits(r) and level < last) {
+        r = visible_region_(++level, BRICK_MARGIN);
+    }
+    if (fits(r)) {
+        return r;
+    }
+
+    // Even the coarsest level is too large: keep a cube around the center
+    const auto limit = std::min(
+        maxTextureSize_, static_cast<int>(std::cbrt(MAX_BRICK_VOXELS)));
+    const auto ls = vc::Volume::levelScale(level);
+    for (int i = 0; i < 3; i++) {
+        if (r.extent[i] <= limit) {
+            continue;
+        }
+        auto first = static_cast<int>(std::lround(center_[i] / ls));
+        first -= limit / 2;
+        first = std::clamp(
+            first, r.origin[i], r.origin[i] + r.extent[i] - limit);
+        r.origin[i] = first;
+        r.extent[i] = limit;
+    }
+    return r;
+}
+
+void CObliqueSliceViewer::update_brick_()
+{
+    if (volume_ == nullptr or width() <= 0 or height() <= 0) {
+        return;
+    }
+
+    // Keep the current brick while it covers the view. A brick which was
+    // cropped to fit never covers the view, so also keep identical bricks.
+    const auto wanted = wanted_region_();
+    if (wanted.empty() or
+        (wanted.level == brickRegion_.level and
+         wanted.origin == brickRegion_.origin and
+         wanted.extent == brickRegion_.extent)) {
+        return;
+    }
+    if (wanted.level == brickRegion_.level and
+        brickRegion_.contains(visible_region_(wanted.level, 0))) {
+        return;
+    }
+
+    // Only one brick is read at a time
+    if (loader_.valid()) {
+        reloadNeeded_ = true;
+        return;
+    }
+
+    brickRegion_ = wanted;
+    auto level = volume_->level(wanted.level);
+    auto generation = generation_;
+    auto read = [this, level, wanted, generation]() {
+        auto brick = std::make_shared<Brick>();
+        brick->generation = generation;
+        brick->region = wanted;
+        try {
+            const auto& e = wanted.extent;
+            brick->voxels.resize(
+                static_cast<std::size_t>(e[0]) * e[1] * e[2]);
+            // Texture layout: x varies fastest
+            level->copyLattice(
+                wanted.origin, {cv::Vec3i{0, 0, 1}, {0, 1, 0}, {1, 0, 0}},
+                {static_cast<std::size_t>(e[2]),
+                 static_cast<std::size_t>(e[1]),
+                 static_cast<std::size_t>(e[0])},
+                brick->voxels.data());
+            brick->window = EstimateWindow(brick->voxels);
+        } catch (const std::exception& ex) {
+            vc::Logger()->error("Failed to read brick: {}", ex.what());
+            brick.reset();
+        }
+        QMetaObject::invokeMethod(
+            this, [this, brick]() { brick_loaded_(brick); },
+            Qt::QueuedConnection);
+    };
+    loader_ = std::async(std::launch::async, read);
+}
+
+void CObliqueSliceViewer::brick_loaded_(std::shared_ptr<Brick> brick)
+{
+    // The loader has posted the brick and is about to finish
+    loader_.wait();
+    loader_ = {};
+
+    if (brick != nullptr and brick->generation == generation_) {
+        pending_ = std::move(brick);
+        update();
+    }
+    if (reloadNeeded_) {
+        reloadNeeded_ = false;
+        update_brick_();
+    }
+}
+
+void CObliqueSliceViewer::upload_brick_()
+{
+    if (pending_ == nullptr) {
+        return;
+    }
+
+    const auto& e = pending_->region.extent;
+    glBindTexture(GL_TEXTURE_3D, texture_);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 2);
+    glTexImage3D(
+        GL_TEXTURE_3D, 0, GL_R16, e[0], e[1], e[2], 0, GL_RED,
+        GL_UNSIGNED_SHORT, pending_->voxels.data());
+    textureRegion_ = pending_->region;
+    textureWindow_ = pending_->window;
+    pending_.reset();
+}
+
+void CObliqueSliceViewer::cleanup_gl_()
+{
+    if (texture_ != 0) {
+        glDeleteTextures(1, &texture_);
+        texture_ = 0;
+    }
+    vao_.reset();
+    program_.reset();
+}
+
+void CObliqueSliceViewer::rotate_(cv::Vec3d axis, double radians)
+{
+    // Rodrigues' rotation formula
+    const auto c = std::cos(radians);
+    const auto s = std::sin(radians);
+    auto rotate = [&](const cv::Vec3d& v) {
+        return v * c + axis.cross(v) * s + axis * axis.dot(v) * (1 - c);
+    };
+    xAxis_ = cv::normalize(rotate(xAxis_));
+    yAxis_ = rotate(yAxis_);
+    yAxis_ = cv::normalize(yAxis_ - yAxis_.dot(xAxis_) * xAxis_);
+}
+
+void CObliqueSliceViewer::move_(double steps)
+{
+    if (volume_ == nullptr) {
+        return;
+    }
+    center_ += normal() * steps * vc::Volume::levelScale(brickRegion_.level);
+    view_changed_();
+}
+
+void CObliqueSliceViewer::view_changed_()
+{
+    update_brick_();
+    update();
+    emit planeChanged();
+}
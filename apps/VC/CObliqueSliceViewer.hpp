@@ -0,0 +1,210 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include <QOpenGLExtraFunctions>
+#include <QOpenGLWidget>
+#include <QPointF>
+#include <opencv2/core.hpp>
+
+#include "vc/core/types/Volume.hpp"
+
+class QOpenGLShaderProgram;
+class QOpenGLVertexArrayObject;
+
+namespace ChaoVis
+{
+
+/**
+ * @brief Widget which draws an arbitrary plane through a Volume with OpenGL
+ *
+ * The plane is given by a center and two orthonormal in-plane axes in
+ * full-resolution voxel coordinates. The plane's X-axis points to the right
+ * of the widget and its Y-axis points down, so a plane with axes (1, 0, 0)
+ * and (0, 1, 0) shows a slice like CVolumeViewer.
+ *
+ * The voxels around the visible part of the plane are uploaded as a single
+ * 16-bit 3D texture (a brick) and the plane is sampled by a fragment shader
+ * with trilinear filtering, so panning, zooming, and rotating within the
+ * brick only redraw the widget. The brick is read from the coarsest pyramid
+ * level which still samples the plane at least once per screen pixel. If
+ * the voxels around the visible plane don't fit in MAX_BRICK_VOXELS at that
+ * level, a coarser level is used. Bricks are read on a background thread
+ * when the visible plane leaves the brick or the level changes, and the
+ * previous brick is drawn in the meantime.
+ *
+ * Controls: left-drag pans, right-drag rotates the plane about its in-plane
+ * axes, the wheel zooms, and Shift+wheel or Page Up/Page Down move the plane
+ * along its normal.
+ */
+class CObliqueSliceViewer : public QOpenGLWidget,
+                            protected QOpenGLExtraFunctions
+{
+    Q_OBJECT
+
+public:
+    /** Maximum number of voxels in the uploaded brick */
+    static constexpr std::size_t MAX_BRICK_VOXELS{32 * 1024 * 1024};
+
+    /** Constructor */
+    explicit CObliqueSliceViewer(QWidget* parent = nullptr);
+
+    /** Destructor. Waits for a running brick read. */
+    ~CObliqueSliceViewer() override;
+
+    /**
+     * @brief Set the displayed Volume
+     *
+     * Resets the plane to the middle slice of the Volume, scaled to fit the
+     * widget. A nullptr clears the widget.
+     */
+    void setVolume(volcart::Volume::Pointer volume);
+
+    /** @brief Get the displayed Volume */
+    [[nodiscard]] auto volume() const -> volcart::Volume::Pointer;
+
+    /**
+     * @brief Set the displayed plane
+     *
+     * The axes are normalized, and the Y-axis is made orthogonal to the
+     * X-axis.
+     */
+    void setPlane(
+        const cv::Vec3d& center,
+        const cv::Vec3d& xAxis,
+        const cv::Vec3d& yAxis);
+
+    /** @brief Move the plane without changing its orientation */
+    void setCenter(const cv::Vec3d& center);
+
+    /** @brief Get the center of the plane */
+    [[nodiscard]] auto center() const -> cv::Vec3d;
+
+    /** @brief Get the unit normal of the plane */
+    [[nodiscard]] auto normal() const -> cv::Vec3d;
+
+    /** @brief Set the number of screen pixels per full-resolution voxel */
+    void setScale(double scale);
+
+    /** @brief Get the number of screen pixels per full-resolution voxel */
+    [[nodiscard]] auto scale() const -> double;
+
+    /**
+     * @brief Set the intensity window
+     *
+     * Intensities below `low` are black and intensities above `high` are
+     * white. Until a window is set, it is estimated from each brick.
+     */
+    void setWindow(std::uint16_t low, std::uint16_t high);
+
+signals:
+    /** The plane or scale changed */
+    void planeChanged();
+
+protected:
+    void initializeGL() override;
+    void resizeGL(int w, int h) override;
+    void paintGL() override;
+    void mousePressEvent(QMouseEvent* event) override;
+    void mouseMoveEvent(QMouseEvent* event) override;
+    void wheelEvent(QWheelEvent* event) override;
+    void keyPressEvent(QKeyEvent* event) override;
+
+private:
+    /** Voxel region of a pyramid level */
+    struct Region {
+        std::size_t level{0};
+        /** First voxel (x, y, z) */
+        cv::Vec3i origin;
+        /** Number of voxels along (x, y, z) */
+        cv::Vec3i extent;
+
+        [[nodiscard]] auto empty() const -> bool;
+        [[nodiscard]] auto contains(const Region& r) const -> bool;
+    };
+
+    /** Brick read from a level, with the window estimated from it */
+    struct Brick {
+        /** Value of generation_ when the read started */
+        std::uint64_t generation{0};
+        Region region;
+        std::vector<std::uint16_t> voxels;
+        std::array<std::uint16_t, 2> window{0, 65535};
+    };
+
+    /**
+     * Region of a level covering the visible plane, grown by `margin` times
+     * its size on every side and clipped to the level
+     */
+    auto visible_region_(std::size_t level, double margin) const -> Region;
+
+    /** Region which should be uploaded for the current view */
+    auto wanted_region_() const -> Region;
+
+    /** Start reading a new brick if the current one doesn't cover the view */
+    void update_brick_();
+
+    /** Receive a brick from the background thread */
+    void brick_loaded_(std::shared_ptr<Brick> brick);
+
+    /** Upload the received brick. Requires the GL context. */
+    void upload_brick_();
+
+    /** Release the GL objects. Requires the GL context. */
+    void cleanup_gl_();
+
+    /** Rotate the plane about one of its in-plane axes */
+    void rotate_(cv::Vec3d axis, double radians);
+
+    /** Move the plane along its normal by voxels of the displayed level */
+    void move_(double steps);
+
+    /** Notify that the view changed */
+    void view_changed_();
+
+    /** Displayed Volume */
+    volcart::Volume::Pointer volume_;
+    /** Plane center in full-resolution voxels */
+    cv::Vec3d center_{0, 0, 0};
+    /** Plane X-axis, right on screen */
+    cv::Vec3d xAxis_{1, 0, 0};
+    /** Plane Y-axis, down on screen */
+    cv::Vec3d yAxis_{0, 1, 0};
+    /** Screen pixels per full-resolution voxel */
+    double scale_{1.0};
+    /** Intensity window, if set by the user */
+    std::optional<std::array<std::uint16_t, 2>> window_;
+
+    /** Incremented when the Volume changes, to drop stale bricks */
+    std::uint64_t generation_{0};
+    /** Region of the newest brick, which may not be uploaded yet */
+    Region brickRegion_;
+    /** Region of the brick in the texture */
+    Region textureRegion_;
+    /** Window estimated from the brick in the texture */
+    std::array<std::uint16_t, 2> textureWindow_{0, 65535};
+    /** Brick waiting for upload */
+    std::shared_ptr<Brick> pending_;
+    /** Running brick read */
+    std::future<void> loader_;
+    /** Whether the view changed while a brick was read */
+    bool reloadNeeded_{false};
+
+    /** Last mouse position for drags */
+    QPointF lastPos_;
+
+    /** Maximum 3D texture size of the GL implementation */
+    int maxTextureSize_{256};
+    /** GL objects */
+    std::unique_ptr<QOpenGLShaderProgram> program_;
+    std::unique_ptr<QOpenGLVertexArrayObject> vao_;
+    unsigned int texture_{0};
+};
+
+}  // namespace ChaoVis
@@ -15,7 +15,6 @@ CVolumeViewer::CVolumeViewer(QWidget* parent)
     , fResetBtn(nullptr)
     , fNextBtn(nullptr)
     , fPrevBtn(nullptr)
-    , fImgQImage(nullptr)
     , fScaleFactor(1.0)
     , fImageIndex(0)
 {
@@ -33,11 +32,10 @@ CVolumeViewer::CVolumeViewer(QWidget* parent)
         fImageIndexEdit, SIGNAL(SendSignalOnTextChanged()), this,
         SLOT(OnImageIndexEditTextChanged()));
 
-    // create image label
-    fCanvas = new QLabel;
+    // create image canvas
+    fCanvas = new TiledImageCanvas;
     fCanvas->setBackgroundRole(QPalette::Base);
     fCanvas->setSizePolicy(QSizePolicy::Ignored, QSizePolicy::Ignored);
-    fCanvas->setScaledContents(true);
 
     // create scroll area
     fScrollArea = new QScrollArea;
@@ -90,16 +88,10 @@ void CVolumeViewer::setButtonsEnabled(bool state)
 }
 
 // Set image
-void CVolumeViewer::SetImage(const QImage& nSrc)
+void CVolumeViewer::SetImage(const cv::Mat& nSrc)
 {
-    if (fImgQImage == nullptr) {
-        fImgQImage = new QImage(nSrc);
-    } else {
-        *fImgQImage = nSrc;
-    }
-
-    fCanvas->setPixmap(QPixmap::fromImage(*fImgQImage));
-    fCanvas->resize(fScaleFactor * fCanvas->pixmap(Qt::ReturnByValue).size());
+    fCanvas->setImage(nSrc);
+    fCanvas->setScale(fScaleFactor);
 
     UpdateButtons();
     update();
@@ -124,10 +116,10 @@ void CVolumeViewer::paintEvent(QPaintEvent* /*event*/)
 // Scale image
 void CVolumeViewer::ScaleImage(double nFactor)
 {
-    Q_ASSERT(!fCanvas->pixmap(Qt::ReturnByValue).isNull());
+    Q_ASSERT(fCanvas->hasImage());
 
     fScaleFactor *= nFactor;
-    fCanvas->resize(fScaleFactor * fCanvas->pixmap(Qt::ReturnByValue).size());
+    fCanvas->setScale(fScaleFactor);
 
     AdjustScrollBar(fScrollArea->horizontalScrollBar(), nFactor);
     AdjustScrollBar(fScrollArea->verticalScrollBar(), nFactor);
@@ -154,8 +146,8 @@ void CVolumeViewer::OnZoomOutClicked(void)
 // Handle reset click
 void CVolumeViewer::OnResetClicked(void)
 {
-    fCanvas->adjustSize();
     fScaleFactor = 1.0;
+    fCanvas->setScale(fScaleFactor);
 
     UpdateButtons();
 }
@@ -188,12 +180,12 @@ void CVolumeViewer::OnImageIndexEditTextChanged(void)
 // Update the status of the buttons
 void CVolumeViewer::UpdateButtons(void)
 {
-    fZoomInBtn->setEnabled(fImgQImage != nullptr && fScaleFactor < 10.0);
-    fZoomOutBtn->setEnabled(fImgQImage != nullptr && fScaleFactor > 0.05);
+    fZoomInBtn->setEnabled(fCanvas->hasImage() && fScaleFactor < 10.0);
+    fZoomOutBtn->setEnabled(fCanvas->hasImage() && fScaleFactor > 0.05);
     fResetBtn->setEnabled(
-        fImgQImage != nullptr && fabs(fScaleFactor - 1.0) > 1e-6);
-    fNextBtn->setEnabled(fImgQImage != nullptr);
-    fPrevBtn->setEnabled(fImgQImage != nullptr);
+        fCanvas->hasImage() && fabs(fScaleFactor - 1.0) > 1e-6);
+    fNextBtn->setEnabled(fCanvas->hasImage());
+    fPrevBtn->setEnabled(fCanvas->hasImage());
     // fImageIndexEdit->setEnabled( false );
     fImageIndexEdit->SetImageIndex(fImageIndex);
 }
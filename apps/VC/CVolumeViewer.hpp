@@ -8,6 +8,7 @@
 #include <opencv2/opencv.hpp>
 
 #include "CSimpleNumEditBox.hpp"
+#include "TiledImageCanvas.hpp"
 
 namespace ChaoVis
 {
@@ -22,7 +23,7 @@ public:
     ~CVolumeViewer(void);
     virtual void setButtonsEnabled(bool state);
 
-    virtual void SetImage(const QImage& nSrc);
+    virtual void SetImage(const cv::Mat& nSrc);
     void SetImageIndex(int nImageIndex)
     {
         fImageIndex = nImageIndex;
@@ -54,7 +55,7 @@ protected:
 
 protected:
     // widget components
-    QLabel* fCanvas;
+    TiledImageCanvas* fCanvas;
     QScrollArea* fScrollArea;
     QPushButton* fZoomInBtn;
     QPushButton* fZoomOutBtn;
@@ -65,7 +66,6 @@ protected:
     QHBoxLayout* fButtonsLayout;
 
     // data
-    QImage* fImgQImage;
     double fScaleFactor;
     int fImageIndex;
 
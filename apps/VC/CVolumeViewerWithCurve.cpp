@@ -2,6 +2,7 @@
 // Chao Du 2015 April
 #include "CVolumeViewerWithCurve.hpp"
 
+#include <QPainter>
 #include <QSettings>
 #include <opencv2/imgproc.hpp>
 
@@ -61,27 +62,46 @@ CVolumeViewerWithCurve::CVolumeViewerWithCurve()
     fButtonsLayout->addWidget(fHistEqBox);
     fButtonsLayout->addWidget(HistEqLabel);
 
+    // curves are painted on top of the visible part of the slice
+    fCanvas->setOverlay([this](QPainter& p) { DrawOverlay(p); });
+
     UpdateButtons();
 }
 
 // Set image
-void CVolumeViewerWithCurve::SetImage(const QImage& nSrc)
+void CVolumeViewerWithCurve::SetImage(const cv::Mat& nSrc)
 {
-    if (fImgQImage == nullptr) {
-        fImgQImage = new QImage(nSrc);
-    } else {
-        *fImgQImage = nSrc;
-    }
-
-    fCanvas->setPixmap(QPixmap::fromImage(*fImgQImage));
-    fCanvas->resize(fScaleFactor * fCanvas->pixmap(Qt::ReturnByValue).size());
+    fImgMat = nSrc;
 
-    fImgMat = QImage2Mat(*fImgQImage);
-    fImgMat.copyTo(fImgMatCache);
+    UpdateImage();
+    fCanvas->setScale(fScaleFactor);
 
     UpdateView();
 }
 
+// Update the displayed image, equalizing the histogram if enabled
+void CVolumeViewerWithCurve::UpdateImage(void)
+{
+    if (!histEq || fImgMat.empty()) {
+        fCanvas->setImage(fImgMat);
+        return;
+    }
+
+    // fImgMat may be the volume's cached slice, so never modify it
+    cv::Mat aGray;
+    if (fImgMat.channels() == 3) {
+        cv::cvtColor(fImgMat, aGray, cv::COLOR_BGR2GRAY);
+    } else {
+        aGray = fImgMat;
+    }
+    if (aGray.depth() == CV_16U) {
+        aGray.convertTo(aGray, CV_8U, 1.0 / 256.0);
+    }
+    cv::Mat aEqualized;
+    cv::equalizeHist(aGray, aEqualized);
+    fCanvas->setImage(aEqualized);
+}
+
 // Set the curve, we only hold a pointer to the original one so the data can be
 // synchronized
 void CVolumeViewerWithCurve::SetSplineCurve(CBSpline& nCurve)
@@ -101,6 +121,12 @@ void CVolumeViewerWithCurve::SetImpactRange(int nImpactRange)
     fImpactRange = nImpactRange;
 }
 
+// Set the chain computed on this slice by a running segmentation
+void CVolumeViewerWithCurve::SetPreviewCurve(std::vector<cv::Vec2f> nCurve)
+{
+    fPreviewCurve = std::move(nCurve);
+}
+
 // Update the B-spline curve
 void CVolumeViewerWithCurve::UpdateSplineCurve(void)
 {
@@ -112,14 +138,17 @@ void CVolumeViewerWithCurve::UpdateSplineCurve(void)
 // Update the view
 void CVolumeViewerWithCurve::UpdateView(void)
 {
-    fImgMatCache.copyTo(fImgMat);
+    // only the visible tiles and the curves are redrawn
+    fCanvas->update();
 
-    if (histEq) {
-        cv::cvtColor(fImgMat, fImgMat, cv::COLOR_BGR2GRAY);
-        cv::equalizeHist(fImgMat, fImgMat);
-        cv::cvtColor(fImgMat, fImgMat, cv::COLOR_GRAY2BGR);
-    }
+    CVolumeViewerWithCurve::UpdateButtons();
+
+    update();  // repaint the widget
+}
 
+// Draw the curves of the current mode, in image coordinates
+void CVolumeViewerWithCurve::DrawOverlay(QPainter& nPainter)
+{
     if (fViewState == EViewState::ViewStateDraw) {
         // get secondary color
         int h{0}, s{0}, v{0};
@@ -129,32 +158,61 @@ void CVolumeViewerWithCurve::UpdateView(void)
             h = h - 360;
         }
         auto secondary = QColor::fromHsv(h, 255, 255);
-        int r{0}, g{0}, b{0};
-        secondary.getRgb(&r, &g, &b);
-        if (fSplineCurveRef != nullptr) {
-            fSplineCurveRef->DrawOnImage(fImgMat, cv::Scalar(b, g, r));
+
+        // the curve is sampled at pixel indices, so shift it to the pixel
+        // centers
+        if (fSplineCurveRef != nullptr &&
+            fSplineCurveRef->GetNumOfControlPoints() >= 2) {
+            nPainter.setPen(QPen(secondary, 1.0));
+            QPolygonF aCurve;
+            if (fSplineCurveRef->GetNumOfControlPoints() == 2) {
+                for (int i = 0; i < 2; ++i) {
+                    auto p = fSplineCurveRef->GetPoint(i);
+                    aCurve << QPointF(p[0] + 0.5, p[1] + 0.5);
+                }
+            } else {
+                std::vector<cv::Vec2f> aSamples;
+                fSplineCurveRef->GetSamplePoints(aSamples);
+                for (const auto& p : aSamples) {
+                    aCurve << QPointF(p[0] + 0.5, p[1] + 0.5);
+                }
+            }
+            nPainter.drawPolyline(aCurve);
         }
 
         // get primary color
-        colorSelector->color().getRgb(&r, &g, &b);
-        for (size_t i = 0; i < fControlPoints.size(); ++i) {
-            auto p = fControlPoints[i] - cv::Vec2f{0.5, 0.5};
-            cv::circle(fImgMat, cv::Point2f(p), 1, cv::Scalar(b, g, r));
+        nPainter.setPen(QPen(colorSelector->color(), 1.0));
+        for (const auto& p : fControlPoints) {
+            nPainter.drawEllipse(QPointF(p[0], p[1]), 1.0, 1.0);
         }
     } else {
         if (fIntersectionCurveRef != nullptr && showCurve) {
-            DrawIntersectionCurve();
+            DrawIntersectionCurve(nPainter);
         }
     }
 
-    *fImgQImage = Mat2QImage(fImgMat);
+    if (showCurve) {
+        DrawPreviewCurve(nPainter);
+    }
+}
 
-    fCanvas->setPixmap(QPixmap::fromImage(*fImgQImage));
-    fCanvas->resize(fScaleFactor * fCanvas->pixmap(Qt::ReturnByValue).size());
+// Draw the preview chain as a dashed line in the secondary color
+void CVolumeViewerWithCurve::DrawPreviewCurve(QPainter& nPainter)
+{
+    if (fPreviewCurve.size() < 2) {
+        return;
+    }
 
-    CVolumeViewerWithCurve::UpdateButtons();
+    int h{0}, s{0}, v{0};
+    colorSelector->color().getHsv(&h, &s, &v);
+    auto secondary = QColor::fromHsv((h + 180) % 360, 255, 255);
 
-    update();  // repaint the widget
+    QPolygonF aCurve;
+    for (const auto& p : fPreviewCurve) {
+        aCurve << QPointF(p[0], p[1]);
+    }
+    nPainter.setPen(QPen(secondary, 1.0, Qt::DashLine));
+    nPainter.drawPolyline(aCurve);
 }
 
 // Handle mouse press event
@@ -266,6 +324,7 @@ void CVolumeViewerWithCurve::OnHistEqStateChanged(int state)
         histEq = false;
     }
 
+    UpdateImage();
     UpdateView();
 }
 
@@ -314,17 +373,14 @@ int CVolumeViewerWithCurve::SelectPointOnCurve(
 }
 
 // Draw intersection curve on the slice
-void CVolumeViewerWithCurve::DrawIntersectionCurve(void)
+void CVolumeViewerWithCurve::DrawIntersectionCurve(QPainter& nPainter)
 {
     if (fIntersectionCurveRef != nullptr) {
-        int r{0};
-        int g{0};
-        int b{0};
-        colorSelector->color().getRgb(&r, &g, &b);
+        nPainter.setPen(QPen(colorSelector->color(), 1.0));
         for (size_t i = 0; i < fIntersectionCurveRef->GetPointsNum(); ++i) {
-            auto p0 = fIntersectionCurveRef->GetPoint(i)[0] - 0.5;
-            auto p1 = fIntersectionCurveRef->GetPoint(i)[1] - 0.5;
-            cv::circle(fImgMat, cv::Point2d(p0, p1), 1, cv::Scalar(b, g, r));
+            auto p0 = fIntersectionCurveRef->GetPoint(i)[0];
+            auto p1 = fIntersectionCurveRef->GetPoint(i)[1];
+            nPainter.drawEllipse(QPointF(p0, p1), 1.0, 1.0);
         }
     }
 }
@@ -332,14 +388,14 @@ void CVolumeViewerWithCurve::DrawIntersectionCurve(void)
 // Update the status of the buttons
 void CVolumeViewerWithCurve::UpdateButtons(void)
 {
-    fZoomInBtn->setEnabled(fImgQImage != nullptr && fScaleFactor < 10.);
-    fZoomOutBtn->setEnabled(fImgQImage != nullptr && fScaleFactor > 0.05);
+    fZoomInBtn->setEnabled(fCanvas->hasImage() && fScaleFactor < 10.);
+    fZoomOutBtn->setEnabled(fCanvas->hasImage() && fScaleFactor > 0.05);
     fResetBtn->setEnabled(
-        fImgQImage != nullptr && fabs(fScaleFactor - 1.0) > 1e-6);
+        fCanvas->hasImage() && fabs(fScaleFactor - 1.0) > 1e-6);
     fNextBtn->setEnabled(
-        fImgQImage != nullptr && fViewState == EViewState::ViewStateIdle);
+        fCanvas->hasImage() && fViewState == EViewState::ViewStateIdle);
     fPrevBtn->setEnabled(
-        fImgQImage != nullptr && fViewState == EViewState::ViewStateIdle);
+        fCanvas->hasImage() && fViewState == EViewState::ViewStateIdle);
     fImageIndexEdit->setEnabled(fViewState == EViewState::ViewStateIdle);
     fImageIndexEdit->SetImageIndex(fImageIndex);
 }
@@ -33,7 +33,7 @@ public:
     CVolumeViewerWithCurve();
     ~CVolumeViewerWithCurve() = default;
 
-    virtual void SetImage(const QImage& nSrc);
+    virtual void SetImage(const cv::Mat& nSrc);
 
     // for drawing mode
     void SetSplineCurve(CBSpline& nCurve);
@@ -42,6 +42,9 @@ public:
     // for editing mode
     void SetIntersectionCurve(CXCurve& nCurve);
     void SetImpactRange(int nImpactRange);
+    // for segmentation preview
+    void SetPreviewCurve(std::vector<cv::Vec2f> nCurve);
+    void ResetPreviewCurve(void) { fPreviewCurve.clear(); }
 
     void UpdateView(void);
     void SetShowCurve(bool b) { showCurve = b; }
@@ -65,9 +68,13 @@ private slots:
 private:
     void WidgetLoc2ImgLoc(const cv::Vec2f& nWidgetLoc, cv::Vec2f& nImgLoc);
 
+    void UpdateImage(void);
+
     int SelectPointOnCurve(const CXCurve* nCurve, const cv::Vec2f& nPt);
 
-    void DrawIntersectionCurve(void);
+    void DrawOverlay(QPainter& nPainter);
+    void DrawIntersectionCurve(QPainter& nPainter);
+    void DrawPreviewCurve(QPainter& nPainter);
 
 private slots:
 
@@ -89,12 +96,14 @@ private:
     int fSelectedPointIndex;
     bool fVertexIsChanged;
 
+    // for previewing a running segmentation
+    std::vector<cv::Vec2f> fPreviewCurve;
+
     QPointF fLastPos;  // last mouse position on the image
     int fImpactRange;  // how many points a control point movement can affect
 
-    // image drawn
+    // slice image, curves are drawn on top of it by DrawOverlay()
     cv::Mat fImgMat;
-    cv::Mat fImgMatCache;
 
     EViewState fViewState;
 
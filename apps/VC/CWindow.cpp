@@ -2,11 +2,15 @@
 // Chao Du 2014 Dec
 #include "CWindow.hpp"
 
+#include <algorithm>
+#include <cmath>
+
 #include <QKeySequence>
 #include <QProgressBar>
 #include <QSettings>
 #include <opencv2/imgproc.hpp>
 
+#include "CObliqueSliceViewer.hpp"
 #include "CVolumeViewerWithCurve.hpp"
 #include "UDataManipulateUtils.hpp"
 #include "vc/core/types/Color.hpp"
@@ -116,6 +120,9 @@ CWindow::CWindow()
     CreateMenus();
     CreateBackend();
 
+    // Point sets are read one at a time
+    fPointSetLoader.setMaxThreadCount(1);
+
     OpenSlice();
     UpdateView();
 
@@ -131,8 +138,16 @@ CWindow::CWindow()
 // Destructor
 CWindow::~CWindow(void)
 {
+    // Don't wait for a running segmentation to finish
+    if (fActiveSegmenter != nullptr) {
+        fActiveSegmenter->cancel();
+    }
     worker_thread_.quit();
     worker_thread_.wait();
+
+    // The loader posts rows to this window, so it must finish first
+    CancelPointSetLoad();
+    fPointSetLoader.waitForDone();
 }
 
 // Handle mouse press event
@@ -180,6 +195,14 @@ void CWindow::CreateWidgets(void)
         fVolumeViewerWidget, SIGNAL(SendSignalPathChanged()), this,
         SLOT(OnPathChanged()));
 
+    // oblique slice viewer, hidden until opened from the View menu
+    fObliqueViewer = new CObliqueSliceViewer();
+    fObliqueDock = new QDockWidget(tr("Oblique Slice"), this);
+    fObliqueDock->setObjectName("obliqueSliceDock");
+    fObliqueDock->setWidget(fObliqueViewer);
+    addDockWidget(Qt::RightDockWidgetArea, fObliqueDock);
+    fObliqueDock->hide();
+
     // new path button
     QPushButton* aBtnNewPath = this->findChild<QPushButton*>("btnNewPath");
     QPushButton* aBtnRemovePath =
@@ -393,7 +416,12 @@ void CWindow::CreateMenus(void)
     fHelpMenu = new QMenu(tr("&Help"), this);
     fHelpMenu->addAction(fAboutAct);
 
+    fViewMenu = new QMenu(tr("&View"), this);
+    fViewMenu->addAction(fObliqueDock->toggleViewAction());
+    fViewMenu->addAction(fAlignObliqueAct);
+
     menuBar()->addMenu(fFileMenu);
+    menuBar()->addMenu(fViewMenu);
     menuBar()->addMenu(fHelpMenu);
 }
 
@@ -414,6 +442,11 @@ void CWindow::CreateActions(void)
     connect(
         fSavePointCloudAct, SIGNAL(triggered()), this, SLOT(SavePointCloud()));
     fSavePointCloudAct->setShortcut(QKeySequence::Save);
+
+    fAlignObliqueAct = new QAction(tr("&Align Oblique Slice to Curve"), this);
+    connect(
+        fAlignObliqueAct, SIGNAL(triggered()), this,
+        SLOT(OnAlignObliqueSlice()));
 }
 
 void CWindow::CreateBackend()
@@ -431,19 +464,30 @@ void CWindow::CreateBackend()
     connect(
         worker, &VolPkgBackend::segmentationFailed, this,
         &CWindow::onSegmentationFailed);
+    connect(
+        worker, &VolPkgBackend::chainComputed, this,
+        &CWindow::onChainComputed);
     connect(worker, &VolPkgBackend::progressUpdated, [=](size_t p) {
         progress_ = p;
     });
     worker_thread_.start();
 
-    // Setup progress dialog
-    auto layout = new QVBoxLayout();
-    worker_progress_.setLayout(layout);
-    progressLabel_ = new QLabel("Segmentation in progress. Please wait...");
-    layout->addWidget(progressLabel_);
+    // Setup progress widgets. These live in the status bar so that the
+    // window stays usable while segmentation runs.
+    progressLabel_ = new QLabel(tr("Segmentation in progress"));
     progressBar_ = new QProgressBar();
-    layout->addWidget(progressBar_);
     progressBar_->setMinimum(0);
+    progressBar_->setMaximumWidth(200);
+    cancelButton_ = new QPushButton(tr("Cancel"));
+    connect(
+        cancelButton_, &QPushButton::clicked, this,
+        &CWindow::OnBtnCancelSegClicked);
+    statusBar->addPermanentWidget(progressLabel_);
+    statusBar->addPermanentWidget(progressBar_);
+    statusBar->addPermanentWidget(cancelButton_);
+    progressLabel_->hide();
+    progressBar_->hide();
+    cancelButton_->hide();
     connect(worker, &VolPkgBackend::segmentationStarted, [=](size_t its) {
         progressBar_->setMaximum(its);
     });
@@ -451,12 +495,6 @@ void CWindow::CreateBackend()
     // Update the GUI intermittently
     worker_progress_updater_.setInterval(1000);
     connect(&worker_progress_updater_, &QTimer::timeout, [=]() {
-        if (progressLabel_->text() ==
-            "Segmentation in progress. Please wait...") {
-            progressLabel_->setText("Segmentation in progress. Please wait");
-        } else {
-            progressLabel_->setText(progressLabel_->text().append('.'));
-        }
         progressBar_->setValue(progress_);
     });
 }
@@ -601,6 +639,26 @@ void CWindow::UpdateView(void)
 
     fEdtStartIndex->setEnabled(false);
 
+    // Only slice navigation stays enabled while segmentation runs
+    auto running = fActiveSegmenter != nullptr;
+    fOpenVolAct->setEnabled(!running);
+    fSavePointCloudAct->setEnabled(!running);
+    if (running) {
+        setWidgetsEnabled(false);
+        fVolumeViewerWidget->setButtonsEnabled(true);
+        fVolumeViewerWidget->SetViewState(
+            CVolumeViewerWithCurve::EViewState::ViewStateIdle);
+    }
+
+    // Editing waits for the point set to be read
+    if (fLoadingPointSet) {
+        fSegTool->setEnabled(false);
+        fPenTool->setEnabled(false);
+        fSavePointCloudAct->setEnabled(false);
+        volSelect->setEnabled(false);
+        assignVol->setEnabled(false);
+    }
+
     fVolumeViewerWidget->UpdateView();
 
     update();
@@ -618,19 +676,20 @@ void CWindow::ChangePathItem(std::string segID)
     fSegmentationId = segID;
     fSegmentation = fVpkg->segmentation(fSegmentationId);
 
-    // load proper point cloud
-    if (fSegmentation->hasPointSet()) {
-        fMasterCloud = fSegmentation->getPointSet();
-    } else {
-        fMasterCloud.reset();
-    }
-
     if (fSegmentation->hasVolumeID()) {
         currentVolume = fVpkg->volume(fSegmentation->getVolumeID());
         volSelect->setCurrentText(
             QString::fromStdString(fSegmentation->getVolumeID()));
     }
 
+    // Read the point cloud in the background. The first slice is shown when
+    // its rows arrive.
+    if (fSegmentation->hasPointSet()) {
+        LoadPointSet();
+        UpdateView();
+        return;
+    }
+
     SetUpCurves();
 
     // Move us to the lowest slice index for the cloud
@@ -675,6 +734,47 @@ void CWindow::SplitCloud(void)
     }
 }
 
+namespace
+{
+// Whether two parameter sets produce the same segmentation. The target index
+// only determines where the segmentation stops.
+auto SameSegParams(const CWindow::SSegParams& a, const CWindow::SSegParams& b)
+    -> bool
+{
+    return a.fNumIters == b.fNumIters && a.fAlpha == b.fAlpha &&
+           a.fBeta == b.fBeta && a.fDelta == b.fDelta && a.fK1 == b.fK1 &&
+           a.fK2 == b.fK2 && a.fPeakDistanceWeight == b.fPeakDistanceWeight &&
+           a.fWindowWidth == b.fWindowWidth &&
+           a.fIncludeMiddle == b.fIncludeMiddle &&
+           a.ofsSmoothBrightnessThreshold == b.ofsSmoothBrightnessThreshold &&
+           a.ofsOutsideThreshold == b.ofsOutsideThreshold &&
+           a.ofsPixelThreshold == b.ofsPixelThreshold &&
+           a.ofsDisplacementThreshold == b.ofsDisplacementThreshold;
+}
+
+// Slice index of a chain
+auto ChainSlice(const std::vector<cv::Vec3d>& chain) -> int
+{
+    return static_cast<int>(std::lround(chain.front()[2]));
+}
+
+// Whether the user has left a chain unedited
+auto SameChain(const std::vector<cv::Vec3d>& a, const std::vector<cv::Vec3d>& b)
+    -> bool
+{
+    constexpr double TOLERANCE{1e-6};
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (cv::norm(a[i] - b[i]) > TOLERANCE) {
+            return false;
+        }
+    }
+    return true;
+}
+}  // namespace
+
 // Do segmentation given the starting point cloud
 void CWindow::DoSegmentation(void)
 {
@@ -720,33 +820,123 @@ void CWindow::DoSegmentation(void)
     // ADD OTHER SEGMENTER SETUP HERE. MATCH THE IDX TO THE IDX IN THE
     // DROPDOWN LIST
 
+    // Resume from the previous run's chains if the starting chain is
+    // unedited. Otherwise, everything downstream of it is stale.
+    fResumedPart = vc::OrderedPointSet<cv::Vec3d>(fStartingPath.size());
+    auto startingChain = fStartingPath;
+    auto cached = fSegCache.chains.find(fPathOnSliceIndex);
+    if (fSegCache.method == segIdx &&
+        fSegCache.volumeID == currentVolume->id() &&
+        SameSegParams(fSegCache.params, fSegParams) &&
+        cached != fSegCache.chains.end() &&
+        SameChain(cached->second, fStartingPath)) {
+        // Reuse consecutive cached chains up to the target slice
+        while (cached->first < fSegParams.targetIndex) {
+            auto next = std::next(cached);
+            if (next == fSegCache.chains.end() ||
+                next->first != cached->first + 1) {
+                break;
+            }
+            fResumedPart.pushRow(cached->second);
+            cached = next;
+        }
+        startingChain = cached->second;
+
+        // Every slice is cached
+        if (cached->first >= fSegParams.targetIndex) {
+            Segmenter::PointSet ps(startingChain.size());
+            ps.pushRow(startingChain);
+            onSegmentationFinished(ps);
+            return;
+        }
+    } else {
+        fSegCache = {segIdx, currentVolume->id(), fSegParams, {}};
+    }
+
     // set common parameters
-    segmenter->setChain(fStartingPath);
+    segmenter->setChain(startingChain);
     segmenter->setVolume(currentVolume);
 
-    // setup
-    submitSegmentation(segmenter);
-    setWidgetsEnabled(false);
-    worker_progress_.show();
+    // Run in the background, previewing each chain as it is computed
+    fActiveSegmenter = segmenter;
+    fPreviewChains.clear();
+    progress_ = 0;
+    progressBar_->setValue(0);
+    cancelButton_->setEnabled(true);
+    progressLabel_->show();
+    progressBar_->show();
+    cancelButton_->show();
     worker_progress_updater_.start();
+    submitSegmentation(segmenter);
+    UpdateView();
 }
 
-void CWindow::onSegmentationFinished(Segmenter::PointSet ps)
+void CWindow::onChainComputed(Segmenter::Chain c)
+{
+    if (c.empty()) {
+        return;
+    }
+    auto slice = ChainSlice(c);
+    fPreviewChains[slice] = std::move(c);
+    if (slice == fPathOnSliceIndex) {
+        SetPreviewCurve(fPathOnSliceIndex);
+        fVolumeViewerWidget->UpdateView();
+    }
+}
+
+void CWindow::OnBtnCancelSegClicked(void)
+{
+    if (fActiveSegmenter != nullptr) {
+        fActiveSegmenter->cancel();
+        cancelButton_->setEnabled(false);
+        statusBar->showMessage(tr("Cancelling segmentation..."));
+    }
+}
+
+void CWindow::StopSegmentationProgress(void)
 {
-    setWidgetsEnabled(true);
     worker_progress_updater_.stop();
-    worker_progress_.close();
+    progressLabel_->hide();
+    progressBar_->hide();
+    cancelButton_->hide();
+    fActiveSegmenter = nullptr;
+    fPreviewChains.clear();
+    fVolumeViewerWidget->ResetPreviewCurve();
+}
+
+void CWindow::onSegmentationFinished(Segmenter::PointSet ps)
+{
+    // Keep the chains computed before a cancellation
+    auto cancelled = fActiveSegmenter != nullptr &&
+                     fActiveSegmenter->getStatus() ==
+                         Segmenter::Status::Cancelled;
+    StopSegmentationProgress();
+    // Prepend the chains reused from the previous run and cache the result
+    fResumedPart.append(ps);
+    CacheSegmentationResult(fResumedPart);
+
     // 3) concatenate the two parts to form the complete point cloud
-    fUpperPart.append(ps);
+    fUpperPart.append(fResumedPart);
     fMasterCloud = fUpperPart;
 
-    statusBar->showMessage(tr("Segmentation complete"));
+    statusBar->showMessage(
+        cancelled ? tr("Segmentation cancelled") : tr("Segmentation complete"));
     fVpkgChanged = true;
 
     CleanupSegmentation();
     UpdateView();
 }
 
+void CWindow::CacheSegmentationResult(const Segmenter::PointSet& ps)
+{
+    for (size_t i = 0; i < ps.height(); ++i) {
+        auto chain = ps.getRow(i);
+        if (not chain.empty()) {
+            fSegCache.chains[ChainSlice(chain)] = std::move(chain);
+        }
+    }
+}
+
 void CWindow::onSegmentationFailed(std::string s)
 {
     vc::Logger()->error("Segmentation failed: {}", s);
@@ -754,9 +944,7 @@ void CWindow::onSegmentationFailed(std::string s)
     QMessageBox::critical(
         this, tr("VC"), QString::fromStdString("Segmentation failed:\n\n" + s));
 
-    setWidgetsEnabled(true);
-    worker_progress_updater_.stop();
-    worker_progress_.close();
+    StopSegmentationProgress();
     CleanupSegmentation();
     UpdateView();
 }
@@ -842,24 +1030,26 @@ void CWindow::SetUpCurves(void)
         return;
     }
     fIntersections.clear();
-    int minIndex, maxIndex;
-    if (fMasterCloud.empty()) {
-        minIndex = maxIndex = fPathOnSliceIndex;
-    } else {
-        minIndex = static_cast<int>(floor(fMasterCloud[0][2]));
-        maxIndex = static_cast<int>(floor(fMasterCloud.max()[2]));
-    }
+    AppendCurves(0);
+}
 
-    fMinSegIndex = minIndex;
-    fMaxSegIndex = maxIndex;
+// Add the curves of the rows of fMasterCloud starting at nFirstRow
+void CWindow::AppendCurves(size_t nFirstRow)
+{
+    if (nFirstRow == 0) {
+        fMinSegIndex = static_cast<int>(floor(fMasterCloud[0][2]));
+        fMaxSegIndex = fMinSegIndex;
+    }
 
     // assign rows of particles to the curves
-    for (size_t i = 0; i < fMasterCloud.height(); ++i) {
+    for (size_t i = nFirstRow; i < fMasterCloud.height(); ++i) {
         CXCurve aCurve;
         for (size_t j = 0; j < fMasterCloud.width(); ++j) {
             int pointIndex = j + (i * fMasterCloud.width());
-            aCurve.SetSliceIndex(
-                static_cast<int>(floor(fMasterCloud[pointIndex][2])));
+            auto aSliceIndex =
+                static_cast<int>(floor(fMasterCloud[pointIndex][2]));
+            fMaxSegIndex = std::max(fMaxSegIndex, aSliceIndex);
+            aCurve.SetSliceIndex(aSliceIndex);
             aCurve.InsertPoint(Vec2<double>(
                 fMasterCloud[pointIndex][0], fMasterCloud[pointIndex][1]));
         }
@@ -881,13 +1071,31 @@ void CWindow::SetCurrentCurve(int nCurrentSliceIndex)
     }
 }
 
+// Show the chain computed on the given slice by the running segmentation
+void CWindow::SetPreviewCurve(int nCurrentSliceIndex)
+{
+    auto chain = fPreviewChains.find(nCurrentSliceIndex);
+    if (chain == fPreviewChains.end()) {
+        fVolumeViewerWidget->ResetPreviewCurve();
+        return;
+    }
+
+    std::vector<cv::Vec2f> aCurve;
+    aCurve.reserve(chain->second.size());
+    for (const auto& p : chain->second) {
+        aCurve.emplace_back(p[0], p[1]);
+    }
+    fVolumeViewerWidget->SetPreviewCurve(std::move(aCurve));
+}
+
 // Open slice
 void CWindow::OpenSlice(void)
 {
     cv::Mat aImgMat;
     if (fVpkg != nullptr) {
-        aImgMat = currentVolume->getSliceDataCopy(fPathOnSliceIndex);
-        aImgMat.convertTo(aImgMat, CV_8UC1, 1.0 / 256.0);
+        // The viewer converts the visible tiles to 8-bit without modifying
+        // the slice, so the cached slice can be displayed directly
+        aImgMat = currentVolume->getSliceData(fPathOnSliceIndex);
     } else {
         aImgMat = cv::Mat::zeros(10, 10, CV_8UC1);
     }
@@ -907,9 +1115,25 @@ void CWindow::OpenSlice(void)
             params.thickness, params.baseline);
     }
 
-    auto aImgQImage = Mat2QImage(aImgMat);
-    fVolumeViewerWidget->SetImage(aImgQImage);
+    fVolumeViewerWidget->SetImage(aImgMat);
     fVolumeViewerWidget->SetImageIndex(fPathOnSliceIndex);
+    SetPreviewCurve(fPathOnSliceIndex);
+    UpdateObliqueSlice();
+}
+
+// Show the current volume in the oblique slice viewer and move its plane to
+// the current slice
+void CWindow::UpdateObliqueSlice(void)
+{
+    auto volume = fVpkg != nullptr ? currentVolume : nullptr;
+    fObliqueViewer->setVolume(volume);
+    if (volume == nullptr) {
+        return;
+    }
+
+    auto center = fObliqueViewer->center();
+    center[2] = fPathOnSliceIndex;
+    fObliqueViewer->setCenter(center);
 }
 
 // Initialize path list
@@ -1032,14 +1256,145 @@ void CWindow::CloseVolume(void)
 // Reset point cloud
 void CWindow::ResetPointCloud(void)
 {
+    CancelPointSetLoad();
     fMasterCloud.reset();
     fUpperPart.reset();
+    fResumedPart.reset();
     fStartingPath.clear();
+    fSegCache = SegmentationCache();
     fIntersections.clear();
     CXCurve emptyCurve;
     fIntersectionCurve = emptyCurve;
 }
 
+namespace
+{
+// Number of point set rows handed to the GUI at a time
+constexpr size_t POINTSET_BATCH_ROWS{256};
+}  // namespace
+
+// Read the current segmentation's point set in the background. The file is
+// memory mapped and handed to the GUI thread in batches of rows, so the
+// first slice is shown before the whole file has been read.
+void CWindow::LoadPointSet(void)
+{
+    CancelPointSetLoad();
+    auto cancel = std::make_shared<std::atomic<bool>>(false);
+    fPointSetCancel = cancel;
+    fLoadingPointSet = true;
+    statusBar->showMessage(tr("Loading point set..."));
+
+    auto segmentation = fSegmentation;
+    auto volume = currentVolume;
+    fPointSetLoader.start([this, segmentation, volume, cancel]() {
+        // Rows queued before a cancellation are dropped on the GUI thread
+        auto post = [this, cancel](vc::Segmentation::PointSet rows, bool done) {
+            QMetaObject::invokeMethod(
+                this,
+                [this, cancel, rows = std::move(rows), done]() {
+                    if (not *cancel) {
+                        OnPointSetRowsLoaded(rows, done);
+                    }
+                },
+                Qt::QueuedConnection);
+        };
+
+        try {
+            auto view = segmentation->getPointSetView();
+            const auto height = view.height();
+            if (height == 0) {
+                post(vc::Segmentation::PointSet(), true);
+                return;
+            }
+            for (size_t y = 0; y < height and not *cancel;
+                 y += POINTSET_BATCH_ROWS) {
+                auto end = std::min(y + POINTSET_BATCH_ROWS, height);
+                vc::Segmentation::PointSet rows(view.width());
+                rows.reserveRows(end - y);
+                for (auto r = y; r < end; r++) {
+                    rows.pushRow(view.getRow(r));
+                }
+
+                // Read the first slice into the cache before it is shown
+                if (y == 0 and volume != nullptr and not rows.empty()) {
+                    volume->getSliceData(
+                        static_cast<int>(std::floor(rows[0][2])));
+                }
+                post(std::move(rows), end == height);
+            }
+        } catch (const std::exception& e) {
+            QMetaObject::invokeMethod(
+                this,
+                [this, cancel, msg = std::string(e.what())]() {
+                    if (not *cancel) {
+                        OnPointSetLoadFailed(msg);
+                    }
+                },
+                Qt::QueuedConnection);
+        }
+    });
+}
+
+// Stop the running point set read, if any
+void CWindow::CancelPointSetLoad(void)
+{
+    if (fPointSetCancel != nullptr) {
+        *fPointSetCancel = true;
+        fPointSetCancel = nullptr;
+    }
+    fLoadingPointSet = false;
+}
+
+// Append rows from the point set loader. The segmentation's first slice is
+// opened with the first rows, and the current curve is updated as its row
+// arrives.
+void CWindow::OnPointSetRowsLoaded(
+    const vc::Segmentation::PointSet& nRows, bool nDone)
+{
+    if (not nRows.empty()) {
+        auto aFirstRow = fMasterCloud.height();
+        if (aFirstRow == 0) {
+            fMasterCloud.setWidth(nRows.width());
+        }
+        fMasterCloud.append(nRows);
+        AppendCurves(aFirstRow);
+
+        if (aFirstRow == 0) {
+            fPathOnSliceIndex = fMinSegIndex;
+            OpenSlice();
+        }
+        SetCurrentCurve(fPathOnSliceIndex);
+    }
+
+    if (nDone) {
+        fLoadingPointSet = false;
+        fPointSetCancel = nullptr;
+        if (fMasterCloud.empty()) {
+            statusBar->showMessage(tr("Selected point cloud is empty"));
+            vc::Logger()->warn("Segmentation point cloud is empty");
+        } else {
+            statusBar->clearMessage();
+        }
+    } else {
+        statusBar->showMessage(tr("Loading point set: %1 rows")
+                                   .arg(fMasterCloud.height()));
+    }
+    UpdateView();
+}
+
+// Report a failed point set read
+void CWindow::OnPointSetLoadFailed(const std::string& nError)
+{
+    vc::Logger()->error("Failed to load point set: {}", nError);
+    fLoadingPointSet = false;
+    fPointSetCancel = nullptr;
+    statusBar->showMessage(tr("Failed to load point set"));
+    QMessageBox::warning(
+        this, tr("Error"),
+        QString::fromStdString("Failed to load point set:\n\n" + nError));
+    UpdateView();
+}
+
 // Handle open request
 void CWindow::Open(void)
 {
@@ -1394,6 +1749,43 @@ void CWindow::OnPathChanged(void)
     }
 }
 
+// Show the cross-section of the sheet at the middle of the current curve. The
+// plane spans the curve normal and the slice axis.
+void CWindow::OnAlignObliqueSlice(void)
+{
+    if (fVpkg == nullptr) {
+        return;
+    }
+
+    // Use the segmentation's curve, or else the drawn path
+    std::vector<Vec2<double>> aPts;
+    for (size_t i = 0; i < fIntersectionCurve.GetPointsNum(); ++i) {
+        aPts.push_back(fIntersectionCurve.GetPoint(i));
+    }
+    if (aPts.size() < 2) {
+        aPts.clear();
+        fSplineCurve.GetSamplePoints(aPts);
+    }
+    if (aPts.size() < 2) {
+        statusBar->showMessage(tr("No curve on this slice"), 5000);
+        return;
+    }
+
+    auto mid = aPts.size() / 2;
+    const auto& prev = aPts[mid - 1];
+    const auto& next = aPts[std::min(mid + 1, aPts.size() - 1)];
+    cv::Vec3d aNormal{-(next[1] - prev[1]), next[0] - prev[0], 0};
+    if (cv::norm(aNormal) == 0) {
+        statusBar->showMessage(tr("Curve has no direction here"), 5000);
+        return;
+    }
+
+    fObliqueDock->show();
+    fObliqueDock->raise();
+    cv::Vec3d aCenter{aPts[mid][0], aPts[mid][1], double(fPathOnSliceIndex)};
+    fObliqueViewer->setPlane(aCenter, aNormal, {0, 0, 1});
+}
+
 bool CWindow::can_change_volume_()
 {
     return fVpkg != nullptr && fVpkg->numberOfVolumes() > 1 &&
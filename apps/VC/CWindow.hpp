@@ -1,5 +1,11 @@
 #pragma once
 
+#include <atomic>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
 #include <QCloseEvent>
 #include <QComboBox>
 #include <QMessageBox>
@@ -8,10 +14,10 @@
 #include <QShortcut>
 #include <QSpinBox>
 #include <QThread>
+#include <QThreadPool>
 #include <QTimer>
 #include <QtWidgets>
 
-#include "BlockingDialog.hpp"
 #include "CBSpline.hpp"
 #include "CXCurve.hpp"
 #include "MathUtils.hpp"
@@ -27,6 +33,7 @@ static constexpr int VOLPKG_SLICE_MIN_INDEX = 0;
 namespace ChaoVis
 {
 
+class CObliqueSliceViewer;
 class CVolumeViewerWithCurve;
 
 class CWindow : public QMainWindow
@@ -72,6 +79,7 @@ signals:
 public slots:
     void onSegmentationFinished(Segmenter::PointSet ps);
     void onSegmentationFailed(std::string s);
+    void onChainComputed(Segmenter::Chain c);
 
 public:
     CWindow();
@@ -100,13 +108,18 @@ private:
 
     void SplitCloud(void);
     void DoSegmentation(void);
+    void CacheSegmentationResult(const Segmenter::PointSet& ps);
     void CleanupSegmentation(void);
+    void StopSegmentationProgress(void);
     bool SetUpSegParams(void);
 
     void SetUpCurves(void);
+    void AppendCurves(size_t nFirstRow);
     void SetCurrentCurve(int nCurrentSliceIndex);
+    void SetPreviewCurve(int nCurrentSliceIndex);
 
     void OpenSlice(void);
+    void UpdateObliqueSlice(void);
 
     void InitPathList(void);
 
@@ -117,6 +130,12 @@ private:
 
     void ResetPointCloud(void);
 
+    void LoadPointSet(void);
+    void CancelPointSetLoad(void);
+    void OnPointSetRowsLoaded(
+        const volcart::Segmentation::PointSet& nRows, bool nDone);
+    void OnPointSetLoadFailed(const std::string& nError);
+
 private slots:
     void Open(void);
     void Close(void);
@@ -145,6 +164,7 @@ private slots:
     void OnEdtEndingSliceValChange();
 
     void OnBtnStartSegClicked(void);
+    void OnBtnCancelSegClicked(void);
 
     void OnEdtImpactRange(int nImpactRange);
 
@@ -154,6 +174,8 @@ private slots:
 
     void OnPathChanged(void);
 
+    void OnAlignObliqueSlice(void);
+
 private:
     // data model
     EWindowState fWindowState;
@@ -188,16 +210,46 @@ private:
     volcart::OrderedPointSet<cv::Vec3d> fUpperPart;
     std::vector<cv::Vec3d> fStartingPath;
 
+    // Per-slice chains computed by the previous segmentation run. When
+    // segmentation is restarted from an unedited slice with the same method
+    // and parameters, the cached chains are reused and only the slices past
+    // the end of the cache are recomputed.
+    struct SegmentationCache {
+        int method{-1};
+        std::string volumeID;
+        SSegParams params{};
+        std::map<int, std::vector<cv::Vec3d>> chains;
+    };
+    SegmentationCache fSegCache;
+    // Cached chains which precede the chain passed to the segmenter
+    volcart::OrderedPointSet<cv::Vec3d> fResumedPart;
+    // The running segmenter, if any, and the chains it has computed so far,
+    // keyed by slice. The chains are drawn as a preview on their slice.
+    Segmenter::Pointer fActiveSegmenter;
+    std::map<int, std::vector<cv::Vec3d>> fPreviewChains;
+
+    // Background read of the selected segmentation's point set. Rows are
+    // appended to fMasterCloud as they arrive, and editing is disabled until
+    // the read is done. Setting the flag cancels the read and drops the rows
+    // it has already queued.
+    QThreadPool fPointSetLoader;
+    std::shared_ptr<std::atomic<bool>> fPointSetCancel;
+    bool fLoadingPointSet{false};
+
     // window components
     QMenu* fFileMenu;
+    QMenu* fViewMenu;
     QMenu* fHelpMenu;
 
     QAction* fOpenVolAct;
     QAction* fSavePointCloudAct;
     QAction* fExitAct;
     QAction* fAboutAct;
+    QAction* fAlignObliqueAct;
 
     CVolumeViewerWithCurve* fVolumeViewerWidget;
+    QDockWidget* fObliqueDock;
+    CObliqueSliceViewer* fObliqueViewer;
     QListWidget* fPathListWidget;
     QPushButton* fPenTool;  // REVISIT - change me to QToolButton
     QPushButton* fSegTool;
@@ -234,11 +286,11 @@ private:
     bool can_change_volume_();
 
     QThread worker_thread_;
-    BlockingDialog worker_progress_;
     QTimer worker_progress_updater_;
     size_t progress_{0};
     QLabel* progressLabel_;
     QProgressBar* progressBar_;
+    QPushButton* cancelButton_;
 };  // class CWindow
 
 class VolPkgBackend : public QObject
@@ -254,12 +306,15 @@ signals:
     void segmentationFinished(Segmenter::PointSet ps);
     void segmentationFailed(std::string);
     void progressUpdated(size_t);
+    void chainComputed(Segmenter::Chain);
 
 public slots:
     void startSegmentation(Segmenter::Pointer segmenter)
     {
         segmenter->progressUpdated.connect(
             [=](size_t p) { progressUpdated(p); });
+        segmenter->chainUpdated.connect(
+            [=](Segmenter::Chain c) { chainComputed(std::move(c)); });
         segmentationStarted(segmenter->progressIterations());
         try {
             auto result = segmenter->compute();
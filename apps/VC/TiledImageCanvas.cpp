@@ -0,0 +1,190 @@
+#include "TiledImageCanvas.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include <QPaintEvent>
+#include <QPainter>
+#include <opencv2/imgproc.hpp>
+
+using namespace ChaoVis;
+
+namespace
+{
+// Number of cached tiles above which unused tiles are dropped
+constexpr std::size_t MAX_CACHED_TILES{256};
+
+// Convert a region of an image to an 8-bit pixmap
+auto ToPixmap(const cv::Mat& region) -> QPixmap
+{
+    cv::Mat tmp;
+    if (region.depth() == CV_16U) {
+        region.convertTo(tmp, CV_8U, 1.0 / 256.0);
+    } else {
+        tmp = region;
+    }
+
+    // Don't convert the color in place: tmp may share the displayed image
+    auto format = QImage::Format_Grayscale8;
+    if (tmp.channels() == 3) {
+        cv::Mat rgb;
+        cv::cvtColor(tmp, rgb, cv::COLOR_BGR2RGB);
+        tmp = rgb;
+        format = QImage::Format_RGB888;
+    }
+
+    // fromImage() copies the pixels
+    QImage img(
+        tmp.data, tmp.cols, tmp.rows, static_cast<qsizetype>(tmp.step),
+        format);
+    return QPixmap::fromImage(img);
+}
+}  // namespace
+
+TiledImageCanvas::TiledImageCanvas(QWidget* parent) : QWidget(parent)
+{
+    // Every paint covers the exposed region with tiles
+    setAttribute(Qt::WA_OpaquePaintEvent);
+}
+
+void TiledImageCanvas::setImage(const cv::Mat& img)
+{
+    levels_.clear();
+    tiles_.clear();
+    if (not img.empty()) {
+        levels_.push_back(img);
+    }
+    setScale(scale_);
+}
+
+auto TiledImageCanvas::hasImage() const -> bool { return not levels_.empty(); }
+
+auto TiledImageCanvas::imageSize() const -> QSize
+{
+    if (not hasImage()) {
+        return {};
+    }
+    return {levels_[0].cols, levels_[0].rows};
+}
+
+void TiledImageCanvas::setScale(double scale)
+{
+    scale_ = scale;
+    if (hasImage()) {
+        auto size = imageSize();
+        resize(
+            static_cast<int>(std::round(size.width() * scale_)),
+            static_cast<int>(std::round(size.height() * scale_)));
+    }
+    update();
+}
+
+auto TiledImageCanvas::scale() const -> double { return scale_; }
+
+void TiledImageCanvas::setOverlay(Overlay overlay)
+{
+    overlay_ = std::move(overlay);
+    update();
+}
+
+void TiledImageCanvas::paintEvent(QPaintEvent* event)
+{
+    QPainter painter(this);
+    if (not hasImage() or width() == 0 or height() == 0) {
+        return;
+    }
+    paintCount_++;
+
+    // Widget pixels per pixel of the displayed level
+    auto level = display_level_();
+    const auto& img = level_(level);
+    auto fx = static_cast<double>(width()) / img.cols;
+    auto fy = static_cast<double>(height()) / img.rows;
+
+    // Tiles which intersect the exposed region
+    const auto r = event->rect();
+    auto firstCol = static_cast<int>(r.left() / fx) / TILE_SIZE;
+    auto firstRow = static_cast<int>(r.top() / fy) / TILE_SIZE;
+    auto lastCol = std::min(
+        static_cast<int>((r.left() + r.width()) / fx) / TILE_SIZE,
+        (img.cols - 1) / TILE_SIZE);
+    auto lastRow = std::min(
+        static_cast<int>((r.top() + r.height()) / fy) / TILE_SIZE,
+        (img.rows - 1) / TILE_SIZE);
+
+    painter.setRenderHint(QPainter::SmoothPixmapTransform, fx < 1.0);
+    for (auto y = firstRow; y <= lastRow; y++) {
+        for (auto x = firstCol; x <= lastCol; x++) {
+            const auto& pixmap = tile_(level, x, y);
+            QRectF target(
+                x * TILE_SIZE * fx, y * TILE_SIZE * fy, pixmap.width() * fx,
+                pixmap.height() * fy);
+            painter.drawPixmap(target, pixmap, QRectF(pixmap.rect()));
+        }
+    }
+
+    if (overlay_) {
+        auto size = imageSize();
+        painter.scale(
+            static_cast<double>(width()) / size.width(),
+            static_cast<double>(height()) / size.height());
+        overlay_(painter);
+    }
+
+    evict_tiles_();
+}
+
+auto TiledImageCanvas::display_level_() -> int
+{
+    // Use the smallest level which is still at least as large as the
+    // displayed image
+    int level{0};
+    auto factor = scale_;
+    auto size = imageSize();
+    while (factor <= 0.5 and (size.width() >> (level + 1)) > 0 and
+           (size.height() >> (level + 1)) > 0) {
+        factor *= 2;
+        level++;
+    }
+    return level;
+}
+
+auto TiledImageCanvas::level_(int level) -> const cv::Mat&
+{
+    while (static_cast<int>(levels_.size()) <= level) {
+        const auto& prev = levels_.back();
+        cv::Mat next;
+        cv::resize(
+            prev, next, {(prev.cols + 1) / 2, (prev.rows + 1) / 2}, 0, 0,
+            cv::INTER_AREA);
+        levels_.push_back(next);
+    }
+    return levels_[level];
+}
+
+auto TiledImageCanvas::tile_(int level, int x, int y) -> const QPixmap&
+{
+    auto& cached = tiles_[{level, x, y}];
+    if (cached.pixmap.isNull()) {
+        const auto& img = level_(level);
+        cv::Rect roi(x * TILE_SIZE, y * TILE_SIZE, TILE_SIZE, TILE_SIZE);
+        roi &= cv::Rect(0, 0, img.cols, img.rows);
+        cached.pixmap = ToPixmap(img(roi));
+    }
+    cached.lastUsed = paintCount_;
+    return cached.pixmap;
+}
+
+void TiledImageCanvas::evict_tiles_()
+{
+    if (tiles_.size() <= MAX_CACHED_TILES) {
+        return;
+    }
+    for (auto it = tiles_.begin(); it != tiles_.end();) {
+        if (it->second.lastUsed != paintCount_) {
+            it = tiles_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
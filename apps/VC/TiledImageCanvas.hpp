@@ -0,0 +1,103 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <tuple>
+#include <vector>
+
+#include <QPixmap>
+#include <QWidget>
+#include <opencv2/core.hpp>
+
+namespace ChaoVis
+{
+
+/**
+ * @brief Widget which draws a large image at a zoom factor
+ *
+ * The image is split into square tiles. Tiles are converted to QPixmaps the
+ * first time they are visible, so changing the image only costs the
+ * conversion of the tiles in the viewport. When zoomed out, tiles are taken
+ * from a downsampled copy of the image whose resolution is closest to the
+ * zoom level. Downsampled copies are also built on demand.
+ *
+ * The widget is meant to be placed in a QScrollArea, which limits painting
+ * to the visible region.
+ */
+class TiledImageCanvas : public QWidget
+{
+    Q_OBJECT
+
+public:
+    /** Draws on top of the image. The painter is in image coordinates. */
+    using Overlay = std::function<void(QPainter&)>;
+
+    /** Tile size in pixels */
+    static constexpr int TILE_SIZE{512};
+
+    /** Constructor */
+    explicit TiledImageCanvas(QWidget* parent = nullptr);
+
+    /**
+     * @brief Set the displayed image
+     *
+     * The image may be 8- or 16-bit, with 1 channel or 3 channels in BGR
+     * order. 16-bit images are displayed at 8 bits. The image is not copied
+     * and must not be modified while it is displayed.
+     */
+    void setImage(const cv::Mat& img);
+
+    /** @brief Whether an image has been set */
+    [[nodiscard]] auto hasImage() const -> bool;
+
+    /** @brief Size of the image at full resolution */
+    [[nodiscard]] auto imageSize() const -> QSize;
+
+    /** @brief Set the zoom factor and resize the widget to match */
+    void setScale(double scale);
+
+    /** @brief Get the zoom factor */
+    [[nodiscard]] auto scale() const -> double;
+
+    /** @brief Set the function which draws on top of the image */
+    void setOverlay(Overlay overlay);
+
+protected:
+    void paintEvent(QPaintEvent* event) override;
+
+private:
+    /** Pyramid level to display at the current scale */
+    auto display_level_() -> int;
+
+    /** Get a pyramid level, building it if needed */
+    auto level_(int level) -> const cv::Mat&;
+
+    /** Get a tile, converting it if needed */
+    auto tile_(int level, int x, int y) -> const QPixmap&;
+
+    /** Drop tiles which were not used by the latest paint */
+    void evict_tiles_();
+
+    /** Tile key: level, column, row */
+    using TileKey = std::tuple<int, int, int>;
+
+    /** Tile and the paint which last used it */
+    struct CachedTile {
+        QPixmap pixmap;
+        std::uint64_t lastUsed{0};
+    };
+
+    /** Full-resolution image followed by its downsampled copies */
+    std::vector<cv::Mat> levels_;
+    /** Converted tiles */
+    std::map<TileKey, CachedTile> tiles_;
+    /** Counter of paint events, for tile eviction */
+    std::uint64_t paintCount_{0};
+    /** Zoom factor */
+    double scale_{1.0};
+    /** Overlay function */
+    Overlay overlay_;
+};
+
+}  // namespace ChaoVis
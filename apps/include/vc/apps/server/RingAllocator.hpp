@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstddef>
+#include <map>
+#include <optional>
+
+namespace volcart
+{
+
+/**
+ * @brief Allocator of the regions of a ring buffer
+ *
+ * Regions are placed one after another, starting at the end of the most
+ * recently allocated region and wrapping around to the start of the buffer
+ * once the end is reached. Regions may be released in any order, and their
+ * space is reused as soon as the search for free space reaches it, so a
+ * region which is held for a long time does not block the rest of the ring.
+ *
+ * Not thread-safe.
+ */
+class RingAllocator
+{
+public:
+    /** Alignment of the regions, in bytes */
+    static constexpr std::size_t ALIGNMENT{64};
+
+    /** Construct an allocator for a ring of `capacity` bytes. */
+    explicit RingAllocator(std::size_t capacity);
+
+    /**
+     * @brief Allocate a region of `size` bytes
+     *
+     * The size is rounded up to a multiple of ALIGNMENT. Returns the
+     * region's offset, or nothing if the ring does not have enough
+     * contiguous free space.
+     */
+    auto allocate(std::size_t size) -> std::optional<std::size_t>;
+
+    /**
+     * @brief Release the region at `offset`
+     *
+     * Returns false if no region is allocated at `offset`.
+     */
+    auto release(std::size_t offset) -> bool;
+
+    /** Get the ring's size in bytes. */
+    [[nodiscard]] auto capacity() const -> std::size_t;
+
+    /** Get the number of allocated regions. */
+    [[nodiscard]] auto size() const -> std::size_t;
+
+    /** Get the number of allocated bytes, including alignment padding. */
+    [[nodiscard]] auto bytes() const -> std::size_t;
+
+private:
+    /**
+     * Get the offset of the first free space of `size` bytes which starts
+     * at or after `from`
+     */
+    [[nodiscard]] auto findFree_(std::size_t from, std::size_t size) const
+        -> std::optional<std::size_t>;
+
+    /** Ring size */
+    std::size_t capacity_;
+    /** Sizes of the allocated regions by offset */
+    std::map<std::size_t, std::size_t> regions_;
+    /** Offset just past the newest region */
+    std::size_t head_{0};
+    /** Number of allocated bytes */
+    std::size_t bytes_{0};
+};
+
+}  // namespace volcart
@@ -1,34 +1,197 @@
 #pragma once
 
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include <QByteArray>
+#include <QLocalSocket>
 #include <QObject>
+#include <QSharedMemory>
 #include <QTcpSocket>
 
+#include "vc/apps/server/VolumeProtocol.hpp"
+
 namespace volcart
 {
 
-/** Class implementing a sample client that uses the VolumeProtocol. */
+/**
+ * Asynchronous client for the VolumeProtocol.
+ *
+ * Requests are sent as protocol::Version::V2 packets with
+ * protocol::RequestFlag::KeepAlive, so any number of requests can be in
+ * flight on the connection at once: request() returns immediately and its
+ * callback is called when the response arrives. Requests made before the
+ * connection is established are sent once it is. Large sub-volumes may be
+ * received in chunks (protocol::RequestFlag::Chunked), which are combined
+ * before the callback is called.
+ *
+ * The client must be used from the thread which owns it. Callbacks are
+ * called on that thread.
+ */
 class VolumeClient : public QObject
 {
     Q_OBJECT
 
 public:
+    /** The response to a sub-volume request */
+    struct Response {
+        /** Response header */
+        protocol::ResponseArgsV2 args{};
+        /**
+         * Decoded `uint16_t` voxels, x fastest. Empty if the request failed.
+         *
+         * Voxels received through the shared memory ring are not copied.
+         * They remain valid while the response, or a copy of it, exists.
+         * Copy the voxels to keep them for longer.
+         */
+        QByteArray voxels;
+        /**
+         * Shared memory ring responses only: releases the voxels once every
+         * copy of the response has been destroyed, so that the server can
+         * reuse their space. Must be destroyed on the client's thread.
+         */
+        std::shared_ptr<void> release;
+    };
+
+    /** Callback for the response to a request */
+    using Callback = std::function<void(const Response&)>;
+
+    /** Callback for the responses to a batch of requests, in request order */
+    using BatchCallback = std::function<void(const std::vector<Response>&)>;
+
     /** Construct a new VolumeClient object. */
     explicit VolumeClient(
         const QString& ip, quint16 port, QObject* parent = nullptr);
 
+    /**
+     * Construct a VolumeClient which connects to the local socket `name`.
+     *
+     * If the server has a shared memory ring, the client attaches to it and
+     * accepts protocol::Codec::SharedMemory responses.
+     */
+    explicit VolumeClient(const QString& name, QObject* parent = nullptr);
+
+    /**
+     * Request a sub-volume.
+     *
+     * Returns the request's ID, which is also the `requestId` of its
+     * response.
+     */
+    auto request(const protocol::RequestArgs& args, Callback callback)
+        -> uint32_t;
+
+    /**
+     * Request several sub-volumes in a single request packet.
+     *
+     * `callback` is called once every response has arrived. Returns the ID
+     * of the first request. The requests have consecutive IDs.
+     */
+    auto request(
+        const std::vector<protocol::RequestArgs>& args,
+        BatchCallback callback) -> uint32_t;
+
+    /**
+     * Request the 2D image of an oblique plane.
+     *
+     * The response's voxels are the `width` x `height` image, row by row.
+     * Returns the request's ID.
+     *
+     * @see protocol::ResliceArgs
+     */
+    auto reslice(const protocol::ResliceArgs& args, Callback callback)
+        -> uint32_t;
+
+    /**
+     * Request the images of several planes in a single request packet.
+     *
+     * `callback` is called once every response has arrived. Returns the ID
+     * of the first request. The requests have consecutive IDs.
+     */
+    auto reslice(
+        const std::vector<protocol::ResliceArgs>& args,
+        BatchCallback callback) -> uint32_t;
+
+    /**
+     * Set the protocol::RequestHdr::priority of subsequent requests.
+     * Defaults to 0.
+     */
+    void setPriority(uint8_t priority);
+
+    /** Get the number of requests which have not been answered. */
+    [[nodiscard]] auto pending() const -> std::size_t;
+
+    /**
+     * Close the connection.
+     *
+     * Pending requests are answered with empty responses.
+     */
+    void close();
+
+signals:
+    /** Called when the connection has been established. */
+    void connected();
+
+    /** Called when it is time to exit the application. */
+    void finished();
+
 private slots:
     /** Called when a new connection has been established. */
     void newConnection();
+    /** Called when response data is ready to be read. */
+    void readResponses();
+    /** Called when the connection has been closed. */
+    void connectionClosed();
     /** Called when an existing connection has an error. */
     void connectionError(QAbstractSocket::SocketError socketError);
-
-signals:
-    /** Called when it is time to exit the application. */
-    void finished();
+    /** Called when an existing local connection has an error. */
+    void localConnectionError(QLocalSocket::LocalSocketError socketError);
 
 private:
     /** Store a pointer to the client connection socket. */
-    QTcpSocket* client_;
+    QIODevice* client_;
+
+    /** The server's shared memory ring, if attached. */
+    std::unique_ptr<QSharedMemory> ring_;
+
+    /** Whether the connection has been established */
+    bool connected_{false};
+
+    /** Request packets waiting for the connection to be established */
+    QByteArray unsent_;
+
+    /** ID of the next request */
+    uint32_t nextRequestId_{0};
+
+    /** Priority of new requests */
+    uint8_t priority_{0};
+
+    /** Callbacks of the requests which have not been answered */
+    std::unordered_map<uint32_t, Callback> pending_;
+
+    /** Chunks received so far of chunked responses, by request ID */
+    std::unordered_map<uint32_t, Response> partial_;
+
+    /**
+     * Send a request packet and register the callback of each request.
+     *
+     * `args` holds one request argument structure per callback. `flags` are
+     * added to the packet's protocol::RequestHdr::flags.
+     */
+    auto send_(
+        const char* args,
+        std::size_t size,
+        uint8_t flags,
+        std::vector<Callback> callbacks) -> uint32_t;
+
+    /** Decode a response from its header and data. */
+    auto decode_(const protocol::ResponseArgsV2& args, const QByteArray& data)
+        -> Response;
+
+    /** Answer every pending request with an empty response. */
+    void failPending_();
 };
 
 }  // namespace volcart
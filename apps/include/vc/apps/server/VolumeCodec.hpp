@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+
+#include <QByteArray>
+
+#include "vc/apps/server/VolumeProtocol.hpp"
+
+namespace volcart::protocol
+{
+
+/**
+ * Select the codec used to encode a response.
+ *
+ * Returns the preferred codec from the set of accepted codecs, a bitwise OR
+ * of CodecFlag() values. Codec::None is always acceptable.
+ */
+auto SelectCodec(uint8_t accepted) -> Codec;
+
+/** Encode `size` bytes of `uint16_t` voxel data with the given codec. */
+auto Encode(Codec codec, const char* data, std::size_t size) -> QByteArray;
+
+/**
+ * Decode voxel data encoded with Encode().
+ *
+ * @throws std::runtime_error if the data cannot be decoded to `rawSize`
+ * bytes
+ */
+auto Decode(Codec codec, const QByteArray& data, std::size_t rawSize)
+    -> QByteArray;
+
+}  // namespace volcart::protocol
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cstdint>
+#include <string>
 
 namespace volcart::protocol
 {
@@ -17,8 +18,88 @@ constexpr uint32_t VOLPKG_SZ = 64;
 /** Size of a volume identifier. */
 constexpr uint32_t VOLUME_SZ = 64;
 
-/** Enumeration of protocol versions. */
-enum Version : uint8_t { V1 = 1 };
+/**
+ * Enumeration of protocol versions.
+ *
+ * - V1: Responses are sent in request order using ResponseArgs.
+ * - V2: Responses are sent as soon as they are ready, possibly out of order,
+ *   using ResponseArgsV2. Response data may be compressed with any Codec
+ *   the client lists in RequestHdr::codecs.
+ */
+enum Version : uint8_t { V1 = 1, V2 = 2 };
+
+/** Enumeration of response data encodings (Version::V2). */
+enum Codec : uint8_t {
+    /** Raw, native-endian `uint16_t` voxels */
+    None = 0,
+    /** zlib compressed voxels */
+    Zlib = 1,
+    /**
+     * zlib compressed voxels, after byte shuffling: all low-order bytes,
+     * followed by all high-order bytes
+     */
+    ZlibShuffle = 2,
+    /**
+     * Raw, native-endian `uint16_t` voxels in the server's shared memory
+     * ring (see SharedMemoryKey()). The response data is a SharedMemoryRef.
+     * Only used for clients connected to the server's local socket.
+     */
+    SharedMemory = 3
+};
+
+/** Get the RequestHdr::codecs bit for a codec. */
+constexpr auto CodecFlag(Codec c) -> uint8_t
+{
+    return static_cast<uint8_t>(1U << c);
+}
+
+/** Enumeration of request packet flags (Version::V2). */
+enum RequestFlag : uint8_t {
+    /**
+     * Keep the connection open once the responses to the packet have been
+     * sent, so that the client can send more request packets on the same
+     * connection without waiting for earlier responses. The `requestId` of
+     * a response then counts the requests of every packet sent on the
+     * connection, starting from 0. The server reads the packets of a
+     * connection until it receives a packet without this flag.
+     */
+    KeepAlive = 1,
+    /**
+     * The packet's requests are ResliceArgs rather than RequestArgs. Each
+     * response holds a single 2D image with `extentZ == 1`. Reslice and
+     * sub-volume requests may be mixed on a KeepAlive connection by sending
+     * them in separate packets.
+     */
+    ResliceRequests = 2,
+    /**
+     * Allow the server to split sub-volume responses into chunks of whole
+     * z-slices (see ResponseFlag::MoreChunks), so that it can send large
+     * sub-volumes while they are generated. Responses through the shared
+     * memory ring and reslice responses are never split.
+     */
+    Chunked = 4,
+    /**
+     * The packet releases Codec::SharedMemory responses instead of making
+     * requests. It holds `numRequests` SharedMemoryRef of responses which
+     * the client has read, and the server reuses their ring space. The
+     * packet has no responses and does not end the connection.
+     */
+    ReleaseShared = 8
+};
+
+/** Enumeration of response flags (Version::V2). */
+enum ResponseFlag : uint8_t {
+    /**
+     * More chunks of this response follow (RequestFlag::Chunked). Each chunk
+     * has its own ResponseArgsV2 header with the response's `requestId`,
+     * `extentX`, and `extentY`, and its number of slices as `extentZ`.
+     * Chunks are sent in slice order, but may be interleaved with other
+     * responses. The last chunk does not have this flag. If the server fails
+     * to generate a later chunk, the last chunk is empty with all extents 0,
+     * and the client should discard the response.
+     */
+    MoreChunks = 1
+};
 
 // TODO: Add a request/response flag so that we can share a uniform prefix
 // header for all packets.
@@ -27,10 +108,27 @@ enum Version : uint8_t { V1 = 1 };
 struct RequestHdr {
     uint32_t magic{MAGIC};
     Version version{Version::V1};
-    uint8_t pad[3];
+    /** V2 only: Bitwise OR of the CodecFlag() of every accepted codec. */
+    uint8_t codecs{0};
+    /** V2 only: Bitwise OR of RequestFlag values. */
+    uint8_t flags{0};
+    /**
+     * V2 only: Scheduling priority of the packet's requests, from 0 to
+     * MAX_PRIORITY. Higher values are clamped to MAX_PRIORITY.
+     *
+     * The server shares its workers fairly between connections, in
+     * proportion to the number of voxels of their requests. Each step of
+     * priority doubles a request's share, so that small, high priority
+     * requests (e.g. of a viewer) are resolved ahead of large, low priority
+     * requests (e.g. of a batch job) which were queued earlier.
+     */
+    uint8_t priority{0};
     uint32_t numRequests{0};
 };
 
+/** Highest RequestHdr::priority */
+constexpr uint8_t MAX_PRIORITY = 16;
+
 /** Packet structure for arguments to a given request. */
 struct RequestArgs {
     // TODO: Move volpkg and volume to UUIDs (128-bit) once the VolumePkg class
@@ -55,6 +153,35 @@ struct RequestArgs {
     float samplingInterval;
 };
 
+/**
+ * Packet structure for arguments to a reslice request
+ * (RequestFlag::ResliceRequests).
+ *
+ * Requests the `width` x `height` image of the plane through `center` which
+ * is spanned by the `xvec` and `yvec` axes, as generated by Volume::reslice().
+ * Positions are in full-resolution voxels. The image is sampled from
+ * resolution level `level` of the volume (see Volume::level()) with a
+ * spacing of one level voxel, so each pixel covers `2^level` full-resolution
+ * voxels along each axis. Requests for a level which the volume does not
+ * have receive an empty response.
+ */
+struct ResliceArgs {
+    char volpkg[VOLPKG_SZ];
+    char volume[VOLUME_SZ];
+    float centerX;
+    float centerY;
+    float centerZ;
+    float xvecX;
+    float xvecY;
+    float xvecZ;
+    float yvecX;
+    float yvecY;
+    float yvecZ;
+    uint32_t width;
+    uint32_t height;
+    uint32_t level;
+};
+
 /** Packet structure for a response to a request. */
 struct ResponseArgs {
     char volpkg[VOLPKG_SZ];
@@ -65,4 +192,53 @@ struct ResponseArgs {
     uint32_t size;
 };
 
+/**
+ * Response data of a Codec::SharedMemory response.
+ *
+ * The voxels are the `rawSize` bytes at `offset` in the shared memory ring.
+ * They remain valid until the client releases them with a
+ * RequestFlag::ReleaseShared packet or closes the connection. Clients should
+ * release each response once they have read it, since the server cannot
+ * reuse the space of unreleased responses. The server does not close
+ * connections which received Codec::SharedMemory responses, so clients
+ * without RequestFlag::KeepAlive must close the connection once they have
+ * read the voxels.
+ */
+struct SharedMemoryRef {
+    /** Offset of the voxels in the shared memory ring */
+    uint64_t offset;
+};
+
+/** Get the shared memory key of the ring of a server's local socket. */
+inline auto SharedMemoryKey(const std::string& serverName) -> std::string
+{
+    return serverName + ".ring";
+}
+
+/**
+ * Packet structure for a response to a request (Version::V2).
+ *
+ * Responses may arrive in any order. `requestId` is the index of the
+ * corresponding RequestArgs in the request packet (see also
+ * RequestFlag::KeepAlive). The data is encoded with
+ * `codec`, which is always one of the codecs accepted by the client.
+ */
+struct ResponseArgsV2 {
+    char volpkg[VOLPKG_SZ];
+    char volume[VOLUME_SZ];
+    uint32_t requestId;
+    uint32_t extentX;
+    uint32_t extentY;
+    uint32_t extentZ;
+    /** Size of the encoded data which follows this header */
+    uint32_t size;
+    /** Size of the data once decoded */
+    uint32_t rawSize;
+    /** Encoding of the data */
+    Codec codec;
+    /** Bitwise OR of ResponseFlag values */
+    uint8_t flags;
+    uint8_t pad[2];
+};
+
 }  // namespace volcart::protocol
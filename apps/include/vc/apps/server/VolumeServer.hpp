@@ -1,11 +1,20 @@
 #pragma once
 
-#include <QDataStream>
+#include <QByteArray>
+#include <QLocalServer>
 #include <QObject>
+#include <QPointer>
+#include <QSharedMemory>
 #include <QTcpServer>
 #include <QTcpSocket>
+#include <QThreadPool>
+#include <QTimer>
 #include <map>
+#include <memory>
+#include <optional>
+#include <vector>
 
+#include "vc/apps/server/RingAllocator.hpp"
 #include "vc/apps/server/VolumeProtocol.hpp"
 #include "vc/core/types/Volume.hpp"
 #include "vc/core/types/VolumePkg.hpp"
@@ -13,7 +22,40 @@
 namespace volcart
 {
 
-/** Class for implementing the VolumeServer. */
+/**
+ * Class for implementing the VolumeServer.
+ *
+ * Sub-volume requests are computed on a pool of worker threads, so that a
+ * large request does not block other clients. Version::V2 clients receive
+ * each response as soon as it is ready. Version::V1 clients receive their
+ * responses in request order.
+ *
+ * Besides TCP, the server can listen on a local (Unix domain) socket for
+ * clients on the same host. Local Version::V2 clients can also receive their
+ * sub-volumes through a shared memory ring: the workers write each
+ * sub-volume in place in the ring and only a protocol::SharedMemoryRef is
+ * sent over the socket.
+ *
+ * Version::V2 clients may keep their connection open with
+ * protocol::RequestFlag::KeepAlive and pipeline any number of request
+ * packets on it. Version::V2 packets with
+ * protocol::RequestFlag::ResliceRequests request 2D images of oblique
+ * planes instead of sub-volumes (see protocol::ResliceArgs), which are
+ * generated with Volume::reslice() at the requested resolution level.
+ *
+ * Clients which set protocol::RequestFlag::Chunked receive large
+ * sub-volumes in chunks of slices. Each chunk is generated once the client
+ * has read most of the previous ones, so the server's memory use per
+ * request is bounded and the first chunk is sent before the whole
+ * sub-volume has been generated.
+ *
+ * Requests wait in a queue per connection and are passed to the workers
+ * with start-time fair queuing: each connection receives a share of the
+ * workers in proportion to the voxels it requests, weighted by the
+ * protocol::RequestHdr::priority of its requests. A client which queues
+ * many large requests therefore does not delay the requests of other
+ * clients by more than about one request per worker.
+ */
 class VolumeServer : public QObject
 {
     Q_OBJECT
@@ -25,19 +67,73 @@ public:
     /** Convenience type for a map of strings to Volume pointers. */
     using VolumeMap = std::unordered_map<std::string, Volume::Pointer>;
 
-    /** Construct a new VolumeServer object. */
+    /**
+     * Construct a new VolumeServer object.
+     *
+     * If `threads` is 0, uses one worker thread per CPU core. Every loaded
+     * volume shares a slice cache of size `memory` which uses the
+     * replacement policy `cachePolicy`.
+     */
     explicit VolumeServer(
         VolumePkgMap volpkgs,
         quint16 port,
         std::size_t memory,
+        int threads = 0,
+        Volume::CachePolicy cachePolicy = Volume::CachePolicy::LRU,
         QObject* parent = nullptr);
 
+    /** Wait for in-flight requests to finish and log cache statistics. */
+    ~VolumeServer() override;
+
+    /**
+     * Log the cache statistics of every loaded volume every `seconds`
+     * seconds. If `seconds` is 0, disables periodic logging.
+     */
+    void setCacheStatsInterval(int seconds);
+
+    /** Log the cache statistics of every loaded volume. */
+    void logCacheStats();
+
+    /**
+     * Reject requests for sub-volumes larger than `bytes`. Rejected requests
+     * receive an empty response. If `bytes` is 0, the size of requests is
+     * not limited.
+     */
+    void setMaxRequestSize(std::size_t bytes);
+
+    /**
+     * Cache up to `bytes` of encoded responses, so that repeated requests
+     * (e.g. the patches of every epoch of a training job) are answered
+     * without generating their sub-volumes again. Responses are keyed by
+     * their request arguments and by the protocol version and codecs of the
+     * client, and are evicted in least recently used order. Responses
+     * through the shared memory ring and chunked responses are not cached.
+     * If `bytes` is 0 (default), disables the cache.
+     */
+    void setResponseCacheSize(std::size_t bytes);
+
+    /**
+     * Also listen on the local socket `name`.
+     *
+     * If `ringBytes` is greater than 0, creates a shared memory ring of
+     * that size with the key protocol::SharedMemoryKey(`name`). Responses to
+     * local clients which accept protocol::Codec::SharedMemory are written
+     * to the ring. A response which does not fit in the free space of the
+     * ring is sent over the socket. The space of a response is reused once
+     * the client releases it with a protocol::RequestFlag::ReleaseShared
+     * packet or closes the connection.
+     *
+     * Returns false if the socket or the ring cannot be created.
+     */
+    bool listenLocal(const QString& name, std::size_t ringBytes = 0);
+
 private slots:
     /** Called when a new client connection has been established. */
     void acceptConnection();
 
-    /** Called when a socket is ready to be read from. */
-    void socketReadyRead(QDataStream* dataStream);
+    /** Called when a new local client connection has been established. */
+    void acceptLocalConnection();
+
 
 signals:
     /** Called when it's time to exit the application. */
@@ -47,6 +143,21 @@ private:
     /** A pointer to the TCP server object. */
     QTcpServer* server_;
 
+    /** A pointer to the local socket server object, if listening. */
+    QLocalServer* localServer_{nullptr};
+
+    /** Shared memory ring for local clients. */
+    std::unique_ptr<QSharedMemory> ring_;
+
+    /** Allocated regions of ring_. */
+    std::unique_ptr<RingAllocator> ringAllocator_;
+
+    /**
+     * Client socket of each region of ring_ whose response has been sent
+     * and not yet released by the client.
+     */
+    std::map<std::size_t, QPointer<QIODevice>> sentRegions_;
+
     /** A map of loaded volpkgs identified by string key. */
     VolumePkgMap volpkgs_;
 
@@ -56,11 +167,117 @@ private:
     /** How much memory the server should use for caching volumes. */
     std::size_t memory_;
 
+    /** Slice and block cache shared by every loaded volume. */
+    Volume::SharedSliceCache::Pointer cache_;
+
+    /** Worker threads for resolving requests. */
+    QThreadPool pool_;
+
+    /** Timer for periodic cache statistics. */
+    QTimer statsTimer_;
+
+    /** State of a client connection. */
+    struct Connection;
+
+    /** State for the responses to one request packet. */
+    struct Batch;
+
+    /** A request waiting for a worker. */
+    struct Job;
+
+    /** State of a sub-volume response which is sent in chunks. */
+    struct ChunkedResponse;
+
+    /** Cache of encoded responses. */
+    struct ResponseCache;
+
+    /** Response cache, if enabled. Only used from the server's thread. */
+    std::unique_ptr<ResponseCache> responseCache_;
+
+    /** Connections with queued requests. */
+    std::vector<std::shared_ptr<Connection>> queued_;
+
+    /** Fair queuing virtual time: start tag of the last started request. */
+    double virtualTime_{0};
+
+    /** Number of requests being resolved by the workers. */
+    int running_{0};
+
+    /** Largest accepted sub-volume, in bytes. 0 if unlimited. */
+    std::size_t maxRequestSize_{0};
+
+    /** Start reading the request packets of a new client connection. */
+    void openConnection_(QIODevice* socket);
+
+    /** Read and dispatch the complete request packets of a connection. */
+    void readRequests_(const std::shared_ptr<Connection>& connection);
+
     /** Generate a string for representing a socket. */
-    std::string socketStr_(QTcpSocket* socket);
+    std::string socketStr_(QIODevice* socket);
+
+    /**
+     * Get a volume by volpkg and volume name, loading it if necessary.
+     * Returns nullptr if the volume cannot be loaded.
+     */
+    Volume::Pointer getVolume_(
+        QIODevice* socket, const protocol::RequestArgs& args);
+
+    /**
+     * Queue a single request for the worker pool. If `reslice` is set, the
+     * request is a reslice request and `args` only holds its volume names.
+     */
+    void resolveRequest_(
+        const std::shared_ptr<Connection>& connection,
+        const std::shared_ptr<Batch>& batch,
+        uint32_t requestId,
+        const protocol::RequestArgs& args,
+        const std::optional<protocol::ResliceArgs>& reslice = std::nullopt);
+
+    /** Start queued requests while there are idle workers. */
+    void schedule_();
+
+    /** Resolve a request on the worker pool. */
+    void start_(Job job);
+
+    /**
+     * Generate the next chunk of a chunked response on the worker pool.
+     * Must be called on the server's thread.
+     */
+    void generateChunk_(const std::shared_ptr<ChunkedResponse>& chunks);
+
+    /**
+     * Write a chunk which is not the last of its response, then generate the
+     * next chunk once the socket's buffered data has been drained.
+     */
+    void writeChunk_(
+        const std::shared_ptr<ChunkedResponse>& chunks,
+        const QByteArray& chunk);
+
+    /** Write the last chunk of a chunked response and release its worker. */
+    void finishChunks_(
+        const std::shared_ptr<ChunkedResponse>& chunks,
+        const QByteArray& chunk);
+
+    /** Write a finished response. Must be called on the server's thread. */
+    void writeResponse_(
+        const std::shared_ptr<Batch>& batch,
+        uint32_t requestId,
+        const QByteArray& response);
+
+    /**
+     * Hand the ring region of a sent response to the client, which releases
+     * it. Releases the region at once if the response was not written to
+     * the ring or the client has gone away.
+     */
+    void sentRegion_(
+        const std::shared_ptr<Batch>& batch, std::size_t offset, bool used);
+
+    /** Release the ring regions which a client has read. */
+    void releaseRegions_(
+        QIODevice* socket, const std::vector<protocol::SharedMemoryRef>& refs);
 
-    /** Resolve a single sub-volume request. */
-    void resolveRequest_(QTcpSocket* socket, protocol::RequestArgs* args);
+    /** Release every ring region held by a client. */
+    void releaseRegions_(QIODevice* socket);
 };
 
 }  // namespace volcart
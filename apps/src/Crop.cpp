@@ -0,0 +1,158 @@
+// Extract a region of a volume into another volume package
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <boost/program_options.hpp>
+
+#include "vc/core/filesystem.hpp"
+#include "vc/core/types/VolumePkg.hpp"
+#include "vc/core/util/Logging.hpp"
+#include "vc/core/util/String.hpp"
+#include "vc/core/util/ThreadPool.hpp"
+
+namespace fs = volcart::filesystem;
+namespace po = boost::program_options;
+namespace vc = volcart;
+
+auto main(int argc, char* argv[]) -> int
+{
+    ///// Parse the command line options /////
+    // clang-format off
+    po::options_description options("Options");
+    options.add_options()
+        ("help,h", "Show this message")
+        ("volpkg,v", po::value<std::string>()->required(),
+            "Path to the source volume package")
+        ("volume", po::value<std::string>(),
+            "Volume to crop. Default: The first volume in the volume package")
+        ("output-volpkg,o", po::value<std::string>()->required(),
+            "Path to the output volume package. Created if it does not "
+            "exist.")
+        ("roi", po::value<std::vector<int>>()->multitoken(),
+            "Region of each slice to extract: x y width height. "
+            "Default: The whole slice")
+        ("slices", po::value<std::vector<int>>()->multitoken(),
+            "Range of slices to extract: first last (inclusive). "
+            "Default: Every slice")
+        ("name", po::value<std::string>(),
+            "Name of the new volume. Default: Name of the source volume")
+        ("format", po::value<std::string>()->default_value("slices"),
+            "On-disk format of the new volume:\n"
+            "  slices: One image per slice\n"
+            "  blocks: Chunked cubic blocks for fast 3D access")
+        ("block-size", po::value<int>()->default_value(
+            vc::Volume::DEFAULT_BLOCK_SIZE),
+            "Block edge length (in voxels) for the blocks format")
+        ("threads,j", po::value<std::size_t>()->default_value(0),
+            "Number of slices to extract in parallel. "
+            "Default: Number of hardware threads");
+    // clang-format on
+
+    po::variables_map parsed;
+    po::store(
+        po::command_line_parser(argc, argv).options(options).run(), parsed);
+
+    // Show the help message
+    if (parsed.count("help") > 0 || argc < 2) {
+        std::cout << options << std::endl;
+        return EXIT_SUCCESS;
+    }
+
+    // Warn of missing options
+    try {
+        po::notify(parsed);
+    } catch (po::error& e) {
+        vc::Logger()->error(e.what());
+        return EXIT_FAILURE;
+    }
+
+    vc::ThreadPool::SetGlobalThreads(parsed["threads"].as<std::size_t>());
+
+    auto format = parsed["format"].as<std::string>();
+    vc::to_lower(format);
+    auto volFormat = vc::Volume::Format::Slices;
+    if (format == "blocks") {
+        volFormat = vc::Volume::Format::Blocks;
+    } else if (format != "slices") {
+        vc::Logger()->error("Unrecognized volume format: {}", format);
+        return EXIT_FAILURE;
+    }
+
+    ///// Load the source volume /////
+    fs::path srcPath = parsed["volpkg"].as<std::string>();
+    vc::VolumePkg::Pointer srcPkg;
+    vc::Volume::Pointer src;
+    try {
+        srcPkg = vc::VolumePkg::New(srcPath);
+        if (parsed.count("volume") > 0) {
+            src = srcPkg->volume(parsed["volume"].as<std::string>());
+        } else {
+            src = srcPkg->volume();
+        }
+    } catch (const std::exception& e) {
+        vc::Logger()->error("Failed to load volume: {}", e.what());
+        return EXIT_FAILURE;
+    }
+
+    ///// Region to extract /////
+    cv::Rect roi(0, 0, src->sliceWidth(), src->sliceHeight());
+    if (parsed.count("roi") > 0) {
+        auto r = parsed["roi"].as<std::vector<int>>();
+        if (r.size() != 4) {
+            vc::Logger()->error("--roi requires 4 values: x y width height");
+            return EXIT_FAILURE;
+        }
+        roi = {r[0], r[1], r[2], r[3]};
+    }
+    cv::Range slices(0, src->numSlices());
+    if (parsed.count("slices") > 0) {
+        auto s = parsed["slices"].as<std::vector<int>>();
+        if (s.size() != 2) {
+            vc::Logger()->error("--slices requires 2 values: first last");
+            return EXIT_FAILURE;
+        }
+        slices = {s[0], s[1] + 1};
+    }
+
+    ///// Open or create the output package /////
+    fs::path dstPath = parsed["output-volpkg"].as<std::string>();
+    vc::VolumePkg::Pointer dstPkg;
+    try {
+        if (fs::exists(dstPath)) {
+            dstPkg = vc::VolumePkg::New(dstPath);
+        } else {
+            dstPkg = vc::VolumePkg::New(dstPath, vc::VOLPKG_VERSION_LATEST);
+            dstPkg->setMetadata("name", dstPath.stem().string());
+            dstPkg->setMetadata(
+                "materialthickness", srcPkg->materialThickness());
+            dstPkg->saveMetadata();
+        }
+    } catch (const std::exception& e) {
+        vc::Logger()->error("Failed to open output package: {}", e.what());
+        return EXIT_FAILURE;
+    }
+
+    ///// Crop /////
+    auto name = parsed.count("name") > 0 ? parsed["name"].as<std::string>()
+                                         : src->name();
+    vc::Logger()->info(
+        "Extracting {}x{} region at ({}, {}) of slices [{}, {}) from {}",
+        roi.width, roi.height, roi.x, roi.y, slices.start, slices.end,
+        src->id());
+    try {
+        auto vol = dstPkg->newVolumeFromRegion(
+            src, roi, slices, name, volFormat,
+            parsed["block-size"].as<int>());
+        auto offset = vol->cropOffset();
+        vc::Logger()->info(
+            "Created volume {} ({}x{}x{}) with offset ({}, {}, {})", vol->id(),
+            vol->sliceWidth(), vol->sliceHeight(), vol->numSlices(),
+            offset[0], offset[1], offset[2]);
+    } catch (const std::exception& e) {
+        vc::Logger()->error("Failed to crop volume: {}", e.what());
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -1,4 +1,10 @@
+#include <cstddef>
+#include <fstream>
+#include <string>
+#include <vector>
+
 #include <boost/program_options.hpp>
+#include <nlohmann/json.hpp>
 
 #include "vc/app_support/ProgressIndicator.hpp"
 #include "vc/core/filesystem.hpp"
@@ -7,6 +13,7 @@
 #include "vc/core/util/Logging.hpp"
 #include "vc/texturing/AngleBasedFlattening.hpp"
 #include "vc/texturing/PPMGenerator.hpp"
+#include "vc/texturing/UVAtlas.hpp"
 
 namespace vc = volcart;
 namespace fs = volcart::filesystem;
@@ -18,12 +25,32 @@ int main(int argc, char* argv[])
     po::options_description all("Usage");
     all.add_options()
         ("help,h", "Show this message")
-        ("input-mesh,i", po::value<std::string>()->required(),
-            "Path to the input mesh")
+        ("input-mesh,i",
+            po::value<std::vector<std::string>>()->required()->multitoken(),
+            "Path to the input mesh. If several meshes are given, their UV "
+            "maps are packed into a single atlas and one PPM is generated "
+            "for all of them.")
         ("output-ppm,o", po::value<std::string>()->required(),
             "Path for the output ppm")
         ("uv-reuse", "If input-mesh is specified, attempt to use its existing "
-            "UV map instead of generating a new one.");
+            "UV map instead of generating a new one.")
+        ("compact", "Write the PPM in the compact, memory-mappable format. "
+            "Stores single-precision values for mapped pixels only.")
+        ("rasterize", "Generate the PPM by rasterizing the UV map rather than "
+            "ray casting. Considerably faster for large outputs.")
+        ("reference-ppm", po::value<std::string>(),
+            "PPM previously generated for a mesh with the same faces and UV "
+            "map as input-mesh, e.g. before its vertices were edited. The "
+            "face samples of the reference are reused, which is much faster "
+            "than locating every face again.")
+        ("reference-mesh", po::value<std::string>(),
+            "Mesh used to generate reference-ppm. If provided, input-mesh "
+            "may also have locally edited faces and UVs, and only the pixels "
+            "covered by the edited faces are regenerated. Both meshes must "
+            "have UV maps.")
+        ("atlas-layout", po::value<std::string>(),
+            "When several meshes are given, write the pixel region of each "
+            "mesh in the atlas to this JSON file.");
     // clang-format on
 
     // parsed will hold the values of all parsed options as a Map
@@ -45,29 +72,86 @@ int main(int argc, char* argv[])
     }
 
     // Get inputs
-    fs::path meshPath = parsed["input-mesh"].as<std::string>();
+    auto meshPaths = parsed["input-mesh"].as<std::vector<std::string>>();
     fs::path ppmPath = parsed["output-ppm"].as<std::string>();
+    auto useAtlas = meshPaths.size() > 1;
+    if (useAtlas and parsed.count("reference-ppm") > 0) {
+        vc::Logger()->error("A reference PPM requires a single input mesh");
+        return EXIT_FAILURE;
+    }
 
     // Load mesh
     vc::Logger()->info("Loading mesh");
-    auto meshFile = vc::ReadMesh(meshPath);
+    auto meshFile = vc::ReadMesh(meshPaths.front());
     auto mesh = meshFile.mesh;
     auto uvMap = meshFile.uv;
 
-    // Generate UV map
+    // Load the reference PPM
+    vc::PerPixelMap::Pointer reference;
+    if (parsed.count("reference-ppm") > 0) {
+        fs::path refPath = parsed["reference-ppm"].as<std::string>();
+        vc::Logger()->info("Loading reference per-pixel map");
+        reference = vc::PerPixelMap::New(vc::PerPixelMap::ReadPPM(refPath));
+    }
+
+    // Find the faces edited since the reference mesh
+    std::vector<std::size_t> changedFaces;
+    if (reference and parsed.count("reference-mesh") > 0) {
+        fs::path refMeshPath = parsed["reference-mesh"].as<std::string>();
+        auto refMesh = vc::ReadMesh(refMeshPath);
+        if (not refMesh.uv or not uvMap) {
+            vc::Logger()->error(
+                "Incremental regeneration requires meshes with UV maps");
+            return EXIT_FAILURE;
+        }
+        changedFaces =
+            vc::texturing::ChangedFaces(refMesh.mesh, refMesh.uv, mesh, uvMap);
+        vc::Logger()->info(
+            "Regenerating {} of {} faces", changedFaces.size(),
+            mesh->GetNumberOfCells());
+    }
+
+    // Generate UV map. Not needed if the reference has barycentric samples.
     auto genUV = parsed.count("uv-reuse") == 0;
-    if (genUV or not uvMap) {
-        // ABF
+    auto needUV = not reference or reference->barycentricMap().empty();
+    genUV = genUV and changedFaces.empty();
+    auto flatten = [](const vc::ITKMesh::Pointer& m) {
         vc::texturing::AngleBasedFlattening abf;
-        abf.setMesh(mesh);
+        abf.setMesh(m);
         abf.compute();
+        return abf.getUVMap();
+    };
+    if (needUV and (genUV or not uvMap)) {
+        uvMap = flatten(mesh);
+    }
 
-        // Get UV map
-        uvMap = abf.getUVMap();
+    // Pack all meshes into one atlas, so that a single PPM covers them
+    vc::texturing::UVAtlas atlas;
+    if (useAtlas) {
+        atlas.addSegment(mesh, uvMap);
+        for (std::size_t i = 1; i < meshPaths.size(); i++) {
+            vc::Logger()->info("Loading mesh: {}", meshPaths[i]);
+            auto seg = vc::ReadMesh(meshPaths[i]);
+            if (genUV or not seg.uv) {
+                seg.uv = flatten(seg.mesh);
+            }
+            atlas.addSegment(seg.mesh, seg.uv);
+        }
+        vc::Logger()->info("Packing {} UV maps", meshPaths.size());
+        atlas.compute();
+        mesh = atlas.getMesh();
+        uvMap = atlas.getUVMap();
     }
 
-    auto width = static_cast<size_t>(std::ceil(uvMap->ratio().width));
-    auto height = static_cast<size_t>(std::ceil(width / uvMap->ratio().aspect));
+    size_t width{0};
+    size_t height{0};
+    if (reference) {
+        width = reference->width();
+        height = reference->height();
+    } else {
+        width = static_cast<size_t>(std::ceil(uvMap->ratio().width));
+        height = static_cast<size_t>(std::ceil(width / uvMap->ratio().aspect));
+    }
 
     // PPM
     vc::Logger()->info("Generating per-pixel map");
@@ -75,11 +159,39 @@ int main(int argc, char* argv[])
     p.setDimensions(height, width);
     p.setMesh(mesh);
     p.setUVMap(uvMap);
-    p.compute();
+    if (parsed.count("rasterize") > 0) {
+        p.setEngine(vc::texturing::PPMGenerator::Engine::Rasterize);
+    }
+    p.setReferencePPM(reference);
+    p.setChangedFaces(changedFaces);
+    try {
+        p.compute();
+    } catch (const std::invalid_argument& e) {
+        vc::Logger()->error("Failed to generate PPM: {}", e.what());
+        return EXIT_FAILURE;
+    }
 
     // Write PPM
     vc::Logger()->info("Writing per-pixel map");
-    vc::PerPixelMap::WritePPM(ppmPath, *p.getPPM());
+    auto format = parsed.count("compact") > 0 ? vc::PerPixelMap::Format::Compact
+                                              : vc::PerPixelMap::Format::Dense;
+    vc::PerPixelMap::WritePPM(ppmPath, *p.getPPM(), format);
+
+    // Write the region of each mesh in the atlas
+    if (useAtlas and parsed.count("atlas-layout") > 0) {
+        nlohmann::json layout = nlohmann::json::array();
+        for (std::size_t i = 0; i < meshPaths.size(); i++) {
+            auto r = atlas.segmentRegion(i, width, height);
+            layout.push_back(
+                {{"mesh", meshPaths[i]},
+                 {"x", r.x},
+                 {"y", r.y},
+                 {"width", r.width},
+                 {"height", r.height}});
+        }
+        std::ofstream file(parsed["atlas-layout"].as<std::string>());
+        file << layout.dump(4) << std::endl;
+    }
 
     return EXIT_SUCCESS;
 }
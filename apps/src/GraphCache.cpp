@@ -0,0 +1,200 @@
+// Inspect and prune the render caches of a volume package
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <sys/stat.h>
+
+#include <boost/program_options.hpp>
+
+#include "vc/core/filesystem.hpp"
+#include "vc/core/types/VolumePkg.hpp"
+#include "vc/core/util/Logging.hpp"
+#include "vc/core/util/MemorySizeStringParser.hpp"
+#include "vc/graph/memoization.hpp"
+
+namespace fs = volcart::filesystem;
+namespace po = boost::program_options;
+
+using namespace volcart;
+
+// Nanoseconds per day
+static constexpr double NS_PER_DAY{86'400e9};
+
+// A render directory and the size of its graph cache
+struct RenderInfo {
+    Render::Identifier id;
+    std::string name;
+    fs::path path;
+    std::size_t bytes{0};
+    // Newest modification time of the render's files
+    std::int64_t lastUsed{0};
+};
+
+static auto Now() -> std::int64_t
+{
+    using namespace std::chrono;
+    return duration_cast<nanoseconds>(system_clock::now().time_since_epoch())
+        .count();
+}
+
+static auto Age(std::int64_t mtime) -> std::string
+{
+    std::stringstream ss;
+    ss << std::fixed << std::setprecision(1)
+       << static_cast<double>(Now() - mtime) / NS_PER_DAY << " days";
+    return ss.str();
+}
+
+static auto Size(std::size_t bytes) -> std::string
+{
+    return BytesToMemorySizeString(bytes, "MB", MemoryStringFormat::Float);
+}
+
+// Measure a render directory
+static auto ScanRender(const Render::Pointer& render) -> RenderInfo
+{
+    RenderInfo info{render->id(), render->name(), render->path()};
+    for (const auto& it : fs::recursive_directory_iterator(info.path)) {
+        struct stat st{};
+        if (::stat(it.path().c_str(), &st) != 0 or not S_ISREG(st.st_mode)) {
+            continue;
+        }
+#ifdef __APPLE__
+        const auto& ts = st.st_mtimespec;
+#else
+        const auto& ts = st.st_mtim;
+#endif
+        auto mtime =
+            static_cast<std::int64_t>(ts.tv_sec) * 1'000'000'000 + ts.tv_nsec;
+        info.bytes += static_cast<std::size_t>(st.st_size);
+        info.lastUsed = std::max(info.lastUsed, mtime);
+    }
+    return info;
+}
+
+auto main(int argc, char* argv[]) -> int
+{
+    // clang-format off
+    po::options_description options("Options");
+    options.add_options()
+        ("help,h", "Show this message")
+        ("volpkg,v", po::value<std::string>()->required(), "VolumePkg path")
+        ("max-size", po::value<std::string>(), "Trim the shared node output "
+            "cache (render_cache) to this size by removing the least recently "
+            "used entries. Accepts the suffixes: (K|M|G|T)(B).")
+        ("purge", "Remove every entry from the shared node output cache")
+        ("remove-renders-older-than", po::value<double>(), "Remove the "
+            "renders, including their graph caches, which have not been "
+            "written in this many days.")
+        ("dry-run", "Only report which renders would be removed");
+    // clang-format on
+
+    po::variables_map parsed;
+    try {
+        po::store(
+            po::command_line_parser(argc, argv).options(options).run(),
+            parsed);
+    } catch (const po::error& e) {
+        Logger()->error(e.what());
+        return EXIT_FAILURE;
+    }
+
+    // Show the help message
+    if (parsed.count("help") > 0 || argc < 3) {
+        std::cout << "Usage: " << argv[0] << " -v volpkg [options]"
+                  << std::endl;
+        std::cout << options << std::endl;
+        return EXIT_SUCCESS;
+    }
+
+    // Warn of missing options
+    try {
+        po::notify(parsed);
+    } catch (const po::error& e) {
+        Logger()->error(e.what());
+        return EXIT_FAILURE;
+    }
+
+    fs::path volpkgPath = parsed["volpkg"].as<std::string>();
+    auto vpkg = VolumePkg::New(volpkgPath);
+
+    ///// Shared node output cache /////
+    auto cache = NodeOutputCache::New(
+        volpkgPath / "render_cache", std::numeric_limits<std::size_t>::max());
+    if (parsed.count("purge") > 0) {
+        Logger()->info("Purging node output cache");
+        cache->purge();
+    } else if (parsed.count("max-size") > 0) {
+        auto target =
+            MemorySizeStringParser(parsed["max-size"].as<std::string>());
+        Logger()->info("Trimming node output cache to {}", Size(target));
+        cache->trimTo(target);
+    }
+
+    auto entries = cache->entries();
+    std::sort(entries.begin(), entries.end(), [](const auto& a, const auto& b) {
+        return a.lastUsed > b.lastUsed;
+    });
+    std::cout << " --- Node Output Cache ---" << std::endl;
+    for (const auto& e : entries) {
+        std::cout << e.key << ": " << e.files << " files, " << Size(e.bytes)
+                  << ", last used " << Age(e.lastUsed) << " ago" << std::endl;
+    }
+    std::cout << "Total: " << entries.size() << " entries, "
+              << Size(cache->bytes()) << " on disk" << std::endl;
+    std::cout << std::endl;
+
+    ///// Render graph caches /////
+    std::vector<RenderInfo> renders;
+    for (const auto& id : vpkg->renderIDs()) {
+        try {
+            renders.emplace_back(ScanRender(vpkg->render(id)));
+        } catch (const std::exception& e) {
+            Logger()->warn("Failed to read render {}: {}", id, e.what());
+        }
+    }
+
+    std::size_t removed{0};
+    auto dryRun = parsed.count("dry-run") > 0;
+    if (parsed.count("remove-renders-older-than") > 0) {
+        auto days = parsed["remove-renders-older-than"].as<double>();
+        auto cutoff = Now() - static_cast<std::int64_t>(days * NS_PER_DAY);
+        auto stale = std::stable_partition(
+            renders.begin(), renders.end(),
+            [cutoff](const auto& r) { return r.lastUsed >= cutoff; });
+        for (auto it = stale; it != renders.end(); ++it) {
+            Logger()->info(
+                "{} render {} ({}, last written {} ago)",
+                dryRun ? "Would remove" : "Removing", it->id, Size(it->bytes),
+                Age(it->lastUsed));
+            if (not dryRun) {
+                fs::remove_all(it->path);
+            }
+            removed += it->bytes;
+        }
+        if (not dryRun) {
+            renders.erase(stale, renders.end());
+        }
+    }
+
+    std::size_t total{0};
+    std::cout << " --- Renders ---" << std::endl;
+    for (const auto& r : renders) {
+        std::cout << "[" << r.id << "] " << r.name << ": " << Size(r.bytes)
+                  << ", last written " << Age(r.lastUsed) << " ago"
+                  << std::endl;
+        total += r.bytes;
+    }
+    std::cout << "Total: " << renders.size() << " renders, " << Size(total)
+              << std::endl;
+    if (removed > 0 and not dryRun) {
+        Logger()->info("Reclaimed {}", Size(removed));
+    }
+}
@@ -7,6 +7,7 @@
 
 #include "vc/app_support/GetMemorySize.hpp"
 #include "vc/core/filesystem.hpp"
+#include "vc/core/io/AsyncImageWriter.hpp"
 #include "vc/core/io/ImageIO.hpp"
 #include "vc/core/io/OBJWriter.hpp"
 #include "vc/core/types/PerPixelMap.hpp"
@@ -27,8 +28,6 @@ namespace fs = volcart::filesystem;
 namespace po = boost::program_options;
 namespace vc = volcart;
 
-using volcart::enumerate;
-
 // Volpkg version required by this app
 static constexpr int VOLPKG_SUPPORTED_VERSION = 6;
 // Number of vertices per square millimeter
@@ -51,8 +50,11 @@ auto main(int argc, char* argv[]) -> int
         ("volume", po::value<std::string>(),
             "Volume to use for texturing. Default: Segmentation's associated "
             "volume or the first volume in the volume package.")
-        ("output-dir,o", po::value<std::string>()->required(),
+        ("output-dir,o", po::value<std::string>(),
             "Output directory for layer images.")
+        ("output-zarr", po::value<std::string>(), "Write the layers to a "
+            "chunked, zlib-compressed Zarr array at this path instead of "
+            "writing layer images.")
         ("image-format,f", po::value<std::string>()->default_value("png"),
             "Image format for layer images. Default: png")
         ("compression", po::value<int>(), "Image compression level");
@@ -69,8 +71,20 @@ auto main(int argc, char* argv[]) -> int
                 "  0 = Omni\n"
                 "  1 = Positive");
 
+    po::options_description performanceOptions("Performance Options");
+    performanceOptions.add_options()
+        ("band-size", po::value<std::size_t>()->default_value(0),
+            "Number of layers to compute at a time. Each completed layer is "
+            "written and released, so smaller bands use less memory but read "
+            "the volume more often. If 0, computes all layers at once.")
+        ("zarr-chunk-size", po::value<int>()->default_value(64),
+            "Width and height of the chunks of --output-zarr.")
+        ("zarr-chunk-layers", po::value<int>()->default_value(0),
+            "Number of layers in each chunk of --output-zarr. If 0, each "
+            "chunk holds every layer.");
+
     po::options_description all("Usage");
-    all.add(required).add(filterOptions);
+    all.add(required).add(filterOptions).add(performanceOptions);
     // clang-format on
 
     // Parse the cmd line
@@ -96,12 +110,21 @@ auto main(int argc, char* argv[]) -> int
     auto segID = parsed["seg"].as<std::string>();
 
     // Check for output file
-    auto outputPath = fs::canonical(parsed["output-dir"].as<std::string>());
-    if (!fs::is_directory(outputPath) || !fs::exists(outputPath)) {
-        std::cerr << "Provided output path is not a directory or does not exist"
-                  << std::endl;
+    auto writeZarr = parsed.count("output-zarr") > 0;
+    if (not writeZarr and parsed.count("output-dir") == 0) {
+        vc::Logger()->error("the option '--output-dir' is required");
         return EXIT_FAILURE;
     }
+    fs::path outputPath;
+    if (not writeZarr) {
+        outputPath = fs::canonical(parsed["output-dir"].as<std::string>());
+        if (!fs::is_directory(outputPath) || !fs::exists(outputPath)) {
+            std::cerr
+                << "Provided output path is not a directory or does not exist"
+                << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
     auto imgFmt = vc::to_lower_copy(parsed["image-format"].as<std::string>());
     vc::WriteImageOpts writeOpts;
     if (parsed.count("compression") > 0) {
@@ -227,18 +250,28 @@ auto main(int argc, char* argv[]) -> int
     s.setPerPixelMap(ppm);
     s.setGenerator(line);
 
-    auto texture = s.compute();
-
-    // Write the layers
-    std::cout << "Writing layers..." << std::endl;
-    const int numChars =
-        static_cast<int>(std::to_string(texture.size()).size());
-    fs::path filepath;
-    for (const auto [i, image] : enumerate(texture)) {
-        auto fileName = vc::to_padded_string(i, numChars) + "." + imgFmt;
-        filepath = outputPath / fileName;
-        vc::WriteImage(filepath, image, writeOpts);
+    s.setBandSize(parsed["band-size"].as<std::size_t>());
+
+    // Write the layers to a Zarr array, or each layer as soon as it is
+    // complete. Layers are encoded in the background while the next band is
+    // sampled.
+    vc::AsyncImageWriter imageWriter;
+    const auto numLayers = line->extents()[0];
+    const auto numChars = static_cast<int>(std::to_string(numLayers).size());
+    if (writeZarr) {
+        auto chunkSize = parsed["zarr-chunk-size"].as<int>();
+        auto chunkLayers = parsed["zarr-chunk-layers"].as<int>();
+        s.setChunkedOutput(
+            parsed["output-zarr"].as<std::string>(),
+            {chunkSize, chunkSize, chunkLayers});
+    } else {
+        s.setLayerWriter([&](auto i, const auto& image) {
+            auto fileName = vc::to_padded_string(i, numChars) + "." + imgFmt;
+            imageWriter.write(outputPath / fileName, image, writeOpts);
+        });
     }
+    s.compute();
+    imageWriter.flush();
 
     return EXIT_SUCCESS;
 }  // end main
@@ -0,0 +1,119 @@
+// Assemble texture parts rendered with vc_render --tile
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <boost/program_options.hpp>
+
+#include "vc/core/filesystem.hpp"
+#include "vc/core/io/TIFFIO.hpp"
+#include "vc/core/util/Logging.hpp"
+#include "vc/core/util/ThreadPool.hpp"
+#include "vc/texturing/TextureParts.hpp"
+
+namespace fs = volcart::filesystem;
+namespace po = boost::program_options;
+namespace tio = volcart::tiffio;
+namespace vct = volcart::texturing;
+
+using namespace volcart;
+
+auto main(int argc, char* argv[]) -> int
+{
+    // clang-format off
+    po::options_description options("Options");
+    options.add_options()
+        ("help,h", "Show this message")
+        ("input-parts,i", po::value<std::vector<std::string>>()->required(),
+            "Texture part images or their .json descriptors")
+        ("output-file,o", po::value<std::string>(), "Output path. A .dzi "
+            "path writes a Deep Zoom tile pyramid. Otherwise, must be a TIFF. "
+            "Required unless --verify-only is set.")
+        ("compression", po::value<std::string>()->default_value("lzw"),
+            "TIFF compression: none, lzw, deflate, packbits, lzma, or zstd")
+        ("verify-only", "Only check that the parts cover the whole texture")
+        ("threads", po::value<std::size_t>()->default_value(0), "Number of "
+            "threads used to decode and encode tiles. If 0, uses one thread "
+            "per CPU core.");
+
+    po::positional_options_description positional;
+    positional.add("input-parts", -1);
+    // clang-format on
+
+    po::variables_map parsed;
+    try {
+        po::store(
+            po::command_line_parser(argc, argv)
+                .options(options)
+                .positional(positional)
+                .run(),
+            parsed);
+    } catch (const po::error& e) {
+        Logger()->error(e.what());
+        return EXIT_FAILURE;
+    }
+
+    // Show the help message
+    if (parsed.count("help") > 0 || argc < 2) {
+        std::cout << "Usage: " << argv[0]
+                  << " [options] -o output.tif part [part ...]" << std::endl;
+        std::cout << options << std::endl;
+        return EXIT_SUCCESS;
+    }
+
+    // Warn of missing options
+    try {
+        po::notify(parsed);
+    } catch (const po::error& e) {
+        Logger()->error(e.what());
+        return EXIT_FAILURE;
+    }
+
+    auto verifyOnly = parsed.count("verify-only") > 0;
+    if (not verifyOnly and parsed.count("output-file") == 0) {
+        Logger()->error("Missing required flag: --output-file");
+        return EXIT_FAILURE;
+    }
+
+    ThreadPool::SetGlobalThreads(parsed["threads"].as<std::size_t>());
+
+    tio::Compression compression;
+    try {
+        compression = tio::CompressionFromString(
+            parsed["compression"].as<std::string>());
+    } catch (const std::invalid_argument& e) {
+        Logger()->error(e.what());
+        return EXIT_FAILURE;
+    }
+
+    // Read and verify the part descriptors
+    std::vector<vct::TexturePart> parts;
+    try {
+        for (const auto& p :
+             parsed["input-parts"].as<std::vector<std::string>>()) {
+            parts.emplace_back(vct::ReadTexturePart(p));
+        }
+        parts = vct::VerifyTextureParts(parts);
+    } catch (const std::exception& e) {
+        Logger()->error(e.what());
+        return EXIT_FAILURE;
+    }
+    const auto& first = parts.front();
+    Logger()->info(
+        "Found all {} parts of a {}x{} texture", first.count, first.width,
+        first.height);
+    if (verifyOnly) {
+        return EXIT_SUCCESS;
+    }
+
+    // Merge
+    fs::path outputPath = parsed["output-file"].as<std::string>();
+    Logger()->info("Writing merged texture: {}", outputPath.string());
+    try {
+        vct::MergeTextureParts(parts, outputPath, compression);
+    } catch (const std::exception& e) {
+        Logger()->error(e.what());
+        return EXIT_FAILURE;
+    }
+    Logger()->info("Done.");
+}
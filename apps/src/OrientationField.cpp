@@ -0,0 +1,112 @@
+// Precompute the orientation field of a volume for segmentation
+#include <cmath>
+#include <iostream>
+#include <string>
+
+#include <boost/program_options.hpp>
+
+#include "vc/core/filesystem.hpp"
+#include "vc/core/math/OrientationField.hpp"
+#include "vc/core/types/VolumePkg.hpp"
+#include "vc/core/util/Logging.hpp"
+#include "vc/core/util/ThreadPool.hpp"
+
+namespace fs = volcart::filesystem;
+namespace po = boost::program_options;
+namespace vc = volcart;
+
+auto main(int argc, char* argv[]) -> int
+{
+    ///// Parse the command line options /////
+    // clang-format off
+    po::options_description options("Options");
+    options.add_options()
+        ("help,h", "Show this message")
+        ("volpkg,v", po::value<std::string>()->required(),
+            "Path to the volume package")
+        ("volume", po::value<std::string>(),
+            "Source volume. Default: The first volume in the volume package")
+        ("name", po::value<std::string>(),
+            "Name of the new volume. Default: \"<source name> orientation\"")
+        ("radius,r", po::value<int>(),
+            "Radius of the structure tensor window. Default: Half the "
+            "material thickness, in voxels")
+        ("kernel-size", po::value<int>()->default_value(3),
+            "Size of the gradient kernel: 3, 5, or 7")
+        ("block-size", po::value<int>()->default_value(
+            vc::Volume::DEFAULT_BLOCK_SIZE),
+            "Block edge length (in voxels) of the new volume")
+        ("threads,j", po::value<std::size_t>()->default_value(0),
+            "Number of threads. Default: Number of hardware threads");
+    // clang-format on
+
+    po::variables_map parsed;
+    po::store(
+        po::command_line_parser(argc, argv).options(options).run(), parsed);
+
+    // Show the help message
+    if (parsed.count("help") > 0 || argc < 2) {
+        std::cout << options << std::endl;
+        return EXIT_SUCCESS;
+    }
+
+    // Warn of missing options
+    try {
+        po::notify(parsed);
+    } catch (po::error& e) {
+        vc::Logger()->error(e.what());
+        return EXIT_FAILURE;
+    }
+
+    vc::ThreadPool::SetGlobalThreads(parsed["threads"].as<std::size_t>());
+
+    ///// Load the source volume /////
+    fs::path volpkgPath = parsed["volpkg"].as<std::string>();
+    vc::VolumePkg::Pointer vpkg;
+    vc::Volume::Pointer src;
+    try {
+        vpkg = vc::VolumePkg::New(volpkgPath);
+        if (parsed.count("volume") > 0) {
+            src = vpkg->volume(parsed["volume"].as<std::string>());
+        } else {
+            src = vpkg->volume();
+        }
+    } catch (const std::exception& e) {
+        vc::Logger()->error("Failed to load volume: {}", e.what());
+        return EXIT_FAILURE;
+    }
+
+    // Same default radius as StructureTensorParticleSim
+    int radius{0};
+    if (parsed.count("radius") > 0) {
+        radius = parsed["radius"].as<int>();
+    } else {
+        radius = static_cast<int>(
+            std::ceil(vpkg->materialThickness() / src->voxelSize()) * 0.5);
+    }
+    if (radius < 1) {
+        vc::Logger()->error("Invalid structure tensor radius: {}", radius);
+        return EXIT_FAILURE;
+    }
+
+    ///// Compute /////
+    auto name = parsed.count("name") > 0 ? parsed["name"].as<std::string>()
+                                         : src->name() + " orientation";
+    vc::Logger()->info(
+        "Computing orientation field of {} with radius {}", src->id(),
+        radius);
+    try {
+        auto field = vpkg->newVolume(
+            name, vc::Volume::Format::Blocks, parsed["block-size"].as<int>());
+        vc::OrientationField::Compute(
+            src, field, radius, parsed["kernel-size"].as<int>());
+        field->saveMetadata();
+        vc::Logger()->info("Created orientation field volume {}", field->id());
+    } catch (const std::exception& e) {
+        vc::Logger()->error(
+            "Failed to compute orientation field: {}", e.what());
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
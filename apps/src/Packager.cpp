@@ -1,20 +1,30 @@
 #include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
 #include <iostream>
 #include <limits>
+#include <mutex>
 #include <regex>
+#include <thread>
 
 #include <boost/program_options.hpp>
+#include <opencv2/imgcodecs.hpp>
 
 #include "vc/app_support/ProgressIndicator.hpp"
 #include "vc/apps/packager/SliceImage.hpp"
 #include "vc/core/filesystem.hpp"
 #include "vc/core/io/FileExtensionFilter.hpp"
+#include "vc/core/io/TIFFIO.hpp"
 #include "vc/core/io/SkyscanMetadataIO.hpp"
 #include "vc/core/types/Metadata.hpp"
+#include "vc/core/types/VolumeBlockStatistics.hpp"
 #include "vc/core/types/VolumePkg.hpp"
+#include "vc/core/types/VolumeStatistics.hpp"
 #include "vc/core/util/FormatStrToRegexStr.hpp"
-#include "vc/core/util/Iteration.hpp"
 #include "vc/core/util/String.hpp"
+#include "vc/core/util/ThreadPool.hpp"
 
 using PathStringList = std::vector<std::string>;
 
@@ -45,6 +55,12 @@ struct VolumeInfo {
 };
 
 static bool DoAnalyze{true};
+static vc::Volume::Format VolumeFormat{vc::Volume::Format::Slices};
+static int BlockSize{vc::Volume::DEFAULT_BLOCK_SIZE};
+static size_t PyramidLevels{0};
+static vc::Volume::LevelFilter PyramidFilter{vc::Volume::LevelFilter::Mean};
+static size_t NumThreads{1};
+static vc::tiffio::Compression SliceCompression{vc::tiffio::Compression::LZW};
 
 auto GetVolumeInfo(const fs::path& slicePath) -> VolumeInfo;
 void AddVolume(vc::VolumePkg::Pointer& volpkg, const VolumeInfo& info);
@@ -73,9 +89,32 @@ auto main(int argc, char* argv[]) -> int
         ("name", po::value<std::string>(),
             "Set a descriptive name for the VolumePkg. Default: Filename "
             "specified by --volpkg");
+
+    po::options_description storage("Volume Storage");
+    storage.add_options()
+        ("format", po::value<std::string>()->default_value("slices"),
+            "On-disk format for new volumes:\n"
+            "  slices: One image per slice\n"
+            "  blocks: Chunked cubic blocks for fast 3D access")
+        ("block-size", po::value<int>()->default_value(
+            vc::Volume::DEFAULT_BLOCK_SIZE),
+            "Block edge length (in voxels) for the blocks format")
+        ("pyramid-levels", po::value<size_t>()->default_value(0),
+            "Number of downsampled resolution levels (2x, 4x, 8x, ...) to "
+            "generate for each new volume")
+        ("pyramid-filter", po::value<std::string>()->default_value("mean"),
+            "Downsampling filter for resolution levels: mean, max")
+        ("compression", po::value<std::string>()->default_value("lzw"),
+            "Codec used when a volume's slices are compressed:\n"
+            "  lzw: Readable by any TIFF reader\n"
+            "  zstd: Several times faster to decode than lzw\n"
+            "  deflate, lzma: Smaller files, slower to decode")
+        ("threads,j", po::value<size_t>()->default_value(0),
+            "Number of threads used to analyze and import slices. "
+            "Default: Number of hardware threads");
     // clang-format on
     po::options_description helpOpts("Usage");
-    helpOpts.add(options).add(extras);
+    helpOpts.add(options).add(extras).add(storage);
 
     po::options_description all("Usage");
     all.add(helpOpts).add_options()(
@@ -102,6 +141,49 @@ auto main(int argc, char* argv[]) -> int
     // Set global opt
     DoAnalyze = parsed["analyze"].as<bool>();
 
+    auto format = parsed["format"].as<std::string>();
+    vc::to_lower(format);
+    if (format == "blocks") {
+        VolumeFormat = vc::Volume::Format::Blocks;
+    } else if (format != "slices") {
+        std::cerr << "ERROR: Unrecognized volume format: " << format << "\n";
+        return EXIT_FAILURE;
+    }
+    BlockSize = parsed["block-size"].as<int>();
+    if (BlockSize <= 0) {
+        std::cerr << "ERROR: Block size must be greater than zero\n";
+        return EXIT_FAILURE;
+    }
+
+    PyramidLevels = parsed["pyramid-levels"].as<size_t>();
+    auto filter = parsed["pyramid-filter"].as<std::string>();
+    vc::to_lower(filter);
+    if (filter == "max") {
+        PyramidFilter = vc::Volume::LevelFilter::Max;
+    } else if (filter != "mean") {
+        std::cerr << "ERROR: Unrecognized pyramid filter: " << filter << "\n";
+        return EXIT_FAILURE;
+    }
+
+    try {
+        SliceCompression = vc::tiffio::CompressionFromString(
+            parsed["compression"].as<std::string>());
+    } catch (const std::invalid_argument& e) {
+        std::cerr << "ERROR: " << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+    if (not vc::tiffio::CompressionAvailable(SliceCompression)) {
+        std::cerr << "ERROR: Compression is not supported by libtiff: ";
+        std::cerr << vc::tiffio::CompressionToString(SliceCompression) << "\n";
+        return EXIT_FAILURE;
+    }
+
+    NumThreads = parsed["threads"].as<size_t>();
+    if (NumThreads == 0) {
+        NumThreads = std::max(1U, std::thread::hardware_concurrency());
+    }
+    vc::ThreadPool::SetGlobalThreads(NumThreads);
+
     ///// New VolumePkg /////
     // Get the output volpkg path
     fs::path volpkgPath = parsed["volpkg"].as<std::string>();
@@ -265,6 +347,94 @@ VolumeInfo GetVolumeInfo(const fs::path& slicePath)
     return info;
 }
 
+// Fixed-capacity queue which connects the stages of the import pipeline
+template <typename T>
+class BoundedQueue
+{
+public:
+    explicit BoundedQueue(size_t capacity) : capacity_{capacity} {}
+
+    // Blocks while the queue is full. Returns false if the queue is closed.
+    auto push(T v) -> bool
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        notFull_.wait(
+            lock, [this]() { return closed_ or items_.size() < capacity_; });
+        if (closed_) {
+            return false;
+        }
+        items_.push_back(std::move(v));
+        notEmpty_.notify_one();
+        return true;
+    }
+
+    // Blocks while the queue is empty. Returns false once the queue is closed
+    // and all queued items have been popped.
+    auto pop(T& v) -> bool
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        notEmpty_.wait(
+            lock, [this]() { return closed_ or not items_.empty(); });
+        if (items_.empty()) {
+            return false;
+        }
+        v = std::move(items_.front());
+        items_.pop_front();
+        notFull_.notify_one();
+        return true;
+    }
+
+    // Stop accepting new items and wake all waiting threads
+    void close()
+    {
+        {
+            const std::lock_guard<std::mutex> lock(mutex_);
+            closed_ = true;
+        }
+        notFull_.notify_all();
+        notEmpty_.notify_all();
+    }
+
+private:
+    size_t capacity_;
+    std::deque<T> items_;
+    bool closed_{false};
+    std::mutex mutex_;
+    std::condition_variable notFull_;
+    std::condition_variable notEmpty_;
+};
+
+// Advance a progress bar created with NewProgressBar
+static void UpdateProgress(
+    indicators::ProgressBar& bar, size_t prog, size_t maxProg)
+{
+    auto post = std::to_string(prog) + "/" + std::to_string(maxProg);
+    bar.set_option(indicators::option::PostfixText{post});
+    if (prog < maxProg) {
+        bar.set_progress(prog);
+    } else {
+        bar.tick();
+    }
+}
+
+// Call fn(i) for every i in [0, n) on the global thread pool and report the
+// progress
+template <class Fn>
+static void ParallelForWithProgress(
+    size_t n, const std::string& label, Fn fn)
+{
+    auto bar = vc::NewProgressBar(n, label);
+    std::mutex mutex;
+    size_t done{0};
+    vc::ParallelChunks(n, NumThreads, [&](size_t begin, size_t end) {
+        for (auto i = begin; i < end; i++) {
+            fn(i);
+            const std::lock_guard<std::mutex> lock(mutex);
+            UpdateProgress(*bar, ++done, n);
+        }
+    });
+}
+
 void AddVolume(vc::VolumePkg::Pointer& volpkg, const VolumeInfo& info)
 {
     std::cout << "Adding Volume: " << info.path << std::endl;
@@ -324,9 +494,16 @@ void AddVolume(vc::VolumePkg::Pointer& volpkg, const VolumeInfo& info)
     auto volMax = std::numeric_limits<double>::lowest();
     std::vector<fs::path> mismatches;
     if (DoAnalyze) {
-        for (auto& slice : vc::ProgressWrap(slices, "Analyzing slices")) {
+        // Read the slices in parallel
+        std::vector<char> analyzed(slices.size(), 0);
+        ParallelForWithProgress(
+            slices.size(), "Analyzing slices",
+            [&](size_t i) { analyzed[i] = slices[i].analyze(); });
+
+        for (size_t i = 0; i < slices.size(); i++) {
             // Skip if we can't analyze
-            if (!slice.analyze()) {
+            auto& slice = slices[i];
+            if (not analyzed[i]) {
                 continue;
             }
 
@@ -374,11 +551,12 @@ void AddVolume(vc::VolumePkg::Pointer& volpkg, const VolumeInfo& info)
 
     ///// Add data to the volume /////
     // Metadata
-    auto volume = volpkg->newVolume(info.name);
+    auto volume = volpkg->newVolume(info.name, VolumeFormat, BlockSize);
     volume->setNumberOfSlices(slices.size());
     volume->setSliceWidth(slices.front().width());
     volume->setSliceHeight(slices.front().height());
     volume->setVoxelSize(info.voxelsize);
+    volume->setCompression(SliceCompression);
 
     // Scale min/max values
     if (slices.begin()->needsScale()) {
@@ -401,47 +579,178 @@ void AddVolume(vc::VolumePkg::Pointer& volpkg, const VolumeInfo& info)
                      info.flipOption == Flip::All;
 
     // Move the slices into the VolPkg
-    using vc::enumerate;
-    using vc::ProgressWrap;
-    for (auto pair : ProgressWrap(enumerate(slices), "Saving to volpkg")) {
-        const auto& idx = pair.first;
-        auto& slice = pair.second;
-        // Convert or flip
-        if (slice.needsConvert() || slice.needsScale() || needsFlip ||
-            info.compress) {
-            // Override slice min/max with volume min/max
-            if (slice.needsScale()) {
-                slice.setScale(volMax, volMin);
+    // Decoder threads read, convert, and flip the slices in index order and
+    // pass them to the writer threads, which encode and store them. The queue
+    // between the stages bounds the number of slices held in memory. Each
+    // writer also gathers the intensity statistics of the slices it stores.
+    struct ImportItem {
+        size_t idx{0};
+        bool copy{false};
+        cv::Mat image;
+    };
+    auto numDecoders = std::max<size_t>(1, (NumThreads + 1) / 2);
+    auto numWriters = std::max<size_t>(1, NumThreads / 2);
+    BoundedQueue<ImportItem> queue(numDecoders);
+    std::atomic<size_t> next{0};
+    std::atomic<bool> failed{false};
+    std::mutex mutex;
+    std::exception_ptr error;
+    size_t saved{0};
+    vc::VolumeStatistics stats;
+    const cv::Vec3i shape{
+        volume->sliceWidth(), volume->sliceHeight(), volume->numSlices()};
+    vc::VolumeBlockStatistics blockStats(shape, volume->blockSize());
+    auto bar = vc::NewProgressBar(slices.size(), "Saving to volpkg");
+
+    auto fail = [&]() {
+        {
+            const std::lock_guard<std::mutex> lock(mutex);
+            if (not error) {
+                error = std::current_exception();
             }
+        }
+        failed = true;
+        queue.close();
+    };
 
-            // Get slice
-            auto tmp = slice.conformedImage();
-
-            // Apply flips
-            switch (info.flipOption) {
-                case Flip::All:
-                case Flip::Both:
-                    cv::flip(tmp, tmp, -1);
-                    break;
-                case Flip::Vertical:
-                    cv::flip(tmp, tmp, 0);
-                    break;
-                case Flip::Horizontal:
-                    cv::flip(tmp, tmp, 1);
-                    break;
-                case Flip::ZFlip:
-                case Flip::None:
-                    // Do nothing
-                    break;
+    auto decode = [&]() {
+        try {
+            for (auto idx = next++; idx < slices.size() and not failed;
+                 idx = next++) {
+                auto& slice = slices[idx];
+                ImportItem item;
+                item.idx = idx;
+
+                // Just copy to the volume
+                if (not(slice.needsConvert() || slice.needsScale() ||
+                        needsFlip || info.compress ||
+                        VolumeFormat == vc::Volume::Format::Blocks)) {
+                    item.copy = true;
+                    item.image = cv::imread(
+                        slice.path.string(), cv::IMREAD_UNCHANGED);
+                    if (not queue.push(std::move(item))) {
+                        return;
+                    }
+                    continue;
+                }
+
+                // Override slice min/max with volume min/max
+                if (slice.needsScale()) {
+                    slice.setScale(volMax, volMin);
+                }
+
+                // Get slice
+                item.image = slice.conformedImage();
+
+                // Apply flips
+                switch (info.flipOption) {
+                    case Flip::All:
+                    case Flip::Both:
+                        cv::flip(item.image, item.image, -1);
+                        break;
+                    case Flip::Vertical:
+                        cv::flip(item.image, item.image, 0);
+                        break;
+                    case Flip::Horizontal:
+                        cv::flip(item.image, item.image, 1);
+                        break;
+                    case Flip::ZFlip:
+                    case Flip::None:
+                        // Do nothing
+                        break;
+                }
+
+                if (not queue.push(std::move(item))) {
+                    return;
+                }
+            }
+        } catch (...) {
+            fail();
+        }
+    };
+
+    auto write = [&]() {
+        try {
+            vc::VolumeStatistics local;
+            vc::VolumeBlockStatistics localBlocks(shape, volume->blockSize());
+            ImportItem item;
+            while (queue.pop(item)) {
+                if (failed) {
+                    continue;
+                }
+                if (item.image.type() == CV_16UC1) {
+                    local.addSlice(static_cast<int>(item.idx), item.image);
+                    localBlocks.addSlice(
+                        static_cast<int>(item.idx), item.image);
+                }
+                if (item.copy) {
+                    fs::copy_file(
+                        slices[item.idx].path, volume->getSlicePath(item.idx));
+                } else {
+                    volume->setSliceData(item.idx, item.image, info.compress);
+                }
+                item.image.release();
+
+                const std::lock_guard<std::mutex> lock(mutex);
+                UpdateProgress(*bar, ++saved, slices.size());
             }
 
-            // Add to volume
-            volume->setSliceData(idx, tmp, info.compress);
+            const std::lock_guard<std::mutex> lock(mutex);
+            stats.merge(local);
+            blockStats.merge(localBlocks);
+        } catch (...) {
+            fail();
         }
+    };
 
-        // Just copy to the volume
-        else {
-            fs::copy_file(slice.path, volume->getSlicePath(idx));
+    std::vector<std::thread> decoders;
+    std::vector<std::thread> writers;
+    for (size_t t = 0; t < numDecoders; t++) {
+        decoders.emplace_back(decode);
+    }
+    for (size_t t = 0; t < numWriters; t++) {
+        writers.emplace_back(write);
+    }
+    for (auto& t : decoders) {
+        t.join();
+    }
+    queue.close();
+    for (auto& t : writers) {
+        t.join();
+    }
+
+    if (error) {
+        try {
+            std::rethrow_exception(error);
+        } catch (const std::exception& e) {
+            std::cerr << "ERROR: Failed to import slices: " << e.what();
+            std::cerr << std::endl;
+        } catch (...) {
+            std::cerr << "ERROR: Failed to import slices" << std::endl;
+        }
+        return;
+    }
+
+    // Store the statistics. Without analysis, they also provide the range.
+    if (stats.count() > 0) {
+        volume->setStatistics(stats);
+        if (not DoAnalyze and not slices.front().needsScale()) {
+            volume->setMin(stats.min());
+            volume->setMax(stats.max());
         }
+        volume->saveMetadata();
+    }
+
+    // Store the block statistics used to skip empty space. They are only
+    // complete if every slice was 16-bit.
+    if (blockStats.complete()) {
+        volume->setBlockStatistics(blockStats);
+    }
+
+    // Generate the resolution pyramid
+    if (PyramidLevels > 0) {
+        std::cout << "Generating " << PyramidLevels << " resolution levels...";
+        std::cout << std::endl;
+        volume->generateLevels(PyramidLevels, PyramidFilter, info.compress);
     }
 }
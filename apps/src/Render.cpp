@@ -1,18 +1,41 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <future>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <thread>
+#include <tuple>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include <boost/program_options.hpp>
 #include <smgl/smgl.hpp>
 
 #include "vc/app_support/GetMemorySize.hpp"
+#include "vc/app_support/ResourceEstimate.hpp"
 #include "vc/core/Version.hpp"
 #include "vc/core/filesystem.hpp"
 #include "vc/core/io/FileExtensionFilter.hpp"
+#include "vc/core/io/MeshIO.hpp"
 #include "vc/core/io/PointSetIO.hpp"
 #include "vc/core/types/VolumePkg.hpp"
 #include "vc/core/util/Iteration.hpp"
+#include "vc/core/util/LargePages.hpp"
 #include "vc/core/util/Logging.hpp"
 #include "vc/core/util/MemorySizeStringParser.hpp"
+#include "vc/core/util/MemoryUsage.hpp"
+#include "vc/core/util/MeshMath.hpp"
 #include "vc/core/util/String.hpp"
+#include "vc/core/util/ThreadPool.hpp"
+#include "vc/core/util/Tracing.hpp"
 #include "vc/graph.hpp"
 
 namespace vc = volcart;
@@ -33,6 +56,13 @@ enum class FlatteningAlgorithm { ABF = 0, LSCM, Orthographic };
 // Available texturing algorithms
 enum class Method { Composite = 0, Intersection, Integral, Thickness };
 
+// Resource estimate model: scratch memory of the flattening solvers and the
+// UV BVH, and the fraction of the PPM which is covered by the mesh
+static constexpr std::uint64_t ABF_FACE_BYTES{1024};
+static constexpr std::uint64_t LSCM_VERTEX_BYTES{512};
+static constexpr std::uint64_t BVH_FACE_BYTES{64};
+static constexpr double UV_FILL_RATIO{0.7};
+
 static auto GetGeneralOpts() -> po::options_description
 {
     // clang-format off
@@ -42,6 +72,42 @@ static auto GetGeneralOpts() -> po::options_description
         ("cache-memory-limit", po::value<std::string>(),
          "Maximum size of the slice cache in bytes. Accepts the suffixes: "
          "(K|M|G|T)(B). Default: 50% of the total system memory.")
+        ("disk-cache", po::value<std::string>(),
+         "Directory of a persistent cache of decoded slices and blocks, "
+         "ideally on a local disk. Processes which use the same directory "
+         "share the cache. Default: Disabled.")
+        ("disk-cache-limit", po::value<std::string>(),
+         "Maximum size of the disk cache in bytes. Accepts the suffixes: "
+         "(K|M|G|T)(B). Default: 64GB.")
+        ("shared-memory-cache", "Use a disk cache in shared memory which "
+         "is shared by every process on this host that uses this option. "
+         "Slices decoded by one process are read by the others without "
+         "copying them. Limited by --disk-cache-limit. Mutually exclusive "
+         "with --disk-cache.")
+        ("memory-soft-limit", po::value<std::string>(),
+         "Soft limit on the memory used by slice caches, PPMs, meshes, "
+         "textures, and masks. When exceeded, the slice cache is shrunk to "
+         "make room. Accepts the suffixes: (K|M|G|T)(B). Default: No limit.")
+        ("large-pages", po::value<std::string>()->default_value("off"),
+         "Back large images and PPMs with 2 MB huge pages to reduce TLB "
+         "misses while sampling. Options: off, transparent (transparent "
+         "huge pages), explicit (the system's MAP_HUGETLB pool, falling back "
+         "to transparent huge pages).")
+        ("cache-stats-interval", po::value<double>()->default_value(0),
+         "Log the volume's cache statistics every N seconds. Statistics are "
+         "always logged on exit. Set to 0 to disable periodic logging.")
+        ("threads", po::value<size_t>()->default_value(0), "Number of "
+         "worker threads shared by all parallel stages of the graph. If 0, "
+         "uses one thread per CPU core.")
+        ("trace", po::value<std::string>(), "Record timing spans of slice "
+         "loads, texturing, and graph nodes and write them to this file as "
+         "Chrome trace-event JSON. View with chrome://tracing or Perfetto.")
+        ("estimate", "Do not render. Build the render graph of every job and "
+         "report its predicted peak memory per stage, the slices it reads, "
+         "and its I/O volume. Predictions are calibrated with the profiles "
+         "of previous renders in the volume package.")
+        ("estimate-output", po::value<std::string>(), "Also write the "
+         "--estimate predictions of every job to this file as JSON.")
         ("log-level", po::value<std::string>()->default_value("info"),
          "Options: off, critical, error, warn, info, debug");
     // clang-format on
@@ -61,11 +127,69 @@ static auto GetIOOpts() -> po::options_description
         "volume or the first volume in the volume package.")
     ("output-file,o", po::value<std::string>(),
         "Output file path. If not specified, an OBJ file and texture image "
-        "will be placed in the current working directory.")
+        "will be placed in the current working directory. A .dzi path "
+        "writes the texture as a Deep Zoom tile pyramid for image viewers.")
     ("output-ppm", po::value<std::string>(),
         "Output file path for the generated PPM.")
     ("save-graph", po::value<bool>()->default_value(true),
-        "Save the generated render graph into the volume package.");
+        "Save the generated render graph into the volume package.")
+    ("reuse-outputs", po::value<bool>()->default_value(true),
+        "Reuse the mesh resampling, flattening, and PPM generation results "
+        "of previous renders with identical inputs and parameters. Results "
+        "are stored in the volume package's render_cache directory.")
+    ("render-cache-limit", po::value<std::string>(),
+        "Maximum size of the render_cache directory in bytes. The least "
+        "recently used results are removed when it is exceeded. Accepts the "
+        "suffixes: (K|M|G|T)(B). Default: 64GB.")
+    ("tile", po::value<std::string>(), "Only render part i of N of the "
+        "texture, given as i/N with 0 <= i < N. The texture is divided into "
+        "horizontal bands, so the parts can be rendered on separate nodes "
+        "and assembled with vc_merge_texture_parts. The output file must be "
+        "a TIFF.")
+    ("checkpoint-dir", po::value<std::string>(), "Periodically save the "
+        "partially textured image to this directory so that an interrupted "
+        "render can be continued with --resume. Each render job uses a "
+        "subdirectory named after its segmentation or mesh. A job's "
+        "checkpoint is removed once the job succeeds. Only supported by the "
+        "Composite and Integral methods, which do not use the GPU when "
+        "checkpointing.")
+    ("checkpoint-interval", po::value<double>()->default_value(300),
+        "Minimum number of seconds between texture checkpoints.")
+    ("resume", "Continue texturing from the checkpoints in --checkpoint-dir. "
+        "With --reuse-outputs, the mesh, flattening, and PPM of the "
+        "interrupted render are loaded from the render cache. Without this "
+        "flag, existing checkpoints are discarded.");
+    // clang-format on
+
+    return opts;
+}
+
+static auto GetBatchOpts() -> po::options_description
+{
+    // clang-format off
+    po::options_description opts("Batch Options");
+    opts.add_options()
+    ("segs", po::value<std::vector<std::string>>()->multitoken(),
+        "Render many segmentations in one process. Jobs share the volume and "
+        "its slice cache and are ordered so that consecutive jobs overlap in "
+        "Z.")
+    ("seg-manifest", po::value<std::string>(), "Path to a file listing the "
+        "IDs of segmentations to render, one per line. Text following a "
+        "'#' is ignored. May be combined with --segs.")
+    ("output-dir", po::value<std::string>()->default_value("."),
+        "Output directory for batch renders. Each segmentation is written to "
+        "[ID]_render.[output-format]. Auxiliary outputs, such as "
+        "--output-ppm, are prefixed with the segmentation ID.")
+    ("output-format", po::value<std::string>()->default_value("obj"),
+        "Output file format for batch renders: obj, ply, png, jpg, tif, or "
+        "dzi.")
+    ("batch-jobs", po::value<std::size_t>()->default_value(1),
+        "Number of batch jobs to render concurrently. Jobs share the "
+        "--threads workers.")
+    ("batch-memory-limit", po::value<std::string>(), "Do not start "
+        "additional concurrent jobs while the tracked memory in use, "
+        "excluding slice caches, exceeds this size. Accepts the suffixes: "
+        "(K|M|G|T)(B). Default: --memory-soft-limit.");
     // clang-format on
 
     return opts;
@@ -78,8 +202,13 @@ static auto GetMeshingOpts() -> po::options_description
     opts.add_options()
         ("scale-mesh", po::value<double>(), "Scale the mesh by a linear scale "
             "factor")
-        ("enable-mesh-resampling", "Enable ACVD mesh resampling. Automatically "
+        ("enable-mesh-resampling", "Enable mesh resampling. Automatically "
             "enabled if the input is a Segmentation")
+        ("mesh-resample-method", po::value<int>()->default_value(0),
+            "Mesh resampling method:\n"
+            "  0 = ACVD\n"
+            "  1 = Quadric edge collapse (much faster, less regular "
+            "triangles. Ignores the ACVD options.)")
         ("mesh-resample-factor", po::value<double>()->default_value(50),
             "Roughly, the number of vertices per square millimeter in the "
             "output mesh")
@@ -103,7 +232,12 @@ static auto GetMeshingOpts() -> po::options_description
             "  3 = Both before and after mesh resampling")
         ("intermediate-mesh", po::value<std::string>(),"Output file path for the "
             "intermediate (i.e. scale + resampled) mesh. File is saved prior "
-            "to flattening. Useful for testing meshing parameters.");
+            "to flattening. Useful for testing meshing parameters.")
+        ("intermediate-mesh-format", po::value<int>()->default_value(0),
+            "Encoding of the intermediate mesh if it is a PLY file:\n"
+            "  0 = ASCII\n"
+            "  1 = Binary, 32-bit floats\n"
+            "  2 = Binary, 64-bit doubles");
     // clang-format on
 
     return opts;
@@ -121,6 +255,31 @@ static auto GetUVOpts() -> po::options_description
                 "  2 = Orthographic Projection")
         ("uv-reuse", "If input-mesh is specified, attempt to use its existing "
             "UV map instead of generating a new one.")
+        ("uv-seed", po::value<std::string>(), "Path to a textured mesh with "
+            "the same vertices as the input mesh. Its UV map is used as a "
+            "starting point when flattening with ABF or LSCM. Useful when "
+            "re-flattening a segmentation which has changed slightly.")
+        ("uv-solver", po::value<int>()->default_value(0),
+            "Sparse solver used by ABF and LSCM flattening:\n"
+                "  0 = Sparse LU\n"
+                "  1 = Simplicial LDLT\n"
+                "  2 = Conjugate gradient\n"
+                "  3 = CHOLMOD (if available)")
+        ("uv-proxy-vertices", po::value<std::size_t>(), "Flatten with ABF or "
+            "LSCM using a resampled proxy mesh with approximately this many "
+            "vertices, then interpolate the UVs of the full-resolution mesh "
+            "from the proxy. Much faster than flattening very large meshes "
+            "directly.")
+        ("uv-charts", "Flatten with ABF or LSCM chart by chart. The mesh is "
+            "split into its connected components, which are flattened in "
+            "parallel and packed into a single UV map. Allows flattening "
+            "meshes with several components or cut into patches.")
+        ("uv-chart-padding", po::value<double>()->default_value(
+            texturing::ChartFlattening::DEFAULT_PADDING),
+            "Gap between packed charts, relative to the size of the UV map.")
+        ("uv-relax-iterations", po::value<std::size_t>()->default_value(10),
+            "Number of relaxation iterations applied to the interpolated UVs "
+            "when uv-proxy-vertices is specified.")
         ("uv-rotate", po::value<double>(), "Rotate the generated UV map by an "
             "angle in degrees (counterclockwise).")
         ("uv-flip", po::value<int>(),
@@ -172,7 +331,10 @@ static auto GetFilteringOpts() -> po::options_description
         ("shading", po::value<int>()->default_value(1),
             "Surface Normal Shading:\n"
                 "  0 = Flat\n"
-                "  1 = Smooth");
+                "  1 = Smooth")
+        ("gpu", po::value<bool>()->default_value(false), "Use the GPU for "
+            "Composite and Integral texturing, if available. Requires a "
+            "Line neighborhood.");
     // clang-format on
 
     return opts;
@@ -240,190 +402,175 @@ static auto GetThicknessOpts() -> po::options_description
     return opts;
 }
 
-auto main(int argc, char* argv[]) -> int
+// Logs a volume's cache statistics periodically and on destruction
+class CacheStatsLogger
 {
-    ///// Parse the command line options /////
-    po::options_description all("Usage");
-    all.add(GetGeneralOpts())
-        .add(GetIOOpts())
-        .add(GetMeshingOpts())
-        .add(GetUVOpts())
-        .add(GetFilteringOpts())
-        .add(GetCompositeOpts())
-        .add(GetIntegralOpts())
-        .add(GetThicknessOpts());
-
-    // Parse the cmd line
-    po::variables_map parsed;
-    try {
-        po::store(
-            po::command_line_parser(argc, argv).options(all).run(), parsed);
-    } catch (const po::error& e) {
-        Logger()->error(e.what());
-        return EXIT_FAILURE;
+public:
+    CacheStatsLogger(Volume::Pointer volume, double interval)
+        : volume_{std::move(volume)}
+    {
+        if (interval <= 0) {
+            return;
+        }
+        std::chrono::duration<double> period{interval};
+        thread_ = std::thread([this, period]() {
+            std::unique_lock<std::mutex> lock(mutex_);
+            auto done = [this]() { return done_; };
+            while (not cv_.wait_for(lock, period, done)) {
+                Logger()->info(
+                    "Cache stats: {}", volume_->cacheStats().summary());
+            }
+        });
     }
 
-    // Show the help message
-    if (parsed.count("help") > 0 || argc < 5) {
-        std::cout << all << std::endl;
-        return EXIT_SUCCESS;
-    }
+    CacheStatsLogger(const CacheStatsLogger&) = delete;
+    auto operator=(const CacheStatsLogger&) -> CacheStatsLogger& = delete;
 
-    // Warn of missing options
-    try {
-        po::notify(parsed);
-    } catch (po::error& e) {
-        Logger()->error(e.what());
-        return EXIT_FAILURE;
+    ~CacheStatsLogger()
+    {
+        {
+            const std::lock_guard<std::mutex> lock(mutex_);
+            done_ = true;
+        }
+        cv_.notify_all();
+        if (thread_.joinable()) {
+            thread_.join();
+        }
+        Logger()->info(
+            "Final cache stats: {}", volume_->cacheStats().summary());
     }
 
-    // Set logging level
-    auto logLevel = parsed["log-level"].as<std::string>();
-    to_lower(logLevel);
-    logging::SetLogLevel(logLevel);
-
-    // Register VC graph nodes
-    vc::RegisterNodes();
-
-    ///// Load the volume package /////
-    fs::path volpkgPath = parsed["volpkg"].as<std::string>();
-    Logger()->info(
-        "Loading VolumePkg: {}",
-        fs::weakly_canonical(volpkgPath).filename().string());
+private:
+    Volume::Pointer volume_;
+    std::thread thread_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool done_{false};
+};
+
+
+// A render of one segmentation or mesh
+struct RenderJob {
+    // Segmentation ID. Empty when rendering a mesh file.
+    Segmentation::Identifier segId;
+    // Input mesh path. Empty when rendering a segmentation.
+    fs::path meshPath;
+    // Volume used for texturing. Empty for the default volume.
+    Volume::Identifier volId;
+    // Z range of the segmentation's points
+    double zMin{0};
+    double zMax{0};
+    // Output file path
+    fs::path outputPath;
+    // Prefix for the file names of auxiliary outputs, e.g. the PPM
+    std::string prefix;
+    // Texture checkpoint. Null if checkpoints are disabled.
+    texturing::TextureCheckpoint::Pointer checkpoint;
+};
+
+// State shared by every render job
+struct RenderContext {
+    const po::variables_map& parsed;
     VolumePkg::Pointer vpkg;
-    try {
-        vpkg = VolumePkg::New(volpkgPath);
-    } catch (const std::exception& e) {
-        Logger()->critical(e.what());
-        return EXIT_FAILURE;
+    smgl::Metadata projectInfo;
+    std::size_t cacheBytes;
+    NodeOutputCache::Pointer outputCache;
+    // Index of the texture part to render
+    std::size_t partIndex{0};
+    // Number of texture parts
+    std::size_t partCount{1};
+    // Calibration of the resource estimates
+    ResourceCalibration calibration;
+    // Whether renders record their resource estimate in their profile
+    bool recordEstimate{false};
+    // Guards the creation of Render graphs in the volume package
+    std::mutex renderMutex;
+};
+
+// Add a job's prefix to the file name of an auxiliary output path
+static auto AuxPath(const RenderJob& job, const fs::path& path) -> fs::path
+{
+    if (job.prefix.empty()) {
+        return path;
     }
+    return path.parent_path() / (job.prefix + path.filename().string());
+}
 
-    if (vpkg->version() != VOLPKG_SUPPORTED_VERSION) {
-        Logger()->error(
-            "Volume Package is version {} but this program requires version {}",
-            vpkg->version(), VOLPKG_SUPPORTED_VERSION);
-        return EXIT_FAILURE;
-    }
+// Get a job's volume
+static auto JobVolume(const VolumePkg::Pointer& vpkg, const RenderJob& job)
+    -> Volume::Pointer
+{
+    return job.volId.empty() ? vpkg->volume() : vpkg->volume(job.volId);
+}
 
-    //// Create the graph pipeline ////
-    std::shared_ptr<smgl::Graph> graph;
-    if (parsed["save-graph"].as<bool>()) {
-        auto render = vpkg->newRender();
-        graph = render->graph();
-        vc::Logger()->info(
-            "Created new Render graph in VolPkg: {}", render->id());
-    } else {
-        graph = std::make_shared<smgl::Graph>();
+// Get the neighborhood radius given by --radius
+static auto ParseRadius(const po::variables_map& parsed) -> cv::Vec3d
+{
+    cv::Vec3d radius;
+    auto parsedRadius = parsed["radius"].as<std::vector<double>>();
+    radius[0] = parsedRadius[0];
+    radius[1] = radius[2] = std::sqrt(std::abs(radius[0]));
+    if (parsedRadius.size() >= 2) {
+        radius[1] = parsedRadius[1];
+    }
+    if (parsedRadius.size() >= 3) {
+        radius[2] = parsedRadius[2];
     }
+    return radius;
+}
+
+// Build the render graph for a job. Returns false if the options are invalid.
+static auto BuildGraph(
+    RenderContext& ctx,
+    const RenderJob& job,
+    GraphProfiler& profiler,
+    AsyncNodeExecutor& background) -> bool
+{
+    const auto& parsed = ctx.parsed;
+    const auto& vpkg = ctx.vpkg;
+    const auto& outputCache = ctx.outputCache;
 
-    // Add the project metadata
-    // clang-format off
-    smgl::Metadata projectInfo{{
-        vc::ProjectInfo::Name(), {
-            {"version", ProjectInfo::VersionString()},
-            {"git-url", ProjectInfo::RepositoryURL()},
-            {"git-hash", ProjectInfo::RepositoryHash()},
-            {"volpkg", {
-                {"path", fs::weakly_canonical(volpkgPath).filename().string()},
-                {"name", vpkg->name()}
-            }}
-        }}
-    };
-    // clang-format on
-    graph->setProjectMetadata(projectInfo);
     // Setup a map to keep a reference to important output ports
     std::unordered_map<std::string, smgl::Output*> results;
 
     //// Load the segmentation/mesh ////
-    bool loadSeg = parsed.count("seg") > 0;
-    bool loadMesh = parsed.count("input-mesh") > 0;
-    if (loadSeg && loadMesh) {
-        Logger()->error(
-            "Specified mutually exclusive flags: --seg and --input-mesh");
-        return EXIT_FAILURE;
-    } else if (not loadSeg and not loadMesh) {
-        Logger()->error("Missing required flag: --seg or --input-mesh");
-        return EXIT_FAILURE;
-    }
-
-    std::string outStem;
+    bool loadSeg = not job.segId.empty();
     if (loadSeg) {
-        auto id = parsed["seg"].as<std::string>();
-        outStem = id;
-
-        auto seg = graph->insertNode<SegmentationSelectorNode>();
+        auto seg = profiler.insertNode<SegmentationSelectorNode>();
         seg->volpkg = vpkg;
-        seg->id = id;
+        seg->id = job.segId;
 
-        auto getPts = graph->insertNode<SegmentationPropertiesNode>();
+        auto getPts = profiler.insertNode<SegmentationPropertiesNode>();
         getPts->segmentation = seg->segmentation;
 
-        auto mesher = graph->insertNode<MeshingNode>();
+        auto mesher = profiler.insertNode<MeshingNode>();
         mesher->points = getPts->pointSet;
         results["mesh"] = &mesher->mesh;
     } else {
-        fs::path inputPath = parsed["input-mesh"].as<std::string>();
-        outStem = inputPath.stem().string();
-
-        auto reader = graph->insertNode<LoadMeshNode>();
-        reader->path = inputPath;
+        auto reader = profiler.insertNode<LoadMeshNode>();
+        reader->path = job.meshPath;
         reader->cacheArgs = true;
         results["mesh"] = &reader->mesh;
         if (parsed.count("uv-reuse") > 0) {
             results["uvMap"] = &reader->uvMap;
         }
     }
-
-    //// Setup the output file path ////
-    fs::path outputPath;
-    if (parsed.count("output-file") > 0) {
-        outputPath = parsed["output-file"].as<std::string>();
-    } else {
-        outputPath = outStem + "_render.obj";
-    }
+    const auto& outputPath = job.outputPath;
 
     //// Load the Volume ////
-    if (not vpkg->hasVolumes()) {
-        Logger()->error("Volume package does not contain any volumes");
-        return EXIT_FAILURE;
-    }
-    auto volumeSelector = graph->insertNode<VolumeSelectorNode>();
+    auto volumeSelector = profiler.insertNode<VolumeSelectorNode>();
     volumeSelector->volpkg = vpkg;
-    Volume::Identifier volId;
-    if (parsed.count("volume") > 0) {
-        volId = parsed["volume"].as<std::string>();
-    } else if (loadSeg) {
-        auto segId = parsed["seg"].as<std::string>();
-        auto seg = vpkg->segmentation(segId);
-        if (seg->hasVolumeID()) {
-            volId = seg->getVolumeID();
-            Logger()->debug(
-                "Selecting segmentation associated volume: {}", volId);
-        }
-    }
-    if (not volId.empty() and not vpkg->hasVolume(volId)) {
-        Logger()->error(
-            "Volume package does not contain volume with ID: {}", volId);
-        return EXIT_FAILURE;
-    }
-    volumeSelector->id = volId;
+    volumeSelector->id = job.volId;
 
-    // Set the cache size
-    std::size_t cacheBytes{2'000'000'000};
-    if (parsed.count("cache-memory-limit") > 0) {
-        auto cacheSizeOpt = parsed["cache-memory-limit"].as<std::string>();
-        cacheBytes = MemorySizeStringParser(cacheSizeOpt);
-    } else {
-        cacheBytes = SystemMemorySize() / 2;
-    }
-    auto volumeProps = graph->insertNode<VolumePropertiesNode>();
+    // Every job shares the volume and its cache
+    auto volumeProps = profiler.insertNode<VolumePropertiesNode>();
     volumeProps->volumeIn = volumeSelector->volume;
-    volumeProps->cacheMemory = cacheBytes;
+    volumeProps->cacheMemory = ctx.cacheBytes;
     results["volume"] = &volumeProps->volumeOut;
 
     //// Scale the mesh /////
     if (parsed.count("scale-mesh") > 0) {
-        auto scaleMesh = graph->insertNode<ScaleMeshNode>();
+        auto scaleMesh = profiler.insertNode<ScaleMeshNode>();
         scaleMesh->input = *results["mesh"];
         scaleMesh->scaleFactor = parsed["scale-mesh"].as<double>();
         results["mesh"] = &scaleMesh->output;
@@ -436,14 +583,17 @@ auto main(int argc, char* argv[]) -> int
         auto smoothType =
             static_cast<SmoothOpt>(parsed["mesh-resample-smoothing"].as<int>());
         if (smoothType == SmoothOpt::Both || smoothType == SmoothOpt::Before) {
-            auto smooth = graph->insertNode<LaplacianSmoothMeshNode>();
+            auto smooth = profiler.insertNode<LaplacianSmoothMeshNode>();
             smooth->input = *results["mesh"];
             results["mesh"] = &smooth->output;
         }
 
         // Setup resampling
-        auto resample = graph->insertNode<ResampleMeshNode>();
+        auto resample = profiler.insertNode<ResampleMeshNode>();
+        resample->setOutputCache(outputCache);
         resample->input = *results["mesh"];
+        resample->method = static_cast<ResampleMeshNode::Method>(
+            parsed["mesh-resample-method"].as<int>());
         if (parsed.count("mesh-resample-anisotropic") > 0) {
             resample->mode = ResampleMeshNode::Mode::Anisotropic;
         } else {
@@ -459,13 +609,13 @@ auto main(int argc, char* argv[]) -> int
         }
 
         else if (parsed.count("mesh-resample-keep-vcount") > 0) {
-            auto meshProps = graph->insertNode<MeshPropertiesNode>();
+            auto meshProps = profiler.insertNode<MeshPropertiesNode>();
             meshProps->mesh = *results["mesh"];
             resample->numVertices = meshProps->numVertices;
         }
 
         else {
-            auto calcVerts = graph->insertNode<CalculateNumVertsNode>();
+            auto calcVerts = profiler.insertNode<CalculateNumVertsNode>();
             calcVerts->mesh = *results["mesh"];
             calcVerts->voxelSize = volumeProps->voxelSize;
             calcVerts->density = parsed["mesh-resample-factor"].as<double>();
@@ -475,17 +625,27 @@ auto main(int argc, char* argv[]) -> int
 
         // Post-smooth
         if (smoothType == SmoothOpt::Both || smoothType == SmoothOpt::After) {
-            auto smooth = graph->insertNode<LaplacianSmoothMeshNode>();
+            auto smooth = profiler.insertNode<LaplacianSmoothMeshNode>();
             smooth->input = *results["mesh"];
             results["mesh"] = &smooth->output;
         }
 
         // Save the intermediate mesh
         if (parsed.count("intermediate-mesh") > 0) {
-            fs::path meshPath = parsed["intermediate-mesh"].as<std::string>();
-            auto writer = graph->insertNode<WriteMeshNode>();
+            auto meshPath = AuxPath(
+                job, parsed["intermediate-mesh"].as<std::string>());
+            auto writer = profiler.insertNode<WriteMeshNode>();
             writer->path = meshPath;
             writer->mesh = *results["mesh"];
+            using PLYFormat = WriteMeshNode::PLYFormat;
+            using PLYPrecision = WriteMeshNode::PLYPrecision;
+            auto format = parsed["intermediate-mesh-format"].as<int>();
+            if (format == 1 or format == 2) {
+                writer->plyFormat = PLYFormat::BinaryLittleEndian;
+                writer->plyPrecision = (format == 2) ? PLYPrecision::Float64
+                                                     : PLYPrecision::Float32;
+            }
+            background.attach(writer);
         }
     }
 
@@ -501,15 +661,89 @@ auto main(int argc, char* argv[]) -> int
     if (results.count("uvMap") == 0) {
         auto method =
             static_cast<FlatteningAlgorithm>(parsed["uv-algorithm"].as<int>());
-        if (method == FlatteningAlgorithm::ABF ||
+        using Solver = texturing::AngleBasedFlattening::Solver;
+        auto solver = static_cast<Solver>(parsed["uv-solver"].as<int>());
+        if (not texturing::AngleBasedFlattening::SolverAvailable(solver)) {
+            Logger()->warn(
+                "Selected UV solver is not available. Using Sparse LU.");
+            solver = Solver::SparseLU;
+        }
+        auto hierarchical = parsed.count("uv-proxy-vertices") > 0;
+        auto charts = parsed.count("uv-charts") > 0;
+        if (charts and (method == FlatteningAlgorithm::ABF ||
+                        method == FlatteningAlgorithm::LSCM)) {
+            if (hierarchical) {
+                Logger()->warn(
+                    "Provided '--uv-proxy-vertices' option with chart "
+                    "flattening. Flattening charts directly.");
+            }
+            if (parsed.count("uv-seed") > 0) {
+                Logger()->warn(
+                    "Provided '--uv-seed' option with chart flattening. "
+                    "Ignoring seed UV map.");
+            }
+            auto flatten = profiler.insertNode<ChartFlatteningNode>();
+            flatten->setOutputCache(outputCache);
+            flatten->input = *results["mesh"];
+            flatten->useABF = (method == FlatteningAlgorithm::ABF);
+            flatten->solver = solver;
+            flatten->padding = parsed["uv-chart-padding"].as<double>();
+            results["uvMap"] = &flatten->uvMap;
+            results["uvMesh"] = &flatten->output;
+
+            auto calcError = profiler.insertNode<FlatteningErrorNode>();
+            calcError->mesh3D = *results["mesh"];
+            calcError->mesh2D = flatten->output;
+            results["flatteningError"] = &calcError->error;
+        }
+
+        else if (hierarchical and (method == FlatteningAlgorithm::ABF ||
+                              method == FlatteningAlgorithm::LSCM)) {
+            if (parsed.count("uv-seed") > 0) {
+                Logger()->warn(
+                    "Provided '--uv-seed' option with hierarchical "
+                    "flattening. Ignoring seed UV map.");
+            }
+            auto flatten = profiler.insertNode<HierarchicalFlatteningNode>();
+            flatten->setOutputCache(outputCache);
+            flatten->input = *results["mesh"];
+            flatten->useABF = (method == FlatteningAlgorithm::ABF);
+            flatten->proxyVertices =
+                parsed["uv-proxy-vertices"].as<std::size_t>();
+            flatten->relaxationIterations =
+                parsed["uv-relax-iterations"].as<std::size_t>();
+            flatten->solver = solver;
+            results["uvMap"] = &flatten->uvMap;
+            results["uvMesh"] = &flatten->output;
+
+            auto calcError = profiler.insertNode<FlatteningErrorNode>();
+            calcError->mesh3D = *results["mesh"];
+            calcError->mesh2D = flatten->output;
+            results["flatteningError"] = &calcError->error;
+        }
+
+        else if (
+            method == FlatteningAlgorithm::ABF ||
             method == FlatteningAlgorithm::LSCM) {
-            auto flatten = graph->insertNode<ABFNode>();
+            auto flatten = profiler.insertNode<ABFNode>();
+            flatten->setOutputCache(outputCache);
             flatten->input = *results["mesh"];
             flatten->useABF = (method == FlatteningAlgorithm::ABF);
+            flatten->solver = solver;
+            if (parsed.count("uv-seed") > 0 and needResample) {
+                Logger()->warn(
+                    "Provided '--uv-seed' option, but input mesh has been "
+                    "resampled. Ignoring seed UV map.");
+            } else if (parsed.count("uv-seed") > 0) {
+                auto seed = profiler.insertNode<LoadMeshNode>();
+                seed->path = parsed["uv-seed"].as<std::string>();
+                seed->cacheArgs = true;
+                flatten->seedUVMap = seed->uvMap;
+            }
             results["uvMap"] = &flatten->uvMap;
             results["uvMesh"] = &flatten->output;
 
-            auto calcError = graph->insertNode<FlatteningErrorNode>();
+            auto calcError = profiler.insertNode<FlatteningErrorNode>();
             calcError->mesh3D = *results["mesh"];
             calcError->mesh2D = flatten->output;
             results["flatteningError"] = &calcError->error;
@@ -517,7 +751,7 @@ auto main(int argc, char* argv[]) -> int
 
         // Orthographic
         else if (method == FlatteningAlgorithm::Orthographic) {
-            auto flatten = graph->insertNode<OrthographicFlatteningNode>();
+            auto flatten = profiler.insertNode<OrthographicFlatteningNode>();
             flatten->input = *results["mesh"];
             results["uvMap"] = &flatten->uvMap;
             results["uvMesh"] = &flatten->output;
@@ -528,13 +762,13 @@ auto main(int argc, char* argv[]) -> int
             Logger()->error(
                 "Provided unrecognized flattening option: {}",
                 parsed["uv-algorithm"].as<int>());
-            return EXIT_FAILURE;
+            return false;
         }
     }
 
     // Rotate
     if (parsed.count("uv-rotate") > 0) {
-        auto rotate = graph->insertNode<RotateUVMapNode>();
+        auto rotate = profiler.insertNode<RotateUVMapNode>();
         rotate->uvMapIn = *results["uvMap"];
         rotate->theta = parsed["uv-rotate"].as<double>();
         results["uvMap"] = &rotate->uvMapOut;
@@ -546,7 +780,7 @@ auto main(int argc, char* argv[]) -> int
     // Flip
     if (parsed.count("uv-flip") > 0) {
         auto axis = static_cast<UVMap::FlipAxis>(parsed["uv-flip"].as<int>());
-        auto flip = graph->insertNode<FlipUVMapNode>();
+        auto flip = profiler.insertNode<FlipUVMapNode>();
         flip->uvMapIn = *results["uvMap"];
         flip->flipAxis = axis;
         results["uvMap"] = &flip->uvMapOut;
@@ -561,7 +795,7 @@ auto main(int argc, char* argv[]) -> int
 
     // Make a UV Mesh if we don't have one yet
     if ((plotUV or plotUVError) and results.count("uvMesh") == 0) {
-        auto mesher = graph->insertNode<UVMapToMeshNode>();
+        auto mesher = profiler.insertNode<UVMapToMeshNode>();
         mesher->inputMesh = *results["mesh"];
         mesher->uvMap = *results["uvMap"];
         mesher->scaleToUVDimensions = true;
@@ -570,69 +804,77 @@ auto main(int argc, char* argv[]) -> int
 
     // Plot the UV Map
     if (plotUV) {
-        auto plot = graph->insertNode<PlotUVMapNode>();
+        auto plot = profiler.insertNode<PlotUVMapNode>();
         plot->uvMap = *results["uvMap"];
         plot->uvMesh = *results["uvMesh"];
 
-        auto writer = graph->insertNode<WriteImageNode>();
-        writer->path = parsed["uv-plot"].as<std::string>();
+        auto writer = profiler.insertNode<WriteImageNode>();
+        writer->path = AuxPath(job, parsed["uv-plot"].as<std::string>());
         writer->image = plot->plot;
+        background.attach(writer);
     }
 
     // Generate the PPM
     using Shading = PPMGeneratorNode::Shading;
-    auto ppmGen = graph->insertNode<PPMGeneratorNode>();
+    auto ppmGen = profiler.insertNode<PPMGeneratorNode>();
+    ppmGen->setOutputCache(outputCache);
     ppmGen->mesh = *results["mesh"];
     ppmGen->uvMap = *results["uvMap"];
     ppmGen->shading = static_cast<Shading>(parsed["shading"].as<int>());
+    ppmGen->partIndex = ctx.partIndex;
+    ppmGen->partCount = ctx.partCount;
 
     // Save the PPM
     if (parsed.count("output-ppm") > 0) {
-        auto writer = graph->insertNode<WritePPMNode>();
-        writer->path = parsed["output-ppm"].as<std::string>();
+        auto writer = profiler.insertNode<WritePPMNode>();
+        writer->path = AuxPath(job, parsed["output-ppm"].as<std::string>());
         writer->ppm = ppmGen->ppm;
+        background.attach(writer);
     }
 
     // Plot the UV error maps
     // Needs PPM to compute
     if (plotUVError) {
         if (results.count("flatteningError") == 0) {
-            auto calcError = graph->insertNode<FlatteningErrorNode>();
+            auto calcError = profiler.insertNode<FlatteningErrorNode>();
             calcError->mesh3D = *results["mesh"];
             calcError->mesh2D = *results["uvMesh"];
             results["flatteningError"] = &calcError->error;
         }
 
         // PPM properties
-        auto ppmProps = graph->insertNode<PPMPropertiesNode>();
+        auto ppmProps = profiler.insertNode<PPMPropertiesNode>();
         ppmProps->ppm = ppmGen->ppm;
 
         // Generate the error plots
-        auto plotErr = graph->insertNode<PlotLStretchErrorNode>();
+        auto plotErr = profiler.insertNode<PlotLStretchErrorNode>();
         plotErr->error = *results["flatteningError"];
         plotErr->cellMap = ppmProps->cellMap;
         plotErr->drawLegend = parsed["uv-plot-error-legend"].as<bool>();
 
         // Save the images
-        fs::path baseName = parsed["uv-plot-error"].as<std::string>();
+        auto baseName =
+            AuxPath(job, parsed["uv-plot-error"].as<std::string>());
         auto l2File =
             baseName.stem().string() + "_l2" + baseName.extension().string();
-        auto writerL2 = graph->insertNode<WriteImageNode>();
+        auto writerL2 = profiler.insertNode<WriteImageNode>();
         writerL2->path = baseName.parent_path() / l2File;
         writerL2->image = plotErr->l2Plot;
+        background.attach(writerL2);
 
         auto lInfFile =
             baseName.stem().string() + "_lInf" + baseName.extension().string();
-        auto writerLInf = graph->insertNode<WriteImageNode>();
+        auto writerLInf = profiler.insertNode<WriteImageNode>();
         writerLInf->path = baseName.parent_path() / lInfFile;
         writerLInf->image = plotErr->lInfPlot;
+        background.attach(writerLInf);
     }
 
     // Neighborhood generator
     Method method = static_cast<Method>(parsed["method"].as<int>());
     if (method != Method::Intersection and method != Method::Thickness) {
         using Shape = NeighborhoodGeneratorNode::Shape;
-        auto neighborGen = graph->insertNode<NeighborhoodGeneratorNode>();
+        auto neighborGen = profiler.insertNode<NeighborhoodGeneratorNode>();
         neighborGen->shape =
             static_cast<Shape>(parsed["neighborhood-shape"].as<int>());
         neighborGen->interval = parsed["interval"].as<double>();
@@ -641,20 +883,10 @@ auto main(int argc, char* argv[]) -> int
 
         // Calculate neighbordhood radius
         if (parsed.count("radius") > 0) {
-            cv::Vec3d radius;
-            auto parsedRadius = parsed["radius"].as<std::vector<double>>();
-            radius[0] = parsedRadius[0];
-            radius[1] = radius[2] = std::sqrt(std::abs(radius[0]));
-            if (parsedRadius.size() >= 2) {
-                radius[1] = parsedRadius[1];
-            }
-            if (parsedRadius.size() >= 3) {
-                radius[2] = parsedRadius[2];
-            }
-            neighborGen->radius = radius;
+            neighborGen->radius = ParseRadius(parsed);
         } else {
             auto radiusCalc =
-                graph->insertNode<CalculateNeighborhoodRadiusNode>();
+                profiler.insertNode<CalculateNeighborhoodRadiusNode>();
             radiusCalc->thickness = vpkg->materialThickness();
             radiusCalc->voxelSize = volumeProps->voxelSize;
             neighborGen->radius = radiusCalc->radius;
@@ -666,16 +898,19 @@ auto main(int argc, char* argv[]) -> int
     // Setup texturing method
     smgl::Node::Pointer texturing;
     if (method == Method::Intersection) {
-        auto t = graph->insertNode<IntersectionTextureNode>();
+        auto t = profiler.insertNode<IntersectionTextureNode>();
         texturing = t;
     }
 
     else if (method == Method::Composite) {
         using Filter = CompositeTextureNode::Filter;
         auto filter = static_cast<Filter>(parsed["filter"].as<int>());
-        auto t = graph->insertNode<CompositeTextureNode>();
+        auto t = profiler.insertNode<CompositeTextureNode>();
         t->generator = *results["generator"];
         t->filter = filter;
+        t->numThreads = parsed["threads"].as<size_t>();
+        t->useGPU = parsed["gpu"].as<bool>();
+        t->checkpoint = job.checkpoint;
         texturing = t;
     }
 
@@ -693,7 +928,7 @@ auto main(int argc, char* argv[]) -> int
         auto expoDiffBase = parsed["expodiff-base"].as<double>();
         auto clampToMax = parsed.count("clamp-to-max") > 0;
 
-        auto t = graph->insertNode<IntegralTextureNode>();
+        auto t = profiler.insertNode<IntegralTextureNode>();
         t->generator = *results["generator"];
         t->weightMethod = wType;
         t->linearWeightDirection = wDir;
@@ -704,6 +939,9 @@ auto main(int argc, char* argv[]) -> int
         if (clampToMax) {
             t->clampMax = parsed["clamp-to-max"].as<uint16_t>();
         }
+        t->numThreads = parsed["threads"].as<size_t>();
+        t->useGPU = parsed["gpu"].as<bool>();
+        t->checkpoint = job.checkpoint;
         texturing = t;
     }
 
@@ -713,13 +951,13 @@ auto main(int argc, char* argv[]) -> int
             vc::Logger()->error(
                 "Selected Thickness texturing, but did not provide volume mask "
                 "path.");
-            std::exit(EXIT_FAILURE);
+            return false;
         }
-        auto reader = graph->insertNode<LoadVolumetricMaskNode>();
+        auto reader = profiler.insertNode<LoadVolumetricMaskNode>();
         reader->cacheArgs = true;
         reader->path = parsed["volume-mask"].as<std::string>();
 
-        auto t = graph->insertNode<ThicknessTextureNode>();
+        auto t = profiler.insertNode<ThicknessTextureNode>();
         t->volumetricMask = reader->volumetricMask;
         t->normalizeOutput = parsed["normalize-output"].as<bool>();
         t->samplingInterval = parsed["interval"].as<double>();
@@ -732,12 +970,18 @@ auto main(int argc, char* argv[]) -> int
     results["texture"] = &texturing->getOutputPort("texture");
 
     // Save final outputs
-    if (vc::IsFileType(outputPath, {"png", "jpg", "jpeg", "tiff", "tif"})) {
-        auto writer = graph->insertNode<WriteImageNode>();
+    if (ctx.partCount > 1) {
+        auto writer = profiler.insertNode<WriteTexturePartNode>();
+        writer->path = outputPath;
+        writer->part = ppmGen->part;
+        writer->image = *results["texture"];
+    } else if (vc::IsFileType(
+            outputPath, {"png", "jpg", "jpeg", "tiff", "tif", "dzi"})) {
+        auto writer = profiler.insertNode<WriteImageNode>();
         writer->path = outputPath;
         writer->image = *results["texture"];
     } else if (vc::IsFileType(outputPath, {"obj", "ply"})) {
-        auto writer = graph->insertNode<WriteMeshNode>();
+        auto writer = profiler.insertNode<WriteMeshNode>();
         writer->path = outputPath;
         writer->mesh = *results["mesh"];
         writer->uvMap = *results["uvMap"];
@@ -746,12 +990,858 @@ auto main(int argc, char* argv[]) -> int
         vc::Logger()->error(
             "Unrecognized output format: {}", outputPath.extension().string());
     }
+    return true;
+}
+
+// Get a job's display name
+static auto JobName(const RenderJob& job) -> std::string
+{
+    return job.segId.empty() ? job.meshPath.string() : job.segId;
+}
+
+// Predict the peak memory and volume reads of a job from its inputs and
+// options, without running its graph
+static auto EstimateJob(const RenderContext& ctx, const RenderJob& job)
+    -> ResourceEstimate
+{
+    using RE = ResourceEstimator;
+    const auto& parsed = ctx.parsed;
+    auto volume = JobVolume(ctx.vpkg, job);
+
+    // Measure the input geometry
+    std::size_t numPoints{0};
+    std::size_t numVerts{0};
+    std::size_t numFaces{0};
+    double area{0};
+    cv::Vec3d lo = cv::Vec3d::all(std::numeric_limits<double>::max());
+    cv::Vec3d hi = cv::Vec3d::all(std::numeric_limits<double>::lowest());
+    std::optional<UVMap::Ratio> uvRatio;
+    if (not job.segId.empty()) {
+        auto seg = ctx.vpkg->segmentation(job.segId);
+        if (seg->hasPointSet()) {
+            // Triangulate the quads between valid points, as MeshingNode
+            // does. Mapped to avoid reading whole files.
+            auto view = seg->getPointSetView();
+            numPoints = view.size();
+            auto valid = [](const cv::Vec3d& p) { return p[2] != -1; };
+            auto addFace = [&](const cv::Vec3d& a, const cv::Vec3d& b,
+                               const cv::Vec3d& c) {
+                if (valid(a) and valid(b) and valid(c)) {
+                    area += 0.5 * cv::norm((b - a).cross(c - a));
+                    numFaces++;
+                }
+            };
+            for (std::size_t y = 0; y < view.height(); y++) {
+                for (std::size_t x = 0; x < view.width(); x++) {
+                    auto p = view(y, x);
+                    if (not valid(p)) {
+                        continue;
+                    }
+                    numVerts++;
+                    for (int i = 0; i < 3; i++) {
+                        lo[i] = std::min(lo[i], p[i]);
+                        hi[i] = std::max(hi[i], p[i]);
+                    }
+                    if (y + 1 < view.height() and x + 1 < view.width()) {
+                        auto right = view(y, x + 1);
+                        auto down = view(y + 1, x);
+                        addFace(p, right, down);
+                        addFace(right, view(y + 1, x + 1), down);
+                    }
+                }
+            }
+        }
+    } else {
+        auto loaded = ReadMesh(job.meshPath);
+        auto flat = ToFlatMesh(loaded.mesh);
+        numVerts = flat.numVertices();
+        numFaces = flat.numFaces();
+        area = meshmath::SurfaceArea(flat);
+        if (numVerts > 0) {
+            auto bounds = meshmath::Bounds(flat);
+            lo = bounds.getLowerBound();
+            hi = bounds.getUpperBound();
+        }
+        if (parsed.count("uv-reuse") > 0 and loaded.uv) {
+            uvRatio = loaded.uv->ratio();
+        }
+    }
+    if (parsed.count("scale-mesh") > 0) {
+        auto scale = parsed["scale-mesh"].as<double>();
+        area *= scale * scale;
+        lo *= scale;
+        hi *= scale;
+    }
+
+    ResourceEstimator estimator;
+    estimator.setVolume(volume);
+    estimator.setCacheBytes(ctx.cacheBytes);
+    estimator.setCalibration(ctx.calibration);
+
+    // Meshing keeps the input and the resampled mesh
+    auto outVerts = numVerts;
+    auto outFaces = numFaces;
+    auto resample =
+        not job.segId.empty() or parsed.count("enable-mesh-resampling") > 0;
+    if (resample) {
+        if (parsed.count("mesh-resample-vcount") > 0) {
+            outVerts = parsed["mesh-resample-vcount"].as<std::size_t>();
+        } else if (parsed.count("mesh-resample-keep-vcount") == 0) {
+            // As CalculateNumVertsNode
+            static constexpr double UM_TO_MM{0.000001};
+            static constexpr std::size_t MIN_NUM{100};
+            auto density = parsed["mesh-resample-factor"].as<double>();
+            auto sqVoxel = volume->voxelSize() * volume->voxelSize();
+            outVerts = std::max(
+                static_cast<std::size_t>(density * area * sqVoxel * UM_TO_MM),
+                MIN_NUM);
+        }
+        outFaces = 2 * outVerts;
+        uvRatio.reset();
+    }
+    auto inputBytes =
+        numPoints * sizeof(cv::Vec3d) + RE::MeshBytes(numVerts, numFaces);
+    if (resample) {
+        estimator.addStage(
+            "Meshing", inputBytes + RE::MeshBytes(outVerts, outFaces),
+            RE::MeshBytes(numVerts, numFaces));
+    } else {
+        estimator.addStage("Meshing", inputBytes);
+    }
+
+    // Flattening keeps the UV map and the flattened mesh
+    std::uint64_t uvBytes = outVerts * sizeof(cv::Vec2d);
+    if (uvRatio) {
+        estimator.addStage("Flattening", uvBytes);
+    } else {
+        auto method =
+            static_cast<FlatteningAlgorithm>(parsed["uv-algorithm"].as<int>());
+        auto flatVerts = outVerts;
+        if (parsed.count("uv-proxy-vertices") > 0 and
+            parsed.count("uv-charts") == 0) {
+            flatVerts = std::min(
+                flatVerts, parsed["uv-proxy-vertices"].as<std::size_t>());
+        }
+        std::uint64_t scratch{0};
+        if (method == FlatteningAlgorithm::ABF) {
+            scratch = 2 * flatVerts * ABF_FACE_BYTES;
+        } else if (method == FlatteningAlgorithm::LSCM) {
+            scratch = flatVerts * LSCM_VERTEX_BYTES;
+        }
+        estimator.addStage(
+            "Flattening", uvBytes + RE::MeshBytes(outVerts, outFaces),
+            scratch);
+    }
+
+    // The UV map is scaled so that a pixel is about one voxel wide
+    std::size_t width{0};
+    std::size_t height{0};
+    if (uvRatio) {
+        width = static_cast<std::size_t>(std::ceil(uvRatio->width));
+        height = static_cast<std::size_t>(std::ceil(uvRatio->height));
+    } else {
+        auto side = std::ceil(std::sqrt(area / UV_FILL_RATIO));
+        width = height = static_cast<std::size_t>(side);
+    }
+    height = (height + ctx.partCount - 1) / ctx.partCount;
+    estimator.addStage(
+        "PPM", RE::PPMBytes(height, width) + outFaces * BVH_FACE_BYTES);
+
+    // Texturing samples a neighborhood at every pixel
+    auto method = static_cast<Method>(parsed["method"].as<int>());
+    cv::Vec3d radius;
+    std::size_t samples{1};
+    if (method != Method::Intersection and method != Method::Thickness) {
+        if (parsed.count("radius") > 0) {
+            radius = ParseRadius(parsed);
+        } else {
+            // As CalculateNeighborhoodRadiusNode
+            radius[0] = ctx.vpkg->materialThickness() / 2 / volume->voxelSize();
+            radius[1] = radius[2] = std::abs(std::sqrt(radius[0]));
+        }
+        auto interval = parsed["interval"].as<double>();
+        auto steps = [interval](double r) {
+            return static_cast<std::size_t>(std::floor(std::abs(r) / interval));
+        };
+        if (parsed["direction"].as<int>() == 0) {
+            samples = 2 * steps(radius[0]) + 1;
+        } else {
+            samples = steps(radius[0]) + 1;
+        }
+        if (parsed["neighborhood-shape"].as<int>() == 1) {
+            samples *= (2 * steps(radius[1]) + 1) * (2 * steps(radius[2]) + 1);
+        }
+    }
+    std::uint64_t textureBytes = height * width * sizeof(std::uint16_t);
+    std::uint64_t scratch =
+        samples * ThreadPool::Global().numThreads() * sizeof(double);
+    if (method == Method::Thickness) {
+        textureBytes = height * width * sizeof(float);
+        if (parsed.count("volume-mask") > 0) {
+            fs::path maskPath = parsed["volume-mask"].as<std::string>();
+            if (fs::exists(maskPath)) {
+                textureBytes += fs::file_size(maskPath);
+            }
+        }
+    }
+    estimator.addStage(
+        "Texturing", textureBytes, scratch, method != Method::Thickness);
+
+    // Texturing reads the voxels within the neighborhood of the mesh
+    if (numVerts > 0) {
+        auto pad = cv::Vec3d::all(
+            std::max({std::abs(radius[0]), std::abs(radius[1]),
+                      std::abs(radius[2])}) +
+            1);
+        estimator.setRegion(lo - pad, hi + pad);
+    }
+
+    auto est = estimator.compute();
+    est.name = JobName(job);
+    return est;
+}
+
+// Build and run the render graph for a job. Returns false if it failed.
+static auto RunJob(RenderContext& ctx, const RenderJob& job) -> bool
+{
+    //// Create the graph pipeline ////
+    std::shared_ptr<smgl::Graph> graph;
+    Render::Pointer render;
+    if (ctx.parsed["save-graph"].as<bool>()) {
+        const std::lock_guard<std::mutex> lock(ctx.renderMutex);
+        render = ctx.vpkg->newRender();
+        graph = render->graph();
+        vc::Logger()->info(
+            "Created new Render graph in VolPkg: {}", render->id());
+    } else {
+        graph = std::make_shared<smgl::Graph>();
+    }
+    graph->setProjectMetadata(ctx.projectInfo);
+
+    // Record the resource usage of every node
+    GraphProfiler profiler(graph);
+
+    // Write intermediate results in the background
+    AsyncNodeExecutor background;
+
+    if (not BuildGraph(ctx, job, profiler, background)) {
+        return false;
+    }
+
+    // Record the predicted resources alongside the measured ones so that
+    // later estimates can be calibrated
+    std::optional<ResourceEstimate> estimate;
+    if (render and ctx.recordEstimate) {
+        try {
+            estimate = EstimateJob(ctx, job);
+        } catch (const std::exception& e) {
+            Logger()->debug(
+                "Could not estimate {}: {}", JobName(job), e.what());
+        }
+    }
 
     // Update the graph
     try {
         graph->update();
+        background.wait();
     } catch (const std::exception& e) {
+        Logger()->error("Failed to render {}: {}", JobName(job), e.what());
+        return false;
+    }
+
+    // The outputs are written, so the checkpoint is no longer needed
+    if (job.checkpoint) {
+        job.checkpoint->clear();
+    }
+
+    // Report the node profiles
+    Logger()->info(
+        "Render graph profile ({}):\n{}", JobName(job), profiler.summary());
+    if (render) {
+        auto profile = profiler.metadata();
+        if (estimate) {
+            profile["estimate"] = estimate->metadata();
+        }
+        render->setProfile(profile);
+    }
+    return true;
+}
+
+// Read segmentation IDs from a manifest with one ID per line
+static auto ReadManifest(const fs::path& path) -> std::vector<std::string>
+{
+    std::ifstream file(path);
+    if (not file.is_open()) {
+        throw std::runtime_error("Could not open manifest: " + path.string());
+    }
+
+    std::vector<std::string> ids;
+    std::string line;
+    while (std::getline(file, line)) {
+        // Drop comments and blank lines
+        line = line.substr(0, line.find('#'));
+        trim(line);
+        if (not line.empty()) {
+            ids.emplace_back(line);
+        }
+    }
+    return ids;
+}
+
+// Parse a texture part given as i/N
+static auto ParseTile(const std::string& s)
+    -> std::pair<std::size_t, std::size_t>
+{
+    auto pos = s.find('/');
+    if (pos == std::string::npos) {
+        throw std::invalid_argument("Expected i/N: " + s);
+    }
+    std::size_t index{0};
+    std::size_t count{0};
+    try {
+        index = std::stoul(s.substr(0, pos));
+        count = std::stoul(s.substr(pos + 1));
+    } catch (const std::exception&) {
+        throw std::invalid_argument("Expected i/N: " + s);
+    }
+    if (count == 0 or index >= count) {
+        throw std::invalid_argument("Expected 0 <= i < N: " + s);
+    }
+    return {index, count};
+}
+
+// Tracked memory in use, not counting the slice caches
+static auto WorkingMemory() -> std::size_t
+{
+    auto usage = memory::Sample();
+    auto cache = usage[static_cast<std::size_t>(MemoryCategory::SliceCache)];
+    std::size_t total{0};
+    for (const auto& bytes : usage) {
+        total += bytes;
+    }
+    return total - cache;
+}
+
+auto main(int argc, char* argv[]) -> int
+{
+    ///// Parse the command line options /////
+    po::options_description all("Usage");
+    all.add(GetGeneralOpts())
+        .add(GetIOOpts())
+        .add(GetBatchOpts())
+        .add(GetMeshingOpts())
+        .add(GetUVOpts())
+        .add(GetFilteringOpts())
+        .add(GetCompositeOpts())
+        .add(GetIntegralOpts())
+        .add(GetThicknessOpts());
+
+    // Parse the cmd line
+    po::variables_map parsed;
+    try {
+        po::store(
+            po::command_line_parser(argc, argv).options(all).run(), parsed);
+    } catch (const po::error& e) {
+        Logger()->error(e.what());
+        return EXIT_FAILURE;
+    }
+
+    // Show the help message
+    if (parsed.count("help") > 0 || argc < 5) {
+        std::cout << all << std::endl;
+        return EXIT_SUCCESS;
+    }
+
+    // Warn of missing options
+    try {
+        po::notify(parsed);
+    } catch (po::error& e) {
         Logger()->error(e.what());
         return EXIT_FAILURE;
     }
+
+    // Set logging level
+    auto logLevel = parsed["log-level"].as<std::string>();
+    to_lower(logLevel);
+    logging::SetLogLevel(logLevel);
+
+    // Size the thread pool shared by every node
+    ThreadPool::SetGlobalThreads(parsed["threads"].as<size_t>());
+
+    // Bound the tracked memory
+    if (parsed.count("memory-soft-limit") > 0) {
+        auto limit = parsed["memory-soft-limit"].as<std::string>();
+        memory::SetSoftLimit(MemorySizeStringParser(limit));
+    }
+
+    // Back large buffers with huge pages
+    try {
+        auto mode = parsed["large-pages"].as<std::string>();
+        to_lower(mode);
+        memory::SetLargePages(memory::ParseLargePageMode(mode));
+    } catch (const std::invalid_argument& e) {
+        Logger()->error(e.what());
+        return EXIT_FAILURE;
+    }
+
+    // Record tracing spans. Written even if the render fails.
+    std::optional<fs::path> tracePath;
+    if (parsed.count("trace") > 0) {
+        tracePath = parsed["trace"].as<std::string>();
+        tracing::SetEnabled(true);
+    }
+    auto writeTrace = [&tracePath]() {
+        if (not tracePath) {
+            return;
+        }
+        tracing::SetEnabled(false);
+        try {
+            tracing::WriteChromeTrace(*tracePath);
+            Logger()->info("Wrote trace: {}", tracePath->string());
+        } catch (const std::exception& e) {
+            Logger()->error("Failed to write trace: {}", e.what());
+        }
+    };
+
+    // Register VC graph nodes
+    vc::RegisterNodes();
+
+    // Estimate the jobs without rendering or modifying any outputs
+    auto estimateOnly = parsed.count("estimate") > 0;
+
+    ///// Load the volume package /////
+    fs::path volpkgPath = parsed["volpkg"].as<std::string>();
+    Logger()->info(
+        "Loading VolumePkg: {}",
+        fs::weakly_canonical(volpkgPath).filename().string());
+    VolumePkg::Pointer vpkg;
+    try {
+        vpkg = VolumePkg::New(volpkgPath);
+    } catch (const std::exception& e) {
+        Logger()->critical(e.what());
+        return EXIT_FAILURE;
+    }
+
+    if (vpkg->version() != VOLPKG_SUPPORTED_VERSION) {
+        Logger()->error(
+            "Volume Package is version {} but this program requires version {}",
+            vpkg->version(), VOLPKG_SUPPORTED_VERSION);
+        return EXIT_FAILURE;
+    }
+
+    if (not vpkg->hasVolumes()) {
+        Logger()->error("Volume package does not contain any volumes");
+        return EXIT_FAILURE;
+    }
+
+    //// Collect the render jobs ////
+    bool loadSeg = parsed.count("seg") > 0;
+    bool loadBatch =
+        parsed.count("segs") > 0 or parsed.count("seg-manifest") > 0;
+    bool loadMesh = parsed.count("input-mesh") > 0;
+    auto numInputs = int(loadSeg) + int(loadBatch) + int(loadMesh);
+    if (numInputs > 1) {
+        Logger()->error(
+            "Specified mutually exclusive flags: --seg, --segs/--seg-manifest, "
+            "and --input-mesh");
+        return EXIT_FAILURE;
+    } else if (numInputs == 0) {
+        Logger()->error(
+            "Missing required flag: --seg, --segs, --seg-manifest, or "
+            "--input-mesh");
+        return EXIT_FAILURE;
+    }
+
+    if (loadBatch and parsed.count("output-file") > 0) {
+        Logger()->error(
+            "Specified --output-file in batch mode. Use --output-dir and "
+            "--output-format instead.");
+        return EXIT_FAILURE;
+    }
+
+    std::vector<RenderJob> jobs;
+    if (loadMesh) {
+        RenderJob job;
+        job.meshPath = parsed["input-mesh"].as<std::string>();
+        if (parsed.count("output-file") > 0) {
+            job.outputPath = parsed["output-file"].as<std::string>();
+        } else {
+            job.outputPath = job.meshPath.stem().string() + "_render.obj";
+        }
+        jobs.emplace_back(job);
+    } else {
+        std::vector<std::string> ids;
+        if (loadSeg) {
+            ids.emplace_back(parsed["seg"].as<std::string>());
+        }
+        if (parsed.count("segs") > 0) {
+            ids = parsed["segs"].as<std::vector<std::string>>();
+        }
+        if (parsed.count("seg-manifest") > 0) {
+            try {
+                auto manifest = ReadManifest(
+                    parsed["seg-manifest"].as<std::string>());
+                ids.insert(ids.end(), manifest.begin(), manifest.end());
+            } catch (const std::exception& e) {
+                Logger()->error(e.what());
+                return EXIT_FAILURE;
+            }
+        }
+
+        fs::path outputDir{parsed["output-dir"].as<std::string>()};
+        auto outputFormat = parsed["output-format"].as<std::string>();
+        std::set<std::string> seen;
+        for (const auto& id : ids) {
+            if (not seen.insert(id).second) {
+                Logger()->warn("Ignoring duplicate segmentation ID: {}", id);
+                continue;
+            }
+
+            Segmentation::Pointer seg;
+            try {
+                seg = vpkg->segmentation(id);
+            } catch (const std::out_of_range&) {
+                Logger()->error(
+                    "Volume package does not contain segmentation with ID: "
+                    "{}",
+                    id);
+                return EXIT_FAILURE;
+            }
+
+            RenderJob job;
+            job.segId = id;
+            if (seg->hasVolumeID()) {
+                job.volId = seg->getVolumeID();
+                Logger()->debug(
+                    "Selecting segmentation associated volume: {}",
+                    job.volId);
+            }
+
+            if (loadBatch) {
+                job.outputPath = outputDir / (id + "_render." + outputFormat);
+                job.prefix = id + "_";
+
+                // Z range of the points. Mapped to avoid reading whole files.
+                if (seg->hasPointSet()) {
+                    auto zMin = std::numeric_limits<double>::max();
+                    auto zMax = std::numeric_limits<double>::lowest();
+                    for (const auto& p : seg->getPointSetView()) {
+                        zMin = std::min(zMin, p[2]);
+                        zMax = std::max(zMax, p[2]);
+                    }
+                    if (zMin <= zMax) {
+                        job.zMin = zMin;
+                        job.zMax = zMax;
+                    }
+                }
+            } else if (parsed.count("output-file") > 0) {
+                job.outputPath = parsed["output-file"].as<std::string>();
+            } else {
+                job.outputPath = id + "_render.obj";
+            }
+            jobs.emplace_back(job);
+        }
+
+        if (jobs.empty()) {
+            Logger()->error("No segmentations to render");
+            return EXIT_FAILURE;
+        }
+
+        if (loadBatch) {
+            if (not vc::IsFileType(
+                    jobs.front().outputPath,
+                    {"obj", "ply", "png", "jpg", "jpeg", "tiff", "tif",
+                     "dzi"})) {
+                Logger()->error("Unrecognized output format: {}", outputFormat);
+                return EXIT_FAILURE;
+            }
+            if (not estimateOnly) {
+                fs::create_directories(outputDir);
+            }
+        }
+    }
+
+    //// Select the texture part ////
+    std::size_t partIndex{0};
+    std::size_t partCount{1};
+    if (parsed.count("tile") > 0) {
+        try {
+            std::tie(partIndex, partCount) =
+                ParseTile(parsed["tile"].as<std::string>());
+        } catch (const std::invalid_argument& e) {
+            Logger()->error("Invalid --tile: {}", e.what());
+            return EXIT_FAILURE;
+        }
+    }
+    if (partCount > 1) {
+        for (const auto& job : jobs) {
+            if (not vc::IsFileType(job.outputPath, {"tif", "tiff"})) {
+                Logger()->error(
+                    "Texture parts must be written to a TIFF: {}",
+                    job.outputPath.string());
+                return EXIT_FAILURE;
+            }
+        }
+
+        auto method = static_cast<Method>(parsed["method"].as<int>());
+        if (method == Method::Integral or method == Method::Thickness) {
+            Logger()->warn(
+                "Integral and Thickness textures may be normalized per part. "
+                "Part boundaries may be visible in the merged texture.");
+        }
+    }
+
+    //// Set up the texture checkpoints ////
+    if (parsed.count("checkpoint-dir") > 0) {
+        auto method = static_cast<Method>(parsed["method"].as<int>());
+        if (method != Method::Composite and method != Method::Integral) {
+            Logger()->warn(
+                "Texture checkpoints are only supported by the Composite and "
+                "Integral methods");
+        }
+        if (parsed["gpu"].as<bool>()) {
+            Logger()->warn("Texture checkpoints disable GPU texturing");
+        }
+        fs::path checkpointDir = parsed["checkpoint-dir"].as<std::string>();
+        auto interval = parsed["checkpoint-interval"].as<double>();
+        auto resume = parsed.count("resume") > 0;
+        for (auto& job : jobs) {
+            auto name = job.segId.empty() ? job.meshPath.stem().string()
+                                          : job.segId;
+            if (partCount > 1) {
+                name += "_part" + std::to_string(partIndex);
+            }
+            job.checkpoint =
+                texturing::TextureCheckpoint::New(checkpointDir / name);
+            job.checkpoint->setInterval(interval);
+            job.checkpoint->setKey(
+                JobName(job) + ":" + job.outputPath.string());
+            if (not resume and not estimateOnly) {
+                job.checkpoint->clear();
+            }
+        }
+    } else if (parsed.count("resume") > 0) {
+        Logger()->error("--resume requires --checkpoint-dir");
+        return EXIT_FAILURE;
+    }
+
+    //// Select the volumes ////
+    if (parsed.count("volume") > 0) {
+        auto volId = parsed["volume"].as<std::string>();
+        for (auto& job : jobs) {
+            job.volId = volId;
+        }
+    }
+    for (const auto& job : jobs) {
+        if (not job.volId.empty() and not vpkg->hasVolume(job.volId)) {
+            Logger()->error(
+                "Volume package does not contain volume with ID: {}",
+                job.volId);
+            return EXIT_FAILURE;
+        }
+    }
+
+    // Order the jobs so that consecutive renders read overlapping slices
+    // from the same volume while they are still cached
+    std::stable_sort(
+        jobs.begin(), jobs.end(), [](const auto& a, const auto& b) {
+            return std::tie(a.volId, a.zMin, a.zMax) <
+                   std::tie(b.volId, b.zMin, b.zMax);
+        });
+
+    // Load every volume up front. Jobs share them, and their caches, for the
+    // lifetime of the process.
+    std::vector<Volume::Pointer> volumes;
+    for (const auto& job : jobs) {
+        auto vol = JobVolume(vpkg, job);
+        if (std::find(volumes.begin(), volumes.end(), vol) == volumes.end()) {
+            volumes.emplace_back(vol);
+        }
+    }
+
+    // Read slices through the disk cache
+    auto sharedMemory = parsed.count("shared-memory-cache") > 0;
+    if (sharedMemory and parsed.count("disk-cache") > 0) {
+        Logger()->error(
+            "--disk-cache and --shared-memory-cache are mutually exclusive");
+        return EXIT_FAILURE;
+    }
+    if (parsed.count("disk-cache") > 0 or sharedMemory) {
+        auto diskBytes = DiskCache::DEFAULT_CAPACITY_BYTES;
+        if (parsed.count("disk-cache-limit") > 0) {
+            diskBytes = MemorySizeStringParser(
+                parsed["disk-cache-limit"].as<std::string>());
+        }
+        DiskCache::Pointer diskCache;
+        if (sharedMemory) {
+            diskCache = DiskCache::SharedMemory(
+                DiskCache::DEFAULT_SHARED_MEMORY_NAME, diskBytes);
+        } else {
+            diskCache = DiskCache::New(
+                parsed["disk-cache"].as<std::string>(), diskBytes);
+        }
+        for (const auto& vol : volumes) {
+            vol->setDiskCache(diskCache);
+        }
+    }
+
+    // Report cache statistics for the selected volumes
+    std::vector<std::unique_ptr<CacheStatsLogger>> statsLoggers;
+    for (const auto& vol : volumes) {
+        statsLoggers.emplace_back(std::make_unique<CacheStatsLogger>(
+            vol, parsed["cache-stats-interval"].as<double>()));
+    }
+
+    // Set the cache size
+    std::size_t cacheBytes{2'000'000'000};
+    if (parsed.count("cache-memory-limit") > 0) {
+        auto cacheSizeOpt = parsed["cache-memory-limit"].as<std::string>();
+        cacheBytes = MemorySizeStringParser(cacheSizeOpt);
+    } else {
+        cacheBytes = SystemMemorySize() / 2;
+    }
+
+    // Add the project metadata
+    // clang-format off
+    smgl::Metadata projectInfo{{
+        vc::ProjectInfo::Name(), {
+            {"version", ProjectInfo::VersionString()},
+            {"git-url", ProjectInfo::RepositoryURL()},
+            {"git-hash", ProjectInfo::RepositoryHash()},
+            {"volpkg", {
+                {"path", fs::weakly_canonical(volpkgPath).filename().string()},
+                {"name", vpkg->name()}
+            }}
+        }}
+    };
+    // clang-format on
+
+    // Share expensive node outputs between renders
+    NodeOutputCache::Pointer outputCache;
+    if (parsed["reuse-outputs"].as<bool>() and not estimateOnly) {
+        auto limit = NodeOutputCache::DEFAULT_CAPACITY_BYTES;
+        if (parsed.count("render-cache-limit") > 0) {
+            limit = MemorySizeStringParser(
+                parsed["render-cache-limit"].as<std::string>());
+        }
+        outputCache =
+            NodeOutputCache::New(volpkgPath / "render_cache", limit);
+    }
+
+    RenderContext ctx{parsed, vpkg, projectInfo, cacheBytes, outputCache};
+    ctx.partIndex = partIndex;
+    ctx.partCount = partCount;
+    ctx.recordEstimate = jobs.size() == 1;
+
+    //// Estimate the jobs ////
+    if (estimateOnly) {
+        ctx.calibration = RenderCalibration(*vpkg);
+        auto estimates = smgl::Metadata::array();
+        std::size_t failed{0};
+        for (const auto& job : jobs) {
+            try {
+                // Build the graph to validate the job's options
+                auto graph = std::make_shared<smgl::Graph>();
+                GraphProfiler profiler(graph);
+                AsyncNodeExecutor background;
+                if (not BuildGraph(ctx, job, profiler, background)) {
+                    failed++;
+                    continue;
+                }
+
+                auto estimate = EstimateJob(ctx, job);
+                Logger()->info(
+                    "Resource estimate ({}):\n{}", JobName(job),
+                    estimate.summary());
+                estimates.push_back(estimate.metadata());
+            } catch (const std::exception& e) {
+                Logger()->error(
+                    "Failed to estimate {}: {}", JobName(job), e.what());
+                failed++;
+            }
+        }
+
+        if (parsed.count("estimate-output") > 0) {
+            fs::path path = parsed["estimate-output"].as<std::string>();
+            std::ofstream file(path);
+            file << smgl::Metadata{{"jobs", estimates}}.dump(4) << "\n";
+            if (not file) {
+                Logger()->error("Failed to write: {}", path.string());
+                return EXIT_FAILURE;
+            }
+        }
+        writeTrace();
+        return failed > 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+    }
+
+    //// Run the jobs ////
+    auto numWorkers = std::clamp<std::size_t>(
+        parsed["batch-jobs"].as<std::size_t>(), 1, jobs.size());
+    auto budget = memory::SoftLimit();
+    if (parsed.count("batch-memory-limit") > 0) {
+        budget = MemorySizeStringParser(
+            parsed["batch-memory-limit"].as<std::string>());
+    }
+
+    // Jobs run on the shared thread pool, so their parallel stages and the
+    // jobs themselves share the --threads workers
+    auto& pool = ThreadPool::Global();
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::size_t running{0};
+    std::size_t failed{0};
+    std::vector<std::future<void>> results;
+    results.reserve(jobs.size());
+    for (std::size_t idx = 0; idx < jobs.size(); idx++) {
+        // Start another job only while the running jobs leave room in the
+        // memory budget. The slice caches shrink to fit the soft limit, so
+        // they are not counted. Jobs wait here rather than in the pool, so
+        // that a waiting job never holds a worker.
+        std::unique_lock<std::mutex> lock(mutex);
+        auto canStart = [&]() {
+            return running == 0 or
+                   (running < numWorkers and
+                    (budget == 0 or WorkingMemory() < budget));
+        };
+        while (not cv.wait_for(lock, std::chrono::seconds(1), canStart)) {
+        }
+        running++;
+        lock.unlock();
+
+        results.emplace_back(pool.submit([&, idx]() {
+            const auto& job = jobs[idx];
+            if (loadBatch) {
+                Logger()->info(
+                    "Rendering {} ({}/{})", JobName(job), idx + 1,
+                    jobs.size());
+            }
+            bool success{false};
+            try {
+                success = RunJob(ctx, job);
+            } catch (const std::exception& e) {
+                Logger()->error(
+                    "Failed to render {}: {}", JobName(job), e.what());
+            }
+
+            std::lock_guard<std::mutex> guard(mutex);
+            running--;
+            if (not success) {
+                failed++;
+            }
+            cv.notify_all();
+        }));
+    }
+    for (auto& r : results) {
+        pool.wait(r);
+    }
+
+    writeTrace();
+    Logger()->info("Memory usage:\n{}", memory::Report());
+    if (loadBatch) {
+        Logger()->info(
+            "Rendered {} of {} segmentations", jobs.size() - failed,
+            jobs.size());
+    }
+
+    return failed > 0 ? EXIT_FAILURE : EXIT_SUCCESS;
 }
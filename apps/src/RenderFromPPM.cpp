@@ -12,15 +12,18 @@
 #include "vc/apps/render/RenderIO.hpp"
 #include "vc/apps/render/RenderTexturing.hpp"
 #include "vc/core/filesystem.hpp"
+#include "vc/core/io/AsyncReader.hpp"
 #include "vc/core/io/PointSetIO.hpp"
 #include "vc/core/neighborhood/CuboidGenerator.hpp"
 #include "vc/core/neighborhood/LineGenerator.hpp"
 #include "vc/core/types/PerPixelMap.hpp"
 #include "vc/core/types/VolumePkg.hpp"
 #include "vc/core/util/MemorySizeStringParser.hpp"
+#include "vc/core/util/ThreadPool.hpp"
 #include "vc/texturing/CompositeTexture.hpp"
 #include "vc/texturing/IntegralTexture.hpp"
 #include "vc/texturing/IntersectionTexture.hpp"
+#include "vc/texturing/SamplePlan.hpp"
 #include "vc/texturing/ThicknessTexture.hpp"
 
 namespace fs = volcart::filesystem;
@@ -55,9 +58,35 @@ int main(int argc, char* argv[])
         ("tiff-floating-point", "When outputting to the TIFF format, save a "
             "floating-point image.");
 
+    po::options_description previewOpts("Preview Options");
+    previewOpts.add_options()
+        ("preview-scale", po::value<std::size_t>()->default_value(1),
+            "Render a quick preview at 1/N of the PPM resolution. If the "
+            "volume has resolution levels, samples the coarsest level which "
+            "is not coarser than the preview.");
+
+    po::options_description perfOpts("Performance Options");
+    perfOpts.add_options()
+        ("numa-slab", po::value<int>(), "Partition the slice cache between "
+            "the NUMA nodes of the system by assigning Z slabs of N slices to "
+            "the nodes in turn, and bind the texturing threads to the nodes of "
+            "the slices they sample. Default: Disabled.")
+        ("io-queue-depth", po::value<std::size_t>(), "Read the blocks of "
+            "chunked volumes with up to N reads in flight, using io_uring "
+            "where available. Default: Blocking reads.")
+        ("output-sample-plan", po::value<std::string>(), "Write the voxel "
+            "coordinates sampled by the line neighborhood of every PPM pixel "
+            "to a sample plan file, for re-texturing with --sample-plan.")
+        ("sample-plan", po::value<std::string>(), "Gather the neighborhoods "
+            "from a sample plan written by --output-sample-plan with the same "
+            "PPM and neighborhood, instead of computing them. The plan can "
+            "be replayed against any volume with the same geometry.");
+
     po::options_description all("Usage");
     all.add(GetGeneralOpts())
             .add(ioOpts)
+            .add(previewOpts)
+            .add(perfOpts)
             .add(GetFilteringOpts())
             .add(GetCompositeOpts())
             .add(GetIntegralOpts())
@@ -80,6 +109,7 @@ int main(int argc, char* argv[])
         std::cerr << "ERROR: " << e.what() << std::endl;
         return EXIT_FAILURE;
     }
+    vc::ThreadPool::SetGlobalThreads(parsed_["threads"].as<std::size_t>());
 
     // Get the parsed_ options
     fs::path volpkgPath = parsed_["volpkg"].as<std::string>();
@@ -121,6 +151,13 @@ int main(int argc, char* argv[])
     } else {
         cacheBytes = SystemMemorySize() / 2;
     }
+    if (parsed_.count("numa-slab")) {
+        volume->setNUMAPartitioning(parsed_["numa-slab"].as<int>());
+    }
+    if (parsed_.count("io-queue-depth")) {
+        volume->setAsyncReader(vc::io::AsyncReader::New(
+            parsed_["io-queue-depth"].as<std::size_t>()));
+    }
     volume->setCacheMemoryInBytes(cacheBytes);
     std::cout << "Volume Cache :: ";
     std::cout << "Capacity: " << volume->getCacheCapacity() << " || ";
@@ -170,6 +207,42 @@ int main(int argc, char* argv[])
     std::cout << "Loading PPM..." << std::endl;
     auto ppm = vc::PerPixelMap::New(vc::PerPixelMap::ReadPPM(inputPPMPath));
 
+    // Preview: Subsample the PPM and sample a matching volume level
+    auto previewScale = parsed_["preview-scale"].as<std::size_t>();
+    if (previewScale > 1) {
+        ppm = vc::PerPixelMap::New(
+            vc::PerPixelMap::Subsample(*ppm, previewScale));
+
+        // Thickness samples a full-resolution mask, not the volume
+        std::size_t level{0};
+        if (method != Method::Thickness) {
+            while (level + 1 < volume->numLevels() and
+                   vc::Volume::levelScale(level + 1) <=
+                       static_cast<double>(previewScale)) {
+                level++;
+            }
+        }
+
+        // Move the mappings and neighborhood into the level's voxel space
+        if (level > 0) {
+            auto scale = vc::Volume::levelScale(level);
+            volume = volume->level(level);
+            if (parsed_.count("numa-slab")) {
+                volume->setNUMAPartitioning(parsed_["numa-slab"].as<int>());
+            }
+            volume->setCacheMemoryInBytes(cacheBytes);
+            // Copies the map into memory once, then scales rows in parallel
+            auto tfm = cv::Matx44d::eye();
+            tfm(0, 0) = tfm(1, 1) = tfm(2, 2) = 1. / scale;
+            ppm->applyTransform(tfm);
+            radius /= scale;
+            interval /= scale;
+        }
+
+        std::cout << "Preview :: Scale: 1/" << previewScale << " || ";
+        std::cout << "Volume Level: " << level << std::endl;
+    }
+
     ///// Setup Neighborhood /////
     vc::NeighborhoodGenerator::Pointer generator;
     if (shape == Shape::Line) {
@@ -183,6 +256,24 @@ int main(int argc, char* argv[])
     generator->setSamplingInterval(interval);
     generator->setSamplingDirection(direction);
 
+    ///// Sample plan /////
+    vct::SamplePlan::Pointer plan;
+    if (parsed_.count("sample-plan") > 0) {
+        std::cout << "Loading sample plan..." << std::endl;
+        plan = vct::SamplePlan::Read(parsed_["sample-plan"].as<std::string>());
+    } else if (parsed_.count("output-sample-plan") > 0) {
+        auto line = std::dynamic_pointer_cast<vc::LineGenerator>(generator);
+        if (not line) {
+            std::cerr << "ERROR: Sample plans require a line neighborhood."
+                      << std::endl;
+            return EXIT_FAILURE;
+        }
+        std::cout << "Writing sample plan..." << std::endl;
+        plan = vct::SamplePlan::Build(*ppm, *line);
+        vct::SamplePlan::Write(
+            parsed_["output-sample-plan"].as<std::string>(), *plan);
+    }
+
     ///// Generate texture /////
     std::cout << "Generating Texture..." << std::endl;
 
@@ -228,6 +319,7 @@ int main(int argc, char* argv[])
         composite->setVolume(volume);
         composite->setFilter(filter);
         composite->setGenerator(generator);
+        composite->setSamplePlan(plan);
         textureGen = composite;
     }
 
@@ -236,6 +328,7 @@ int main(int argc, char* argv[])
         integral->setPerPixelMap(ppm);
         integral->setVolume(volume);
         integral->setGenerator(generator);
+        integral->setSamplePlan(plan);
         integral->setWeightMethod(weightType);
         integral->setLinearWeightDirection(weightDirection);
         integral->setExponentialDiffExponent(weightExponent);
@@ -147,6 +147,7 @@ vc::ITKMesh::Pointer ResampleMesh(const vc::ITKMesh::Pointer& m)
     if (smooth != SmoothOpt::Off) {
         vcm::CalculateNormals normals;
         normals.setMesh(workingMesh);
+        normals.setInPlace(true);
         workingMesh = normals.compute();
     }
 
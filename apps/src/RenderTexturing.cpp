@@ -494,6 +494,8 @@ std::vector<cv::Mat> TextureMesh(
     // Set method generic parameters
     textureGeneric->setVolume(volume_);
     textureGeneric->setPerPixelMap(ppm);
+    textureGeneric->setNumThreads(parsed_["threads"].as<size_t>());
+    textureGeneric->setNUMABinding(parsed_.count("numa-slab") > 0);
 
     // Setup progress tracker
     if (parsed_["progress"].as<bool>()) {
@@ -0,0 +1,73 @@
+#include "vc/apps/server/RingAllocator.hpp"
+
+#include <algorithm>
+#include <iterator>
+
+namespace vc = volcart;
+
+vc::RingAllocator::RingAllocator(std::size_t capacity) : capacity_{capacity}
+{
+}
+
+auto vc::RingAllocator::allocate(std::size_t size)
+    -> std::optional<std::size_t>
+{
+    size = (size + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+    if (size == 0 or size > capacity_) {
+        return std::nullopt;
+    }
+
+    // Continue after the newest region, then wrap around
+    auto offset = findFree_(head_, size);
+    if (not offset) {
+        offset = findFree_(0, size);
+    }
+    if (not offset) {
+        return std::nullopt;
+    }
+    regions_.emplace(*offset, size);
+    head_ = *offset + size;
+    bytes_ += size;
+    return offset;
+}
+
+auto vc::RingAllocator::release(std::size_t offset) -> bool
+{
+    auto it = regions_.find(offset);
+    if (it == regions_.end()) {
+        return false;
+    }
+    bytes_ -= it->second;
+    regions_.erase(it);
+    return true;
+}
+
+auto vc::RingAllocator::capacity() const -> std::size_t { return capacity_; }
+
+auto vc::RingAllocator::size() const -> std::size_t { return regions_.size(); }
+
+auto vc::RingAllocator::bytes() const -> std::size_t { return bytes_; }
+
+auto vc::RingAllocator::findFree_(std::size_t from, std::size_t size) const
+    -> std::optional<std::size_t>
+{
+    // Skip the region which contains `from`, if any
+    auto pos = from;
+    auto next = regions_.upper_bound(from);
+    if (next != regions_.begin()) {
+        auto prev = std::prev(next);
+        pos = std::max(pos, prev->first + prev->second);
+    }
+
+    // Check the gaps between the following regions
+    for (; next != regions_.end(); ++next) {
+        if (next->first - pos >= size) {
+            return pos;
+        }
+        pos = next->first + next->second;
+    }
+    if (pos <= capacity_ and capacity_ - pos >= size) {
+        return pos;
+    }
+    return std::nullopt;
+}
@@ -1,18 +1,30 @@
+#include <algorithm>
+#include <atomic>
 #include <cmath>
+#include <cstdint>
+#include <fstream>
 #include <iostream>
+#include <limits>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
 
 #include <boost/program_options.hpp>
 
 #include "vc/app_support/GeneralOptions.hpp"
 #include "vc/app_support/GetMemorySize.hpp"
+#include "vc/app_support/ResourceEstimate.hpp"
 #include "vc/app_support/ProgressIndicator.hpp"
 #include "vc/core/filesystem.hpp"
 #include "vc/core/io/PointSetIO.hpp"
 #include "vc/core/types/VolumePkg.hpp"
 #include "vc/core/util/Logging.hpp"
 #include "vc/core/util/MemorySizeStringParser.hpp"
+#include "vc/core/util/ThreadPool.hpp"
 #include "vc/meshing/OrderedPointSetMesher.hpp"
 #include "vc/segmentation/LocalResliceParticleSim.hpp"
+#include "vc/segmentation/OpticalFlowSegmentation.hpp"
 #include "vc/segmentation/ThinnedFloodFillSegmentation.hpp"
 
 namespace fs = volcart::filesystem;
@@ -37,17 +49,64 @@ static const int kDefaultPeakDistanceWeight = 50;
 static const bool kDefaultConsiderPrevious = false;
 static constexpr int kDefaultResliceSize = 32;
 
-static int SaveInterval{-1};
-static int CurrentIteration{0};
-
-enum class Algorithm { LRPS, TFF };
+enum class Algorithm { LRPS, OFS, TFF };
 
 using PointSet = vs::ThinnedFloodFillSegmentation::PointSet;
 using VoxelMask = vs::ThinnedFloodFillSegmentation::VoxelMask;
 
-static void WritePointset(const PointSet& pointset);
-static void WriteIntermediatePointset(const PointSet& pointset);
-static void WriteMaskPointset(const VoxelMask& pointset);
+// A seed chain to segment
+struct SegmentJob {
+    vc::Segmentation::Pointer seg;
+    // Progress label
+    std::string label{"Segmenting"};
+    // Prefix of the files written to the working directory
+    std::string prefix;
+    // Whether the job may draw progress bars and visualizations
+    bool interactive{true};
+};
+
+static auto RunJob(
+    const po::variables_map& parsed,
+    Algorithm alg,
+    const vc::Volume::Pointer& volume,
+    double materialThickness,
+    const SegmentJob& job) -> int;
+static auto EstimateJob(
+    const po::variables_map& parsed,
+    Algorithm alg,
+    const vc::Volume::Pointer& volume,
+    std::size_t cacheBytes,
+    double materialThickness,
+    const SegmentJob& job) -> vc::ResourceEstimate;
+static auto JobRange(
+    const po::variables_map& parsed,
+    const vc::Volume::Pointer& volume,
+    std::size_t maxIndex) -> std::pair<std::size_t, std::size_t>;
+static void WritePointset(const fs::path& path, const PointSet& pointset);
+static void WriteMaskPointset(const fs::path& path, const VoxelMask& pointset);
+
+// Draw a progress bar, or log every 10% for jobs which run concurrently
+template <class ProgressEnabled>
+static void ShowProgress(ProgressEnabled& p, const SegmentJob& job)
+{
+    if (job.interactive) {
+        vc::ReportProgress(p, job.label);
+        return;
+    }
+
+    auto iters = p.progressIterations();
+    auto reported = std::make_shared<std::size_t>(0);
+    auto label = job.label;
+    p.progressUpdated.connect([iters, reported, label](auto i) {
+        auto percent = iters == 0 ? 100 : 100 * i / iters;
+        if (percent >= *reported + 10) {
+            *reported = percent - percent % 10;
+            vc::Logger()->info("{}: {}%", label, *reported);
+        }
+    });
+    p.progressComplete.connect(
+        [label]() { vc::Logger()->info("{}: Done", label); });
+}
 
 int main(int argc, char* argv[])
 {
@@ -56,9 +115,11 @@ int main(int argc, char* argv[])
     po::options_description required("Required arguments");
     required.add_options()
         ("volpkg,v", po::value<std::string>()->required(), "VolumePkg path")
-        ("seg,s", po::value<std::string>()->required(), "Segmentation ID")
+        ("seg,s", po::value<std::vector<std::string>>()->required()
+            ->multitoken(), "Segmentation ID. Several IDs segment their seed "
+            "chains concurrently, sharing the volume's slice cache.")
         ("method,m", po::value<std::string>()->required(),
-            "Segmentation method: LRPS, TFF")
+            "Segmentation method: LRPS, OFS, TFF")
         ("volume", po::value<std::string>(),
             "Volume to use for texturing. Default: Segmentation's associated "
             "volume or the first volume in the volume package.")
@@ -71,6 +132,14 @@ int main(int argc, char* argv[])
             "Mutually exclusive with 'end-index'")
         ("step-size", po::value<double>()->default_value(kDefaultStep),
             "Z distance travelled per iteration")
+        ("seg-jobs", po::value<std::size_t>()->default_value(0),
+            "Number of segmentations run at once. If 0, runs every "
+            "segmentation at once.")
+        ("estimate", "Do not segment. Report the predicted peak memory, "
+            "the slices read, and the I/O volume of every segmentation.")
+        ("estimate-output", po::value<std::string>(), "Also write the "
+            "--estimate predictions of every segmentation to this file as "
+            "JSON.")
         ("dump-vis", "Write full visualization information to disk as algorithm runs")
             ("verbose","Output debugging information");
 
@@ -98,8 +167,37 @@ int main(int argc, char* argv[])
             po::value<bool>()->default_value(kDefaultConsiderPrevious),
             "Consider propagation of a point's previous XY position as a "
             "candidate when optimizing each iteration")
+        ("energy-fit-radius", po::value<std::size_t>()->default_value(0),
+            "Number of neighboring particles refit when evaluating the "
+            "energy of a candidate position. If 0, the whole chain is refit. "
+            "Non-zero values speed up long chains by approximating the "
+            "energy.")
+        ("lrps-threads", po::value<std::size_t>()->default_value(0),
+            "Number of threads used to generate candidate positions. If 0, "
+            "uses every thread set by --threads.")
         ("visualize", "Display curve visualization as algorithm runs");
 
+    // OFS options
+    po::options_description ofsOptions("Optical Flow Segmentation Options");
+    ofsOptions.add_options()
+        ("ofs-outside-thresh", po::value<int>()->default_value(80),
+            "Pixels darker than this threshold are considered outside the "
+            "sheet [0-255]")
+        ("ofs-flow-thresh", po::value<int>()->default_value(80),
+            "Optical flow of pixels darker than this threshold is "
+            "interpolated from brighter pixels [0-255]")
+        ("ofs-disp-thresh", po::value<std::uint32_t>()->default_value(10),
+            "Maximum optical flow displacement of a point before its flow is "
+            "replaced by the average flow of its neighborhood")
+        ("ofs-smooth-thresh", po::value<int>()->default_value(180),
+            "Points on pixels brighter than this threshold are smoothed "
+            "[0-255]")
+        ("ofs-threads", po::value<std::size_t>()->default_value(0),
+            "Maximum number of threads used for the curve segments of each "
+            "slice. If 0, uses every thread set by --threads.")
+        ("gpu", "Compute the optical flow on the GPU. Requires a build with "
+            "VC_WITH_OPENCV_CUDA and a CUDA device.");
+
     // TFF options
     po::options_description tffOptions("Thinned Flood Fill Segmentation Options");
     tffOptions.add_options()
@@ -119,10 +217,17 @@ int main(int argc, char* argv[])
             "from each seed point (measures horizontally by default)")
         ("save-interval", po::value<int>(),
             "Save the segmentation after a specified number of slices.")
-        ("save-mask","Save the mask created by the segmentation algorithm.");
+        ("save-mask","Save the mask created by the segmentation algorithm.")
+        ("tff-threads", po::value<std::size_t>()->default_value(0),
+            "Number of threads used to process each slice. If 1, slices are "
+            "processed serially. If 0, uses every thread set by --threads.");
     // clang-format on
     po::options_description all("Usage");
-    all.add(GetGeneralOpts()).add(required).add(lrpsOptions).add(tffOptions);
+    all.add(GetGeneralOpts())
+        .add(required)
+        .add(lrpsOptions)
+        .add(ofsOptions)
+        .add(tffOptions);
 
     // Parse and handle options
     po::variables_map parsed;
@@ -153,6 +258,7 @@ int main(int argc, char* argv[])
         std::cerr << "[error]: " << e.what() << std::endl;
         return EXIT_FAILURE;
     }
+    vc::ThreadPool::SetGlobalThreads(parsed["threads"].as<std::size_t>());
 
     Algorithm alg;
     auto method = parsed["method"].as<std::string>();
@@ -160,12 +266,14 @@ int main(int argc, char* argv[])
     std::cout << "Segmentation method: " << method << std::endl;
     if (method == "lrps") {
         alg = Algorithm::LRPS;
+    } else if (method == "ofs") {
+        alg = Algorithm::OFS;
     } else if (method == "tff") {
         alg = Algorithm::TFF;
     } else {
-        std::cerr
-            << "[error]: Unknown algorithm type. Must be one of ['LRPS', 'TFF']"
-            << std::endl;
+        std::cerr << "[error]: Unknown algorithm type. Must be one of "
+                     "['LRPS', 'OFS', 'TFF']"
+                  << std::endl;
         std::exit(1);
     }
 
@@ -183,26 +291,56 @@ int main(int argc, char* argv[])
         return EXIT_FAILURE;
     }
 
-    ///// Load the segmentation /////
-    vc::Segmentation::Pointer seg;
-    auto segID = parsed["seg"].as<std::string>();
-    try {
-        seg = vpkg.segmentation(segID);
-    } catch (const std::exception& e) {
-        std::cerr << "Cannot load segmentation. ";
-        std::cerr << "Please check the provided ID: " << segID << std::endl;
-        std::cerr << e.what() << std::endl;
-        return EXIT_FAILURE;
+    ///// Load the segmentations /////
+    auto segIDs = parsed["seg"].as<std::vector<std::string>>();
+    std::vector<SegmentJob> jobs;
+    for (const auto& segID : segIDs) {
+        SegmentJob job;
+        try {
+            job.seg = vpkg.segmentation(segID);
+        } catch (const std::exception& e) {
+            std::cerr << "Cannot load segmentation. ";
+            std::cerr << "Please check the provided ID: " << segID
+                      << std::endl;
+            std::cerr << e.what() << std::endl;
+            return EXIT_FAILURE;
+        }
+
+        // Concurrent jobs get their own output files and log their progress
+        // instead of drawing progress bars
+        if (segIDs.size() > 1) {
+            job.label = segID;
+            job.prefix = segID + "_";
+            job.interactive = false;
+        }
+        jobs.emplace_back(job);
+    }
+    if (jobs.size() > 1 and
+        (parsed.count("visualize") > 0 or parsed.count("dump-vis") > 0)) {
+        vc::Logger()->warn(
+            "Visualization is disabled when segmenting multiple seeds");
     }
 
     ///// Load the Volume /////
+    // Every job shares the volume and its slice cache
     vc::Volume::Pointer volume;
     vc::Volume::Identifier volID;
 
     if (parsed.count("volume")) {
         volID = parsed["volume"].as<std::string>();
-    } else if (seg->hasVolumeID()) {
-        volID = seg->getVolumeID();
+    } else {
+        for (const auto& job : jobs) {
+            if (not job.seg->hasVolumeID()) {
+                continue;
+            }
+            if (not volID.empty() and job.seg->getVolumeID() != volID) {
+                vc::Logger()->error(
+                    "Segmentations are associated with different volumes. "
+                    "Select one with --volume.");
+                return EXIT_FAILURE;
+            }
+            volID = job.seg->getVolumeID();
+        }
     }
 
     try {
@@ -234,8 +372,102 @@ int main(int argc, char* argv[])
     std::cout << "Size: " << vc::BytesToMemorySizeString(cacheBytes);
     std::cout << std::endl;
 
-    // Setup
+    ///// Run the jobs /////
+    // Jobs run on their own threads and share the global thread pool
+    auto numJobs = parsed["seg-jobs"].as<std::size_t>();
+    if (numJobs == 0) {
+        numJobs = jobs.size();
+    }
+
+    ///// Estimate the jobs /////
+    if (parsed.count("estimate") > 0) {
+        auto estimates = nlohmann::json::array();
+        std::vector<std::uint64_t> peaks;
+        for (const auto& job : jobs) {
+            try {
+                auto estimate = EstimateJob(
+                    parsed, alg, volume, cacheBytes, vpkg.materialThickness(),
+                    job);
+                vc::Logger()->info(
+                    "Resource estimate ({}):\n{}", job.seg->id(),
+                    estimate.summary());
+                estimates.push_back(estimate.metadata());
+                peaks.push_back(estimate.peakBytes);
+            } catch (const std::exception& e) {
+                vc::Logger()->error(
+                    "Failed to estimate {}: {}", job.seg->id(), e.what());
+                return EXIT_FAILURE;
+            }
+        }
+
+        // Concurrent jobs share the slice cache, so the sum of their peaks
+        // is an upper bound
+        std::sort(peaks.rbegin(), peaks.rend());
+        std::uint64_t total{0};
+        for (std::size_t i = 0; i < std::min(numJobs, peaks.size()); i++) {
+            total += peaks[i];
+        }
+        if (peaks.size() > 1) {
+            vc::Logger()->info(
+                "Peak memory of {} concurrent segmentations: at most {}",
+                std::min(numJobs, peaks.size()),
+                vc::BytesToMemorySizeString(total, "MB"));
+        }
+
+        if (parsed.count("estimate-output") > 0) {
+            fs::path path = parsed["estimate-output"].as<std::string>();
+            std::ofstream file(path);
+            nlohmann::json out{{"jobs", estimates}, {"peakBytes", total}};
+            file << out.dump(4) << "\n";
+            if (not file) {
+                vc::Logger()->error("Failed to write: {}", path.string());
+                return EXIT_FAILURE;
+            }
+        }
+        return EXIT_SUCCESS;
+    }
+
+    std::vector<int> results(jobs.size(), EXIT_FAILURE);
+    std::atomic<std::size_t> next{0};
+    auto worker = [&]() {
+        for (auto i = next++; i < jobs.size(); i = next++) {
+            try {
+                results[i] = RunJob(
+                    parsed, alg, volume, vpkg.materialThickness(), jobs[i]);
+            } catch (const std::exception& e) {
+                vc::Logger()->error(
+                    "Failed to segment {}: {}", jobs[i].seg->id(), e.what());
+            }
+        }
+    };
+    std::vector<std::thread> workers;
+    for (std::size_t t = 1; t < std::min(numJobs, jobs.size()); ++t) {
+        workers.emplace_back(worker);
+    }
+    worker();
+    for (auto& w : workers) {
+        w.join();
+    }
+    vc::Logger()->info("Final cache stats: {}", volume->cacheStats().summary());
+
+    auto failed = std::count(results.begin(), results.end(), EXIT_FAILURE);
+    if (jobs.size() > 1 and failed > 0) {
+        vc::Logger()->error(
+            "{} of {} segmentations failed", failed, jobs.size());
+    }
+    return failed > 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+// Segment one seed chain
+static auto RunJob(
+    const po::variables_map& parsed,
+    Algorithm alg,
+    const vc::Volume::Pointer& volume,
+    double materialThickness,
+    const SegmentJob& job) -> int
+{
     // Load the segmentation
+    const auto& seg = job.seg;
     auto masterCloud = seg->getPointSet();
 
     // Get some info about the cloud, including chain length and z-index's
@@ -245,34 +477,11 @@ int main(int argc, char* argv[])
     auto maxIndex = static_cast<size_t>(floor(masterCloud.max()[2]));
 
     // Cache arguments
-    // If no start index is given, our starting path is all of the points
-    // already on the largest slice index
-    size_t startIndex{0};
-    if (parsed.count("start-index") == 0) {
-        startIndex = maxIndex;
-        std::cout
-            << "No starting index given. Defaulting to max Z in point set: "
-            << startIndex << std::endl;
-    } else {
-        startIndex = parsed["start-index"].as<size_t>();
-    }
+    auto [startIndex, endIndex] = JobRange(parsed, volume, maxIndex);
 
     // Step size
     auto step = parsed["step-size"].as<double>();
 
-    // Figure out endIndex using either start-index or stride
-    size_t endIndex{0};
-    if (parsed.count("end-index") > 0) {
-        endIndex = parsed["end-index"].as<size_t>();
-    } else if (parsed.count("stride") > 0) {
-        endIndex = startIndex + parsed["stride"].as<size_t>();
-        endIndex = std::min(endIndex, size_t(volume->numSlices() - 1));
-    } else {
-        endIndex = size_t(volume->numSlices() - 1);
-        std::cout << "No end index given. Defaulting to max Z in volume: "
-                  << endIndex << std::endl;
-    }
-
     // Sanity check for whether we actually need to run the algorithm
     if (startIndex >= endIndex) {
         std::cerr << "[info]: startIndex(" << startIndex << ") >= endIndex("
@@ -280,7 +489,7 @@ int main(int argc, char* argv[])
                   << "), do not need to segment. Consider using --stride "
                      "option instead of manually specifying endIndex"
                   << std::endl;
-        std::exit(1);
+        return EXIT_FAILURE;
     }
 
     // Prepare our clouds
@@ -315,17 +524,18 @@ int main(int argc, char* argv[])
         std::cerr << "       Consider using a lower starting index value."
                   << std::endl
                   << std::endl;
-        std::exit(1);
+        return EXIT_FAILURE;
     }
 
     // Run the algorithms
     vc::OrderedPointSet<cv::Vec3d> mutableCloud;
+    std::unique_ptr<vc::Segmentation::PointSetWriter> checkpoint;
     if (alg == Algorithm::LRPS) {
         // Run segmentation using path as our starting points
         vs::LocalResliceSegmentation segmenter;
         segmenter.setChain(segPath);
         segmenter.setVolume(volume);
-        segmenter.setMaterialThickness(vpkg.materialThickness());
+        segmenter.setMaterialThickness(materialThickness);
         segmenter.setTargetZIndex(endIndex);
         segmenter.setStepSize(step);
         segmenter.setOptimizationIterations(parsed["num-iters"].as<int>());
@@ -337,9 +547,59 @@ int main(int argc, char* argv[])
         segmenter.setDelta(parsed["delta"].as<double>());
         segmenter.setDistanceWeightFactor(parsed["distance-weight"].as<int>());
         segmenter.setConsiderPrevious(parsed["consider-previous"].as<bool>());
-        segmenter.setVisualize(parsed.count("visualize") > 0);
-        segmenter.setDumpVis(parsed.count("dump-vis") > 0);
-        vc::ReportProgress(segmenter, "Segmenting");
+        segmenter.setEnergyFitRadius(
+            parsed["energy-fit-radius"].as<std::size_t>());
+        segmenter.setNumThreads(parsed["lrps-threads"].as<std::size_t>());
+        segmenter.setVisualize(job.interactive and parsed.count("visualize"));
+        segmenter.setDumpVis(job.interactive and parsed.count("dump-vis"));
+        ShowProgress(segmenter, job);
+
+        // Checkpoint each new row so that a crash does not lose progress
+        checkpoint = seg->appendPointSet(chainLength, immutableCloud.height());
+        segmenter.chainUpdated.connect([&checkpoint](auto row) {
+            try {
+                checkpoint->writeRow(std::move(row));
+            } catch (const std::exception& e) {
+                vc::Logger()->warn("Failed to checkpoint row: {}", e.what());
+            }
+        });
+
+        mutableCloud = segmenter.compute();
+    }
+
+    else if (alg == Algorithm::OFS) {
+        vs::OpticalFlowSegmentation segmenter;
+        segmenter.setChain(segPath);
+        segmenter.setVolume(volume);
+        segmenter.setMaterialThickness(materialThickness);
+        segmenter.setTargetZIndex(endIndex);
+        segmenter.setStepSize(step);
+        segmenter.setOutsideThreshold(
+            static_cast<std::uint8_t>(parsed["ofs-outside-thresh"].as<int>()));
+        segmenter.setOFThreshold(
+            static_cast<std::uint8_t>(parsed["ofs-flow-thresh"].as<int>()));
+        segmenter.setOFDispThreshold(
+            parsed["ofs-disp-thresh"].as<std::uint32_t>());
+        segmenter.setSmoothBrightnessThreshold(
+            static_cast<std::uint8_t>(parsed["ofs-smooth-thresh"].as<int>()));
+        auto ofsThreads = parsed["ofs-threads"].as<std::size_t>();
+        if (ofsThreads > 0) {
+            segmenter.setMaxThreads(static_cast<std::uint32_t>(ofsThreads));
+        }
+        segmenter.setUseGPU(parsed.count("gpu") > 0);
+        segmenter.setVisualize(job.interactive and parsed.count("visualize"));
+        segmenter.setDumpVis(job.interactive and parsed.count("dump-vis"));
+        ShowProgress(segmenter, job);
+
+        checkpoint = seg->appendPointSet(chainLength, immutableCloud.height());
+        segmenter.chainUpdated.connect([&checkpoint](auto row) {
+            try {
+                checkpoint->writeRow(std::move(row));
+            } catch (const std::exception& e) {
+                vc::Logger()->warn("Failed to checkpoint row: {}", e.what());
+            }
+        });
+
         mutableCloud = segmenter.compute();
     }
 
@@ -361,48 +621,181 @@ int main(int argc, char* argv[])
             segmenter.setMaxRadius(r);
         }
         segmenter.setMeasureVertical(parsed.count("measure-vert") > 0);
-        segmenter.setDumpVis(parsed.count("dump-vis") > 0);
+        segmenter.setNumThreads(parsed["tff-threads"].as<std::size_t>());
+        segmenter.setDumpVis(job.interactive and parsed.count("dump-vis"));
 
+        // Save intermediate pointsets if we're doing that
+        auto pointsetPath = job.prefix + "pointset.vcps";
+        int saveInterval{-1};
+        int iteration{0};
         if (parsed.count("save-interval") > 0) {
-            SaveInterval = parsed["save-interval"].as<int>();
-            if (SaveInterval > 0) {
-                segmenter.pointsetUpdated.connect(WriteIntermediatePointset);
-            }
+            saveInterval = parsed["save-interval"].as<int>();
+        }
+        if (saveInterval > 0) {
+            segmenter.pointsetUpdated.connect([&](const PointSet& ps) {
+                if (++iteration % saveInterval == 0) {
+                    WritePointset(pointsetPath, ps);
+                }
+            });
         }
         if (parsed.count("save-mask") > 0) {
-            segmenter.maskUpdated.connect(WriteMaskPointset);
+            auto maskPath = job.prefix + "mask_pointset.vcps";
+            segmenter.maskUpdated.connect([maskPath](const VoxelMask& mask) {
+                WriteMaskPointset(maskPath, mask);
+            });
         }
-        vc::ReportProgress(segmenter, "Segmenting");
+        ShowProgress(segmenter, job);
         auto skeleton = segmenter.compute();
 
         // Regular pointsets aren't fully supported in the main logic yet
         // Write our point set and exit early
-        WritePointset(skeleton);
-        return 0;
+        WritePointset(pointsetPath, skeleton);
+        return EXIT_SUCCESS;
     }
 
     // Update the master cloud with the points we saved and concat the new
     // points into the space
     immutableCloud.append(mutableCloud);
 
-    // Save point cloud and mesh
-    seg->setPointSet(immutableCloud);
+    // Save point cloud and mesh. The checkpointed rows already form the
+    // final point set unless a write failed or the algorithm stopped before
+    // emitting every row.
+    bool saved{false};
+    if (checkpoint) {
+        try {
+            saved = checkpoint->flush() == immutableCloud.height();
+        } catch (const std::exception& e) {
+            vc::Logger()->warn("Failed to checkpoint point set: {}", e.what());
+        }
+        checkpoint.reset();
+    }
+    if (not saved) {
+        seg->setPointSet(immutableCloud);
+    }
+
+    return EXIT_SUCCESS;
 }
 
-static void WritePointset(const PointSet& pointset)
+// Get the start and end slice indices of a job
+static auto JobRange(
+    const po::variables_map& parsed,
+    const vc::Volume::Pointer& volume,
+    std::size_t maxIndex) -> std::pair<std::size_t, std::size_t>
 {
-    vc::PointSetIO<cv::Vec3d>::WritePointSet("pointset.vcps", pointset);
+    // If no start index is given, our starting path is all of the points
+    // already on the largest slice index
+    size_t startIndex{0};
+    if (parsed.count("start-index") == 0) {
+        startIndex = maxIndex;
+        std::cout
+            << "No starting index given. Defaulting to max Z in point set: "
+            << startIndex << std::endl;
+    } else {
+        startIndex = parsed["start-index"].as<size_t>();
+    }
+
+    // Figure out endIndex using either start-index or stride
+    size_t endIndex{0};
+    if (parsed.count("end-index") > 0) {
+        endIndex = parsed["end-index"].as<size_t>();
+    } else if (parsed.count("stride") > 0) {
+        endIndex = startIndex + parsed["stride"].as<size_t>();
+        endIndex = std::min(endIndex, size_t(volume->numSlices() - 1));
+    } else {
+        endIndex = size_t(volume->numSlices() - 1);
+        std::cout << "No end index given. Defaulting to max Z in volume: "
+                  << endIndex << std::endl;
+    }
+    return {startIndex, endIndex};
 }
 
-static void WriteIntermediatePointset(const PointSet& pointset)
+// Predict the peak memory and volume reads of a job without running it
+static auto EstimateJob(
+    const po::variables_map& parsed,
+    Algorithm alg,
+    const vc::Volume::Pointer& volume,
+    std::size_t cacheBytes,
+    double materialThickness,
+    const SegmentJob& job) -> vc::ResourceEstimate
 {
-    // Save intermediate pointsets if we're doing that
-    if (++CurrentIteration % SaveInterval == 0) {
-        WritePointset(pointset);
+    // Measure the seed chain. Mapped to avoid reading whole files.
+    auto view = job.seg->getPointSetView();
+    if (view.empty()) {
+        throw std::runtime_error("Segmentation has no points");
+    }
+    auto chainLength = view.width();
+    cv::Vec3d lo = cv::Vec3d::all(std::numeric_limits<double>::max());
+    cv::Vec3d hi = cv::Vec3d::all(std::numeric_limits<double>::lowest());
+    for (const auto& p : view) {
+        if (p[2] == -1) {
+            continue;
+        }
+        for (int i = 0; i < 3; i++) {
+            lo[i] = std::min(lo[i], p[i]);
+            hi[i] = std::max(hi[i], p[i]);
+        }
+    }
+    auto maxIndex = static_cast<std::size_t>(std::floor(std::max(hi[2], 0.)));
+    auto [startIndex, endIndex] = JobRange(parsed, volume, maxIndex);
+    if (startIndex >= endIndex) {
+        throw std::runtime_error("Start index is not less than end index");
     }
+    auto step = parsed["step-size"].as<double>();
+    auto rows = static_cast<std::size_t>(
+        std::ceil(static_cast<double>(endIndex - startIndex) / step));
+
+    vc::ResourceEstimator estimator;
+    estimator.setVolume(volume);
+    estimator.setCacheBytes(cacheBytes);
+
+    // The input and output point sets are kept until the job finishes
+    auto pointBytes = sizeof(cv::Vec3d);
+    estimator.addStage(
+        "Point set", 2 * (view.size() + chainLength * rows) * pointBytes);
+
+    // Every algorithm reads the slices between the start and end index
+    auto sliceBytes = static_cast<std::uint64_t>(volume->sliceWidth()) *
+                      static_cast<std::uint64_t>(volume->sliceHeight());
+    cv::Vec3d first{0, 0, static_cast<double>(startIndex)};
+    cv::Vec3d last{
+        static_cast<double>(volume->sliceWidth()),
+        static_cast<double>(volume->sliceHeight()),
+        static_cast<double>(endIndex)};
+    if (alg == Algorithm::LRPS) {
+        // Each particle is resliced within a window around the chain
+        auto r = static_cast<double>(parsed["reslice-size"].as<int>());
+        auto window = static_cast<std::uint64_t>(2 * r + 1);
+        estimator.addStage(
+            "LRPS", 0, chainLength * window * window * sizeof(std::uint16_t),
+            true);
+        first = {lo[0] - r, lo[1] - r, first[2] - r};
+        last = {hi[0] + r, hi[1] + r, last[2] + r};
+    } else if (alg == Algorithm::OFS) {
+        // Two 8-bit slices and their two-channel float flow field
+        estimator.addStage(
+            "OFS", 0, sliceBytes * (2 + 2 * sizeof(float)), true);
+    } else if (alg == Algorithm::TFF) {
+        // The voxel mask grows by about one sheet thickness per chain point
+        // and slice. Each slice is thresholded and distance transformed.
+        auto thickness = static_cast<std::uint64_t>(
+            std::ceil(materialThickness / volume->voxelSize()));
+        estimator.addStage(
+            "TFF", chainLength * thickness * rows * sizeof(cv::Vec3i),
+            sliceBytes * (1 + sizeof(float)), true);
+    }
+    estimator.setRegion(first, last);
+
+    auto est = estimator.compute();
+    est.name = job.seg->id();
+    return est;
+}
+
+static void WritePointset(const fs::path& path, const PointSet& pointset)
+{
+    vc::PointSetIO<cv::Vec3d>::WritePointSet(path, pointset);
 }
 
-static void WriteMaskPointset(const VoxelMask& pointset)
+static void WriteMaskPointset(const fs::path& path, const VoxelMask& pointset)
 {
-    vc::PointSetIO<cv::Vec3i>::WritePointSet("mask_pointset.vcps", pointset);
+    vc::PointSetIO<cv::Vec3i>::WritePointSet(path, pointset);
 }
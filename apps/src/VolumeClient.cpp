@@ -1,107 +1,366 @@
 #include <cstring>
 #include <iostream>
+#include <memory>
 
-#include <QDataStream>
-#include <QTcpServer>
+#include <QPointer>
 
-#include "vc/app_support/GetMemorySize.hpp"
 #include "vc/apps/server/VolumeClient.hpp"
+#include "vc/apps/server/VolumeCodec.hpp"
 #include "vc/apps/server/VolumeProtocol.hpp"
-#include "vc/core/neighborhood/CuboidGenerator.hpp"
-#include "vc/core/types/Volume.hpp"
-#include "vc/core/types/VolumePkg.hpp"
 #include "vc/core/util/Logging.hpp"
 
 namespace vc = volcart;
 
+// Write a connection's buffered data
+static void FlushSocket(QIODevice* socket)
+{
+    if (auto* tcp = qobject_cast<QTcpSocket*>(socket)) {
+        tcp->flush();
+    } else if (auto* local = qobject_cast<QLocalSocket*>(socket)) {
+        local->flush();
+    }
+}
+
+// Get a handle which releases a response in the server's shared memory ring
+// once it has been destroyed
+static auto ReleaseHandle(QIODevice* socket, vc::protocol::SharedMemoryRef ref)
+    -> std::shared_ptr<void>
+{
+    auto release = [s = QPointer<QIODevice>{socket}, ref](void*) {
+        if (s.isNull() or not s->isOpen()) {
+            return;
+        }
+        vc::protocol::RequestHdr requestHdr;
+        requestHdr.version = vc::protocol::V2;
+        requestHdr.flags = vc::protocol::ReleaseShared;
+        requestHdr.numRequests = 1;
+        QByteArray packet;
+        packet.append(
+            reinterpret_cast<const char*>(&requestHdr), sizeof(requestHdr));
+        packet.append(reinterpret_cast<const char*>(&ref), sizeof(ref));
+        s->write(packet);
+        FlushSocket(s.data());
+    };
+    return std::shared_ptr<void>(nullptr, release);
+}
+
+// Get callbacks which collect the responses to `n` requests and pass them
+// to `callback`, in request order, once every response has arrived
+static auto CollectResponses(
+    std::size_t n, vc::VolumeClient::BatchCallback callback)
+    -> std::vector<vc::VolumeClient::Callback>
+{
+    using Response = vc::VolumeClient::Response;
+    struct State {
+        std::vector<Response> responses;
+        std::size_t remaining;
+        vc::VolumeClient::BatchCallback callback;
+    };
+    auto state = std::make_shared<State>(
+        State{std::vector<Response>(n), n, std::move(callback)});
+    std::vector<vc::VolumeClient::Callback> callbacks;
+    callbacks.reserve(n);
+    for (std::size_t i = 0; i < n; i++) {
+        callbacks.emplace_back([state, i](const Response& response) {
+            state->responses[i] = response;
+            if (--state->remaining == 0) {
+                state->callback(state->responses);
+            }
+        });
+    }
+    return callbacks;
+}
+
 vc::VolumeClient::VolumeClient(const QString& ip, quint16 port, QObject* parent)
     : QObject{parent}
 {
-    client_ = new QTcpSocket(this);
+    auto* socket = new QTcpSocket(this);
+    client_ = socket;
+    connect(
+        socket, &QAbstractSocket::disconnected, this,
+        &VolumeClient::connectionClosed);
     connect(
-        client_, &QAbstractSocket::disconnected, client_,
-        &QObject::deleteLater);
+        socket, &QAbstractSocket::disconnected, socket, &QObject::deleteLater);
     connect(
-        client_, &QAbstractSocket::connected, this,
+        socket, &QAbstractSocket::connected, this,
         &VolumeClient::newConnection);
     connect(
-        client_, &QAbstractSocket::errorOccurred, this,
+        socket, &QIODevice::readyRead, this, &VolumeClient::readResponses);
+    connect(
+        socket, &QAbstractSocket::errorOccurred, this,
         &VolumeClient::connectionError);
-    client_->connectToHost(ip, port);
+    socket->connectToHost(ip, port);
+}
+
+vc::VolumeClient::VolumeClient(const QString& name, QObject* parent)
+    : QObject{parent}
+{
+    // Receive responses in place if the server has a shared memory ring
+    auto key =
+        QString::fromStdString(protocol::SharedMemoryKey(name.toStdString()));
+    ring_ = std::make_unique<QSharedMemory>(key);
+    if (not ring_->attach(QSharedMemory::ReadOnly)) {
+        ring_.reset();
+    }
+
+    auto* socket = new QLocalSocket(this);
+    client_ = socket;
+    connect(
+        socket, &QLocalSocket::disconnected, this,
+        &VolumeClient::connectionClosed);
+    connect(
+        socket, &QLocalSocket::disconnected, socket, &QObject::deleteLater);
+    connect(
+        socket, &QLocalSocket::connected, this, &VolumeClient::newConnection);
+    connect(
+        socket, &QIODevice::readyRead, this, &VolumeClient::readResponses);
+    connect(
+        socket, &QLocalSocket::errorOccurred, this,
+        &VolumeClient::localConnectionError);
+    socket->connectToServer(name);
+}
+
+auto vc::VolumeClient::request(
+    const protocol::RequestArgs& args, Callback callback) -> uint32_t
+{
+    return send_(
+        reinterpret_cast<const char*>(&args), sizeof(args), 0,
+        {std::move(callback)});
+}
+
+auto vc::VolumeClient::request(
+    const std::vector<protocol::RequestArgs>& args, BatchCallback callback)
+    -> uint32_t
+{
+    if (args.empty()) {
+        callback({});
+        return nextRequestId_;
+    }
+    return send_(
+        reinterpret_cast<const char*>(args.data()),
+        sizeof(protocol::RequestArgs) * args.size(), 0,
+        CollectResponses(args.size(), std::move(callback)));
+}
+
+auto vc::VolumeClient::reslice(
+    const protocol::ResliceArgs& args, Callback callback) -> uint32_t
+{
+    return send_(
+        reinterpret_cast<const char*>(&args), sizeof(args),
+        protocol::ResliceRequests, {std::move(callback)});
+}
+
+auto vc::VolumeClient::reslice(
+    const std::vector<protocol::ResliceArgs>& args, BatchCallback callback)
+    -> uint32_t
+{
+    if (args.empty()) {
+        callback({});
+        return nextRequestId_;
+    }
+    return send_(
+        reinterpret_cast<const char*>(args.data()),
+        sizeof(protocol::ResliceArgs) * args.size(),
+        protocol::ResliceRequests,
+        CollectResponses(args.size(), std::move(callback)));
+}
+
+void vc::VolumeClient::setPriority(uint8_t priority) { priority_ = priority; }
+
+auto vc::VolumeClient::pending() const -> std::size_t
+{
+    return pending_.size();
+}
+
+void vc::VolumeClient::close()
+{
+    connected_ = false;
+    failPending_();
+    // Closing the connection releases every response in the shared memory
+    // ring
+    if (auto* tcp = qobject_cast<QTcpSocket*>(client_)) {
+        tcp->disconnectFromHost();
+    } else if (auto* local = qobject_cast<QLocalSocket*>(client_)) {
+        local->disconnectFromServer();
+    }
+}
+
+auto vc::VolumeClient::send_(
+    const char* args,
+    std::size_t size,
+    uint8_t flags,
+    std::vector<Callback> callbacks) -> uint32_t
+{
+    protocol::RequestHdr requestHdr;
+    requestHdr.version = protocol::V2;
+    requestHdr.codecs = protocol::CodecFlag(protocol::Zlib) |
+                        protocol::CodecFlag(protocol::ZlibShuffle);
+    if (ring_) {
+        requestHdr.codecs |= protocol::CodecFlag(protocol::SharedMemory);
+    }
+    requestHdr.flags = static_cast<uint8_t>(
+        protocol::KeepAlive | protocol::Chunked | flags);
+    requestHdr.priority = priority_;
+    requestHdr.numRequests = static_cast<uint32_t>(callbacks.size());
+
+    QByteArray packet;
+    packet.append(
+        reinterpret_cast<const char*>(&requestHdr), sizeof(requestHdr));
+    packet.append(args, static_cast<qsizetype>(size));
+
+    // The server numbers the requests of KeepAlive packets consecutively
+    auto firstId = nextRequestId_;
+    for (auto& callback : callbacks) {
+        pending_.emplace(nextRequestId_++, std::move(callback));
+    }
+    if (connected_) {
+        client_->write(packet);
+        FlushSocket(client_);
+    } else {
+        unsent_.append(packet);
+    }
+    return firstId;
 }
 
 void vc::VolumeClient::newConnection()
 {
-    // CarbonSquares
-    // 20180509123106
-    // 20180509123119
     vc::Logger()->info("Connection established.");
-    protocol::RequestHdr requestHdr;
-    requestHdr.numRequests = 2;
-    client_->write(
-        reinterpret_cast<char*>(&requestHdr), sizeof(protocol::RequestHdr));
-    client_->flush();
-    for (uint32_t i = 0; i < requestHdr.numRequests; i++) {
-        // Neighborhood should be 27 with these settings
-        protocol::RequestArgs requestArgs;
-        std::memset(&requestArgs, 0, sizeof(requestArgs));
-        std::strncpy(requestArgs.volpkg, "CarbonSquares", protocol::VOLPKG_SZ);
-        std::strncpy(requestArgs.volume, "20180509123106", protocol::VOLUME_SZ);
-        requestArgs.centerX = 100.0f;
-        requestArgs.centerY = 50.0f;
-        requestArgs.centerZ = 100.0f;
-        requestArgs.basis0X = 1.0f;
-        requestArgs.basis1Y = 1.0f;
-        requestArgs.basis2Z = 1.0f;
-        requestArgs.samplingRX = 40.0f;
-        requestArgs.samplingRY = 20.0f;
-        requestArgs.samplingRZ = 40.0f;
-        requestArgs.samplingInterval = 1.0f / (i + 1);
-        client_->write(
-            reinterpret_cast<char*>(&requestArgs),
-            sizeof(protocol::RequestArgs));
-        client_->flush();
+    connected_ = true;
+    if (not unsent_.isEmpty()) {
+        client_->write(unsent_);
+        FlushSocket(client_);
+        unsent_.clear();
     }
-    // Read response from server
-    auto* responseArgs = new protocol::ResponseArgs[requestHdr.numRequests];
-    QDataStream* dataStream = new QDataStream(client_);
-    while (client_->waitForReadyRead()) {
-        dataStream->startTransaction();
-        bool abort = false;
-        for (uint32_t i = 0; i < requestHdr.numRequests; i++) {
-            int bytesArgs = dataStream->readRawData(
-                reinterpret_cast<char*>(&responseArgs[i]),
-                sizeof(protocol::ResponseArgs));
-            if (bytesArgs != sizeof(protocol::ResponseArgs)) {
-                dataStream->rollbackTransaction();
-                abort = true;
-                break;
+    emit connected();
+}
+
+void vc::VolumeClient::readResponses()
+{
+    // V2 responses may arrive in any order
+    protocol::ResponseArgsV2 args;
+    while (connected_ and
+           client_->bytesAvailable() >= static_cast<qint64>(sizeof(args))) {
+        client_->peek(reinterpret_cast<char*>(&args), sizeof(args));
+        if (client_->bytesAvailable() <
+            static_cast<qint64>(sizeof(args) + args.size)) {
+            return;
+        }
+        client_->read(reinterpret_cast<char*>(&args), sizeof(args));
+        auto data = client_->read(args.size);
+
+        auto it = pending_.find(args.requestId);
+        if (it == pending_.end()) {
+            vc::Logger()->error(
+                "Response #{}: Unknown request ID", args.requestId);
+            continue;
+        }
+        auto response = decode_(args, data);
+
+        // Combine the chunks of a chunked response
+        auto partial = partial_.find(args.requestId);
+        if ((args.flags & protocol::MoreChunks) != 0 or
+            partial != partial_.end()) {
+            if (partial == partial_.end()) {
+                partial = partial_.emplace(args.requestId, Response{}).first;
+                partial->second.args = args;
+                partial->second.args.extentZ = 0;
+                partial->second.args.size = 0;
+                partial->second.args.rawSize = 0;
             }
-            vc::Logger()->info("Skipping {} bytes.", responseArgs[i].size);
-            int bytesSkipped = dataStream->skipRawData(responseArgs[i].size);
-            if (bytesSkipped != responseArgs[i].size) {
-                dataStream->rollbackTransaction();
-                abort = true;
-                break;
+            auto& combined = partial->second;
+            combined.voxels.append(response.voxels);
+            combined.args.extentZ += args.extentZ;
+            combined.args.size += args.size;
+            combined.args.rawSize += args.rawSize;
+            if ((args.flags & protocol::MoreChunks) != 0) {
+                continue;
             }
+
+            // An empty last chunk means that the response failed
+            response = std::move(combined);
+            response.args.flags = 0;
+            if (args.extentX == 0) {
+                response = Response{};
+                response.args = args;
+            }
+            partial_.erase(partial);
         }
-        if (!abort && dataStream->commitTransaction()) {
-            break;
+
+        // The callback may make new requests
+        auto callback = std::move(it->second);
+        pending_.erase(it);
+        callback(response);
+    }
+}
+
+auto vc::VolumeClient::decode_(
+    const protocol::ResponseArgsV2& args, const QByteArray& data)
+    -> Response
+{
+    Response response{args, {}, nullptr};
+
+    // Voxels in the shared memory ring are read in place
+    if (args.codec == protocol::SharedMemory) {
+        protocol::SharedMemoryRef ref{};
+        if (ring_ and data.size() == sizeof(ref)) {
+            std::memcpy(&ref, data.data(), sizeof(ref));
+        }
+        if (not ring_ or data.size() != sizeof(ref) or
+            ref.offset + args.rawSize >
+                static_cast<std::size_t>(ring_->size())) {
+            vc::Logger()->error(
+                "Response #{}: Invalid shared memory reference",
+                args.requestId);
+            return response;
         }
+        const auto* voxels =
+            static_cast<const char*>(ring_->constData()) + ref.offset;
+        response.voxels = QByteArray::fromRawData(
+            voxels, static_cast<qsizetype>(args.rawSize));
+        response.release = ReleaseHandle(client_, ref);
+        return response;
     }
-    for (uint32_t i = 0; i < requestHdr.numRequests; i++) {
-        vc::Logger()->info("=== Response: #{} ===", i);
-        vc::Logger()->info("Volume Package: {}", responseArgs[i].volpkg);
-        vc::Logger()->info("Volume: {}", responseArgs[i].volume);
+
+    try {
+        response.voxels = protocol::Decode(args.codec, data, args.rawSize);
+    } catch (const std::exception& e) {
+        vc::Logger()->error("Response #{}: {}", args.requestId, e.what());
     }
-    delete dataStream;
-    delete[] responseArgs;
-    client_->disconnectFromHost();
+    return response;
+}
+
+void vc::VolumeClient::failPending_()
+{
+    partial_.clear();
+    // Callbacks may make new requests, which fail in turn
+    while (not pending_.empty()) {
+        auto it = pending_.begin();
+        Response response;
+        response.args.requestId = it->first;
+        auto callback = std::move(it->second);
+        pending_.erase(it);
+        callback(response);
+    }
+}
+
+void vc::VolumeClient::connectionClosed()
+{
+    connected_ = false;
+    failPending_();
     emit finished();
 }
 
 void vc::VolumeClient::connectionError(QAbstractSocket::SocketError socketError)
 {
     vc::Logger()->error("{}", client_->errorString().toStdString());
+    failPending_();
+    emit finished();
+}
+
+void vc::VolumeClient::localConnectionError(
+    QLocalSocket::LocalSocketError socketError)
+{
+    vc::Logger()->error("{}", client_->errorString().toStdString());
+    failPending_();
     emit finished();
 }
@@ -1,11 +1,15 @@
+#include <algorithm>
 #include <cstring>
 #include <iostream>
+#include <memory>
+#include <vector>
 
 #include <boost/program_options.hpp>
 
 #include <QCoreApplication>
 
 #include "vc/apps/server/VolumeClient.hpp"
+#include "vc/apps/server/VolumeProtocol.hpp"
 #include "vc/core/filesystem.hpp"
 #include "vc/core/util/Logging.hpp"
 
@@ -19,8 +23,14 @@ int main(int argc, char* argv[])
     po::options_description required("General Options");
     required.add_options()
         ("help,h", "Show this message")
-        ("server,s", po::value<std::string>()->required(), "IP address of the Volume Server")
-        ("port,p", po::value<quint16>()->required(), "Port of the Volume Server");
+        ("server,s", po::value<std::string>(), "IP address of the Volume Server")
+        ("port,p", po::value<quint16>(), "Port of the Volume Server")
+        ("local", po::value<std::string>(), "Connect to the local socket of a Volume Server on this host instead of --server and --port")
+        ("requests,n", po::value<uint32_t>()->default_value(2), "Number of sample requests. Requests are pipelined on the connection")
+        ("batch", "Send the requests in a single request packet")
+        ("reslice", "Request 2D reslice images instead of sub-volumes")
+        ("level", po::value<uint32_t>()->default_value(0), "Resolution level of reslice requests")
+        ("priority", po::value<uint32_t>()->default_value(0), "Scheduling priority of the requests. Each step doubles their share of the server's workers");
 
     po::options_description all("Usage");
     all.add(required);
@@ -31,7 +41,7 @@ int main(int argc, char* argv[])
     po::store(po::command_line_parser(argc, argv).options(all).run(), parsed);
 
     // Show the help message
-    if (parsed.count("help") || argc < 5) {
+    if (parsed.count("help") || argc < 3) {
         std::cout << all << std::endl;
         return EXIT_SUCCESS;
     }
@@ -45,14 +55,120 @@ int main(int argc, char* argv[])
     }
 
     // Get the parsed options
-    std::string server_ip = parsed["server"].as<std::string>();
-    quint16 server_port = parsed["port"].as<quint16>();
+    auto local = parsed.count("local") > 0;
+    if (not local and
+        (parsed.count("server") == 0 or parsed.count("port") == 0)) {
+        vc::Logger()->error("--local or --server and --port is required");
+        return EXIT_FAILURE;
+    }
+
+    auto numRequests = parsed["requests"].as<uint32_t>();
+    if (numRequests == 0) {
+        return EXIT_SUCCESS;
+    }
 
     // Launch the Qt CLI application
     QCoreApplication application(argc, argv);
-    vc::VolumeClient client_(QString::fromStdString(server_ip), server_port);
+    std::unique_ptr<vc::VolumeClient> client_;
+    if (local) {
+        client_ = std::make_unique<vc::VolumeClient>(
+            QString::fromStdString(parsed["local"].as<std::string>()));
+    } else {
+        std::string server_ip = parsed["server"].as<std::string>();
+        quint16 server_port = parsed["port"].as<quint16>();
+        client_ = std::make_unique<vc::VolumeClient>(
+            QString::fromStdString(server_ip), server_port);
+    }
     QObject::connect(
-        &client_, &vc::VolumeClient::finished, &application,
+        client_.get(), &vc::VolumeClient::finished, &application,
         &QCoreApplication::quit);
+
+    client_->setPriority(static_cast<uint8_t>(std::min<uint32_t>(
+        parsed["priority"].as<uint32_t>(), vc::protocol::MAX_PRIORITY)));
+
+    // CarbonSquares
+    // 20180509123106
+    // 20180509123119
+    std::vector<vc::protocol::RequestArgs> requests;
+    std::vector<vc::protocol::ResliceArgs> reslices;
+    auto reslice = parsed.count("reslice") > 0;
+    for (uint32_t i = 0; reslice and i < numRequests; i++) {
+        // Oblique planes through the same center
+        vc::protocol::ResliceArgs resliceArgs;
+        std::memset(&resliceArgs, 0, sizeof(resliceArgs));
+        std::strncpy(
+            resliceArgs.volpkg, "CarbonSquares", vc::protocol::VOLPKG_SZ);
+        std::strncpy(
+            resliceArgs.volume, "20180509123106", vc::protocol::VOLUME_SZ);
+        resliceArgs.centerX = 100.0f;
+        resliceArgs.centerY = 50.0f;
+        resliceArgs.centerZ = 100.0f;
+        resliceArgs.xvecX = 1.0f;
+        resliceArgs.xvecY = static_cast<float>(i);
+        resliceArgs.yvecZ = 1.0f;
+        resliceArgs.width = 80;
+        resliceArgs.height = 80;
+        resliceArgs.level = parsed["level"].as<uint32_t>();
+        reslices.push_back(resliceArgs);
+    }
+    for (uint32_t i = 0; not reslice and i < numRequests; i++) {
+        // Neighborhood should be 27 with these settings
+        vc::protocol::RequestArgs requestArgs;
+        std::memset(&requestArgs, 0, sizeof(requestArgs));
+        std::strncpy(
+            requestArgs.volpkg, "CarbonSquares", vc::protocol::VOLPKG_SZ);
+        std::strncpy(
+            requestArgs.volume, "20180509123106", vc::protocol::VOLUME_SZ);
+        requestArgs.centerX = 100.0f;
+        requestArgs.centerY = 50.0f;
+        requestArgs.centerZ = 100.0f;
+        requestArgs.basis0X = 1.0f;
+        requestArgs.basis1Y = 1.0f;
+        requestArgs.basis2Z = 1.0f;
+        requestArgs.samplingRX = 40.0f;
+        requestArgs.samplingRY = 20.0f;
+        requestArgs.samplingRZ = 40.0f;
+        requestArgs.samplingInterval = 1.0f / (i + 1);
+        requests.push_back(requestArgs);
+    }
+
+    // Requests are sent once the connection is established. The client
+    // closes the connection once every response has arrived.
+    using Response = vc::VolumeClient::Response;
+    auto* client = client_.get();
+    auto log = [](const Response& response) {
+        vc::Logger()->info(
+            "Response #{}: ({}, {}), {}x{}x{}, {} bytes",
+            response.args.requestId, response.args.volpkg,
+            response.args.volume, response.args.extentX,
+            response.args.extentY, response.args.extentZ,
+            response.voxels.size());
+    };
+    auto logBatch = [client, log](const std::vector<Response>& responses) {
+        for (const auto& response : responses) {
+            log(response);
+        }
+        client->close();
+    };
+    auto logOne = [client, log](const Response& r) {
+        log(r);
+        if (client->pending() == 0) {
+            client->close();
+        }
+    };
+    if (parsed.count("batch") > 0) {
+        if (reslice) {
+            client->reslice(reslices, logBatch);
+        } else {
+            client->request(requests, logBatch);
+        }
+    } else {
+        for (const auto& resliceArgs : reslices) {
+            client->reslice(resliceArgs, logOne);
+        }
+        for (const auto& requestArgs : requests) {
+            client->request(requestArgs, logOne);
+        }
+    }
     return application.exec();
 }
@@ -0,0 +1,84 @@
+#include "vc/apps/server/VolumeCodec.hpp"
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+namespace vcp = volcart::protocol;
+
+// Favor speed: responses are generated per request
+static constexpr int COMPRESSION_LEVEL{1};
+
+// Split 16-bit values into planes of low- and high-order bytes
+static auto Shuffle(const char* data, std::size_t size) -> QByteArray
+{
+    auto n = size / sizeof(uint16_t);
+    QByteArray result(static_cast<int>(size), Qt::Uninitialized);
+    for (std::size_t i = 0; i < n; i++) {
+        result[static_cast<int>(i)] = data[2 * i];
+        result[static_cast<int>(n + i)] = data[2 * i + 1];
+    }
+    return result;
+}
+
+static auto Unshuffle(const QByteArray& data) -> QByteArray
+{
+    auto n = static_cast<std::size_t>(data.size()) / sizeof(uint16_t);
+    QByteArray result(data.size(), Qt::Uninitialized);
+    for (std::size_t i = 0; i < n; i++) {
+        result[static_cast<int>(2 * i)] = data[static_cast<int>(i)];
+        result[static_cast<int>(2 * i + 1)] = data[static_cast<int>(n + i)];
+    }
+    return result;
+}
+
+auto vcp::SelectCodec(uint8_t accepted) -> vcp::Codec
+{
+    for (auto c : {Codec::ZlibShuffle, Codec::Zlib}) {
+        if ((accepted & CodecFlag(c)) != 0) {
+            return c;
+        }
+    }
+    return Codec::None;
+}
+
+auto vcp::Encode(Codec codec, const char* data, std::size_t size)
+    -> QByteArray
+{
+    switch (codec) {
+        case Codec::None:
+            return {data, static_cast<int>(size)};
+        case Codec::Zlib:
+            return qCompress(
+                reinterpret_cast<const uchar*>(data), static_cast<int>(size),
+                COMPRESSION_LEVEL);
+        case Codec::ZlibShuffle:
+            return qCompress(Shuffle(data, size), COMPRESSION_LEVEL);
+    }
+    throw std::invalid_argument(
+        "Unknown codec: " + std::to_string(static_cast<int>(codec)));
+}
+
+auto vcp::Decode(Codec codec, const QByteArray& data, std::size_t rawSize)
+    -> QByteArray
+{
+    QByteArray result;
+    switch (codec) {
+        case Codec::None:
+            result = data;
+            break;
+        case Codec::Zlib:
+            result = qUncompress(data);
+            break;
+        case Codec::ZlibShuffle:
+            result = Unshuffle(qUncompress(data));
+            break;
+        default:
+            throw std::invalid_argument(
+                "Unknown codec: " + std::to_string(static_cast<int>(codec)));
+    }
+    if (static_cast<std::size_t>(result.size()) != rawSize) {
+        throw std::runtime_error("Failed to decode response data");
+    }
+    return result;
+}
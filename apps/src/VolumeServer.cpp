@@ -1,25 +1,391 @@
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstring>
+#include <deque>
 #include <iostream>
+#include <optional>
+#include <string>
+#include <vector>
 
 #include <QCoreApplication>
+#include <QDataStream>
+#include <QLocalSocket>
+#include <QPointer>
 #include <QSignalMapper>
 
 #include "vc/app_support/GetMemorySize.hpp"
+#include "vc/apps/server/VolumeCodec.hpp"
 #include "vc/apps/server/VolumeServer.hpp"
 #include "vc/core/neighborhood/CuboidGenerator.hpp"
+#include "vc/core/types/ByteLRUCache.hpp"
 #include "vc/core/util/Logging.hpp"
 
 namespace vc = volcart;
 
-std::string vc::VolumeServer::socketStr_(QTcpSocket* socket)
+struct vc::VolumeServer::Batch {
+    /** Client socket. Null once the socket has been destroyed. */
+    QPointer<QIODevice> socket;
+    /** Protocol version of the request packet */
+    protocol::Version version{protocol::V1};
+    /** V2 only: keep the connection open after the responses */
+    bool keepAlive{false};
+    /** V2 only: codecs accepted by the client */
+    uint8_t codecs{0};
+    /** Number of responses not yet written */
+    uint32_t remaining{0};
+    /** V1 only: ID of the next response to write */
+    uint32_t nextId{0};
+    /** V1 only: finished responses waiting for an earlier response */
+    std::map<uint32_t, QByteArray> pending;
+    /** V2 only: send responses through the shared memory ring */
+    bool shared{false};
+    /** Whether responses of this batch were sent through the ring */
+    bool sentShared{false};
+    /** V2 only: scheduling priority of the requests */
+    uint8_t priority{0};
+    /** V2 only: sub-volume responses may be split into chunks */
+    bool chunked{false};
+};
+
+struct vc::VolumeServer::Job {
+    /** The request's batch */
+    std::shared_ptr<Batch> batch;
+    /** Request ID */
+    uint32_t requestId{0};
+    /** Request arguments */
+    protocol::RequestArgs args{};
+    /** Requested volume */
+    Volume::Pointer volume;
+    /** Fair queuing start tag */
+    double tag{0};
+    /** Arguments of a reslice request. Empty for sub-volume requests. */
+    std::optional<protocol::ResliceArgs> reslice;
+    /** Response cache key. Empty if the response is not cached. */
+    std::string cacheKey;
+};
+
+// Charge a cached response for its size
+struct ResponseBytes {
+    auto operator()(const QByteArray& r) const -> std::size_t
+    {
+        return static_cast<std::size_t>(r.size());
+    }
+};
+
+struct vc::VolumeServer::ResponseCache {
+    explicit ResponseCache(std::size_t bytes) : responses{bytes} {}
+    /** Encoded responses by request key */
+    vc::ByteLRUCache<std::string, QByteArray, ResponseBytes> responses;
+    /** Number of requests answered from the cache */
+    std::size_t hits{0};
+    /** Number of cacheable requests which were not in the cache */
+    std::size_t misses{0};
+};
+
+struct vc::VolumeServer::ChunkedResponse {
+    /** The request */
+    Job job;
+    /** Extents of the whole sub-volume in x/y/z order */
+    std::array<uint32_t, 3> extents{};
+    /** Number of slices per chunk */
+    std::size_t chunkSlices{1};
+    /** First slice of the next chunk */
+    std::size_t nextSlice{0};
+    /** Resume generating chunks once the socket has been drained */
+    QMetaObject::Connection drained;
+    /** Resume (and finish) once the socket has been destroyed */
+    QMetaObject::Connection destroyed;
+};
+
+struct vc::VolumeServer::Connection {
+    explicit Connection(QIODevice* socket) : stream{socket} {}
+    /** Client data stream */
+    QDataStream stream;
+    /** KeepAlive only: ID of the first request of the next packet */
+    uint32_t nextRequestId{0};
+    /** Whether a packet without KeepAlive has been read */
+    bool closing{false};
+    /** Requests waiting for a worker, in request order */
+    std::deque<Job> queue;
+    /** Fair queuing finish tag of the last queued request */
+    double finishTag{0};
+};
+
+// Sub-volumes larger than this are sent in chunks of about this size to
+// clients which accept RequestFlag::Chunked
+static constexpr std::size_t CHUNK_BYTES{4 << 20};
+
+// Chunks are only generated while less than this much data is waiting to be
+// written to the client
+static constexpr qint64 MAX_BUFFERED_BYTES{16 << 20};
+
+// Get a request's sub-volume generator. Axes and radii are in z/y/x order.
+static auto MakeGenerator(const vc::protocol::RequestArgs& args)
+    -> vc::CuboidGenerator
+{
+    vc::CuboidGenerator subvolume;
+    subvolume.setSamplingRadius(
+        args.samplingRZ, args.samplingRY, args.samplingRX);
+    subvolume.setSamplingInterval(args.samplingInterval);
+    return subvolume;
+}
+
+// Get a request's sub-volume axes in z/y/x order
+static auto Axes(const vc::protocol::RequestArgs& args)
+    -> std::vector<cv::Vec3d>
+{
+    cv::Vec3d xvec{args.basis0X, args.basis0Y, args.basis0Z};
+    cv::Vec3d yvec{args.basis1X, args.basis1Y, args.basis1Z};
+    cv::Vec3d zvec{args.basis2X, args.basis2Y, args.basis2Z};
+    return {zvec, yvec, xvec};
+}
+
+// Get neighborhood extents in x/y/z order
+static auto ExtentsXYZ(const vc::Neighborhood::Extent& e)
+    -> std::array<uint32_t, 3>
+{
+    return {
+        static_cast<uint32_t>(e[2]), static_cast<uint32_t>(e[1]),
+        static_cast<uint32_t>(e[0])};
+}
+
+// Get the extents of a request's response in x/y/z order
+static auto ResponseExtents(
+    const vc::protocol::RequestArgs& args,
+    const std::optional<vc::protocol::ResliceArgs>& reslice)
+    -> std::array<uint32_t, 3>
+{
+    if (reslice) {
+        return {reslice->width, reslice->height, 1};
+    }
+    return ExtentsXYZ(MakeGenerator(args).extents());
+}
+
+// Get the number of voxels of a request's response
+static auto NumVoxels(
+    const vc::protocol::RequestArgs& args,
+    const std::optional<vc::protocol::ResliceArgs>& reslice) -> std::size_t
+{
+    auto e = ResponseExtents(args, reslice);
+    return std::size_t{e[0]} * e[1] * e[2];
+}
+
+// Get the sub-volume request which carries the volume names of a reslice
+// request. Response headers are made from it.
+static auto HeaderArgs(const vc::protocol::ResliceArgs& reslice)
+    -> vc::protocol::RequestArgs
+{
+    vc::protocol::RequestArgs args;
+    std::memset(&args, 0, sizeof(args));
+    std::memcpy(args.volpkg, reslice.volpkg, vc::protocol::VOLPKG_SZ);
+    std::memcpy(args.volume, reslice.volume, vc::protocol::VOLUME_SZ);
+    return args;
+}
+
+// Get a reslice request's plane, in the coordinates of its resolution level
+static auto MakeFrame(const vc::protocol::ResliceArgs& reslice)
+    -> vc::Volume::ResliceFrame
+{
+    auto scale = vc::Volume::levelScale(reslice.level);
+    cv::Vec3d center{reslice.centerX, reslice.centerY, reslice.centerZ};
+    cv::Vec3d xvec{reslice.xvecX, reslice.xvecY, reslice.xvecZ};
+    cv::Vec3d yvec{reslice.yvecX, reslice.yvecY, reslice.yvecZ};
+    return {center / scale, xvec, yvec};
+}
+
+// Write a client connection's buffered data
+static void FlushSocket(QIODevice* socket)
+{
+    if (auto* tcp = qobject_cast<QTcpSocket*>(socket)) {
+        tcp->flush();
+    } else if (auto* local = qobject_cast<QLocalSocket*>(socket)) {
+        local->flush();
+    }
+}
+
+// Close a client connection
+static void CloseSocket(QIODevice* socket)
+{
+    if (auto* tcp = qobject_cast<QTcpSocket*>(socket)) {
+        tcp->disconnectFromHost();
+    } else if (auto* local = qobject_cast<QLocalSocket*>(socket)) {
+        local->disconnectFromServer();
+    }
+}
+
+// Append the bytes of request arguments to a response cache key
+template <typename Args>
+static void AppendKey(std::string& key, Args args)
+{
+    // Bytes after the end of the volume names are not part of the request
+    auto clear = [](char* s, std::size_t n) {
+        auto* end = std::find(s, s + n, '\0');
+        std::fill(end, s + n, '\0');
+    };
+    clear(args.volpkg, vc::protocol::VOLPKG_SZ);
+    clear(args.volume, vc::protocol::VOLUME_SZ);
+    key.append(reinterpret_cast<const char*>(&args), sizeof(args));
+}
+
+// Get the response cache key of a request. The encoded response depends on
+// the request's arguments and on the protocol version and codecs of the
+// client.
+static auto ResponseKey(
+    vc::protocol::Version version,
+    uint8_t codecs,
+    const vc::protocol::RequestArgs& args,
+    const std::optional<vc::protocol::ResliceArgs>& reslice) -> std::string
+{
+    std::string key{
+        static_cast<char>(version), static_cast<char>(codecs),
+        static_cast<char>(reslice ? 1 : 0)};
+    if (reslice) {
+        AppendKey(key, *reslice);
+    } else {
+        AppendKey(key, args);
+    }
+    return key;
+}
+
+// Set the request ID of a (cached) response
+static auto WithRequestId(
+    QByteArray response, vc::protocol::Version version, uint32_t requestId)
+    -> QByteArray
+{
+    constexpr auto idOffset = offsetof(vc::protocol::ResponseArgsV2, requestId);
+    if (version == vc::protocol::V2 and
+        static_cast<std::size_t>(response.size()) >=
+            sizeof(vc::protocol::ResponseArgsV2)) {
+        std::memcpy(response.data() + idOffset, &requestId, sizeof(requestId));
+    }
+    return response;
+}
+
+// Serialize a response header and (optional) voxels with x/y/z extents
+static auto MakeResponse(
+    vc::protocol::Version version,
+    uint8_t codecs,
+    const vc::protocol::RequestArgs& args,
+    uint32_t requestId,
+    const uint16_t* voxels = nullptr,
+    std::array<uint32_t, 3> extents = {0, 0, 0},
+    uint8_t flags = 0) -> QByteArray
+{
+    uint32_t size{0};
+    if (voxels != nullptr) {
+        size = static_cast<uint32_t>(
+            sizeof(uint16_t) * extents[0] * extents[1] * extents[2]);
+    } else {
+        extents = {0, 0, 0};
+    }
+
+    QByteArray response;
+    if (version == vc::protocol::V2) {
+        // Encode the data, unless encoding doesn't make it smaller
+        auto codec = vc::protocol::Codec::None;
+        QByteArray encoded;
+        if (voxels != nullptr) {
+            const auto* raw = reinterpret_cast<const char*>(voxels);
+            codec = vc::protocol::SelectCodec(codecs);
+            encoded = vc::protocol::Encode(codec, raw, size);
+            if (static_cast<uint32_t>(encoded.size()) >= size) {
+                codec = vc::protocol::Codec::None;
+                encoded = vc::protocol::Encode(codec, raw, size);
+            }
+        }
+
+        vc::protocol::ResponseArgsV2 hdr;
+        std::memset(&hdr, 0, sizeof(hdr));
+        std::strncpy(hdr.volpkg, args.volpkg, vc::protocol::VOLPKG_SZ);
+        std::strncpy(hdr.volume, args.volume, vc::protocol::VOLUME_SZ);
+        hdr.requestId = requestId;
+        hdr.extentX = extents[0];
+        hdr.extentY = extents[1];
+        hdr.extentZ = extents[2];
+        hdr.size = static_cast<uint32_t>(encoded.size());
+        hdr.rawSize = size;
+        hdr.codec = codec;
+        hdr.flags = flags;
+        response.append(reinterpret_cast<const char*>(&hdr), sizeof(hdr));
+        response.append(encoded);
+        return response;
+    }
+
+    vc::protocol::ResponseArgs hdr;
+    std::memset(&hdr, 0, sizeof(hdr));
+    std::strncpy(hdr.volpkg, args.volpkg, vc::protocol::VOLPKG_SZ);
+    std::strncpy(hdr.volume, args.volume, vc::protocol::VOLUME_SZ);
+    hdr.extentX = extents[0];
+    hdr.extentY = extents[1];
+    hdr.extentZ = extents[2];
+    hdr.size = size;
+    response.append(reinterpret_cast<const char*>(&hdr), sizeof(hdr));
+    if (voxels != nullptr) {
+        response.append(
+            reinterpret_cast<const char*>(voxels), static_cast<int>(size));
+    }
+    return response;
+}
+
+// Serialize the header of a response in the shared memory ring
+static auto MakeSharedResponse(
+    const vc::protocol::RequestArgs& args,
+    uint32_t requestId,
+    const std::array<uint32_t, 3>& extents,
+    std::size_t offset) -> QByteArray
+{
+    vc::protocol::ResponseArgsV2 hdr;
+    std::memset(&hdr, 0, sizeof(hdr));
+    std::strncpy(hdr.volpkg, args.volpkg, vc::protocol::VOLPKG_SZ);
+    std::strncpy(hdr.volume, args.volume, vc::protocol::VOLUME_SZ);
+    hdr.requestId = requestId;
+    hdr.extentX = extents[0];
+    hdr.extentY = extents[1];
+    hdr.extentZ = extents[2];
+    hdr.size = sizeof(vc::protocol::SharedMemoryRef);
+    hdr.rawSize = static_cast<uint32_t>(
+        sizeof(uint16_t) * extents[0] * extents[1] * extents[2]);
+    hdr.codec = vc::protocol::Codec::SharedMemory;
+    vc::protocol::SharedMemoryRef ref{offset};
+
+    QByteArray response;
+    response.append(reinterpret_cast<const char*>(&hdr), sizeof(hdr));
+    response.append(reinterpret_cast<const char*>(&ref), sizeof(ref));
+    return response;
+}
+
+std::string vc::VolumeServer::socketStr_(QIODevice* socket)
 {
-    return "[" + socket->peerAddress().toString().toStdString() + ":" +
-           std::to_string(socket->peerPort()) + "]: ";
+    if (auto* local = qobject_cast<QLocalSocket*>(socket)) {
+        return "[local:" + std::to_string(local->socketDescriptor()) + "]: ";
+    }
+    auto* tcp = qobject_cast<QTcpSocket*>(socket);
+    return "[" + tcp->peerAddress().toString().toStdString() + ":" +
+           std::to_string(tcp->peerPort()) + "]: ";
 }
 
 vc::VolumeServer::VolumeServer(
-    VolumePkgMap volpkgs, quint16 port, std::size_t memory, QObject* parent)
-    : QObject{parent}, volpkgs_{volpkgs}, memory_{memory}
+    VolumePkgMap volpkgs,
+    quint16 port,
+    std::size_t memory,
+    int threads,
+    Volume::CachePolicy cachePolicy,
+    QObject* parent)
+    : QObject{parent}
+    , volpkgs_{volpkgs}
+    , memory_{memory}
+    , cache_{Volume::NewSharedCache(
+          memory, Volume::SharedSliceCache::DEFAULT_SHARDS, cachePolicy)}
 {
+    if (threads > 0) {
+        pool_.setMaxThreadCount(threads);
+    }
+    vc::Logger()->info(
+        "Resolving requests with {} threads", pool_.maxThreadCount());
+    connect(
+        &statsTimer_, &QTimer::timeout, this, &VolumeServer::logCacheStats);
+
     server_ = new QTcpServer(this);
     connect(
         server_, &QTcpServer::newConnection, this,
@@ -31,60 +397,240 @@ vc::VolumeServer::VolumeServer(
     }
 }
 
-void vc::VolumeServer::socketReadyRead(QDataStream* dataStream)
+vc::VolumeServer::~VolumeServer()
 {
-    QTcpSocket* socket = reinterpret_cast<QTcpSocket*>(dataStream->device());
-    // Read all data from the socket
-    dataStream->startTransaction();
-    protocol::RequestHdr requestHdr;
-    int bytesHdr = dataStream->readRawData(
-        reinterpret_cast<char*>(&requestHdr), sizeof(requestHdr));
-    if (bytesHdr != sizeof(protocol::RequestHdr)) {
-        dataStream->rollbackTransaction();
-        return;
-    }
-    if (requestHdr.magic != protocol::MAGIC) {
-        vc::Logger()->error(
-            "{}: magic value is incorrect: {}", socketStr_(socket),
-            requestHdr.magic);
-        // TODO: actually exit
+    pool_.waitForDone();
+    logCacheStats();
+}
+
+bool vc::VolumeServer::listenLocal(const QString& name, std::size_t ringBytes)
+{
+    if (ringBytes > 0) {
+        auto key = QString::fromStdString(
+            protocol::SharedMemoryKey(name.toStdString()));
+        ring_ = std::make_unique<QSharedMemory>(key);
+        // Reclaim the ring of a server which did not exit cleanly
+        if (ring_->attach()) {
+            ring_->detach();
+        }
+        if (not ring_->create(static_cast<qsizetype>(ringBytes))) {
+            vc::Logger()->error(
+                "Failed to create shared memory ring: {}",
+                ring_->errorString().toStdString());
+            ring_.reset();
+            return false;
+        }
+        ringAllocator_ = std::make_unique<RingAllocator>(ringBytes);
     }
-    if (requestHdr.version != protocol::V1) {
+
+    // Remove the socket of a server which did not exit cleanly
+    QLocalServer::removeServer(name);
+    localServer_ = new QLocalServer(this);
+    connect(
+        localServer_, &QLocalServer::newConnection, this,
+        &VolumeServer::acceptLocalConnection);
+    if (not localServer_->listen(name)) {
         vc::Logger()->error(
-            "{}: version is unsupported: {}", socketStr_(socket),
-            static_cast<uint32_t>(requestHdr.version));
-        // TODO: actually exit
+            "Failed to listen on local socket: {}",
+            localServer_->errorString().toStdString());
+        return false;
     }
     vc::Logger()->info(
-        "{}: Need to resolve {} requests.", socketStr_(socket),
-        requestHdr.numRequests);
-    protocol::RequestArgs* requestArgs =
-        new protocol::RequestArgs[requestHdr.numRequests];
-
-    dataStream->startTransaction();
-    int bytesArgs = dataStream->readRawData(
-        reinterpret_cast<char*>(requestArgs),
-        sizeof(protocol::RequestArgs) * requestHdr.numRequests);
-    if (bytesArgs !=
-        static_cast<int>(
-            sizeof(protocol::RequestArgs) * requestHdr.numRequests)) {
-        dataStream->rollbackTransaction();
-    } else {
-        dataStream->commitTransaction();
+        "Listening on local socket: {}",
+        localServer_->fullServerName().toStdString());
+    if (ring_) {
+        vc::Logger()->info("Shared memory ring: {} bytes", ringBytes);
     }
-    if (!dataStream->commitTransaction()) {
-        delete[] requestArgs;
+    return true;
+}
+
+void vc::VolumeServer::setCacheStatsInterval(int seconds)
+{
+    if (seconds <= 0) {
+        statsTimer_.stop();
         return;
     }
-    // Resolve requests
-    for (uint32_t i = 0; i < requestHdr.numRequests; i++) {
-        resolveRequest_(socket, &requestArgs[i]);
+    statsTimer_.start(seconds * 1000);
+}
+
+void vc::VolumeServer::setMaxRequestSize(std::size_t bytes)
+{
+    maxRequestSize_ = bytes;
+}
+
+void vc::VolumeServer::setResponseCacheSize(std::size_t bytes)
+{
+    if (bytes == 0) {
+        responseCache_.reset();
+        return;
     }
-    // Clean up
-    vc::Logger()->info("{}: Closing connection...", socketStr_(socket));
-    delete[] requestArgs;
-    delete dataStream;
-    socket->disconnectFromHost();
+    responseCache_ = std::make_unique<ResponseCache>(bytes);
+}
+
+void vc::VolumeServer::logCacheStats()
+{
+    vc::Logger()->info(
+        "Shared cache: {} entries, {} evictions, capacity {} bytes",
+        cache_->size(), cache_->evictions(), cache_->capacity());
+    if (responseCache_) {
+        const auto& rc = *responseCache_;
+        vc::Logger()->info(
+            "Response cache: {} hits, {} misses, {} entries, {} of {} bytes",
+            rc.hits, rc.misses, rc.responses.size(), rc.responses.bytes(),
+            rc.responses.capacity());
+    }
+    for (const auto& [id, volume] : volumes_) {
+        vc::Logger()->info(
+            "Cache stats for volume {}: {}", id,
+            volume->cacheStats().summary());
+    }
+}
+
+void vc::VolumeServer::readRequests_(
+    const std::shared_ptr<Connection>& connection)
+{
+    auto& stream = connection->stream;
+    QIODevice* socket = stream.device();
+    // Clients with KeepAlive may pipeline several packets
+    while (not connection->closing) {
+        stream.startTransaction();
+        protocol::RequestHdr requestHdr;
+        int bytesHdr = stream.readRawData(
+            reinterpret_cast<char*>(&requestHdr), sizeof(requestHdr));
+        if (bytesHdr != sizeof(protocol::RequestHdr)) {
+            stream.rollbackTransaction();
+            return;
+        }
+        if (requestHdr.magic != protocol::MAGIC) {
+            vc::Logger()->error(
+                "{}: magic value is incorrect: {}", socketStr_(socket),
+                requestHdr.magic);
+            // TODO: actually exit
+        }
+        if (requestHdr.version != protocol::V1 and
+            requestHdr.version != protocol::V2) {
+            vc::Logger()->error(
+                "{}: version is unsupported: {}", socketStr_(socket),
+                static_cast<uint32_t>(requestHdr.version));
+            // TODO: actually exit
+        }
+
+        // Release packets hold the ring regions which the client has read
+        if (requestHdr.version == protocol::V2 and
+            (requestHdr.flags & protocol::ReleaseShared) != 0) {
+            std::vector<protocol::SharedMemoryRef> refs(
+                requestHdr.numRequests);
+            auto refsSize = sizeof(protocol::SharedMemoryRef) * refs.size();
+            int bytesRefs = stream.readRawData(
+                reinterpret_cast<char*>(refs.data()), refsSize);
+            if (bytesRefs != static_cast<int>(refsSize)) {
+                stream.rollbackTransaction();
+                return;
+            }
+            if (not stream.commitTransaction()) {
+                return;
+            }
+            releaseRegions_(socket, refs);
+            continue;
+        }
+
+        // V2 packets may hold reslice requests instead of sub-volume
+        // requests
+        auto isReslice = requestHdr.version == protocol::V2 and
+                         (requestHdr.flags & protocol::ResliceRequests) != 0;
+        std::vector<protocol::RequestArgs> requestArgs;
+        std::vector<protocol::ResliceArgs> resliceArgs;
+        char* argsData{nullptr};
+        std::size_t argsSize{0};
+        if (isReslice) {
+            resliceArgs.resize(requestHdr.numRequests);
+            argsData = reinterpret_cast<char*>(resliceArgs.data());
+            argsSize = sizeof(protocol::ResliceArgs) * requestHdr.numRequests;
+        } else {
+            requestArgs.resize(requestHdr.numRequests);
+            argsData = reinterpret_cast<char*>(requestArgs.data());
+            argsSize = sizeof(protocol::RequestArgs) * requestHdr.numRequests;
+        }
+        int bytesArgs = stream.readRawData(argsData, argsSize);
+        if (bytesArgs != static_cast<int>(argsSize)) {
+            stream.rollbackTransaction();
+            return;
+        }
+        if (not stream.commitTransaction()) {
+            return;
+        }
+        vc::Logger()->info(
+            "{}: Need to resolve {} requests.", socketStr_(socket),
+            requestHdr.numRequests);
+
+        // Dispatch requests. Responses are written as they complete.
+        auto batch = std::make_shared<Batch>();
+        batch->socket = socket;
+        batch->version = requestHdr.version == protocol::V2 ? protocol::V2
+                                                            : protocol::V1;
+        if (batch->version == protocol::V2) {
+            batch->codecs = requestHdr.codecs;
+            batch->keepAlive =
+                (requestHdr.flags & protocol::KeepAlive) != 0;
+            batch->priority =
+                std::min(requestHdr.priority, protocol::MAX_PRIORITY);
+            batch->chunked = (requestHdr.flags & protocol::Chunked) != 0;
+        }
+        batch->remaining = requestHdr.numRequests;
+        connection->closing = not batch->keepAlive;
+
+        // Requests of KeepAlive packets are numbered across the connection
+        uint32_t firstId{0};
+        if (batch->keepAlive) {
+            firstId = connection->nextRequestId;
+            connection->nextRequestId += requestHdr.numRequests;
+        }
+
+        // Local clients may read their responses from the shared memory
+        // ring. The client releases each response once it has read it.
+        auto* local = qobject_cast<QLocalSocket*>(socket);
+        batch->shared =
+            ring_ and local != nullptr and batch->version == protocol::V2 and
+            (batch->codecs & protocol::CodecFlag(protocol::SharedMemory)) != 0;
+        if (batch->remaining == 0) {
+            writeResponse_(batch, 0, {});
+            continue;
+        }
+        for (uint32_t i = 0; i < requestHdr.numRequests; i++) {
+            if (isReslice) {
+                resolveRequest_(
+                    connection, batch, firstId + i,
+                    HeaderArgs(resliceArgs[i]), resliceArgs[i]);
+            } else {
+                resolveRequest_(
+                    connection, batch, firstId + i, requestArgs[i]);
+            }
+        }
+        schedule_();
+    }
+}
+
+void vc::VolumeServer::openConnection_(QIODevice* socket)
+{
+    vc::Logger()->info("{}: Accepted connection...", socketStr_(socket));
+    // The connection state lives as long as the socket's readyRead slot
+    auto connection = std::make_shared<Connection>(socket);
+    connect(socket, &QIODevice::readyRead, [this, connection] {
+        readRequests_(connection);
+    });
+}
+
+void vc::VolumeServer::acceptLocalConnection()
+{
+    QLocalSocket* socket = localServer_->nextPendingConnection();
+    // Ring regions which the client did not release are released when it
+    // goes away
+    connect(socket, &QLocalSocket::disconnected, this, [this, socket]() {
+        releaseRegions_(socket);
+    });
+    connect(
+        socket, &QLocalSocket::disconnected, socket, &QObject::deleteLater);
+    openConnection_(socket);
 }
 
 void vc::VolumeServer::acceptConnection()
@@ -92,86 +638,418 @@ void vc::VolumeServer::acceptConnection()
     QTcpSocket* socket = server_->nextPendingConnection();
     connect(
         socket, &QAbstractSocket::disconnected, socket, &QObject::deleteLater);
-    vc::Logger()->info("{}: Accepted connection...", socketStr_(socket));
-    QDataStream* dataStream = new QDataStream(socket);
-    connect(socket, &QTcpSocket::readyRead, [this, dataStream] {
-        socketReadyRead(dataStream);
-    });
+    openConnection_(socket);
 }
 
-void vc::VolumeServer::resolveRequest_(
-    QTcpSocket* socket, protocol::RequestArgs* args)
-{
-    Volume::Pointer volume = nullptr;
-    protocol::ResponseArgs responseArgs;
-    std::memset(&responseArgs, 0, sizeof(protocol::ResponseArgs));
-    std::strncpy(responseArgs.volpkg, args->volpkg, protocol::VOLPKG_SZ);
-    std::strncpy(responseArgs.volume, args->volume, protocol::VOLUME_SZ);
-    if (!volumes_.count(args->volume)) {
+vc::Volume::Pointer vc::VolumeServer::getVolume_(
+    QIODevice* socket, const protocol::RequestArgs& args)
+{
+    if (volumes_.count(args.volume)) {
         vc::Logger()->info(
-            "{}: Request for volume ({}, {}): need to load for the first "
-            "time",
-            socketStr_(socket), args->volpkg, args->volume);
+            "{}: Request for volume ({}, {}): found in cache",
+            socketStr_(socket), args.volpkg, args.volume);
+        return volumes_.at(args.volume);
+    }
+
+    vc::Logger()->info(
+        "{}: Request for volume ({}, {}): need to load for the first time",
+        socketStr_(socket), args.volpkg, args.volume);
+    Volume::Pointer volume;
+    try {
+        volume = volpkgs_.at(args.volpkg).volume(args.volume);
+        // Every volume draws on the same memory budget, so that eviction
+        // follows demand across all volumes
+        volume->setCache(cache_);
+        volumes_.insert({args.volume, volume});
+    } catch (std::exception& e) {
+        // TODO: solve this
+        vc::Logger()->error("Unable to load volume: {}", e.what());
+        return nullptr;
+    }
+    return volume;
+}
+
+void vc::VolumeServer::resolveRequest_(
+    const std::shared_ptr<Connection>& connection,
+    const std::shared_ptr<Batch>& batch,
+    uint32_t requestId,
+    const protocol::RequestArgs& args,
+    const std::optional<protocol::ResliceArgs>& reslice)
+{
+    // Volumes and their resolution levels are loaded on the server thread
+    auto volume = getVolume_(batch->socket, args);
+    if (volume and reslice) {
+        try {
+            volume = volume->level(reslice->level);
+        } catch (const std::exception& e) {
+            vc::Logger()->error(
+                "{}: Reslice #{}: Cannot load level {}: {}",
+                socketStr_(batch->socket), requestId, reslice->level,
+                e.what());
+            volume = nullptr;
+        }
+    }
+    if (not volume) {
+        writeResponse_(
+            batch, requestId,
+            MakeResponse(batch->version, batch->codecs, args, requestId));
+        return;
+    }
+
+    // Reject requests which are too large
+    auto voxels = NumVoxels(args, reslice);
+    if (maxRequestSize_ > 0 and voxels * sizeof(uint16_t) > maxRequestSize_) {
+        vc::Logger()->error(
+            "{}: Request #{} exceeds the request size limit ({} bytes)",
+            socketStr_(batch->socket), requestId, maxRequestSize_);
+        writeResponse_(
+            batch, requestId,
+            MakeResponse(batch->version, batch->codecs, args, requestId));
+        return;
+    }
+
+    // Answer repeated requests from the response cache. Responses through
+    // the shared memory ring are not cached.
+    std::string cacheKey;
+    if (responseCache_ and not batch->shared) {
+        cacheKey = ResponseKey(batch->version, batch->codecs, args, reslice);
+        auto& responses = responseCache_->responses;
+        if (responses.contains(cacheKey)) {
+            responseCache_->hits++;
+            writeResponse_(
+                batch, requestId,
+                WithRequestId(
+                    responses.get(cacheKey), batch->version, requestId));
+            return;
+        }
+        responseCache_->misses++;
+    }
+
+    // Start-time fair queuing: a request's cost is its number of voxels,
+    // divided by the weight of its priority. Connections which were idle
+    // start at the current virtual time, so they do not save up a share.
+    auto weight = static_cast<double>(1U << batch->priority);
+    Job job{batch, requestId, args, volume};
+    job.reslice = reslice;
+    job.cacheKey = std::move(cacheKey);
+    job.tag = std::max(virtualTime_, connection->finishTag);
+    connection->finishTag = job.tag + static_cast<double>(voxels) / weight;
+    if (connection->queue.empty()) {
+        queued_.push_back(connection);
+    }
+    connection->queue.push_back(std::move(job));
+}
+
+void vc::VolumeServer::schedule_()
+{
+    // Only pass as many requests to the pool as it has threads, so that
+    // the order of the remaining requests can still change
+    while (running_ < pool_.maxThreadCount() and not queued_.empty()) {
+        // Start the queued request with the earliest start tag. Each
+        // connection's requests are queued in increasing tag order.
+        auto next = std::min_element(
+            queued_.begin(), queued_.end(), [](const auto& a, const auto& b) {
+                return a->queue.front().tag < b->queue.front().tag;
+            });
+        auto connection = *next;
+        auto job = std::move(connection->queue.front());
+        connection->queue.pop_front();
+        if (connection->queue.empty()) {
+            queued_.erase(next);
+        }
+        virtualTime_ = job.tag;
+        start_(std::move(job));
+    }
+}
+
+void vc::VolumeServer::start_(Job job)
+{
+    const auto& batch = job.batch;
+    const auto& args = job.args;
+    const auto requestId = job.requestId;
+
+    // Skip the requests of clients which have gone away
+    if (batch->socket.isNull()) {
+        writeResponse_(
+            batch, requestId,
+            MakeResponse(batch->version, batch->codecs, args, requestId));
+        return;
+    }
+
+    // Reserve space for the response in the shared memory ring
+    std::optional<std::size_t> region;
+    if (batch->shared) {
+        region = ringAllocator_->allocate(
+            NumVoxels(args, job.reslice) * sizeof(uint16_t));
+    }
+    auto* ring = region ? static_cast<char*>(ring_->data()) + *region
+                        : nullptr;
+
+    // Stream large sub-volumes over the socket in chunks of slices, so that
+    // only one chunk per request is held in memory
+    auto bytes = NumVoxels(args, job.reslice) * sizeof(uint16_t);
+    if (batch->chunked and ring == nullptr and not job.reslice and
+        bytes > CHUNK_BYTES) {
+        auto chunks = std::make_shared<ChunkedResponse>();
+        chunks->extents = ResponseExtents(args, job.reslice);
+        auto sliceBytes = std::size_t{chunks->extents[0]} *
+                          chunks->extents[1] * sizeof(uint16_t);
+        chunks->chunkSlices =
+            std::max<std::size_t>(1, CHUNK_BYTES / sliceBytes);
+        chunks->job = std::move(job);
+        running_++;
+        generateChunk_(chunks);
+        return;
+    }
+
+    // Generate the response on the worker pool
+    running_++;
+    auto version = batch->version;
+    auto codecs = batch->codecs;
+    auto volume = job.volume;
+    auto reslice = job.reslice;
+    auto cacheKey = std::move(job.cacheKey);
+    pool_.start([this, batch, requestId, args, reslice, volume, version,
+                 codecs, ring, region, cacheKey]() mutable {
+        QByteArray response;
+        bool inRing{false};
+        try {
+            auto extents = ResponseExtents(args, reslice);
+            auto* out = reinterpret_cast<uint16_t*>(ring);
+            std::vector<uint16_t> voxels;
+            if (ring == nullptr) {
+                voxels.resize(NumVoxels(args, reslice));
+                out = voxels.data();
+            }
+
+            // Write the image or subvolume in place in the ring, if it has
+            // a region
+            if (reslice) {
+                auto frame = MakeFrame(*reslice);
+                volume->reslice(
+                    &frame, 1, static_cast<int>(reslice->width),
+                    static_cast<int>(reslice->height), out);
+            } else {
+                auto subvolume = MakeGenerator(args);
+                // This must be in x/y/z order.
+                cv::Vec3d center{args.centerX, args.centerY, args.centerZ};
+                auto offsets = subvolume.precompute(Axes(args));
+                subvolume.computeInto(volume, center, offsets, out);
+            }
+            if (ring != nullptr) {
+                response =
+                    MakeSharedResponse(args, requestId, extents, *region);
+                inRing = true;
+            } else {
+                response = MakeResponse(
+                    version, codecs, args, requestId, out, extents);
+            }
+        } catch (const std::exception& e) {
+            vc::Logger()->error(
+                "Failed to generate request #{}: {}", requestId, e.what());
+            response = MakeResponse(version, codecs, args, requestId);
+            cacheKey.clear();
+        }
+
+        // Sockets and the response cache may only be used from the server's
+        // thread
+        QMetaObject::invokeMethod(
+            this,
+            [this, batch, requestId, response, cacheKey, region, inRing]() {
+                running_--;
+                if (not cacheKey.empty()) {
+                    responseCache_->responses.put(cacheKey, response);
+                }
+                if (region) {
+                    sentRegion_(batch, *region, inRing);
+                }
+                writeResponse_(batch, requestId, response);
+                schedule_();
+            },
+            Qt::QueuedConnection);
+    });
+}
+
+void vc::VolumeServer::generateChunk_(
+    const std::shared_ptr<ChunkedResponse>& chunks)
+{
+    // Skip the remaining chunks of clients which have gone away
+    const auto& job = chunks->job;
+    if (job.batch->socket.isNull()) {
+        finishChunks_(
+            chunks, MakeResponse(
+                        job.batch->version, job.batch->codecs, job.args,
+                        job.requestId));
+        return;
+    }
+
+    auto first = chunks->nextSlice;
+    auto last = std::min<std::size_t>(
+        first + chunks->chunkSlices, chunks->extents[2]);
+    chunks->nextSlice = last;
+    auto version = job.batch->version;
+    auto codecs = job.batch->codecs;
+    pool_.start([this, chunks, first, last, version, codecs]() {
+        const auto& job = chunks->job;
+        const auto& args = job.args;
+        auto extents = chunks->extents;
+        extents[2] = static_cast<uint32_t>(last - first);
+        auto more = last < chunks->extents[2];
+        QByteArray chunk;
         try {
-            volume = volpkgs_.at(args->volpkg).volume(args->volume);
-            volumes_.insert({args->volume, volume});
-            // Update memory allocation distribution for all loaded volumes
-            std::size_t memPerVolume = static_cast<std::size_t>(
-                static_cast<double>(memory_) /
-                static_cast<double>(volumes_.size()));
+            std::vector<uint16_t> voxels(
+                std::size_t{extents[0]} * extents[1] * extents[2]);
+            // This must be in x/y/z order.
+            cv::Vec3d center{args.centerX, args.centerY, args.centerZ};
+            MakeGenerator(args).computeSlicesInto(
+                job.volume, center, Axes(args), first, last, voxels.data());
+            chunk = MakeResponse(
+                version, codecs, args, job.requestId, voxels.data(), extents,
+                more ? protocol::MoreChunks : 0);
+        } catch (const std::exception& e) {
+            vc::Logger()->error(
+                "Failed to generate request #{}: {}", job.requestId,
+                e.what());
+            chunk = MakeResponse(version, codecs, args, job.requestId);
+            more = false;
+        }
+
+        // Sockets may only be used from the server's thread
+        QMetaObject::invokeMethod(
+            this,
+            [this, chunks, chunk, more]() {
+                if (more) {
+                    writeChunk_(chunks, chunk);
+                } else {
+                    finishChunks_(chunks, chunk);
+                }
+            },
+            Qt::QueuedConnection);
+    });
+}
+
+void vc::VolumeServer::writeChunk_(
+    const std::shared_ptr<ChunkedResponse>& chunks, const QByteArray& chunk)
+{
+    auto* socket = chunks->job.batch->socket.data();
+    if (socket == nullptr) {
+        generateChunk_(chunks);
+        return;
+    }
+    socket->write(chunk);
+    FlushSocket(socket);
+    if (socket->bytesToWrite() <= MAX_BUFFERED_BYTES) {
+        generateChunk_(chunks);
+        return;
+    }
+
+    // Wait until the client has read most of the buffered data
+    auto resume = [this, chunks]() {
+        auto* s = chunks->job.batch->socket.data();
+        if (s != nullptr and s->bytesToWrite() > MAX_BUFFERED_BYTES) {
+            return;
+        }
+        disconnect(chunks->drained);
+        disconnect(chunks->destroyed);
+        generateChunk_(chunks);
+    };
+    chunks->drained = connect(socket, &QIODevice::bytesWritten, this, resume);
+    chunks->destroyed = connect(
+        socket, &QObject::destroyed, this, resume, Qt::QueuedConnection);
+}
+
+void vc::VolumeServer::finishChunks_(
+    const std::shared_ptr<ChunkedResponse>& chunks, const QByteArray& chunk)
+{
+    running_--;
+    writeResponse_(chunks->job.batch, chunks->job.requestId, chunk);
+    schedule_();
+}
+
+void vc::VolumeServer::writeResponse_(
+    const std::shared_ptr<Batch>& batch,
+    uint32_t requestId,
+    const QByteArray& response)
+{
+    auto* socket = batch->socket.data();
+    if (batch->remaining > 0) {
+        batch->remaining--;
+        if (socket != nullptr) {
             vc::Logger()->info(
-                "Reallocating memory per loaded volume to {} bytes.",
-                memPerVolume);
-            for (auto& pair : volumes_) {
-                try {
-                    pair.second->setCacheMemoryInBytes(memPerVolume);
-                    if (pair.second->getCacheCapacity() < 1) {
-                        throw std::runtime_error("Cache capacity is 0");
-                    }
-                } catch (const std::exception& e) {
-                    vc::Logger()->error("{}", e.what());
-                    // TODO: exit or something
+                "{}: Subvolume #{} generated...", socketStr_(socket),
+                requestId);
+            // V1 responses must be written in request order
+            if (batch->version == protocol::V1) {
+                batch->pending.emplace(requestId, response);
+                auto it = batch->pending.begin();
+                while (it != batch->pending.end() and
+                       it->first == batch->nextId) {
+                    socket->write(it->second);
+                    it = batch->pending.erase(it);
+                    batch->nextId++;
                 }
+            } else {
+                socket->write(response);
             }
-        } catch (std::exception& e) {
-            // TODO: solve this
-            vc::Logger()->error("Unable to load volume: {}", e.what());
-            socket->write(
-                reinterpret_cast<char*>(&responseArgs),
-                sizeof(protocol::ResponseArgs));
-            return;
+            FlushSocket(socket);
+        }
+    }
+    if (batch->remaining > 0) {
+        return;
+    }
+
+    // The client closes connections with responses in the ring once it has
+    // read them
+    if (batch->sentShared) {
+        return;
+    }
+
+    // Clean up. The client closes KeepAlive connections.
+    if (socket == nullptr or batch->keepAlive) {
+        return;
+    }
+    vc::Logger()->info("{}: Closing connection...", socketStr_(socket));
+    CloseSocket(socket);
+}
+
+void vc::VolumeServer::sentRegion_(
+    const std::shared_ptr<Batch>& batch, std::size_t offset, bool used)
+{
+    auto* local = qobject_cast<QLocalSocket*>(batch->socket.data());
+    if (not used or local == nullptr or
+        local->state() != QLocalSocket::ConnectedState) {
+        ringAllocator_->release(offset);
+        return;
+    }
+    batch->sentShared = true;
+    sentRegions_.emplace(offset, batch->socket);
+}
+
+void vc::VolumeServer::releaseRegions_(
+    QIODevice* socket, const std::vector<protocol::SharedMemoryRef>& refs)
+{
+    for (const auto& ref : refs) {
+        // Clients may only release the regions of their own responses
+        auto it = sentRegions_.find(ref.offset);
+        if (it == sentRegions_.end() or it->second.data() != socket) {
+            vc::Logger()->warn(
+                "{}: Cannot release ring region {}: not held by the client",
+                socketStr_(socket), ref.offset);
+            continue;
+        }
+        ringAllocator_->release(it->first);
+        sentRegions_.erase(it);
+    }
+}
+
+void vc::VolumeServer::releaseRegions_(QIODevice* socket)
+{
+    for (auto it = sentRegions_.begin(); it != sentRegions_.end();) {
+        if (it->second.isNull() or it->second.data() == socket) {
+            ringAllocator_->release(it->first);
+            it = sentRegions_.erase(it);
+        } else {
+            ++it;
         }
-    } else {
-        volume = volumes_.at(args->volume);
-        vc::Logger()->info(
-            "{}: Request for volume ({}, {}): found in cache",
-            socketStr_(socket), args->volpkg, args->volume);
     }
-    // Generate subvolume for this request
-    vc::CuboidGenerator subvolume;
-    // This must be in x/y/z order.
-    cv::Vec3d center{args->centerX, args->centerY, args->centerZ};
-    cv::Vec3d xvec{args->basis0X, args->basis0Y, args->basis0Z};
-    cv::Vec3d yvec{args->basis1X, args->basis1Y, args->basis0Z};
-    cv::Vec3d zvec{args->basis2X, args->basis2Y, args->basis2Z};
-    // This must be in z/y/x order.
-    subvolume.setSamplingRadius(
-        args->samplingRZ, args->samplingRY, args->samplingRX);
-    subvolume.setSamplingInterval(args->samplingInterval);
-    // This must be in z/y/x order.
-    vc::Neighborhood neighborhood =
-        subvolume.compute(volume, center, {zvec, yvec, xvec});
-    vc::Logger()->info("{}: Subvolume generated...", socketStr_(socket));
-    responseArgs.size =
-        static_cast<uint32_t>(neighborhood.size() * sizeof(uint16_t));
-    auto extents = neighborhood.extents();
-    responseArgs.extentX = static_cast<uint32_t>(extents[2]);
-    responseArgs.extentY = static_cast<uint32_t>(extents[1]);
-    responseArgs.extentZ = static_cast<uint32_t>(extents[0]);
-    socket->write(
-        reinterpret_cast<char*>(&responseArgs), sizeof(protocol::ResponseArgs));
-    socket->write(
-        reinterpret_cast<char*>(neighborhood.data()),
-        sizeof(uint16_t) * neighborhood.size());
-    socket->flush();
 }
@@ -29,6 +29,13 @@ int main(int argc, char* argv[])
         ("help,h", "Show this message")
         ("port,p", po::value<quint16>()->default_value(8087), "Port to listen on")
         ("memory,m", po::value<std::string>()->required(), "Memory to reserve for the server in bytes (accepts K, M, G, T suffixes)")
+        ("threads,t", po::value<int>()->default_value(0), "Number of threads used to resolve requests. If 0, uses one thread per CPU core")
+        ("cache-stats-interval", po::value<int>()->default_value(0), "Log cache statistics every N seconds. Statistics are always logged on exit. If 0, disables periodic logging")
+        ("cache-policy", po::value<std::string>()->default_value("lru"), "Slice cache replacement policy: lru, 2q. 2q keeps frequently used slices cached while a client scans through a volume")
+        ("local", po::value<std::string>(), "Also listen on this local (Unix domain) socket, for clients on the same host")
+        ("shared-memory", po::value<std::string>(), "Size of the shared memory ring of the local socket (accepts K, M, G, T suffixes). Local clients which accept shared memory responses read their sub-volumes from the ring instead of the socket")
+        ("max-request-size", po::value<std::string>(), "Reject requests for sub-volumes larger than this size (accepts K, M, G, T suffixes)")
+        ("response-cache", po::value<std::string>(), "Cache up to this size of encoded responses, so that repeated requests are answered without resampling the volume (accepts K, M, G, T suffixes)")
         ("volpkg,v", po::value(&volpkgPaths)->multitoken()->required(), "VolumePkg path (required, repeatable option)");
 
     po::options_description all("Usage");
@@ -74,6 +81,16 @@ int main(int argc, char* argv[])
     vc::Logger()->info(
         "Server will use no more than {} bytes of memory for volumes.", memory);
 
+    // Get the cache policy
+    auto policyString = parsed["cache-policy"].as<std::string>();
+    auto cachePolicy = vc::Volume::CachePolicy::LRU;
+    if (policyString == "2q") {
+        cachePolicy = vc::Volume::CachePolicy::TwoQ;
+    } else if (policyString != "lru") {
+        vc::Logger()->error("Unknown cache policy: {}", policyString);
+        return EXIT_FAILURE;
+    }
+
     // Load the volume packages
     vc::VolumeServer::VolumePkgMap volpkgs;
     for (auto volpkgPath : volpkgPaths) {
@@ -104,7 +121,28 @@ int main(int argc, char* argv[])
 
     // Start the QtCoreApplication
     QCoreApplication application(argc, argv);
-    vc::VolumeServer server(volpkgs, port, memory);
+    auto threads = parsed["threads"].as<int>();
+    vc::VolumeServer server(volpkgs, port, memory, threads, cachePolicy);
+    server.setCacheStatsInterval(parsed["cache-stats-interval"].as<int>());
+    if (parsed.count("max-request-size") > 0) {
+        server.setMaxRequestSize(vc::MemorySizeStringParser(
+            parsed["max-request-size"].as<std::string>()));
+    }
+    if (parsed.count("response-cache") > 0) {
+        server.setResponseCacheSize(vc::MemorySizeStringParser(
+            parsed["response-cache"].as<std::string>()));
+    }
+    if (parsed.count("local") > 0) {
+        std::size_t ringBytes{0};
+        if (parsed.count("shared-memory") > 0) {
+            ringBytes = vc::MemorySizeStringParser(
+                parsed["shared-memory"].as<std::string>());
+        }
+        auto name = QString::fromStdString(parsed["local"].as<std::string>());
+        if (not server.listenLocal(name, ringBytes)) {
+            return EXIT_FAILURE;
+        }
+    }
     QObject::connect(
         &server, &vc::VolumeServer::finished, &application,
         &QCoreApplication::quit);
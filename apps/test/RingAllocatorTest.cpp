@@ -0,0 +1,85 @@
+#include <gtest/gtest.h>
+
+#include "vc/apps/server/RingAllocator.hpp"
+
+using namespace volcart;
+
+static constexpr auto A = RingAllocator::ALIGNMENT;
+
+TEST(RingAllocator, Allocate)
+{
+    RingAllocator ring(4 * A);
+    EXPECT_EQ(ring.capacity(), 4 * A);
+
+    // Regions are placed one after another and rounded up to the alignment
+    EXPECT_EQ(ring.allocate(1), 0U);
+    EXPECT_EQ(ring.allocate(A), A);
+    EXPECT_EQ(ring.allocate(A + 1), 2 * A);
+    EXPECT_EQ(ring.size(), 3U);
+    EXPECT_EQ(ring.bytes(), 4 * A);
+
+    // The ring is full
+    EXPECT_FALSE(ring.allocate(1));
+
+    // Empty and oversized regions are never allocated
+    RingAllocator empty(4 * A);
+    EXPECT_FALSE(empty.allocate(0));
+    EXPECT_FALSE(empty.allocate(4 * A + 1));
+    EXPECT_EQ(empty.allocate(4 * A), 0U);
+}
+
+TEST(RingAllocator, Wraparound)
+{
+    RingAllocator ring(4 * A);
+    auto a = ring.allocate(A);
+    auto b = ring.allocate(2 * A);
+    ASSERT_EQ(a, 0U);
+    ASSERT_EQ(b, A);
+
+    // Space at the start is used once the end does not fit
+    EXPECT_TRUE(ring.release(*a));
+    EXPECT_FALSE(ring.allocate(2 * A));
+    auto c = ring.allocate(A);
+    EXPECT_EQ(c, 3 * A);
+    auto d = ring.allocate(A);
+    EXPECT_EQ(d, 0U);
+    EXPECT_FALSE(ring.allocate(1));
+
+    // Allocation continues after the newest region
+    EXPECT_TRUE(ring.release(*b));
+    EXPECT_TRUE(ring.release(*c));
+    EXPECT_EQ(ring.allocate(A), A);
+    EXPECT_EQ(ring.allocate(A), 2 * A);
+    EXPECT_EQ(ring.allocate(A), 3 * A);
+    EXPECT_FALSE(ring.allocate(1));
+}
+
+TEST(RingAllocator, Release)
+{
+    RingAllocator ring(4 * A);
+    auto a = ring.allocate(A);
+    auto b = ring.allocate(A);
+    auto c = ring.allocate(A);
+    auto d = ring.allocate(A);
+    ASSERT_TRUE(a and b and c and d);
+
+    // Only allocated regions can be released, and only once
+    EXPECT_FALSE(ring.release(A / 2));
+    EXPECT_TRUE(ring.release(*b));
+    EXPECT_FALSE(ring.release(*b));
+    EXPECT_EQ(ring.size(), 3U);
+    EXPECT_EQ(ring.bytes(), 3 * A);
+
+    // Space released out of order is reused while an earlier region is
+    // still held
+    EXPECT_EQ(ring.allocate(A), *b);
+    EXPECT_TRUE(ring.release(*c));
+    EXPECT_TRUE(ring.release(*d));
+    EXPECT_EQ(ring.allocate(2 * A), 2 * A);
+
+    // Adjacent released regions form one free space
+    EXPECT_TRUE(ring.release(*b));
+    EXPECT_TRUE(ring.release(2 * A));
+    EXPECT_EQ(ring.allocate(3 * A), A);
+    EXPECT_EQ(ring.bytes(), 4 * A);
+}
@@ -0,0 +1,177 @@
+// Generates the synthetic datasets used by the perf_suite target
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+#include <boost/program_options.hpp>
+#include <nlohmann/json.hpp>
+#include <opencv2/core.hpp>
+
+#include "vc/core/filesystem.hpp"
+#include "vc/core/io/TIFFIO.hpp"
+#include "vc/core/shapes/Arch.hpp"
+#include "vc/core/types/VolumePkg.hpp"
+#include "vc/core/util/Logging.hpp"
+
+namespace po = boost::program_options;
+namespace fs = volcart::filesystem;
+namespace tio = volcart::tiffio;
+namespace vc = volcart;
+
+// Dataset dimensions
+struct DatasetSize {
+    int width;
+    int height;
+    int slices;
+    // Number of points in each row of the seed segmentation
+    int chainLength;
+    // Number of rows in the seed segmentation
+    int seedRows;
+    // Number of slices vc_segment propagates the seed through
+    int segmentStride;
+};
+
+static constexpr DatasetSize SMALL{256, 256, 96, 64, 8, 32};
+static constexpr DatasetSize MEDIUM{512, 512, 192, 128, 8, 64};
+
+// Every dataset is generated from the same seed
+static constexpr std::uint64_t SEED{0x5eed};
+
+// Thickness of the bright sheet in voxels
+static constexpr double SHEET_THICKNESS{4};
+
+int main(int argc, char* argv[])
+{
+    ///// Parse the command line options /////
+    // clang-format off
+    po::options_description required("General Options");
+    required.add_options()
+        ("help,h", "Show this message")
+        ("output-dir,o", po::value<std::string>()->required(),
+            "Output directory. Replaced if it already exists.")
+        ("size", po::value<std::string>()->default_value("small"),
+            "Dataset size: small, medium");
+    // clang-format on
+
+    po::variables_map parsed;
+    po::store(
+        po::command_line_parser(argc, argv).options(required).run(), parsed);
+
+    if (parsed.count("help") > 0 || argc < 2) {
+        std::cout << required << std::endl;
+        return EXIT_SUCCESS;
+    }
+
+    try {
+        po::notify(parsed);
+    } catch (po::error& e) {
+        vc::Logger()->error(e.what());
+        return EXIT_FAILURE;
+    }
+
+    DatasetSize size;
+    auto sizeName = parsed["size"].as<std::string>();
+    if (sizeName == "small") {
+        size = SMALL;
+    } else if (sizeName == "medium") {
+        size = MEDIUM;
+    } else {
+        vc::Logger()->error("Unknown dataset size: {}", sizeName);
+        return EXIT_FAILURE;
+    }
+
+    fs::path outputDir = parsed["output-dir"].as<std::string>();
+    fs::remove_all(outputDir);
+    auto slicesDir = outputDir / "slices";
+    fs::create_directories(slicesDir);
+
+    ///// Seed segmentation /////
+    // A half-pipe which runs along the z-axis through the middle of the
+    // volume. Its rows are consecutive slices.
+    const auto radius = 0.35 * std::min(size.width, size.height);
+    const cv::Vec3d center{size.width / 2.0, size.height / 4.0, 2};
+    vc::shapes::Arch arch(size.chainLength, size.seedRows);
+    auto seedPoints = arch.orderedPoints();
+    for (auto& p : seedPoints) {
+        // Arches have a radius of 5
+        p[0] = center[0] + p[0] * radius / 5;
+        p[1] = center[1] + p[1] * radius / 5;
+        p[2] = center[2] + p[2];
+    }
+
+    ///// Volume /////
+    auto vpkgPath = outputDir / "perf.volpkg";
+    auto vpkg = vc::VolumePkg::New(vpkgPath, vc::VOLPKG_VERSION_LATEST);
+    vpkg->setMetadata("name", "perf-" + sizeName);
+    vpkg->setMetadata("materialthickness", 2 * SHEET_THICKNESS);
+    vpkg->saveMetadata();
+
+    auto volume = vpkg->newVolume("Synthetic");
+    volume->setSliceWidth(size.width);
+    volume->setSliceHeight(size.height);
+    volume->setNumberOfSlices(size.slices);
+    volume->setVoxelSize(1);
+    volume->saveMetadata();
+
+    // Every slice has the same bright sheet along the arch, plus noise. This
+    // gives the segmentation algorithms a surface to follow.
+    vc::Logger()->info(
+        "Generating {} dataset: {}x{}x{}", sizeName, size.width, size.height,
+        size.slices);
+    cv::Mat sheet(size.height, size.width, CV_32FC1);
+    for (int y = 0; y < size.height; y++) {
+        for (int x = 0; x < size.width; x++) {
+            auto dist = std::abs(
+                std::hypot(x - center[0], y - center[1]) - radius);
+            auto falloff = std::exp(-std::pow(dist / SHEET_THICKNESS, 2));
+            sheet.at<float>(y, x) = static_cast<float>(8000 + 40000 * falloff);
+        }
+    }
+
+    cv::RNG rng(SEED);
+    cv::Mat noise(size.height, size.width, CV_32FC1);
+    auto numWidth = std::to_string(size.slices - 1).size();
+    for (int z = 0; z < size.slices; z++) {
+        rng.fill(noise, cv::RNG::NORMAL, 0, 1500);
+        cv::Mat slice;
+        cv::Mat(sheet + noise).convertTo(slice, CV_16UC1);
+
+        // The raw slices are the input of the vc_packager stage
+        std::stringstream name;
+        name << std::setw(numWidth) << std::setfill('0') << z << ".tif";
+        tio::WriteTIFF(slicesDir / name.str(), slice);
+        volume->setSliceData(z, slice);
+    }
+
+    ///// Segmentation /////
+    auto seg = vpkg->newSegmentation("perf");
+    seg->setVolumeID(volume->id());
+    seg->setPointSet(seedPoints);
+    seg->saveMetadata();
+
+    ///// Dataset description /////
+    // Read by the perf suite to build the stage command lines
+    nlohmann::json meta{
+        {"size", sizeName},
+        {"width", size.width},
+        {"height", size.height},
+        {"slices", size.slices},
+        {"volpkg", vpkgPath.filename().string()},
+        {"slicesDir", slicesDir.filename().string()},
+        {"segmentation", seg->id()},
+        {"segmentStride", size.segmentStride}};
+    std::ofstream metaFile((outputDir / "dataset.json").string());
+    metaFile << meta.dump(4) << "\n";
+    if (not metaFile) {
+        vc::Logger()->error("Failed to write dataset description");
+        return EXIT_FAILURE;
+    }
+
+    vc::Logger()->info("Wrote dataset: {}", outputDir.string());
+    return EXIT_SUCCESS;
+}
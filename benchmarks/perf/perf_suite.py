@@ -0,0 +1,276 @@
+#!/usr/bin/env python3
+'''
+End-to-end performance suite.
+
+Generates synthetic datasets with vc_perf_data, runs scripted vc_packager,
+vc_render, and vc_segment stages on them, and writes a JSON report of the
+wall time, peak RSS, and slice cache hit rate of every stage. Reports from
+two builds can be compared to gate changes on stage slowdowns:
+
+    perf_suite.py run --bin-dir build/bin --output new.json
+    perf_suite.py compare baseline.json new.json --max-slowdown 0.10
+'''
+
+import argparse
+import json
+import logging
+import os
+import platform
+import re
+import shutil
+import statistics
+import subprocess
+import sys
+import tempfile
+import time
+from typing import Any, Dict, List, Optional
+
+REPORT_VERSION = 1
+
+# Matches the cache statistics which the apps log on exit
+CACHE_STATS_RE = re.compile(r'Final cache stats: .*?hit rate: ([0-9.]+)%')
+
+
+def peak_rss_bytes(rusage: Any) -> int:
+    '''
+    ru_maxrss is in bytes on macOS and in kilobytes elsewhere
+    '''
+    if sys.platform == 'darwin':
+        return rusage.ru_maxrss
+    return rusage.ru_maxrss * 1024
+
+
+def run_stage(cmd: List[str], cwd: str, log_path: str,
+              stdin: Optional[str] = None) -> Dict[str, Any]:
+    '''
+    Run one stage and measure its wall time and peak RSS. The output of the
+    stage is written to log_path.
+    '''
+    logging.debug(f'Running: {" ".join(cmd)}')
+    with open(log_path, 'w') as log:
+        start = time.perf_counter()
+        proc = subprocess.Popen(cmd, cwd=cwd, stdin=subprocess.PIPE,
+                                stdout=log, stderr=subprocess.STDOUT,
+                                text=True)
+        if stdin is not None:
+            proc.stdin.write(stdin)
+        proc.stdin.close()
+
+        # Reap the process ourselves to get its own resource usage
+        _, status, rusage = os.wait4(proc.pid, 0)
+        wall = time.perf_counter() - start
+        proc.returncode = os.waitstatus_to_exitcode(status)
+
+    with open(log_path) as log:
+        matches = CACHE_STATS_RE.findall(log.read())
+    hit_rate = float(matches[-1]) / 100 if matches else None
+    return {
+        'exit_code': proc.returncode,
+        'wall_seconds': wall,
+        'peak_rss_bytes': peak_rss_bytes(rusage),
+        'cache_hit_rate': hit_rate,
+    }
+
+
+def stage_commands(bin_dir: str, data_dir: str,
+                   dataset: Dict[str, Any]) -> List[Dict[str, Any]]:
+    '''
+    Get the scripted command lines of every stage, in execution order.
+    vc_segment extends the segmentation in place, so it runs last.
+    '''
+    def exe(name: str) -> str:
+        return os.path.join(bin_dir, name)
+
+    volpkg = os.path.join(data_dir, dataset['volpkg'])
+    seg = dataset['segmentation']
+    return [
+        {
+            'name': 'packager',
+            'cmd': [exe('vc_packager'),
+                    '-v', os.path.join(data_dir, 'packaged.volpkg'),
+                    '-m', '8',
+                    '-s', os.path.join(data_dir, dataset['slicesDir'])],
+            # Volume name, voxel size, no flip, no compression
+            'stdin': 'packaged\n1\n\nn\n',
+        },
+        {
+            'name': 'render',
+            'cmd': [exe('vc_render'), '-v', volpkg, '-s', seg,
+                    '-o', os.path.join(data_dir, 'render.obj'),
+                    '--reuse-outputs', 'false'],
+        },
+        {
+            'name': 'segment',
+            'cmd': [exe('vc_segment'), '-v', volpkg, '-s', seg,
+                    '-m', 'LRPS',
+                    '--stride', str(dataset['segmentStride'])],
+        },
+    ]
+
+
+def run_suite(args: argparse.Namespace) -> int:
+    work_dir = args.work_dir or tempfile.mkdtemp(prefix='vc_perf_')
+    os.makedirs(work_dir, exist_ok=True)
+
+    # Wall time samples of every stage, keyed by "<dataset>/<stage>"
+    samples: Dict[str, List[Dict[str, Any]]] = {}
+    failed = False
+    for size in args.datasets:
+        for rep in range(args.repeat):
+            # Regenerate the dataset every repetition, since vc_segment
+            # modifies it. Generation is not timed.
+            data_dir = os.path.join(work_dir, size)
+            gen = subprocess.run(
+                [args.generator or os.path.join(args.bin_dir, 'vc_perf_data'),
+                 '-o', data_dir, '--size', size],
+                stdout=subprocess.PIPE, stderr=subprocess.STDOUT, text=True)
+            if gen.returncode != 0:
+                logging.error(f'Failed to generate {size} dataset:\n'
+                              f'{gen.stdout}')
+                return 1
+            with open(os.path.join(data_dir, 'dataset.json')) as f:
+                dataset = json.load(f)
+
+            for stage in stage_commands(args.bin_dir, data_dir, dataset):
+                key = f'{size}/{stage["name"]}'
+                log_path = os.path.join(
+                    work_dir, f'{size}-{stage["name"]}-{rep}.log')
+                result = run_stage(stage['cmd'], data_dir, log_path,
+                                   stage.get('stdin'))
+                samples.setdefault(key, []).append(result)
+                logging.info(f'{key} [{rep + 1}/{args.repeat}]: '
+                             f'{result["wall_seconds"]:.2f}s')
+                if result['exit_code'] != 0:
+                    logging.error(f'{key} failed with exit code '
+                                  f'{result["exit_code"]}. See {log_path}')
+                    failed = True
+
+    # The median wall time is robust to a single slow repetition
+    stages = {}
+    for key, results in samples.items():
+        walls = [r['wall_seconds'] for r in results]
+        rates = [r['cache_hit_rate'] for r in results
+                 if r['cache_hit_rate'] is not None]
+        stages[key] = {
+            'wall_seconds': statistics.median(walls),
+            'wall_seconds_samples': walls,
+            'peak_rss_bytes': max(r['peak_rss_bytes'] for r in results),
+            'cache_hit_rate': statistics.median(rates) if rates else None,
+            'exit_code': max(r['exit_code'] for r in results),
+        }
+
+    report = {
+        'version': REPORT_VERSION,
+        'repeat': args.repeat,
+        'host': {
+            'platform': platform.platform(),
+            'processor': platform.processor(),
+            'cpus': os.cpu_count(),
+        },
+        'stages': stages,
+    }
+    with open(args.output, 'w') as f:
+        json.dump(report, f, indent=2, sort_keys=True)
+        f.write('\n')
+    logging.info(f'Wrote report: {args.output}')
+
+    if not args.keep_data and args.work_dir is None:
+        shutil.rmtree(work_dir, ignore_errors=True)
+
+    if failed:
+        return 1
+    if args.baseline:
+        return compare_reports(args.baseline, args.output, args.max_slowdown)
+    return 0
+
+
+def compare_reports(baseline_path: str, current_path: str,
+                    max_slowdown: float) -> int:
+    '''
+    Print the change of every stage between two reports. Returns non-zero if
+    any stage failed, is missing, or got slower than max_slowdown.
+    '''
+    with open(baseline_path) as f:
+        baseline = json.load(f)['stages']
+    with open(current_path) as f:
+        current = json.load(f)['stages']
+
+    def mb(b: int) -> float:
+        return b / (1024 * 1024)
+
+    regressions = []
+    print(f'{"Stage":<20}{"Base (s)":>10}{"New (s)":>10}{"Change":>9}'
+          f'{"Base RSS (MB)":>15}{"New RSS (MB)":>14}')
+    for key in sorted(baseline):
+        base = baseline[key]
+        if key not in current:
+            print(f'{key:<20}{"missing":>10}')
+            regressions.append(key)
+            continue
+        cur = current[key]
+        change = cur['wall_seconds'] / base['wall_seconds'] - 1
+        flag = ''
+        if cur['exit_code'] != 0:
+            flag = '  FAILED'
+        elif change > max_slowdown:
+            flag = '  SLOWER'
+        if flag:
+            regressions.append(key)
+        print(f'{key:<20}{base["wall_seconds"]:>10.2f}'
+              f'{cur["wall_seconds"]:>10.2f}{change:>+9.1%}'
+              f'{mb(base["peak_rss_bytes"]):>15.1f}'
+              f'{mb(cur["peak_rss_bytes"]):>14.1f}{flag}')
+
+    if regressions:
+        print(f'{len(regressions)} stage(s) regressed by more than '
+              f'{max_slowdown:.0%}: {", ".join(regressions)}')
+        return 1
+    return 0
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(
+        description=__doc__,
+        formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('--verbose', '-v', action='store_true')
+    sub = parser.add_subparsers(dest='command', required=True)
+
+    run = sub.add_parser('run', help='Run the suite and write a report')
+    run.add_argument('--bin-dir', required=True,
+                     help='Directory containing the VC executables')
+    run.add_argument('--generator',
+                     help='Path to vc_perf_data. Default: In --bin-dir')
+    run.add_argument('--output', '-o', default='perf_report.json',
+                     help='Output report path')
+    run.add_argument('--datasets', nargs='+', default=['small', 'medium'],
+                     choices=['small', 'medium'])
+    run.add_argument('--repeat', type=int, default=3,
+                     help='Number of runs of every stage')
+    run.add_argument('--work-dir',
+                     help='Directory for the datasets and stage logs. '
+                          'Default: a temporary directory which is removed')
+    run.add_argument('--keep-data', action='store_true',
+                     help='Keep the temporary datasets and stage logs')
+    run.add_argument('--baseline',
+                     help='Compare the new report against this report')
+    run.add_argument('--max-slowdown', type=float, default=0.10,
+                     help='Maximum allowed relative slowdown of any stage')
+
+    compare = sub.add_parser('compare', help='Compare two reports')
+    compare.add_argument('baseline')
+    compare.add_argument('current')
+    compare.add_argument('--max-slowdown', type=float, default=0.10,
+                         help='Maximum allowed relative slowdown of any stage')
+
+    args = parser.parse_args()
+    logging.basicConfig(
+        format='[%(levelname)s] %(message)s',
+        level=logging.DEBUG if args.verbose else logging.INFO)
+
+    if args.command == 'run':
+        return run_suite(args)
+    return compare_reports(args.baseline, args.current, args.max_slowdown)
+
+
+if __name__ == '__main__':
+    sys.exit(main())
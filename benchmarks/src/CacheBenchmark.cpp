@@ -0,0 +1,48 @@
+#include <benchmark/benchmark.h>
+
+#include "vc/core/types/LRUCache.hpp"
+#include "vc/core/types/ShardedCache.hpp"
+
+using namespace volcart;
+
+static constexpr int CACHE_CAPACITY = 1024;
+
+static void BM_LRUCacheGet(benchmark::State& state)
+{
+    LRUCache<int, int> cache(CACHE_CAPACITY);
+    for (int i = 0; i < CACHE_CAPACITY; i++) {
+        cache.put(i, i);
+    }
+    int k{0};
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(cache.get(k));
+        k = (k + 1) % CACHE_CAPACITY;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_LRUCacheGet);
+
+static void BM_LRUCachePutEvict(benchmark::State& state)
+{
+    LRUCache<int, int> cache(CACHE_CAPACITY);
+    int k{0};
+    for (auto _ : state) {
+        cache.put(k, k);
+        k++;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_LRUCachePutEvict);
+
+static void BM_ShardedCacheGetOrLoad(benchmark::State& state)
+{
+    static ShardedCache<int, int> cache(CACHE_CAPACITY);
+    int k{static_cast<int>(state.thread_index())};
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(
+            cache.getOrLoad(k % (2 * CACHE_CAPACITY), [k]() { return k; }));
+        k += static_cast<int>(state.threads());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ShardedCacheGetOrLoad)->ThreadRange(1, 8);
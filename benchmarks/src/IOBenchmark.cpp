@@ -0,0 +1,149 @@
+#include <cstdint>
+
+#include <benchmark/benchmark.h>
+
+#include "SyntheticData.hpp"
+#include "vc/core/io/OBJReader.hpp"
+#include "vc/core/io/OBJWriter.hpp"
+#include "vc/core/io/PLYReader.hpp"
+#include "vc/core/io/PLYWriter.hpp"
+#include "vc/core/io/TIFFIO.hpp"
+
+using namespace volcart;
+using namespace volcart::benchmarks;
+namespace tio = volcart::tiffio;
+
+static constexpr std::size_t PPM_SIZE = 512;
+static constexpr int MESH_SIZE = 200;
+
+// Arguments: PerPixelMap::Format
+static void BM_PPMWrite(benchmark::State& state)
+{
+    auto ppm = SyntheticPPM(PPM_SIZE, PPM_SIZE);
+    auto format = static_cast<PerPixelMap::Format>(state.range(0));
+    auto path = ScratchDir() / "write.ppm";
+    for (auto _ : state) {
+        PerPixelMap::WritePPM(path, ppm, format);
+    }
+    state.SetItemsProcessed(state.iterations() * PPM_SIZE * PPM_SIZE);
+}
+BENCHMARK(BM_PPMWrite)
+    ->Arg(static_cast<int>(PerPixelMap::Format::Dense))
+    ->Arg(static_cast<int>(PerPixelMap::Format::Compact));
+
+// Arguments: PerPixelMap::Format
+static void BM_PPMRead(benchmark::State& state)
+{
+    auto format = static_cast<PerPixelMap::Format>(state.range(0));
+    auto path = ScratchDir() / "read.ppm";
+    PerPixelMap::WritePPM(path, SyntheticPPM(PPM_SIZE, PPM_SIZE), format);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(PerPixelMap::ReadPPM(path));
+    }
+    state.SetItemsProcessed(state.iterations() * PPM_SIZE * PPM_SIZE);
+}
+BENCHMARK(BM_PPMRead)
+    ->Arg(static_cast<int>(PerPixelMap::Format::Dense))
+    ->Arg(static_cast<int>(PerPixelMap::Format::Compact));
+
+// Arguments: Number of parser threads (0 = hardware threads)
+static void BM_OBJReader(benchmark::State& state)
+{
+    auto mesh = SyntheticMesh(MESH_SIZE, MESH_SIZE);
+    auto path = ScratchDir() / "mesh.obj";
+    io::OBJWriter writer;
+    writer.setPath(path);
+    writer.setMesh(mesh);
+    writer.write();
+
+    for (auto _ : state) {
+        io::OBJReader reader;
+        reader.setPath(path);
+        reader.setNumThreads(state.range(0));
+        benchmark::DoNotOptimize(reader.read());
+    }
+    state.SetItemsProcessed(state.iterations() * mesh->GetNumberOfPoints());
+}
+BENCHMARK(BM_OBJReader)->Arg(1)->Arg(0);
+
+// Arguments: Number of parser threads (0 = hardware threads)
+static void BM_PLYReader(benchmark::State& state)
+{
+    auto mesh = SyntheticMesh(MESH_SIZE, MESH_SIZE);
+    auto path = ScratchDir() / "mesh.ply";
+    io::PLYWriter writer;
+    writer.setPath(path);
+    writer.setMesh(mesh);
+    writer.write();
+
+    for (auto _ : state) {
+        io::PLYReader reader(path);
+        reader.setNumThreads(state.range(0));
+        benchmark::DoNotOptimize(reader.read());
+    }
+    state.SetItemsProcessed(state.iterations() * mesh->GetNumberOfPoints());
+}
+BENCHMARK(BM_PLYReader)->Arg(1)->Arg(0);
+
+// Arguments: tiffio::Compression
+static void SliceCodecs(benchmark::internal::Benchmark* bm)
+{
+    for (auto c :
+         {tio::Compression::NONE, tio::Compression::LZW,
+          tio::Compression::ADOBE_DEFLATE, tio::Compression::LZMA,
+          tio::Compression::ZSTD}) {
+        bm->Arg(static_cast<int>(c));
+    }
+}
+
+// Write a synthetic slice with a compression scheme. Returns false if the
+// scheme is not available.
+static auto WriteSlice(
+    benchmark::State& state, const filesystem::path& path, cv::Mat& slice)
+    -> bool
+{
+    auto c = static_cast<tio::Compression>(state.range(0));
+    if (not tio::CompressionAvailable(c)) {
+        state.SkipWithError("Compression not supported by libtiff");
+        return false;
+    }
+    slice = SyntheticVolume()->getSliceDataCopy(VOLUME_SLICES / 2);
+    tio::WriteTIFF(path, slice, c);
+    return true;
+}
+
+// Reports the compressed size relative to the raw slice as "ratio"
+static void BM_SliceWrite(benchmark::State& state)
+{
+    auto path = ScratchDir() / "write.tif";
+    cv::Mat slice;
+    if (not WriteSlice(state, path, slice)) {
+        return;
+    }
+    auto c = static_cast<tio::Compression>(state.range(0));
+    for (auto _ : state) {
+        tio::WriteTIFF(path, slice, c);
+    }
+    auto bytes = static_cast<double>(slice.total() * slice.elemSize());
+    state.SetBytesProcessed(
+        state.iterations() * static_cast<std::int64_t>(bytes));
+    state.counters["ratio"] = filesystem::file_size(path) / bytes;
+}
+BENCHMARK(BM_SliceWrite)->Apply(SliceCodecs);
+
+// Decoding is most of the cost of a slice cache miss on a local disk
+static void BM_SliceRead(benchmark::State& state)
+{
+    auto path = ScratchDir() / "read.tif";
+    cv::Mat slice;
+    if (not WriteSlice(state, path, slice)) {
+        return;
+    }
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(tio::ReadTIFF(path));
+    }
+    state.SetBytesProcessed(
+        state.iterations() *
+        static_cast<std::int64_t>(slice.total() * slice.elemSize()));
+}
+BENCHMARK(BM_SliceRead)->Apply(SliceCodecs);
@@ -0,0 +1,88 @@
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <opencv2/core.hpp>
+
+#include "SyntheticData.hpp"
+#include "vc/core/neighborhood/CuboidGenerator.hpp"
+#include "vc/core/neighborhood/LineGenerator.hpp"
+
+using namespace volcart;
+using namespace volcart::benchmarks;
+
+static const cv::Vec3d CENTER{
+    VOLUME_WIDTH / 2., VOLUME_HEIGHT / 2., VOLUME_SLICES / 2.};
+
+static void BM_LineGenerator(benchmark::State& state)
+{
+    auto vol = SyntheticVolume();
+    LineGenerator gen;
+    gen.setSamplingRadius(static_cast<double>(state.range(0)));
+    std::vector<cv::Vec3d> axes{cv::normalize(cv::Vec3d{1, 1, 1})};
+    gen.compute(vol, CENTER, axes);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(gen.compute(vol, CENTER, axes));
+    }
+    state.SetItemsProcessed(state.iterations() * (2 * state.range(0) + 1));
+}
+BENCHMARK(BM_LineGenerator)->Arg(8)->Arg(64);
+
+// Arguments: radius, whether the bases are axis-aligned
+static void BM_CuboidGenerator(benchmark::State& state)
+{
+    auto vol = SyntheticVolume();
+    auto r = static_cast<double>(state.range(0));
+    CuboidGenerator gen;
+    gen.setSamplingRadius(r, r, r);
+
+    std::vector<cv::Vec3d> axes{{0, 0, 1}, {0, 1, 0}, {1, 0, 0}};
+    if (state.range(1) == 0) {
+        axes = {
+            cv::normalize(cv::Vec3d{1, 1, 1}),
+            cv::normalize(cv::Vec3d{1, -1, 0}),
+            cv::normalize(cv::Vec3d{1, 1, -2})};
+    }
+    gen.compute(vol, CENTER, axes);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(gen.compute(vol, CENTER, axes));
+    }
+    auto side = 2 * state.range(0) + 1;
+    state.SetItemsProcessed(state.iterations() * side * side * side);
+}
+BENCHMARK(BM_CuboidGenerator)
+    ->ArgNames({"radius", "aligned"})
+    ->Args({8, 0})
+    ->Args({8, 1})
+    ->Args({32, 0})
+    ->Args({32, 1});
+
+// Arguments: radius, whether the bases are axis-aligned
+static void BM_CuboidGeneratorPrecomputed(benchmark::State& state)
+{
+    auto vol = SyntheticVolume();
+    auto r = static_cast<double>(state.range(0));
+    CuboidGenerator gen;
+    gen.setSamplingRadius(r, r, r);
+
+    std::vector<cv::Vec3d> axes{{0, 0, 1}, {0, 1, 0}, {1, 0, 0}};
+    if (state.range(1) == 0) {
+        axes = {
+            cv::normalize(cv::Vec3d{1, 1, 1}),
+            cv::normalize(cv::Vec3d{1, -1, 0}),
+            cv::normalize(cv::Vec3d{1, 1, -2})};
+    }
+    auto offsets = gen.precompute(axes);
+    std::vector<uint16_t> out(offsets.samples.size());
+    for (auto _ : state) {
+        gen.computeInto(vol, CENTER, offsets, out.data());
+        benchmark::DoNotOptimize(out.data());
+    }
+    auto side = 2 * state.range(0) + 1;
+    state.SetItemsProcessed(state.iterations() * side * side * side);
+}
+BENCHMARK(BM_CuboidGeneratorPrecomputed)
+    ->ArgNames({"radius", "aligned"})
+    ->Args({8, 0})
+    ->Args({8, 1})
+    ->Args({32, 0})
+    ->Args({32, 1});
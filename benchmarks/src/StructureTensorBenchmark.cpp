@@ -0,0 +1,30 @@
+#include <benchmark/benchmark.h>
+#include <opencv2/core.hpp>
+
+#include "SyntheticData.hpp"
+#include "vc/core/math/StructureTensor.hpp"
+
+using namespace volcart;
+using namespace volcart::benchmarks;
+
+// Arguments: radius, kernel size
+static void BM_ComputeSubvoxelStructureTensor(benchmark::State& state)
+{
+    auto vol = SyntheticVolume();
+    auto radius = static_cast<int>(state.range(0));
+    auto kernel = static_cast<int>(state.range(1));
+    cv::Vec3d pt{
+        VOLUME_WIDTH / 2. + 0.25, VOLUME_HEIGHT / 2. + 0.5,
+        VOLUME_SLICES / 2. + 0.75};
+    ComputeSubvoxelStructureTensor(vol, pt, radius, kernel);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(
+            ComputeSubvoxelStructureTensor(vol, pt, radius, kernel));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ComputeSubvoxelStructureTensor)
+    ->ArgNames({"radius", "kernel"})
+    ->Args({1, 3})
+    ->Args({3, 3})
+    ->Args({3, 5});
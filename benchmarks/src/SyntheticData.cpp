@@ -0,0 +1,84 @@
+#include "SyntheticData.hpp"
+
+#include <cmath>
+#include <cstdlib>
+#include <mutex>
+
+#include <opencv2/core.hpp>
+
+#include "vc/core/shapes/Plane.hpp"
+
+namespace fs = volcart::filesystem;
+
+using namespace volcart;
+using namespace volcart::benchmarks;
+
+auto benchmarks::ScratchDir() -> fs::path
+{
+    static const auto dir = []() {
+        auto d = fs::temp_directory_path() / "vc_benchmarks";
+        fs::remove_all(d);
+        fs::create_directories(d);
+        std::atexit([]() {
+            std::error_code ec;
+            fs::remove_all(fs::temp_directory_path() / "vc_benchmarks", ec);
+        });
+        return d;
+    }();
+    return dir;
+}
+
+auto benchmarks::SyntheticVolume() -> Volume::Pointer
+{
+    static std::once_flag written;
+    auto path = ScratchDir() / "volume";
+    std::call_once(written, [&path]() {
+        fs::create_directories(path);
+        auto vol = Volume::New(path, "Synthetic", "Synthetic");
+        vol->setSliceWidth(VOLUME_WIDTH);
+        vol->setSliceHeight(VOLUME_HEIGHT);
+        vol->setNumberOfSlices(VOLUME_SLICES);
+        vol->setVoxelSize(1);
+        vol->saveMetadata();
+
+        cv::RNG rng(0);
+        cv::Mat noise(VOLUME_HEIGHT, VOLUME_WIDTH, CV_32FC1);
+        for (int z = 0; z < VOLUME_SLICES; z++) {
+            rng.fill(noise, cv::RNG::NORMAL, 0, 500);
+            cv::Mat slice(VOLUME_HEIGHT, VOLUME_WIDTH, CV_16UC1);
+            for (int y = 0; y < VOLUME_HEIGHT; y++) {
+                for (int x = 0; x < VOLUME_WIDTH; x++) {
+                    auto v = 32768 + 16000 * std::sin(x / 8.0) *
+                                         std::cos(y / 11.0) *
+                                         std::sin(z / 5.0);
+                    slice.at<uint16_t>(y, x) = cv::saturate_cast<uint16_t>(
+                        v + noise.at<float>(y, x));
+                }
+            }
+            vol->setSliceData(z, slice);
+        }
+    });
+    return Volume::New(path);
+}
+
+auto benchmarks::SyntheticMesh(int width, int height) -> ITKMesh::Pointer
+{
+    shapes::Plane plane(width, height);
+    return plane.itkMesh();
+}
+
+auto benchmarks::SyntheticPPM(std::size_t height, std::size_t width)
+    -> PerPixelMap
+{
+    PerPixelMap ppm(height, width);
+    auto h = static_cast<int>(height);
+    auto w = static_cast<int>(width);
+    ppm.setMask(cv::Mat(h, w, CV_8UC1, cv::Scalar(255)));
+    for (std::size_t y = 0; y < height; y++) {
+        for (std::size_t x = 0; x < width; x++) {
+            auto z = 64 + 8 * std::sin(x / 32.0);
+            ppm(y, x) = {double(x), double(y), z, 0, 0, 1};
+        }
+    }
+    return ppm;
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+/** @file */
+
+#include "vc/core/filesystem.hpp"
+#include "vc/core/types/ITKMesh.hpp"
+#include "vc/core/types/PerPixelMap.hpp"
+#include "vc/core/types/Volume.hpp"
+
+namespace volcart::benchmarks
+{
+
+/** Synthetic volume dimensions */
+constexpr int VOLUME_WIDTH = 256;
+constexpr int VOLUME_HEIGHT = 256;
+constexpr int VOLUME_SLICES = 128;
+
+/**
+ * @brief Get the scratch directory for benchmark data
+ *
+ * The directory is created inside the system temporary directory on first
+ * use and removed when the program exits.
+ */
+auto ScratchDir() -> filesystem::path;
+
+/**
+ * @brief Get a synthetic Slices-format volume
+ *
+ * The volume is written to the scratch directory on first use. Its intensity
+ * is a smooth, periodic pattern with added noise. Every call returns a
+ * freshly loaded Volume, so that benchmarks do not share cache state.
+ */
+auto SyntheticVolume() -> Volume::Pointer;
+
+/** @brief Get a planar, triangulated mesh with `width * height` vertices */
+auto SyntheticMesh(int width, int height) -> ITKMesh::Pointer;
+
+/**
+ * @brief Get a PPM with every pixel mapped
+ *
+ * The mapped positions lie on a gently curved surface inside the synthetic
+ * volume.
+ */
+auto SyntheticPPM(std::size_t height, std::size_t width) -> PerPixelMap;
+
+}  // namespace volcart::benchmarks
@@ -0,0 +1,145 @@
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <opencv2/core.hpp>
+
+#include "SyntheticData.hpp"
+
+using namespace volcart;
+using namespace volcart::benchmarks;
+
+namespace
+{
+// Random subvoxel positions inside the synthetic volume
+auto RandomPoints(std::size_t n) -> std::vector<cv::Vec3d>
+{
+    cv::RNG rng(42);
+    std::vector<cv::Vec3d> pts;
+    pts.reserve(n);
+    for (std::size_t i = 0; i < n; i++) {
+        pts.emplace_back(
+            rng.uniform(0., VOLUME_WIDTH - 1.),
+            rng.uniform(0., VOLUME_HEIGHT - 1.),
+            rng.uniform(0., VOLUME_SLICES - 1.));
+    }
+    return pts;
+}
+}  // namespace
+
+static void BM_VolumeInterpolateAt(benchmark::State& state)
+{
+    auto vol = SyntheticVolume();
+    auto pts = RandomPoints(static_cast<std::size_t>(state.range(0)));
+    vol->interpolateAt(pts);
+    for (auto _ : state) {
+        for (const auto& p : pts) {
+            benchmark::DoNotOptimize(vol->interpolateAt(p));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_VolumeInterpolateAt)->Arg(1 << 10)->Arg(1 << 16);
+
+static void BM_VolumeInterpolateAtBatch(benchmark::State& state)
+{
+    auto vol = SyntheticVolume();
+    auto pts = RandomPoints(static_cast<std::size_t>(state.range(0)));
+    std::vector<uint16_t> out(pts.size());
+    vol->interpolateAt(pts);
+    for (auto _ : state) {
+        vol->interpolateAt(pts.data(), pts.size(), out.data());
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_VolumeInterpolateAtBatch)->Arg(1 << 10)->Arg(1 << 16);
+
+// Arguments: Volume::Interpolation
+static void BM_VolumeInterpolateKernel(benchmark::State& state)
+{
+    auto vol = SyntheticVolume();
+    auto method = static_cast<Volume::Interpolation>(state.range(0));
+    auto pts = RandomPoints(1 << 16);
+    std::vector<uint16_t> out(pts.size());
+    vol->interpolateAt(pts.data(), pts.size(), out.data(), method);
+    for (auto _ : state) {
+        vol->interpolateAt(pts.data(), pts.size(), out.data(), method);
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetItemsProcessed(state.iterations() * pts.size());
+}
+BENCHMARK(BM_VolumeInterpolateKernel)
+    ->Arg(static_cast<int>(Volume::Interpolation::Nearest))
+    ->Arg(static_cast<int>(Volume::Interpolation::Trilinear))
+    ->Arg(static_cast<int>(Volume::Interpolation::Tricubic));
+
+static void BM_VolumeReslice(benchmark::State& state)
+{
+    auto vol = SyntheticVolume();
+    auto size = static_cast<int>(state.range(0));
+    cv::Vec3d center{VOLUME_WIDTH / 2., VOLUME_HEIGHT / 2., VOLUME_SLICES / 2.};
+
+    // Oblique plane which crosses many slices
+    auto xvec = cv::normalize(cv::Vec3d{1, 0, 1});
+    auto yvec = cv::normalize(cv::Vec3d{0, 1, 1});
+    vol->reslice(center, xvec, yvec, size, size);
+    for (auto _ : state) {
+        auto r = vol->reslice(center, xvec, yvec, size, size);
+        benchmark::DoNotOptimize(r);
+    }
+    state.SetItemsProcessed(state.iterations() * size * size);
+}
+BENCHMARK(BM_VolumeReslice)->Arg(64)->Arg(256);
+
+// Arguments: Number of planes. Planes along a curve, like the particles of
+// the LRPS segmentation.
+static void BM_VolumeResliceBatch(benchmark::State& state)
+{
+    auto vol = SyntheticVolume();
+    auto n = static_cast<std::size_t>(state.range(0));
+    constexpr int SIZE{32};
+    std::vector<Volume::ResliceFrame> frames;
+    for (std::size_t i = 0; i < n; i++) {
+        auto t = static_cast<double>(i) / n;
+        cv::Vec3d center{
+            SIZE + t * (VOLUME_WIDTH - 2 * SIZE), VOLUME_HEIGHT / 2.,
+            VOLUME_SLICES / 2.};
+        frames.push_back({center, cv::Vec3d{0, 1, 0}, cv::Vec3d{0, 0, 1}});
+    }
+    for (auto _ : state) {
+        auto r = vol->reslice(frames, SIZE, SIZE);
+        benchmark::DoNotOptimize(r);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0) * SIZE * SIZE);
+}
+BENCHMARK(BM_VolumeResliceBatch)->Arg(64)->Arg(512);
+
+static void BM_VolumeSliceCached(benchmark::State& state)
+{
+    auto vol = SyntheticVolume();
+    for (int z = 0; z < VOLUME_SLICES; z++) {
+        vol->getSliceData(z);
+    }
+    int z{0};
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(vol->getSliceData(z));
+        z = (z + 1) % VOLUME_SLICES;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_VolumeSliceCached);
+
+static void BM_VolumeSliceUncached(benchmark::State& state)
+{
+    auto vol = SyntheticVolume();
+    vol->setCacheSlices(false);
+    int z{0};
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(vol->getSliceData(z));
+        z = (z + 1) % VOLUME_SLICES;
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.SetBytesProcessed(
+        state.iterations() * VOLUME_WIDTH * VOLUME_HEIGHT * sizeof(uint16_t));
+}
+BENCHMARK(BM_VolumeSliceUncached);
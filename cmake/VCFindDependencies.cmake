@@ -28,7 +28,9 @@ list(APPEND VC_CUSTOM_MODULES "${CMAKE_MODULE_PATH}/FindFilesystem.cmake")
 
 ### Qt6 ###
 if((VC_BUILD_APPS OR VC_BUILD_UTILS) AND VC_BUILD_GUI)
-    find_package(Qt6 6.3 QUIET REQUIRED COMPONENTS Widgets Gui Core Network)
+    find_package(Qt6 6.3 QUIET REQUIRED COMPONENTS
+        Widgets Gui Core Network OpenGL OpenGLWidgets
+    )
     qt_standard_project_setup()
 endif()
 
@@ -110,6 +112,77 @@ if(VC_BUILD_TESTS)
     endif()
 endif()
 
+### Google Benchmark ###
+if(VC_BUILD_BENCHMARKS)
+    FetchContent_Declare(
+        googlebenchmark
+        GIT_REPOSITORY https://github.com/google/benchmark.git
+        GIT_TAG        v1.8.3
+    )
+
+    FetchContent_GetProperties(googlebenchmark)
+    if(NOT googlebenchmark_POPULATED)
+        set(BENCHMARK_ENABLE_TESTING OFF CACHE BOOL "" FORCE)
+        set(BENCHMARK_ENABLE_INSTALL OFF CACHE BOOL "" FORCE)
+        FetchContent_Populate(googlebenchmark)
+        add_subdirectory(${googlebenchmark_SOURCE_DIR} ${googlebenchmark_BINARY_DIR} EXCLUDE_FROM_ALL)
+    endif()
+endif()
+
+### Sparse solvers ###
+# Multithreads Eigen's iterative solvers
+option(VC_USE_OPENMP "Enable OpenMP multithreading in Eigen" OFF)
+if(VC_USE_OPENMP)
+    find_package(OpenMP REQUIRED COMPONENTS CXX)
+endif()
+
+# Adds the CHOLMOD LSCM solver
+option(VC_USE_CHOLMOD "Use SuiteSparse CHOLMOD for LSCM" OFF)
+if(VC_USE_CHOLMOD)
+    find_package(CHOLMOD CONFIG REQUIRED)
+endif()
+
+### GPU texturing ###
+# Adds the CUDA backend for the line texturing algorithms
+option(VC_WITH_CUDA "Build the CUDA texturing backend" OFF)
+if(VC_WITH_CUDA)
+    enable_language(CUDA)
+    set(CMAKE_CUDA_STANDARD 17)
+    set(CMAKE_CUDA_STANDARD_REQUIRED ON)
+    find_package(CUDAToolkit REQUIRED)
+endif()
+
+### GPU optical flow ###
+# Adds the CUDA optical flow backend for OpticalFlowSegmentation. Requires an
+# OpenCV build which includes the CUDA contrib modules.
+option(VC_WITH_OPENCV_CUDA "Use OpenCV's CUDA optical flow in segmentation" OFF)
+if(VC_WITH_OPENCV_CUDA AND NOT TARGET opencv_cudaoptflow)
+    message(FATAL_ERROR "VC_WITH_OPENCV_CUDA requires OpenCV with the cudaoptflow module")
+endif()
+
+### Remote volumes ###
+# Adds the HTTP/S3 volume source
+option(VC_WITH_CURL "Read volumes from HTTP servers with libcurl" OFF)
+if(VC_WITH_CURL)
+    find_package(CURL REQUIRED)
+endif()
+
+### Chunked volumes ###
+# zlib is always available since libtiff depends on it
+find_package(ZLIB REQUIRED)
+
+# Adds the zstd and blosc Zarr/N5 chunk codecs
+option(VC_WITH_ZSTD "Read zstd-compressed Zarr and N5 chunks" OFF)
+if(VC_WITH_ZSTD)
+    find_path(ZSTD_INCLUDE_DIR zstd.h REQUIRED)
+    find_library(ZSTD_LIBRARY zstd REQUIRED)
+endif()
+option(VC_WITH_BLOSC "Read blosc-compressed Zarr and N5 chunks" OFF)
+if(VC_WITH_BLOSC)
+    find_path(BLOSC_INCLUDE_DIR blosc.h REQUIRED)
+    find_library(BLOSC_LIBRARY blosc REQUIRED)
+endif()
+
 # Python bindings
 if(VC_BUILD_PYTHON_BINDINGS)
     find_package(pybind11 REQUIRED)
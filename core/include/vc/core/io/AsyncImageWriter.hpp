@@ -0,0 +1,117 @@
+#pragma once
+
+/** @file */
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+#include "vc/core/filesystem.hpp"
+#include "vc/core/io/ImageIO.hpp"
+
+namespace volcart
+{
+/**
+ * @class AsyncImageWriter
+ * @brief Encode and write images with WriteImage() on background threads
+ *
+ * Writing a stack of compressed images, such as the layers of a
+ * LayerTexture or the outputs of a multi-image texturing algorithm, is
+ * dominated by compression, which WriteImage() does on the calling thread.
+ * Images passed to write() are instead queued and written concurrently by a
+ * pool of background threads, so the caller can continue while they are
+ * encoded.
+ *
+ * Queued images are not copied: their data is shared with the caller and
+ * must not be modified until flush() returns. The total size of the queued
+ * images is bounded by the byte limit passed to the constructor. When it is
+ * reached, write() waits for queued images to be written. A single image
+ * larger than the limit is still accepted if the queue is empty.
+ *
+ * If a write fails, the error is rethrown by the next call to write() or
+ * flush(). The destructor waits for the queued images to be written and logs
+ * any error.
+ *
+ * @ingroup IO
+ */
+class AsyncImageWriter
+{
+public:
+    /** Default limit on the size of the queued images */
+    static constexpr std::size_t DEFAULT_MAX_BYTES = std::size_t{1} << 30;
+
+    /**
+     * @brief Constructor
+     *
+     * @param numThreads Number of writer threads. If 0, uses one thread per
+     * hardware thread.
+     * @param maxBytes Limit on the total size of the queued images
+     */
+    explicit AsyncImageWriter(
+        std::size_t numThreads = 0, std::size_t maxBytes = DEFAULT_MAX_BYTES);
+
+    /** @brief Write the queued images and stop the background threads */
+    ~AsyncImageWriter();
+
+    AsyncImageWriter(const AsyncImageWriter&) = delete;
+    auto operator=(const AsyncImageWriter&) -> AsyncImageWriter& = delete;
+
+    /**
+     * @brief Queue an image to be written to `path`
+     *
+     * Waits while the queue is full.
+     */
+    void write(
+        const filesystem::path& path,
+        const cv::Mat& img,
+        WriteImageOpts opts = {});
+
+    /** @brief Wait until every queued image has been written */
+    void flush();
+
+    /** @brief Get the number of writer threads */
+    [[nodiscard]] auto numThreads() const -> std::size_t;
+
+private:
+    /** Queued image */
+    struct Job {
+        filesystem::path path;
+        cv::Mat img;
+        WriteImageOpts opts;
+        std::size_t bytes{0};
+    };
+
+    /** Images which have not been written */
+    std::deque<Job> queue_;
+    /** Limit on queuedBytes_ */
+    std::size_t maxBytes_;
+    /** Size of the queued and in-progress images */
+    std::size_t queuedBytes_{0};
+    /** Number of images being written */
+    std::size_t busy_{0};
+    /** Whether the background threads should stop */
+    bool stop_{false};
+    /** The first write error */
+    std::exception_ptr error_;
+    /** Guards the queue and state */
+    std::mutex mutex_;
+    /** Signals new jobs */
+    std::condition_variable workCv_;
+    /** Signals written jobs */
+    std::condition_variable doneCv_;
+    /** Background threads */
+    std::vector<std::thread> workers_;
+
+    /** Rethrow and clear the stored write error. Requires the lock. */
+    void rethrow_();
+
+    /** Background thread: write the queued images */
+    void run_();
+};
+}  // namespace volcart
@@ -0,0 +1,184 @@
+#pragma once
+
+/** @file */
+
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+#include "vc/core/filesystem.hpp"
+#include "vc/core/util/ThreadPool.hpp"
+
+namespace volcart::io
+{
+
+/**
+ * @class AsyncReader
+ * @brief Reads whole files with many reads in flight at once
+ *
+ * A thread which reads a file with blocking calls waits for every request to
+ * finish before it can issue the next, so the number of reads in flight is
+ * limited by the number of threads. NVMe drives and parallel filesystems
+ * only approach their bandwidth with deep queues. An AsyncReader keeps up to
+ * queueDepth() files open and in flight and calls each read's callback on a
+ * pool of completion threads as soon as its data arrives, so expensive work
+ * such as decoding a slice runs on the completion threads while the next
+ * reads are in flight.
+ *
+ * On Linux, files are opened, measured and read with io_uring from a single
+ * submission thread. Elsewhere, on kernels without io_uring, or when the
+ * Engine::Threads engine is requested, each file is read with blocking calls
+ * on one of the completion threads.
+ *
+ * Readers are safe to use from many threads at once and may be shared
+ * between volumes. The destructor waits for every submitted read, so
+ * callbacks must not hold the last reference to their reader.
+ *
+ * Example Usage:
+ * @code{.cpp}
+ * auto reader = AsyncReader::New();
+ * for (const auto& path : paths) {
+ *     reader->read(path, [](auto data, auto error) {
+ *         if (data) {
+ *             auto image = cv::imdecode(*data, cv::IMREAD_UNCHANGED);
+ *         }
+ *     });
+ * }
+ * reader->wait();
+ * @endcode
+ *
+ * @see Volume::setAsyncReader()
+ * @ingroup IO
+ */
+class AsyncReader
+{
+public:
+    /** Shared pointer type */
+    using Pointer = std::shared_ptr<AsyncReader>;
+
+    /** @brief I/O engine */
+    enum class Engine {
+        /** io_uring if available, Threads otherwise */
+        Auto,
+        /** Linux io_uring */
+        IOUring,
+        /** Blocking reads on the completion threads */
+        Threads
+    };
+
+    /** Contents of a file, or std::nullopt if it does not exist */
+    using Result = std::optional<std::vector<char>>;
+
+    /**
+     * @brief Read completion callback
+     *
+     * Called on a completion thread with the contents of the file, or with
+     * a null result and the exception which made the read fail. Exceptions
+     * thrown by the callback are logged and discarded.
+     */
+    using Callback = std::function<void(Result, std::exception_ptr)>;
+
+    /** Default maximum number of reads in flight */
+    static constexpr std::size_t DEFAULT_QUEUE_DEPTH{64};
+
+    /**
+     * @brief Constructor
+     *
+     * @param queueDepth Maximum number of reads in flight. Reads beyond this
+     * are queued until an earlier read completes.
+     * @param threads Number of completion threads. If `0`, uses
+     * `std::thread::hardware_concurrency()`.
+     * @param engine I/O engine. Engine::IOUring falls back to
+     * Engine::Threads if io_uring is not available.
+     * @throws std::invalid_argument if `queueDepth == 0`
+     */
+    explicit AsyncReader(
+        std::size_t queueDepth = DEFAULT_QUEUE_DEPTH,
+        std::size_t threads = 0,
+        Engine engine = Engine::Auto);
+
+    /** @copydoc AsyncReader(std::size_t, std::size_t, Engine) */
+    static auto New(
+        std::size_t queueDepth = DEFAULT_QUEUE_DEPTH,
+        std::size_t threads = 0,
+        Engine engine = Engine::Auto) -> Pointer;
+
+    /** @brief Wait for every submitted read, then stop */
+    ~AsyncReader();
+
+    /**@{*/
+    AsyncReader(const AsyncReader&) = delete;
+    auto operator=(const AsyncReader&) -> AsyncReader& = delete;
+    AsyncReader(AsyncReader&&) = delete;
+    auto operator=(AsyncReader&&) -> AsyncReader& = delete;
+    /**@}*/
+
+    /** @brief Whether io_uring is available on this system */
+    static auto IOUringAvailable() -> bool;
+
+    /** @brief Get the engine in use. Never Engine::Auto. */
+    [[nodiscard]] auto engine() const -> Engine;
+
+    /** @brief Get the maximum number of reads in flight */
+    [[nodiscard]] auto queueDepth() const -> std::size_t;
+
+    /** @brief Get the number of submitted reads which have not completed */
+    [[nodiscard]] auto pending() const -> std::size_t;
+
+    /**
+     * @brief Read a file asynchronously
+     *
+     * Returns immediately. `done` is called once the file has been read.
+     * Files which do not exist produce a null result without an error.
+     * Other failures produce a volcart::IOException.
+     */
+    void read(const filesystem::path& path, Callback done);
+
+    /**
+     * @brief Read a file asynchronously
+     *
+     * The future rethrows the exception of a failed read.
+     */
+    auto read(const filesystem::path& path) -> std::future<Result>;
+
+    /**
+     * @brief Run a blocking read on a completion thread
+     *
+     * For storage which cannot be read with the I/O engine, such as a
+     * remote VolumeSource. Blocking reads are limited by the number of
+     * completion threads rather than by queueDepth().
+     */
+    void submit(std::function<Result()> load, Callback done);
+
+    /** @brief Wait until every submitted read has completed */
+    void wait();
+
+private:
+    /** io_uring submission thread */
+    class Ring;
+
+    /** Run a callback and mark its read as complete */
+    void complete_(
+        const Callback& done, Result data, std::exception_ptr error);
+
+    /** Maximum number of reads in flight */
+    std::size_t queueDepth_;
+    /** Completion threads */
+    ThreadPool completions_;
+    /** io_uring engine. Null if using blocking reads. */
+    std::unique_ptr<Ring> ring_;
+    /** Guards pending_ */
+    mutable std::mutex mutex_;
+    /** Signals that a read has completed */
+    std::condition_variable cv_;
+    /** Number of submitted reads which have not completed */
+    std::size_t pending_{0};
+};
+
+}  // namespace volcart::io
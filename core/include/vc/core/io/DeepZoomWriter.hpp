@@ -0,0 +1,158 @@
+#pragma once
+
+/** @file */
+
+#include <cstddef>
+#include <map>
+#include <utility>
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+#include "vc/core/filesystem.hpp"
+
+namespace volcart
+{
+/**
+ * @class DeepZoomWriter
+ * @brief Write an image as a Deep Zoom (DZI) tile pyramid one region at a
+ * time
+ *
+ * Deep Zoom images can be panned and zoomed by web viewers such as
+ * OpenSeadragon without loading the full image. The pyramid is written to
+ * `<stem>_files/<level>/<column>_<row>.png` next to the `.dzi` descriptor,
+ * where level 0 is a single pixel and the last level is the full-resolution
+ * image. Tiles do not overlap.
+ *
+ * Like tiffio::TiledTIFFWriter, full-resolution tiles are written as soon as
+ * they are passed to writeRegion(). Each tile is then downsampled by half
+ * into its parent tile, and a parent tile is written (and downsampled in
+ * turn) as soon as all of its children have been written. Only the
+ * partially complete tiles of each level are held in memory, so the pyramid
+ * is built in the same pass as the full-resolution image.
+ *
+ * Regions must be aligned to the tile grid and must cover whole tiles,
+ * except along the right and bottom edges of the image. Full-resolution
+ * tiles which are never written are missing from the pyramid, and are
+ * treated as zeros in the lower resolution levels.
+ *
+ * Supports unsigned 8 & 16 bit images with 1, 3, or 4 channels.
+ *
+ * @ingroup IO
+ */
+class DeepZoomWriter
+{
+public:
+    /**
+     * @brief Open a Deep Zoom image for writing
+     *
+     * @param path Descriptor path. Must have a `.dzi` extension.
+     * @param width Image width
+     * @param height Image height
+     * @param cvType OpenCV type of the image (e.g. `CV_16UC1`)
+     * @param tileSize Tile width and height. Must be even.
+     *
+     * @throws std::invalid_argument If the dimensions or tile size are
+     * invalid
+     * @throws std::runtime_error If the path or type is not supported
+     */
+    DeepZoomWriter(
+        filesystem::path path,
+        int width,
+        int height,
+        int cvType,
+        int tileSize = 256);
+
+    /** @brief Close the image. Errors are ignored. See close(). */
+    ~DeepZoomWriter();
+
+    /**@{*/
+    DeepZoomWriter(const DeepZoomWriter&) = delete;
+    auto operator=(const DeepZoomWriter&) -> DeepZoomWriter& = delete;
+    /**@}*/
+
+    /** @brief Image width */
+    [[nodiscard]] auto width() const -> int;
+    /** @brief Image height */
+    [[nodiscard]] auto height() const -> int;
+    /** @brief Tile width and height */
+    [[nodiscard]] auto tileSize() const -> int;
+    /** @brief Number of pyramid levels, including the full-resolution level */
+    [[nodiscard]] auto numLevels() const -> int;
+
+    /**
+     * @brief Set the number of threads used to encode and downsample tiles
+     *
+     * If `0`, uses every thread in the global ThreadPool. Default: 1
+     */
+    void setNumThreads(std::size_t n);
+    /** @brief Number of threads used to encode and downsample tiles */
+    [[nodiscard]] auto numThreads() const -> std::size_t;
+
+    /**
+     * @brief Write a region of the full-resolution image
+     *
+     * @param origin Position of the top-left corner of `img` in the image
+     * @param img Region image. Must have the type given to the constructor.
+     *
+     * @throws std::invalid_argument If the region does not match the type or
+     * tile grid of the image
+     * @throws std::out_of_range If the region is not within the image
+     * @throws std::runtime_error If the writer is closed or a tile cannot be
+     * written
+     */
+    void writeRegion(const cv::Point& origin, const cv::Mat& img);
+
+    /**
+     * @brief Write the incomplete lower resolution tiles and the descriptor
+     *
+     * Further writes throw. Does nothing if the writer is already closed.
+     */
+    void close();
+
+private:
+    /** Tile of a pyramid level */
+    struct Tile {
+        /** Tile column */
+        int x{0};
+        /** Tile row */
+        int y{0};
+        /** Tile image */
+        cv::Mat img;
+    };
+
+    /** Lower resolution tile which is still being assembled */
+    struct PendingTile {
+        /** Tile image */
+        cv::Mat img;
+        /** Number of children which have been downsampled into img */
+        int children{0};
+    };
+
+    /** Descriptor path */
+    filesystem::path path_;
+    /** Tile directory */
+    filesystem::path tileDir_;
+    /** Image type */
+    int cvType_{0};
+    /** Tile width and height */
+    int tileSize_{0};
+    /** Number of threads */
+    std::size_t numThreads_{1};
+    /** Image size of each level, from 1x1 to full resolution */
+    std::vector<cv::Size> levelSizes_;
+    /** Incomplete tiles of each level, keyed by (column, row) */
+    std::vector<std::map<std::pair<int, int>, PendingTile>> pending_;
+    /** Whether the writer has been closed */
+    bool closed_{false};
+
+    /** Size of a tile in a level */
+    [[nodiscard]] auto tile_size_(int level, int x, int y) const -> cv::Size;
+    /** Number of tile columns and rows in a level */
+    [[nodiscard]] auto tile_grid_(int level) const -> cv::Size;
+    /** Number of children of a tile in a level */
+    [[nodiscard]] auto num_children_(int level, int x, int y) const -> int;
+    /** Write complete tiles of a level and propagate them down the pyramid */
+    void write_tiles_(int level, std::vector<Tile> tiles);
+};
+}  // namespace volcart
@@ -0,0 +1,124 @@
+#pragma once
+
+/** @file */
+
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "vc/core/io/VolumeSource.hpp"
+
+namespace volcart::io
+{
+
+/** @brief HTTPVolumeSource request options */
+struct HTTPSourceOptions {
+    /** Size of the byte ranges in which objects are downloaded */
+    std::size_t chunkSize{std::size_t{8} << 20};
+    /** Maximum number of concurrent range requests per read */
+    std::size_t maxConnections{8};
+    /** Number of times a failed request is retried */
+    int retries{3};
+    /** Timeout of a single request in seconds */
+    long timeout{60};
+    /** Extra request headers, such as `Authorization: ...` */
+    std::vector<std::string> headers;
+};
+
+/**
+ * @class HTTPVolumeSource
+ * @brief VolumeSource which downloads objects from an HTTP server or an
+ * object store
+ *
+ * Objects are read from `<baseURL>/<name>` with HTTP GET requests. Large
+ * objects are downloaded as several byte ranges at once, which is usually
+ * much faster than a single request when reading from object stores such as
+ * Amazon S3, where the throughput of a single connection is limited. The
+ * first request asks for the first range and learns the object size from the
+ * response, so an object which fits in one range costs a single request.
+ * Servers which do not support range requests return the whole object
+ * instead.
+ *
+ * Connections are kept open and reused between reads. Failed requests are
+ * retried, and 404 responses are reported as missing objects.
+ *
+ * Objects are assumed to be immutable, so stamp() is the same for every
+ * object and decoded objects can be kept in a DiskCache without contacting
+ * the server. Requests are not signed, so private S3 buckets must be
+ * accessed through an endpoint which authorizes requests, such as a proxy,
+ * or by passing the appropriate headers in Options::headers.
+ *
+ * Requires libcurl. Build with `VC_WITH_CURL` to enable it, and use
+ * Available() to check for it at runtime.
+ *
+ * @ingroup IO
+ */
+class HTTPVolumeSource final : public VolumeSource
+{
+public:
+    /** Shared pointer type */
+    using Pointer = std::shared_ptr<HTTPVolumeSource>;
+
+    /** Request options */
+    using Options = HTTPSourceOptions;
+
+    /**
+     * @brief Constructor
+     *
+     * `s3://bucket/prefix` URLs are mapped to
+     * `https://bucket.s3.amazonaws.com/prefix`.
+     *
+     * @throws std::runtime_error if built without libcurl
+     */
+    explicit HTTPVolumeSource(std::string baseURL, Options options = {});
+
+    /** @copydoc HTTPVolumeSource(std::string, Options) */
+    static auto New(std::string baseURL, Options options = {}) -> Pointer;
+
+    /** Destructor */
+    ~HTTPVolumeSource() override;
+
+    /** Disallow copies */
+    HTTPVolumeSource(const HTTPVolumeSource&) = delete;
+    /** Disallow copies */
+    auto operator=(const HTTPVolumeSource&) -> HTTPVolumeSource& = delete;
+
+    /** @brief Whether HTTP support was built */
+    static auto Available() -> bool;
+
+    /**
+     * @brief Get the HTTP(S) URL of a location
+     *
+     * Maps `s3://bucket/prefix` to its virtual-hosted HTTPS URL and returns
+     * other URLs unchanged.
+     */
+    static auto ResolveURL(const std::string& url) -> std::string;
+
+    /** @brief Get the request options */
+    [[nodiscard]] auto options() const -> const Options&;
+
+    /** @copydoc VolumeSource::read() */
+    auto read(const std::string& name)
+        -> std::optional<std::vector<char>> override;
+
+    /** @brief A constant stamp, since objects are assumed to be immutable */
+    auto stamp(const std::string& name) -> DiskCache::Stamp override;
+
+    /** @copydoc VolumeSource::uri() */
+    [[nodiscard]] auto uri() const -> std::string override;
+
+private:
+    /** Idle libcurl handles */
+    struct Connections;
+
+    /** Base URL, without a trailing `/` */
+    std::string baseURL_;
+    /** Request options */
+    Options options_;
+    /** Reused connections */
+    std::unique_ptr<Connections> connections_;
+};
+
+}  // namespace volcart::io
@@ -32,7 +32,9 @@ struct WriteImageOpts {
  * @brief Write image to the specified path
  *
  * Uses volcart::WriteTIFF for all tiff images, which includes support for
- * transparency and floating-point images. Otherwise, uses cv::imwrite.
+ * transparency and floating-point images. Paths with a `.dzi` extension are
+ * written as a Deep Zoom tile pyramid with DeepZoomWriter, which viewers can
+ * pan and zoom without loading the full image. Otherwise, uses cv::imwrite.
  */
 void WriteImage(
     const filesystem::path& path, const cv::Mat& img, WriteImageOpts = {});
@@ -0,0 +1,56 @@
+#pragma once
+
+/** @file */
+
+#include <cstddef>
+#include <string_view>
+
+#include "vc/core/filesystem.hpp"
+
+namespace volcart::io
+{
+
+/**
+ * @class MappedFile
+ * @brief Read-only memory mapping of a file
+ *
+ * Maps the entire contents of a file into memory for the lifetime of the
+ * object. Empty files are supported and have a null data() pointer. Throws
+ * volcart::IOException if the file cannot be opened or mapped.
+ *
+ * @ingroup IO
+ */
+class MappedFile
+{
+public:
+    /** @brief Map a file */
+    explicit MappedFile(const filesystem::path& path);
+
+    /** @brief Unmap the file */
+    ~MappedFile();
+
+    /** Disallow copies */
+    MappedFile(const MappedFile&) = delete;
+    /** Disallow copies */
+    auto operator=(const MappedFile&) -> MappedFile& = delete;
+
+    /** @brief Get a pointer to the first byte of the file */
+    [[nodiscard]] auto data() const -> const char*;
+
+    /** @brief Get the size of the file in bytes */
+    [[nodiscard]] auto size() const -> std::size_t;
+
+    /** @brief Get a pointer to one past the last byte of the file */
+    [[nodiscard]] auto end() const -> const char*;
+
+    /** @brief Get the contents of the file */
+    [[nodiscard]] auto view() const -> std::string_view;
+
+private:
+    /** Mapped file contents */
+    const char* data_{nullptr};
+    /** Mapped file size */
+    std::size_t size_{0};
+};
+
+}  // namespace volcart::io
@@ -0,0 +1,308 @@
+#pragma once
+
+/** @file */
+
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "vc/core/filesystem.hpp"
+#include "vc/core/io/MappedFile.hpp"
+#include "vc/core/io/PointSetIO.hpp"
+#include "vc/core/types/Exceptions.hpp"
+#include "vc/core/types/OrderedPointSet.hpp"
+#include "vc/core/types/PointSet.hpp"
+
+namespace volcart
+{
+
+/**
+ * @class MappedPointSet
+ * @brief Read-only, memory-mapped view of a binary PointSet file
+ *
+ * Maps a binary PointSet or OrderedPointSet file without copying its points
+ * into memory. Points are paged in from disk as they are accessed, so large
+ * point sets can be traversed with a small resident footprint. Points are
+ * returned by value because the file gives no alignment guarantees.
+ *
+ * Copies of a MappedPointSet share the same mapping. Point information is
+ * expected to be stored in the type and order specified by the template
+ * parameter T.
+ *
+ * @ingroup IO
+ *
+ * @see volcart::PointSetIO
+ * @see volcart::PointSetReader
+ */
+template <typename T>
+class MappedPointSet
+{
+public:
+    /** PointSet file header information */
+    using Header = typename PointSetIO<T>::Header;
+
+    /** Point type */
+    using value_type = T;
+
+    /** @brief Random-access iterator over the mapped points */
+    class ConstIterator
+    {
+    public:
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = T;
+
+        ConstIterator() = default;
+
+        /** @brief Get the current point */
+        auto operator*() const -> T { return ps_->point_(idx_); }
+        /** @brief Get the point at an offset from the current point */
+        auto operator[](difference_type n) const -> T
+        {
+            return ps_->point_(idx_ + n);
+        }
+
+        auto operator++() -> ConstIterator&
+        {
+            ++idx_;
+            return *this;
+        }
+        auto operator++(int) -> ConstIterator
+        {
+            auto tmp = *this;
+            ++idx_;
+            return tmp;
+        }
+        auto operator--() -> ConstIterator&
+        {
+            --idx_;
+            return *this;
+        }
+        auto operator--(int) -> ConstIterator
+        {
+            auto tmp = *this;
+            --idx_;
+            return tmp;
+        }
+        auto operator+=(difference_type n) -> ConstIterator&
+        {
+            idx_ += n;
+            return *this;
+        }
+        auto operator-=(difference_type n) -> ConstIterator&
+        {
+            idx_ -= n;
+            return *this;
+        }
+        auto operator+(difference_type n) const -> ConstIterator
+        {
+            return {ps_, idx_ + n};
+        }
+        auto operator-(difference_type n) const -> ConstIterator
+        {
+            return {ps_, idx_ - n};
+        }
+        auto operator-(const ConstIterator& o) const -> difference_type
+        {
+            return static_cast<difference_type>(idx_) -
+                   static_cast<difference_type>(o.idx_);
+        }
+
+        auto operator==(const ConstIterator& o) const -> bool
+        {
+            return idx_ == o.idx_;
+        }
+        auto operator!=(const ConstIterator& o) const -> bool
+        {
+            return idx_ != o.idx_;
+        }
+        auto operator<(const ConstIterator& o) const -> bool
+        {
+            return idx_ < o.idx_;
+        }
+        auto operator>(const ConstIterator& o) const -> bool
+        {
+            return idx_ > o.idx_;
+        }
+        auto operator<=(const ConstIterator& o) const -> bool
+        {
+            return idx_ <= o.idx_;
+        }
+        auto operator>=(const ConstIterator& o) const -> bool
+        {
+            return idx_ >= o.idx_;
+        }
+
+    private:
+        friend class MappedPointSet;
+        ConstIterator(const MappedPointSet* ps, std::size_t idx)
+            : ps_{ps}, idx_{idx}
+        {
+        }
+
+        /** Iterated point set */
+        const MappedPointSet* ps_{nullptr};
+        /** Current point index */
+        std::size_t idx_{0};
+    };
+
+    /**
+     * @brief Map a binary PointSet or OrderedPointSet file
+     *
+     * If `ordered` is true, the file must contain an OrderedPointSet.
+     * Otherwise, both kinds of file are accepted. Throws
+     * volcart::IOException if the header is invalid or the file is
+     * truncated.
+     */
+    explicit MappedPointSet(
+        const filesystem::path& path, bool ordered = false)
+    {
+        std::ifstream infile{path.string(), std::ios::binary};
+        if (!infile.is_open()) {
+            auto msg = "could not open file '" + path.string() + "'";
+            throw IOException(msg);
+        }
+        header_ = PointSetIO<T>::ParseHeader(infile, ordered);
+        auto offset = infile.tellg();
+        if (offset < 0) {
+            throw IOException("Failed to parse header: " + path.string());
+        }
+        offset_ = static_cast<std::size_t>(offset);
+        if (header_.ordered) {
+            header_.size = header_.width * header_.height;
+        }
+        infile.close();
+
+        file_ = std::make_shared<io::MappedFile>(path);
+        if (file_->size() < offset_ + header_.size * POINT_BYTES) {
+            throw IOException("PointSet file is truncated: " + path.string());
+        }
+    }
+
+    /** @brief Get the parsed file header */
+    [[nodiscard]] auto header() const -> const Header& { return header_; }
+
+    /** @brief Get the number of points */
+    [[nodiscard]] auto size() const -> std::size_t { return header_.size; }
+
+    /** @brief Return whether the point set is empty */
+    [[nodiscard]] auto empty() const -> bool { return header_.size == 0; }
+
+    /** @brief Return whether the file contains an OrderedPointSet */
+    [[nodiscard]] auto ordered() const -> bool { return header_.ordered; }
+
+    /**
+     * @brief Get the width of the point set
+     *
+     * Unordered point sets are treated as a single row.
+     */
+    [[nodiscard]] auto width() const -> std::size_t
+    {
+        return header_.ordered ? header_.width : header_.size;
+    }
+
+    /** @brief Get the height of the point set */
+    [[nodiscard]] auto height() const -> std::size_t
+    {
+        if (header_.ordered) {
+            return header_.height;
+        }
+        return header_.size > 0 ? 1 : 0;
+    }
+
+    /** @brief Get a point by index */
+    auto operator[](std::size_t idx) const -> T
+    {
+        if (idx >= header_.size) {
+            throw std::out_of_range("Point index out of range");
+        }
+        return point_(idx);
+    }
+
+    /** @brief Get a point by 2D position */
+    auto operator()(std::size_t y, std::size_t x) const -> T
+    {
+        if (x >= width() || y >= height()) {
+            throw std::out_of_range("Point position out of range");
+        }
+        return point_(y * width() + x);
+    }
+
+    /** @brief Copy a row of points */
+    [[nodiscard]] auto getRow(std::size_t y) const -> std::vector<T>
+    {
+        if (y >= height()) {
+            throw std::out_of_range("Row index out of range");
+        }
+        std::vector<T> row(width());
+        std::memcpy(
+            static_cast<void*>(row.data()), data_(y * width()),
+            row.size() * POINT_BYTES);
+        return row;
+    }
+
+    /** @brief Iterator to the first point */
+    [[nodiscard]] auto begin() const -> ConstIterator { return {this, 0}; }
+
+    /** @brief Iterator to one past the last point */
+    [[nodiscard]] auto end() const -> ConstIterator
+    {
+        return {this, header_.size};
+    }
+
+    /** @brief Copy the mapped points into a PointSet */
+    [[nodiscard]] auto toPointSet() const -> PointSet<T>
+    {
+        PointSet<T> ps(header_.size);
+        for (std::size_t i = 0; i < header_.size; ++i) {
+            ps.push_back(point_(i));
+        }
+        return ps;
+    }
+
+    /** @brief Copy the mapped points into an OrderedPointSet */
+    [[nodiscard]] auto toOrderedPointSet() const -> OrderedPointSet<T>
+    {
+        OrderedPointSet<T> ps{width()};
+        ps.reserveRows(height());
+        for (std::size_t y = 0; y < height(); ++y) {
+            ps.pushRow(getRow(y));
+        }
+        return ps;
+    }
+
+private:
+    /** Size of a single point in the file */
+    static constexpr std::size_t POINT_BYTES =
+        T::channels * sizeof(typename T::value_type);
+
+    /** Parsed header */
+    Header header_;
+    /** Offset of the first point in the file */
+    std::size_t offset_{0};
+    /** Mapped file. Shared between copies. */
+    std::shared_ptr<const io::MappedFile> file_;
+
+    /** Get a pointer to the file data for a point */
+    [[nodiscard]] auto data_(std::size_t idx) const -> const char*
+    {
+        return file_->data() + offset_ + idx * POINT_BYTES;
+    }
+
+    /** Read a point without bounds checking */
+    [[nodiscard]] auto point_(std::size_t idx) const -> T
+    {
+        T t;
+        std::memcpy(t.val, data_(idx), POINT_BYTES);
+        return t;
+    }
+};
+
+}  // namespace volcart
@@ -6,6 +6,7 @@
 #include <opencv2/core.hpp>
 
 #include "vc/core/filesystem.hpp"
+#include "vc/core/io/PLYWriter.hpp"
 #include "vc/core/types/ITKMesh.hpp"
 #include "vc/core/types/UVMap.hpp"
 
@@ -34,7 +35,12 @@ auto ReadMesh(const filesystem::path& path) -> MeshReaderResult;
 
 /** @brief General options for WriteMesh */
 struct MeshWriterOpts {
+    /** Texture image format */
     std::string imgFmt{"tif"};
+    /** PLY body encoding */
+    io::PLYWriter::Format plyFormat{io::PLYWriter::Format::ASCII};
+    /** PLY vertex precision */
+    io::PLYWriter::Precision plyPrecision{io::PLYWriter::Precision::Float32};
 };
 
 /**
@@ -2,7 +2,10 @@
 
 /** @file */
 
-#include <fstream>
+#include <array>
+#include <cstddef>
+#include <string>
+#include <vector>
 
 #include <opencv2/core.hpp>
 
@@ -24,6 +27,9 @@ namespace volcart::io
  * include. Other material properties are currently ignored. Throws
  * volcart::IOException on error.
  *
+ * The file is memory mapped and split into blocks of lines which are parsed
+ * in parallel. Only triangular faces are supported.
+ *
  * @ingroup IO
  */
 class OBJReader
@@ -32,6 +38,14 @@ public:
     /** @brief Set the OBJ file path */
     void setPath(const filesystem::path& p);
 
+    /**
+     * @brief Set the number of threads used to parse the file
+     *
+     * If 0 (the default), uses the number of hardware threads. Small files
+     * are always parsed by a single thread.
+     */
+    void setNumThreads(std::size_t n);
+
     /** @brief Read the mesh from file */
     auto read() -> ITKMesh::Pointer;
 
@@ -65,17 +79,21 @@ private:
      * VertexRefs { v, vt, vn }
      */
     using VertexRefs = cv::Vec3i;
-    /** @brief A list of at least three OBJReader::VertexRefs comprise a face */
-    using Face = std::vector<VertexRefs>;
-
-    /** @brief Validation enumeration to ensure proper parsing of
-     * OBJReader::VertexRefs */
-    enum class RefType {
-        Invalid,
-        Vertex,
-        VertexWithTexture,
-        VertexWithNormal,
-        VertexWithTextureAndNormal
+    /** @brief Three OBJReader::VertexRefs comprise a triangular face */
+    using Face = std::array<VertexRefs, 3>;
+
+    /** @brief Elements parsed from a block of lines */
+    struct Block {
+        /** Vertex positions */
+        std::vector<cv::Vec3d> vertices;
+        /** Vertex normals */
+        std::vector<cv::Vec3d> normals;
+        /** Vertex UV coordinates */
+        std::vector<cv::Vec2d> uvs;
+        /** Faces */
+        std::vector<Face> faces;
+        /** Referenced mtl files */
+        std::vector<std::string> mtllibs;
     };
 
     /** Clear all temporary data structures */
@@ -83,18 +101,10 @@ private:
 
     /** Parse the mesh */
     void parse_();
-    /** Handle parsed vertex lines */
-    void parse_vertex_(const std::vector<std::string>& strs);
-    /** Handle parsed vertex normal lines */
-    void parse_normal_(const std::vector<std::string>& strs);
-    /** Handle parsed vertex UV coordinate lines */
-    void parse_tcoord_(const std::vector<std::string>& strs);
-    /** Handle parsed face lines */
-    void parse_face_(const std::vector<std::string>& strs);
+    /** Parse the lines in [begin, end) */
+    static void parse_block_(const char* begin, const char* end, Block& b);
     /** Handle parsed mtllib lines */
-    void parse_mtllib_(const std::vector<std::string>& strs);
-    /** Classify a OBJReader::VertexRefs as an OBJReader::RefType */
-    auto classify_vertref_(const std::string& ref) -> RefType;
+    void parse_mtllib_(const std::string& name);
 
     /** Construct a mesh from the parsed information */
     void build_mesh_();
@@ -109,6 +119,8 @@ private:
     UVMap::Pointer uvMap_;
     /** Internal representation of texture image */
     cv::Mat textureMat_;
+    /** Number of parser threads */
+    std::size_t numThreads_{0};
 
     /** List of parsed vertex positions */
     std::vector<cv::Vec3d> vertices_;
@@ -117,7 +129,7 @@ private:
     /** List of parsed vertex UV coordinates */
     std::vector<cv::Vec2d> uvs_;
     /** List of parsed faces */
-    std::vector<OBJReader::Face> faces_;
+    std::vector<Face> faces_;
 };
 
 }  // namespace volcart::io
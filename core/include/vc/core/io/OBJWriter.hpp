@@ -4,6 +4,7 @@
 
 #include <fstream>
 #include <iostream>
+#include <vector>
 
 #include <opencv2/core.hpp>
 
@@ -92,13 +93,13 @@ private:
      * Keeps track of what info we have about each point in the mesh. Used for
      * building OBJ faces.
      *
-     * [ Point Index, {v, vt, vn} ]
+     * Indexed by point ID: {v, vt, vn}
      *
      * v = vertex index number \n
      * vt = UV coordinate index number \n
      * vn = vertex normal index number \n
      */
-    std::map<uint32_t, cv::Vec3i> pointLinks_;
+    std::vector<cv::Vec3i> pointLinks_;
 
     /** Input mesh */
     ITKMesh::Pointer mesh_;
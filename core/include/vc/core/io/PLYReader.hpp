@@ -2,8 +2,11 @@
 
 /** @file */
 
-#include <fstream>
+#include <cstddef>
 #include <map>
+#include <string>
+#include <string_view>
+#include <vector>
 
 #include "vc/core/filesystem.hpp"
 #include "vc/core/types/ITKMesh.hpp"
@@ -19,7 +22,9 @@ namespace volcart::io
  *
  * @brief Read a PLY file to an ITKMesh
  *
- * Only supports vertices, vertex normals, and faces.
+ * Only supports vertices, vertex normals, and triangular faces. Reads
+ * ASCII, binary little-endian, and binary big-endian files. The file is
+ * memory mapped and its vertices are parsed in parallel.
  *
  * @ingroup IO
  */
@@ -38,6 +43,14 @@ public:
     /** @brief Set the input file path */
     void setPath(filesystem::path path);
 
+    /**
+     * @brief Set the number of threads used to parse the file
+     *
+     * If 0 (the default), uses the number of hardware threads. Small files
+     * are always parsed by a single thread.
+     */
+    void setNumThreads(std::size_t n);
+
     /** @brief Get the parsed input as an ITKMesh */
     auto getMesh() -> ITKMesh::Pointer;
     /**@}*/
@@ -48,14 +61,41 @@ public:
     /**@}*/
 
 private:
+    /** Scalar property types */
+    enum class Type {
+        Int8,
+        UInt8,
+        Int16,
+        UInt16,
+        Int32,
+        UInt32,
+        Float32,
+        Float64
+    };
+
+    /** Element property declared in the header */
+    struct Property {
+        /** Property name */
+        std::string name;
+        /** Value type. For lists, the type of the list items. */
+        Type type{Type::Float32};
+        /** Whether the property is a list */
+        bool isList{false};
+        /** Type of the list length */
+        Type countType{Type::UInt8};
+    };
+
+    /** Body encodings */
+    enum class Format { ASCII, BinaryLittleEndian, BinaryBigEndian };
+
     /** Input file path */
     filesystem::path inputPath_;
-    /** Input file stream */
-    std::ifstream plyFile_;
+    /** Number of parser threads */
+    std::size_t numThreads_{0};
     /** Output mesh */
     ITKMesh::Pointer outMesh_;
-    /** Line currently being parsed */
-    std::string line_;
+    /** Start of every line in the body of the file */
+    std::vector<const char*> lines_;
     /** Temporary face list */
     std::vector<SimpleMesh::Cell> faceList_;
     /** Temporary vertex list */
@@ -68,14 +108,14 @@ private:
     int numFaces_;
     /** Number of lines used by the elements we can't handle */
     std::vector<int> skippedLine_;
-    /** Maps positions in a string to a particular attribute */
+    /** Maps vertex attributes to their position in a vertex line */
     std::map<std::string, int> properties_;
-
-    /**
-     * Tracks if there is a leading character in front of each face line. This
-     * character tells how many vertices are in that face.
-     */
-    bool hasLeadingChar_ = true;
+    /** Number of values in a vertex line */
+    int numVertexProperties_{0};
+    /** Encoding of the body */
+    Format format_{Format::ASCII};
+    /** Properties of each element in elementsList_ */
+    std::vector<std::vector<Property>> elementProperties_;
 
     /** Track if there are vertex normals */
     bool hasPointNorm_ = false;
@@ -90,13 +130,63 @@ private:
      * including the count for each element (e.g. vertices, faces, etc). This
      * information is stored in elementsList_ and used when reading in faces
      * and vertices.
+     *
+     * @return The start of the body
      */
-    void parse_header_();
+    auto parse_header_(const char* begin, const char* end) -> const char*;
+
+    /** @brief Parse the body of an ASCII file */
+    void read_ascii_(const char* begin, const char* end);
+
+    /** @brief Parse the body of a binary file */
+    void read_binary_(const char* begin, const char* end);
+
+    /** @brief Record the start of every line in the body */
+    void index_lines_(const char* begin, const char* end);
+
+    /**
+     * @brief Fill the temporary vertex list with parsed vertex information
+     *
+     * `readValues(i, values)` fills `values` with the properties of vertex
+     * `i` in header order.
+     */
+    template <typename ValueReader>
+    void read_points_(const ValueReader& readValues);
+
+    /**
+     * @brief Fill the temporary face list from an ASCII file
+     *
+     * @param first Index of the first face line in lines_
+     */
+    void read_ascii_faces_(std::size_t first, const char* end);
+
+    /**
+     * @brief Fill the temporary face list from a binary file
+     *
+     * @return The end of the face element
+     */
+    auto read_binary_faces_(
+        const char* pos, const char* end, const std::vector<Property>& props)
+        -> const char*;
+
+    /**
+     * @brief Skip the records of an element in a binary file
+     *
+     * @return The end of the element
+     */
+    auto skip_binary_element_(
+        const char* pos,
+        const char* end,
+        const std::vector<Property>& props,
+        std::size_t count) -> const char*;
+
+    /** @brief Convert a PLY type name to a Type */
+    static auto parse_type_(std::string_view name) -> Type;
 
-    /** @brief Fill the temporary face list with parsed face information */
-    void read_faces_();
+    /** @brief Get the size in bytes of a binary value */
+    static auto type_size_(Type type) -> std::size_t;
 
-    /** @brief Fill the temporary vertex list with parsed vertex information */
-    void read_points_();
+    /** @brief Read a binary value */
+    auto read_value_(const char* pos, Type type) const -> double;
 };
 }  // namespace volcart::io
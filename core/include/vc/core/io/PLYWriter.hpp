@@ -19,9 +19,13 @@ namespace volcart::io
  *
  * @brief Write an ITKMesh to a PLY file
  *
- * Writes both textured and untextured meshes in ASCII PLY format. Texture
- * information is automatically written if the volcart::Texture has images
- * and if the UV map is set and is not empty.
+ * Writes both textured and untextured meshes in ASCII or binary
+ * little-endian PLY format. Texture information is automatically written if
+ * the volcart::Texture has images and if the UV map is set and is not empty.
+ *
+ * Binary files are about a third of the size of ASCII files and are much
+ * faster to write and read. Vertex positions and normals are written as
+ * 32-bit floats by default. Use setPrecision() to write 64-bit doubles.
  *
  * Assumes that vertices have vertex normal information.
  *
@@ -30,6 +34,12 @@ namespace volcart::io
 class PLYWriter
 {
 public:
+    /** @brief Body encodings */
+    enum class Format { ASCII, BinaryLittleEndian };
+
+    /** @brief Floating-point precision of vertex positions and normals */
+    enum class Precision { Float32, Float64 };
+
     /**@{*/
     /** @brief Default constructor */
     PLYWriter() = default;
@@ -61,6 +71,12 @@ public:
 
     /** @brief Set per-vertex color information */
     void setVertexColors(const std::vector<uint16_t>& c);
+
+    /** @brief Set the body encoding. Default: Format::ASCII */
+    void setFormat(Format format);
+
+    /** @brief Set the vertex precision. Default: Precision::Float32 */
+    void setPrecision(Precision precision);
     /**@}*/
 
     /**@{*/
@@ -86,6 +102,16 @@ private:
     cv::Mat texture_;
     /** Vertex colors */
     std::vector<uint16_t> vcolors_;
+    /** Body encoding */
+    Format format_{Format::ASCII};
+    /** Vertex precision */
+    Precision precision_{Precision::Float32};
+
+    /** @brief Whether vertex colors are written */
+    [[nodiscard]] auto has_colors_() const -> bool;
+
+    /** @brief Get the 8-bit color of a vertex */
+    [[nodiscard]] auto vertex_color_(std::size_t idx) const -> int;
 
     /** @brief Write the PLY header */
     auto write_header_() -> int;
@@ -93,14 +119,14 @@ private:
     /**
      * @brief Write the PLY vertices
      *
-     * Lines are formatted:
+     * ASCII lines are formatted:
      *
-     * `x y z nx ny nz`
+     * `x y z nx ny nz [r g b]`
      */
     auto write_vertices_() -> int;
     /**@brief Write the PLY faces
      *
-     * Lines are formatted:
+     * ASCII lines are formatted:
      *
      * `[n vertices in face] v1 v2 ... vn`
      */
@@ -118,12 +118,30 @@ public:
     }
     /**@}*/
 
+    /**
+     * @brief Width of the height field of an OrderedPointSet header
+     *
+     * The height is padded with trailing spaces to this width, so that rows
+     * can be appended to a file by rewriting the field in place. See
+     * OrderedPointSetWriter. The size field of a PointSet header is padded
+     * the same way for PointSetWriter.
+     */
+    static constexpr std::size_t HEIGHT_FIELD_WIDTH{20};
+
+    /** @brief Format a height for the OrderedPointSet header */
+    static auto PadHeight(std::size_t height) -> std::string
+    {
+        auto s = std::to_string(height);
+        s.resize(std::max(s.size(), HEIGHT_FIELD_WIDTH), ' ');
+        return s;
+    }
+
     /**@{*/
     /** @brief Generate a PointSet header string */
     static std::string MakeHeader(PointSet<T> ps)
     {
         std::stringstream ss;
-        ss << "size: " << ps.size() << std::endl;
+        ss << "size: " << PadHeight(ps.size()) << std::endl;
         ss << "dim: " << T::channels << std::endl;
         ss << "ordered: false" << std::endl;
 
@@ -150,7 +168,7 @@ public:
     {
         std::stringstream ss;
         ss << "width: " << ps.width() << std::endl;
-        ss << "height: " << ps.height() << std::endl;
+        ss << "height: " << PadHeight(ps.height()) << std::endl;
         ss << "dim: " << T::channels << std::endl;
         ss << "ordered: true" << std::endl;
 
@@ -318,8 +336,9 @@ public:
         } else if (!ordered && h.size == 0) {
             auto msg = "Unordered pointsets must have a size";
             throw IOException(msg);
-        } else if (ordered && (h.width == 0 || h.height == 0)) {
-            auto msg = "Ordered pointsets must have a nonzero width and height";
+        } else if (ordered && h.width == 0) {
+            // Rows may still be appended to an ordered pointset of height 0
+            auto msg = "Ordered pointsets must have a nonzero width";
             throw IOException(msg);
         } else if (ordered && !h.ordered) {
             auto msg =
@@ -370,6 +389,7 @@ private:
         // Get header
         auto header = PointSetIO<T>::ParseHeader(infile, true);
         OrderedPointSet<T> ps{header.width};
+        ps.reserveRows(header.height);
 
         for (size_t h = 0; h < header.height; ++h) {
             std::vector<T> points;
@@ -430,6 +450,7 @@ private:
         }
         auto header = PointSetIO<T>::ParseHeader(infile, true);
         OrderedPointSet<T> ps{header.width};
+        ps.reserveRows(header.height);
 
         // Size of binary elements to read
         size_t typeBytes = sizeof(int);
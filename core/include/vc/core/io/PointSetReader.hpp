@@ -0,0 +1,138 @@
+#pragma once
+
+/** @file */
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "vc/core/filesystem.hpp"
+#include "vc/core/io/PointSetIO.hpp"
+#include "vc/core/types/Exceptions.hpp"
+
+namespace volcart
+{
+
+/**
+ * @class PointSetReader
+ * @brief Streaming reader for PointSet and OrderedPointSet files
+ *
+ * Reads points from a PointSet or OrderedPointSet file incrementally, so that
+ * only the points currently being processed are held in memory. Ordered
+ * files can be read one row at a time with readRow(). Any file can be read
+ * in chunks of points with read().
+ *
+ * The IOMode should match the encoding type of the file. Point information
+ * is expected to be stored in the type and order specified by the template
+ * parameter T.
+ *
+ * @ingroup IO
+ *
+ * @see volcart::PointSetIO
+ * @see volcart::MappedPointSet
+ */
+template <typename T>
+class PointSetReader
+{
+public:
+    /** PointSet file header information */
+    using Header = typename PointSetIO<T>::Header;
+
+    /**
+     * @brief Open a PointSet or OrderedPointSet file and parse its header
+     *
+     * Throws volcart::IOException if the file cannot be opened or the header
+     * is invalid.
+     */
+    explicit PointSetReader(
+        const filesystem::path& path, IOMode mode = IOMode::BINARY)
+        : mode_{mode}
+    {
+        auto flags = std::ios::in;
+        if (mode_ == IOMode::BINARY) {
+            flags |= std::ios::binary;
+        }
+        infile_.open(path.string(), flags);
+        if (!infile_.is_open()) {
+            auto msg = "could not open file '" + path.string() + "'";
+            throw IOException(msg);
+        }
+        header_ = PointSetIO<T>::ParseHeader(infile_, false);
+        remaining_ = header_.size;
+    }
+
+    /** @brief Get the parsed file header */
+    [[nodiscard]] auto header() const -> const Header& { return header_; }
+
+    /** @brief Get the number of points which have not been read */
+    [[nodiscard]] auto remaining() const -> std::size_t { return remaining_; }
+
+    /**
+     * @brief Read the next row of an OrderedPointSet
+     *
+     * Replaces the contents of `row` with the next `header().width` points.
+     * Returns false if every row has been read. Throws volcart::IOException
+     * if the file is unordered or truncated.
+     */
+    auto readRow(std::vector<T>& row) -> bool
+    {
+        if (!header_.ordered) {
+            throw IOException("Cannot read rows of an unordered PointSet");
+        }
+        if (remaining_ == 0) {
+            return false;
+        }
+        row.resize(header_.width);
+        read_points_(row.data(), row.size());
+        return true;
+    }
+
+    /**
+     * @brief Read up to `count` points
+     *
+     * Replaces the contents of `points` with the next points in the file.
+     * Returns the number of points read, which is zero once every point has
+     * been read. Throws volcart::IOException if the file is truncated.
+     */
+    auto read(std::vector<T>& points, std::size_t count) -> std::size_t
+    {
+        count = std::min(count, remaining_);
+        points.resize(count);
+        read_points_(points.data(), count);
+        return count;
+    }
+
+private:
+    /** Input file */
+    std::ifstream infile_;
+    /** Point encoding */
+    IOMode mode_;
+    /** Parsed header */
+    Header header_;
+    /** Number of points left to read */
+    std::size_t remaining_{0};
+
+    /** Read `n` points into `out` */
+    void read_points_(T* out, std::size_t n)
+    {
+        if (mode_ == IOMode::BINARY) {
+            auto nbytes = n * T::channels * sizeof(typename T::value_type);
+            infile_.read(reinterpret_cast<char*>(out), nbytes);
+        } else {
+            for (std::size_t i = 0; i < n; ++i) {
+                for (std::size_t d = 0; d < T::channels; ++d) {
+                    infile_ >> out[i][d];
+                }
+            }
+        }
+        if (!infile_) {
+            throw IOException("PointSet file is truncated");
+        }
+        remaining_ -= n;
+    }
+};
+
+}  // namespace volcart
@@ -0,0 +1,506 @@
+#pragma once
+
+/** @file */
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <fstream>
+#include <limits>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "vc/core/filesystem.hpp"
+#include "vc/core/io/PointSetIO.hpp"
+#include "vc/core/types/Exceptions.hpp"
+#include "vc/core/types/OrderedPointSet.hpp"
+#include "vc/core/types/PointSet.hpp"
+
+namespace volcart
+{
+
+/**
+ * @class PointSetWriter
+ * @brief Streams points to a binary PointSet file
+ *
+ * Writes a point set which is too large to be held in memory, e.g. the
+ * result of merging many point sets. Points are buffered and appended to
+ * the end of the file, and the size in the header is updated by flush(),
+ * so the file on disk contains every point which has been flushed. The
+ * destructor flushes the remaining points.
+ *
+ * @ingroup IO
+ *
+ * @see volcart::PointSetIO
+ * @see volcart::OrderedPointSetWriter
+ */
+template <typename T>
+class PointSetWriter
+{
+public:
+    /** Number of bytes per point */
+    static constexpr std::size_t POINT_BYTES{
+        T::channels * sizeof(typename T::value_type)};
+
+    /** Default number of points buffered before they are written */
+    static constexpr std::size_t DEFAULT_BUFFER_SIZE{1 << 16};
+
+    /**
+     * @brief Create an empty point set file, replacing any existing file
+     *
+     * Throws volcart::IOException if the file cannot be created.
+     */
+    explicit PointSetWriter(
+        const filesystem::path& path,
+        std::size_t bufferSize = DEFAULT_BUFFER_SIZE)
+        : path_{path}, bufferSize_{std::max<std::size_t>(bufferSize, 1)}
+    {
+        auto header = PointSetIO<T>::MakeHeader(PointSet<T>{});
+        const std::string key{"size: "};
+        sizeOffset_ = header.find(key) + key.size();
+        file_.open(path_.string(), std::ios::out | std::ios::binary);
+        file_.write(header.data(), static_cast<std::streamsize>(header.size()));
+        file_.flush();
+        if (!file_) {
+            auto msg = "could not open file '" + path_.string() + "'";
+            throw IOException(msg);
+        }
+        buffer_.reserve(bufferSize_);
+    }
+
+    /** @brief Write the buffered points and close the file */
+    ~PointSetWriter()
+    {
+        try {
+            flush();
+        } catch (const IOException&) {
+            // Points flushed before the error are still on disk
+        }
+    }
+
+    PointSetWriter(const PointSetWriter&) = delete;
+    auto operator=(const PointSetWriter&) -> PointSetWriter& = delete;
+
+    /** @brief Get the number of points written, including buffered points */
+    [[nodiscard]] auto size() const -> std::size_t
+    {
+        return size_ + buffer_.size();
+    }
+
+    /** @brief Append a point */
+    void write(const T& point)
+    {
+        buffer_.push_back(point);
+        if (buffer_.size() >= bufferSize_) {
+            write_buffer_();
+        }
+    }
+
+    /**
+     * @brief Write the buffered points and update the header
+     *
+     * Throws volcart::IOException if the points cannot be written.
+     */
+    void flush()
+    {
+        write_buffer_();
+        auto field = PointSetIO<T>::PadHeight(size_);
+        file_.seekp(static_cast<std::streamoff>(sizeOffset_));
+        file_.write(field.data(), static_cast<std::streamsize>(field.size()));
+        file_.seekp(0, std::ios::end);
+        file_.flush();
+        if (!file_) {
+            throw IOException("Failed to write PointSet: " + path_.string());
+        }
+    }
+
+private:
+    /** Output file */
+    std::ofstream file_;
+    /** Path of the output file */
+    filesystem::path path_;
+    /** Points which have not been written */
+    std::vector<T> buffer_;
+    /** Maximum number of buffered points */
+    std::size_t bufferSize_;
+    /** Number of points in the file */
+    std::size_t size_{0};
+    /** Offset of the header's size field */
+    std::size_t sizeOffset_{0};
+
+    /** Append the buffered points to the file */
+    void write_buffer_()
+    {
+        if (buffer_.empty()) {
+            return;
+        }
+        for (const auto& p : buffer_) {
+            file_.write(reinterpret_cast<const char*>(p.val), POINT_BYTES);
+        }
+        if (!file_) {
+            throw IOException("Failed to write PointSet: " + path_.string());
+        }
+        size_ += buffer_.size();
+        buffer_.clear();
+    }
+};
+
+/**
+ * @class OrderedPointSetWriter
+ * @brief Appends rows to a binary OrderedPointSet file
+ *
+ * Rows are written to the end of the file as they are added, so growing a
+ * point set does not rewrite the rows which are already on disk. Each row is
+ * written before the height in the header is updated, so an interrupted
+ * write leaves a valid file which contains every completed row: readers
+ * ignore data past the last row in the header, and the partial row is
+ * discarded when the file is next opened for appending.
+ *
+ * Files written by PointSetIO are appendable. Files written by earlier
+ * releases, which do not pad the height field of their header, are rewritten
+ * once by Append().
+ *
+ * @ingroup IO
+ *
+ * @see volcart::PointSetIO
+ * @see volcart::AsyncPointSetWriter
+ */
+template <typename T>
+class OrderedPointSetWriter
+{
+public:
+    /** Number of bytes per point */
+    static constexpr std::size_t POINT_BYTES{
+        T::channels * sizeof(typename T::value_type)};
+
+    /**
+     * @brief Create an empty point set file, replacing any existing file
+     *
+     * Throws volcart::IOException if the file cannot be created.
+     */
+    OrderedPointSetWriter(const filesystem::path& path, std::size_t width)
+        : path_{path}, width_{width}
+    {
+        OrderedPointSet<T> empty(width);
+        PointSetIO<T>::WriteOrderedPointSet(path_, empty);
+        open_();
+    }
+
+    /**
+     * @brief Open an existing point set file for appending
+     *
+     * Keeps the first `keepRows` rows of the file and discards the rest.
+     * Throws volcart::IOException if the file cannot be opened or is not a
+     * binary OrderedPointSet.
+     */
+    static auto Append(
+        const filesystem::path& path,
+        std::size_t keepRows = std::numeric_limits<std::size_t>::max())
+        -> OrderedPointSetWriter
+    {
+        return OrderedPointSetWriter(path, keepRows, AppendTag{});
+    }
+
+    /** @brief Get the width of the point set */
+    [[nodiscard]] auto width() const -> std::size_t { return width_; }
+
+    /** @brief Get the number of rows in the file */
+    [[nodiscard]] auto height() const -> std::size_t { return height_; }
+
+    /**
+     * @brief Append a row to the file
+     *
+     * Throws volcart::IOException if the row does not match the width of the
+     * point set or cannot be written.
+     */
+    void writeRow(const std::vector<T>& row)
+    {
+        if (row.size() != width_) {
+            throw IOException("Row does not match the PointSet width");
+        }
+        write_rows_(row.data(), 1);
+    }
+
+    /** @brief Append every row of a point set to the file */
+    void writeRows(const OrderedPointSet<T>& ps)
+    {
+        if (ps.empty()) {
+            return;
+        }
+        if (ps.width() != width_) {
+            throw IOException("Rows do not match the PointSet width");
+        }
+        write_rows_(&ps[0], ps.height());
+    }
+
+private:
+    /** Tag for the append constructor */
+    struct AppendTag {
+    };
+
+    /** Output file */
+    std::fstream file_;
+    /** Path of the output file */
+    filesystem::path path_;
+    /** Width of the point set */
+    std::size_t width_{0};
+    /** Number of rows in the file */
+    std::size_t height_{0};
+    /** Offset of the first point */
+    std::size_t dataOffset_{0};
+    /** Offset of the header's height field */
+    std::size_t heightOffset_{0};
+
+    /** Open an existing file for appending */
+    OrderedPointSetWriter(
+        const filesystem::path& path, std::size_t keepRows, AppendTag)
+        : path_{path}
+    {
+        if (not parse_header_()) {
+            // Rewrite the file with an appendable header
+            auto ps = PointSetIO<T>::ReadOrderedPointSet(path_);
+            if (keepRows < ps.height()) {
+                ps = ps.copyRows(0, keepRows);
+            }
+            PointSetIO<T>::WriteOrderedPointSet(path_, ps);
+        }
+        open_();
+        height_ = std::min(height_, keepRows);
+        if (row_bytes_() > 0) {
+            auto size = filesystem::file_size(path_);
+            auto rows = size > dataOffset_ ? (size - dataOffset_) / row_bytes_()
+                                           : 0;
+            height_ = std::min<std::size_t>(height_, rows);
+        }
+
+        // Discard the discarded rows and any partially written row
+        file_.close();
+        filesystem::resize_file(path_, dataOffset_ + height_ * row_bytes_());
+        file_.open(
+            path_.string(), std::ios::in | std::ios::out | std::ios::binary);
+        write_height_();
+    }
+
+    /** Bytes per row */
+    [[nodiscard]] auto row_bytes_() const -> std::size_t
+    {
+        return width_ * POINT_BYTES;
+    }
+
+    /**
+     * Parse the header of the file. Returns false if the height field is not
+     * padded for in-place updates.
+     */
+    auto parse_header_() -> bool
+    {
+        std::ifstream infile{path_.string(), std::ios::binary};
+        if (!infile.is_open()) {
+            auto msg = "could not open file '" + path_.string() + "'";
+            throw IOException(msg);
+        }
+        auto header = PointSetIO<T>::ParseHeader(infile, true);
+        width_ = header.width;
+        height_ = header.height;
+        dataOffset_ = static_cast<std::size_t>(infile.tellg());
+
+        // Find the height field
+        const std::string key{"height: "};
+        const auto fieldWidth = PointSetIO<T>::HEIGHT_FIELD_WIDTH;
+        infile.clear();
+        infile.seekg(0);
+        std::string line;
+        while (std::getline(infile, line)) {
+            if (line.compare(0, key.size(), key) == 0) {
+                if (line.size() != key.size() + fieldWidth) {
+                    return false;
+                }
+                heightOffset_ =
+                    static_cast<std::size_t>(infile.tellg()) - line.size() - 1 +
+                    key.size();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /** Open the file and find its header fields */
+    void open_()
+    {
+        if (not parse_header_()) {
+            throw IOException("Cannot append to PointSet: " + path_.string());
+        }
+        file_.open(
+            path_.string(), std::ios::in | std::ios::out | std::ios::binary);
+        if (!file_.is_open()) {
+            auto msg = "could not open file '" + path_.string() + "'";
+            throw IOException(msg);
+        }
+    }
+
+    /** Write the height into the header */
+    void write_height_()
+    {
+        auto field = PointSetIO<T>::PadHeight(height_);
+        file_.seekp(static_cast<std::streamoff>(heightOffset_));
+        file_.write(field.data(), static_cast<std::streamsize>(field.size()));
+        file_.flush();
+        if (!file_) {
+            throw IOException("Failed to write PointSet: " + path_.string());
+        }
+    }
+
+    /** Write `rows` rows, then update the header */
+    void write_rows_(const T* points, std::size_t rows)
+    {
+        file_.seekp(
+            static_cast<std::streamoff>(dataOffset_ + height_ * row_bytes_()));
+        for (std::size_t i = 0; i < rows * width_; ++i) {
+            file_.write(
+                reinterpret_cast<const char*>(points[i].val), POINT_BYTES);
+        }
+        file_.flush();
+        if (!file_) {
+            throw IOException("Failed to write PointSet: " + path_.string());
+        }
+        height_ += rows;
+        write_height_();
+    }
+};
+
+/**
+ * @class AsyncPointSetWriter
+ * @brief Appends rows to an OrderedPointSet file on a background thread
+ *
+ * Checkpoints a growing point set, e.g. the output of a long segmentation
+ * run, without stalling the thread which produces it. Rows passed to
+ * writeRow() are queued and written by an OrderedPointSetWriter on a
+ * background thread, so the file on disk always contains every row which has
+ * been written so far.
+ *
+ * If a write fails, the error is rethrown by the next call to writeRow() or
+ * flush(). The destructor waits for the queued rows to be written.
+ *
+ * @ingroup IO
+ */
+template <typename T>
+class AsyncPointSetWriter
+{
+public:
+    /** @brief Write rows with `writer` */
+    explicit AsyncPointSetWriter(OrderedPointSetWriter<T> writer)
+        : writer_{std::move(writer)}
+    {
+        thread_ = std::thread([this]() { run_(); });
+    }
+
+    /** @brief Write the queued rows and stop the background thread */
+    ~AsyncPointSetWriter()
+    {
+        {
+            const std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        cv_.notify_all();
+        thread_.join();
+    }
+
+    AsyncPointSetWriter(const AsyncPointSetWriter&) = delete;
+    auto operator=(const AsyncPointSetWriter&) -> AsyncPointSetWriter& = delete;
+
+    /** @brief Get the width of the point set */
+    [[nodiscard]] auto width() const -> std::size_t { return writer_.width(); }
+
+    /** @brief Queue a row to be appended to the file */
+    void writeRow(std::vector<T> row)
+    {
+        if (row.size() != writer_.width()) {
+            throw IOException("Row does not match the PointSet width");
+        }
+        {
+            const std::lock_guard<std::mutex> lock(mutex_);
+            rethrow_();
+            queue_.emplace_back(std::move(row));
+        }
+        cv_.notify_all();
+    }
+
+    /**
+     * @brief Wait until every queued row has been written
+     *
+     * @return The number of rows in the file
+     */
+    auto flush() -> std::size_t
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [this]() { return queue_.empty() and not busy_; });
+        rethrow_();
+        return writer_.height();
+    }
+
+private:
+    /** Writer */
+    OrderedPointSetWriter<T> writer_;
+    /** Rows which have not been written */
+    std::deque<std::vector<T>> queue_;
+    /** Whether the background thread is writing a row */
+    bool busy_{false};
+    /** Whether the background thread should stop */
+    bool stop_{false};
+    /** The first write error */
+    std::exception_ptr error_;
+    /** Guards the queue and state */
+    std::mutex mutex_;
+    /** Signals queue and state changes */
+    std::condition_variable cv_;
+    /** Background thread */
+    std::thread thread_;
+
+    /** Rethrow and clear the stored write error. Requires the lock. */
+    void rethrow_()
+    {
+        if (error_) {
+            auto e = error_;
+            error_ = nullptr;
+            std::rethrow_exception(e);
+        }
+    }
+
+    /** Background thread: write the queued rows */
+    void run_()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (true) {
+            cv_.wait(lock, [this]() { return stop_ or not queue_.empty(); });
+            if (queue_.empty()) {
+                return;
+            }
+
+            // Write every queued row at once
+            OrderedPointSet<T> rows(writer_.width());
+            while (not queue_.empty()) {
+                rows.pushRow(queue_.front());
+                queue_.pop_front();
+            }
+            busy_ = true;
+            lock.unlock();
+            std::exception_ptr error;
+            try {
+                writer_.writeRows(rows);
+            } catch (...) {
+                error = std::current_exception();
+            }
+            lock.lock();
+            busy_ = false;
+            if (error and not error_) {
+                error_ = error;
+            }
+            cv_.notify_all();
+        }
+    }
+};
+
+}  // namespace volcart
@@ -10,6 +10,11 @@
 
 #pragma once
 
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
 #include <opencv2/core.hpp>
 
 #include "vc/core/filesystem.hpp"
@@ -44,17 +49,220 @@ enum class Compression {
     JBIG = 34661,
     SGILOG = 34676,
     SGILOG24 = 34677,
-    JP2000 = 34712
+    JP2000 = 34712,
+    LZMA = 34925,
+    ZSTD = 50000
 };
 
+/**
+ * @brief Whether the linked libtiff can encode and decode a compression
+ * scheme
+ *
+ * LZMA and ZSTD are optional libtiff codecs, so they may be unavailable.
+ */
+auto CompressionAvailable(Compression c) -> bool;
+
+/**
+ * @brief Get the name of a compression scheme
+ *
+ * Names are lower case, such as `lzw` or `zstd`, and are understood by
+ * CompressionFromString().
+ */
+auto CompressionToString(Compression c) -> std::string;
+
+/**
+ * @brief Get a compression scheme by name
+ *
+ * Accepts the names of the lossless schemes: `none`, `lzw`, `deflate`,
+ * `packbits`, `lzma` and `zstd`. Case insensitive.
+ *
+ * @throws std::invalid_argument If the name is not recognized
+ */
+auto CompressionFromString(const std::string& s) -> Compression;
+
+/**
+ * @brief Read a TIFF image from file
+ *
+ * Only the strips or tiles which intersect `roi` are decoded, so reading a
+ * small region of a large image is proportionally cheaper than reading the
+ * whole image. An empty `roi` reads the whole image. Otherwise, `roi` is
+ * clipped to the image bounds.
+ *
+ * Strips and tiles are decoded in parallel on `numThreads` threads, each of
+ * which opens its own handle to the file. If `numThreads` is 0, the number of
+ * hardware threads is used.
+ *
+ * Like cv::imread(), 3 and 4 channel images are returned in BGR(A) order.
+ * Images which cannot be decoded strip by strip, such as planar, palette, or
+ * YCbCr images, are read with cv::imread() and cropped.
+ *
+ * @throws std::runtime_error If the file cannot be read
+ */
+auto ReadTIFF(
+    const volcart::filesystem::path& path,
+    const cv::Rect& roi = {},
+    std::size_t numThreads = 1) -> cv::Mat;
+
+/**
+ * @brief Read a TIFF image from memory
+ *
+ * Decodes a TIFF file which has already been loaded into memory, such as an
+ * object downloaded from a remote server. Otherwise identical to reading the
+ * image from a file.
+ *
+ * @throws std::runtime_error If the data cannot be decoded
+ */
+auto ReadTIFF(
+    const std::vector<char>& data,
+    const cv::Rect& roi = {},
+    std::size_t numThreads = 1) -> cv::Mat;
+
 /**
  * @brief Write a TIFF image to file
  *
  * Supports writing floating point and signed integer TIFFs, in addition to
  * unsigned 8 & 16 bit integer types. Also supports 1-4 channel images.
+ *
+ * The image is split into strips of `rowsPerStrip` rows so that readers can
+ * decode regions of the image and decode strips in parallel. If
+ * `rowsPerStrip` is 0, strips of approximately 256 KiB are written.
+ *
+ * Images with more than 2 GiB of uncompressed data are written as BigTIFF,
+ * since their offsets may not fit in a classic TIFF.
+ *
+ * Integer images compressed with DEFLATE, LZMA or ZSTD are stored with the
+ * horizontal differencing predictor, which makes smooth images such as CT
+ * slices much more compressible. LZW images are written without it for
+ * compatibility with existing files.
+ *
+ * @throws std::runtime_error If `compression` is not available in libtiff
  */
 void WriteTIFF(
     const volcart::filesystem::path& path,
     const cv::Mat& img,
-    Compression compression = Compression::LZW);
+    Compression compression = Compression::LZW,
+    std::size_t rowsPerStrip = 0);
+
+/**
+ * @brief Write a tiled TIFF image one region at a time
+ *
+ * The image is split into square tiles of `tileSize` pixels, and regions of
+ * the image are encoded and written to disk as soon as they are passed to
+ * writeRegion(). This allows images which are far larger than the available
+ * memory to be written in pieces. Tiled images can be read with ReadTIFF(),
+ * which only decodes the tiles intersecting the requested region.
+ *
+ * Regions must be aligned to the tile grid and must cover whole tiles,
+ * except along the right and bottom edges of the image. Tiles which have not
+ * been written when the writer is closed are filled with zeros.
+ *
+ * When a region covers more than one tile, its tiles can be compressed in
+ * parallel (see setNumThreads()). The compressed tiles are still written to
+ * the file in tile order, so the file does not depend on the number of
+ * threads. JPEG and the other schemes whose tiles depend on
+ * shared tables are always compressed by a single thread.
+ *
+ * Supports the same image types as WriteTIFF(). Like WriteTIFF(), images
+ * with more than 2 GiB of uncompressed data are written as BigTIFF.
+ */
+class TiledTIFFWriter
+{
+public:
+    /**
+     * @brief Open a tiled TIFF for writing
+     *
+     * @param path Output path. Must have a TIFF extension.
+     * @param width Image width
+     * @param height Image height
+     * @param cvType OpenCV type of the image (e.g. `CV_16UC1`)
+     * @param tileSize Tile width and height. Must be a multiple of 16.
+     * @param compression Compression scheme
+     *
+     * @throws std::invalid_argument If the dimensions or tile size are
+     * invalid
+     * @throws std::runtime_error If the type is not supported or the file
+     * cannot be opened
+     */
+    TiledTIFFWriter(
+        const volcart::filesystem::path& path,
+        int width,
+        int height,
+        int cvType,
+        int tileSize = 256,
+        Compression compression = Compression::LZW);
+
+    /** @brief Close the file. Errors are ignored. See close(). */
+    ~TiledTIFFWriter();
+
+    /**@{*/
+    TiledTIFFWriter(const TiledTIFFWriter&) = delete;
+    auto operator=(const TiledTIFFWriter&) -> TiledTIFFWriter& = delete;
+    /**@}*/
+
+    /** @brief Image width */
+    [[nodiscard]] auto width() const -> int;
+    /** @brief Image height */
+    [[nodiscard]] auto height() const -> int;
+    /** @brief Tile width and height */
+    [[nodiscard]] auto tileSize() const -> int;
+
+    /**
+     * @brief Set the number of threads used to compress tiles
+     *
+     * If `0`, uses every thread in the global ThreadPool. Default: 1
+     */
+    void setNumThreads(std::size_t n);
+    /** @brief Number of threads used to compress tiles */
+    [[nodiscard]] auto numThreads() const -> std::size_t;
+
+    /**
+     * @brief Write a region of the image
+     *
+     * @param origin Position of the top-left corner of `img` in the image
+     * @param img Region image. Must have the type given to the constructor.
+     *
+     * @throws std::invalid_argument If the region does not match the type or
+     * tile grid of the image
+     * @throws std::out_of_range If the region is not within the image
+     * @throws std::runtime_error If the writer is closed or a tile cannot be
+     * written
+     */
+    void writeRegion(const cv::Point& origin, cv::Mat img);
+
+    /**
+     * @brief Fill unwritten tiles and close the file
+     *
+     * Further writes throw. Does nothing if the file is already closed.
+     */
+    void close();
+
+private:
+    /** libtiff handle */
+    struct Handle;
+    /** Open file */
+    std::unique_ptr<Handle> handle_;
+    /** Image width */
+    int width_{0};
+    /** Image height */
+    int height_{0};
+    /** Image type */
+    int cvType_{0};
+    /** Tile width and height */
+    int tileSize_{0};
+    /** Compression scheme */
+    Compression compression_{Compression::LZW};
+    /** Number of compression threads */
+    std::size_t numThreads_{1};
+    /** Number of tile columns */
+    int tilesX_{0};
+    /** Number of tile rows */
+    int tilesY_{0};
+    /** Whether each tile has been written */
+    std::vector<bool> written_;
+
+    /** Write a tile-sized image at the tile with the given origin */
+    void write_tile_(int x, int y, cv::Mat& tile);
+    /** Write an already compressed tile at the tile with the given origin */
+    void write_encoded_tile_(int x, int y, std::vector<char>& data);
+};
 }  // namespace volcart::tiffio
@@ -0,0 +1,127 @@
+#pragma once
+
+/** @file */
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace volcart::io
+{
+
+/**
+ * @class TextScanner
+ * @brief Allocation-free tokenizer for line-based text formats
+ *
+ * Scans whitespace-delimited tokens and numbers from a character buffer,
+ * such as the contents of an io::MappedFile. Tokens never span lines: the
+ * caller reads the tokens of a line and then calls nextLine(). Spaces, tabs,
+ * and carriage returns are treated as token separators.
+ *
+ * Floating-point numbers with at most 19 significant digits and a small
+ * exponent are converted directly. This is exact and correctly rounded.
+ * Other numbers fall back to `std::strtod`.
+ *
+ * @ingroup IO
+ */
+class TextScanner
+{
+public:
+    /** @brief Scan the range [begin, end) */
+    TextScanner(const char* begin, const char* end) : pos_{begin}, end_{end}
+    {
+    }
+
+    /** @brief Whether the whole buffer has been consumed */
+    [[nodiscard]] auto atEnd() const -> bool { return pos_ >= end_; }
+
+    /** @brief Whether the current line has no more tokens */
+    auto atLineEnd() -> bool
+    {
+        skip_space_();
+        return pos_ >= end_ or *pos_ == '\n';
+    }
+
+    /** @brief Advance to the start of the next line */
+    void nextLine();
+
+    /**
+     * @brief Get the next token on the current line
+     *
+     * Returns an empty view if the line has no more tokens.
+     */
+    auto token() -> std::string_view;
+
+    /**
+     * @brief Parse the next token on the current line as a double
+     *
+     * Returns false and leaves the position unchanged if the line has no more
+     * tokens or the token does not start with a number.
+     */
+    auto parseDouble(double& v) -> bool;
+
+    /**
+     * @brief Parse a signed integer at the current position
+     *
+     * Returns false and leaves the position unchanged if the line has no more
+     * tokens or the token does not start with an integer. Unlike
+     * parseDouble(), stops at the first character which is not part of the
+     * number, so that delimited values like `1/2/3` can be parsed in parts.
+     */
+    auto parseInt(std::int64_t& v) -> bool;
+
+    /**
+     * @brief Consume `c` if it is the next character
+     *
+     * Does not skip whitespace.
+     */
+    auto consume(char c) -> bool
+    {
+        if (pos_ < end_ and *pos_ == c) {
+            ++pos_;
+            return true;
+        }
+        return false;
+    }
+
+    /** @brief Whether the next character ends the current token */
+    [[nodiscard]] auto atSeparator() const -> bool
+    {
+        return pos_ >= end_ or *pos_ == ' ' or *pos_ == '\t' or
+               *pos_ == '\r' or *pos_ == '\n';
+    }
+
+    /** @brief Get the current position */
+    [[nodiscard]] auto position() const -> const char* { return pos_; }
+
+private:
+    /** Current position */
+    const char* pos_;
+    /** End of the buffer */
+    const char* end_;
+
+    /** Skip token separators on the current line */
+    void skip_space_()
+    {
+        while (pos_ < end_ and (*pos_ == ' ' or *pos_ == '\t' or *pos_ == '\r'))
+        {
+            ++pos_;
+        }
+    }
+};
+
+/**
+ * @brief Split a buffer into at most `n` ranges of whole lines
+ *
+ * Ranges are approximately the same size, are in buffer order, and do not
+ * overlap. Every range except the last ends just after a newline. Ranges are
+ * never smaller than `minSize` bytes, so small buffers produce fewer than `n`
+ * ranges.
+ */
+auto SplitLines(
+    const char* begin, const char* end, std::size_t n, std::size_t minSize)
+    -> std::vector<std::pair<const char*, const char*>>;
+
+}  // namespace volcart::io
@@ -5,9 +5,31 @@
 
 namespace volcart::io
 {
+/** @brief UVMap file formats */
+enum class UVMapFormat {
+    /**
+     * @brief Text header followed by an (ID, UV) record for every mapping.
+     * Version 1 of the .uvm format.
+     */
+    Archive = 0,
+    /**
+     * @brief Binary header followed by the raw UVMap storage. Version 2 of
+     * the .uvm format. Memory mapped when read.
+     */
+    Binary
+};
+
 /** @brief Write a UVMap in the custom .uvm archival format */
-void WriteUVMap(const filesystem::path& path, const UVMap& uvMap);
+void WriteUVMap(
+    const filesystem::path& path,
+    const UVMap& uvMap,
+    UVMapFormat format = UVMapFormat::Binary);
 
-/** @brief Read a UVMap from the custom .uvm archival format */
+/**
+ * @brief Read a UVMap from the custom .uvm archival format
+ *
+ * The file format is detected automatically. Binary files are memory mapped
+ * and copied into the UVMap in a single pass.
+ */
 auto ReadUVMap(const filesystem::path& path) -> UVMap;
 }  // namespace volcart::io
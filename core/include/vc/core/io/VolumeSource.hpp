@@ -0,0 +1,140 @@
+#pragma once
+
+/** @file */
+
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "vc/core/filesystem.hpp"
+#include "vc/core/io/AsyncReader.hpp"
+#include "vc/core/types/DiskCache.hpp"
+
+namespace volcart::io
+{
+
+/**
+ * @class VolumeSource
+ * @brief Storage backend which provides the encoded slices and blocks of a
+ * Volume
+ *
+ * A Volume normally reads its slice and block files from its own directory.
+ * A VolumeSource instead provides these files by name, so the image data of a
+ * volume can be stored elsewhere, such as on a remote HTTP server or in an
+ * object store, while its metadata stays in the volume package. Names are
+ * paths relative to the root of the source, using `/` as the separator, such
+ * as `0042.tif` or `blocks/0_1_2.tif`.
+ *
+ * Implementations must be safe to call from many threads at once, since the
+ * Volume prefetcher loads several slices concurrently.
+ *
+ * @see Volume::setSource()
+ * @ingroup IO
+ */
+class VolumeSource
+{
+public:
+    /** Shared pointer type */
+    using Pointer = std::shared_ptr<VolumeSource>;
+
+    /** Destructor */
+    virtual ~VolumeSource() = default;
+
+    /**
+     * @brief Read the complete contents of an object
+     *
+     * Returns std::nullopt if the object does not exist.
+     *
+     * @throws volcart::IOException if the object cannot be read
+     */
+    virtual auto read(const std::string& name)
+        -> std::optional<std::vector<char>> = 0;
+
+    /**
+     * @brief Read the complete contents of an object asynchronously
+     *
+     * Calls `done` on one of the reader's completion threads with the result
+     * of read(). The default implementation runs read() as a blocking read
+     * with AsyncReader::submit(). Sources which can keep many reads in flight
+     * override this.
+     */
+    virtual void readAsync(
+        const std::string& name,
+        AsyncReader& reader,
+        AsyncReader::Callback done);
+
+    /**
+     * @brief Get the version of an object
+     *
+     * Used to validate the entries of a DiskCache. Returns a zero stamp if
+     * the object does not exist or if its version is unknown, in which case
+     * the object is not disk cached.
+     */
+    virtual auto stamp(const std::string& name) -> DiskCache::Stamp = 0;
+
+    /** @brief Get the location of the source, for messages */
+    [[nodiscard]] virtual auto uri() const -> std::string = 0;
+
+    /**
+     * @brief Open the source for a URI
+     *
+     * `http://` and `https://` URIs open an HTTPVolumeSource, as do `s3://`
+     * URIs, which are mapped to their HTTPS endpoint. `file://` URIs and
+     * other strings open a LocalVolumeSource. Relative paths are resolved
+     * against `base`.
+     *
+     * @throws std::runtime_error if the URI requires a backend which was not
+     * built
+     */
+    static auto Open(
+        const std::string& uri, const filesystem::path& base = {}) -> Pointer;
+
+protected:
+    /** Default constructor */
+    VolumeSource() = default;
+};
+
+/**
+ * @class LocalVolumeSource
+ * @brief VolumeSource which reads files from a local directory
+ *
+ * @ingroup IO
+ */
+class LocalVolumeSource final : public VolumeSource
+{
+public:
+    /** Shared pointer type */
+    using Pointer = std::shared_ptr<LocalVolumeSource>;
+
+    /** @brief Constructor */
+    explicit LocalVolumeSource(filesystem::path root);
+
+    /** @copydoc LocalVolumeSource(filesystem::path) */
+    static auto New(filesystem::path root) -> Pointer;
+
+    /** @brief Get the source directory */
+    [[nodiscard]] auto root() const -> filesystem::path;
+
+    /** @copydoc VolumeSource::read() */
+    auto read(const std::string& name)
+        -> std::optional<std::vector<char>> override;
+
+    /** @brief Read the file with the reader's I/O engine */
+    void readAsync(
+        const std::string& name,
+        AsyncReader& reader,
+        AsyncReader::Callback done) override;
+
+    /** @brief The size and modification time of the file */
+    auto stamp(const std::string& name) -> DiskCache::Stamp override;
+
+    /** @copydoc VolumeSource::uri() */
+    [[nodiscard]] auto uri() const -> std::string override;
+
+private:
+    /** Source directory */
+    filesystem::path root_;
+};
+
+}  // namespace volcart::io
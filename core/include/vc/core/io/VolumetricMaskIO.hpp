@@ -0,0 +1,21 @@
+#pragma once
+
+/** @file */
+
+#include "vc/core/filesystem.hpp"
+#include "vc/core/types/VolumetricMask.hpp"
+
+namespace volcart::io
+{
+/**
+ * @brief Write a VolumetricMask in the custom .vcvm block format
+ *
+ * Only the allocated mask blocks are written, so the file size is
+ * proportional to the mask's memory footprint rather than its voxel count.
+ */
+void WriteVolumetricMask(
+    const filesystem::path& path, const VolumetricMask& mask);
+
+/** @brief Read a VolumetricMask from the custom .vcvm block format */
+auto ReadVolumetricMask(const filesystem::path& path) -> VolumetricMask;
+}  // namespace volcart::io
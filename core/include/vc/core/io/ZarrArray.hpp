@@ -0,0 +1,165 @@
+#pragma once
+
+/** @file */
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+#include "vc/core/io/VolumeSource.hpp"
+
+namespace volcart::io
+{
+
+/**
+ * @class ZarrArray
+ * @brief Reader for the chunks of a 3D Zarr or N5 array
+ *
+ * Reads the chunked arrays which acquisition pipelines write as OME-Zarr or
+ * N5, so a Volume can use them without conversion to a TIFF stack. The array
+ * at `path` in a VolumeSource is opened as a Zarr v2 array if it has a
+ * `.zarray` file, or as an N5 dataset if it has an `attributes.json` file
+ * with array dimensions.
+ *
+ * Arrays must have 3 dimensions, ordered ZYX in Zarr and XYZ in N5, or more
+ * dimensions of which all but the last 3 have size 1, like the TCZYX arrays
+ * of OME-Zarr. Unsigned 8 and 16-bit samples are supported. Chunks may be
+ * uncompressed or compressed with zlib, gzip, zstd or blosc. zstd and blosc
+ * require building with `VC_WITH_ZSTD` and `VC_WITH_BLOSC`.
+ *
+ * Chunks are returned in the layout of Volume::getBlockData(): an image with
+ * `chunkShape()[0]` columns and `chunkShape()[1] * chunkShape()[2]` rows in
+ * which the Z-planes of the chunk are stacked vertically. 8-bit chunks are
+ * scaled to 16 bits. Chunks which do not exist are filled with the fill value
+ * of the array.
+ *
+ * All member functions are safe to call concurrently.
+ *
+ * @ingroup IO
+ */
+class ZarrArray
+{
+public:
+    /** Shared pointer type */
+    using Pointer = std::shared_ptr<ZarrArray>;
+
+    /** @brief Array storage layouts */
+    enum class Layout {
+        /** Zarr v2 */
+        Zarr,
+        /** N5 */
+        N5
+    };
+
+    /** @brief Chunk compressors */
+    enum class Compressor {
+        /** Uncompressed */
+        None,
+        /** zlib or gzip */
+        Zlib,
+        /** zstd */
+        Zstd,
+        /** blosc */
+        Blosc
+    };
+
+    /**
+     * @brief Open an array
+     *
+     * @param source Storage of the array
+     * @param path Path of the array in `source`. Empty for the root.
+     *
+     * @throws volcart::IOException if the array cannot be read or is not
+     * supported
+     */
+    ZarrArray(VolumeSource::Pointer source, std::string path);
+
+    /** @copydoc ZarrArray(VolumeSource::Pointer, std::string) */
+    static auto New(VolumeSource::Pointer source, std::string path)
+        -> Pointer;
+
+    /**
+     * @brief Get the paths of the arrays of a multiscale group
+     *
+     * Reads the OME-Zarr `multiscales` metadata, or the `scales` convention
+     * of N5 viewers, of the group at `path`. Arrays are ordered from the
+     * highest to the lowest resolution. If `path` is itself an array or has
+     * no multiscale metadata, returns `{path}`.
+     */
+    static auto MultiscaleArrays(VolumeSource& source, const std::string& path)
+        -> std::vector<std::string>;
+
+    /** @brief Get the storage layout */
+    [[nodiscard]] auto layout() const -> Layout;
+
+    /** @brief Get the array size as (x, y, z) */
+    [[nodiscard]] auto shape() const -> cv::Vec3i;
+
+    /** @brief Get the chunk size as (x, y, z) */
+    [[nodiscard]] auto chunkShape() const -> cv::Vec3i;
+
+    /** @brief Get the number of chunks along each axis as (x, y, z) */
+    [[nodiscard]] auto chunkGridSize() const -> cv::Vec3i;
+
+    /** @brief Get the name of a chunk's object in the source */
+    [[nodiscard]] auto chunkName(int cx, int cy, int cz) const -> std::string;
+
+    /**
+     * @brief Read and decode a chunk
+     *
+     * @throws volcart::IOException if the chunk cannot be read or decoded
+     */
+    [[nodiscard]] auto readChunk(int cx, int cy, int cz) const -> cv::Mat;
+
+    /**
+     * @brief Decode the contents of a chunk's object
+     *
+     * For chunks read by other means, such as VolumeSource::readAsync().
+     * A null `data` is a missing chunk, which is filled with the fill value.
+     *
+     * @throws volcart::IOException if the chunk cannot be decoded
+     */
+    [[nodiscard]] auto decodeChunk(
+        const std::optional<std::vector<char>>& data) const -> cv::Mat;
+
+private:
+    /** Parse a Zarr `.zarray` file */
+    void parse_zarr_(const std::string& text);
+    /** Parse an N5 `attributes.json` file */
+    void parse_n5_(const std::string& text);
+    /** Copy decompressed samples into a chunk image */
+    void decode_samples_(
+        const char* data,
+        std::size_t size,
+        const cv::Vec3i& dims,
+        cv::Mat& chunk) const;
+
+    /** Array storage */
+    VolumeSource::Pointer source_;
+    /** Path of the array in the source */
+    std::string path_;
+    /** Storage layout */
+    Layout layout_{Layout::Zarr};
+    /** Array size (x, y, z) */
+    cv::Vec3i shape_;
+    /** Chunk size (x, y, z) */
+    cv::Vec3i chunks_;
+    /** Number of leading size-1 dimensions */
+    std::size_t extraDims_{0};
+    /** Bytes per sample */
+    std::size_t sampleBytes_{2};
+    /** Whether samples are stored big-endian */
+    bool bigEndian_{false};
+    /** Chunk compressor */
+    Compressor compressor_{Compressor::None};
+    /** Separator of the chunk indices in chunk names */
+    std::string separator_{"."};
+    /** Value of the samples of missing chunks */
+    std::uint16_t fill_{0};
+};
+
+}  // namespace volcart::io
@@ -0,0 +1,106 @@
+#pragma once
+
+/** @file */
+
+#include <memory>
+
+#include <opencv2/core.hpp>
+
+#include "vc/core/filesystem.hpp"
+#include "vc/core/io/ZarrArray.hpp"
+
+namespace volcart::io
+{
+
+/**
+ * @class ZarrWriter
+ * @brief Writer for the chunks of a 3D Zarr v2 array
+ *
+ * Creates a Zarr v2 array of unsigned 16-bit samples (`<u2`) in a directory,
+ * ordered ZYX like the arrays read by ZarrArray. The `.zarray` metadata is
+ * written when the writer is constructed, and each chunk is written to its
+ * own file by writeChunk(), so chunks can be written in any order and from
+ * several threads at once. Chunks which are never written are read as the
+ * array's fill value, 0.
+ *
+ * Chunks are passed in the layout of ZarrArray::readChunk(): an image with
+ * `chunkShape()[0]` columns and `chunkShape()[1] * chunkShape()[2]` rows in
+ * which the Z-planes of the chunk are stacked vertically. Chunks along the
+ * edges of the array are stored at the full chunk size, as required by
+ * Zarr v2.
+ *
+ * Chunks may be uncompressed or compressed with zlib.
+ *
+ * @ingroup IO
+ */
+class ZarrWriter
+{
+public:
+    /** Shared pointer type */
+    using Pointer = std::shared_ptr<ZarrWriter>;
+
+    /** zlib compression level of compressed chunks */
+    static constexpr int ZLIB_LEVEL{1};
+
+    /**
+     * @brief Create an array
+     *
+     * @param path Array directory. Created if it does not exist.
+     * @param shape Array size as (x, y, z)
+     * @param chunkShape Chunk size as (x, y, z)
+     * @param compressor Chunk compressor
+     *
+     * @throws std::invalid_argument If the shapes are not positive or the
+     * compressor is not supported
+     * @throws volcart::IOException If the metadata cannot be written
+     */
+    ZarrWriter(
+        filesystem::path path,
+        const cv::Vec3i& shape,
+        const cv::Vec3i& chunkShape,
+        ZarrArray::Compressor compressor = ZarrArray::Compressor::Zlib);
+
+    /** @copydoc ZarrWriter() */
+    static auto New(
+        filesystem::path path,
+        const cv::Vec3i& shape,
+        const cv::Vec3i& chunkShape,
+        ZarrArray::Compressor compressor = ZarrArray::Compressor::Zlib)
+        -> Pointer;
+
+    /** @brief Get the array directory */
+    [[nodiscard]] auto path() const -> const filesystem::path&;
+
+    /** @brief Get the array size as (x, y, z) */
+    [[nodiscard]] auto shape() const -> cv::Vec3i;
+
+    /** @brief Get the chunk size as (x, y, z) */
+    [[nodiscard]] auto chunkShape() const -> cv::Vec3i;
+
+    /** @brief Get the number of chunks along each axis as (x, y, z) */
+    [[nodiscard]] auto chunkGridSize() const -> cv::Vec3i;
+
+    /**
+     * @brief Compress and write a chunk
+     *
+     * Replaces the chunk if it has already been written. Safe to call
+     * concurrently for different chunks.
+     *
+     * @throws std::invalid_argument If the chunk index is outside of the
+     * grid or the chunk has the wrong size or type
+     * @throws volcart::IOException If the chunk cannot be written
+     */
+    void writeChunk(int cx, int cy, int cz, const cv::Mat& chunk) const;
+
+private:
+    /** Array directory */
+    filesystem::path path_;
+    /** Array size (x, y, z) */
+    cv::Vec3i shape_;
+    /** Chunk size (x, y, z) */
+    cv::Vec3i chunks_;
+    /** Chunk compressor */
+    ZarrArray::Compressor compressor_;
+};
+
+}  // namespace volcart::io
@@ -0,0 +1,106 @@
+/**
+ * @file
+ *
+ * @brief Separable 3D filters for Tensor3D
+ *
+ * All filters compute a correlation (like cv::sepFilter2D()) and replicate
+ * the border of the input. Each 1D pass is written as a sequence of
+ * multiply-adds over contiguous rows of the Tensor3D, which the compiler
+ * vectorizes. The multiply-adds are also compiled for AVX2 and AVX-512, and
+ * the version for the CPU is selected at run time. See simd::ActivePath().
+ * Every version gives bitwise identical results.
+ *
+ * @ingroup Math
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+#include "vc/core/math/Tensor3D.hpp"
+#include "vc/core/util/CPUFeatures.hpp"
+
+namespace volcart
+{
+/** @brief 1D filter kernel. Must have an odd number of elements. */
+using Kernel1D = std::vector<double>;
+
+/** @brief Axis of a Tensor3D */
+enum class TensorAxis { X, Y, Z };
+
+/**
+ * @brief Compute `y[i] += w * x[i]` for `n` elements
+ *
+ * The multiply-add which every filter pass is built from. Uses the version
+ * for `path`, or the next lower path which has one. Every version rounds
+ * the product and the sum separately, so all paths give bitwise identical
+ * results.
+ */
+void ScaledAdd(
+    double w,
+    const double* x,
+    double* y,
+    std::size_t n,
+    simd::Path path = simd::ActivePath());
+
+/**
+ * @brief Get a normalized 1D Gaussian kernel
+ *
+ * The kernel has `2 * radius + 1` elements and sums to 1.
+ *
+ * @throws std::invalid_argument If radius is negative or sigma is not
+ * positive
+ */
+auto GaussianKernel1D(int radius, double sigma = 1.0) -> Kernel1D;
+
+/**
+ * @brief Get the separable components of a first-order derivative kernel
+ *
+ * Returns the derivative kernel and the smoothing kernel of the operator
+ * used by cv::Sobel() with the same `ksize`. If `ksize == 3`, returns the
+ * components of the Scharr operator instead.
+ *
+ * @param ksize Kernel size. One of 1, 3, 5, 7.
+ * @throws std::invalid_argument If ksize is not supported
+ */
+auto DerivativeKernels1D(int ksize) -> std::array<Kernel1D, 2>;
+
+/**
+ * @brief Correlate a Tensor3D with a 1D kernel along an axis
+ *
+ * An empty kernel copies the input.
+ *
+ * @throws std::invalid_argument If the kernel has an even number of elements
+ */
+auto Correlate1D(
+    const Tensor3D<double>& input, const Kernel1D& kernel, TensorAxis axis)
+    -> Tensor3D<double>;
+
+/**
+ * @brief Correlate a Tensor3D with a separable 3D kernel
+ *
+ * Equivalent to correlating with the outer product of `kx`, `ky`, and `kz`.
+ * An empty kernel skips the pass along that axis.
+ */
+auto SepFilter3D(
+    const Tensor3D<double>& input,
+    const Kernel1D& kx,
+    const Kernel1D& ky,
+    const Kernel1D& kz) -> Tensor3D<double>;
+
+/**
+ * @brief Compute the X, Y, and Z gradients of a Tensor3D
+ *
+ * Each gradient is the derivative kernel along its axis combined with the
+ * smoothing kernel along the in-plane axis used by the 2D operator: X and Y
+ * gradients are smoothed within XY slices, and Z gradients are smoothed
+ * along X. This matches computing cv::Scharr() or cv::Sobel() on the XY and
+ * XZ slices of the tensor.
+ *
+ * @param ksize Kernel size. See DerivativeKernels1D().
+ */
+auto Gradient3D(const Tensor3D<double>& input, int ksize = 3)
+    -> std::array<Tensor3D<double>, 3>;
+}  // namespace volcart
@@ -0,0 +1,138 @@
+/**
+ * @file
+ *
+ * @ingroup Math
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+#include "vc/core/math/StructureTensor.hpp"
+#include "vc/core/types/Volume.hpp"
+
+namespace volcart
+{
+/**
+ * @class OrientationField
+ * @brief Precomputed principal direction and coherence of every voxel
+ *
+ * Segmentation algorithms which follow the structure tensor of a volume,
+ * such as StructureTensorParticleSim, compute the same eigenvectors every
+ * time they run over a scan. Compute() instead computes the structure tensor
+ * of every voxel once, with StructureTensorField, and stores its principal
+ * eigenvector and coherence in a derived 16-bit Volume, which can be kept in
+ * the volume package. An OrientationField reads that Volume and interpolates
+ * the stored directions at subvoxel positions.
+ *
+ * Each voxel packs a direction and a coherence into 16 bits:
+ * - Bits 0-11: The principal eigenvector, flipped into the upper (+Z)
+ *   hemisphere, in a hemi-octahedral encoding with DIRECTION_BITS per axis.
+ *   The angular error is about 1 degree on average and at most 2.3 degrees.
+ * - Bits 12-15: The coherence `(l0 - l1) / (l0 + l1)` of the two largest
+ *   eigenvalues, quantized to COHERENCE_BITS.
+ *
+ * Since eigenvectors have no sign, interpolation flips each neighbouring
+ * direction to agree with the nearest one before blending.
+ *
+ * All query functions are safe to call concurrently.
+ *
+ * @ingroup Math
+ */
+class OrientationField
+{
+public:
+    /** Bits per axis of the encoded direction */
+    static constexpr int DIRECTION_BITS{6};
+    /** Bits of the encoded coherence */
+    static constexpr int COHERENCE_BITS{4};
+
+    /** Shared pointer type */
+    using Pointer = std::shared_ptr<OrientationField>;
+
+    /**@{*/
+    /**
+     * @brief Read the orientation field stored in a Volume
+     *
+     * @throws std::invalid_argument if `field` is null or not 16-bit
+     */
+    explicit OrientationField(Volume::Pointer field);
+
+    /** Make a new shared instance */
+    template <typename... Args>
+    static auto New(Args... args) -> Pointer
+    {
+        return std::make_shared<OrientationField>(std::forward<Args>(args)...);
+    }
+    /**@}*/
+
+    /**@{*/
+    /**
+     * @brief Compute the orientation field of a volume into `field`
+     *
+     * `field` takes the dimensions and voxel size of `src` and is filled one
+     * layer of StructureTensorField blocks at a time. The blocks of a layer
+     * are computed in parallel, so memory use is about two bytes per voxel
+     * of a layer, in addition to the tensor blocks. Call
+     * Volume::saveMetadata() on `field` afterwards.
+     *
+     * @param src Source volume
+     * @param field Empty output volume, e.g. from VolumePkg::newVolume()
+     * @param radius Radius of the structure tensor's Gaussian window
+     * @param kernelSize Size of the gradient kernel. One of 3, 5, 7.
+     * @param numThreads Number of threads. If `0`, uses every thread in the
+     * global ThreadPool.
+     */
+    static void Compute(
+        const Volume::Pointer& src,
+        const Volume::Pointer& field,
+        int radius,
+        int kernelSize = 3,
+        std::size_t numThreads = 0);
+
+    /** @brief Encode the principal direction and coherence of eigenpairs */
+    static auto Encode(const EigenPairs& ep) -> std::uint16_t;
+
+    /** @brief Decode the principal direction of an encoded voxel */
+    static auto DecodeDirection(std::uint16_t v) -> cv::Vec3d;
+
+    /** @brief Decode the coherence of an encoded voxel */
+    static auto DecodeCoherence(std::uint16_t v) -> double;
+    /**@}*/
+
+    /**@{*/
+    /** @brief Get the field volume */
+    [[nodiscard]] auto volume() const -> Volume::Pointer;
+
+    /** @brief Get the principal direction at a voxel position */
+    [[nodiscard]] auto directionAt(int x, int y, int z) const -> cv::Vec3d;
+
+    /** @brief Get the interpolated principal direction at a subvoxel point */
+    [[nodiscard]] auto directionAt(const cv::Vec3d& v) const -> cv::Vec3d;
+
+    /** @brief Get the interpolated coherence at a subvoxel position */
+    [[nodiscard]] auto coherenceAt(const cv::Vec3d& v) const -> double;
+
+    /**
+     * @brief Get the interpolated principal directions at many subvoxel
+     * positions
+     *
+     * Positions are split into contiguous chunks which are evaluated in
+     * parallel on the global ThreadPool.
+     */
+    [[nodiscard]] auto directionsAt(
+        const std::vector<cv::Vec3d>& vs, std::size_t numThreads = 0) const
+        -> std::vector<cv::Vec3d>;
+    /**@}*/
+
+private:
+    /** Field volume */
+    Volume::Pointer field_;
+};
+
+}  // namespace volcart
@@ -84,6 +84,13 @@ StructureTensor ComputeSubvoxelStructureTensor(
     int radius = 1,
     int kernelSize = 3);
 
+/**
+ * @brief Compute the eigenvalues and eigenvectors of a structure tensor
+ *
+ * Eigenpairs are sorted by descending eigenvalue.
+ */
+EigenPairs ComputeEigenPairs(const StructureTensor& st);
+
 /**
  * @brief Compute the eigenvalues and eigenvectors from the structure tensor
  * for a voxel position
@@ -0,0 +1,180 @@
+/**
+ * @file
+ *
+ * @ingroup Math
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+#include "vc/core/math/StructureTensor.hpp"
+#include "vc/core/types/ShardedCache.hpp"
+#include "vc/core/types/Volume.hpp"
+
+namespace volcart
+{
+/**
+ * @class StructureTensorField
+ * @brief Cached, block-wise structure tensor field of a Volume
+ *
+ * ComputeSubvoxelStructureTensor() loads a subvolume, computes its gradient,
+ * and sums the Gaussian-weighted gradient tensors for every query. Particle
+ * simulations make many such queries with heavily overlapping neighborhoods.
+ * This class instead computes the structure tensor of every voxel in a
+ * cubic block of the volume at once, and caches the most recently used
+ * blocks. Queries at subvoxel positions are trilinearly interpolated from
+ * the tensors of the surrounding voxels.
+ *
+ * Gradients are computed with the same Scharr or Sobel operators as
+ * ComputeVoxelStructureTensor(), and the Gaussian window is applied with
+ * separable 1D filters. Because gradients are computed over the whole block
+ * rather than a replicated-border subvolume, tensors differ slightly from
+ * ComputeSubvoxelStructureTensor() near the edge of the window. The tensor
+ * scale matches ComputeSubvoxelStructureTensor().
+ *
+ * All query functions are safe to call concurrently.
+ *
+ * @ingroup Math
+ */
+class StructureTensorField
+{
+public:
+    /** Default block edge length, in voxels */
+    static constexpr int DEFAULT_BLOCK_SIZE{32};
+    /** Default number of cached blocks */
+    static constexpr std::size_t DEFAULT_CACHE_BLOCKS{32};
+
+    /** Shared pointer type */
+    using Pointer = std::shared_ptr<StructureTensorField>;
+
+    /**@{*/
+    /**
+     * @brief Constructor
+     *
+     * @param volume Source volume
+     * @param radius Radius of the Gaussian window
+     * @param kernelSize Size of the gradient kernel. One of 3, 5, 7.
+     * @param blockSize Edge length of the computed blocks, in voxels
+     * @param cacheBlocks Maximum number of cached blocks
+     *
+     * @throws std::invalid_argument If a parameter is out of range
+     */
+    explicit StructureTensorField(
+        Volume::Pointer volume,
+        int radius = 1,
+        int kernelSize = 3,
+        int blockSize = DEFAULT_BLOCK_SIZE,
+        std::size_t cacheBlocks = DEFAULT_CACHE_BLOCKS);
+
+    /** Make a new shared instance */
+    template <typename... Args>
+    static auto New(Args... args) -> Pointer
+    {
+        return std::make_shared<StructureTensorField>(
+            std::forward<Args>(args)...);
+    }
+    /**@}*/
+
+    /**@{*/
+    /** @brief Get the source volume */
+    [[nodiscard]] auto volume() const -> Volume::Pointer;
+
+    /** @brief Get the radius of the Gaussian window */
+    [[nodiscard]] auto radius() const -> int;
+
+    /** @brief Get the size of the gradient kernel */
+    [[nodiscard]] auto kernelSize() const -> int;
+
+    /** @brief Get the block edge length */
+    [[nodiscard]] auto blockSize() const -> int;
+    /**@}*/
+
+    /**@{*/
+    /** @brief Get the structure tensor at a voxel position */
+    [[nodiscard]] auto tensorAt(int x, int y, int z) const -> StructureTensor;
+
+    /** @copydoc tensorAt(int, int, int) const */
+    [[nodiscard]] auto tensorAt(const cv::Vec3i& v) const -> StructureTensor;
+
+    /** @brief Get the interpolated structure tensor at a subvoxel position */
+    [[nodiscard]] auto interpolateAt(const cv::Vec3d& v) const
+        -> StructureTensor;
+
+    /**
+     * @brief Get the eigenpairs of the interpolated structure tensor at a
+     * subvoxel position
+     */
+    [[nodiscard]] auto eigenPairsAt(const cv::Vec3d& v) const -> EigenPairs;
+
+    /**
+     * @brief Get the eigenpairs of the interpolated structure tensor at many
+     * subvoxel positions
+     *
+     * Positions are split into contiguous chunks which are evaluated in
+     * parallel on the global ThreadPool. Consecutive positions which fall in
+     * the same block share a single cache lookup, so spatially ordered
+     * positions, such as the particles of a chain, are cheaper to evaluate
+     * together than with separate calls.
+     *
+     * @param vs Subvoxel positions
+     * @param numThreads Number of threads. If `0`, uses every thread in the
+     * global ThreadPool.
+     */
+    [[nodiscard]] auto eigenPairsAt(
+        const std::vector<cv::Vec3d>& vs, std::size_t numThreads = 0) const
+        -> std::vector<EigenPairs>;
+    /**@}*/
+
+    /**@{*/
+    /** @brief Get the number of cached blocks */
+    [[nodiscard]] auto cacheSize() const -> std::size_t;
+
+    /** @brief Remove all cached blocks */
+    void purge();
+    /**@}*/
+
+private:
+    /**
+     * Unique tensor components of a block, ordered x-fastest:
+     * (xx, xy, xz, yy, yz, zz)
+     */
+    using Block = std::vector<cv::Vec6f>;
+    /** Shared, immutable block */
+    using BlockPointer = std::shared_ptr<const Block>;
+
+    /** Source volume */
+    Volume::Pointer volume_;
+    /** Gaussian window radius */
+    int radius_;
+    /** Gradient kernel size */
+    int kernelSize_;
+    /** Block edge length */
+    int blockSize_;
+    /** Cached blocks, keyed by packed block position */
+    mutable ShardedCache<std::uint64_t, BlockPointer> cache_;
+
+    /** Most recently used block of a sequence of queries */
+    struct BlockHint {
+        /** Block position */
+        cv::Vec3i pos;
+        /** Block. Null if no block has been used. */
+        BlockPointer block;
+    };
+
+    /** Interpolate a tensor, reusing the hinted block if possible */
+    [[nodiscard]] auto interpolate_(const cv::Vec3d& v, BlockHint& hint) const
+        -> StructureTensor;
+    /** Get a block from the cache, computing it on a miss */
+    [[nodiscard]] auto block_(const cv::Vec3i& pos) const -> BlockPointer;
+    /** Compute the tensors of a block */
+    [[nodiscard]] auto compute_block_(const cv::Vec3i& pos) const
+        -> BlockPointer;
+};
+
+}  // namespace volcart
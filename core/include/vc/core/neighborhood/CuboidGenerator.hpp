@@ -2,6 +2,10 @@
 
 /** @file */
 
+#include <array>
+#include <limits>
+#include <vector>
+
 #include "vc/core/neighborhood/NeighborhoodGenerator.hpp"
 
 namespace volcart
@@ -26,6 +30,24 @@ public:
     static Pointer New() { return std::make_shared<CuboidGenerator>(); }
     /**@}*/
 
+    /**
+     * @brief Precomputed sample offsets of a cuboid neighborhood
+     *
+     * Holds the position of every sample relative to the neighborhood's
+     * center point for a fixed shape and orientation. Created by
+     * precompute().
+     */
+    struct SampleOffsets {
+        /** Number of samples along each axis */
+        std::array<size_t, 3> extent{};
+        /** Offset of each sample from the center, in (z, y, x) order */
+        std::vector<cv::Vec3d> samples;
+        /** Whether the bases are axis-aligned with an integer interval */
+        bool lattice{false};
+        /** Lattice offset between neighboring samples along each axis */
+        std::array<cv::Vec3i, 3> steps{};
+    };
+
     /**@{*/
     Neighborhood::Extent extents() const override;
     /**@}*/
@@ -48,7 +70,82 @@ public:
         const Volume::Pointer& v,
         const cv::Vec3d& pt,
         const std::vector<cv::Vec3d>& axes) override;
+
+    /**
+     * @brief Compute a cuboid neighborhood into caller-provided storage
+     *
+     * Produces the same samples as compute() with `axis` as the only axis,
+     * generating the remaining axes regardless of `setAutoGenAxes()`. Does
+     * not allocate, except to grow a reused per-thread buffer of sample
+     * positions.
+     */
+    void computeInto(
+        const Volume::Pointer& v,
+        const cv::Vec3d& pt,
+        const cv::Vec3d& axis,
+        uint16_t* out) const override;
+
+    /**
+     * @brief Precompute the sample offsets of a neighborhood orientation
+     *
+     * Resolves the axes as compute() does, then computes the offset of every
+     * sample from the center point using the current radius, interval, and
+     * direction. Later changes to these parameters do not affect the
+     * result.
+     *
+     * @throws std::invalid_argument If fewer than 3 axes are available
+     */
+    SampleOffsets precompute(const std::vector<cv::Vec3d>& axes) const;
+
+    /**
+     * @brief Compute a neighborhood with precomputed sample offsets
+     *
+     * Produces the same samples as compute() with the axes passed to
+     * precompute(), but only adds the center point to each offset. Use this
+     * when extracting many neighborhoods with the same shape and
+     * orientation, such as the patches of a training set. `out` must have
+     * space for `offsets.samples.size()` values.
+     */
+    void computeInto(
+        const Volume::Pointer& v,
+        const cv::Vec3d& pt,
+        const SampleOffsets& offsets,
+        uint16_t* out) const;
+
+    /**
+     * @brief Compute a range of slices of a neighborhood
+     *
+     * Produces slices `[first, last)` along the first axis of the
+     * neighborhood computed by compute(), without computing the other
+     * slices. Use this to generate a large neighborhood in bounded memory,
+     * e.g. to stream it. `out` must have space for
+     * `(last - first) * extents()[1] * extents()[2]` values.
+     *
+     * @throws std::invalid_argument If fewer than 3 axes are available
+     * @throws std::out_of_range If `first > last` or `last > extents()[0]`
+     */
+    void computeSlicesInto(
+        const Volume::Pointer& v,
+        const cv::Vec3d& pt,
+        const std::vector<cv::Vec3d>& axes,
+        size_t first,
+        size_t last,
+        uint16_t* out) const;
     /**@}*/
+
+private:
+    /**
+     * Compute the sample offsets of the bases into `offsets`. Only computes
+     * the slices `[first, last)` along the first basis.
+     */
+    void offsets_(
+        const std::array<cv::Vec3d, 3>& bases,
+        SampleOffsets& offsets,
+        size_t first = 0,
+        size_t last = std::numeric_limits<size_t>::max()) const;
+
+    /** Number of samples along each axis */
+    std::array<size_t, 3> extent_() const;
 };
 
 }  // namespace volcart
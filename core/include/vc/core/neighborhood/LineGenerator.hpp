@@ -45,7 +45,52 @@ public:
         const Volume::Pointer& v,
         const cv::Vec3d& pt,
         const std::vector<cv::Vec3d>& axes) override;
+
+    /**
+     * @brief Compute a line-like neighborhood into caller-provided storage
+     *
+     * Produces the same samples as compute(), but takes the line's axis
+     * directly and writes the samples to `out`, which must have space for
+     * `extents()[0]` values. This is the per-pixel operation of most
+     * texturing algorithms, so it does not allocate: sample positions are
+     * generated along the axis into a stack buffer, or into a reused
+     * per-thread buffer for very long lines, and then interpolated in a
+     * single batch.
+     */
+    void computeInto(
+        const Volume::Pointer& v,
+        const cv::Vec3d& pt,
+        const cv::Vec3d& axis,
+        uint16_t* out) const override;
+
+    /**
+     * @brief Compute a contiguous range of a line-like neighborhood
+     *
+     * Writes samples `[first, first + count)` of the line computed by
+     * computeInto() to `out`, which must have space for `count` values. The
+     * samples are identical to the same samples of the full line.
+     *
+     * @throws std::out_of_range if the range extends past `extents()[0]`
+     */
+    void computeRangeInto(
+        const Volume::Pointer& v,
+        const cv::Vec3d& pt,
+        const cv::Vec3d& axis,
+        size_t first,
+        size_t count,
+        uint16_t* out) const;
+
+    /**
+     * @brief Offset along the axis of the first sample
+     *
+     * The samples are spaced samplingInterval() apart along the axis.
+     */
+    double lineStart() const;
     /**@}*/
+
+private:
+    /** Number of samples in the line */
+    size_t line_size_() const;
 };
 
 }  // namespace volcart
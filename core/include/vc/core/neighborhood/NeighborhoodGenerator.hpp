@@ -42,7 +42,7 @@ public:
 
     /**@{*/
     /** @brief Get the dimensionality of the neighborhood generator */
-    size_t dim() { return dim_; }
+    size_t dim() const { return dim_; }
 
     /** @brief Get the size of the neighborhood returned by this class
      *
@@ -50,6 +50,16 @@ public:
      * parameters
      */
     virtual Neighborhood::Extent extents() const = 0;
+
+    /** @brief Get the number of samples in the neighborhood */
+    size_t size() const
+    {
+        size_t size{1};
+        for (const auto& e : extents()) {
+            size *= e;
+        }
+        return size;
+    }
     /**@}*/
 
     /**@{*/
@@ -73,6 +83,9 @@ public:
      */
     void setSamplingInterval(double i) { interval_ = i; }
 
+    /** @brief Get the sampling interval */
+    double samplingInterval() const { return interval_; }
+
     /**
      * @brief Set the filtering search direction
      *
@@ -86,6 +99,16 @@ public:
      * Derived classes are not guaranteed to make use of this functionality
      */
     void setAutoGenAxes(bool b) { autoGenAxes_ = b; }
+
+    /**
+     * @brief Set the interpolation kernel used to sample the Volume
+     *
+     * Default: Trilinear
+     */
+    void setInterpolation(Volume::Interpolation i) { interpolation_ = i; }
+
+    /** @brief Get the interpolation kernel */
+    Volume::Interpolation interpolation() const { return interpolation_; }
     /**@}*/
 
     /**@{*/
@@ -94,6 +117,20 @@ public:
         const Volume::Pointer& v,
         const cv::Vec3d& pt,
         const std::vector<cv::Vec3d>& axes) = 0;
+
+    /**
+     * @brief Compute a neighborhood into caller-provided storage
+     *
+     * Produces the same samples as compute() given the single axis `axis`,
+     * in the same row-major order, and writes them to `out`, which must have
+     * space for size() values. Intended for per-pixel loops: allocate `out`
+     * once, then wrap it in an NDArrayView if indexed access is needed.
+     */
+    virtual void computeInto(
+        const Volume::Pointer& v,
+        const cv::Vec3d& pt,
+        const cv::Vec3d& axis,
+        uint16_t* out) const = 0;
     /**@}*/
 
 protected:
@@ -116,6 +153,9 @@ protected:
 
     /** Auto-generate Axes flag */
     bool autoGenAxes_{true};
+
+    /** Interpolation kernel */
+    Volume::Interpolation interpolation_{Volume::Interpolation::Trilinear};
 };
 
 }  // namespace volcart
@@ -0,0 +1,232 @@
+#pragma once
+
+/** @file */
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <future>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+#include "vc/core/neighborhood/CuboidGenerator.hpp"
+#include "vc/core/types/Volume.hpp"
+
+namespace volcart
+{
+
+/**
+ * @brief Samples large lists of cuboid patches from a Volume in batches
+ *
+ * Training loops usually request patches at random centers, one at a time.
+ * Every request then touches different slices, so the slice cache is
+ * thrashed and most of the time is spent reading and decoding slices. This
+ * class takes the whole list of patch centers up front and samples them in
+ * batches, ordered so that patches which share slices are sampled together.
+ *
+ * Requests are bucketed into z-slabs of slabDepth() slices, and are sorted by
+ * Morton (Z-order) code within each slab. With Order::Locality, batches are
+ * formed in this order, and each batch reports the request index of each of
+ * its patches. With Order::Requested, batches contain the requests in their
+ * original order, and only the requests of each window of prefetchBatches()
+ * batches are sampled in locality order.
+ *
+ * Windows are sampled ahead of time on the global ThreadPool, so the slices
+ * for the next batches are read while the current batch is being consumed.
+ * Every patch has the shape and orientation of the CuboidGenerator and axes
+ * passed to the constructor.
+ *
+ * This class is not thread-safe.
+ *
+ * @ingroup Neighborhoods
+ */
+class PatchSampler
+{
+public:
+    /** @brief Order in which requests are batched */
+    enum class Order {
+        /** @brief Batches contain the requests in their original order */
+        Requested = 0,
+        /** @brief Batches contain the requests in locality order */
+        Locality
+    };
+
+    /** @brief Batch of patches */
+    struct Batch {
+        /** Request index of each patch */
+        std::vector<std::size_t> indices;
+        /**
+         * Patch samples. Patch `i` is stored at offset `i * patchSize()` in
+         * the layout of CuboidGenerator::compute().
+         */
+        std::vector<std::uint16_t> patches;
+    };
+
+    /** @brief Default number of slices in a z-slab */
+    static constexpr std::size_t DEFAULT_SLAB_DEPTH{64};
+
+    /**
+     * @brief Constructor
+     *
+     * The patch shape and orientation are fixed when the sampler is
+     * constructed. Later changes to `generator` do not affect the sampler.
+     *
+     * @throws std::invalid_argument if the volume is null or fewer than 3
+     * axes are available
+     */
+    PatchSampler(
+        Volume::Pointer volume,
+        const CuboidGenerator& generator,
+        const std::vector<cv::Vec3d>& axes = {
+            {1, 0, 0}, {0, 1, 0}, {0, 0, 1}});
+
+    /**
+     * @brief Destructor
+     *
+     * Windows which are still being sampled finish in the background and
+     * are discarded.
+     */
+    ~PatchSampler();
+
+    /**@{*/
+    PatchSampler(const PatchSampler&) = delete;
+    auto operator=(const PatchSampler&) -> PatchSampler& = delete;
+    /**@}*/
+
+    /**
+     * @brief Set the patch centers
+     *
+     * The request index of a patch is the index of its center. Restarts
+     * sampling at the first batch.
+     */
+    void setCenters(std::vector<cv::Vec3d> centers);
+
+    /** @brief Get the patch centers */
+    [[nodiscard]] auto centers() const -> const std::vector<cv::Vec3d>&;
+
+    /**
+     * @brief Set the number of patches in a batch
+     *
+     * The last batch may be smaller. Restarts sampling at the first batch.
+     * Default: 32
+     *
+     * @throws std::invalid_argument if `n` is 0
+     */
+    void setBatchSize(std::size_t n);
+
+    /** @brief Get the number of patches in a batch */
+    [[nodiscard]] auto batchSize() const -> std::size_t;
+
+    /**
+     * @brief Set the order in which requests are batched
+     *
+     * Restarts sampling at the first batch. Default: Order::Requested
+     */
+    void setOrder(Order order);
+
+    /** @brief Get the order in which requests are batched */
+    [[nodiscard]] auto order() const -> Order;
+
+    /**
+     * @brief Set the number of slices in a z-slab
+     *
+     * Should be at least the number of slices spanned by a patch. Restarts
+     * sampling at the first batch.
+     *
+     * @throws std::invalid_argument if `n` is 0
+     */
+    void setSlabDepth(std::size_t n);
+
+    /** @brief Get the number of slices in a z-slab */
+    [[nodiscard]] auto slabDepth() const -> std::size_t;
+
+    /**
+     * @brief Set the number of batches which are sampled together
+     *
+     * Larger windows give more locality with Order::Requested, but hold
+     * more batches in memory: up to three windows are sampled or waiting to
+     * be returned at a time. Restarts sampling at the first batch.
+     * Default: 4
+     *
+     * @throws std::invalid_argument if `n` is 0
+     */
+    void setPrefetchBatches(std::size_t n);
+
+    /** @brief Get the number of batches which are sampled together */
+    [[nodiscard]] auto prefetchBatches() const -> std::size_t;
+
+    /**
+     * @brief Set the number of threads used to sample a window
+     *
+     * If `0` (default), uses every thread in the global ThreadPool. Restarts
+     * sampling at the first batch.
+     */
+    void setNumThreads(std::size_t n);
+
+    /** @brief Get the number of threads used to sample a window */
+    [[nodiscard]] auto numThreads() const -> std::size_t;
+
+    /** @brief Get the number of samples along each patch axis */
+    [[nodiscard]] auto patchExtent() const -> std::array<std::size_t, 3>;
+
+    /** @brief Get the number of samples in a patch */
+    [[nodiscard]] auto patchSize() const -> std::size_t;
+
+    /** @brief Get the number of batches */
+    [[nodiscard]] auto numBatches() const -> std::size_t;
+
+    /** @brief Restart sampling at the first batch */
+    void reset();
+
+    /**
+     * @brief Get the next batch
+     *
+     * Blocks until the batch has been sampled, and starts sampling the
+     * following windows. Returns an empty optional after the last batch.
+     * Exceptions thrown while sampling are rethrown here.
+     */
+    auto next() -> std::optional<Batch>;
+
+private:
+    /** Shared sampling parameters */
+    struct Plan;
+    /** Batches of a window */
+    using Window = std::vector<Batch>;
+
+    /** Sampling parameters of the current iteration */
+    std::shared_ptr<const Plan> plan_;
+    /** Sampled and in-flight windows, in batch order */
+    std::deque<std::future<Window>> windows_;
+    /** Batches of the current window which have not been returned */
+    std::deque<Batch> ready_;
+    /** Index of the next window to submit */
+    std::size_t nextWindow_{0};
+
+    /** Input volume */
+    Volume::Pointer volume_;
+    /** Patch generator */
+    CuboidGenerator generator_;
+    /** Patch sample offsets */
+    std::shared_ptr<const CuboidGenerator::SampleOffsets> offsets_;
+    /** Patch centers */
+    std::vector<cv::Vec3d> centers_;
+    /** Patches in a batch */
+    std::size_t batchSize_{32};
+    /** Batch order */
+    Order order_{Order::Requested};
+    /** Slices in a z-slab */
+    std::size_t slabDepth_{DEFAULT_SLAB_DEPTH};
+    /** Batches in a window */
+    std::size_t prefetchBatches_{4};
+    /** Sampling threads */
+    std::size_t numThreads_{0};
+
+    /** Submit windows until two are in flight */
+    void submit_();
+};
+
+}  // namespace volcart
@@ -0,0 +1,203 @@
+#pragma once
+
+/** @file */
+
+#include <list>
+#include <memory>
+#include <stdexcept>
+#include <unordered_map>
+
+#include <opencv2/core.hpp>
+
+#include "vc/core/types/Cache.hpp"
+
+namespace volcart
+{
+/**
+ * @brief Functor which returns the number of bytes charged for a cached value
+ *
+ * The default implementation charges `sizeof(T)`. Specialize this struct to
+ * charge values which own heap memory.
+ */
+template <typename T>
+struct CacheValueBytes {
+    /** Get the size of a value in bytes */
+    auto operator()(const T& /*v*/) const -> size_t { return sizeof(T); }
+};
+
+/** @brief Charge a cv::Mat for the size of its pixel data */
+template <>
+struct CacheValueBytes<cv::Mat> {
+    /** Get the size of a value in bytes */
+    auto operator()(const cv::Mat& m) const -> size_t
+    {
+        return m.total() * m.elemSize();
+    }
+};
+
+/**
+ * @class ByteLRUCache
+ * @brief Least Recently Used Cache with a capacity measured in bytes
+ *
+ * A cache using a least recently used replacement policy like LRUCache.
+ * Unlike LRUCache, which limits the number of stored elements, this cache
+ * limits the total size of the stored elements as reported by TSizeOf. This
+ * makes it suitable for caches which hold elements of varying sizes, such as
+ * slices from 8-bit, 16-bit, and floating-point volumes.
+ *
+ * For this class, capacity() and setCapacity() are measured in bytes, while
+ * size() still reports the number of stored elements. The current number of
+ * stored bytes is available from bytes().
+ *
+ * An element which is larger than the capacity of the cache is never stored.
+ *
+ * @tparam TSizeOf Functor returning the size of a TValue in bytes
+ *
+ * @ingroup Types
+ */
+template <
+    typename TKey,
+    typename TValue,
+    typename TSizeOf = CacheValueBytes<TValue>>
+class ByteLRUCache final : public Cache<TKey, TValue>
+{
+public:
+    using BaseClass = Cache<TKey, TValue>;
+    using BaseClass::capacity_;
+
+    /** Default cache capacity: 1 GiB */
+    static constexpr size_t DEFAULT_CAPACITY_BYTES = size_t{1} << 30;
+
+    /** Stored key/value/size tuple */
+    struct Entry {
+        /** Key */
+        TKey key;
+        /** Value */
+        TValue value;
+        /** Size of value in bytes */
+        size_t bytes;
+    };
+
+    /** Entry list iterator. Stored in the lookup map. */
+    using TListIterator = typename std::list<Entry>::iterator;
+
+    /** Shared pointer type */
+    using Pointer = std::shared_ptr<ByteLRUCache<TKey, TValue, TSizeOf>>;
+
+    /**@{*/
+    /** @brief Default constructor */
+    ByteLRUCache() : BaseClass(DEFAULT_CAPACITY_BYTES) {}
+
+    /** @brief Constructor with cache capacity parameter (in bytes) */
+    explicit ByteLRUCache(size_t capacity) : BaseClass(capacity) {}
+
+    /** @overload ByteLRUCache() */
+    static Pointer New()
+    {
+        return std::make_shared<ByteLRUCache<TKey, TValue, TSizeOf>>();
+    }
+
+    /** @overload ByteLRUCache(size_t) */
+    static Pointer New(size_t capacity)
+    {
+        return std::make_shared<ByteLRUCache<TKey, TValue, TSizeOf>>(capacity);
+    }
+    /**@}*/
+
+    /**@{*/
+    /** @brief Set the maximum size of the cache in bytes */
+    void setCapacity(size_t capacity) override
+    {
+        if (capacity <= 0) {
+            throw std::invalid_argument(
+                "Cannot create cache with capacity <= 0");
+        }
+        capacity_ = capacity;
+        evict_();
+    }
+
+    /** @brief Get the maximum size of the cache in bytes */
+    size_t capacity() const override { return capacity_; }
+
+    /** @brief Get the current number of elements in the cache */
+    size_t size() const override { return lookup_.size(); }
+
+    /** @brief Get the current size of the cache in bytes */
+    size_t bytes() const { return bytes_; }
+
+    /** @copydoc Cache::evictions() */
+    size_t evictions() const override { return evictions_; }
+    /**@}*/
+
+    /**@{*/
+    /** @brief Get an item from the cache by key */
+    TValue get(const TKey& k) override
+    {
+        auto lookupIter = lookup_.find(k);
+        if (lookupIter == std::end(lookup_)) {
+            throw std::invalid_argument("Key not in cache");
+        }
+        items_.splice(std::begin(items_), items_, lookupIter->second);
+        return lookupIter->second->value;
+    }
+
+    /** @brief Put an item into the cache */
+    void put(const TKey& k, const TValue& v) override
+    {
+        // If already in cache, need to refresh it
+        auto lookupIter = lookup_.find(k);
+        if (lookupIter != std::end(lookup_)) {
+            bytes_ -= lookupIter->second->bytes;
+            items_.erase(lookupIter->second);
+            lookup_.erase(lookupIter);
+        }
+
+        auto nbytes = TSizeOf()(v);
+        if (nbytes > capacity_) {
+            return;
+        }
+
+        items_.push_front({k, v, nbytes});
+        lookup_[k] = std::begin(items_);
+        bytes_ += nbytes;
+        evict_();
+    }
+
+    /** @brief Check if an item is already in the cache */
+    bool contains(const TKey& k) override
+    {
+        return lookup_.find(k) != std::end(lookup_);
+    }
+
+    /** @brief Clear the cache */
+    void purge() override
+    {
+        lookup_.clear();
+        items_.clear();
+        bytes_ = 0;
+    }
+    /**@}*/
+
+private:
+    /** Cache data storage */
+    std::list<Entry> items_;
+    /** Cache usage information */
+    std::unordered_map<TKey, TListIterator> lookup_;
+    /** Current size of the stored elements in bytes */
+    size_t bytes_{0};
+    /** Number of evicted elements */
+    size_t evictions_{0};
+
+    /** Remove the least recently used elements until within capacity */
+    void evict_()
+    {
+        while (bytes_ > capacity_ and not items_.empty()) {
+            auto& last = items_.back();
+            bytes_ -= last.bytes;
+            lookup_.erase(last.key);
+            items_.pop_back();
+            evictions_++;
+        }
+    }
+};
+}  // namespace volcart
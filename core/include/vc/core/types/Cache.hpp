@@ -26,6 +26,14 @@ public:
 
     /** @brief Get the current number of elements in the cache */
     virtual size_t size() const = 0;
+
+    /**
+     * @brief Get the number of elements evicted to stay within capacity
+     *
+     * Purged elements are not counted. Returns 0 for caches which do not
+     * track evictions.
+     */
+    virtual size_t evictions() const { return 0; }
     /**@}*/
 
     /**@{*/
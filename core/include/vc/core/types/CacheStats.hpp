@@ -0,0 +1,98 @@
+#pragma once
+
+/** @file */
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+namespace volcart
+{
+/**
+ * @class LatencyHistogram
+ * @brief Thread-safe histogram of operation latencies
+ *
+ * Latencies are counted in power-of-two buckets of microseconds: bucket 0
+ * holds latencies below 1 µs, and bucket `i` holds latencies in
+ * `[2^(i-1), 2^i)` µs. The last bucket also holds every longer latency.
+ * Recording a latency only updates atomic counters, so record() may be
+ * called concurrently from any number of threads.
+ *
+ * @ingroup Types
+ */
+class LatencyHistogram
+{
+public:
+    /** Number of histogram buckets */
+    static constexpr std::size_t NUM_BUCKETS = 32;
+
+    /** @brief Point-in-time copy of a LatencyHistogram */
+    struct Snapshot {
+        /** Number of latencies in each bucket */
+        std::array<std::uint64_t, NUM_BUCKETS> buckets{};
+        /** Total number of recorded latencies */
+        std::uint64_t count{0};
+        /** Sum of all recorded latencies in microseconds */
+        std::uint64_t totalUs{0};
+        /** Largest recorded latency in microseconds */
+        std::uint64_t maxUs{0};
+
+        /** @brief Get the mean latency in microseconds */
+        double mean() const;
+
+        /**
+         * @brief Get an upper bound for a latency percentile in microseconds
+         *
+         * Returns the upper edge of the bucket which contains the `p`-th
+         * percentile, where `p` is in the range [0, 100].
+         */
+        double percentile(double p) const;
+    };
+
+    /** @brief Record a latency */
+    void record(std::chrono::nanoseconds d);
+
+    /** @brief Get a copy of the current histogram */
+    Snapshot snapshot() const;
+
+    /** @brief Remove all recorded latencies */
+    void reset();
+
+private:
+    /** Bucket counters */
+    std::array<std::atomic<std::uint64_t>, NUM_BUCKETS> buckets_{};
+    /** Sum of all latencies in microseconds */
+    std::atomic<std::uint64_t> totalUs_{0};
+    /** Largest latency in microseconds */
+    std::atomic<std::uint64_t> maxUs_{0};
+};
+
+/**
+ * @brief Cache usage and I/O statistics
+ *
+ * @see Volume::cacheStats()
+ * @ingroup Types
+ */
+struct CacheStats {
+    /** Number of cache lookups */
+    std::uint64_t lookups{0};
+    /** Number of lookups which were resolved without loading from disk */
+    std::uint64_t hits{0};
+    /** Number of lookups which loaded from disk */
+    std::uint64_t misses{0};
+    /** Number of elements evicted from the cache */
+    std::uint64_t evictions{0};
+    /** Number of bytes loaded from disk */
+    std::uint64_t bytesRead{0};
+    /** Time taken to read and decode each slice or block */
+    LatencyHistogram::Snapshot loadLatency;
+
+    /** @brief Get the fraction of lookups which were cache hits */
+    double hitRate() const;
+
+    /** @brief Get a single-line, human-readable summary for logging */
+    std::string summary() const;
+};
+}  // namespace volcart
@@ -0,0 +1,212 @@
+#pragma once
+
+/** @file */
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include <opencv2/core.hpp>
+
+#include "vc/core/filesystem.hpp"
+
+namespace volcart
+{
+/**
+ * @class DiskCache
+ * @brief Persistent cache of decoded images in a local directory
+ *
+ * Stores decoded images as uncompressed files in a directory, typically on a
+ * fast local disk, so that images which are expensive to load, such as the
+ * LZW-compressed slices of a volume on a network filesystem, only need to be
+ * read and decoded once per machine. Volume uses it as a second tier below
+ * its in-memory slice cache. See Volume::setDiskCache().
+ *
+ * Every entry is stored with the size and modification time of the file it
+ * was decoded from (its Stamp). An entry whose stamp does not match the
+ * current source file is stale: get() treats it as a miss and removes it.
+ *
+ * Entries are written to a temporary file which is renamed into place, and
+ * are read through a memory mapping. Several processes can therefore use the
+ * same directory at the same time, and an entry which is removed while
+ * another process reads it stays valid for that reader.
+ *
+ * The total size of the entries is kept below capacity() by removing the
+ * least recently used entries. Reading an entry updates its modification
+ * time, which is used as its last use time. Since other processes also add
+ * entries, the directory is scanned to find its actual size whenever this
+ * object's estimate exceeds the capacity, and trimmed to 90% of the
+ * capacity to avoid scanning on every put().
+ *
+ * With setMapEntries(), get() returns images which reference a
+ * copy-on-write memory mapping of their entry instead of a copy. Until an
+ * image is written, its memory is the entry's page cache, which is shared by
+ * every process which reads the entry. A cache in a shared memory
+ * filesystem, such as the one returned by SharedMemory(), therefore holds
+ * one decoded copy of each slice for every process on the host, within a
+ * single capacity. A process which opens a volume that another process has
+ * already read starts with its slices decoded. Note that the memory of a
+ * removed entry is not released until every image which references it is
+ * released, so processes which keep many slices in their own caches can
+ * briefly exceed the capacity.
+ *
+ * Errors while writing or removing entries are logged and otherwise ignored,
+ * since a cache which cannot be written only costs performance. All member
+ * functions are safe to call concurrently.
+ *
+ * @ingroup Types
+ */
+class DiskCache
+{
+public:
+    /** Shared pointer type */
+    using Pointer = std::shared_ptr<DiskCache>;
+
+    /** Default capacity: 64 GiB */
+    static constexpr std::size_t DEFAULT_CAPACITY_BYTES = std::size_t{64}
+                                                          << 30;
+
+    /** Default name of the caches constructed by SharedMemory() */
+    static constexpr const char* DEFAULT_SHARED_MEMORY_NAME{
+        "volume-cartographer"};
+
+    /** @brief Version of the source file of an entry */
+    struct Stamp {
+        /** Size of the source file in bytes */
+        std::uint64_t size{0};
+        /** Modification time of the source file in nanoseconds */
+        std::int64_t mtime{0};
+
+        /** Equality comparison */
+        auto operator==(const Stamp& other) const -> bool
+        {
+            return size == other.size and mtime == other.mtime;
+        }
+    };
+
+    /**
+     * @brief Constructor
+     *
+     * Creates `dir` if it does not exist.
+     *
+     * @throws volcart::IOException if the directory cannot be created
+     */
+    explicit DiskCache(
+        filesystem::path dir, std::size_t capacity = DEFAULT_CAPACITY_BYTES);
+
+    /** @copydoc DiskCache(filesystem::path, std::size_t) */
+    static auto New(
+        filesystem::path dir, std::size_t capacity = DEFAULT_CAPACITY_BYTES)
+        -> Pointer;
+
+    /**
+     * @brief Construct a cache in the host's shared memory
+     *
+     * Places the cache at `/dev/shm/<name>`, or in the temporary directory
+     * on systems without `/dev/shm`, and enables setMapEntries(). Every
+     * process which uses the same name shares the cache.
+     *
+     * @throws volcart::IOException if the directory cannot be created
+     */
+    static auto SharedMemory(
+        const std::string& name = DEFAULT_SHARED_MEMORY_NAME,
+        std::size_t capacity = DEFAULT_CAPACITY_BYTES) -> Pointer;
+
+    /**
+     * @brief Get the stamp of a source file
+     *
+     * Returns a zero stamp if the file does not exist.
+     */
+    static auto SourceStamp(const filesystem::path& path) -> Stamp;
+
+    /** @brief Get the cache directory */
+    [[nodiscard]] auto directory() const -> filesystem::path;
+
+    /** @brief Set the maximum total size of the entries in bytes */
+    void setCapacity(std::size_t capacity);
+
+    /** @brief Get the maximum total size of the entries in bytes */
+    [[nodiscard]] auto capacity() const -> std::size_t;
+
+    /**
+     * @brief Return images which reference the memory mapping of their entry
+     *
+     * When enabled, images returned by get() share their memory with the
+     * entry's file in the page cache until they are written. Writing to such
+     * an image modifies a private copy of its pages and never modifies the
+     * entry. Default: Disabled.
+     */
+    void setMapEntries(bool b);
+
+    /** @brief Whether get() returns mapped images */
+    [[nodiscard]] auto mapEntries() const -> bool;
+
+    /**
+     * @brief Get the total size of the entries in bytes
+     *
+     * Scans the cache directory, so includes the entries of other processes.
+     */
+    [[nodiscard]] auto bytes() const -> std::size_t;
+
+    /**
+     * @brief Get an entry
+     *
+     * Returns an empty image if there is no entry for `key` or if the entry
+     * was decoded from a different version of its source file.
+     */
+    auto get(const std::string& key, const Stamp& stamp) -> cv::Mat;
+
+    /**
+     * @brief Add an entry
+     *
+     * Replaces any existing entry for `key`. Empty images and images larger
+     * than the capacity are not stored. `key` is used as a file name, so it
+     * should only contain characters which are valid in file names.
+     */
+    void put(const std::string& key, const Stamp& stamp, const cv::Mat& m);
+
+    /** @brief Remove an entry */
+    void remove(const std::string& key);
+
+    /** @brief Remove entries until the total size is within the capacity */
+    void trim();
+
+    /** @brief Remove every entry */
+    void purge();
+
+    /** @brief Get the number of calls to get() which returned an entry */
+    [[nodiscard]] auto hits() const -> std::uint64_t;
+
+    /** @brief Get the number of calls to get() which did not */
+    [[nodiscard]] auto misses() const -> std::uint64_t;
+
+private:
+    /** Path of the entry for a key */
+    [[nodiscard]] auto entry_path_(const std::string& key) const
+        -> filesystem::path;
+    /** Remove an entry file */
+    void remove_(const filesystem::path& path);
+    /** Remove an entry file of known size */
+    void remove_(const filesystem::path& path, std::size_t size);
+    /** Remove entries until the total size is within `target` bytes */
+    void trim_to_(std::size_t target);
+
+    /** Cache directory */
+    filesystem::path dir_;
+    /** Maximum total size of the entries */
+    std::atomic<std::size_t> capacity_;
+    /** Whether get() returns mapped images */
+    std::atomic<bool> mapEntries_{false};
+    /** Estimated total size of the entries */
+    std::size_t estimate_{0};
+    /** Guards estimate_ and trimming */
+    std::mutex mutex_;
+    /** Number of get() hits */
+    std::atomic<std::uint64_t> hits_{0};
+    /** Number of get() misses */
+    std::atomic<std::uint64_t> misses_{0};
+};
+}  // namespace volcart
@@ -0,0 +1,176 @@
+#pragma once
+
+/** @file */
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+#include "vc/core/types/ITKMesh.hpp"
+
+namespace volcart
+{
+/**
+ * @class FlatMesh
+ * @brief Triangle mesh stored as contiguous attribute arrays
+ *
+ * ITKMesh stores every face as a separately allocated cell object, and every
+ * vertex and face access goes through the ITK container interfaces. For
+ * algorithms that sweep over every face or vertex of a large mesh, this
+ * pointer-chasing dominates the runtime. FlatMesh instead stores each mesh
+ * attribute in its own contiguous array: vertex positions, triangle vertex
+ * indices, and optional per-vertex normals and UV coordinates. The arrays
+ * are exposed by reference, so algorithms can read and write them directly.
+ *
+ * Use ToFlatMesh() and ToITKMesh() to convert to and from ITKMesh.
+ *
+ * @ingroup Types
+ */
+class FlatMesh
+{
+public:
+    /** Vertex index type */
+    using Index = std::uint32_t;
+    /** Triangular face type */
+    using Face = std::array<Index, 3>;
+    /** Vertex position type */
+    using Vertex = cv::Vec3d;
+    /** Vertex normal type */
+    using Normal = cv::Vec3d;
+    /** Vertex UV type */
+    using UV = cv::Vec2d;
+
+    /** Pointer type */
+    using Pointer = std::shared_ptr<FlatMesh>;
+
+    /**@{*/
+    /** @brief Default constructor */
+    FlatMesh() = default;
+
+    /** Static New function for all constructors of T */
+    template <typename... Args>
+    static auto New(Args... args) -> Pointer
+    {
+        return std::make_shared<FlatMesh>(std::forward<Args>(args)...);
+    }
+    /**@}*/
+
+    /**@{*/
+    /** @brief Get the number of vertices */
+    [[nodiscard]] auto numVertices() const -> std::size_t;
+
+    /** @brief Get the number of faces */
+    [[nodiscard]] auto numFaces() const -> std::size_t;
+
+    /** @brief Whether every vertex has a normal */
+    [[nodiscard]] auto hasNormals() const -> bool;
+
+    /** @brief Whether every vertex has a UV coordinate */
+    [[nodiscard]] auto hasUVs() const -> bool;
+
+    /** @brief Reserve storage for vertices and faces */
+    void reserve(std::size_t numVertices, std::size_t numFaces);
+
+    /** @brief Remove all vertices, faces, and attributes */
+    void clear();
+    /**@}*/
+
+    /**@{*/
+    /**
+     * @brief Add a vertex and return its index
+     *
+     * @throws std::overflow_error If the mesh already has the maximum number
+     * of vertices representable by Index
+     */
+    auto addVertex(const Vertex& v) -> Index;
+
+    /**
+     * @brief Add a face and return its index
+     *
+     * @throws std::out_of_range If a vertex index is out of range
+     */
+    auto addFace(Index a, Index b, Index c) -> std::size_t;
+    /**@}*/
+
+    /**@{*/
+    /** @brief Vertex positions */
+    auto vertices() -> std::vector<Vertex>&;
+    /** @copydoc vertices() */
+    [[nodiscard]] auto vertices() const -> const std::vector<Vertex>&;
+
+    /** @brief Triangle vertex indices */
+    auto faces() -> std::vector<Face>&;
+    /** @copydoc faces() */
+    [[nodiscard]] auto faces() const -> const std::vector<Face>&;
+
+    /**
+     * @brief Per-vertex normals
+     *
+     * Empty, or the same size as vertices().
+     */
+    auto normals() -> std::vector<Normal>&;
+    /** @copydoc normals() */
+    [[nodiscard]] auto normals() const -> const std::vector<Normal>&;
+
+    /**
+     * @brief Per-vertex UV coordinates
+     *
+     * Empty, or the same size as vertices().
+     */
+    auto uvs() -> std::vector<UV>&;
+    /** @copydoc uvs() */
+    [[nodiscard]] auto uvs() const -> const std::vector<UV>&;
+    /**@}*/
+
+    /**@{*/
+    /**
+     * @brief Compute area-weighted vertex normals
+     *
+     * Each vertex normal is the normalized sum of the (unnormalized) normals
+     * of its adjacent faces. Replaces any existing normals.
+     *
+     * With more than one thread, face normals are computed in parallel and
+     * each vertex then gathers the normals of its adjacent faces. Faces are
+     * summed in the same order as the serial computation, so the result does
+     * not depend on the number of threads.
+     *
+     * @param numThreads Number of threads. If `0`, uses every thread in the
+     * global ThreadPool.
+     */
+    void computeNormals(std::size_t numThreads = 1);
+    /**@}*/
+
+private:
+    /** Vertex positions */
+    std::vector<Vertex> vertices_;
+    /** Faces */
+    std::vector<Face> faces_;
+    /** Vertex normals */
+    std::vector<Normal> normals_;
+    /** Vertex UVs */
+    std::vector<UV> uvs_;
+};
+
+/**
+ * @brief Convert an ITKMesh to a FlatMesh
+ *
+ * Vertex normals are copied if every vertex has point data.
+ *
+ * @throws std::invalid_argument If any cell is not a triangle
+ * @throws std::overflow_error If the mesh has more vertices than can be
+ * indexed by FlatMesh::Index
+ */
+auto ToFlatMesh(const ITKMesh::Pointer& mesh) -> FlatMesh;
+
+/**
+ * @brief Convert a FlatMesh to an ITKMesh
+ *
+ * Vertex normals are copied to the point data. UV coordinates are not
+ * stored in ITKMesh and are ignored.
+ */
+auto ToITKMesh(const FlatMesh& mesh) -> ITKMesh::Pointer;
+}  // namespace volcart
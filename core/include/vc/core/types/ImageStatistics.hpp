@@ -0,0 +1,122 @@
+#pragma once
+
+/** @file */
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+namespace volcart
+{
+/**
+ * @class ImageStatistics
+ * @brief Streaming intensity statistics of images and volumes
+ *
+ * Accumulates the count, minimum, maximum, mean, variance, and an intensity
+ * histogram of the pixels of one or more single-channel images. Values are
+ * not stored, so memory use is independent of the number of pixels. Every
+ * call to add() processes the image rows in parallel on the global
+ * ThreadPool, with per-chunk histograms which are merged at the end. To
+ * gather statistics over a volume, add() every slice.
+ *
+ * Percentiles are computed from the histogram. They are exact for 8- and
+ * 16-bit images, which have one bin per value. Other depths are binned by
+ * the 16 most significant bits of their value as a float, so their
+ * percentiles have a relative error below 1%. The minimum, maximum, mean,
+ * and variance are computed from the pixel values rather than the histogram
+ * for every depth. NaN pixels are ignored.
+ *
+ * All images added to an object must have the same depth. This class is not
+ * thread-safe. Combine the objects of several threads with merge().
+ *
+ * @see VolumeStatistics
+ * @ingroup Types
+ */
+class ImageStatistics
+{
+public:
+    /** @brief Default constructor */
+    ImageStatistics() = default;
+
+    /**
+     * @brief Add the pixels of an image
+     *
+     * If `mask` is not empty, only pixels where the `CV_8UC1` mask is
+     * non-zero are added. Multi-channel images are not supported.
+     *
+     * @throws std::invalid_argument if the image has more than one channel
+     * or a depth other than 8U, 8S, 16U, 16S, 32S, 32F, or 64F, if its depth
+     * differs from previously added images, or if the mask does not match
+     * the image
+     */
+    void add(const cv::Mat& img, const cv::Mat& mask = cv::Mat());
+
+    /**
+     * @brief Add another object's statistics to this one
+     *
+     * @throws std::invalid_argument if the objects have different depths
+     */
+    void merge(const ImageStatistics& other);
+
+    /** @brief Get the number of pixels which have been added */
+    [[nodiscard]] auto count() const -> std::uint64_t;
+
+    /** @brief Get the minimum value. Returns 0 if empty. */
+    [[nodiscard]] auto min() const -> double;
+
+    /** @brief Get the maximum value. Returns 0 if empty. */
+    [[nodiscard]] auto max() const -> double;
+
+    /** @brief Get the mean value. Returns 0 if empty. */
+    [[nodiscard]] auto mean() const -> double;
+
+    /** @brief Get the population variance. Returns 0 if empty. */
+    [[nodiscard]] auto variance() const -> double;
+
+    /** @brief Get the population standard deviation */
+    [[nodiscard]] auto stdDev() const -> double;
+
+    /**
+     * @brief Get a percentile
+     *
+     * Returns the smallest value which is greater than or equal to `p`
+     * percent of the pixels, where `p` is in the range [0, 100]. Returns 0 if
+     * empty.
+     */
+    [[nodiscard]] auto percentile(double p) const -> double;
+
+    /**
+     * @brief Get the median
+     *
+     * Returns the value at rank `count() / 2` in sorted order, i.e. the upper
+     * median if the count is even. Returns 0 if empty.
+     */
+    [[nodiscard]] auto median() const -> double;
+
+    /** @brief Get the histogram. Empty until an image has been added. */
+    [[nodiscard]] auto histogram() const -> const std::vector<std::uint64_t>&;
+
+private:
+    /** Value of the `rank`-th smallest pixel, counting from 0 */
+    [[nodiscard]] auto value_at_rank_(std::uint64_t rank) const -> double;
+    /** Representative value of a histogram bin */
+    [[nodiscard]] auto bin_value_(std::size_t bin) const -> double;
+
+    /** Depth of the added images. -1 until an image has been added. */
+    int depth_{-1};
+    /** Histogram */
+    std::vector<std::uint64_t> histogram_;
+    /** Number of pixels */
+    std::uint64_t count_{0};
+    /** Minimum value */
+    double min_{0};
+    /** Maximum value */
+    double max_{0};
+    /** Mean value */
+    double mean_{0};
+    /** Sum of squared differences from the mean */
+    double m2_{0};
+};
+}  // namespace volcart
@@ -0,0 +1,101 @@
+#pragma once
+
+/** @file */
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+namespace volcart
+{
+/**
+ * @class KDTree
+ * @brief Static 3D KD-tree for fixed-radius neighbor queries
+ *
+ * The tree is built once from a list of points and is immutable afterwards.
+ * Nodes and points are stored in flat arrays, with the points of each leaf
+ * stored contiguously, so queries do not chase pointers between individually
+ * allocated nodes. Queries are `const` and can be run concurrently from
+ * multiple threads.
+ *
+ * Example Usage:
+ * @code{.cpp}
+ * KDTree tree(points);
+ * std::vector<std::size_t> neighbors;
+ * tree.radiusSearch(points[0], 2.0, neighbors);
+ * @endcode
+ *
+ * @ingroup Types
+ */
+class KDTree
+{
+public:
+    /** Point type */
+    using Point = cv::Vec3d;
+
+    /**@{*/
+    /** @brief Default constructor. Creates an empty tree. */
+    KDTree() = default;
+
+    /**
+     * @brief Build a tree from a list of points
+     *
+     * @param points Points to index. Queries return indices into this list.
+     * @param leafSize Maximum number of points stored in a leaf node
+     */
+    explicit KDTree(std::vector<Point> points, std::size_t leafSize = 16);
+    /**@}*/
+
+    /** @brief Get the number of indexed points */
+    [[nodiscard]] auto size() const -> std::size_t;
+
+    /** @brief Whether the tree has no points */
+    [[nodiscard]] auto empty() const -> bool;
+
+    /**
+     * @brief Find all points within a radius of a query point
+     *
+     * Fills `result` with the indices of every point whose distance to `q` is
+     * less than or equal to `radius`. Indices are returned in no particular
+     * order. `result` is cleared before it is filled, so the same buffer can
+     * be reused between queries to avoid reallocation.
+     */
+    void radiusSearch(
+        const Point& q, double radius, std::vector<std::size_t>& result) const;
+
+    /** @copybrief radiusSearch() */
+    [[nodiscard]] auto radiusSearch(const Point& q, double radius) const
+        -> std::vector<std::size_t>;
+
+private:
+    /** Tree node. Leaves have no children. */
+    struct Node {
+        /** First point in this node */
+        std::size_t begin{0};
+        /** One past the last point in this node */
+        std::size_t end{0};
+        /** Index of the left child */
+        std::size_t left{0};
+        /** Index of the right child */
+        std::size_t right{0};
+        /** Split position */
+        double split{0};
+        /** Split axis, or -1 for leaves */
+        std::int8_t axis{-1};
+    };
+
+    /** Recursively build the subtree for points [begin, end) */
+    auto build_(std::size_t begin, std::size_t end) -> std::size_t;
+
+    /** Points, in leaf order */
+    std::vector<Point> points_;
+    /** Original index of each point in points_ */
+    std::vector<std::size_t> indices_;
+    /** Nodes. The root is the first node. */
+    std::vector<Node> nodes_;
+    /** Maximum leaf size */
+    std::size_t leafSize_{16};
+};
+}  // namespace volcart
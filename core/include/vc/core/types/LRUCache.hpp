@@ -88,6 +88,7 @@ public:
             last--;
             lookup_.erase(last->first);
             items_.pop_back();
+            evictions_++;
         }
     }
 
@@ -96,6 +97,9 @@ public:
 
     /** @brief Get the current number of elements in the cache */
     size_t size() const override { return lookup_.size(); }
+
+    /** @copydoc Cache::evictions() */
+    size_t evictions() const override { return evictions_; }
     /**@}*/
 
     /**@{*/
@@ -129,6 +133,7 @@ public:
             last--;
             lookup_.erase(last->first);
             items_.pop_back();
+            evictions_++;
         }
     }
 
@@ -151,5 +156,7 @@ private:
     std::list<TPair> items_;
     /** Cache usage information */
     std::unordered_map<TKey, TListIterator> lookup_;
+    /** Number of evicted elements */
+    size_t evictions_{0};
 };
 }  // namespace volcart
@@ -2,15 +2,127 @@
 
 /** @file */
 
+#include <array>
+#include <cassert>
+#include <cstddef>
 #include <exception>
 #include <functional>
+#include <initializer_list>
 #include <iostream>
 #include <iterator>
 #include <numeric>
+#include <stdexcept>
 #include <vector>
 
 namespace volcart
 {
+/**
+ * @class NDArrayView
+ * @brief Non-owning, unchecked view of an N-Dimensional array
+ *
+ * Views row-major data owned by an NDArray or by the caller, such as a stack
+ * buffer, without allocating. The extents and strides are stored inline, so
+ * views are cheap to create for every pixel. Element access is not bounds
+ * checked, except by assertions in debug builds.
+ *
+ * @ingroup Types
+ *
+ * @tparam T Type of array elements. Use `const T` for read-only views.
+ */
+template <typename T>
+class NDArrayView
+{
+public:
+    /** Maximum number of dimensions */
+    static constexpr std::size_t MAX_DIMS{4};
+    /** Extent and index type */
+    using IndexType = std::size_t;
+
+    /** @brief Default constructor. Creates an empty view. */
+    NDArrayView() = default;
+
+    /**
+     * @brief View `data` with the given extents
+     *
+     * @throws std::invalid_argument If there are more than MAX_DIMS extents
+     */
+    template <typename Extents>
+    NDArrayView(T* data, const Extents& extents) : data_{data}
+    {
+        init_(extents);
+    }
+
+    /** @overload NDArrayView(T*, const Extents&) */
+    NDArrayView(T* data, std::initializer_list<IndexType> extents)
+        : data_{data}
+    {
+        init_(extents);
+    }
+
+    /** @brief Get the number of dimensions */
+    [[nodiscard]] auto dims() const -> std::size_t { return dim_; }
+
+    /** @brief Get the extent of a dimension */
+    [[nodiscard]] auto extent(std::size_t d) const -> IndexType
+    {
+        return extents_[d];
+    }
+
+    /** @brief Get the total number of elements */
+    [[nodiscard]] auto size() const -> std::size_t { return size_; }
+
+    /** @brief Unchecked per-element access */
+    template <typename... Is>
+    auto operator()(Is... indices) const -> T&
+    {
+        assert(sizeof...(indices) == dim_ && "Index of wrong dimension");
+        IndexType idx{0};
+        std::size_t d{0};
+        ((idx += static_cast<IndexType>(indices) * strides_[d++]), ...);
+        assert(idx < size_ && "Index out of range");
+        return data_[idx];
+    }
+
+    /** @brief Get a pointer to the first element */
+    [[nodiscard]] auto data() const -> T* { return data_; }
+
+    /** @brief Get a pointer to the first element */
+    [[nodiscard]] auto begin() const -> T* { return data_; }
+
+    /** @brief Get a pointer past the last element */
+    [[nodiscard]] auto end() const -> T* { return data_ + size_; }
+
+private:
+    /** Set the extents and strides */
+    template <typename Extents>
+    void init_(const Extents& extents)
+    {
+        if (std::size(extents) > MAX_DIMS) {
+            throw std::invalid_argument("Too many dimensions for view");
+        }
+        for (const auto& e : extents) {
+            extents_[dim_++] = static_cast<IndexType>(e);
+        }
+        IndexType stride{1};
+        for (auto d = dim_; d > 0; d--) {
+            strides_[d - 1] = stride;
+            stride *= extents_[d - 1];
+        }
+        size_ = dim_ == 0 ? 0 : stride;
+    }
+
+    /** Viewed data */
+    T* data_{nullptr};
+    /** Number of dimensions */
+    std::size_t dim_{0};
+    /** Total number of elements */
+    std::size_t size_{0};
+    /** Dimension extents */
+    std::array<IndexType, MAX_DIMS> extents_{};
+    /** Distance between consecutive indices of each dimension */
+    std::array<IndexType, MAX_DIMS> strides_{};
+};
+
 /**
  * @class NDArray
  * @brief Dynamically-allocated N-Dimensional Array
@@ -120,7 +232,7 @@ public:
 
     /**@{*/
     /** @brief Per-element access */
-    T& operator()(Index index)
+    T& operator()(const Index& index)
     {
 
         if (index.size() != dim_) {
@@ -130,7 +242,7 @@ public:
     }
 
     /** @overload T& operator()(Index index) */
-    const T& operator()(Index index) const
+    const T& operator()(const Index& index) const
     {
         if (index.size() != dim_) {
             throw std::invalid_argument("Index of wrong dimension");
@@ -142,16 +254,36 @@ public:
     template <typename... Is>
     T& operator()(Is... indices)
     {
-        return operator()(Index{static_cast<IndexType>(indices)...});
+        const std::array<IndexType, sizeof...(Is)> index{
+            static_cast<IndexType>(indices)...};
+        if (index.size() != dim_) {
+            throw std::invalid_argument("Index of wrong dimension");
+        }
+        return data_.at(index_to_data_index_(index));
     }
 
     /** @overload T& operator()(Index index) */
     template <typename... Is>
     const T& operator()(Is... indices) const
     {
-        return operator()(Index{static_cast<IndexType>(indices)...});
+        const std::array<IndexType, sizeof...(Is)> index{
+            static_cast<IndexType>(indices)...};
+        if (index.size() != dim_) {
+            throw std::invalid_argument("Index of wrong dimension");
+        }
+        return data_.at(index_to_data_index_(index));
     }
 
+    /**
+     * @brief Get an unchecked view of the array
+     *
+     * The view is invalidated by setExtents() and Flatten().
+     */
+    NDArrayView<T> view() { return {data_.data(), extents_}; }
+
+    /** @overload view() */
+    NDArrayView<const T> view() const { return {data_.data(), extents_}; }
+
     /** @brief Get slice of array by dropping highest dimension */
     NDArray slice(IndexType index)
     {
@@ -179,7 +311,7 @@ public:
     typename Container::value_type* data() { return data_.data(); }
 
     /** @overload data() */
-    typename Container::value_type* data() const { return data_.data(); }
+    const typename Container::value_type* data() const { return data_.data(); }
 
     /**
      * @brief Return an iterator that points to the first element in the array
@@ -261,17 +393,15 @@ private:
     }
 
     /** Convert item index to data index */
-    inline IndexType index_to_data_index_(Index i) const
+    template <class I>
+    inline IndexType index_to_data_index_(const I& i) const
     {
         IndexType idx{0};
-        for (size_t it = 0; it < extents_.size(); it++) {
-            auto begin = std::next(extents_.begin(), it + 1);
-            auto offset = std::accumulate(
-                begin, extents_.end(), IndexType(1),
-                std::multiplies<IndexType>());
-            idx += i[it] * offset;
+        IndexType stride{1};
+        for (auto it = extents_.size(); it > 0; it--) {
+            idx += i[it - 1] * stride;
+            stride *= extents_[it - 1];
         }
-
         return idx;
     }
 };
@@ -6,9 +6,12 @@
 #include <iostream>
 #include <memory>
 #include <stdexcept>
+#include <type_traits>
+#include <vector>
 
 #include "Exceptions.hpp"
 #include "PointSet.hpp"
+#include "vc/core/util/LargePages.hpp"
 
 namespace volcart
 {
@@ -31,6 +34,18 @@ namespace volcart
  * change the width of the point set, make a new OrderedPointSet with the
  * desired width or use reset() in conjunction with setWidth().
  *
+ * Points are stored contiguously in row-major order. Growing a large set one
+ * row at a time can reallocate and copy its storage, so use reserveRows()
+ * when the final number of rows is known. Rows can be accessed without
+ * copying them through the views returned by row().
+ *
+ * Sets can be converted between point types, e.g. to store a `cv::Vec3d`
+ * set with `cv::Vec3f` points at half the memory:
+ *
+ * @code
+ * OrderedPointSet<cv::Vec3f> compact(ps);
+ * @endcode
+ *
  * In order to use the PointSetIO functions, the point type should be based on
  * `int`, `float`, or `double` (e.g. `cv::Vec2i`, `cv::Vec3d`, etc.)
  *
@@ -47,6 +62,61 @@ public:
     /** Pointer type */
     using Pointer = std::shared_ptr<OrderedPointSet<T>>;
 
+    /**
+     * @brief Non-owning view of the points of a row
+     *
+     * Views are invalidated when rows are added to the OrderedPointSet.
+     */
+    template <typename P>
+    class BasicRowView
+    {
+    public:
+        /** @brief Construct a view of `size` points starting at `data` */
+        BasicRowView(P* data, size_t size) : data_{data}, size_{size} {}
+
+        /** @brief Convert a mutable view to a const view */
+        template <
+            typename Q,
+            std::enable_if_t<
+                std::is_same_v<const Q, P> and not std::is_same_v<Q, P>,
+                bool> = true>
+        BasicRowView(const BasicRowView<Q>& other)
+            : data_{other.data()}, size_{other.size()}
+        {
+        }
+
+        /** @brief Get the point at column x */
+        P& operator[](size_t x) const
+        {
+            assert(x < size_ && "x out of range");
+            return data_[x];
+        }
+
+        /** @brief Number of points in the row */
+        size_t size() const { return size_; }
+
+        /** @brief Pointer to the first point of the row */
+        P* data() const { return data_; }
+
+        /** @brief Iterator to the first point */
+        P* begin() const { return data_; }
+
+        /** @brief Iterator past the last point */
+        P* end() const { return data_ + size_; }
+
+    private:
+        /** First point */
+        P* data_;
+        /** Number of points */
+        size_t size_;
+    };
+
+    /** Mutable row view type */
+    using RowView = BasicRowView<T>;
+
+    /** Const row view type */
+    using ConstRowView = BasicRowView<const T>;
+
     /**@{*/
     /** @brief Default constructor */
     explicit OrderedPointSet() = default;
@@ -63,6 +133,23 @@ public:
     {
         data_.assign(width_ * CAPACITY_MULTIPLIER, initVal);
     }
+
+    /**
+     * @brief Convert an OrderedPointSet with a different point type
+     *
+     * Each point is converted with `static_cast<T>()`.
+     */
+    template <
+        typename U,
+        std::enable_if_t<not std::is_same_v<U, T>, bool> = true>
+    explicit OrderedPointSet(const OrderedPointSet<U>& other)
+        : BaseClass(), width_(other.width())
+    {
+        data_.reserve(other.size());
+        for (const auto& p : other) {
+            data_.push_back(static_cast<T>(p));
+        }
+    }
     /**@}*/
 
     /**@{*/
@@ -119,6 +206,14 @@ public:
         width_ = 0;
         this->clear();
     }
+
+    /**
+     * @brief Preallocate storage for a number of rows
+     *
+     * Adding rows does not reallocate the storage until the set has more
+     * than `rows` rows.
+     */
+    void reserveRows(size_t rows) { data_.reserve(width_ * rows); }
     /**@}*/
 
     /**@{*/
@@ -126,16 +221,25 @@ public:
     void pushRow(const std::vector<T>& points)
     {
         assert(points.size() == width_ && "row incorrect size");
-        std::copy(
-            std::begin(points), std::end(points), std::back_inserter(data_));
+        data_.insert(std::end(data_), std::begin(points), std::end(points));
     }
 
     /** @copydoc OrderedPointSet::pushRow() */
     void pushRow(std::vector<T>&& points)
     {
         assert(points.size() == width_ && "row incorrect size");
-        std::copy(
-            std::begin(points), std::end(points), std::back_inserter(data_));
+        data_.insert(std::end(data_), std::begin(points), std::end(points));
+    }
+
+    /**
+     * @copydoc OrderedPointSet::pushRow()
+     *
+     * The row must not be a view of this OrderedPointSet.
+     */
+    void pushRow(const ConstRowView& points)
+    {
+        assert(points.size() == width_ && "row incorrect size");
+        data_.insert(std::end(data_), points.begin(), points.end());
     }
 
     // Cannot add individual points to this class because it would break
@@ -159,23 +263,40 @@ public:
             throw std::logic_error(msg);
         }
 
-        std::copy(std::begin(ps), std::end(ps), std::back_inserter(data_));
+        data_.insert(std::end(data_), std::begin(ps), std::end(ps));
     }
 
-    /** @brief Get a row of points
+    /** @brief Get a copy of a row of points
      *
      * Throws a std::range_error if `i` is outside the range of row indices.
+     *
+     * @see row()
      */
     std::vector<T> getRow(size_t i) const
+    {
+        auto r = row(i);
+        return {r.begin(), r.end()};
+    }
+
+    /** @brief Get a view of a row of points
+     *
+     * Throws a std::range_error if `i` is outside the range of row indices.
+     */
+    RowView row(size_t i)
     {
         if (i >= this->height()) {
             throw std::range_error("out of range");
         }
-        std::vector<T> row(width_);
-        std::copy(
-            std::begin(data_) + width_ * i,
-            std::begin(data_) + width_ * (i + 1), std::begin(row));
-        return row;
+        return {data_.data() + width_ * i, width_};
+    }
+
+    /** @copydoc row(size_t) */
+    ConstRowView row(size_t i) const
+    {
+        if (i >= this->height()) {
+            throw std::range_error("out of range");
+        }
+        return {data_.data() + width_ * i, width_};
     }
 
     /**
@@ -203,15 +324,18 @@ public:
 
     /**@{*/
     /** @brief Create an OrderedPointSet of a specific size, filled with an
-     * initial value */
+     * initial value
+     *
+     * Large point sets are backed by huge pages if they are enabled. See
+     * memory::SetLargePages().
+     */
     static OrderedPointSet Fill(size_t width, size_t height, T initVal)
     {
         OrderedPointSet ps(width);
-        std::vector<T> v;
-        v.assign(width, initVal);
-        for (size_t _ = 0; _ < height; ++_) {
-            ps.pushRow(v);
-        }
+        ps.data_.reserve(width * height);
+        memory::AdviseLargePages(
+            ps.data_.data(), ps.data_.capacity() * sizeof(T));
+        ps.data_.assign(width * height, initVal);
         return ps;
     }
     /**@{*/
@@ -2,13 +2,18 @@
 
 /** @file */
 
+#include <atomic>
+#include <cstdint>
+#include <limits>
 #include <memory>
+#include <mutex>
 
 #include <opencv2/core.hpp>
 
 #include "vc/core/filesystem.hpp"
 #include "vc/core/types/OrderedPointSet.hpp"
 #include "vc/core/types/UVMap.hpp"
+#include "vc/core/util/MemoryUsage.hpp"
 
 namespace volcart
 {
@@ -43,6 +48,15 @@ namespace volcart
  * The texturing::PPMGenerator class generates a PerPixelMap by mapping
  * pixels through the barycentric coordinates of the mesh's triangular faces.
  *
+ * PPMs can be written in one of two file formats (see Format). The Compact
+ * format is memory mapped by ReadPPM(), so that mappings are paged in from
+ * disk only as they are accessed. A memory-mapped PPM is read-only: calling
+ * any non-const accessor or modifier first copies the entire map into
+ * memory. Prefer the const accessors when reading large PPMs. Non-const
+ * accessors may be called from multiple threads, in which case the map is
+ * copied once, but must not race with the const accessors of a map which is
+ * still memory mapped.
+ *
  * @ingroup Types
  */
 class PerPixelMap
@@ -75,6 +89,67 @@ public:
     /** Pointer type */
     using Pointer = std::shared_ptr<PerPixelMap>;
 
+    /** Linear pixel index: `y * width() + x` */
+    using PixelIndex = std::size_t;
+
+    /** @brief Order of the indices returned by getMappingIndices() */
+    enum class MappingOrder {
+        /** @brief Row-major pixel order */
+        Raster = 0,
+        /**
+         * @brief Ascending order of the mapped Volume slice, `floor(z)`.
+         * Pixels which map to the same slice are in Raster order.
+         */
+        Slice,
+        /**
+         * @brief Morton (Z-order) curve order of the mapped cell. Positions
+         * are grouped into cells, usually the Volume's blocks, and the cells
+         * are visited along the curve. Pixels which map to the same cell are
+         * in Raster order.
+         */
+        Morton,
+        /**
+         * @brief Hilbert curve order of the mapped cell. Like Morton, but
+         * consecutive cells are always neighbors.
+         */
+        Hilbert
+    };
+
+    /** @brief PPM file format */
+    enum class Format {
+        /**
+         * @brief Double-precision position and normal for every pixel,
+         * including pixels without a mapping. Loaded entirely into memory.
+         */
+        Dense = 0,
+        /**
+         * @brief Single-precision position and normal for mapped pixels
+         * only. Memory mapped when read.
+         */
+        Compact
+    };
+
+    /**
+     * @brief Memory-mapped storage of a Format::Compact PPM
+     *
+     * Each pointer keeps the mapping alive, so the storage remains valid
+     * after the PerPixelMap is modified or destroyed.
+     */
+    struct CompactData {
+        /** Value of `index` for pixels without a mapping */
+        static constexpr std::uint32_t NO_RECORD{
+            std::numeric_limits<std::uint32_t>::max()};
+        /** Number of floats in each record: position, then normal */
+        static constexpr std::size_t RECORD_DIMS{6};
+
+        /** Record number of each pixel, row-major, or NO_RECORD */
+        std::shared_ptr<const std::uint32_t> index;
+        /** Mapped pixel records */
+        std::shared_ptr<const float> records;
+        /** Number of records */
+        std::size_t count{0};
+    };
+
     /**@{*/
     /** @brief Default constructor */
     PerPixelMap() = default;
@@ -95,18 +170,21 @@ public:
      * The map is initialized as soon as its width and height have been set.
      */
     [[nodiscard]] auto initialized() const -> bool;
+
+    /** @brief Return whether the map is backed by a memory-mapped file */
+    [[nodiscard]] auto memoryMapped() const -> bool;
     /**@}*/
 
     /**@{*/
     /** @brief Get the mapping for a pixel by x, y coordinate */
-    auto operator()(size_t y, size_t x) const -> const cv::Vec6d&;
+    auto operator()(size_t y, size_t x) const -> cv::Vec6d;
 
     /** @copydoc operator()() */
     auto operator()(size_t y, size_t x) -> cv::Vec6d&;
 
     /** @copydoc operator()() */
     [[nodiscard]] auto getMapping(std::size_t y, std::size_t x) const
-        -> const cv::Vec6d&;
+        -> cv::Vec6d;
 
     /** @copydoc operator()() */
     auto getMapping(std::size_t y, std::size_t x) -> cv::Vec6d&;
@@ -119,14 +197,82 @@ public:
     [[nodiscard]] auto hasMapping(size_t y, size_t x) const -> bool;
 
     /** @brief Get the mapping for a pixel as a PixelMap */
-    auto getAsPixelMap(size_t y, size_t x) -> PixelMap;
+    [[nodiscard]] auto getAsPixelMap(size_t y, size_t x) const -> PixelMap;
+
+    /** @copydoc getAsPixelMap(size_t, size_t) const */
+    [[nodiscard]] auto getAsPixelMap(PixelIndex idx) const -> PixelMap;
 
     /**
      * @brief Get all valid pixel mappings as a list of PixelMap
      *
      * Uses hasMapping() to determine which pixels in the PPM are valid.
+     *
+     * @warning This copies every valid mapping. To iterate over large PPMs,
+     * prefer getMappingIndices() and the const accessors.
      */
     [[nodiscard]] auto getMappings() const -> std::vector<PixelMap>;
+
+    /** @brief Get the number of pixels which have a mapping */
+    [[nodiscard]] auto numMappings() const -> size_t;
+
+    /**
+     * @brief Get the linear indices of all valid pixel mappings
+     *
+     * Unlike getMappings(), this does not copy the mapping values. Use
+     * getAsPixelMap(PixelIndex) or the const accessors to look up the mapping
+     * for each index. MappingOrder::Slice groups the pixels by the Volume
+     * slice they sample, which improves slice cache reuse while texturing.
+     * MappingOrder::Morton and MappingOrder::Hilbert group them by the cell
+     * of shape `cell` (x, y, z) they sample, which improves block cache
+     * reuse. `cell` is ignored by the other orders.
+     */
+    [[nodiscard]] auto getMappingIndices(
+        MappingOrder order = MappingOrder::Raster,
+        const cv::Vec3i& cell = {1, 1, 1}) const -> std::vector<PixelIndex>;
+
+    /**
+     * @brief Get the mappings of a list of pixels
+     *
+     * Copies the mapping of each pixel in `indices` into a contiguous buffer,
+     * in the same order. Pixels are gathered in parallel. Combined with
+     * getMappingIndices(), this extracts every valid mapping without the
+     * per-pixel overhead of getMappings().
+     */
+    [[nodiscard]] auto getMappingValues(
+        const std::vector<PixelIndex>& indices) const -> std::vector<cv::Vec6d>;
+    /**@}*/
+
+    /**@{*/
+    /**
+     * @brief Apply an affine transform to every mapping
+     *
+     * Positions are transformed by the homogeneous matrix `tfm`. Normals are
+     * transformed by the inverse transpose of its linear part, so that they
+     * remain perpendicular to the surface, and are rescaled to their original
+     * length. Pixels without a mapping are not modified. Rows are processed
+     * in parallel.
+     *
+     * @throws std::invalid_argument If the linear part of `tfm` is singular
+     */
+    void applyTransform(const cv::Matx44d& tfm);
+    /**@}*/
+
+    /**@{*/
+    /**
+     * @brief Get the in-memory mapping of every pixel
+     *
+     * Returns a pointer to `height() * width()` mappings in row-major order,
+     * or `nullptr` if the map is memory mapped or uninitialized. The pointer
+     * is invalidated by any function which resizes the map.
+     */
+    [[nodiscard]] auto data() const -> const cv::Vec6d*;
+
+    /**
+     * @brief Get the storage of a memory-mapped map without copying it
+     *
+     * @throws std::logic_error If the map is not memory mapped
+     */
+    [[nodiscard]] auto compactData() const -> CompactData;
     /**@}*/
 
     /**@{*/
@@ -188,16 +334,58 @@ public:
      * @copydetails cellMap()
      */
     void setCellMap(const cv::Mat& m);
+
+    /**
+     * @brief Get the barycentric map image
+     *
+     * A `CV_64FC3` image with the barycentric coordinate of each mapped pixel
+     * within the face given by the cell map. Together with the cell map, it
+     * locates every pixel on the mesh without any ray tracing, so that the
+     * PPM of a deformed mesh with the same faces and UV map can be
+     * regenerated by interpolation alone. See
+     * texturing::PPMGenerator::setReferencePPM(). This is an optional
+     * feature, and older PPMs may not make this information available.
+     */
+    [[nodiscard]] auto barycentricMap() const -> cv::Mat;
+
+    /**
+     * @brief Set the barycentric map image
+     *
+     * @copydetails barycentricMap()
+     */
+    void setBarycentricMap(const cv::Mat& m);
     /**@}*/
 
     /**@{*/
     /** @brief Write a PerPixelMap to disk */
-    static void WritePPM(const filesystem::path& path, const PerPixelMap& map);
+    static void WritePPM(
+        const filesystem::path& path,
+        const PerPixelMap& map,
+        Format format = Format::Dense);
 
-    /** @brief Read a PerPixelMap from disk */
+    /**
+     * @brief Read a PerPixelMap from disk
+     *
+     * The file format is detected automatically. Compact PPMs are memory
+     * mapped rather than read into memory.
+     */
     static auto ReadPPM(const filesystem::path& path) -> PerPixelMap;
     /**@}*/
 
+    /**
+     * @brief Subsample a PerPixelMap by an integer factor
+     *
+     * Pixel (y, x) of the result is pixel (y * factor, x * factor) of the
+     * input, including its mask, cell map and barycentric map values. The mappings are not
+     * modified, so the result samples the same points of the Volume at
+     * `1 / factor` of the resolution. Useful for fast, low-resolution
+     * previews of a texture. Rows are subsampled in parallel.
+     *
+     * @throws std::invalid_argument If `factor == 0`
+     */
+    static auto Subsample(const PerPixelMap& map, std::size_t factor)
+        -> PerPixelMap;
+
 private:
     /**
      * Initialize the map for value assignment
@@ -206,6 +394,43 @@ private:
      */
     void initialize_map_();
 
+    /** Memory-mapped Compact PPM file */
+    struct MappedFile;
+
+    /**
+     * Copy the memory-mapped file into map_ and mask_ and release the
+     * mapping. Does nothing if the map is not memory mapped. Safe to call
+     * from multiple threads.
+     */
+    void detach_();
+
+    /**
+     * Synchronizes detach_(). Copies share the flag, but not the mutex, of
+     * the original.
+     */
+    struct DetachState {
+        DetachState() = default;
+        DetachState(const DetachState& other) : mapped{other.mapped.load()} {}
+        auto operator=(const DetachState& other) -> DetachState&
+        {
+            mapped = other.mapped.load();
+            return *this;
+        }
+        /** Whether mapped_ may be set */
+        std::atomic<bool> mapped{false};
+        /** Held while the map is copied */
+        std::mutex mutex;
+    };
+
+    /** Sort mapping indices along a space-filling curve of cells */
+    auto curve_order_(
+        std::vector<PixelIndex> indices,
+        MappingOrder order,
+        const cv::Vec3i& cell) const -> std::vector<PixelIndex>;
+
+    /** Update the memory counted for map_, mask_, cellMap_ and baryMap_ */
+    void update_memory_();
+
     /** Height of the map */
     size_t height_{0};
     /** Width of the map */
@@ -223,5 +448,20 @@ private:
 
     /** Cell map */
     cv::Mat cellMap_;
+
+    /** Barycentric map */
+    cv::Mat baryMap_;
+
+    /** Memory-mapped map data. Shared between copies of this map. */
+    std::shared_ptr<const MappedFile> mapped_;
+
+    /** Synchronizes detach_() */
+    DetachState detachState_;
+
+    /**
+     * Memory held by this map. Memory-mapped data is not counted, since it
+     * is owned by the page cache.
+     */
+    memory::TrackedBytes memory_{MemoryCategory::PPM};
 };
 }  // namespace volcart
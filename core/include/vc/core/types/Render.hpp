@@ -55,6 +55,17 @@ public:
      */
     [[nodiscard]] auto graph() const -> std::shared_ptr<smgl::Graph>;
 
+    /**
+     * @brief Store the profiling results of a graph update
+     *
+     * The profile is saved in the render's metadata file alongside the
+     * graph, so that it is not overwritten when the graph cache is saved.
+     */
+    void setProfile(const smgl::Metadata& profile);
+
+    /** @brief Get the stored profiling results, if any */
+    [[nodiscard]] auto profile() const -> smgl::Metadata;
+
 private:
     /** Render graph */
     mutable std::shared_ptr<smgl::Graph> graph_;
@@ -2,7 +2,11 @@
 
 /** @file */
 
+#include <memory>
+
 #include "vc/core/filesystem.hpp"
+#include "vc/core/io/MappedPointSet.hpp"
+#include "vc/core/io/PointSetWriter.hpp"
 #include "vc/core/types/DiskBasedObjectBaseClass.hpp"
 #include "vc/core/types/OrderedPointSet.hpp"
 #include "vc/core/types/Volume.hpp"
@@ -31,6 +35,12 @@ public:
     /** Point set type */
     using PointSet = OrderedPointSet<cv::Vec3d>;
 
+    /** Memory-mapped point set type */
+    using PointSetView = MappedPointSet<cv::Vec3d>;
+
+    /** Asynchronous point set writer type */
+    using PointSetWriter = AsyncPointSetWriter<cv::Vec3d>;
+
     /** Shared pointer type */
     using Pointer = std::shared_ptr<Segmentation>;
 
@@ -62,6 +72,18 @@ public:
      */
     void setPointSet(const PointSet& ps);
 
+    /**
+     * @brief Append rows to the PointSet file as they are computed
+     *
+     * Keeps the first `keepRows` rows of the associated PointSet and returns
+     * a writer which appends new rows on a background thread, so a long
+     * segmentation can be checkpointed without rewriting the whole PointSet.
+     * If the Segmentation has no PointSet, or its PointSet is not `width`
+     * points wide, a new empty PointSet is started instead.
+     */
+    auto appendPointSet(std::size_t width, std::size_t keepRows)
+        -> std::unique_ptr<PointSetWriter>;
+
     /**
      * @brief Load the associated PointSet from the Segmentation file
      *
@@ -69,6 +91,14 @@ public:
      */
     PointSet getPointSet() const;
 
+    /**
+     * @brief Memory map the associated PointSet from the Segmentation file
+     *
+     * Points are paged in from disk as they are accessed rather than read
+     * into memory. The view does not reflect later calls to setPointSet().
+     */
+    PointSetView getPointSetView() const;
+
     /** @brief Return whether this Segmentation is associated with a Volume */
     bool hasVolumeID() const
     {
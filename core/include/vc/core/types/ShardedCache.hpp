@@ -0,0 +1,282 @@
+#pragma once
+
+/** @file */
+
+#include <algorithm>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "vc/core/types/Cache.hpp"
+#include "vc/core/types/LRUCache.hpp"
+
+namespace volcart
+{
+/**
+ * @class ShardedCache
+ * @brief Thread-safe cache which partitions keys across independent shards
+ *
+ * Keys are distributed across a fixed number of shards by their hash, or by a
+ * user-provided ShardSelector which keeps related keys in the same shards,
+ * such as the slices assigned to a NUMA node. Each shard is a separate Cache
+ * guarded by its own mutex, so that threads accessing different keys rarely
+ * contend for the same lock. The replacement
+ * policy and capacity units are those of the shard caches, which are
+ * constructed by a user-provided factory (LRUCache by default). The capacity
+ * of the cache is divided evenly between the shards.
+ *
+ * In addition to the Cache interface, getOrLoad() provides an atomic
+ * lookup-or-load operation. Loads are performed outside of the shard lock and
+ * are de-duplicated: if several threads miss on the same key, only one of
+ * them executes the loader while the others wait for its result.
+ *
+ * All member functions are safe to call concurrently.
+ *
+ * @ingroup Types
+ */
+template <typename TKey, typename TValue>
+class ShardedCache final : public Cache<TKey, TValue>
+{
+public:
+    using BaseClass = Cache<TKey, TValue>;
+    using BaseClass::capacity_;
+
+    /** Shard cache pointer type */
+    using ShardPointer = typename BaseClass::Pointer;
+
+    /** Factory which constructs a shard with the given capacity */
+    using ShardFactory = std::function<ShardPointer(size_t)>;
+
+    /**
+     * Function which maps a key to the index of its shard. Indices are taken
+     * modulo the number of shards.
+     */
+    using ShardSelector = std::function<size_t(const TKey&)>;
+
+    /** Shared pointer type */
+    using Pointer = std::shared_ptr<ShardedCache<TKey, TValue>>;
+
+    /** Default number of shards */
+    static constexpr size_t DEFAULT_SHARDS = 8;
+
+    /**@{*/
+    /**
+     * @brief Constructor
+     *
+     * @param capacity Total capacity of the cache
+     * @param numShards Number of independently locked shards
+     * @param factory Shard constructor. Defaults to LRUCache.
+     * @param selector Shard of each key. Defaults to the key's hash.
+     */
+    explicit ShardedCache(
+        size_t capacity,
+        size_t numShards = DEFAULT_SHARDS,
+        ShardFactory factory = DefaultFactory,
+        ShardSelector selector = {})
+        : BaseClass(capacity), selector_{std::move(selector)}
+    {
+        if (numShards == 0) {
+            throw std::invalid_argument("Cannot create cache with 0 shards");
+        }
+        shards_.resize(numShards);
+        for (auto& s : shards_) {
+            s = std::make_unique<Shard>();
+            s->cache = factory(shard_capacity_());
+        }
+    }
+
+    /** @overload ShardedCache(size_t, size_t, ShardFactory, ShardSelector) */
+    static Pointer New(
+        size_t capacity,
+        size_t numShards = DEFAULT_SHARDS,
+        ShardFactory factory = DefaultFactory,
+        ShardSelector selector = {})
+    {
+        return std::make_shared<ShardedCache<TKey, TValue>>(
+            capacity, numShards, std::move(factory), std::move(selector));
+    }
+    /**@}*/
+
+    /**@{*/
+    /**
+     * @brief Set the maximum capacity of the cache
+     *
+     * Each shard receives an equal share of the capacity, but never less than
+     * one unit.
+     */
+    void setCapacity(size_t newCapacity) override
+    {
+        if (newCapacity <= 0) {
+            throw std::invalid_argument(
+                "Cannot create cache with capacity <= 0");
+        }
+        capacity_ = newCapacity;
+        for (auto& s : shards_) {
+            const std::lock_guard<std::mutex> lock(s->mutex);
+            s->cache->setCapacity(shard_capacity_());
+        }
+    }
+
+    /** @brief Get the maximum capacity of the cache */
+    size_t capacity() const override { return capacity_; }
+
+    /** @brief Get the current number of elements in the cache */
+    size_t size() const override
+    {
+        size_t size{0};
+        for (const auto& s : shards_) {
+            const std::lock_guard<std::mutex> lock(s->mutex);
+            size += s->cache->size();
+        }
+        return size;
+    }
+
+    /** @brief Get the total number of elements evicted by the shards */
+    size_t evictions() const override
+    {
+        size_t evictions{0};
+        for (const auto& s : shards_) {
+            const std::lock_guard<std::mutex> lock(s->mutex);
+            evictions += s->cache->evictions();
+        }
+        return evictions;
+    }
+
+    /** @brief Get the number of shards */
+    size_t numShards() const { return shards_.size(); }
+
+    /**
+     * @brief Get a shard cache by index
+     *
+     * @warning Accessing the shard's members is not thread safe.
+     */
+    ShardPointer shard(size_t idx) const { return shards_.at(idx)->cache; }
+    /**@}*/
+
+    /**@{*/
+    /** @brief Get an item from the cache by key */
+    TValue get(const TKey& k) override
+    {
+        auto& s = shard_(k);
+        const std::lock_guard<std::mutex> lock(s.mutex);
+        return s.cache->get(k);
+    }
+
+    /** @brief Put an item into the cache */
+    void put(const TKey& k, const TValue& v) override
+    {
+        auto& s = shard_(k);
+        const std::lock_guard<std::mutex> lock(s.mutex);
+        s.cache->put(k, v);
+    }
+
+    /** @brief Check if an item is already in the cache */
+    bool contains(const TKey& k) override
+    {
+        auto& s = shard_(k);
+        const std::lock_guard<std::mutex> lock(s.mutex);
+        return s.cache->contains(k);
+    }
+
+    /** @brief Clear the cache */
+    void purge() override
+    {
+        for (auto& s : shards_) {
+            const std::lock_guard<std::mutex> lock(s->mutex);
+            s->cache->purge();
+        }
+    }
+
+    /**
+     * @brief Get an item from the cache, loading it on a miss
+     *
+     * If the key is not in the cache, `load()` is called without holding any
+     * lock and the result is added to the cache. Concurrent misses on the same
+     * key wait for the first caller's load rather than calling `load()` again.
+     * If `load()` throws, the exception is propagated to every waiting caller
+     * and nothing is cached.
+     *
+     * @tparam TLoader Callable with signature `TValue()`
+     */
+    template <typename TLoader>
+    TValue getOrLoad(const TKey& k, TLoader&& load)
+    {
+        auto& s = shard_(k);
+        std::unique_lock<std::mutex> lock(s.mutex);
+        if (s.cache->contains(k)) {
+            return s.cache->get(k);
+        }
+
+        // Wait on another thread's load
+        auto loading = s.loading.find(k);
+        if (loading != s.loading.end()) {
+            auto future = loading->second;
+            lock.unlock();
+            return future.get();
+        }
+
+        std::promise<TValue> promise;
+        s.loading.emplace(k, promise.get_future().share());
+        lock.unlock();
+
+        // Load outside of the lock
+        try {
+            TValue v = load();
+            lock.lock();
+            s.cache->put(k, v);
+            s.loading.erase(k);
+            lock.unlock();
+            promise.set_value(v);
+            return v;
+        } catch (...) {
+            if (not lock.owns_lock()) {
+                lock.lock();
+            }
+            s.loading.erase(k);
+            lock.unlock();
+            promise.set_exception(std::current_exception());
+            throw;
+        }
+    }
+    /**@}*/
+
+    /** @brief Default shard factory. Constructs an LRUCache. */
+    static ShardPointer DefaultFactory(size_t capacity)
+    {
+        return LRUCache<TKey, TValue>::New(capacity);
+    }
+
+private:
+    /** A single cache partition */
+    struct Shard {
+        /** Shard mutex */
+        std::mutex mutex;
+        /** Shard data */
+        ShardPointer cache;
+        /** In-flight loads */
+        std::unordered_map<TKey, std::shared_future<TValue>> loading;
+    };
+
+    /** Cache partitions */
+    std::vector<std::unique_ptr<Shard>> shards_;
+    /** Shard of each key. Empty to use the key's hash. */
+    ShardSelector selector_;
+
+    /** Get the shard responsible for a key */
+    Shard& shard_(const TKey& k)
+    {
+        auto idx = selector_ ? selector_(k) : std::hash<TKey>{}(k);
+        return *shards_[idx % shards_.size()];
+    }
+
+    /** Get the capacity of each shard */
+    size_t shard_capacity_() const
+    {
+        auto n = shards_.size();
+        return std::max<size_t>(1, (capacity_ + n - 1) / n);
+    }
+};
+}  // namespace volcart
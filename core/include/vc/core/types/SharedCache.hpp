@@ -0,0 +1,182 @@
+#pragma once
+
+/** @file */
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+
+#include "vc/core/types/Cache.hpp"
+#include "vc/core/types/ShardedCache.hpp"
+
+namespace volcart
+{
+/**
+ * @brief Key of an element in a SharedCache
+ *
+ * Combines the key used by a single client of the cache with a token which is
+ * unique to that client.
+ */
+template <typename TKey>
+struct SharedCacheKey {
+    /** Unique identifier of the client which owns the element */
+    std::uint64_t owner;
+    /** Client key */
+    TKey key;
+
+    /** Equality comparison */
+    bool operator==(const SharedCacheKey& rhs) const
+    {
+        return owner == rhs.owner and key == rhs.key;
+    }
+};
+}  // namespace volcart
+
+namespace std
+{
+/** @brief Hash function for volcart::SharedCacheKey */
+template <typename TKey>
+struct hash<volcart::SharedCacheKey<TKey>> {
+    /** Get the hash of a key */
+    size_t operator()(const volcart::SharedCacheKey<TKey>& k) const
+    {
+        auto h = std::hash<TKey>{}(k.key);
+        auto o = std::hash<std::uint64_t>{}(k.owner);
+        return h ^ (o + 0x9e3779b9 + (h << 6) + (h >> 2));
+    }
+};
+}  // namespace std
+
+namespace volcart
+{
+/**
+ * @brief Thread-safe cache whose capacity is shared by several clients
+ *
+ * A ShardedCache in which every key is tagged with the client which stored
+ * it. Clients access the cache through SharedCacheView objects, which behave
+ * like independent caches while drawing on the same capacity. Elements are
+ * therefore evicted according to the combined demand of all clients rather
+ * than a fixed per-client quota.
+ *
+ * @ingroup Types
+ */
+template <typename TKey, typename TValue>
+using SharedCache = ShardedCache<SharedCacheKey<TKey>, TValue>;
+
+/**
+ * @class SharedCacheView
+ * @brief A single client's view of a SharedCache
+ *
+ * Elements put into the view are only visible through the same view. Each
+ * view is assigned a new, unique token on construction and whenever it is
+ * purged. Purging a view does not remove its elements from the shared cache
+ * immediately. Instead, they become unreachable and are evicted as other
+ * elements are loaded.
+ *
+ * Because the capacity is shared, capacity() and setCapacity() refer to the
+ * capacity of the shared cache. size() reports the number of elements in the
+ * shared cache across all views.
+ *
+ * All member functions are safe to call concurrently.
+ *
+ * @ingroup Types
+ */
+template <typename TKey, typename TValue>
+class SharedCacheView final : public Cache<TKey, TValue>
+{
+public:
+    using BaseClass = Cache<TKey, TValue>;
+
+    /** Shared cache type */
+    using Storage = SharedCache<TKey, TValue>;
+
+    /** Shared pointer type */
+    using Pointer = std::shared_ptr<SharedCacheView<TKey, TValue>>;
+
+    /**@{*/
+    /** @brief Constructor */
+    explicit SharedCacheView(typename Storage::Pointer storage)
+        : BaseClass(1), storage_{std::move(storage)}, owner_{NextOwner()}
+    {
+        if (not storage_) {
+            throw std::invalid_argument("Shared cache is null");
+        }
+    }
+
+    /** @overload SharedCacheView(typename Storage::Pointer) */
+    static Pointer New(typename Storage::Pointer storage)
+    {
+        return std::make_shared<SharedCacheView<TKey, TValue>>(
+            std::move(storage));
+    }
+    /**@}*/
+
+    /**@{*/
+    /** @brief Set the maximum capacity of the shared cache */
+    void setCapacity(size_t newCapacity) override
+    {
+        storage_->setCapacity(newCapacity);
+    }
+
+    /** @brief Get the maximum capacity of the shared cache */
+    size_t capacity() const override { return storage_->capacity(); }
+
+    /** @brief Get the current number of elements in the shared cache */
+    size_t size() const override { return storage_->size(); }
+
+    /** @brief Get the number of elements evicted from the shared cache */
+    size_t evictions() const override { return storage_->evictions(); }
+
+    /** @brief Get the shared cache */
+    typename Storage::Pointer storage() const { return storage_; }
+    /**@}*/
+
+    /**@{*/
+    /** @brief Get an item from the cache by key */
+    TValue get(const TKey& k) override { return storage_->get(key_(k)); }
+
+    /** @brief Put an item into the cache */
+    void put(const TKey& k, const TValue& v) override
+    {
+        storage_->put(key_(k), v);
+    }
+
+    /** @brief Check if an item is already in the cache */
+    bool contains(const TKey& k) override
+    {
+        return storage_->contains(key_(k));
+    }
+
+    /** @brief Clear this view's items from the cache */
+    void purge() override { owner_ = NextOwner(); }
+
+    /** @copydoc ShardedCache::getOrLoad() */
+    template <typename TLoader>
+    TValue getOrLoad(const TKey& k, TLoader&& load)
+    {
+        return storage_->getOrLoad(key_(k), std::forward<TLoader>(load));
+    }
+    /**@}*/
+
+private:
+    /** Shared cache */
+    typename Storage::Pointer storage_;
+    /** Unique token for this view's items */
+    std::atomic<std::uint64_t> owner_;
+
+    /** Get the shared key for a client key */
+    SharedCacheKey<TKey> key_(const TKey& k) const
+    {
+        return {owner_.load(), k};
+    }
+
+    /** Get a new, unique owner token */
+    static std::uint64_t NextOwner()
+    {
+        static std::atomic<std::uint64_t> next{0};
+        return next++;
+    }
+};
+}  // namespace volcart
@@ -0,0 +1,52 @@
+#pragma once
+
+/** @file */
+
+#include <utility>
+
+#include <opencv2/core.hpp>
+
+namespace volcart
+{
+/**
+ * @class SliceView
+ * @brief Read-only handle to a Volume slice
+ *
+ * Volume::getSliceView() returns a slice without copying it, so the image
+ * may share memory with the Volume's slice cache. The view holds a
+ * reference to the image, which keeps the image valid even if the slice is
+ * evicted from the cache, and only provides const access to it. Use clone()
+ * to get a copy which may be modified.
+ *
+ * @warning cv::Mat can't enforce constness. Copying the image returned by
+ * mat() into a non-const cv::Mat and writing to it modifies the cached
+ * slice.
+ *
+ * @ingroup Types
+ */
+class SliceView
+{
+public:
+    /** @brief Construct an empty view */
+    SliceView() = default;
+
+    /** @brief Construct a view of an image */
+    explicit SliceView(cv::Mat mat) : mat_{std::move(mat)} {}
+
+    /** @brief Get the image */
+    const cv::Mat& mat() const { return mat_; }
+
+    /** @brief Pass the view to functions which read an image */
+    operator const cv::Mat&() const { return mat_; }
+
+    /** @brief Get a copy of the image which may be modified */
+    cv::Mat clone() const { return mat_.clone(); }
+
+    /** @brief Return whether the view is empty */
+    bool empty() const { return mat_.empty(); }
+
+private:
+    /** Viewed image */
+    cv::Mat mat_;
+};
+}  // namespace volcart
@@ -0,0 +1,298 @@
+#pragma once
+
+/** @file */
+
+#include <algorithm>
+#include <list>
+#include <memory>
+#include <stdexcept>
+#include <unordered_map>
+
+#include "vc/core/types/Cache.hpp"
+
+namespace volcart
+{
+/**
+ * @brief Functor which charges every cached value one unit
+ *
+ * Makes the capacity of TwoQCache a number of elements.
+ */
+template <typename T>
+struct CacheValueCount {
+    /** Get the size of a value in elements */
+    auto operator()(const T& /*v*/) const -> size_t { return 1; }
+};
+
+/**
+ * @class TwoQCache
+ * @brief Scan-resistant cache using the 2Q replacement policy
+ *
+ * A cache which separates elements which have been used once from elements
+ * which have been used repeatedly. New elements enter a FIFO queue (A1in)
+ * which is limited to a quarter of the capacity. When they are evicted from
+ * it, only their keys are remembered in a ghost queue (A1out) which covers
+ * half of the capacity. An element which is read with get() while it is in
+ * A1in, or which is put again while its key is in A1out, has been reused, so
+ * it is promoted to an LRU queue (Am) which may use the rest of the capacity.
+ * Elements which are evicted from Am are forgotten.
+ *
+ * A long sequential scan therefore only cycles through A1in and cannot evict
+ * the frequently used elements in Am, which is what happens to LRUCache when a
+ * scan is larger than its capacity. A scan does not displace the working set
+ * of other users of the same cache, such as the volumes of a VolumeServer.
+ *
+ * The original 2Q policy ignores hits in A1in as correlated references and
+ * only promotes elements from A1out. This cache also promotes on A1in hits,
+ * because cache users such as Volume only put() an element after a miss, so
+ * an element which stays cached would otherwise never be promoted.
+ *
+ * Capacity is measured in the units of TSizeOf. By default, every element is
+ * one unit. Use CacheValueBytes to measure the capacity in bytes like
+ * ByteLRUCache. An element which is larger than the capacity of the cache is
+ * never stored.
+ *
+ * Based on: Johnson, T. and Shasha, D. "2Q: A Low Overhead High Performance
+ * Buffer Management Replacement Algorithm." VLDB 1994.
+ *
+ * @tparam TSizeOf Functor returning the size of a TValue in capacity units
+ *
+ * @ingroup Types
+ */
+template <
+    typename TKey,
+    typename TValue,
+    typename TSizeOf = CacheValueCount<TValue>>
+class TwoQCache final : public Cache<TKey, TValue>
+{
+public:
+    using BaseClass = Cache<TKey, TValue>;
+    using BaseClass::capacity_;
+
+    /** Stored key/value/size tuple */
+    struct Entry {
+        /** Key */
+        TKey key;
+        /** Value */
+        TValue value;
+        /** Size of value in capacity units */
+        size_t size;
+    };
+
+    /** Entry list iterator */
+    using TListIterator = typename std::list<Entry>::iterator;
+
+    /** Shared pointer type */
+    using Pointer = std::shared_ptr<TwoQCache<TKey, TValue, TSizeOf>>;
+
+    /**@{*/
+    /** @brief Default constructor */
+    TwoQCache() : BaseClass() {}
+
+    /** @brief Constructor with cache capacity parameter */
+    explicit TwoQCache(size_t capacity) : BaseClass(capacity) {}
+
+    /** @overload TwoQCache() */
+    static Pointer New()
+    {
+        return std::make_shared<TwoQCache<TKey, TValue, TSizeOf>>();
+    }
+
+    /** @overload TwoQCache(size_t) */
+    static Pointer New(size_t capacity)
+    {
+        return std::make_shared<TwoQCache<TKey, TValue, TSizeOf>>(capacity);
+    }
+    /**@}*/
+
+    /**@{*/
+    /** @brief Set the maximum size of the cache */
+    void setCapacity(size_t capacity) override
+    {
+        if (capacity <= 0) {
+            throw std::invalid_argument(
+                "Cannot create cache with capacity <= 0");
+        }
+        capacity_ = capacity;
+        evict_();
+    }
+
+    /** @brief Get the maximum size of the cache */
+    size_t capacity() const override { return capacity_; }
+
+    /** @brief Get the current number of elements in the cache */
+    size_t size() const override { return lookup_.size(); }
+
+    /** @brief Get the current size of the stored elements */
+    size_t usage() const { return in_.used + main_.used; }
+
+    /** @brief Get the number of elements which have been used only once */
+    size_t probationSize() const { return in_.items.size(); }
+
+    /** @brief Get the number of elements which have been reused */
+    size_t protectedSize() const { return main_.items.size(); }
+
+    /** @copydoc Cache::evictions() */
+    size_t evictions() const override { return evictions_; }
+    /**@}*/
+
+    /**@{*/
+    /** @brief Get an item from the cache by key */
+    TValue get(const TKey& k) override
+    {
+        auto lookupIter = lookup_.find(k);
+        if (lookupIter == std::end(lookup_)) {
+            throw std::invalid_argument("Key not in cache");
+        }
+        // Move to the front of Am
+        auto& node = lookupIter->second;
+        main_.items.splice(
+            std::begin(main_.items), node.queue->items, node.iter);
+        if (node.queue != &main_) {
+            node.queue->used -= node.iter->size;
+            main_.used += node.iter->size;
+            node.queue = &main_;
+        }
+        return node.iter->value;
+    }
+
+    /** @brief Put an item into the cache */
+    void put(const TKey& k, const TValue& v) override
+    {
+        // Replace an existing element in its current queue
+        auto* queue = &in_;
+        auto lookupIter = lookup_.find(k);
+        if (lookupIter != std::end(lookup_)) {
+            queue = lookupIter->second.queue;
+            queue->erase(lookupIter->second.iter);
+            lookup_.erase(lookupIter);
+        }
+
+        // Reused elements are promoted
+        auto ghostIter = ghostLookup_.find(k);
+        if (ghostIter != std::end(ghostLookup_)) {
+            queue = &main_;
+            ghostUsed_ -= ghostIter->second->size;
+            ghost_.erase(ghostIter->second);
+            ghostLookup_.erase(ghostIter);
+        }
+
+        auto size = TSizeOf()(v);
+        if (size > capacity_) {
+            return;
+        }
+
+        queue->items.push_front({k, v, size});
+        queue->used += size;
+        lookup_[k] = {queue, std::begin(queue->items)};
+        evict_();
+    }
+
+    /** @brief Check if an item is already in the cache */
+    bool contains(const TKey& k) override
+    {
+        return lookup_.find(k) != std::end(lookup_);
+    }
+
+    /** @brief Clear the cache */
+    void purge() override
+    {
+        lookup_.clear();
+        in_.clear();
+        main_.clear();
+        ghostLookup_.clear();
+        ghost_.clear();
+        ghostUsed_ = 0;
+    }
+    /**@}*/
+
+private:
+    /** Queue of stored elements, most recent first */
+    struct Queue {
+        /** Elements */
+        std::list<Entry> items;
+        /** Total size of the elements */
+        size_t used{0};
+
+        /** Remove an element */
+        void erase(TListIterator it)
+        {
+            used -= it->size;
+            items.erase(it);
+        }
+
+        /** Remove every element */
+        void clear()
+        {
+            items.clear();
+            used = 0;
+        }
+    };
+
+    /** Location of a stored element */
+    struct Node {
+        /** Queue which holds the element */
+        Queue* queue;
+        /** Element in the queue */
+        TListIterator iter;
+    };
+
+    /** Key of an element evicted from A1in, most recent first */
+    struct Ghost {
+        /** Key */
+        TKey key;
+        /** Size of the evicted value */
+        size_t size;
+    };
+
+    /** Ghost list iterator */
+    using TGhostIterator = typename std::list<Ghost>::iterator;
+
+    /** A1in: Elements which have been used once */
+    Queue in_;
+    /** Am: Elements which have been reused */
+    Queue main_;
+    /** Stored elements */
+    std::unordered_map<TKey, Node> lookup_;
+    /** A1out: Keys of elements recently evicted from A1in */
+    std::list<Ghost> ghost_;
+    /** Total size of the values of the ghost keys */
+    size_t ghostUsed_{0};
+    /** Ghost keys */
+    std::unordered_map<TKey, TGhostIterator> ghostLookup_;
+    /** Number of evicted elements */
+    size_t evictions_{0};
+
+    /** Maximum size of A1in before it is evicted in favor of Am */
+    size_t in_capacity_() const { return std::max<size_t>(capacity_ / 4, 1); }
+
+    /** Maximum size of the values remembered by A1out */
+    size_t ghost_capacity_() const { return capacity_ / 2; }
+
+    /** Evict elements until within capacity */
+    void evict_()
+    {
+        while (usage() > capacity_) {
+            if (in_.used > in_capacity_() or main_.items.empty()) {
+                // Remember the key of the oldest single-use element
+                auto& last = in_.items.back();
+                ghost_.push_front({last.key, last.size});
+                ghostUsed_ += last.size;
+                ghostLookup_[last.key] = std::begin(ghost_);
+                lookup_.erase(last.key);
+                in_.erase(std::prev(std::end(in_.items)));
+            } else {
+                lookup_.erase(main_.items.back().key);
+                main_.erase(std::prev(std::end(main_.items)));
+            }
+            evictions_++;
+        }
+
+        while (ghostUsed_ > ghost_capacity_()) {
+            auto& last = ghost_.back();
+            ghostUsed_ -= last.size;
+            ghostLookup_.erase(last.key);
+            ghost_.pop_back();
+        }
+    }
+};
+}  // namespace volcart
@@ -4,6 +4,7 @@
 
 #include <map>
 #include <memory>
+#include <vector>
 
 #include <opencv2/core.hpp>
 #include <opencv2/imgproc.hpp>
@@ -45,6 +46,12 @@ const static cv::Vec2d NULL_MAPPING{-1, -1};
  * a way to store the dimensions and aspect ratio of the texture space for
  * later PerPixelMap and Texture generation.
  *
+ * Mappings are stored contiguously and indexed by vertex ID, so copies and
+ * the transform functions (Rotate(), Flip()) are linear passes over memory.
+ * The transforms run in place and in parallel on the global ThreadPool.
+ * Since storage grows to the largest inserted ID, UV maps are intended for
+ * densely numbered vertices.
+ *
  * @ingroup Types
  */
 class UVMap
@@ -130,6 +137,21 @@ public:
 
     /** Access to underlying data. For serialization only. */
     [[nodiscard]] auto as_map() const -> std::map<size_t, cv::Vec2d>;
+
+    /**
+     * @brief Access to the underlying storage. For serialization only.
+     *
+     * Indexed by vertex ID. Values are relative to the top-left origin. IDs
+     * without a mapping hold NULL_MAPPING.
+     */
+    [[nodiscard]] auto as_vector() const -> const std::vector<cv::Vec2d>&;
+
+    /**
+     * @brief Replace the underlying storage. For serialization only.
+     *
+     * @copydetails as_vector()
+     */
+    void from_vector(std::vector<cv::Vec2d> uvs);
     /**@}*/
 
     /**@{*/
@@ -205,8 +227,10 @@ public:
     /**@}*/
 
 private:
-    /** UV storage */
-    std::map<size_t, cv::Vec2d> map_;
+    /** UV storage, indexed by vertex ID */
+    std::vector<cv::Vec2d> uvs_;
+    /** Number of mapped IDs */
+    std::size_t size_{0};
     /** Origin for set and get functions */
     Origin origin_{Origin::TopLeft};
     /** Aspect ratio */
@@ -0,0 +1,95 @@
+#pragma once
+
+/** @file */
+
+#include <array>
+#include <cstddef>
+
+#include <opencv2/core.hpp>
+
+#include "vc/core/types/ITKMesh.hpp"
+#include "vc/core/types/UVMap.hpp"
+
+namespace volcart
+{
+/**
+ * @class UVMeshView
+ * @brief Read-only view of a mesh in UV space
+ *
+ * Pairs the faces of a mesh with the UV coordinates of its vertices without
+ * building a new mesh. Faces are read from the source ITKMesh and vertex
+ * positions are read from the UVMap when requested, so a view costs two
+ * shared pointers regardless of the size of the mesh. Positions use the
+ * same layout as meshing::UVMapToITKMesh: the U coordinate is on the X-axis
+ * and the V coordinate is on the Z-axis.
+ *
+ * The view does not copy its inputs. Changes to the mesh faces or the UVMap
+ * are visible through the view.
+ *
+ * @ingroup Types
+ */
+class UVMeshView
+{
+public:
+    /** Face type */
+    using Face = std::array<std::size_t, 3>;
+
+    /** @brief Default constructor */
+    UVMeshView() = default;
+
+    /**
+     * @brief Construct a view of a mesh and its UVMap
+     *
+     * @param scaleToUVDimensions If `true`, scale the positions by the
+     * width and height stored in the UVMap
+     */
+    UVMeshView(
+        ITKMesh::Pointer mesh,
+        UVMap::Pointer uvMap,
+        bool scaleToUVDimensions = false);
+
+    /** @brief Whether the view has a mesh and a UVMap */
+    [[nodiscard]] auto valid() const -> bool;
+
+    /** @brief Get the number of vertices */
+    [[nodiscard]] auto numVertices() const -> std::size_t;
+
+    /** @brief Get the number of faces */
+    [[nodiscard]] auto numFaces() const -> std::size_t;
+
+    /** @brief Get the (optionally scaled) UV coordinate of a vertex */
+    [[nodiscard]] auto uv(std::size_t id) const -> cv::Vec2d;
+
+    /** @brief Get the position of a vertex in the UV plane */
+    [[nodiscard]] auto vertex(std::size_t id) const -> cv::Vec3d;
+
+    /** @brief Get the vertex normal. The same for every vertex. */
+    [[nodiscard]] static auto normal() -> cv::Vec3d;
+
+    /** @brief Get the vertex indices of a triangular face */
+    [[nodiscard]] auto face(std::size_t id) const -> Face;
+
+    /** @brief Get the source mesh */
+    [[nodiscard]] auto mesh() const -> ITKMesh::Pointer;
+
+    /** @brief Get the UVMap */
+    [[nodiscard]] auto uvMap() const -> UVMap::Pointer;
+
+    /**
+     * @brief Build an ITKMesh of the view
+     *
+     * The returned mesh shares its cells container with the source mesh, so
+     * only the vertex positions and normals are allocated. Do not modify the
+     * cells of the returned mesh.
+     */
+    [[nodiscard]] auto toITKMesh() const -> ITKMesh::Pointer;
+
+private:
+    /** Source mesh */
+    ITKMesh::Pointer mesh_;
+    /** UV map */
+    UVMap::Pointer uvMap_;
+    /** Scale applied to UV coordinates */
+    cv::Vec2d scale_{1, 1};
+};
+}  // namespace volcart
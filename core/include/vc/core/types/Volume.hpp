@@ -2,14 +2,35 @@
 
 /** @file */
 
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <map>
+#include <memory>
 #include <mutex>
+#include <optional>
 
 #include "vc/core/filesystem.hpp"
+#include "vc/core/io/AsyncReader.hpp"
+#include "vc/core/io/TIFFIO.hpp"
+#include "vc/core/io/VolumeSource.hpp"
+#include "vc/core/io/ZarrArray.hpp"
 #include "vc/core/types/BoundingBox.hpp"
+#include "vc/core/types/ByteLRUCache.hpp"
 #include "vc/core/types/Cache.hpp"
+#include "vc/core/types/CacheStats.hpp"
+#include "vc/core/types/DiskCache.hpp"
 #include "vc/core/types/DiskBasedObjectBaseClass.hpp"
 #include "vc/core/types/LRUCache.hpp"
 #include "vc/core/types/Reslice.hpp"
+#include "vc/core/types/ShardedCache.hpp"
+#include "vc/core/types/SharedCache.hpp"
+#include "vc/core/types/TwoQCache.hpp"
+#include "vc/core/types/SliceView.hpp"
+#include "vc/core/types/VolumeBlockStatistics.hpp"
+#include "vc/core/types/VolumeStatistics.hpp"
+#include "vc/core/util/MemoryUsage.hpp"
 
 namespace volcart
 {
@@ -20,7 +41,34 @@ namespace volcart
  * @brief Volumetric image data
  *
  * Provides access to a volumetric dataset, such as a CT scan. By default,
- * slices are cached in memory using volcart::LRUCache.
+ * slices are cached in memory using a volcart::ShardedCache of
+ * volcart::LRUCache shards, which is safe to access from many threads. Use
+ * setCachePolicy() to switch to scan-resistant volcart::TwoQCache shards.
+ *
+ * Volumes can be stored on disk in one of two formats. Format::Slices stores
+ * one 2D TIFF image per Z-index. Format::Blocks stores the volume as a grid of
+ * fixed-size cubic blocks so that 3D access patterns only need to read the
+ * voxels in their immediate neighborhood. In the Blocks format, the cache is
+ * keyed by block rather than by slice index. Each block is stored as a
+ * single-channel 2D TIFF of size `blockSize` x `blockSize^2` in which the
+ * Z-planes of the block are stacked vertically.
+ *
+ * Format::Zarr reads a chunked Zarr or N5 array, such as an OME-Zarr scan,
+ * in place with io::ZarrArray, so that the array does not need to be
+ * converted to a TIFF stack. Its chunks are used as the blocks of the volume,
+ * and the multiscale arrays of the array's group are its resolution levels.
+ * Zarr volumes are read-only.
+ *
+ * Voxels are stored as 8-bit or 16-bit unsigned integers or as 32-bit floats
+ * (see VoxelType). Slices and blocks are cached in their stored type, so an
+ * 8-bit volume needs half the cache memory of a 16-bit volume. The sampling
+ * functions which return `uint16_t` scale 8-bit voxels to the 16-bit range,
+ * and the overloads which return `float` return voxels in their stored units.
+ *
+ * The slice and block files are read from the volume directory unless the
+ * volume has a io::VolumeSource, which lets a volume package reference image
+ * data stored elsewhere, such as on an HTTP server or in an object store. See
+ * setSource().
  *
  * @ingroup Types
  */
@@ -42,9 +90,86 @@ public:
     /** Default slice cache type */
     using DefaultCache = LRUCache<int, cv::Mat>;
 
+    /** Slice cache type with a capacity measured in bytes */
+    using ByteCache = ByteLRUCache<int, cv::Mat>;
+
+    /** Scan-resistant slice cache type */
+    using TwoQSliceCache = TwoQCache<int, cv::Mat>;
+
+    /** Scan-resistant slice cache type with a capacity measured in bytes */
+    using TwoQByteCache = TwoQCache<int, cv::Mat, CacheValueBytes<cv::Mat>>;
+
+    /**
+     * Thread-safe slice cache type
+     *
+     * When the slice cache is a ConcurrentCache, cache lookups only lock the
+     * shard which holds the requested slice, and slices are read from disk
+     * without holding any lock. This is the default.
+     */
+    using ConcurrentCache = ShardedCache<int, cv::Mat>;
+
+    /**
+     * Slice cache type which is shared by several volumes
+     *
+     * Use NewSharedCache() to construct a SharedSliceCache with a capacity
+     * measured in bytes and setCache(SharedSliceCache::Pointer) to attach it
+     * to a volume. Every volume attached to the same cache draws on a single
+     * memory budget, so that slices and blocks of frequently used volumes
+     * are not evicted to make room for those of rarely used ones.
+     */
+    using SharedSliceCache = SharedCache<int, cv::Mat>;
+
+    /** A volume's view of a SharedSliceCache */
+    using SharedSliceCacheView = SharedCacheView<int, cv::Mat>;
+
+    /** Shard type of the caches constructed by NewSharedCache() */
+    using SharedByteCache = ByteLRUCache<SharedCacheKey<int>, cv::Mat>;
+
+    /** Shard type of the 2Q caches constructed by NewSharedCache() */
+    using SharedTwoQByteCache =
+        TwoQCache<SharedCacheKey<int>, cv::Mat, CacheValueBytes<cv::Mat>>;
+
+    /** Replacement policies of the slice caches constructed by Volume */
+    enum class CachePolicy {
+        /** Least recently used (LRUCache, ByteLRUCache) */
+        LRU,
+        /**
+         * Scan-resistant 2Q (TwoQCache). Slices which are only read once,
+         * such as those of a sequential pass over the volume, do not evict
+         * slices which are used repeatedly.
+         */
+        TwoQ
+    };
+
     /** Default slice cache capacity */
     static constexpr size_t DEFAULT_CAPACITY = 200;
 
+    /** On-disk storage formats */
+    enum class Format {
+        /** One image file per slice */
+        Slices,
+        /** One image file per cubic block */
+        Blocks,
+        /** Chunked Zarr or N5 array. Read-only. */
+        Zarr
+    };
+
+    /** Voxel sample types */
+    enum class VoxelType {
+        /** 8-bit unsigned integer */
+        UInt8,
+        /** 16-bit unsigned integer */
+        UInt16,
+        /** 32-bit floating point */
+        Float32
+    };
+
+    /** Default block edge length for Format::Blocks */
+    static constexpr int DEFAULT_BLOCK_SIZE = 64;
+
+    /** Default memory limit for slices queued by asynchronous writes */
+    static constexpr size_t DEFAULT_ASYNC_WRITE_BYTES = size_t{512} << 20;
+
     /**@{*/
     /** Default constructor. Cannot be constructed without path. */
     Volume() = delete;
@@ -76,6 +201,29 @@ public:
     double min() const;
     /** @brief Get the maximum intensity value in the Volume */
     double max() const;
+    /** @brief Get the on-disk storage format */
+    Format format() const;
+    /** @brief Get the block edge length. Only used by Format::Blocks. */
+    int blockSize() const;
+    /**
+     * @brief Get the block dimensions as (x, y, z)
+     *
+     * Equal to the chunk dimensions for Format::Zarr.
+     */
+    cv::Vec3i blockShape() const;
+    /**
+     * @brief Get the compression scheme of newly written slices and blocks
+     *
+     * Defaults to LZW. See setCompression().
+     */
+    tiffio::Compression compression() const;
+    /**
+     * @brief Get the type of the voxel samples
+     *
+     * Defaults to VoxelType::UInt16. Format::Zarr volumes are always
+     * VoxelType::UInt16. See setVoxelType().
+     */
+    VoxelType voxelType() const;
     /**@}*/
 
     /**@{*/
@@ -91,6 +239,125 @@ public:
     void setMin(double m);
     /** @brief Set the maximum value in the Volume */
     void setMax(double m);
+    /**
+     * @brief Set the on-disk storage format
+     *
+     * Should be set before any slice data is written to the Volume. Changing
+     * the format of a Volume which already contains data does not convert the
+     * existing data.
+     */
+    void setFormat(Format f, int blockSize = DEFAULT_BLOCK_SIZE);
+    /**
+     * @brief Set the compression scheme of newly written slices and blocks
+     *
+     * Used by setSliceData() and generateLevels() when compression is
+     * requested. ZSTD slices decode several times faster than LZW slices of
+     * a similar size, which makes cache misses on local disks much cheaper,
+     * but they cannot be read by libtiff builds without zstd support.
+     * Existing files are not converted, and files with any scheme can be
+     * read regardless of this setting.
+     *
+     * @throws std::invalid_argument If libtiff does not support `c`
+     */
+    void setCompression(tiffio::Compression c);
+    /**
+     * @brief Set the type of the voxel samples
+     *
+     * Should be set before any slice data is written to the Volume, and
+     * written slices should have the matching depth (`CV_8U`, `CV_16U` or
+     * `CV_32F`). Slices and blocks of a different depth are converted when
+     * they are loaded: 8-bit and 16-bit samples are scaled to each other's
+     * range, and other conversions keep the sample values.
+     *
+     * @throws std::invalid_argument If the volume is a Format::Zarr volume
+     * and `t` is not VoxelType::UInt16
+     */
+    void setVoxelType(VoxelType t);
+    /**@}*/
+
+    /**@{*/
+    /** @brief Return whether intensity statistics are stored in the metadata */
+    bool hasStatistics() const;
+
+    /**
+     * @brief Get the intensity statistics stored in the metadata
+     *
+     * Statistics are gathered by `vc_packager` when the volume is imported.
+     *
+     * @throws std::runtime_error if no statistics are stored
+     */
+    VolumeStatistics statistics() const;
+
+    /**
+     * @brief Store intensity statistics in the metadata
+     *
+     * Call saveMetadata() to write the statistics to disk.
+     */
+    void setStatistics(const VolumeStatistics& s);
+
+    /**
+     * @brief Return whether per-block intensity statistics are stored with
+     * the volume
+     */
+    bool hasBlockStatistics() const;
+
+    /**
+     * @brief Get the per-block intensity statistics stored with the volume
+     *
+     * Block statistics are gathered by `vc_packager` when the volume is
+     * imported and are stored in `block_statistics.bin` in the volume
+     * directory. The file is read on first use. Returns nullptr if the
+     * volume has no block statistics, or if they do not match the volume
+     * dimensions.
+     *
+     * If the statistics use the same block size as a Format::Blocks volume,
+     * blocks of a single intensity are filled with that intensity rather
+     * than read from disk.
+     */
+    std::shared_ptr<const VolumeBlockStatistics> blockStatistics() const;
+
+    /**
+     * @brief Store per-block intensity statistics with the volume
+     *
+     * Unlike the other metadata properties, the statistics are written to
+     * disk immediately. Writing a slice with setSliceData() removes the
+     * stored statistics, since they may no longer be valid.
+     *
+     * @throws std::invalid_argument if the statistics do not match the
+     * volume dimensions
+     * @throws IOException if the statistics file cannot be written
+     */
+    void setBlockStatistics(const VolumeBlockStatistics& s);
+    /**@}*/
+
+    /**@{*/
+    /**
+     * @brief Return whether the Volume was cropped from another Volume
+     *
+     * See VolumePkg::newVolumeFromRegion().
+     */
+    bool hasCropOrigin() const;
+
+    /** @brief Get the ID of the Volume this Volume was cropped from */
+    Identifier cropSourceID() const;
+
+    /**
+     * @brief Get the position of this Volume's first voxel in the Volume it
+     * was cropped from
+     *
+     * Add the offset to a position in this Volume to get the position in the
+     * source Volume.
+     *
+     * @throws std::runtime_error if the Volume is not a crop
+     */
+    cv::Vec3i cropOffset() const;
+
+    /**
+     * @brief Record the Volume this Volume was cropped from
+     *
+     * Call saveMetadata() to write the crop origin to disk.
+     */
+    void setCropOrigin(const Identifier& sourceID, const cv::Vec3i& offset);
     /**@}*/
 
     /**@{*/
@@ -108,19 +375,66 @@ public:
      *
      * @warning Because cv::Mat is essentially a pointer to a matrix, modifying
      * the slice returned by getSliceData() will modify the cached slice as
-     * well. Use getSliceDataCopy() if the slice is to be modified.
+     * well. Use getSliceView() if the slice is only read, and
+     * getSliceDataCopy() if the slice is to be modified.
      */
     cv::Mat getSliceData(int index) const;
 
     /** @copydoc getSliceData(int) const */
     cv::Mat getSliceDataCopy(int index) const;
 
+    /**
+     * @brief Get a read-only view of a slice
+     *
+     * Like getSliceData(), the slice is not copied. The view only gives
+     * const access to the slice, and keeps it valid if it is evicted from
+     * the slice cache.
+     */
+    SliceView getSliceView(int index) const;
+
+    /**
+     * @brief Get a rectangular region of a slice
+     *
+     * `roi` is clipped to the slice bounds. If the slice is already cached,
+     * the region is copied from the cached slice. Otherwise, only the TIFF
+     * strips or tiles which intersect the region are decoded, and the result
+     * is not added to the slice cache. In the Blocks format, only the blocks
+     * which intersect the region are loaded.
+     *
+     * Unlike getSliceData(), the returned image never shares memory with the
+     * cache.
+     *
+     * @throws std::out_of_range If the slice index is outside of the volume
+     */
+    cv::Mat getSliceRegion(int index, const cv::Rect& roi) const;
+
+    /**
+     * @brief Set the number of threads used to decode a slice image
+     *
+     * Slice TIFFs which are split into multiple strips or tiles are decoded
+     * in parallel. If `n` is 0, the number of hardware threads is used.
+     * Default: 1
+     */
+    void setSliceDecodeThreads(size_t n) { decodeThreads_ = n; }
+
+    /** @brief Get the number of threads used to decode a slice image */
+    size_t sliceDecodeThreads() const { return decodeThreads_; }
+
     /**
      * @brief Set a slice by index number
      *
      * Index must be less than the number of slices in the volume.
      *
+     * In the Blocks format, slices are buffered in memory until every slice
+     * intersecting a layer of blocks has been set, at which point the whole
+     * layer is written to disk. Slices can be set in any order.
+     *
+     * If asynchronous writes are enabled, the slice is copied and written on
+     * a background thread. See setAsyncWrites().
+     *
      * @warning This will overwrite any existing slice data on disk.
+     *
+     * @throws std::logic_error If the volume has a VolumeSource
      */
     void setSliceData(int index, const cv::Mat& slice, bool compress = true);
 
@@ -129,7 +443,38 @@ public:
     /**@}*/
 
     /**@{*/
-    /** @brief Get the intensity value at a voxel position */
+    /**
+     * @brief Get a block by its position in the block grid
+     *
+     * Only valid for Format::Blocks and Format::Zarr. With a blockShape() of
+     * (w, h, d), the returned image has `w` columns and `h * d` rows: the
+     * voxel (x, y, z) of the block is stored at row `z * h + y`, column `x`.
+     * Blocks on the edge of the Volume are zero-padded to the full block size,
+     * as are blocks which have no file on disk. Missing Zarr chunks are filled
+     * with the array's fill value.
+     *
+     * @warning Like getSliceData(), the returned image shares memory with
+     * the cached block.
+     *
+     * @throws std::logic_error If the Volume is not stored in blocks
+     * @throws std::out_of_range If the block position is outside of the grid
+     */
+    cv::Mat getBlockData(int bx, int by, int bz) const;
+
+    /** @brief Get the file path of a block by its position in the grid */
+    volcart::filesystem::path getBlockPath(int bx, int by, int bz) const;
+
+    /** @brief Get the number of blocks along each axis of the Volume */
+    cv::Vec3i blockGridSize() const;
+    /**@}*/
+
+    /**@{*/
+    /**
+     * @brief Get the intensity value at a voxel position
+     *
+     * 8-bit voxels are scaled to the 16-bit range, and float voxels are
+     * rounded and clamped to it.
+     */
     uint16_t intensityAt(int x, int y, int z) const;
 
     /** @copydoc intensityAt() */
@@ -138,6 +483,23 @@ public:
         return intensityAt(int(v[0]), int(v[1]), int(v[2]));
     }
 
+    /** Interpolation kernels for subvoxel positions */
+    enum class Interpolation {
+        /**
+         * Value of the nearest voxel. Several times faster than Trilinear,
+         * and suitable for previews and for extracting training patches.
+         */
+        Nearest,
+        /** Trilinear interpolation of the 2x2x2 surrounding voxels */
+        Trilinear,
+        /**
+         * Catmull-Rom interpolation of the 4x4x4 surrounding voxels.
+         * Sharper than Trilinear, but about 8 times as expensive. Voxels
+         * past the edge of the volume repeat the edge voxels.
+         */
+        Tricubic
+    };
+
     /**
      * @brief Get the intensity value at a subvoxel position
      *
@@ -154,6 +516,100 @@ public:
         return interpolateAt(v[0], v[1], v[2]);
     }
 
+    /**
+     * @brief Get the intensity value at a subvoxel position with an
+     * interpolation kernel
+     *
+     * Positions outside of the volume are 0. With Interpolation::Nearest,
+     * these are the positions whose nearest voxel is outside of the volume.
+     */
+    uint16_t interpolateAt(const cv::Vec3d& v, Interpolation method) const;
+
+    /**
+     * @brief Get the interpolated intensity values at many subvoxel positions
+     *
+     * Produces the same values as calling interpolateAt(const cv::Vec3d&) for
+     * each position, but with much lower per-sample overhead: samples are
+     * grouped by the pair of slices they fall between, each slice pair is
+     * fetched from the cache once, and the interpolation kernel reads directly
+     * from the slice images.
+     *
+     * @param pts Array of `n` subvoxel positions
+     * @param n Number of positions
+     * @param out Output array with space for `n` values
+     */
+    void interpolateAt(const cv::Vec3d* pts, size_t n, uint16_t* out) const;
+
+    /** @copydoc interpolateAt(const cv::Vec3d*, size_t, uint16_t*) const */
+    std::vector<uint16_t> interpolateAt(const std::vector<cv::Vec3d>& pts) const
+    {
+        std::vector<uint16_t> out(pts.size());
+        interpolateAt(pts.data(), pts.size(), out.data());
+        return out;
+    }
+
+    /**
+     * @brief Get the intensity values at many subvoxel positions with an
+     * interpolation kernel
+     *
+     * Produces the same values as calling
+     * interpolateAt(const cv::Vec3d&, Interpolation) const for each position.
+     * The kernel is selected once per call, so the per-sample cost is that
+     * of the kernel alone.
+     */
+    void interpolateAt(
+        const cv::Vec3d* pts,
+        size_t n,
+        uint16_t* out,
+        Interpolation method) const;
+
+    /**
+     * @copydoc interpolateAt(const cv::Vec3d*, size_t, uint16_t*,
+     * Interpolation) const
+     */
+    std::vector<uint16_t> interpolateAt(
+        const std::vector<cv::Vec3d>& pts, Interpolation method) const
+    {
+        std::vector<uint16_t> out(pts.size());
+        interpolateAt(pts.data(), pts.size(), out.data(), method);
+        return out;
+    }
+
+    /**
+     * @brief Get the intensity values at many subvoxel positions in the
+     * units of the stored voxels
+     *
+     * Like interpolateAt(const cv::Vec3d*, size_t, uint16_t*, Interpolation)
+     * const, but 8-bit voxels are not scaled and float voxels are neither
+     * rounded nor clamped.
+     */
+    void interpolateAt(
+        const cv::Vec3d* pts,
+        size_t n,
+        float* out,
+        Interpolation method = Interpolation::Trilinear) const;
+
+    /**
+     * @brief Copy the voxels which lie on an integer lattice
+     *
+     * For every index `(k, j, i)` in `extent`, copies the voxel at
+     * `origin + k * steps[0] + j * steps[1] + i * steps[2]` to
+     * `out[(k * extent[1] + j) * extent[2] + i]`. Positions outside of the
+     * volume are 0. This is equivalent to calling interpolateAt() at the same
+     * positions, but performs no interpolation. Rows with a unit step along
+     * the slice's X-axis are copied directly from the cached slices.
+     *
+     * @param origin Position of the first voxel (x, y, z)
+     * @param steps Offset between neighboring voxels along each output axis
+     * @param extent Number of voxels along each output axis
+     * @param out Output array with space for the product of `extent` values
+     */
+    void copyLattice(
+        const cv::Vec3i& origin,
+        const std::array<cv::Vec3i, 3>& steps,
+        const std::array<size_t, 3>& extent,
+        uint16_t* out) const;
+
     /**
      * @brief Create a Reslice image by intersecting the volume with a plane
      *
@@ -173,14 +629,257 @@ public:
         const cv::Vec3d& yvec,
         int width = 64,
         int height = 64) const;
+
+    /** @brief Plane of a batch reslice. See reslice(). */
+    struct ResliceFrame {
+        /** Center of the Reslice image */
+        cv::Vec3d center;
+        /** X-axis of the Reslice plane */
+        cv::Vec3d xvec;
+        /** Y-axis of the Reslice plane */
+        cv::Vec3d yvec;
+    };
+
+    /**
+     * @brief Intersect the volume with many planes at once
+     *
+     * Produces the same images as calling reslice() for each frame, but the
+     * sample positions of all frames are interpolated together, so a slice
+     * which is intersected by many nearby planes is fetched from the cache
+     * once per batch rather than once per plane.
+     *
+     * @param frames Array of `n` planes
+     * @param n Number of planes
+     * @param width Width of each Reslice image
+     * @param height Height of each Reslice image
+     * @param out Output array with space for `n * height * width` values.
+     * Image `i` starts at `out + i * height * width` and is stored in
+     * row-major order.
+     */
+    void reslice(
+        const ResliceFrame* frames,
+        size_t n,
+        int width,
+        int height,
+        uint16_t* out) const;
+
+    /**
+     * @copybrief reslice(const ResliceFrame*, size_t, int, int, uint16_t*)
+     * const
+     *
+     * The images of the returned Reslices are views of a single buffer.
+     */
+    std::vector<Reslice> reslice(
+        const std::vector<ResliceFrame>& frames,
+        int width = 64,
+        int height = 64) const;
+    /**@}*/
+
+    /**@{*/
+    /** Downsampling filters for pyramid levels */
+    enum class LevelFilter {
+        /** Each voxel is the mean of its 2x2x2 source voxels */
+        Mean,
+        /** Each voxel is the maximum of its 2x2x2 source voxels */
+        Max
+    };
+
+    /**
+     * @brief Get the number of resolution levels, including full resolution
+     *
+     * Level 0 is the full-resolution Volume. Each subsequent level is
+     * downsampled by a factor of 2 along every axis from the previous level.
+     */
+    size_t numLevels() const;
+
+    /**
+     * @brief Get a resolution level of the Volume
+     *
+     * Levels are stored as separate Volumes inside of this Volume's directory
+     * and are loaded on first access. The levels of a Format::Zarr Volume are
+     * the arrays of its multiscale group. Voxel positions in level `n` are
+     * scaled by `1 / levelScale(n)` relative to full resolution. `level(0)`
+     * returns this Volume.
+     *
+     * @throws std::out_of_range If `n >= numLevels()`
+     */
+    Pointer level(size_t n);
+
+    /** @brief Get the downsampling factor of a resolution level */
+    static double levelScale(size_t n);
+
+    /**
+     * @brief Select the coarsest level which still samples the Volume at
+     * least as finely as the given interval
+     *
+     * @param interval Sampling interval in full-resolution voxels, e.g. the
+     * number of voxels covered by one screen pixel
+     */
+    size_t levelForSamplingInterval(double interval) const;
+
+    /**
+     * @brief Generate downsampled resolution levels for this Volume
+     *
+     * Replaces any existing levels. Level `n` is computed from level `n - 1`.
+     *
+     * @throws std::logic_error If the Volume is in Format::Zarr, which uses
+     * the levels of its multiscale group
+     *
+     * @param numLevels Number of downsampled levels to generate
+     * @param filter Downsampling filter
+     * @param compress Whether to compress the level slice images with
+     * compression()
+     */
+    void generateLevels(
+        size_t numLevels,
+        LevelFilter filter = LevelFilter::Mean,
+        bool compress = true);
+
+    /** @brief Get the directory path of a resolution level */
+    volcart::filesystem::path getLevelPath(size_t n) const;
     /**@}*/
 
     /**@{*/
     /** @brief Enable slice caching */
     void setCacheSlices(bool b) { cacheSlices_ = b; }
 
-    /** @brief Set the slice cache */
-    void setCache(SliceCache::Pointer c) { cache_ = std::move(c); }
+    /**
+     * @brief Set the slice cache
+     *
+     * Caches other than ConcurrentCache and SharedSliceCacheView are guarded
+     * by a single mutex.
+     *
+     * The cache is counted as MemoryCategory::SliceCache by volcart::memory.
+     * If the memory soft limit is exceeded, the cache capacity is reduced
+     * until the tracked total is below the limit.
+     */
+    void setCache(SliceCache::Pointer c);
+
+    /**
+     * @brief Use a cache which is shared with other volumes
+     *
+     * Attaches this volume to `c` through a new SharedSliceCacheView.
+     * Afterwards, the cache capacity and size functions refer to the shared
+     * cache. In particular, setCacheMemoryInBytes() resizes the shared cache
+     * for every attached volume.
+     */
+    void setCache(const SharedSliceCache::Pointer& c);
+
+    /**
+     * @brief Construct a SharedSliceCache with a capacity in bytes
+     *
+     * Every slice or block in the returned cache is charged for its actual
+     * size. The shards use the replacement policy `policy`.
+     */
+    static SharedSliceCache::Pointer NewSharedCache(
+        size_t nbytes,
+        size_t numShards = SharedSliceCache::DEFAULT_SHARDS,
+        CachePolicy policy = CachePolicy::LRU);
+
+    /**
+     * @brief Set the replacement policy of the slice cache
+     *
+     * Replaces the slice cache with a ConcurrentCache of the same capacity
+     * whose shards use the new policy. If the capacity is measured in bytes,
+     * it still is afterwards. The cached slices are discarded. Later calls to
+     * setCacheMemoryInBytes() construct caches with the same policy.
+     *
+     * A cache which is shared with other volumes keeps the policy it was
+     * constructed with. Pass the policy to NewSharedCache() instead.
+     */
+    void setCachePolicy(CachePolicy policy);
+
+    /** @brief Get the replacement policy of the slice cache */
+    CachePolicy getCachePolicy() const { return cachePolicy_; }
+
+    /** Default number of slices in each Z slab assigned to a NUMA node */
+    static constexpr int DEFAULT_NUMA_SLAB = 64;
+
+    /**
+     * @brief Partition the slice cache between NUMA nodes
+     *
+     * Divides the volume into Z slabs of `slabSize` slices, which are
+     * assigned to the nodes in turn, and replaces the slice cache with a
+     * ConcurrentCache of the same capacity and policy whose shards are split
+     * evenly between the nodes. A node's slices and blocks are then only
+     * evicted to make room for slices and blocks of the same node. The cached
+     * slices are discarded.
+     *
+     * Threads which sample a slab should be bound to its node (see numaNode()
+     * and numa::ScopedBinding), so that the slices they load are allocated in
+     * the node's memory and read without crossing the socket interconnect.
+     * texturing::TexturingAlgorithm::setNUMABinding() does this for the
+     * texturing algorithms.
+     *
+     * A cache which is shared with other volumes is not partitioned.
+     *
+     * @param slabSize Number of slices in each slab. 0 disables partitioning.
+     * @param numNodes Number of nodes. If 0, uses numa::NumNodes().
+     *
+     * @throws std::invalid_argument If `slabSize < 0`
+     */
+    void setNUMAPartitioning(
+        int slabSize = DEFAULT_NUMA_SLAB, size_t numNodes = 0);
+
+    /**
+     * @brief Get the number of NUMA nodes the slice cache is partitioned
+     * between
+     *
+     * 1 if the cache is not partitioned.
+     */
+    size_t numaPartitions() const { return numaNodes_; }
+
+    /**
+     * @brief Get the NUMA node assigned to a slice
+     *
+     * 0 if the cache is not partitioned.
+     */
+    size_t numaNode(int z) const;
+
+    /**
+     * @brief Set a persistent cache of decoded slices and blocks
+     *
+     * Adds a second cache tier below the slice cache. A slice or block which
+     * misses the slice cache is read from `c` if it holds an entry decoded
+     * from the current version of the slice or block file. Otherwise, the
+     * file is read and decoded as usual and the result is added to `c`. Use a
+     * DiskCache on a local disk to avoid repeated network reads and decoding
+     * of volumes on remote filesystems. Several volumes and processes may use
+     * the same DiskCache directory. With DiskCache::SharedMemory(), every
+     * process on the host shares a single decoded copy of each slice.
+     *
+     * Resolution levels returned by level() afterwards use the same cache.
+     * Pass nullptr to disable.
+     *
+     * @warning Setting the disk cache is not thread safe.
+     */
+    void setDiskCache(DiskCache::Pointer c);
+
+    /** @brief Get the persistent cache of decoded slices and blocks */
+    DiskCache::Pointer getDiskCache() const { return diskCache_; }
+
+    /**
+     * @brief Read the slice and block files from a VolumeSource
+     *
+     * Files are requested from `source` by their paths relative to the
+     * volume directory, such as `0042.tif` or `blocks/0_1_2.tif`, and are
+     * then cached and prefetched like local files. Since sources read whole
+     * files, region reads such as getSliceRegion() load and cache the whole
+     * slice. Volumes with a source are read-only.
+     *
+     * A volume whose metadata has a `source` key, such as
+     * `"source": "s3://bucket/volume"`, opens it with
+     * io::VolumeSource::Open() when it is loaded. Relative paths are
+     * resolved against the volume directory.
+     *
+     * Pass nullptr to read from the volume directory.
+     *
+     * @warning Setting the source is not thread safe.
+     */
+    void setSource(io::VolumeSource::Pointer source);
+
+    /** @brief Get the source of the slice and block files, if any */
+    io::VolumeSource::Pointer getSource() const { return source_; }
 
     /** @brief Set the maximum number of cached slices */
     void setCacheCapacity(size_t newCacheCapacity)
@@ -188,12 +887,24 @@ public:
         cache_->setCapacity(newCacheCapacity);
     }
 
-    /** @brief Set the maximum size of the cache in bytes */
-    void setCacheMemoryInBytes(size_t nbytes)
-    {
-        // x2 because pixels are 16 bits normally. Not a great solution.
-        setCacheCapacity(nbytes / (sliceWidth() * sliceHeight() * 2));
-    }
+    /**
+     * @brief Set the maximum size of the cache in bytes
+     *
+     * If the current cache is not a ByteCache (or a TwoQByteCache when the
+     * cache policy is CachePolicy::TwoQ), it is replaced by one so that every
+     * cached slice or block is charged for its actual size.
+     * Afterwards, getCacheCapacity() reports the capacity in bytes.
+     */
+    void setCacheMemoryInBytes(size_t nbytes);
+
+    /**
+     * @brief Get the current size of the cache in bytes
+     *
+     * Returns 0 if the current cache is not a ByteCache, a TwoQByteCache, or
+     * a ConcurrentCache of either. For a shared cache constructed by
+     * NewSharedCache(), returns the size of the shared cache.
+     */
+    size_t getCacheMemoryInBytes() const;
 
     /** @brief Get the maximum number of cached slices */
     size_t getCacheCapacity() const { return cache_->capacity(); }
@@ -203,8 +914,132 @@ public:
 
     /** @brief Purge the slice cache */
     void cachePurge() { cache_->purge(); }
+
+    /**
+     * @brief Get cache usage and I/O statistics
+     *
+     * Counts every slice or block lookup since the cache was set or the
+     * statistics were last reset. A lookup is a miss if it read the slice or
+     * block from disk. Lookups which wait on another thread's read are
+     * counted as hits. Reads performed by the prefetcher are counted as
+     * misses. The load latency and bytes read also include reads performed
+     * while caching is disabled.
+     *
+     * If the cache is shared with other volumes, the reported evictions are
+     * those of the shared cache.
+     */
+    CacheStats cacheStats() const;
+
+    /** @brief Reset the statistics reported by cacheStats() */
+    void resetCacheStats();
+    /**@}*/
+
+    /**@{*/
+    /**
+     * @brief Enable asynchronous slice prefetching
+     *
+     * When enabled, every call to getSliceData() which changes the current
+     * slice index schedules the neighboring slices to be loaded into the
+     * slice cache by a pool of background threads. The direction of travel is
+     * inferred from the last two distinct slice indices: `ahead` slices are
+     * prefetched in the direction of travel and `behind` slices in the
+     * opposite direction. Pending prefetches which fall outside of the new
+     * window are discarded.
+     *
+     * Prefetching only applies to Format::Slices volumes with slice caching
+     * enabled. It works best with a ConcurrentCache, which is the default.
+     * With an asynchronous reader (see setAsyncReader()), the prefetch
+     * threads only issue reads, and up to io::AsyncReader::queueDepth()
+     * slices are read at once.
+     *
+     * @warning Enabling or disabling prefetching is not thread safe.
+     *
+     * @param ahead Number of slices to prefetch in the direction of travel
+     * @param behind Number of slices to prefetch against the direction of
+     * travel
+     * @param threads Number of background I/O threads
+     */
+    void setPrefetching(size_t ahead, size_t behind = 0, size_t threads = 1);
+
+    /** @brief Disable asynchronous slice prefetching */
+    void disablePrefetching();
+
+    /** @brief Return whether asynchronous slice prefetching is enabled */
+    bool prefetchingEnabled() const { return prefetcher_ != nullptr; }
+    /**@}*/
+
+    /**@{*/
+    /**
+     * @brief Read slices and blocks with an asynchronous reader
+     *
+     * A thread which reads a slice with blocking calls has one read in
+     * flight, so blocking prefetch threads cannot keep a deep I/O queue full.
+     * With a reader, the prefetcher keeps many slice reads in flight and
+     * each slice is decoded on the reader's completion threads as soon as its
+     * file arrives. Blocked volumes also read every uncached block of a slice
+     * or region at once, rather than one block after another. Files are read
+     * through the volume's io::VolumeSource if it has one.
+     *
+     * The reader may be shared between volumes, and is used by the
+     * resolution levels returned by level(). Volumes with a disk cache read
+     * through it and do not use the reader. Pass nullptr to read with
+     * blocking calls.
+     *
+     * @warning Setting the reader is not thread safe. Slice reads must not
+     * be made from the reader's completion threads.
+     */
+    void setAsyncReader(io::AsyncReader::Pointer reader);
+
+    /** @brief Get the asynchronous reader, if any */
+    io::AsyncReader::Pointer asyncReader() const { return asyncReader_; }
+    /**@}*/
+
+    /**@{*/
+    /**
+     * @brief Enable asynchronous slice writes
+     *
+     * When enabled, setSliceData() copies the slice into a queue and returns
+     * immediately, while compression and disk writes happen on a pool of
+     * background threads. If the queued and in-progress slices would exceed
+     * `maxBytes`, setSliceData() blocks until enough writes have completed.
+     * A single slice larger than `maxBytes` is still accepted when nothing
+     * else is queued.
+     *
+     * An error raised by a background write is rethrown by the next call to
+     * setSliceData() or flushSliceWrites(). Reading a slice which has a
+     * pending write returns the data which was on disk before the write.
+     *
+     * @warning Enabling or disabling asynchronous writes is not thread safe.
+     *
+     * @param maxBytes Memory limit for queued slices
+     * @param threads Number of background write threads
+     */
+    void setAsyncWrites(
+        size_t maxBytes = DEFAULT_ASYNC_WRITE_BYTES, size_t threads = 1);
+
+    /**
+     * @brief Wait for every pending asynchronous write to complete
+     *
+     * Rethrows the first error raised by a background write since the last
+     * call. Does nothing if asynchronous writes are disabled.
+     */
+    void flushSliceWrites();
+
+    /**
+     * @brief Disable asynchronous slice writes
+     *
+     * Waits for pending writes and rethrows their first error, as
+     * flushSliceWrites() does.
+     */
+    void disableAsyncWrites();
+
+    /** @brief Return whether asynchronous slice writes are enabled */
+    bool asyncWritesEnabled() const { return writer_ != nullptr; }
     /**@}*/
 
+    /** Destructor */
+    ~Volume();
+
 protected:
     /** Slice width */
     int width_{0};
@@ -212,19 +1047,229 @@ protected:
     int height_{0};
     /** Number of slices */
     int slices_{0};
+    /** Voxel size (in microns), if set */
+    std::optional<double> voxelSize_;
+    /** Minimum intensity value, if set */
+    std::optional<double> min_;
+    /** Maximum intensity value, if set */
+    std::optional<double> max_;
+    /** Intensity statistics, if set */
+    std::optional<VolumeStatistics> statistics_;
+    /** Per-block statistics. Null if unavailable or not yet read. */
+    mutable std::shared_ptr<const VolumeBlockStatistics> blockStats_;
+    /** Whether the block statistics file has been read */
+    mutable bool blockStatsRead_{false};
+    /** Block statistics mutex */
+    mutable std::mutex blockStatsMutex_;
+    /** Get the block statistics, if they can fill blocks of this volume */
+    std::shared_ptr<const VolumeBlockStatistics> fill_statistics_() const;
+    /** Remove the stored block statistics */
+    void clear_block_statistics_();
+    /** ID of the Volume this Volume was cropped from, if any */
+    std::optional<Identifier> cropSource_;
+    /** Position of this Volume in the Volume it was cropped from, if any */
+    std::optional<cv::Vec3i> cropOffset_;
+    /** Number of resolution levels stored after level 0 */
+    size_t storedLevels_{0};
     /** Slice file name padding */
     int numSliceCharacters_{0};
+    /** On-disk storage format */
+    Format format_{Format::Slices};
+    /** Block edge length */
+    int blockSize_{DEFAULT_BLOCK_SIZE};
+    /** Block dimensions (x, y, z) */
+    cv::Vec3i blockShape_{
+        DEFAULT_BLOCK_SIZE, DEFAULT_BLOCK_SIZE, DEFAULT_BLOCK_SIZE};
+    /** Compression of written slices and blocks */
+    tiffio::Compression compression_{tiffio::Compression::LZW};
+    /** Type of the voxel samples */
+    VoxelType voxelType_{VoxelType::UInt16};
+    /** Convert a loaded slice or block to the voxel type */
+    cv::Mat conform_(cv::Mat m) const;
+    /** Chunked array read by Format::Zarr */
+    io::ZarrArray::Pointer zarr_;
+    /** Paths of the multiscale arrays of Format::Zarr, by level */
+    std::vector<std::string> zarrArrays_;
+    /** Whether the format stores the volume in blocks */
+    bool blocked_() const;
+    /** Read the array of a resolution level of Format::Zarr */
+    void open_zarr_(size_t n);
+    /** Construct a resolution level of Format::Zarr */
+    Pointer new_zarr_level_(size_t n) const;
 
     /** Whether to use slice cache */
     bool cacheSlices_{true};
+    /** Number of threads used to decode a slice image */
+    size_t decodeThreads_{1};
     /** Slice cache */
-    mutable SliceCache::Pointer cache_{DefaultCache::New(DEFAULT_CAPACITY)};
-    /** Cache mutex for thread-safe access */
+    mutable SliceCache::Pointer cache_;
+    /** Slice cache, if it is a ConcurrentCache */
+    ConcurrentCache* concurrentCache_{nullptr};
+    /** Slice cache, if it is a SharedSliceCacheView */
+    SharedSliceCacheView* sharedCache_{nullptr};
+    /** Cache mutex for thread-safe access to non-concurrent caches */
     mutable std::mutex cacheMutex_;
+    /** Replacement policy of the caches constructed by this volume */
+    CachePolicy cachePolicy_{CachePolicy::LRU};
+    /** Number of slices in each NUMA slab. 0 if not partitioned. */
+    int numaSlab_{0};
+    /** Number of NUMA partitions of the cache */
+    size_t numaNodes_{1};
+    /**
+     * Construct a ConcurrentCache with `shards` shards for each NUMA
+     * partition
+     */
+    SliceCache::Pointer new_concurrent_cache_(
+        size_t capacity,
+        size_t shards,
+        ConcurrentCache::ShardFactory factory) const;
+    /** Persistent cache of decoded slices and blocks */
+    DiskCache::Pointer diskCache_;
+    /** Prefix of this volume's keys in the disk cache */
+    std::string diskCacheKey_;
+    /**
+     * Read a slice or block through the disk cache. `load()` is called if
+     * there is no entry for the version of the file returned by `getStamp()`.
+     */
+    template <typename TStamp, typename TLoader>
+    cv::Mat disk_cached_load_(
+        const std::string& key, TStamp getStamp, TLoader load) const;
+    /** Source of the slice and block files, if not the volume directory */
+    io::VolumeSource::Pointer source_;
+    /** Read and decode a file from the source through the disk cache */
+    cv::Mat read_source_(const std::string& name, const std::string& key) const;
+    /** Reader of slice and block files. Null if reads are blocking. */
+    io::AsyncReader::Pointer asyncReader_;
+    /** Whether slices and blocks are read with asyncReader_ */
+    bool async_reads_() const;
+    /** Read a slice or block file by name with asyncReader_ */
+    void read_async_(
+        const std::string& name,
+        const filesystem::path& path,
+        io::AsyncReader::Callback done) const;
+    /** File name of a slice, relative to the volume directory */
+    std::string slice_name_(int index) const;
+    /** File name of a block, relative to the volume directory */
+    std::string block_name_(int bx, int by, int bz) const;
+    /** Reports the slice cache size to volcart::memory */
+    memory::Registration cacheMemory_;
+    /** Shrinks the slice cache when the memory soft limit is exceeded */
+    memory::Registration cacheShrink_;
+    /** Register the slice cache with volcart::memory */
+    void register_cache_memory_();
+    /** Size of the slice cache in bytes, estimated for non-byte caches */
+    std::size_t cache_bytes_() const;
+    /** Size of a cached slice or block in bytes */
+    std::size_t entry_bytes_() const;
+    /** Construct a ConcurrentCache of byte caches of the cache policy */
+    SliceCache::Pointer new_byte_cache_(size_t nbytes) const;
+    /** Shrink the slice cache by up to `excess` bytes */
+    void shrink_cache_(std::size_t excess);
+
+    /** Number of cache lookups */
+    mutable std::atomic<std::uint64_t> cacheLookups_{0};
+    /** Number of cache lookups which loaded from disk */
+    mutable std::atomic<std::uint64_t> cacheMisses_{0};
+    /** Number of bytes loaded from disk */
+    mutable std::atomic<std::uint64_t> bytesRead_{0};
+    /** Slice and block load latencies */
+    mutable LatencyHistogram loadLatency_;
+    /** Cache evictions at the time the statistics were reset */
+    std::atomic<std::size_t> evictionsBase_{0};
+    /** Get the number of evictions reported by the cache */
+    std::size_t cache_evictions_() const;
+    /** Record the latency and size of a slice or block read */
+    void record_load_(
+        std::chrono::steady_clock::time_point start, const cv::Mat& m) const;
 
     /** Load slice from disk */
     cv::Mat load_slice_(int index) const;
     /** Load slice from cache */
     cv::Mat cache_slice_(int index) const;
+    /** Load slice into the cache if it is not already cached */
+    void prefetch_slice_(int index) const;
+    /**
+     * Start loading a slice into the cache with asyncReader_. `done` is
+     * called on a completion thread once the slice is cached or has failed.
+     */
+    void prefetch_slice_async_(int index, std::function<void()> done) const;
+    /** Whether a slice or block is in the cache */
+    bool cache_contains_(int key) const;
+    /** Get a cached slice without loading it. Empty on a cache miss. */
+    cv::Mat cached_slice_(int index) const;
+    /** Load a region of a slice from disk */
+    cv::Mat load_slice_region_(int index, const cv::Rect& roi) const;
+    /**
+     * Get the slice data needed to sample a region of a slice. Small regions
+     * of uncached slices are decoded on their own. `offset` is set to the
+     * position of the returned image in the slice.
+     */
+    cv::Mat sample_slice_(
+        int index, const cv::Rect& roi, cv::Point& offset) const;
+    /** Get a voxel of type T. Positions outside of the volume are 0. */
+    template <typename T>
+    T voxel_(int x, int y, int z) const;
+    /** Interpolate many positions of a volume of voxel type T */
+    template <class Kernel, typename T, typename TOut>
+    void interpolate_batch_(const cv::Vec3d* pts, size_t n, TOut* out) const;
+
+    /** Load block from disk */
+    cv::Mat load_block_(int bx, int by, int bz) const;
+    /** Load block from cache */
+    cv::Mat cache_block_(int bx, int by, int bz) const;
+    /** Cache key of a block */
+    int block_key_(int bx, int by, int bz) const;
+    /** Fill a missing block and convert it to the voxel type */
+    cv::Mat finish_block_(cv::Mat block) const;
+    /**
+     * Get a block of a single intensity without reading it. Empty if the
+     * block statistics do not show the block to be constant.
+     */
+    cv::Mat constant_block_(int bx, int by, int bz) const;
+    /**
+     * Start loading the uncached blocks of a list into the cache with
+     * asyncReader_. `done` is called once every block is cached or has
+     * failed.
+     */
+    void cache_blocks_async_(
+        std::vector<cv::Vec3i> blocks, std::function<void()> done) const;
+    /** Get an item from the cache, calling `load()` on a cache miss */
+    template <typename TLoader>
+    cv::Mat cache_get_(int key, TLoader load) const;
+    /** Assemble a region of a slice from the blocks which intersect it */
+    cv::Mat assemble_slice_(int index, const cv::Rect& roi) const;
+    /** Write a slice to disk */
+    void write_slice_(int index, const cv::Mat& slice, bool compress);
+    /** Copy a slice into the block write buffer */
+    void write_slice_to_blocks_(int index, const cv::Mat& slice, bool compress);
+
+    /** In-progress layer of blocks waiting to be written to disk */
+    struct BlockLayer {
+        /** Layer blocks in row-major grid order */
+        std::vector<cv::Mat> blocks;
+        /** Which of the layer's Z-planes have been set */
+        std::vector<bool> written;
+        /** Number of Z-planes which have been set */
+        size_t numWritten{0};
+    };
+    /** Block layers waiting to be written, keyed by block Z-index */
+    std::map<int, BlockLayer> pendingLayers_;
+    /** Write buffer mutex */
+    std::mutex writeMutex_;
+
+    /** Background slice loader */
+    class Prefetcher;
+    /** Slice prefetcher. Null if prefetching is disabled. */
+    std::unique_ptr<Prefetcher> prefetcher_;
+
+    /** Background slice writer */
+    class SliceWriter;
+    /** Slice writer. Null if asynchronous writes are disabled. */
+    std::unique_ptr<SliceWriter> writer_;
+
+    /** Loaded resolution levels */
+    std::map<size_t, Pointer> levels_;
+    /** Resolution level mutex */
+    std::mutex levelsMutex_;
 };
 }  // namespace volcart
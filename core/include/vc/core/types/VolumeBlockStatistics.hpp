@@ -0,0 +1,198 @@
+#pragma once
+
+/** @file */
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+#include "vc/core/filesystem.hpp"
+
+namespace volcart
+{
+
+class Volume;
+
+/**
+ * @class VolumeBlockStatistics
+ * @brief Per-block intensity statistics of a 16-bit Volume
+ *
+ * Divides a volume into a grid of cubic blocks and records the minimum,
+ * maximum, and mean intensity of every block. Large parts of most scans are
+ * air or mounting material, and this index lets readers skip the blocks
+ * which cannot contain an intensity range of interest, or fill blocks of a
+ * single intensity without reading them.
+ *
+ * Like VolumeStatistics, block statistics are usually gathered while
+ * importing a volume by adding every slice with addSlice(). A block layer is
+ * only considered complete once every slice which intersects it has been
+ * added. Incomplete layers never reject a query, so a partially-filled
+ * index is still safe to use. This class is not thread-safe. To gather
+ * statistics from several threads, give each thread its own object and
+ * combine them with merge().
+ *
+ * @see Volume::blockStatistics()
+ * @ingroup Types
+ */
+class VolumeBlockStatistics
+{
+public:
+    /** @brief Statistics of a single block */
+    struct BlockStatistics {
+        /** Minimum intensity */
+        std::uint16_t min{0};
+        /** Maximum intensity */
+        std::uint16_t max{0};
+        /** Mean intensity */
+        double mean{0};
+    };
+
+    /** @brief Default block edge length */
+    static constexpr int DEFAULT_BLOCK_SIZE = 64;
+
+    /** @brief Default constructor. Creates an empty index. */
+    VolumeBlockStatistics() = default;
+
+    /**
+     * @brief Construct an empty index for a volume
+     *
+     * @param volumeShape Volume dimensions (width, height, slices)
+     * @param blockSize Block edge length
+     * @throws std::invalid_argument if the block size is not positive
+     */
+    explicit VolumeBlockStatistics(
+        const cv::Vec3i& volumeShape, int blockSize = DEFAULT_BLOCK_SIZE);
+
+    /**
+     * @brief Compute the index of an existing volume
+     *
+     * Reads every slice of the volume. Slices are read in parallel on the
+     * global ThreadPool. If `numThreads` is 0, every thread in the pool is
+     * used.
+     *
+     * @throws std::invalid_argument if the volume is not 16-bit
+     */
+    static VolumeBlockStatistics Compute(
+        const Volume& volume,
+        int blockSize = DEFAULT_BLOCK_SIZE,
+        std::size_t numThreads = 0);
+
+    /**
+     * @brief Add a slice's intensities
+     *
+     * The slice must be a single-channel, 16-bit image with the volume's
+     * width and height. Adding the same slice index more than once counts
+     * its intensities more than once.
+     *
+     * @throws std::invalid_argument if the slice is not CV_16UC1 or does not
+     * match the volume dimensions
+     * @throws std::out_of_range if the index is outside of the volume
+     */
+    void addSlice(int index, const cv::Mat& slice);
+
+    /**
+     * @brief Add another object's statistics to this one
+     *
+     * @throws std::invalid_argument if the volume dimensions or block sizes
+     * do not match
+     */
+    void merge(const VolumeBlockStatistics& other);
+
+    /** @brief Get the volume dimensions (width, height, slices) */
+    cv::Vec3i volumeShape() const;
+
+    /** @brief Get the block edge length */
+    int blockSize() const;
+
+    /** @brief Get the number of blocks along each dimension (x, y, z) */
+    cv::Vec3i gridSize() const;
+
+    /** @brief Return whether every block has been completed */
+    bool complete() const;
+
+    /**
+     * @brief Return whether every slice which intersects a block has been
+     * added
+     */
+    bool isComplete(int bx, int by, int bz) const;
+
+    /**
+     * @brief Get the statistics of a block
+     *
+     * The statistics of an incomplete block only describe the slices which
+     * have been added.
+     *
+     * @throws std::out_of_range if the block is outside of the grid
+     */
+    BlockStatistics block(int bx, int by, int bz) const;
+
+    /**
+     * @brief Return whether a block may contain an intensity in the range
+     * `[low, high]`
+     *
+     * Returns true for incomplete blocks and blocks outside of the grid.
+     */
+    bool mayContain(
+        int bx, int by, int bz, std::uint16_t low, std::uint16_t high) const;
+
+    /**
+     * @brief Return whether a voxel region may contain an intensity in the
+     * range `[low, high]`
+     *
+     * The region is the half-open box `[start, end)` in voxel coordinates.
+     * It is checked at block resolution, so this returns true if any block
+     * which intersects the region may contain the range.
+     */
+    bool mayContain(
+        const cv::Vec3i& start,
+        const cv::Vec3i& end,
+        std::uint16_t low,
+        std::uint16_t high) const;
+
+    /**
+     * @brief Return whether every voxel of a block has the same intensity
+     *
+     * Returns false for incomplete blocks and blocks outside of the grid.
+     */
+    bool isConstant(int bx, int by, int bz) const;
+
+    /**
+     * @brief Write the index to a binary file
+     *
+     * @throws IOException if the file cannot be written
+     */
+    void write(const filesystem::path& path) const;
+
+    /**
+     * @brief Read an index from a binary file
+     *
+     * @throws IOException if the file cannot be read or is not a block
+     * statistics file
+     */
+    static VolumeBlockStatistics Read(const filesystem::path& path);
+
+private:
+    /** Volume dimensions */
+    cv::Vec3i shape_{0, 0, 0};
+    /** Block edge length */
+    int blockSize_{DEFAULT_BLOCK_SIZE};
+    /** Number of blocks along each dimension */
+    cv::Vec3i grid_{0, 0, 0};
+    /** Per-block minimum, in grid order */
+    std::vector<std::uint16_t> min_;
+    /** Per-block maximum, in grid order */
+    std::vector<std::uint16_t> max_;
+    /** Per-block intensity sum, in grid order */
+    std::vector<double> sum_;
+    /** Number of slices added to each block layer */
+    std::vector<std::uint32_t> layerSlices_;
+
+    /** Index of a block in grid order. -1 if outside of the grid. */
+    std::ptrdiff_t index_(int bx, int by, int bz) const;
+    /** Number of slices which intersect a block layer */
+    int layer_depth_(int bz) const;
+};
+
+}  // namespace volcart
@@ -2,9 +2,11 @@
 
 /** @file */
 
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
 #include <vector>
 
-#include <Eigen/SparseCore>
 #include <opencv2/core.hpp>
 
 #include "vc/core/types/NDArray.hpp"
@@ -19,8 +21,15 @@ namespace volcart
  * Stores the segmentation state (segmented/unsegmented) for each voxel
  * of a Volume.
  *
- * @warning The underlying data structure for this class is memory efficient
- * but extremely slow. This class should be not used in production code.
+ * The volume is divided into cubic bricks of BRICK_SIZE voxels per side.
+ * Unsegmented bricks are not stored, fully segmented bricks are stored as a
+ * flag, and only partially segmented bricks store one bit per voxel. The
+ * subvolume functions and the set operations (merge(), intersect()) work on
+ * whole bricks and on 32-voxel rows of bits, so large uniform regions cost
+ * one operation per brick rather than one per voxel.
+ *
+ * Voxels outside of the mask's dimensions are always unsegmented. Setting
+ * them has no effect.
  */
 class VolumeMask
 {
@@ -31,6 +40,9 @@ public:
     /** Subvolume containing voxel states */
     using Subvolume = NDArray<State>;
 
+    /** Edge length of a brick, in voxels */
+    static constexpr int BRICK_SIZE{32};
+
     /** @brief Construct from Volume dimensions */
     VolumeMask(size_t width, size_t height, size_t numSlices);
 
@@ -38,7 +50,7 @@ public:
     void setVoxelState(const cv::Vec3i& xyz, State state);
 
     /** @brief Get the segmentation state for a voxel */
-    State getVoxelState(const cv::Vec3i& xyz);
+    State getVoxelState(const cv::Vec3i& xyz) const;
 
     /**
      * @brief Set the segmentation state for every voxel in a subvolume
@@ -55,22 +67,78 @@ public:
      * @param origin Top-left corner of subvolume
      * @param dims Length of the subvolume's basis axes in voxels
      */
-    Subvolume getSubvolumeState(const cv::Vec3i& origin, const cv::Vec3i& dims);
+    Subvolume getSubvolumeState(
+        const cv::Vec3i& origin, const cv::Vec3i& dims) const;
+
+    /**
+     * @brief Count the segmented voxels in a subvolume
+     *
+     * @param origin Top-left corner of subvolume
+     * @param dims Length of the subvolume's basis axes in voxels
+     */
+    std::size_t countSegmented(
+        const cv::Vec3i& origin, const cv::Vec3i& dims) const;
+
+    /** @brief Count the segmented voxels in the mask */
+    std::size_t countSegmented() const;
 
-private:
     /**
-     * Voxel state storage matrix
+     * @brief Segment every voxel which is segmented in another mask
      *
-     * The Eigen matrix is a 2D storage array. To accommodate a 3D volume,
-     * z-indices are stored sequentially
+     * @throws std::invalid_argument if the masks have different dimensions
      */
-    Eigen::SparseMatrix<int, Eigen::RowMajor> states_;
+    void merge(const VolumeMask& other);
+
+    /**
+     * @brief Unsegment every voxel which is not segmented in another mask
+     *
+     * @throws std::invalid_argument if the masks have different dimensions
+     */
+    void intersect(const VolumeMask& other);
+
+private:
+    /** Voxels per brick */
+    static constexpr std::size_t BRICK_VOXELS{
+        BRICK_SIZE * BRICK_SIZE * BRICK_SIZE};
+
+    /** Partially or fully segmented brick */
+    struct Brick {
+        /**
+         * One 32-bit row of voxel bits per (z, y) position, ordered
+         * y-fastest. Bit x is the voxel at x. Empty if the brick is full.
+         */
+        std::vector<std::uint32_t> rows;
+        /** Number of segmented voxels */
+        std::size_t count{0};
+
+        /** @brief Whether every voxel is segmented */
+        [[nodiscard]] bool full() const { return count == BRICK_VOXELS; }
+    };
+
+    /** Linear index of the brick containing a voxel */
+    std::size_t brick_index_(const cv::Vec3i& xyz) const;
+    /** Whether a voxel is within the mask */
+    bool in_bounds_(const cv::Vec3i& xyz) const;
+    /**
+     * Call `f(index, min, max, offset)` for every brick overlapped by a
+     * subvolume, clipped to the mask. `min` and `max` bound the overlapped
+     * voxels in brick coordinates and `offset` is the position of the brick
+     * relative to the subvolume origin.
+     */
+    template <class F>
+    void for_each_brick_(
+        const cv::Vec3i& origin, const cv::Vec3i& dims, F&& f) const;
+    /** Check that another mask has the same dimensions */
+    void check_dims_(const VolumeMask& other) const;
+
+    /** Allocated bricks, keyed by linear brick index */
+    std::unordered_map<std::size_t, Brick> bricks_;
 
-    /** Slice width */
-    size_t sliceWidth_;
+    /** Mask dimensions in voxels */
+    cv::Vec3i dims_;
 
-    /** Slice height */
-    size_t sliceHeight_;
+    /** Mask dimensions in bricks */
+    cv::Vec3i brickDims_;
 };
 
-}  // namespace volcart
\ No newline at end of file
+}  // namespace volcart
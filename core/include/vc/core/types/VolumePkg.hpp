@@ -4,6 +4,9 @@
 
 #include <iostream>
 #include <map>
+#include <memory>
+#include <mutex>
+#include <string>
 
 #include "vc/core/filesystem.hpp"
 #include "vc/core/types/Metadata.hpp"
@@ -21,7 +24,17 @@ namespace volcart
  *
  * Provides access to volume, segmentation, and rendering data stored on disk.
  *
- * @warning VolumePkg is not thread safe.
+ * Volumes, Segmentations, and Renders are constructed on first access. The
+ * IDs and names of the objects are cached in an index file (`index.json`) in
+ * the root of the VolumePkg, so opening a package with many objects does not
+ * read each object's metadata. The index is keyed by the objects'
+ * subdirectories. When the package is opened, subdirectories missing from
+ * the index are read and added to it, and the index is rewritten. If the
+ * index cannot be written (e.g. the package is read-only), the package is
+ * still opened, but unindexed objects are read every time.
+ *
+ * @warning VolumePkg is not thread safe, with the exception that objects may
+ * be accessed concurrently. Copies of a VolumePkg share their objects.
  *
  * @ingroup Types
  * @ingroup VolumePackage
@@ -159,9 +172,47 @@ public:
      * @brief Add a new Volume to the VolumePkg
      * @param name Human-readable name for the new Volume. Defaults to the
      * auto-generated Volume ID.
+     * @param format On-disk storage format for the new Volume
+     * @param blockSize Block edge length. Only used by Volume::Format::Blocks.
      * @return Pointer to the new Volume
      */
-    auto newVolume(std::string name = "") -> Volume::Pointer;
+    auto newVolume(
+        std::string name = "",
+        Volume::Format format = Volume::Format::Slices,
+        int blockSize = Volume::DEFAULT_BLOCK_SIZE) -> Volume::Pointer;
+
+    /**
+     * @brief Add a new Volume containing a region of an existing Volume
+     *
+     * Copies the voxels within `roi` of the slices in `slices` from `src`,
+     * which may belong to another VolumePkg. Regions are read with
+     * Volume::getSliceRegion(), so only the TIFF strips, tiles or blocks
+     * which intersect `roi` are decoded, and slices are copied in parallel
+     * on the global ThreadPool.
+     *
+     * The new Volume has the voxel size, voxel type, compression and
+     * intensity range of `src`. Its crop origin records the ID of `src` and
+     * the position of its first voxel in `src`, so that positions in the
+     * new Volume can be mapped back. If `src` is itself a crop, the origin
+     * refers to the Volume `src` was cropped from. See Volume::cropOffset().
+     *
+     * @param src Volume to copy from
+     * @param roi Region of each slice. Clipped to the slice bounds.
+     * @param slices Slice indices [start, end). Clipped to the Volume.
+     * @param name Human-readable name for the new Volume
+     * @param format On-disk storage format for the new Volume
+     * @param blockSize Block edge length. Only used by Volume::Format::Blocks.
+     * @return Pointer to the new Volume
+     *
+     * @throws std::invalid_argument If the clipped region is empty
+     */
+    auto newVolumeFromRegion(
+        const Volume::Pointer& src,
+        cv::Rect roi,
+        cv::Range slices,
+        std::string name = "",
+        Volume::Format format = Volume::Format::Slices,
+        int blockSize = Volume::DEFAULT_BLOCK_SIZE) -> Volume::Pointer;
 
     /** @brief Get the first Volume */
     [[nodiscard]] auto volume() const -> const Volume::Pointer;
@@ -242,6 +293,59 @@ public:
     /**@}*/
 
 private:
+    /**
+     * An object of the VolumePkg which is constructed from its directory on
+     * first access. Copies share the constructed object.
+     */
+    template <class T>
+    class LazyObject
+    {
+    public:
+        /** Object which has not been read */
+        LazyObject(filesystem::path path, std::string name)
+            : state_{std::make_shared<State>()}
+        {
+            state_->path = std::move(path);
+            state_->name = std::move(name);
+        }
+
+        /** Object which is already constructed */
+        explicit LazyObject(typename T::Pointer obj)
+            : state_{std::make_shared<State>()}
+        {
+            state_->path = obj->path();
+            state_->name = obj->name();
+            state_->object = std::move(obj);
+            std::call_once(state_->once, [] {});
+        }
+
+        /** Get the object, constructing it if needed */
+        auto get() const -> typename T::Pointer
+        {
+            auto* s = state_.get();
+            std::call_once(s->once, [s]() { s->object = T::New(s->path); });
+            return s->object;
+        }
+
+        /** Get the object's name without constructing it */
+        [[nodiscard]] auto name() const -> std::string { return state_->name; }
+
+        /** Get the object's directory */
+        [[nodiscard]] auto path() const -> const filesystem::path&
+        {
+            return state_->path;
+        }
+
+    private:
+        struct State {
+            filesystem::path path;
+            std::string name;
+            std::once_flag once;
+            typename T::Pointer object;
+        };
+        std::shared_ptr<State> state_;
+    };
+
     /** VolumePkg metadata */
     Metadata config_;
     /** The root directory of the VolumePkg */
@@ -253,11 +357,18 @@ private:
     /** The subdirectory containing Render data */
     filesystem::path rendDir_;
     /** The list of all Volumes in the VolumePkg. */
-    std::map<Volume::Identifier, Volume::Pointer> volumes_;
+    std::map<Volume::Identifier, LazyObject<Volume>> volumes_;
     /** The list of all Segmentations in the VolumePkg. */
-    std::map<Segmentation::Identifier, Segmentation::Pointer> segmentations_;
+    std::map<Segmentation::Identifier, LazyObject<Segmentation>>
+        segmentations_;
     /** The list of all Renders in the VolumePkg. */
-    std::map<Render::Identifier, Render::Pointer> renders_;
+    std::map<Render::Identifier, LazyObject<Render>> renders_;
+
+    /** Read the index file and list the objects in each subdirectory */
+    void load_objects_();
+
+    /** Write the index file. Logs a warning if it cannot be written. */
+    void write_index_() const;
 
     /**
      * @brief Populates an empty VolumePkg::config from a volcart::Dictionary
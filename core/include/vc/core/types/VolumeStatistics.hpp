@@ -0,0 +1,116 @@
+#pragma once
+
+/** @file */
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+#include <opencv2/core.hpp>
+
+namespace volcart
+{
+/**
+ * @class VolumeStatistics
+ * @brief Intensity statistics of a 16-bit Volume
+ *
+ * Accumulates a full-resolution intensity histogram and the minimum, maximum,
+ * and mean intensity of every slice. Percentiles are computed from the
+ * histogram, so that tools such as texturing and intensity windowing do not
+ * need to re-read the volume.
+ *
+ * Statistics are usually gathered while importing a volume by adding every
+ * slice with addSlice(). This class is not thread-safe. To gather statistics
+ * from several threads, give each thread its own object and combine them
+ * with merge().
+ *
+ * @see Volume::statistics()
+ * @ingroup Types
+ */
+class VolumeStatistics
+{
+public:
+    /** Number of histogram bins: one per 16-bit intensity */
+    static constexpr std::size_t NUM_BINS = 65536;
+
+    /** @brief Statistics of a single slice */
+    struct SliceStatistics {
+        /** Minimum intensity */
+        double min{0};
+        /** Maximum intensity */
+        double max{0};
+        /** Mean intensity */
+        double mean{0};
+        /** Whether the slice has been added */
+        bool valid{false};
+    };
+
+    /** @brief Default percentiles stored in the percentile table */
+    static std::vector<double> DefaultPercentiles();
+
+    /** @brief Default constructor */
+    VolumeStatistics();
+
+    /**
+     * @brief Add a slice's intensities
+     *
+     * The slice must be a single-channel, 16-bit image. Adding the same slice
+     * index more than once counts its intensities more than once.
+     *
+     * @throws std::invalid_argument if the slice is not CV_16UC1
+     */
+    void addSlice(int index, const cv::Mat& slice);
+
+    /**
+     * @brief Add another object's statistics to this one
+     *
+     * Slices which were added to `other` replace the statistics of
+     * the same slices in this object.
+     */
+    void merge(const VolumeStatistics& other);
+
+    /** @brief Get the number of voxels which have been added */
+    std::uint64_t count() const;
+
+    /** @brief Get the minimum intensity. Returns 0 if empty. */
+    double min() const;
+
+    /** @brief Get the maximum intensity. Returns 0 if empty. */
+    double max() const;
+
+    /** @brief Get the mean intensity. Returns 0 if empty. */
+    double mean() const;
+
+    /**
+     * @brief Get an intensity percentile
+     *
+     * Returns the smallest intensity which is greater than or equal to `p`
+     * percent of the voxels, where `p` is in the range [0, 100]. Returns 0 if
+     * empty.
+     */
+    double percentile(double p) const;
+
+    /** @brief Get the intensity histogram */
+    const std::vector<std::uint64_t>& histogram() const;
+
+    /** @brief Get the statistics of every slice, indexed by slice number */
+    const std::vector<SliceStatistics>& slices() const;
+
+private:
+    /** JSON deserialization */
+    friend void from_json(const nlohmann::json& j, VolumeStatistics& s);
+
+    /** Intensity histogram */
+    std::vector<std::uint64_t> histogram_;
+    /** Per-slice statistics */
+    std::vector<SliceStatistics> slices_;
+};
+
+/** @brief Serialize VolumeStatistics to JSON */
+void to_json(nlohmann::json& j, const VolumeStatistics& s);
+
+/** @brief Deserialize VolumeStatistics from JSON */
+void from_json(const nlohmann::json& j, VolumeStatistics& s);
+
+}  // namespace volcart
@@ -2,11 +2,19 @@
 
 /** @file */
 
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
 #include <memory>
-#include <unordered_set>
+#include <unordered_map>
+#include <vector>
+
+#include <opencv2/core.hpp>
 
 #include "vc/core/types/PointSet.hpp"
 #include "vc/core/util/HashFunctions.hpp"
+#include "vc/core/util/MemoryUsage.hpp"
 
 namespace volcart
 {
@@ -14,8 +22,14 @@ namespace volcart
 /**
  * @brief Stores per-voxel mask information for a volume
  *
- * @warning This container is built on std::unordered_set, so it's very fast
- * once built, but not very memory friendly.
+ * The mask is stored as a sparse set of fixed-size, cubic blocks. Each block
+ * is a bitset with one bit per voxel, and blocks are only allocated when they
+ * contain at least one masked voxel. Membership tests are O(1): one hash
+ * lookup for the block and one bit test. Densely masked regions cost roughly
+ * one bit per voxel, rather than the dozens of bytes per voxel required by a
+ * hash set of voxel positions.
+ *
+ * Iteration order is unspecified.
  */
 class VolumetricMask
 {
@@ -23,15 +37,70 @@ public:
     /** Voxel type */
     using Voxel = cv::Vec3i;
 
+    /** Edge length of a mask block, in voxels */
+    static constexpr int BLOCK_SIZE{16};
+    /** Number of voxels in a mask block */
+    static constexpr std::size_t BLOCK_VOXELS{
+        BLOCK_SIZE * BLOCK_SIZE * BLOCK_SIZE};
+    /** Number of 64-bit words in a mask block */
+    static constexpr std::size_t BLOCK_WORDS{BLOCK_VOXELS / 64};
+
+    /** @brief Bitset for a single mask block */
+    struct Block {
+        /** Voxel bits, ordered x-fastest */
+        std::array<std::uint64_t, BLOCK_WORDS> bits{};
+        /** Number of set bits */
+        std::size_t count{0};
+    };
+
 private:
-    /** Custom set type */
-    using MaskSet = std::unordered_set<Voxel, Vec3iHash>;
+    /** Block storage type, keyed by block position */
+    using BlockMap = std::unordered_map<Voxel, Block, Vec3iHash>;
 
 public:
+    /** @brief Forward iterator over the voxels in the mask */
+    class ConstIterator
+    {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = Voxel;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = Voxel;
+
+        ConstIterator() = default;
+
+        /** @brief Get the current voxel */
+        auto operator*() const -> Voxel;
+
+        auto operator++() -> ConstIterator&;
+        auto operator++(int) -> ConstIterator;
+
+        auto operator==(const ConstIterator& o) const -> bool;
+        auto operator!=(const ConstIterator& o) const -> bool;
+
+    private:
+        friend class VolumetricMask;
+        ConstIterator(
+            BlockMap::const_iterator it, BlockMap::const_iterator end);
+
+        /** Advance to the next set bit, starting with the current word */
+        void find_next_();
+
+        /** Current block */
+        BlockMap::const_iterator it_;
+        /** End of the block map */
+        BlockMap::const_iterator end_;
+        /** Index of the current word in the current block */
+        std::size_t word_{0};
+        /** Remaining set bits in the current word */
+        std::uint64_t bits_{0};
+    };
+
     /** Iterator type */
-    using iterator = MaskSet::iterator;
+    using iterator = ConstIterator;
     /** Const-iterator type */
-    using const_iterator = MaskSet::const_iterator;
+    using const_iterator = ConstIterator;
 
     /** Pointer type */
     using Pointer = std::shared_ptr<VolumetricMask>;
@@ -50,8 +119,7 @@ public:
     template <class Container>
     explicit VolumetricMask(const Container& ps)
     {
-        mask_.reserve(ps.size());
-        mask_.insert(std::begin(ps), std::end(ps));
+        setIn(ps);
     }
 
     /** @brief Add Voxel to mask */
@@ -63,8 +131,9 @@ public:
     template <class Container>
     void setIn(const Container& ps)
     {
-        mask_.reserve(mask_.size() + ps.size());
-        mask_.insert(std::begin(ps), std::end(ps));
+        for (const auto& p : ps) {
+            setIn(p);
+        }
     }
 
     /** @brief Remove Voxels from the mask */
@@ -76,6 +145,14 @@ public:
         }
     }
 
+    /**
+     * @brief Add a slice of voxels to the mask from a binary image
+     *
+     * Every non-zero pixel (x, y) of the single-channel, 8-bit image is added
+     * to the mask as voxel (x, y, z).
+     */
+    void setIn(const cv::Mat& sliceMask, int z);
+
     /** @brief Check whether a Voxel is in the mask */
     [[nodiscard]] auto isIn(const Voxel& v) const -> bool;
     /** @brief Check whether a Voxel is not in the mask */
@@ -87,31 +164,74 @@ public:
     [[nodiscard]] auto isOut(const cv::Vec3d& v) const -> bool;
 
     /** @brief Get a const-iterator to the first element in the mask */
-    auto begin() noexcept -> iterator;
-    /** @copydoc begin() */
     [[nodiscard]] auto begin() const noexcept -> const_iterator;
     /** @copydoc begin() */
     [[nodiscard]] auto cbegin() const noexcept -> const_iterator;
 
     /** @brief Get a const-iterator to one past the last element in the mask */
-    auto end() noexcept -> iterator;
-    /** @copydoc end() */
     [[nodiscard]] auto end() const noexcept -> const_iterator;
     /** @copydoc end() */
     [[nodiscard]] auto cend() const noexcept -> const_iterator;
 
+    /**
+     * @brief Add all voxels of another mask to this mask
+     *
+     * Merges block-by-block, so the cost is proportional to the number of
+     * blocks in `other` rather than the number of voxels.
+     */
+    void merge(const VolumetricMask& other);
+
     /** @brief Clear the mask of all voxels */
     void clear();
 
     /** @brief Check if mask is empty */
     [[nodiscard]] auto empty() const -> bool;
 
+    /** @brief Get the number of voxels in the mask */
+    [[nodiscard]] auto size() const -> std::size_t;
+
     /** @brief Get the list of masked points as a vector */
     [[nodiscard]] auto as_vector() const -> std::vector<Voxel>;
 
+    /**@{*/
+    /**
+     * @brief Get the number of allocated mask blocks
+     *
+     * The approximate memory footprint of the mask is
+     * `numBlocks() * sizeof(Block)`.
+     */
+    [[nodiscard]] auto numBlocks() const -> std::size_t;
+
+    /**
+     * @brief Get a block by its block position
+     *
+     * Returns nullptr if the block contains no masked voxels. Block (i, j, k)
+     * covers the voxels from `BLOCK_SIZE * (i, j, k)` up to, but not
+     * including, `BLOCK_SIZE * (i + 1, j + 1, k + 1)`.
+     */
+    [[nodiscard]] auto getBlock(const Voxel& pos) const -> const Block*;
+
+    /**
+     * @brief Set a block by its block position
+     *
+     * Replaces any existing block at `pos`. Empty blocks are not stored.
+     * Used by the mask IO functions to load blocks without per-voxel inserts.
+     */
+    void setBlock(const Voxel& pos, const Block& block);
+
+    /** @brief Get the positions of all allocated blocks */
+    [[nodiscard]] auto blockPositions() const -> std::vector<Voxel>;
+    /**@}*/
+
 private:
     /** Mask storage container */
-    MaskSet mask_;
+    BlockMap blocks_;
+    /** Number of voxels in the mask */
+    std::size_t size_{0};
+    /** Memory held by the allocated blocks */
+    memory::TrackedBytes memory_{MemoryCategory::Mask};
+    /** Update the memory counted for the allocated blocks */
+    void update_memory_();
 };
 
 }  // namespace volcart
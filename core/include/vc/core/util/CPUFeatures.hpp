@@ -0,0 +1,151 @@
+#pragma once
+
+/**
+ * @file CPUFeatures.hpp
+ *
+ * @ingroup Util
+ */
+
+#include <string>
+
+// Target attributes for kernels compiled for a higher instruction set than
+// the rest of the library. Only defined for GCC and Clang on x86, where a
+// kernel can be compiled several times and the best version picked at run
+// time with simd::Kernels.
+#if (defined(__GNUC__) || defined(__clang__)) && \
+    (defined(__x86_64__) || defined(__i386__))
+/** Defined when kernels can be compiled for x86 instruction sets */
+#define VC_SIMD_X86 1
+/** Compile a function for SSE4.2 */
+#define VC_TARGET_SSE4 __attribute__((target("sse4.2")))
+/** Compile a function for AVX2 and FMA */
+#define VC_TARGET_AVX2 __attribute__((target("avx2,fma")))
+/** Compile a function for AVX-512 (F, BW, VL) */
+#define VC_TARGET_AVX512 \
+    __attribute__((target("avx512f,avx512bw,avx512vl,avx2,fma")))
+#endif
+
+namespace volcart
+{
+
+/**
+ * @namespace volcart::simd
+ * @brief Run-time selection of SIMD kernel implementations
+ *
+ * The library is built for a baseline instruction set so that one binary
+ * runs on every machine. Hot kernels are additionally compiled for SSE4.2,
+ * AVX2 and AVX-512 with the `VC_TARGET_*` attributes, and simd::Kernels
+ * picks the best version the CPU supports. On ARM64, NEON is part of the
+ * baseline, so every kernel already uses it.
+ *
+ * The highest path used can be lowered with the `VC_SIMD` environment
+ * variable (`scalar`, `sse4`, `avx2`, `avx512` or `neon`), e.g. to compare
+ * results or timings between paths. Paths the CPU does not support are
+ * never used.
+ */
+namespace simd
+{
+
+/** Instruction set paths, from lowest to highest */
+enum class Path { Scalar, SSE4, AVX2, AVX512, NEON };
+
+/** @brief Get the highest path supported by the CPU */
+auto DetectPath() -> Path;
+
+/** @brief Return whether the CPU supports a path */
+auto Supports(Path p) -> bool;
+
+/**
+ * @brief Get the path used by simd::Kernels
+ *
+ * The highest supported path, lowered by `VC_SIMD` if set. Determined once,
+ * on first call, and logged at the debug level.
+ */
+auto ActivePath() -> Path;
+
+/** @brief Get the name of a path */
+auto PathName(Path p) -> std::string;
+
+/**
+ * @brief Parse a path name, as returned by PathName()
+ *
+ * Case-insensitive.
+ *
+ * @throws std::invalid_argument If `name` is not a path name
+ */
+auto ParsePath(const std::string& name) -> Path;
+
+/**
+ * @brief Table of implementations of a kernel for each path
+ *
+ * Only the scalar implementation is required. select() returns the
+ * implementation for the highest path which is at most the given path and
+ * has an implementation, so a kernel can provide only the paths which pay
+ * off. Select once, e.g. into a function-local static, rather than on every
+ * call.
+ *
+ * Example Usage:
+ * @code{.cpp}
+ * void SumScalar(const float* x, std::size_t n, float* out);
+ * #ifdef VC_SIMD_X86
+ * VC_TARGET_AVX2 void SumAVX2(const float* x, std::size_t n, float* out);
+ * #endif
+ *
+ * auto SelectSum()
+ * {
+ *     simd::Kernels<decltype(&SumScalar)> k{SumScalar};
+ * #ifdef VC_SIMD_X86
+ *     k.avx2 = SumAVX2;
+ * #endif
+ *     return k.select();
+ * }
+ *
+ * static const auto sum = SelectSum();
+ * @endcode
+ */
+template <class Fn>
+struct Kernels {
+    /** Baseline implementation */
+    Fn scalar;
+    /** SSE4.2 implementation */
+    Fn sse4{nullptr};
+    /** AVX2 implementation */
+    Fn avx2{nullptr};
+    /** AVX-512 implementation */
+    Fn avx512{nullptr};
+    /** NEON implementation */
+    Fn neon{nullptr};
+
+    /** @brief Select the implementation for a path */
+    auto select(Path p) const -> Fn
+    {
+        switch (p) {
+            case Path::NEON:
+                return neon ? neon : scalar;
+            case Path::AVX512:
+                if (avx512) {
+                    return avx512;
+                }
+                [[fallthrough]];
+            case Path::AVX2:
+                if (avx2) {
+                    return avx2;
+                }
+                [[fallthrough]];
+            case Path::SSE4:
+                if (sse4) {
+                    return sse4;
+                }
+                [[fallthrough]];
+            case Path::Scalar:
+                break;
+        }
+        return scalar;
+    }
+
+    /** @brief Select the implementation for ActivePath() */
+    auto select() const -> Fn { return select(ActivePath()); }
+};
+
+}  // namespace simd
+}  // namespace volcart
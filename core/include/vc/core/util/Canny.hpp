@@ -35,6 +35,19 @@ struct CannySettings {
  */
 auto Canny(cv::Mat src, CannySettings settings) -> cv::Mat;
 
+/**
+ * @brief Perform Canny edge segmentation on an image with OpenCL
+ *
+ * Runs the same pipeline as Canny(cv::Mat, CannySettings) through OpenCV's
+ * transparent API. If `cv::ocl::useOpenCL()` is true, the filters run on the
+ * OpenCL device and the image stays in device memory between calls, so an
+ * image uploaded once can be segmented with many settings. Otherwise, the
+ * filters run on the CPU. Contour extraction always runs on the CPU.
+ *
+ * @ingroup Util
+ */
+auto Canny(const cv::UMat& src, const CannySettings& settings) -> cv::UMat;
+
 }  // namespace volcart
 
 #pragma clang diagnostic pop
\ No newline at end of file
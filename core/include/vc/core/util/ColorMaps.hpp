@@ -36,6 +36,9 @@ ColorMap ColorMapFromString(const std::string& str);
 /**
  * @brief Get a color map LUT for use with ApplyLUT
  *
+ * Each LUT is built once per color map and bin count and then cached. Every
+ * call returns a copy of the cached LUT. Safe to call from multiple threads.
+ *
  * @ingroup Util
  */
 cv::Mat GetColorMapLUT(ColorMap cm, std::size_t bins = 256);
@@ -5,6 +5,7 @@
 #include <cmath>
 #include <iostream>
 #include <type_traits>
+#include <utility>
 
 namespace volcart
 {
@@ -113,9 +114,15 @@ public:
     template <typename Q = T>
     std::enable_if_t<std::is_integral<Q>::value, size_t> size() const
     {
-        return static_cast<size_t>((end_ - start_) / step_);
+        if (end_ <= start_) {
+            return 0;
+        }
+        return static_cast<size_t>((end_ - start_ + step_ - 1) / step_);
     }
 
+    /** Returns the i-th value of the range */
+    T operator[](size_t i) const { return start_ + static_cast<T>(i) * step_; }
+
 private:
     T start_{0};
     T end_{0};
@@ -308,8 +315,21 @@ public:
     template <typename Q = T>
     std::enable_if_t<std::is_integral<Q>::value, size_t> size() const
     {
-        auto vLen = static_cast<size_t>((vEnd_ - vStart_) / step_);
-        return static_cast<size_t>((uEnd_ - uStart_) / step_) * vLen;
+        return range(vStart_, vEnd_, step_).size() *
+               range(uStart_, uEnd_, step_).size();
+    }
+
+    /**
+     * @brief Returns the i-th (v, u) pair of the range
+     *
+     * Pairs are numbered in iteration order, i.e. the u value changes
+     * fastest.
+     */
+    std::pair<T, T> operator[](size_t i) const
+    {
+        auto u = range(uStart_, uEnd_, step_);
+        auto v = range(vStart_, vEnd_, step_);
+        return {v[i / u.size()], u[i % u.size()]};
     }
 
 private:
@@ -0,0 +1,91 @@
+#pragma once
+
+/**
+ * @file LargePages.hpp
+ *
+ * @ingroup Util
+ */
+
+#include <cstddef>
+#include <string>
+
+#include <opencv2/core.hpp>
+
+namespace volcart
+{
+
+/** @brief Backing of large buffers */
+enum class LargePageMode {
+    /** Standard heap allocations */
+    Off = 0,
+    /** Anonymous mappings advised to use transparent huge pages */
+    Transparent,
+    /**
+     * Explicit huge pages (`MAP_HUGETLB`) from the system's huge page pool.
+     * Falls back to Transparent when the pool is exhausted.
+     */
+    Explicit
+};
+
+namespace memory
+{
+/** Buffers of at least this many bytes are backed by huge pages */
+constexpr std::size_t LARGE_BUFFER_BYTES{std::size_t{2} << 20};
+
+/** Size of a huge page, and the alignment of large buffers */
+constexpr std::size_t HUGE_PAGE_BYTES{std::size_t{2} << 20};
+
+/**
+ * @brief Set how large buffers are backed
+ *
+ * The largest buffers of a render, such as cached slices, PerPixelMap
+ * storage, cell maps, and texture images, are sampled randomly. With the
+ * default 4 KB pages, sampling across many gigabytes of them constantly
+ * misses the TLB. With LargePageMode::Transparent or LargePageMode::Explicit,
+ * buffers of at least LARGE_BUFFER_BYTES are instead placed in mappings
+ * which are aligned to, and backed by, 2 MB huge pages where the system
+ * supports them.
+ *
+ * Enabling large pages installs LargePageAllocator() as the default
+ * cv::Mat allocator, so every image allocated afterwards is covered.
+ * OrderedPointSet::Fill() advises its storage with AdviseLargePages().
+ * Huge pages round the memory used by each large buffer up to a multiple of
+ * HUGE_PAGE_BYTES. Buffers which were allocated before the mode changed are
+ * released by the allocator which created them.
+ *
+ * On systems without huge page support, every mode behaves like
+ * LargePageMode::Off. Default: LargePageMode::Off
+ */
+void SetLargePages(LargePageMode mode);
+
+/** @brief Get how large buffers are backed */
+auto LargePages() -> LargePageMode;
+
+/**
+ * @brief Parse a large page mode: `off`, `transparent`, or `explicit`
+ *
+ * @throws std::invalid_argument If `s` is not a large page mode
+ */
+auto ParseLargePageMode(const std::string& s) -> LargePageMode;
+
+/**
+ * @brief Get the cv::Mat allocator for large buffers
+ *
+ * Images of at least LARGE_BUFFER_BYTES which are allocated while large
+ * pages are enabled are placed in huge-page mappings. Other images, and
+ * images which wrap user data, are allocated by the standard OpenCV
+ * allocator, which aligns them to 64 bytes.
+ */
+auto LargePageAllocator() -> cv::MatAllocator*;
+
+/**
+ * @brief Advise that a heap buffer should be backed by huge pages
+ *
+ * For storage which is not allocated with LargePageAllocator(), such as
+ * `std::vector`. Covers the pages which lie entirely within the buffer, so
+ * call it before the buffer is first written. Does nothing if large pages
+ * are disabled or the buffer is smaller than LARGE_BUFFER_BYTES.
+ */
+void AdviseLargePages(void* ptr, std::size_t bytes);
+}  // namespace memory
+}  // namespace volcart
@@ -0,0 +1,230 @@
+#pragma once
+
+/**
+ * @file MemoryUsage.hpp
+ *
+ * @ingroup Util
+ */
+
+#include <array>
+#include <cstddef>
+#include <functional>
+#include <string>
+
+namespace volcart
+{
+
+/** @brief Categories of memory tracked by volcart::memory */
+enum class MemoryCategory {
+    /** Cached Volume slices and blocks */
+    SliceCache = 0,
+    /** PerPixelMap mappings, masks, and cell maps */
+    PPM,
+    /** Meshes */
+    Mesh,
+    /** Texture images */
+    Texture,
+    /** Volumetric masks */
+    Mask
+};
+
+/**
+ * @namespace volcart::memory
+ * @brief Accounting of the memory used by VC objects
+ *
+ * Memory is accounted in two ways. Objects with simple lifetimes, such as
+ * PerPixelMap, hold a TrackedBytes counter which is updated when their
+ * storage changes. Objects whose usage changes constantly, such as the slice
+ * caches, register a provider function which reports their current usage
+ * whenever the accounts are sampled.
+ *
+ * An optional soft limit bounds the tracked total. When a sample exceeds the
+ * limit, the registered shrink handlers are asked to release the excess.
+ * Volume registers a handler which shrinks its slice cache, so the cache
+ * gives way to other allocations rather than pushing the process into the
+ * OOM killer. The accounts are sampled whenever the TrackedBytes counters
+ * have grown by SAMPLE_GRANULARITY bytes and whenever Sample() is called,
+ * e.g. at graph node boundaries.
+ *
+ * The accounts only cover memory tracked by VC objects. They complement,
+ * rather than replace, the process' resident set size.
+ */
+namespace memory
+{
+/** Number of memory categories */
+constexpr std::size_t NUM_CATEGORIES{5};
+
+/**
+ * Growth of the TrackedBytes counters, in bytes, after which the accounts are
+ * sampled
+ */
+constexpr std::size_t SAMPLE_GRANULARITY{1 << 20};
+
+/** @brief Get the display name of a category */
+auto CategoryName(MemoryCategory c) -> std::string;
+
+/** @brief Add bytes to a category's counter */
+void Add(MemoryCategory c, std::size_t bytes);
+
+/** @brief Remove bytes from a category's counter */
+void Remove(MemoryCategory c, std::size_t bytes);
+
+class Registration;
+
+/**
+ * @brief Register a function which reports memory usage when sampled
+ *
+ * Providers which share the same non-null `key` are counted once. Use this
+ * for objects which share storage, such as Volumes sharing a slice cache.
+ * The function must be safe to call from any thread.
+ */
+auto RegisterProvider(
+    MemoryCategory c,
+    std::function<std::size_t()> provider,
+    const void* key = nullptr) -> Registration;
+
+/**
+ * @brief Register a function which releases memory when the soft limit is
+ * exceeded
+ *
+ * The function is called with the number of bytes by which the total exceeds
+ * the limit and should release up to that many bytes. Handlers are called in
+ * the order they were registered until the excess has been released.
+ */
+auto RegisterShrinkHandler(std::function<void(std::size_t)> handler)
+    -> Registration;
+
+/**
+ * @brief Handle to a registered provider or shrink handler
+ *
+ * The function is unregistered when the handle is destroyed or reset.
+ */
+class Registration
+{
+public:
+    /** Empty registration */
+    Registration() = default;
+    /** Unregister */
+    ~Registration();
+    /**@{*/
+    Registration(const Registration&) = delete;
+    auto operator=(const Registration&) -> Registration& = delete;
+    Registration(Registration&& other) noexcept;
+    auto operator=(Registration&& other) noexcept -> Registration&;
+    /**@}*/
+
+    /** @brief Unregister the function */
+    void reset();
+
+private:
+    friend auto RegisterProvider(
+        MemoryCategory, std::function<std::size_t()>, const void*)
+        -> Registration;
+    friend auto RegisterShrinkHandler(std::function<void(std::size_t)>)
+        -> Registration;
+    /** Construct from a registry ID */
+    explicit Registration(std::size_t id) : id_{id} {}
+    /** Registry ID. 0 if empty. */
+    std::size_t id_{0};
+};
+
+/** @brief Current usage of a category */
+auto Current(MemoryCategory c) -> std::size_t;
+
+/** @brief Current usage of all categories */
+auto Total() -> std::size_t;
+
+/** @brief Peak sampled usage of a category */
+auto Peak(MemoryCategory c) -> std::size_t;
+
+/** @brief Peak sampled usage of all categories */
+auto PeakTotal() -> std::size_t;
+
+/** @brief Reset the peaks to the current usage */
+void ResetPeaks();
+
+/**
+ * @brief Set the soft limit on the tracked total in bytes
+ *
+ * If `bytes == 0` (default), there is no limit.
+ */
+void SetSoftLimit(std::size_t bytes);
+
+/** @brief Get the soft limit on the tracked total in bytes */
+auto SoftLimit() -> std::size_t;
+
+/**
+ * @brief Sample the current usage
+ *
+ * Updates the peaks and, if the soft limit is exceeded, calls the shrink
+ * handlers. Returns the current usage of each category.
+ */
+auto Sample() -> std::array<std::size_t, NUM_CATEGORIES>;
+
+/** @brief Single-line summary of the current usage, e.g. for logging */
+auto Summary() -> std::string;
+
+/** @brief Table of the current and peak usage of every category */
+auto Report() -> std::string;
+
+/**
+ * @brief Counter for the memory held by an object
+ *
+ * Add one as a member of the object and call set() whenever the object's
+ * storage changes. Copies count their bytes separately, which matches
+ * objects whose copies are deep.
+ */
+class TrackedBytes
+{
+public:
+    /** Construct a counter with no bytes */
+    explicit TrackedBytes(MemoryCategory c) : category_{c} {}
+    /** Remove the counted bytes */
+    ~TrackedBytes() { Remove(category_, bytes_); }
+    /** Count the other counter's bytes again */
+    TrackedBytes(const TrackedBytes& other) : category_{other.category_}
+    {
+        set(other.bytes_);
+    }
+    /** Count the other counter's bytes again */
+    auto operator=(const TrackedBytes& other) -> TrackedBytes&
+    {
+        if (this != &other) {
+            set(0);
+            category_ = other.category_;
+            set(other.bytes_);
+        }
+        return *this;
+    }
+    /** Take over the other counter's bytes */
+    TrackedBytes(TrackedBytes&& other) noexcept
+        : category_{other.category_}, bytes_{other.bytes_}
+    {
+        other.bytes_ = 0;
+    }
+    /** Take over the other counter's bytes */
+    auto operator=(TrackedBytes&& other) noexcept -> TrackedBytes&
+    {
+        if (this != &other) {
+            Remove(category_, bytes_);
+            category_ = other.category_;
+            bytes_ = other.bytes_;
+            other.bytes_ = 0;
+        }
+        return *this;
+    }
+
+    /** @brief Set the number of bytes held by the object */
+    void set(std::size_t bytes);
+
+    /** @brief Get the number of bytes held by the object */
+    [[nodiscard]] auto bytes() const -> std::size_t { return bytes_; }
+
+private:
+    /** Category of the bytes */
+    MemoryCategory category_;
+    /** Counted bytes */
+    std::size_t bytes_{0};
+};
+}  // namespace memory
+}  // namespace volcart
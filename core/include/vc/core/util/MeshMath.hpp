@@ -10,6 +10,13 @@
  * @ingroup Util
  */
 
+#include <cstddef>
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+#include "vc/core/types/BoundingBox.hpp"
+#include "vc/core/types/FlatMesh.hpp"
 #include "vc/core/types/ITKMesh.hpp"
 
 namespace volcart::meshmath
@@ -37,7 +44,81 @@ T TriangleArea(T a, T b, T c)
     return 0.25 * std::sqrt(p);
 }
 
-/** @brief Calculate the surface area of an ITKMesh */
+/** @brief Summary statistics of the edge lengths of a mesh */
+struct EdgeLengthStats {
+    /** Number of edges measured */
+    std::size_t count{0};
+    /** Shortest edge length */
+    double min{0};
+    /** Longest edge length */
+    double max{0};
+    /** Mean edge length */
+    double mean{0};
+    /** Standard deviation of the edge lengths */
+    double stddev{0};
+};
+
+/**
+ * @brief Calculate the surface area of an ITKMesh
+ *
+ * Converts the mesh with ToFlatMesh() and calls
+ * SurfaceArea(const FlatMesh&, std::size_t).
+ */
 double SurfaceArea(const ITKMesh::Pointer& mesh);
 
+/**
+ * @brief Calculate the surface area of a FlatMesh
+ *
+ * Faces are summed in parallel chunks which are combined in a fixed order,
+ * so the result does not depend on the number of threads. Faces with a NaN
+ * area are evaluated as 0.
+ *
+ * @param numThreads Number of threads. If `0`, uses every thread in the
+ * global ThreadPool.
+ */
+double SurfaceArea(const FlatMesh& mesh, std::size_t numThreads = 0);
+
+/**
+ * @brief Calculate the axis-aligned bounds of the vertices of a FlatMesh
+ *
+ * Unlike the BoundingBox convention, both bounds are the inclusive minimum
+ * and maximum vertex coordinates. Returns an empty box for a mesh without
+ * vertices.
+ *
+ * @copydetails SurfaceArea(const FlatMesh&, std::size_t)
+ */
+auto Bounds(const FlatMesh& mesh, std::size_t numThreads = 0)
+    -> BoundingBox<double, 3>;
+
+/**
+ * @brief Calculate statistics of the edge lengths of a FlatMesh
+ *
+ * Measures the three edges of every face, so an edge shared by two faces is
+ * counted twice.
+ *
+ * @copydetails SurfaceArea(const FlatMesh&, std::size_t)
+ */
+auto EdgeLengths(const FlatMesh& mesh, std::size_t numThreads = 0)
+    -> EdgeLengthStats;
+
+/**
+ * @brief Calculate the unit normal of every face of a FlatMesh
+ *
+ * Normals follow the orientation used by FlatMesh::computeNormals().
+ * Degenerate faces have a zero normal.
+ *
+ * @param numThreads Number of threads. If `0`, uses every thread in the
+ * global ThreadPool.
+ */
+auto FaceNormals(const FlatMesh& mesh, std::size_t numThreads = 0)
+    -> std::vector<cv::Vec3d>;
+
+/**
+ * @brief Estimate the memory held by an ITKMesh in bytes
+ *
+ * Counts the points, point data, and triangle cells. Returns 0 for a null
+ * mesh.
+ */
+std::size_t MemoryInBytes(const ITKMesh::Pointer& mesh);
+
 }  // namespace volcart::meshmath
@@ -0,0 +1,102 @@
+#pragma once
+
+/**
+ * @file NUMA.hpp
+ *
+ * @ingroup Util
+ */
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace volcart
+{
+
+/**
+ * @namespace volcart::numa
+ * @brief NUMA topology and thread placement
+ *
+ * On multi-socket machines, memory is attached to the socket of the CPUs
+ * which first wrote it. Threads which read memory attached to another socket
+ * pay for every access with a trip across the interconnect. These functions
+ * describe the NUMA nodes of the system and bind threads to their CPUs, so
+ * that a thread which loads a slice and the threads which sample it run on
+ * the same node. See Volume::setNUMAPartitioning() and
+ * texturing::TexturingAlgorithm::setNUMABinding().
+ *
+ * The topology is read from `/sys/devices/system/node` on Linux. On other
+ * systems, and on Linux systems with a single node, there is one node and
+ * binding threads has no effect. Nodes without CPUs, such as memory
+ * expansion devices, are not counted.
+ */
+namespace numa
+{
+/** @brief Get the number of NUMA nodes with CPUs. At least 1. */
+auto NumNodes() -> std::size_t;
+
+/**
+ * @brief Get the CPUs of a NUMA node
+ *
+ * Empty if the topology is unknown.
+ *
+ * @throws std::out_of_range If `node >= NumNodes()`
+ */
+auto NodeCPUs(std::size_t node) -> std::vector<int>;
+
+/**
+ * @brief Get the NUMA node of the CPU running the calling thread
+ *
+ * 0 if the topology is unknown. The thread may be moved to another node
+ * right after the call unless it is bound to a node.
+ */
+auto CurrentNode() -> std::size_t;
+
+/**
+ * @brief Parse a Linux CPU list, such as `0-3,8,10-11`
+ *
+ * @throws std::invalid_argument If `list` is not a CPU list
+ */
+auto ParseCPUList(const std::string& list) -> std::vector<int>;
+
+/**
+ * @brief Binds the calling thread to the CPUs of a NUMA node for the
+ * lifetime of the object
+ *
+ * The thread's previous CPU affinity is restored by the destructor, so
+ * threads of a shared pool, such as ThreadPool::Global(), can be bound for
+ * the duration of a task. Must be destroyed by the thread which constructed
+ * it.
+ */
+class ScopedBinding
+{
+public:
+    /**
+     * @brief Bind the calling thread to a NUMA node
+     *
+     * Does nothing if there is only one node, if `node >= NumNodes()`, or if
+     * the thread cannot be bound.
+     */
+    explicit ScopedBinding(std::size_t node);
+
+    /** @brief Restore the thread's previous CPU affinity */
+    ~ScopedBinding();
+
+    /**@{*/
+    ScopedBinding(const ScopedBinding&) = delete;
+    auto operator=(const ScopedBinding&) -> ScopedBinding& = delete;
+    ScopedBinding(ScopedBinding&&) = delete;
+    auto operator=(ScopedBinding&&) -> ScopedBinding& = delete;
+    /**@}*/
+
+    /** @brief Whether the thread was bound */
+    [[nodiscard]] auto bound() const -> bool { return bound_; }
+
+private:
+    /** Whether the thread was bound */
+    bool bound_{false};
+    /** Previous CPU affinity mask */
+    std::vector<unsigned char> previous_;
+};
+}  // namespace numa
+}  // namespace volcart
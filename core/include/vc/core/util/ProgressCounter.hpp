@@ -0,0 +1,121 @@
+#pragma once
+
+/** @file */
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+
+namespace volcart
+{
+
+/**
+ * @brief Thread-safe, rate-limited progress counter
+ *
+ * Worker threads record completed items with add(), which is a single
+ * relaxed atomic increment. A consumer samples the count and reports it at
+ * most once per reporting interval by checking shouldReport(). This keeps
+ * the cost of progress reporting independent of the number of items, so
+ * loops can count every item without emitting a Signal for each one.
+ *
+ * The counter also tracks the elapsed time since it was started, from which
+ * it derives the throughput and the estimated time remaining.
+ *
+ * Example Usage:
+ * @code{.cpp}
+ * ProgressCounter progress(n);
+ * ParallelFor(range(n), [&](auto i) {
+ *     process(i);
+ *     progress.add();
+ * });
+ *
+ * // Elsewhere, e.g. on the calling thread
+ * if (progress.shouldReport()) {
+ *     progressUpdated(progress.count());
+ * }
+ * @endcode
+ *
+ * @ingroup Util
+ */
+class ProgressCounter
+{
+public:
+    /** Clock type */
+    using Clock = std::chrono::steady_clock;
+
+    /** Default minimum time between reports */
+    static constexpr std::chrono::milliseconds DEFAULT_INTERVAL{100};
+
+    /**
+     * @brief Construct and start a counter
+     *
+     * @param total Expected number of items
+     * @param interval Minimum time between reports
+     */
+    explicit ProgressCounter(
+        std::size_t total = 0, Clock::duration interval = DEFAULT_INTERVAL);
+
+    /**
+     * @brief Restart the counter
+     *
+     * Not thread-safe. Must not be called while other threads use the
+     * counter.
+     */
+    void reset(std::size_t total);
+
+    /** @brief Record `n` completed items */
+    void add(std::size_t n = 1) noexcept
+    {
+        count_.fetch_add(n, std::memory_order_relaxed);
+    }
+
+    /** @brief Set the number of completed items */
+    void set(std::size_t n) noexcept
+    {
+        count_.store(n, std::memory_order_relaxed);
+    }
+
+    /** @brief Get the number of completed items */
+    [[nodiscard]] auto count() const noexcept -> std::size_t
+    {
+        return count_.load(std::memory_order_relaxed);
+    }
+
+    /** @brief Get the expected number of items */
+    [[nodiscard]] auto total() const noexcept -> std::size_t { return total_; }
+
+    /**
+     * @brief Whether the progress should be reported now
+     *
+     * Returns true at most once per reporting interval, across all threads.
+     * The first call after construction or reset() returns true.
+     */
+    auto shouldReport() noexcept -> bool;
+
+    /** @brief Seconds since the counter was started */
+    [[nodiscard]] auto elapsed() const -> double;
+
+    /** @brief Average number of items completed per second */
+    [[nodiscard]] auto rate() const -> double;
+
+    /**
+     * @brief Estimated seconds until total() items are completed
+     *
+     * Returns infinity if no items have been completed yet.
+     */
+    [[nodiscard]] auto remaining() const -> double;
+
+private:
+    /** Number of completed items */
+    std::atomic<std::size_t> count_{0};
+    /** Expected number of items */
+    std::size_t total_{0};
+    /** Minimum time between reports */
+    Clock::duration interval_;
+    /** Start time */
+    Clock::time_point start_;
+    /** Earliest time of the next report, in Clock ticks */
+    std::atomic<Clock::rep> nextReport_{0};
+};
+
+}  // namespace volcart
@@ -0,0 +1,263 @@
+#pragma once
+
+/** @file */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "vc/core/util/Iteration.hpp"
+
+namespace volcart
+{
+
+/**
+ * @brief Persistent, work-stealing pool of worker threads
+ *
+ * Each worker owns a task queue. Tasks submitted from a worker are pushed to
+ * the front of that worker's queue and run last-in, first-out, while tasks
+ * submitted from other threads are distributed round-robin across the
+ * queues. Idle workers steal from the back of the other queues, so uneven
+ * tasks are balanced across threads without any central scheduling.
+ *
+ * Use wait() rather than `std::future::get()` to wait on tasks from inside a
+ * task. wait() runs queued tasks while the result is not ready, so nested
+ * parallel work cannot deadlock the pool.
+ *
+ * Global() returns a pool shared by the whole library, so that parallel
+ * algorithms share cores rather than each creating their own threads.
+ *
+ * Example Usage:
+ * @code{.cpp}
+ * auto& pool = ThreadPool::Global();
+ * auto result = pool.submit([]() { return 1 + 1; });
+ * std::cout << pool.wait(result) << std::endl; // prints "2"
+ * @endcode
+ *
+ * @ingroup Util
+ */
+class ThreadPool
+{
+public:
+    /**
+     * @brief Construct a pool with the given number of worker threads
+     *
+     * If `numThreads == 0` (default), uses
+     * `std::thread::hardware_concurrency()`.
+     */
+    explicit ThreadPool(std::size_t numThreads = 0);
+
+    /** @brief Run all queued tasks, then stop the worker threads */
+    ~ThreadPool();
+
+    /**@{*/
+    ThreadPool(const ThreadPool&) = delete;
+    auto operator=(const ThreadPool&) -> ThreadPool& = delete;
+    ThreadPool(ThreadPool&&) = delete;
+    auto operator=(ThreadPool&&) -> ThreadPool& = delete;
+    /**@}*/
+
+    /**
+     * @brief Get the library-wide thread pool
+     *
+     * The pool is started on first use with the number of threads set by
+     * SetGlobalThreads().
+     */
+    static auto Global() -> ThreadPool&;
+
+    /**
+     * @brief Set the number of threads in the library-wide thread pool
+     *
+     * Applications call this once, e.g. from a `--threads` option, before any
+     * parallel work is started. If `numThreads == 0` (default), uses
+     * `std::thread::hardware_concurrency()`.
+     *
+     * @throws std::logic_error if the global pool has already been started
+     * with a different number of threads
+     */
+    static void SetGlobalThreads(std::size_t numThreads);
+
+    /** @brief Get the number of worker threads */
+    [[nodiscard]] auto numThreads() const -> std::size_t;
+
+    /**
+     * @brief Queue a task for execution
+     *
+     * Returns a future for the task's result. Exceptions thrown by the task
+     * are rethrown when the result is retrieved.
+     */
+    template <class F>
+    auto submit(F&& f) -> std::future<std::invoke_result_t<std::decay_t<F>>>
+    {
+        using R = std::invoke_result_t<std::decay_t<F>>;
+        auto task = std::make_shared<std::packaged_task<R()>>(
+            std::forward<F>(f));
+        auto result = task->get_future();
+        push_([task]() { (*task)(); });
+        return result;
+    }
+
+    /**
+     * @brief Wait for a task's result, running queued tasks in the meantime
+     *
+     * Safe to call from inside a task.
+     */
+    template <class T>
+    auto wait(std::future<T>& f) -> T
+    {
+        using namespace std::chrono_literals;
+        while (f.wait_for(0s) != std::future_status::ready) {
+            if (not runPendingTask()) {
+                f.wait_for(1ms);
+            }
+        }
+        return f.get();
+    }
+
+    /**
+     * @brief Run one queued task on the calling thread
+     *
+     * Returns false if there were no queued tasks.
+     */
+    auto runPendingTask() -> bool;
+
+private:
+    /** Type-erased task */
+    using Task = std::function<void()>;
+
+    /** Per-worker task queue */
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    /** Add a task to a queue and wake a worker */
+    void push_(Task task);
+    /** Pop a task, preferring queue `idx` and stealing from the others */
+    auto pop_(std::size_t idx, Task& task) -> bool;
+    /** Worker thread loop */
+    void worker_(std::size_t idx);
+
+    /** Task queues. One per worker. */
+    std::vector<std::unique_ptr<Queue>> queues_;
+    /** Worker threads */
+    std::vector<std::thread> threads_;
+    /** Guards sleeping and waking workers */
+    std::mutex mutex_;
+    /** Signals that tasks are available or the pool is stopping */
+    std::condition_variable cv_;
+    /** Number of queued tasks */
+    std::atomic<std::size_t> pending_{0};
+    /** Next queue for tasks submitted from outside the pool */
+    std::atomic<std::size_t> nextQueue_{0};
+    /** Stop when all queued tasks have run */
+    bool stop_{false};
+};
+
+/**
+ * @brief Split `[0, n)` into contiguous chunks and process them in parallel
+ *
+ * Calls `f(begin, end)` once per chunk on the global ThreadPool and waits for
+ * every chunk to finish. If any chunk throws, the first exception is
+ * rethrown after all chunks have finished.
+ *
+ * @param n Number of items
+ * @param numThreads Number of threads to split the work between. If `0`,
+ * uses every thread in the global ThreadPool.
+ * @param f Callable with the signature `void(std::size_t, std::size_t)`
+ */
+template <class F>
+void ParallelChunks(std::size_t n, std::size_t numThreads, F&& f)
+{
+    auto& pool = ThreadPool::Global();
+    if (numThreads == 0) {
+        numThreads = pool.numThreads();
+    }
+
+    // A few chunks per thread so that uneven chunks are balanced
+    const auto numChunks = std::min(n, 4 * numThreads);
+    std::vector<std::future<void>> results;
+    results.reserve(numChunks);
+    for (std::size_t c = 0; c < numChunks; ++c) {
+        const auto begin = n * c / numChunks;
+        const auto end = n * (c + 1) / numChunks;
+        results.emplace_back(
+            pool.submit([&f, begin, end]() { f(begin, end); }));
+    }
+
+    std::exception_ptr error;
+    for (auto& r : results) {
+        try {
+            pool.wait(r);
+        } catch (...) {
+            if (not error) {
+                error = std::current_exception();
+            }
+        }
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+/**
+ * @brief Call `f(i)` for every value `i` of a range in parallel
+ *
+ * The range is split into contiguous chunks with ParallelChunks(). `f` must
+ * be safe to call concurrently for different values.
+ *
+ * Example Usage:
+ * @code{.cpp}
+ * std::vector<double> out(100);
+ * ParallelFor(range(100), [&out](auto i) { out[i] = std::sqrt(i); });
+ * @endcode
+ *
+ * @param r Range of values
+ * @param f Callable with the signature `void(T)`
+ * @param numThreads Number of threads to split the work between. If `0`,
+ * uses every thread in the global ThreadPool.
+ */
+template <typename T, class F>
+void ParallelFor(const RangeIterable<T>& r, F&& f, std::size_t numThreads = 0)
+{
+    ParallelChunks(r.size(), numThreads, [&r, &f](auto begin, auto end) {
+        for (auto i = begin; i < end; ++i) {
+            f(r[i]);
+        }
+    });
+}
+
+/**
+ * @brief Call `f(v, u)` for every pair of a 2D range in parallel
+ *
+ * @copydetails ParallelFor(const RangeIterable<T>&, F&&, std::size_t)
+ *
+ * @param r Range of (v, u) pairs
+ * @param f Callable with the signature `void(T, T)`
+ * @param numThreads Number of threads to split the work between. If `0`,
+ * uses every thread in the global ThreadPool.
+ */
+template <typename T, class F>
+void ParallelFor(
+    const Range2DIterable<T>& r, F&& f, std::size_t numThreads = 0)
+{
+    ParallelChunks(r.size(), numThreads, [&r, &f](auto begin, auto end) {
+        for (auto i = begin; i < end; ++i) {
+            auto [v, u] = r[i];
+            f(v, u);
+        }
+    });
+}
+
+}  // namespace volcart
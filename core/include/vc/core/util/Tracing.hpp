@@ -0,0 +1,119 @@
+#pragma once
+
+/**
+ * @file Tracing.hpp
+ *
+ * @ingroup Util
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+#include "vc/core/filesystem.hpp"
+
+/**
+ * @namespace volcart::tracing
+ * @brief Scoped timing spans exportable to the Chrome trace-event format
+ *
+ * Spans are recorded with the VC_TRACE_SPAN macros, which compile to nothing
+ * when the library is built without `VC_WITH_TRACING`. Recording is off by
+ * default. When it is off, a span costs a single atomic load.
+ *
+ * Each thread records its spans into its own buffer, so recording does not
+ * serialize worker threads. WriteChromeTrace() writes the recorded spans as
+ * Chrome trace-event JSON, which can be opened in `chrome://tracing` or
+ * Perfetto (https://ui.perfetto.dev).
+ *
+ * Example Usage:
+ * @code{.cpp}
+ * tracing::SetEnabled(true);
+ * {
+ *     VC_TRACE_SPAN("Load slice");
+ *     volume->getSliceData(0);
+ * }
+ * tracing::WriteChromeTrace("trace.json");
+ * @endcode
+ */
+namespace volcart::tracing
+{
+/** @brief Enable or disable span recording */
+void SetEnabled(bool enabled);
+
+/** @brief Whether spans are being recorded */
+auto Enabled() noexcept -> bool;
+
+/** @brief Discard all recorded spans */
+void Clear();
+
+/** @brief Number of recorded spans */
+auto NumSpans() -> std::size_t;
+
+/**
+ * @brief Write the recorded spans as Chrome trace-event JSON
+ *
+ * @throws volcart::IOException if the file cannot be written
+ */
+void WriteChromeTrace(const filesystem::path& path);
+
+/**
+ * @brief Records the time between its construction and destruction
+ *
+ * Prefer the VC_TRACE_SPAN macros, which can be compiled out.
+ */
+class Span
+{
+public:
+    /**
+     * @brief Start a span
+     *
+     * @param name Span name. Copied only if recording is enabled.
+     * @param category Span category. Must be a string literal.
+     */
+    explicit Span(const char* name, const char* category = "vc");
+
+    /** @copydoc Span(const char*, const char*) */
+    explicit Span(std::string name, const char* category = "vc");
+
+    /** @brief Finish the span and record it */
+    ~Span();
+
+    /**@{*/
+    Span(const Span&) = delete;
+    auto operator=(const Span&) -> Span& = delete;
+    Span(Span&&) = delete;
+    auto operator=(Span&&) -> Span& = delete;
+    /**@}*/
+
+private:
+    /** Span name */
+    std::string name_;
+    /** Span category */
+    const char* category_;
+    /** Start time, or the epoch if recording was disabled */
+    std::chrono::steady_clock::time_point start_;
+};
+}  // namespace volcart::tracing
+
+/** @cond */
+#define VC_TRACE_CONCAT_(a, b) a##b
+#define VC_TRACE_CONCAT(a, b) VC_TRACE_CONCAT_(a, b)
+/** @endcond */
+
+#ifdef VC_WITH_TRACING
+/** @brief Record a tracing span until the end of the enclosing scope */
+#define VC_TRACE_SPAN(name)                                                    \
+    const volcart::tracing::Span VC_TRACE_CONCAT(vcTraceSpan, __LINE__)        \
+    {                                                                          \
+        name                                                                   \
+    }
+/** @brief Record a tracing span with a category */
+#define VC_TRACE_SPAN_CAT(category, name)                                      \
+    const volcart::tracing::Span VC_TRACE_CONCAT(vcTraceSpan, __LINE__)        \
+    {                                                                          \
+        name, category                                                         \
+    }
+#else
+#define VC_TRACE_SPAN(name) static_cast<void>(0)
+#define VC_TRACE_SPAN_CAT(category, name) static_cast<void>(0)
+#endif
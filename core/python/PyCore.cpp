@@ -2,6 +2,7 @@
 
 namespace py = pybind11;
 
+void init_PatchSampler(py::module&);
 void init_PerPixelMap(py::module&);
 void init_Reslice(py::module&);
 void init_Volume(py::module&);
@@ -12,6 +13,7 @@ PYBIND11_MODULE(Core, m)
     m.doc() = "Library containing fundamental VC data types and operations.";
 
     // init types
+    init_PatchSampler(m);
     init_PerPixelMap(m);
     init_Reslice(m);
     init_Volume(m);
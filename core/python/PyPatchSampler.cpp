@@ -0,0 +1,132 @@
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <vector>
+
+#include <pybind11/numpy.h>
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+
+#include "vc/core/neighborhood/PatchSampler.hpp"
+#include "vc/python/PyArrayView.hpp"
+#include "vc/python/PyCVVecCaster.hpp"
+
+namespace py = pybind11;
+namespace vc = volcart;
+namespace vcpy = volcart::python;
+
+void init_PatchSampler(py::module& m);
+
+void init_PatchSampler(py::module& m)
+{
+    using Order = vc::PatchSampler::Order;
+
+    /** Class */
+    py::class_<vc::PatchSampler> c(m, "PatchSampler");
+    c.doc() =
+        "Samples a large list of axis-aligned or oriented subvolumes from a "
+        "Volume in batches. Requests are bucketed into z-slabs and sampled "
+        "in Z-order within each slab, and upcoming batches are sampled on "
+        "background threads while the current batch is being consumed. "
+        "Iterating yields (indices, patches) tuples, where indices holds the "
+        "request index of each patch and patches has shape "
+        "(N, ...) of the subvolumes returned by Volume.subvolume().";
+
+    py::enum_<Order>(c, "Order")
+        .value(
+            "Requested", Order::Requested,
+            "Batches contain the requests in their original order")
+        .value(
+            "Locality", Order::Locality,
+            "Batches contain the requests in z-slab and Z-order");
+
+    /** Constructors */
+    c.def(
+        py::init([](vc::Volume::Pointer v,
+                    py::array_t<double, py::array::c_style |
+                                            py::array::forcecast> centers,
+                    int rx, int ry, int rz, cv::Vec3d xvec, cv::Vec3d yvec,
+                    cv::Vec3d zvec, std::size_t batchSize, Order order,
+                    std::size_t slabDepth, std::size_t prefetchBatches,
+                    std::size_t threads) {
+            if (centers.ndim() != 2 or centers.shape(1) != 3) {
+                throw std::invalid_argument("centers must have shape (N, 3)");
+            }
+            vc::CuboidGenerator gen;
+            gen.setSamplingRadius(rx, ry, rz);
+            auto s = std::make_unique<vc::PatchSampler>(
+                std::move(v), gen, std::vector<cv::Vec3d>{xvec, yvec, zvec});
+            const auto* in =
+                reinterpret_cast<const cv::Vec3d*>(centers.data());
+            s->setCenters({in, in + centers.shape(0)});
+            s->setBatchSize(batchSize);
+            s->setOrder(order);
+            s->setSlabDepth(slabDepth);
+            s->setPrefetchBatches(prefetchBatches);
+            s->setNumThreads(threads);
+            return s;
+        }),
+        // clang-format off
+        py::arg("volume"),
+        py::arg("centers"),
+        py::arg("x_rad"),
+        py::arg("y_rad"),
+        py::arg("z_rad"),
+        py::arg_v("x_vec", cv::Vec3d{1, 0, 0}, "(1, 0, 0)"),
+        py::arg_v("y_vec", cv::Vec3d{0, 1, 0}, "(0, 1, 0)"),
+        py::arg_v("z_vec", cv::Vec3d{0, 0, 1}, "(0, 0, 1)"),
+        py::arg("batch_size") = 32,
+        py::arg("order") = Order::Requested,
+        py::arg("slab_depth") = vc::PatchSampler::DEFAULT_SLAB_DEPTH,
+        py::arg("prefetch_batches") = 4,
+        py::arg("threads") = 0,
+        "Create a sampler for subvolumes at an array of center points with "
+        "shape (N, 3). prefetch_batches batches are sampled together, and "
+        "with Order.Requested only the requests within each group are "
+        "reordered.");
+    // clang-format on
+
+    /** Properties */
+    c.def(
+        "__len__", &vc::PatchSampler::numBatches, "The number of batches");
+    c.def(
+        "batchSize", &vc::PatchSampler::batchSize,
+        "The number of patches in a batch");
+    c.def(
+        "patchShape", &vc::PatchSampler::patchExtent,
+        "The shape of a single patch");
+
+    /** Iteration */
+    c.def(
+        "__iter__",
+        [](vc::PatchSampler& s) -> vc::PatchSampler& {
+            s.reset();
+            return s;
+        },
+        py::return_value_policy::reference_internal,
+        "Restart sampling at the first batch");
+    c.def(
+        "__next__",
+        [](vc::PatchSampler& s) {
+            std::optional<vc::PatchSampler::Batch> batch;
+            {
+                py::gil_scoped_release release;
+                batch = s.next();
+            }
+            if (not batch) {
+                throw py::stop_iteration();
+            }
+            auto n = static_cast<ssize_t>(batch->indices.size());
+            std::vector<ssize_t> shape{n};
+            for (auto e : s.patchExtent()) {
+                shape.push_back(static_cast<ssize_t>(e));
+            }
+            auto indices = vcpy::MoveToArray<std::size_t>(
+                std::move(batch->indices), {n});
+            auto patches = vcpy::MoveToArray<uint16_t>(
+                std::move(batch->patches), shape);
+            return py::make_tuple(indices, patches);
+        },
+        "Get the next batch as an (indices, patches) tuple. Releases the GIL "
+        "while waiting for the batch.");
+}
@@ -1,12 +1,65 @@
+#include <algorithm>
+#include <memory>
 #include <tuple>
+#include <vector>
 
+#include <pybind11/numpy.h>
 #include <pybind11/pybind11.h>
 
 #include "vc/core/types/PerPixelMap.hpp"
+#include "vc/core/util/Iteration.hpp"
+#include "vc/core/util/ThreadPool.hpp"
+#include "vc/python/PyArrayView.hpp"
 #include "vc/python/PyCVVecCaster.hpp"
 
 namespace py = pybind11;
 namespace vc = volcart;
+namespace vcpy = volcart::python;
+
+using PPM = vc::PerPixelMap;
+
+// Wrap the shared storage in a read-only array which keeps it alive
+template <typename T>
+static auto SharedView(
+    std::shared_ptr<const T> ptr, std::vector<ssize_t> shape) -> py::array
+{
+    auto* owner = new std::shared_ptr<const T>(std::move(ptr));
+    py::capsule base(owner, [](void* p) {
+        delete reinterpret_cast<std::shared_ptr<const T>*>(p);
+    });
+    py::array_t<T> a(std::move(shape), owner->get(), base);
+    a.attr("setflags")(py::arg("write") = false);
+    return std::move(a);
+}
+
+// Every mapping as a (height, width, 6) array
+static auto MappingsArray(const py::object& self) -> py::array
+{
+    const auto& p = self.cast<const PPM&>();
+    std::vector<ssize_t> shape{
+        static_cast<ssize_t>(p.height()), static_cast<ssize_t>(p.width()), 6};
+
+    // In-memory maps are viewed directly and kept alive by the PPM object
+    if (const auto* data = p.data()) {
+        py::array_t<double> a(
+            shape, reinterpret_cast<const double*>(data), self);
+        a.attr("setflags")(py::arg("write") = false);
+        return std::move(a);
+    }
+
+    // Memory-mapped maps are expanded in bulk
+    py::array_t<double> a(shape);
+    auto* out = reinterpret_cast<cv::Vec6d*>(a.mutable_data());
+    {
+        py::gil_scoped_release release;
+        vc::ParallelFor(vc::range(p.height()), [&](auto y) {
+            for (size_t x = 0; x < p.width(); ++x) {
+                out[y * p.width() + x] = p.getMapping(y, x);
+            }
+        });
+    }
+    return std::move(a);
+}
 
 void init_PerPixelMap(py::module&);
 
@@ -25,18 +78,125 @@ void init_PerPixelMap(py::module& m)
     /** Element Access */
     c.def(
         "__getitem__",
-        [](vc::PerPixelMap& p, std::tuple<size_t, size_t> pos) {
+        [](const vc::PerPixelMap& p, std::tuple<size_t, size_t> pos) {
             return p(std::get<0>(pos), std::get<1>(pos));
         },
         py::arg("pos[y, x]"), "Get the mapping for a pixel by coordinate");
     c.def(
-        "get", py::overload_cast<size_t, size_t>(&vc::PerPixelMap::operator()),
+        "get",
+        py::overload_cast<size_t, size_t>(
+            &vc::PerPixelMap::operator(), py::const_),
         py::arg("y"), py::arg("x"),
         "Get the mapping for a pixel by coordinate");
     c.def(
         "hasMapping", &vc::PerPixelMap::hasMapping, py::arg("y"), py::arg("x"),
         "Return whether a pixel has a mapping");
 
+    /** Bulk Access */
+    c.def(
+        "memoryMapped", &vc::PerPixelMap::memoryMapped,
+        "Return whether the map is backed by a memory-mapped file");
+    c.def(
+        "mappings", &MappingsArray,
+        "Get the mapping of every pixel as a read-only (height, width, 6) "
+        "array of {x, y, z, nx, ny, nz}. In-memory maps are viewed without "
+        "copying. Memory-mapped maps are expanded into a new array.");
+    c.def(
+        "positions",
+        [](const py::object& self) -> py::object {
+            return MappingsArray(self)[py::make_tuple(
+                py::ellipsis(), py::slice(0, 3, 1))];
+        },
+        "Get the position of every pixel as a view of mappings()");
+    c.def(
+        "normals",
+        [](const py::object& self) -> py::object {
+            return MappingsArray(self)[py::make_tuple(
+                py::ellipsis(), py::slice(3, 6, 1))];
+        },
+        "Get the surface normal of every pixel as a view of mappings()");
+    c.def(
+        "mask",
+        [](const vc::PerPixelMap& p) {
+            auto mask = p.mask();
+            if (mask.empty()) {
+                mask = cv::Mat(
+                    static_cast<int>(p.height()), static_cast<int>(p.width()),
+                    CV_8UC1, cv::Scalar(255));
+            }
+            return vcpy::MatView(mask);
+        },
+        "Get a read-only view of the pixel mask. Mapped pixels are 255.");
+    c.def(
+        "cellMap",
+        [](const vc::PerPixelMap& p) -> py::object {
+            auto cellMap = p.cellMap();
+            if (cellMap.empty()) {
+                return py::none();
+            }
+            return vcpy::MatView(cellMap);
+        },
+        "Get a read-only view of the face index of each pixel, or None if "
+        "the map has no cell map");
+    c.def(
+        "compactData",
+        [](const vc::PerPixelMap& p) {
+            auto data = p.compactData();
+            auto index = SharedView(
+                data.index, {static_cast<ssize_t>(p.height()),
+                             static_cast<ssize_t>(p.width())});
+            auto records = SharedView(
+                data.records,
+                {static_cast<ssize_t>(data.count),
+                 static_cast<ssize_t>(PPM::CompactData::RECORD_DIMS)});
+            return py::make_tuple(index, records);
+        },
+        "Get read-only views of the storage of a memory-mapped map without "
+        "copying: a (height, width) array of record numbers and a (count, 6) "
+        "float32 array of records. Unmapped pixels have the record number "
+        "0xFFFFFFFF. The views remain valid after the map is destroyed.");
+    c.def(
+        "mappingIndices",
+        [](const vc::PerPixelMap& p, bool sliceOrder) {
+            std::vector<PPM::PixelIndex> indices;
+            {
+                py::gil_scoped_release release;
+                indices = p.getMappingIndices(
+                    sliceOrder ? PPM::MappingOrder::Slice
+                               : PPM::MappingOrder::Raster);
+            }
+            auto n = static_cast<ssize_t>(indices.size());
+            return vcpy::MoveToArray<PPM::PixelIndex>(std::move(indices), {n});
+        },
+        py::arg("slice_order") = false,
+        "Get the linear indices (y * width + x) of every mapped pixel. If "
+        "slice_order is True, the pixels are grouped by Volume slice.");
+    c.def(
+        "mappingValues",
+        [](const vc::PerPixelMap& p,
+           py::array_t<PPM::PixelIndex, py::array::c_style |
+                                            py::array::forcecast> indices) {
+            const auto* in = indices.data();
+            std::vector<PPM::PixelIndex> idx(in, in + indices.size());
+            for (const auto& i : idx) {
+                if (i >= p.width() * p.height()) {
+                    throw py::index_error("pixel index out of range");
+                }
+            }
+            py::array_t<double> out({static_cast<ssize_t>(idx.size()), 6});
+            {
+                py::gil_scoped_release release;
+                auto values = p.getMappingValues(idx);
+                std::copy(
+                    values.begin(), values.end(),
+                    reinterpret_cast<cv::Vec6d*>(out.mutable_data()));
+            }
+            return out;
+        },
+        py::arg("indices"),
+        "Get the mappings of an array of linear pixel indices as an (n, 6) "
+        "array. Releases the GIL while gathering.");
+
     /** IO */
     // Note: Defined in the module, not the class
     m.def(
@@ -1,11 +1,13 @@
 #include <pybind11/pybind11.h>
 
 #include "vc/core/types/Reslice.hpp"
+#include "vc/python/PyArrayView.hpp"
 #include "vc/python/PyCVMatCaster.hpp"
 #include "vc/python/PyCVVecCaster.hpp"
 
 namespace py = pybind11;
 namespace vc = volcart;
+namespace vcpy = volcart::python;
 
 void init_Reslice(py::module&);
 
@@ -26,4 +28,9 @@ void init_Reslice(py::module& m)
 
     /** Image */
     c.def("data", &vc::Reslice::sliceData, "Get the Reslice image data");
+    c.def(
+        "dataView",
+        [](const vc::Reslice& r) { return vcpy::MatView(r.sliceData()); },
+        "Get a read-only view of the Reslice image data. The returned array "
+        "shares memory with the Reslice and is not copied.");
 }
@@ -1,12 +1,17 @@
+#include <pybind11/numpy.h>
 #include <pybind11/pybind11.h>
 
 #include "vc/core/neighborhood/CuboidGenerator.hpp"
 #include "vc/core/types/Volume.hpp"
+#include "vc/core/util/Iteration.hpp"
+#include "vc/core/util/ThreadPool.hpp"
+#include "vc/python/PyArrayView.hpp"
 #include "vc/python/PyCVMatCaster.hpp"
 #include "vc/python/PyCVVecCaster.hpp"
 
 namespace py = pybind11;
 namespace vc = volcart;
+namespace vcpy = volcart::python;
 
 void init_Volume(py::module& m);
 
@@ -49,11 +54,35 @@ void init_Volume(py::module& m)
     c.def(
         "setCacheMemory", &vc::Volume::setCacheMemoryInBytes, py::arg("bytes"),
         "Set the maximum cache size in bytes");
+    c.def(
+        "getCacheMemory", &vc::Volume::getCacheMemoryInBytes,
+        "Get the current cache size in bytes");
+
+    c.def(
+        "setPrefetching", &vc::Volume::setPrefetching, py::arg("ahead"),
+        py::arg("behind") = 0, py::arg("threads") = 1,
+        "Enable asynchronous prefetching of neighboring slices");
+    c.def(
+        "disablePrefetching", &vc::Volume::disablePrefetching,
+        "Disable asynchronous slice prefetching");
 
     /** Slice Data */
     c.def(
         "slice", &vc::Volume::getSliceData, py::arg("z"),
         "Get a slice image by index");
+    c.def(
+        "sliceView",
+        [](const vc::Volume& v, int z) {
+            cv::Mat slice;
+            {
+                py::gil_scoped_release release;
+                slice = v.getSliceData(z);
+            }
+            return vcpy::MatView(slice);
+        },
+        py::arg("z"),
+        "Get a read-only view of a slice image by index. The returned array "
+        "shares memory with the slice cache and is not copied.");
 
     /** Voxel Data */
     c.def(
@@ -67,6 +96,30 @@ void init_Volume(py::module& m)
             &vc::Volume::interpolateAt, py::const_),
         "Get the interpolated intensity at a subvoxel position",
         py::arg_v("pos", "(x, y, z)"));
+    c.def(
+        "interpolate",
+        [](const vc::Volume& v,
+           py::array_t<double, py::array::c_style | py::array::forcecast>
+               pts) {
+            if (pts.ndim() < 1 or pts.shape(pts.ndim() - 1) != 3) {
+                throw std::invalid_argument("points must have shape (..., 3)");
+            }
+            std::vector<ssize_t> shape(
+                pts.shape(), pts.shape() + pts.ndim() - 1);
+            py::array_t<uint16_t> out(shape);
+            auto n = static_cast<size_t>(out.size());
+            const auto* in = reinterpret_cast<const cv::Vec3d*>(pts.data());
+            auto* outPtr = out.mutable_data();
+            {
+                py::gil_scoped_release release;
+                v.interpolateAt(in, n, outPtr);
+            }
+            return out;
+        },
+        py::arg("points"),
+        "Get the interpolated intensities at an array of subvoxel positions "
+        "with shape (..., 3). Returns an array with the shape of the leading "
+        "dimensions. Releases the GIL while sampling.");
 
     /** Reslices and Subvolumes */
     c.def(
@@ -77,7 +130,9 @@ void init_Volume(py::module& m)
         py::arg_v("y_vec", cv::Vec3d{0, 1, 0}, "(0, 1, 0)"),
         py::arg("width") = 64,
         py::arg("height") = 64,
-        "Generate an arbitrarily-oriented reslice image");
+        py::call_guard<py::gil_scoped_release>(),
+        "Generate an arbitrarily-oriented reslice image. Releases the GIL "
+        "while sampling.");
     // clang-format on
 
     c.def(
@@ -86,18 +141,15 @@ void init_Volume(py::module& m)
            cv::Vec3d xvec, cv::Vec3d yvec, cv::Vec3d zvec) {
             vc::CuboidGenerator subvolume;
             subvolume.setSamplingRadius(rx, ry, rz);
-            auto s = subvolume.compute(
-                v.shared_from_this(), center, {xvec, yvec, zvec});
-            auto buf = s.as_vector();
-            size_t size = sizeof(uint16_t);
-            std::string format = py::format_descriptor<uint16_t>::format();
-            auto extents = s.extents();
-            std::vector<size_t> strides{
-                size * extents[1] * extents[0], size * extents[0], size};
-            return py::array(py::buffer_info{
-                                 buf.data(), static_cast<ssize_t>(size), format,
-                                 3, extents, strides})
-                .release();
+            vc::Neighborhood s(3);
+            {
+                py::gil_scoped_release release;
+                s = subvolume.compute(
+                    v.shared_from_this(), center, {xvec, yvec, zvec});
+            }
+            auto e = s.extents();
+            std::vector<ssize_t> shape(e.begin(), e.end());
+            return vcpy::MoveToArray<uint16_t>(std::move(s), shape);
         },
         // clang-format off
         py::arg_v("center", "(x, y, z)"),
@@ -107,6 +159,54 @@ void init_Volume(py::module& m)
         py::arg_v("x_vec", cv::Vec3d{1, 0, 0}, "(1, 0, 0)"),
         py::arg_v("y_vec", cv::Vec3d{0, 1, 0}, "(0, 1, 0)"),
         py::arg_v("z_vec", cv::Vec3d{0, 0, 1}, "(0, 0, 1)"),
-        "Generate an arbitrarily-oriented subvolume");
+        "Generate an arbitrarily-oriented subvolume. Releases the GIL while "
+        "sampling.");
+    // clang-format on
+
+    c.def(
+        "subvolumes",
+        [](vc::Volume& v,
+           py::array_t<double, py::array::c_style | py::array::forcecast>
+               centers,
+           int rx, int ry, int rz, cv::Vec3d xvec, cv::Vec3d yvec,
+           cv::Vec3d zvec) {
+            if (centers.ndim() != 2 or centers.shape(1) != 3) {
+                throw std::invalid_argument("centers must have shape (N, 3)");
+            }
+            vc::CuboidGenerator subvolume;
+            subvolume.setSamplingRadius(rx, ry, rz);
+            auto offsets = subvolume.precompute({xvec, yvec, zvec});
+            const auto& e = offsets.extent;
+            auto n = static_cast<size_t>(centers.shape(0));
+            py::array_t<uint16_t> out(std::vector<ssize_t>{
+                static_cast<ssize_t>(n), static_cast<ssize_t>(e[0]),
+                static_cast<ssize_t>(e[1]), static_cast<ssize_t>(e[2])});
+            const auto* in =
+                reinterpret_cast<const cv::Vec3d*>(centers.data());
+            auto* outPtr = out.mutable_data();
+            const auto size = offsets.samples.size();
+            {
+                py::gil_scoped_release release;
+                auto vol = v.shared_from_this();
+                vc::ParallelFor(vc::range(n), [&](auto i) {
+                    subvolume.computeInto(
+                        vol, in[i], offsets, outPtr + i * size);
+                });
+            }
+            return out;
+        },
+        // clang-format off
+        py::arg("centers"),
+        py::arg("x_rad"),
+        py::arg("y_rad"),
+        py::arg("z_rad"),
+        py::arg_v("x_vec", cv::Vec3d{1, 0, 0}, "(1, 0, 0)"),
+        py::arg_v("y_vec", cv::Vec3d{0, 1, 0}, "(0, 1, 0)"),
+        py::arg_v("z_vec", cv::Vec3d{0, 0, 1}, "(0, 0, 1)"),
+        "Generate subvolumes with the same orientation at an array of center "
+        "points with shape (N, 3). Returns an array with shape "
+        "(N, ...) of the subvolumes returned by subvolume(). The sample "
+        "offsets are computed once and the subvolumes are sampled in "
+        "parallel. Releases the GIL while sampling.");
     // clang-format on
 }
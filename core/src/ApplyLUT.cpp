@@ -1,9 +1,13 @@
 #include "vc/core/util/ApplyLUT.hpp"
 
+#include <limits>
+#include <vector>
+
 #include <opencv2/imgproc.hpp>
 
 #include "vc/core/util/ImageConversion.hpp"
 #include "vc/core/util/Iteration.hpp"
+#include "vc/core/util/ThreadPool.hpp"
 
 using namespace volcart;
 namespace vc = volcart;
@@ -31,10 +35,8 @@ static int ValueToBin(float value, float min, float max, int bins)
     return static_cast<int>(bin);
 }
 
-cv::Mat vc::ApplyLUT(
-    const cv::Mat& img, const cv::Mat& lut, float min, float max, bool invert)
+static void ValidateLUT(const cv::Mat& lut)
 {
-    // Validate the LUT
     if (lut.depth() != CV_8U) {
         throw std::invalid_argument("LUT must be 8bpc");
     }
@@ -44,40 +46,106 @@ cv::Mat vc::ApplyLUT(
     if (lut.channels() != 1 and lut.channels() != 3) {
         throw std::invalid_argument("LUT must be gray/RGB");
     }
+}
+
+// Map every pixel of an integer image through a table of the LUT colors of
+// every possible pixel value. Building the table costs one bin calculation per
+// value, so this is only used when the image has at least as many pixels.
+template <typename T, typename Px, class BinFn>
+static void MapIntegral(
+    const cv::Mat& gray, const Px* colors, BinFn&& toBin, cv::Mat& output)
+{
+    std::vector<Px> table(std::size_t{std::numeric_limits<T>::max()} + 1);
+    ParallelFor(range(table.size()), [&](auto v) {
+        table[v] = colors[toBin(static_cast<float>(v))];
+    });
+
+    ParallelChunks(gray.rows, 0, [&](auto begin, auto end) {
+        for (auto y = begin; y < end; ++y) {
+            const auto* in = gray.ptr<T>(static_cast<int>(y));
+            auto* out = output.ptr<Px>(static_cast<int>(y));
+            for (int x = 0; x < gray.cols; ++x) {
+                out[x] = table[in[x]];
+            }
+        }
+    });
+}
+
+// Map every pixel of an image by calculating its bin
+template <typename Px, class BinFn>
+static void MapGeneric(
+    const cv::Mat& gray, const Px* colors, BinFn&& toBin, cv::Mat& output)
+{
+    ParallelChunks(gray.rows, 0, [&](auto begin, auto end) {
+        cv::Mat row;
+        for (auto y = begin; y < end; ++y) {
+            const float* in{nullptr};
+            if (gray.depth() == CV_32F) {
+                in = gray.ptr<float>(static_cast<int>(y));
+            } else {
+                gray.row(static_cast<int>(y)).convertTo(row, CV_32F);
+                in = row.ptr<float>(0);
+            }
+            auto* out = output.ptr<Px>(static_cast<int>(y));
+            for (int x = 0; x < gray.cols; ++x) {
+                out[x] = colors[toBin(in[x])];
+            }
+        }
+    });
+}
 
-    // Convert input img to 32FC1
-    cv::Mat gray;
-    if (img.channels() != 1) {
-        gray = ColorConvertImage(img);
+template <typename Px, class BinFn>
+static void MapPixels(
+    const cv::Mat& gray, const cv::Mat& lut, BinFn&& toBin, cv::Mat& output)
+{
+    const auto* colors = lut.ptr<Px>(0);
+    auto pixels = gray.total();
+    if (gray.depth() == CV_8U and pixels > 1U << 8) {
+        MapIntegral<uint8_t>(gray, colors, toBin, output);
+    } else if (gray.depth() == CV_16U and pixels > 1U << 16) {
+        MapIntegral<uint16_t>(gray, colors, toBin, output);
     } else {
-        gray = img.clone();
+        MapGeneric(gray, colors, toBin, output);
     }
-    gray.convertTo(gray, CV_32F);
+}
 
-    // Construct output image
-    cv::Mat output = cv::Mat::zeros(gray.rows, gray.cols, lut.type());
+// Map an image to the LUT using a function which returns the (non-inverted)
+// bin of a pixel value
+template <class BinFn>
+static auto MapToLUT(
+    const cv::Mat& img, const cv::Mat& lut, bool invert, BinFn&& valueToBin)
+    -> cv::Mat
+{
+    ValidateLUT(lut);
 
-    // Iterate over pixels
-    for (const auto& [y, x] : range2D(gray.rows, gray.cols)) {
-        auto val = gray.at<float>(y, x);
-        auto bin = ValueToBin(val, min, max, lut.cols);
+    // The mapping functions handle any single-channel depth, so only
+    // multi-channel inputs need to be converted first
+    cv::Mat gray = img.channels() != 1 ? ColorConvertImage(img) : img;
 
+    auto toBin = [&](float value) {
+        auto bin = valueToBin(value);
         // Invert bin assignment values
-        if (invert) {
-            bin = lut.cols - 1 - bin;
-        }
+        return invert ? lut.cols - 1 - bin : bin;
+    };
 
-        // Assign to image
-        if (lut.channels() == 1) {
-            output.at<uint8_t>(y, x) = lut.at<uint8_t>(0, bin);
-        } else if (lut.channels() == 3) {
-            output.at<cv::Vec3b>(y, x) = lut.at<cv::Vec3b>(0, bin);
-        }
+    // Construct output image
+    cv::Mat output(gray.rows, gray.cols, lut.type());
+    if (lut.channels() == 1) {
+        MapPixels<uint8_t>(gray, lut, toBin, output);
+    } else {
+        MapPixels<cv::Vec3b>(gray, lut, toBin, output);
     }
-
     return output;
 }
 
+cv::Mat vc::ApplyLUT(
+    const cv::Mat& img, const cv::Mat& lut, float min, float max, bool invert)
+{
+    return MapToLUT(img, lut, invert, [&](float val) {
+        return ValueToBin(val, min, max, lut.cols);
+    });
+}
+
 cv::Mat vc::ApplyLUT(
     const cv::Mat& img,
     const cv::Mat& lut,
@@ -86,54 +154,20 @@ cv::Mat vc::ApplyLUT(
     float max,
     bool invert)
 {
-    // Validate the LUT
-    if (lut.depth() != CV_8U) {
-        throw std::invalid_argument("LUT must be 8bpc");
-    }
-    if (lut.rows != 1) {
-        throw std::invalid_argument("LUT must have shape (1, bins)");
-    }
-    if (lut.channels() != 1 and lut.channels() != 3) {
-        throw std::invalid_argument("LUT must be gray/RGB");
-    }
-
-    // Convert input img to 32FC1
-    cv::Mat gray;
-    if (img.channels() != 1) {
-        gray = ColorConvertImage(img);
-    } else {
-        gray = img.clone();
-    }
-    gray.convertTo(gray, CV_32F);
-
-    // Construct output image
-    cv::Mat output = cv::Mat::zeros(gray.rows, gray.cols, lut.type());
-
     // Mid point bin
     auto midBin = static_cast<int>(std::round(lut.cols / 2));
 
-    // Iterate over pixels
-    for (const auto& [y, x] : range2D(gray.rows, gray.cols)) {
-        auto val = gray.at<float>(y, x);
-        int bin{0};
+    return MapToLUT(img, lut, invert, [&](float val) {
         if (val == mid) {
-            bin = midBin;
-        } else if (val < mid) {
-            bin = ValueToBin(val, min, mid, midBin);
-        } else {
-            bin = ValueToBin(val, mid, max, lut.cols - midBin) + midBin;
+            return midBin;
         }
-
-        // Invert bin assignment values
-        if (invert) {
-            bin = lut.cols - 1 - bin;
+        if (val < mid) {
+            return ValueToBin(val, min, mid, midBin);
         }
+        return ValueToBin(val, mid, max, lut.cols - midBin) + midBin;
+    });
+}
 
-        // Assign to image
-        if (lut.channels() == 1) {
-            output.at<uint8_t>(y, x) = lut.at<uint8_t>(0, bin);
-        } else if (lut.channels() == 3) {
-            output.at<cv::Vec3b>(y, x) = lut.at<cv::Vec3b>(0, bin);
         }
     }
 
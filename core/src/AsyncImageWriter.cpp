@@ -0,0 +1,108 @@
+#include "vc/core/io/AsyncImageWriter.hpp"
+
+#include <algorithm>
+
+#include "vc/core/util/Logging.hpp"
+
+using namespace volcart;
+
+namespace fs = volcart::filesystem;
+
+AsyncImageWriter::AsyncImageWriter(
+    std::size_t numThreads, std::size_t maxBytes)
+    : maxBytes_{maxBytes}
+{
+    if (numThreads == 0) {
+        numThreads = std::max(1U, std::thread::hardware_concurrency());
+    }
+    for (std::size_t i = 0; i < numThreads; i++) {
+        workers_.emplace_back([this]() { run_(); });
+    }
+}
+
+AsyncImageWriter::~AsyncImageWriter()
+{
+    try {
+        flush();
+    } catch (const std::exception& e) {
+        Logger()->error("Failed to write image: {}", e.what());
+    }
+    {
+        const std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    workCv_.notify_all();
+    for (auto& w : workers_) {
+        w.join();
+    }
+}
+
+void AsyncImageWriter::write(
+    const fs::path& path, const cv::Mat& img, WriteImageOpts opts)
+{
+    Job job{path, img, opts, img.total() * img.elemSize()};
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        doneCv_.wait(lock, [&]() {
+            return error_ or queuedBytes_ == 0 or
+                   queuedBytes_ + job.bytes <= maxBytes_;
+        });
+        rethrow_();
+        queuedBytes_ += job.bytes;
+        queue_.emplace_back(std::move(job));
+    }
+    workCv_.notify_one();
+}
+
+void AsyncImageWriter::flush()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    doneCv_.wait(lock, [this]() { return queue_.empty() and busy_ == 0; });
+    rethrow_();
+}
+
+auto AsyncImageWriter::numThreads() const -> std::size_t
+{
+    return workers_.size();
+}
+
+void AsyncImageWriter::rethrow_()
+{
+    if (error_) {
+        auto e = error_;
+        error_ = nullptr;
+        std::rethrow_exception(e);
+    }
+}
+
+void AsyncImageWriter::run_()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        workCv_.wait(lock, [this]() { return stop_ or not queue_.empty(); });
+        if (queue_.empty()) {
+            return;
+        }
+        auto job = std::move(queue_.front());
+        queue_.pop_front();
+        busy_++;
+
+        // Encode without holding the lock
+        lock.unlock();
+        std::exception_ptr error;
+        try {
+            WriteImage(job.path, job.img, job.opts);
+        } catch (...) {
+            error = std::current_exception();
+        }
+        job.img.release();
+        lock.lock();
+
+        busy_--;
+        queuedBytes_ -= job.bytes;
+        if (error and not error_) {
+            error_ = error;
+        }
+        doneCv_.notify_all();
+    }
+}
@@ -0,0 +1,588 @@
+#include "vc/core/io/AsyncReader.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include "vc/core/types/Exceptions.hpp"
+#include "vc/core/util/Logging.hpp"
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#define VC_HAS_IO_URING
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdint>
+#endif
+
+using namespace volcart;
+using namespace volcart::io;
+
+namespace fs = volcart::filesystem;
+
+namespace
+{
+// Read a whole file with blocking calls
+auto ReadFile(const fs::path& path) -> AsyncReader::Result
+{
+    std::ifstream file(path.string(), std::ios::binary | std::ios::ate);
+    if (not file) {
+        if (not fs::exists(path)) {
+            return std::nullopt;
+        }
+        throw IOException("Failed to open file: " + path.string());
+    }
+
+    // Directories can be opened, but not read
+    if (fs::is_directory(path)) {
+        throw IOException("Failed to read file: " + path.string());
+    }
+
+    std::vector<char> data(static_cast<std::size_t>(file.tellg()));
+    file.seekg(0);
+    file.read(data.data(), static_cast<std::streamsize>(data.size()));
+    if (not file) {
+        throw IOException("Failed to read file: " + path.string());
+    }
+    return data;
+}
+}  // namespace
+
+#ifdef VC_HAS_IO_URING
+// Opens, measures and reads files with io_uring. Each read is a small state
+// machine which has one operation in flight at a time, so a ring with one
+// entry per read, plus one for the wake-up eventfd, can never overflow.
+class AsyncReader::Ring
+{
+public:
+    Ring(AsyncReader& owner, std::size_t depth) : owner_{owner}, depth_{depth}
+    {
+        io_uring_params params{};
+        auto entries = static_cast<unsigned>(depth_ + 1);
+        ringFd_ = static_cast<int>(
+            syscall(__NR_io_uring_setup, entries, &params));
+        if (ringFd_ < 0) {
+            throw std::runtime_error("io_uring is not available");
+        }
+        try {
+            map_(params);
+            probe_();
+            wakeFd_ = eventfd(0, EFD_CLOEXEC);
+            if (wakeFd_ < 0) {
+                throw std::runtime_error("Failed to create eventfd");
+            }
+        } catch (...) {
+            unmap_();
+            throw;
+        }
+        thread_ = std::thread(&Ring::run_, this);
+    }
+
+    ~Ring()
+    {
+        {
+            const std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        wake_();
+        thread_.join();
+        unmap_();
+    }
+
+    Ring(const Ring&) = delete;
+    auto operator=(const Ring&) -> Ring& = delete;
+    Ring(Ring&&) = delete;
+    auto operator=(Ring&&) -> Ring& = delete;
+
+    void push(const fs::path& path, Callback done)
+    {
+        auto request = std::make_unique<Request>();
+        request->path = path.string();
+        request->done = std::move(done);
+        {
+            const std::lock_guard<std::mutex> lock(mutex_);
+            queue_.emplace_back(std::move(request));
+        }
+        wake_();
+    }
+
+private:
+    // State of one read
+    struct Request {
+        enum class Stage { Open, Stat, Read };
+        std::string path;
+        Callback done;
+        Stage stage{Stage::Open};
+        int fd{-1};
+        struct statx stx {
+        };
+        std::vector<char> data;
+        std::size_t offset{0};
+    };
+
+    // Reads larger than this are split into several operations
+    static constexpr std::size_t MAX_READ{std::size_t{1} << 30};
+
+    // user_data of the wake-up read. Requests use their address.
+    static constexpr std::uint64_t WAKE_TAG{0};
+
+    template <typename T>
+    static auto Field(void* base, std::uint32_t offset) -> T*
+    {
+        return reinterpret_cast<T*>(static_cast<char*>(base) + offset);
+    }
+
+    void map_(const io_uring_params& p)
+    {
+        sqBytes_ = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+        cqBytes_ = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+        auto single = (p.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (single) {
+            sqBytes_ = cqBytes_ = std::max(sqBytes_, cqBytes_);
+        }
+        sq_ = mmap_(sqBytes_, IORING_OFF_SQ_RING);
+        cq_ = single ? sq_ : mmap_(cqBytes_, IORING_OFF_CQ_RING);
+        sqesBytes_ = p.sq_entries * sizeof(io_uring_sqe);
+        sqes_ = static_cast<io_uring_sqe*>(mmap_(sqesBytes_, IORING_OFF_SQES));
+
+        sqHead_ = Field<unsigned>(sq_, p.sq_off.head);
+        sqTail_ = Field<unsigned>(sq_, p.sq_off.tail);
+        sqMask_ = *Field<unsigned>(sq_, p.sq_off.ring_mask);
+        sqArray_ = Field<unsigned>(sq_, p.sq_off.array);
+        sqLocalTail_ = *sqTail_;
+        cqHead_ = Field<unsigned>(cq_, p.cq_off.head);
+        cqTail_ = Field<unsigned>(cq_, p.cq_off.tail);
+        cqMask_ = *Field<unsigned>(cq_, p.cq_off.ring_mask);
+        cqes_ = Field<io_uring_cqe>(cq_, p.cq_off.cqes);
+    }
+
+    auto mmap_(std::size_t bytes, off_t offset) -> void*
+    {
+        auto* m = mmap(
+            nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+            ringFd_, offset);
+        if (m == MAP_FAILED) {
+            throw std::runtime_error("Failed to map io_uring");
+        }
+        return m;
+    }
+
+    void unmap_()
+    {
+        if (sqes_ != nullptr) {
+            munmap(sqes_, sqesBytes_);
+        }
+        if (cq_ != nullptr and cq_ != sq_) {
+            munmap(cq_, cqBytes_);
+        }
+        if (sq_ != nullptr) {
+            munmap(sq_, sqBytes_);
+        }
+        close(ringFd_);
+        if (wakeFd_ >= 0) {
+            close(wakeFd_);
+        }
+    }
+
+    // Check that the kernel supports every operation we use (Linux 5.6+)
+    void probe_() const
+    {
+        constexpr unsigned numOps{256};
+        std::vector<char> buffer(
+            sizeof(io_uring_probe) + numOps * sizeof(io_uring_probe_op));
+        auto* probe = reinterpret_cast<io_uring_probe*>(buffer.data());
+        if (syscall(
+                __NR_io_uring_register, ringFd_, IORING_REGISTER_PROBE, probe,
+                numOps) < 0) {
+            throw std::runtime_error("io_uring probe failed");
+        }
+        for (int op : {IORING_OP_OPENAT, IORING_OP_STATX, IORING_OP_READ}) {
+            if (op > probe->last_op or
+                (probe->ops[op].flags & IO_URING_OP_SUPPORTED) == 0) {
+                throw std::runtime_error("io_uring operation not supported");
+            }
+        }
+    }
+
+    void wake_() const
+    {
+        std::uint64_t one{1};
+        while (write(wakeFd_, &one, sizeof(one)) < 0 and errno == EINTR) {
+        }
+    }
+
+    // Get the next submission entry. The ring has room for every operation
+    // which can be in flight. Entries are published by enter_().
+    auto sqe_(std::uint64_t tag) -> io_uring_sqe*
+    {
+        auto index = sqLocalTail_++ & sqMask_;
+        auto* sqe = &sqes_[index];
+        std::memset(sqe, 0, sizeof(*sqe));
+        sqe->user_data = tag;
+        sqArray_[index] = index;
+        toSubmit_++;
+        return sqe;
+    }
+
+    void arm_wake_()
+    {
+        auto* sqe = sqe_(WAKE_TAG);
+        sqe->opcode = IORING_OP_READ;
+        sqe->fd = wakeFd_;
+        sqe->addr = reinterpret_cast<std::uint64_t>(&wakeCount_);
+        sqe->len = sizeof(wakeCount_);
+        wakeArmed_ = true;
+    }
+
+    void submit_(Request* r)
+    {
+        auto* sqe = sqe_(reinterpret_cast<std::uint64_t>(r));
+        switch (r->stage) {
+            case Request::Stage::Open:
+                sqe->opcode = IORING_OP_OPENAT;
+                sqe->fd = AT_FDCWD;
+                sqe->addr = reinterpret_cast<std::uint64_t>(r->path.c_str());
+                sqe->open_flags = O_RDONLY | O_CLOEXEC;
+                break;
+            case Request::Stage::Stat:
+                sqe->opcode = IORING_OP_STATX;
+                sqe->fd = r->fd;
+                sqe->addr = reinterpret_cast<std::uint64_t>("");
+                sqe->len = STATX_SIZE;
+                sqe->off = reinterpret_cast<std::uint64_t>(&r->stx);
+                sqe->statx_flags = AT_EMPTY_PATH;
+                break;
+            case Request::Stage::Read:
+                sqe->opcode = IORING_OP_READ;
+                sqe->fd = r->fd;
+                sqe->addr =
+                    reinterpret_cast<std::uint64_t>(r->data.data() + r->offset);
+                sqe->len = static_cast<std::uint32_t>(
+                    std::min(r->data.size() - r->offset, MAX_READ));
+                sqe->off = r->offset;
+                break;
+        }
+    }
+
+    // Submit queued operations and wait for at least one completion
+    void enter_()
+    {
+        __atomic_store_n(sqTail_, sqLocalTail_, __ATOMIC_RELEASE);
+        while (true) {
+            auto n = syscall(
+                __NR_io_uring_enter, ringFd_, toSubmit_, 1,
+                IORING_ENTER_GETEVENTS, nullptr, 0);
+            if (n >= 0) {
+                toSubmit_ -= std::min<unsigned>(toSubmit_, n);
+                return;
+            }
+            // EAGAIN and EBUSY mean the kernel is short of resources, and
+            // will accept the entries once some operations complete
+            if (errno != EINTR and errno != EAGAIN and errno != EBUSY) {
+                throw std::runtime_error(
+                    std::string("io_uring_enter failed: ") +
+                    std::strerror(errno));
+            }
+        }
+    }
+
+    void finish_(Request* r, Result data, std::exception_ptr error)
+    {
+        if (r->fd >= 0) {
+            close(r->fd);
+        }
+        std::unique_ptr<Request> owned(r);
+        inflight_--;
+        owner_.completions_.submit(
+            [this, done = std::move(r->done), data = std::move(data),
+             error]() mutable {
+                owner_.complete_(done, std::move(data), error);
+            });
+    }
+
+    void fail_(Request* r, const std::string& what, int err)
+    {
+        finish_(
+            r, std::nullopt,
+            std::make_exception_ptr(IOException(
+                what + " " + r->path + ": " + std::strerror(err))));
+    }
+
+    void handle_(Request* r, int res)
+    {
+        using Stage = Request::Stage;
+        if (res == -EINTR or res == -EAGAIN) {
+            submit_(r);
+            return;
+        }
+        switch (r->stage) {
+            case Stage::Open:
+                if (res == -ENOENT or res == -ENOTDIR) {
+                    finish_(r, std::nullopt, nullptr);
+                } else if (res < 0) {
+                    fail_(r, "Failed to open file", -res);
+                } else {
+                    r->fd = res;
+                    r->stage = Stage::Stat;
+                    submit_(r);
+                }
+                return;
+            case Stage::Stat:
+                if (res < 0) {
+                    fail_(r, "Failed to stat file", -res);
+                    return;
+                }
+                r->data.resize(static_cast<std::size_t>(r->stx.stx_size));
+                r->stage = Stage::Read;
+                break;
+            case Stage::Read:
+                if (res < 0) {
+                    fail_(r, "Failed to read file", -res);
+                    return;
+                }
+                // The file shrank while it was read
+                if (res == 0) {
+                    r->data.resize(r->offset);
+                }
+                r->offset += static_cast<std::size_t>(res);
+                break;
+        }
+        if (r->offset < r->data.size()) {
+            submit_(r);
+        } else {
+            finish_(r, std::move(r->data), nullptr);
+        }
+    }
+
+    void run_()
+    {
+        arm_wake_();
+        while (true) {
+            {
+                const std::lock_guard<std::mutex> lock(mutex_);
+                while (not queue_.empty() and inflight_ < depth_) {
+                    submit_(queue_.front().release());
+                    queue_.pop_front();
+                    inflight_++;
+                }
+                if (stop_ and queue_.empty() and inflight_ == 0 and
+                    not wakeArmed_) {
+                    return;
+                }
+            }
+
+            try {
+                enter_();
+            } catch (const std::exception& e) {
+                // Nothing sensible can be done with the ring. Retry after a
+                // pause rather than abandoning the reads in flight.
+                Logger()->error("{}", e.what());
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+
+            auto head = *cqHead_;
+            auto tail = __atomic_load_n(cqTail_, __ATOMIC_ACQUIRE);
+            for (; head != tail; head++) {
+                const auto& cqe = cqes_[head & cqMask_];
+                if (cqe.user_data == WAKE_TAG) {
+                    wakeArmed_ = false;
+                    const std::lock_guard<std::mutex> lock(mutex_);
+                    if (not stop_) {
+                        arm_wake_();
+                    }
+                } else {
+                    // NOLINTNEXTLINE(performance-no-int-to-ptr)
+                    handle_(reinterpret_cast<Request*>(cqe.user_data), cqe.res);
+                }
+            }
+            __atomic_store_n(cqHead_, head, __ATOMIC_RELEASE);
+        }
+    }
+
+    AsyncReader& owner_;
+    std::size_t depth_;
+    std::thread thread_;
+
+    // Submitted reads which have not been started
+    std::mutex mutex_;
+    std::deque<std::unique_ptr<Request>> queue_;
+    bool stop_{false};
+
+    // Owned by the submission thread
+    std::size_t inflight_{0};
+    unsigned toSubmit_{0};
+    bool wakeArmed_{false};
+    std::uint64_t wakeCount_{0};
+
+    int ringFd_{-1};
+    int wakeFd_{-1};
+    void* sq_{nullptr};
+    void* cq_{nullptr};
+    io_uring_sqe* sqes_{nullptr};
+    std::size_t sqBytes_{0};
+    std::size_t cqBytes_{0};
+    std::size_t sqesBytes_{0};
+    unsigned* sqHead_{nullptr};
+    unsigned* sqTail_{nullptr};
+    unsigned sqLocalTail_{0};
+    unsigned sqMask_{0};
+    unsigned* sqArray_{nullptr};
+    unsigned* cqHead_{nullptr};
+    unsigned* cqTail_{nullptr};
+    unsigned cqMask_{0};
+    io_uring_cqe* cqes_{nullptr};
+};
+#else
+// Placeholder so that std::unique_ptr<Ring> can be destroyed
+class AsyncReader::Ring
+{
+public:
+    Ring(AsyncReader& /*owner*/, std::size_t /*depth*/)
+    {
+        throw std::runtime_error("io_uring is not available");
+    }
+
+    void push(const fs::path& /*path*/, const Callback& /*done*/) {}
+};
+#endif
+
+AsyncReader::AsyncReader(
+    std::size_t queueDepth, std::size_t threads, Engine engine)
+    : queueDepth_{queueDepth}, completions_{threads}
+{
+    if (queueDepth_ == 0) {
+        throw std::invalid_argument("Queue depth must be greater than 0");
+    }
+    if (engine != Engine::Threads) {
+        try {
+            ring_ = std::make_unique<Ring>(*this, queueDepth_);
+        } catch (const std::exception& e) {
+            Logger()->debug("Using blocking reads: {}", e.what());
+        }
+    }
+}
+
+auto AsyncReader::New(
+    std::size_t queueDepth, std::size_t threads, Engine engine) -> Pointer
+{
+    return std::make_shared<AsyncReader>(queueDepth, threads, engine);
+}
+
+AsyncReader::~AsyncReader()
+{
+    wait();
+    ring_.reset();
+}
+
+auto AsyncReader::IOUringAvailable() -> bool
+{
+    static const bool available = []() {
+        try {
+            AsyncReader reader(1, 1, Engine::IOUring);
+            return reader.engine() == Engine::IOUring;
+        } catch (const std::exception&) {
+            return false;
+        }
+    }();
+    return available;
+}
+
+auto AsyncReader::engine() const -> Engine
+{
+    return ring_ ? Engine::IOUring : Engine::Threads;
+}
+
+auto AsyncReader::queueDepth() const -> std::size_t { return queueDepth_; }
+
+auto AsyncReader::pending() const -> std::size_t
+{
+    const std::lock_guard<std::mutex> lock(mutex_);
+    return pending_;
+}
+
+void AsyncReader::read(const fs::path& path, Callback done)
+{
+    {
+        const std::lock_guard<std::mutex> lock(mutex_);
+        pending_++;
+    }
+    if (ring_) {
+        ring_->push(path, std::move(done));
+        return;
+    }
+    completions_.submit([this, path, done = std::move(done)]() {
+        Result data;
+        std::exception_ptr error;
+        try {
+            data = ReadFile(path);
+        } catch (...) {
+            error = std::current_exception();
+        }
+        complete_(done, std::move(data), error);
+    });
+}
+
+auto AsyncReader::read(const fs::path& path) -> std::future<Result>
+{
+    auto promise = std::make_shared<std::promise<Result>>();
+    auto result = promise->get_future();
+    read(path, [promise](Result data, const std::exception_ptr& error) {
+        if (error) {
+            promise->set_exception(error);
+        } else {
+            promise->set_value(std::move(data));
+        }
+    });
+    return result;
+}
+
+void AsyncReader::submit(std::function<Result()> load, Callback done)
+{
+    {
+        const std::lock_guard<std::mutex> lock(mutex_);
+        pending_++;
+    }
+    completions_.submit(
+        [this, load = std::move(load), done = std::move(done)]() {
+            Result data;
+            std::exception_ptr error;
+            try {
+                data = load();
+            } catch (...) {
+                error = std::current_exception();
+            }
+            complete_(done, std::move(data), error);
+        });
+}
+
+void AsyncReader::wait()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [this]() { return pending_ == 0; });
+}
+
+void AsyncReader::complete_(
+    const Callback& done, Result data, std::exception_ptr error)
+{
+    try {
+        done(std::move(data), std::move(error));
+    } catch (const std::exception& e) {
+        Logger()->warn("Async read callback failed: {}", e.what());
+    }
+    // Notify while locked, since wait() may return and the reader be
+    // destroyed as soon as the lock is released
+    const std::lock_guard<std::mutex> lock(mutex_);
+    pending_--;
+    cv_.notify_all();
+}
@@ -0,0 +1,108 @@
+#include "vc/core/util/CPUFeatures.hpp"
+
+#include <cstdlib>
+#include <stdexcept>
+
+#include "vc/core/util/Logging.hpp"
+#include "vc/core/util/String.hpp"
+
+using namespace volcart;
+using namespace volcart::simd;
+
+namespace
+{
+auto ResolveActivePath() -> Path
+{
+    auto path = DetectPath();
+    const auto* env = std::getenv("VC_SIMD");
+    if (env != nullptr and *env != '\0') {
+        try {
+            auto requested = ParsePath(env);
+            if (Supports(requested)) {
+                path = requested;
+            } else {
+                Logger()->warn(
+                    "VC_SIMD={} is not supported by this CPU. Using {}.", env,
+                    PathName(path));
+            }
+        } catch (const std::invalid_argument&) {
+            Logger()->warn("Ignoring unknown VC_SIMD path: {}", env);
+        }
+    }
+    Logger()->debug("SIMD path: {}", PathName(path));
+    return path;
+}
+}  // namespace
+
+auto simd::Supports(Path p) -> bool
+{
+    switch (p) {
+        case Path::Scalar:
+            return true;
+#ifdef VC_SIMD_X86
+        case Path::SSE4:
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("sse4.2");
+        case Path::AVX2:
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("avx2") and
+                   __builtin_cpu_supports("fma");
+        case Path::AVX512:
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("avx512f") and
+                   __builtin_cpu_supports("avx512bw") and
+                   __builtin_cpu_supports("avx512vl");
+#endif
+#if defined(__aarch64__) || defined(__ARM_NEON)
+        case Path::NEON:
+            return true;
+#endif
+        default:
+            return false;
+    }
+}
+
+auto simd::DetectPath() -> Path
+{
+    for (auto p : {Path::NEON, Path::AVX512, Path::AVX2, Path::SSE4}) {
+        if (Supports(p)) {
+            return p;
+        }
+    }
+    return Path::Scalar;
+}
+
+auto simd::ActivePath() -> Path
+{
+    static const auto path = ResolveActivePath();
+    return path;
+}
+
+auto simd::PathName(Path p) -> std::string
+{
+    switch (p) {
+        case Path::Scalar:
+            return "scalar";
+        case Path::SSE4:
+            return "sse4";
+        case Path::AVX2:
+            return "avx2";
+        case Path::AVX512:
+            return "avx512";
+        case Path::NEON:
+            return "neon";
+    }
+    return "unknown";
+}
+
+auto simd::ParsePath(const std::string& name) -> Path
+{
+    auto lower = to_lower(std::string(name));
+    for (auto p : {Path::Scalar, Path::SSE4, Path::AVX2, Path::AVX512,
+                   Path::NEON}) {
+        if (lower == PathName(p)) {
+            return p;
+        }
+    }
+    throw std::invalid_argument("Unknown SIMD path: " + name);
+}
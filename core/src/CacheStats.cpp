@@ -0,0 +1,102 @@
+#include "vc/core/types/CacheStats.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+
+#include "vc/core/util/MemorySizeStringParser.hpp"
+
+using namespace volcart;
+
+void LatencyHistogram::record(std::chrono::nanoseconds d)
+{
+    auto us = static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(d).count());
+
+    // Bucket index is the bit width of the latency
+    std::size_t idx{0};
+    for (auto v = us; v > 0 and idx < NUM_BUCKETS - 1; v >>= 1) {
+        idx++;
+    }
+    buckets_[idx]++;
+    totalUs_ += us;
+
+    auto max = maxUs_.load();
+    while (us > max and not maxUs_.compare_exchange_weak(max, us)) {
+    }
+}
+
+LatencyHistogram::Snapshot LatencyHistogram::snapshot() const
+{
+    Snapshot s;
+    for (std::size_t i = 0; i < NUM_BUCKETS; i++) {
+        s.buckets[i] = buckets_[i].load();
+        s.count += s.buckets[i];
+    }
+    s.totalUs = totalUs_.load();
+    s.maxUs = maxUs_.load();
+    return s;
+}
+
+void LatencyHistogram::reset()
+{
+    for (auto& b : buckets_) {
+        b = 0;
+    }
+    totalUs_ = 0;
+    maxUs_ = 0;
+}
+
+double LatencyHistogram::Snapshot::mean() const
+{
+    if (count == 0) {
+        return 0;
+    }
+    return static_cast<double>(totalUs) / static_cast<double>(count);
+}
+
+double LatencyHistogram::Snapshot::percentile(double p) const
+{
+    if (count == 0) {
+        return 0;
+    }
+    auto target = std::ceil(std::clamp(p, 0., 100.) / 100. * count);
+    std::uint64_t seen{0};
+    for (std::size_t i = 0; i < NUM_BUCKETS; i++) {
+        seen += buckets[i];
+        if (seen >= target and seen > 0) {
+            // The last bucket is unbounded
+            if (i == NUM_BUCKETS - 1) {
+                return static_cast<double>(maxUs);
+            }
+            return std::min(std::ldexp(1., int(i)), double(maxUs));
+        }
+    }
+    return static_cast<double>(maxUs);
+}
+
+double CacheStats::hitRate() const
+{
+    if (lookups == 0) {
+        return 0;
+    }
+    return static_cast<double>(hits) / static_cast<double>(lookups);
+}
+
+std::string CacheStats::summary() const
+{
+    auto ms = [](double us) { return us / 1000.; };
+    std::stringstream ss;
+    ss << std::fixed << std::setprecision(1);
+    ss << "lookups: " << lookups << ", hit rate: " << 100 * hitRate()
+       << "%, misses: " << misses << ", evictions: " << evictions
+       << ", read: "
+       << BytesToMemorySizeString(bytesRead, "MB", MemoryStringFormat::Float)
+       << ", load latency (ms): mean " << std::setprecision(2)
+       << ms(loadLatency.mean()) << ", p50 "
+       << ms(loadLatency.percentile(50)) << ", p99 "
+       << ms(loadLatency.percentile(99)) << ", max "
+       << ms(static_cast<double>(loadLatency.maxUs));
+    return ss.str();
+}
@@ -1,27 +1,38 @@
+#include <vector>
+
 #include <opencv2/imgproc.hpp>
 
 #include "vc/core/util/Canny.hpp"
 
 namespace vc = volcart;
 
-auto vc::Canny(const cv::Mat src, const vc::CannySettings settings) -> cv::Mat
+namespace
+{
+// Canny pipeline for cv::Mat and cv::UMat images
+template <class Image>
+auto CannyImpl(const Image& src, const vc::CannySettings& settings) -> Image
 {
     int gaussianKernel = 2 * settings.blurSize + 1;
     int aperture = 2 * settings.apertureSize + 3;
-    cv::Mat canny;
-    cv::GaussianBlur(src, canny, {gaussianKernel, gaussianKernel}, 0);
+    Image blurred;
+    cv::GaussianBlur(src, blurred, {gaussianKernel, gaussianKernel}, 0);
     if (settings.bilateral) {
-        cv::bilateralFilter(canny.clone(), canny, gaussianKernel, 75, 75);
+        Image filtered;
+        cv::bilateralFilter(blurred, filtered, gaussianKernel, 75, 75);
+        blurred = filtered;
     }
 
     // Run Canny Edge Detect
+    Image canny;
     cv::Canny(
-        canny, canny, settings.minThreshold, settings.maxThreshold, aperture,
+        blurred, canny, settings.minThreshold, settings.maxThreshold, aperture,
         true);
 
     // Apply mask
     if (!settings.mask.empty()) {
-        canny.copyTo(canny, settings.mask);
+        Image masked(canny.size(), canny.type(), cv::Scalar::all(0));
+        canny.copyTo(masked, settings.mask);
+        canny = masked;
     }
 
     // Replace canny edges with contour edges
@@ -35,9 +46,22 @@ auto vc::Canny(const cv::Mat src, const vc::CannySettings settings) -> cv::Mat
         cv::findContours(
             canny, contours, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_NONE);
 
-        canny = cv::Mat::zeros(src.size(), CV_8UC1);
-        cv::drawContours(canny, contours, -1, {255});
+        cv::Mat edges = cv::Mat::zeros(src.size(), CV_8UC1);
+        cv::drawContours(edges, contours, -1, {255});
+        edges.copyTo(canny);
     }
 
     return canny;
-}
\ No newline at end of file
+}
+}  // namespace
+
+auto vc::Canny(const cv::Mat src, const vc::CannySettings settings) -> cv::Mat
+{
+    return CannyImpl(src, settings);
+}
+
+auto vc::Canny(const cv::UMat& src, const vc::CannySettings& settings)
+    -> cv::UMat
+{
+    return CannyImpl(src, settings);
+}
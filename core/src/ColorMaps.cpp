@@ -2,7 +2,10 @@
 
 #include <array>
 #include <limits>
+#include <map>
+#include <mutex>
 #include <unordered_map>
+#include <utility>
 
 #include "opencv2/imgproc.hpp"
 
@@ -28,7 +31,7 @@ static const std::unordered_map<std::string, ColorMap> STR_TO_CM{
     {"plasma", ColorMap::Plasma}, {"viridis", ColorMap::Viridis},
     {"phase", ColorMap::Phase},   {"bwr", ColorMap::BWR}};
 
-cv::Mat vc::GetColorMapLUT(ColorMap cm, std::size_t bins)
+static cv::Mat BuildColorMapLUT(ColorMap cm, std::size_t bins)
 {
     cv::Mat lut;
     switch (cm) {
@@ -61,6 +64,22 @@ cv::Mat vc::GetColorMapLUT(ColorMap cm, std::size_t bins)
     return lut;
 }
 
+cv::Mat vc::GetColorMapLUT(ColorMap cm, std::size_t bins)
+{
+    // LUTs built so far, by color map and bin count
+    static std::mutex mutex;
+    static std::map<std::pair<ColorMap, std::size_t>, cv::Mat> cache;
+
+    std::unique_lock lock(mutex);
+    auto [it, inserted] = cache.try_emplace({cm, bins});
+    if (inserted) {
+        it->second = BuildColorMapLUT(cm, bins);
+    }
+
+    // Copy so that callers cannot modify the cached LUT
+    return it->second.clone();
+}
+
 cv::Mat vc::GetColorMapLUT(const std::string& name, std::size_t bins)
 {
     return GetColorMapLUT(ColorMapFromString(name), bins);
@@ -1,30 +1,64 @@
 #include "vc/core/neighborhood/CuboidGenerator.hpp"
 
+#include <algorithm>
+#include <array>
+#include <cmath>
 #include <exception>
+#include <limits>
 
 static const std::vector<cv::Vec3d> BASIS_VECTORS = {
     {1, 0, 0}, {0, 1, 0}, {0, 0, 1}};
 
+// Convert v to an integer vector if all of its components are integers
+static auto ToLattice(const cv::Vec3d& v, cv::Vec3i& out) -> bool
+{
+    constexpr auto maxVal = std::numeric_limits<int>::max();
+    for (int i = 0; i < 3; i++) {
+        if (v[i] != std::round(v[i]) or std::abs(v[i]) > maxVal) {
+            return false;
+        }
+        out[i] = static_cast<int>(v[i]);
+    }
+    return true;
+}
+
+// Check if v is a signed, axis-aligned unit vector
+static auto IsAxisAligned(const cv::Vec3d& v) -> bool
+{
+    cv::Vec3i i;
+    if (not ToLattice(v, i)) {
+        return false;
+    }
+    return std::abs(i[0]) + std::abs(i[1]) + std::abs(i[2]) == 1;
+}
+
 using namespace volcart;
 
-Neighborhood CuboidGenerator::compute(
-    const Volume::Pointer& v,
-    const cv::Vec3d& pt,
-    const std::vector<cv::Vec3d>& axes)
+// Generate the 2nd and 3rd axes from the first
+static void GenerateAxes(std::array<cv::Vec3d, 3>& bases)
+{
+    // Find a basis vector not parallel to n
+    cv::Vec3d basis;
+    for (const auto& b : BASIS_VECTORS) {
+        if (bases[0].dot(b) != 1.0) {
+            basis = b;
+            break;
+        }
+    }
+    bases[1] = cv::normalize(bases[0].cross(basis));
+    bases[2] = cv::normalize(bases[0].cross(bases[1]));
+}
+
+// Resolve the bases of a neighborhood from its axes
+static auto Bases(std::vector<cv::Vec3d> bases, bool autoGen)
+    -> std::array<cv::Vec3d, 3>
 {
     // Auto-generate missing axes
-    auto bases = axes;
-    if (autoGenAxes_) {
+    if (autoGen) {
         if (bases.size() == 1) {
-            // Find a basis vector not parallel to n
-            cv::Vec3d basis;
-            for (const auto& b : BASIS_VECTORS) {
-                if (bases[0].dot(b) != 1.0) {
-                    basis = b;
-                    break;
-                }
-            }
-            bases.emplace_back(cv::normalize(bases[0].cross(basis)));
+            std::array<cv::Vec3d, 3> generated{bases[0]};
+            GenerateAxes(generated);
+            bases.emplace_back(generated[1]);
         }
 
         if (bases.size() == 2) {
@@ -39,57 +73,172 @@ Neighborhood CuboidGenerator::compute(
         throw std::invalid_argument(msg);
     }
 
+    return {bases[0], bases[1], bases[2]};
+}
+
+// Sample the neighborhood at pt + each offset
+static void Sample(
+    const Volume& v,
+    const cv::Vec3d& pt,
+    const CuboidGenerator::SampleOffsets& offsets,
+    Volume::Interpolation method,
+    uint16_t* out)
+{
+    const auto& samples = offsets.samples;
+    if (samples.empty()) {
+        return;
+    }
+
+    // Axis-aligned bases on an integer lattice sample voxels exactly with
+    // every kernel, so copy them straight out of the volume instead of
+    // interpolating
+    cv::Vec3i origin;
+    if (offsets.lattice and ToLattice(pt + samples.front(), origin)) {
+        v.copyLattice(origin, offsets.steps, offsets.extent, out);
+        return;
+    }
+
+    // Sample in (z, y, x) order to match the subvolume layout. The
+    // positions buffer is reused by every neighborhood on this thread.
+    thread_local std::vector<cv::Vec3d> pts;
+    pts.resize(samples.size());
+    for (size_t i = 0; i < samples.size(); i++) {
+        pts[i] = pt + samples[i];
+    }
+    v.interpolateAt(pts.data(), pts.size(), out, method);
+}
+
+Neighborhood CuboidGenerator::compute(
+    const Volume::Pointer& v,
+    const cv::Vec3d& pt,
+    const std::vector<cv::Vec3d>& axes)
+{
+    thread_local SampleOffsets offsets;
+    offsets_(Bases(axes, autoGenAxes_), offsets);
+    Neighborhood output(3, extents());
+    Sample(*v, pt, offsets, interpolation_, output.data());
+    return output;
+}
+
+void CuboidGenerator::computeInto(
+    const Volume::Pointer& v,
+    const cv::Vec3d& pt,
+    const cv::Vec3d& axis,
+    uint16_t* out) const
+{
+    std::array<cv::Vec3d, 3> bases{axis};
+    GenerateAxes(bases);
+    thread_local SampleOffsets offsets;
+    offsets_(bases, offsets);
+    Sample(*v, pt, offsets, interpolation_, out);
+}
+
+CuboidGenerator::SampleOffsets CuboidGenerator::precompute(
+    const std::vector<cv::Vec3d>& axes) const
+{
+    SampleOffsets offsets;
+    offsets_(Bases(axes, autoGenAxes_), offsets);
+    return offsets;
+}
+
+void CuboidGenerator::computeInto(
+    const Volume::Pointer& v,
+    const cv::Vec3d& pt,
+    const SampleOffsets& offsets,
+    uint16_t* out) const
+{
+    Sample(*v, pt, offsets, interpolation_, out);
+}
+
+void CuboidGenerator::computeSlicesInto(
+    const Volume::Pointer& v,
+    const cv::Vec3d& pt,
+    const std::vector<cv::Vec3d>& axes,
+    size_t first,
+    size_t last,
+    uint16_t* out) const
+{
+    if (first > last or last > extent_()[0]) {
+        throw std::out_of_range("Slice range exceeds the neighborhood");
+    }
+    thread_local SampleOffsets offsets;
+    offsets_(Bases(axes, autoGenAxes_), offsets, first, last);
+    Sample(*v, pt, offsets, interpolation_, out);
+}
+
+void CuboidGenerator::offsets_(
+    const std::array<cv::Vec3d, 3>& bases,
+    SampleOffsets& offsets,
+    size_t first,
+    size_t last) const
+{
     // Get center and primary radius of directional subvolume
-    auto center = pt;
+    cv::Vec3d center;
     auto radius = radius_;
     if (direction_ != Direction::Bidirectional) {
         radius[0] /= 2.0;
-        auto offset = bases[0] * radius[0];
+        center = bases[0] * radius[0];
         if (direction_ == Direction::Negative) {
-            offset *= -1;
+            center *= -1;
         }
-        center += offset;
     }
 
-    // Get the number of samples along each basis
-    auto extent = extents();
+    // Get the number of samples along each basis, limited to the requested
+    // slices
+    auto extent = extent_();
+    last = std::min(last, extent[0]);
+    first = std::min(first, last);
+    extent[0] = last - first;
+    offsets.extent = extent;
+
+    // Samples lie on an integer lattice if the bases are axis-aligned and
+    // the interval is an integer
+    offsets.lattice = IsAxisAligned(bases[0]) and IsAxisAligned(bases[1]) and
+                      IsAxisAligned(bases[2]) and interval_ >= 1 and
+                      interval_ == std::round(interval_);
+    if (offsets.lattice) {
+        for (size_t i = 0; i < 3; i++) {
+            ToLattice(bases[i] * interval_, offsets.steps[i]);
+        }
+    }
 
-    // Iterate over the axes
-    Neighborhood output(3, extent);
-    for (size_t z = 0; z < extent[0]; ++z) {
+    // Offset between neighboring samples along each basis
+    const auto zStep = bases[0] * interval_;
+    const auto yStep = bases[1] * interval_;
+    const auto xStep = bases[2] * interval_;
+
+    // Offsets are computed from their index rather than by accumulating
+    // steps, so long rows don't drift. Only the row's start is computed per
+    // row, and one multiply-add per sample.
+    const auto origin = center - bases[0] * radius[0] -
+                        bases[1] * radius[1] - bases[2] * radius[2];
+    auto& samples = offsets.samples;
+    samples.resize(extent[0] * extent[1] * extent[2]);
+    auto* sample = samples.data();
+    for (size_t z = first; z < last; ++z) {
+        const cv::Vec3d slice = origin + zStep * static_cast<double>(z);
         for (size_t y = 0; y < extent[1]; ++y) {
+            const cv::Vec3d row = slice + yStep * static_cast<double>(y);
             for (size_t x = 0; x < extent[2]; ++x) {
-
-                // Offset along each axis
-                auto zOffset = -radius[0] + (z * interval_);
-                auto yOffset = -radius[1] + (y * interval_);
-                auto xOffset = -radius[2] + (x * interval_);
-
-                // Current 3D position
-                auto p = center + (bases[2] * xOffset) + (bases[1] * yOffset) +
-                         (bases[0] * zOffset);
-
-                // Assign to the subvolume array
-                output(z, y, x) = v->interpolateAt(p);
+                *sample++ = row + xStep * static_cast<double>(x);
             }
         }
     }
-
-    return output;
 }
 
 Neighborhood::Extent CuboidGenerator::extents() const
+{
+    auto extent = extent_();
+    return {extent.begin(), extent.end()};
+}
+
+std::array<size_t, 3> CuboidGenerator::extent_() const
 {
     auto radius =
         (direction_ != Direction::Bidirectional) ? radius_[0] / 2 : radius_[0];
 
-    Neighborhood::Extent extent;
-    extent.emplace_back(
-        static_cast<size_t>(std::floor(2.0 * radius / interval_) + 1));
-    extent.emplace_back(
-        static_cast<size_t>(std::floor(2.0 * radius_[1] / interval_) + 1));
-    extent.emplace_back(
-        static_cast<size_t>(std::floor(2.0 * radius_[2] / interval_) + 1));
-
-    return extent;
-}
\ No newline at end of file
+    return {
+        static_cast<size_t>(std::floor(2.0 * radius / interval_) + 1),
+        static_cast<size_t>(std::floor(2.0 * radius_[1] / interval_) + 1),
+        static_cast<size_t>(std::floor(2.0 * radius_[2] / interval_) + 1)};
+}
@@ -0,0 +1,234 @@
+#include "vc/core/io/DeepZoomWriter.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc.hpp>
+
+#include "vc/core/io/FileExtensionFilter.hpp"
+#include "vc/core/util/ThreadPool.hpp"
+
+using namespace volcart;
+
+namespace fs = volcart::filesystem;
+
+namespace
+{
+// Tile image format
+const std::string TILE_FORMAT{"png"};
+
+// Downsample by half, rounding odd sizes up
+auto HalfSize(const cv::Mat& img) -> cv::Mat
+{
+    cv::Mat out;
+    cv::Size size((img.cols + 1) / 2, (img.rows + 1) / 2);
+    cv::resize(img, out, size, 0, 0, cv::INTER_AREA);
+    return out;
+}
+}  // namespace
+
+DeepZoomWriter::DeepZoomWriter(
+    fs::path path, int width, int height, int cvType, int tileSize)
+    : path_{std::move(path)}, cvType_{cvType}, tileSize_{tileSize}
+{
+    // Safety checks
+    if (width <= 0 or height <= 0) {
+        throw std::invalid_argument("Image dimensions must be positive");
+    }
+    if (tileSize <= 0 or tileSize % 2 != 0) {
+        throw std::invalid_argument("Tile size must be positive and even");
+    }
+    if (not io::FileExtensionFilter(path_, {"dzi"})) {
+        throw std::runtime_error(
+            "Invalid file extension " + path_.extension().string());
+    }
+    auto depth = CV_MAT_DEPTH(cvType);
+    auto channels = CV_MAT_CN(cvType);
+    if ((depth != CV_8U and depth != CV_16U) or channels == 2) {
+        throw std::runtime_error("Unsupported image type");
+    }
+
+    // Level sizes, halving until a single pixel remains
+    cv::Size size(width, height);
+    levelSizes_.push_back(size);
+    while (size.width > 1 or size.height > 1) {
+        size = {(size.width + 1) / 2, (size.height + 1) / 2};
+        levelSizes_.push_back(size);
+    }
+    std::reverse(levelSizes_.begin(), levelSizes_.end());
+    pending_.resize(levelSizes_.size());
+
+    // Tile directories
+    tileDir_ = path_.parent_path() / (path_.stem().string() + "_files");
+    for (std::size_t level = 0; level < levelSizes_.size(); level++) {
+        fs::create_directories(tileDir_ / std::to_string(level));
+    }
+}
+
+DeepZoomWriter::~DeepZoomWriter()
+{
+    try {
+        close();
+    } catch (...) {
+        // Destructors can't throw. Call close() to handle errors.
+    }
+}
+
+auto DeepZoomWriter::width() const -> int { return levelSizes_.back().width; }
+
+auto DeepZoomWriter::height() const -> int
+{
+    return levelSizes_.back().height;
+}
+
+auto DeepZoomWriter::tileSize() const -> int { return tileSize_; }
+
+auto DeepZoomWriter::numLevels() const -> int
+{
+    return static_cast<int>(levelSizes_.size());
+}
+
+void DeepZoomWriter::setNumThreads(std::size_t n) { numThreads_ = n; }
+
+auto DeepZoomWriter::numThreads() const -> std::size_t { return numThreads_; }
+
+void DeepZoomWriter::writeRegion(const cv::Point& origin, const cv::Mat& img)
+{
+    if (closed_) {
+        throw std::runtime_error("Writer is closed");
+    }
+    if (img.type() != cvType_) {
+        throw std::invalid_argument("Image type does not match writer");
+    }
+
+    // The region must cover whole tiles, except along the image edges
+    auto x1 = origin.x + img.cols;
+    auto y1 = origin.y + img.rows;
+    if (origin.x < 0 or origin.y < 0 or x1 > width() or y1 > height()) {
+        throw std::out_of_range("Region is outside of the image");
+    }
+    if (origin.x % tileSize_ != 0 or origin.y % tileSize_ != 0 or
+        (x1 % tileSize_ != 0 and x1 != width()) or
+        (y1 % tileSize_ != 0 and y1 != height())) {
+        throw std::invalid_argument("Region is not aligned to the tile grid");
+    }
+
+    // Full-resolution tiles are views into the region
+    std::vector<Tile> tiles;
+    for (auto y = origin.y; y < y1; y += tileSize_) {
+        for (auto x = origin.x; x < x1; x += tileSize_) {
+            cv::Rect src(
+                x - origin.x, y - origin.y, std::min(tileSize_, x1 - x),
+                std::min(tileSize_, y1 - y));
+            tiles.push_back({x / tileSize_, y / tileSize_, img(src)});
+        }
+    }
+    write_tiles_(numLevels() - 1, std::move(tiles));
+}
+
+void DeepZoomWriter::close()
+{
+    if (closed_) {
+        return;
+    }
+
+    // Write the incomplete tiles of each level, from the highest resolution
+    // down, so that each level's tiles complete the level below it
+    for (auto level = numLevels() - 2; level >= 0; level--) {
+        std::vector<Tile> tiles;
+        for (auto& [key, p] : pending_[level]) {
+            tiles.push_back({key.first, key.second, std::move(p.img)});
+        }
+        pending_[level].clear();
+        write_tiles_(level, std::move(tiles));
+    }
+
+    // Descriptor
+    std::ofstream dzi(path_.string());
+    dzi << R"(<?xml version="1.0" encoding="UTF-8"?>)" << "\n";
+    dzi << R"(<Image xmlns="http://schemas.microsoft.com/deepzoom/2008")";
+    dzi << R"( Format=")" << TILE_FORMAT << R"(" Overlap="0")";
+    dzi << R"( TileSize=")" << tileSize_ << R"(">)" << "\n";
+    dzi << R"(  <Size Width=")" << width() << R"(" Height=")" << height();
+    dzi << R"("/>)" << "\n";
+    dzi << "</Image>\n";
+    dzi.close();
+    if (dzi.fail()) {
+        throw std::runtime_error("Failed to write file: " + path_.string());
+    }
+    closed_ = true;
+}
+
+auto DeepZoomWriter::tile_size_(int level, int x, int y) const -> cv::Size
+{
+    const auto& size = levelSizes_[level];
+    return {
+        std::min(tileSize_, size.width - x * tileSize_),
+        std::min(tileSize_, size.height - y * tileSize_)};
+}
+
+auto DeepZoomWriter::tile_grid_(int level) const -> cv::Size
+{
+    const auto& size = levelSizes_[level];
+    return {
+        (size.width + tileSize_ - 1) / tileSize_,
+        (size.height + tileSize_ - 1) / tileSize_};
+}
+
+auto DeepZoomWriter::num_children_(int level, int x, int y) const -> int
+{
+    auto grid = tile_grid_(level + 1);
+    return std::min(2, grid.width - 2 * x) * std::min(2, grid.height - 2 * y);
+}
+
+void DeepZoomWriter::write_tiles_(int level, std::vector<Tile> tiles)
+{
+    const auto half = tileSize_ / 2;
+    while (not tiles.empty()) {
+        // Encode each tile and downsample it for the next level
+        std::vector<cv::Mat> halves(tiles.size());
+        ParallelChunks(tiles.size(), numThreads_, [&](auto begin, auto end) {
+            for (auto i = begin; i < end; i++) {
+                const auto& t = tiles[i];
+                auto file = tileDir_ / std::to_string(level) /
+                            (std::to_string(t.x) + "_" + std::to_string(t.y) +
+                             "." + TILE_FORMAT);
+                if (not cv::imwrite(file.string(), t.img)) {
+                    throw std::runtime_error(
+                        "Failed to write file: " + file.string());
+                }
+                if (level > 0) {
+                    halves[i] = HalfSize(t.img);
+                }
+            }
+        });
+        if (level == 0) {
+            return;
+        }
+
+        // Assemble the parent tiles. Completed parents are written next.
+        std::vector<Tile> complete;
+        auto& pending = pending_[level - 1];
+        for (std::size_t i = 0; i < tiles.size(); i++) {
+            auto px = tiles[i].x / 2;
+            auto py = tiles[i].y / 2;
+            auto& p = pending[{px, py}];
+            if (p.img.empty()) {
+                p.img = cv::Mat::zeros(tile_size_(level - 1, px, py), cvType_);
+            }
+            cv::Rect dst(
+                {(tiles[i].x % 2) * half, (tiles[i].y % 2) * half},
+                halves[i].size());
+            halves[i].copyTo(p.img(dst));
+            if (++p.children == num_children_(level - 1, px, py)) {
+                complete.push_back({px, py, std::move(p.img)});
+                pending.erase({px, py});
+            }
+        }
+        tiles = std::move(complete);
+        level--;
+    }
+}
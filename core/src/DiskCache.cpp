@@ -0,0 +1,422 @@
+#include "vc/core/types/DiskCache.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "vc/core/types/Exceptions.hpp"
+#include "vc/core/util/Logging.hpp"
+
+using namespace volcart;
+
+namespace fs = volcart::filesystem;
+
+///// Entry file format /////
+// All values are stored in native byte order:
+//   EntryHeader
+//   uint8_t pixels[rows][cols * elemSize]: The image, without row padding
+static constexpr std::array<char, 8> ENTRY_MAGIC{'V', 'C', 'D', 'S',
+                                                 'K', 'C', '\r', '\n'};
+static constexpr std::uint32_t ENTRY_VERSION{1};
+static const std::string ENTRY_EXT{".vcc"};
+static const std::string TMP_EXT{".tmp"};
+
+namespace
+{
+struct EntryHeader {
+    std::array<char, 8> magic{ENTRY_MAGIC};
+    std::uint32_t version{ENTRY_VERSION};
+    // OpenCV type of the image
+    std::int32_t type{0};
+    std::int32_t rows{0};
+    std::int32_t cols{0};
+    // Stamp of the source file
+    std::uint64_t sourceSize{0};
+    std::int64_t sourceMTime{0};
+};
+
+// An entry file found while scanning the cache directory
+struct EntryFile {
+    fs::path path;
+    std::size_t size{0};
+    std::int64_t mtime{0};
+};
+
+// Type of the access flags of cv::MatAllocator, which differs between
+// OpenCV versions
+template <class T>
+struct AccessFlagOf;
+template <class R, class C, class D, class F>
+struct AccessFlagOf<R (C::*)(D, F) const> {
+    using type = F;
+};
+using AccessFlag = AccessFlagOf<decltype(&cv::MatAllocator::map)>::type;
+
+// Frees images which reference the memory mapping of an entry. Images which
+// are reallocated use the standard allocator.
+class MappedEntryAllocator : public cv::MatAllocator
+{
+public:
+    auto allocate(
+        int dims,
+        const int* sizes,
+        int type,
+        void* data,
+        std::size_t* step,
+        AccessFlag flags,
+        cv::UMatUsageFlags usage) const -> cv::UMatData* override
+    {
+        return cv::Mat::getStdAllocator()->allocate(
+            dims, sizes, type, data, step, flags, usage);
+    }
+
+    auto allocate(
+        cv::UMatData* u, AccessFlag flags, cv::UMatUsageFlags usage) const
+        -> bool override
+    {
+        return cv::Mat::getStdAllocator()->allocate(u, flags, usage);
+    }
+
+    void deallocate(cv::UMatData* u) const override
+    {
+        if (u == nullptr) {
+            return;
+        }
+        ::munmap(u->origdata, u->size);
+        delete u;
+    }
+};
+
+// Map an entry file. The returned image references a private, copy-on-write
+// mapping of the file, which is unmapped when the last reference to the
+// image is released. Until they are written, the image's pages are the
+// pages of the file in the page cache, which are shared with every other
+// process which maps the file.
+auto MapEntry(const fs::path& path) -> std::pair<EntryHeader, cv::Mat>
+{
+    static const MappedEntryAllocator ALLOCATOR;
+
+    auto fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw IOException("Failed to open disk cache entry");
+    }
+    struct stat st{};
+    if (::fstat(fd, &st) != 0) {
+        ::close(fd);
+        throw IOException("Failed to stat disk cache entry");
+    }
+    auto size = static_cast<std::size_t>(st.st_size);
+    EntryHeader header;
+    if (size < sizeof(header)) {
+        ::close(fd);
+        throw IOException("Disk cache entry is truncated");
+    }
+    auto* ptr = ::mmap(
+        nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (ptr == MAP_FAILED) {
+        throw IOException("Failed to memory map disk cache entry");
+    }
+    auto* data = static_cast<uchar*>(ptr);
+
+    std::memcpy(&header, data, sizeof(header));
+    // Entries may be written by other processes. The image size is bounded
+    // by division against the file size, so that it cannot overflow.
+    auto elemSize = static_cast<std::size_t>(CV_ELEM_SIZE(header.type));
+    auto rows = static_cast<std::size_t>(std::max(header.rows, 0));
+    auto cols = static_cast<std::size_t>(std::max(header.cols, 0));
+    auto available = size - sizeof(header);
+    auto valid = header.magic == ENTRY_MAGIC and
+                 header.version == ENTRY_VERSION and elemSize > 0 and
+                 rows > 0 and cols > 0 and
+                 rows <= available / elemSize / cols and
+                 rows * cols * elemSize == available;
+    if (not valid) {
+        ::munmap(ptr, size);
+        throw IOException("Invalid disk cache entry");
+    }
+
+    // The image owns the mapping
+    auto* u = new cv::UMatData(&ALLOCATOR);
+    u->data = u->origdata = data;
+    u->size = size;
+    u->refcount = 1;
+    cv::Mat m(header.rows, header.cols, header.type, data + sizeof(header));
+    m.u = u;
+    return {header, m};
+}
+}  // namespace
+
+// Get the modification time of a file in nanoseconds
+static auto MTime(const struct stat& st) -> std::int64_t
+{
+#ifdef __APPLE__
+    const auto& ts = st.st_mtimespec;
+#else
+    const auto& ts = st.st_mtim;
+#endif
+    return static_cast<std::int64_t>(ts.tv_sec) * 1'000'000'000 + ts.tv_nsec;
+}
+
+// List the entry files in a cache directory
+static auto ListEntries(const fs::path& dir) -> std::vector<EntryFile>
+{
+    std::vector<EntryFile> entries;
+    try {
+        for (const auto& it : fs::directory_iterator(dir)) {
+            const auto& path = it.path();
+            if (path.extension().string() != ENTRY_EXT) {
+                continue;
+            }
+            struct stat st{};
+            if (::stat(path.c_str(), &st) != 0) {
+                continue;
+            }
+            entries.push_back(
+                {path, static_cast<std::size_t>(st.st_size), MTime(st)});
+        }
+    } catch (const std::exception& e) {
+        Logger()->warn("Failed to scan disk cache: {}", e.what());
+    }
+    return entries;
+}
+
+// Remove a file. Returns whether it was removed.
+static auto RemoveFile(const fs::path& path) -> bool
+{
+    return ::unlink(path.c_str()) == 0;
+}
+
+DiskCache::DiskCache(fs::path dir, std::size_t capacity)
+    : dir_{std::move(dir)}, capacity_{capacity}
+{
+    try {
+        fs::create_directories(dir_);
+    } catch (const std::exception& e) {
+        throw IOException(
+            "Failed to create disk cache directory: " + dir_.string() + ": " +
+            e.what());
+    }
+
+    const std::lock_guard<std::mutex> lock(mutex_);
+    trim_to_(capacity_);
+}
+
+auto DiskCache::New(fs::path dir, std::size_t capacity) -> Pointer
+{
+    return std::make_shared<DiskCache>(std::move(dir), capacity);
+}
+
+auto DiskCache::SharedMemory(const std::string& name, std::size_t capacity)
+    -> Pointer
+{
+    // Use the system's shared memory filesystem when it has one
+    fs::path root{"/dev/shm"};
+    if (not fs::is_directory(root)) {
+        root = fs::temp_directory_path();
+    }
+    auto cache = New(root / name, capacity);
+    cache->setMapEntries(true);
+    return cache;
+}
+
+auto DiskCache::SourceStamp(const fs::path& path) -> Stamp
+{
+    struct stat st{};
+    if (::stat(path.c_str(), &st) != 0) {
+        return {};
+    }
+    return {static_cast<std::uint64_t>(st.st_size), MTime(st)};
+}
+
+auto DiskCache::directory() const -> fs::path { return dir_; }
+
+void DiskCache::setCapacity(std::size_t capacity)
+{
+    capacity_ = capacity;
+    trim();
+}
+
+auto DiskCache::capacity() const -> std::size_t { return capacity_; }
+
+void DiskCache::setMapEntries(bool b) { mapEntries_ = b; }
+
+auto DiskCache::mapEntries() const -> bool { return mapEntries_; }
+
+auto DiskCache::bytes() const -> std::size_t
+{
+    std::size_t bytes{0};
+    for (const auto& e : ListEntries(dir_)) {
+        bytes += e.size;
+    }
+    return bytes;
+}
+
+auto DiskCache::get(const std::string& key, const Stamp& stamp) -> cv::Mat
+{
+    auto path = entry_path_(key);
+    if (::access(path.c_str(), R_OK) != 0) {
+        misses_++;
+        return {};
+    }
+
+    try {
+        auto [header, m] = MapEntry(path);
+
+        // Stale entries are removed
+        if (not(Stamp{header.sourceSize, header.sourceMTime} == stamp)) {
+            remove_(path, sizeof(header) + m.total() * m.elemSize());
+            misses_++;
+            return {};
+        }
+
+        // Copy the image unless it may reference the mapping
+        if (not mapEntries_) {
+            m = m.clone();
+        }
+
+        // Mark as recently used
+        ::utimensat(AT_FDCWD, path.c_str(), nullptr, 0);
+        hits_++;
+        return m;
+    } catch (const IOException& e) {
+        // Removed by another process, or written by an incompatible version
+        Logger()->debug("Disk cache miss on {}: {}", path.string(), e.what());
+        remove_(path);
+        misses_++;
+        return {};
+    }
+}
+
+void DiskCache::put(
+    const std::string& key, const Stamp& stamp, const cv::Mat& m)
+{
+    if (m.empty()) {
+        return;
+    }
+    auto rowBytes = static_cast<std::size_t>(m.cols) * m.elemSize();
+    auto size = sizeof(EntryHeader) + rowBytes * m.rows;
+    if (size > capacity_) {
+        return;
+    }
+
+    EntryHeader header;
+    header.type = m.type();
+    header.rows = m.rows;
+    header.cols = m.cols;
+    header.sourceSize = stamp.size;
+    header.sourceMTime = stamp.mtime;
+
+    // Write to a unique temporary file so that readers never see a partial
+    // entry
+    static std::atomic<std::uint64_t> counter{0};
+    auto path = entry_path_(key);
+    auto tmpPath = path;
+    tmpPath += "." + std::to_string(::getpid()) + "." +
+               std::to_string(counter++) + TMP_EXT;
+    {
+        std::ofstream file(tmpPath.string(), std::ios::binary);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        for (int y = 0; y < m.rows; y++) {
+            file.write(
+                m.ptr<char>(y), static_cast<std::streamsize>(rowBytes));
+        }
+        file.close();
+        if (not file) {
+            Logger()->warn(
+                "Failed to write disk cache entry: {}", tmpPath.string());
+            RemoveFile(tmpPath);
+            return;
+        }
+    }
+    if (::rename(tmpPath.c_str(), path.c_str()) != 0) {
+        Logger()->warn(
+            "Failed to write disk cache entry {}: {}", path.string(),
+            std::strerror(errno));
+        RemoveFile(tmpPath);
+        return;
+    }
+
+    // Scan the directory once the entries may exceed the capacity
+    const std::lock_guard<std::mutex> lock(mutex_);
+    estimate_ += size;
+    if (estimate_ > capacity_) {
+        trim_to_(capacity_ / 10 * 9);
+    }
+}
+
+void DiskCache::remove(const std::string& key) { remove_(entry_path_(key)); }
+
+void DiskCache::trim()
+{
+    const std::lock_guard<std::mutex> lock(mutex_);
+    trim_to_(capacity_);
+}
+
+void DiskCache::purge()
+{
+    const std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& e : ListEntries(dir_)) {
+        RemoveFile(e.path);
+    }
+    estimate_ = 0;
+}
+
+auto DiskCache::hits() const -> std::uint64_t { return hits_; }
+
+auto DiskCache::misses() const -> std::uint64_t { return misses_; }
+
+auto DiskCache::entry_path_(const std::string& key) const -> fs::path
+{
+    return dir_ / (key + ENTRY_EXT);
+}
+
+void DiskCache::remove_(const fs::path& path)
+{
+    struct stat st{};
+    if (::stat(path.c_str(), &st) == 0) {
+        remove_(path, static_cast<std::size_t>(st.st_size));
+    }
+}
+
+void DiskCache::remove_(const fs::path& path, std::size_t size)
+{
+    if (RemoveFile(path)) {
+        const std::lock_guard<std::mutex> lock(mutex_);
+        estimate_ -= std::min(estimate_, size);
+    }
+}
+
+void DiskCache::trim_to_(std::size_t target)
+{
+    auto entries = ListEntries(dir_);
+    std::size_t total{0};
+    for (const auto& e : entries) {
+        total += e.size;
+    }
+
+    // Remove the least recently used entries first
+    if (total > target) {
+        std::sort(
+            entries.begin(), entries.end(),
+            [](const auto& a, const auto& b) { return a.mtime < b.mtime; });
+        for (const auto& e : entries) {
+            if (total <= target) {
+                break;
+            }
+            if (RemoveFile(e.path)) {
+                total -= e.size;
+            }
+        }
+    }
+    estimate_ = total;
+}
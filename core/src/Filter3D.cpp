@@ -0,0 +1,234 @@
+#include "vc/core/math/Filter3D.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <stdexcept>
+
+#include <opencv2/imgproc.hpp>
+
+#include "vc/core/util/CPUFeatures.hpp"
+
+using namespace volcart;
+
+namespace
+{
+// Index clamped to [0, n)
+auto Clamp(std::ptrdiff_t v, std::size_t n) -> std::size_t
+{
+    if (v < 0) {
+        return 0;
+    }
+    return std::min(static_cast<std::size_t>(v), n - 1);
+}
+
+// y += w * x. Kept as a plain loop over contiguous memory so that the
+// compiler can vectorize it, once per SIMD path. This file is compiled
+// without floating-point contraction, so the FMA of the AVX2 and AVX-512
+// paths is not used to fuse the multiply and add, which would change the
+// rounding.
+inline void AxpyLoop(double w, const double* x, double* y, std::size_t n)
+{
+    for (std::size_t i = 0; i < n; ++i) {
+        y[i] += w * x[i];
+    }
+}
+
+void AxpyScalar(double w, const double* x, double* y, std::size_t n)
+{
+    AxpyLoop(w, x, y, n);
+}
+
+#ifdef VC_SIMD_X86
+VC_TARGET_AVX2 void AxpyAVX2(
+    double w, const double* x, double* y, std::size_t n)
+{
+    AxpyLoop(w, x, y, n);
+}
+
+VC_TARGET_AVX512 void AxpyAVX512(
+    double w, const double* x, double* y, std::size_t n)
+{
+    AxpyLoop(w, x, y, n);
+}
+#endif
+
+auto AxpyKernels()
+{
+    simd::Kernels<decltype(&AxpyScalar)> k{AxpyScalar};
+#ifdef VC_SIMD_X86
+    k.avx2 = AxpyAVX2;
+    k.avx512 = AxpyAVX512;
+#endif
+    return k;
+}
+
+void Axpy(double w, const double* x, double* y, std::size_t n)
+{
+    static const auto kernel = AxpyKernels().select();
+    kernel(w, x, y, n);
+}
+
+// Correlate a single row with replicated borders
+void CorrelateRow(
+    const double* in, double* out, std::size_t n, const Kernel1D& k)
+{
+    const auto r = k.size() / 2;
+    std::fill(out, out + n, 0.0);
+
+    // Interior: every tap is in range
+    const auto lo = std::min(r, n);
+    const auto hi = (n > r) ? std::max(n - r, lo) : lo;
+    if (hi > lo) {
+        for (std::size_t i = 0; i < k.size(); ++i) {
+            Axpy(k[i], in + (lo - r + i), out + lo, hi - lo);
+        }
+    }
+
+    // Borders
+    auto border = [&](std::size_t x) {
+        double sum{0};
+        for (std::size_t i = 0; i < k.size(); ++i) {
+            auto src = static_cast<std::ptrdiff_t>(x + i) -
+                       static_cast<std::ptrdiff_t>(r);
+            sum += k[i] * in[Clamp(src, n)];
+        }
+        out[x] = sum;
+    };
+    for (std::size_t x = 0; x < lo; ++x) {
+        border(x);
+    }
+    for (std::size_t x = hi; x < n; ++x) {
+        border(x);
+    }
+}
+
+auto Offset(std::size_t v, std::size_t i, std::size_t r) -> std::ptrdiff_t
+{
+    return static_cast<std::ptrdiff_t>(v + i) - static_cast<std::ptrdiff_t>(r);
+}
+}  // namespace
+
+void volcart::ScaledAdd(
+    double w, const double* x, double* y, std::size_t n, simd::Path path)
+{
+    AxpyKernels().select(path)(w, x, y, n);
+}
+
+auto volcart::GaussianKernel1D(int radius, double sigma) -> Kernel1D
+{
+    if (radius < 0) {
+        throw std::invalid_argument("radius must be non-negative");
+    }
+    if (sigma <= 0) {
+        throw std::invalid_argument("sigma must be positive");
+    }
+
+    Kernel1D k;
+    k.reserve(2 * static_cast<std::size_t>(radius) + 1);
+    double sum{0};
+    for (int i = -radius; i <= radius; ++i) {
+        k.push_back(std::exp(-(i * i) / (2 * sigma * sigma)));
+        sum += k.back();
+    }
+    for (auto& v : k) {
+        v /= sum;
+    }
+    return k;
+}
+
+auto volcart::DerivativeKernels1D(int ksize) -> std::array<Kernel1D, 2>
+{
+    if (ksize != 1 and ksize != 3 and ksize != 5 and ksize != 7) {
+        throw std::invalid_argument("kernel size must be one of 1, 3, 5, 7");
+    }
+
+    cv::Mat deriv;
+    cv::Mat smooth;
+    cv::getDerivKernels(
+        deriv, smooth, 1, 0, (ksize == 3) ? cv::FILTER_SCHARR : ksize, false,
+        CV_64F);
+    return {
+        Kernel1D(deriv.begin<double>(), deriv.end<double>()),
+        Kernel1D(smooth.begin<double>(), smooth.end<double>())};
+}
+
+auto volcart::Correlate1D(
+    const Tensor3D<double>& input, const Kernel1D& kernel, TensorAxis axis)
+    -> Tensor3D<double>
+{
+    if (kernel.size() % 2 == 0 and not kernel.empty()) {
+        throw std::invalid_argument("kernel must have an odd number of taps");
+    }
+
+    const auto dx = input.dx();
+    const auto dy = input.dy();
+    const auto dz = input.dz();
+    Tensor3D<double> output(dx, dy, dz, false);
+    if (kernel.empty()) {
+        for (std::size_t z = 0; z < dz; ++z) {
+            input.xySlice(z).copyTo(output.xySlice(z));
+        }
+        return output;
+    }
+
+    const auto r = kernel.size() / 2;
+    for (std::size_t z = 0; z < dz; ++z) {
+        const auto& in = input.xySlice(z);
+        auto& out = output.xySlice(z);
+        for (std::size_t y = 0; y < dy; ++y) {
+            auto* dst = out[static_cast<int>(y)];
+            switch (axis) {
+                case TensorAxis::X:
+                    CorrelateRow(in[static_cast<int>(y)], dst, dx, kernel);
+                    break;
+                case TensorAxis::Y:
+                    std::fill(dst, dst + dx, 0.0);
+                    for (std::size_t i = 0; i < kernel.size(); ++i) {
+                        auto src = Clamp(Offset(y, i, r), dy);
+                        Axpy(kernel[i], in[static_cast<int>(src)], dst, dx);
+                    }
+                    break;
+                case TensorAxis::Z:
+                    std::fill(dst, dst + dx, 0.0);
+                    for (std::size_t i = 0; i < kernel.size(); ++i) {
+                        auto src = Clamp(Offset(z, i, r), dz);
+                        const auto& slice = input.xySlice(src);
+                        Axpy(kernel[i], slice[static_cast<int>(y)], dst, dx);
+                    }
+                    break;
+            }
+        }
+    }
+    return output;
+}
+
+auto volcart::SepFilter3D(
+    const Tensor3D<double>& input,
+    const Kernel1D& kx,
+    const Kernel1D& ky,
+    const Kernel1D& kz) -> Tensor3D<double>
+{
+    auto output = Correlate1D(input, kx, TensorAxis::X);
+    if (not ky.empty()) {
+        output = Correlate1D(output, ky, TensorAxis::Y);
+    }
+    if (not kz.empty()) {
+        output = Correlate1D(output, kz, TensorAxis::Z);
+    }
+    return output;
+}
+
+auto volcart::Gradient3D(const Tensor3D<double>& input, int ksize)
+    -> std::array<Tensor3D<double>, 3>
+{
+    const auto [deriv, smooth] = DerivativeKernels1D(ksize);
+
+    // Y and Z are both smoothed along X
+    auto smoothX = Correlate1D(input, smooth, TensorAxis::X);
+    auto gx = Correlate1D(input, deriv, TensorAxis::X);
+    return {
+        Correlate1D(gx, smooth, TensorAxis::Y),
+        Correlate1D(smoothX, deriv, TensorAxis::Y),
+        Correlate1D(smoothX, deriv, TensorAxis::Z)};
+}
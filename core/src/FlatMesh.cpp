@@ -0,0 +1,250 @@
+#include "vc/core/types/FlatMesh.hpp"
+
+#include <limits>
+#include <stdexcept>
+
+#include "vc/core/util/ThreadPool.hpp"
+
+using namespace volcart;
+
+namespace
+{
+// Meshes smaller than this aren't worth splitting between threads
+constexpr std::size_t PARALLEL_MIN_FACES{4096};
+}  // namespace
+
+auto FlatMesh::numVertices() const -> std::size_t { return vertices_.size(); }
+
+auto FlatMesh::numFaces() const -> std::size_t { return faces_.size(); }
+
+auto FlatMesh::hasNormals() const -> bool
+{
+    return not vertices_.empty() and normals_.size() == vertices_.size();
+}
+
+auto FlatMesh::hasUVs() const -> bool
+{
+    return not vertices_.empty() and uvs_.size() == vertices_.size();
+}
+
+void FlatMesh::reserve(std::size_t numVertices, std::size_t numFaces)
+{
+    vertices_.reserve(numVertices);
+    faces_.reserve(numFaces);
+}
+
+void FlatMesh::clear()
+{
+    vertices_.clear();
+    faces_.clear();
+    normals_.clear();
+    uvs_.clear();
+}
+
+auto FlatMesh::addVertex(const Vertex& v) -> Index
+{
+    if (vertices_.size() > std::numeric_limits<Index>::max()) {
+        throw std::overflow_error("FlatMesh vertex index overflow");
+    }
+    vertices_.push_back(v);
+    return static_cast<Index>(vertices_.size() - 1);
+}
+
+auto FlatMesh::addFace(Index a, Index b, Index c) -> std::size_t
+{
+    const auto n = vertices_.size();
+    if (a >= n or b >= n or c >= n) {
+        throw std::out_of_range("FlatMesh face vertex index out of range");
+    }
+    faces_.push_back({a, b, c});
+    return faces_.size() - 1;
+}
+
+auto FlatMesh::vertices() -> std::vector<Vertex>& { return vertices_; }
+
+auto FlatMesh::vertices() const -> const std::vector<Vertex>&
+{
+    return vertices_;
+}
+
+auto FlatMesh::faces() -> std::vector<Face>& { return faces_; }
+
+auto FlatMesh::faces() const -> const std::vector<Face>& { return faces_; }
+
+auto FlatMesh::normals() -> std::vector<Normal>& { return normals_; }
+
+auto FlatMesh::normals() const -> const std::vector<Normal>&
+{
+    return normals_;
+}
+
+auto FlatMesh::uvs() -> std::vector<UV>& { return uvs_; }
+
+auto FlatMesh::uvs() const -> const std::vector<UV>& { return uvs_; }
+
+void FlatMesh::computeNormals(std::size_t numThreads)
+{
+    auto faceNormal = [this](const Face& f) {
+        const auto& v0 = vertices_[f[0]];
+        const auto e0 = vertices_[f[2]] - v0;
+        const auto e1 = vertices_[f[1]] - v0;
+        return e1.cross(e0);
+    };
+
+    if (numThreads == 0) {
+        numThreads = ThreadPool::Global().numThreads();
+    }
+    if (numThreads == 1 or faces_.size() < PARALLEL_MIN_FACES) {
+        normals_.assign(vertices_.size(), Normal(0, 0, 0));
+        for (const auto& f : faces_) {
+            const auto n = faceNormal(f);
+            normals_[f[0]] += n;
+            normals_[f[1]] += n;
+            normals_[f[2]] += n;
+        }
+        for (auto& n : normals_) {
+            n = cv::normalize(n);
+        }
+        return;
+    }
+
+    // Vertex-to-face adjacency, with each vertex's faces in face order
+    const auto numVerts = vertices_.size();
+    std::vector<std::size_t> offsets(numVerts + 1, 0);
+    for (const auto& f : faces_) {
+        ++offsets[f[0] + 1];
+        ++offsets[f[1] + 1];
+        ++offsets[f[2] + 1];
+    }
+    for (std::size_t i = 0; i < numVerts; ++i) {
+        offsets[i + 1] += offsets[i];
+    }
+    std::vector<std::size_t> adjacent(offsets.back());
+    {
+        auto next = offsets;
+        for (std::size_t i = 0; i < faces_.size(); ++i) {
+            for (const auto v : faces_[i]) {
+                adjacent[next[v]++] = i;
+            }
+        }
+    }
+
+    // Face normals
+    std::vector<Normal> faceNormals(faces_.size());
+    ParallelChunks(faces_.size(), numThreads, [&](auto begin, auto end) {
+        for (auto i = begin; i < end; ++i) {
+            faceNormals[i] = faceNormal(faces_[i]);
+        }
+    });
+
+    // Gather and normalize
+    normals_.resize(numVerts);
+    ParallelChunks(numVerts, numThreads, [&](auto begin, auto end) {
+        for (auto v = begin; v < end; ++v) {
+            Normal n(0, 0, 0);
+            for (auto i = offsets[v]; i < offsets[v + 1]; ++i) {
+                n += faceNormals[adjacent[i]];
+            }
+            normals_[v] = cv::normalize(n);
+        }
+    });
+}
+
+auto volcart::ToFlatMesh(const ITKMesh::Pointer& mesh) -> FlatMesh
+{
+    const auto numPts = mesh->GetNumberOfPoints();
+    if (numPts > std::numeric_limits<FlatMesh::Index>::max()) {
+        throw std::overflow_error("Mesh has too many vertices for FlatMesh");
+    }
+
+    FlatMesh out;
+    auto& vertices = out.vertices();
+    vertices.resize(numPts);
+    for (auto pt = mesh->GetPoints()->Begin(); pt != mesh->GetPoints()->End();
+         ++pt) {
+        if (pt.Index() >= numPts) {
+            throw std::invalid_argument("Mesh point IDs are not contiguous");
+        }
+        const auto& p = pt.Value();
+        vertices[pt.Index()] = {p[0], p[1], p[2]};
+    }
+
+    // Point data is only meaningful if every vertex has a normal
+    const auto* pointData = mesh->GetPointData();
+    if (pointData != nullptr and pointData->Size() == numPts and numPts > 0) {
+        auto& normals = out.normals();
+        normals.resize(numPts);
+        for (auto n = pointData->Begin(); n != pointData->End(); ++n) {
+            if (n.Index() < numPts) {
+                const auto& v = n.Value();
+                normals[n.Index()] = {v[0], v[1], v[2]};
+            }
+        }
+    }
+
+    auto& faces = out.faces();
+    faces.reserve(mesh->GetNumberOfCells());
+    for (auto cell = mesh->GetCells()->Begin();
+         cell != mesh->GetCells()->End(); ++cell) {
+        if (cell.Value()->GetNumberOfPoints() != 3) {
+            throw std::invalid_argument("FlatMesh only supports triangles");
+        }
+        const auto* ids = cell.Value()->GetPointIds();
+        faces.push_back(
+            {static_cast<FlatMesh::Index>(ids[0]),
+             static_cast<FlatMesh::Index>(ids[1]),
+             static_cast<FlatMesh::Index>(ids[2])});
+    }
+
+    return out;
+}
+
+auto volcart::ToITKMesh(const FlatMesh& mesh) -> ITKMesh::Pointer
+{
+    auto out = ITKMesh::New();
+
+    // Fill the containers directly rather than one SetPoint() at a time
+    const auto& vertices = mesh.vertices();
+    auto points = ITKPointsContainer::New();
+    auto& outPts = points->CastToSTLContainer();
+    outPts.resize(vertices.size());
+    ParallelChunks(vertices.size(), 0, [&](auto begin, auto end) {
+        for (auto i = begin; i < end; ++i) {
+            outPts[i][0] = vertices[i][0];
+            outPts[i][1] = vertices[i][1];
+            outPts[i][2] = vertices[i][2];
+        }
+    });
+    out->SetPoints(points);
+
+    if (mesh.hasNormals()) {
+        const auto& normals = mesh.normals();
+        auto pointData = ITKMesh::PointDataContainer::New();
+        auto& outData = pointData->CastToSTLContainer();
+        outData.resize(normals.size());
+        ParallelChunks(normals.size(), 0, [&](auto begin, auto end) {
+            for (auto i = begin; i < end; ++i) {
+                outData[i] = ITKPixel(normals[i].val);
+            }
+        });
+        out->SetPointData(pointData);
+    }
+
+    // Every cell is a separate allocation, so allocate them in parallel
+    const auto& faces = mesh.faces();
+    auto cells = ITKMesh::CellsContainer::New();
+    auto& outCells = cells->CastToSTLContainer();
+    outCells.resize(faces.size(), nullptr);
+    ParallelChunks(faces.size(), 0, [&](auto begin, auto end) {
+        for (auto i = begin; i < end; ++i) {
+            auto* cell = new ITKTriangle;
+            cell->SetPointId(0, faces[i][0]);
+            cell->SetPointId(1, faces[i][1]);
+            cell->SetPointId(2, faces[i][2]);
+            outCells[i] = cell;
+        }
+    });
+    out->SetCells(cells);
+
+    return out;
+}
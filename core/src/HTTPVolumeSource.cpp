@@ -0,0 +1,375 @@
+#include "vc/core/io/HTTPVolumeSource.hpp"
+
+#include <stdexcept>
+
+#ifdef VC_HAS_CURL
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <mutex>
+#include <thread>
+
+#include <curl/curl.h>
+#include <strings.h>
+
+#include "vc/core/Version.hpp"
+#include "vc/core/types/Exceptions.hpp"
+#endif
+
+using namespace volcart;
+using namespace volcart::io;
+
+static const std::string S3_SCHEME{"s3://"};
+
+#ifdef VC_HAS_CURL
+namespace
+{
+// Destination of the body of a request
+struct Transfer {
+    std::vector<char>* data{nullptr};
+    // Whether the body is written into a preallocated range of data, rather
+    // than appended to it
+    bool fixed{false};
+    // Range of data which is written when fixed
+    std::size_t begin{0};
+    std::size_t end{0};
+    // Write position when fixed
+    std::size_t pos{0};
+    // Value of the Content-Range response header
+    std::string contentRange;
+
+    // Prepare for a new attempt
+    void reset()
+    {
+        if (not fixed) {
+            data->clear();
+        }
+        pos = begin;
+        contentRange.clear();
+    }
+};
+
+// Frees a header list
+struct HeaderListDeleter {
+    void operator()(curl_slist* l) const { curl_slist_free_all(l); }
+};
+using HeaderList = std::unique_ptr<curl_slist, HeaderListDeleter>;
+
+// Initialize libcurl once per process
+void GlobalInit()
+{
+    static std::once_flag flag;
+    std::call_once(flag, []() { curl_global_init(CURL_GLOBAL_DEFAULT); });
+}
+
+auto WriteBody(char* ptr, std::size_t size, std::size_t nmemb, void* user)
+    -> std::size_t
+{
+    auto* t = static_cast<Transfer*>(user);
+    auto n = size * nmemb;
+    if (not t->fixed) {
+        t->data->insert(t->data->end(), ptr, ptr + n);
+        return n;
+    }
+    // Returning less than n aborts the transfer
+    if (t->pos + n > t->end) {
+        return 0;
+    }
+    std::copy(ptr, ptr + n, t->data->begin() + t->pos);
+    t->pos += n;
+    return n;
+}
+
+auto WriteHeader(char* buf, std::size_t size, std::size_t nitems, void* user)
+    -> std::size_t
+{
+    auto* t = static_cast<Transfer*>(user);
+    auto n = size * nitems;
+    static const std::string key{"content-range:"};
+    if (n > key.size() and ::strncasecmp(buf, key.c_str(), key.size()) == 0) {
+        t->contentRange.assign(buf + key.size(), n - key.size());
+    }
+    return n;
+}
+
+// Get the object size from a Content-Range value: `bytes 0-1023/4096`
+auto RangeTotal(const std::string& contentRange) -> std::optional<std::size_t>
+{
+    auto slash = contentRange.find('/');
+    if (slash == std::string::npos) {
+        return std::nullopt;
+    }
+    try {
+        return std::stoull(contentRange.substr(slash + 1));
+    } catch (const std::exception&) {
+        return std::nullopt;
+    }
+}
+
+// Download a URL, or a byte range of it, into a Transfer. Connection errors
+// and server errors are retried. Returns the final HTTP status code.
+auto Perform(
+    CURL* c,
+    const std::string& url,
+    const std::string& range,
+    curl_slist* headers,
+    const HTTPVolumeSource::Options& opts,
+    Transfer& t) -> long
+{
+    static const auto userAgent = ProjectInfo::NameAndVersion();
+    for (int attempt = 0;; attempt++) {
+        t.reset();
+        curl_easy_reset(c);
+        curl_easy_setopt(c, CURLOPT_URL, url.c_str());
+        curl_easy_setopt(c, CURLOPT_FOLLOWLOCATION, 1L);
+        curl_easy_setopt(c, CURLOPT_NOSIGNAL, 1L);
+        curl_easy_setopt(c, CURLOPT_TIMEOUT, opts.timeout);
+        curl_easy_setopt(c, CURLOPT_USERAGENT, userAgent.c_str());
+        curl_easy_setopt(c, CURLOPT_HTTPHEADER, headers);
+        curl_easy_setopt(c, CURLOPT_WRITEFUNCTION, WriteBody);
+        curl_easy_setopt(c, CURLOPT_WRITEDATA, &t);
+        curl_easy_setopt(c, CURLOPT_HEADERFUNCTION, WriteHeader);
+        curl_easy_setopt(c, CURLOPT_HEADERDATA, &t);
+        if (not range.empty()) {
+            curl_easy_setopt(c, CURLOPT_RANGE, range.c_str());
+        }
+
+        auto res = curl_easy_perform(c);
+        long status{0};
+        if (res == CURLE_OK) {
+            curl_easy_getinfo(c, CURLINFO_RESPONSE_CODE, &status);
+            if (status < 500 and status != 429) {
+                return status;
+            }
+        }
+        if (attempt >= opts.retries) {
+            auto reason = (res == CURLE_OK) ? "HTTP " + std::to_string(status)
+                                            : curl_easy_strerror(res);
+            throw IOException("Failed to download " + url + ": " + reason);
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(100 << attempt));
+    }
+}
+
+// Get a byte range header value for [begin, end)
+auto RangeString(std::size_t begin, std::size_t end) -> std::string
+{
+    return std::to_string(begin) + "-" + std::to_string(end - 1);
+}
+}  // namespace
+
+struct HTTPVolumeSource::Connections {
+    std::mutex mutex;
+    std::vector<CURL*> idle;
+
+    ~Connections()
+    {
+        for (auto* c : idle) {
+            curl_easy_cleanup(c);
+        }
+    }
+
+    // Get a handle, reusing an idle handle and its open connections
+    auto acquire() -> CURL*
+    {
+        {
+            const std::lock_guard<std::mutex> lock(mutex);
+            if (not idle.empty()) {
+                auto* c = idle.back();
+                idle.pop_back();
+                return c;
+            }
+        }
+        auto* c = curl_easy_init();
+        if (c == nullptr) {
+            throw IOException("Failed to create HTTP connection");
+        }
+        return c;
+    }
+
+    void release(CURL* c)
+    {
+        const std::lock_guard<std::mutex> lock(mutex);
+        idle.push_back(c);
+    }
+
+    // Returns a handle to the pool when destroyed
+    class Handle
+    {
+    public:
+        explicit Handle(Connections& pool) : pool_{pool}, curl_{pool.acquire()}
+        {
+        }
+        ~Handle() { pool_.release(curl_); }
+        Handle(const Handle&) = delete;
+        auto operator=(const Handle&) -> Handle& = delete;
+
+        [[nodiscard]] auto get() const -> CURL* { return curl_; }
+
+    private:
+        Connections& pool_;
+        CURL* curl_;
+    };
+};
+
+#else
+struct HTTPVolumeSource::Connections {
+};
+#endif
+
+HTTPVolumeSource::HTTPVolumeSource(std::string baseURL, Options options)
+    : baseURL_{ResolveURL(baseURL)}, options_{std::move(options)}
+{
+#ifdef VC_HAS_CURL
+    GlobalInit();
+    while (not baseURL_.empty() and baseURL_.back() == '/') {
+        baseURL_.pop_back();
+    }
+    options_.chunkSize = std::max<std::size_t>(options_.chunkSize, 1);
+    options_.maxConnections = std::max<std::size_t>(options_.maxConnections, 1);
+    connections_ = std::make_unique<Connections>();
+#else
+    throw std::runtime_error(
+        "HTTP volume sources require libcurl. Rebuild with VC_WITH_CURL.");
+#endif
+}
+
+auto HTTPVolumeSource::New(std::string baseURL, Options options) -> Pointer
+{
+    return std::make_shared<HTTPVolumeSource>(
+        std::move(baseURL), std::move(options));
+}
+
+HTTPVolumeSource::~HTTPVolumeSource() = default;
+
+auto HTTPVolumeSource::Available() -> bool
+{
+#ifdef VC_HAS_CURL
+    return true;
+#else
+    return false;
+#endif
+}
+
+auto HTTPVolumeSource::ResolveURL(const std::string& url) -> std::string
+{
+    if (url.compare(0, S3_SCHEME.size(), S3_SCHEME) != 0) {
+        return url;
+    }
+    auto path = url.substr(S3_SCHEME.size());
+    auto slash = path.find('/');
+    auto bucket = path.substr(0, slash);
+    auto prefix = (slash == std::string::npos) ? "" : path.substr(slash);
+    return "https://" + bucket + ".s3.amazonaws.com" + prefix;
+}
+
+auto HTTPVolumeSource::options() const -> const Options& { return options_; }
+
+auto HTTPVolumeSource::read(const std::string& name)
+    -> std::optional<std::vector<char>>
+{
+#ifdef VC_HAS_CURL
+    auto url = baseURL_ + "/" + name;
+    HeaderList headers;
+    for (const auto& h : options_.headers) {
+        auto* l = curl_slist_append(headers.get(), h.c_str());
+        if (l == nullptr) {
+            throw IOException("Failed to set HTTP request headers");
+        }
+        // The list head does not change after the first append
+        headers.release();
+        headers.reset(l);
+    }
+
+    // The first range also tells us the size of the object
+    std::vector<char> data;
+    Transfer first;
+    first.data = &data;
+    {
+        Connections::Handle handle(*connections_);
+        auto status = Perform(
+            handle.get(), url, RangeString(0, options_.chunkSize),
+            headers.get(), options_, first);
+        if (status == 404 or status == 410) {
+            return std::nullopt;
+        }
+        // Empty objects cannot satisfy any range
+        if (status == 416) {
+            return std::vector<char>{};
+        }
+        // The server ignored the range and sent the whole object
+        if (status == 200) {
+            return data;
+        }
+        if (status != 206) {
+            throw IOException(
+                "Failed to download " + url + ": HTTP " +
+                std::to_string(status));
+        }
+    }
+    auto total = RangeTotal(first.contentRange);
+    if (not total) {
+        throw IOException("Failed to download " + url + ": Unknown size");
+    }
+    if (data.size() >= *total) {
+        data.resize(*total);
+        return data;
+    }
+
+    // Download the remaining ranges concurrently
+    auto offset = data.size();
+    auto chunk = options_.chunkSize;
+    auto numChunks = (*total - offset + chunk - 1) / chunk;
+    data.resize(*total);
+    auto numThreads = std::min(options_.maxConnections, numChunks);
+    std::atomic<std::size_t> next{0};
+    std::vector<std::exception_ptr> errors(numThreads);
+    std::vector<std::thread> threads;
+    for (std::size_t i = 0; i < numThreads; i++) {
+        threads.emplace_back([&, i]() {
+            try {
+                Connections::Handle handle(*connections_);
+                for (auto n = next++; n < numChunks; n = next++) {
+                    Transfer t;
+                    t.data = &data;
+                    t.fixed = true;
+                    t.begin = offset + n * chunk;
+                    t.end = std::min(t.begin + chunk, *total);
+                    auto status = Perform(
+                        handle.get(), url, RangeString(t.begin, t.end),
+                        headers.get(), options_, t);
+                    if (status != 206 or t.pos != t.end) {
+                        throw IOException(
+                            "Failed to download " + url + ": Bad response " +
+                            "to range request (HTTP " +
+                            std::to_string(status) + ")");
+                    }
+                }
+            } catch (...) {
+                errors[i] = std::current_exception();
+                next = numChunks;
+            }
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    for (const auto& e : errors) {
+        if (e) {
+            std::rethrow_exception(e);
+        }
+    }
+    return data;
+#else
+    throw std::runtime_error(
+        "HTTP volume sources require libcurl. Rebuild with VC_WITH_CURL.");
+#endif
+}
+
+auto HTTPVolumeSource::stamp(const std::string& /*name*/) -> DiskCache::Stamp
+{
+    return {1, 0};
+}
+
+auto HTTPVolumeSource::uri() const -> std::string { return baseURL_; }
@@ -1,31 +1,80 @@
 #include "vc/core/util/ImageConversion.hpp"
 
+#include <limits>
+#include <mutex>
+
+#include "vc/core/util/ThreadPool.hpp"
+
 namespace vc = volcart;
 
-static inline auto CreateAlphaChannel(const cv::Size& size, int depth)
-    -> cv::Mat
+// Images smaller than this many pixels are converted on the calling thread
+static constexpr std::size_t MIN_PARALLEL_PIXELS{1 << 16};
+
+// Call f(rows) for contiguous row ranges of a 2D image, in parallel for large
+// images
+template <class F>
+static void ForEachRowRange(const cv::Mat& m, F&& f)
+{
+    if (m.total() < MIN_PARALLEL_PIXELS) {
+        f(cv::Range(0, m.rows));
+        return;
+    }
+    ParallelChunks(m.rows, 0, [&f](auto begin, auto end) {
+        f(cv::Range(static_cast<int>(begin), static_cast<int>(end)));
+    });
+}
+
+// Min and max value across all channels of an image
+static void MinMax(const cv::Mat& m, double& min, double& max)
+{
+    min = std::numeric_limits<double>::max();
+    max = std::numeric_limits<double>::lowest();
+    std::mutex mutex;
+    ForEachRowRange(m, [&](const cv::Range& rows) {
+        double lo{0};
+        double hi{0};
+        // Treat channels as columns to get the range across all channels
+        cv::minMaxIdx(m.rowRange(rows).reshape(1), &lo, &hi);
+        const std::lock_guard<std::mutex> lock(mutex);
+        min = std::min(min, lo);
+        max = std::max(max, hi);
+    });
+}
+
+// Opaque alpha value for an image depth
+static inline auto AlphaValue(int depth) -> double
 {
-    // Create and scale the alpha channel
-    cv::Mat alpha = cv::Mat::ones(size, depth);
-    switch (alpha.depth()) {
+    switch (depth) {
         case CV_8U:
-            alpha *= std::numeric_limits<uint8_t>::max();
-            break;
+            return std::numeric_limits<uint8_t>::max();
         case CV_8S:
-            alpha *= std::numeric_limits<int8_t>::max();
-            break;
+            return std::numeric_limits<int8_t>::max();
         case CV_16U:
-            alpha *= std::numeric_limits<uint16_t>::max();
-            break;
+            return std::numeric_limits<uint16_t>::max();
         case CV_16S:
-            alpha *= std::numeric_limits<int16_t>::max();
-            break;
+            return std::numeric_limits<int16_t>::max();
         default:
-            // do nothing
-            break;
+            return 1;
     }
+}
 
-    return alpha;
+// Build an image with `channels` channels by copying channels of the inputs
+// in a single pass. Inputs are numbered as in cv::mixChannels. Output
+// channels which are not copied are filled with `fill`.
+static auto MixChannels(
+    const std::vector<cv::Mat>& src,
+    int channels,
+    const std::vector<int>& fromTo,
+    double fill = 0) -> cv::Mat
+{
+    const auto& m = src.front();
+    cv::Mat output(m.rows, m.cols, CV_MAKETYPE(m.depth(), channels));
+    if (fromTo.size() / 2 < static_cast<std::size_t>(channels)) {
+        output.setTo(cv::Scalar::all(fill));
+    }
+    std::vector<cv::Mat> dst{output};
+    cv::mixChannels(src, dst, fromTo);
+    return output;
 }
 
 auto vc::DepthToString(int depth) -> std::string
@@ -56,9 +105,6 @@ auto vc::QuantizeImage(const cv::Mat& m, int depth, bool scaleMinMax) -> cv::Mat
         return m;
     }
 
-    // Copy to output
-    auto output = m.clone();
-
     // Setup the max value for integer images
     double outputMax{1.0};
     switch (depth) {
@@ -83,7 +129,7 @@ auto vc::QuantizeImage(const cv::Mat& m, int depth, bool scaleMinMax) -> cv::Mat
     double min{0};
     double max{1};
     if (scaleMinMax) {
-        cv::minMaxLoc(output, &min, &max);
+        MinMax(m, min, max);
     } else {
         switch (m.depth()) {
             case CV_8U:
@@ -103,8 +149,15 @@ auto vc::QuantizeImage(const cv::Mat& m, int depth, bool scaleMinMax) -> cv::Mat
                 break;
         }
     }
-    output.convertTo(
-        output, depth, outputMax / (max - min), -min * outputMax / (max - min));
+
+    // Convert in row ranges, e.g. to share the work of large textures
+    auto alpha = outputMax / (max - min);
+    auto beta = -min * outputMax / (max - min);
+    cv::Mat output(m.rows, m.cols, CV_MAKETYPE(depth, m.channels()));
+    ForEachRowRange(m, [&](const cv::Range& rows) {
+        auto out = output.rowRange(rows);
+        m.rowRange(rows).convertTo(out, depth, alpha, beta);
+    });
 
     return output;
 }
@@ -131,8 +184,7 @@ auto vc::ColorConvertImage(const cv::Mat& m, int channels) -> cv::Mat
 
     // 1 -> 2
     else if (ic == 1 && oc == 2) {
-        auto alpha = CreateAlphaChannel(m.size(), m.depth());
-        cv::merge(std::vector<cv::Mat>{m, alpha}, output);
+        output = MixChannels({m}, 2, {0, 0}, AlphaValue(m.depth()));
     }
 
     // 1 -> 4
@@ -142,23 +194,17 @@ auto vc::ColorConvertImage(const cv::Mat& m, int channels) -> cv::Mat
 
     // 2 -> 1
     else if (ic == 2 && oc == 1) {
-        std::vector<cv::Mat> cns;
-        cv::split(m, cns);
-        output = cns[0];
+        cv::extractChannel(m, output, 0);
     }
 
     // 2 -> 3
     else if (ic == 2 && oc == 3) {
-        std::vector<cv::Mat> cns;
-        cv::split(m, cns);
-        cv::merge(std::vector<cv::Mat>{cns[0], cns[0], cns[0]}, output);
+        output = MixChannels({m}, 3, {0, 0, 0, 1, 0, 2});
     }
 
     // 2 -> 4
     else if (ic == 2 && oc == 4) {
-        std::vector<cv::Mat> cns;
-        cv::split(m, cns);
-        cv::merge(std::vector<cv::Mat>{cns[0], cns[0], cns[0], cns[1]}, output);
+        output = MixChannels({m}, 4, {0, 0, 0, 1, 0, 2, 1, 3});
     }
 
     // 3 -> 1
@@ -173,8 +219,7 @@ auto vc::ColorConvertImage(const cv::Mat& m, int channels) -> cv::Mat
         cv::cvtColor(m, gray, cv::COLOR_BGR2GRAY);
 
         // Add alpha
-        auto alpha = CreateAlphaChannel(m.size(), m.depth());
-        cv::merge(std::vector<cv::Mat>{gray, alpha}, output);
+        output = MixChannels({gray}, 2, {0, 0}, AlphaValue(m.depth()));
     }
 
     // 3 -> 4
@@ -193,12 +238,8 @@ auto vc::ColorConvertImage(const cv::Mat& m, int channels) -> cv::Mat
         cv::Mat gray;
         cv::cvtColor(m, gray, cv::COLOR_BGRA2GRAY);
 
-        // Extract alpha
-        std::vector<cv::Mat> cns;
-        cv::split(m, cns);
-
-        // Merge gray + alpha
-        cv::merge(std::vector<cv::Mat>{gray, cns[3]}, output);
+        // Merge gray + alpha. Channel 4 is the alpha channel of m.
+        output = MixChannels({gray, m}, 2, {0, 0, 4, 1});
     }
 
     // 4 -> 3
@@ -2,6 +2,7 @@
 
 #include <opencv2/imgcodecs.hpp>
 
+#include "vc/core/io/DeepZoomWriter.hpp"
 #include "vc/core/io/FileExtensionFilter.hpp"
 #include "vc/core/io/TIFFIO.hpp"
 #include "vc/core/util/ImageConversion.hpp"
@@ -30,6 +31,7 @@ void vc::WriteImage(
     auto isJPG = IsFileType(path, {"jpg", "jpeg"});
     auto isPNG = IsFileType(path, {"png"});
     auto isTIF = IsFileType(path, {"tif", "tiff"});
+    auto isDZI = IsFileType(path, {"dzi"});
 
     // Use our TIFF writer
     if (isTIF) {
@@ -55,7 +57,9 @@ void vc::WriteImage(
 
         // Rescale values as needed
         bool needsRescale = (img.depth() == CV_32F or img.depth() == CV_64F) or
-                            (isJPG and img.depth() != CV_8U);
+                            (isJPG and img.depth() != CV_8U) or
+                            (isDZI and img.depth() != CV_8U and
+                             img.depth() != CV_16U);
 
         if (needsRescale) {
             auto depth = DepthToString(img.depth());
@@ -64,13 +68,23 @@ void vc::WriteImage(
                 "depth. Image will be min-max scaled to the maximum "
                 "supported bit depth.",
                 depth, path.extension().string());
-            if (isPNG) {
+            if (isPNG or isDZI) {
                 output = QuantizeImage(output, CV_16U);
             } else {
                 output = QuantizeImage(output, CV_8U);
             }
         }
 
+        // Deep Zoom tile pyramid
+        if (isDZI) {
+            DeepZoomWriter writer(
+                path, output.cols, output.rows, output.type());
+            writer.setNumThreads(0);
+            writer.writeRegion({0, 0}, output);
+            writer.close();
+            return;
+        }
+
         // imwrite params
         std::vector<int> params;
         if (opts.compression) {
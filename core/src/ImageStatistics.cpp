@@ -0,0 +1,305 @@
+#include "vc/core/types/ImageStatistics.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <mutex>
+#include <stdexcept>
+#include <type_traits>
+
+#include "vc/core/util/ThreadPool.hpp"
+
+using namespace volcart;
+
+namespace
+{
+// Histogram bins of 16-bit and binned depths
+constexpr std::size_t WIDE_BINS{1 << 16};
+
+auto IsSupported(int depth) -> bool
+{
+    switch (depth) {
+        case CV_8U:
+        case CV_8S:
+        case CV_16U:
+        case CV_16S:
+        case CV_32S:
+        case CV_32F:
+        case CV_64F:
+            return true;
+        default:
+            return false;
+    }
+}
+
+auto NumBins(int depth) -> std::size_t
+{
+    return (depth == CV_8U or depth == CV_8S) ? 256 : WIDE_BINS;
+}
+
+// Map a float to an unsigned integer with the same sort order
+auto FloatToKey(float v) -> std::uint32_t
+{
+    std::uint32_t bits{0};
+    std::memcpy(&bits, &v, sizeof(bits));
+    return (bits & 0x80000000U) ? ~bits : bits | 0x80000000U;
+}
+
+// Inverse of FloatToKey
+auto KeyToFloat(std::uint32_t key) -> float
+{
+    auto bits = (key & 0x80000000U) ? key & 0x7FFFFFFFU : ~key;
+    float v{0};
+    std::memcpy(&v, &bits, sizeof(v));
+    return v;
+}
+
+// Histogram bin of a value
+template <typename T>
+auto Bin(T v) -> std::size_t
+{
+    if constexpr (std::is_same_v<T, std::uint8_t> or
+                  std::is_same_v<T, std::uint16_t>) {
+        return v;
+    } else if constexpr (std::is_same_v<T, std::int8_t>) {
+        return static_cast<std::size_t>(v + 128);
+    } else if constexpr (std::is_same_v<T, std::int16_t>) {
+        return static_cast<std::size_t>(v + 32768);
+    } else {
+        return FloatToKey(static_cast<float>(v)) >> 16;
+    }
+}
+
+// Statistics of one chunk of rows. Sums are taken relative to the first
+// value to limit the cancellation in the variance.
+struct Accumulator {
+    explicit Accumulator(std::size_t bins) : histogram(bins, 0) {}
+
+    template <typename T>
+    void add(T v)
+    {
+        auto d = static_cast<double>(v);
+        if (count == 0) {
+            shift = d;
+            min = max = d;
+        }
+        histogram[Bin(v)]++;
+        count++;
+        min = std::min(min, d);
+        max = std::max(max, d);
+        sum += d - shift;
+        sumSq += (d - shift) * (d - shift);
+    }
+
+    std::vector<std::uint64_t> histogram;
+    std::uint64_t count{0};
+    double shift{0};
+    double min{0};
+    double max{0};
+    double sum{0};
+    double sumSq{0};
+};
+
+template <typename T>
+void AccumulateRows(
+    const cv::Mat& img, const cv::Mat& mask, int begin, int end, Accumulator& a)
+{
+    for (auto y = begin; y < end; y++) {
+        const auto* row = img.ptr<T>(y);
+        const auto* m = mask.empty() ? nullptr : mask.ptr<std::uint8_t>(y);
+        for (int x = 0; x < img.cols; x++) {
+            if (m != nullptr and m[x] == 0) {
+                continue;
+            }
+            if constexpr (std::is_floating_point_v<T>) {
+                if (std::isnan(row[x])) {
+                    continue;
+                }
+            }
+            a.add(row[x]);
+        }
+    }
+}
+}  // namespace
+
+void ImageStatistics::add(const cv::Mat& img, const cv::Mat& mask)
+{
+    if (img.channels() != 1) {
+        throw std::invalid_argument("Statistics require a 1-channel image");
+    }
+    if (not IsSupported(img.depth())) {
+        throw std::invalid_argument("Unsupported image depth");
+    }
+    if (depth_ != -1 and img.depth() != depth_) {
+        throw std::invalid_argument("Image depth differs from added images");
+    }
+    if (not mask.empty() and
+        (mask.type() != CV_8UC1 or mask.size() != img.size())) {
+        throw std::invalid_argument("Mask must be CV_8UC1 and match image");
+    }
+    if (depth_ == -1) {
+        depth_ = img.depth();
+        histogram_.assign(NumBins(depth_), 0);
+    }
+
+    std::mutex mutex;
+    auto rows = static_cast<std::size_t>(img.rows);
+    ParallelChunks(rows, 0, [&](auto begin, auto end) {
+        Accumulator a(histogram_.size());
+        auto b = static_cast<int>(begin);
+        auto e = static_cast<int>(end);
+        switch (depth_) {
+            case CV_8U:
+                AccumulateRows<std::uint8_t>(img, mask, b, e, a);
+                break;
+            case CV_8S:
+                AccumulateRows<std::int8_t>(img, mask, b, e, a);
+                break;
+            case CV_16U:
+                AccumulateRows<std::uint16_t>(img, mask, b, e, a);
+                break;
+            case CV_16S:
+                AccumulateRows<std::int16_t>(img, mask, b, e, a);
+                break;
+            case CV_32S:
+                AccumulateRows<std::int32_t>(img, mask, b, e, a);
+                break;
+            case CV_32F:
+                AccumulateRows<float>(img, mask, b, e, a);
+                break;
+            default:
+                AccumulateRows<double>(img, mask, b, e, a);
+                break;
+        }
+        if (a.count == 0) {
+            return;
+        }
+
+        // Merge the chunk as a single-chunk ImageStatistics
+        ImageStatistics chunk;
+        chunk.depth_ = depth_;
+        chunk.histogram_ = std::move(a.histogram);
+        chunk.count_ = a.count;
+        chunk.min_ = a.min;
+        chunk.max_ = a.max;
+        auto n = static_cast<double>(a.count);
+        chunk.mean_ = a.shift + a.sum / n;
+        chunk.m2_ = std::max(0.0, a.sumSq - a.sum * a.sum / n);
+
+        const std::lock_guard<std::mutex> lock(mutex);
+        merge(chunk);
+    });
+}
+
+void ImageStatistics::merge(const ImageStatistics& other)
+{
+    if (other.depth_ == -1) {
+        return;
+    }
+    if (depth_ == -1) {
+        depth_ = other.depth_;
+        histogram_.assign(NumBins(depth_), 0);
+    } else if (depth_ != other.depth_) {
+        throw std::invalid_argument("Cannot merge statistics of other depth");
+    }
+
+    for (std::size_t i = 0; i < histogram_.size(); i++) {
+        histogram_[i] += other.histogram_[i];
+    }
+    if (other.count_ == 0) {
+        return;
+    }
+    if (count_ == 0) {
+        count_ = other.count_;
+        min_ = other.min_;
+        max_ = other.max_;
+        mean_ = other.mean_;
+        m2_ = other.m2_;
+        return;
+    }
+
+    // Chan et al.'s parallel variance update
+    auto na = static_cast<double>(count_);
+    auto nb = static_cast<double>(other.count_);
+    auto n = na + nb;
+    auto delta = other.mean_ - mean_;
+    mean_ += delta * nb / n;
+    m2_ += other.m2_ + delta * delta * na * nb / n;
+    count_ += other.count_;
+    min_ = std::min(min_, other.min_);
+    max_ = std::max(max_, other.max_);
+}
+
+auto ImageStatistics::count() const -> std::uint64_t { return count_; }
+
+auto ImageStatistics::min() const -> double { return min_; }
+
+auto ImageStatistics::max() const -> double { return max_; }
+
+auto ImageStatistics::mean() const -> double { return mean_; }
+
+auto ImageStatistics::variance() const -> double
+{
+    return (count_ == 0) ? 0 : m2_ / static_cast<double>(count_);
+}
+
+auto ImageStatistics::stdDev() const -> double { return std::sqrt(variance()); }
+
+auto ImageStatistics::percentile(double p) const -> double
+{
+    if (count_ == 0) {
+        return 0;
+    }
+
+    p = std::clamp(p, 0.0, 100.0);
+    auto target = static_cast<std::uint64_t>(
+        std::ceil(p / 100.0 * static_cast<double>(count_)));
+    target = std::max<std::uint64_t>(target, 1);
+    return value_at_rank_(target - 1);
+}
+
+auto ImageStatistics::median() const -> double
+{
+    return (count_ == 0) ? 0 : value_at_rank_(count_ / 2);
+}
+
+auto ImageStatistics::histogram() const -> const std::vector<std::uint64_t>&
+{
+    return histogram_;
+}
+
+auto ImageStatistics::value_at_rank_(std::uint64_t rank) const -> double
+{
+    std::uint64_t seen{0};
+    for (std::size_t i = 0; i < histogram_.size(); i++) {
+        seen += histogram_[i];
+        if (seen > rank) {
+            return bin_value_(i);
+        }
+    }
+    return max_;
+}
+
+auto ImageStatistics::bin_value_(std::size_t bin) const -> double
+{
+    double v{0};
+    switch (depth_) {
+        case CV_8U:
+        case CV_16U:
+            return static_cast<double>(bin);
+        case CV_8S:
+            return static_cast<double>(bin) - 128;
+        case CV_16S:
+            return static_cast<double>(bin) - 32768;
+        default: {
+            // Midpoint of the values in the bin
+            auto key = static_cast<std::uint32_t>(bin) << 16;
+            double lo = KeyToFloat(key);
+            double hi = KeyToFloat(key | 0xFFFFU);
+            v = std::isfinite(lo) and std::isfinite(hi) ? (lo + hi) / 2 : lo;
+            break;
+        }
+    }
+    return std::clamp(v, min_, max_);
+}
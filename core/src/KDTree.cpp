@@ -0,0 +1,124 @@
+#include "vc/core/types/KDTree.hpp"
+
+#include <algorithm>
+#include <numeric>
+#include <utility>
+
+using namespace volcart;
+
+KDTree::KDTree(std::vector<Point> points, std::size_t leafSize)
+    : points_{std::move(points)}, leafSize_{std::max<std::size_t>(leafSize, 1)}
+{
+    indices_.resize(points_.size());
+    std::iota(indices_.begin(), indices_.end(), 0);
+    if (points_.empty()) {
+        return;
+    }
+
+    // Build over the permutation, then store the points in leaf order
+    nodes_.reserve(2 * (points_.size() / leafSize_ + 1));
+    build_(0, points_.size());
+    std::vector<Point> sorted;
+    sorted.reserve(points_.size());
+    for (const auto& i : indices_) {
+        sorted.push_back(points_[i]);
+    }
+    points_ = std::move(sorted);
+}
+
+auto KDTree::size() const -> std::size_t { return points_.size(); }
+
+auto KDTree::empty() const -> bool { return points_.empty(); }
+
+auto KDTree::build_(std::size_t begin, std::size_t end) -> std::size_t
+{
+    const auto id = nodes_.size();
+    nodes_.push_back({begin, end});
+    if (end - begin <= leafSize_) {
+        return id;
+    }
+
+    // Split the widest axis of the bounding box at the median
+    Point lo = points_[indices_[begin]];
+    Point hi = lo;
+    for (auto i = begin + 1; i < end; ++i) {
+        const auto& p = points_[indices_[i]];
+        for (int a = 0; a < 3; ++a) {
+            lo[a] = std::min(lo[a], p[a]);
+            hi[a] = std::max(hi[a], p[a]);
+        }
+    }
+    const auto extent = hi - lo;
+    int axis = 0;
+    if (extent[1] > extent[axis]) {
+        axis = 1;
+    }
+    if (extent[2] > extent[axis]) {
+        axis = 2;
+    }
+
+    // All points are identical
+    if (extent[axis] == 0) {
+        return id;
+    }
+
+    const auto mid = begin + (end - begin) / 2;
+    std::nth_element(
+        indices_.begin() + begin, indices_.begin() + mid,
+        indices_.begin() + end, [this, axis](auto l, auto r) {
+            return points_[l][axis] < points_[r][axis];
+        });
+    const auto split = points_[indices_[mid]][axis];
+
+    const auto left = build_(begin, mid);
+    const auto right = build_(mid, end);
+    auto& node = nodes_[id];
+    node.axis = static_cast<std::int8_t>(axis);
+    node.split = split;
+    node.left = left;
+    node.right = right;
+    return id;
+}
+
+void KDTree::radiusSearch(
+    const Point& q, double radius, std::vector<std::size_t>& result) const
+{
+    result.clear();
+    if (nodes_.empty() or radius < 0) {
+        return;
+    }
+
+    const auto r2 = radius * radius;
+    std::size_t stack[64];
+    std::size_t top{0};
+    stack[top++] = 0;
+    while (top > 0) {
+        const auto& node = nodes_[stack[--top]];
+        if (node.axis < 0) {
+            for (auto i = node.begin; i < node.end; ++i) {
+                const auto d = points_[i] - q;
+                if (d.dot(d) <= r2) {
+                    result.push_back(indices_[i]);
+                }
+            }
+            continue;
+        }
+
+        // Points equal to the split may be on either side
+        const auto offset = q[node.axis] - node.split;
+        if (offset <= radius) {
+            stack[top++] = node.left;
+        }
+        if (offset >= -radius) {
+            stack[top++] = node.right;
+        }
+    }
+}
+
+auto KDTree::radiusSearch(const Point& q, double radius) const
+    -> std::vector<std::size_t>
+{
+    std::vector<std::size_t> result;
+    radiusSearch(q, radius, result);
+    return result;
+}
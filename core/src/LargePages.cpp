@@ -0,0 +1,193 @@
+#include "vc/core/util/LargePages.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <stdexcept>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+using namespace volcart;
+using namespace volcart::memory;
+
+namespace
+{
+std::atomic<LargePageMode> MODE{LargePageMode::Off};
+
+// Type of the access flags of cv::MatAllocator, which differs between
+// OpenCV versions
+template <class T>
+struct AccessFlagOf;
+template <class R, class C, class D, class F>
+struct AccessFlagOf<R (C::*)(D, F) const> {
+    using type = F;
+};
+using AccessFlag = AccessFlagOf<decltype(&cv::MatAllocator::map)>::type;
+
+auto RoundUp(std::size_t bytes) -> std::size_t
+{
+    return (bytes + HUGE_PAGE_BYTES - 1) / HUGE_PAGE_BYTES * HUGE_PAGE_BYTES;
+}
+
+// Map bytes of anonymous memory, aligned to and backed by huge pages.
+// Returns nullptr if huge pages are unavailable.
+auto MapHugePages(std::size_t bytes, LargePageMode mode) -> void*
+{
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+    constexpr auto PROT = PROT_READ | PROT_WRITE;
+    constexpr auto FLAGS = MAP_PRIVATE | MAP_ANONYMOUS;
+
+#ifdef MAP_HUGETLB
+    // Explicit huge pages from the pool
+    if (mode == LargePageMode::Explicit) {
+        auto hugeFlags = FLAGS | MAP_HUGETLB;
+#ifdef MAP_HUGE_2MB
+        hugeFlags |= MAP_HUGE_2MB;
+#endif
+        auto* ptr = ::mmap(nullptr, bytes, PROT, hugeFlags, -1, 0);
+        if (ptr != MAP_FAILED) {
+            return ptr;
+        }
+    }
+#endif
+
+    // Transparent huge pages. Over-map by one huge page and trim the ends so
+    // that the mapping is aligned to huge pages.
+    auto* ptr = ::mmap(nullptr, bytes + HUGE_PAGE_BYTES, PROT, FLAGS, -1, 0);
+    if (ptr == MAP_FAILED) {
+        return nullptr;
+    }
+    auto addr = reinterpret_cast<std::uintptr_t>(ptr);
+    auto aligned = RoundUp(addr);
+    if (aligned > addr) {
+        ::munmap(ptr, aligned - addr);
+    }
+    ::munmap(
+        reinterpret_cast<void*>(aligned + bytes),
+        addr + HUGE_PAGE_BYTES - aligned);
+    ptr = reinterpret_cast<void*>(aligned);
+    ::madvise(ptr, bytes, MADV_HUGEPAGE);
+    return ptr;
+#else
+    static_cast<void>(bytes);
+    static_cast<void>(mode);
+    return nullptr;
+#endif
+}
+
+// Places large images in huge-page mappings. Small images, images which
+// wrap user data, and images which cannot be mapped use the standard
+// allocator.
+class HugePageAllocator : public cv::MatAllocator
+{
+public:
+    auto allocate(
+        int dims,
+        const int* sizes,
+        int type,
+        void* data,
+        std::size_t* step,
+        AccessFlag flags,
+        cv::UMatUsageFlags usage) const -> cv::UMatData* override
+    {
+        auto mode = MODE.load();
+        if (data != nullptr or mode == LargePageMode::Off) {
+            return cv::Mat::getStdAllocator()->allocate(
+                dims, sizes, type, data, step, flags, usage);
+        }
+
+        // Size of the continuous image
+        auto total = static_cast<std::size_t>(CV_ELEM_SIZE(type));
+        for (auto i = dims - 1; i >= 0; i--) {
+            if (step != nullptr) {
+                step[i] = total;
+            }
+            total *= static_cast<std::size_t>(sizes[i]);
+        }
+
+        void* ptr{nullptr};
+        if (total >= LARGE_BUFFER_BYTES) {
+            ptr = MapHugePages(RoundUp(total), mode);
+        }
+        if (ptr == nullptr) {
+            return cv::Mat::getStdAllocator()->allocate(
+                dims, sizes, type, data, step, flags, usage);
+        }
+
+        auto* u = new cv::UMatData(this);
+        u->data = u->origdata = static_cast<uchar*>(ptr);
+        u->size = total;
+        return u;
+    }
+
+    auto allocate(
+        cv::UMatData* u, AccessFlag flags, cv::UMatUsageFlags usage) const
+        -> bool override
+    {
+        return cv::Mat::getStdAllocator()->allocate(u, flags, usage);
+    }
+
+    void deallocate(cv::UMatData* u) const override
+    {
+        if (u == nullptr) {
+            return;
+        }
+#ifdef __linux__
+        ::munmap(u->origdata, RoundUp(u->size));
+#endif
+        delete u;
+    }
+};
+}  // namespace
+
+void memory::SetLargePages(LargePageMode mode)
+{
+    MODE = mode;
+    if (mode == LargePageMode::Off) {
+        cv::Mat::setDefaultAllocator(cv::Mat::getStdAllocator());
+    } else {
+        cv::Mat::setDefaultAllocator(LargePageAllocator());
+    }
+}
+
+auto memory::LargePages() -> LargePageMode { return MODE.load(); }
+
+auto memory::ParseLargePageMode(const std::string& s) -> LargePageMode
+{
+    if (s == "off") {
+        return LargePageMode::Off;
+    }
+    if (s == "transparent") {
+        return LargePageMode::Transparent;
+    }
+    if (s == "explicit") {
+        return LargePageMode::Explicit;
+    }
+    throw std::invalid_argument("Unknown large page mode: " + s);
+}
+
+auto memory::LargePageAllocator() -> cv::MatAllocator*
+{
+    static HugePageAllocator allocator;
+    return &allocator;
+}
+
+void memory::AdviseLargePages(void* ptr, std::size_t bytes)
+{
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+    if (MODE.load() == LargePageMode::Off or ptr == nullptr or
+        bytes < LARGE_BUFFER_BYTES) {
+        return;
+    }
+    auto begin = RoundUp(reinterpret_cast<std::uintptr_t>(ptr));
+    auto end = (reinterpret_cast<std::uintptr_t>(ptr) + bytes) /
+               HUGE_PAGE_BYTES * HUGE_PAGE_BYTES;
+    if (end > begin) {
+        ::madvise(reinterpret_cast<void*>(begin), end - begin, MADV_HUGEPAGE);
+    }
+#else
+    static_cast<void>(ptr);
+    static_cast<void>(bytes);
+#endif
+}
@@ -1,9 +1,54 @@
 #include "vc/core/neighborhood/LineGenerator.hpp"
 
+#include <array>
+#include <stdexcept>
+
 #include "vc/core/util/FloatComparison.hpp"
 
 using namespace volcart;
 
+namespace
+{
+// Lines up to these lengths keep their sample positions on the stack
+constexpr std::size_t SMALL_LINE{16};
+constexpr std::size_t LARGE_LINE{64};
+
+// Generate the positions of samples [first, first + count) of the line, then
+// interpolate them in a single batch. Positions are computed from their index
+// rather than by stepping, so that any range of samples matches the same
+// samples of the full line exactly.
+template <typename Container>
+void SampleLine(
+    const Volume& v,
+    const cv::Vec3d& start,
+    const cv::Vec3d& step,
+    std::size_t first,
+    std::size_t count,
+    Volume::Interpolation method,
+    Container& pts,
+    uint16_t* out)
+{
+    for (std::size_t i = 0; i < count; i++) {
+        pts[i] = start + step * static_cast<double>(first + i);
+    }
+    v.interpolateAt(pts.data(), count, out, method);
+}
+
+template <std::size_t N>
+void SampleFixedLine(
+    const Volume& v,
+    const cv::Vec3d& start,
+    const cv::Vec3d& step,
+    std::size_t first,
+    std::size_t count,
+    Volume::Interpolation method,
+    uint16_t* out)
+{
+    std::array<cv::Vec3d, N> pts;
+    SampleLine(v, start, step, first, count, method, pts, out);
+}
+}  // namespace
+
 Neighborhood LineGenerator::compute(
     const Volume::Pointer& v,
     const cv::Vec3d& pt,
@@ -21,43 +66,63 @@ Neighborhood LineGenerator::compute(
         throw std::domain_error("Sampling interval too small");
     }
 
-    // Make sure radius is positive
-    auto radius = std::abs(radius_[0]);
+    Neighborhood n(1, line_size_());
+    computeInto(v, pt, axes[0], n.data());
+
+    return n;
+}
+
+void LineGenerator::computeInto(
+    const Volume::Pointer& v,
+    const cv::Vec3d& pt,
+    const cv::Vec3d& axis,
+    uint16_t* out) const
+{
+    computeRangeInto(v, pt, axis, 0, line_size_(), out);
+}
 
-    // Setup Range
-    double min, max;
-    switch (direction_) {
-        case Direction::Bidirectional: {
-            min = -1 * radius;
-            max = radius;
-            break;
-        }
-        case Direction::Positive: {
-            min = 0;
-            max = radius;
-            break;
-        }
-        case Direction::Negative: {
-            min = -1 * radius;
-            max = 0;
-            break;
-        }
+void LineGenerator::computeRangeInto(
+    const Volume::Pointer& v,
+    const cv::Vec3d& pt,
+    const cv::Vec3d& axis,
+    size_t first,
+    size_t count,
+    uint16_t* out) const
+{
+    // Interval bounds
+    if (AlmostEqual(interval_, 0.0)) {
+        throw std::domain_error("Sampling interval too small");
+    }
+    if (first + count > line_size_()) {
+        throw std::out_of_range("Sample range exceeds the line");
     }
 
-    // Iterate through range
-    auto count = static_cast<size_t>(std::floor((max - min) / interval_) + 1);
-    Neighborhood n(1, count);
-    for (size_t it = 0; it < count; it++) {
-        auto offset = min + (it * interval_);
-        n(it) = v->interpolateAt(pt + (axes[0] * offset));
+    const cv::Vec3d start = pt + axis * lineStart();
+    const cv::Vec3d step = axis * interval_;
+    const auto m = interpolation_;
+    if (count <= SMALL_LINE) {
+        SampleFixedLine<SMALL_LINE>(*v, start, step, first, count, m, out);
+    } else if (count <= LARGE_LINE) {
+        SampleFixedLine<LARGE_LINE>(*v, start, step, first, count, m, out);
+    } else {
+        thread_local std::vector<cv::Vec3d> pts;
+        pts.resize(count);
+        SampleLine(*v, start, step, first, count, m, pts, out);
     }
+}
 
-    return n;
+Neighborhood::Extent LineGenerator::extents() const { return {line_size_()}; }
+
+double LineGenerator::lineStart() const
+{
+    return (direction_ == Direction::Positive) ? 0 : -std::abs(radius_[0]);
 }
 
-Neighborhood::Extent LineGenerator::extents() const
+size_t LineGenerator::line_size_() const
 {
-    auto radius =
-        (direction_ != Direction::Bidirectional) ? radius_[0] / 2 : radius_[0];
-    return {static_cast<size_t>(std::floor(2.0 * radius / interval_) + 1)};
-}
\ No newline at end of file
+    // Make sure radius is positive
+    auto radius = std::abs(radius_[0]);
+    auto length =
+        (direction_ == Direction::Bidirectional) ? 2 * radius : radius;
+    return static_cast<size_t>(std::floor(length / interval_) + 1);
+}
@@ -0,0 +1,56 @@
+#include "vc/core/io/MappedFile.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "vc/core/types/Exceptions.hpp"
+
+using namespace volcart;
+using namespace volcart::io;
+
+MappedFile::MappedFile(const filesystem::path& path)
+{
+    auto fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw IOException("Failed to open file: " + path.string());
+    }
+    struct stat st{};
+    if (::fstat(fd, &st) != 0) {
+        ::close(fd);
+        throw IOException("Failed to stat file: " + path.string());
+    }
+    size_ = static_cast<std::size_t>(st.st_size);
+
+    // mmap does not accept zero-length mappings
+    if (size_ == 0) {
+        ::close(fd);
+        return;
+    }
+
+    auto* ptr = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (ptr == MAP_FAILED) {
+        throw IOException("Failed to memory map file: " + path.string());
+    }
+    data_ = static_cast<const char*>(ptr);
+
+    // Files are parsed front to back
+    ::madvise(ptr, size_, MADV_SEQUENTIAL);
+}
+
+MappedFile::~MappedFile()
+{
+    if (data_ != nullptr) {
+        ::munmap(const_cast<char*>(data_), size_);
+    }
+}
+
+auto MappedFile::data() const -> const char* { return data_; }
+
+auto MappedFile::size() const -> std::size_t { return size_; }
+
+auto MappedFile::end() const -> const char* { return data_ + size_; }
+
+auto MappedFile::view() const -> std::string_view { return {data_, size_}; }
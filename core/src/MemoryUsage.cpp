@@ -0,0 +1,316 @@
+#include "vc/core/util/MemoryUsage.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <iomanip>
+#include <map>
+#include <mutex>
+#include <numeric>
+#include <set>
+#include <sstream>
+#include <vector>
+
+#include "vc/core/util/MemorySizeStringParser.hpp"
+
+using namespace volcart;
+using namespace volcart::memory;
+
+using Usage = std::array<std::size_t, NUM_CATEGORIES>;
+
+namespace
+{
+struct Provider {
+    MemoryCategory category;
+    std::function<std::size_t()> fn;
+    const void* key;
+};
+
+struct Registry {
+    // Recursive so that providers and handlers may register, unregister, or
+    // update a TrackedBytes while they are being called
+    std::recursive_mutex mutex;
+    std::size_t nextId{1};
+    std::map<std::size_t, Provider> providers;
+    std::map<std::size_t, std::function<void(std::size_t)>> handlers;
+    Usage peaks{};
+    std::size_t peakTotal{0};
+    bool shrinking{false};
+};
+
+std::array<std::atomic<std::size_t>, NUM_CATEGORIES> Counters{};
+std::atomic<std::size_t> Limit{0};
+
+// Bytes added by TrackedBytes since the last sample
+std::atomic<std::size_t> Unsampled{0};
+
+// Never destroyed, since static objects may unregister or release tracked
+// bytes during program exit
+auto GetRegistry() -> Registry&
+{
+    static auto* registry = new Registry;
+    return *registry;
+}
+
+auto Index(MemoryCategory c) -> std::size_t
+{
+    return static_cast<std::size_t>(c);
+}
+
+auto Sum(const Usage& u) -> std::size_t
+{
+    return std::accumulate(u.begin(), u.end(), std::size_t{0});
+}
+
+auto FormatBytes(std::size_t bytes) -> std::string
+{
+    return BytesToMemorySizeString(bytes, "MB");
+}
+
+// Requires the registry lock
+auto Collect(Registry& r) -> Usage
+{
+    Usage usage{};
+    for (std::size_t i = 0; i < NUM_CATEGORIES; i++) {
+        usage[i] = Counters[i].load(std::memory_order_relaxed);
+    }
+
+    // Snapshot the IDs, since providers may modify the registry
+    std::vector<std::size_t> ids;
+    ids.reserve(r.providers.size());
+    for (const auto& [id, p] : r.providers) {
+        ids.push_back(id);
+    }
+
+    std::set<const void*> seen;
+    for (const auto& id : ids) {
+        auto it = r.providers.find(id);
+        if (it == r.providers.end()) {
+            continue;
+        }
+        auto category = it->second.category;
+        auto key = it->second.key;
+        if (key != nullptr and not seen.insert(key).second) {
+            continue;
+        }
+        auto fn = it->second.fn;
+        usage[Index(category)] += fn();
+    }
+    return usage;
+}
+
+// Requires the registry lock
+void UpdatePeaks(Registry& r, const Usage& usage)
+{
+    for (std::size_t i = 0; i < NUM_CATEGORIES; i++) {
+        r.peaks[i] = std::max(r.peaks[i], usage[i]);
+    }
+    r.peakTotal = std::max(r.peakTotal, Sum(usage));
+}
+}  // namespace
+
+auto memory::CategoryName(MemoryCategory c) -> std::string
+{
+    switch (c) {
+        case MemoryCategory::SliceCache:
+            return "Slice cache";
+        case MemoryCategory::PPM:
+            return "PPM";
+        case MemoryCategory::Mesh:
+            return "Mesh";
+        case MemoryCategory::Texture:
+            return "Texture";
+        case MemoryCategory::Mask:
+            return "Mask";
+    }
+    return "Unknown";
+}
+
+void memory::Add(MemoryCategory c, std::size_t bytes)
+{
+    Counters[Index(c)].fetch_add(bytes, std::memory_order_relaxed);
+}
+
+void memory::Remove(MemoryCategory c, std::size_t bytes)
+{
+    Counters[Index(c)].fetch_sub(bytes, std::memory_order_relaxed);
+}
+
+Registration::~Registration() { reset(); }
+
+Registration::Registration(Registration&& other) noexcept : id_{other.id_}
+{
+    other.id_ = 0;
+}
+
+auto Registration::operator=(Registration&& other) noexcept -> Registration&
+{
+    if (this != &other) {
+        reset();
+        id_ = other.id_;
+        other.id_ = 0;
+    }
+    return *this;
+}
+
+void Registration::reset()
+{
+    if (id_ == 0) {
+        return;
+    }
+    auto& r = GetRegistry();
+    const std::lock_guard<std::recursive_mutex> lock(r.mutex);
+    r.providers.erase(id_);
+    r.handlers.erase(id_);
+    id_ = 0;
+}
+
+auto memory::RegisterProvider(
+    MemoryCategory c,
+    std::function<std::size_t()> provider,
+    const void* key) -> Registration
+{
+    auto& r = GetRegistry();
+    const std::lock_guard<std::recursive_mutex> lock(r.mutex);
+    auto id = r.nextId++;
+    r.providers[id] = {c, std::move(provider), key};
+    return Registration(id);
+}
+
+auto memory::RegisterShrinkHandler(std::function<void(std::size_t)> handler)
+    -> Registration
+{
+    auto& r = GetRegistry();
+    const std::lock_guard<std::recursive_mutex> lock(r.mutex);
+    auto id = r.nextId++;
+    r.handlers[id] = std::move(handler);
+    return Registration(id);
+}
+
+auto memory::Current(MemoryCategory c) -> std::size_t
+{
+    auto& r = GetRegistry();
+    const std::lock_guard<std::recursive_mutex> lock(r.mutex);
+    return Collect(r)[Index(c)];
+}
+
+auto memory::Total() -> std::size_t
+{
+    auto& r = GetRegistry();
+    const std::lock_guard<std::recursive_mutex> lock(r.mutex);
+    return Sum(Collect(r));
+}
+
+auto memory::Peak(MemoryCategory c) -> std::size_t
+{
+    auto& r = GetRegistry();
+    const std::lock_guard<std::recursive_mutex> lock(r.mutex);
+    return r.peaks[Index(c)];
+}
+
+auto memory::PeakTotal() -> std::size_t
+{
+    auto& r = GetRegistry();
+    const std::lock_guard<std::recursive_mutex> lock(r.mutex);
+    return r.peakTotal;
+}
+
+void memory::ResetPeaks()
+{
+    auto& r = GetRegistry();
+    const std::lock_guard<std::recursive_mutex> lock(r.mutex);
+    r.peaks = Collect(r);
+    r.peakTotal = Sum(r.peaks);
+}
+
+void memory::SetSoftLimit(std::size_t bytes) { Limit = bytes; }
+
+auto memory::SoftLimit() -> std::size_t { return Limit; }
+
+auto memory::Sample() -> Usage
+{
+    auto& r = GetRegistry();
+    const std::lock_guard<std::recursive_mutex> lock(r.mutex);
+    Unsampled = 0;
+    auto usage = Collect(r);
+    UpdatePeaks(r, usage);
+
+    // Shrink handlers may grow other counters, which samples again
+    auto limit = SoftLimit();
+    if (limit == 0 or r.shrinking or Sum(usage) <= limit) {
+        return usage;
+    }
+
+    r.shrinking = true;
+    std::vector<std::size_t> ids;
+    ids.reserve(r.handlers.size());
+    for (const auto& [id, h] : r.handlers) {
+        ids.push_back(id);
+    }
+    for (const auto& id : ids) {
+        auto it = r.handlers.find(id);
+        if (it == r.handlers.end()) {
+            continue;
+        }
+        auto handler = it->second;
+        handler(Sum(usage) - limit);
+        usage = Collect(r);
+        if (Sum(usage) <= limit) {
+            break;
+        }
+    }
+    r.shrinking = false;
+    return usage;
+}
+
+auto memory::Summary() -> std::string
+{
+    auto usage = Sample();
+    std::stringstream ss;
+    for (std::size_t i = 0; i < NUM_CATEGORIES; i++) {
+        ss << CategoryName(static_cast<MemoryCategory>(i)) << ": ";
+        ss << FormatBytes(usage[i]) << ", ";
+    }
+    ss << "Total: " << FormatBytes(Sum(usage));
+    ss << " (Peak: " << FormatBytes(PeakTotal()) << ")";
+    return ss.str();
+}
+
+auto memory::Report() -> std::string
+{
+    auto usage = Sample();
+    std::stringstream ss;
+    ss << std::left << std::setw(14) << "Category" << std::right;
+    ss << std::setw(12) << "Current" << std::setw(12) << "Peak" << "\n";
+    for (std::size_t i = 0; i < NUM_CATEGORIES; i++) {
+        auto c = static_cast<MemoryCategory>(i);
+        ss << std::left << std::setw(14) << CategoryName(c) << std::right;
+        ss << std::setw(12) << FormatBytes(usage[i]);
+        ss << std::setw(12) << FormatBytes(Peak(c)) << "\n";
+    }
+    ss << std::left << std::setw(14) << "Total" << std::right;
+    ss << std::setw(12) << FormatBytes(Sum(usage));
+    ss << std::setw(12) << FormatBytes(PeakTotal());
+    if (SoftLimit() > 0) {
+        ss << "\nSoft limit: " << FormatBytes(SoftLimit());
+    }
+    return ss.str();
+}
+
+void TrackedBytes::set(std::size_t bytes)
+{
+    if (bytes == bytes_) {
+        return;
+    }
+    auto growth = bytes > bytes_ ? bytes - bytes_ : 0;
+    Add(category_, bytes);
+    Remove(category_, bytes_);
+    bytes_ = bytes;
+
+    // Growth is the only time the peaks or the soft limit can be exceeded.
+    // Small allocations are batched so that objects which grow often, like
+    // VolumetricMask, do not sample on every change.
+    if (growth > 0 and
+        Unsampled.fetch_add(growth) + growth >= SAMPLE_GRANULARITY) {
+        Sample();
+    }
+}
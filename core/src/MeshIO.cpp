@@ -64,6 +64,8 @@ void volcart::WriteMesh(
         PLYWriter writer;
         writer.setPath(path);
         writer.setMesh(mesh);
+        writer.setFormat(opts.plyFormat);
+        writer.setPrecision(opts.plyPrecision);
         // TODO: Add texture writing support back
         writer.write();
     }
@@ -1,40 +1,198 @@
 #include "vc/core/util/MeshMath.hpp"
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <utility>
+
+#include "vc/core/util/Iteration.hpp"
 #include "vc/core/util/Logging.hpp"
+#include "vc/core/util/ThreadPool.hpp"
 
 namespace volcart::meshmath
 {
 
+namespace
+{
+// Number of partial results in a reduction. Fixed so that the combined
+// result does not depend on the number of threads.
+constexpr std::size_t NUM_CHUNKS{64};
+
+// Accumulate f(i, partial) over [0, n) in parallel chunks, then combine the
+// partial results in chunk order
+template <typename T, class F, class C>
+auto ChunkedReduce(
+    std::size_t n, std::size_t numThreads, const T& init, F f, C combine) -> T
+{
+    std::vector<T> partials(NUM_CHUNKS, init);
+    ParallelFor(
+        range(NUM_CHUNKS),
+        [&](auto c) {
+            auto& partial = partials[c];
+            for (auto i = n * c / NUM_CHUNKS; i < n * (c + 1) / NUM_CHUNKS;
+                 i++) {
+                f(i, partial);
+            }
+        },
+        numThreads);
+    auto result = init;
+    for (const auto& p : partials) {
+        combine(result, p);
+    }
+    return result;
+}
+
+// Sum and count of the faces with a NaN area
+struct AreaSum {
+    double area{0};
+    std::size_t nans{0};
+};
+
+// Partial edge length statistics
+struct EdgeSum {
+    std::size_t count{0};
+    double min{std::numeric_limits<double>::max()};
+    double max{std::numeric_limits<double>::lowest()};
+    double sum{0};
+    double sumSq{0};
+};
+}  // namespace
+
 double SurfaceArea(const ITKMesh::Pointer& mesh)
 {
-    double surfaceArea{0};
-    for (auto cell = mesh->GetCells()->Begin(); cell != mesh->GetCells()->End();
-         ++cell) {
-
-        // Get vertices
-        auto vID0 = cell->Value()->GetPointIds()[0];
-        auto vID1 = cell->Value()->GetPointIds()[1];
-        auto vID2 = cell->Value()->GetPointIds()[2];
-
-        // Get the side lengths
-        auto a = mesh->GetPoint(vID0).EuclideanDistanceTo(mesh->GetPoint(vID1));
-        auto b = mesh->GetPoint(vID0).EuclideanDistanceTo(mesh->GetPoint(vID2));
-        auto c = mesh->GetPoint(vID1).EuclideanDistanceTo(mesh->GetPoint(vID2));
-
-        // Get cell surface area
-        auto sa = TriangleArea(a, b, c);
-
-        // Note: Can get NaN's when using std::math
-        if (std::isnan(sa)) {
-            Logger()->error(
-                "volcart::meshMath: Warning: NaN surface area for face[{}]. "
-                "Evaluating as 0.",
-                cell.Index());
-            sa = 0.0;
-        }
-        surfaceArea += sa;
+    return SurfaceArea(ToFlatMesh(mesh));
+}
+
+double SurfaceArea(const FlatMesh& mesh, std::size_t numThreads)
+{
+    const auto& vs = mesh.vertices();
+    const auto& fs = mesh.faces();
+    auto result = ChunkedReduce(
+        fs.size(), numThreads, AreaSum{},
+        [&](auto i, auto& sum) {
+            const auto& f = fs[i];
+            auto a = cv::norm(vs[f[0]] - vs[f[1]]);
+            auto b = cv::norm(vs[f[0]] - vs[f[2]]);
+            auto c = cv::norm(vs[f[1]] - vs[f[2]]);
+            auto sa = TriangleArea(a, b, c);
+            // Note: Can get NaN's when using std::math
+            if (std::isnan(sa)) {
+                sum.nans++;
+            } else {
+                sum.area += sa;
+            }
+        },
+        [](auto& r, const auto& p) {
+            r.area += p.area;
+            r.nans += p.nans;
+        });
+
+    if (result.nans > 0) {
+        Logger()->warn(
+            "volcart::meshMath: NaN surface area for {} faces. Evaluating as "
+            "0.",
+            result.nans);
+    }
+    return result.area;
+}
+
+auto Bounds(const FlatMesh& mesh, std::size_t numThreads)
+    -> BoundingBox<double, 3>
+{
+    using Point = cv::Vec3d;
+    const auto& vs = mesh.vertices();
+    if (vs.empty()) {
+        return {};
+    }
+    using MinMax = std::pair<Point, Point>;
+    auto [lower, upper] = ChunkedReduce(
+        vs.size(), numThreads, MinMax{vs.front(), vs.front()},
+        [&](auto i, auto& b) {
+            for (int d = 0; d < 3; d++) {
+                b.first[d] = std::min(b.first[d], vs[i][d]);
+                b.second[d] = std::max(b.second[d], vs[i][d]);
+            }
+        },
+        [](auto& r, const auto& p) {
+            for (int d = 0; d < 3; d++) {
+                r.first[d] = std::min(r.first[d], p.first[d]);
+                r.second[d] = std::max(r.second[d], p.second[d]);
+            }
+        });
+    return {lower, upper};
+}
+
+auto EdgeLengths(const FlatMesh& mesh, std::size_t numThreads)
+    -> EdgeLengthStats
+{
+    const auto& vs = mesh.vertices();
+    const auto& fs = mesh.faces();
+    auto sum = ChunkedReduce(
+        fs.size(), numThreads, EdgeSum{},
+        [&](auto i, auto& s) {
+            const auto& f = fs[i];
+            for (std::size_t e = 0; e < 3; e++) {
+                auto l = cv::norm(vs[f[e]] - vs[f[(e + 1) % 3]]);
+                s.count++;
+                s.min = std::min(s.min, l);
+                s.max = std::max(s.max, l);
+                s.sum += l;
+                s.sumSq += l * l;
+            }
+        },
+        [](auto& r, const auto& p) {
+            r.count += p.count;
+            r.min = std::min(r.min, p.min);
+            r.max = std::max(r.max, p.max);
+            r.sum += p.sum;
+            r.sumSq += p.sumSq;
+        });
+
+    EdgeLengthStats stats;
+    if (sum.count == 0) {
+        return stats;
     }
+    auto n = static_cast<double>(sum.count);
+    stats.count = sum.count;
+    stats.min = sum.min;
+    stats.max = sum.max;
+    stats.mean = sum.sum / n;
+    stats.stddev =
+        std::sqrt(std::max(0.0, sum.sumSq / n - stats.mean * stats.mean));
+    return stats;
+}
 
-    return surfaceArea;
+auto FaceNormals(const FlatMesh& mesh, std::size_t numThreads)
+    -> std::vector<cv::Vec3d>
+{
+    const auto& vs = mesh.vertices();
+    const auto& fs = mesh.faces();
+    std::vector<cv::Vec3d> normals(fs.size());
+    ParallelFor(
+        range(fs.size()),
+        [&](auto i) {
+            const auto& f = fs[i];
+            const auto& v0 = vs[f[0]];
+            auto n = (vs[f[1]] - v0).cross(vs[f[2]] - v0);
+            auto l = cv::norm(n);
+            normals[i] = l > 0 ? n / l : cv::Vec3d(0, 0, 0);
+        },
+        numThreads);
+    return normals;
+}
+
+std::size_t MemoryInBytes(const ITKMesh::Pointer& mesh)
+{
+    if (not mesh) {
+        return 0;
+    }
+
+    // Cells are allocated individually and owned through the cells container
+    std::size_t bytes = mesh->GetNumberOfPoints() * sizeof(ITKPoint);
+    if (mesh->GetPointData()) {
+        bytes += mesh->GetPointData()->Size() * sizeof(ITKPixel);
+    }
+    bytes += mesh->GetNumberOfCells() * (sizeof(ITKTriangle) + sizeof(void*));
+    return bytes;
 }
 }  // namespace volcart::meshmath
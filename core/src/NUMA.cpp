@@ -0,0 +1,186 @@
+#include "vc/core/util/NUMA.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#include "vc/core/filesystem.hpp"
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+using namespace volcart;
+using namespace volcart::numa;
+
+namespace fs = volcart::filesystem;
+
+namespace
+{
+struct Topology {
+    // CPUs of each node
+    std::vector<std::vector<int>> nodeCPUs;
+    // Node of each CPU, or -1
+    std::vector<int> cpuNodes;
+};
+
+auto ReadTopology() -> Topology
+{
+    Topology topo;
+#ifdef __linux__
+    const fs::path root{"/sys/devices/system/node"};
+    auto dir = fs::is_directory(root) ? fs::directory_iterator(root)
+                                      : fs::directory_iterator();
+    std::vector<std::pair<int, std::vector<int>>> nodes;
+    auto isDigit = [](unsigned char c) { return std::isdigit(c) != 0; };
+    for (const auto& entry : dir) {
+        auto name = entry.path().filename().string();
+        if (name.rfind("node", 0) != 0 or name.size() == 4 or
+            not std::all_of(name.begin() + 4, name.end(), isDigit)) {
+            continue;
+        }
+        std::ifstream file((entry.path() / "cpulist").string());
+        std::string list;
+        std::getline(file, list);
+        try {
+            auto cpus = ParseCPUList(list);
+            if (not cpus.empty()) {
+                nodes.emplace_back(std::stoi(name.substr(4)), cpus);
+            }
+        } catch (const std::invalid_argument&) {
+            // Not a node we can use
+        }
+    }
+    std::sort(nodes.begin(), nodes.end());
+    for (auto& [id, cpus] : nodes) {
+        for (auto cpu : cpus) {
+            if (static_cast<std::size_t>(cpu) >= topo.cpuNodes.size()) {
+                topo.cpuNodes.resize(cpu + 1, -1);
+            }
+            topo.cpuNodes[cpu] = static_cast<int>(topo.nodeCPUs.size());
+        }
+        topo.nodeCPUs.emplace_back(std::move(cpus));
+    }
+#endif
+    if (topo.nodeCPUs.empty()) {
+        topo.nodeCPUs.emplace_back();
+    }
+    return topo;
+}
+
+// The topology does not change while the process runs
+auto GetTopology() -> const Topology&
+{
+    static const Topology topo = ReadTopology();
+    return topo;
+}
+}  // namespace
+
+auto numa::NumNodes() -> std::size_t { return GetTopology().nodeCPUs.size(); }
+
+auto numa::NodeCPUs(std::size_t node) -> std::vector<int>
+{
+    return GetTopology().nodeCPUs.at(node);
+}
+
+auto numa::CurrentNode() -> std::size_t
+{
+#ifdef __linux__
+    const auto& nodes = GetTopology().cpuNodes;
+    auto cpu = sched_getcpu();
+    if (cpu >= 0 and static_cast<std::size_t>(cpu) < nodes.size() and
+        nodes[cpu] >= 0) {
+        return static_cast<std::size_t>(nodes[cpu]);
+    }
+#endif
+    return 0;
+}
+
+auto numa::ParseCPUList(const std::string& list) -> std::vector<int>
+{
+    std::vector<int> cpus;
+    std::size_t pos{0};
+    auto number = [&]() {
+        auto start = pos;
+        while (pos < list.size() and
+               std::isdigit(static_cast<unsigned char>(list[pos])) != 0) {
+            pos++;
+        }
+        if (pos == start) {
+            throw std::invalid_argument("Invalid CPU list: " + list);
+        }
+        return std::stoi(list.substr(start, pos - start));
+    };
+
+    // Trailing newlines are allowed
+    auto end = list.find_last_not_of("\n ");
+    if (end == std::string::npos) {
+        return cpus;
+    }
+    while (pos <= end) {
+        auto first = number();
+        auto last = first;
+        if (pos <= end and list[pos] == '-') {
+            pos++;
+            last = number();
+        }
+        if (last < first) {
+            throw std::invalid_argument("Invalid CPU list: " + list);
+        }
+        for (auto cpu = first; cpu <= last; cpu++) {
+            cpus.push_back(cpu);
+        }
+        if (pos <= end) {
+            if (list[pos] != ',') {
+                throw std::invalid_argument("Invalid CPU list: " + list);
+            }
+            pos++;
+        }
+    }
+    return cpus;
+}
+
+ScopedBinding::ScopedBinding(std::size_t node)
+{
+#ifdef __linux__
+    if (NumNodes() < 2 or node >= NumNodes()) {
+        return;
+    }
+    auto self = pthread_self();
+    cpu_set_t previous;
+    CPU_ZERO(&previous);
+    if (pthread_getaffinity_np(self, sizeof(previous), &previous) != 0) {
+        return;
+    }
+
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    for (auto cpu : NodeCPUs(node)) {
+        if (cpu < CPU_SETSIZE) {
+            CPU_SET(cpu, &cpus);
+        }
+    }
+    if (pthread_setaffinity_np(self, sizeof(cpus), &cpus) != 0) {
+        return;
+    }
+    previous_.resize(sizeof(previous));
+    std::memcpy(previous_.data(), &previous, sizeof(previous));
+    bound_ = true;
+#else
+    static_cast<void>(node);
+#endif
+}
+
+ScopedBinding::~ScopedBinding()
+{
+#ifdef __linux__
+    if (bound_) {
+        cpu_set_t previous;
+        std::memcpy(&previous, previous_.data(), sizeof(previous));
+        pthread_setaffinity_np(pthread_self(), sizeof(previous), &previous);
+    }
+#endif
+}
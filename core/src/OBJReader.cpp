@@ -1,9 +1,16 @@
 #include "vc/core/io/OBJReader.hpp"
 
+#include <algorithm>
+#include <cstdint>
+#include <exception>
+#include <fstream>
 #include <regex>
 #include <string>
+#include <thread>
 
 #include "vc/core/io/ImageIO.hpp"
+#include "vc/core/io/MappedFile.hpp"
+#include "vc/core/io/TextScanner.hpp"
 #include "vc/core/types/Exceptions.hpp"
 #include "vc/core/util/Logging.hpp"
 #include "vc/core/util/String.hpp"
@@ -16,9 +23,13 @@ namespace fs = volcart::filesystem;
 // Constant for validating face values
 constexpr static int NOT_PRESENT = -1;
 constexpr static size_t VALID_FACE_SIZE = 3;
+// Smallest block of lines parsed by a thread
+constexpr static size_t MIN_BLOCK_SIZE = 1 << 20;
 
 void OBJReader::setPath(const filesystem::path& p) { path_ = p; }
 
+void OBJReader::setNumThreads(std::size_t n) { numThreads_ = n; }
+
 auto OBJReader::getMesh() -> ITKMesh::Pointer { return mesh_; }
 
 auto OBJReader::getUVMap() -> UVMap::Pointer { return uvMap_; }
@@ -49,122 +60,173 @@ void OBJReader::reset_()
 // Parse the file
 void OBJReader::parse_()
 {
-    std::regex vertex{"^v"};
-    std::regex normal{"^vn"};
-    std::regex tcoord{"^vt"};
-    std::regex face{"^f"};
-    std::regex mtllib("^mtllib");
+    const MappedFile file(path_);
 
-    std::ifstream ifs(path_.string());
-    if (!ifs.good()) {
-        throw IOException("Failed to open file for reading");
+    auto numThreads = numThreads_;
+    if (numThreads == 0) {
+        numThreads = std::max(1U, std::thread::hardware_concurrency());
+    }
+    auto ranges =
+        SplitLines(file.data(), file.end(), numThreads, MIN_BLOCK_SIZE);
+
+    // Parse the blocks
+    std::vector<Block> blocks(ranges.size());
+    std::vector<std::exception_ptr> errors(ranges.size());
+    auto parse = [&](std::size_t i) {
+        try {
+            parse_block_(ranges[i].first, ranges[i].second, blocks[i]);
+        } catch (...) {
+            errors[i] = std::current_exception();
+        }
+    };
+    std::vector<std::thread> threads;
+    for (std::size_t i = 1; i < ranges.size(); i++) {
+        threads.emplace_back(parse, i);
+    }
+    parse(0);
+    for (auto& t : threads) {
+        t.join();
+    }
+    for (const auto& e : errors) {
+        if (e) {
+            std::rethrow_exception(e);
+        }
     }
 
-    std::string line;
-    std::vector<std::string> strs;
-    while (std::getline(ifs, line)) {
-        // Parse the line
-        trim(line);
-        strs = split(line, ' ');
-        std::for_each(
-            std::begin(strs), std::end(strs), [](auto& s) { trim(s); });
-        if (strs.empty()) {
-            continue;
+    // Concatenate the blocks in file order
+    std::size_t numVerts{0};
+    std::size_t numNormals{0};
+    std::size_t numUVs{0};
+    std::size_t numFaces{0};
+    for (const auto& b : blocks) {
+        numVerts += b.vertices.size();
+        numNormals += b.normals.size();
+        numUVs += b.uvs.size();
+        numFaces += b.faces.size();
+    }
+    vertices_.reserve(numVerts);
+    normals_.reserve(numNormals);
+    uvs_.reserve(numUVs);
+    faces_.reserve(numFaces);
+    for (auto& b : blocks) {
+        vertices_.insert(vertices_.end(), b.vertices.begin(), b.vertices.end());
+        normals_.insert(normals_.end(), b.normals.begin(), b.normals.end());
+        uvs_.insert(uvs_.end(), b.uvs.begin(), b.uvs.end());
+        faces_.insert(faces_.end(), b.faces.begin(), b.faces.end());
+        for (const auto& mtllib : b.mtllibs) {
+            parse_mtllib_(mtllib);
         }
+    }
+}
+
+void OBJReader::parse_block_(const char* begin, const char* end, Block& b)
+{
+    // Count the elements so that they can be stored without reallocating
+    std::size_t numVerts{0};
+    std::size_t numNormals{0};
+    std::size_t numUVs{0};
+    std::size_t numFaces{0};
+    for (TextScanner counter(begin, end); not counter.atEnd();
+         counter.nextLine()) {
+        auto keyword = counter.token();
+        if (keyword == "v") {
+            numVerts++;
+        } else if (keyword == "vn") {
+            numNormals++;
+        } else if (keyword == "vt") {
+            numUVs++;
+        } else if (keyword == "f") {
+            numFaces++;
+        }
+    }
+    b.vertices.reserve(numVerts);
+    b.normals.reserve(numNormals);
+    b.uvs.reserve(numUVs);
+    b.faces.reserve(numFaces);
+
+    for (TextScanner scanner(begin, end); not scanner.atEnd();
+         scanner.nextLine()) {
+        auto keyword = scanner.token();
 
         // Handle vertices
-        if (std::regex_match(strs[0], vertex)) {
-            parse_vertex_(strs);
+        if (keyword == "v") {
+            cv::Vec3d v;
+            if (not scanner.parseDouble(v[0]) or
+                not scanner.parseDouble(v[1]) or
+                not scanner.parseDouble(v[2])) {
+                throw IOException("Invalid vertex in obj file");
+            }
+            b.vertices.push_back(v);
         }
 
         // Handle normals
-        else if (std::regex_match(strs[0], normal)) {
-            parse_normal_(strs);
+        else if (keyword == "vn") {
+            cv::Vec3d n;
+            if (not scanner.parseDouble(n[0]) or
+                not scanner.parseDouble(n[1]) or
+                not scanner.parseDouble(n[2])) {
+                throw IOException("Invalid normal in obj file");
+            }
+            b.normals.push_back(n);
         }
 
         // Handle texture coordinates
-        else if (std::regex_match(strs[0], tcoord)) {
-            parse_tcoord_(strs);
+        else if (keyword == "vt") {
+            cv::Vec2d uv;
+            if (not scanner.parseDouble(uv[0]) or
+                not scanner.parseDouble(uv[1])) {
+                throw IOException("Invalid texture coordinate in obj file");
+            }
+            b.uvs.push_back(uv);
         }
 
-        // Handle faces
-        else if (std::regex_match(strs[0], face)) {
-            parse_face_(strs);
+        // Handle faces: v, v/vt, v//vn, or v/vt/vn
+        else if (keyword == "f") {
+            Face f;
+            std::size_t size{0};
+            while (not scanner.atLineEnd()) {
+                if (size == VALID_FACE_SIZE) {
+                    throw IOException(
+                        "Parsed unsupported, non-triangular face");
+                }
+                std::int64_t v{0};
+                std::int64_t vt{NOT_PRESENT};
+                std::int64_t vn{NOT_PRESENT};
+                bool valid = scanner.parseInt(v);
+                if (valid and scanner.consume('/')) {
+                    if (not scanner.consume('/')) {
+                        valid = scanner.parseInt(vt);
+                        if (valid and scanner.consume('/')) {
+                            valid = scanner.parseInt(vn);
+                        }
+                    } else {
+                        valid = scanner.parseInt(vn);
+                    }
+                }
+                if (not valid or not scanner.atSeparator()) {
+                    throw IOException("Invalid face in obj file");
+                }
+                f[size++] = VertexRefs(
+                    static_cast<int>(v), static_cast<int>(vt),
+                    static_cast<int>(vn));
+            }
+            if (size != VALID_FACE_SIZE) {
+                throw IOException("Parsed unsupported, non-triangular face");
+            }
+            b.faces.push_back(f);
         }
 
         // Handle mtllib
-        else if (std::regex_match(strs[0], mtllib)) {
-            parse_mtllib_(strs);
+        else if (keyword == "mtllib") {
+            b.mtllibs.emplace_back(scanner.token());
         }
-
-        // Otherwise clear and continue
-        strs.clear();
     }
-
-    ifs.close();
 }
 
-void OBJReader::parse_vertex_(const std::vector<std::string>& strs)
-{
-    auto a = std::stod(strs[1]);
-    auto b = std::stod(strs[2]);
-    auto c = std::stod(strs[3]);
-    vertices_.emplace_back(a, b, c);
-}
-
-void OBJReader::parse_normal_(const std::vector<std::string>& strs)
-{
-    auto a = std::stod(strs[1]);
-    auto b = std::stod(strs[2]);
-    auto c = std::stod(strs[3]);
-    normals_.emplace_back(a, b, c);
-}
-
-void OBJReader::parse_tcoord_(const std::vector<std::string>& strs)
-{
-    auto u = std::stod(strs[1]);
-    auto v = std::stod(strs[2]);
-    uvs_.emplace_back(u, v);
-}
-
-void OBJReader::parse_face_(const std::vector<std::string>& strs)
-{
-    OBJReader::Face f;
-    std::vector<std::string> vinfo;
-    std::vector<std::string> sub(std::begin(strs) + 1, std::end(strs));
-
-    for (const auto& s : sub) {
-        auto faceType = classify_vertref_(s);
-        vinfo = split(s, '/');
-        switch (faceType) {
-            case RefType::Vertex:
-                f.emplace_back(std::stoi(vinfo[0]), NOT_PRESENT, NOT_PRESENT);
-                break;
-            case RefType::VertexWithTexture:
-                f.emplace_back(
-                    std::stoi(vinfo[0]), std::stoi(vinfo[1]), NOT_PRESENT);
-                break;
-            case RefType::VertexWithNormal:
-                f.emplace_back(
-                    std::stoi(vinfo[0]), NOT_PRESENT, std::stoi(vinfo[1]));
-                break;
-            case RefType::VertexWithTextureAndNormal:
-                f.emplace_back(
-                    std::stoi(vinfo[0]), std::stoi(vinfo[1]),
-                    std::stoi(vinfo[2]));
-                break;
-            case RefType::Invalid:
-                throw IOException("Invalid face in obj file");
-        }
-        vinfo.clear();
-    }
-    faces_.push_back(f);
-}
-
-void OBJReader::parse_mtllib_(const std::vector<std::string>& strs)
+void OBJReader::parse_mtllib_(const std::string& name)
 {
     // Get mtl path, relative to OBJ directory
-    fs::path mtlPath = path_.parent_path() / strs[1];
+    fs::path mtlPath = path_.parent_path() / name;
 
     // Open the mtl file
     std::ifstream ifs(mtlPath.string());
@@ -196,43 +258,6 @@ void OBJReader::parse_mtllib_(const std::vector<std::string>& strs)
     ifs.close();
 }
 
-OBJReader::RefType OBJReader::classify_vertref_(const std::string& ref)
-{
-    const char delimiter = '/';
-    auto slashCount = std::count(ref.begin(), ref.end(), delimiter);
-
-    // Invalid slash positions
-    if (ref.front() == delimiter || ref.back() == delimiter) {
-        throw IOException("Invalid face in obj file");
-    }
-
-    // No slashes
-    if (slashCount == 0) {
-        return RefType::Vertex;
-    }
-
-    // One slash
-    else if (slashCount == 1) {
-        return RefType::VertexWithTexture;
-    }
-
-    // Two slashes
-    else if (slashCount == 2) {
-        // Get the two slash positions
-        auto pos0 = ref.find(delimiter, 0);
-        auto pos1 = ref.find(delimiter, pos0 + 1);
-
-        // If positions differ by 1, then v//vn
-        // else v/vt/vn
-        if ((pos1 - pos0) == 1) {
-            return RefType::VertexWithNormal;
-        } else {
-            return RefType::VertexWithTextureAndNormal;
-        }
-    }
-    return RefType::Invalid;
-}
-
 void OBJReader::build_mesh_()
 {
     // Reset output structures
@@ -255,13 +280,9 @@ void OBJReader::build_mesh_()
     ITKCell::CellAutoPointer cell;
     ITKMesh::CellIdentifier cid = 0;
     for (const auto& face : faces_) {
-        if (face.size() != VALID_FACE_SIZE) {
-            throw IOException("Parsed unsupported, non-triangular face");
-        }
-
         cell.TakeOwnership(new ITKTriangle);
         auto idInCell = 0;
-        for (auto vinfo : face) {
+        for (const auto& vinfo : face) {
             if (vinfo[0] - 1 < 0 ||
                 vinfo[0] - 1 >= static_cast<int>(vertices_.size())) {
                 throw IOException("Out-of-range vertex reference");
@@ -158,6 +158,9 @@ auto OBJWriter::write_vertices_() -> int
     outputMesh_ << "# Vertices: " << mesh_->GetNumberOfPoints() << "\n";
 
     // Iterate over all of the points
+    pointLinks_.assign(
+        mesh_->GetNumberOfPoints(),
+        cv::Vec3i(UNSET_VALUE, UNSET_VALUE, UNSET_VALUE));
     uint32_t vIndex = 1;
     uint32_t vnIndex = 1;
     for (auto pt = mesh_->GetPoints()->Begin(); pt != mesh_->GetPoints()->End();
@@ -178,7 +181,7 @@ auto OBJWriter::write_vertices_() -> int
         }
 
         // Add this vertex to the point links
-        pointLinks_.insert({pt.Index(), pointLink});
+        pointLinks_.at(pt.Index()) = pointLink;
 
         ++vIndex;
     }
@@ -211,9 +214,9 @@ auto OBJWriter::write_texture_coordinates_() -> int
         cv::Vec2d uv = uvMap_->get(pId);
         outputMesh_ << "vt " << uv[0] << " " << uv[1] << "\n";
 
-        // Find this UV map's point in _point_links and set its vt value to our
-        // current position in the vt list
-        pointLinks_.find(pId)->second[1] = vtIndex;
+        // Set this UV map's point's vt value to our current position in the
+        // vt list
+        pointLinks_.at(pId)[1] = vtIndex;
 
         ++vtIndex;
     }
@@ -238,15 +241,15 @@ auto OBJWriter::write_faces_() -> int
     for (auto cell = mesh_->GetCells()->Begin();
          cell != mesh_->GetCells()->End(); ++cell) {
         // Starts a new face line
-        outputMesh_ << "f ";
+        outputMesh_ << "f";
 
         // Iterate over the points of this face
         for (point = cell.Value()->PointIdsBegin();
              point != cell.Value()->PointIdsEnd(); ++point) {
 
-            cv::Vec3i pointLink = pointLinks_.find(*point)->second;
+            const auto& pointLink = pointLinks_.at(*point);
 
-            outputMesh_ << pointLink[0];
+            outputMesh_ << " " << pointLink[0];
 
             // Write the vtIndex
             if (pointLink[1] != UNSET_VALUE) {
@@ -262,8 +265,6 @@ auto OBJWriter::write_faces_() -> int
 
                 outputMesh_ << "/" << pointLink[2];
             }
-
-            outputMesh_ << " ";
         }
         outputMesh_ << "\n";
     }
@@ -0,0 +1,228 @@
+#include "vc/core/math/OrientationField.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+#include "vc/core/math/StructureTensorField.hpp"
+#include "vc/core/util/Logging.hpp"
+#include "vc/core/util/ThreadPool.hpp"
+
+using namespace volcart;
+
+namespace
+{
+// Largest quantized value of an encoded component
+constexpr int DIRECTION_MAX{(1 << OrientationField::DIRECTION_BITS) - 1};
+constexpr int COHERENCE_MAX{(1 << OrientationField::COHERENCE_BITS) - 1};
+
+// Quantize a value in [-1, 1]
+auto QuantizeUnit(double v) -> int
+{
+    auto q = static_cast<int>(std::lround((v + 1) * 0.5 * DIRECTION_MAX));
+    return std::clamp(q, 0, DIRECTION_MAX);
+}
+
+// Dequantize a value to [-1, 1]
+auto DequantizeUnit(int q) -> double
+{
+    return 2.0 * q / DIRECTION_MAX - 1.0;
+}
+}  // namespace
+
+OrientationField::OrientationField(Volume::Pointer field)
+    : field_{std::move(field)}
+{
+    if (not field_) {
+        throw std::invalid_argument("orientation field requires volume");
+    }
+    if (field_->voxelType() != Volume::VoxelType::UInt16) {
+        throw std::invalid_argument("orientation field volume must be 16-bit");
+    }
+}
+
+void OrientationField::Compute(
+    const Volume::Pointer& src,
+    const Volume::Pointer& field,
+    int radius,
+    int kernelSize,
+    std::size_t numThreads)
+{
+    if (not src or not field) {
+        throw std::invalid_argument("orientation field requires volumes");
+    }
+    field->setSliceWidth(src->sliceWidth());
+    field->setSliceHeight(src->sliceHeight());
+    field->setNumberOfSlices(src->numSlices());
+    field->setVoxelSize(src->voxelSize());
+    field->setVoxelType(Volume::VoxelType::UInt16);
+    field->setMin(0);
+    field->setMax(std::numeric_limits<std::uint16_t>::max());
+
+    // Cache a layer's worth of blocks per thread
+    auto threads = numThreads;
+    if (threads == 0) {
+        threads = ThreadPool::Global().numThreads();
+    }
+    const auto bs = StructureTensorField::DEFAULT_BLOCK_SIZE;
+    StructureTensorField tensors(src, radius, kernelSize, bs, 2 * threads);
+
+    const auto width = src->sliceWidth();
+    const auto height = src->sliceHeight();
+    const auto slices = src->numSlices();
+    const auto blocksX = (width + bs - 1) / bs;
+    const auto blocksY = (height + bs - 1) / bs;
+    const auto numBlocks = static_cast<std::size_t>(blocksX * blocksY);
+    for (int z0 = 0; z0 < slices; z0 += bs) {
+        const auto depth = std::min(bs, slices - z0);
+        std::vector<cv::Mat> layer;
+        for (int i = 0; i < depth; i++) {
+            layer.emplace_back(height, width, CV_16UC1);
+        }
+
+        // Each block reads a single block of the tensor field
+        ParallelChunks(numBlocks, numThreads, [&](auto begin, auto end) {
+            for (auto b = begin; b < end; b++) {
+                const auto x0 = static_cast<int>(b % blocksX) * bs;
+                const auto y0 = static_cast<int>(b / blocksX) * bs;
+                const auto x1 = std::min(x0 + bs, width);
+                const auto y1 = std::min(y0 + bs, height);
+                for (int z = 0; z < depth; z++) {
+                    auto& slice = layer[z];
+                    for (int y = y0; y < y1; y++) {
+                        auto* row = slice.ptr<std::uint16_t>(y);
+                        for (int x = x0; x < x1; x++) {
+                            auto st = tensors.tensorAt(x, y, z0 + z);
+                            row[x] = Encode(ComputeEigenPairs(st));
+                        }
+                    }
+                }
+            }
+        });
+
+        for (int z = 0; z < depth; z++) {
+            field->setSliceData(z0 + z, layer[z]);
+        }
+        Logger()->debug(
+            "Computed orientation field slices [{}, {})", z0, z0 + depth);
+    }
+}
+
+auto OrientationField::Encode(const EigenPairs& ep) -> std::uint16_t
+{
+    // Flip the direction into the upper hemisphere
+    auto e = ep[0].second;
+    auto sum = std::abs(e[0]) + std::abs(e[1]) + std::abs(e[2]);
+    if (sum <= 0) {
+        return 0;
+    }
+    if (e[2] < 0) {
+        e = -e;
+    }
+
+    // Hemi-octahedral projection, rotated to fill the unit square
+    auto px = e[0] / sum;
+    auto py = e[1] / sum;
+    auto qx = QuantizeUnit(px + py);
+    auto qy = QuantizeUnit(px - py);
+
+    // Coherence of the two largest eigenvalues
+    double c{0};
+    auto l0 = ep[0].first;
+    auto l1 = ep[1].first;
+    if (l0 + l1 > 0) {
+        c = std::clamp((l0 - l1) / (l0 + l1), 0.0, 1.0);
+    }
+    auto qc = static_cast<int>(std::lround(c * COHERENCE_MAX));
+
+    return static_cast<std::uint16_t>(
+        qx | (qy << DIRECTION_BITS) | (qc << (2 * DIRECTION_BITS)));
+}
+
+auto OrientationField::DecodeDirection(std::uint16_t v) -> cv::Vec3d
+{
+    auto qx = DequantizeUnit(v & DIRECTION_MAX);
+    auto qy = DequantizeUnit((v >> DIRECTION_BITS) & DIRECTION_MAX);
+    auto px = 0.5 * (qx + qy);
+    auto py = 0.5 * (qx - qy);
+    auto pz = std::max(1.0 - std::abs(px) - std::abs(py), 0.0);
+    return cv::normalize(cv::Vec3d{px, py, pz});
+}
+
+auto OrientationField::DecodeCoherence(std::uint16_t v) -> double
+{
+    auto qc = (v >> (2 * DIRECTION_BITS)) & COHERENCE_MAX;
+    return static_cast<double>(qc) / COHERENCE_MAX;
+}
+
+auto OrientationField::volume() const -> Volume::Pointer { return field_; }
+
+auto OrientationField::directionAt(int x, int y, int z) const -> cv::Vec3d
+{
+    return DecodeDirection(field_->intensityAt(x, y, z));
+}
+
+auto OrientationField::directionAt(const cv::Vec3d& v) const -> cv::Vec3d
+{
+    const auto x0 = static_cast<int>(std::floor(v[0]));
+    const auto y0 = static_cast<int>(std::floor(v[1]));
+    const auto z0 = static_cast<int>(std::floor(v[2]));
+    const cv::Vec3d f{v[0] - x0, v[1] - y0, v[2] - z0};
+
+    // Blend the corner directions, flipped to agree with the nearest one
+    std::array<cv::Vec3d, 8> dirs;
+    std::array<double, 8> weights{};
+    std::size_t nearest{0};
+    for (std::size_t i = 0; i < 8; i++) {
+        const auto dx = static_cast<int>(i & 1);
+        const auto dy = static_cast<int>((i >> 1) & 1);
+        const auto dz = static_cast<int>((i >> 2) & 1);
+        dirs[i] = directionAt(x0 + dx, y0 + dy, z0 + dz);
+        weights[i] = (dx ? f[0] : 1 - f[0]) * (dy ? f[1] : 1 - f[1]) *
+                     (dz ? f[2] : 1 - f[2]);
+        if (weights[i] > weights[nearest]) {
+            nearest = i;
+        }
+    }
+    cv::Vec3d sum{0, 0, 0};
+    for (std::size_t i = 0; i < 8; i++) {
+        auto s = dirs[i].dot(dirs[nearest]) < 0 ? -1.0 : 1.0;
+        sum += s * weights[i] * dirs[i];
+    }
+    auto norm = cv::norm(sum);
+    return norm > 0 ? sum / norm : dirs[nearest];
+}
+
+auto OrientationField::coherenceAt(const cv::Vec3d& v) const -> double
+{
+    const auto x0 = static_cast<int>(std::floor(v[0]));
+    const auto y0 = static_cast<int>(std::floor(v[1]));
+    const auto z0 = static_cast<int>(std::floor(v[2]));
+    const cv::Vec3d f{v[0] - x0, v[1] - y0, v[2] - z0};
+    double c{0};
+    for (int i = 0; i < 8; i++) {
+        const auto dx = i & 1;
+        const auto dy = (i >> 1) & 1;
+        const auto dz = (i >> 2) & 1;
+        auto w = (dx ? f[0] : 1 - f[0]) * (dy ? f[1] : 1 - f[1]) *
+                 (dz ? f[2] : 1 - f[2]);
+        auto v = field_->intensityAt(x0 + dx, y0 + dy, z0 + dz);
+        c += w * DecodeCoherence(v);
+    }
+    return c;
+}
+
+auto OrientationField::directionsAt(
+    const std::vector<cv::Vec3d>& vs, std::size_t numThreads) const
+    -> std::vector<cv::Vec3d>
+{
+    std::vector<cv::Vec3d> result(vs.size());
+    ParallelChunks(vs.size(), numThreads, [&](auto begin, auto end) {
+        for (auto i = begin; i < end; i++) {
+            result[i] = directionAt(vs[i]);
+        }
+    });
+    return result;
+}
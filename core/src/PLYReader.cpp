@@ -1,13 +1,82 @@
 #include "vc/core/io/PLYReader.hpp"
 
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <thread>
+
+#include "vc/core/io/MappedFile.hpp"
+#include "vc/core/io/TextScanner.hpp"
 #include "vc/core/types/Exceptions.hpp"
 #include "vc/core/util/Logging.hpp"
-#include "vc/core/util/String.hpp"
 
 using namespace volcart;
 using namespace volcart::io;
 namespace fs = volcart::filesystem;
 
+namespace
+{
+// Smallest number of lines parsed by a thread
+constexpr std::size_t MIN_LINES_PER_THREAD = 1 << 15;
+
+// Call fn(begin, end) on ranges of [0, count) in parallel
+template <typename Fn>
+void ParallelRanges(std::size_t count, std::size_t numThreads, const Fn& fn)
+{
+    if (numThreads == 0) {
+        numThreads = std::max(1U, std::thread::hardware_concurrency());
+    }
+    auto n = std::clamp<std::size_t>(
+        count / MIN_LINES_PER_THREAD, 1, numThreads);
+
+    std::vector<std::exception_ptr> errors(n);
+    auto run = [&](std::size_t i) {
+        try {
+            fn(i * count / n, (i + 1) * count / n);
+        } catch (...) {
+            errors[i] = std::current_exception();
+        }
+    };
+    std::vector<std::thread> threads;
+    for (std::size_t i = 1; i < n; i++) {
+        threads.emplace_back(run, i);
+    }
+    run(0);
+    for (auto& t : threads) {
+        t.join();
+    }
+    for (const auto& e : errors) {
+        if (e) {
+            std::rethrow_exception(e);
+        }
+    }
+}
+
+auto HostIsLittleEndian() -> bool
+{
+    const std::uint16_t one{1};
+    std::uint8_t first{0};
+    std::memcpy(&first, &one, 1);
+    return first == 1;
+}
+
+// Read a binary value, reversing its bytes if requested
+template <typename T>
+auto ReadBinary(const char* pos, bool swap) -> double
+{
+    std::array<char, sizeof(T)> bytes{};
+    std::memcpy(bytes.data(), pos, sizeof(T));
+    if (swap) {
+        std::reverse(bytes.begin(), bytes.end());
+    }
+    T value;
+    std::memcpy(&value, bytes.data(), sizeof(T));
+    return static_cast<double>(value);
+}
+}  // namespace
+
 ITKMesh::Pointer PLYReader::read()
 {
     if (inputPath_.empty() || !fs::exists(inputPath_)) {
@@ -20,134 +89,444 @@ ITKMesh::Pointer PLYReader::read()
     faceList_.clear();
     properties_.clear();
     elementsList_.clear();
+    elementProperties_.clear();
+    skippedLine_.clear();
     outMesh_ = ITKMesh::New();
     numVertices_ = 0;
     numFaces_ = 0;
-    hasLeadingChar_ = true;
+    numVertexProperties_ = 0;
+    format_ = Format::ASCII;
     hasPointNorm_ = false;
 
-    int skippedElementCnt = 0;
-
-    plyFile_.open(inputPath_.string());
-    if (!plyFile_.is_open()) {
-        auto msg = "Open file " + inputPath_.string() + " failed.";
-        throw volcart::IOException(msg);
+    const MappedFile file(inputPath_);
+    const auto* body = parse_header_(file.data(), file.end());
+    if (format_ == Format::ASCII) {
+        read_ascii_(body, file.end());
+    } else {
+        read_binary_(body, file.end());
     }
-    parse_header_();
-    for (auto& cur : elementsList_) {
-        if (cur == "vertex") {
-            read_points_();
-        } else if (cur == "face") {
-            read_faces_();
-        } else {
-            int curSkip = skippedLine_[skippedElementCnt];
-            for (int i = 0; i < curSkip; i++) {
-                std::getline(plyFile_, line_);
-            }
-            skippedElementCnt++;
-        }
-    }
-    plyFile_.close();
     create_mesh_();
 
     return outMesh_;
 }
 
-void PLYReader::parse_header_()
-{
-    std::getline(plyFile_, line_);
-    while (line_ != "end_header") {
-        if (line_.find("element") != std::string::npos) {
-            auto splitLine = split(line_, ' ');
-            elementsList_.push_back(splitLine[1]);
-            if (splitLine[1] == "vertex") {
-                numVertices_ = std::stoi(splitLine[2]);
-            } else if (splitLine[1] == "face") {
-                numFaces_ = std::stoi(splitLine[2]);
+auto PLYReader::parse_header_(const char* begin, const char* end)
+    -> const char*
+{
+    TextScanner scanner(begin, end);
+    if (scanner.token() != "ply") {
+        throw volcart::IOException("Not a PLY file: " + inputPath_.string());
+    }
+    scanner.nextLine();
+
+    std::string element;
+    while (true) {
+        if (scanner.atEnd()) {
+            throw volcart::IOException("PLY header is missing end_header");
+        }
+
+        auto keyword = scanner.token();
+        if (keyword == "end_header") {
+            scanner.nextLine();
+            break;
+        }
+
+        if (keyword == "format") {
+            auto format = scanner.token();
+            if (format == "ascii") {
+                format_ = Format::ASCII;
+            } else if (format == "binary_little_endian") {
+                format_ = Format::BinaryLittleEndian;
+            } else if (format == "binary_big_endian") {
+                format_ = Format::BinaryBigEndian;
             } else {
-                skippedLine_.push_back(std::stoi(splitLine[2]));
-            }
-            std::getline(plyFile_, line_);
-            splitLine = split(line_, ' ');
-            int currentLine{0};
-            while (splitLine[0] == "property") {
-                if (splitLine[1] == "list") {
-                    hasLeadingChar_ = line_.find("uchar") != std::string::npos;
+                auto msg = "Unsupported PLY format: " + std::string(format);
+                throw volcart::IOException(msg);
+            }
+        } else if (keyword == "element") {
+            element = scanner.token();
+            std::int64_t count{0};
+            if (not scanner.parseInt(count) or count < 0) {
+                throw volcart::IOException("Invalid PLY element: " + element);
+            }
+            elementsList_.push_back(element);
+            elementProperties_.emplace_back();
+            if (element == "vertex") {
+                numVertices_ = static_cast<int>(count);
+            } else if (element == "face") {
+                numFaces_ = static_cast<int>(count);
+            } else {
+                skippedLine_.push_back(static_cast<int>(count));
+            }
+        } else if (keyword == "property") {
+            if (elementProperties_.empty()) {
+                throw volcart::IOException("PLY property without element");
+            }
+            Property prop;
+            auto type = scanner.token();
+            if (type == "list") {
+                prop.isList = true;
+                prop.countType = parse_type_(scanner.token());
+                type = scanner.token();
+            }
+            prop.type = parse_type_(type);
+            prop.name = scanner.token();
+
+            auto& props = elementProperties_.back();
+            if (element == "vertex") {
+                if (prop.isList) {
+                    throw volcart::IOException(
+                        "PLY vertex list properties are not supported");
                 }
-                // Not sure how to handle if it's not the vertices or faces
-                else {
-                    if (splitLine[2] == "nx") {
-                        hasPointNorm_ = true;
-                    }
-                    properties_[splitLine[2]] = currentLine;
+                if (prop.name == "nx") {
+                    hasPointNorm_ = true;
                 }
-                std::getline(plyFile_, line_);
-                currentLine++;
-                splitLine = split(line_, ' ');
+                properties_[prop.name] = static_cast<int>(props.size());
+                numVertexProperties_ = static_cast<int>(props.size()) + 1;
             }
-        } else {
-            std::getline(plyFile_, line_);
+            props.push_back(prop);
         }
+        scanner.nextLine();
     }
     if (numFaces_ == 0) {
         Logger()->warn("Warning: No face information found");
     }
-    std::getline(plyFile_, line_);
+    return scanner.position();
 
 }  // ParseHeader
 
-void PLYReader::read_points_()
-{
-    for (int i = 0; i < numVertices_; i++) {
-        SimpleMesh::Vertex curPoint;
-        auto curLine = split(line_, ' ');
-        curPoint.x = std::stod(curLine[properties_["x"]]);
-        curPoint.y = std::stod(curLine[properties_["y"]]);
-        curPoint.z = std::stod(curLine[properties_["z"]]);
-        if (properties_.find("nx") != properties_.end()) {
-            curPoint.nx = std::stod(curLine[properties_["nx"]]);
-            curPoint.ny = std::stod(curLine[properties_["ny"]]);
-            curPoint.nz = std::stod(curLine[properties_["nz"]]);
+template <typename ValueReader>
+void PLYReader::read_points_(const ValueReader& readValues)
+{
+    if (properties_.count("x") == 0 or properties_.count("y") == 0 or
+        properties_.count("z") == 0) {
+        throw volcart::IOException("PLY vertices are missing coordinates");
+    }
+    auto column = [this](const std::string& name) {
+        auto it = properties_.find(name);
+        return (it == properties_.end()) ? -1 : it->second;
+    };
+    auto x = column("x");
+    auto y = column("y");
+    auto z = column("z");
+    auto nx = column("nx");
+    auto ny = column("ny");
+    auto nz = column("nz");
+    auto r = column("r");
+    auto g = column("g");
+    auto b = column("b");
+    if (nx >= 0 and (ny < 0 or nz < 0)) {
+        throw volcart::IOException("PLY vertices have incomplete normals");
+    }
+    if (r >= 0 and (g < 0 or b < 0)) {
+        throw volcart::IOException("PLY vertices have incomplete colors");
+    }
+
+    pointList_.resize(numVertices_);
+    ParallelRanges(numVertices_, numThreads_, [&](auto begin, auto stop) {
+        std::vector<double> values(numVertexProperties_);
+        for (auto i = begin; i < stop; i++) {
+            readValues(i, values);
+
+            SimpleMesh::Vertex curPoint{};
+            curPoint.x = values[x];
+            curPoint.y = values[y];
+            curPoint.z = values[z];
+            if (nx >= 0) {
+                curPoint.nx = values[nx];
+                curPoint.ny = values[ny];
+                curPoint.nz = values[nz];
+            }
+            if (r >= 0) {
+                curPoint.r = static_cast<int>(values[r]);
+                curPoint.g = static_cast<int>(values[g]);
+                curPoint.b = static_cast<int>(values[b]);
+            }
+            pointList_[i] = curPoint;
+        }
+    });
+}
+
+void PLYReader::read_ascii_(const char* begin, const char* end)
+{
+    index_lines_(begin, end);
+
+    std::size_t line{0};
+    int skippedElementCnt = 0;
+    for (auto& cur : elementsList_) {
+        if (cur == "vertex") {
+            auto first = line;
+            read_points_([&](auto i, auto& values) {
+                auto lineIdx = first + i;
+                auto lineEnd =
+                    (lineIdx + 1 < lines_.size()) ? lines_[lineIdx + 1] : end;
+                TextScanner scanner(lines_[lineIdx], lineEnd);
+                for (auto& v : values) {
+                    if (not scanner.parseDouble(v)) {
+                        throw volcart::IOException(
+                            "Invalid vertex in PLY file");
+                    }
+                }
+            });
+            line += numVertices_;
+        } else if (cur == "face") {
+            read_ascii_faces_(line, end);
+            line += numFaces_;
+        } else {
+            line += skippedLine_[skippedElementCnt];
+            skippedElementCnt++;
         }
-        if (properties_.find("r") != properties_.end()) {
-            curPoint.r = stoi(curLine[properties_["r"]]);
-            curPoint.g = stoi(curLine[properties_["g"]]);
-            curPoint.b = stoi(curLine[properties_["b"]]);
+    }
+
+    // The line index points into the mapped file
+    lines_.clear();
+}
+
+void PLYReader::read_binary_(const char* begin, const char* end)
+{
+    const auto* pos = begin;
+    int skippedElementCnt = 0;
+    for (std::size_t e = 0; e < elementsList_.size(); e++) {
+        const auto& cur = elementsList_[e];
+        const auto& props = elementProperties_[e];
+        if (cur == "vertex") {
+            // Vertex records have a fixed size
+            std::vector<std::size_t> offsets;
+            std::size_t stride{0};
+            for (const auto& prop : props) {
+                offsets.push_back(stride);
+                stride += type_size_(prop.type);
+            }
+            auto size = stride * static_cast<std::size_t>(numVertices_);
+            if (static_cast<std::size_t>(end - pos) < size) {
+                throw volcart::IOException("Unexpected end of PLY file");
+            }
+            const auto* records = pos;
+            read_points_([&](auto i, auto& values) {
+                const auto* record = records + i * stride;
+                for (std::size_t p = 0; p < props.size(); p++) {
+                    values[p] = read_value_(record + offsets[p], props[p].type);
+                }
+            });
+            pos += size;
+        } else if (cur == "face") {
+            pos = read_binary_faces_(pos, end, props);
+        } else {
+            auto count =
+                static_cast<std::size_t>(skippedLine_[skippedElementCnt]);
+            pos = skip_binary_element_(pos, end, props, count);
+            skippedElementCnt++;
         }
-        pointList_.push_back(curPoint);
-        std::getline(plyFile_, line_);
     }
 }
 
-void PLYReader::read_faces_()
+void PLYReader::index_lines_(const char* begin, const char* end)
+{
+    std::size_t expected = numVertices_ + numFaces_;
+    for (const auto& skipped : skippedLine_) {
+        expected += skipped;
+    }
+
+    lines_.clear();
+    lines_.reserve(expected);
+    const auto* pos = begin;
+    while (lines_.size() < expected and pos < end) {
+        lines_.push_back(pos);
+        auto remaining = static_cast<std::size_t>(end - pos);
+        const auto* nl =
+            static_cast<const char*>(std::memchr(pos, '\n', remaining));
+        pos = (nl == nullptr) ? end : nl + 1;
+    }
+    if (lines_.size() < expected) {
+        throw volcart::IOException("Unexpected end of PLY file");
+    }
+}
+
+void PLYReader::read_ascii_faces_(std::size_t first, const char* end)
 {
-    for (int i = 0; i < numFaces_; i++) {
-        SimpleMesh::Cell face;
-        auto curFace = split(line_, ' ');
-        if (hasLeadingChar_) {
-            int pointsPerFace = std::stoi(curFace[0]);
+    faceList_.resize(numFaces_);
+    ParallelRanges(numFaces_, numThreads_, [&](auto begin, auto stop) {
+        for (auto i = begin; i < stop; i++) {
+            auto lineIdx = first + i;
+            auto lineEnd =
+                (lineIdx + 1 < lines_.size()) ? lines_[lineIdx + 1] : end;
+            TextScanner scanner(lines_[lineIdx], lineEnd);
+
+            std::int64_t pointsPerFace{0};
+            if (not scanner.parseInt(pointsPerFace)) {
+                throw volcart::IOException("Invalid face in PLY file");
+            }
             if (pointsPerFace != 3) {
                 auto msg = "Not a Triangular Mesh";
                 throw volcart::IOException(msg);
-            } else {
-                face = SimpleMesh::Cell(
-                    std::stoul(curFace[1]), std::stoul(curFace[2]),
-                    std::stoul(curFace[3]));
-                faceList_.push_back(face);
             }
-        } else {
-            if (curFace.size() != 3) {
+            std::int64_t v1{0};
+            std::int64_t v2{0};
+            std::int64_t v3{0};
+            if (not scanner.parseInt(v1) or not scanner.parseInt(v2) or
+                not scanner.parseInt(v3) or v1 < 0 or v2 < 0 or v3 < 0) {
+                throw volcart::IOException("Invalid face in PLY file");
+            }
+            faceList_[i] = SimpleMesh::Cell(v1, v2, v3);
+        }
+    });
+}
+
+auto PLYReader::read_binary_faces_(
+    const char* pos, const char* end, const std::vector<Property>& props)
+    -> const char*
+{
+    // The first list holds the vertex indices
+    auto indices = std::find_if(
+        props.begin(), props.end(), [](const auto& p) { return p.isList; });
+    if (indices == props.end()) {
+        throw volcart::IOException("PLY faces have no vertex indices");
+    }
+
+    auto check = [&](std::size_t size) {
+        if (static_cast<std::size_t>(end - pos) < size) {
+            throw volcart::IOException("Unexpected end of PLY file");
+        }
+    };
+
+    faceList_.resize(numFaces_);
+    for (std::size_t i = 0; i < faceList_.size(); i++) {
+        for (auto prop = props.begin(); prop != props.end(); ++prop) {
+            auto size = type_size_(prop->type);
+            if (not prop->isList) {
+                check(size);
+                pos += size;
+                continue;
+            }
+
+            auto countSize = type_size_(prop->countType);
+            check(countSize);
+            auto count =
+                static_cast<std::size_t>(read_value_(pos, prop->countType));
+            pos += countSize;
+            check(count * size);
+            if (prop != indices) {
+                pos += count * size;
+                continue;
+            }
+
+            if (count != 3) {
                 auto msg = "Not a Triangular Mesh";
                 throw volcart::IOException(msg);
-            } else {
-                face = SimpleMesh::Cell(
-                    std::stoul(curFace[1]), std::stoul(curFace[2]),
-                    std::stoul(curFace[3]));
-                faceList_.push_back(face);
             }
+            auto v1 = read_value_(pos, prop->type);
+            auto v2 = read_value_(pos + size, prop->type);
+            auto v3 = read_value_(pos + 2 * size, prop->type);
+            if (v1 < 0 or v2 < 0 or v3 < 0) {
+                throw volcart::IOException("Invalid face in PLY file");
+            }
+            faceList_[i] = SimpleMesh::Cell(
+                static_cast<std::uint64_t>(v1), static_cast<std::uint64_t>(v2),
+                static_cast<std::uint64_t>(v3));
+            pos += count * size;
         }
-        std::getline(plyFile_, line_);
     }
+    return pos;
+}
+
+auto PLYReader::skip_binary_element_(
+    const char* pos,
+    const char* end,
+    const std::vector<Property>& props,
+    std::size_t count) -> const char*
+{
+    for (std::size_t i = 0; i < count; i++) {
+        for (const auto& prop : props) {
+            std::size_t size{type_size_(prop.type)};
+            if (prop.isList) {
+                auto countSize = type_size_(prop.countType);
+                if (static_cast<std::size_t>(end - pos) < countSize) {
+                    throw volcart::IOException("Unexpected end of PLY file");
+                }
+                auto n =
+                    static_cast<std::size_t>(read_value_(pos, prop.countType));
+                size = countSize + n * size;
+            }
+            if (static_cast<std::size_t>(end - pos) < size) {
+                throw volcart::IOException("Unexpected end of PLY file");
+            }
+            pos += size;
+        }
+    }
+    return pos;
+}
+
+auto PLYReader::parse_type_(std::string_view name) -> Type
+{
+    if (name == "char" or name == "int8") {
+        return Type::Int8;
+    }
+    if (name == "uchar" or name == "uint8") {
+        return Type::UInt8;
+    }
+    if (name == "short" or name == "int16") {
+        return Type::Int16;
+    }
+    if (name == "ushort" or name == "uint16") {
+        return Type::UInt16;
+    }
+    if (name == "int" or name == "int32") {
+        return Type::Int32;
+    }
+    if (name == "uint" or name == "uint32") {
+        return Type::UInt32;
+    }
+    if (name == "float" or name == "float32") {
+        return Type::Float32;
+    }
+    if (name == "double" or name == "float64") {
+        return Type::Float64;
+    }
+    auto msg = "Unsupported PLY property type: " + std::string(name);
+    throw volcart::IOException(msg);
+}
+
+auto PLYReader::type_size_(Type type) -> std::size_t
+{
+    switch (type) {
+        case Type::Int8:
+        case Type::UInt8:
+            return 1;
+        case Type::Int16:
+        case Type::UInt16:
+            return 2;
+        case Type::Int32:
+        case Type::UInt32:
+        case Type::Float32:
+            return 4;
+        case Type::Float64:
+            return 8;
+    }
+    return 0;
+}
+
+auto PLYReader::read_value_(const char* pos, Type type) const -> double
+{
+    auto swap = (format_ == Format::BinaryLittleEndian) != HostIsLittleEndian();
+    switch (type) {
+        case Type::Int8:
+            return ReadBinary<std::int8_t>(pos, swap);
+        case Type::UInt8:
+            return ReadBinary<std::uint8_t>(pos, swap);
+        case Type::Int16:
+            return ReadBinary<std::int16_t>(pos, swap);
+        case Type::UInt16:
+            return ReadBinary<std::uint16_t>(pos, swap);
+        case Type::Int32:
+            return ReadBinary<std::int32_t>(pos, swap);
+        case Type::UInt32:
+            return ReadBinary<std::uint32_t>(pos, swap);
+        case Type::Float32:
+            return ReadBinary<float>(pos, swap);
+        case Type::Float64:
+            return ReadBinary<double>(pos, swap);
+    }
+    return 0;
 }
 
 void PLYReader::create_mesh_()
@@ -185,4 +564,6 @@ PLYReader::PLYReader(fs::path path) : inputPath_{std::move(path)} {}
 
 void PLYReader::setPath(fs::path path) { inputPath_ = std::move(path); }
 
+void PLYReader::setNumThreads(std::size_t n) { numThreads_ = n; }
+
 auto PLYReader::getMesh() -> ITKMesh::Pointer { return outMesh_; }
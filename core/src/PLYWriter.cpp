@@ -1,5 +1,10 @@
 #include "vc/core/io/PLYWriter.hpp"
 
+#include <array>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
 #include "vc/core/types/Exceptions.hpp"
 #include "vc/core/util/Logging.hpp"
 
@@ -7,6 +12,28 @@ using namespace volcart;
 using namespace volcart::io;
 namespace fs = volcart::filesystem;
 
+// Binary output is buffered and written in blocks of this size
+static constexpr std::size_t BINARY_BLOCK_SIZE = 1 << 20;
+
+// Number of significant digits of 32-bit ASCII output (iostream default)
+static constexpr int DEFAULT_ASCII_PRECISION = 6;
+
+// Append a value to a buffer in little-endian byte order
+template <typename T>
+static inline void AppendLE(std::vector<char>& buffer, T value)
+{
+    using Bits = std::conditional_t<
+        sizeof(T) == 8, uint64_t,
+        std::conditional_t<
+            sizeof(T) == 4, uint32_t,
+            std::conditional_t<sizeof(T) == 2, uint16_t, uint8_t>>>;
+    Bits bits{0};
+    std::memcpy(&bits, &value, sizeof(T));
+    for (std::size_t i = 0; i < sizeof(T); i++) {
+        buffer.push_back(static_cast<char>((bits >> (8 * i)) & 0xFF));
+    }
+}
+
 static inline auto PtIntensity(
     std::size_t idx, const UVMap::Pointer& uvMap, const cv::Mat& image)
     -> double
@@ -25,7 +52,11 @@ auto PLYWriter::write() -> int
     }
 
     // Open the file stream
-    outputMesh_.open(outputPath_.string());
+    auto mode = std::ios::out;
+    if (format_ != Format::ASCII) {
+        mode |= std::ios::binary;
+    }
+    outputMesh_.open(outputPath_.string(), mode);
     if (!outputMesh_.is_open()) {
         return EXIT_FAILURE;
     }
@@ -58,36 +89,39 @@ auto PLYWriter::write_header_() -> int
         return EXIT_FAILURE;
     }
 
-    outputMesh_ << "ply" << std::endl;
-    outputMesh_ << "format ascii 1.0" << std::endl;
-    outputMesh_ << "comment VC PLY Exporter v1.0" << std::endl;
+    outputMesh_ << "ply\n";
+    if (format_ == Format::ASCII) {
+        outputMesh_ << "format ascii 1.0\n";
+    } else {
+        outputMesh_ << "format binary_little_endian 1.0\n";
+    }
+    outputMesh_ << "comment VC PLY Exporter v1.0\n";
 
     // Vertex Info for Header
-    outputMesh_ << "element vertex " << mesh_->GetNumberOfPoints() << std::endl;
-    outputMesh_ << "property float x" << std::endl;
-    outputMesh_ << "property float y" << std::endl;
-    outputMesh_ << "property float z" << std::endl;
-    outputMesh_ << "property float nx" << std::endl;
-    outputMesh_ << "property float ny" << std::endl;
-    outputMesh_ << "property float nz" << std::endl;
+    std::string type = (precision_ == Precision::Float32) ? "float" : "double";
+    outputMesh_ << "element vertex " << mesh_->GetNumberOfPoints() << "\n";
+    outputMesh_ << "property " << type << " x\n";
+    outputMesh_ << "property " << type << " y\n";
+    outputMesh_ << "property " << type << " z\n";
+    outputMesh_ << "property " << type << " nx\n";
+    outputMesh_ << "property " << type << " ny\n";
+    outputMesh_ << "property " << type << " nz\n";
 
     // Color info for vertices
-    if ((not texture_.empty() and uvMap_ and not uvMap_->empty()) or
-        not vcolors_.empty()) {
-        outputMesh_ << "property uchar red" << std::endl;
-        outputMesh_ << "property uchar green" << std::endl;
-        outputMesh_ << "property uchar blue" << std::endl;
+    if (has_colors_()) {
+        outputMesh_ << "property uchar red\n";
+        outputMesh_ << "property uchar green\n";
+        outputMesh_ << "property uchar blue\n";
     }
 
     // Face Info for Header
     if (mesh_->GetNumberOfCells() != 0) {
-        outputMesh_ << "element face " << mesh_->GetNumberOfCells()
-                    << std::endl;
-        outputMesh_ << "property list uchar int vertex_indices" << std::endl;
+        outputMesh_ << "element face " << mesh_->GetNumberOfCells() << "\n";
+        outputMesh_ << "property list uchar int vertex_indices\n";
     }
 
     // End header
-    outputMesh_ << "end_header" << std::endl;
+    outputMesh_ << "end_header\n";
 
     return EXIT_SUCCESS;
 }
@@ -100,7 +134,16 @@ auto PLYWriter::write_vertices_() -> int
     }
     Logger()->info("Writing vertices...");
 
+    auto colors = has_colors_();
+    auto ascii = format_ == Format::ASCII;
+    if (ascii and precision_ == Precision::Float64) {
+        outputMesh_.precision(std::numeric_limits<double>::max_digits10);
+    } else {
+        outputMesh_.precision(DEFAULT_ASCII_PRECISION);
+    }
+
     // Iterate over all of the points
+    std::vector<char> buffer;
     for (auto point = mesh_->GetPoints()->Begin();
          point != mesh_->GetPoints()->End(); ++point) {
 
@@ -108,31 +151,45 @@ auto PLYWriter::write_vertices_() -> int
         ITKPixel normal;
         mesh_->GetPointData(point.Index(), &normal);
 
-        // Write the point position components and its normal components.
-        outputMesh_ << point.Value()[0] << " " << point.Value()[1] << " "
-                    << point.Value()[2] << " ";
-        outputMesh_ << normal[0] << " " << normal[1] << " " << normal[2];
-
-        // If the texture has images and a uv map, write texture info
-        if (not texture_.empty() and uvMap_ and not uvMap_->empty()) {
-            // Get the intensity for this point from the texture. If it doesn't
-            // exist, set to 0.
-            double intensity{0};
-            if (uvMap_->contains(point.Index())) {
-                intensity = PtIntensity(point.Index(), uvMap_, texture_);
-                intensity = cvRound(intensity * 255.0 / 65535.0);
+        std::array<double, 6> values{point.Value()[0], point.Value()[1],
+                                     point.Value()[2], normal[0],
+                                     normal[1],        normal[2]};
+
+        if (ascii) {
+            // Write the point position components and its normal components.
+            outputMesh_ << values[0] << " " << values[1] << " " << values[2]
+                        << " ";
+            outputMesh_ << values[3] << " " << values[4] << " " << values[5];
+
+            // If the texture has images and a uv map, write texture info
+            if (colors) {
+                auto i = vertex_color_(point.Index());
+                outputMesh_ << " " << i << " " << i << " " << i;
             }
 
-            auto i = static_cast<int>(intensity);
-            outputMesh_ << " " << i << " " << i << " " << i;
-        } else if (not vcolors_.empty()) {
-            float val = vcolors_.at(point.Index());
-            auto i = static_cast<int>(val * 255.F / 65535.F);
-            outputMesh_ << " " << i << " " << i << " " << i;
+            outputMesh_ << "\n";
+            continue;
         }
 
-        outputMesh_ << std::endl;
+        for (const auto& v : values) {
+            if (precision_ == Precision::Float32) {
+                AppendLE(buffer, static_cast<float>(v));
+            } else {
+                AppendLE(buffer, v);
+            }
+        }
+        if (colors) {
+            auto i = static_cast<uint8_t>(vertex_color_(point.Index()));
+            AppendLE(buffer, i);
+            AppendLE(buffer, i);
+            AppendLE(buffer, i);
+        }
+        if (buffer.size() >= BINARY_BLOCK_SIZE) {
+            outputMesh_.write(buffer.data(), buffer.size());
+            buffer.clear();
+        }
     }
+    outputMesh_.write(buffer.data(), buffer.size());
 
     return EXIT_SUCCESS;
 }
@@ -146,27 +203,71 @@ auto PLYWriter::write_faces_() -> int
     Logger()->info("Writing faces...");
 
     // Iterate over the faces of the mesh
+    std::vector<char> buffer;
     ITKPointInCellIterator point;
     for (auto cell = mesh_->GetCells()->Begin();
          cell != mesh_->GetCells()->End(); ++cell) {
-        outputMesh_ << cell->Value()->GetNumberOfPoints();
+        auto numPoints = cell->Value()->GetNumberOfPoints();
 
-        // Iterate over the points of this face and write the point IDs
+        if (format_ == Format::ASCII) {
+            outputMesh_ << numPoints;
+
+            // Iterate over the points of this face and write the point IDs
+            for (point = cell.Value()->PointIdsBegin();
+                 point != cell.Value()->PointIdsEnd(); ++point) {
+                outputMesh_ << " " << *point;
+            }
+            outputMesh_ << "\n";
+            continue;
+        }
+
+        AppendLE(buffer, static_cast<uint8_t>(numPoints));
         for (point = cell.Value()->PointIdsBegin();
              point != cell.Value()->PointIdsEnd(); ++point) {
-            outputMesh_ << " " << *point;
+            AppendLE(buffer, static_cast<int32_t>(*point));
+        }
+        if (buffer.size() >= BINARY_BLOCK_SIZE) {
+            outputMesh_.write(buffer.data(), buffer.size());
+            buffer.clear();
         }
-        outputMesh_ << std::endl;
     }
+    outputMesh_.write(buffer.data(), buffer.size());
 
     return EXIT_SUCCESS;
 }
 
+auto PLYWriter::has_colors_() const -> bool
+{
+    return (not texture_.empty() and uvMap_ and not uvMap_->empty()) or
+           not vcolors_.empty();
+}
+
+auto PLYWriter::vertex_color_(std::size_t idx) const -> int
+{
+    // Get the intensity for this point from the texture. If it doesn't exist,
+    // set to 0.
+    if (not texture_.empty() and uvMap_ and not uvMap_->empty()) {
+        double intensity{0};
+        if (uvMap_->contains(idx)) {
+            intensity = PtIntensity(idx, uvMap_, texture_);
+            intensity = cvRound(intensity * 255.0 / 65535.0);
+        }
+        return static_cast<int>(intensity);
+    }
+
+    float val = vcolors_.at(idx);
+    return static_cast<int>(val * 255.F / 65535.F);
+}
+
 void PLYWriter::setVertexColors(const std::vector<uint16_t>& c)
 {
     vcolors_ = c;
 }
 
+void PLYWriter::setFormat(Format format) { format_ = format; }
+
+void PLYWriter::setPrecision(Precision precision) { precision_ = precision; }
+
 PLYWriter::PLYWriter(fs::path outputPath, ITKMesh::Pointer mesh)
     : outputPath_{std::move(outputPath)}, mesh_{std::move(mesh)}
 {
@@ -0,0 +1,285 @@
+#include "vc/core/neighborhood/PatchSampler.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <utility>
+
+#include "vc/core/util/ThreadPool.hpp"
+
+using namespace volcart;
+
+namespace
+{
+// Number of windows which are sampled ahead of the consumer
+constexpr std::size_t WINDOWS_IN_FLIGHT{2};
+
+// Bits per coordinate of a Morton code
+constexpr int MORTON_BITS{21};
+
+// Spread the low 21 bits of v so that there are two zero bits between each
+auto SpreadBits(std::uint64_t v) -> std::uint64_t
+{
+    v &= (1ULL << MORTON_BITS) - 1;
+    v = (v | v << 32) & 0x1F00000000FFFFULL;
+    v = (v | v << 16) & 0x1F0000FF0000FFULL;
+    v = (v | v << 8) & 0x100F00F00F00F00FULL;
+    v = (v | v << 4) & 0x10C30C30C30C30C3ULL;
+    v = (v | v << 2) & 0x1249249249249249ULL;
+    return v;
+}
+
+// Morton (Z-order) code of a voxel position. Coordinates are clamped to
+// [0, 2^21).
+auto Morton(const cv::Vec3d& p) -> std::uint64_t
+{
+    constexpr auto MAX = static_cast<double>((1ULL << MORTON_BITS) - 1);
+    auto clamp = [](double v) {
+        return static_cast<std::uint64_t>(std::clamp(std::floor(v), 0.0, MAX));
+    };
+    return SpreadBits(clamp(p[0])) | SpreadBits(clamp(p[1])) << 1 |
+           SpreadBits(clamp(p[2])) << 2;
+}
+}  // namespace
+
+struct PatchSampler::Plan {
+    /** Input volume */
+    Volume::Pointer volume;
+    /** Patch generator */
+    CuboidGenerator generator;
+    /** Patch sample offsets */
+    std::shared_ptr<const CuboidGenerator::SampleOffsets> offsets;
+    /** Patch centers */
+    std::vector<cv::Vec3d> centers;
+    /** Locality key of each request: z-slab, then Morton code */
+    std::vector<std::pair<std::int64_t, std::uint64_t>> keys;
+    /** Request index at each batch position */
+    std::vector<std::size_t> requests;
+    /** Patches in a batch */
+    std::size_t batchSize{0};
+    /** Batches in a window */
+    std::size_t windowSize{0};
+    /** Sampling threads */
+    std::size_t numThreads{0};
+
+    /** Number of batches */
+    [[nodiscard]] auto numBatches() const -> std::size_t
+    {
+        return (requests.size() + batchSize - 1) / batchSize;
+    }
+
+    /** Number of windows */
+    [[nodiscard]] auto numWindows() const -> std::size_t
+    {
+        return (numBatches() + windowSize - 1) / windowSize;
+    }
+
+    /** Sample the batches of a window */
+    [[nodiscard]] auto sample(std::size_t window) const -> Window;
+};
+
+auto PatchSampler::Plan::sample(std::size_t window) const -> Window
+{
+    const auto firstBatch = window * windowSize;
+    const auto lastBatch = std::min(firstBatch + windowSize, numBatches());
+    const auto first = firstBatch * batchSize;
+    const auto last = std::min(lastBatch * batchSize, requests.size());
+    const auto size = offsets->samples.size();
+
+    // Setup the batches
+    Window batches(lastBatch - firstBatch);
+    for (std::size_t b = 0; b < batches.size(); b++) {
+        auto begin = first + b * batchSize;
+        auto end = std::min(begin + batchSize, last);
+        auto& batch = batches[b];
+        batch.indices.assign(
+            requests.begin() + static_cast<std::ptrdiff_t>(begin),
+            requests.begin() + static_cast<std::ptrdiff_t>(end));
+        batch.patches.resize((end - begin) * size);
+    }
+
+    // Sample the window's patches in locality order, so that each thread
+    // works through a contiguous run of slabs
+    std::vector<std::size_t> positions(last - first);
+    for (std::size_t i = 0; i < positions.size(); i++) {
+        positions[i] = first + i;
+    }
+    std::stable_sort(
+        positions.begin(), positions.end(), [this](auto a, auto b) {
+            return keys[requests[a]] < keys[requests[b]];
+        });
+    ParallelChunks(positions.size(), numThreads, [&](auto begin, auto end) {
+        for (auto i = begin; i < end; i++) {
+            auto pos = positions[i] - first;
+            auto& batch = batches[pos / batchSize];
+            auto* out = batch.patches.data() + (pos % batchSize) * size;
+            generator.computeInto(
+                volume, centers[requests[positions[i]]], *offsets, out);
+        }
+    });
+    return batches;
+}
+
+PatchSampler::PatchSampler(
+    Volume::Pointer volume,
+    const CuboidGenerator& generator,
+    const std::vector<cv::Vec3d>& axes)
+    : volume_{std::move(volume)}, generator_{generator}
+{
+    if (not volume_) {
+        throw std::invalid_argument("Volume is null");
+    }
+    offsets_ = std::make_shared<const CuboidGenerator::SampleOffsets>(
+        generator_.precompute(axes));
+}
+
+PatchSampler::~PatchSampler() = default;
+
+void PatchSampler::setCenters(std::vector<cv::Vec3d> centers)
+{
+    centers_ = std::move(centers);
+    reset();
+}
+
+auto PatchSampler::centers() const -> const std::vector<cv::Vec3d>&
+{
+    return centers_;
+}
+
+void PatchSampler::setBatchSize(std::size_t n)
+{
+    if (n == 0) {
+        throw std::invalid_argument("Batch size must be positive");
+    }
+    batchSize_ = n;
+    reset();
+}
+
+auto PatchSampler::batchSize() const -> std::size_t { return batchSize_; }
+
+void PatchSampler::setOrder(Order order)
+{
+    order_ = order;
+    reset();
+}
+
+auto PatchSampler::order() const -> Order { return order_; }
+
+void PatchSampler::setSlabDepth(std::size_t n)
+{
+    if (n == 0) {
+        throw std::invalid_argument("Slab depth must be positive");
+    }
+    slabDepth_ = n;
+    reset();
+}
+
+auto PatchSampler::slabDepth() const -> std::size_t { return slabDepth_; }
+
+void PatchSampler::setPrefetchBatches(std::size_t n)
+{
+    if (n == 0) {
+        throw std::invalid_argument("Prefetch batches must be positive");
+    }
+    prefetchBatches_ = n;
+    reset();
+}
+
+auto PatchSampler::prefetchBatches() const -> std::size_t
+{
+    return prefetchBatches_;
+}
+
+void PatchSampler::setNumThreads(std::size_t n)
+{
+    numThreads_ = n;
+    reset();
+}
+
+auto PatchSampler::numThreads() const -> std::size_t { return numThreads_; }
+
+auto PatchSampler::patchExtent() const -> std::array<std::size_t, 3>
+{
+    return offsets_->extent;
+}
+
+auto PatchSampler::patchSize() const -> std::size_t
+{
+    return offsets_->samples.size();
+}
+
+auto PatchSampler::numBatches() const -> std::size_t
+{
+    return (centers_.size() + batchSize_ - 1) / batchSize_;
+}
+
+void PatchSampler::reset()
+{
+    plan_.reset();
+    windows_.clear();
+    ready_.clear();
+    nextWindow_ = 0;
+}
+
+auto PatchSampler::next() -> std::optional<Batch>
+{
+    // Plan the iteration on first use
+    if (not plan_) {
+        auto plan = std::make_shared<Plan>();
+        plan->volume = volume_;
+        plan->generator = generator_;
+        plan->offsets = offsets_;
+        plan->centers = centers_;
+        plan->batchSize = batchSize_;
+        plan->windowSize = prefetchBatches_;
+        plan->numThreads = numThreads_;
+
+        // Bucket by z-slab, then sort by Z-order within each slab
+        const auto depth = static_cast<double>(slabDepth_);
+        plan->keys.reserve(centers_.size());
+        for (const auto& c : centers_) {
+            auto slab = static_cast<std::int64_t>(std::floor(c[2] / depth));
+            plan->keys.emplace_back(slab, Morton(c));
+        }
+        plan->requests.resize(centers_.size());
+        for (std::size_t i = 0; i < centers_.size(); i++) {
+            plan->requests[i] = i;
+        }
+        if (order_ == Order::Locality) {
+            const auto& keys = plan->keys;
+            std::stable_sort(
+                plan->requests.begin(), plan->requests.end(),
+                [&keys](auto a, auto b) { return keys[a] < keys[b]; });
+        }
+        plan_ = std::move(plan);
+    }
+
+    if (ready_.empty()) {
+        submit_();
+        if (windows_.empty()) {
+            return std::nullopt;
+        }
+        auto future = std::move(windows_.front());
+        windows_.pop_front();
+        auto window = ThreadPool::Global().wait(future);
+        for (auto& batch : window) {
+            ready_.push_back(std::move(batch));
+        }
+        submit_();
+    }
+
+    auto batch = std::move(ready_.front());
+    ready_.pop_front();
+    return batch;
+}
+
+void PatchSampler::submit_()
+{
+    auto& pool = ThreadPool::Global();
+    while (windows_.size() < WINDOWS_IN_FLIGHT and
+           nextWindow_ < plan_->numWindows()) {
+        windows_.push_back(pool.submit(
+            [plan = plan_, w = nextWindow_]() { return plan->sample(w); }));
+        nextWindow_++;
+    }
+}
@@ -1,11 +1,28 @@
 #include "vc/core/types/PerPixelMap.hpp"
 
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <mutex>
+#include <numeric>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 #include <opencv2/imgcodecs.hpp>
 
 #include "vc/core/io/PointSetIO.hpp"
 #include "vc/core/io/TIFFIO.hpp"
 #include "vc/core/types/Exceptions.hpp"
+#include "vc/core/util/Iteration.hpp"
 #include "vc/core/util/Logging.hpp"
+#include "vc/core/util/ThreadPool.hpp"
 
 using namespace volcart;
 namespace fs = volcart::filesystem;
@@ -22,9 +39,128 @@ inline auto CellMapPath(const fs::path& p) -> fs::path
     return p.parent_path() / (p.stem().string() + "_cellmap.tif");
 }
 
+inline auto BarycentricMapPath(const fs::path& p) -> fs::path
+{
+    return p.parent_path() / (p.stem().string() + "_barycentric.tif");
+}
+
+///// Compact file format /////
+// All values are stored in native byte order:
+//   CompactHeader
+//   uint32_t index[height * width]: record number or NO_MAPPING, row-major
+//   float records[count][6]: {x, y, z, nx, ny, nz}
+static constexpr std::array<char, 8> COMPACT_MAGIC{'V', 'C', 'P', 'P',
+                                                   'M', 'C', '\r', '\n'};
+static constexpr uint32_t COMPACT_VERSION{1};
+static constexpr uint32_t NO_MAPPING{PerPixelMap::CompactData::NO_RECORD};
+static constexpr size_t RECORD_DIMS{PerPixelMap::CompactData::RECORD_DIMS};
+
+namespace
+{
+struct CompactHeader {
+    std::array<char, 8> magic{COMPACT_MAGIC};
+    uint32_t version{COMPACT_VERSION};
+    uint32_t recordDims{RECORD_DIMS};
+    uint64_t width{0};
+    uint64_t height{0};
+    uint64_t count{0};
+};
+}  // namespace
+
+// Read-only memory mapping of a Compact PPM file
+struct PerPixelMap::MappedFile {
+    explicit MappedFile(const fs::path& path)
+    {
+        auto fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw IOException("Failed to open file: " + path.string());
+        }
+        struct stat st{};
+        if (::fstat(fd, &st) != 0) {
+            ::close(fd);
+            throw IOException("Failed to stat file: " + path.string());
+        }
+        size = static_cast<size_t>(st.st_size);
+        if (size < sizeof(CompactHeader)) {
+            ::close(fd);
+            throw IOException("File too small for PPM: " + path.string());
+        }
+        auto* ptr = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (ptr == MAP_FAILED) {
+            throw IOException("Failed to memory map file: " + path.string());
+        }
+        data = static_cast<const char*>(ptr);
+
+        std::memcpy(&header, data, sizeof(CompactHeader));
+        auto invalid = [&]() {
+            ::munmap(const_cast<char*>(data), size);
+            throw IOException("Invalid compact PPM file: " + path.string());
+        };
+        if (header.version != COMPACT_VERSION or
+            header.recordDims != RECORD_DIMS) {
+            invalid();
+        }
+
+        // Compare the dimensions and count with the elements which fit in
+        // the rest of the file, so that a corrupt header cannot overflow
+        auto available = size - sizeof(CompactHeader);
+        if (header.width > 0 and
+            header.height > available / sizeof(uint32_t) / header.width) {
+            invalid();
+        }
+        auto pixels = header.width * header.height;
+        available -= pixels * sizeof(uint32_t);
+        if (header.count > available / (RECORD_DIMS * sizeof(float))) {
+            invalid();
+        }
+        index = reinterpret_cast<const uint32_t*>(data + sizeof(CompactHeader));
+        records = reinterpret_cast<const float*>(index + pixels);
+
+        // Check every record number once, so that lookups need no checks
+        for (size_t i = 0; i < pixels; ++i) {
+            if (index[i] != NO_MAPPING and index[i] >= header.count) {
+                invalid();
+            }
+        }
+    }
+
+    ~MappedFile() { ::munmap(const_cast<char*>(data), size); }
+
+    MappedFile(const MappedFile&) = delete;
+    auto operator=(const MappedFile&) -> MappedFile& = delete;
+
+    // Check whether a file starts with the Compact magic number
+    static auto IsCompact(const fs::path& path) -> bool
+    {
+        std::array<char, 8> magic{};
+        std::ifstream file(path.string(), std::ios::binary);
+        file.read(magic.data(), magic.size());
+        return file and magic == COMPACT_MAGIC;
+    }
+
+    [[nodiscard]] auto recordIndex(size_t y, size_t x) const -> uint32_t
+    {
+        return index[y * header.width + x];
+    }
+
+    [[nodiscard]] auto record(uint32_t i) const -> cv::Vec6d
+    {
+        const auto* r = records + size_t{i} * RECORD_DIMS;
+        return {r[0], r[1], r[2], r[3], r[4], r[5]};
+    }
+
+    CompactHeader header;
+    const char* data{nullptr};
+    size_t size{0};
+    const uint32_t* index{nullptr};
+    const float* records{nullptr};
+};
+
 ///// Metadata /////
 void PerPixelMap::setDimensions(size_t h, size_t w)
 {
+    mapped_.reset();
     height_ = h;
     width_ = w;
     initialize_map_();
@@ -32,20 +168,27 @@ void PerPixelMap::setDimensions(size_t h, size_t w)
 
 void PerPixelMap::setWidth(size_t w)
 {
+    mapped_.reset();
     width_ = w;
     initialize_map_();
 }
 
 void PerPixelMap::setHeight(size_t h)
 {
+    mapped_.reset();
     height_ = h;
     initialize_map_();
 }
 
 // Get individual mappings
-auto PerPixelMap::getAsPixelMap(size_t y, size_t x) -> PPM::PixelMap
+auto PerPixelMap::getAsPixelMap(size_t y, size_t x) const -> PPM::PixelMap
+{
+    return {x, y, getMapping(y, x)};
+}
+
+auto PerPixelMap::getAsPixelMap(PixelIndex idx) const -> PPM::PixelMap
 {
-    return {x, y, map_(y, x)};
+    return getAsPixelMap(idx / width_, idx % width_);
 }
 
 // Return only valid mappings
@@ -54,6 +197,20 @@ auto PerPixelMap::getMappings() const -> std::vector<PPM::PixelMap>
     // Output vector
     std::vector<PixelMap> mappings;
 
+    // Memory-mapped records are already restricted to the valid mappings
+    if (mapped_) {
+        mappings.reserve(mapped_->header.count);
+        for (size_t y = 0; y < height_; ++y) {
+            for (size_t x = 0; x < width_; ++x) {
+                auto i = mapped_->recordIndex(y, x);
+                if (i != NO_MAPPING) {
+                    mappings.emplace_back(x, y, mapped_->record(i));
+                }
+            }
+        }
+        return mappings;
+    }
+
     // For each pixel...
     for (size_t y = 0; y < height_; ++y) {
         for (size_t x = 0; x < width_; ++x) {
@@ -70,6 +227,255 @@ auto PerPixelMap::getMappings() const -> std::vector<PPM::PixelMap>
     return mappings;
 }
 
+auto PerPixelMap::numMappings() const -> size_t
+{
+    if (mapped_) {
+        return mapped_->header.count;
+    }
+    if (mask_.empty()) {
+        return width_ * height_;
+    }
+    return static_cast<size_t>(cv::countNonZero(mask_ == 255));
+}
+
+// Bits per axis of a space-filling curve key
+static constexpr int CURVE_BITS{21};
+
+// Interleave the bits of a cell's coordinates, most significant first, with
+// x as the least significant axis
+static auto Interleave(const std::array<uint32_t, 3>& c, int bits) -> uint64_t
+{
+    uint64_t key{0};
+    for (auto b = bits - 1; b >= 0; b--) {
+        for (auto i = 2; i >= 0; i--) {
+            key = (key << 1) | ((c[i] >> b) & 1U);
+        }
+    }
+    return key;
+}
+
+// Hilbert curve index of a cell, using Skilling's transpose algorithm
+// ("Programming the Hilbert curve", 2004)
+static auto HilbertKey(std::array<uint32_t, 3> c, int bits) -> uint64_t
+{
+    // Inverse undo excess work
+    const uint32_t m = 1U << (bits - 1);
+    for (auto q = m; q > 1; q >>= 1) {
+        const auto p = q - 1;
+        for (auto i = 0; i < 3; i++) {
+            if (c[i] & q) {
+                c[0] ^= p;
+            } else {
+                auto t = (c[0] ^ c[i]) & p;
+                c[0] ^= t;
+                c[i] ^= t;
+            }
+        }
+    }
+
+    // Gray encode
+    for (auto i = 1; i < 3; i++) {
+        c[i] ^= c[i - 1];
+    }
+    uint32_t t{0};
+    for (auto q = m; q > 1; q >>= 1) {
+        if (c[2] & q) {
+            t ^= q - 1;
+        }
+    }
+    for (auto& v : c) {
+        v ^= t;
+    }
+
+    // The transposed index holds the key's bits in axis order
+    return Interleave({c[2], c[1], c[0]}, bits);
+}
+
+auto PerPixelMap::getMappingIndices(
+    MappingOrder order, const cv::Vec3i& cell) const -> std::vector<PixelIndex>
+{
+    // Count the mappings in each row, then fill the rows in parallel
+    std::vector<size_t> rowBegin(height_ + 1, 0);
+    ParallelFor(range(height_), [&](auto y) {
+        size_t count{0};
+        for (size_t x = 0; x < width_; ++x) {
+            count += hasMapping(y, x) ? 1 : 0;
+        }
+        rowBegin[y + 1] = count;
+    });
+    std::partial_sum(rowBegin.begin(), rowBegin.end(), rowBegin.begin());
+    std::vector<PixelIndex> indices(rowBegin.back());
+    ParallelFor(range(height_), [&](auto y) {
+        auto i = rowBegin[y];
+        for (size_t x = 0; x < width_; ++x) {
+            if (hasMapping(y, x)) {
+                indices[i++] = y * width_ + x;
+            }
+        }
+    });
+    if (order == MappingOrder::Raster or indices.empty()) {
+        return indices;
+    }
+    if (order == MappingOrder::Morton or order == MappingOrder::Hilbert) {
+        return curve_order_(std::move(indices), order, cell);
+    }
+
+    // Get the slice sampled by a pixel
+    auto slice = [this](PixelIndex i) -> int64_t {
+        auto z = getMapping(i / width_, i % width_)[2];
+        return std::isfinite(z) ? static_cast<int64_t>(std::floor(z)) : 0;
+    };
+    auto minSlice = std::numeric_limits<int64_t>::max();
+    auto maxSlice = std::numeric_limits<int64_t>::min();
+    for (const auto& i : indices) {
+        auto s = slice(i);
+        minSlice = std::min(minSlice, s);
+        maxSlice = std::max(maxSlice, s);
+    }
+
+    // Fall back to a comparison sort if the range of slices is unreasonable
+    auto numSlices = static_cast<size_t>(maxSlice - minSlice) + 1;
+    if (numSlices > indices.size()) {
+        std::stable_sort(
+            indices.begin(), indices.end(),
+            [&](auto lhs, auto rhs) { return slice(lhs) < slice(rhs); });
+        return indices;
+    }
+
+    // Counting sort by slice
+    std::vector<size_t> offsets(numSlices + 1, 0);
+    for (const auto& i : indices) {
+        offsets[slice(i) - minSlice + 1]++;
+    }
+    std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+    std::vector<PixelIndex> sorted(indices.size());
+    for (const auto& i : indices) {
+        sorted[offsets[slice(i) - minSlice]++] = i;
+    }
+    return sorted;
+}
+
+auto PerPixelMap::curve_order_(
+    std::vector<PixelIndex> indices,
+    MappingOrder order,
+    const cv::Vec3i& cell) const -> std::vector<PixelIndex>
+{
+    if (cell[0] < 1 or cell[1] < 1 or cell[2] < 1) {
+        throw std::invalid_argument("Cell shape must be positive");
+    }
+
+    // Get the cell sampled by each pixel
+    std::vector<std::array<int64_t, 3>> cells(indices.size());
+    ParallelFor(range(indices.size()), [&](auto i) {
+        auto pos = getMapping(indices[i] / width_, indices[i] % width_);
+        for (auto a = 0; a < 3; a++) {
+            auto v = std::isfinite(pos[a]) ? std::floor(pos[a] / cell[a]) : 0;
+            cells[i][a] = static_cast<int64_t>(v);
+        }
+    });
+
+    // Cell coordinates relative to the first cell of the bounding box. Boxes
+    // which are too large for the key are clamped.
+    std::array<int64_t, 3> minCell;
+    minCell.fill(std::numeric_limits<int64_t>::max());
+    int64_t maxExtent{0};
+    for (const auto& c : cells) {
+        for (auto a = 0; a < 3; a++) {
+            minCell[a] = std::min(minCell[a], c[a]);
+        }
+    }
+    for (const auto& c : cells) {
+        for (auto a = 0; a < 3; a++) {
+            maxExtent = std::max(maxExtent, c[a] - minCell[a]);
+        }
+    }
+    constexpr int64_t maxCoord{(int64_t{1} << CURVE_BITS) - 1};
+    int bits{1};
+    while (bits < CURVE_BITS and (maxExtent >> bits) > 0) {
+        bits++;
+    }
+
+    // Sort by key. Ties are broken by index, which keeps Raster order.
+    std::vector<std::pair<uint64_t, PixelIndex>> keys(indices.size());
+    ParallelFor(range(indices.size()), [&](auto i) {
+        std::array<uint32_t, 3> c;
+        for (auto a = 0; a < 3; a++) {
+            c[a] = static_cast<uint32_t>(
+                std::min(cells[i][a] - minCell[a], maxCoord));
+        }
+        auto key = (order == MappingOrder::Hilbert) ? HilbertKey(c, bits)
+                                                    : Interleave(c, bits);
+        keys[i] = {key, indices[i]};
+    });
+    std::sort(keys.begin(), keys.end());
+    for (size_t i = 0; i < keys.size(); i++) {
+        indices[i] = keys[i].second;
+    }
+    return indices;
+}
+
+auto PerPixelMap::getMappingValues(const std::vector<PixelIndex>& indices) const
+    -> std::vector<cv::Vec6d>
+{
+    std::vector<cv::Vec6d> values(indices.size());
+    ParallelFor(range(indices.size()), [&](auto i) {
+        auto idx = indices[i];
+        values[i] = getMapping(idx / width_, idx % width_);
+    });
+    return values;
+}
+
+void PerPixelMap::applyTransform(const cv::Matx44d& tfm)
+{
+    detach_();
+    const auto linear = tfm.get_minor<3, 3>(0, 0);
+    const cv::Vec3d translation{tfm(0, 3), tfm(1, 3), tfm(2, 3)};
+    if (cv::determinant(linear) == 0) {
+        throw std::invalid_argument("Transform is not invertible");
+    }
+    const auto normalTfm = linear.inv().t();
+
+    ParallelFor(range(height_), [&](auto y) {
+        for (size_t x = 0; x < width_; ++x) {
+            if (not hasMapping(y, x)) {
+                continue;
+            }
+            auto& m = map_(y, x);
+            cv::Vec3d pos{m[0], m[1], m[2]};
+            cv::Vec3d normal{m[3], m[4], m[5]};
+            pos = linear * pos + translation;
+            auto length = cv::norm(normal);
+            normal = normalTfm * normal;
+            auto newLength = cv::norm(normal);
+            if (newLength > 0) {
+                normal *= length / newLength;
+            }
+            m = {pos[0], pos[1], pos[2], normal[0], normal[1], normal[2]};
+        }
+    });
+}
+
+auto PerPixelMap::data() const -> const cv::Vec6d*
+{
+    if (mapped_ or not initialized()) {
+        return nullptr;
+    }
+    return &map_(0, 0);
+}
+
+auto PerPixelMap::compactData() const -> CompactData
+{
+    if (not mapped_) {
+        throw std::logic_error("PerPixelMap is not memory mapped");
+    }
+    // Alias the mapping so that each pointer keeps it alive
+    CompactData result;
+    result.index = {mapped_, mapped_->index};
+    result.records = {mapped_, mapped_->records};
+    result.count = mapped_->header.count;
+    return result;
+}
+
 // Initialize map
 void PerPixelMap::initialize_map_()
 {
@@ -77,32 +483,150 @@ void PerPixelMap::initialize_map_()
         map_ = volcart::OrderedPointSet<cv::Vec6d>::Fill(
             width_, height_, {0, 0, 0, 0, 0, 0});
     }
+    update_memory_();
+}
+
+void PerPixelMap::detach_()
+{
+    // Threads which call a non-const accessor at the same time wait for the
+    // first to copy the map. The flag is cleared once the copy is complete,
+    // so a thread which sees it cleared also sees the copy.
+    auto& state = detachState_;
+    if (not state.mapped.load(std::memory_order_acquire)) {
+        return;
+    }
+    const std::lock_guard<std::mutex> lock(state.mutex);
+    if (not mapped_) {
+        state.mapped.store(false, std::memory_order_release);
+        return;
+    }
+
+    auto mapped = mapped_;
+    initialize_map_();
+    mask_ = cv::Mat::zeros(height_, width_, CV_8UC1);
+    for (size_t y = 0; y < height_; ++y) {
+        for (size_t x = 0; x < width_; ++x) {
+            auto i = mapped->recordIndex(y, x);
+            if (i != NO_MAPPING) {
+                map_(y, x) = mapped->record(i);
+                mask_.at<uint8_t>(y, x) = 255;
+            }
+        }
+    }
+    mapped_.reset();
+    update_memory_();
+    state.mapped.store(false, std::memory_order_release);
+    Logger()->debug("Copied memory-mapped PPM into memory");
+}
+
+void PerPixelMap::update_memory_()
+{
+    auto bytes = map_.size() * sizeof(cv::Vec6d);
+    bytes += mask_.total() * mask_.elemSize();
+    bytes += cellMap_.total() * cellMap_.elemSize();
+    bytes += baryMap_.total() * baryMap_.elemSize();
+    memory_.set(bytes);
 }
 
 ///// Disk IO /////
-void PerPixelMap::WritePPM(const fs::path& path, const PerPixelMap& map)
+static void WriteCompactPPM(const fs::path& path, const PerPixelMap& map)
+{
+    CompactHeader header;
+    header.width = map.width();
+    header.height = map.height();
+    for (size_t y = 0; y < map.height(); ++y) {
+        for (size_t x = 0; x < map.width(); ++x) {
+            header.count += map.hasMapping(y, x) ? 1 : 0;
+        }
+    }
+    if (header.count >= NO_MAPPING) {
+        throw std::invalid_argument("Too many mappings for compact PPM format");
+    }
+
+    std::ofstream file(path.string(), std::ios::binary);
+    if (not file.is_open()) {
+        throw IOException("Failed to open file for writing: " + path.string());
+    }
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    // Record index
+    std::vector<uint32_t> row(map.width());
+    uint32_t next{0};
+    for (size_t y = 0; y < map.height(); ++y) {
+        for (size_t x = 0; x < map.width(); ++x) {
+            row[x] = map.hasMapping(y, x) ? next++ : NO_MAPPING;
+        }
+        file.write(
+            reinterpret_cast<const char*>(row.data()),
+            static_cast<std::streamsize>(row.size() * sizeof(uint32_t)));
+    }
+
+    // Records
+    std::array<float, RECORD_DIMS> record{};
+    for (size_t y = 0; y < map.height(); ++y) {
+        for (size_t x = 0; x < map.width(); ++x) {
+            if (not map.hasMapping(y, x)) {
+                continue;
+            }
+            auto m = map.getMapping(y, x);
+            for (size_t d = 0; d < RECORD_DIMS; ++d) {
+                record[d] = static_cast<float>(m[d]);
+            }
+            file.write(
+                reinterpret_cast<const char*>(record.data()), sizeof(record));
+        }
+    }
+
+    if (file.fail()) {
+        throw IOException("Failed to write file: " + path.string());
+    }
+}
+
+void PerPixelMap::WritePPM(
+    const fs::path& path, const PerPixelMap& map, Format format)
 {
-    volcart::PointSetIO<cv::Vec6d>::WriteOrderedPointSet(path, map.map_);
+    if (format == Format::Compact) {
+        WriteCompactPPM(path, map);
+    } else if (map.mapped_) {
+        auto copy = map;
+        copy.detach_();
+        PointSetIO<cv::Vec6d>::WriteOrderedPointSet(path, copy.map_);
+    } else {
+        PointSetIO<cv::Vec6d>::WriteOrderedPointSet(path, map.map_);
+    }
 
-    if (!map.mask_.empty()) {
-        cv::imwrite(MaskPath(path).string(), map.mask_);
+    auto mask = map.mask();
+    if (!mask.empty()) {
+        cv::imwrite(MaskPath(path).string(), mask);
     }
 
     if (!map.cellMap_.empty()) {
         tiffio::WriteTIFF(CellMapPath(path), map.cellMap_);
     }
+
+    if (!map.baryMap_.empty()) {
+        tiffio::WriteTIFF(BarycentricMapPath(path), map.baryMap_);
+    }
 }
 
 auto PerPixelMap::ReadPPM(const fs::path& path) -> PerPixelMap
 {
     PerPixelMap ppm;
-    ppm.map_ = volcart::PointSetIO<cv::Vec6d>::ReadOrderedPointSet(path);
-    ppm.height_ = ppm.map_.height();
-    ppm.width_ = ppm.map_.width();
+    if (MappedFile::IsCompact(path)) {
+        // The mask is implied by the record index
+        ppm.mapped_ = std::make_shared<MappedFile>(path);
+        ppm.detachState_.mapped = true;
+        ppm.height_ = ppm.mapped_->header.height;
+        ppm.width_ = ppm.mapped_->header.width;
+    } else {
+        ppm.map_ = volcart::PointSetIO<cv::Vec6d>::ReadOrderedPointSet(path);
+        ppm.height_ = ppm.map_.height();
+        ppm.width_ = ppm.map_.width();
 
-    ppm.mask_ = cv::imread(MaskPath(path).string(), cv::IMREAD_GRAYSCALE);
-    if (ppm.mask_.empty()) {
-        Logger()->warn("Failed to read mask: {}", MaskPath(path).string());
+        ppm.mask_ = cv::imread(MaskPath(path).string(), cv::IMREAD_GRAYSCALE);
+        if (ppm.mask_.empty()) {
+            Logger()->warn("Failed to read mask: {}", MaskPath(path).string());
+        }
     }
 
     ppm.cellMap_ = cv::imread(CellMapPath(path).string(), cv::IMREAD_UNCHANGED);
@@ -111,6 +635,13 @@ auto PerPixelMap::ReadPPM(const fs::path& path) -> PerPixelMap
             "Failed to read cell map: {}", CellMapPath(path).string());
     }
 
+    // Optional. Only written by newer versions of PPMGenerator.
+    auto baryPath = BarycentricMapPath(path);
+    if (fs::exists(baryPath)) {
+        ppm.baryMap_ = tiffio::ReadTIFF(baryPath);
+    }
+
+    ppm.update_memory_();
     return ppm;
 }
 
@@ -121,31 +652,46 @@ PerPixelMap::PerPixelMap(size_t height, size_t width)
 }
 auto PerPixelMap::initialized() const -> bool
 {
+    if (mapped_) {
+        return width_ > 0 && height_ > 0;
+    }
     return width_ == map_.width() && height_ == map_.height() && width_ > 0 &&
            height_ > 0;
 }
-auto PerPixelMap::operator()(size_t y, size_t x) const -> const cv::Vec6d&
+auto PerPixelMap::memoryMapped() const -> bool
 {
-    return map_(y, x);
+    return static_cast<bool>(mapped_);
+}
+auto PerPixelMap::operator()(size_t y, size_t x) const -> cv::Vec6d
+{
+    return getMapping(y, x);
 }
 auto PerPixelMap::operator()(size_t y, size_t x) -> cv::Vec6d&
 {
-    return map_(y, x);
+    return getMapping(y, x);
 }
 
-auto PerPixelMap::getMapping(std::size_t y, std::size_t x) const
-    -> const cv::Vec6d&
+auto PerPixelMap::getMapping(std::size_t y, std::size_t x) const -> cv::Vec6d
 {
+    if (mapped_) {
+        auto i = mapped_->recordIndex(y, x);
+        return i == NO_MAPPING ? cv::Vec6d{} : mapped_->record(i);
+    }
     return map_(y, x);
 }
 
 auto PerPixelMap::getMapping(std::size_t y, std::size_t x) -> cv::Vec6d&
 {
+    detach_();
     return map_(y, x);
 }
 
 auto PerPixelMap::hasMapping(size_t y, size_t x) const -> bool
 {
+    if (mapped_) {
+        return mapped_->recordIndex(y, x) != NO_MAPPING;
+    }
+
     if (mask_.empty()) {
         return true;
     }
@@ -154,7 +700,84 @@ auto PerPixelMap::hasMapping(size_t y, size_t x) const -> bool
 }
 auto PerPixelMap::width() const -> size_t { return width_; }
 auto PerPixelMap::height() const -> size_t { return height_; }
-auto PerPixelMap::mask() const -> cv::Mat { return mask_; }
-void PerPixelMap::setMask(const cv::Mat& m) { mask_ = m.clone(); }
+auto PerPixelMap::mask() const -> cv::Mat
+{
+    if (not mapped_) {
+        return mask_;
+    }
+
+    // Build the mask from the record index
+    cv::Mat mask = cv::Mat::zeros(height_, width_, CV_8UC1);
+    for (size_t y = 0; y < height_; ++y) {
+        for (size_t x = 0; x < width_; ++x) {
+            if (hasMapping(y, x)) {
+                mask.at<uint8_t>(y, x) = 255;
+            }
+        }
+    }
+    return mask;
+}
+void PerPixelMap::setMask(const cv::Mat& m)
+{
+    detach_();
+    mask_ = m.clone();
+    update_memory_();
+}
 auto PerPixelMap::cellMap() const -> cv::Mat { return cellMap_; }
-void PerPixelMap::setCellMap(const cv::Mat& m) { cellMap_ = m.clone(); }
+void PerPixelMap::setCellMap(const cv::Mat& m)
+{
+    cellMap_ = m.clone();
+    update_memory_();
+}
+auto PerPixelMap::barycentricMap() const -> cv::Mat { return baryMap_; }
+void PerPixelMap::setBarycentricMap(const cv::Mat& m)
+{
+    baryMap_ = m.clone();
+    update_memory_();
+}
+
+auto PerPixelMap::Subsample(const PerPixelMap& map, std::size_t factor)
+    -> PerPixelMap
+{
+    if (factor == 0) {
+        throw std::invalid_argument("Subsample factor must be positive");
+    }
+
+    const auto height = (map.height_ + factor - 1) / factor;
+    const auto width = (map.width_ + factor - 1) / factor;
+    PerPixelMap result(height, width);
+    cv::Mat mask = cv::Mat::zeros(
+        static_cast<int>(height), static_cast<int>(width), CV_8UC1);
+    ParallelFor(range(height), [&](auto y) {
+        for (size_t x = 0; x < width; ++x) {
+            if (map.hasMapping(y * factor, x * factor)) {
+                result.map_(y, x) = map.getMapping(y * factor, x * factor);
+                mask.at<uint8_t>(y, x) = 255;
+            }
+        }
+    });
+    result.setMask(mask);
+
+    // Subsample the per-pixel images
+    auto subsample = [&](const cv::Mat& src) {
+        cv::Mat dst(
+            static_cast<int>(height), static_cast<int>(width), src.type());
+        ParallelFor(range(height), [&](auto y) {
+            for (size_t x = 0; x < width; ++x) {
+                auto sy = static_cast<int>(y * factor);
+                auto sx = static_cast<int>(x * factor);
+                std::memcpy(
+                    dst.ptr(static_cast<int>(y), static_cast<int>(x)),
+                    src.ptr(sy, sx), src.elemSize());
+            }
+        });
+        return dst;
+    };
+    if (not map.cellMap_.empty()) {
+        result.setCellMap(subsample(map.cellMap_));
+    }
+    if (not map.baryMap_.empty()) {
+        result.setBarycentricMap(subsample(map.baryMap_));
+    }
+    return result;
+}
@@ -0,0 +1,56 @@
+#include "vc/core/util/ProgressCounter.hpp"
+
+#include <limits>
+
+using namespace volcart;
+
+ProgressCounter::ProgressCounter(std::size_t total, Clock::duration interval)
+    : interval_{interval}
+{
+    reset(total);
+}
+
+void ProgressCounter::reset(std::size_t total)
+{
+    count_ = 0;
+    total_ = total;
+    start_ = Clock::now();
+    nextReport_ = start_.time_since_epoch().count();
+}
+
+auto ProgressCounter::shouldReport() noexcept -> bool
+{
+    auto now = Clock::now().time_since_epoch().count();
+    auto next = nextReport_.load(std::memory_order_relaxed);
+    if (now < next) {
+        return false;
+    }
+
+    // Only one of the threads which see the deadline pass gets to report
+    return nextReport_.compare_exchange_strong(
+        next, now + interval_.count(), std::memory_order_relaxed);
+}
+
+auto ProgressCounter::elapsed() const -> double
+{
+    return std::chrono::duration<double>(Clock::now() - start_).count();
+}
+
+auto ProgressCounter::rate() const -> double
+{
+    auto secs = elapsed();
+    if (secs <= 0) {
+        return 0;
+    }
+    return static_cast<double>(count()) / secs;
+}
+
+auto ProgressCounter::remaining() const -> double
+{
+    auto r = rate();
+    if (r <= 0) {
+        return std::numeric_limits<double>::infinity();
+    }
+    auto left = total_ > count() ? total_ - count() : 0;
+    return static_cast<double>(left) / r;
+}
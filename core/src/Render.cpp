@@ -49,6 +49,20 @@ auto Render::New(fs::path path, std::string uuid, std::string name)
     return std::make_shared<Render>(path, uuid, name);
 }
 
+void Render::setProfile(const smgl::Metadata& profile)
+{
+    metadata_.set("profile", profile);
+    metadata_.save();
+}
+
+auto Render::profile() const -> smgl::Metadata
+{
+    if (metadata_.hasKey("profile")) {
+        return metadata_.get<smgl::Metadata>("profile");
+    }
+    return {};
+}
+
 auto Render::graph() const -> GraphPtr
 {
     // Lazy load the graph
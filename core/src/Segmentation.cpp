@@ -54,6 +54,28 @@ void Segmentation::setPointSet(const PointSet& ps)
     PointSetIO<cv::Vec3d>::WriteOrderedPointSet(filepath, ps);
 }
 
+// Append rows to the PointSet on disk
+auto Segmentation::appendPointSet(std::size_t width, std::size_t keepRows)
+    -> std::unique_ptr<PointSetWriter>
+{
+    using Writer = OrderedPointSetWriter<cv::Vec3d>;
+
+    // Set a name into the metadata if we haven't set one already
+    if (metadata_.get<std::string>("vcps").empty()) {
+        metadata_.set("vcps", "pointset.vcps");
+        metadata_.save();
+    }
+
+    auto filepath = path_ / metadata_.get<std::string>("vcps");
+    if (fs::exists(filepath)) {
+        auto writer = Writer::Append(filepath, keepRows);
+        if (writer.width() == width) {
+            return std::make_unique<PointSetWriter>(std::move(writer));
+        }
+    }
+    return std::make_unique<PointSetWriter>(Writer(filepath, width));
+}
+
 // Load the PointSet from disk
 Segmentation::PointSet Segmentation::getPointSet() const
 {
@@ -65,4 +87,16 @@ Segmentation::PointSet Segmentation::getPointSet() const
     // Load the pointset
     auto filepath = path_ / metadata_.get<std::string>("vcps");
     return PointSetIO<cv::Vec3d>::ReadOrderedPointSet(filepath);
-}
\ No newline at end of file
+}
+
+// Memory map the PointSet from disk
+Segmentation::PointSetView Segmentation::getPointSetView() const
+{
+    // Make sure there's an associated pointset file
+    if (metadata_.get<std::string>("vcps").empty()) {
+        throw std::runtime_error("segmentation has no pointset");
+    }
+
+    auto filepath = path_ / metadata_.get<std::string>("vcps");
+    return PointSetView(filepath, true);
+}
@@ -1,16 +1,14 @@
 #include "vc/core/math/StructureTensor.hpp"
 
-#include <opencv2/imgproc.hpp>
+#include <array>
+#include <cmath>
 
-using namespace volcart;
+#include "vc/core/math/Filter3D.hpp"
 
-/** @enum Axis labels */
-enum class Axis { X, Y };
+using namespace volcart;
 
-StructureTensor Tensorize(cv::Vec3d gradient);
-Tensor3D<cv::Vec3d> VolumeGradient(const Tensor3D<double>& v, int kernelSize);
-cv::Mat_<double> Gradient(const cv::Mat_<double>& input, Axis axis, int ksize);
-std::unique_ptr<double[]> MakeUniformGaussianField(int radius);
+StructureTensor WeightedTensorSum(
+    const Tensor3D<double>& v, int radius, int ksize);
 
 StructureTensor volcart::ComputeVoxelStructureTensor(
     const Volume::Pointer& volume,
@@ -33,24 +31,8 @@ StructureTensor volcart::ComputeVoxelStructureTensor(
         v.xySlice(z) /= std::numeric_limits<uint16_t>::max();
     }
 
-    // Get gradient of volume
-    auto gradientField = VolumeGradient(v, kernelSize);
-
-    // Modulate by gaussian distribution (element-wise) and sum
-    auto gaussianField = MakeUniformGaussianField(radius);
-    StructureTensor sum(0, 0, 0, 0, 0, 0, 0, 0, 0);
-    for (size_t z = 0; z < v.dz(); ++z) {
-        for (size_t y = 0; y < v.dy(); ++y) {
-            for (size_t x = 0; x < v.dx(); ++x) {
-                sum += gaussianField[z * v.dy() * v.dx() + y * v.dx() + x] *
-                       Tensorize(gradientField(x, y, z));
-            }
-        }
-    }
-
-    cv::Mat matSum(sum);
-    matSum /= v.dx() * v.dy() * v.dz();
-    return StructureTensor{matSum};
+    // Gaussian-weighted sum of the gradient tensors
+    return WeightedTensorSum(v, radius, kernelSize);
 }
 
 StructureTensor volcart::ComputeVoxelStructureTensor(
@@ -79,24 +61,8 @@ StructureTensor volcart::ComputeSubvoxelStructureTensor(
     auto v = ComputeSubvoxelNeighbors<double>(
         volume, {vx, vy, vz}, radius, radius, radius);
 
-    // Get gradient of volume
-    auto gradientField = VolumeGradient(v, kernelSize);
-
-    // Modulate by gaussian distribution (element-wise) and sum
-    auto gaussianField = MakeUniformGaussianField(radius);
-    StructureTensor sum(0, 0, 0, 0, 0, 0, 0, 0, 0);
-    for (size_t z = 0; z < v.dz(); ++z) {
-        for (size_t y = 0; y < v.dy(); ++y) {
-            for (size_t x = 0; x < v.dx(); ++x) {
-                sum += gaussianField[z * v.dy() * v.dx() + y * v.dx() + x] *
-                       Tensorize(gradientField(x, y, z));
-            }
-        }
-    }
-
-    cv::Mat matSum(sum);
-    matSum /= v.dx() * v.dy() * v.dz();
-    return StructureTensor{matSum};
+    // Gaussian-weighted sum of the gradient tensors
+    return WeightedTensorSum(v, radius, kernelSize);
 }
 
 StructureTensor volcart::ComputeSubvoxelStructureTensor(
@@ -109,15 +75,8 @@ StructureTensor volcart::ComputeSubvoxelStructureTensor(
         volume, index(0), index(1), index(2), radius, kernelSize);
 }
 
-EigenPairs volcart::ComputeVoxelEigenPairs(
-    const Volume::Pointer& volume,
-    int x,
-    int y,
-    int z,
-    int radius,
-    int kernelSize)
+EigenPairs volcart::ComputeEigenPairs(const StructureTensor& st)
 {
-    auto st = ComputeVoxelStructureTensor(volume, x, y, z, radius, kernelSize);
     cv::Vec3d eigenValues;
     cv::Matx33d eigenVectors;
     cv::eigen(st, eigenValues, eigenVectors);
@@ -134,6 +93,18 @@ EigenPairs volcart::ComputeVoxelEigenPairs(
     };
 }
 
+EigenPairs volcart::ComputeVoxelEigenPairs(
+    const Volume::Pointer& volume,
+    int x,
+    int y,
+    int z,
+    int radius,
+    int kernelSize)
+{
+    auto st = ComputeVoxelStructureTensor(volume, x, y, z, radius, kernelSize);
+    return ComputeEigenPairs(st);
+}
+
 EigenPairs volcart::ComputeVoxelEigenPairs(
     const Volume::Pointer& volume,
     const cv::Vec3i& index,
@@ -154,20 +125,7 @@ EigenPairs volcart::ComputeSubvoxelEigenPairs(
 {
     auto st =
         ComputeSubvoxelStructureTensor(volume, x, y, z, radius, kernelSize);
-    cv::Vec3d eigenValues;
-    cv::Matx33d eigenVectors;
-    cv::eigen(st, eigenValues, eigenVectors);
-    auto row0 = eigenVectors.row(0);
-    auto row1 = eigenVectors.row(1);
-    auto row2 = eigenVectors.row(2);
-    EigenVector e0{row0(0), row0(1), row0(2)};
-    EigenVector e1{row1(0), row1(1), row1(2)};
-    EigenVector e2{row2(0), row2(1), row2(2)};
-    return {
-        std::make_pair(eigenValues(0), e0),
-        std::make_pair(eigenValues(1), e1),
-        std::make_pair(eigenValues(2), e2),
-    };
+    return ComputeEigenPairs(st);
 }
 
 EigenPairs volcart::ComputeSubvoxelEigenPairs(
@@ -180,120 +138,44 @@ EigenPairs volcart::ComputeSubvoxelEigenPairs(
         volume, index(0), index(1), index(2), radius, kernelSize);
 }
 
-StructureTensor Tensorize(cv::Vec3d gradient)
-{
-    double ix = gradient(0);
-    double iy = gradient(1);
-    double iz = gradient(2);
-    // clang-format off
-    return StructureTensor{ix * ix, ix * iy, ix * iz,
-                           ix * iy, iy * iy, iy * iz,
-                           ix * iz, iy * iz, iz * iz};
-    // clang-format on
-}
-
-Tensor3D<cv::Vec3d> VolumeGradient(const Tensor3D<double>& v, int kernelSize)
+// Compute the gradient of the subvolume, modulate the gradient tensors by a
+// uniform gaussian distribution, and average
+StructureTensor WeightedTensorSum(
+    const Tensor3D<double>& v, int radius, int ksize)
 {
-    // Limitation of OpenCV: Kernel size must be 1, 3, 5, or 7
-    assert(
-        (kernelSize == 1 || kernelSize == 3 || kernelSize == 5 ||
-         kernelSize == 7) &&
-        "kernelSize must be one of [1, 3, 5, 7]");
+    const auto grad = Gradient3D(v, ksize);
 
-    // Calculate gradient field around specified voxel
-    Tensor3D<cv::Vec3d> gradientField{v.dx(), v.dy(), v.dz()};
+    // The 3D weight field is separable: w(x, y, z) = n * w(x) * w(y) * w(z)
+    // with w() normalized to sum to 1 and n = 1 / (2pi)^(3/2)
+    const auto w = GaussianKernel1D(radius, 1.0 / std::sqrt(2.0));
+    const auto n = 1.0 / std::pow(2 * M_PI, 3.0 / 2.0);
 
-    // First do XY gradients
+    std::array<double, 6> sum{};
     for (size_t z = 0; z < v.dz(); ++z) {
-        auto xGradient = Gradient(v.xySlice(z), Axis::X, kernelSize);
-        auto yGradient = Gradient(v.xySlice(z), Axis::Y, kernelSize);
         for (size_t y = 0; y < v.dy(); ++y) {
+            const auto* ix = grad[0].xySlice(z)[static_cast<int>(y)];
+            const auto* iy = grad[1].xySlice(z)[static_cast<int>(y)];
+            const auto* iz = grad[2].xySlice(z)[static_cast<int>(y)];
+            const auto wzy = w[z] * w[y];
             for (size_t x = 0; x < v.dx(); ++x) {
-                gradientField(x, y, z) = {xGradient(y, x), yGradient(y, x), 0};
+                const auto wt = wzy * w[x];
+                sum[0] += wt * ix[x] * ix[x];
+                sum[1] += wt * ix[x] * iy[x];
+                sum[2] += wt * ix[x] * iz[x];
+                sum[3] += wt * iy[x] * iy[x];
+                sum[4] += wt * iy[x] * iz[x];
+                sum[5] += wt * iz[x] * iz[x];
             }
         }
     }
 
-    // Then Z gradients
-    for (size_t layer = 0; layer < v.dy(); ++layer) {
-        auto zGradient = Gradient(v.xzSlice(layer), Axis::Y, kernelSize);
-        for (size_t z = 0; z < v.dz(); ++z) {
-            for (size_t x = 0; x < v.dx(); ++x) {
-                gradientField(x, layer, z)(2) = zGradient(z, x);
-            }
-        }
+    const auto scale = n / static_cast<double>(v.dx() * v.dy() * v.dz());
+    for (auto& s : sum) {
+        s *= scale;
     }
-
-    return gradientField;
-}
-
-// Helper function to calculate gradient using best choice for given kernel
-// size. If the kernel size is 3, uses the Scharr() operator to calculate the
-// gradient which is more accurate than 3x3 Sobel operator
-cv::Mat_<double> Gradient(const cv::Mat_<double>& input, Axis axis, int ksize)
-{
-    // OpenCV params for gradients
-    // XXX Revisit this and see if changing these makes a big difference
-    constexpr double SCALE = 1;
-    constexpr double DELTA = 0;
-
-    cv::Mat_<double> grad(input.rows, input.cols);
-
-    switch (axis) {
-        case Axis::X:
-            if (ksize == 3) {
-                cv::Scharr(
-                    input, grad, CV_64F, 1, 0, SCALE, DELTA,
-                    cv::BORDER_REPLICATE);
-            } else {
-                cv::Sobel(
-                    input, grad, CV_64F, 1, 0, ksize, SCALE, DELTA,
-                    cv::BORDER_REPLICATE);
-            }
-            break;
-        case Axis::Y:
-            if (ksize == 3) {
-                cv::Scharr(
-                    input, grad, CV_64F, 0, 1, SCALE, DELTA,
-                    cv::BORDER_REPLICATE);
-            } else {
-                cv::Sobel(
-                    input, grad, CV_64F, 0, 1, ksize, SCALE, DELTA,
-                    cv::BORDER_REPLICATE);
-            }
-            break;
-    }
-    return grad;
+    // clang-format off
+    return StructureTensor{sum[0], sum[1], sum[2],
+                           sum[1], sum[3], sum[4],
+                           sum[2], sum[4], sum[5]};
+    // clang-format on
 }
-
-std::unique_ptr<double[]> MakeUniformGaussianField(int radius)
-{
-    auto sideLength = 2 * static_cast<size_t>(radius) + 1;
-    auto fieldSize = sideLength * sideLength * sideLength;
-    auto field = std::unique_ptr<double[]>(new double[fieldSize]);
-    double sum = 0;
-    double sigma = 1;
-    double sigma3 = sigma * sigma * sigma;
-    double n = 1 / (sigma3 * std::pow(2 * M_PI, 3.0 / 2.0));
-
-    // Fill field
-    for (int z = -radius; z <= radius; ++z) {
-        for (int y = -radius; y <= radius; ++y) {
-            for (int x = -radius; x <= radius; ++x) {
-                double val = std::exp(-(x * x + y * y + z * z));
-                auto index = static_cast<size_t>(
-                    (z + radius) * sideLength * sideLength +
-                    (y + radius) * sideLength + (x + radius));
-                field[index] = n * val;
-                sum += val;
-            }
-        }
-    }
-
-    // Normalize
-    for (size_t i = 0; i < sideLength * sideLength * sideLength; ++i) {
-        field[i] /= sum;
-    }
-
-    return field;
-}
\ No newline at end of file
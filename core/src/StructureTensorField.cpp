@@ -0,0 +1,244 @@
+#include "vc/core/math/StructureTensorField.hpp"
+
+#include <array>
+#include <cmath>
+#include <stdexcept>
+
+#include "vc/core/math/Filter3D.hpp"
+#include "vc/core/util/ThreadPool.hpp"
+
+using namespace volcart;
+
+namespace
+{
+// Floor division, correct for negative values
+auto FloorDiv(int v, int d) -> int { return (v < 0) ? (v - d + 1) / d : v / d; }
+
+// Pack a block position into a cache key
+auto BlockKey(const cv::Vec3i& pos) -> std::uint64_t
+{
+    constexpr std::uint64_t MASK{0x1FFFFF};
+    auto x = static_cast<std::uint64_t>(pos[0]) & MASK;
+    auto y = static_cast<std::uint64_t>(pos[1]) & MASK;
+    auto z = static_cast<std::uint64_t>(pos[2]) & MASK;
+    return (z << 42) | (y << 21) | x;
+}
+
+// Convert the unique tensor components to a full tensor
+auto ToTensor(const cv::Vec6d& t) -> StructureTensor
+{
+    // clang-format off
+    return StructureTensor{t[0], t[1], t[2],
+                           t[1], t[3], t[4],
+                           t[2], t[4], t[5]};
+    // clang-format on
+}
+}  // namespace
+
+StructureTensorField::StructureTensorField(
+    Volume::Pointer volume,
+    int radius,
+    int kernelSize,
+    int blockSize,
+    std::size_t cacheBlocks)
+    : volume_{std::move(volume)}
+    , radius_{radius}
+    , kernelSize_{kernelSize}
+    , blockSize_{blockSize}
+    , cache_{
+          std::max<std::size_t>(cacheBlocks, 1),
+          std::min<std::size_t>(
+              std::max<std::size_t>(cacheBlocks, 1),
+              ShardedCache<std::uint64_t, BlockPointer>::DEFAULT_SHARDS)}
+{
+    if (not volume_) {
+        throw std::invalid_argument("structure tensor field requires volume");
+    }
+    if (radius_ < 0) {
+        throw std::invalid_argument("radius must be non-negative");
+    }
+    if (kernelSize_ != 3 and kernelSize_ != 5 and kernelSize_ != 7) {
+        throw std::invalid_argument("gradient kernel size must be 3, 5, or 7");
+    }
+    if (blockSize_ < 2) {
+        throw std::invalid_argument("block size must be at least 2");
+    }
+}
+
+auto StructureTensorField::volume() const -> Volume::Pointer { return volume_; }
+
+auto StructureTensorField::radius() const -> int { return radius_; }
+
+auto StructureTensorField::kernelSize() const -> int { return kernelSize_; }
+
+auto StructureTensorField::blockSize() const -> int { return blockSize_; }
+
+auto StructureTensorField::tensorAt(int x, int y, int z) const
+    -> StructureTensor
+{
+    const auto n = blockSize_;
+    const cv::Vec3i pos{FloorDiv(x, n), FloorDiv(y, n), FloorDiv(z, n)};
+    const auto block = block_(pos);
+    const auto lx = static_cast<std::size_t>(x - pos[0] * n);
+    const auto ly = static_cast<std::size_t>(y - pos[1] * n);
+    const auto lz = static_cast<std::size_t>(z - pos[2] * n);
+    const auto bs = static_cast<std::size_t>(n);
+    return ToTensor((*block)[(lz * bs + ly) * bs + lx]);
+}
+
+auto StructureTensorField::tensorAt(const cv::Vec3i& v) const
+    -> StructureTensor
+{
+    return tensorAt(v[0], v[1], v[2]);
+}
+
+auto StructureTensorField::interpolateAt(const cv::Vec3d& v) const
+    -> StructureTensor
+{
+    BlockHint hint;
+    return interpolate_(v, hint);
+}
+
+auto StructureTensorField::eigenPairsAt(const cv::Vec3d& v) const
+    -> EigenPairs
+{
+    return ComputeEigenPairs(interpolateAt(v));
+}
+
+auto StructureTensorField::eigenPairsAt(
+    const std::vector<cv::Vec3d>& vs, std::size_t numThreads) const
+    -> std::vector<EigenPairs>
+{
+    std::vector<EigenPairs> result(vs.size());
+    ParallelChunks(vs.size(), numThreads, [&](auto begin, auto end) {
+        BlockHint hint;
+        for (auto i = begin; i < end; ++i) {
+            result[i] = ComputeEigenPairs(interpolate_(vs[i], hint));
+        }
+    });
+    return result;
+}
+
+auto StructureTensorField::interpolate_(
+    const cv::Vec3d& v, BlockHint& hint) const -> StructureTensor
+{
+    const auto x0 = static_cast<int>(std::floor(v[0]));
+    const auto y0 = static_cast<int>(std::floor(v[1]));
+    const auto z0 = static_cast<int>(std::floor(v[2]));
+    const std::array<double, 3> t{v[0] - x0, v[1] - y0, v[2] - z0};
+
+    // Fast path: all 8 corners are in the same block
+    const auto n = blockSize_;
+    const cv::Vec3i pos{FloorDiv(x0, n), FloorDiv(y0, n), FloorDiv(z0, n)};
+    const auto lx = x0 - pos[0] * n;
+    const auto ly = y0 - pos[1] * n;
+    const auto lz = z0 - pos[2] * n;
+    const auto sameBlock = lx < n - 1 and ly < n - 1 and lz < n - 1;
+    if (sameBlock and (not hint.block or hint.pos != pos)) {
+        hint.pos = pos;
+        hint.block = block_(pos);
+    }
+    const auto& block = hint.block;
+
+    cv::Vec6d sum;
+    for (int c = 0; c < 8; ++c) {
+        const auto dx = c & 1;
+        const auto dy = (c >> 1) & 1;
+        const auto dz = (c >> 2) & 1;
+        const auto w = (dx ? t[0] : 1 - t[0]) * (dy ? t[1] : 1 - t[1]) *
+                       (dz ? t[2] : 1 - t[2]);
+        if (w == 0) {
+            continue;
+        }
+
+        if (sameBlock) {
+            const auto bs = static_cast<std::size_t>(n);
+            const auto idx = (static_cast<std::size_t>(lz + dz) * bs +
+                              static_cast<std::size_t>(ly + dy)) *
+                                 bs +
+                             static_cast<std::size_t>(lx + dx);
+            sum += w * cv::Vec6d((*block)[idx]);
+        } else {
+            const auto st = tensorAt(x0 + dx, y0 + dy, z0 + dz);
+            sum += w * cv::Vec6d{st(0, 0), st(0, 1), st(0, 2),
+                                 st(1, 1), st(1, 2), st(2, 2)};
+        }
+    }
+    return ToTensor(sum);
+}
+
+auto StructureTensorField::cacheSize() const -> std::size_t
+{
+    return cache_.size();
+}
+
+void StructureTensorField::purge() { cache_.purge(); }
+
+auto StructureTensorField::block_(const cv::Vec3i& pos) const -> BlockPointer
+{
+    return cache_.getOrLoad(
+        BlockKey(pos), [this, &pos]() { return compute_block_(pos); });
+}
+
+auto StructureTensorField::compute_block_(const cv::Vec3i& pos) const
+    -> BlockPointer
+{
+    // The block is padded by the Gaussian window and the gradient kernel, so
+    // that every tensor uses exact gradients
+    const auto n = static_cast<std::size_t>(blockSize_);
+    const auto r = static_cast<std::size_t>(radius_);
+    const auto kr = static_cast<std::size_t>(kernelSize_ / 2);
+    const auto pad = r + kr;
+    const auto dim = n + 2 * pad;
+
+    // Load the padded subvolume. Voxels outside the volume are 0.
+    const cv::Vec3i origin = pos * blockSize_ - cv::Vec3i::all(int(pad));
+    std::vector<uint16_t> raw(dim * dim * dim);
+    volume_->copyLattice(
+        origin, {cv::Vec3i{0, 0, 1}, cv::Vec3i{0, 1, 0}, cv::Vec3i{1, 0, 0}},
+        {dim, dim, dim}, raw.data());
+    Tensor3D<double> v(dim, dim, dim, false);
+    for (std::size_t z = 0; z < dim; ++z) {
+        cv::Mat(int(dim), int(dim), CV_16UC1, raw.data() + z * dim * dim)
+            .convertTo(v.xySlice(z), CV_64F);
+    }
+    raw.clear();
+
+    // Gradient tensors
+    const auto grad = Gradient3D(v, kernelSize_);
+    const std::array<std::array<std::size_t, 2>, 6> products{
+        {{0, 0}, {0, 1}, {0, 2}, {1, 1}, {1, 2}, {2, 2}}};
+
+    // Gaussian window. Scale to match ComputeSubvoxelStructureTensor(),
+    // which uses a field normalized to 1 / (2pi)^(3/2) and divides by the
+    // window volume.
+    const auto w = GaussianKernel1D(radius_, 1.0 / std::sqrt(2.0));
+    const auto win = 2 * r + 1;
+    const auto scale =
+        1.0 / (std::pow(2 * M_PI, 1.5) * static_cast<double>(win * win * win));
+
+    auto block = std::make_shared<Block>(n * n * n);
+    for (std::size_t c = 0; c < products.size(); ++c) {
+        const auto& a = grad[products[c][0]];
+        const auto& b = grad[products[c][1]];
+        Tensor3D<double> t(dim, dim, dim, false);
+        for (std::size_t z = 0; z < dim; ++z) {
+            cv::multiply(a.xySlice(z), b.xySlice(z), t.xySlice(z));
+        }
+        t = SepFilter3D(t, w, w, w);
+
+        // Keep the unpadded interior
+        for (std::size_t z = 0; z < n; ++z) {
+            const auto& slice = t.xySlice(z + pad);
+            for (std::size_t y = 0; y < n; ++y) {
+                const auto* row = slice[static_cast<int>(y + pad)] + pad;
+                for (std::size_t x = 0; x < n; ++x) {
+                    (*block)[(z * n + y) * n + x][static_cast<int>(c)] =
+                        static_cast<float>(row[x] * scale);
+                }
+            }
+        }
+    }
+
+    return block;
+}
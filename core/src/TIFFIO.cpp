@@ -1,11 +1,23 @@
 #include "vc/core/io/TIFFIO.hpp"
 
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdio>
 #include <cstring>
+#include <exception>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <vector>
 
+#include <opencv2/imgcodecs.hpp>
 #include <opencv2/imgproc.hpp>
 
 #include "vc/core/Version.hpp"
 #include "vc/core/io/FileExtensionFilter.hpp"
+#include "vc/core/util/String.hpp"
+#include "vc/core/util/ThreadPool.hpp"
 
 // Wrapping in a namespace to avoid define collisions
 namespace lt
@@ -16,94 +28,299 @@ namespace lt
 namespace tio = volcart::tiffio;
 namespace fs = volcart::filesystem;
 
-// Write a TIFF to a file. This implementation heavily borrows from how OpenCV's
-// TIFFEncoder writes to the TIFF
-void tio::WriteTIFF(
-    const fs::path& path, const cv::Mat& img, Compression compression)
+namespace
 {
-    // Safety checks
-    if (img.channels() < 1 or img.channels() > 4) {
-        throw std::runtime_error("Unsupported number of channels");
+// Approximate uncompressed size of the strips written by WriteTIFF
+constexpr std::size_t TARGET_STRIP_BYTES = 256 * 1024;
+
+// Images with more uncompressed data than this are written as BigTIFF.
+// Classic TIFF offsets are 32-bit, and compressed data can be larger than the
+// uncompressed data, so this leaves plenty of headroom.
+constexpr std::uint64_t BIGTIFF_THRESHOLD_BYTES{std::uint64_t{2} << 30};
+
+// Closes a TIFF handle
+struct TIFFCloser {
+    void operator()(lt::TIFF* t) const { lt::TIFFClose(t); }
+};
+using TIFFHandle = std::unique_ptr<lt::TIFF, TIFFCloser>;
+
+auto OpenTIFF(const fs::path& path) -> TIFFHandle
+{
+    TIFFHandle t{lt::TIFFOpen(path.c_str(), "r")};
+    if (not t) {
+        throw std::runtime_error(
+            "Failed to open file for reading: " + path.string());
+    }
+    return t;
+}
+
+// Pixel layout of an image which can be decoded strip by strip or tile by
+// tile
+struct Layout {
+    int width{0};
+    int height{0};
+    int cvType{0};
+    std::size_t pixelBytes{0};
+    bool rgb{false};
+    bool tiled{false};
+    // Strip or tile height
+    std::uint32_t unitHeight{0};
+    // Tile width
+    std::uint32_t unitWidth{0};
+};
+
+// Get the pixel layout. Returns false if the image is not supported.
+auto GetLayout(lt::TIFF* t, Layout& l) -> bool
+{
+    std::uint32_t width{0};
+    std::uint32_t height{0};
+    std::uint16_t bitsPerSample{0};
+    std::uint16_t channels{0};
+    std::uint16_t sampleFormat{0};
+    std::uint16_t planar{0};
+    std::uint16_t photometric{0};
+    std::uint16_t orientation{0};
+    lt::TIFFGetField(t, TIFFTAG_IMAGEWIDTH, &width);
+    lt::TIFFGetField(t, TIFFTAG_IMAGELENGTH, &height);
+    lt::TIFFGetFieldDefaulted(t, TIFFTAG_BITSPERSAMPLE, &bitsPerSample);
+    lt::TIFFGetFieldDefaulted(t, TIFFTAG_SAMPLESPERPIXEL, &channels);
+    lt::TIFFGetFieldDefaulted(t, TIFFTAG_SAMPLEFORMAT, &sampleFormat);
+    lt::TIFFGetFieldDefaulted(t, TIFFTAG_PLANARCONFIG, &planar);
+    lt::TIFFGetFieldDefaulted(t, TIFFTAG_ORIENTATION, &orientation);
+    if (lt::TIFFGetField(t, TIFFTAG_PHOTOMETRIC, &photometric) != 1) {
+        return false;
+    }
+
+    if (width == 0 or height == 0 or planar != PLANARCONFIG_CONTIG or
+        orientation != ORIENTATION_TOPLEFT or channels < 1 or channels > 4) {
+        return false;
+    }
+    if (photometric == PHOTOMETRIC_RGB) {
+        l.rgb = channels >= 3;
+    } else if (photometric != PHOTOMETRIC_MINISBLACK) {
+        return false;
+    }
+
+    int depth{-1};
+    switch (sampleFormat) {
+        case SAMPLEFORMAT_UINT:
+            depth = (bitsPerSample == 8)    ? CV_8U
+                    : (bitsPerSample == 16) ? CV_16U
+                                            : -1;
+            break;
+        case SAMPLEFORMAT_INT:
+            depth = (bitsPerSample == 8)    ? CV_8S
+                    : (bitsPerSample == 16) ? CV_16S
+                    : (bitsPerSample == 32) ? CV_32S
+                                            : -1;
+            break;
+        case SAMPLEFORMAT_IEEEFP:
+            depth = (bitsPerSample == 32)   ? CV_32F
+                    : (bitsPerSample == 64) ? CV_64F
+                                            : -1;
+            break;
+        default:
+            break;
+    }
+    if (depth < 0) {
+        return false;
+    }
+
+    l.width = static_cast<int>(width);
+    l.height = static_cast<int>(height);
+    l.cvType = CV_MAKETYPE(depth, channels);
+    l.pixelBytes = std::size_t{channels} * bitsPerSample / 8;
+    l.tiled = lt::TIFFIsTiled(t) != 0;
+    if (l.tiled) {
+        lt::TIFFGetField(t, TIFFTAG_TILEWIDTH, &l.unitWidth);
+        lt::TIFFGetField(t, TIFFTAG_TILELENGTH, &l.unitHeight);
+        if (l.unitWidth == 0 or l.unitHeight == 0) {
+            return false;
+        }
+    } else {
+        lt::TIFFGetFieldDefaulted(t, TIFFTAG_ROWSPERSTRIP, &l.unitHeight);
+        l.unitHeight = std::clamp<std::uint32_t>(l.unitHeight, 1, height);
+        l.unitWidth = width;
+    }
+    return true;
+}
+
+// Decode the strips or rows of tiles [first, last) into the ROI image
+void DecodeUnits(
+    lt::TIFF* t,
+    const Layout& l,
+    const cv::Rect& roi,
+    int first,
+    int last,
+    cv::Mat& out)
+{
+    auto unitBytes = static_cast<std::size_t>(
+        l.tiled ? lt::TIFFTileSize(t) : lt::TIFFStripSize(t));
+    std::vector<char> buffer(unitBytes);
+    auto bufferSize = static_cast<lt::tmsize_t>(unitBytes);
+    auto unitRowBytes = l.unitWidth * l.pixelBytes;
+    auto unitHeight = static_cast<int>(l.unitHeight);
+    auto unitWidth = static_cast<int>(l.unitWidth);
+
+    for (auto u = first; u < last; u++) {
+        auto y0 = u * unitHeight;
+        auto ry0 = std::max(y0, roi.y);
+        auto ry1 = std::min(y0 + unitHeight, roi.y + roi.height);
+
+        // Strips span the whole image width. Tiles only span part of it.
+        auto tx0 = l.tiled ? roi.x / unitWidth : 0;
+        auto tx1 = l.tiled ? (roi.x + roi.width - 1) / unitWidth : 0;
+        for (auto tx = tx0; tx <= tx1; tx++) {
+            auto x0 = tx * unitWidth;
+            lt::tmsize_t result{0};
+            if (l.tiled) {
+                auto tile = lt::TIFFComputeTile(
+                    t, static_cast<std::uint32_t>(x0),
+                    static_cast<std::uint32_t>(y0), 0, 0);
+                result = lt::TIFFReadEncodedTile(
+                    t, tile, buffer.data(), bufferSize);
+            } else {
+                auto strip = static_cast<std::uint32_t>(u);
+                result = lt::TIFFReadEncodedStrip(
+                    t, strip, buffer.data(), bufferSize);
+            }
+            if (result < 0) {
+                auto msg = "Failed to decode rows starting at " +
+                           std::to_string(y0);
+                throw std::runtime_error(msg);
+            }
+
+            auto rx0 = std::max(x0, roi.x);
+            auto rx1 = std::min(x0 + unitWidth, roi.x + roi.width);
+            auto rowBytes = static_cast<std::size_t>(rx1 - rx0) * l.pixelBytes;
+            auto colOffset = static_cast<std::size_t>(rx0 - x0) * l.pixelBytes;
+            for (auto y = ry0; y < ry1; y++) {
+                auto rowOffset =
+                    static_cast<std::size_t>(y - y0) * unitRowBytes;
+                std::memcpy(
+                    out.ptr(y - roi.y) +
+                        static_cast<std::size_t>(rx0 - roi.x) * l.pixelBytes,
+                    buffer.data() + rowOffset + colOffset, rowBytes);
+            }
+        }
     }
+}
 
-    if (not io::FileExtensionFilter(path, {"tif", "tiff"})) {
+// TIFF tile dimensions must be a multiple of this
+constexpr int TILE_MULTIPLE{16};
+
+// Check that a path has a TIFF extension
+void CheckOutputPath(const fs::path& path)
+{
+    if (not volcart::io::FileExtensionFilter(path, {"tif", "tiff"})) {
         throw std::runtime_error(
             "Invalid file extension " + path.extension().string());
     }
+}
 
-    // Image metadata
-    auto channels = img.channels();
-    auto width = static_cast<unsigned>(img.cols);
-    auto height = static_cast<unsigned>(img.rows);
-    auto rowsPerStrip = height;
+// Sample encoding for an OpenCV type
+struct Encoding {
+    int bitsPerSample{0};
+    int sampleFormat{0};
+    int photometric{0};
+};
+
+auto GetEncoding(int cvType) -> Encoding
+{
+    auto channels = CV_MAT_CN(cvType);
+    if (channels < 1 or channels > 4) {
+        throw std::runtime_error("Unsupported number of channels");
+    }
 
     // Sample format
-    int bitsPerSample;
-    int sampleFormat;
-    switch (img.depth()) {
+    Encoding e;
+    switch (CV_MAT_DEPTH(cvType)) {
         case CV_8U:
-            sampleFormat = SAMPLEFORMAT_UINT;
-            bitsPerSample = 8;
+            e.sampleFormat = SAMPLEFORMAT_UINT;
+            e.bitsPerSample = 8;
             break;
         case CV_8S:
-            sampleFormat = SAMPLEFORMAT_INT;
-            bitsPerSample = 8;
+            e.sampleFormat = SAMPLEFORMAT_INT;
+            e.bitsPerSample = 8;
             break;
         case CV_16U:
-            sampleFormat = SAMPLEFORMAT_UINT;
-            bitsPerSample = 16;
+            e.sampleFormat = SAMPLEFORMAT_UINT;
+            e.bitsPerSample = 16;
             break;
         case CV_16S:
-            sampleFormat = SAMPLEFORMAT_INT;
-            bitsPerSample = 16;
+            e.sampleFormat = SAMPLEFORMAT_INT;
+            e.bitsPerSample = 16;
             break;
         case CV_32S:
-            sampleFormat = SAMPLEFORMAT_INT;
-            bitsPerSample = 32;
+            e.sampleFormat = SAMPLEFORMAT_INT;
+            e.bitsPerSample = 32;
             break;
         case CV_32F:
-            sampleFormat = SAMPLEFORMAT_IEEEFP;
-            bitsPerSample = 32;
+            e.sampleFormat = SAMPLEFORMAT_IEEEFP;
+            e.bitsPerSample = 32;
             break;
         case CV_64F:
-            sampleFormat = SAMPLEFORMAT_IEEEFP;
-            bitsPerSample = 64;
+            e.sampleFormat = SAMPLEFORMAT_IEEEFP;
+            e.bitsPerSample = 64;
             break;
         default:
             throw std::runtime_error("Unsupported image depth");
     }
 
     // Photometric Interpretation
-    int photometric;
-    switch (channels) {
-        case 1:
-        case 2:
-            photometric = PHOTOMETRIC_MINISBLACK;
-            break;
-        case 3:
-        case 4:
-            photometric = PHOTOMETRIC_RGB;
-            break;
-        default:
-            throw std::runtime_error("Unsupported number of channels");
+    e.photometric = (channels < 3) ? PHOTOMETRIC_MINISBLACK : PHOTOMETRIC_RGB;
+    return e;
+}
+
+// Throw if libtiff cannot encode with a compression scheme
+void CheckCompression(tio::Compression c)
+{
+    if (not tio::CompressionAvailable(c)) {
+        throw std::runtime_error(
+            "TIFF compression is not supported by libtiff: " +
+            tio::CompressionToString(c));
     }
+}
 
-    // Open the file
-    auto out = lt::TIFFOpen(path.c_str(), "w");
-    if (out == nullptr) {
-        throw std::runtime_error("Failed to open file for writing");
+// Whether to store an image with the horizontal differencing predictor.
+// Differencing turns the slowly varying samples of CT images into small
+// values which the general-purpose codecs compress much better.
+auto UsesPredictor(tio::Compression c, const Encoding& e) -> bool
+{
+    if (e.sampleFormat == SAMPLEFORMAT_IEEEFP) {
+        return false;
+    }
+    switch (c) {
+        case tio::Compression::ADOBE_DEFLATE:
+        case tio::Compression::DEFLATE:
+        case tio::Compression::LZMA:
+        case tio::Compression::ZSTD:
+            return true;
+        default:
+            return false;
     }
+}
 
-    // Encoding parameters
+// Set the fields shared by strip and tiled images
+void SetImageFields(
+    lt::TIFF* out,
+    unsigned width,
+    unsigned height,
+    int channels,
+    const Encoding& e,
+    tio::Compression compression)
+{
     lt::TIFFSetField(out, TIFFTAG_IMAGEWIDTH, width);
     lt::TIFFSetField(out, TIFFTAG_IMAGELENGTH, height);
-    lt::TIFFSetField(out, TIFFTAG_PHOTOMETRIC, photometric);
+    lt::TIFFSetField(out, TIFFTAG_PHOTOMETRIC, e.photometric);
     lt::TIFFSetField(out, TIFFTAG_PLANARCONFIG, PLANARCONFIG_CONTIG);
     lt::TIFFSetField(out, TIFFTAG_COMPRESSION, compression);
-    lt::TIFFSetField(out, TIFFTAG_SAMPLEFORMAT, sampleFormat);
-    lt::TIFFSetField(out, TIFFTAG_BITSPERSAMPLE, bitsPerSample);
+    if (UsesPredictor(compression, e)) {
+        lt::TIFFSetField(out, TIFFTAG_PREDICTOR, PREDICTOR_HORIZONTAL);
+    }
+    lt::TIFFSetField(out, TIFFTAG_SAMPLEFORMAT, e.sampleFormat);
+    lt::TIFFSetField(out, TIFFTAG_BITSPERSAMPLE, e.bitsPerSample);
     lt::TIFFSetField(out, TIFFTAG_SAMPLESPERPIXEL, channels);
-    lt::TIFFSetField(out, TIFFTAG_ROWSPERSTRIP, rowsPerStrip);
 
     // Add alpha tag data
     // TODO: Let user decide associated/unassociated tag
@@ -115,7 +332,413 @@ void tio::WriteTIFF(
 
     // Metadata
     lt::TIFFSetField(
-        out, TIFFTAG_SOFTWARE, ProjectInfo::NameAndVersion().c_str());
+        out, TIFFTAG_SOFTWARE, volcart::ProjectInfo::NameAndVersion().c_str());
+}
+
+// Convert BGR(A) images to the RGB(A) order stored in TIFFs
+auto ToTIFFChannelOrder(const cv::Mat& img) -> cv::Mat
+{
+    cv::Mat out;
+    if (img.channels() == 3) {
+        cv::cvtColor(img, out, cv::COLOR_BGR2RGB);
+    } else if (img.channels() == 4) {
+        cv::cvtColor(img, out, cv::COLOR_BGRA2RGBA);
+    } else {
+        out = img;
+    }
+    return out;
+}
+
+// libtiff open mode for writing an image of the given size
+auto WriteMode(unsigned width, unsigned height, int cvType) -> const char*
+{
+    auto bytes = std::uint64_t{width} * height * CV_ELEM_SIZE(cvType);
+    return (bytes > BIGTIFF_THRESHOLD_BYTES) ? "w8" : "w";
+}
+
+// Whether tiles can be compressed independently of the output file. JPEG
+// tiles, for example, depend on tables stored in the image directory.
+auto IndependentTiles(tio::Compression c) -> bool
+{
+    switch (c) {
+        case tio::Compression::NONE:
+        case tio::Compression::LZW:
+        case tio::Compression::ADOBE_DEFLATE:
+        case tio::Compression::DEFLATE:
+        case tio::Compression::PACKBITS:
+        case tio::Compression::LZMA:
+        case tio::Compression::ZSTD:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// In-memory file for libtiff
+struct MemoryFile {
+    std::vector<char> data;
+    std::size_t pos{0};
+};
+
+auto MemoryRead(lt::thandle_t h, void* buf, lt::tmsize_t size) -> lt::tmsize_t
+{
+    auto* f = static_cast<MemoryFile*>(h);
+    auto pos = std::min(f->pos, f->data.size());
+    auto n = std::min(static_cast<std::size_t>(size), f->data.size() - pos);
+    std::memcpy(buf, f->data.data() + pos, n);
+    f->pos = pos + n;
+    return static_cast<lt::tmsize_t>(n);
+}
+
+auto MemoryWrite(lt::thandle_t h, void* buf, lt::tmsize_t size)
+    -> lt::tmsize_t
+{
+    auto* f = static_cast<MemoryFile*>(h);
+    auto n = static_cast<std::size_t>(size);
+    if (f->pos + n > f->data.size()) {
+        f->data.resize(f->pos + n);
+    }
+    std::memcpy(f->data.data() + f->pos, buf, n);
+    f->pos += n;
+    return size;
+}
+
+auto MemorySeek(lt::thandle_t h, lt::toff_t off, int whence) -> lt::toff_t
+{
+    auto* f = static_cast<MemoryFile*>(h);
+    switch (whence) {
+        case SEEK_SET:
+            f->pos = static_cast<std::size_t>(off);
+            break;
+        case SEEK_CUR:
+            f->pos += static_cast<std::size_t>(off);
+            break;
+        case SEEK_END:
+            f->pos = f->data.size() + static_cast<std::size_t>(off);
+            break;
+        default:
+            return static_cast<lt::toff_t>(-1);
+    }
+    return f->pos;
+}
+
+auto MemoryClose(lt::thandle_t /*h*/) -> int { return 0; }
+
+auto MemorySize(lt::thandle_t h) -> lt::toff_t
+{
+    return static_cast<MemoryFile*>(h)->data.size();
+}
+
+auto MemoryMap(lt::thandle_t /*h*/, void** /*base*/, lt::toff_t* /*size*/)
+    -> int
+{
+    return 0;
+}
+
+void MemoryUnmap(lt::thandle_t /*h*/, void* /*base*/, lt::toff_t /*size*/) {}
+
+// Compress a full-size tile into the bytes which TIFFWriteTile would store
+// in the file. The tile is encoded as the only tile of an in-memory TIFF with
+// the same encoding parameters, so tiles can be compressed on separate
+// threads. libtiff may modify the tile buffer.
+auto EncodeTile(cv::Mat& tile, const Encoding& e, tio::Compression c)
+    -> std::vector<char>
+{
+    MemoryFile file;
+    TIFFHandle t{lt::TIFFClientOpen(
+        "tile", "w", &file, MemoryRead, MemoryWrite, MemorySeek, MemoryClose,
+        MemorySize, MemoryMap, MemoryUnmap)};
+    if (not t) {
+        throw std::runtime_error("Failed to create tile encoder");
+    }
+
+    auto size = static_cast<unsigned>(tile.cols);
+    SetImageFields(t.get(), size, size, tile.channels(), e, c);
+    lt::TIFFSetField(t.get(), TIFFTAG_TILEWIDTH, size);
+    lt::TIFFSetField(t.get(), TIFFTAG_TILELENGTH, size);
+    auto bytes = static_cast<lt::tmsize_t>(tile.total() * tile.elemSize());
+    if (lt::TIFFWriteEncodedTile(t.get(), 0, tile.data, bytes) == -1) {
+        throw std::runtime_error("Failed to encode tile");
+    }
+
+    std::uint64_t* offsets{nullptr};
+    std::uint64_t* counts{nullptr};
+    if (lt::TIFFGetField(t.get(), TIFFTAG_TILEOFFSETS, &offsets) == 0 or
+        lt::TIFFGetField(t.get(), TIFFTAG_TILEBYTECOUNTS, &counts) == 0 or
+        offsets[0] + counts[0] > file.data.size()) {
+        throw std::runtime_error("Failed to encode tile");
+    }
+    auto begin = file.data.begin() + static_cast<std::ptrdiff_t>(offsets[0]);
+    return {begin, begin + static_cast<std::ptrdiff_t>(counts[0])};
+}
+
+// Read-only view of an in-memory file for libtiff. Copies of a view share
+// the data but have their own position, so every decoding thread can open
+// its own handle.
+struct MemoryView {
+    const char* data{nullptr};
+    std::size_t size{0};
+    std::size_t pos{0};
+};
+
+auto ViewRead(lt::thandle_t h, void* buf, lt::tmsize_t size) -> lt::tmsize_t
+{
+    auto* v = static_cast<MemoryView*>(h);
+    auto pos = std::min(v->pos, v->size);
+    auto n = std::min(static_cast<std::size_t>(size), v->size - pos);
+    std::memcpy(buf, v->data + pos, n);
+    v->pos = pos + n;
+    return static_cast<lt::tmsize_t>(n);
+}
+
+auto ViewWrite(lt::thandle_t /*h*/, void* /*buf*/, lt::tmsize_t /*size*/)
+    -> lt::tmsize_t
+{
+    return -1;
+}
+
+auto ViewSeek(lt::thandle_t h, lt::toff_t off, int whence) -> lt::toff_t
+{
+    auto* v = static_cast<MemoryView*>(h);
+    switch (whence) {
+        case SEEK_SET:
+            v->pos = static_cast<std::size_t>(off);
+            break;
+        case SEEK_CUR:
+            v->pos += static_cast<std::size_t>(off);
+            break;
+        case SEEK_END:
+            v->pos = v->size + static_cast<std::size_t>(off);
+            break;
+        default:
+            return static_cast<lt::toff_t>(-1);
+    }
+    return v->pos;
+}
+
+auto ViewSize(lt::thandle_t h) -> lt::toff_t
+{
+    return static_cast<MemoryView*>(h)->size;
+}
+
+auto OpenTIFF(MemoryView& view) -> TIFFHandle
+{
+    TIFFHandle t{lt::TIFFClientOpen(
+        "memory", "r", &view, ViewRead, ViewWrite, ViewSeek, MemoryClose,
+        ViewSize, MemoryMap, MemoryUnmap)};
+    if (not t) {
+        throw std::runtime_error("Failed to open in-memory TIFF for reading");
+    }
+    return t;
+}
+
+// Decode an image with OpenCV, for images which DecodeUnits does not support
+auto DecodeWithOpenCV(const fs::path& path) -> cv::Mat
+{
+    auto img = cv::imread(path.string(), cv::IMREAD_UNCHANGED);
+    if (img.empty()) {
+        throw std::runtime_error("Failed to read file: " + path.string());
+    }
+    return img;
+}
+
+auto DecodeWithOpenCV(const MemoryView& view) -> cv::Mat
+{
+    // imdecode does not modify its input
+    cv::Mat buf(
+        1, static_cast<int>(view.size), CV_8UC1,
+        const_cast<char*>(view.data));
+    auto img = cv::imdecode(buf, cv::IMREAD_UNCHANGED);
+    if (img.empty()) {
+        throw std::runtime_error("Failed to decode in-memory TIFF");
+    }
+    return img;
+}
+
+// Read a TIFF from a file path or a MemoryView
+template <typename TSource>
+auto ReadTIFFImpl(
+    const TSource& source, const cv::Rect& roi, std::size_t numThreads)
+    -> cv::Mat
+{
+    auto src = source;
+    auto tif = OpenTIFF(src);
+    Layout layout;
+    if (not GetLayout(tif.get(), layout)) {
+        tif.reset();
+        auto img = DecodeWithOpenCV(source);
+        if (roi.empty()) {
+            return img;
+        }
+        return img(roi & cv::Rect(0, 0, img.cols, img.rows)).clone();
+    }
+
+    // Clip the region to the image
+    cv::Rect bounds(0, 0, layout.width, layout.height);
+    auto r = roi.empty() ? bounds : (roi & bounds);
+    cv::Mat out(r.height, r.width, layout.cvType);
+    if (r.empty()) {
+        return out;
+    }
+
+    // Strips or rows of tiles which intersect the region
+    auto unitHeight = static_cast<int>(layout.unitHeight);
+    auto first = r.y / unitHeight;
+    auto last = (r.y + r.height - 1) / unitHeight + 1;
+
+    // Decode
+    if (numThreads == 0) {
+        numThreads = std::max(1U, std::thread::hardware_concurrency());
+    }
+    auto numUnits = static_cast<std::size_t>(last - first);
+    numThreads = std::min(numThreads, numUnits);
+    if (numThreads <= 1) {
+        DecodeUnits(tif.get(), layout, r, first, last, out);
+    } else {
+        // libtiff handles cannot be shared between threads
+        tif.reset();
+        std::vector<std::thread> threads;
+        std::vector<std::exception_ptr> errors(numThreads);
+        for (std::size_t i = 0; i < numThreads; i++) {
+            auto begin = first + static_cast<int>(i * numUnits / numThreads);
+            auto end =
+                first + static_cast<int>((i + 1) * numUnits / numThreads);
+            threads.emplace_back([&, i, begin, end]() {
+                try {
+                    auto threadSrc = source;
+                    auto t = OpenTIFF(threadSrc);
+                    DecodeUnits(t.get(), layout, r, begin, end, out);
+                } catch (...) {
+                    errors[i] = std::current_exception();
+                }
+            });
+        }
+        for (auto& t : threads) {
+            t.join();
+        }
+        for (const auto& e : errors) {
+            if (e) {
+                std::rethrow_exception(e);
+            }
+        }
+    }
+
+    // Match the channel order of cv::imread
+    if (layout.rgb) {
+        cv::Mat bgr(out.size(), out.type());
+        if (out.channels() == 3) {
+            std::array<int, 6> fromTo{0, 2, 1, 1, 2, 0};
+            cv::mixChannels(&out, 1, &bgr, 1, fromTo.data(), 3);
+        } else {
+            std::array<int, 8> fromTo{0, 2, 1, 1, 2, 0, 3, 3};
+            cv::mixChannels(&out, 1, &bgr, 1, fromTo.data(), 4);
+        }
+        out = bgr;
+    }
+    return out;
+}
+}  // namespace
+
+auto tio::CompressionAvailable(Compression c) -> bool
+{
+    return lt::TIFFIsCODECConfigured(static_cast<std::uint16_t>(c)) != 0;
+}
+
+auto tio::CompressionToString(Compression c) -> std::string
+{
+    switch (c) {
+        case Compression::NONE:
+            return "none";
+        case Compression::LZW:
+            return "lzw";
+        case Compression::ADOBE_DEFLATE:
+        case Compression::DEFLATE:
+            return "deflate";
+        case Compression::PACKBITS:
+            return "packbits";
+        case Compression::LZMA:
+            return "lzma";
+        case Compression::ZSTD:
+            return "zstd";
+        default:
+            return std::to_string(static_cast<int>(c));
+    }
+}
+
+auto tio::CompressionFromString(const std::string& s) -> Compression
+{
+    auto name = volcart::to_lower_copy(s);
+    if (name == "none") {
+        return Compression::NONE;
+    }
+    if (name == "lzw") {
+        return Compression::LZW;
+    }
+    if (name == "deflate") {
+        return Compression::ADOBE_DEFLATE;
+    }
+    if (name == "packbits") {
+        return Compression::PACKBITS;
+    }
+    if (name == "lzma") {
+        return Compression::LZMA;
+    }
+    if (name == "zstd") {
+        return Compression::ZSTD;
+    }
+    throw std::invalid_argument("Unknown TIFF compression: " + s);
+}
+
+auto tio::ReadTIFF(
+    const fs::path& path, const cv::Rect& roi, std::size_t numThreads)
+    -> cv::Mat
+{
+    return ReadTIFFImpl(path, roi, numThreads);
+}
+
+auto tio::ReadTIFF(
+    const std::vector<char>& data, const cv::Rect& roi, std::size_t numThreads)
+    -> cv::Mat
+{
+    return ReadTIFFImpl(MemoryView{data.data(), data.size()}, roi, numThreads);
+}
+
+// Write a TIFF to a file. This implementation heavily borrows from how OpenCV's
+// TIFFEncoder writes to the TIFF
+void tio::WriteTIFF(
+    const fs::path& path,
+    const cv::Mat& img,
+    Compression compression,
+    std::size_t rowsPerStrip)
+{
+    // Safety checks
+    CheckOutputPath(path);
+    CheckCompression(compression);
+    auto encoding = GetEncoding(img.type());
+
+    // Image metadata
+    auto channels = img.channels();
+    auto width = static_cast<unsigned>(img.cols);
+    auto height = static_cast<unsigned>(img.rows);
+
+    // Strip size
+    if (rowsPerStrip == 0) {
+        auto rowBytes = std::max<std::size_t>(
+            1, std::size_t{width} * channels * encoding.bitsPerSample / 8);
+        rowsPerStrip = std::max<std::size_t>(1, TARGET_STRIP_BYTES / rowBytes);
+    }
+    rowsPerStrip = std::min<std::size_t>(rowsPerStrip, std::max(height, 1U));
+
+    // Open the file
+    auto out = lt::TIFFOpen(path.c_str(), WriteMode(width, height, img.type()));
+    if (out == nullptr) {
+        throw std::runtime_error("Failed to open file for writing");
+    }
+
+    // Encoding parameters
+    SetImageFields(out, width, height, channels, encoding, compression);
+    lt::TIFFSetField(
+        out, TIFFTAG_ROWSPERSTRIP, static_cast<unsigned>(rowsPerStrip));
 
     // Row buffer. OpenCV documentation mentions that TIFFWriteScanline
     // modifies its read buffer, so we can't use the cv::Mat directly
@@ -123,14 +746,7 @@ void tio::WriteTIFF(
     std::vector<char> buffer(bufferSize + 32);
 
     // Get working copy with converted channels if an RGB-type image
-    cv::Mat imgCopy;
-    if (img.channels() == 3) {
-        cv::cvtColor(img, imgCopy, cv::COLOR_BGR2RGB);
-    } else if (img.channels() == 4) {
-        cv::cvtColor(img, imgCopy, cv::COLOR_BGRA2RGBA);
-    } else {
-        imgCopy = img;
-    }
+    auto imgCopy = ToTIFFChannelOrder(img);
 
     // For each row
     for (unsigned row = 0; row < height; row++) {
@@ -146,3 +762,191 @@ void tio::WriteTIFF(
     // Close the tiff
     lt::TIFFClose(out);
 }
+
+struct tio::TiledTIFFWriter::Handle {
+    TIFFHandle tif;
+};
+
+tio::TiledTIFFWriter::TiledTIFFWriter(
+    const fs::path& path,
+    int width,
+    int height,
+    int cvType,
+    int tileSize,
+    Compression compression)
+    : width_{width}
+    , height_{height}
+    , cvType_{cvType}
+    , tileSize_{tileSize}
+    , compression_{compression}
+{
+    // Safety checks
+    if (width <= 0 or height <= 0) {
+        throw std::invalid_argument("Image dimensions must be positive");
+    }
+    if (tileSize <= 0 or tileSize % TILE_MULTIPLE != 0) {
+        throw std::invalid_argument("Tile size must be a multiple of 16");
+    }
+    CheckOutputPath(path);
+    CheckCompression(compression);
+    auto encoding = GetEncoding(cvType);
+
+    // Open the file
+    handle_ = std::make_unique<Handle>();
+    auto mode = WriteMode(
+        static_cast<unsigned>(width), static_cast<unsigned>(height), cvType);
+    handle_->tif.reset(lt::TIFFOpen(path.c_str(), mode));
+    if (not handle_->tif) {
+        throw std::runtime_error(
+            "Failed to open file for writing: " + path.string());
+    }
+
+    // Encoding parameters
+    auto* out = handle_->tif.get();
+    SetImageFields(
+        out, static_cast<unsigned>(width), static_cast<unsigned>(height),
+        CV_MAT_CN(cvType), encoding, compression);
+    lt::TIFFSetField(out, TIFFTAG_TILEWIDTH, static_cast<unsigned>(tileSize));
+    lt::TIFFSetField(out, TIFFTAG_TILELENGTH, static_cast<unsigned>(tileSize));
+
+    tilesX_ = (width + tileSize - 1) / tileSize;
+    tilesY_ = (height + tileSize - 1) / tileSize;
+    written_.assign(static_cast<std::size_t>(tilesX_) * tilesY_, false);
+}
+
+tio::TiledTIFFWriter::~TiledTIFFWriter()
+{
+    try {
+        close();
+    } catch (...) {
+        // Destructors can't throw. Call close() to handle errors.
+    }
+}
+
+auto tio::TiledTIFFWriter::width() const -> int { return width_; }
+
+auto tio::TiledTIFFWriter::height() const -> int { return height_; }
+
+auto tio::TiledTIFFWriter::tileSize() const -> int { return tileSize_; }
+
+void tio::TiledTIFFWriter::setNumThreads(std::size_t n) { numThreads_ = n; }
+
+auto tio::TiledTIFFWriter::numThreads() const -> std::size_t
+{
+    return numThreads_;
+}
+
+void tio::TiledTIFFWriter::writeRegion(const cv::Point& origin, cv::Mat img)
+{
+    if (not handle_) {
+        throw std::runtime_error("Writer is closed");
+    }
+    if (img.type() != cvType_) {
+        throw std::invalid_argument("Image type does not match writer");
+    }
+
+    // The region must cover whole tiles, except along the image edges
+    auto x1 = origin.x + img.cols;
+    auto y1 = origin.y + img.rows;
+    if (origin.x < 0 or origin.y < 0 or x1 > width_ or y1 > height_) {
+        throw std::out_of_range("Region is outside of the image");
+    }
+    if (origin.x % tileSize_ != 0 or origin.y % tileSize_ != 0 or
+        (x1 % tileSize_ != 0 and x1 != width_) or
+        (y1 % tileSize_ != 0 and y1 != height_)) {
+        throw std::invalid_argument("Region is not aligned to the tile grid");
+    }
+
+    // Tiles are always full size, so edge tiles are padded with zeros
+    img = ToTIFFChannelOrder(img);
+    std::vector<cv::Point> tiles;
+    for (auto y = origin.y; y < y1; y += tileSize_) {
+        for (auto x = origin.x; x < x1; x += tileSize_) {
+            tiles.emplace_back(x, y);
+        }
+    }
+    auto copyTile = [&](const cv::Point& t, cv::Mat& tile) {
+        tile.setTo(0);
+        cv::Rect src(
+            t.x - origin.x, t.y - origin.y, std::min(tileSize_, x1 - t.x),
+            std::min(tileSize_, y1 - t.y));
+        img(src).copyTo(tile(cv::Rect({0, 0}, src.size())));
+    };
+
+    // Let libtiff compress and write each tile
+    if (numThreads_ == 1 or tiles.size() == 1 or
+        not IndependentTiles(compression_)) {
+        cv::Mat tile(tileSize_, tileSize_, cvType_);
+        for (const auto& t : tiles) {
+            copyTile(t, tile);
+            write_tile_(t.x, t.y, tile);
+        }
+        return;
+    }
+
+    // Compress the tiles in parallel, then write them in order
+    auto encoding = GetEncoding(cvType_);
+    std::vector<std::vector<char>> encoded(tiles.size());
+    ParallelChunks(tiles.size(), numThreads_, [&](auto begin, auto end) {
+        cv::Mat tile(tileSize_, tileSize_, cvType_);
+        for (auto i = begin; i < end; i++) {
+            copyTile(tiles[i], tile);
+            encoded[i] = EncodeTile(tile, encoding, compression_);
+        }
+    });
+    for (std::size_t i = 0; i < tiles.size(); i++) {
+        write_encoded_tile_(tiles[i].x, tiles[i].y, encoded[i]);
+        encoded[i] = {};
+    }
+}
+
+void tio::TiledTIFFWriter::close()
+{
+    if (not handle_) {
+        return;
+    }
+
+    // Fill unwritten tiles so that the file is complete
+    cv::Mat tile = cv::Mat::zeros(tileSize_, tileSize_, cvType_);
+    for (int ty = 0; ty < tilesY_; ty++) {
+        for (int tx = 0; tx < tilesX_; tx++) {
+            if (not written_[static_cast<std::size_t>(ty) * tilesX_ + tx]) {
+                write_tile_(tx * tileSize_, ty * tileSize_, tile);
+            }
+        }
+    }
+    handle_.reset();
+}
+
+void tio::TiledTIFFWriter::write_tile_(int x, int y, cv::Mat& tile)
+{
+    auto result = lt::TIFFWriteTile(
+        handle_->tif.get(), tile.data, static_cast<std::uint32_t>(x),
+        static_cast<std::uint32_t>(y), 0, 0);
+    if (result == -1) {
+        auto msg = "Failed to write tile at " + std::to_string(x) + ", " +
+                   std::to_string(y);
+        throw std::runtime_error(msg);
+    }
+    auto idx = static_cast<std::size_t>(y / tileSize_) * tilesX_ +
+               static_cast<std::size_t>(x / tileSize_);
+    written_[idx] = true;
+}
+
+void tio::TiledTIFFWriter::write_encoded_tile_(
+    int x, int y, std::vector<char>& data)
+{
+    auto* out = handle_->tif.get();
+    auto idx = lt::TIFFComputeTile(
+        out, static_cast<std::uint32_t>(x), static_cast<std::uint32_t>(y), 0,
+        0);
+    auto result = lt::TIFFWriteRawTile(
+        out, idx, data.data(), static_cast<lt::tmsize_t>(data.size()));
+    if (result == -1) {
+        auto msg = "Failed to write tile at " + std::to_string(x) + ", " +
+                   std::to_string(y);
+        throw std::runtime_error(msg);
+    }
+    written_[static_cast<std::size_t>(y / tileSize_) * tilesX_ +
+             static_cast<std::size_t>(x / tileSize_)] = true;
+}
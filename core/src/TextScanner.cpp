@@ -0,0 +1,197 @@
+#include "vc/core/io/TextScanner.hpp"
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cstdlib>
+#include <cstring>
+
+using namespace volcart::io;
+
+namespace
+{
+// Exactly representable powers of ten
+constexpr std::array<double, 23> POW10{
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+// Largest integer such that every smaller integer is exactly representable
+constexpr std::uint64_t MAX_EXACT_MANTISSA = std::uint64_t{1} << 53;
+
+// Longest token passed to strtod
+constexpr std::size_t MAX_FALLBACK_LENGTH = 128;
+
+inline auto IsDigit(char c) -> bool { return c >= '0' and c <= '9'; }
+
+inline auto IsSeparator(char c) -> bool
+{
+    return c == ' ' or c == '\t' or c == '\r' or c == '\n';
+}
+
+// Parse a double with strtod
+auto ParseFallback(const char*& pos, const char* end, double& v) -> bool
+{
+    auto tokenEnd = std::find_if(pos, end, IsSeparator);
+    auto len = static_cast<std::size_t>(tokenEnd - pos);
+    if (len == 0 or len > MAX_FALLBACK_LENGTH) {
+        return false;
+    }
+
+    std::array<char, MAX_FALLBACK_LENGTH + 1> buffer{};
+    std::memcpy(buffer.data(), pos, len);
+    char* parsedEnd{nullptr};
+    auto result = std::strtod(buffer.data(), &parsedEnd);
+    if (parsedEnd == buffer.data()) {
+        return false;
+    }
+    v = result;
+    pos += parsedEnd - buffer.data();
+    return true;
+}
+}  // namespace
+
+void TextScanner::nextLine()
+{
+    if (pos_ >= end_) {
+        return;
+    }
+    auto remaining = static_cast<std::size_t>(end_ - pos_);
+    const auto* nl =
+        static_cast<const char*>(std::memchr(pos_, '\n', remaining));
+    pos_ = (nl == nullptr) ? end_ : nl + 1;
+}
+
+auto TextScanner::token() -> std::string_view
+{
+    skip_space_();
+    const auto* begin = pos_;
+    while (pos_ < end_ and not IsSeparator(*pos_)) {
+        ++pos_;
+    }
+    return {begin, static_cast<std::size_t>(pos_ - begin)};
+}
+
+auto TextScanner::parseDouble(double& v) -> bool
+{
+    skip_space_();
+    const auto* p = pos_;
+
+    bool negative{false};
+    if (p < end_ and (*p == '-' or *p == '+')) {
+        negative = *p == '-';
+        ++p;
+    }
+
+    // Accumulate the significant digits
+    std::uint64_t mantissa{0};
+    int digits{0};
+    int exponent{0};
+    bool any{false};
+    bool exact{true};
+    for (; p < end_ and IsDigit(*p); ++p) {
+        any = true;
+        if (digits < 19) {
+            mantissa = mantissa * 10 + static_cast<std::uint64_t>(*p - '0');
+            digits += (mantissa != 0) ? 1 : 0;
+        } else {
+            exponent++;
+            exact = exact and *p == '0';
+        }
+    }
+    if (p < end_ and *p == '.') {
+        ++p;
+        for (; p < end_ and IsDigit(*p); ++p) {
+            any = true;
+            if (digits < 19) {
+                mantissa =
+                    mantissa * 10 + static_cast<std::uint64_t>(*p - '0');
+                digits += (mantissa != 0) ? 1 : 0;
+                exponent--;
+            } else {
+                exact = exact and *p == '0';
+            }
+        }
+    }
+
+    // Not a plain decimal number (e.g. inf, nan, or hex)
+    if (not any) {
+        return ParseFallback(pos_, end_, v);
+    }
+
+    if (p < end_ and (*p == 'e' or *p == 'E')) {
+        const auto* e = p + 1;
+        bool negExp{false};
+        if (e < end_ and (*e == '-' or *e == '+')) {
+            negExp = *e == '-';
+            ++e;
+        }
+        if (e < end_ and IsDigit(*e)) {
+            int exp{0};
+            for (; e < end_ and IsDigit(*e); ++e) {
+                exp = std::min(exp * 10 + (*e - '0'), 100000);
+            }
+            exponent += negExp ? -exp : exp;
+            p = e;
+        }
+    }
+
+    // Clinger's fast path: both operands are exact, so the single rounding
+    // of the multiplication or division gives the correctly rounded result
+    if (not exact or mantissa > MAX_EXACT_MANTISSA or exponent < -22 or
+        exponent > 22) {
+        return ParseFallback(pos_, end_, v);
+    }
+
+    auto result = static_cast<double>(mantissa);
+    if (exponent < 0) {
+        result /= POW10[-exponent];
+    } else {
+        result *= POW10[exponent];
+    }
+    v = negative ? -result : result;
+    pos_ = p;
+    return true;
+}
+
+auto TextScanner::parseInt(std::int64_t& v) -> bool
+{
+    skip_space_();
+    const auto* p = pos_;
+    if (p < end_ and *p == '+') {
+        ++p;
+    }
+    auto [ptr, ec] = std::from_chars(p, end_, v);
+    if (ec != std::errc()) {
+        return false;
+    }
+    pos_ = ptr;
+    return true;
+}
+
+auto volcart::io::SplitLines(
+    const char* begin, const char* end, std::size_t n, std::size_t minSize)
+    -> std::vector<std::pair<const char*, const char*>>
+{
+    std::vector<std::pair<const char*, const char*>> ranges;
+    auto size = static_cast<std::size_t>(end - begin);
+    auto maxRanges = size / std::max<std::size_t>(1, minSize);
+    n = std::clamp<std::size_t>(n, 1, std::max<std::size_t>(1, maxRanges));
+    auto target = size / n;
+
+    const auto* start = begin;
+    for (std::size_t i = 1; i < n and start < end; i++) {
+        auto offset = static_cast<std::size_t>(start - begin);
+        auto pos = std::max(i * target, offset);
+        const auto* nl = static_cast<const char*>(
+            std::memchr(begin + pos, '\n', size - pos));
+        if (nl == nullptr) {
+            break;
+        }
+        ranges.emplace_back(start, nl + 1);
+        start = nl + 1;
+    }
+    if (start < end or ranges.empty()) {
+        ranges.emplace_back(start, end);
+    }
+    return ranges;
+}
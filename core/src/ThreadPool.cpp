@@ -0,0 +1,159 @@
+#include "vc/core/util/ThreadPool.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+using namespace volcart;
+
+namespace
+{
+// The pool and queue owned by the current thread, if it is a worker
+thread_local const ThreadPool* WorkerPool{nullptr};
+thread_local std::size_t WorkerIdx{0};
+
+// Number of threads requested for the global pool
+std::mutex GlobalMutex;
+std::size_t GlobalThreads{0};
+// Number of threads in the global pool, once started
+std::size_t GlobalStarted{0};
+
+auto ResolveNumThreads(std::size_t numThreads) -> std::size_t
+{
+    if (numThreads == 0) {
+        numThreads =
+            std::max<std::size_t>(1, std::thread::hardware_concurrency());
+    }
+    return numThreads;
+}
+}  // namespace
+
+ThreadPool::ThreadPool(std::size_t numThreads)
+{
+    numThreads = ResolveNumThreads(numThreads);
+    queues_.reserve(numThreads);
+    for (std::size_t i = 0; i < numThreads; ++i) {
+        queues_.emplace_back(std::make_unique<Queue>());
+    }
+    threads_.reserve(numThreads);
+    for (std::size_t i = 0; i < numThreads; ++i) {
+        threads_.emplace_back(&ThreadPool::worker_, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    cv_.notify_all();
+    for (auto& t : threads_) {
+        t.join();
+    }
+}
+
+auto ThreadPool::Global() -> ThreadPool&
+{
+    static ThreadPool pool([]() {
+        const std::lock_guard<std::mutex> lock(GlobalMutex);
+        GlobalStarted = ResolveNumThreads(GlobalThreads);
+        return GlobalStarted;
+    }());
+    return pool;
+}
+
+void ThreadPool::SetGlobalThreads(std::size_t numThreads)
+{
+    const std::lock_guard<std::mutex> lock(GlobalMutex);
+    if (GlobalStarted > 0 and GlobalStarted != ResolveNumThreads(numThreads)) {
+        throw std::logic_error(
+            "global ThreadPool already started with " +
+            std::to_string(GlobalStarted) + " threads");
+    }
+    GlobalThreads = numThreads;
+}
+
+auto ThreadPool::numThreads() const -> std::size_t { return threads_.size(); }
+
+auto ThreadPool::runPendingTask() -> bool
+{
+    auto idx = (WorkerPool == this) ? WorkerIdx : 0;
+    Task task;
+    if (not pop_(idx, task)) {
+        return false;
+    }
+    task();
+    return true;
+}
+
+void ThreadPool::push_(Task task)
+{
+    // Count the task before it's queued so that the count never underflows.
+    // Workers woken early retry until the task is visible.
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        ++pending_;
+    }
+
+    // Workers keep their own tasks local. Other threads spread them out.
+    if (WorkerPool == this) {
+        auto& q = *queues_[WorkerIdx];
+        std::unique_lock<std::mutex> lock(q.mutex);
+        q.tasks.emplace_front(std::move(task));
+    } else {
+        auto& q = *queues_[nextQueue_++ % queues_.size()];
+        std::unique_lock<std::mutex> lock(q.mutex);
+        q.tasks.emplace_back(std::move(task));
+    }
+    cv_.notify_one();
+}
+
+auto ThreadPool::pop_(std::size_t idx, Task& task) -> bool
+{
+    // Own queue first, newest task
+    {
+        auto& q = *queues_[idx];
+        std::unique_lock<std::mutex> lock(q.mutex);
+        if (not q.tasks.empty()) {
+            task = std::move(q.tasks.front());
+            q.tasks.pop_front();
+            --pending_;
+            return true;
+        }
+    }
+
+    // Steal the oldest task from another queue
+    for (std::size_t i = 1; i < queues_.size(); ++i) {
+        auto& q = *queues_[(idx + i) % queues_.size()];
+        std::unique_lock<std::mutex> lock(q.mutex);
+        if (not q.tasks.empty()) {
+            task = std::move(q.tasks.back());
+            q.tasks.pop_back();
+            --pending_;
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::worker_(std::size_t idx)
+{
+    WorkerPool = this;
+    WorkerIdx = idx;
+
+    Task task;
+    while (true) {
+        if (pop_(idx, task)) {
+            task();
+            task = nullptr;
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [this]() { return stop_ or pending_ > 0; });
+        if (stop_ and pending_ == 0) {
+            return;
+        }
+    }
+}
@@ -0,0 +1,152 @@
+#include "vc/core/util/Tracing.hpp"
+
+#include <atomic>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include "vc/core/types/Exceptions.hpp"
+
+using namespace volcart;
+using namespace volcart::tracing;
+
+namespace fs = volcart::filesystem;
+using Clock = std::chrono::steady_clock;
+
+namespace
+{
+// A finished span
+struct Event {
+    std::string name;
+    const char* category;
+    Clock::time_point start;
+    Clock::time_point end;
+};
+
+// Spans recorded by one thread
+struct ThreadBuffer {
+    // Only contended while the trace is cleared or written
+    std::mutex mutex;
+    std::vector<Event> events;
+    std::size_t tid{0};
+};
+
+std::atomic<bool> IsEnabled{false};
+
+// Every thread's buffer. Buffers outlive their threads so that spans from
+// finished threads are still written.
+std::mutex RegistryMutex;
+std::vector<std::shared_ptr<ThreadBuffer>> Registry;
+
+// Start of the trace's time axis
+const Clock::time_point Epoch{Clock::now()};
+
+auto LocalBuffer() -> ThreadBuffer&
+{
+    thread_local std::shared_ptr<ThreadBuffer> buffer = []() {
+        auto b = std::make_shared<ThreadBuffer>();
+        const std::lock_guard<std::mutex> lock(RegistryMutex);
+        b->tid = Registry.size();
+        Registry.push_back(b);
+        return b;
+    }();
+    return *buffer;
+}
+
+auto Microseconds(Clock::time_point t) -> double
+{
+    return std::chrono::duration<double, std::micro>(t - Epoch).count();
+}
+}  // namespace
+
+void tracing::SetEnabled(bool enabled) { IsEnabled = enabled; }
+
+auto tracing::Enabled() noexcept -> bool
+{
+    return IsEnabled.load(std::memory_order_relaxed);
+}
+
+void tracing::Clear()
+{
+    const std::lock_guard<std::mutex> lock(RegistryMutex);
+    for (const auto& b : Registry) {
+        const std::lock_guard<std::mutex> bufferLock(b->mutex);
+        b->events.clear();
+    }
+}
+
+auto tracing::NumSpans() -> std::size_t
+{
+    std::size_t n{0};
+    const std::lock_guard<std::mutex> lock(RegistryMutex);
+    for (const auto& b : Registry) {
+        const std::lock_guard<std::mutex> bufferLock(b->mutex);
+        n += b->events.size();
+    }
+    return n;
+}
+
+void tracing::WriteChromeTrace(const fs::path& path)
+{
+    std::ofstream file(path.string());
+    if (not file) {
+        throw IOException("Failed to open file for writing: " + path.string());
+    }
+
+    // Events are written one at a time rather than as a single JSON
+    // document, since long runs can record millions of spans
+    file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool first{true};
+    const std::lock_guard<std::mutex> lock(RegistryMutex);
+    for (const auto& b : Registry) {
+        const std::lock_guard<std::mutex> bufferLock(b->mutex);
+        for (const auto& e : b->events) {
+            nlohmann::json event{
+                {"name", e.name},
+                {"cat", e.category},
+                {"ph", "X"},
+                {"pid", 0},
+                {"tid", b->tid},
+                {"ts", Microseconds(e.start)},
+                {"dur", Microseconds(e.end) - Microseconds(e.start)}};
+            file << (first ? "\n" : ",\n") << event.dump();
+            first = false;
+        }
+    }
+    file << "\n]}\n";
+
+    if (not file) {
+        throw IOException("Failed to write file: " + path.string());
+    }
+}
+
+Span::Span(const char* name, const char* category) : category_{category}
+{
+    if (Enabled()) {
+        name_ = name;
+        start_ = Clock::now();
+    }
+}
+
+Span::Span(std::string name, const char* category)
+    : name_{std::move(name)}, category_{category}
+{
+    if (Enabled()) {
+        start_ = Clock::now();
+    }
+}
+
+Span::~Span()
+{
+    // Spans which started while recording was disabled are not recorded
+    if (start_ == Clock::time_point{} or not Enabled()) {
+        return;
+    }
+    auto end = Clock::now();
+    auto& buffer = LocalBuffer();
+    const std::lock_guard<std::mutex> lock(buffer.mutex);
+    buffer.events.push_back({std::move(name_), category_, start_, end});
+}
@@ -1,8 +1,14 @@
 #include "vc/core/types/UVMap.hpp"
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <mutex>
+
 #include <opencv2/imgproc.hpp>
 
 #include "vc/core/util/Iteration.hpp"
+#include "vc/core/util/ThreadPool.hpp"
 
 /** Top-left UV Origin */
 const static cv::Vec2d ORIGIN_TOP_LEFT(0, 0);
@@ -20,41 +26,56 @@ using namespace volcart;
 
 inline auto OriginVector(const UVMap::Origin& o) -> cv::Vec2d;
 
+// Per-element absolute difference. Equivalent to cv::absdiff, without the
+// overhead of wrapping the vectors in cv::Mat.
+static inline auto AbsDiff(const cv::Vec2d& a, const cv::Vec2d& b)
+    -> cv::Vec2d
+{
+    return {std::abs(a[0] - b[0]), std::abs(a[1] - b[1])};
+}
+
+static inline auto IsMapped(const cv::Vec2d& uv) -> bool
+{
+    return uv != NULL_MAPPING;
+}
+
 void UVMap::set(size_t id, const cv::Vec2d& uv, const Origin& o)
 {
+    if (id >= uvs_.size()) {
+        uvs_.resize(id + 1, NULL_MAPPING);
+    }
+    if (not IsMapped(uvs_[id])) {
+        size_++;
+    }
+
     // transform to be relative to top-left
-    cv::Vec2d transformed;
-    cv::absdiff(uv, OriginVector(o), transformed);
-    map_[id] = transformed;
+    uvs_[id] = AbsDiff(uv, OriginVector(o));
 }
 
 void UVMap::set(size_t id, const cv::Vec2d& uv) { set(id, uv, origin_); }
 
 auto UVMap::get(size_t id, const Origin& o) const -> cv::Vec2d
 {
-    auto it = map_.find(id);
-    if (it != map_.end()) {
-        // transform to be relative to the provided origin
-        cv::Vec2d transformed;
-        cv::absdiff(it->second, OriginVector(o), transformed);
-        return transformed;
-    } else {
+    if (not contains(id)) {
         return NULL_MAPPING;
     }
+
+    // transform to be relative to the provided origin
+    return AbsDiff(uvs_[id], OriginVector(o));
 }
 
 auto UVMap::get(size_t id) const -> cv::Vec2d { return get(id, origin_); }
 
 auto UVMap::contains(std::size_t id) const -> bool
 {
-    return map_.count(id) > 0;
+    return id < uvs_.size() and IsMapped(uvs_[id]);
 }
 
 UVMap::UVMap(UVMap::Origin o) : origin_{o} {}
 
-auto UVMap::size() const -> size_t { return map_.size(); }
+auto UVMap::size() const -> size_t { return size_; }
 
-auto UVMap::empty() const -> bool { return map_.empty(); }
+auto UVMap::empty() const -> bool { return size_ == 0; }
 
 void UVMap::setOrigin(const UVMap::Origin& o) { origin_ = o; }
 
@@ -70,7 +91,29 @@ void UVMap::ratio(double w, double h)
     ratio_.height = h;
     ratio_.aspect = w / h;
 }
-auto UVMap::as_map() const -> std::map<size_t, cv::Vec2d> { return map_; }
+
+auto UVMap::as_map() const -> std::map<size_t, cv::Vec2d>
+{
+    std::map<size_t, cv::Vec2d> map;
+    for (const auto& [id, uv] : enumerate(uvs_)) {
+        if (IsMapped(uv)) {
+            map.emplace_hint(map.end(), id, uv);
+        }
+    }
+    return map;
+}
+
+auto UVMap::as_vector() const -> const std::vector<cv::Vec2d>&
+{
+    return uvs_;
+}
+
+void UVMap::from_vector(std::vector<cv::Vec2d> uvs)
+{
+    uvs_ = std::move(uvs);
+    size_ = static_cast<std::size_t>(
+        std::count_if(uvs_.begin(), uvs_.end(), IsMapped));
+}
 
 auto OriginVector(const UVMap::Origin& o) -> cv::Vec2d
 {
@@ -95,8 +138,11 @@ auto UVMap::Plot(const UVMap& uv, const Color& color) -> cv::Mat
     auto h = static_cast<int>(std::ceil(w / uv.ratio_.aspect));
     cv::Mat r = cv::Mat::zeros(h, w, CV_8UC3);
 
-    for (auto it : uv.map_) {
-        cv::Point2d p(it.second[0] * w, it.second[1] * h);
+    for (const auto& m : uv.uvs_) {
+        if (not IsMapped(m)) {
+            continue;
+        }
+        cv::Point2d p(m[0] * w, m[1] * h);
         cv::circle(r, p, 1, color, -1);
     }
 
@@ -152,21 +198,21 @@ void UVMap::Rotate(UVMap& uv, Rotation rotation, cv::Mat& texture)
     }
 
     // Update each UV coordinate
-    for (auto& m : uv.map_) {
-        if (rotation == Rotation::CW90) {
-            auto u = 1. - m.second[1];
-            auto v = m.second[0];
-            m.second[0] = u;
-            m.second[1] = v;
-        } else if (rotation == Rotation::CW180) {
-            m.second = cv::Vec2d{1, 1} - m.second;
-        } else if (rotation == Rotation::CCW90) {
-            auto u = m.second[1];
-            auto v = 1. - m.second[0];
-            m.second[0] = u;
-            m.second[1] = v;
+    ParallelChunks(uv.uvs_.size(), 0, [&uv, rotation](auto begin, auto end) {
+        for (auto i = begin; i < end; ++i) {
+            auto& m = uv.uvs_[i];
+            if (not IsMapped(m)) {
+                continue;
+            }
+            if (rotation == Rotation::CW90) {
+                m = {1. - m[1], m[0]};
+            } else if (rotation == Rotation::CW180) {
+                m = cv::Vec2d{1, 1} - m;
+            } else if (rotation == Rotation::CCW90) {
+                m = {m[1], 1. - m[0]};
+            }
         }
-    }
+    });
 
     // Update the texture
     if (not texture.empty()) {
@@ -177,18 +223,9 @@ void UVMap::Rotate(UVMap& uv, Rotation rotation, cv::Mat& texture)
 void UVMap::Rotate(
     UVMap& uv, double theta, cv::Mat& texture, const cv::Vec2d& center)
 {
-    // Setup pts matrix
-    cv::Mat pts = cv::Mat::ones(uv.map_.size(), 3, CV_64F);
-    int row = 0;
-    for (const auto& p : uv.map_) {
-        // transform so that operation happens relative to stored origin
-        cv::Vec2d transformed;
-        cv::absdiff(p.second, OriginVector(uv.origin_), transformed);
-
-        // Store in matrix of points
-        pts.at<double>(row, 0) = transformed[0];
-        pts.at<double>(row, 1) = transformed[1];
-        row++;
+    // Nothing to rotate
+    if (uv.empty()) {
+        return;
     }
 
     // Translate to center of rotation in UV space
@@ -211,21 +248,46 @@ void UVMap::Rotate(
     r.at<double>(1, 1) = cos;
 
     // Composite UV transform matrix
-    cv::Mat composite = r * s * t1;
-
-    // Apply the transform to the col-major pts matrix
-    pts = composite * pts.t();
-
-    // Transpose back to row major
-    pts = pts.t();
+    cv::Matx33d composite = cv::Mat(r * s * t1);
+
+    // Transform the UVs in place to image space and get the new min-max u & v
+    auto origin = OriginVector(uv.origin_);
+    constexpr auto MAX = std::numeric_limits<double>::max();
+    double uMin{MAX};
+    double uMax{-MAX};
+    double vMin{MAX};
+    double vMax{-MAX};
+    std::mutex boundsMutex;
+    ParallelChunks(uv.uvs_.size(), 0, [&](auto begin, auto end) {
+        double uMinChunk{MAX};
+        double uMaxChunk{-MAX};
+        double vMinChunk{MAX};
+        double vMaxChunk{-MAX};
+        for (auto i = begin; i < end; ++i) {
+            // Image space positions may equal NULL_MAPPING, so unmapped IDs
+            // are marked with NaN until the UVs are rescaled
+            auto& p = uv.uvs_[i];
+            if (not IsMapped(p)) {
+                p = {NAN, NAN};
+                continue;
+            }
+
+            // transform so that operation happens relative to stored origin
+            auto t = AbsDiff(p, origin);
+            auto q = composite * cv::Vec3d{t[0], t[1], 1};
+            p = {q[0], q[1]};
+            uMinChunk = std::min(uMinChunk, q[0]);
+            uMaxChunk = std::max(uMaxChunk, q[0]);
+            vMinChunk = std::min(vMinChunk, q[1]);
+            vMaxChunk = std::max(vMaxChunk, q[1]);
+        }
 
-    // Get new min-max u & v
-    double uMin{0};
-    double uMax{0};
-    double vMin{0};
-    double vMax{0};
-    cv::minMaxLoc(pts.col(0), &uMin, &uMax);
-    cv::minMaxLoc(pts.col(1), &vMin, &vMax);
+        const std::lock_guard<std::mutex> lock(boundsMutex);
+        uMin = std::min(uMin, uMinChunk);
+        uMax = std::max(uMax, uMaxChunk);
+        vMin = std::min(vMin, vMinChunk);
+        vMax = std::max(vMax, vMaxChunk);
+    });
 
     // Set new width and height
     auto aspectWidth = std::abs(uMax - uMin);
@@ -233,24 +295,22 @@ void UVMap::Rotate(
     uv.ratio(aspectWidth, aspectHeight);
 
     // Update UVs within new bounds
-    cv::Vec2d newPos;
-    row = 0;
-    for (auto& p : uv.map_) {
-        // rescale within bounds
-        newPos[0] = (pts.at<double>(row, 0) - uMin) / (uMax - uMin);
-        newPos[1] = (pts.at<double>(row, 1) - vMin) / (vMax - vMin);
-
-        // transform back to storage origin
-        cv::Vec2d transformed;
-        cv::absdiff(newPos, OriginVector(uv.origin_), transformed);
-
-        // store
-        p.second[0] = transformed[0];
-        p.second[1] = transformed[1];
-
-        // Advance the row counter
-        row++;
-    }
+    ParallelChunks(uv.uvs_.size(), 0, [&](auto begin, auto end) {
+        for (auto i = begin; i < end; ++i) {
+            auto& p = uv.uvs_[i];
+            if (std::isnan(p[0])) {
+                p = NULL_MAPPING;
+                continue;
+            }
+
+            // rescale within bounds
+            cv::Vec2d newPos{
+                (p[0] - uMin) / (uMax - uMin), (p[1] - vMin) / (vMax - vMin)};
+
+            // transform back to storage origin
+            p = AbsDiff(newPos, origin);
+        }
+    });
 
     // Update texture
     if (not texture.empty()) {
@@ -283,17 +343,23 @@ void UVMap::Rotate(UVMap& uv, double theta, const cv::Vec2d& center)
 
 void UVMap::Flip(UVMap& uv, FlipAxis axis)
 {
-    for (auto& p : uv.map_) {
-        switch (axis) {
-            case FlipAxis::Horizontal:
-                p.second[0] = 1 - p.second[0];
-                continue;
-            case FlipAxis::Vertical:
-                p.second[1] = 1 - p.second[1];
-                continue;
-            case FlipAxis::Both:
-                p.second = cv::Vec2d{1, 1} - p.second;
+    ParallelChunks(uv.uvs_.size(), 0, [&uv, axis](auto begin, auto end) {
+        for (auto i = begin; i < end; ++i) {
+            auto& p = uv.uvs_[i];
+            if (not IsMapped(p)) {
                 continue;
+            }
+            switch (axis) {
+                case FlipAxis::Horizontal:
+                    p[0] = 1 - p[0];
+                    continue;
+                case FlipAxis::Vertical:
+                    p[1] = 1 - p[1];
+                    continue;
+                case FlipAxis::Both:
+                    p = cv::Vec2d{1, 1} - p;
+                    continue;
+            }
         }
-    }
+    });
 }
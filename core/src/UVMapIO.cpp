@@ -1,9 +1,13 @@
 #include "vc/core/io/UVMapIO.hpp"
 
+#include <array>
+#include <cstdint>
+#include <cstring>
 #include <fstream>
 #include <regex>
 #include <sstream>
 
+#include "vc/core/io/MappedFile.hpp"
 #include "vc/core/types/Exceptions.hpp"
 #include "vc/core/util/Iteration.hpp"
 #include "vc/core/util/String.hpp"
@@ -14,8 +18,95 @@ using namespace volcart::io;
 namespace fs = volcart::filesystem;
 namespace vio = volcart::io;
 
-void vio::WriteUVMap(const fs::path& path, const UVMap& uvMap)
+///// Binary file format /////
+// All values are stored in native byte order:
+//   BinaryHeader
+//   double uvs[length][2]: UVMap::as_vector(), indexed by vertex ID
+static constexpr std::array<char, 8> BINARY_MAGIC{'V', 'C', 'U', 'V',
+                                                  'M', 'B', '\r', '\n'};
+static constexpr uint32_t BINARY_VERSION{2};
+static_assert(sizeof(cv::Vec2d) == 2 * sizeof(double));
+
+namespace
+{
+struct BinaryHeader {
+    std::array<char, 8> magic{BINARY_MAGIC};
+    uint32_t version{BINARY_VERSION};
+    uint32_t origin{0};
+    double width{0};
+    double height{0};
+    // Number of mapped IDs
+    uint64_t count{0};
+    // Number of stored UVs, including those of unmapped IDs
+    uint64_t length{0};
+};
+}  // namespace
+
+static void WriteBinaryUVMap(const fs::path& path, const UVMap& uvMap)
+{
+    const auto& uvs = uvMap.as_vector();
+    BinaryHeader header;
+    header.origin = static_cast<uint32_t>(uvMap.origin());
+    header.width = uvMap.ratio().width;
+    header.height = uvMap.ratio().height;
+    header.count = uvMap.size();
+    header.length = uvs.size();
+
+    std::ofstream file{path.string(), std::ios::binary};
+    if (not file.is_open()) {
+        auto msg = "could not open file '" + path.string() + "'";
+        throw IOException(msg);
+    }
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(
+        reinterpret_cast<const char*>(uvs.data()),
+        static_cast<std::streamsize>(uvs.size() * sizeof(cv::Vec2d)));
+    if (file.fail()) {
+        throw IOException("Failed to write file: " + path.string());
+    }
+}
+
+static auto ReadBinaryUVMap(const MappedFile& file) -> UVMap
+{
+    BinaryHeader header;
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (header.version != BINARY_VERSION) {
+        auto msg = "Version mismatch. UVMap file version is " +
+                   std::to_string(header.version) + ", processing version is " +
+                   std::to_string(BINARY_VERSION) + ".";
+        throw IOException(msg);
+    }
+    if (header.origin > static_cast<uint32_t>(UVMap::Origin::BottomRight)) {
+        throw IOException("UVMap file contains an invalid origin");
+    }
+    if (header.width == 0 or header.height == 0) {
+        throw IOException("UVMap cannot have dimensions == 0");
+    }
+    // Compare the length with the UVs in the file, rather than their size
+    // with the file size, so that a corrupt length cannot overflow
+    auto available = (file.size() - sizeof(header)) / sizeof(cv::Vec2d);
+    if (header.length > available) {
+        throw IOException("UVMap file is truncated");
+    }
+    auto bytes = header.length * sizeof(cv::Vec2d);
+
+    UVMap map;
+    map.setOrigin(static_cast<UVMap::Origin>(header.origin));
+    map.ratio(header.width, header.height);
+    std::vector<cv::Vec2d> uvs(header.length);
+    std::memcpy(uvs.data(), file.data() + sizeof(header), bytes);
+    map.from_vector(std::move(uvs));
+    return map;
+}
+
+void vio::WriteUVMap(
+    const fs::path& path, const UVMap& uvMap, UVMapFormat format)
 {
+    if (format == UVMapFormat::Binary) {
+        WriteBinaryUVMap(path, uvMap);
+        return;
+    }
+
     std::ofstream outfile{path.string(), std::ios::binary};
     if (!outfile.is_open()) {
         auto msg = "could not open file '" + path.string() + "'";
@@ -35,9 +126,10 @@ void vio::WriteUVMap(const fs::path& path, const UVMap& uvMap)
     outfile << ss.rdbuf();
 
     // Write the mappings
-    for (const auto& mapping : uvMap.as_map()) {
-        const auto& id = mapping.first;
-        const auto& uv = mapping.second;
+    for (const auto& [id, uv] : enumerate(uvMap.as_vector())) {
+        if (uv == NULL_MAPPING) {
+            continue;
+        }
         outfile.write(reinterpret_cast<const char*>(&id), sizeof(id));
         auto nbytes = 2 * sizeof(double);
         outfile.write(reinterpret_cast<const char*>(uv.val), nbytes);
@@ -48,6 +140,15 @@ void vio::WriteUVMap(const fs::path& path, const UVMap& uvMap)
 
 auto vio::ReadUVMap(const fs::path& path) -> UVMap
 {
+    {
+        MappedFile file(path);
+        const auto& magic = BINARY_MAGIC;
+        if (file.size() >= sizeof(BinaryHeader) and
+            std::memcmp(file.data(), magic.data(), magic.size()) == 0) {
+            return ReadBinaryUVMap(file);
+        }
+    }
+
     std::ifstream infile{path.string(), std::ios::binary};
     if (!infile.is_open()) {
         auto msg = "could not open file '" + path.string() + "'";
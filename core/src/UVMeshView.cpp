@@ -0,0 +1,79 @@
+#include "vc/core/types/UVMeshView.hpp"
+
+#include "vc/core/util/ThreadPool.hpp"
+
+using namespace volcart;
+
+UVMeshView::UVMeshView(
+    ITKMesh::Pointer mesh, UVMap::Pointer uvMap, bool scaleToUVDimensions)
+    : mesh_{std::move(mesh)}, uvMap_{std::move(uvMap)}
+{
+    if (scaleToUVDimensions and uvMap_) {
+        scale_ = {uvMap_->ratio().width, uvMap_->ratio().height};
+    }
+}
+
+auto UVMeshView::valid() const -> bool { return mesh_ and uvMap_; }
+
+auto UVMeshView::numVertices() const -> std::size_t
+{
+    return mesh_->GetNumberOfPoints();
+}
+
+auto UVMeshView::numFaces() const -> std::size_t
+{
+    return mesh_->GetNumberOfCells();
+}
+
+auto UVMeshView::uv(std::size_t id) const -> cv::Vec2d
+{
+    auto uv = uvMap_->get(id);
+    return {uv[0] * scale_[0], uv[1] * scale_[1]};
+}
+
+auto UVMeshView::vertex(std::size_t id) const -> cv::Vec3d
+{
+    auto p = uv(id);
+    return {p[0], 0, p[1]};
+}
+
+auto UVMeshView::normal() -> cv::Vec3d { return {0, 1, 0}; }
+
+auto UVMeshView::face(std::size_t id) const -> Face
+{
+    const auto* ids = mesh_->GetCells()->ElementAt(id)->GetPointIds();
+    return {ids[0], ids[1], ids[2]};
+}
+
+auto UVMeshView::mesh() const -> ITKMesh::Pointer { return mesh_; }
+
+auto UVMeshView::uvMap() const -> UVMap::Pointer { return uvMap_; }
+
+auto UVMeshView::toITKMesh() const -> ITKMesh::Pointer
+{
+    auto out = ITKMesh::New();
+
+    // ITK only frees the cells when the last mesh holding the container
+    // releases it, so the container can be shared with the source mesh
+    out->SetCells(mesh_->GetCells());
+
+    const auto n = numVertices();
+    auto points = ITKPointsContainer::New();
+    auto& pts = points->CastToSTLContainer();
+    pts.resize(n);
+    auto pointData = ITKMesh::PointDataContainer::New();
+    auto& data = pointData->CastToSTLContainer();
+    data.resize(n, ITKPixel(normal().val));
+    ParallelChunks(n, 0, [&](auto begin, auto end) {
+        for (auto i = begin; i < end; ++i) {
+            auto v = vertex(i);
+            pts[i][0] = v[0];
+            pts[i][1] = v[1];
+            pts[i][2] = v[2];
+        }
+    });
+    out->SetPoints(points);
+    out->SetPointData(pointData);
+
+    return out;
+}
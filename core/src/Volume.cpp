@@ -1,17 +1,435 @@
 #include "vc/core/types/Volume.hpp"
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <future>
 #include <iomanip>
+#include <limits>
+#include <optional>
+#include <set>
 #include <sstream>
+#include <thread>
+#include <type_traits>
 
 #include <opencv2/imgcodecs.hpp>
 
 #include "vc/core/io/TIFFIO.hpp"
+#include "vc/core/util/Logging.hpp"
+#include "vc/core/util/MemorySizeStringParser.hpp"
+#include "vc/core/util/NUMA.hpp"
+#include "vc/core/util/Tracing.hpp"
 
 namespace fs = volcart::filesystem;
 namespace tio = volcart::tiffio;
 
 using namespace volcart;
 
+static const fs::path SUBPATH_BLOCKS{"blocks"};
+static const fs::path SUBPATH_LEVELS{"levels"};
+static const fs::path BLOCK_STATISTICS_FILE{"block_statistics.bin"};
+
+// Largest fraction of an uncached slice which interpolateAt decodes on its own
+// rather than loading the whole slice into the cache
+static constexpr double MAX_REGION_FRACTION = 0.25;
+
+// Maximum number of sample positions buffered by a batch reslice
+static constexpr size_t RESLICE_BATCH_SAMPLES = size_t{1} << 20;
+
+// Get a file name-safe key which identifies a volume in the disk cache
+static auto PathKey(const fs::path& path) -> std::string
+{
+    // FNV-1a, which is stable across processes and builds
+    std::uint64_t hash{14695981039346656037ULL};
+    for (auto c : fs::absolute(path).lexically_normal().string()) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 1099511628211ULL;
+    }
+    std::ostringstream ss;
+    ss << std::hex << std::setw(16) << std::setfill('0') << hash;
+    return ss.str();
+}
+
+// Read an optional metadata value
+template <typename T>
+static auto OptionalValue(const Metadata& m, const std::string& key)
+    -> std::optional<T>
+{
+    if (m.hasKey(key)) {
+        return m.get<T>(key);
+    }
+    return std::nullopt;
+}
+
+// Get a cached metadata value, or throw like Metadata::get() if it's unset
+template <typename T>
+static auto CachedValue(const std::optional<T>& value, const std::string& key)
+    -> const T&
+{
+    if (not value) {
+        auto msg = "could not find key '" + key + "' in metadata";
+        throw std::runtime_error(msg);
+    }
+    return *value;
+}
+
+// Get the disk cache key of a slice
+static auto SliceKey(int index) -> std::string
+{
+    return "s" + std::to_string(index);
+}
+
+static auto FormatToString(Volume::Format f) -> std::string
+{
+    switch (f) {
+        case Volume::Format::Slices:
+            return "slices";
+        case Volume::Format::Blocks:
+            return "blocks";
+        case Volume::Format::Zarr:
+            return "zarr";
+    }
+    throw std::invalid_argument("Unknown volume format");
+}
+
+// Downsample two adjacent slices into a single half-resolution slice
+static auto DownsampleSlices(
+    const cv::Mat& a, const cv::Mat& b, Volume::LevelFilter filter) -> cv::Mat
+{
+    cv::Mat fa;
+    cv::Mat fb;
+    a.convertTo(fa, CV_32F);
+    b.convertTo(fb, CV_32F);
+
+    auto w = (a.cols + 1) / 2;
+    auto h = (a.rows + 1) / 2;
+    cv::Mat out(h, w, CV_32FC1);
+    for (int y = 0; y < h; y++) {
+        std::array<int, 2> sy{2 * y, std::min(2 * y + 1, a.rows - 1)};
+        for (int x = 0; x < w; x++) {
+            std::array<int, 2> sx{2 * x, std::min(2 * x + 1, a.cols - 1)};
+            float sum{0};
+            float max{std::numeric_limits<float>::lowest()};
+            for (const auto& m : {fa, fb}) {
+                for (auto r : sy) {
+                    for (auto c : sx) {
+                        auto v = m.at<float>(r, c);
+                        sum += v;
+                        max = std::max(max, v);
+                    }
+                }
+            }
+            out.at<float>(y, x) =
+                (filter == Volume::LevelFilter::Mean) ? sum / 8.F : max;
+        }
+    }
+
+    cv::Mat result;
+    out.convertTo(result, a.type());
+    return result;
+}
+
+static auto FormatFromString(const std::string& s) -> Volume::Format
+{
+    if (s == "slices") {
+        return Volume::Format::Slices;
+    }
+    if (s == "blocks") {
+        return Volume::Format::Blocks;
+    }
+    if (s == "zarr") {
+        return Volume::Format::Zarr;
+    }
+    throw std::runtime_error("Unknown volume format: " + s);
+}
+
+static auto VoxelTypeToString(Volume::VoxelType t) -> std::string
+{
+    switch (t) {
+        case Volume::VoxelType::UInt8:
+            return "uint8";
+        case Volume::VoxelType::UInt16:
+            return "uint16";
+        case Volume::VoxelType::Float32:
+            return "float32";
+    }
+    throw std::invalid_argument("Unknown voxel type");
+}
+
+static auto VoxelTypeFromString(const std::string& s) -> Volume::VoxelType
+{
+    if (s == "uint8") {
+        return Volume::VoxelType::UInt8;
+    }
+    if (s == "uint16") {
+        return Volume::VoxelType::UInt16;
+    }
+    if (s == "float32") {
+        return Volume::VoxelType::Float32;
+    }
+    throw std::runtime_error("Unknown voxel type: " + s);
+}
+
+// OpenCV depth of the samples of a voxel type
+static auto VoxelDepth(Volume::VoxelType t) -> int
+{
+    switch (t) {
+        case Volume::VoxelType::UInt8:
+            return CV_8U;
+        case Volume::VoxelType::UInt16:
+            return CV_16U;
+        case Volume::VoxelType::Float32:
+            return CV_32F;
+    }
+    throw std::invalid_argument("Unknown voxel type");
+}
+
+// Loads slices into the Volume's cache on background threads
+class Volume::Prefetcher
+{
+public:
+    Prefetcher(const Volume* vol, size_t ahead, size_t behind, size_t threads)
+        : vol_{vol}, ahead_{ahead}, behind_{behind}
+    {
+        for (size_t i = 0; i < std::max<size_t>(threads, 1); i++) {
+            workers_.emplace_back(&Prefetcher::run_, this);
+        }
+    }
+
+    ~Prefetcher()
+    {
+        {
+            const std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        cv_.notify_all();
+        for (auto& w : workers_) {
+            w.join();
+        }
+
+        // Asynchronous reads call back into the prefetcher
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [this]() { return inflight_ == 0; });
+    }
+
+    // Schedule the window around a newly accessed slice
+    void notify(int index)
+    {
+        // Fast path: repeated access to the same slice
+        auto prev = last_.exchange(index);
+        if (prev == index) {
+            return;
+        }
+
+        {
+            const std::lock_guard<std::mutex> lock(mutex_);
+            if (prev >= 0) {
+                direction_ = (index > prev) ? 1 : -1;
+            }
+
+            queue_.clear();
+            auto schedule = [this](int i) {
+                if (i >= 0 and i < vol_->numSlices()) {
+                    queue_.push_back(i);
+                }
+            };
+            for (size_t i = 1; i <= ahead_; i++) {
+                schedule(index + direction_ * static_cast<int>(i));
+            }
+            for (size_t i = 1; i <= behind_; i++) {
+                schedule(index - direction_ * static_cast<int>(i));
+            }
+        }
+        cv_.notify_all();
+    }
+
+private:
+    // Maximum number of asynchronous reads in flight
+    size_t max_inflight_() const
+    {
+        if (vol_->async_reads_()) {
+            return vol_->asyncReader_->queueDepth();
+        }
+        return std::numeric_limits<size_t>::max();
+    }
+
+    void run_()
+    {
+        while (true) {
+            int index;
+            bool async;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                cv_.wait(lock, [this]() {
+                    return stop_ or
+                           (!queue_.empty() and inflight_ < max_inflight_());
+                });
+                if (stop_) {
+                    return;
+                }
+                index = queue_.front();
+                queue_.pop_front();
+
+                // Only issue reads, so that many slices are read at once
+                async = vol_->async_reads_();
+                if (async) {
+                    if (not loading_.insert(index).second) {
+                        continue;
+                    }
+                    inflight_++;
+                }
+            }
+
+            if (async) {
+                vol_->prefetch_slice_async_(index, [this, index]() {
+                    const std::lock_guard<std::mutex> lock(mutex_);
+                    loading_.erase(index);
+                    inflight_--;
+                    cv_.notify_all();
+                });
+                continue;
+            }
+
+            try {
+                vol_->prefetch_slice_(index);
+            } catch (const std::exception& e) {
+                Logger()->debug(
+                    "Failed to prefetch slice {}: {}", index, e.what());
+            }
+        }
+    }
+
+    const Volume* vol_;
+    size_t ahead_;
+    size_t behind_;
+    std::atomic<int> last_{-1};
+    int direction_{1};
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<int> queue_;
+    // Slices with an asynchronous read in flight
+    std::set<int> loading_;
+    size_t inflight_{0};
+    bool stop_{false};
+    std::vector<std::thread> workers_;
+};
+
+// Writes slices to disk on background threads
+class Volume::SliceWriter
+{
+public:
+    SliceWriter(Volume* vol, size_t maxBytes, size_t threads)
+        : vol_{vol}, maxBytes_{maxBytes}
+    {
+        for (size_t i = 0; i < std::max<size_t>(threads, 1); i++) {
+            workers_.emplace_back(&SliceWriter::run_, this);
+        }
+    }
+
+    // Finish the queued writes before stopping
+    ~SliceWriter()
+    {
+        {
+            const std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        workCv_.notify_all();
+        for (auto& w : workers_) {
+            w.join();
+        }
+    }
+
+    // Queue a slice, waiting for space if the memory limit is reached
+    void enqueue(int index, cv::Mat slice, bool compress)
+    {
+        auto bytes = slice.total() * slice.elemSize();
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            spaceCv_.wait(lock, [this, bytes]() {
+                return inFlight_ == 0 or inFlight_ + bytes <= maxBytes_;
+            });
+            rethrow_();
+            inFlight_ += bytes;
+            queue_.push_back({index, std::move(slice), compress, bytes});
+        }
+        workCv_.notify_one();
+    }
+
+    // Wait for the queued writes and rethrow the first error
+    void flush()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        spaceCv_.wait(lock, [this]() { return inFlight_ == 0; });
+        rethrow_();
+    }
+
+private:
+    struct Job {
+        int index{0};
+        cv::Mat slice;
+        bool compress{false};
+        size_t bytes{0};
+    };
+
+    // Rethrow and clear the stored error. Requires the lock.
+    void rethrow_()
+    {
+        if (error_) {
+            auto e = error_;
+            error_ = nullptr;
+            std::rethrow_exception(e);
+        }
+    }
+
+    void run_()
+    {
+        while (true) {
+            Job job;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                workCv_.wait(
+                    lock, [this]() { return stop_ or !queue_.empty(); });
+                if (queue_.empty()) {
+                    return;
+                }
+                job = std::move(queue_.front());
+                queue_.pop_front();
+            }
+
+            std::exception_ptr error;
+            try {
+                vol_->write_slice_(job.index, job.slice, job.compress);
+            } catch (...) {
+                error = std::current_exception();
+            }
+
+            {
+                const std::lock_guard<std::mutex> lock(mutex_);
+                if (error and not error_) {
+                    error_ = error;
+                }
+                inFlight_ -= job.bytes;
+            }
+            spaceCv_.notify_all();
+        }
+    }
+
+    Volume* vol_;
+    size_t maxBytes_;
+    size_t inFlight_{0};
+    std::mutex mutex_;
+    std::condition_variable workCv_;
+    std::condition_variable spaceCv_;
+    std::deque<Job> queue_;
+    std::exception_ptr error_;
+    bool stop_{false};
+    std::vector<std::thread> workers_;
+};
+
 // Load a Volume from disk
 Volume::Volume(fs::path path) : DiskBasedObjectBaseClass(std::move(path))
 {
@@ -23,6 +441,56 @@ Volume::Volume(fs::path path) : DiskBasedObjectBaseClass(std::move(path))
     height_ = metadata_.get<int>("height");
     slices_ = metadata_.get<int>("slices");
     numSliceCharacters_ = std::to_string(slices_).size();
+    setCache(ConcurrentCache::New(DEFAULT_CAPACITY));
+
+    // Keep typed copies of the properties which are read in hot paths
+    voxelSize_ = OptionalValue<double>(metadata_, "voxelsize");
+    min_ = OptionalValue<double>(metadata_, "min");
+    max_ = OptionalValue<double>(metadata_, "max");
+    statistics_ = OptionalValue<VolumeStatistics>(metadata_, "statistics");
+    cropSource_ = OptionalValue<Identifier>(metadata_, "cropSource");
+    cropOffset_ = OptionalValue<cv::Vec3i>(metadata_, "cropOffset");
+    storedLevels_ = OptionalValue<size_t>(metadata_, "levels").value_or(0);
+
+    // Volumes written before the format key was added are slice volumes
+    if (metadata_.hasKey("format")) {
+        format_ = FormatFromString(metadata_.get<std::string>("format"));
+    }
+    if (format_ == Format::Blocks) {
+        blockSize_ = metadata_.get<int>("blocksize");
+        blockShape_ = {blockSize_, blockSize_, blockSize_};
+    }
+    if (metadata_.hasKey("compression")) {
+        compression_ = tio::CompressionFromString(
+            metadata_.get<std::string>("compression"));
+    }
+    // Volumes written before the voxel type key was added are 16-bit
+    if (metadata_.hasKey("voxeltype")) {
+        voxelType_ =
+            VoxelTypeFromString(metadata_.get<std::string>("voxeltype"));
+    }
+
+    // The slice files of this volume are stored elsewhere
+    if (metadata_.hasKey("source")) {
+        source_ = io::VolumeSource::Open(
+            metadata_.get<std::string>("source"), path_);
+    }
+
+    // Zarr arrays are read through a source, which defaults to the volume
+    // directory. The array's own shape replaces the metadata dimensions.
+    // Its chunks are scaled to 16 bits.
+    if (format_ == Format::Zarr) {
+        voxelType_ = VoxelType::UInt16;
+        if (not source_) {
+            source_ = io::LocalVolumeSource::New(path_);
+        }
+        std::string group;
+        if (metadata_.hasKey("zarrpath")) {
+            group = metadata_.get<std::string>("zarrpath");
+        }
+        zarrArrays_ = io::ZarrArray::MultiscaleArrays(*source_, group);
+        open_zarr_(0);
+    }
 }
 
 // Setup a Volume from a folder of slices
@@ -34,9 +502,26 @@ Volume::Volume(fs::path path, std::string uuid, std::string name)
     metadata_.set("width", width_);
     metadata_.set("height", height_);
     metadata_.set("slices", slices_);
-    metadata_.set("voxelsize", double{});
-    metadata_.set("min", double{});
-    metadata_.set("max", double{});
+    setVoxelSize(double{});
+    setMin(double{});
+    setMax(double{});
+    metadata_.set("format", FormatToString(format_));
+    metadata_.set("voxeltype", VoxelTypeToString(voxelType_));
+    setCache(ConcurrentCache::New(DEFAULT_CAPACITY));
+}
+
+// Stop the background threads before the cache is destroyed
+Volume::~Volume()
+{
+    if (writer_) {
+        try {
+            writer_->flush();
+        } catch (const std::exception& e) {
+            Logger()->error("Failed to write slice: {}", e.what());
+        }
+        writer_.reset();
+    }
+    prefetcher_.reset();
 }
 
 // Load a Volume from disk, return a pointer
@@ -54,9 +539,32 @@ Volume::Pointer Volume::New(fs::path path, std::string uuid, std::string name)
 int Volume::sliceWidth() const { return width_; }
 int Volume::sliceHeight() const { return height_; }
 int Volume::numSlices() const { return slices_; }
-double Volume::voxelSize() const { return metadata_.get<double>("voxelsize"); }
-double Volume::min() const { return metadata_.get<double>("min"); }
-double Volume::max() const { return metadata_.get<double>("max"); }
+double Volume::voxelSize() const
+{
+    return CachedValue(voxelSize_, "voxelsize");
+}
+double Volume::min() const { return CachedValue(min_, "min"); }
+double Volume::max() const { return CachedValue(max_, "max"); }
+Volume::Format Volume::format() const { return format_; }
+int Volume::blockSize() const { return blockSize_; }
+
+cv::Vec3i Volume::blockShape() const { return blockShape_; }
+
+tio::Compression Volume::compression() const { return compression_; }
+
+Volume::VoxelType Volume::voxelType() const { return voxelType_; }
+
+bool Volume::blocked_() const { return format_ != Format::Slices; }
+
+void Volume::open_zarr_(size_t n)
+{
+    zarr_ = io::ZarrArray::New(source_, zarrArrays_.at(n));
+    auto shape = zarr_->shape();
+    width_ = shape[0];
+    height_ = shape[1];
+    slices_ = shape[2];
+    blockShape_ = zarr_->chunkShape();
+}
 
 void Volume::setSliceWidth(int w)
 {
@@ -77,9 +585,181 @@ void Volume::setNumberOfSlices(size_t numSlices)
     metadata_.set("slices", numSlices);
 }
 
-void Volume::setVoxelSize(double s) { metadata_.set("voxelsize", s); }
-void Volume::setMin(double m) { metadata_.set("min", m); }
-void Volume::setMax(double m) { metadata_.set("max", m); }
+void Volume::setVoxelSize(double s)
+{
+    voxelSize_ = s;
+    metadata_.set("voxelsize", s);
+}
+
+void Volume::setMin(double m)
+{
+    min_ = m;
+    metadata_.set("min", m);
+}
+
+void Volume::setMax(double m)
+{
+    max_ = m;
+    metadata_.set("max", m);
+}
+
+bool Volume::hasStatistics() const { return statistics_.has_value(); }
+
+VolumeStatistics Volume::statistics() const
+{
+    return CachedValue(statistics_, "statistics");
+}
+
+void Volume::setStatistics(const VolumeStatistics& s)
+{
+    statistics_ = s;
+    metadata_.set("statistics", s);
+}
+
+bool Volume::hasBlockStatistics() const { return blockStatistics() != nullptr; }
+
+std::shared_ptr<const VolumeBlockStatistics> Volume::blockStatistics() const
+{
+    const std::lock_guard<std::mutex> lock(blockStatsMutex_);
+    if (blockStatsRead_) {
+        return blockStats_;
+    }
+    blockStatsRead_ = true;
+
+    auto path = path_ / BLOCK_STATISTICS_FILE;
+    if (not fs::exists(path)) {
+        return nullptr;
+    }
+    try {
+        auto s = VolumeBlockStatistics::Read(path);
+        if (s.volumeShape() != cv::Vec3i{width_, height_, slices_}) {
+            Logger()->warn(
+                "Ignoring block statistics which do not match volume {}",
+                id());
+            return nullptr;
+        }
+        blockStats_ =
+            std::make_shared<const VolumeBlockStatistics>(std::move(s));
+    } catch (const std::exception& e) {
+        Logger()->warn("Failed to read block statistics: {}", e.what());
+    }
+    return blockStats_;
+}
+
+void Volume::setBlockStatistics(const VolumeBlockStatistics& s)
+{
+    if (s.volumeShape() != cv::Vec3i{width_, height_, slices_}) {
+        throw std::invalid_argument(
+            "Block statistics do not match volume dimensions");
+    }
+    s.write(path_ / BLOCK_STATISTICS_FILE);
+
+    const std::lock_guard<std::mutex> lock(blockStatsMutex_);
+    blockStats_ = std::make_shared<const VolumeBlockStatistics>(s);
+    blockStatsRead_ = true;
+}
+
+std::shared_ptr<const VolumeBlockStatistics> Volume::fill_statistics_() const
+{
+    if (voxelType_ != VoxelType::UInt16) {
+        return nullptr;
+    }
+    auto s = blockStatistics();
+    if (not s or blockShape_ != cv::Vec3i::all(s->blockSize())) {
+        return nullptr;
+    }
+    return s;
+}
+
+void Volume::clear_block_statistics_()
+{
+    const std::lock_guard<std::mutex> lock(blockStatsMutex_);
+    if (blockStatsRead_ and not blockStats_) {
+        return;
+    }
+    blockStats_.reset();
+    blockStatsRead_ = true;
+    auto path = path_ / BLOCK_STATISTICS_FILE;
+    if (fs::exists(path)) {
+        fs::remove(path);
+    }
+}
+
+bool Volume::hasCropOrigin() const { return cropSource_.has_value(); }
+
+Volume::Identifier Volume::cropSourceID() const
+{
+    return CachedValue(cropSource_, "cropSource");
+}
+
+cv::Vec3i Volume::cropOffset() const
+{
+    return CachedValue(cropOffset_, "cropOffset");
+}
+
+void Volume::setCropOrigin(const Identifier& sourceID, const cv::Vec3i& offset)
+{
+    cropSource_ = sourceID;
+    cropOffset_ = offset;
+    metadata_.set("cropSource", sourceID);
+    metadata_.set("cropOffset", offset);
+}
+
+void Volume::setFormat(Format f, int blockSize)
+{
+    if (f == Format::Blocks and blockSize <= 0) {
+        throw std::invalid_argument("Block size must be greater than zero");
+    }
+    if (f == Format::Zarr) {
+        throw std::invalid_argument("Zarr volumes are read-only");
+    }
+    format_ = f;
+    metadata_.set("format", FormatToString(f));
+    if (f == Format::Blocks) {
+        blockSize_ = blockSize;
+        blockShape_ = {blockSize, blockSize, blockSize};
+        metadata_.set("blocksize", blockSize);
+    }
+}
+
+void Volume::setCompression(tio::Compression c)
+{
+    if (not tio::CompressionAvailable(c)) {
+        throw std::invalid_argument(
+            "TIFF compression is not supported by libtiff: " +
+            tio::CompressionToString(c));
+    }
+    compression_ = c;
+    metadata_.set("compression", tio::CompressionToString(c));
+}
+
+void Volume::setVoxelType(VoxelType t)
+{
+    if (format_ == Format::Zarr and t != VoxelType::UInt16) {
+        throw std::invalid_argument("Zarr volumes are 16-bit");
+    }
+    voxelType_ = t;
+    metadata_.set("voxeltype", VoxelTypeToString(t));
+}
+
+cv::Mat Volume::conform_(cv::Mat m) const
+{
+    auto depth = VoxelDepth(voxelType_);
+    if (m.empty() or m.depth() == depth) {
+        return m;
+    }
+
+    // Scale between the ranges of 8-bit and 16-bit samples
+    double scale{1};
+    if (m.depth() == CV_8U and depth == CV_16U) {
+        scale = 257;
+    } else if (m.depth() == CV_16U and depth == CV_8U) {
+        scale = 1.0 / 257;
+    }
+    cv::Mat out;
+    m.convertTo(out, depth, scale);
+    return out;
+}
 
 Volume::Bounds Volume::bounds() const
 {
@@ -101,16 +781,68 @@ bool Volume::isInBounds(const cv::Vec3d& v) const
 }
 
 fs::path Volume::getSlicePath(int index) const
+{
+    return path_ / slice_name_(index);
+}
+
+fs::path Volume::getBlockPath(int bx, int by, int bz) const
+{
+    return path_ / block_name_(bx, by, bz);
+}
+
+std::string Volume::slice_name_(int index) const
 {
     std::stringstream ss;
     ss << std::setw(numSliceCharacters_) << std::setfill('0') << index
        << ".tif";
-    return path_ / ss.str();
+    return ss.str();
+}
+
+std::string Volume::block_name_(int bx, int by, int bz) const
+{
+    std::stringstream ss;
+    ss << SUBPATH_BLOCKS.string() << "/" << bz << "_" << by << "_" << bx
+       << ".tif";
+    return ss.str();
+}
+
+cv::Vec3i Volume::blockGridSize() const
+{
+    return {
+        (width_ + blockShape_[0] - 1) / blockShape_[0],
+        (height_ + blockShape_[1] - 1) / blockShape_[1],
+        (slices_ + blockShape_[2] - 1) / blockShape_[2]};
+}
+
+cv::Mat Volume::getBlockData(int bx, int by, int bz) const
+{
+    if (not blocked_()) {
+        throw std::logic_error("Volume is not stored in blocks");
+    }
+
+    auto grid = blockGridSize();
+    if (bx < 0 or bx >= grid[0] or by < 0 or by >= grid[1] or bz < 0 or
+        bz >= grid[2]) {
+        throw std::out_of_range("Block position outside of volume");
+    }
+
+    if (cacheSlices_) {
+        return cache_block_(bx, by, bz);
+    } else {
+        return load_block_(bx, by, bz);
+    }
 }
 
 cv::Mat Volume::getSliceData(int index) const
 {
+    if (blocked_()) {
+        return assemble_slice_(index, {0, 0, width_, height_});
+    }
+
     if (cacheSlices_) {
+        if (prefetcher_) {
+            prefetcher_->notify(index);
+        }
         return cache_slice_(index);
     } else {
         return load_slice_(index);
@@ -122,98 +854,1493 @@ cv::Mat Volume::getSliceDataCopy(int index) const
     return getSliceData(index).clone();
 }
 
-void Volume::setSliceData(int index, const cv::Mat& slice, bool compress)
+SliceView Volume::getSliceView(int index) const
 {
-    auto slicePath = getSlicePath(index);
-    tio::WriteTIFF(
-        slicePath.string(), slice,
-        (compress) ? tiffio::Compression::LZW : tiffio::Compression::NONE);
+    return SliceView(getSliceData(index));
 }
 
-uint16_t Volume::intensityAt(int x, int y, int z) const
+cv::Mat Volume::getSliceRegion(int index, const cv::Rect& roi) const
 {
-    // clang-format off
-    if (x < 0 || x >= sliceWidth() ||
-        y < 0 || y >= sliceHeight() ||
-        z < 0 || z >= numSlices()) {
-        return 0;
+    if (index < 0 or index >= slices_) {
+        throw std::out_of_range("Slice index outside of volume");
     }
-    // clang-format on
-    return getSliceData(z).at<uint16_t>(y, x);
-}
 
-// Trilinear Interpolation
-// From: https://en.wikipedia.org/wiki/Trilinear_interpolation
-uint16_t Volume::interpolateAt(double x, double y, double z) const
-{
-    // insert safety net
-    if (!isInBounds(x, y, z)) {
-        return 0;
+    auto r = roi & cv::Rect(0, 0, width_, height_);
+    if (blocked_()) {
+        return assemble_slice_(index, r);
     }
 
-    double intPart;
-    double dx = std::modf(x, &intPart);
-    auto x0 = static_cast<int>(intPart);
-    int x1 = x0 + 1;
-    double dy = std::modf(y, &intPart);
-    auto y0 = static_cast<int>(intPart);
-    int y1 = y0 + 1;
-    double dz = std::modf(z, &intPart);
-    auto z0 = static_cast<int>(intPart);
-    int z1 = z0 + 1;
-
-    auto c00 =
-        intensityAt(x0, y0, z0) * (1 - dx) + intensityAt(x1, y0, z0) * dx;
-    auto c10 =
-        intensityAt(x0, y1, z0) * (1 - dx) + intensityAt(x1, y0, z0) * dx;
-    auto c01 =
-        intensityAt(x0, y0, z1) * (1 - dx) + intensityAt(x1, y0, z1) * dx;
-    auto c11 =
-        intensityAt(x0, y1, z1) * (1 - dx) + intensityAt(x1, y1, z1) * dx;
-
-    auto c0 = c00 * (1 - dy) + c10 * dy;
-    auto c1 = c01 * (1 - dy) + c11 * dy;
-
-    auto c = c0 * (1 - dz) + c1 * dz;
-    return static_cast<uint16_t>(cvRound(c));
+    if (cacheSlices_) {
+        auto cached = cached_slice_(index);
+        if (not cached.empty()) {
+            return cached(r).clone();
+        }
+    }
+    return load_slice_region_(index, r);
 }
 
-Reslice Volume::reslice(
-    const cv::Vec3d& center,
-    const cv::Vec3d& xvec,
-    const cv::Vec3d& yvec,
-    int width,
-    int height) const
+void Volume::setSliceData(int index, const cv::Mat& slice, bool compress)
 {
-    auto xnorm = cv::normalize(xvec);
-    auto ynorm = cv::normalize(yvec);
-    auto origin = center - ((width / 2) * xnorm + (height / 2) * ynorm);
-
-    cv::Mat m(height, width, CV_16UC1);
-    for (int h = 0; h < height; ++h) {
-        for (int w = 0; w < width; ++w) {
-            m.at<uint16_t>(h, w) =
-                interpolateAt(origin + (h * ynorm) + (w * xnorm));
-        }
+    if (source_) {
+        throw std::logic_error("Cannot write to a volume with a source");
     }
-
-    return Reslice(m, origin, xnorm, ynorm);
+    clear_block_statistics_();
+    if (writer_) {
+        writer_->enqueue(index, slice.clone(), compress);
+        return;
+    }
+    write_slice_(index, slice, compress);
 }
 
-cv::Mat Volume::load_slice_(int index) const
+void Volume::write_slice_(int index, const cv::Mat& slice, bool compress)
 {
+    if (format_ == Format::Blocks) {
+        write_slice_to_blocks_(index, slice, compress);
+        return;
+    }
+
     auto slicePath = getSlicePath(index);
-    return cv::imread(slicePath.string(), -1);
+    tio::WriteTIFF(
+        slicePath.string(), slice,
+        (compress) ? compression_ : tiffio::Compression::NONE);
 }
 
-cv::Mat Volume::cache_slice_(int index) const
+namespace
 {
-    const std::lock_guard<std::mutex> lock(cacheMutex_);
-    if (cache_->contains(index)) {
-        return cache_->get(index);
+// Interpolation kernels. A kernel weighs the TAPS voxels along each axis
+// which start LO voxels before the base voxel of a position. If CLAMP is set,
+// voxels past the edge of the volume repeat the edge voxels. Otherwise, they
+// are 0.
+
+// The voxel at the rounded position
+struct NearestKernel {
+    static constexpr int TAPS{1};
+    static constexpr int LO{0};
+    static constexpr bool CLAMP{false};
+    static auto Contains(double c, int size) -> bool
+    {
+        return c >= -0.5 and c < size - 0.5;
+    }
+    static auto Base(double c) -> int
+    {
+        return static_cast<int>(std::floor(c + 0.5));
+    }
+    static void Weights(double /*t*/, std::array<double, TAPS>& w)
+    {
+        w[0] = 1;
+    }
+};
+
+// Linear interpolation between the voxels on either side of a position
+struct TrilinearKernel {
+    static constexpr int TAPS{2};
+    static constexpr int LO{0};
+    static constexpr bool CLAMP{false};
+    static auto Contains(double c, int size) -> bool
+    {
+        return c >= 0 and c < size;
+    }
+    static auto Base(double c) -> int
+    {
+        return static_cast<int>(std::floor(c));
+    }
+    static void Weights(double t, std::array<double, TAPS>& w)
+    {
+        w[0] = 1 - t;
+        w[1] = t;
+    }
+};
+
+// Catmull-Rom spline through the two voxels on either side of a position
+struct TricubicKernel {
+    static constexpr int TAPS{4};
+    static constexpr int LO{1};
+    static constexpr bool CLAMP{true};
+    static auto Contains(double c, int size) -> bool
+    {
+        return c >= 0 and c < size;
+    }
+    static auto Base(double c) -> int
+    {
+        return static_cast<int>(std::floor(c));
+    }
+    static void Weights(double t, std::array<double, TAPS>& w)
+    {
+        w[0] = ((2 - t) * t - 1) * t / 2;
+        w[1] = ((3 * t - 5) * t * t + 2) / 2;
+        w[2] = ((4 - 3 * t) * t + 1) * t / 2;
+        w[3] = (t - 1) * t * t / 2;
+    }
+};
+
+// Interpolate the voxels around p, where voxel(x, y, z) gets a voxel of a
+// volume with dimensions `size`. Positions outside of the volume are 0.
+template <class K, class VoxelFn>
+auto Interpolate(const cv::Vec3d& p, const cv::Vec3i& size, VoxelFn&& voxel)
+    -> double
+{
+    std::array<int, 3> base{};
+    std::array<std::array<double, K::TAPS>, 3> w{};
+    for (int a = 0; a < 3; a++) {
+        if (not K::Contains(p[a], size[a])) {
+            return 0;
+        }
+        base[a] = K::Base(p[a]);
+        K::Weights(p[a] - base[a], w[a]);
+    }
+    auto tap = [&](int a, int t) {
+        auto c = base[a] + t - K::LO;
+        return K::CLAMP ? std::clamp(c, 0, size[a] - 1) : c;
+    };
+
+    double c{0};
+    for (int k = 0; k < K::TAPS; k++) {
+        auto z = tap(2, k);
+        double cz{0};
+        for (int j = 0; j < K::TAPS; j++) {
+            auto y = tap(1, j);
+            double cy{0};
+            for (int i = 0; i < K::TAPS; i++) {
+                cy += voxel(tap(0, i), y, z) * w[0][i];
+            }
+            cz += cy * w[1][j];
+        }
+        c += cz * w[2][k];
+    }
+    return c;
+}
+
+// Call f with a value of the kernel type of an interpolation method
+template <class F>
+void VisitKernel(Volume::Interpolation method, F&& f)
+{
+    switch (method) {
+        case Volume::Interpolation::Nearest:
+            f(NearestKernel{});
+            return;
+        case Volume::Interpolation::Trilinear:
+            f(TrilinearKernel{});
+            return;
+        case Volume::Interpolation::Tricubic:
+            f(TricubicKernel{});
+            return;
+    }
+    throw std::invalid_argument("Unknown interpolation method");
+}
+
+// Call f with a value of the sample type of a voxel type
+template <class F>
+void VisitVoxelType(Volume::VoxelType t, F&& f)
+{
+    switch (t) {
+        case Volume::VoxelType::UInt8:
+            f(uint8_t{});
+            return;
+        case Volume::VoxelType::UInt16:
+            f(uint16_t{});
+            return;
+        case Volume::VoxelType::Float32:
+            f(float{});
+            return;
+    }
+    throw std::invalid_argument("Unknown voxel type");
+}
+
+// Convert a value in the units of voxel type T to an output value. 8-bit
+// values are scaled to the range of uint16_t outputs.
+template <typename T, typename TOut>
+auto ToOutput(double v) -> TOut
+{
+    if constexpr (std::is_same_v<TOut, float>) {
+        return static_cast<float>(v);
+    } else if constexpr (std::is_same_v<T, uint8_t>) {
+        return cv::saturate_cast<TOut>(v * 257);
+    } else {
+        return cv::saturate_cast<TOut>(v);
+    }
+}
+}  // namespace
+
+template <typename T>
+T Volume::voxel_(int x, int y, int z) const
+{
+    // clang-format off
+    if (x < 0 || x >= width_ ||
+        y < 0 || y >= height_ ||
+        z < 0 || z >= slices_) {
+        return 0;
+    }
+    // clang-format on
+    if (blocked_()) {
+        const auto& bs = blockShape_;
+        auto block = getBlockData(x / bs[0], y / bs[1], z / bs[2]);
+        return block.at<T>((z % bs[2]) * bs[1] + (y % bs[1]), x % bs[0]);
+    }
+    return getSliceData(z).at<T>(y, x);
+}
+
+uint16_t Volume::intensityAt(int x, int y, int z) const
+{
+    uint16_t value{0};
+    VisitVoxelType(voxelType_, [&](auto t) {
+        using T = decltype(t);
+        value = ToOutput<T, uint16_t>(voxel_<T>(x, y, z));
+    });
+    return value;
+}
+
+uint16_t Volume::interpolateAt(double x, double y, double z) const
+{
+    return interpolateAt(cv::Vec3d{x, y, z}, Interpolation::Trilinear);
+}
+
+template <class K, typename T, typename TOut>
+void Volume::interpolate_batch_(
+    const cv::Vec3d* pts, size_t n, TOut* out) const
+{
+    const cv::Vec3i size{width_, height_, slices_};
+
+    // Blocks are cached near each other, so no grouping is needed
+    if (blocked_()) {
+        auto voxel = [this](int x, int y, int z) { return voxel_<T>(x, y, z); };
+        for (size_t i = 0; i < n; i++) {
+            out[i] = ToOutput<T, TOut>(Interpolate<K>(pts[i], size, voxel));
+        }
+        return;
+    }
+
+    // Group the in-bounds samples by base slice index. This is called once
+    // per pixel by the texturing algorithms, so the grouping buffers are
+    // reused between calls.
+    thread_local std::vector<int> z0sBuffer;
+    thread_local std::vector<size_t> orderBuffer;
+    auto& z0s = z0sBuffer;
+    auto& order = orderBuffer;
+    z0s.resize(n);
+    order.clear();
+    for (size_t i = 0; i < n; i++) {
+        const auto& p = pts[i];
+        if (K::Contains(p[0], width_) and K::Contains(p[1], height_) and
+            K::Contains(p[2], slices_)) {
+            z0s[i] = K::Base(p[2]);
+            order.push_back(i);
+        } else {
+            out[i] = 0;
+        }
+    }
+    // Ties are broken by index, which keeps the order stable without the
+    // temporary buffer used by std::stable_sort
+    std::sort(order.begin(), order.end(), [&z0s](auto a, auto b) {
+        return z0s[a] < z0s[b] or (z0s[a] == z0s[b] and a < b);
+    });
+
+    // Interpolate each group from a single fetch of each of its slices
+    std::array<cv::Mat, K::TAPS> slices;
+    std::array<cv::Point, K::TAPS> offsets;
+    auto it = order.begin();
+    while (it != order.end()) {
+        auto z0 = z0s[*it];
+        auto groupEnd = std::find_if(
+            it, order.end(), [&z0s, z0](auto i) { return z0s[i] != z0; });
+
+        // Region of the slices covered by the group's samples
+        auto minX = width_;
+        auto minY = height_;
+        auto maxX = 0;
+        auto maxY = 0;
+        for (auto g = it; g != groupEnd; g++) {
+            auto x = K::Base(pts[*g][0]);
+            auto y = K::Base(pts[*g][1]);
+            minX = std::min(minX, x);
+            minY = std::min(minY, y);
+            maxX = std::max(maxX, x);
+            maxY = std::max(maxY, y);
+        }
+        cv::Rect region(
+            minX - K::LO, minY - K::LO, maxX - minX + K::TAPS,
+            maxY - minY + K::TAPS);
+
+        // Slice `first + k` is slices[k]
+        const auto first = z0 - K::LO;
+        for (int k = 0; k < K::TAPS; k++) {
+            auto z = first + k;
+            slices[k] = (z >= 0 and z < slices_)
+                            ? sample_slice_(z, region, offsets[k])
+                            : cv::Mat();
+        }
+        auto voxel = [&](int x, int y, int z) -> double {
+            const auto& s = slices[z - first];
+            const auto& o = offsets[z - first];
+            auto sx = x - o.x;
+            auto sy = y - o.y;
+            if (s.empty() or sx < 0 or sy < 0 or sx >= s.cols or
+                sy >= s.rows) {
+                return 0;
+            }
+            return s.ptr<T>(sy)[sx];
+        };
+
+        for (; it != groupEnd; it++) {
+            out[*it] = ToOutput<T, TOut>(Interpolate<K>(pts[*it], size, voxel));
+        }
+    }
+}
+
+uint16_t Volume::interpolateAt(const cv::Vec3d& v, Interpolation method) const
+{
+    const cv::Vec3i size{width_, height_, slices_};
+    uint16_t value{0};
+    VisitVoxelType(voxelType_, [&](auto t) {
+        using T = decltype(t);
+        auto voxel = [this](int x, int y, int z) { return voxel_<T>(x, y, z); };
+        VisitKernel(method, [&](auto k) {
+            using K = decltype(k);
+            value = ToOutput<T, uint16_t>(Interpolate<K>(v, size, voxel));
+        });
+    });
+    return value;
+}
+
+void Volume::interpolateAt(const cv::Vec3d* pts, size_t n, uint16_t* out) const
+{
+    interpolateAt(pts, n, out, Interpolation::Trilinear);
+}
+
+void Volume::interpolateAt(
+    const cv::Vec3d* pts, size_t n, uint16_t* out, Interpolation method) const
+{
+    VisitVoxelType(voxelType_, [&](auto t) {
+        VisitKernel(method, [&](auto k) {
+            interpolate_batch_<decltype(k), decltype(t)>(pts, n, out);
+        });
+    });
+}
+
+void Volume::interpolateAt(
+    const cv::Vec3d* pts, size_t n, float* out, Interpolation method) const
+{
+    VisitVoxelType(voxelType_, [&](auto t) {
+        VisitKernel(method, [&](auto k) {
+            interpolate_batch_<decltype(k), decltype(t)>(pts, n, out);
+        });
+    });
+}
+
+void Volume::copyLattice(
+    const cv::Vec3i& origin,
+    const std::array<cv::Vec3i, 3>& steps,
+    const std::array<size_t, 3>& extent,
+    uint16_t* out) const
+{
+    // Keep a reference to the most recently used slice
+    int lastZ{-1};
+    cv::Mat slice;
+    auto getSlice = [&](int z) -> const cv::Mat& {
+        if (z != lastZ) {
+            slice = getSliceData(z);
+            lastZ = z;
+        }
+        return slice;
+    };
+
+    // Dispatch on the voxel type once for the whole lattice
+    VisitVoxelType(voxelType_, [&](auto t) {
+        using T = decltype(t);
+        auto convert = [](T v) { return ToOutput<T, uint16_t>(v); };
+        const auto& step = steps[2];
+        const auto rowLen = static_cast<int>(extent[2]);
+        for (size_t k = 0; k < extent[0]; k++) {
+            for (size_t j = 0; j < extent[1]; j++) {
+                cv::Vec3i p = origin + static_cast<int>(k) * steps[0] +
+                              static_cast<int>(j) * steps[1];
+                auto* row = out + (k * extent[1] + j) * extent[2];
+
+                // Contiguous row of a single slice
+                if (format_ == Format::Slices and step == cv::Vec3i(1, 0, 0)) {
+                    std::fill_n(row, rowLen, uint16_t{0});
+                    if (p[1] < 0 or p[1] >= height_ or p[2] < 0 or
+                        p[2] >= slices_) {
+                        continue;
+                    }
+                    auto begin = std::max(0, -p[0]);
+                    auto end = std::min(rowLen, width_ - p[0]);
+                    if (begin < end) {
+                        const auto* src = getSlice(p[2]).ptr<T>(p[1]) + p[0];
+                        std::transform(
+                            src + begin, src + end, row + begin, convert);
+                    }
+                    continue;
+                }
+
+                // Strided row
+                for (int i = 0; i < rowLen; i++, p += step) {
+                    if (not isInBounds(p[0], p[1], p[2])) {
+                        row[i] = 0;
+                    } else if (blocked_()) {
+                        row[i] = convert(voxel_<T>(p[0], p[1], p[2]));
+                    } else {
+                        row[i] = convert(getSlice(p[2]).at<T>(p[1], p[0]));
+                    }
+                }
+            }
+        }
+    });
+}
+
+Reslice Volume::reslice(
+    const cv::Vec3d& center,
+    const cv::Vec3d& xvec,
+    const cv::Vec3d& yvec,
+    int width,
+    int height) const
+{
+    const std::vector<ResliceFrame> frames{{center, xvec, yvec}};
+    return std::move(reslice(frames, width, height).front());
+}
+
+void Volume::reslice(
+    const ResliceFrame* frames,
+    size_t n,
+    int width,
+    int height,
+    uint16_t* out) const
+{
+    if (width <= 0 or height <= 0 or n == 0) {
+        return;
+    }
+
+    // Interpolate as many frames at once as fit in the position buffer, so
+    // that large batches use a bounded amount of memory
+    const auto frameSize = static_cast<size_t>(width) * height;
+    const auto perPass = std::max<size_t>(1, RESLICE_BATCH_SAMPLES / frameSize);
+    thread_local std::vector<cv::Vec3d> ptsBuffer;
+    auto& pts = ptsBuffer;
+    for (size_t first = 0; first < n; first += perPass) {
+        auto last = std::min(n, first + perPass);
+        pts.resize((last - first) * frameSize);
+        auto* p = pts.data();
+        for (auto f = first; f < last; f++) {
+            auto xnorm = cv::normalize(frames[f].xvec);
+            auto ynorm = cv::normalize(frames[f].yvec);
+            auto origin = frames[f].center -
+                          ((width / 2) * xnorm + (height / 2) * ynorm);
+
+            // Step along each row rather than recomputing every position
+            for (int h = 0; h < height; h++) {
+                cv::Vec3d pos = origin + h * ynorm;
+                for (int w = 0; w < width; w++, pos += xnorm) {
+                    *p++ = pos;
+                }
+            }
+        }
+        interpolateAt(pts.data(), pts.size(), out + first * frameSize);
+    }
+}
+
+std::vector<Reslice> Volume::reslice(
+    const std::vector<ResliceFrame>& frames, int width, int height) const
+{
+    cv::Mat m(static_cast<int>(frames.size()) * height, width, CV_16UC1);
+    reslice(frames.data(), frames.size(), width, height, m.ptr<uint16_t>());
+
+    std::vector<Reslice> reslices;
+    reslices.reserve(frames.size());
+    for (size_t f = 0; f < frames.size(); f++) {
+        auto xnorm = cv::normalize(frames[f].xvec);
+        auto ynorm = cv::normalize(frames[f].yvec);
+        auto origin =
+            frames[f].center - ((width / 2) * xnorm + (height / 2) * ynorm);
+        auto row = static_cast<int>(f) * height;
+        reslices.emplace_back(
+            m.rowRange(row, row + height), origin, xnorm, ynorm);
+    }
+    return reslices;
+}
+
+void Volume::setCache(SliceCache::Pointer c)
+{
+    cache_ = std::move(c);
+    concurrentCache_ = dynamic_cast<ConcurrentCache*>(cache_.get());
+    sharedCache_ = dynamic_cast<SharedSliceCacheView*>(cache_.get());
+    resetCacheStats();
+    register_cache_memory_();
+}
+
+void Volume::setCache(const SharedSliceCache::Pointer& c)
+{
+    setCache(SharedSliceCacheView::New(c));
+}
+
+// Number of bytes stored by a cache with a capacity in bytes. 0 for other
+// caches.
+template <typename TByteLRU, typename TByteTwoQ, typename TCache>
+static auto StoredBytes(const std::shared_ptr<TCache>& c) -> size_t
+{
+    if (auto lru = std::dynamic_pointer_cast<TByteLRU>(c)) {
+        return lru->bytes();
+    }
+    if (auto twoQ = std::dynamic_pointer_cast<TByteTwoQ>(c)) {
+        return twoQ->usage();
+    }
+    return 0;
+}
+
+// Whether a cache has a capacity in bytes
+static auto IsByteCache(const Volume::SliceCache::Pointer& c) -> bool
+{
+    return std::dynamic_pointer_cast<Volume::ByteCache>(c) or
+           std::dynamic_pointer_cast<Volume::TwoQByteCache>(c);
+}
+
+// Whether a cache uses a replacement policy
+static auto HasPolicy(
+    const Volume::SliceCache::Pointer& c, Volume::CachePolicy policy) -> bool
+{
+    auto twoQ = std::dynamic_pointer_cast<Volume::TwoQByteCache>(c) or
+                std::dynamic_pointer_cast<Volume::TwoQSliceCache>(c);
+    return twoQ == (policy == Volume::CachePolicy::TwoQ);
+}
+
+Volume::SharedSliceCache::Pointer Volume::NewSharedCache(
+    size_t nbytes, size_t numShards, CachePolicy policy)
+{
+    if (policy == CachePolicy::TwoQ) {
+        return SharedSliceCache::New(nbytes, numShards, [](size_t c) {
+            return SharedTwoQByteCache::New(c);
+        });
+    }
+    return SharedSliceCache::New(
+        nbytes, numShards, [](size_t c) { return SharedByteCache::New(c); });
+}
+
+void Volume::setDiskCache(DiskCache::Pointer c)
+{
+    diskCache_ = std::move(c);
+    diskCacheKey_ = PathKey(path_) + "-";
+    const std::lock_guard<std::mutex> lock(levelsMutex_);
+    for (auto& [n, level] : levels_) {
+        level->setDiskCache(diskCache_);
+    }
+}
+
+void Volume::setSource(io::VolumeSource::Pointer source)
+{
+    source_ = std::move(source);
+}
+
+void Volume::setAsyncReader(io::AsyncReader::Pointer reader)
+{
+    asyncReader_ = std::move(reader);
+    const std::lock_guard<std::mutex> lock(levelsMutex_);
+    for (auto& [n, level] : levels_) {
+        level->setAsyncReader(asyncReader_);
+    }
+}
+
+bool Volume::async_reads_() const
+{
+    return asyncReader_ != nullptr and diskCache_ == nullptr;
+}
+
+void Volume::read_async_(
+    const std::string& name,
+    const fs::path& path,
+    io::AsyncReader::Callback done) const
+{
+    if (source_) {
+        source_->readAsync(name, *asyncReader_, std::move(done));
+    } else {
+        asyncReader_->read(path, std::move(done));
+    }
+}
+
+template <typename TStamp, typename TLoader>
+cv::Mat Volume::disk_cached_load_(
+    const std::string& key, TStamp getStamp, TLoader load) const
+{
+    if (not diskCache_) {
+        return load();
+    }
+
+    // Files which do not exist are not cached
+    auto stamp = getStamp();
+    if (stamp.size == 0) {
+        return load();
+    }
+    auto m = diskCache_->get(diskCacheKey_ + key, stamp);
+    if (m.empty()) {
+        m = load();
+        diskCache_->put(diskCacheKey_ + key, stamp, m);
+    }
+    return m;
+}
+
+void Volume::setCachePolicy(CachePolicy policy)
+{
+    cachePolicy_ = policy;
+    if (sharedCache_ != nullptr) {
+        return;
+    }
+
+    // Rebuild the cache with the same capacity
+    auto capacity = cache_->capacity();
+    if (IsByteCache(cache_) or (concurrentCache_ != nullptr and
+                                IsByteCache(concurrentCache_->shard(0)))) {
+        setCache(new_byte_cache_(capacity));
+    } else if (policy == CachePolicy::TwoQ) {
+        setCache(new_concurrent_cache_(
+            capacity, ConcurrentCache::DEFAULT_SHARDS,
+            [](size_t c) { return TwoQSliceCache::New(c); }));
+    } else {
+        setCache(new_concurrent_cache_(
+            capacity, ConcurrentCache::DEFAULT_SHARDS,
+            ConcurrentCache::DefaultFactory));
+    }
+}
+
+void Volume::setNUMAPartitioning(int slabSize, size_t numNodes)
+{
+    if (slabSize < 0) {
+        throw std::invalid_argument("NUMA slab size must not be negative");
+    }
+    numaSlab_ = slabSize;
+    if (slabSize == 0) {
+        numaNodes_ = 1;
+    } else {
+        numaNodes_ = (numNodes > 0) ? numNodes : numa::NumNodes();
+    }
+
+    // Rebuild the cache with the partitioned shards
+    setCachePolicy(cachePolicy_);
+}
+
+size_t Volume::numaNode(int z) const
+{
+    if (numaNodes_ < 2) {
+        return 0;
+    }
+    return static_cast<size_t>(std::max(z, 0) / numaSlab_) % numaNodes_;
+}
+
+Volume::SliceCache::Pointer Volume::new_concurrent_cache_(
+    size_t capacity, size_t shards, ConcurrentCache::ShardFactory factory) const
+{
+    if (numaNodes_ < 2) {
+        return ConcurrentCache::New(capacity, shards, std::move(factory));
+    }
+
+    // Block keys are ordered by Z-layer of the block grid
+    int keysPerLayer{1};
+    int layerDepth{1};
+    if (blocked_()) {
+        auto grid = blockGridSize();
+        keysPerLayer = std::max(grid[0] * grid[1], 1);
+        layerDepth = blockShape_[2];
+    }
+
+    // Each node's keys are spread across the node's own shards
+    auto selector = [nodes = numaNodes_, slab = numaSlab_, shards,
+                     keysPerLayer, layerDepth](const int& key) {
+        auto z = (key / keysPerLayer) * layerDepth;
+        auto node = static_cast<size_t>(z / slab) % nodes;
+        return node * shards + std::hash<int>{}(key) % shards;
+    };
+    return ConcurrentCache::New(
+        capacity, shards * numaNodes_, std::move(factory), selector);
+}
+
+void Volume::setCacheMemoryInBytes(size_t nbytes)
+{
+    // Resize an existing byte cache of the current policy
+    if (HasPolicy(cache_, cachePolicy_) and IsByteCache(cache_)) {
+        const std::lock_guard<std::mutex> lock(cacheMutex_);
+        cache_->setCapacity(nbytes);
+        return;
+    }
+    if (concurrentCache_ != nullptr) {
+        auto shard = concurrentCache_->shard(0);
+        if (HasPolicy(shard, cachePolicy_) and IsByteCache(shard)) {
+            concurrentCache_->setCapacity(nbytes);
+            return;
+        }
+    }
+    if (sharedCache_ != nullptr) {
+        sharedCache_->setCapacity(nbytes);
+        return;
+    }
+    setCache(new_byte_cache_(nbytes));
+}
+
+Volume::SliceCache::Pointer Volume::new_byte_cache_(size_t nbytes) const
+{
+    // Use enough shards to reduce contention, but few enough that every
+    // shard can hold several slices or blocks
+    auto shards =
+        nbytes / (4 * numaNodes_ * std::max<size_t>(entry_bytes_(), 1));
+    shards = std::clamp<size_t>(shards, 1, ConcurrentCache::DEFAULT_SHARDS);
+    if (cachePolicy_ == CachePolicy::TwoQ) {
+        return new_concurrent_cache_(
+            nbytes, shards, [](size_t c) { return TwoQByteCache::New(c); });
+    }
+    return new_concurrent_cache_(
+        nbytes, shards, [](size_t c) { return ByteCache::New(c); });
+}
+
+size_t Volume::getCacheMemoryInBytes() const
+{
+    if (IsByteCache(cache_)) {
+        const std::lock_guard<std::mutex> lock(cacheMutex_);
+        return StoredBytes<ByteCache, TwoQByteCache>(cache_);
+    }
+
+    size_t bytes{0};
+    if (concurrentCache_ != nullptr) {
+        for (size_t i = 0; i < concurrentCache_->numShards(); i++) {
+            bytes += StoredBytes<ByteCache, TwoQByteCache>(
+                concurrentCache_->shard(i));
+        }
+    }
+    if (sharedCache_ != nullptr) {
+        auto storage = sharedCache_->storage();
+        for (size_t i = 0; i < storage->numShards(); i++) {
+            bytes += StoredBytes<SharedByteCache, SharedTwoQByteCache>(
+                storage->shard(i));
+        }
+    }
+    return bytes;
+}
+
+void Volume::register_cache_memory_()
+{
+    // Volumes which share a cache are counted once
+    const void* key = this;
+    if (sharedCache_ != nullptr) {
+        key = sharedCache_->storage().get();
+    }
+    cacheMemory_ = memory::RegisterProvider(
+        MemoryCategory::SliceCache, [this]() { return cache_bytes_(); }, key);
+    cacheShrink_ = memory::RegisterShrinkHandler(
+        [this](auto excess) { shrink_cache_(excess); });
+}
+
+std::size_t Volume::cache_bytes_() const
+{
+    auto bytes = getCacheMemoryInBytes();
+    if (bytes > 0) {
+        return bytes;
+    }
+
+    // Caches which count their elements are estimated from the element size
+    std::size_t size;
+    if (concurrentCache_ != nullptr or sharedCache_ != nullptr) {
+        size = cache_->size();
+    } else {
+        const std::lock_guard<std::mutex> lock(cacheMutex_);
+        size = cache_->size();
+    }
+    return size * entry_bytes_();
+}
+
+std::size_t Volume::entry_bytes_() const
+{
+    const size_t voxelBytes = CV_ELEM_SIZE1(VoxelDepth(voxelType_));
+    if (blocked_()) {
+        return static_cast<size_t>(blockShape_[0]) * blockShape_[1] *
+               blockShape_[2] * voxelBytes;
+    }
+    return static_cast<size_t>(width_) * height_ * voxelBytes;
+}
+
+void Volume::shrink_cache_(std::size_t excess)
+{
+    auto bytes = cache_bytes_();
+    if (bytes == 0) {
+        return;
+    }
+    auto target = bytes > excess ? bytes - excess : 0;
+
+    // Byte caches shrink to the target size. Other caches keep as many
+    // elements as fit in it. Every cache keeps room for one element.
+    auto isByteCache = getCacheMemoryInBytes() > 0;
+    auto capacity = target;
+    if (not isByteCache) {
+        capacity = target / std::max<size_t>(entry_bytes_(), 1);
+    }
+    capacity = std::max<size_t>(capacity, 1);
+    Logger()->debug(
+        "Shrinking slice cache to {} to meet memory soft limit",
+        isByteCache ? BytesToMemorySizeString(capacity, "MB")
+                    : std::to_string(capacity) + " entries");
+    if (isByteCache) {
+        setCacheMemoryInBytes(capacity);
+    } else if (concurrentCache_ != nullptr or sharedCache_ != nullptr) {
+        cache_->setCapacity(capacity);
+    } else {
+        const std::lock_guard<std::mutex> lock(cacheMutex_);
+        cache_->setCapacity(capacity);
+    }
+}
+
+template <typename TLoader>
+cv::Mat Volume::cache_get_(int key, TLoader load) const
+{
+    cacheLookups_++;
+    auto countedLoad = [this, &load]() {
+        VC_TRACE_SPAN_CAT("cache", "Cache miss");
+        cacheMisses_++;
+        return load();
+    };
+
+    if (concurrentCache_ != nullptr) {
+        return concurrentCache_->getOrLoad(key, countedLoad);
+    }
+    if (sharedCache_ != nullptr) {
+        return sharedCache_->getOrLoad(key, countedLoad);
+    }
+
+    const std::lock_guard<std::mutex> lock(cacheMutex_);
+    if (cache_->contains(key)) {
+        return cache_->get(key);
+    }
+
+    auto value = countedLoad();
+    cache_->put(key, value);
+    return value;
+}
+
+CacheStats Volume::cacheStats() const
+{
+    CacheStats stats;
+    stats.lookups = cacheLookups_;
+    stats.misses = cacheMisses_;
+    stats.hits = stats.lookups - std::min(stats.lookups, stats.misses);
+    auto evictions = cache_evictions_();
+    stats.evictions = evictions - std::min<size_t>(evictions, evictionsBase_);
+    stats.bytesRead = bytesRead_;
+    stats.loadLatency = loadLatency_.snapshot();
+    return stats;
+}
+
+void Volume::resetCacheStats()
+{
+    cacheLookups_ = 0;
+    cacheMisses_ = 0;
+    bytesRead_ = 0;
+    loadLatency_.reset();
+    evictionsBase_ = cache_evictions_();
+}
+
+size_t Volume::cache_evictions_() const
+{
+    if (concurrentCache_ != nullptr or sharedCache_ != nullptr) {
+        return cache_->evictions();
+    }
+    const std::lock_guard<std::mutex> lock(cacheMutex_);
+    return cache_->evictions();
+}
+
+void Volume::record_load_(
+    std::chrono::steady_clock::time_point start, const cv::Mat& m) const
+{
+    loadLatency_.record(std::chrono::steady_clock::now() - start);
+    bytesRead_ += m.total() * m.elemSize();
+}
+
+cv::Mat Volume::load_slice_(int index) const
+{
+    VC_TRACE_SPAN_CAT("io", "Load slice");
+    auto start = std::chrono::steady_clock::now();
+    auto slicePath = getSlicePath(index);
+    cv::Mat slice;
+    if (source_) {
+        slice = read_source_(slice_name_(index), SliceKey(index));
+    } else if (fs::exists(slicePath)) {
+        slice = disk_cached_load_(
+            SliceKey(index),
+            [&]() { return DiskCache::SourceStamp(slicePath); },
+            [&]() { return tio::ReadTIFF(slicePath, {}, decodeThreads_); });
+    }
+    record_load_(start, slice);
+    return conform_(slice);
+}
+
+cv::Mat Volume::read_source_(
+    const std::string& name, const std::string& key) const
+{
+    return disk_cached_load_(
+        key, [&]() { return source_->stamp(name); },
+        [&]() {
+            auto data = source_->read(name);
+            if (not data) {
+                return cv::Mat();
+            }
+            return tio::ReadTIFF(*data, {}, decodeThreads_);
+        });
+}
+
+cv::Mat Volume::load_slice_region_(int index, const cv::Rect& roi) const
+{
+    // Sources only read whole files, so keep the whole slice
+    if (source_) {
+        auto slice = cacheSlices_ ? cache_slice_(index) : load_slice_(index);
+        if (slice.empty() or roi.empty()) {
+            return {};
+        }
+        return slice(roi & cv::Rect(0, 0, slice.cols, slice.rows)).clone();
+    }
+
+    VC_TRACE_SPAN_CAT("io", "Load slice region");
+    auto start = std::chrono::steady_clock::now();
+    auto slicePath = getSlicePath(index);
+    cv::Mat region;
+    if (roi.empty() or not fs::exists(slicePath)) {
+        record_load_(start, region);
+        return region;
+    }
+
+    // Crop a slice from the disk cache, but do not decode the whole slice to
+    // add it
+    if (diskCache_) {
+        auto slice = diskCache_->get(
+            diskCacheKey_ + SliceKey(index), DiskCache::SourceStamp(slicePath));
+        if (not slice.empty() and
+            (roi & cv::Rect(0, 0, slice.cols, slice.rows)) == roi) {
+            region = slice(roi).clone();
+        }
+    }
+    if (region.empty()) {
+        region = tio::ReadTIFF(slicePath, roi, decodeThreads_);
+    }
+    record_load_(start, region);
+    return conform_(region);
+}
+
+cv::Mat Volume::cached_slice_(int index) const
+{
+    try {
+        if (concurrentCache_ != nullptr or sharedCache_ != nullptr) {
+            if (cache_->contains(index)) {
+                return cache_->get(index);
+            }
+            return {};
+        }
+
+        const std::lock_guard<std::mutex> lock(cacheMutex_);
+        if (cache_->contains(index)) {
+            return cache_->get(index);
+        }
+    } catch (const std::invalid_argument&) {
+        // Evicted by another thread between contains() and get()
+    }
+    return {};
+}
+
+cv::Mat Volume::sample_slice_(
+    int index, const cv::Rect& roi, cv::Point& offset) const
+{
+    offset = {0, 0};
+    auto r = roi & cv::Rect(0, 0, width_, height_);
+    auto sliceArea = static_cast<double>(width_) * height_;
+    if (source_ or r.area() > MAX_REGION_FRACTION * sliceArea) {
+        return getSliceData(index);
+    }
+
+    // Prefer the whole slice if it is already in memory
+    if (cacheSlices_) {
+        auto cached = cached_slice_(index);
+        if (not cached.empty()) {
+            cacheLookups_++;
+            return cached;
+        }
+    }
+
+    offset = r.tl();
+    return load_slice_region_(index, r);
+}
+
+cv::Mat Volume::cache_slice_(int index) const
+{
+    return cache_get_(index, [this, index]() { return load_slice_(index); });
+}
+
+size_t Volume::numLevels() const
+{
+    if (format_ == Format::Zarr) {
+        return zarrArrays_.size();
+    }
+    return 1 + storedLevels_;
+}
+
+Volume::Pointer Volume::level(size_t n)
+{
+    if (n >= numLevels()) {
+        throw std::out_of_range("Volume level out of range");
+    }
+    if (n == 0) {
+        return shared_from_this();
+    }
+
+    const std::lock_guard<std::mutex> lock(levelsMutex_);
+    auto it = levels_.find(n);
+    if (it == levels_.end()) {
+        auto lvl = (format_ == Format::Zarr) ? new_zarr_level_(n)
+                                             : Volume::New(getLevelPath(n));
+        it = levels_.emplace(n, lvl).first;
+        if (sharedCache_ != nullptr) {
+            it->second->setCache(sharedCache_->storage());
+        }
+        if (diskCache_) {
+            it->second->setDiskCache(diskCache_);
+        }
+        it->second->setAsyncReader(asyncReader_);
+    }
+    return it->second;
+}
+
+Volume::Pointer Volume::new_zarr_level_(size_t n) const
+{
+    auto lvl = Volume::New(path_);
+    lvl->source_ = source_;
+    lvl->open_zarr_(n);
+    lvl->zarrArrays_ = {zarrArrays_[n]};
+    if (voxelSize_) {
+        lvl->setVoxelSize(*voxelSize_ * levelScale(n));
+    }
+    // Keep saveMetadata() on the level from replacing this volume's metadata
+    lvl->metadata_.setPath(getLevelPath(n) / "meta.json");
+    return lvl;
+}
+
+double Volume::levelScale(size_t n) { return std::ldexp(1.0, int(n)); }
+
+size_t Volume::levelForSamplingInterval(double interval) const
+{
+    if (interval < 2) {
+        return 0;
+    }
+    auto n = static_cast<size_t>(std::floor(std::log2(interval)));
+    return std::min(n, numLevels() - 1);
+}
+
+fs::path Volume::getLevelPath(size_t n) const
+{
+    return path_ / SUBPATH_LEVELS / std::to_string(n);
+}
+
+void Volume::generateLevels(size_t numLevels, LevelFilter filter, bool compress)
+{
+    if (format_ == Format::Zarr) {
+        throw std::logic_error("Zarr volumes use their multiscale arrays");
+    }
+
+    // Remove the old levels
+    {
+        const std::lock_guard<std::mutex> lock(levelsMutex_);
+        levels_.clear();
+    }
+    fs::remove_all(path_ / SUBPATH_LEVELS);
+    storedLevels_ = 0;
+    metadata_.set("levels", 0);
+
+    // Each level is computed from the one before it
+    const Volume* src = this;
+    Pointer prev;
+    for (size_t n = 1; n <= numLevels; n++) {
+        auto levelPath = getLevelPath(n);
+        fs::create_directories(levelPath);
+        auto lvlID = id() + "_" + std::to_string(n);
+        auto lvlName = name() + " (level " + std::to_string(n) + ")";
+        auto lvl = Volume::New(levelPath, lvlID, lvlName);
+        lvl->setSliceWidth((src->sliceWidth() + 1) / 2);
+        lvl->setSliceHeight((src->sliceHeight() + 1) / 2);
+        lvl->setNumberOfSlices((src->numSlices() + 1) / 2);
+        lvl->setVoxelSize(voxelSize() * levelScale(n));
+        lvl->setMin(min());
+        lvl->setMax(max());
+        lvl->setCompression(compression_);
+        lvl->setVoxelType(voxelType_);
+        lvl->saveMetadata();
+
+        // Overlap compression with downsampling
+        lvl->setAsyncWrites();
+        for (int z = 0; z < lvl->numSlices(); z++) {
+            auto a = src->getSliceData(2 * z);
+            auto b = (2 * z + 1 < src->numSlices())
+                         ? src->getSliceData(2 * z + 1)
+                         : a;
+            lvl->setSliceData(z, DownsampleSlices(a, b, filter), compress);
+        }
+
+        // The next level is computed from this one
+        lvl->disableAsyncWrites();
+
+        prev = lvl;
+        src = prev.get();
+    }
+
+    storedLevels_ = numLevels;
+    metadata_.set("levels", numLevels);
+    saveMetadata();
+}
+
+void Volume::setPrefetching(size_t ahead, size_t behind, size_t threads)
+{
+    prefetcher_.reset();
+    prefetcher_ = std::make_unique<Prefetcher>(this, ahead, behind, threads);
+}
+
+void Volume::disablePrefetching() { prefetcher_.reset(); }
+
+void Volume::setAsyncWrites(size_t maxBytes, size_t threads)
+{
+    disableAsyncWrites();
+    writer_ = std::make_unique<SliceWriter>(this, maxBytes, threads);
+}
+
+void Volume::flushSliceWrites()
+{
+    if (writer_) {
+        writer_->flush();
+    }
+}
+
+void Volume::disableAsyncWrites()
+{
+    if (not writer_) {
+        return;
+    }
+
+    // Stop the writer even if a write failed
+    auto writer = std::move(writer_);
+    writer->flush();
+}
+
+void Volume::prefetch_slice_(int index) const
+{
+    // The cache holds blocks, so load the blocks which the slice intersects
+    if (blocked_()) {
+        assemble_slice_(index, {0, 0, width_, height_});
+        return;
+    }
+
+    if (not cache_contains_(index)) {
+        cache_slice_(index);
+    }
+}
+
+void Volume::prefetch_slice_async_(int index, std::function<void()> done) const
+{
+    if (blocked_()) {
+        auto grid = blockGridSize();
+        std::vector<cv::Vec3i> blocks;
+        for (int by = 0; by < grid[1]; by++) {
+            for (int bx = 0; bx < grid[0]; bx++) {
+                blocks.emplace_back(bx, by, index / blockShape_[2]);
+            }
+        }
+        cache_blocks_async_(std::move(blocks), std::move(done));
+        return;
+    }
+
+    if (cache_contains_(index)) {
+        done();
+        return;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    auto decode = [this, index, start, done](auto data, auto error) {
+        try {
+            if (error) {
+                std::rethrow_exception(error);
+            }
+            cv::Mat slice;
+            if (data) {
+                slice = tio::ReadTIFF(*data, {}, decodeThreads_);
+            }
+            record_load_(start, slice);
+            slice = conform_(slice);
+            cache_get_(index, [&slice]() { return slice; });
+        } catch (const std::exception& e) {
+            Logger()->debug("Failed to prefetch slice {}: {}", index, e.what());
+        }
+        done();
+    };
+    try {
+        read_async_(slice_name_(index), getSlicePath(index), decode);
+    } catch (const std::exception& e) {
+        Logger()->debug("Failed to prefetch slice {}: {}", index, e.what());
+        done();
+    }
+}
+
+bool Volume::cache_contains_(int key) const
+{
+    if (concurrentCache_ != nullptr or sharedCache_ != nullptr) {
+        return cache_->contains(key);
+    }
+    const std::lock_guard<std::mutex> lock(cacheMutex_);
+    return cache_->contains(key);
+}
+
+cv::Mat Volume::load_block_(int bx, int by, int bz) const
+{
+    VC_TRACE_SPAN_CAT("io", "Load block");
+
+    // Blocks of a single intensity do not need to be read
+    auto constant = constant_block_(bx, by, bz);
+    if (not constant.empty()) {
+        return constant;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    auto blockPath = getBlockPath(bx, by, bz);
+    auto key = "b" + std::to_string(bx) + "_" + std::to_string(by) + "_" +
+               std::to_string(bz);
+    cv::Mat block;
+    if (zarr_) {
+        block = disk_cached_load_(
+            key,
+            [&]() { return source_->stamp(zarr_->chunkName(bx, by, bz)); },
+            [&]() { return zarr_->readChunk(bx, by, bz); });
+    } else if (source_) {
+        block = read_source_(block_name_(bx, by, bz), key);
+    } else {
+        block = disk_cached_load_(
+            key, [&]() { return DiskCache::SourceStamp(blockPath); },
+            [&]() { return cv::imread(blockPath.string(), -1); });
+    }
+    record_load_(start, block);
+    return finish_block_(block);
+}
+
+cv::Mat Volume::finish_block_(cv::Mat block) const
+{
+    if (block.empty()) {
+        return cv::Mat::zeros(
+            blockShape_[2] * blockShape_[1], blockShape_[0],
+            VoxelDepth(voxelType_));
+    }
+    return conform_(block);
+}
+
+cv::Mat Volume::constant_block_(int bx, int by, int bz) const
+{
+    auto stats = fill_statistics_();
+    if (not stats or not stats->isConstant(bx, by, bz)) {
+        return {};
+    }
+
+    // Edge blocks are zero outside of the volume
+    const auto& s = blockShape_;
+    auto w = std::min(s[0], width_ - bx * s[0]);
+    auto h = std::min(s[1], height_ - by * s[1]);
+    auto d = std::min(s[2], slices_ - bz * s[2]);
+    cv::Mat block = cv::Mat::zeros(s[2] * s[1], s[0], CV_16UC1);
+    cv::Scalar value(stats->block(bx, by, bz).min);
+    for (int z = 0; z < d; z++) {
+        block(cv::Rect(0, z * s[1], w, h)).setTo(value);
+    }
+    return block;
+}
+
+int Volume::block_key_(int bx, int by, int bz) const
+{
+    auto grid = blockGridSize();
+    return (bz * grid[1] + by) * grid[0] + bx;
+}
+
+cv::Mat Volume::cache_block_(int bx, int by, int bz) const
+{
+    return cache_get_(block_key_(bx, by, bz), [this, bx, by, bz]() {
+        return load_block_(bx, by, bz);
+    });
+}
+
+void Volume::cache_blocks_async_(
+    std::vector<cv::Vec3i> blocks, std::function<void()> done) const
+{
+    blocks.erase(
+        std::remove_if(
+            blocks.begin(), blocks.end(),
+            [this](const auto& b) {
+                return cache_contains_(block_key_(b[0], b[1], b[2]));
+            }),
+        blocks.end());
+    if (blocks.empty()) {
+        done();
+        return;
+    }
+
+    // The last block to finish reports the batch
+    auto remaining = std::make_shared<std::atomic<size_t>>(blocks.size());
+    auto finish = [remaining, done = std::move(done)]() {
+        if (--*remaining == 0) {
+            done();
+        }
+    };
+    for (const auto& b : blocks) {
+        auto constant = constant_block_(b[0], b[1], b[2]);
+        if (not constant.empty()) {
+            cache_get_(
+                block_key_(b[0], b[1], b[2]),
+                [&constant]() { return constant; });
+            finish();
+            continue;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        auto decode = [this, b, start, finish](auto data, auto error) {
+            try {
+                if (error) {
+                    std::rethrow_exception(error);
+                }
+                cv::Mat block;
+                if (zarr_) {
+                    block = zarr_->decodeChunk(data);
+                } else if (data and source_) {
+                    block = tio::ReadTIFF(*data, {}, decodeThreads_);
+                } else if (data) {
+                    const cv::Mat encoded(
+                        1, static_cast<int>(data->size()), CV_8UC1,
+                        data->data());
+                    block = cv::imdecode(encoded, cv::IMREAD_UNCHANGED);
+                }
+                record_load_(start, block);
+                block = finish_block_(block);
+                cache_get_(
+                    block_key_(b[0], b[1], b[2]), [&block]() { return block; });
+            } catch (const std::exception& e) {
+                Logger()->debug(
+                    "Failed to load block {}_{}_{}: {}", b[0], b[1], b[2],
+                    e.what());
+            }
+            finish();
+        };
+
+        auto name = zarr_ ? zarr_->chunkName(b[0], b[1], b[2])
+                          : block_name_(b[0], b[1], b[2]);
+        try {
+            read_async_(name, getBlockPath(b[0], b[1], b[2]), decode);
+        } catch (const std::exception& e) {
+            Logger()->debug("Failed to load block {}: {}", name, e.what());
+            finish();
+        }
+    }
+}
+
+cv::Mat Volume::assemble_slice_(int index, const cv::Rect& roi) const
+{
+    auto bw = blockShape_[0];
+    auto bh = blockShape_[1];
+    auto bz = index / blockShape_[2];
+    auto z = index % blockShape_[2];
+
+    cv::Mat slice;
+    if (roi.empty()) {
+        return slice;
+    }
+
+    auto bx0 = roi.x / bw;
+    auto by0 = roi.y / bh;
+    auto bx1 = (roi.x + roi.width - 1) / bw;
+    auto by1 = (roi.y + roi.height - 1) / bh;
+
+    // Read the uncached blocks at once. Blocks which failed to load are read
+    // again below, which reports the error.
+    if (cacheSlices_ and async_reads_() and (bx1 > bx0 or by1 > by0)) {
+        std::vector<cv::Vec3i> blocks;
+        for (int by = by0; by <= by1; by++) {
+            for (int bx = bx0; bx <= bx1; bx++) {
+                blocks.emplace_back(bx, by, bz);
+            }
+        }
+        auto loaded = std::make_shared<std::promise<void>>();
+        auto ready = loaded->get_future();
+        cache_blocks_async_(
+            std::move(blocks), [loaded]() { loaded->set_value(); });
+        ready.wait();
     }
 
-    auto slice = load_slice_(index);
-    cache_->put(index, slice);
+    for (int by = by0; by <= by1; by++) {
+        for (int bx = bx0; bx <= bx1; bx++) {
+            auto block = getBlockData(bx, by, bz);
+            if (slice.empty()) {
+                slice = cv::Mat::zeros(roi.height, roi.width, block.type());
+            }
+
+            // Part of the region covered by this block
+            auto r = cv::Rect(bx * bw, by * bh, bw, bh) & roi;
+            auto src = cv::Rect(
+                r.x - bx * bw, z * bh + r.y - by * bh, r.width, r.height);
+            block(src).copyTo(slice(r - roi.tl()));
+        }
+    }
     return slice;
 }
+
+void Volume::write_slice_to_blocks_(
+    int index, const cv::Mat& slice, bool compress)
+{
+    if (index < 0 or index >= slices_) {
+        throw std::out_of_range("Slice index outside of volume");
+    }
+    if (slice.cols != width_ or slice.rows != height_) {
+        throw std::invalid_argument("Slice does not match volume dimensions");
+    }
+    if (slice.channels() != 1) {
+        throw std::invalid_argument("Blocks format requires 1-channel slices");
+    }
+
+    auto bs = blockSize_;
+    auto grid = blockGridSize();
+    auto bz = index / bs;
+    auto z = index % bs;
+
+    const std::lock_guard<std::mutex> lock(writeMutex_);
+
+    // Setup the layer buffer
+    auto& layer = pendingLayers_[bz];
+    if (layer.blocks.empty()) {
+        for (int i = 0; i < grid[0] * grid[1]; i++) {
+            layer.blocks.emplace_back(
+                cv::Mat::zeros(bs * bs, bs, slice.type()));
+        }
+        layer.written.assign(std::min(bs, slices_ - bz * bs), false);
+    }
+
+    // Copy the slice into the Z-plane of each block in the layer
+    for (int by = 0; by < grid[1]; by++) {
+        for (int bx = 0; bx < grid[0]; bx++) {
+            auto x0 = bx * bs;
+            auto y0 = by * bs;
+            auto w = std::min(bs, width_ - x0);
+            auto h = std::min(bs, height_ - y0);
+            auto& block = layer.blocks[by * grid[0] + bx];
+            slice(cv::Rect(x0, y0, w, h))
+                .copyTo(block(cv::Rect(0, z * bs, w, h)));
+        }
+    }
+    if (not layer.written[z]) {
+        layer.written[z] = true;
+        layer.numWritten++;
+    }
+
+    // Wait until every plane in the layer has been set
+    if (layer.numWritten < layer.written.size()) {
+        return;
+    }
+
+    fs::create_directories(path_ / SUBPATH_BLOCKS);
+    auto c = (compress) ? compression_ : tiffio::Compression::NONE;
+    for (int by = 0; by < grid[1]; by++) {
+        for (int bx = 0; bx < grid[0]; bx++) {
+            tio::WriteTIFF(
+                getBlockPath(bx, by, bz), layer.blocks[by * grid[0] + bx], c);
+        }
+    }
+    pendingLayers_.erase(bz);
+
+    // Cached blocks may now be stale
+    const std::lock_guard<std::mutex> cacheLock(cacheMutex_);
+    cache_->purge();
+}
@@ -0,0 +1,320 @@
+#include "vc/core/types/VolumeBlockStatistics.hpp"
+
+#include <algorithm>
+#include <array>
+#include <fstream>
+#include <limits>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+
+#include "vc/core/types/Exceptions.hpp"
+#include "vc/core/types/Volume.hpp"
+#include "vc/core/util/ThreadPool.hpp"
+
+namespace fs = volcart::filesystem;
+
+using namespace volcart;
+
+namespace
+{
+constexpr std::array<char, 8> MAGIC{'V', 'C', 'B', 'L', 'K', 'S', 'T', '\0'};
+constexpr std::uint32_t VERSION{1};
+
+// Fixed-size file header
+struct Header {
+    std::array<char, 8> magic{MAGIC};
+    std::uint32_t version{VERSION};
+    std::int32_t blockSize{0};
+    std::int32_t width{0};
+    std::int32_t height{0};
+    std::int32_t slices{0};
+    std::int32_t reserved{0};
+};
+
+constexpr auto EMPTY_MIN = std::numeric_limits<std::uint16_t>::max();
+
+auto GridSize(const cv::Vec3i& shape, int blockSize) -> cv::Vec3i
+{
+    return {
+        (shape[0] + blockSize - 1) / blockSize,
+        (shape[1] + blockSize - 1) / blockSize,
+        (shape[2] + blockSize - 1) / blockSize};
+}
+
+template <typename T>
+void WriteVector(std::ofstream& file, const std::vector<T>& v)
+{
+    file.write(
+        reinterpret_cast<const char*>(v.data()),
+        static_cast<std::streamsize>(v.size() * sizeof(T)));
+}
+
+template <typename T>
+void ReadVector(std::ifstream& file, std::vector<T>& v)
+{
+    file.read(
+        reinterpret_cast<char*>(v.data()),
+        static_cast<std::streamsize>(v.size() * sizeof(T)));
+}
+}  // namespace
+
+VolumeBlockStatistics::VolumeBlockStatistics(
+    const cv::Vec3i& volumeShape, int blockSize)
+    : shape_{volumeShape}, blockSize_{blockSize}
+{
+    if (blockSize <= 0) {
+        throw std::invalid_argument("Block size must be positive");
+    }
+    if (volumeShape[0] < 0 or volumeShape[1] < 0 or volumeShape[2] < 0) {
+        throw std::invalid_argument("Volume shape is negative");
+    }
+    grid_ = GridSize(shape_, blockSize_);
+    auto n = static_cast<std::size_t>(grid_[0]) * grid_[1] * grid_[2];
+    min_.assign(n, EMPTY_MIN);
+    max_.assign(n, 0);
+    sum_.assign(n, 0);
+    layerSlices_.assign(grid_[2], 0);
+}
+
+VolumeBlockStatistics VolumeBlockStatistics::Compute(
+    const Volume& volume, int blockSize, std::size_t numThreads)
+{
+    if (volume.voxelType() != Volume::VoxelType::UInt16) {
+        throw std::invalid_argument("Block statistics require a 16-bit volume");
+    }
+
+    cv::Vec3i shape{
+        volume.sliceWidth(), volume.sliceHeight(), volume.numSlices()};
+    VolumeBlockStatistics stats(shape, blockSize);
+    std::mutex mutex;
+    auto slices = static_cast<std::size_t>(shape[2]);
+    ParallelChunks(slices, numThreads, [&](auto begin, auto end) {
+        VolumeBlockStatistics local(shape, blockSize);
+        for (auto z = begin; z < end; ++z) {
+            auto index = static_cast<int>(z);
+            local.addSlice(index, volume.getSliceData(index));
+        }
+        const std::lock_guard<std::mutex> lock(mutex);
+        stats.merge(local);
+    });
+    return stats;
+}
+
+void VolumeBlockStatistics::addSlice(int index, const cv::Mat& slice)
+{
+    if (slice.type() != CV_16UC1) {
+        throw std::invalid_argument("Statistics require a CV_16UC1 slice");
+    }
+    if (slice.cols != shape_[0] or slice.rows != shape_[1]) {
+        throw std::invalid_argument("Slice does not match volume dimensions");
+    }
+    if (index < 0 or index >= shape_[2]) {
+        throw std::out_of_range("Slice index outside of volume");
+    }
+
+    // Every block of the slice's layer is updated from one pass over the
+    // slice rows
+    auto bz = index / blockSize_;
+    auto layer = static_cast<std::size_t>(bz) * grid_[0] * grid_[1];
+    for (int y = 0; y < slice.rows; y++) {
+        const auto* row = slice.ptr<std::uint16_t>(y);
+        auto rowBlocks = layer + static_cast<std::size_t>(y / blockSize_) *
+                                     grid_[0];
+        for (int bx = 0; bx < grid_[0]; bx++) {
+            auto x0 = bx * blockSize_;
+            auto x1 = std::min(x0 + blockSize_, slice.cols);
+            auto min = min_[rowBlocks + bx];
+            auto max = max_[rowBlocks + bx];
+            std::uint64_t sum{0};
+            for (int x = x0; x < x1; x++) {
+                auto v = row[x];
+                min = std::min(min, v);
+                max = std::max(max, v);
+                sum += v;
+            }
+            min_[rowBlocks + bx] = min;
+            max_[rowBlocks + bx] = max;
+            sum_[rowBlocks + bx] += static_cast<double>(sum);
+        }
+    }
+    layerSlices_[bz]++;
+}
+
+void VolumeBlockStatistics::merge(const VolumeBlockStatistics& other)
+{
+    if (other.shape_ != shape_ or other.blockSize_ != blockSize_) {
+        throw std::invalid_argument("Block statistics do not match");
+    }
+    for (std::size_t i = 0; i < min_.size(); i++) {
+        min_[i] = std::min(min_[i], other.min_[i]);
+        max_[i] = std::max(max_[i], other.max_[i]);
+        sum_[i] += other.sum_[i];
+    }
+    for (std::size_t i = 0; i < layerSlices_.size(); i++) {
+        layerSlices_[i] += other.layerSlices_[i];
+    }
+}
+
+cv::Vec3i VolumeBlockStatistics::volumeShape() const { return shape_; }
+
+int VolumeBlockStatistics::blockSize() const { return blockSize_; }
+
+cv::Vec3i VolumeBlockStatistics::gridSize() const { return grid_; }
+
+bool VolumeBlockStatistics::complete() const
+{
+    for (int bz = 0; bz < grid_[2]; bz++) {
+        if (static_cast<int>(layerSlices_[bz]) < layer_depth_(bz)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool VolumeBlockStatistics::isComplete(int bx, int by, int bz) const
+{
+    if (index_(bx, by, bz) < 0) {
+        return false;
+    }
+    return static_cast<int>(layerSlices_[bz]) >= layer_depth_(bz);
+}
+
+VolumeBlockStatistics::BlockStatistics VolumeBlockStatistics::block(
+    int bx, int by, int bz) const
+{
+    auto idx = index_(bx, by, bz);
+    if (idx < 0) {
+        throw std::out_of_range("Block position outside of grid");
+    }
+    if (layerSlices_[bz] == 0) {
+        return {};
+    }
+
+    // Edge blocks are clipped to the volume
+    auto w = std::min(blockSize_, shape_[0] - bx * blockSize_);
+    auto h = std::min(blockSize_, shape_[1] - by * blockSize_);
+    auto count = static_cast<double>(w) * h * layerSlices_[bz];
+    return {min_[idx], max_[idx], sum_[idx] / count};
+}
+
+bool VolumeBlockStatistics::mayContain(
+    int bx, int by, int bz, std::uint16_t low, std::uint16_t high) const
+{
+    auto idx = index_(bx, by, bz);
+    if (idx < 0 or not isComplete(bx, by, bz)) {
+        return true;
+    }
+    return min_[idx] <= high and max_[idx] >= low;
+}
+
+bool VolumeBlockStatistics::mayContain(
+    const cv::Vec3i& start,
+    const cv::Vec3i& end,
+    std::uint16_t low,
+    std::uint16_t high) const
+{
+    cv::Vec3i b0;
+    cv::Vec3i b1;
+    for (int d = 0; d < 3; d++) {
+        auto s = std::max(start[d], 0);
+        auto e = std::min(end[d], shape_[d]);
+        if (s >= e) {
+            return false;
+        }
+        b0[d] = s / blockSize_;
+        b1[d] = (e - 1) / blockSize_;
+    }
+    for (int bz = b0[2]; bz <= b1[2]; bz++) {
+        for (int by = b0[1]; by <= b1[1]; by++) {
+            for (int bx = b0[0]; bx <= b1[0]; bx++) {
+                if (mayContain(bx, by, bz, low, high)) {
+                    return true;
+                }
+            }
+        }
+    }
+    return false;
+}
+
+bool VolumeBlockStatistics::isConstant(int bx, int by, int bz) const
+{
+    auto idx = index_(bx, by, bz);
+    if (idx < 0 or not isComplete(bx, by, bz)) {
+        return false;
+    }
+    return min_[idx] == max_[idx];
+}
+
+void VolumeBlockStatistics::write(const fs::path& path) const
+{
+    std::ofstream file(path.string(), std::ios::binary);
+    if (not file.is_open()) {
+        throw IOException("Failed to open file for writing: " + path.string());
+    }
+
+    Header header;
+    header.blockSize = blockSize_;
+    header.width = shape_[0];
+    header.height = shape_[1];
+    header.slices = shape_[2];
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    WriteVector(file, layerSlices_);
+    WriteVector(file, min_);
+    WriteVector(file, max_);
+    WriteVector(file, sum_);
+
+    if (file.fail()) {
+        throw IOException("Failed to write file: " + path.string());
+    }
+}
+
+VolumeBlockStatistics VolumeBlockStatistics::Read(const fs::path& path)
+{
+    std::ifstream file(path.string(), std::ios::binary);
+    if (not file.is_open()) {
+        throw IOException("Failed to open file for reading: " + path.string());
+    }
+
+    Header header;
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (file.fail() or header.magic != MAGIC) {
+        throw IOException("Not a block statistics file: " + path.string());
+    }
+    if (header.version != VERSION) {
+        throw IOException(
+            "Unsupported block statistics version: " +
+            std::to_string(header.version));
+    }
+
+    VolumeBlockStatistics stats;
+    try {
+        stats = VolumeBlockStatistics(
+            {header.width, header.height, header.slices}, header.blockSize);
+    } catch (const std::invalid_argument&) {
+        throw IOException("Invalid block statistics header: " + path.string());
+    }
+    ReadVector(file, stats.layerSlices_);
+    ReadVector(file, stats.min_);
+    ReadVector(file, stats.max_);
+    ReadVector(file, stats.sum_);
+
+    if (file.fail()) {
+        throw IOException("Failed to read file: " + path.string());
+    }
+    return stats;
+}
+
+std::ptrdiff_t VolumeBlockStatistics::index_(int bx, int by, int bz) const
+{
+    if (bx < 0 or bx >= grid_[0] or by < 0 or by >= grid_[1] or bz < 0 or
+        bz >= grid_[2]) {
+        return -1;
+    }
+    return (static_cast<std::ptrdiff_t>(bz) * grid_[1] + by) * grid_[0] + bx;
+}
+
+int VolumeBlockStatistics::layer_depth_(int bz) const
+{
+    return std::min(blockSize_, shape_[2] - bz * blockSize_);
+}
@@ -1,60 +1,325 @@
 #include "vc/core/types/VolumeMask.hpp"
 
+#include <algorithm>
+#include <stdexcept>
+
 using namespace volcart;
 
+static constexpr int BS{VolumeMask::BRICK_SIZE};
+static constexpr std::size_t NUM_ROWS{BS * BS};
+static constexpr std::uint32_t FULL_ROW{0xFFFFFFFFU};
+
+namespace
+{
+// Number of set bits
+auto PopCount(std::uint32_t word) -> std::size_t
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return static_cast<std::size_t>(__builtin_popcount(word));
+#else
+    std::size_t count{0};
+    for (; word != 0; word &= word - 1) {
+        ++count;
+    }
+    return count;
+#endif
+}
+
+// Bits [x0, x1) of a brick row
+auto RowMask(int x0, int x1) -> std::uint32_t
+{
+    if (x1 - x0 == BS) {
+        return FULL_ROW;
+    }
+    return ((std::uint32_t{1} << (x1 - x0)) - 1) << x0;
+}
+
+// Index of a brick row
+auto RowIndex(int y, int z) -> std::size_t
+{
+    return static_cast<std::size_t>(z * BS + y);
+}
+
+// Number of voxels in a region
+auto Volume(const cv::Vec3i& min, const cv::Vec3i& max) -> std::size_t
+{
+    return static_cast<std::size_t>(max[0] - min[0]) *
+           static_cast<std::size_t>(max[1] - min[1]) *
+           static_cast<std::size_t>(max[2] - min[2]);
+}
+
+// Whether a region covers an entire brick
+auto CoversBrick(const cv::Vec3i& min, const cv::Vec3i& max) -> bool
+{
+    return min == cv::Vec3i(0, 0, 0) and max == cv::Vec3i(BS, BS, BS);
+}
+}  // namespace
+
 VolumeMask::VolumeMask(size_t width, size_t height, size_t numSlices)
-    : sliceWidth_{width}, sliceHeight_{height}
+    : dims_{static_cast<int>(width), static_cast<int>(height),
+            static_cast<int>(numSlices)}
 {
+    for (int i = 0; i < 3; i++) {
+        brickDims_[i] = (dims_[i] + BS - 1) / BS;
+    }
+}
 
-    // sparse matrix length decided by number of slices
-    states_ = Eigen::SparseMatrix<int, Eigen::RowMajor>(
-        height * numSlices, sliceWidth_);
+std::size_t VolumeMask::brick_index_(const cv::Vec3i& xyz) const
+{
+    auto bx = static_cast<std::size_t>(xyz[0] / BS);
+    auto by = static_cast<std::size_t>(xyz[1] / BS);
+    auto bz = static_cast<std::size_t>(xyz[2] / BS);
+    return (bz * brickDims_[1] + by) * brickDims_[0] + bx;
+}
+
+bool VolumeMask::in_bounds_(const cv::Vec3i& xyz) const
+{
+    for (int i = 0; i < 3; i++) {
+        if (xyz[i] < 0 or xyz[i] >= dims_[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+template <class F>
+void VolumeMask::for_each_brick_(
+    const cv::Vec3i& origin, const cv::Vec3i& dims, F&& f) const
+{
+    // Clip to the mask
+    cv::Vec3i lo;
+    cv::Vec3i hi;
+    for (int i = 0; i < 3; i++) {
+        lo[i] = std::max(origin[i], 0);
+        hi[i] = std::min(origin[i] + dims[i], dims_[i]);
+        if (lo[i] >= hi[i]) {
+            return;
+        }
+    }
+
+    for (int bz = lo[2] / BS; bz <= (hi[2] - 1) / BS; bz++) {
+        for (int by = lo[1] / BS; by <= (hi[1] - 1) / BS; by++) {
+            for (int bx = lo[0] / BS; bx <= (hi[0] - 1) / BS; bx++) {
+                cv::Vec3i brickOrigin{bx * BS, by * BS, bz * BS};
+                cv::Vec3i min;
+                cv::Vec3i max;
+                for (int i = 0; i < 3; i++) {
+                    min[i] = std::max(lo[i], brickOrigin[i]) - brickOrigin[i];
+                    max[i] = std::min(hi[i], brickOrigin[i] + BS) -
+                             brickOrigin[i];
+                }
+                f(brick_index_(brickOrigin), min, max, brickOrigin - origin);
+            }
+        }
+    }
+}
+
+void VolumeMask::check_dims_(const VolumeMask& other) const
+{
+    if (dims_ != other.dims_) {
+        throw std::invalid_argument("VolumeMask dimensions do not match");
+    }
 }
 
 void VolumeMask::setVoxelState(const cv::Vec3i& xyz, State state)
 {
-    states_.coeffRef(xyz[2] * sliceHeight_ + xyz[1], xyz[0]) =
-        static_cast<int>(state);
+    setSubvolumeState(xyz, {1, 1, 1}, state);
 }
 
 void VolumeMask::setSubvolumeState(
     const cv::Vec3i& origin, const cv::Vec3i& dims, State state)
 {
-    cv::Vec3i pos;
-    for (int zOffset = 0; zOffset < dims[2]; zOffset++) {
-        for (int yOffset = 0; yOffset < dims[1]; yOffset++) {
-            for (int xOffset = 0; xOffset < dims[0]; xOffset++) {
-                pos[0] = origin[0] + xOffset;
-                pos[1] = origin[1] + yOffset;
-                pos[2] = origin[2] + zOffset;
-                setVoxelState(pos, state);
+    auto segment = state == State::Segmented;
+    for_each_brick_(origin, dims, [&](auto idx, auto min, auto max, auto) {
+        // Uniform bricks
+        if (CoversBrick(min, max)) {
+            if (segment) {
+                bricks_[idx] = Brick{{}, BRICK_VOXELS};
+            } else {
+                bricks_.erase(idx);
             }
+            return;
         }
-    }
+
+        auto it = bricks_.find(idx);
+        if (it == bricks_.end()) {
+            if (not segment) {
+                return;
+            }
+            it = bricks_.emplace(idx, Brick{}).first;
+            it->second.rows.assign(NUM_ROWS, 0);
+        }
+        auto& brick = it->second;
+        if (brick.full()) {
+            if (segment) {
+                return;
+            }
+            brick.rows.assign(NUM_ROWS, FULL_ROW);
+        }
+
+        // Update the covered rows
+        auto mask = RowMask(min[0], max[0]);
+        for (int z = min[2]; z < max[2]; z++) {
+            for (int y = min[1]; y < max[1]; y++) {
+                auto& row = brick.rows[RowIndex(y, z)];
+                auto before = PopCount(row);
+                row = segment ? row | mask : row & ~mask;
+                brick.count = brick.count + PopCount(row) - before;
+            }
+        }
+
+        // Collapse uniform bricks
+        if (brick.count == 0) {
+            bricks_.erase(it);
+        } else if (brick.full()) {
+            std::vector<std::uint32_t>().swap(brick.rows);
+        }
+    });
 }
 
-VolumeMask::State VolumeMask::getVoxelState(const cv::Vec3i& xyz)
+VolumeMask::State VolumeMask::getVoxelState(const cv::Vec3i& xyz) const
 {
-    return static_cast<State>(
-        states_.coeffRef(xyz[2] * sliceHeight_ + xyz[1], xyz[0]));
+    if (not in_bounds_(xyz)) {
+        return State::Unsegmented;
+    }
+    auto it = bricks_.find(brick_index_(xyz));
+    if (it == bricks_.end()) {
+        return State::Unsegmented;
+    }
+    const auto& brick = it->second;
+    if (brick.full()) {
+        return State::Segmented;
+    }
+    auto row = brick.rows[RowIndex(xyz[1] % BS, xyz[2] % BS)];
+    auto bit = (row >> (xyz[0] % BS)) & 1U;
+    return bit != 0 ? State::Segmented : State::Unsegmented;
 }
 
 VolumeMask::Subvolume VolumeMask::getSubvolumeState(
-    const cv::Vec3i& origin, const cv::Vec3i& dims)
+    const cv::Vec3i& origin, const cv::Vec3i& dims) const
 {
+    // Voxels default to unsegmented
     Subvolume result(3, dims[2], dims[1], dims[0]);
-    int u, v;
-    for (int zOffset = 0; zOffset < dims[2]; zOffset++) {
-        for (int yOffset = 0; yOffset < dims[1]; yOffset++) {
-            for (int xOffset = 0; xOffset < dims[0]; xOffset++) {
-                u = origin[0] + xOffset;
-                v = (origin[2] * sliceHeight_) + (zOffset * sliceHeight_) +
-                    (origin[1] + yOffset);
-                result(zOffset, yOffset, xOffset) =
-                    static_cast<State>(states_.coeffRef(v, u));
+    auto* data = result.data();
+    auto width = static_cast<std::size_t>(dims[0]);
+    auto height = static_cast<std::size_t>(dims[1]);
+
+    for_each_brick_(origin, dims, [&](auto idx, auto min, auto max, auto off) {
+        auto it = bricks_.find(idx);
+        if (it == bricks_.end()) {
+            return;
+        }
+        const auto& brick = it->second;
+        for (int z = min[2]; z < max[2]; z++) {
+            for (int y = min[1]; y < max[1]; y++) {
+                auto rz = static_cast<std::size_t>(z + off[2]);
+                auto ry = static_cast<std::size_t>(y + off[1]);
+                auto* out = data + (rz * height + ry) * width;
+                if (brick.full()) {
+                    std::fill(
+                        out + min[0] + off[0], out + max[0] + off[0],
+                        State::Segmented);
+                    continue;
+                }
+                auto row = brick.rows[RowIndex(y, z)];
+                for (int x = min[0]; x < max[0]; x++) {
+                    if (((row >> x) & 1U) != 0) {
+                        out[x + off[0]] = State::Segmented;
+                    }
+                }
             }
         }
-    }
+    });
 
     return result;
 }
+
+std::size_t VolumeMask::countSegmented(
+    const cv::Vec3i& origin, const cv::Vec3i& dims) const
+{
+    std::size_t count{0};
+    for_each_brick_(origin, dims, [&](auto idx, auto min, auto max, auto) {
+        auto it = bricks_.find(idx);
+        if (it == bricks_.end()) {
+            return;
+        }
+        const auto& brick = it->second;
+        if (brick.full()) {
+            count += Volume(min, max);
+            return;
+        }
+        if (CoversBrick(min, max)) {
+            count += brick.count;
+            return;
+        }
+        auto mask = RowMask(min[0], max[0]);
+        for (int z = min[2]; z < max[2]; z++) {
+            for (int y = min[1]; y < max[1]; y++) {
+                count += PopCount(brick.rows[RowIndex(y, z)] & mask);
+            }
+        }
+    });
+    return count;
+}
+
+std::size_t VolumeMask::countSegmented() const
+{
+    std::size_t count{0};
+    for (const auto& [idx, brick] : bricks_) {
+        count += brick.count;
+    }
+    return count;
+}
+
+void VolumeMask::merge(const VolumeMask& other)
+{
+    check_dims_(other);
+    for (const auto& [idx, ob] : other.bricks_) {
+        auto it = bricks_.find(idx);
+        if (it == bricks_.end() or ob.full()) {
+            bricks_[idx] = ob;
+            continue;
+        }
+        auto& brick = it->second;
+        if (brick.full()) {
+            continue;
+        }
+        brick.count = 0;
+        for (std::size_t r = 0; r < NUM_ROWS; r++) {
+            brick.rows[r] |= ob.rows[r];
+            brick.count += PopCount(brick.rows[r]);
+        }
+        if (brick.full()) {
+            std::vector<std::uint32_t>().swap(brick.rows);
+        }
+    }
+}
+
+void VolumeMask::intersect(const VolumeMask& other)
+{
+    check_dims_(other);
+    for (auto it = bricks_.begin(); it != bricks_.end();) {
+        auto ot = other.bricks_.find(it->first);
+        if (ot == other.bricks_.end()) {
+            it = bricks_.erase(it);
+            continue;
+        }
+        const auto& ob = ot->second;
+        auto& brick = it->second;
+        if (ob.full()) {
+            ++it;
+            continue;
+        }
+        if (brick.full()) {
+            brick = ob;
+            ++it;
+            continue;
+        }
+        brick.count = 0;
+        for (std::size_t r = 0; r < NUM_ROWS; r++) {
+            brick.rows[r] &= ob.rows[r];
+            brick.count += PopCount(brick.rows[r]);
+        }
+        it = (brick.count == 0) ? bricks_.erase(it) : std::next(it);
+    }
+}
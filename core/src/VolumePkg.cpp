@@ -1,6 +1,15 @@
 #include "vc/core/types/VolumePkg.hpp"
 
+#include <algorithm>
+#include <fstream>
+#include <set>
+
+#include <nlohmann/json.hpp>
+
 #include "vc/core/util/DateTime.hpp"
+#include "vc/core/util/Iteration.hpp"
+#include "vc/core/util/Logging.hpp"
+#include "vc/core/util/ThreadPool.hpp"
 
 using namespace volcart;
 
@@ -10,6 +19,78 @@ static const fs::path SUBPATH_META{"config.json"};
 static const fs::path SUBPATH_REND{"renders"};
 static const fs::path SUBPATH_SEGS{"paths"};
 static const fs::path SUBPATH_VOLS{"volumes"};
+static const fs::path SUBPATH_INDEX{"index.json"};
+
+// Version of the index file format
+static constexpr int INDEX_VERSION{1};
+
+namespace
+{
+// Index entry: object ID and name, keyed by subdirectory name
+struct IndexEntry {
+    std::string id;
+    std::string name;
+};
+using IndexSection = std::map<std::string, IndexEntry>;
+
+// Read a section of the index. Returns an empty section if the index is
+// missing or invalid.
+auto ReadIndexSection(const nlohmann::json& index, const std::string& key)
+    -> IndexSection
+{
+    IndexSection section;
+    if (not index.contains(key) or not index[key].is_array()) {
+        return section;
+    }
+    for (const auto& e : index[key]) {
+        section[e.at("dir").get<std::string>()] = {
+            e.at("id").get<std::string>(), e.at("name").get<std::string>()};
+    }
+    return section;
+}
+
+// Add the objects of a subdirectory to `objects`. Indexed subdirectories are
+// not read. Returns whether the index is out of date.
+template <class T, class Map>
+auto LoadObjects(const fs::path& dir, const IndexSection& section, Map& objects)
+    -> bool
+{
+    using Object = typename Map::mapped_type;
+    std::set<std::string> found;
+    bool stale{false};
+    for (const auto& entry : fs::directory_iterator(dir)) {
+        if (not fs::is_directory(entry)) {
+            continue;
+        }
+        auto dirName = entry.path().filename().string();
+        found.insert(dirName);
+        auto it = section.find(dirName);
+        if (it != section.end()) {
+            const auto& [id, name] = it->second;
+            objects.emplace(id, Object(entry.path(), name));
+        } else {
+            auto obj = T::New(entry.path());
+            objects.emplace(obj->id(), Object(obj));
+            stale = true;
+        }
+    }
+    return stale or found.size() != section.size();
+}
+
+// Write a section of the index
+template <class Map>
+auto WriteIndexSection(const Map& objects) -> nlohmann::json
+{
+    auto section = nlohmann::json::array();
+    for (const auto& [id, obj] : objects) {
+        section.push_back(
+            {{"dir", obj.path().filename().string()},
+             {"id", id},
+             {"name", obj.name()}});
+    }
+    return section;
+}
+}  // namespace
 
 // CONSTRUCTORS //
 // Make a volpkg of a particular version number
@@ -38,6 +119,7 @@ VolumePkg::VolumePkg(const fs::path& fileLocation, int version)
 
     // Do initial save
     config_.save();
+    write_index_();
 }
 
 // Use this when reading a volpkg from a file
@@ -56,29 +138,8 @@ VolumePkg::VolumePkg(const fs::path& fileLocation)
     // Loads the metadata
     config_ = Metadata(fileLocation / SUBPATH_META);
 
-    // Load volumes into volumes_ vector
-    for (const auto& entry : fs::directory_iterator(volsDir_)) {
-        if (fs::is_directory(entry)) {
-            auto v = Volume::New(entry);
-            volumes_.emplace(v->id(), v);
-        }
-    }
-
-    // Load segmentations into the segmentations_ vector
-    for (const auto& entry : fs::directory_iterator(segsDir_)) {
-        if (fs::is_directory(entry)) {
-            auto s = Segmentation::New(entry);
-            segmentations_.emplace(s->id(), s);
-        }
-    }
-
-    // Load Renders into the renders_ vector
-    for (const auto& entry : fs::directory_iterator(rendDir_)) {
-        if (fs::is_directory(entry)) {
-            auto r = Render::New(entry);
-            renders_.emplace(r->id(), r);
-        }
-    }
+    // Load the objects
+    load_objects_();
 }
 
 auto VolumePkg::New(fs::path fileLocation, int version) -> VolumePkg::Pointer
@@ -144,12 +205,13 @@ auto VolumePkg::volumeNames() const -> std::vector<std::string>
 {
     std::vector<Volume::Identifier> names;
     for (const auto& v : volumes_) {
-        names.emplace_back(v.second->name());
+        names.emplace_back(v.second.name());
     }
     return names;
 }
 
-auto VolumePkg::newVolume(std::string name) -> Volume::Pointer
+auto VolumePkg::newVolume(
+    std::string name, Volume::Format format, int blockSize) -> Volume::Pointer
 {
     // Generate a uuid
     auto uuid = DateTime();
@@ -168,14 +230,60 @@ auto VolumePkg::newVolume(std::string name) -> Volume::Pointer
     }
 
     // Make the volume
-    auto r = volumes_.emplace(uuid, Volume::New(volDir, uuid, name));
+    auto vol = Volume::New(volDir, uuid, name);
+    auto r = volumes_.emplace(uuid, LazyObject<Volume>(vol));
     if (!r.second) {
         auto msg = "Volume already exists with id " + uuid;
         throw std::runtime_error(msg);
     }
+    vol->setFormat(format, blockSize);
+    write_index_();
 
     // Return the Volume Pointer
-    return r.first->second;
+    return vol;
+}
+
+auto VolumePkg::newVolumeFromRegion(
+    const Volume::Pointer& src,
+    cv::Rect roi,
+    cv::Range slices,
+    std::string name,
+    Volume::Format format,
+    int blockSize) -> Volume::Pointer
+{
+    // Clip the region to the source volume
+    roi &= cv::Rect(0, 0, src->sliceWidth(), src->sliceHeight());
+    slices.start = std::max(slices.start, 0);
+    slices.end = std::min(slices.end, src->numSlices());
+    if (roi.empty() or slices.empty()) {
+        throw std::invalid_argument("Crop region is empty");
+    }
+
+    auto vol = newVolume(std::move(name), format, blockSize);
+    vol->setSliceWidth(roi.width);
+    vol->setSliceHeight(roi.height);
+    vol->setNumberOfSlices(static_cast<size_t>(slices.size()));
+    vol->setVoxelSize(src->voxelSize());
+    vol->setMin(src->min());
+    vol->setMax(src->max());
+    vol->setVoxelType(src->voxelType());
+    vol->setCompression(src->compression());
+    // Crops of crops map back to the original Volume
+    cv::Vec3i offset{roi.x, roi.y, slices.start};
+    if (src->hasCropOrigin()) {
+        vol->setCropOrigin(src->cropSourceID(), src->cropOffset() + offset);
+    } else {
+        vol->setCropOrigin(src->id(), offset);
+    }
+    vol->saveMetadata();
+
+    // Each task reads and writes its own slices
+    ParallelFor(range(slices.size()), [&](auto z) {
+        auto region = src->getSliceRegion(slices.start + z, roi);
+        vol->setSliceData(z, region);
+    });
+
+    return vol;
 }
 
 auto VolumePkg::volume() const -> const Volume::Pointer
@@ -183,7 +291,7 @@ auto VolumePkg::volume() const -> const Volume::Pointer
     if (volumes_.empty()) {
         throw std::out_of_range("No volumes in VolPkg");
     }
-    return volumes_.begin()->second;
+    return volumes_.begin()->second.get();
 }
 
 auto VolumePkg::volume() -> Volume::Pointer
@@ -191,18 +299,18 @@ auto VolumePkg::volume() -> Volume::Pointer
     if (volumes_.empty()) {
         throw std::out_of_range("No volumes in VolPkg");
     }
-    return volumes_.begin()->second;
+    return volumes_.begin()->second.get();
 }
 
 auto VolumePkg::volume(const Volume::Identifier& id) const
     -> const Volume::Pointer
 {
-    return volumes_.at(id);
+    return volumes_.at(id).get();
 }
 
 auto VolumePkg::volume(const Volume::Identifier& id) -> Volume::Pointer
 {
-    return volumes_.at(id);
+    return volumes_.at(id).get();
 }
 
 // SEGMENTATION FUNCTIONS //
@@ -216,13 +324,13 @@ auto VolumePkg::numberOfSegmentations() -> size_t
 auto VolumePkg::segmentation(const DiskBasedObjectBaseClass::Identifier& id)
     const -> const Segmentation::Pointer
 {
-    return segmentations_.at(id);
+    return segmentations_.at(id).get();
 }
 
 auto VolumePkg::segmentation(const DiskBasedObjectBaseClass::Identifier& id)
     -> Segmentation::Pointer
 {
-    return segmentations_.at(id);
+    return segmentations_.at(id).get();
 }
 
 auto VolumePkg::segmentationIDs() const -> std::vector<Segmentation::Identifier>
@@ -238,7 +346,7 @@ auto VolumePkg::segmentationNames() const -> std::vector<std::string>
 {
     std::vector<std::string> names;
     for (const auto& s : segmentations_) {
-        names.emplace_back(s.second->name());
+        names.emplace_back(s.second.name());
     }
     return names;
 }
@@ -265,15 +373,16 @@ auto VolumePkg::newSegmentation(std::string name) -> Segmentation::Pointer
     }
 
     // Make the Segmentation
-    auto r =
-        segmentations_.emplace(uuid, Segmentation::New(segDir, uuid, name));
+    auto seg = Segmentation::New(segDir, uuid, name);
+    auto r = segmentations_.emplace(uuid, LazyObject<Segmentation>(seg));
     if (!r.second) {
         auto msg = "Segmentation already exists with id " + uuid;
         throw std::runtime_error(msg);
     }
+    write_index_();
 
     // Return the Segmentation Pointer
-    return r.first->second;
+    return seg;
 }
 
 // RENDER FUNCTIONS //
@@ -282,12 +391,12 @@ auto VolumePkg::numberOfRenders() -> size_t { return renders_.size(); }
 auto VolumePkg::render(const DiskBasedObjectBaseClass::Identifier& id) const
     -> const Render::Pointer
 {
-    return renders_.at(id);
+    return renders_.at(id).get();
 }
 auto VolumePkg::render(const DiskBasedObjectBaseClass::Identifier& id)
     -> Render::Pointer
 {
-    return renders_.at(id);
+    return renders_.at(id).get();
 }
 
 auto VolumePkg::renderIDs() const -> std::vector<Render::Identifier>
@@ -303,7 +412,7 @@ auto VolumePkg::renderNames() const -> std::vector<std::string>
 {
     std::vector<std::string> names;
     for (const auto& r : renders_) {
-        names.emplace_back(r.second->name());
+        names.emplace_back(r.second.name());
     }
     return names;
 }
@@ -329,14 +438,87 @@ auto VolumePkg::newRender(std::string name) -> Render::Pointer
     }
 
     // Make the Render
-    auto r = renders_.emplace(uuid, Render::New(renDir, uuid, name));
+    auto render = Render::New(renDir, uuid, name);
+    auto r = renders_.emplace(uuid, LazyObject<Render>(render));
     if (!r.second) {
         auto msg = "Render already exists with id " + uuid;
         throw std::runtime_error(msg);
     }
+    write_index_();
 
     // Return the Render Pointer
-    return r.first->second;
+    return render;
+}
+
+void VolumePkg::load_objects_()
+{
+    // Read the index
+    nlohmann::json index;
+    auto indexPath = rootDir_ / SUBPATH_INDEX;
+    if (fs::exists(indexPath)) {
+        try {
+            std::ifstream file(indexPath.string());
+            index = nlohmann::json::parse(file);
+            if (index.value("version", 0) != INDEX_VERSION) {
+                index = nlohmann::json();
+            }
+        } catch (const std::exception& e) {
+            Logger()->warn("Ignoring invalid VolumePkg index: {}", e.what());
+            index = nlohmann::json();
+        }
+    }
+
+    IndexSection vols;
+    IndexSection segs;
+    IndexSection rends;
+    try {
+        vols = ReadIndexSection(index, SUBPATH_VOLS.string());
+        segs = ReadIndexSection(index, SUBPATH_SEGS.string());
+        rends = ReadIndexSection(index, SUBPATH_REND.string());
+    } catch (const std::exception& e) {
+        Logger()->warn("Ignoring invalid VolumePkg index: {}", e.what());
+        vols.clear();
+        segs.clear();
+        rends.clear();
+    }
+
+    // List the objects, reading only the unindexed ones
+    auto stale = LoadObjects<Volume>(volsDir_, vols, volumes_);
+    stale |= LoadObjects<Segmentation>(segsDir_, segs, segmentations_);
+    stale |= LoadObjects<Render>(rendDir_, rends, renders_);
+    if (stale) {
+        write_index_();
+    }
+}
+
+void VolumePkg::write_index_() const
+{
+    nlohmann::json index;
+    index["version"] = INDEX_VERSION;
+    index[SUBPATH_VOLS.string()] = WriteIndexSection(volumes_);
+    index[SUBPATH_SEGS.string()] = WriteIndexSection(segmentations_);
+    index[SUBPATH_REND.string()] = WriteIndexSection(renders_);
+
+    // Write to a temporary file first so that readers never see a partial
+    // index
+    auto indexPath = rootDir_ / SUBPATH_INDEX;
+    auto tmpPath = indexPath;
+    tmpPath += ".tmp";
+    try {
+        {
+            std::ofstream file(tmpPath.string());
+            if (not file) {
+                throw std::runtime_error("could not open " + tmpPath.string());
+            }
+            file << index.dump(2) << std::endl;
+            if (not file) {
+                throw std::runtime_error("could not write " + tmpPath.string());
+            }
+        }
+        fs::rename(tmpPath, indexPath);
+    } catch (const std::exception& e) {
+        Logger()->warn("Could not write VolumePkg index: {}", e.what());
+    }
 }
 
 auto VolumePkg::InitConfig(const Dictionary& dict, int version) -> Metadata
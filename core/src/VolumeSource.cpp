@@ -0,0 +1,86 @@
+#include "vc/core/io/VolumeSource.hpp"
+
+#include <fstream>
+
+#include "vc/core/io/HTTPVolumeSource.hpp"
+#include "vc/core/types/Exceptions.hpp"
+
+using namespace volcart;
+using namespace volcart::io;
+
+namespace fs = volcart::filesystem;
+
+// Whether a string starts with a prefix
+static auto StartsWith(const std::string& s, const std::string& prefix)
+    -> bool
+{
+    return s.compare(0, prefix.size(), prefix) == 0;
+}
+
+auto VolumeSource::Open(const std::string& uri, const fs::path& base)
+    -> Pointer
+{
+    if (StartsWith(uri, "http://") or StartsWith(uri, "https://") or
+        StartsWith(uri, "s3://")) {
+        return HTTPVolumeSource::New(uri);
+    }
+
+    const std::string fileScheme{"file://"};
+    fs::path root{StartsWith(uri, fileScheme) ? uri.substr(fileScheme.size())
+                                              : uri};
+    if (root.is_relative() and not base.empty()) {
+        root = base / root;
+    }
+    return LocalVolumeSource::New(root);
+}
+
+void VolumeSource::readAsync(
+    const std::string& name, AsyncReader& reader, AsyncReader::Callback done)
+{
+    reader.submit([this, name]() { return read(name); }, std::move(done));
+}
+
+LocalVolumeSource::LocalVolumeSource(fs::path root) : root_{std::move(root)}
+{
+}
+
+auto LocalVolumeSource::New(fs::path root) -> Pointer
+{
+    return std::make_shared<LocalVolumeSource>(std::move(root));
+}
+
+auto LocalVolumeSource::root() const -> fs::path { return root_; }
+
+auto LocalVolumeSource::read(const std::string& name)
+    -> std::optional<std::vector<char>>
+{
+    auto path = root_ / name;
+    std::ifstream file(path.string(), std::ios::binary | std::ios::ate);
+    if (not file) {
+        if (not fs::exists(path)) {
+            return std::nullopt;
+        }
+        throw IOException("Failed to open file: " + path.string());
+    }
+
+    std::vector<char> data(static_cast<std::size_t>(file.tellg()));
+    file.seekg(0);
+    file.read(data.data(), static_cast<std::streamsize>(data.size()));
+    if (not file) {
+        throw IOException("Failed to read file: " + path.string());
+    }
+    return data;
+}
+
+void LocalVolumeSource::readAsync(
+    const std::string& name, AsyncReader& reader, AsyncReader::Callback done)
+{
+    reader.read(root_ / name, std::move(done));
+}
+
+auto LocalVolumeSource::stamp(const std::string& name) -> DiskCache::Stamp
+{
+    return DiskCache::SourceStamp(root_ / name);
+}
+
+auto LocalVolumeSource::uri() const -> std::string { return root_.string(); }
@@ -0,0 +1,200 @@
+#include "vc/core/types/VolumeStatistics.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+using namespace volcart;
+
+std::vector<double> VolumeStatistics::DefaultPercentiles()
+{
+    return {0.1, 1, 5, 25, 50, 75, 95, 99, 99.9};
+}
+
+VolumeStatistics::VolumeStatistics() : histogram_(NUM_BINS, 0) {}
+
+void VolumeStatistics::addSlice(int index, const cv::Mat& slice)
+{
+    if (slice.type() != CV_16UC1) {
+        throw std::invalid_argument("Statistics require a CV_16UC1 slice");
+    }
+    if (index < 0) {
+        throw std::out_of_range("Slice index is negative");
+    }
+
+    std::uint16_t min{std::numeric_limits<std::uint16_t>::max()};
+    std::uint16_t max{0};
+    std::uint64_t sum{0};
+    for (int y = 0; y < slice.rows; y++) {
+        const auto* row = slice.ptr<std::uint16_t>(y);
+        for (int x = 0; x < slice.cols; x++) {
+            auto v = row[x];
+            histogram_[v]++;
+            min = std::min(min, v);
+            max = std::max(max, v);
+            sum += v;
+        }
+    }
+
+    if (static_cast<std::size_t>(index) >= slices_.size()) {
+        slices_.resize(index + 1);
+    }
+    auto& s = slices_[index];
+    if (slice.total() == 0) {
+        s = SliceStatistics{0, 0, 0, true};
+    } else {
+        s.min = min;
+        s.max = max;
+        s.mean = static_cast<double>(sum) / static_cast<double>(slice.total());
+        s.valid = true;
+    }
+}
+
+void VolumeStatistics::merge(const VolumeStatistics& other)
+{
+    for (std::size_t i = 0; i < NUM_BINS; i++) {
+        histogram_[i] += other.histogram_[i];
+    }
+
+    if (other.slices_.size() > slices_.size()) {
+        slices_.resize(other.slices_.size());
+    }
+    for (std::size_t i = 0; i < other.slices_.size(); i++) {
+        if (other.slices_[i].valid) {
+            slices_[i] = other.slices_[i];
+        }
+    }
+}
+
+std::uint64_t VolumeStatistics::count() const
+{
+    std::uint64_t count{0};
+    for (const auto& c : histogram_) {
+        count += c;
+    }
+    return count;
+}
+
+double VolumeStatistics::min() const
+{
+    auto it = std::find_if(
+        histogram_.begin(), histogram_.end(), [](auto c) { return c > 0; });
+    if (it == histogram_.end()) {
+        return 0;
+    }
+    return static_cast<double>(std::distance(histogram_.begin(), it));
+}
+
+double VolumeStatistics::max() const
+{
+    auto it = std::find_if(
+        histogram_.rbegin(), histogram_.rend(), [](auto c) { return c > 0; });
+    if (it == histogram_.rend()) {
+        return 0;
+    }
+    return static_cast<double>(std::distance(it, histogram_.rend()) - 1);
+}
+
+double VolumeStatistics::mean() const
+{
+    double sum{0};
+    std::uint64_t count{0};
+    for (std::size_t i = 0; i < NUM_BINS; i++) {
+        sum += static_cast<double>(i) * static_cast<double>(histogram_[i]);
+        count += histogram_[i];
+    }
+    return (count == 0) ? 0 : sum / static_cast<double>(count);
+}
+
+double VolumeStatistics::percentile(double p) const
+{
+    auto total = count();
+    if (total == 0) {
+        return 0;
+    }
+
+    p = std::clamp(p, 0.0, 100.0);
+    auto target = static_cast<std::uint64_t>(
+        std::ceil(p / 100.0 * static_cast<double>(total)));
+    target = std::max<std::uint64_t>(target, 1);
+    std::uint64_t seen{0};
+    for (std::size_t i = 0; i < NUM_BINS; i++) {
+        seen += histogram_[i];
+        if (seen >= target) {
+            return static_cast<double>(i);
+        }
+    }
+    return max();
+}
+
+const std::vector<std::uint64_t>& VolumeStatistics::histogram() const
+{
+    return histogram_;
+}
+
+const std::vector<VolumeStatistics::SliceStatistics>&
+VolumeStatistics::slices() const
+{
+    return slices_;
+}
+
+void volcart::to_json(nlohmann::json& j, const VolumeStatistics& s)
+{
+    auto mins = nlohmann::json::array();
+    auto maxs = nlohmann::json::array();
+    auto means = nlohmann::json::array();
+    for (const auto& slice : s.slices()) {
+        if (slice.valid) {
+            mins.push_back(slice.min);
+            maxs.push_back(slice.max);
+            means.push_back(slice.mean);
+        } else {
+            mins.push_back(nullptr);
+            maxs.push_back(nullptr);
+            means.push_back(nullptr);
+        }
+    }
+
+    auto percentiles = nlohmann::json::object();
+    for (const auto& p : VolumeStatistics::DefaultPercentiles()) {
+        std::ostringstream key;
+        key << p;
+        percentiles[key.str()] = s.percentile(p);
+    }
+
+    j = {{"count", s.count()},
+         {"min", s.min()},
+         {"max", s.max()},
+         {"mean", s.mean()},
+         {"percentiles", percentiles},
+         {"slices", {{"min", mins}, {"max", maxs}, {"mean", means}}},
+         {"histogram", s.histogram()}};
+}
+
+void volcart::from_json(const nlohmann::json& j, VolumeStatistics& s)
+{
+    auto histogram = j.at("histogram").get<std::vector<std::uint64_t>>();
+    if (histogram.size() != VolumeStatistics::NUM_BINS) {
+        throw std::runtime_error("Volume histogram has wrong number of bins");
+    }
+    s.histogram_ = std::move(histogram);
+
+    const auto& slices = j.at("slices");
+    const auto& mins = slices.at("min");
+    const auto& maxs = slices.at("max");
+    const auto& means = slices.at("mean");
+    s.slices_.assign(mins.size(), {});
+    for (std::size_t i = 0; i < mins.size(); i++) {
+        if (mins[i].is_null()) {
+            continue;
+        }
+        auto& slice = s.slices_[i];
+        slice.min = mins[i].get<double>();
+        slice.max = maxs.at(i).get<double>();
+        slice.mean = means.at(i).get<double>();
+        slice.valid = true;
+    }
+}
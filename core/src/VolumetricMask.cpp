@@ -1,14 +1,126 @@
 #include "vc/core/types/VolumetricMask.hpp"
 
+#include <cmath>
+
 using namespace volcart;
 
-void VolumetricMask::setIn(const Voxel& v) { mask_.insert(v); }
+using Block = VolumetricMask::Block;
+using Voxel = VolumetricMask::Voxel;
+
+namespace
+{
+constexpr auto BS = VolumetricMask::BLOCK_SIZE;
+
+// Floor division by the block size, correct for negative coordinates
+auto BlockCoord(int v) -> int { return (v < 0) ? (v - BS + 1) / BS : v / BS; }
+
+// Block position of a voxel
+auto BlockPos(const Voxel& v) -> Voxel
+{
+    return {BlockCoord(v[0]), BlockCoord(v[1]), BlockCoord(v[2])};
+}
+
+// Index of a voxel's bit within its block
+auto BitIndex(const Voxel& v, const Voxel& block) -> std::size_t
+{
+    auto x = static_cast<std::size_t>(v[0] - block[0] * BS);
+    auto y = static_cast<std::size_t>(v[1] - block[1] * BS);
+    auto z = static_cast<std::size_t>(v[2] - block[2] * BS);
+    return (z * BS + y) * BS + x;
+}
+
+// Index of the lowest set bit. Word must be non-zero.
+auto LowestBit(std::uint64_t word) -> std::size_t
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return static_cast<std::size_t>(__builtin_ctzll(word));
+#else
+    std::size_t idx{0};
+    while ((word & 1) == 0) {
+        word >>= 1;
+        ++idx;
+    }
+    return idx;
+#endif
+}
+
+// Number of set bits
+auto PopCount(std::uint64_t word) -> std::size_t
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return static_cast<std::size_t>(__builtin_popcountll(word));
+#else
+    std::size_t count{0};
+    for (; word != 0; word &= word - 1) {
+        ++count;
+    }
+    return count;
+#endif
+}
+}  // namespace
+
+void VolumetricMask::setIn(const Voxel& v)
+{
+    auto pos = BlockPos(v);
+    auto idx = BitIndex(v, pos);
+    auto numBlocks = blocks_.size();
+    auto& block = blocks_[pos];
+    auto& word = block.bits[idx / 64];
+    auto bit = std::uint64_t{1} << (idx % 64);
+    if ((word & bit) == 0) {
+        word |= bit;
+        ++block.count;
+        ++size_;
+    }
+    if (blocks_.size() != numBlocks) {
+        update_memory_();
+    }
+}
 
-void VolumetricMask::setOut(const Voxel& v) { mask_.erase(v); }
+void VolumetricMask::setOut(const Voxel& v)
+{
+    auto pos = BlockPos(v);
+    auto it = blocks_.find(pos);
+    if (it == blocks_.end()) {
+        return;
+    }
+
+    auto idx = BitIndex(v, pos);
+    auto& block = it->second;
+    auto& word = block.bits[idx / 64];
+    auto bit = std::uint64_t{1} << (idx % 64);
+    if ((word & bit) != 0) {
+        word &= ~bit;
+        --block.count;
+        --size_;
+        if (block.count == 0) {
+            blocks_.erase(it);
+            update_memory_();
+        }
+    }
+}
+
+void VolumetricMask::setIn(const cv::Mat& sliceMask, int z)
+{
+    for (int y = 0; y < sliceMask.rows; ++y) {
+        const auto* row = sliceMask.ptr<std::uint8_t>(y);
+        for (int x = 0; x < sliceMask.cols; ++x) {
+            if (row[x] > 0) {
+                setIn({x, y, z});
+            }
+        }
+    }
+}
 
 auto VolumetricMask::isIn(const Voxel& v) const -> bool
 {
-    return mask_.count(v) > 0;
+    auto pos = BlockPos(v);
+    auto it = blocks_.find(pos);
+    if (it == blocks_.end()) {
+        return false;
+    }
+    auto idx = BitIndex(v, pos);
+    return ((it->second.bits[idx / 64] >> (idx % 64)) & 1) != 0;
 }
 
 auto VolumetricMask::isOut(const Voxel& v) const -> bool { return not isIn(v); }
@@ -26,41 +138,166 @@ auto VolumetricMask::isOut(const cv::Vec3d& v) const -> bool
     return not isIn(v);
 }
 
-auto VolumetricMask::begin() noexcept -> VolumetricMask::iterator
+auto VolumetricMask::begin() const noexcept -> VolumetricMask::const_iterator
 {
-    return mask_.begin();
+    return {blocks_.begin(), blocks_.end()};
 }
 
-auto VolumetricMask::begin() const noexcept -> VolumetricMask::const_iterator
+auto VolumetricMask::cbegin() const noexcept -> VolumetricMask::const_iterator
 {
-    return mask_.begin();
+    return begin();
 }
 
-auto VolumetricMask::cbegin() const noexcept -> VolumetricMask::const_iterator
+auto VolumetricMask::end() const noexcept -> VolumetricMask::const_iterator
 {
-    return mask_.cbegin();
+    return {blocks_.end(), blocks_.end()};
 }
 
-auto VolumetricMask::end() noexcept -> VolumetricMask::iterator
+auto VolumetricMask::cend() const noexcept -> VolumetricMask::const_iterator
 {
-    return mask_.end();
+    return end();
 }
 
-auto VolumetricMask::end() const noexcept -> VolumetricMask::const_iterator
+void VolumetricMask::merge(const VolumetricMask& other)
 {
-    return mask_.end();
+    for (const auto& [pos, src] : other.blocks_) {
+        auto& dst = blocks_[pos];
+        size_ -= dst.count;
+        dst.count = 0;
+        for (std::size_t i = 0; i < BLOCK_WORDS; ++i) {
+            dst.bits[i] |= src.bits[i];
+            dst.count += PopCount(dst.bits[i]);
+        }
+        size_ += dst.count;
+    }
+    update_memory_();
 }
 
-auto VolumetricMask::cend() const noexcept -> VolumetricMask::const_iterator
+void VolumetricMask::clear()
 {
-    return mask_.end();
+    blocks_.clear();
+    size_ = 0;
+    update_memory_();
 }
 
-void VolumetricMask::clear() { mask_.clear(); }
+auto VolumetricMask::empty() const -> bool { return size_ == 0; }
 
-auto VolumetricMask::empty() const -> bool { return mask_.empty(); }
+auto VolumetricMask::size() const -> std::size_t { return size_; }
 
 auto VolumetricMask::as_vector() const -> std::vector<VolumetricMask::Voxel>
 {
-    return {mask_.begin(), mask_.end()};
+    std::vector<Voxel> voxels;
+    voxels.reserve(size_);
+    voxels.insert(voxels.end(), begin(), end());
+    return voxels;
+}
+
+auto VolumetricMask::numBlocks() const -> std::size_t { return blocks_.size(); }
+
+auto VolumetricMask::getBlock(const Voxel& pos) const -> const Block*
+{
+    auto it = blocks_.find(pos);
+    if (it == blocks_.end()) {
+        return nullptr;
+    }
+    return &it->second;
+}
+
+void VolumetricMask::setBlock(const Voxel& pos, const Block& block)
+{
+    // Remove the existing block
+    auto it = blocks_.find(pos);
+    if (it != blocks_.end()) {
+        size_ -= it->second.count;
+        blocks_.erase(it);
+    }
+
+    // Recount so that the stored count always matches the bits
+    Block b{block.bits, 0};
+    for (const auto& word : b.bits) {
+        b.count += PopCount(word);
+    }
+    if (b.count > 0) {
+        size_ += b.count;
+        blocks_.emplace(pos, b);
+    }
+    update_memory_();
+}
+
+auto VolumetricMask::blockPositions() const -> std::vector<Voxel>
+{
+    std::vector<Voxel> positions;
+    positions.reserve(blocks_.size());
+    for (const auto& b : blocks_) {
+        positions.push_back(b.first);
+    }
+    return positions;
+}
+
+void VolumetricMask::update_memory_()
+{
+    memory_.set(blocks_.size() * sizeof(BlockMap::value_type));
+}
+
+///// Iterator /////
+VolumetricMask::ConstIterator::ConstIterator(
+    BlockMap::const_iterator it, BlockMap::const_iterator end)
+    : it_{it}, end_{end}
+{
+    if (it_ != end_) {
+        bits_ = it_->second.bits[0];
+        find_next_();
+    }
+}
+
+void VolumetricMask::ConstIterator::find_next_()
+{
+    while (bits_ == 0) {
+        if (++word_ == BLOCK_WORDS) {
+            word_ = 0;
+            if (++it_ == end_) {
+                return;
+            }
+        }
+        bits_ = it_->second.bits[word_];
+    }
+}
+
+auto VolumetricMask::ConstIterator::operator*() const -> Voxel
+{
+    auto idx = word_ * 64 + LowestBit(bits_);
+    auto x = static_cast<int>(idx % BS);
+    auto y = static_cast<int>((idx / BS) % BS);
+    auto z = static_cast<int>(idx / (BS * BS));
+    const auto& pos = it_->first;
+    return {pos[0] * BS + x, pos[1] * BS + y, pos[2] * BS + z};
+}
+
+auto VolumetricMask::ConstIterator::operator++() -> ConstIterator&
+{
+    bits_ &= bits_ - 1;
+    find_next_();
+    return *this;
+}
+
+auto VolumetricMask::ConstIterator::operator++(int) -> ConstIterator
+{
+    auto tmp = *this;
+    ++(*this);
+    return tmp;
+}
+
+auto VolumetricMask::ConstIterator::operator==(const ConstIterator& o) const
+    -> bool
+{
+    if (it_ != o.it_) {
+        return false;
+    }
+    return it_ == end_ or (word_ == o.word_ and bits_ == o.bits_);
+}
+
+auto VolumetricMask::ConstIterator::operator!=(const ConstIterator& o) const
+    -> bool
+{
+    return not(*this == o);
 }
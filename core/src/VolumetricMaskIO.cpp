@@ -0,0 +1,164 @@
+#include "vc/core/io/VolumetricMaskIO.hpp"
+
+#include <fstream>
+#include <regex>
+#include <sstream>
+
+#include "vc/core/types/Exceptions.hpp"
+#include "vc/core/util/Iteration.hpp"
+#include "vc/core/util/String.hpp"
+
+using namespace volcart;
+using namespace volcart::io;
+
+namespace fs = volcart::filesystem;
+namespace vio = volcart::io;
+
+using Block = VolumetricMask::Block;
+
+void vio::WriteVolumetricMask(
+    const fs::path& path, const VolumetricMask& mask)
+{
+    std::ofstream outfile{path.string(), std::ios::binary};
+    if (!outfile.is_open()) {
+        auto msg = "could not open file '" + path.string() + "'";
+        throw IOException(msg);
+    }
+
+    // Header
+    auto positions = mask.blockPositions();
+    std::stringstream ss;
+    ss << "filetype: volumetric mask" << std::endl;
+    ss << "version: 1" << std::endl;
+    ss << "block size: " << VolumetricMask::BLOCK_SIZE << std::endl;
+    ss << "blocks: " << positions.size() << std::endl;
+    ss << "size: " << mask.size() << std::endl;
+    ss << "<>" << std::endl;
+    outfile << ss.rdbuf();
+
+    // Write the blocks
+    for (const auto& pos : positions) {
+        const auto* block = mask.getBlock(pos);
+        outfile.write(reinterpret_cast<const char*>(pos.val), sizeof(pos.val));
+        outfile.write(
+            reinterpret_cast<const char*>(block->bits.data()),
+            sizeof(block->bits));
+    }
+
+    outfile.close();
+}
+
+auto vio::ReadVolumetricMask(const fs::path& path) -> VolumetricMask
+{
+    std::ifstream infile{path.string(), std::ios::binary};
+    if (!infile.is_open()) {
+        auto msg = "could not open file '" + path.string() + "'";
+        throw IOException(msg);
+    }
+
+    struct Header {
+        std::string fileType;
+        int blockSize{0};
+        std::size_t blocks{0};
+        std::size_t size{0};
+    };
+
+    // Regexes
+    std::regex comments{"^#"};
+    std::regex fileType{"^filetype"};
+    std::regex version{"^version"};
+    std::regex blockSize{"^block size"};
+    std::regex blocks{"^blocks"};
+    std::regex size{"^size"};
+    std::regex headerTerminator{"^<>$"};
+
+    Header h;
+    std::string line;
+    while (std::getline(infile, line)) {
+        trim(line);
+        auto strs = split(line, ':');
+        std::for_each(
+            std::begin(strs), std::end(strs), [](auto& s) { trim(s); });
+
+        // Comments
+        if (std::regex_match(strs[0], comments)) {
+            continue;
+        }
+
+        // File type
+        else if (std::regex_match(strs[0], fileType)) {
+            if (strs[1] != "volumetric mask") {
+                throw IOException(
+                    "File mismatch. File is not a VolumetricMask.");
+            }
+            h.fileType = strs[1];
+        }
+
+        // Version
+        else if (std::regex_match(strs[0], version)) {
+            auto fileVersion = std::stoi(strs[1]);
+            if (fileVersion != 1) {
+                auto msg = "Version mismatch. VolumetricMask file version is " +
+                           strs[1] + ", processing version is 1.";
+                throw IOException(msg);
+            }
+        }
+
+        // Block size
+        else if (std::regex_match(strs[0], blockSize)) {
+            h.blockSize = std::stoi(strs[1]);
+        }
+
+        // Number of blocks
+        else if (std::regex_match(strs[0], blocks)) {
+            h.blocks = std::stoul(strs[1]);
+        }
+
+        // Number of voxels
+        else if (std::regex_match(strs[0], size)) {
+            h.size = std::stoul(strs[1]);
+        }
+
+        // End of the header
+        else if (std::regex_match(line, headerTerminator)) {
+            break;
+        }
+
+        // Ignore everything else
+        else {
+            continue;
+        }
+        strs.clear();
+    }
+
+    // Sanity check. Do we have a valid header?
+    if (h.fileType.empty()) {
+        throw IOException("Must provide file type");
+    } else if (h.blockSize != VolumetricMask::BLOCK_SIZE) {
+        auto msg = "Block size mismatch. File block size is " +
+                   std::to_string(h.blockSize) + ", processing block size is " +
+                   std::to_string(VolumetricMask::BLOCK_SIZE) + ".";
+        throw IOException(msg);
+    }
+
+    // Read all of the blocks
+    VolumetricMask mask;
+    for (const auto& i : range(h.blocks)) {
+        std::ignore = i;
+        VolumetricMask::Voxel pos;
+        Block block;
+        infile.read(reinterpret_cast<char*>(pos.val), sizeof(pos.val));
+        infile.read(
+            reinterpret_cast<char*>(block.bits.data()), sizeof(block.bits));
+        if (!infile) {
+            throw IOException("VolumetricMask file is truncated");
+        }
+        mask.setBlock(pos, block);
+    }
+
+    if (mask.size() != h.size) {
+        throw IOException("VolumetricMask size does not match header");
+    }
+
+    return mask;
+}
@@ -0,0 +1,421 @@
+#include "vc/core/io/ZarrArray.hpp"
+
+#include <cstring>
+
+#include <nlohmann/json.hpp>
+#include <zlib.h>
+
+#ifdef VC_HAS_ZSTD
+#include <zstd.h>
+#endif
+#ifdef VC_HAS_BLOSC
+#include <blosc.h>
+#endif
+
+#include "vc/core/types/Exceptions.hpp"
+#include "vc/core/util/ImageConversion.hpp"
+
+using namespace volcart;
+using namespace volcart::io;
+
+using json = nlohmann::json;
+
+static const std::string ZARR_ARRAY_FILE{".zarray"};
+static const std::string ZARR_ATTRS_FILE{".zattrs"};
+static const std::string N5_ATTRS_FILE{"attributes.json"};
+
+// Join an array path and a name, omitting the separator for the root
+static auto Join(const std::string& path, const std::string& name)
+    -> std::string
+{
+    return path.empty() ? name : path + "/" + name;
+}
+
+// Read a JSON object from a source. Returns null if it does not exist.
+static auto ReadJSON(VolumeSource& source, const std::string& name) -> json
+{
+    auto data = source.read(name);
+    if (not data) {
+        return nullptr;
+    }
+    try {
+        return json::parse(data->begin(), data->end());
+    } catch (const json::exception& e) {
+        throw IOException(
+            "Failed to parse " + source.uri() + "/" + name + ": " + e.what());
+    }
+}
+
+// Get a chunk compressor from its Zarr (numcodecs) or N5 name
+static auto CompressorFromString(const std::string& s) -> ZarrArray::Compressor
+{
+    if (s.empty() or s == "raw") {
+        return ZarrArray::Compressor::None;
+    }
+    if (s == "zlib" or s == "gzip") {
+        return ZarrArray::Compressor::Zlib;
+    }
+    if (s == "zstd") {
+#ifndef VC_HAS_ZSTD
+        throw IOException(
+            "zstd chunks require zstd support. Rebuild with VC_WITH_ZSTD.");
+#endif
+        return ZarrArray::Compressor::Zstd;
+    }
+    if (s == "blosc") {
+#ifndef VC_HAS_BLOSC
+        throw IOException(
+            "blosc chunks require blosc support. Rebuild with VC_WITH_BLOSC.");
+#endif
+        return ZarrArray::Compressor::Blosc;
+    }
+    throw IOException("Unsupported chunk compressor: " + s);
+}
+
+// Decompress a chunk whose decompressed size is known
+static auto Decompress(
+    ZarrArray::Compressor c, const char* data, std::size_t size, std::size_t n)
+    -> std::vector<char>
+{
+    std::vector<char> out(n);
+    switch (c) {
+        case ZarrArray::Compressor::None:
+            if (size < n) {
+                throw IOException("Chunk is truncated");
+            }
+            std::memcpy(out.data(), data, n);
+            break;
+        case ZarrArray::Compressor::Zlib: {
+            z_stream zs{};
+            // Detect zlib and gzip headers
+            if (inflateInit2(&zs, 15 + 32) != Z_OK) {
+                throw IOException("Failed to initialize zlib");
+            }
+            zs.next_in =
+                reinterpret_cast<Bytef*>(const_cast<char*>(data));
+            zs.avail_in = static_cast<uInt>(size);
+            zs.next_out = reinterpret_cast<Bytef*>(out.data());
+            zs.avail_out = static_cast<uInt>(n);
+            auto res = inflate(&zs, Z_FINISH);
+            auto written = zs.total_out;
+            inflateEnd(&zs);
+            if ((res != Z_STREAM_END and res != Z_BUF_ERROR) or written != n) {
+                throw IOException("Failed to decompress zlib chunk");
+            }
+            break;
+        }
+        case ZarrArray::Compressor::Zstd: {
+#ifdef VC_HAS_ZSTD
+            auto res = ZSTD_decompress(out.data(), n, data, size);
+            if (ZSTD_isError(res) != 0 or res != n) {
+                throw IOException("Failed to decompress zstd chunk");
+            }
+#endif
+            break;
+        }
+        case ZarrArray::Compressor::Blosc: {
+#ifdef VC_HAS_BLOSC
+            auto res = blosc_decompress_ctx(
+                data, out.data(), n, /*numinternalthreads=*/1);
+            if (res < 0 or static_cast<std::size_t>(res) != n) {
+                throw IOException("Failed to decompress blosc chunk");
+            }
+#endif
+            break;
+        }
+    }
+    return out;
+}
+
+// Read a big-endian integer
+template <typename T>
+static auto ReadBigEndian(const char* p) -> T
+{
+    T v{0};
+    for (std::size_t i = 0; i < sizeof(T); i++) {
+        v = static_cast<T>(v << 8) | static_cast<unsigned char>(p[i]);
+    }
+    return v;
+}
+
+// Get the (x, y, z) dimensions from the trailing entries of a ZYX array
+static auto TrailingXYZ(const json& dims) -> cv::Vec3i
+{
+    auto n = dims.size();
+    return {
+        dims[n - 1].get<int>(), dims[n - 2].get<int>(),
+        dims[n - 3].get<int>()};
+}
+
+ZarrArray::ZarrArray(VolumeSource::Pointer source, std::string path)
+    : source_{std::move(source)}, path_{std::move(path)}
+{
+    while (not path_.empty() and path_.back() == '/') {
+        path_.pop_back();
+    }
+
+    if (auto zarray = source_->read(Join(path_, ZARR_ARRAY_FILE))) {
+        parse_zarr_({zarray->begin(), zarray->end()});
+    } else if (auto attrs = source_->read(Join(path_, N5_ATTRS_FILE))) {
+        parse_n5_({attrs->begin(), attrs->end()});
+    } else {
+        throw IOException(
+            "Not a Zarr or N5 array: " + Join(source_->uri(), path_));
+    }
+
+    for (int i = 0; i < 3; i++) {
+        if (shape_[i] <= 0 or chunks_[i] <= 0) {
+            throw IOException("Invalid array or chunk shape");
+        }
+    }
+}
+
+auto ZarrArray::New(VolumeSource::Pointer source, std::string path)
+    -> Pointer
+{
+    return std::make_shared<ZarrArray>(std::move(source), std::move(path));
+}
+
+void ZarrArray::parse_zarr_(const std::string& text)
+{
+    layout_ = Layout::Zarr;
+    try {
+        auto j = json::parse(text);
+        if (j.value("zarr_format", 2) != 2) {
+            throw IOException("Only Zarr v2 arrays are supported");
+        }
+        if (j.value("order", "C") != "C") {
+            throw IOException("Only C-order Zarr arrays are supported");
+        }
+        if (j.contains("filters") and not j["filters"].is_null() and
+            not j["filters"].empty()) {
+            throw IOException("Zarr filters are not supported");
+        }
+
+        const auto& shape = j.at("shape");
+        const auto& chunks = j.at("chunks");
+        if (shape.size() < 3 or chunks.size() != shape.size()) {
+            throw IOException("Zarr array is not 3D");
+        }
+        extraDims_ = shape.size() - 3;
+        for (std::size_t i = 0; i < extraDims_; i++) {
+            if (shape[i].get<int>() != 1) {
+                throw IOException("Zarr array is not 3D");
+            }
+        }
+        shape_ = TrailingXYZ(shape);
+        chunks_ = TrailingXYZ(chunks);
+
+        // dtype is a NumPy type string, such as "<u2"
+        auto dtype = j.at("dtype").get<std::string>();
+        if (dtype.size() != 3 or dtype[1] != 'u' or
+            (dtype[2] != '1' and dtype[2] != '2')) {
+            throw IOException("Unsupported Zarr dtype: " + dtype);
+        }
+        sampleBytes_ = static_cast<std::size_t>(dtype[2] - '0');
+        bigEndian_ = dtype[0] == '>';
+
+        const auto& comp = j["compressor"];
+        compressor_ = CompressorFromString(
+            comp.is_null() ? "" : comp.at("id").get<std::string>());
+        separator_ = j.value("dimension_separator", ".");
+        if (j.contains("fill_value") and j["fill_value"].is_number()) {
+            fill_ = j["fill_value"].get<std::uint16_t>();
+        }
+        // Scale the fill value like the stored 8-bit samples, so that
+        // missing chunks match stored samples of the same value
+        if (sampleBytes_ == 1) {
+            cv::Mat fill(1, 1, CV_8UC1, cv::Scalar(fill_));
+            fill_ = QuantizeImage(fill, CV_16U, false).at<std::uint16_t>(0);
+        }
+    } catch (const json::exception& e) {
+        throw IOException(std::string("Invalid Zarr array: ") + e.what());
+    }
+}
+
+void ZarrArray::parse_n5_(const std::string& text)
+{
+    layout_ = Layout::N5;
+    try {
+        auto j = json::parse(text);
+        if (not j.contains("dimensions")) {
+            throw IOException("N5 group is not an array");
+        }
+        // N5 dimensions are ordered XYZ
+        const auto& dims = j.at("dimensions");
+        const auto& blocks = j.at("blockSize");
+        if (dims.size() != 3 or blocks.size() != 3) {
+            throw IOException("N5 array is not 3D");
+        }
+        for (int i = 0; i < 3; i++) {
+            shape_[i] = dims[i].get<int>();
+            chunks_[i] = blocks[i].get<int>();
+        }
+
+        auto type = j.at("dataType").get<std::string>();
+        if (type == "uint8") {
+            sampleBytes_ = 1;
+        } else if (type == "uint16") {
+            sampleBytes_ = 2;
+        } else {
+            throw IOException("Unsupported N5 data type: " + type);
+        }
+        bigEndian_ = true;
+
+        // Older files use compressionType
+        if (j.contains("compression")) {
+            compressor_ = CompressorFromString(
+                j["compression"].at("type").get<std::string>());
+        } else {
+            compressor_ = CompressorFromString(
+                j.value("compressionType", "raw"));
+        }
+        separator_ = "/";
+    } catch (const json::exception& e) {
+        throw IOException(std::string("Invalid N5 array: ") + e.what());
+    }
+}
+
+auto ZarrArray::MultiscaleArrays(VolumeSource& source, const std::string& path)
+    -> std::vector<std::string>
+{
+    // OME-Zarr: {"multiscales": [{"datasets": [{"path": "0"}, ...]}]}
+    // N5 viewers: {"scales": [[1, 1, 1], [2, 2, 2], ...]} with s0, s1, ...
+    std::vector<std::string> arrays;
+    try {
+        auto attrs = ReadJSON(source, Join(path, ZARR_ATTRS_FILE));
+        if (attrs.is_object() and attrs.contains("multiscales")) {
+            for (const auto& d : attrs["multiscales"].at(0).at("datasets")) {
+                arrays.push_back(Join(path, d.at("path").get<std::string>()));
+            }
+            return arrays;
+        }
+        attrs = ReadJSON(source, Join(path, N5_ATTRS_FILE));
+        if (attrs.is_object() and not attrs.contains("dimensions") and
+            attrs.contains("scales")) {
+            for (std::size_t n = 0; n < attrs["scales"].size(); n++) {
+                arrays.push_back(Join(path, "s" + std::to_string(n)));
+            }
+            return arrays;
+        }
+    } catch (const json::exception& e) {
+        throw IOException(
+            std::string("Invalid multiscale metadata: ") + e.what());
+    }
+    return {path};
+}
+
+auto ZarrArray::layout() const -> Layout { return layout_; }
+
+auto ZarrArray::shape() const -> cv::Vec3i { return shape_; }
+
+auto ZarrArray::chunkShape() const -> cv::Vec3i { return chunks_; }
+
+auto ZarrArray::chunkGridSize() const -> cv::Vec3i
+{
+    cv::Vec3i grid;
+    for (int i = 0; i < 3; i++) {
+        grid[i] = (shape_[i] + chunks_[i] - 1) / chunks_[i];
+    }
+    return grid;
+}
+
+auto ZarrArray::chunkName(int cx, int cy, int cz) const -> std::string
+{
+    std::string name;
+    if (layout_ == Layout::N5) {
+        name = std::to_string(cx) + separator_ + std::to_string(cy) +
+               separator_ + std::to_string(cz);
+    } else {
+        for (std::size_t i = 0; i < extraDims_; i++) {
+            name += "0" + separator_;
+        }
+        name += std::to_string(cz) + separator_ + std::to_string(cy) +
+                separator_ + std::to_string(cx);
+    }
+    return Join(path_, name);
+}
+
+auto ZarrArray::readChunk(int cx, int cy, int cz) const -> cv::Mat
+{
+    return decodeChunk(source_->read(chunkName(cx, cy, cz)));
+}
+
+auto ZarrArray::decodeChunk(const std::optional<std::vector<char>>& data) const
+    -> cv::Mat
+{
+    cv::Mat chunk(
+        chunks_[2] * chunks_[1], chunks_[0], CV_16UC1, cv::Scalar(fill_));
+    if (not data) {
+        return chunk;
+    }
+
+    // N5 blocks start with a header and may be smaller than the block size
+    // at the edge of the array
+    const auto* begin = data->data();
+    auto size = data->size();
+    auto dims = chunks_;
+    if (layout_ == Layout::N5) {
+        if (size < 4) {
+            throw IOException("N5 block is truncated");
+        }
+        auto mode = ReadBigEndian<std::uint16_t>(begin);
+        auto ndim = ReadBigEndian<std::uint16_t>(begin + 2);
+        auto headerBytes = 4 + 4 * std::size_t{ndim} + (mode == 1 ? 4 : 0);
+        if (ndim != 3 or mode > 1 or size < headerBytes) {
+            throw IOException("Unsupported N5 block header");
+        }
+        for (int i = 0; i < 3; i++) {
+            dims[i] = static_cast<int>(
+                ReadBigEndian<std::uint32_t>(begin + 4 + 4 * i));
+            if (dims[i] > chunks_[i]) {
+                throw IOException("N5 block is larger than the block size");
+            }
+        }
+        begin += headerBytes;
+        size -= headerBytes;
+    }
+
+    auto samples = static_cast<std::size_t>(dims[0]) * dims[1] * dims[2];
+    auto bytes = Decompress(compressor_, begin, size, samples * sampleBytes_);
+    decode_samples_(bytes.data(), bytes.size(), dims, chunk);
+    return chunk;
+}
+
+void ZarrArray::decode_samples_(
+    const char* data,
+    std::size_t size,
+    const cv::Vec3i& dims,
+    cv::Mat& chunk) const
+{
+    // Samples of a dims-sized block, stacked like the chunk image
+    auto rows = dims[2] * dims[1];
+    cv::Mat samples(
+        rows, dims[0], sampleBytes_ == 1 ? CV_8UC1 : CV_16UC1,
+        const_cast<char*>(data));
+    if (static_cast<std::size_t>(rows) * dims[0] * sampleBytes_ != size) {
+        throw IOException("Chunk has the wrong size");
+    }
+
+    cv::Mat converted;
+    if (sampleBytes_ == 1) {
+        converted = QuantizeImage(samples, CV_16U, false);
+    } else {
+        converted = samples.clone();
+        if (bigEndian_) {
+            converted.forEach<std::uint16_t>([](auto& v, const int*) {
+                v = static_cast<std::uint16_t>((v << 8) | (v >> 8));
+            });
+        }
+    }
+
+    // Copy each Z-plane into the full-size chunk
+    if (dims == chunks_) {
+        converted.copyTo(chunk);
+        return;
+    }
+    for (int z = 0; z < dims[2]; z++) {
+        converted(cv::Rect(0, z * dims[1], dims[0], dims[1]))
+            .copyTo(chunk(cv::Rect(0, z * chunks_[1], dims[0], dims[1])));
+    }
+}
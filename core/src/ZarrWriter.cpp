@@ -0,0 +1,137 @@
+#include "vc/core/io/ZarrWriter.hpp"
+
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+#include <zlib.h>
+
+#include "vc/core/types/Exceptions.hpp"
+
+using namespace volcart;
+using namespace volcart::io;
+namespace fs = volcart::filesystem;
+
+using json = nlohmann::json;
+
+// Write a file, replacing it if it exists
+static void WriteFile(const fs::path& path, const char* data, std::size_t size)
+{
+    std::ofstream file(path.string(), std::ios::binary | std::ios::trunc);
+    if (not file.is_open()) {
+        throw IOException("Failed to open file for writing: " + path.string());
+    }
+    file.write(data, static_cast<std::streamsize>(size));
+    if (file.fail()) {
+        throw IOException("Failed to write file: " + path.string());
+    }
+}
+
+ZarrWriter::ZarrWriter(
+    fs::path path,
+    const cv::Vec3i& shape,
+    const cv::Vec3i& chunkShape,
+    ZarrArray::Compressor compressor)
+    : path_{std::move(path)}
+    , shape_{shape}
+    , chunks_{chunkShape}
+    , compressor_{compressor}
+{
+    for (int i = 0; i < 3; i++) {
+        if (shape_[i] <= 0 or chunks_[i] <= 0) {
+            throw std::invalid_argument("Invalid array or chunk shape");
+        }
+    }
+
+    json compressorJSON;
+    switch (compressor_) {
+        case ZarrArray::Compressor::None:
+            break;
+        case ZarrArray::Compressor::Zlib:
+            compressorJSON = {{"id", "zlib"}, {"level", ZLIB_LEVEL}};
+            break;
+        default:
+            throw std::invalid_argument(
+                "Zarr chunks can only be written uncompressed or with zlib");
+    }
+
+    // Zarr dimensions are ordered ZYX
+    json zarray = {
+        {"zarr_format", 2},
+        {"shape", {shape_[2], shape_[1], shape_[0]}},
+        {"chunks", {chunks_[2], chunks_[1], chunks_[0]}},
+        {"dtype", "<u2"},
+        {"compressor", compressorJSON},
+        {"fill_value", 0},
+        {"order", "C"},
+        {"filters", nullptr},
+        {"dimension_separator", "."}};
+    fs::create_directories(path_);
+    auto text = zarray.dump(4);
+    WriteFile(path_ / ".zarray", text.data(), text.size());
+}
+
+auto ZarrWriter::New(
+    fs::path path,
+    const cv::Vec3i& shape,
+    const cv::Vec3i& chunkShape,
+    ZarrArray::Compressor compressor) -> Pointer
+{
+    return std::make_shared<ZarrWriter>(
+        std::move(path), shape, chunkShape, compressor);
+}
+
+auto ZarrWriter::path() const -> const fs::path& { return path_; }
+
+auto ZarrWriter::shape() const -> cv::Vec3i { return shape_; }
+
+auto ZarrWriter::chunkShape() const -> cv::Vec3i { return chunks_; }
+
+auto ZarrWriter::chunkGridSize() const -> cv::Vec3i
+{
+    cv::Vec3i grid;
+    for (int i = 0; i < 3; i++) {
+        grid[i] = (shape_[i] + chunks_[i] - 1) / chunks_[i];
+    }
+    return grid;
+}
+
+void ZarrWriter::writeChunk(int cx, int cy, int cz, const cv::Mat& chunk) const
+{
+    const cv::Vec3i idx{cx, cy, cz};
+    const auto grid = chunkGridSize();
+    for (int i = 0; i < 3; i++) {
+        if (idx[i] < 0 or idx[i] >= grid[i]) {
+            throw std::invalid_argument("Chunk index is outside of the array");
+        }
+    }
+    if (chunk.type() != CV_16UC1 or chunk.cols != chunks_[0] or
+        chunk.rows != chunks_[1] * chunks_[2]) {
+        throw std::invalid_argument("Chunk has the wrong size or type");
+    }
+
+    // The stacked Z-planes are the C-order samples of the chunk
+    const auto samples = chunk.isContinuous() ? chunk : chunk.clone();
+    const auto* data = reinterpret_cast<const char*>(samples.data);
+    const auto bytes = samples.total() * samples.elemSize();
+
+    auto name = std::to_string(cz) + "." + std::to_string(cy) + "." +
+                std::to_string(cx);
+    if (compressor_ == ZarrArray::Compressor::None) {
+        WriteFile(path_ / name, data, bytes);
+        return;
+    }
+
+    auto size = compressBound(static_cast<uLong>(bytes));
+    std::vector<char> compressed(size);
+    auto res = compress2(
+        reinterpret_cast<Bytef*>(compressed.data()), &size,
+        reinterpret_cast<const Bytef*>(data), static_cast<uLong>(bytes),
+        ZLIB_LEVEL);
+    if (res != Z_OK) {
+        throw IOException("Failed to compress zlib chunk");
+    }
+    WriteFile(path_ / name, compressed.data(), size);
+}
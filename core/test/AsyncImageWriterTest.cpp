@@ -0,0 +1,92 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+#include "vc/core/filesystem.hpp"
+#include "vc/core/io/AsyncImageWriter.hpp"
+#include "vc/core/io/ImageIO.hpp"
+
+using namespace volcart;
+namespace fs = volcart::filesystem;
+
+class AsyncImageWriter_Images : public ::testing::Test
+{
+public:
+    fs::path dir{"vc_core_AsyncImageWriter"};
+    std::vector<cv::Mat> images;
+
+    AsyncImageWriter_Images()
+    {
+        fs::remove_all(dir);
+        fs::create_directories(dir);
+        for (int i = 0; i < 12; i++) {
+            images.emplace_back(32, 24, CV_16UC1, cv::Scalar(i * 1000));
+        }
+    }
+
+    ~AsyncImageWriter_Images() override { fs::remove_all(dir); }
+
+    auto path(std::size_t i) const -> fs::path
+    {
+        return dir / (std::to_string(i) + ".tif");
+    }
+
+    void expectWritten() const
+    {
+        for (std::size_t i = 0; i < images.size(); i++) {
+            auto img = ReadImage(path(i));
+            ASSERT_FALSE(img.empty()) << path(i);
+            EXPECT_EQ(cv::countNonZero(img != images[i]), 0) << path(i);
+        }
+    }
+};
+
+TEST_F(AsyncImageWriter_Images, WriteAll)
+{
+    AsyncImageWriter writer(4);
+    EXPECT_EQ(writer.numThreads(), 4U);
+    for (std::size_t i = 0; i < images.size(); i++) {
+        writer.write(path(i), images[i]);
+    }
+    writer.flush();
+    expectWritten();
+}
+
+TEST_F(AsyncImageWriter_Images, SmallQueue)
+{
+    // Room for a single image at a time
+    const auto bytes = images[0].total() * images[0].elemSize();
+    AsyncImageWriter writer(3, bytes);
+    for (std::size_t i = 0; i < images.size(); i++) {
+        writer.write(path(i), images[i]);
+    }
+    writer.flush();
+    expectWritten();
+}
+
+TEST_F(AsyncImageWriter_Images, DestructorWrites)
+{
+    {
+        AsyncImageWriter writer(2);
+        for (std::size_t i = 0; i < images.size(); i++) {
+            writer.write(path(i), images[i]);
+        }
+    }
+    expectWritten();
+}
+
+TEST_F(AsyncImageWriter_Images, Errors)
+{
+    // Two-channel TIFFs are not supported
+    AsyncImageWriter writer(1);
+    writer.write(dir / "bad.tif", cv::Mat(4, 4, CV_16UC2));
+    EXPECT_THROW(writer.flush(), std::runtime_error);
+
+    // The error is only reported once
+    writer.write(path(0), images[0]);
+    EXPECT_NO_THROW(writer.flush());
+}
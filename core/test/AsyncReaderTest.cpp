@@ -0,0 +1,148 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "vc/core/filesystem.hpp"
+#include "vc/core/io/AsyncReader.hpp"
+#include "vc/core/types/Exceptions.hpp"
+
+using namespace volcart;
+using namespace volcart::io;
+namespace fs = volcart::filesystem;
+
+class AsyncReader_Files : public ::testing::TestWithParam<AsyncReader::Engine>
+{
+public:
+    AsyncReader_Files()
+    {
+        fs::remove_all(dir);
+        fs::create_directories(dir);
+        for (std::size_t i = 0; i < numFiles; i++) {
+            std::ofstream(path(i).string(), std::ios::binary) << contents(i);
+        }
+    }
+
+    ~AsyncReader_Files() override { fs::remove_all(dir); }
+
+    auto path(std::size_t i) const -> fs::path
+    {
+        return dir / (std::to_string(i) + ".bin");
+    }
+
+    // Files of different sizes, including an empty file
+    static auto contents(std::size_t i) -> std::string
+    {
+        std::string s(i * 1000, '\0');
+        for (std::size_t j = 0; j < s.size(); j++) {
+            s[j] = static_cast<char>((i + j) % 251);
+        }
+        return s;
+    }
+
+    fs::path dir{"vc_core_AsyncReader"};
+    std::size_t numFiles{40};
+};
+
+TEST_P(AsyncReader_Files, ReadMany)
+{
+    // Fewer slots than files, so that reads wait for a free slot
+    AsyncReader reader(8, 2, GetParam());
+    if (GetParam() == AsyncReader::Engine::Threads) {
+        EXPECT_EQ(reader.engine(), AsyncReader::Engine::Threads);
+    }
+
+    std::mutex mutex;
+    std::vector<std::string> results(numFiles);
+    std::atomic<int> errors{0};
+    for (std::size_t i = 0; i < numFiles; i++) {
+        reader.read(path(i), [&, i](auto data, auto error) {
+            if (error or not data) {
+                errors++;
+                return;
+            }
+            const std::lock_guard<std::mutex> lock(mutex);
+            results[i].assign(data->begin(), data->end());
+        });
+    }
+    reader.wait();
+    EXPECT_EQ(reader.pending(), 0);
+    EXPECT_EQ(errors, 0);
+    for (std::size_t i = 0; i < numFiles; i++) {
+        EXPECT_EQ(results[i], contents(i)) << "File " << i;
+    }
+}
+
+TEST_P(AsyncReader_Files, MissingAndFailed)
+{
+    AsyncReader reader(4, 1, GetParam());
+    auto missing = reader.read(dir / "missing.bin");
+    EXPECT_FALSE(missing.get().has_value());
+
+    // A directory can be opened but not read
+    auto failed = reader.read(dir);
+    EXPECT_THROW(failed.get(), IOException);
+
+    auto found = reader.read(path(3));
+    auto data = found.get();
+    ASSERT_TRUE(data.has_value());
+    EXPECT_EQ(std::string(data->begin(), data->end()), contents(3));
+}
+
+TEST_P(AsyncReader_Files, Submit)
+{
+    AsyncReader reader(4, 2, GetParam());
+    std::atomic<int> count{0};
+    for (int i = 0; i < 10; i++) {
+        reader.submit(
+            []() { return AsyncReader::Result(std::vector<char>(3, 'x')); },
+            [&count](auto data, auto /*error*/) {
+                if (data and data->size() == 3) {
+                    count++;
+                }
+            });
+    }
+
+    // Callback exceptions do not stop the reader
+    reader.submit(
+        []() -> AsyncReader::Result { throw std::runtime_error("load"); },
+        [](auto /*data*/, auto error) { std::rethrow_exception(error); });
+    reader.wait();
+    EXPECT_EQ(count, 10);
+}
+
+TEST_P(AsyncReader_Files, DestructorWaits)
+{
+    std::atomic<int> count{0};
+    {
+        AsyncReader reader(4, 2, GetParam());
+        for (std::size_t i = 0; i < numFiles; i++) {
+            reader.read(path(i), [&count](auto /*data*/, auto /*error*/) {
+                count++;
+            });
+        }
+    }
+    EXPECT_EQ(count, numFiles);
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    Engines,
+    AsyncReader_Files,
+    ::testing::Values(
+        AsyncReader::Engine::Auto, AsyncReader::Engine::Threads));
+
+TEST(AsyncReader, Engine)
+{
+    EXPECT_THROW(AsyncReader(0), std::invalid_argument);
+
+    AsyncReader reader(4, 1, AsyncReader::Engine::IOUring);
+    EXPECT_EQ(reader.queueDepth(), 4);
+    if (AsyncReader::IOUringAvailable()) {
+        EXPECT_EQ(reader.engine(), AsyncReader::Engine::IOUring);
+    } else {
+        EXPECT_EQ(reader.engine(), AsyncReader::Engine::Threads);
+    }
+}
@@ -0,0 +1,104 @@
+#include <gtest/gtest.h>
+
+#include <opencv2/core.hpp>
+
+#include "vc/core/types/ByteLRUCache.hpp"
+
+using namespace volcart;
+
+// Charge each int value as the number of bytes it stores
+struct IntValueBytes {
+    auto operator()(const int& v) const -> size_t
+    {
+        return static_cast<size_t>(v);
+    }
+};
+
+class ByteLRUCache_Empty : public ::testing::Test
+{
+public:
+    ByteLRUCache<int, int, IntValueBytes> cache{100};
+};
+
+TEST_F(ByteLRUCache_Empty, Defaults)
+{
+    EXPECT_EQ(cache.capacity(), 100);
+    EXPECT_EQ(cache.size(), 0);
+    EXPECT_EQ(cache.bytes(), 0);
+    EXPECT_THROW(cache.setCapacity(0), std::invalid_argument);
+}
+
+TEST_F(ByteLRUCache_Empty, ChargesValueSize)
+{
+    cache.put(0, 10);
+    cache.put(1, 20);
+    EXPECT_EQ(cache.size(), 2);
+    EXPECT_EQ(cache.bytes(), 30);
+
+    // Replacing a value updates the total
+    cache.put(1, 40);
+    EXPECT_EQ(cache.size(), 2);
+    EXPECT_EQ(cache.bytes(), 50);
+}
+
+TEST_F(ByteLRUCache_Empty, EvictsLeastRecentlyUsed)
+{
+    cache.put(0, 40);
+    cache.put(1, 40);
+    cache.get(0);
+
+    // Exceeds capacity: 1 is the least recently used
+    cache.put(2, 40);
+    EXPECT_TRUE(cache.contains(0));
+    EXPECT_FALSE(cache.contains(1));
+    EXPECT_TRUE(cache.contains(2));
+    EXPECT_EQ(cache.bytes(), 80);
+
+    // A single large element evicts everything
+    cache.put(3, 100);
+    EXPECT_EQ(cache.size(), 1);
+    EXPECT_EQ(cache.bytes(), 100);
+}
+
+TEST_F(ByteLRUCache_Empty, RejectsOversizeElement)
+{
+    cache.put(0, 50);
+    cache.put(1, 101);
+    EXPECT_FALSE(cache.contains(1));
+    EXPECT_TRUE(cache.contains(0));
+    EXPECT_EQ(cache.bytes(), 50);
+}
+
+TEST_F(ByteLRUCache_Empty, ShrinkCapacity)
+{
+    for (int i = 0; i < 10; i++) {
+        cache.put(i, 10);
+    }
+    EXPECT_EQ(cache.bytes(), 100);
+
+    cache.setCapacity(35);
+    EXPECT_EQ(cache.size(), 3);
+    EXPECT_EQ(cache.bytes(), 30);
+    EXPECT_TRUE(cache.contains(9));
+    EXPECT_FALSE(cache.contains(6));
+
+    cache.purge();
+    EXPECT_EQ(cache.size(), 0);
+    EXPECT_EQ(cache.bytes(), 0);
+}
+
+TEST(ByteLRUCache, ChargesMatBytes)
+{
+    ByteLRUCache<int, cv::Mat> cache(1000);
+    cache.put(0, cv::Mat::zeros(10, 10, CV_8UC1));
+    cache.put(1, cv::Mat::zeros(10, 10, CV_16UC1));
+    cache.put(2, cv::Mat::zeros(10, 10, CV_32FC1));
+    EXPECT_EQ(cache.bytes(), 700);
+
+    // Older slices are evicted to make room
+    cache.put(3, cv::Mat::zeros(10, 10, CV_32FC2));
+    EXPECT_EQ(cache.size(), 1);
+    EXPECT_EQ(cache.bytes(), 800);
+    EXPECT_FALSE(cache.contains(2));
+    EXPECT_TRUE(cache.contains(3));
+}
@@ -0,0 +1,51 @@
+#include <gtest/gtest.h>
+
+#include "vc/core/util/CPUFeatures.hpp"
+
+using namespace volcart;
+using namespace volcart::simd;
+
+namespace
+{
+auto Scalar() -> int { return 0; }
+auto SSE4() -> int { return 1; }
+auto AVX512() -> int { return 3; }
+auto NEON() -> int { return 4; }
+}  // namespace
+
+TEST(CPUFeatures, DetectedPathIsSupported)
+{
+    EXPECT_TRUE(Supports(Path::Scalar));
+    EXPECT_TRUE(Supports(DetectPath()));
+    EXPECT_TRUE(Supports(ActivePath()));
+}
+
+TEST(CPUFeatures, PathNames)
+{
+    for (auto p :
+         {Path::Scalar, Path::SSE4, Path::AVX2, Path::AVX512, Path::NEON}) {
+        EXPECT_EQ(ParsePath(PathName(p)), p);
+    }
+    EXPECT_EQ(ParsePath("AVX2"), Path::AVX2);
+    EXPECT_THROW(ParsePath("mmx"), std::invalid_argument);
+}
+
+TEST(CPUFeatures, SelectFallsBackToLowerPaths)
+{
+    Kernels<decltype(&Scalar)> k{Scalar};
+    k.sse4 = SSE4;
+    k.avx512 = AVX512;
+    k.neon = NEON;
+
+    EXPECT_EQ(k.select(Path::Scalar)(), 0);
+    EXPECT_EQ(k.select(Path::SSE4)(), 1);
+    // No AVX2 implementation
+    EXPECT_EQ(k.select(Path::AVX2)(), 1);
+    EXPECT_EQ(k.select(Path::AVX512)(), 3);
+    EXPECT_EQ(k.select(Path::NEON)(), 4);
+
+    // Only the scalar implementation is required
+    Kernels<decltype(&Scalar)> scalarOnly{Scalar};
+    EXPECT_EQ(scalarOnly.select(Path::AVX512)(), 0);
+    EXPECT_EQ(scalarOnly.select(Path::NEON)(), 0);
+}
@@ -0,0 +1,68 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+
+#include "vc/core/types/CacheStats.hpp"
+#include "vc/core/types/LRUCache.hpp"
+
+using namespace volcart;
+using namespace std::chrono_literals;
+
+TEST(LatencyHistogram, Empty)
+{
+    LatencyHistogram h;
+    auto s = h.snapshot();
+    EXPECT_EQ(s.count, 0);
+    EXPECT_EQ(s.mean(), 0);
+    EXPECT_EQ(s.percentile(50), 0);
+}
+
+TEST(LatencyHistogram, RecordAndReset)
+{
+    LatencyHistogram h;
+    for (int i = 0; i < 98; i++) {
+        h.record(3us);
+    }
+    h.record(100us);
+    h.record(1000us);
+
+    auto s = h.snapshot();
+    EXPECT_EQ(s.count, 100);
+    EXPECT_EQ(s.totalUs, 98 * 3 + 100 + 1000);
+    EXPECT_EQ(s.maxUs, 1000);
+    EXPECT_DOUBLE_EQ(s.mean(), (98 * 3 + 100 + 1000) / 100.);
+
+    // 3 µs is in the [2, 4) bucket
+    EXPECT_EQ(s.buckets[2], 98);
+    EXPECT_DOUBLE_EQ(s.percentile(50), 4);
+    EXPECT_DOUBLE_EQ(s.percentile(99), 128);
+    EXPECT_DOUBLE_EQ(s.percentile(100), 1000);
+
+    h.reset();
+    EXPECT_EQ(h.snapshot().count, 0);
+    EXPECT_EQ(h.snapshot().maxUs, 0);
+}
+
+TEST(CacheStats, HitRate)
+{
+    CacheStats stats;
+    EXPECT_EQ(stats.hitRate(), 0);
+    stats.lookups = 4;
+    stats.hits = 3;
+    stats.misses = 1;
+    EXPECT_DOUBLE_EQ(stats.hitRate(), 0.75);
+    EXPECT_FALSE(stats.summary().empty());
+}
+
+TEST(CacheStats, LRUCacheEvictions)
+{
+    LRUCache<int, int> cache(2);
+    for (int i = 0; i < 5; i++) {
+        cache.put(i, i);
+    }
+    EXPECT_EQ(cache.evictions(), 3);
+    cache.setCapacity(1);
+    EXPECT_EQ(cache.evictions(), 4);
+    cache.purge();
+    EXPECT_EQ(cache.evictions(), 4);
+}
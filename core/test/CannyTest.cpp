@@ -0,0 +1,66 @@
+#include <gtest/gtest.h>
+
+#include <opencv2/core.hpp>
+#include <opencv2/core/ocl.hpp>
+#include <opencv2/imgproc.hpp>
+
+#include "vc/core/util/Canny.hpp"
+
+using namespace volcart;
+
+namespace
+{
+// Bright rectangle and disk on a noisy background
+auto MakeImage() -> cv::Mat
+{
+    cv::Mat img(200, 300, CV_8UC1);
+    cv::RNG rng(1234);
+    rng.fill(img, cv::RNG::UNIFORM, 0, 20);
+    cv::rectangle(img, {40, 50}, {120, 150}, cv::Scalar(200), cv::FILLED);
+    cv::circle(img, {220, 100}, 40, cv::Scalar(180), cv::FILLED);
+    return img;
+}
+
+auto Equal(const cv::Mat& a, const cv::Mat& b) -> bool
+{
+    return a.size() == b.size() and a.type() == b.type() and
+           cv::norm(a, b, cv::NORM_INF) == 0;
+}
+}  // namespace
+
+TEST(Canny, UMatMatchesMat)
+{
+    // Compare against the CPU implementations
+    const auto useOpenCL = cv::ocl::useOpenCL();
+    cv::ocl::setUseOpenCL(false);
+
+    auto img = MakeImage();
+    auto uImg = img.getUMat(cv::ACCESS_READ);
+    CannySettings settings;
+    for (auto bilateral : {false, true}) {
+        for (auto contour : {false, true}) {
+            settings.bilateral = bilateral;
+            settings.contour = contour;
+            auto expected = Canny(img, settings);
+            cv::Mat result;
+            Canny(uImg, settings).copyTo(result);
+            EXPECT_GT(cv::countNonZero(expected), 0);
+            EXPECT_TRUE(Equal(result, expected))
+                << "bilateral: " << bilateral << ", contour: " << contour;
+        }
+    }
+
+    cv::ocl::setUseOpenCL(useOpenCL);
+}
+
+TEST(Canny, MaskRemovesEdges)
+{
+    auto img = MakeImage();
+    CannySettings settings;
+    settings.mask = cv::Mat::zeros(img.size(), CV_8UC1);
+    settings.mask.colRange(0, 150).setTo(255);
+
+    auto edges = Canny(img, settings);
+    EXPECT_GT(cv::countNonZero(edges.colRange(0, 150)), 0);
+    EXPECT_EQ(cv::countNonZero(edges.colRange(150, edges.cols)), 0);
+}
@@ -0,0 +1,153 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+#include "vc/core/filesystem.hpp"
+#include "vc/core/neighborhood/CuboidGenerator.hpp"
+#include "vc/core/types/Volume.hpp"
+
+using namespace volcart;
+namespace fs = volcart::filesystem;
+
+TEST(CuboidGenerator, ComputeIntoMatchesCompute)
+{
+    fs::path volPath{"vc_core_CuboidGenerator"};
+    fs::remove_all(volPath);
+    fs::create_directory(volPath);
+
+    auto vol = Volume::New(volPath, "CuboidGenerator", "CuboidGenerator");
+    vol->setSliceWidth(20);
+    vol->setSliceHeight(20);
+    vol->setNumberOfSlices(20);
+    vol->saveMetadata();
+    cv::RNG rng(1234);
+    for (int z = 0; z < 20; z++) {
+        cv::Mat slice(20, 20, CV_16UC1);
+        rng.fill(slice, cv::RNG::UNIFORM, 0, 65535);
+        vol->setSliceData(z, slice);
+    }
+
+    auto gen = CuboidGenerator::New();
+    gen->setSamplingRadius(2, 1, 3);
+
+    // Oblique axes are interpolated, axis-aligned axes are copied
+    for (const auto& axis :
+         {cv::normalize(cv::Vec3d{0.2, -0.4, 1}), cv::Vec3d{0, 0, 1}}) {
+        for (auto dir : {Direction::Negative, Direction::Bidirectional}) {
+            gen->setSamplingDirection(dir);
+            const cv::Vec3d pt{10, 10, 10};
+            auto n = gen->compute(vol, pt, {axis});
+            ASSERT_EQ(n.size(), gen->size());
+
+            std::vector<uint16_t> samples(gen->size());
+            gen->computeInto(vol, pt, axis, samples.data());
+            for (size_t i = 0; i < samples.size(); i++) {
+                EXPECT_EQ(n.data()[i], samples[i]);
+            }
+        }
+    }
+}
+
+TEST(CuboidGenerator, PrecomputedOffsetsMatchCompute)
+{
+    fs::path volPath{"vc_core_CuboidGeneratorOffsets"};
+    fs::remove_all(volPath);
+    fs::create_directory(volPath);
+
+    auto vol = Volume::New(volPath, "CuboidGenerator", "CuboidGenerator");
+    vol->setSliceWidth(20);
+    vol->setSliceHeight(20);
+    vol->setNumberOfSlices(20);
+    vol->saveMetadata();
+    cv::RNG rng(4321);
+    for (int z = 0; z < 20; z++) {
+        cv::Mat slice(20, 20, CV_16UC1);
+        rng.fill(slice, cv::RNG::UNIFORM, 0, 65535);
+        vol->setSliceData(z, slice);
+    }
+
+    auto gen = CuboidGenerator::New();
+    gen->setSamplingRadius(3, 2, 1);
+    gen->setSamplingInterval(0.5);
+
+    const std::vector<cv::Vec3d> axes{
+        cv::normalize(cv::Vec3d{1, 1, 1}), cv::normalize(cv::Vec3d{1, -1, 0}),
+        cv::normalize(cv::Vec3d{1, 1, -2})};
+    auto offsets = gen->precompute(axes);
+    ASSERT_EQ(offsets.samples.size(), gen->size());
+    EXPECT_FALSE(offsets.lattice);
+
+    std::vector<uint16_t> samples(offsets.samples.size());
+    for (const auto& pt : {cv::Vec3d{10, 10, 10}, cv::Vec3d{8.3, 11.2, 9.7}}) {
+        auto n = gen->compute(vol, pt, axes);
+        gen->computeInto(vol, pt, offsets, samples.data());
+        for (size_t i = 0; i < samples.size(); i++) {
+            EXPECT_EQ(n.data()[i], samples[i]);
+        }
+    }
+
+    // Axis-aligned bases with an integer interval copy the lattice
+    gen->setSamplingInterval(1);
+    offsets = gen->precompute({{0, 0, 1}, {0, 1, 0}, {1, 0, 0}});
+    EXPECT_TRUE(offsets.lattice);
+    samples.resize(offsets.samples.size());
+    const cv::Vec3d pt{10, 9, 8};
+    gen->computeInto(vol, pt, offsets, samples.data());
+    for (size_t i = 0; i < samples.size(); i++) {
+        EXPECT_EQ(samples[i], vol->interpolateAt(pt + offsets.samples[i]));
+    }
+}
+
+TEST(CuboidGenerator, SlicesMatchCompute)
+{
+    fs::path volPath{"vc_core_CuboidGeneratorSlices"};
+    fs::remove_all(volPath);
+    fs::create_directory(volPath);
+
+    auto vol = Volume::New(volPath, "CuboidGenerator", "CuboidGenerator");
+    vol->setSliceWidth(20);
+    vol->setSliceHeight(20);
+    vol->setNumberOfSlices(20);
+    vol->saveMetadata();
+    cv::RNG rng(2468);
+    for (int z = 0; z < 20; z++) {
+        cv::Mat slice(20, 20, CV_16UC1);
+        rng.fill(slice, cv::RNG::UNIFORM, 0, 65535);
+        vol->setSliceData(z, slice);
+    }
+
+    auto gen = CuboidGenerator::New();
+    gen->setSamplingRadius(3, 2, 1);
+    const cv::Vec3d pt{10, 9, 8};
+
+    // Oblique axes are interpolated, axis-aligned axes are copied
+    for (const auto& axes : std::vector<std::vector<cv::Vec3d>>{
+             {cv::normalize(cv::Vec3d{1, 1, 1}),
+              cv::normalize(cv::Vec3d{1, -1, 0}),
+              cv::normalize(cv::Vec3d{1, 1, -2})},
+             {{0, 0, 1}, {0, 1, 0}, {1, 0, 0}}}) {
+        auto n = gen->compute(vol, pt, axes);
+        auto e = gen->extents();
+        auto sliceSize = e[1] * e[2];
+
+        // Uneven slabs of slices reassemble the neighborhood
+        std::vector<uint16_t> samples(gen->size());
+        for (size_t first = 0; first < e[0]; first += 2) {
+            auto last = std::min<size_t>(first + 2, e[0]);
+            gen->computeSlicesInto(
+                vol, pt, axes, first, last, samples.data() + first * sliceSize);
+        }
+        for (size_t i = 0; i < samples.size(); i++) {
+            EXPECT_EQ(n.data()[i], samples[i]);
+        }
+    }
+
+    EXPECT_THROW(
+        gen->computeSlicesInto(
+            vol, pt, {{0, 0, 1}}, 0, gen->extents()[0] + 1, nullptr),
+        std::out_of_range);
+}
@@ -0,0 +1,95 @@
+#include <gtest/gtest.h>
+
+#include <fstream>
+#include <sstream>
+
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc.hpp>
+
+#include "vc/core/filesystem.hpp"
+#include "vc/core/io/DeepZoomWriter.hpp"
+
+using namespace volcart;
+namespace fs = volcart::filesystem;
+
+namespace
+{
+auto RandomImage(int rows, int cols, int type) -> cv::Mat
+{
+    cv::RNG rng(1234);
+    cv::Mat img(rows, cols, type);
+    rng.fill(img, cv::RNG::UNIFORM, 0, 65535);
+    return img;
+}
+
+void ExpectEqual(const cv::Mat& a, const cv::Mat& b)
+{
+    ASSERT_EQ(a.size(), b.size());
+    ASSERT_EQ(a.type(), b.type());
+    cv::Mat diff = (a != b);
+    EXPECT_EQ(cv::countNonZero(diff.reshape(1)), 0);
+}
+
+auto ReadTile(int level, int x, int y) -> cv::Mat
+{
+    auto file = fs::path("DeepZoom_files") / std::to_string(level) /
+                (std::to_string(x) + "_" + std::to_string(y) + ".png");
+    return cv::imread(file.string(), cv::IMREAD_UNCHANGED);
+}
+}  // namespace
+
+TEST(DeepZoomWriter, WritePyramid)
+{
+    auto img = RandomImage(70, 100, CV_16UC1);
+    {
+        DeepZoomWriter writer("DeepZoom.dzi", 100, 70, CV_16UC1, 32);
+        writer.setNumThreads(4);
+        EXPECT_EQ(writer.numLevels(), 8);
+        writer.writeRegion({64, 0}, img(cv::Rect(64, 0, 36, 64)));
+        writer.writeRegion({0, 0}, img(cv::Rect(0, 0, 64, 64)));
+        writer.writeRegion({0, 64}, img(cv::Rect(0, 64, 100, 6)));
+    }
+
+    // Full-resolution tiles, including the edge tiles
+    ExpectEqual(ReadTile(7, 0, 0), img(cv::Rect(0, 0, 32, 32)));
+    ExpectEqual(ReadTile(7, 3, 2), img(cv::Rect(96, 64, 4, 6)));
+
+    // Tiles are downsampled by half at each level
+    cv::Mat half;
+    cv::resize(
+        img(cv::Rect(0, 0, 64, 64)), half, {32, 32}, 0, 0, cv::INTER_AREA);
+    ExpectEqual(ReadTile(6, 0, 0), half);
+    EXPECT_EQ(ReadTile(6, 1, 1).size(), cv::Size(18, 3));
+    EXPECT_EQ(ReadTile(0, 0, 0).size(), cv::Size(1, 1));
+
+    // Descriptor
+    std::ifstream dzi("DeepZoom.dzi");
+    std::stringstream ss;
+    ss << dzi.rdbuf();
+    EXPECT_NE(ss.str().find(R"(TileSize="32")"), std::string::npos);
+    EXPECT_NE(
+        ss.str().find(R"(<Size Width="100" Height="70"/>)"),
+        std::string::npos);
+}
+
+TEST(DeepZoomWriter, InvalidArguments)
+{
+    EXPECT_THROW(
+        DeepZoomWriter("DeepZoom_Invalid.dzi", 40, 40, CV_16UC1, 15),
+        std::invalid_argument);
+    EXPECT_THROW(
+        DeepZoomWriter("DeepZoom_Invalid.dzi", 40, 40, CV_32FC1),
+        std::runtime_error);
+    EXPECT_THROW(
+        DeepZoomWriter("DeepZoom_Invalid.tif", 40, 40, CV_16UC1),
+        std::runtime_error);
+
+    auto img = RandomImage(40, 40, CV_16UC1);
+    DeepZoomWriter writer("DeepZoom_Invalid.dzi", 40, 40, CV_16UC1, 16);
+    EXPECT_THROW(
+        writer.writeRegion({8, 0}, img(cv::Rect(0, 0, 16, 16))),
+        std::invalid_argument);
+    EXPECT_THROW(writer.writeRegion({32, 32}, img), std::out_of_range);
+    writer.close();
+    EXPECT_THROW(writer.writeRegion({0, 0}, img), std::runtime_error);
+}
@@ -0,0 +1,189 @@
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include <opencv2/core.hpp>
+
+#include "vc/core/filesystem.hpp"
+#include "vc/core/types/DiskCache.hpp"
+
+using namespace volcart;
+namespace fs = volcart::filesystem;
+
+class DiskCache_Empty : public ::testing::Test
+{
+public:
+    DiskCache_Empty()
+    {
+        fs::remove_all(dir);
+        cache = DiskCache::New(dir, 1 << 20);
+    }
+
+    ~DiskCache_Empty() override { fs::remove_all(dir); }
+
+    fs::path dir{"vc_core_DiskCache"};
+    DiskCache::Pointer cache;
+    DiskCache::Stamp stamp{100, 1};
+};
+
+// 64 KiB slice filled with v
+static auto Slice(int v) -> cv::Mat
+{
+    return {128, 256, CV_16UC1, cv::Scalar(v)};
+}
+
+TEST_F(DiskCache_Empty, PutAndGet)
+{
+    EXPECT_TRUE(cache->get("a", stamp).empty());
+    EXPECT_EQ(cache->misses(), 1);
+
+    cv::Mat img(20, 30, CV_32FC3);
+    cv::randu(img, 0, 1);
+    cache->put("a", stamp, img);
+    auto result = cache->get("a", stamp);
+    EXPECT_EQ(cache->hits(), 1);
+    ASSERT_EQ(result.size(), img.size());
+    ASSERT_EQ(result.type(), img.type());
+    EXPECT_EQ(cv::norm(result, img, cv::NORM_INF), 0);
+}
+
+TEST_F(DiskCache_Empty, NonContinuousImage)
+{
+    auto full = Slice(0);
+    full(cv::Rect(10, 10, 5, 5)).setTo(7);
+    auto roi = full(cv::Rect(8, 8, 10, 10));
+    cache->put("roi", stamp, roi);
+    auto result = cache->get("roi", stamp);
+    ASSERT_EQ(result.size(), roi.size());
+    EXPECT_EQ(cv::norm(result, roi, cv::NORM_INF), 0);
+}
+
+TEST_F(DiskCache_Empty, StaleEntriesAreRemoved)
+{
+    cache->put("a", stamp, Slice(1));
+    EXPECT_TRUE(cache->get("a", {100, 2}).empty());
+
+    // Removed by the stale lookup
+    EXPECT_TRUE(cache->get("a", stamp).empty());
+    EXPECT_EQ(cache->bytes(), 0);
+}
+
+TEST_F(DiskCache_Empty, SharedDirectory)
+{
+    cache->put("a", stamp, Slice(2));
+
+    auto other = DiskCache::New(dir, 1 << 20);
+    auto result = other->get("a", stamp);
+    ASSERT_FALSE(result.empty());
+    EXPECT_EQ(result.at<uint16_t>(0, 0), 2);
+}
+
+TEST_F(DiskCache_Empty, EvictsLeastRecentlyUsed)
+{
+    // File times are coarse, so wait between uses which must be ordered
+    auto wait = []() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    };
+
+    // Room for 15 slices
+    for (int i = 0; i < 15; i++) {
+        cache->put(std::to_string(i), stamp, Slice(i));
+    }
+    EXPECT_LE(cache->bytes(), cache->capacity());
+    wait();
+    EXPECT_FALSE(cache->get("0", stamp).empty());
+    wait();
+
+    // Exceeding the capacity trims the unused entries
+    cache->put("15", stamp, Slice(15));
+    cache->put("16", stamp, Slice(16));
+    EXPECT_LE(cache->bytes(), cache->capacity());
+    size_t unused{0};
+    for (int i = 1; i < 15; i++) {
+        unused += cache->get(std::to_string(i), stamp).empty() ? 0 : 1;
+    }
+    EXPECT_EQ(unused, 12);
+    EXPECT_FALSE(cache->get("0", stamp).empty());
+    wait();
+    EXPECT_FALSE(cache->get("15", stamp).empty());
+    EXPECT_FALSE(cache->get("16", stamp).empty());
+
+    // Room for two slices
+    cache->setCapacity(3 << 16);
+    EXPECT_LE(cache->bytes(), 3 << 16);
+    EXPECT_FALSE(cache->get("15", stamp).empty());
+    EXPECT_FALSE(cache->get("16", stamp).empty());
+
+    cache->purge();
+    EXPECT_EQ(cache->bytes(), 0);
+}
+
+TEST_F(DiskCache_Empty, RejectsOversizeImage)
+{
+    cache->put("big", stamp, cv::Mat(1024, 1024, CV_8UC1, cv::Scalar(0)));
+    EXPECT_TRUE(cache->get("big", stamp).empty());
+    cache->put("empty", stamp, cv::Mat());
+    EXPECT_TRUE(cache->get("empty", stamp).empty());
+}
+
+TEST_F(DiskCache_Empty, MappedEntries)
+{
+    cache->put("a", stamp, Slice(3));
+    cache->setMapEntries(true);
+    auto mapped = cache->get("a", stamp);
+    ASSERT_FALSE(mapped.empty());
+    EXPECT_EQ(cv::norm(mapped, Slice(3), cv::NORM_INF), 0);
+
+    // Writing to a mapped image does not modify the entry
+    mapped.setTo(4);
+    auto again = cache->get("a", stamp);
+    EXPECT_EQ(again.at<uint16_t>(0, 0), 3);
+    EXPECT_EQ(mapped.at<uint16_t>(0, 0), 4);
+
+    // Mapped images stay valid after their entry is removed
+    auto roi = again(cv::Rect(10, 10, 20, 20));
+    again.release();
+    cache->purge();
+    EXPECT_EQ(cv::norm(roi, Slice(3)(cv::Rect(10, 10, 20, 20))), 0);
+
+    // Reallocated images do not reference the mapping
+    roi.create(300, 300, CV_8UC1);
+    roi.setTo(1);
+    EXPECT_EQ(roi.at<uint8_t>(299, 299), 1);
+}
+
+TEST_F(DiskCache_Empty, CorruptEntry)
+{
+    cache->put("a", stamp, Slice(3));
+    fs::path entry;
+    for (const auto& it : fs::directory_iterator(cache->directory())) {
+        entry = it.path();
+    }
+    ASSERT_EQ(entry.extension().string(), ".vcc");
+    std::ifstream in(entry.string(), std::ios::binary);
+    std::string bytes(
+        (std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    in.close();
+
+    // The image size wraps around to the size of the file's pixel data
+    std::int32_t type = CV_MAKETYPE(CV_64F, 512);
+    std::int32_t rows{111150332};
+    std::int32_t cols{2147458995};
+    std::memcpy(&bytes[12], &type, sizeof(type));
+    std::memcpy(&bytes[16], &rows, sizeof(rows));
+    std::memcpy(&bytes[20], &cols, sizeof(cols));
+    bytes.resize(40 + 52 * 4096);
+    std::ofstream out(entry.string(), std::ios::binary | std::ios::trunc);
+    out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+    out.close();
+
+    // Invalid entries are missed and removed
+    EXPECT_TRUE(cache->get("a", stamp).empty());
+    EXPECT_FALSE(fs::exists(entry));
+}
@@ -0,0 +1,177 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include <opencv2/imgproc.hpp>
+
+#include "vc/core/math/Filter3D.hpp"
+
+using namespace volcart;
+
+namespace
+{
+auto RandomTensor(std::size_t dx, std::size_t dy, std::size_t dz)
+    -> Tensor3D<double>
+{
+    cv::RNG rng(1234);
+    Tensor3D<double> t(dx, dy, dz);
+    for (std::size_t z = 0; z < dz; z++) {
+        rng.fill(t.xySlice(z), cv::RNG::UNIFORM, 0, 1);
+    }
+    return t;
+}
+}  // namespace
+
+TEST(Filter3D, GaussianKernel)
+{
+    auto k = GaussianKernel1D(3, 1.5);
+    ASSERT_EQ(k.size(), 7);
+    double sum{0};
+    for (std::size_t i = 0; i < k.size(); i++) {
+        EXPECT_DOUBLE_EQ(k[i], k[k.size() - 1 - i]);
+        sum += k[i];
+    }
+    EXPECT_NEAR(sum, 1, 1e-12);
+    EXPECT_GT(k[3], k[2]);
+
+    EXPECT_EQ(GaussianKernel1D(0).size(), 1);
+    EXPECT_THROW(GaussianKernel1D(-1), std::invalid_argument);
+    EXPECT_THROW(GaussianKernel1D(1, 0), std::invalid_argument);
+}
+
+TEST(Filter3D, InvalidKernels)
+{
+    auto t = RandomTensor(4, 4, 4);
+    EXPECT_THROW(Correlate1D(t, {1, 1}, TensorAxis::X), std::invalid_argument);
+    EXPECT_THROW(DerivativeKernels1D(4), std::invalid_argument);
+    EXPECT_THROW(Gradient3D(t, 9), std::invalid_argument);
+}
+
+TEST(Filter3D, ImpulseResponse)
+{
+    // Correlating an impulse gives the flipped outer product of the kernels
+    Tensor3D<double> t(9, 9, 9);
+    t(4, 4, 4) = 1;
+    Kernel1D kx{1, 2, 3};
+    Kernel1D ky{4, 5, 6};
+    Kernel1D kz{7, 8, 9};
+    auto out = SepFilter3D(t, kx, ky, kz);
+    for (std::size_t z = 0; z < 9; z++) {
+        for (std::size_t y = 0; y < 9; y++) {
+            for (std::size_t x = 0; x < 9; x++) {
+                double expected{0};
+                if (x >= 3 and x <= 5 and y >= 3 and y <= 5 and z >= 3 and
+                    z <= 5) {
+                    expected = kx[5 - x] * ky[5 - y] * kz[5 - z];
+                }
+                EXPECT_DOUBLE_EQ(out(x, y, z), expected);
+            }
+        }
+    }
+}
+
+TEST(Filter3D, ReplicatedBorder)
+{
+    // A constant tensor is unchanged by a normalized kernel on every axis,
+    // including at the border and when the kernel is wider than the tensor
+    Tensor3D<double> t(2, 5, 3);
+    for (std::size_t z = 0; z < t.dz(); z++) {
+        t.xySlice(z) = 7;
+    }
+    auto k = GaussianKernel1D(4);
+    for (auto axis : {TensorAxis::X, TensorAxis::Y, TensorAxis::Z}) {
+        auto out = Correlate1D(t, k, axis);
+        for (std::size_t z = 0; z < t.dz(); z++) {
+            for (std::size_t y = 0; y < t.dy(); y++) {
+                for (std::size_t x = 0; x < t.dx(); x++) {
+                    EXPECT_NEAR(out(x, y, z), 7, 1e-12);
+                }
+            }
+        }
+    }
+}
+
+TEST(Filter3D, GradientMatchesOpenCV)
+{
+    auto t = RandomTensor(11, 9, 7);
+    for (auto ksize : {1, 3, 5, 7}) {
+        auto grad = Gradient3D(t, ksize);
+
+        // XY gradients are computed on XY slices
+        for (std::size_t z = 0; z < t.dz(); z++) {
+            cv::Mat_<double> gx;
+            cv::Mat_<double> gy;
+            if (ksize == 3) {
+                cv::Scharr(
+                    t.xySlice(z), gx, CV_64F, 1, 0, 1, 0,
+                    cv::BORDER_REPLICATE);
+                cv::Scharr(
+                    t.xySlice(z), gy, CV_64F, 0, 1, 1, 0,
+                    cv::BORDER_REPLICATE);
+            } else {
+                cv::Sobel(
+                    t.xySlice(z), gx, CV_64F, 1, 0, ksize, 1, 0,
+                    cv::BORDER_REPLICATE);
+                cv::Sobel(
+                    t.xySlice(z), gy, CV_64F, 0, 1, ksize, 1, 0,
+                    cv::BORDER_REPLICATE);
+            }
+            for (std::size_t y = 0; y < t.dy(); y++) {
+                for (std::size_t x = 0; x < t.dx(); x++) {
+                    EXPECT_NEAR(grad[0](x, y, z), gx(y, x), 1e-9);
+                    EXPECT_NEAR(grad[1](x, y, z), gy(y, x), 1e-9);
+                }
+            }
+        }
+
+        // Z gradients are computed on XZ slices
+        for (std::size_t y = 0; y < t.dy(); y++) {
+            cv::Mat_<double> gz;
+            if (ksize == 3) {
+                cv::Scharr(
+                    t.xzSlice(y), gz, CV_64F, 0, 1, 1, 0,
+                    cv::BORDER_REPLICATE);
+            } else {
+                cv::Sobel(
+                    t.xzSlice(y), gz, CV_64F, 0, 1, ksize, 1, 0,
+                    cv::BORDER_REPLICATE);
+            }
+            for (std::size_t z = 0; z < t.dz(); z++) {
+                for (std::size_t x = 0; x < t.dx(); x++) {
+                    EXPECT_NEAR(grad[2](x, y, z), gz(z, x), 1e-9);
+                }
+            }
+        }
+    }
+}
+
+TEST(Filter3D, ScaledAddPathsMatch)
+{
+    // Random operands, so that a fused multiply-add would round differently
+    cv::RNG rng(5678);
+    std::vector<double> x(80);
+    std::vector<double> y0(80);
+    for (std::size_t i = 0; i < x.size(); i++) {
+        x[i] = rng.uniform(-1.0, 1.0);
+        y0[i] = rng.uniform(-1.0, 1.0);
+    }
+    const auto w = rng.uniform(-1.0, 1.0);
+
+    // Every length up to several vectors, with unaligned tails
+    for (std::size_t n = 0; n < 70; n++) {
+        auto expected = y0;
+        ScaledAdd(w, x.data() + 1, expected.data() + 1, n, simd::Path::Scalar);
+        for (auto p : {simd::Path::SSE4, simd::Path::AVX2, simd::Path::AVX512,
+                       simd::Path::NEON}) {
+            if (not simd::Supports(p)) {
+                continue;
+            }
+            auto result = y0;
+            ScaledAdd(w, x.data() + 1, result.data() + 1, n, p);
+            for (std::size_t i = 0; i < result.size(); i++) {
+                ASSERT_EQ(result[i], expected[i])
+                    << simd::PathName(p) << ", n = " << n << ", i = " << i;
+            }
+        }
+    }
+}
@@ -0,0 +1,85 @@
+#include <gtest/gtest.h>
+
+#include "vc/core/shapes/Arch.hpp"
+#include "vc/core/shapes/Plane.hpp"
+#include "vc/core/types/FlatMesh.hpp"
+
+using namespace volcart;
+
+TEST(FlatMesh, AddVerticesAndFaces)
+{
+    FlatMesh mesh;
+    EXPECT_EQ(mesh.addVertex({0, 0, 0}), 0);
+    EXPECT_EQ(mesh.addVertex({1, 0, 0}), 1);
+    EXPECT_EQ(mesh.addVertex({0, 1, 0}), 2);
+    EXPECT_EQ(mesh.addFace(0, 1, 2), 0);
+    EXPECT_THROW(mesh.addFace(0, 1, 3), std::out_of_range);
+    EXPECT_EQ(mesh.numVertices(), 3);
+    EXPECT_EQ(mesh.numFaces(), 1);
+    EXPECT_FALSE(mesh.hasNormals());
+    EXPECT_FALSE(mesh.hasUVs());
+
+    mesh.computeNormals();
+    ASSERT_TRUE(mesh.hasNormals());
+    for (const auto& n : mesh.normals()) {
+        EXPECT_DOUBLE_EQ(n[0], 0);
+        EXPECT_DOUBLE_EQ(n[1], 0);
+        EXPECT_DOUBLE_EQ(std::abs(n[2]), 1);
+    }
+
+    mesh.clear();
+    EXPECT_EQ(mesh.numVertices(), 0);
+    EXPECT_EQ(mesh.numFaces(), 0);
+    EXPECT_FALSE(mesh.hasNormals());
+}
+
+TEST(FlatMesh, ITKMeshRoundTrip)
+{
+    auto itkMesh = shapes::Arch(10, 10).itkMesh();
+    auto flat = ToFlatMesh(itkMesh);
+    ASSERT_EQ(flat.numVertices(), itkMesh->GetNumberOfPoints());
+    ASSERT_EQ(flat.numFaces(), itkMesh->GetNumberOfCells());
+    EXPECT_TRUE(flat.hasNormals());
+
+    auto result = ToITKMesh(flat);
+    ASSERT_EQ(result->GetNumberOfPoints(), itkMesh->GetNumberOfPoints());
+    ASSERT_EQ(result->GetNumberOfCells(), itkMesh->GetNumberOfCells());
+    for (auto pt = itkMesh->GetPoints()->Begin();
+         pt != itkMesh->GetPoints()->End(); ++pt) {
+        auto p = result->GetPoint(pt.Index());
+        ITKPixel n0;
+        ITKPixel n1;
+        itkMesh->GetPointData(pt.Index(), &n0);
+        ASSERT_TRUE(result->GetPointData(pt.Index(), &n1));
+        for (int i = 0; i < 3; i++) {
+            EXPECT_DOUBLE_EQ(p[i], pt.Value()[i]);
+            EXPECT_DOUBLE_EQ(n1[i], n0[i]);
+        }
+    }
+
+    auto cell = itkMesh->GetCells()->Begin();
+    auto resultCell = result->GetCells()->Begin();
+    for (; cell != itkMesh->GetCells()->End(); ++cell, ++resultCell) {
+        ASSERT_EQ(resultCell.Value()->GetNumberOfPoints(), 3);
+        for (unsigned i = 0; i < 3; i++) {
+            EXPECT_EQ(
+                resultCell.Value()->GetPointIds()[i],
+                cell.Value()->GetPointIds()[i]);
+        }
+    }
+}
+
+TEST(FlatMesh, ComputeNormalsMatchesShape)
+{
+    auto itkMesh = shapes::Plane(5, 5).itkMesh();
+    auto flat = ToFlatMesh(itkMesh);
+    auto expected = flat.normals();
+
+    flat.normals().clear();
+    EXPECT_FALSE(flat.hasNormals());
+    flat.computeNormals();
+    ASSERT_TRUE(flat.hasNormals());
+    for (std::size_t i = 0; i < expected.size(); i++) {
+        EXPECT_NEAR(std::abs(flat.normals()[i].dot(expected[i])), 1, 1e-9);
+    }
+}
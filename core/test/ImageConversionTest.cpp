@@ -0,0 +1,122 @@
+#include <gtest/gtest.h>
+
+#include <opencv2/core.hpp>
+
+#include "vc/core/util/ApplyLUT.hpp"
+#include "vc/core/util/ColorMaps.hpp"
+#include "vc/core/util/ImageConversion.hpp"
+
+using namespace volcart;
+
+namespace
+{
+// Large enough to take the parallel and table-based paths
+auto RandomImage(int type, double lo, double hi) -> cv::Mat
+{
+    cv::RNG rng(1234);
+    cv::Mat m(512, 300, type);
+    rng.fill(m, cv::RNG::UNIFORM, lo, hi);
+    return m;
+}
+
+auto Equal(const cv::Mat& a, const cv::Mat& b) -> bool
+{
+    return a.size() == b.size() and a.type() == b.type() and
+           cv::norm(a, b, cv::NORM_INF) == 0;
+}
+}  // namespace
+
+TEST(ImageConversion, QuantizeMinMax)
+{
+    auto m = RandomImage(CV_32FC1, 2, 10);
+    m.at<float>(0, 0) = 2;
+    m.at<float>(511, 299) = 10;
+
+    auto q = QuantizeImage(m, CV_16U);
+    ASSERT_EQ(q.type(), CV_16UC1);
+
+    cv::Mat expected;
+    m.convertTo(expected, CV_16U, 65535. / 8, -2 * 65535. / 8);
+    EXPECT_TRUE(Equal(q, expected));
+}
+
+TEST(ImageConversion, QuantizeMultiChannel)
+{
+    auto m = RandomImage(CV_16UC3, 100, 1000);
+    double min{0};
+    double max{0};
+    cv::minMaxIdx(m.reshape(1), &min, &max);
+
+    auto q = QuantizeImage(m, CV_8U);
+    ASSERT_EQ(q.type(), CV_8UC3);
+
+    cv::Mat expected;
+    m.convertTo(expected, CV_8U, 255 / (max - min), -min * 255 / (max - min));
+    EXPECT_TRUE(Equal(q, expected));
+}
+
+TEST(ImageConversion, ColorConvert)
+{
+    cv::Mat gray(4, 4, CV_16UC1, cv::Scalar(100));
+
+    auto ga = ColorConvertImage(gray, 2);
+    ASSERT_EQ(ga.type(), CV_16UC2);
+    EXPECT_EQ(ga.at<cv::Vec2w>(1, 2), cv::Vec2w(100, 65535));
+
+    auto bgra = ColorConvertImage(ga, 4);
+    ASSERT_EQ(bgra.type(), CV_16UC4);
+    EXPECT_EQ(bgra.at<cv::Vec4w>(3, 0), cv::Vec4w(100, 100, 100, 65535));
+
+    auto back = ColorConvertImage(bgra, 2);
+    EXPECT_TRUE(Equal(back, ga));
+    EXPECT_TRUE(Equal(ColorConvertImage(ga, 1), gray));
+}
+
+TEST(ApplyLUT, TableMatchesFloat)
+{
+    auto lut = GetColorMapLUT(ColorMap::Viridis);
+    for (auto type : {CV_8UC1, CV_16UC1}) {
+        auto hi = type == CV_8UC1 ? 256 : 65536;
+        auto img = RandomImage(type, 0, hi);
+        cv::Mat imgF;
+        img.convertTo(imgF, CV_32F);
+
+        auto lo = static_cast<float>(hi) * 0.1F;
+        auto mid = static_cast<float>(hi) * 0.4F;
+        auto up = static_cast<float>(hi) * 0.9F;
+        for (auto invert : {false, true}) {
+            EXPECT_TRUE(Equal(
+                ApplyLUT(img, lut, lo, up, invert),
+                ApplyLUT(imgF, lut, lo, up, invert)));
+            EXPECT_TRUE(Equal(
+                ApplyLUT(img, lut, lo, mid, up, invert),
+                ApplyLUT(imgF, lut, lo, mid, up, invert)));
+        }
+    }
+}
+
+TEST(ApplyLUT, CachedColorMapLUT)
+{
+    auto lut = GetColorMapLUT(ColorMap::Magma, 64);
+    ASSERT_EQ(lut.cols, 64);
+    EXPECT_EQ(lut.type(), CV_8UC3);
+
+    // Modifying a returned LUT does not modify the cache
+    auto expected = lut.clone();
+    lut.setTo(0);
+    EXPECT_TRUE(Equal(GetColorMapLUT(ColorMap::Magma, 64), expected));
+    EXPECT_TRUE(Equal(GetColorMapLUT("magma", 64), expected));
+    EXPECT_EQ(GetColorMapLUT(ColorMap::Magma).cols, 256);
+}
+
+TEST(ApplyLUT, Bins)
+{
+    cv::Mat lut = (cv::Mat_<uint8_t>(1, 4) << 10, 20, 30, 40);
+    cv::Mat img = (cv::Mat_<float>(1, 4) << 0, 0.4F, 0.6F, 1);
+
+    cv::Mat expected = (cv::Mat_<uint8_t>(1, 4) << 10, 20, 30, 40);
+    EXPECT_TRUE(Equal(ApplyLUT(img, lut, 0, 1), expected));
+
+    cv::Mat inverted = (cv::Mat_<uint8_t>(1, 4) << 40, 30, 20, 10);
+    EXPECT_TRUE(Equal(ApplyLUT(img, lut, 0, 1, true), inverted));
+}
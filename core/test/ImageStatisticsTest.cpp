@@ -0,0 +1,107 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+#include "vc/core/types/ImageStatistics.hpp"
+
+using namespace volcart;
+
+TEST(ImageStatistics, Empty)
+{
+    ImageStatistics s;
+    EXPECT_EQ(s.count(), 0);
+    EXPECT_EQ(s.mean(), 0);
+    EXPECT_EQ(s.variance(), 0);
+    EXPECT_EQ(s.median(), 0);
+    EXPECT_EQ(s.percentile(50), 0);
+    EXPECT_TRUE(s.histogram().empty());
+}
+
+TEST(ImageStatistics, MatchesStoredValues)
+{
+    // Large enough to be split between threads
+    cv::Mat img(517, 301, CV_16UC1);
+    cv::RNG rng(1234);
+    rng.fill(img, cv::RNG::UNIFORM, 0, 4000);
+
+    ImageStatistics s;
+    s.add(img);
+
+    std::vector<double> vals(img.begin<uint16_t>(), img.end<uint16_t>());
+    auto mean = std::accumulate(vals.begin(), vals.end(), 0.0) / vals.size();
+    double var{0};
+    for (const auto& v : vals) {
+        var += (v - mean) * (v - mean);
+    }
+    var /= vals.size();
+    std::sort(vals.begin(), vals.end());
+
+    EXPECT_EQ(s.count(), vals.size());
+    EXPECT_EQ(s.min(), vals.front());
+    EXPECT_EQ(s.max(), vals.back());
+    EXPECT_NEAR(s.mean(), mean, 1e-9);
+    EXPECT_NEAR(s.variance(), var, 1e-6);
+    EXPECT_EQ(s.median(), vals[vals.size() / 2]);
+    auto p95 = static_cast<std::size_t>(std::ceil(0.95 * vals.size())) - 1;
+    EXPECT_EQ(s.percentile(95), vals[p95]);
+}
+
+TEST(ImageStatistics, Mask)
+{
+    cv::Mat img = (cv::Mat_<uint8_t>(2, 3) << 1, 2, 3, 4, 5, 6);
+    cv::Mat mask = (cv::Mat_<uint8_t>(2, 3) << 0, 255, 0, 255, 255, 0);
+
+    ImageStatistics s;
+    s.add(img, mask);
+    EXPECT_EQ(s.count(), 3);
+    EXPECT_EQ(s.min(), 2);
+    EXPECT_EQ(s.max(), 5);
+    EXPECT_NEAR(s.mean(), 11. / 3, 1e-12);
+    EXPECT_EQ(s.median(), 4);
+    EXPECT_EQ(s.histogram().size(), 256);
+
+    EXPECT_THROW(s.add(img, cv::Mat(1, 1, CV_8UC1)), std::invalid_argument);
+    EXPECT_THROW(s.add(cv::Mat(2, 2, CV_16UC1)), std::invalid_argument);
+    EXPECT_THROW(s.add(cv::Mat(2, 2, CV_8UC3)), std::invalid_argument);
+}
+
+TEST(ImageStatistics, Float)
+{
+    cv::Mat img = (cv::Mat_<float>(1, 5) << -2.5F, 0.F, NAN, 1.F, 100.F);
+
+    ImageStatistics s;
+    s.add(img);
+    EXPECT_EQ(s.count(), 4);
+    EXPECT_EQ(s.min(), -2.5);
+    EXPECT_EQ(s.max(), 100);
+    EXPECT_DOUBLE_EQ(s.mean(), 98.5 / 4);
+    EXPECT_EQ(s.percentile(0), -2.5);
+    EXPECT_EQ(s.percentile(100), 100);
+    EXPECT_NEAR(s.median(), 1, 0.01);
+}
+
+TEST(ImageStatistics, Merge)
+{
+    ImageStatistics a;
+    ImageStatistics b;
+    a.add(cv::Mat(2, 2, CV_16UC1, cv::Scalar(10)));
+    b.add(cv::Mat(2, 2, CV_16UC1, cv::Scalar(30)));
+    a.merge(b);
+
+    EXPECT_EQ(a.count(), 8);
+    EXPECT_EQ(a.min(), 10);
+    EXPECT_EQ(a.max(), 30);
+    EXPECT_DOUBLE_EQ(a.mean(), 20);
+    EXPECT_DOUBLE_EQ(a.variance(), 100);
+    EXPECT_DOUBLE_EQ(a.stdDev(), 10);
+    EXPECT_EQ(a.median(), 30);
+
+    ImageStatistics c;
+    c.add(cv::Mat(2, 2, CV_32FC1, cv::Scalar(1)));
+    EXPECT_THROW(a.merge(c), std::invalid_argument);
+}
@@ -76,6 +76,23 @@ TEST(Iteration, RangeIteratorEquality)
     EXPECT_EQ(it, r.end());
 }
 
+TEST(Iteration, RangeSizeAndIndex)
+{
+    // Sizes match the number of iterated values
+    for (auto r : {range(5), range(1, 5), range(1, 5, 2), range(0, 10, 3)}) {
+        size_t i{0};
+        for (const auto& v : r) {
+            EXPECT_EQ(r[i++], v);
+        }
+        EXPECT_EQ(r.size(), i);
+    }
+    EXPECT_EQ(range(5, 5).size(), 0);
+
+    auto r = range(1.F, 2.F, .25F);
+    EXPECT_EQ(r.size(), 4);
+    EXPECT_FLOAT_EQ(r[3], 1.75F);
+}
+
 TEST(Iteration, Range2DEndOnly)
 {
     // Construct range and get iterator
@@ -180,6 +197,19 @@ TEST(Iteration, Range2DFloat)
     }
 }
 
+TEST(Iteration, Range2DSizeAndIndex)
+{
+    auto r = range2D(1, 6, 0, 10, 3);
+    size_t i{0};
+    for (const auto& [v, u] : r) {
+        auto pair = r[i++];
+        EXPECT_EQ(pair.first, v);
+        EXPECT_EQ(pair.second, u);
+    }
+    EXPECT_EQ(r.size(), i);
+    EXPECT_EQ(r.size(), 8);
+}
+
 TEST(Iteration, Range2DIteratorEquality)
 {
 
@@ -0,0 +1,62 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+
+#include "vc/core/types/KDTree.hpp"
+
+using namespace volcart;
+
+namespace
+{
+auto BruteForceRadius(
+    const std::vector<cv::Vec3d>& points, const cv::Vec3d& q, double r)
+    -> std::vector<std::size_t>
+{
+    std::vector<std::size_t> result;
+    for (std::size_t i = 0; i < points.size(); i++) {
+        auto d = points[i] - q;
+        if (d.dot(d) <= r * r) {
+            result.push_back(i);
+        }
+    }
+    return result;
+}
+}  // namespace
+
+TEST(KDTree, EmptyTree)
+{
+    KDTree tree;
+    EXPECT_TRUE(tree.empty());
+    EXPECT_TRUE(tree.radiusSearch({0, 0, 0}, 10).empty());
+}
+
+TEST(KDTree, MatchesBruteForce)
+{
+    cv::RNG rng(4321);
+    std::vector<cv::Vec3d> points(5000);
+    for (auto& p : points) {
+        p = {rng.uniform(0., 100.), rng.uniform(0., 100.), rng.uniform(0., 5.)};
+    }
+    KDTree tree(points, 8);
+    ASSERT_EQ(tree.size(), points.size());
+
+    std::vector<std::size_t> result;
+    for (int i = 0; i < 100; i++) {
+        const auto& q = points[static_cast<std::size_t>(i) * 37];
+        for (auto r : {0., 1., 7.5, 200.}) {
+            tree.radiusSearch(q, r, result);
+            std::sort(result.begin(), result.end());
+            EXPECT_EQ(result, BruteForceRadius(points, q, r));
+        }
+    }
+}
+
+TEST(KDTree, DuplicatePoints)
+{
+    std::vector<cv::Vec3d> points(100, {1, 2, 3});
+    points.emplace_back(5, 5, 5);
+    KDTree tree(points, 4);
+    EXPECT_EQ(tree.radiusSearch({1, 2, 3}, 0).size(), 100);
+    EXPECT_EQ(tree.radiusSearch({5, 5, 5}, 0.5).size(), 1);
+    EXPECT_EQ(tree.radiusSearch({1, 2, 3}, 10).size(), 101);
+}
@@ -0,0 +1,98 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <stdexcept>
+
+#include <opencv2/core.hpp>
+
+#include "vc/core/types/OrderedPointSet.hpp"
+#include "vc/core/util/LargePages.hpp"
+
+using namespace volcart;
+
+namespace
+{
+// Size of a CV_8UC1 image of at least LARGE_BUFFER_BYTES
+constexpr int LARGE_ROWS{1024};
+constexpr int LARGE_COLS{4096};
+
+auto Address(const void* ptr) -> std::uintptr_t
+{
+    return reinterpret_cast<std::uintptr_t>(ptr);
+}
+}  // namespace
+
+TEST(LargePages, ParseMode)
+{
+    EXPECT_EQ(memory::ParseLargePageMode("off"), LargePageMode::Off);
+    EXPECT_EQ(
+        memory::ParseLargePageMode("transparent"), LargePageMode::Transparent);
+    EXPECT_EQ(memory::ParseLargePageMode("explicit"), LargePageMode::Explicit);
+    EXPECT_THROW(memory::ParseLargePageMode("huge"), std::invalid_argument);
+}
+
+TEST(LargePages, OffUsesStandardAllocator)
+{
+    memory::SetLargePages(LargePageMode::Off);
+    EXPECT_EQ(memory::LargePages(), LargePageMode::Off);
+
+    cv::Mat m(LARGE_ROWS, LARGE_COLS, CV_8UC1);
+    EXPECT_EQ(m.u->currAllocator, cv::Mat::getStdAllocator());
+    EXPECT_EQ(Address(m.data) % 64, 0U);
+}
+
+TEST(LargePages, SmallImagesUseStandardAllocator)
+{
+    memory::SetLargePages(LargePageMode::Transparent);
+    cv::Mat m(16, 16, CV_64FC3, cv::Scalar::all(1));
+    EXPECT_EQ(m.u->currAllocator, cv::Mat::getStdAllocator());
+    EXPECT_EQ(Address(m.data) % 64, 0U);
+    EXPECT_EQ(m.at<cv::Vec3d>(15, 15), cv::Vec3d(1, 1, 1));
+    memory::SetLargePages(LargePageMode::Off);
+}
+
+TEST(LargePages, LargeImagesAreAligned)
+{
+    for (auto mode : {LargePageMode::Transparent, LargePageMode::Explicit}) {
+        memory::SetLargePages(mode);
+        EXPECT_EQ(memory::LargePages(), mode);
+
+        cv::Mat m(LARGE_ROWS, LARGE_COLS, CV_8UC1, cv::Scalar(7));
+        ASSERT_TRUE(m.isContinuous());
+        EXPECT_EQ(Address(m.data) % 64, 0U);
+#ifdef __linux__
+        EXPECT_EQ(m.u->currAllocator, memory::LargePageAllocator());
+        EXPECT_EQ(Address(m.data) % memory::HUGE_PAGE_BYTES, 0U);
+#endif
+        EXPECT_EQ(m.at<uchar>(LARGE_ROWS - 1, LARGE_COLS - 1), 7);
+
+        // Copies and views share or reallocate the buffer
+        cv::Mat roi = m(cv::Rect(10, 10, 100, 100));
+        auto copy = m.clone();
+        m.release();
+        EXPECT_EQ(roi.at<uchar>(99, 99), 7);
+        EXPECT_EQ(copy.at<uchar>(0, 0), 7);
+        EXPECT_EQ(cv::countNonZero(copy != 7), 0);
+    }
+
+    // Images allocated before the mode changed are still released
+    cv::Mat m(LARGE_ROWS, LARGE_COLS, CV_16UC1, cv::Scalar(1));
+    memory::SetLargePages(LargePageMode::Off);
+    EXPECT_EQ(m.at<std::uint16_t>(LARGE_ROWS - 1, LARGE_COLS - 1), 1);
+    m.release();
+}
+
+TEST(LargePages, FillPointSet)
+{
+    memory::SetLargePages(LargePageMode::Transparent);
+    auto ps = OrderedPointSet<cv::Vec6d>::Fill(512, 512, {1, 2, 3, 4, 5, 6});
+    memory::SetLargePages(LargePageMode::Off);
+    ASSERT_EQ(ps.width(), 512U);
+    ASSERT_EQ(ps.height(), 512U);
+    EXPECT_EQ(ps(511, 511), cv::Vec6d(1, 2, 3, 4, 5, 6));
+    EXPECT_EQ(ps(0, 0), cv::Vec6d(1, 2, 3, 4, 5, 6));
+
+    // Small buffers are not advised
+    memory::AdviseLargePages(nullptr, memory::LARGE_BUFFER_BYTES);
+    memory::AdviseLargePages(&ps(0, 0), 1);
+}
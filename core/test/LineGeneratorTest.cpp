@@ -0,0 +1,149 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+#include "vc/core/filesystem.hpp"
+#include "vc/core/neighborhood/LineGenerator.hpp"
+#include "vc/core/types/Volume.hpp"
+
+using namespace volcart;
+namespace fs = volcart::filesystem;
+
+TEST(LineGenerator, ComputeIntoMatchesGradient)
+{
+    fs::path volPath{"vc_core_LineGenerator"};
+    fs::remove_all(volPath);
+    fs::create_directory(volPath);
+
+    // Linear gradient so that trilinear interpolation is exact
+    auto vol = Volume::New(volPath, "LineGenerator", "LineGenerator");
+    vol->setSliceWidth(20);
+    vol->setSliceHeight(20);
+    vol->setNumberOfSlices(20);
+    vol->saveMetadata();
+    for (int z = 0; z < 20; z++) {
+        cv::Mat slice(20, 20, CV_16UC1);
+        for (int y = 0; y < 20; y++) {
+            for (int x = 0; x < 20; x++) {
+                slice.at<uint16_t>(y, x) = x + 20 * y + 400 * z;
+            }
+        }
+        vol->setSliceData(z, slice);
+    }
+
+    const cv::Vec3d pt{9.3, 9.6, 9.1};
+    const auto axis = cv::normalize(cv::Vec3d{0.2, -0.4, 1});
+    auto gen = LineGenerator::New();
+
+    // Short, medium, and long lines use different sample buffers
+    for (auto interval : {1.0, 0.5, 0.1}) {
+        for (auto dir :
+             {Direction::Negative, Direction::Bidirectional,
+              Direction::Positive}) {
+            gen->setSamplingRadius(5);
+            gen->setSamplingInterval(interval);
+            gen->setSamplingDirection(dir);
+
+            auto size = gen->extents()[0];
+            std::vector<uint16_t> samples(size);
+            gen->computeInto(vol, pt, axis, samples.data());
+            auto n = gen->compute(vol, pt, {axis});
+            ASSERT_EQ(n.size(), size);
+
+            auto start = (dir == Direction::Positive) ? 0.0 : -5.0;
+            for (size_t i = 0; i < size; i++) {
+                EXPECT_EQ(n(i), samples[i]);
+                auto p = pt + axis * (start + i * interval);
+                auto expected = p[0] + 20 * p[1] + 400 * p[2];
+                EXPECT_LE(std::abs(samples[i] - expected), 0.5 + 1e-6);
+            }
+        }
+    }
+}
+
+TEST(LineGenerator, ComputeRangeIntoMatchesFullLine)
+{
+    fs::path volPath{"vc_core_LineGeneratorRange"};
+    fs::remove_all(volPath);
+    fs::create_directory(volPath);
+
+    auto vol = Volume::New(volPath, "LineGenerator", "LineGenerator");
+    vol->setSliceWidth(20);
+    vol->setSliceHeight(20);
+    vol->setNumberOfSlices(20);
+    vol->saveMetadata();
+    cv::RNG rng(1234);
+    for (int z = 0; z < 20; z++) {
+        cv::Mat slice(20, 20, CV_16UC1);
+        rng.fill(slice, cv::RNG::UNIFORM, 0, 65536);
+        vol->setSliceData(z, slice);
+    }
+
+    const cv::Vec3d pt{9.3, 9.6, 9.1};
+    const auto axis = cv::normalize(cv::Vec3d{0.2, -0.4, 1});
+    auto gen = LineGenerator::New();
+    gen->setSamplingRadius(5);
+    gen->setSamplingInterval(0.1);
+    gen->setSamplingDirection(Direction::Bidirectional);
+
+    auto size = gen->extents()[0];
+    std::vector<uint16_t> full(size);
+    gen->computeInto(vol, pt, axis, full.data());
+
+    // Ranges of every buffer size, including ones which end the line
+    for (auto count : {size_t{1}, size_t{7}, size_t{40}, size}) {
+        std::vector<uint16_t> range(count);
+        for (size_t first = 0; first + count <= size; first += 13) {
+            gen->computeRangeInto(vol, pt, axis, first, count, range.data());
+            for (size_t i = 0; i < count; i++) {
+                EXPECT_EQ(range[i], full[first + i]);
+            }
+        }
+    }
+
+    std::vector<uint16_t> range(2);
+    EXPECT_THROW(
+        gen->computeRangeInto(vol, pt, axis, size - 1, 2, range.data()),
+        std::out_of_range);
+}
+
+TEST(LineGenerator, Interpolation)
+{
+    fs::path volPath{"vc_core_LineGeneratorInterpolation"};
+    fs::remove_all(volPath);
+    fs::create_directory(volPath);
+
+    auto vol = Volume::New(volPath, "LineGenerator", "LineGenerator");
+    vol->setSliceWidth(20);
+    vol->setSliceHeight(20);
+    vol->setNumberOfSlices(20);
+    vol->saveMetadata();
+    cv::RNG rng(1234);
+    for (int z = 0; z < 20; z++) {
+        cv::Mat slice(20, 20, CV_16UC1);
+        rng.fill(slice, cv::RNG::UNIFORM, 0, 65536);
+        vol->setSliceData(z, slice);
+    }
+
+    const cv::Vec3d pt{9.3, 9.6, 9.1};
+    const auto axis = cv::normalize(cv::Vec3d{0.2, -0.4, 1});
+    auto gen = LineGenerator::New();
+    EXPECT_EQ(gen->interpolation(), Volume::Interpolation::Trilinear);
+    gen->setSamplingRadius(5);
+    gen->setSamplingInterval(0.5);
+
+    for (auto method :
+         {Volume::Interpolation::Nearest, Volume::Interpolation::Trilinear,
+          Volume::Interpolation::Tricubic}) {
+        gen->setInterpolation(method);
+        auto n = gen->compute(vol, pt, {axis});
+        for (size_t i = 0; i < n.size(); i++) {
+            auto p = pt + axis * (-5.0 + i * 0.5);
+            EXPECT_EQ(n(i), vol->interpolateAt(p, method));
+        }
+    }
+}
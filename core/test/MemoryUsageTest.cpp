@@ -0,0 +1,93 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <utility>
+
+#include "vc/core/util/MemoryUsage.hpp"
+
+using namespace volcart;
+
+namespace mem = volcart::memory;
+
+TEST(MemoryUsage, TrackedBytes)
+{
+    auto base = mem::Current(MemoryCategory::PPM);
+    {
+        mem::TrackedBytes a(MemoryCategory::PPM);
+        a.set(100);
+        EXPECT_EQ(mem::Current(MemoryCategory::PPM), base + 100);
+        mem::Sample();
+        EXPECT_GE(mem::Peak(MemoryCategory::PPM), base + 100);
+
+        // Copies count their bytes again
+        auto b = a;
+        EXPECT_EQ(mem::Current(MemoryCategory::PPM), base + 200);
+
+        // Moves transfer their bytes
+        auto c = std::move(b);
+        EXPECT_EQ(b.bytes(), 0);
+        EXPECT_EQ(c.bytes(), 100);
+        EXPECT_EQ(mem::Current(MemoryCategory::PPM), base + 200);
+
+        a.set(50);
+        EXPECT_EQ(mem::Current(MemoryCategory::PPM), base + 150);
+    }
+    EXPECT_EQ(mem::Current(MemoryCategory::PPM), base);
+}
+
+TEST(MemoryUsage, SharedProviders)
+{
+    auto base = mem::Current(MemoryCategory::SliceCache);
+    int key{0};
+    {
+        auto r0 = mem::RegisterProvider(
+            MemoryCategory::SliceCache, []() { return 10; });
+        auto r1 = mem::RegisterProvider(
+            MemoryCategory::SliceCache, []() { return 20; }, &key);
+        auto r2 = mem::RegisterProvider(
+            MemoryCategory::SliceCache, []() { return 20; }, &key);
+        EXPECT_EQ(mem::Current(MemoryCategory::SliceCache), base + 30);
+
+        r0.reset();
+        EXPECT_EQ(mem::Current(MemoryCategory::SliceCache), base + 20);
+    }
+    EXPECT_EQ(mem::Current(MemoryCategory::SliceCache), base);
+}
+
+TEST(MemoryUsage, SoftLimitShrinks)
+{
+    constexpr std::size_t MB{1 << 20};
+    std::size_t cache{16 * MB};
+    auto provider = mem::RegisterProvider(
+        MemoryCategory::SliceCache, [&cache]() { return cache; });
+    auto handler = mem::RegisterShrinkHandler([&cache](auto excess) {
+        cache -= std::min(cache, excess);
+    });
+
+    // Under the limit
+    mem::SetSoftLimit(mem::Total() + MB);
+    mem::Sample();
+    EXPECT_EQ(cache, 16 * MB);
+
+    // Growing another category past the limit shrinks the cache
+    {
+        mem::TrackedBytes texture(MemoryCategory::Texture);
+        texture.set(3 * MB);
+        EXPECT_EQ(cache, 14 * MB);
+        EXPECT_LE(mem::Total(), mem::SoftLimit());
+        EXPECT_GE(mem::PeakTotal(), mem::SoftLimit() + 2 * MB);
+    }
+
+    mem::SetSoftLimit(0);
+    EXPECT_EQ(mem::SoftLimit(), 0);
+}
+
+TEST(MemoryUsage, Summary)
+{
+    auto summary = mem::Summary();
+    for (int i = 0; i < static_cast<int>(mem::NUM_CATEGORIES); i++) {
+        auto name = mem::CategoryName(static_cast<MemoryCategory>(i));
+        EXPECT_NE(summary.find(name), std::string::npos);
+    }
+    EXPECT_NE(mem::Report().find("Peak"), std::string::npos);
+}
@@ -0,0 +1,83 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+
+#include "vc/core/shapes/Arch.hpp"
+#include "vc/core/types/FlatMesh.hpp"
+#include "vc/core/util/MeshMath.hpp"
+
+using namespace volcart;
+namespace mm = volcart::meshmath;
+
+namespace
+{
+// Unit square in the z = 2 plane
+auto Square() -> FlatMesh
+{
+    FlatMesh mesh;
+    mesh.addVertex({0, 0, 2});
+    mesh.addVertex({1, 0, 2});
+    mesh.addVertex({1, 1, 2});
+    mesh.addVertex({0, 1, 2});
+    mesh.addFace(0, 1, 2);
+    mesh.addFace(0, 2, 3);
+    return mesh;
+}
+}  // namespace
+
+TEST(MeshMath, SquareMetrics)
+{
+    auto mesh = Square();
+    EXPECT_DOUBLE_EQ(mm::SurfaceArea(mesh), 1);
+
+    auto bounds = mm::Bounds(mesh);
+    EXPECT_EQ(bounds.getLowerBound(), cv::Vec3d(0, 0, 2));
+    EXPECT_EQ(bounds.getUpperBound(), cv::Vec3d(1, 1, 2));
+
+    auto edges = mm::EdgeLengths(mesh);
+    EXPECT_EQ(edges.count, 6);
+    EXPECT_DOUBLE_EQ(edges.min, 1);
+    EXPECT_DOUBLE_EQ(edges.max, std::sqrt(2.0));
+    EXPECT_DOUBLE_EQ(edges.mean, (4 + 2 * std::sqrt(2.0)) / 6);
+    EXPECT_GT(edges.stddev, 0);
+
+    auto normals = mm::FaceNormals(mesh);
+    ASSERT_EQ(normals.size(), 2);
+    for (const auto& n : normals) {
+        EXPECT_EQ(n, cv::Vec3d(0, 0, 1));
+    }
+}
+
+TEST(MeshMath, EmptyMesh)
+{
+    FlatMesh mesh;
+    EXPECT_EQ(mm::SurfaceArea(mesh), 0);
+    EXPECT_EQ(mm::EdgeLengths(mesh).count, 0);
+    EXPECT_TRUE(mm::FaceNormals(mesh).empty());
+}
+
+TEST(MeshMath, ThreadCountIndependent)
+{
+    auto itkMesh = shapes::Arch(100, 100).itkMesh();
+    auto mesh = ToFlatMesh(itkMesh);
+
+    auto area = mm::SurfaceArea(mesh, 1);
+    EXPECT_GT(area, 0);
+    EXPECT_EQ(mm::SurfaceArea(mesh, 4), area);
+    EXPECT_EQ(mm::SurfaceArea(itkMesh), area);
+
+    auto edges = mm::EdgeLengths(mesh, 1);
+    auto parallel = mm::EdgeLengths(mesh, 4);
+    EXPECT_EQ(parallel.count, mesh.numFaces() * 3);
+    EXPECT_EQ(parallel.mean, edges.mean);
+    EXPECT_EQ(parallel.stddev, edges.stddev);
+
+    // Face normals agree in orientation with the vertex normals
+    mesh.computeNormals();
+    auto normals = mm::FaceNormals(mesh, 4);
+    for (std::size_t i = 0; i < mesh.numFaces(); i++) {
+        const auto& f = mesh.faces()[i];
+        EXPECT_NEAR(cv::norm(normals[i]), 1, 1e-9);
+        EXPECT_GT(normals[i].dot(mesh.normals()[f[0]]), 0);
+    }
+}
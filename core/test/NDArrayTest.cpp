@@ -1,3 +1,4 @@
+#include <array>
 #include <iostream>
 
 #include <gtest/gtest.h>
@@ -74,4 +75,48 @@ TEST(NDArray, BadConstructor)
     EXPECT_THROW(
         IntArray array2_3(2, {5, 3}, data.begin(), data.end()),
         std::invalid_argument);
-}
\ No newline at end of file
+}
+
+TEST(NDArray, View)
+{
+    // Fill a 3D array
+    IntArray array3(3, 4, 3, 2);
+    int val = 0;
+    for (auto& i : array3) {
+        i = val++;
+    }
+
+    // View matches checked access
+    auto view = array3.view();
+    EXPECT_EQ(view.dims(), 3);
+    EXPECT_EQ(view.size(), array3.size());
+    for (Idx z = 0; z < 4; z++) {
+        for (Idx y = 0; y < 3; y++) {
+            for (Idx x = 0; x < 2; x++) {
+                EXPECT_EQ(view(z, y, x), array3(z, y, x));
+            }
+        }
+    }
+
+    // Writes through the view
+    view(3, 2, 1) = -1;
+    EXPECT_EQ(array3(3, 2, 1), -1);
+    EXPECT_EQ(array3.back(), -1);
+}
+
+TEST(NDArray, ViewExternalData)
+{
+    // View a stack buffer
+    std::array<int, 12> buffer{};
+    vc::NDArrayView<int> view(buffer.data(), {3, 4});
+    EXPECT_EQ(view.extent(0), 3);
+    EXPECT_EQ(view.extent(1), 4);
+    view(2, 1) = 5;
+    EXPECT_EQ(buffer[9], 5);
+    EXPECT_EQ(std::distance(view.begin(), view.end()), 12);
+
+    // Too many dimensions
+    EXPECT_THROW(
+        vc::NDArrayView<int>(buffer.data(), {1, 1, 1, 1, 1}),
+        std::invalid_argument);
+}
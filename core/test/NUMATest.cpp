@@ -0,0 +1,47 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "vc/core/util/NUMA.hpp"
+
+using namespace volcart;
+
+TEST(NUMA, ParseCPUList)
+{
+    EXPECT_EQ(numa::ParseCPUList("0"), std::vector<int>{0});
+    EXPECT_EQ(
+        numa::ParseCPUList("0-3,8,10-11\n"),
+        (std::vector<int>{0, 1, 2, 3, 8, 10, 11}));
+    EXPECT_TRUE(numa::ParseCPUList("\n").empty());
+    EXPECT_THROW(numa::ParseCPUList("1-"), std::invalid_argument);
+    EXPECT_THROW(numa::ParseCPUList("3-1"), std::invalid_argument);
+    EXPECT_THROW(numa::ParseCPUList("1;2"), std::invalid_argument);
+}
+
+TEST(NUMA, Topology)
+{
+    auto nodes = numa::NumNodes();
+    ASSERT_GE(nodes, 1);
+    EXPECT_LT(numa::CurrentNode(), nodes);
+    EXPECT_THROW(numa::NodeCPUs(nodes), std::out_of_range);
+
+    // Every CPU belongs to one node
+    std::vector<int> seen;
+    for (std::size_t n = 0; n < nodes; n++) {
+        for (auto cpu : numa::NodeCPUs(n)) {
+            EXPECT_EQ(std::count(seen.begin(), seen.end(), cpu), 0);
+            seen.push_back(cpu);
+        }
+    }
+}
+
+TEST(NUMA, ScopedBinding)
+{
+    for (std::size_t n = 0; n < numa::NumNodes(); n++) {
+        const numa::ScopedBinding binding(n);
+        if (binding.bound()) {
+            EXPECT_EQ(numa::CurrentNode(), n);
+        }
+    }
+}
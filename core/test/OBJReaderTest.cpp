@@ -4,6 +4,8 @@
 #include <opencv2/core.hpp>
 
 #include "vc/core/io/OBJReader.hpp"
+#include "vc/core/io/OBJWriter.hpp"
+#include "vc/core/shapes/Plane.hpp"
 #include "vc/core/types/Exceptions.hpp"
 
 using namespace volcart;
@@ -84,4 +86,34 @@ TEST_F(OBJReader, Invalid)
 {
     reader.setPath(path + "Invalid.obj");
     EXPECT_THROW(reader.read(), IOException);
-}
\ No newline at end of file
+}
+
+TEST_F(OBJReader, MultithreadedMatchesSingleThreaded)
+{
+    // Large enough to be split between threads
+    auto in = shapes::Plane(300, 300).itkMesh();
+    io::OBJWriter writer;
+    writer.setPath(path + "Multithreaded.obj");
+    writer.setMesh(in);
+    writer.write();
+
+    reader.setPath(path + "Multithreaded.obj");
+    reader.setNumThreads(1);
+    auto single = reader.read();
+    reader.setNumThreads(4);
+    auto multi = reader.read();
+
+    ASSERT_EQ(single->GetNumberOfPoints(), in->GetNumberOfPoints());
+    ASSERT_EQ(multi->GetNumberOfPoints(), in->GetNumberOfPoints());
+    ASSERT_EQ(multi->GetNumberOfCells(), in->GetNumberOfCells());
+    for (ITKMesh::PointIdentifier i = 0; i < in->GetNumberOfPoints(); i++) {
+        EXPECT_EQ(multi->GetPoint(i), single->GetPoint(i));
+    }
+    for (auto s = single->GetCells()->Begin(), m = multi->GetCells()->Begin();
+         s != single->GetCells()->End(); ++s, ++m) {
+        for (int v = 0; v < 3; v++) {
+            EXPECT_EQ(
+                m.Value()->GetPointIds()[v], s.Value()->GetPointIds()[v]);
+        }
+    }
+}
@@ -1,10 +1,16 @@
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <fstream>
 #include <iostream>
+#include <vector>
 
 #include <opencv2/core.hpp>
 
+#include "vc/core/io/MappedPointSet.hpp"
 #include "vc/core/io/PointSetIO.hpp"
+#include "vc/core/io/PointSetReader.hpp"
+#include "vc/core/io/PointSetWriter.hpp"
 #include "vc/core/types/OrderedPointSet.hpp"
 
 using namespace volcart;
@@ -18,6 +24,7 @@ public:
     OrderedPointSetIO() : ps{3}
     {
         ps.pushRow({{1, 1, 1}, {2, 2, 2}, {3, 3, 3}});
+        ps.pushRow({{4, 4, 4}, {5, 5, 5}, {6, 6, 6}});
     }
 };
 
@@ -54,4 +61,170 @@ TEST_F(OrderedPointSetIO, WriteReadASCII)
     EXPECT_EQ(read(0, 0), ps(0, 0));
     EXPECT_EQ(read(0, 1), ps(0, 1));
     EXPECT_EQ(read(0, 2), ps(0, 2));
-}
\ No newline at end of file
+}
+
+TEST_F(OrderedPointSetIO, MappedView)
+{
+    path += "MappedView.vcps";
+    PointSetIO<cv::Vec3i>::WriteOrderedPointSet(path, ps);
+
+    // Map the file
+    MappedPointSet<cv::Vec3i> mapped{path, true};
+    EXPECT_TRUE(mapped.ordered());
+    EXPECT_EQ(mapped.width(), ps.width());
+    EXPECT_EQ(mapped.height(), ps.height());
+    EXPECT_EQ(mapped.size(), ps.size());
+
+    // Check values
+    for (std::size_t y = 0; y < ps.height(); y++) {
+        EXPECT_EQ(mapped.getRow(y), ps.getRow(y));
+        for (std::size_t x = 0; x < ps.width(); x++) {
+            EXPECT_EQ(mapped(y, x), ps(y, x));
+        }
+    }
+    EXPECT_TRUE(std::equal(mapped.begin(), mapped.end(), ps.begin()));
+    EXPECT_THROW(mapped(ps.height(), 0), std::out_of_range);
+
+    // Copy out of the mapping
+    auto copy = mapped.toOrderedPointSet();
+    EXPECT_EQ(copy.width(), ps.width());
+    EXPECT_TRUE(std::equal(copy.begin(), copy.end(), ps.begin()));
+}
+
+TEST_F(OrderedPointSetIO, MappedTruncatedThrows)
+{
+    path += "MappedTruncated.vcps";
+    std::ofstream out{path, std::ios::binary};
+    out << PointSetIO<cv::Vec3i>::MakeOrderedHeader(ps);
+    out.write(reinterpret_cast<const char*>(ps[0].val), sizeof(cv::Vec3i));
+    out.close();
+
+    using Mapped = MappedPointSet<cv::Vec3i>;
+    EXPECT_THROW(Mapped(path, true), IOException);
+}
+
+TEST_F(OrderedPointSetIO, StreamRowsBinary)
+{
+    path += "StreamRowsBinary.vcps";
+    PointSetIO<cv::Vec3i>::WriteOrderedPointSet(path, ps);
+
+    PointSetReader<cv::Vec3i> reader{path};
+    EXPECT_EQ(reader.header().width, ps.width());
+    EXPECT_EQ(reader.header().height, ps.height());
+
+    std::vector<cv::Vec3i> row;
+    std::size_t y{0};
+    while (reader.readRow(row)) {
+        EXPECT_EQ(row, ps.getRow(y++));
+    }
+    EXPECT_EQ(y, ps.height());
+    EXPECT_EQ(reader.remaining(), 0);
+}
+
+TEST_F(OrderedPointSetIO, StreamRowsASCII)
+{
+    path += "StreamRowsASCII.vcps";
+    PointSetIO<cv::Vec3i>::WriteOrderedPointSet(path, ps, IOMode::ASCII);
+
+    PointSetReader<cv::Vec3i> reader{path, IOMode::ASCII};
+    std::vector<cv::Vec3i> row;
+    std::size_t y{0};
+    while (reader.readRow(row)) {
+        EXPECT_EQ(row, ps.getRow(y++));
+    }
+    EXPECT_EQ(y, ps.height());
+}
+
+TEST_F(OrderedPointSetIO, AppendRows)
+{
+    path += "AppendRows.vcps";
+    {
+        OrderedPointSetWriter<cv::Vec3i> writer{path, ps.width()};
+        EXPECT_EQ(writer.height(), 0);
+        writer.writeRow(ps.getRow(0));
+        EXPECT_EQ(PointSetIO<cv::Vec3i>::ReadOrderedPointSet(path).height(), 1);
+        writer.writeRow(ps.getRow(1));
+        EXPECT_THROW(writer.writeRow({{1, 1, 1}}), IOException);
+    }
+
+    // Every reader sees the appended rows
+    auto read = PointSetIO<cv::Vec3i>::ReadOrderedPointSet(path);
+    EXPECT_EQ(read.height(), ps.height());
+    EXPECT_TRUE(std::equal(read.begin(), read.end(), ps.begin()));
+    MappedPointSet<cv::Vec3i> mapped{path, true};
+    EXPECT_EQ(mapped.height(), ps.height());
+
+    // Reopen, keep the first row, and append the point set again
+    auto writer = OrderedPointSetWriter<cv::Vec3i>::Append(path, 1);
+    EXPECT_EQ(writer.width(), ps.width());
+    EXPECT_EQ(writer.height(), 1);
+    writer.writeRows(ps);
+    read = PointSetIO<cv::Vec3i>::ReadOrderedPointSet(path);
+    EXPECT_EQ(read.height(), 3);
+    EXPECT_EQ(read.getRow(0), ps.getRow(0));
+    EXPECT_EQ(read.getRow(1), ps.getRow(0));
+    EXPECT_EQ(read.getRow(2), ps.getRow(1));
+}
+
+TEST_F(OrderedPointSetIO, AppendDiscardsPartialRow)
+{
+    path += "AppendPartialRow.vcps";
+    PointSetIO<cv::Vec3i>::WriteOrderedPointSet(path, ps);
+
+    // Simulate a write which was interrupted before the header was updated
+    {
+        std::ofstream out{path, std::ios::binary | std::ios::app};
+        out.write(reinterpret_cast<const char*>(ps[0].val), sizeof(cv::Vec3i));
+    }
+    EXPECT_EQ(PointSetIO<cv::Vec3i>::ReadOrderedPointSet(path).height(), 2);
+
+    auto writer = OrderedPointSetWriter<cv::Vec3i>::Append(path);
+    EXPECT_EQ(writer.height(), 2);
+    writer.writeRow(ps.getRow(1));
+    auto read = PointSetIO<cv::Vec3i>::ReadOrderedPointSet(path);
+    EXPECT_EQ(read.height(), 3);
+    EXPECT_EQ(read.getRow(2), ps.getRow(1));
+}
+
+TEST_F(OrderedPointSetIO, AppendUnpaddedHeader)
+{
+    // Files written by earlier releases do not pad the height
+    path += "AppendUnpadded.vcps";
+    {
+        std::ofstream out{path, std::ios::binary};
+        out << "width: 3\nheight: 2\ndim: 3\nordered: true\ntype: int\n"
+               "version: 1\n<>\n";
+        for (const auto& p : ps) {
+            out.write(reinterpret_cast<const char*>(p.val), sizeof(p.val));
+        }
+    }
+
+    auto writer = OrderedPointSetWriter<cv::Vec3i>::Append(path);
+    EXPECT_EQ(writer.height(), 2);
+    writer.writeRow(ps.getRow(0));
+    auto read = PointSetIO<cv::Vec3i>::ReadOrderedPointSet(path);
+    EXPECT_EQ(read.height(), 3);
+    EXPECT_EQ(read.getRow(1), ps.getRow(1));
+    EXPECT_EQ(read.getRow(2), ps.getRow(0));
+}
+
+TEST_F(OrderedPointSetIO, AsyncAppendRows)
+{
+    path += "AsyncAppendRows.vcps";
+    {
+        AsyncPointSetWriter<cv::Vec3i> writer{
+            OrderedPointSetWriter<cv::Vec3i>{path, ps.width()}};
+        for (int i = 0; i < 100; i++) {
+            writer.writeRow(ps.getRow(i % 2));
+        }
+        EXPECT_EQ(writer.flush(), 100);
+        auto read = PointSetIO<cv::Vec3i>::ReadOrderedPointSet(path);
+        EXPECT_EQ(read.height(), 100);
+        writer.writeRow(ps.getRow(0));
+    }
+
+    // Queued rows are written on destruction
+    auto read = PointSetIO<cv::Vec3i>::ReadOrderedPointSet(path);
+    EXPECT_EQ(read.height(), 101);
+    EXPECT_EQ(read.getRow(99), ps.getRow(1));
+}
@@ -140,4 +140,58 @@ TEST_F(OrderedPointSet, Append_WidthCheck)
     vc::OrderedPointSet<cv::Vec3i> other{4};
     other.pushRow({{1, 1, 1}, {2, 2, 2}, {3, 3, 3}, {4, 4, 4}});
     EXPECT_THROW(ps.append(other), std::logic_error);
-}
\ No newline at end of file
+}
+
+TEST_F(OrderedPointSet, RowView)
+{
+    auto row = ps.row(0);
+    ASSERT_EQ(row.size(), 3);
+    EXPECT_EQ(row[0], cv::Vec3i(1, 1, 1));
+    EXPECT_EQ(row[2], cv::Vec3i(3, 3, 3));
+
+    // Views refer to the points of the set
+    row[1] = {5, 5, 5};
+    EXPECT_EQ(ps(0, 1), cv::Vec3i(5, 5, 5));
+
+    const auto& cps = ps;
+    auto crow = cps.row(1);
+    EXPECT_EQ(crow.data(), &ps(1, 0));
+    for (const auto& p : crow) {
+        EXPECT_EQ(p, cv::Vec3i(4, 4, 4));
+    }
+
+    EXPECT_THROW(ps.row(4), std::range_error);
+    EXPECT_THROW(cps.row(4), std::range_error);
+}
+
+TEST_F(OrderedPointSet, PushRowView)
+{
+    vc::OrderedPointSet<cv::Vec3i> other(3);
+    other.pushRow(ps.row(1));
+    other.pushRow(ps.row(0));
+    EXPECT_EQ(other.height(), 2);
+    EXPECT_EQ(other(0, 0), cv::Vec3i(4, 4, 4));
+    EXPECT_EQ(other(1, 2), cv::Vec3i(3, 3, 3));
+}
+
+TEST_F(OrderedPointSet, ReserveRows)
+{
+    vc::OrderedPointSet<cv::Vec3i> other(3);
+    other.reserveRows(100);
+    other.pushRow(ps.row(0));
+    const auto* first = &other(0, 0);
+    for (size_t i = 1; i < 100; i++) {
+        other.pushRow(ps.row(i % ps.height()));
+    }
+    EXPECT_EQ(other.height(), 100);
+    EXPECT_EQ(&other(0, 0), first);
+}
+
+TEST_F(OrderedPointSet, Convert)
+{
+    vc::OrderedPointSet<cv::Vec3f> converted(ps);
+    EXPECT_EQ(converted.width(), ps.width());
+    EXPECT_EQ(converted.height(), ps.height());
+    EXPECT_EQ(converted(0, 2), cv::Vec3f(3, 3, 3));
+    EXPECT_EQ(converted(3, 0), cv::Vec3f(1, 1, 1));
+}
@@ -0,0 +1,95 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+
+#include <opencv2/core.hpp>
+
+#include "vc/core/filesystem.hpp"
+#include "vc/core/math/OrientationField.hpp"
+#include "vc/core/types/Volume.hpp"
+
+using namespace volcart;
+namespace fs = volcart::filesystem;
+
+class OrientationRampVolume : public ::testing::Test
+{
+public:
+    static constexpr int SIZE = 40;
+
+    Volume::Pointer vol;
+    Volume::Pointer field;
+
+    OrientationRampVolume()
+    {
+        fs::path volPath{"vc_core_OrientationField_Ramp"};
+        fs::remove_all(volPath);
+        fs::create_directory(volPath);
+
+        vol = Volume::New(volPath, "Ramp", "Ramp");
+        vol->setSliceWidth(SIZE);
+        vol->setSliceHeight(SIZE);
+        vol->setNumberOfSlices(SIZE);
+        vol->saveMetadata();
+
+        // Intensity increases along Z
+        for (int z = 0; z < SIZE; z++) {
+            cv::Mat slice(SIZE, SIZE, CV_16UC1, cv::Scalar(1000 * z));
+            vol->setSliceData(z, slice);
+        }
+
+        fs::path fieldPath{"vc_core_OrientationField_Field"};
+        fs::remove_all(fieldPath);
+        fs::create_directory(fieldPath);
+        field = Volume::New(fieldPath, "Field", "Field");
+    }
+};
+
+TEST(OrientationField, EncodeDecode)
+{
+    const double maxError = std::cos(2.5 * M_PI / 180);
+    for (int i = 0; i < 200; i++) {
+        // Spread directions over the sphere
+        auto z = 1 - 2 * (i + 0.5) / 200;
+        auto r = std::sqrt(1 - z * z);
+        auto phi = i * 2.399963;
+        cv::Vec3d dir{r * std::cos(phi), r * std::sin(phi), z};
+
+        EigenPairs ep;
+        ep[0] = {3, dir};
+        ep[1] = {1, {0, 0, 0}};
+        ep[2] = {0, {0, 0, 0}};
+        auto v = OrientationField::Encode(ep);
+        auto decoded = OrientationField::DecodeDirection(v);
+        EXPECT_NEAR(cv::norm(decoded), 1, 1e-9);
+        EXPECT_GE(decoded[2], 0);
+        EXPECT_GE(std::abs(decoded.dot(dir)), maxError) << i;
+        EXPECT_NEAR(OrientationField::DecodeCoherence(v), 0.5, 1.0 / 15);
+    }
+}
+
+TEST_F(OrientationRampVolume, Compute)
+{
+    OrientationField::Compute(vol, field, 2);
+    EXPECT_EQ(field->sliceWidth(), SIZE);
+    EXPECT_EQ(field->sliceHeight(), SIZE);
+    EXPECT_EQ(field->numSlices(), SIZE);
+    field->saveMetadata();
+
+    OrientationField orientation(field);
+    for (const auto& p : {cv::Vec3d{20, 20, 20}, cv::Vec3d{10.3, 25.7, 17.5}}) {
+        auto dir = orientation.directionAt(p);
+        EXPECT_NEAR(std::abs(dir[2]), 1, 1e-3);
+        EXPECT_GT(orientation.coherenceAt(p), 0.9);
+    }
+
+    auto dirs = orientation.directionsAt({{12, 14, 16}, {30.5, 8.25, 22.75}});
+    ASSERT_EQ(dirs.size(), 2U);
+    for (const auto& dir : dirs) {
+        EXPECT_NEAR(std::abs(dir[2]), 1, 1e-3);
+    }
+}
+
+TEST(OrientationField, RequiresVolume)
+{
+    EXPECT_THROW(OrientationField(nullptr), std::invalid_argument);
+}
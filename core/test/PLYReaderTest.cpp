@@ -257,4 +257,63 @@ TEST_F(ReadITKSphereMeshFixture, ReadSphereMeshTest)
         EXPECT_EQ(in_C->GetPointIds()[1], read_C->GetPointIds()[1]);
         EXPECT_EQ(in_C->GetPointIds()[2], read_C->GetPointIds()[2]);
     }
-}
\ No newline at end of file
+}
+class ReadBinaryPLYFixture : public ::testing::TestWithParam<
+                                 volcart::io::PLYWriter::Precision>
+{
+public:
+    ReadBinaryPLYFixture() { _in_Mesh = _Sphere.itkMesh(); }
+
+    volcart::ITKMesh::Pointer _in_Mesh;
+    volcart::shapes::Sphere _Sphere;
+};
+
+TEST_P(ReadBinaryPLYFixture, ReadBinaryMeshTest)
+{
+    using Precision = volcart::io::PLYWriter::Precision;
+    volcart::io::PLYWriter writer("PLYReader_binary.ply", _in_Mesh);
+    writer.setFormat(volcart::io::PLYWriter::Format::BinaryLittleEndian);
+    writer.setPrecision(GetParam());
+    writer.write();
+
+    volcart::io::PLYReader reader("PLYReader_binary.ply");
+    auto read = reader.read();
+    ASSERT_EQ(_in_Mesh->GetNumberOfPoints(), read->GetNumberOfPoints());
+    ASSERT_EQ(_in_Mesh->GetNumberOfCells(), read->GetNumberOfCells());
+    for (uint64_t pnt_id = 0; pnt_id < _in_Mesh->GetNumberOfPoints();
+         pnt_id++) {
+        volcart::ITKPixel in_normal;
+        volcart::ITKPixel read_normal;
+        _in_Mesh->GetPointData(pnt_id, &in_normal);
+        read->GetPointData(pnt_id, &read_normal);
+        for (int i = 0; i < 3; i++) {
+            auto in = _in_Mesh->GetPoint(pnt_id)[i];
+            auto out = read->GetPoint(pnt_id)[i];
+            if (GetParam() == Precision::Float64) {
+                EXPECT_EQ(in, out);
+                EXPECT_EQ(in_normal[i], read_normal[i]);
+            } else {
+                EXPECT_EQ(static_cast<float>(in), out);
+                EXPECT_EQ(static_cast<float>(in_normal[i]), read_normal[i]);
+            }
+        }
+    }
+
+    for (uint64_t cell_id = 0; cell_id < _in_Mesh->GetNumberOfCells();
+         cell_id++) {
+        volcart::ITKCell::CellAutoPointer in_C;
+        _in_Mesh->GetCell(cell_id, in_C);
+        volcart::ITKCell::CellAutoPointer read_C;
+        read->GetCell(cell_id, read_C);
+        EXPECT_EQ(in_C->GetPointIds()[0], read_C->GetPointIds()[0]);
+        EXPECT_EQ(in_C->GetPointIds()[1], read_C->GetPointIds()[1]);
+        EXPECT_EQ(in_C->GetPointIds()[2], read_C->GetPointIds()[2]);
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    PLYPrecision,
+    ReadBinaryPLYFixture,
+    ::testing::Values(
+        volcart::io::PLYWriter::Precision::Float32,
+        volcart::io::PLYWriter::Precision::Float64));
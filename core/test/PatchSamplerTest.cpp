@@ -0,0 +1,144 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+#include "vc/core/filesystem.hpp"
+#include "vc/core/neighborhood/PatchSampler.hpp"
+#include "vc/core/types/Volume.hpp"
+
+using namespace volcart;
+namespace fs = volcart::filesystem;
+
+namespace
+{
+const std::vector<cv::Vec3d> Axes{{1, 0, 0}, {0, 1, 0}, {0, 0, 1}};
+
+auto TestVolume(const fs::path& volPath) -> Volume::Pointer
+{
+    fs::remove_all(volPath);
+    fs::create_directory(volPath);
+
+    auto vol = Volume::New(volPath, "PatchSampler", "PatchSampler");
+    vol->setSliceWidth(20);
+    vol->setSliceHeight(20);
+    vol->setNumberOfSlices(40);
+    vol->saveMetadata();
+    cv::RNG rng(1234);
+    for (int z = 0; z < 40; z++) {
+        cv::Mat slice(20, 20, CV_16UC1);
+        rng.fill(slice, cv::RNG::UNIFORM, 0, 65535);
+        vol->setSliceData(z, slice);
+    }
+    return vol;
+}
+
+auto TestCenters(std::size_t n) -> std::vector<cv::Vec3d>
+{
+    cv::RNG rng(5678);
+    std::vector<cv::Vec3d> centers;
+    for (std::size_t i = 0; i < n; i++) {
+        centers.emplace_back(
+            rng.uniform(0.0, 20.0), rng.uniform(0.0, 20.0),
+            rng.uniform(0.0, 40.0));
+    }
+    return centers;
+}
+}  // namespace
+
+TEST(PatchSampler, RequestedOrderMatchesCompute)
+{
+    auto vol = TestVolume("vc_core_PatchSampler");
+    auto gen = CuboidGenerator::New();
+    gen->setSamplingRadius(2, 1, 3);
+    auto centers = TestCenters(50);
+
+    PatchSampler sampler(vol, *gen);
+    sampler.setCenters(centers);
+    sampler.setBatchSize(8);
+    sampler.setPrefetchBatches(3);
+    sampler.setSlabDepth(8);
+    EXPECT_EQ(sampler.numBatches(), 7U);
+    ASSERT_EQ(sampler.patchSize(), gen->size());
+
+    std::size_t next{0};
+    std::size_t batches{0};
+    while (auto batch = sampler.next()) {
+        batches++;
+        ASSERT_EQ(
+            batch->patches.size(), batch->indices.size() * gen->size());
+        for (std::size_t i = 0; i < batch->indices.size(); i++) {
+            ASSERT_EQ(batch->indices[i], next++);
+            auto n = gen->compute(vol, centers[batch->indices[i]], Axes);
+            const auto* patch = batch->patches.data() + i * gen->size();
+            for (std::size_t s = 0; s < gen->size(); s++) {
+                ASSERT_EQ(patch[s], n.data()[s]);
+            }
+        }
+    }
+    EXPECT_EQ(batches, 7U);
+    EXPECT_EQ(next, centers.size());
+    EXPECT_FALSE(sampler.next());
+
+    // Reset restarts at the first batch
+    sampler.reset();
+    auto first = sampler.next();
+    ASSERT_TRUE(first);
+    EXPECT_EQ(first->indices.front(), 0U);
+}
+
+TEST(PatchSampler, LocalityOrderIsSlabOrdered)
+{
+    auto vol = TestVolume("vc_core_PatchSamplerLocality");
+    auto gen = CuboidGenerator::New();
+    gen->setSamplingRadius(1, 1, 1);
+    auto centers = TestCenters(100);
+
+    PatchSampler sampler(vol, *gen);
+    sampler.setCenters(centers);
+    sampler.setBatchSize(16);
+    sampler.setSlabDepth(10);
+    sampler.setOrder(PatchSampler::Order::Locality);
+
+    std::vector<bool> seen(centers.size(), false);
+    double prevSlab{-1};
+    while (auto batch = sampler.next()) {
+        for (std::size_t i = 0; i < batch->indices.size(); i++) {
+            auto idx = batch->indices[i];
+            ASSERT_LT(idx, centers.size());
+            EXPECT_FALSE(seen[idx]);
+            seen[idx] = true;
+
+            auto slab = std::floor(centers[idx][2] / 10);
+            EXPECT_GE(slab, prevSlab);
+            prevSlab = slab;
+
+            auto n = gen->compute(vol, centers[idx], Axes);
+            const auto* patch = batch->patches.data() + i * gen->size();
+            for (std::size_t s = 0; s < gen->size(); s++) {
+                ASSERT_EQ(patch[s], n.data()[s]);
+            }
+        }
+    }
+    for (auto s : seen) {
+        EXPECT_TRUE(s);
+    }
+}
+
+TEST(PatchSampler, InvalidParameters)
+{
+    auto vol = TestVolume("vc_core_PatchSamplerInvalid");
+    CuboidGenerator gen;
+    EXPECT_THROW(PatchSampler(nullptr, gen), std::invalid_argument);
+
+    PatchSampler sampler(vol, gen);
+    EXPECT_EQ(sampler.numBatches(), 0U);
+    EXPECT_FALSE(sampler.next());
+    EXPECT_THROW(sampler.setBatchSize(0), std::invalid_argument);
+    EXPECT_THROW(sampler.setSlabDepth(0), std::invalid_argument);
+    EXPECT_THROW(sampler.setPrefetchBatches(0), std::invalid_argument);
+}
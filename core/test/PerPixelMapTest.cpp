@@ -1,6 +1,20 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <vector>
+
 #include <gtest/gtest.h>
 
+#include "vc/core/types/Exceptions.hpp"
 #include "vc/core/types/PerPixelMap.hpp"
+#include "vc/core/util/Iteration.hpp"
+#include "vc/core/util/ThreadPool.hpp"
 
 using namespace volcart;
 
@@ -30,4 +44,403 @@ TEST(PerPixelMap, WriteRead)
             EXPECT_EQ(result(y, x), ppm(y, x));
         }
     }
-}
\ No newline at end of file
+}
+
+TEST(PerPixelMap, WriteReadCompact)
+{
+    // Build a PPM with a partial mask
+    PerPixelMap ppm(10, 12);
+    cv::Mat mask = cv::Mat::zeros(10, 12, CV_8UC1);
+    for (auto y = 0; y < 10; ++y) {
+        for (auto x = 0; x < 12; ++x) {
+            auto dx = static_cast<double>(x);
+            auto dy = static_cast<double>(y);
+            ppm(y, x) = {dx, dy, (dx + dy) / 2.0, dx, dy, (dx + dy) / 2.0};
+            if ((x + y) % 3 != 0) {
+                mask.at<uint8_t>(y, x) = 255;
+            }
+        }
+    }
+    ppm.setMask(mask);
+
+    // Write the PPM
+    std::string path{"vc_core_PerPixelMap_WriteReadCompact.ppm"};
+    EXPECT_NO_THROW(
+        PerPixelMap::WritePPM(path, ppm, PerPixelMap::Format::Compact));
+
+    // Read the PPM
+    PerPixelMap result;
+    EXPECT_NO_THROW(result = PerPixelMap::ReadPPM(path));
+    EXPECT_TRUE(result.memoryMapped());
+    EXPECT_EQ(result.height(), 10);
+    EXPECT_EQ(result.width(), 12);
+    EXPECT_EQ(result.getMappings().size(), ppm.getMappings().size());
+
+    // Test the values through the const accessors
+    const auto& constResult = result;
+    for (auto y = 0; y < 10; ++y) {
+        for (auto x = 0; x < 12; ++x) {
+            ASSERT_EQ(constResult.hasMapping(y, x), ppm.hasMapping(y, x));
+            if (ppm.hasMapping(y, x)) {
+                EXPECT_EQ(constResult(y, x), ppm(y, x));
+            }
+        }
+    }
+    EXPECT_EQ(cv::countNonZero(result.mask() != mask), 0);
+
+    // Writing through a non-const accessor copies the map into memory
+    result(0, 1) = {1, 2, 3, 4, 5, 6};
+    EXPECT_FALSE(result.memoryMapped());
+    EXPECT_EQ(result(0, 1), cv::Vec6d(1, 2, 3, 4, 5, 6));
+    EXPECT_EQ(result(0, 2), ppm(0, 2));
+    EXPECT_EQ(result.hasMapping(0, 0), ppm.hasMapping(0, 0));
+}
+
+TEST(PerPixelMap, ConcurrentDetach)
+{
+    PerPixelMap ppm(64, 48);
+    for (auto y = 0; y < 64; ++y) {
+        for (auto x = 0; x < 48; ++x) {
+            auto dx = static_cast<double>(x);
+            auto dy = static_cast<double>(y);
+            ppm(y, x) = {dx, dy, dx + dy, 0, 0, 1};
+        }
+    }
+    std::string path{"vc_core_PerPixelMap_ConcurrentDetach.ppm"};
+    PerPixelMap::WritePPM(path, ppm, PerPixelMap::Format::Compact);
+
+    // Every thread uses the non-const accessors, which copy the map once
+    auto result = PerPixelMap::ReadPPM(path);
+    ASSERT_TRUE(result.memoryMapped());
+    std::vector<int> matches(64, 0);
+    ParallelFor(range(64), [&](auto y) {
+        for (auto x = 0; x < 48; ++x) {
+            if (result.getMapping(y, x) == ppm(y, x)) {
+                matches[y]++;
+            }
+        }
+    });
+    EXPECT_FALSE(result.memoryMapped());
+    EXPECT_EQ(std::count(matches.begin(), matches.end(), 48), 64);
+
+    // Copies made before the first access are detached separately
+    auto mapped = PerPixelMap::ReadPPM(path);
+    auto copy = mapped;
+    copy(0, 0) = {1, 2, 3, 4, 5, 6};
+    EXPECT_TRUE(mapped.memoryMapped());
+    EXPECT_FALSE(copy.memoryMapped());
+    const auto& constMapped = mapped;
+    EXPECT_EQ(constMapped(0, 0), ppm(0, 0));
+}
+
+TEST(PerPixelMap, CorruptCompactFile)
+{
+    PerPixelMap ppm(4, 5);
+    for (auto y = 0; y < 4; ++y) {
+        for (auto x = 0; x < 5; ++x) {
+            ppm(y, x) = {double(x), double(y), 0, 0, 0, 1};
+        }
+    }
+    std::string path{"vc_core_PerPixelMap_CorruptCompactFile.ppm"};
+    PerPixelMap::WritePPM(path, ppm, PerPixelMap::Format::Compact);
+    std::ifstream in(path, std::ios::binary);
+    std::string bytes(
+        (std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    in.close();
+
+    // Header: magic[8], version, recordDims, then uint64_t width, height,
+    // count. The record index table follows.
+    constexpr std::size_t widthOffset{16};
+    constexpr std::size_t heightOffset{24};
+    constexpr std::size_t countOffset{32};
+    constexpr std::size_t indexOffset{40};
+    auto readCorrupt = [&](std::size_t offset, auto value) {
+        auto corrupt = bytes;
+        std::memcpy(&corrupt[offset], &value, sizeof(value));
+        std::string corruptPath{"vc_core_PerPixelMap_Corrupt.ppm"};
+        std::ofstream out(corruptPath, std::ios::binary);
+        out.write(corrupt.data(), static_cast<std::streamsize>(corrupt.size()));
+        out.close();
+        return PerPixelMap::ReadPPM(corruptPath);
+    };
+
+    // The uncorrupted file reads
+    EXPECT_NO_THROW(readCorrupt(widthOffset, uint64_t{5}));
+
+    // Dimensions whose number of pixels overflows to 0
+    EXPECT_THROW(readCorrupt(widthOffset, uint64_t{1} << 62), IOException);
+    EXPECT_THROW(readCorrupt(heightOffset, uint64_t{1} << 62), IOException);
+
+    // Counts larger than the file, and counts whose size overflows
+    EXPECT_THROW(readCorrupt(countOffset, uint64_t{21}), IOException);
+    EXPECT_THROW(
+        readCorrupt(countOffset, (uint64_t{1} << 62) + 20), IOException);
+
+    // Record numbers past the count
+    EXPECT_THROW(readCorrupt(indexOffset, uint32_t{20}), IOException);
+}
+
+TEST(PerPixelMap, MappingIndices)
+{
+    // Build a PPM where z decreases along each row
+    PerPixelMap ppm(4, 5);
+    cv::Mat mask = cv::Mat::zeros(4, 5, CV_8UC1);
+    for (auto y = 0; y < 4; ++y) {
+        for (auto x = 0; x < 5; ++x) {
+            auto dx = static_cast<double>(x);
+            auto dy = static_cast<double>(y);
+            ppm(y, x) = {dx, dy, 4.5 - dx, 0, 0, 1};
+            if (x != y) {
+                mask.at<uint8_t>(y, x) = 255;
+            }
+        }
+    }
+    ppm.setMask(mask);
+    EXPECT_EQ(ppm.numMappings(), 16);
+
+    // Raster order
+    auto raster = ppm.getMappingIndices();
+    ASSERT_EQ(raster.size(), 16);
+    EXPECT_TRUE(std::is_sorted(raster.begin(), raster.end()));
+    for (const auto& idx : raster) {
+        auto pixel = ppm.getAsPixelMap(idx);
+        EXPECT_TRUE(ppm.hasMapping(pixel.y, pixel.x));
+        EXPECT_EQ(idx, pixel.y * 5 + pixel.x);
+    }
+
+    // Slice order
+    auto sorted = ppm.getMappingIndices(PerPixelMap::MappingOrder::Slice);
+    ASSERT_EQ(sorted.size(), 16);
+    for (size_t i = 1; i < sorted.size(); i++) {
+        auto prev = ppm.getAsPixelMap(sorted[i - 1]);
+        auto curr = ppm.getAsPixelMap(sorted[i]);
+        EXPECT_LE(std::floor(prev.pos[2]), std::floor(curr.pos[2]));
+        if (std::floor(prev.pos[2]) == std::floor(curr.pos[2])) {
+            EXPECT_LT(sorted[i - 1], sorted[i]);
+        }
+    }
+}
+
+TEST(PerPixelMap, CurveMappingIndices)
+{
+    // Map each pixel to a different 2x2x2 cell of a 4x4x4 grid of cells,
+    // in reverse raster order
+    PerPixelMap ppm(8, 8);
+    for (auto y = 0; y < 8; ++y) {
+        for (auto x = 0; x < 8; ++x) {
+            auto c = 63 - (y * 8 + x);
+            auto px = 2.0 * (c % 4) + 0.5;
+            auto py = 2.0 * ((c / 4) % 4) + 1.5;
+            auto pz = 2.0 * (c / 16) + 0.5;
+            ppm(y, x) = {px, py, pz, 0, 0, 1};
+        }
+    }
+    auto cellOf = [&ppm](PerPixelMap::PixelIndex i) {
+        auto pos = ppm.getAsPixelMap(i).pos;
+        return cv::Vec3i(
+            static_cast<int>(std::floor(pos[0] / 2)),
+            static_cast<int>(std::floor(pos[1] / 2)),
+            static_cast<int>(std::floor(pos[2] / 2)));
+    };
+    const cv::Vec3i cell{2, 2, 2};
+
+    // The first octant of the Morton curve is the first 2x2x2 cells
+    auto morton =
+        ppm.getMappingIndices(PerPixelMap::MappingOrder::Morton, cell);
+    ASSERT_EQ(morton.size(), 64);
+    EXPECT_EQ(cellOf(morton[0]), cv::Vec3i(0, 0, 0));
+    EXPECT_EQ(cellOf(morton[1]), cv::Vec3i(1, 0, 0));
+    EXPECT_EQ(cellOf(morton[2]), cv::Vec3i(0, 1, 0));
+    EXPECT_EQ(cellOf(morton[7]), cv::Vec3i(1, 1, 1));
+    EXPECT_EQ(cellOf(morton[8]), cv::Vec3i(2, 0, 0));
+
+    // Consecutive cells of the Hilbert curve are neighbors
+    auto hilbert =
+        ppm.getMappingIndices(PerPixelMap::MappingOrder::Hilbert, cell);
+    ASSERT_EQ(hilbert.size(), 64);
+    for (size_t i = 1; i < hilbert.size(); i++) {
+        auto d = cellOf(hilbert[i]) - cellOf(hilbert[i - 1]);
+        EXPECT_EQ(std::abs(d[0]) + std::abs(d[1]) + std::abs(d[2]), 1);
+    }
+
+    // Both visit every pixel once
+    for (auto order : {morton, hilbert}) {
+        std::sort(order.begin(), order.end());
+        EXPECT_EQ(order, ppm.getMappingIndices());
+    }
+
+    EXPECT_THROW(
+        std::ignore = ppm.getMappingIndices(
+            PerPixelMap::MappingOrder::Hilbert, {0, 1, 1}),
+        std::invalid_argument);
+}
+
+TEST(PerPixelMap, GatherMappingValues)
+{
+    PerPixelMap ppm(3, 4);
+    cv::Mat mask = cv::Mat::zeros(3, 4, CV_8UC1);
+    for (auto y = 0; y < 3; ++y) {
+        for (auto x = 0; x < 4; ++x) {
+            auto dx = static_cast<double>(x);
+            auto dy = static_cast<double>(y);
+            ppm(y, x) = {dx, dy, dx * dy, 0, 0, 1};
+            if ((x + y) % 2 == 0) {
+                mask.at<uint8_t>(y, x) = 255;
+            }
+        }
+    }
+    ppm.setMask(mask);
+
+    auto indices = ppm.getMappingIndices();
+    auto values = ppm.getMappingValues(indices);
+    ASSERT_EQ(values.size(), indices.size());
+    for (size_t i = 0; i < indices.size(); i++) {
+        EXPECT_EQ(values[i], ppm.getMapping(indices[i] / 4, indices[i] % 4));
+    }
+}
+
+TEST(PerPixelMap, ApplyTransform)
+{
+    PerPixelMap ppm(2, 3);
+    cv::Mat mask = cv::Mat::zeros(2, 3, CV_8UC1);
+    for (auto y = 0; y < 2; ++y) {
+        for (auto x = 0; x < 3; ++x) {
+            auto dx = static_cast<double>(x);
+            auto dy = static_cast<double>(y);
+            ppm(y, x) = {dx, dy, 1, 1, 0, 0};
+            if (x != 1) {
+                mask.at<uint8_t>(y, x) = 255;
+            }
+        }
+    }
+    ppm.setMask(mask);
+
+    // Scale y by 2 and translate
+    // clang-format off
+    cv::Matx44d tfm{1, 1, 0, 10,
+                    0, 2, 0, 20,
+                    0, 0, 1, 30,
+                    0, 0, 0, 1};
+    // clang-format on
+    ppm.applyTransform(tfm);
+
+    for (auto y = 0; y < 2; ++y) {
+        for (auto x = 0; x < 3; ++x) {
+            auto dx = static_cast<double>(x);
+            auto dy = static_cast<double>(y);
+            const auto& m = ppm.getMapping(y, x);
+            if (x == 1) {
+                // Unmapped pixels are not modified
+                EXPECT_EQ(m, cv::Vec6d(dx, dy, 1, 1, 0, 0));
+                continue;
+            }
+            EXPECT_DOUBLE_EQ(m[0], dx + dy + 10);
+            EXPECT_DOUBLE_EQ(m[1], 2 * dy + 20);
+            EXPECT_DOUBLE_EQ(m[2], 31);
+
+            // Normal stays perpendicular to the transformed surface tangents
+            cv::Vec3d n{m[3], m[4], m[5]};
+            cv::Vec3d tangent = tfm.get_minor<3, 3>(0, 0) * cv::Vec3d(0, 1, 0);
+            EXPECT_NEAR(cv::norm(n), 1, 1e-12);
+            EXPECT_NEAR(n.dot(tangent), 0, 1e-12);
+            EXPECT_NEAR(n.dot(cv::Vec3d(0, 0, 1)), 0, 1e-12);
+        }
+    }
+
+    // Singular transforms are rejected
+    EXPECT_THROW(
+        ppm.applyTransform(cv::Matx44d::zeros()), std::invalid_argument);
+}
+
+TEST(PerPixelMap, RawData)
+{
+    PerPixelMap ppm(3, 4);
+    cv::Mat mask = cv::Mat::zeros(3, 4, CV_8UC1);
+    for (auto y = 0; y < 3; ++y) {
+        for (auto x = 0; x < 4; ++x) {
+            auto dx = static_cast<double>(x);
+            auto dy = static_cast<double>(y);
+            ppm(y, x) = {dx, dy, 0.5, 0, 0, 1};
+            if (x != y) {
+                mask.at<uint8_t>(y, x) = 255;
+            }
+        }
+    }
+    ppm.setMask(mask);
+
+    // In-memory maps expose their row-major storage
+    const auto* data = ppm.data();
+    ASSERT_NE(data, nullptr);
+    for (size_t i = 0; i < 12; i++) {
+        EXPECT_EQ(data[i], ppm.getMapping(i / 4, i % 4));
+    }
+    EXPECT_THROW(std::ignore = ppm.compactData(), std::logic_error);
+
+    // Memory-mapped maps expose their records
+    std::string path{"vc_core_PerPixelMap_RawData.ppm"};
+    PerPixelMap::WritePPM(path, ppm, PerPixelMap::Format::Compact);
+    PerPixelMap::CompactData compact;
+    {
+        const auto result = PerPixelMap::ReadPPM(path);
+        EXPECT_EQ(result.data(), nullptr);
+        compact = result.compactData();
+    }
+
+    // The storage outlives the map
+    const auto rd = PerPixelMap::CompactData::RECORD_DIMS;
+    EXPECT_EQ(compact.count, ppm.numMappings());
+    for (size_t i = 0; i < 12; i++) {
+        auto record = compact.index.get()[i];
+        if (not ppm.hasMapping(i / 4, i % 4)) {
+            EXPECT_EQ(record, PerPixelMap::CompactData::NO_RECORD);
+            continue;
+        }
+        ASSERT_LT(record, compact.count);
+        const auto* r = compact.records.get() + record * rd;
+        auto m = ppm.getMapping(i / 4, i % 4);
+        for (size_t d = 0; d < rd; d++) {
+            EXPECT_FLOAT_EQ(r[d], static_cast<float>(m[d]));
+        }
+    }
+}
+
+TEST(PerPixelMap, Subsample)
+{
+    PerPixelMap ppm(5, 7);
+    cv::Mat mask = cv::Mat::zeros(5, 7, CV_8UC1);
+    cv::Mat cellMap(5, 7, CV_32SC1);
+    for (auto y = 0; y < 5; ++y) {
+        for (auto x = 0; x < 7; ++x) {
+            auto dx = static_cast<double>(x);
+            auto dy = static_cast<double>(y);
+            ppm(y, x) = {dx, dy, dx + dy, 0, 0, 1};
+            cellMap.at<int32_t>(y, x) = y * 7 + x;
+            if (x != 2) {
+                mask.at<uint8_t>(y, x) = 255;
+            }
+        }
+    }
+    ppm.setMask(mask);
+    ppm.setCellMap(cellMap);
+
+    auto sub = PerPixelMap::Subsample(ppm, 2);
+    ASSERT_EQ(sub.height(), 3);
+    ASSERT_EQ(sub.width(), 4);
+    ASSERT_FALSE(sub.cellMap().empty());
+    for (size_t y = 0; y < 3; ++y) {
+        for (size_t x = 0; x < 4; ++x) {
+            EXPECT_EQ(sub.hasMapping(y, x), x != 1);
+            EXPECT_EQ(
+                sub.cellMap().at<int32_t>(y, x),
+                static_cast<int32_t>(2 * y * 7 + 2 * x));
+            if (sub.hasMapping(y, x)) {
+                EXPECT_EQ(sub(y, x), ppm(2 * y, 2 * x));
+            }
+        }
+    }
+
+    // A factor of 1 is a copy
+    auto copy = PerPixelMap::Subsample(ppm, 1);
+    EXPECT_EQ(copy.numMappings(), ppm.numMappings());
+    EXPECT_THROW(PerPixelMap::Subsample(ppm, 0), std::invalid_argument);
+}
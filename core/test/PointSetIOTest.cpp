@@ -6,7 +6,10 @@
 
 #include <opencv2/core.hpp>
 
+#include "vc/core/io/MappedPointSet.hpp"
 #include "vc/core/io/PointSetIO.hpp"
+#include "vc/core/io/PointSetReader.hpp"
+#include "vc/core/io/PointSetWriter.hpp"
 #include "vc/core/types/PointSet.hpp"
 
 constexpr auto TEST_HEADER_FILENAME = "test_header.txt";
@@ -47,6 +50,65 @@ TEST_F(Point3iUnorderedPointSet, WriteThenReadAsciiUnorderedPointSet)
     EXPECT_EQ(readPs[2], ps[2]);
 }
 
+TEST_F(Point3iUnorderedPointSet, MappedUnorderedPointSet)
+{
+    PointSetIO<cv::Vec3i>::WritePointSet("tmp.txt", ps);
+    MappedPointSet<cv::Vec3i> mapped{"tmp.txt"};
+    EXPECT_FALSE(mapped.ordered());
+    EXPECT_EQ(mapped.size(), ps.size());
+    EXPECT_EQ(mapped.width(), ps.size());
+    EXPECT_EQ(mapped.height(), 1);
+    EXPECT_EQ(mapped[0], ps[0]);
+    EXPECT_EQ(mapped[1], ps[1]);
+    EXPECT_EQ(mapped[2], ps[2]);
+    EXPECT_THROW(mapped[3], std::out_of_range);
+
+    // Unordered files cannot be mapped as ordered
+    using Mapped = MappedPointSet<cv::Vec3i>;
+    EXPECT_THROW(Mapped("tmp.txt", true), IOException);
+}
+
+TEST_F(Point3iUnorderedPointSet, StreamUnorderedPointSetInChunks)
+{
+    PointSetIO<cv::Vec3i>::WritePointSet("tmp.txt", ps);
+    PointSetReader<cv::Vec3i> reader{"tmp.txt"};
+    EXPECT_EQ(reader.remaining(), ps.size());
+
+    std::vector<cv::Vec3i> chunk;
+    EXPECT_EQ(reader.read(chunk, 2), 2);
+    EXPECT_EQ(chunk[0], ps[0]);
+    EXPECT_EQ(chunk[1], ps[1]);
+    EXPECT_EQ(reader.read(chunk, 2), 1);
+    EXPECT_EQ(chunk[0], ps[2]);
+    EXPECT_EQ(reader.read(chunk, 2), 0);
+    EXPECT_TRUE(chunk.empty());
+
+    // Unordered files have no rows
+    PointSetReader<cv::Vec3i> rows{"tmp.txt"};
+    EXPECT_THROW(rows.readRow(chunk), IOException);
+}
+
+TEST_F(Point3iUnorderedPointSet, StreamWriteUnorderedPointSet)
+{
+    {
+        PointSetWriter<cv::Vec3i> writer{"tmp.txt", 2};
+        for (const auto& p : ps) {
+            writer.write(p);
+        }
+        EXPECT_EQ(writer.size(), ps.size());
+        writer.flush();
+        auto read = PointSetIO<cv::Vec3i>::ReadPointSet("tmp.txt");
+        EXPECT_EQ(read.size(), ps.size());
+        writer.write(ps[0]);
+    }
+
+    // Buffered points are written on destruction
+    MappedPointSet<cv::Vec3i> mapped{"tmp.txt"};
+    EXPECT_EQ(mapped.size(), ps.size() + 1);
+    EXPECT_EQ(mapped[1], ps[1]);
+    EXPECT_EQ(mapped[3], ps[0]);
+}
+
 // Utility method for writing a test header defined in a test case
 void writeTestHeader(const std::string& testHeader)
 {
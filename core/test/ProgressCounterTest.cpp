@@ -0,0 +1,47 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+
+#include "vc/core/util/Iteration.hpp"
+#include "vc/core/util/ProgressCounter.hpp"
+#include "vc/core/util/ThreadPool.hpp"
+
+using namespace volcart;
+
+TEST(ProgressCounter, CountsFromAllThreads)
+{
+    ProgressCounter progress(1000);
+    EXPECT_EQ(progress.total(), 1000);
+    EXPECT_EQ(progress.count(), 0);
+    EXPECT_TRUE(std::isinf(progress.remaining()));
+
+    ParallelFor(range(1000), [&](auto) { progress.add(); }, 4);
+    EXPECT_EQ(progress.count(), 1000);
+    EXPECT_GE(progress.rate(), 0);
+    EXPECT_DOUBLE_EQ(progress.remaining(), 0);
+
+    progress.set(10);
+    EXPECT_EQ(progress.count(), 10);
+
+    progress.reset(5);
+    EXPECT_EQ(progress.count(), 0);
+    EXPECT_EQ(progress.total(), 5);
+}
+
+TEST(ProgressCounter, RateLimitsReports)
+{
+    ProgressCounter progress(10, std::chrono::hours(1));
+
+    // Only the first check reports within the interval
+    EXPECT_TRUE(progress.shouldReport());
+    EXPECT_FALSE(progress.shouldReport());
+
+    // Restarting allows an immediate report
+    progress.reset(10);
+    EXPECT_TRUE(progress.shouldReport());
+
+    // Without an interval, every check reports
+    ProgressCounter always(10, ProgressCounter::Clock::duration::zero());
+    EXPECT_TRUE(always.shouldReport());
+    EXPECT_TRUE(always.shouldReport());
+}
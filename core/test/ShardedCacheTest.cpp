@@ -0,0 +1,123 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "vc/core/types/ShardedCache.hpp"
+
+using namespace volcart;
+
+using IntCache = ShardedCache<int, int>;
+
+TEST(ShardedCache, Defaults)
+{
+    IntCache cache(100);
+    EXPECT_EQ(cache.capacity(), 100);
+    EXPECT_EQ(cache.size(), 0);
+    EXPECT_EQ(cache.numShards(), IntCache::DEFAULT_SHARDS);
+    EXPECT_THROW(cache.setCapacity(0), std::invalid_argument);
+    EXPECT_THROW(IntCache(100, 0), std::invalid_argument);
+}
+
+TEST(ShardedCache, PutGetPurge)
+{
+    IntCache cache(100, 4);
+    for (int i = 0; i < 50; i++) {
+        cache.put(i, i * i);
+    }
+    EXPECT_EQ(cache.size(), 50);
+    for (int i = 0; i < 50; i++) {
+        EXPECT_TRUE(cache.contains(i));
+        EXPECT_EQ(cache.get(i), i * i);
+    }
+    EXPECT_FALSE(cache.contains(50));
+    EXPECT_ANY_THROW(cache.get(50));
+
+    cache.purge();
+    EXPECT_EQ(cache.size(), 0);
+}
+
+TEST(ShardedCache, CapacitySplitAcrossShards)
+{
+    IntCache cache(8, 4);
+    for (int i = 0; i < 4; i++) {
+        EXPECT_EQ(cache.shard(i)->capacity(), 2);
+    }
+
+    // Sequential keys are spread evenly, so the cache never exceeds capacity
+    for (int i = 0; i < 100; i++) {
+        cache.put(i, i);
+    }
+    EXPECT_EQ(cache.size(), 8);
+
+    cache.setCapacity(2);
+    for (int i = 0; i < 4; i++) {
+        EXPECT_EQ(cache.shard(i)->capacity(), 1);
+    }
+    EXPECT_EQ(cache.size(), 4);
+}
+
+TEST(ShardedCache, ShardSelector)
+{
+    // Even keys in shard 0, odd keys in shard 1
+    IntCache cache(
+        4, 2, IntCache::DefaultFactory, [](const int& k) { return k % 2; });
+    for (int i = 0; i < 6; i++) {
+        cache.put(i, i);
+    }
+
+    // Each shard only evicts its own keys
+    EXPECT_EQ(cache.shard(0)->size(), 2);
+    EXPECT_EQ(cache.shard(1)->size(), 2);
+    EXPECT_TRUE(cache.shard(0)->contains(4));
+    EXPECT_TRUE(cache.shard(1)->contains(5));
+    EXPECT_FALSE(cache.contains(0));
+    EXPECT_EQ(cache.get(4), 4);
+}
+
+TEST(ShardedCache, GetOrLoad)
+{
+    IntCache cache(100);
+    int loads{0};
+    auto loader = [&loads]() {
+        loads++;
+        return 42;
+    };
+    EXPECT_EQ(cache.getOrLoad(1, loader), 42);
+    EXPECT_EQ(cache.getOrLoad(1, loader), 42);
+    EXPECT_EQ(loads, 1);
+    EXPECT_TRUE(cache.contains(1));
+}
+
+TEST(ShardedCache, GetOrLoadFailureNotCached)
+{
+    IntCache cache(100);
+    auto loader = []() -> int { throw std::runtime_error("failed"); };
+    EXPECT_THROW(cache.getOrLoad(1, loader), std::runtime_error);
+    EXPECT_FALSE(cache.contains(1));
+    EXPECT_EQ(cache.getOrLoad(1, []() { return 1; }), 1);
+}
+
+TEST(ShardedCache, ConcurrentMissesLoadOnce)
+{
+    IntCache cache(100);
+    std::atomic<int> loads{0};
+    auto loader = [&loads]() {
+        loads++;
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        return 7;
+    };
+
+    std::vector<std::thread> threads;
+    std::atomic<int> sum{0};
+    for (int i = 0; i < 8; i++) {
+        threads.emplace_back([&]() { sum += cache.getOrLoad(3, loader); });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    EXPECT_EQ(loads, 1);
+    EXPECT_EQ(sum, 56);
+}
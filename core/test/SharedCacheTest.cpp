@@ -0,0 +1,83 @@
+#include <gtest/gtest.h>
+
+#include "vc/core/types/SharedCache.hpp"
+
+using namespace volcart;
+
+using IntStorage = SharedCache<int, int>;
+using IntView = SharedCacheView<int, int>;
+
+TEST(SharedCache, ViewsAreIndependent)
+{
+    auto storage = IntStorage::New(100, 4);
+    auto a = IntView::New(storage);
+    auto b = IntView::New(storage);
+
+    a->put(1, 10);
+    b->put(1, 20);
+    b->put(2, 30);
+    EXPECT_EQ(a->get(1), 10);
+    EXPECT_EQ(b->get(1), 20);
+    EXPECT_FALSE(a->contains(2));
+    EXPECT_TRUE(b->contains(2));
+    EXPECT_ANY_THROW(a->get(2));
+
+    // Capacity and size are those of the shared cache
+    EXPECT_EQ(a->capacity(), 100);
+    EXPECT_EQ(a->size(), 3);
+    b->setCapacity(200);
+    EXPECT_EQ(a->capacity(), 200);
+}
+
+TEST(SharedCache, PurgeOnlyAffectsView)
+{
+    auto storage = IntStorage::New(100, 4);
+    auto a = IntView::New(storage);
+    auto b = IntView::New(storage);
+    a->put(1, 10);
+    b->put(1, 20);
+
+    a->purge();
+    EXPECT_FALSE(a->contains(1));
+    EXPECT_TRUE(b->contains(1));
+
+    a->put(1, 11);
+    EXPECT_EQ(a->get(1), 11);
+    EXPECT_EQ(b->get(1), 20);
+}
+
+TEST(SharedCache, EvictionFollowsDemand)
+{
+    // Single shard so that eviction order is exact
+    auto storage = IntStorage::New(4, 1);
+    auto hot = IntView::New(storage);
+    auto cold = IntView::New(storage);
+
+    cold->put(0, 0);
+    for (int i = 0; i < 3; i++) {
+        hot->put(i, i);
+    }
+
+    // The hot view can use the whole budget
+    for (int i = 3; i < 6; i++) {
+        hot->put(i, i);
+    }
+    EXPECT_FALSE(cold->contains(0));
+    EXPECT_EQ(storage->size(), 4);
+    for (int i = 2; i < 6; i++) {
+        EXPECT_TRUE(hot->contains(i));
+    }
+}
+
+TEST(SharedCache, GetOrLoad)
+{
+    auto storage = IntStorage::New(100, 4);
+    auto a = IntView::New(storage);
+    auto b = IntView::New(storage);
+
+    int loads{0};
+    EXPECT_EQ(a->getOrLoad(5, [&]() { return ++loads; }), 1);
+    EXPECT_EQ(a->getOrLoad(5, [&]() { return ++loads; }), 1);
+    EXPECT_EQ(b->getOrLoad(5, [&]() { return ++loads; }), 2);
+    EXPECT_EQ(loads, 2);
+}
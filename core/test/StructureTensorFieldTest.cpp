@@ -0,0 +1,105 @@
+#include <gtest/gtest.h>
+
+#include <opencv2/core.hpp>
+
+#include "vc/core/filesystem.hpp"
+#include "vc/core/math/StructureTensor.hpp"
+#include "vc/core/math/StructureTensorField.hpp"
+#include "vc/core/types/Volume.hpp"
+
+using namespace volcart;
+namespace fs = volcart::filesystem;
+
+class RampVolume : public ::testing::Test
+{
+public:
+    static constexpr int SIZE = 40;
+
+    Volume::Pointer vol;
+
+    RampVolume()
+    {
+        fs::path volPath{"vc_core_StructureTensorField_Ramp"};
+        fs::remove_all(volPath);
+        fs::create_directory(volPath);
+
+        vol = Volume::New(volPath, "Ramp", "Ramp");
+        vol->setSliceWidth(SIZE);
+        vol->setSliceHeight(SIZE);
+        vol->setNumberOfSlices(SIZE);
+        vol->saveMetadata();
+
+        // Intensity increases along Z
+        for (int z = 0; z < SIZE; z++) {
+            cv::Mat slice(SIZE, SIZE, CV_16UC1, cv::Scalar(1000 * z));
+            vol->setSliceData(z, slice);
+        }
+    }
+};
+
+TEST_F(RampVolume, PrincipalDirection)
+{
+    StructureTensorField field(vol, 2);
+    for (const auto& p : {cv::Vec3d{20, 20, 20}, cv::Vec3d{10.3, 25.7, 17.5}}) {
+        auto ep = field.eigenPairsAt(p);
+        EXPECT_NEAR(std::abs(ep[0].second[2]), 1, 1e-6);
+        EXPECT_GT(ep[0].first, 0);
+        EXPECT_NEAR(ep[1].first / ep[0].first, 0, 1e-6);
+
+        // Same principal direction as the per-query computation
+        auto ref = ComputeSubvoxelEigenPairs(vol, p, 2);
+        EXPECT_NEAR(std::abs(ep[0].second.dot(ref[0].second)), 1, 1e-6);
+    }
+}
+
+TEST_F(RampVolume, BlockSizeDoesNotChangeResult)
+{
+    StructureTensorField small(vol, 2, 3, 8);
+    StructureTensorField large(vol, 2, 3, 32);
+    for (int z = 5; z < 35; z += 3) {
+        for (int y = 0; y < SIZE; y += 7) {
+            for (int x = 0; x < SIZE; x += 5) {
+                cv::Vec3d p{x + 0.5, y + 0.25, z + 0.75};
+                auto a = small.interpolateAt(p);
+                auto b = large.interpolateAt(p);
+                for (int i = 0; i < 9; i++) {
+                    EXPECT_NEAR(a.val[i], b.val[i], 1e-3 * (1 + b(2, 2)));
+                }
+            }
+        }
+    }
+    EXPECT_GT(small.cacheSize(), 1);
+
+    small.purge();
+    EXPECT_EQ(small.cacheSize(), 0);
+}
+
+TEST_F(RampVolume, BatchedEigenPairs)
+{
+    // A chain of positions which crosses block boundaries
+    StructureTensorField field(vol, 2, 3, 8);
+    std::vector<cv::Vec3d> ps;
+    for (int i = 0; i < 60; i++) {
+        ps.emplace_back(3 + 0.55 * i, 20.25, 10 + 0.3 * i);
+    }
+
+    auto batch = field.eigenPairsAt(ps, 3);
+    ASSERT_EQ(batch.size(), ps.size());
+    for (std::size_t i = 0; i < ps.size(); i++) {
+        auto ep = field.eigenPairsAt(ps[i]);
+        for (std::size_t j = 0; j < 3; j++) {
+            EXPECT_EQ(batch[i][j].first, ep[j].first);
+            EXPECT_EQ(batch[i][j].second, ep[j].second);
+        }
+    }
+
+    EXPECT_TRUE(field.eigenPairsAt(std::vector<cv::Vec3d>{}).empty());
+}
+
+TEST_F(RampVolume, InvalidParameters)
+{
+    EXPECT_THROW(StructureTensorField(nullptr), std::invalid_argument);
+    EXPECT_THROW(StructureTensorField(vol, -1), std::invalid_argument);
+    EXPECT_THROW(StructureTensorField(vol, 1, 4), std::invalid_argument);
+    EXPECT_THROW(StructureTensorField(vol, 1, 3, 1), std::invalid_argument);
+}
@@ -0,0 +1,130 @@
+#include <gtest/gtest.h>
+
+#include <opencv2/core.hpp>
+
+#include "vc/core/io/TIFFIO.hpp"
+
+using namespace volcart;
+namespace tio = volcart::tiffio;
+
+namespace
+{
+auto RandomImage(int rows, int cols, int type) -> cv::Mat
+{
+    cv::RNG rng(1234);
+    cv::Mat img(rows, cols, type);
+    rng.fill(img, cv::RNG::UNIFORM, 0, 255);
+    return img;
+}
+
+void ExpectEqual(const cv::Mat& a, const cv::Mat& b)
+{
+    ASSERT_EQ(a.size(), b.size());
+    ASSERT_EQ(a.type(), b.type());
+    cv::Mat diff = (a != b);
+    EXPECT_EQ(cv::countNonZero(diff.reshape(1)), 0);
+}
+}  // namespace
+
+TEST(TIFFIO, TiledWriterRoundTrip)
+{
+    for (auto type : {CV_16UC1, CV_8UC3, CV_32FC1}) {
+        auto img = RandomImage(70, 100, type);
+        {
+            // Regions which span multiple tiles and the image edges
+            tio::TiledTIFFWriter writer("TIFFIO_Tiled.tif", 100, 70, type, 32);
+            writer.writeRegion({64, 0}, img(cv::Rect(64, 0, 36, 64)));
+            writer.writeRegion({0, 0}, img(cv::Rect(0, 0, 64, 32)));
+            writer.writeRegion({0, 32}, img(cv::Rect(0, 32, 64, 32)));
+            writer.writeRegion({0, 64}, img(cv::Rect(0, 64, 100, 6)));
+        }
+        ExpectEqual(tio::ReadTIFF("TIFFIO_Tiled.tif"), img);
+
+        // Partial reads only decode the intersecting tiles
+        cv::Rect roi(20, 30, 50, 25);
+        ExpectEqual(tio::ReadTIFF("TIFFIO_Tiled.tif", roi), img(roi));
+    }
+}
+
+TEST(TIFFIO, TiledWriterParallelCompression)
+{
+    using Compression = tio::Compression;
+    auto img = RandomImage(150, 200, CV_16UC1);
+    for (auto c : {Compression::NONE, Compression::LZW, Compression::DEFLATE,
+                   Compression::PACKBITS}) {
+        {
+            tio::TiledTIFFWriter writer(
+                "TIFFIO_Parallel.tif", 200, 150, CV_16UC1, 32, c);
+            writer.setNumThreads(4);
+            writer.writeRegion({0, 0}, img(cv::Rect(0, 0, 200, 128)));
+            writer.writeRegion({0, 128}, img(cv::Rect(0, 128, 200, 22)));
+        }
+        ExpectEqual(tio::ReadTIFF("TIFFIO_Parallel.tif"), img);
+    }
+}
+
+TEST(TIFFIO, TiledWriterFillsUnwrittenTiles)
+{
+    auto img = RandomImage(40, 40, CV_16UC1);
+    tio::TiledTIFFWriter writer("TIFFIO_Partial.tif", 40, 40, CV_16UC1, 32);
+    writer.writeRegion({0, 0}, img(cv::Rect(0, 0, 32, 32)));
+    writer.close();
+    EXPECT_THROW(writer.writeRegion({0, 0}, img), std::runtime_error);
+
+    cv::Mat expected = cv::Mat::zeros(40, 40, CV_16UC1);
+    img(cv::Rect(0, 0, 32, 32)).copyTo(expected(cv::Rect(0, 0, 32, 32)));
+    ExpectEqual(tio::ReadTIFF("TIFFIO_Partial.tif"), expected);
+}
+
+TEST(TIFFIO, TiledWriterInvalidRegions)
+{
+    EXPECT_THROW(
+        tio::TiledTIFFWriter("TIFFIO_Invalid.tif", 40, 40, CV_16UC1, 20),
+        std::invalid_argument);
+
+    auto img = RandomImage(40, 40, CV_16UC1);
+    tio::TiledTIFFWriter writer("TIFFIO_Invalid.tif", 40, 40, CV_16UC1, 16);
+    EXPECT_THROW(
+        writer.writeRegion({8, 0}, img(cv::Rect(0, 0, 16, 16))),
+        std::invalid_argument);
+    EXPECT_THROW(
+        writer.writeRegion({0, 0}, img(cv::Rect(0, 0, 20, 16))),
+        std::invalid_argument);
+    EXPECT_THROW(writer.writeRegion({32, 32}, img), std::out_of_range);
+    cv::Mat wrongType(16, 16, CV_8UC1);
+    EXPECT_THROW(writer.writeRegion({0, 0}, wrongType), std::invalid_argument);
+}
+
+TEST(TIFFIO, CompressionNames)
+{
+    using Compression = tio::Compression;
+    for (auto c : {Compression::NONE, Compression::LZW, Compression::PACKBITS,
+                   Compression::LZMA, Compression::ZSTD}) {
+        EXPECT_EQ(tio::CompressionFromString(tio::CompressionToString(c)), c);
+    }
+    EXPECT_EQ(tio::CompressionFromString("ZSTD"), Compression::ZSTD);
+    EXPECT_THROW(tio::CompressionFromString("lz4"), std::invalid_argument);
+}
+
+TEST(TIFFIO, PredictorRoundTrip)
+{
+    // Differencing applies to integer images with these schemes
+    using Compression = tio::Compression;
+    for (auto c : {Compression::ADOBE_DEFLATE, Compression::LZMA,
+                   Compression::ZSTD}) {
+        if (not tio::CompressionAvailable(c)) {
+            EXPECT_THROW(
+                tio::WriteTIFF(
+                    "TIFFIO_Predictor.tif", cv::Mat::zeros(4, 4, CV_16UC1), c),
+                std::runtime_error);
+            continue;
+        }
+        for (auto type : {CV_16UC1, CV_8UC3, CV_32FC1}) {
+            auto img = RandomImage(70, 100, type);
+            tio::WriteTIFF("TIFFIO_Predictor.tif", img, c, 16);
+            ExpectEqual(tio::ReadTIFF("TIFFIO_Predictor.tif"), img);
+            cv::Rect roi(20, 30, 50, 25);
+            ExpectEqual(tio::ReadTIFF("TIFFIO_Predictor.tif", roi), img(roi));
+        }
+    }
+}
@@ -0,0 +1,121 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include "vc/core/io/TextScanner.hpp"
+
+using namespace volcart::io;
+
+TEST(TextScanner, Tokens)
+{
+    std::string text{"v  1 2\t3\r\n\nf 1/2/3\n"};
+    TextScanner scanner(text.data(), text.data() + text.size());
+
+    EXPECT_EQ(scanner.token(), "v");
+    EXPECT_EQ(scanner.token(), "1");
+    EXPECT_EQ(scanner.token(), "2");
+    EXPECT_EQ(scanner.token(), "3");
+    EXPECT_TRUE(scanner.atLineEnd());
+    EXPECT_EQ(scanner.token(), "");
+
+    scanner.nextLine();
+    EXPECT_TRUE(scanner.atLineEnd());
+    scanner.nextLine();
+    EXPECT_EQ(scanner.token(), "f");
+    EXPECT_EQ(scanner.token(), "1/2/3");
+    scanner.nextLine();
+    EXPECT_TRUE(scanner.atEnd());
+}
+
+TEST(TextScanner, ParseDouble)
+{
+    std::string text{
+        "0 -1.5 +2.25e3 1e-7 0.000123 123456789012345678901 "
+        "2.2250738585072014e-308 1.7976931348623157e308 inf"};
+    TextScanner scanner(text.data(), text.data() + text.size());
+
+    const char* pos = text.data();
+    double v{0};
+    while (scanner.parseDouble(v)) {
+        char* expectedEnd{nullptr};
+        auto expected = std::strtod(pos, &expectedEnd);
+        EXPECT_EQ(v, expected);
+        EXPECT_EQ(scanner.position(), expectedEnd);
+        pos = expectedEnd;
+    }
+    EXPECT_TRUE(std::isinf(v));
+    EXPECT_TRUE(scanner.atLineEnd());
+}
+
+TEST(TextScanner, ParseInvalid)
+{
+    std::string text{"abc\n1"};
+    TextScanner scanner(text.data(), text.data() + text.size());
+
+    double d{0};
+    std::int64_t i{0};
+    EXPECT_FALSE(scanner.parseDouble(d));
+    EXPECT_FALSE(scanner.parseInt(i));
+    EXPECT_EQ(scanner.position(), text.data());
+
+    // Numbers do not span lines
+    scanner.nextLine();
+    EXPECT_TRUE(scanner.parseInt(i));
+    EXPECT_EQ(i, 1);
+    EXPECT_FALSE(scanner.parseInt(i));
+}
+
+TEST(TextScanner, ParseFaceReferences)
+{
+    std::string text{"1/2/3 -4//5"};
+    TextScanner scanner(text.data(), text.data() + text.size());
+
+    std::int64_t v{0};
+    EXPECT_TRUE(scanner.parseInt(v));
+    EXPECT_EQ(v, 1);
+    EXPECT_TRUE(scanner.consume('/'));
+    EXPECT_TRUE(scanner.parseInt(v));
+    EXPECT_EQ(v, 2);
+    EXPECT_TRUE(scanner.consume('/'));
+    EXPECT_TRUE(scanner.parseInt(v));
+    EXPECT_EQ(v, 3);
+    EXPECT_TRUE(scanner.atSeparator());
+
+    EXPECT_TRUE(scanner.parseInt(v));
+    EXPECT_EQ(v, -4);
+    EXPECT_TRUE(scanner.consume('/'));
+    EXPECT_TRUE(scanner.consume('/'));
+    EXPECT_TRUE(scanner.parseInt(v));
+    EXPECT_EQ(v, 5);
+    EXPECT_TRUE(scanner.atEnd());
+}
+
+TEST(TextScanner, SplitLines)
+{
+    std::string text;
+    for (int i = 0; i < 1000; i++) {
+        text += "line " + std::to_string(i) + "\n";
+    }
+    const auto* begin = text.data();
+    const auto* end = text.data() + text.size();
+
+    auto ranges = SplitLines(begin, end, 4, 100);
+    ASSERT_EQ(ranges.size(), 4);
+    EXPECT_EQ(ranges.front().first, begin);
+    EXPECT_EQ(ranges.back().second, end);
+    for (std::size_t i = 0; i < ranges.size(); i++) {
+        EXPECT_EQ(*(ranges[i].second - 1), '\n');
+        if (i > 0) {
+            EXPECT_EQ(ranges[i].first, ranges[i - 1].second);
+        }
+    }
+
+    // Small buffers are not split
+    ranges = SplitLines(begin, end, 4, text.size());
+    ASSERT_EQ(ranges.size(), 1);
+    EXPECT_EQ(ranges[0].first, begin);
+    EXPECT_EQ(ranges[0].second, end);
+}
@@ -0,0 +1,129 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <numeric>
+#include <stdexcept>
+#include <vector>
+
+#include "vc/core/util/ThreadPool.hpp"
+
+using namespace volcart;
+
+TEST(ThreadPool, NumThreads)
+{
+    ThreadPool pool(3);
+    EXPECT_EQ(pool.numThreads(), 3);
+
+    ThreadPool defaultPool;
+    EXPECT_GE(defaultPool.numThreads(), 1);
+}
+
+TEST(ThreadPool, SubmitAndWait)
+{
+    ThreadPool pool(4);
+    std::vector<std::future<int>> results;
+    for (int i = 0; i < 100; ++i) {
+        results.emplace_back(pool.submit([i]() { return i * i; }));
+    }
+    for (int i = 0; i < 100; ++i) {
+        EXPECT_EQ(pool.wait(results[i]), i * i);
+    }
+}
+
+TEST(ThreadPool, DestructorRunsQueuedTasks)
+{
+    std::atomic<int> count{0};
+    {
+        ThreadPool pool(2);
+        for (int i = 0; i < 50; ++i) {
+            pool.submit([&count]() { ++count; });
+        }
+    }
+    EXPECT_EQ(count, 50);
+}
+
+TEST(ThreadPool, RethrowsTaskExceptions)
+{
+    ThreadPool pool(2);
+    auto result = pool.submit([]() -> int { throw std::runtime_error("x"); });
+    EXPECT_THROW(pool.wait(result), std::runtime_error);
+}
+
+TEST(ThreadPool, NestedTasksDoNotDeadlock)
+{
+    // More outer tasks than workers, each waiting on inner tasks
+    ThreadPool pool(2);
+    std::vector<std::future<int>> outer;
+    for (int i = 0; i < 8; ++i) {
+        outer.emplace_back(pool.submit([&pool]() {
+            std::vector<std::future<int>> inner;
+            for (int j = 0; j < 8; ++j) {
+                inner.emplace_back(pool.submit([j]() { return j; }));
+            }
+            int sum{0};
+            for (auto& f : inner) {
+                sum += pool.wait(f);
+            }
+            return sum;
+        }));
+    }
+    for (auto& f : outer) {
+        EXPECT_EQ(pool.wait(f), 28);
+    }
+}
+
+TEST(ThreadPool, GlobalPool)
+{
+    auto& pool = ThreadPool::Global();
+    EXPECT_EQ(&pool, &ThreadPool::Global());
+    auto result = pool.submit([]() { return 2; });
+    EXPECT_EQ(pool.wait(result), 2);
+}
+
+TEST(ThreadPool, ParallelChunks)
+{
+    std::vector<int> visited(1000, 0);
+    ParallelChunks(visited.size(), 3, [&](auto begin, auto end) {
+        for (auto i = begin; i < end; ++i) {
+            visited[i]++;
+        }
+    });
+    for (const auto& v : visited) {
+        EXPECT_EQ(v, 1);
+    }
+
+    // Empty range
+    ParallelChunks(0, 0, [](auto, auto) { FAIL(); });
+
+    // Errors are rethrown
+    auto throws = [](auto begin, auto) {
+        if (begin == 0) {
+            throw std::runtime_error("chunk error");
+        }
+    };
+    EXPECT_THROW(ParallelChunks(10, 2, throws), std::runtime_error);
+}
+
+TEST(ThreadPool, ParallelFor)
+{
+    std::vector<int> visited(100, 0);
+    ParallelFor(range(10, 100, 3), [&](auto i) { visited[i]++; });
+    for (const auto& [i, v] : enumerate(visited)) {
+        EXPECT_EQ(v, (i >= 10 and (i - 10) % 3 == 0) ? 1 : 0);
+    }
+
+    // 2D ranges
+    std::vector<std::atomic<int>> grid(6 * 7);
+    ParallelFor(range2D(6, 7), [&](auto v, auto u) { grid[v * 7 + u]++; }, 2);
+    for (const auto& c : grid) {
+        EXPECT_EQ(c, 1);
+    }
+}
+
+TEST(ThreadPool, SetGlobalThreads)
+{
+    // The global pool is already running, so its size cannot change
+    auto n = ThreadPool::Global().numThreads();
+    EXPECT_NO_THROW(ThreadPool::SetGlobalThreads(n));
+    EXPECT_THROW(ThreadPool::SetGlobalThreads(n + 1), std::logic_error);
+}
@@ -0,0 +1,56 @@
+#include <gtest/gtest.h>
+
+#include <fstream>
+
+#include <nlohmann/json.hpp>
+
+#include "vc/core/filesystem.hpp"
+#include "vc/core/util/Iteration.hpp"
+#include "vc/core/util/ThreadPool.hpp"
+#include "vc/core/util/Tracing.hpp"
+
+using namespace volcart;
+namespace fs = volcart::filesystem;
+
+TEST(Tracing, DisabledSpansAreNotRecorded)
+{
+    tracing::SetEnabled(false);
+    tracing::Clear();
+    {
+        const tracing::Span span("Disabled");
+    }
+    EXPECT_EQ(tracing::NumSpans(), 0);
+}
+
+TEST(Tracing, WriteChromeTrace)
+{
+    tracing::Clear();
+    tracing::SetEnabled(true);
+    {
+        const tracing::Span outer("Outer", "test");
+        ParallelFor(range(8), [](auto) {
+            const tracing::Span inner(std::string("Inner"), "test");
+        });
+    }
+    tracing::SetEnabled(false);
+    EXPECT_EQ(tracing::NumSpans(), 9);
+
+    fs::path path{"vc_core_Tracing_WriteChromeTrace.json"};
+    tracing::WriteChromeTrace(path);
+    std::ifstream file(path.string());
+    auto trace = nlohmann::json::parse(file);
+    const auto& events = trace.at("traceEvents");
+    ASSERT_EQ(events.size(), 9);
+    std::size_t numInner{0};
+    for (const auto& e : events) {
+        EXPECT_EQ(e.at("ph"), "X");
+        EXPECT_EQ(e.at("cat"), "test");
+        EXPECT_GE(e.at("dur").get<double>(), 0);
+        numInner += e.at("name") == "Inner" ? 1 : 0;
+    }
+    EXPECT_EQ(numInner, 8);
+
+    tracing::Clear();
+    EXPECT_EQ(tracing::NumSpans(), 0);
+    fs::remove(path);
+}
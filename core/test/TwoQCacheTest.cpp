@@ -0,0 +1,169 @@
+#include <gtest/gtest.h>
+
+#include "vc/core/types/LRUCache.hpp"
+#include "vc/core/types/TwoQCache.hpp"
+
+using namespace volcart;
+
+// Charge each int value as the number of units it stores
+struct IntValueSize {
+    auto operator()(const int& v) const -> size_t
+    {
+        return static_cast<size_t>(v);
+    }
+};
+
+// Read a key through the cache, putting it on a miss. Returns true on a hit.
+template <typename TCache>
+auto Access(TCache& cache, int k) -> bool
+{
+    if (cache.contains(k)) {
+        cache.get(k);
+        return true;
+    }
+    cache.put(k, k);
+    return false;
+}
+
+class TwoQCache_Empty : public ::testing::Test
+{
+public:
+    TwoQCache<int, int> cache{8};
+};
+
+TEST_F(TwoQCache_Empty, Defaults)
+{
+    EXPECT_EQ(cache.capacity(), 8);
+    EXPECT_EQ(cache.size(), 0);
+    EXPECT_EQ(cache.usage(), 0);
+    EXPECT_EQ(cache.evictions(), 0);
+    EXPECT_THROW(cache.get(0), std::invalid_argument);
+    EXPECT_THROW(cache.setCapacity(0), std::invalid_argument);
+}
+
+TEST_F(TwoQCache_Empty, PutAndGet)
+{
+    cache.put(0, 10);
+    cache.put(1, 11);
+    EXPECT_EQ(cache.get(0), 10);
+    EXPECT_EQ(cache.get(1), 11);
+
+    // Replacing a value keeps a single element
+    cache.put(1, 12);
+    EXPECT_EQ(cache.size(), 2);
+    EXPECT_EQ(cache.get(1), 12);
+
+    cache.purge();
+    EXPECT_EQ(cache.size(), 0);
+    EXPECT_FALSE(cache.contains(0));
+}
+
+TEST_F(TwoQCache_Empty, FillsCapacityWithNewElements)
+{
+    for (int i = 0; i < 8; i++) {
+        cache.put(i, i);
+    }
+    EXPECT_EQ(cache.size(), 8);
+    EXPECT_EQ(cache.probationSize(), 8);
+    EXPECT_EQ(cache.evictions(), 0);
+
+    // New elements are evicted first in, first out
+    cache.put(8, 8);
+    EXPECT_EQ(cache.size(), 8);
+    EXPECT_EQ(cache.evictions(), 1);
+    EXPECT_FALSE(cache.contains(0));
+    EXPECT_TRUE(cache.contains(8));
+}
+
+TEST_F(TwoQCache_Empty, PromotesReusedElements)
+{
+    for (int i = 0; i < 9; i++) {
+        cache.put(i, i);
+    }
+    EXPECT_FALSE(cache.contains(0));
+
+    // 0 was recently evicted, so putting it again promotes it
+    cache.put(0, 0);
+    EXPECT_TRUE(cache.contains(0));
+    EXPECT_EQ(cache.protectedSize(), 1);
+    EXPECT_EQ(cache.size(), 8);
+}
+
+TEST_F(TwoQCache_Empty, PromotesOnHit)
+{
+    for (int i = 0; i < 8; i++) {
+        cache.put(i, i);
+    }
+    cache.get(0);
+    EXPECT_EQ(cache.protectedSize(), 1);
+
+    // New elements do not evict the promoted element
+    for (int i = 8; i < 100; i++) {
+        cache.put(i, i);
+    }
+    EXPECT_TRUE(cache.contains(0));
+    EXPECT_EQ(cache.size(), 8);
+}
+
+TEST_F(TwoQCache_Empty, ShrinkCapacity)
+{
+    for (int i = 0; i < 8; i++) {
+        cache.put(i, i);
+    }
+    cache.setCapacity(3);
+    EXPECT_EQ(cache.size(), 3);
+    EXPECT_EQ(cache.evictions(), 5);
+    EXPECT_TRUE(cache.contains(7));
+}
+
+TEST(TwoQCache, ChargesValueSize)
+{
+    TwoQCache<int, int, IntValueSize> cache(100);
+    cache.put(0, 10);
+    cache.put(1, 20);
+    EXPECT_EQ(cache.size(), 2);
+    EXPECT_EQ(cache.usage(), 30);
+
+    // Oversize elements are never stored
+    cache.put(2, 101);
+    EXPECT_FALSE(cache.contains(2));
+    EXPECT_EQ(cache.usage(), 30);
+
+    // A large element evicts by size
+    cache.put(3, 90);
+    EXPECT_EQ(cache.size(), 1);
+    EXPECT_EQ(cache.usage(), 90);
+}
+
+TEST(TwoQCache, ScanResistance)
+{
+    // A hot working set which is reused between long scans
+    constexpr size_t capacity{100};
+    constexpr int hot{40};
+    constexpr int scan{1000};
+    TwoQCache<int, int> twoQ(capacity);
+    LRUCache<int, int> lru(capacity);
+
+    size_t twoQHits{0};
+    size_t lruHits{0};
+    int next{hot};
+    for (int round = 0; round < 20; round++) {
+        for (int rep = 0; rep < 3; rep++) {
+            for (int k = 0; k < hot; k++) {
+                twoQHits += Access(twoQ, k) ? 1 : 0;
+                lruHits += Access(lru, k) ? 1 : 0;
+            }
+        }
+        for (int k = 0; k < scan; k++, next++) {
+            twoQHits += Access(twoQ, next) ? 1 : 0;
+            lruHits += Access(lru, next) ? 1 : 0;
+        }
+    }
+
+    // The scans evict the working set from the LRU cache every round, but
+    // 2Q keeps it after it has been reused once
+    EXPECT_GT(twoQHits, lruHits);
+    EXPECT_GE(twoQHits, 20 * 2 * hot + 18 * hot);
+    EXPECT_TRUE(twoQ.contains(0));
+    EXPECT_FALSE(lru.contains(0));
+}
@@ -1,8 +1,14 @@
 #include <gtest/gtest.h>
 
+#include <cstdint>
+#include <cstring>
+#include <fstream>
 #include <iostream>
+#include <iterator>
+#include <string>
 
 #include "vc/core/io/UVMapIO.hpp"
+#include "vc/core/types/Exceptions.hpp"
 #include "vc/core/types/UVMap.hpp"
 #include "vc/core/util/Logging.hpp"
 
@@ -132,7 +138,11 @@ TEST_F(CreateUVMapFixture, TransformationTest)
     }
 }
 
-TEST(UVMapTest, WriteAndRead)
+class UVMapIOTest : public ::testing::TestWithParam<io::UVMapFormat>
+{
+};
+
+TEST_P(UVMapIOTest, WriteAndRead)
 {
     // Construct a UVMap
     UVMap uvMap;
@@ -149,7 +159,7 @@ TEST(UVMapTest, WriteAndRead)
     }
 
     // Write the UVMap
-    io::WriteUVMap("WriteUVMap.uvm", uvMap);
+    io::WriteUVMap("WriteUVMap.uvm", uvMap, GetParam());
 
     // Read the UVMap
     auto uvMapClone = io::ReadUVMap("WriteUVMap.uvm");
@@ -166,6 +176,90 @@ TEST(UVMapTest, WriteAndRead)
         const auto& uv = m.second;
         EXPECT_EQ(uv, uvMap.get(id));
     }
+    for (size_t id = 0; id < size; id++) {
+        EXPECT_EQ(uvMapClone.contains(id), uvMap.contains(id));
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    UVMapFormats,
+    UVMapIOTest,
+    ::testing::Values(io::UVMapFormat::Archive, io::UVMapFormat::Binary));
+
+TEST(UVMapTest, BinaryLengthMustFitFile)
+{
+    UVMap uvMap;
+    for (std::size_t id = 0; id < 10; id++) {
+        uvMap.set(id, {0.1 * id, 0.5});
+    }
+    io::WriteUVMap("BinaryLength.uvm", uvMap, io::UVMapFormat::Binary);
+    std::ifstream in("BinaryLength.uvm", std::ios::binary);
+    std::string bytes(
+        (std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    in.close();
+
+    // The length is the last field of the header, just before the UVs
+    const auto lengthOffset = bytes.size() - 10 * sizeof(cv::Vec2d) - 8;
+    auto writeLength = [&](uint64_t length) {
+        auto corrupt = bytes;
+        std::memcpy(&corrupt[lengthOffset], &length, sizeof(length));
+        std::ofstream out("BinaryLength.uvm", std::ios::binary);
+        out.write(corrupt.data(), static_cast<std::streamsize>(corrupt.size()));
+    };
+
+    // Longer than the file
+    writeLength(11);
+    EXPECT_THROW(io::ReadUVMap("BinaryLength.uvm"), IOException);
+
+    // Overflows the size in bytes to the size of the file's UVs
+    writeLength((uint64_t{1} << 60) + 10);
+    EXPECT_THROW(io::ReadUVMap("BinaryLength.uvm"), IOException);
+
+    // Shorter than the file
+    writeLength(5);
+    EXPECT_EQ(io::ReadUVMap("BinaryLength.uvm").size(), 5U);
+}
+
+TEST(UVMapTest, SparseIDs)
+{
+    UVMap uvMap;
+    uvMap.set(2, {0.25, 0.5});
+    uvMap.set(5, {0.75, 1});
+    EXPECT_EQ(uvMap.size(), 2U);
+    EXPECT_FALSE(uvMap.contains(0));
+    EXPECT_FALSE(uvMap.contains(6));
+    EXPECT_EQ(uvMap.get(3), NULL_MAPPING);
+
+    // Re-setting a mapping does not change the size
+    uvMap.set(2, {0.5, 0.5});
+    EXPECT_EQ(uvMap.size(), 2U);
+
+    // Transforms skip unmapped IDs
+    UVMap::Flip(uvMap, UVMap::FlipAxis::Both);
+    UVMap::Rotate(uvMap, 30. * PI / 180.);
+    EXPECT_EQ(uvMap.size(), 2U);
+    EXPECT_TRUE(uvMap.contains(2));
+    EXPECT_TRUE(uvMap.contains(5));
+    EXPECT_FALSE(uvMap.contains(3));
+    EXPECT_EQ(uvMap.as_map().size(), 2U);
+}
+
+TEST(UVMapTest, Flip)
+{
+    UVMap uvMap;
+    uvMap.set(0, {0.25, 0.75});
+
+    auto horizontal = uvMap;
+    UVMap::Flip(horizontal, UVMap::FlipAxis::Horizontal);
+    EXPECT_EQ(horizontal.get(0), cv::Vec2d(0.75, 0.75));
+
+    auto vertical = uvMap;
+    UVMap::Flip(vertical, UVMap::FlipAxis::Vertical);
+    EXPECT_EQ(vertical.get(0), cv::Vec2d(0.25, 0.25));
+
+    auto both = uvMap;
+    UVMap::Flip(both, UVMap::FlipAxis::Both);
+    EXPECT_EQ(both.get(0), cv::Vec2d(0.75, 0.25));
 }
 
 TEST(UVMapTest, Rotate45)
@@ -0,0 +1,85 @@
+#include <gtest/gtest.h>
+
+#include "vc/core/shapes/Plane.hpp"
+#include "vc/core/types/UVMeshView.hpp"
+
+using namespace volcart;
+
+class UVMeshViewFixture : public ::testing::Test
+{
+public:
+    UVMeshViewFixture()
+    {
+        mesh = shapes::Plane(5, 4).itkMesh();
+        uvMap = UVMap::New();
+        for (std::size_t i = 0; i < mesh->GetNumberOfPoints(); ++i) {
+            auto p = mesh->GetPoint(i);
+            uvMap->set(i, {p[0] / 4.0, p[2] / 3.0});
+        }
+        uvMap->ratio(40, 30);
+    }
+
+    ITKMesh::Pointer mesh;
+    UVMap::Pointer uvMap;
+};
+
+TEST_F(UVMeshViewFixture, ReadsMeshAndUVMap)
+{
+    UVMeshView view(mesh, uvMap);
+    EXPECT_TRUE(view.valid());
+    EXPECT_EQ(view.numVertices(), mesh->GetNumberOfPoints());
+    EXPECT_EQ(view.numFaces(), mesh->GetNumberOfCells());
+
+    for (std::size_t i = 0; i < view.numVertices(); ++i) {
+        auto uv = uvMap->get(i);
+        EXPECT_EQ(view.uv(i), uv);
+        EXPECT_EQ(view.vertex(i), cv::Vec3d(uv[0], 0, uv[1]));
+    }
+
+    for (std::size_t i = 0; i < view.numFaces(); ++i) {
+        const auto* ids = mesh->GetCells()->ElementAt(i)->GetPointIds();
+        auto face = view.face(i);
+        EXPECT_EQ(face[0], ids[0]);
+        EXPECT_EQ(face[1], ids[1]);
+        EXPECT_EQ(face[2], ids[2]);
+    }
+}
+
+TEST_F(UVMeshViewFixture, ScaleToUVDimensions)
+{
+    UVMeshView view(mesh, uvMap, true);
+    for (std::size_t i = 0; i < view.numVertices(); ++i) {
+        auto uv = uvMap->get(i);
+        EXPECT_DOUBLE_EQ(view.uv(i)[0], uv[0] * 40);
+        EXPECT_DOUBLE_EQ(view.uv(i)[1], uv[1] * 30);
+    }
+}
+
+TEST_F(UVMeshViewFixture, ToITKMeshSharesCells)
+{
+    UVMeshView view(mesh, uvMap);
+    auto uvMesh = view.toITKMesh();
+    EXPECT_EQ(uvMesh->GetCells(), mesh->GetCells());
+    ASSERT_EQ(uvMesh->GetNumberOfPoints(), view.numVertices());
+
+    for (std::size_t i = 0; i < view.numVertices(); ++i) {
+        auto p = uvMesh->GetPoint(i);
+        auto v = view.vertex(i);
+        EXPECT_EQ(p[0], v[0]);
+        EXPECT_EQ(p[1], v[1]);
+        EXPECT_EQ(p[2], v[2]);
+
+        ITKPixel n;
+        uvMesh->GetPointData(i, &n);
+        EXPECT_EQ(n[1], 1);
+    }
+
+    // The cells stay valid after the source mesh is released
+    const auto numCells = mesh->GetNumberOfCells();
+    mesh = nullptr;
+    view = UVMeshView();
+    EXPECT_EQ(uvMesh->GetNumberOfCells(), numCells);
+    EXPECT_EQ(uvMesh->GetCells()->ElementAt(0)->GetNumberOfPoints(), 3);
+}
+
+TEST(UVMeshView, DefaultIsInvalid) { EXPECT_FALSE(UVMeshView().valid()); }
@@ -0,0 +1,173 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+
+#include <opencv2/core.hpp>
+
+#include "vc/core/filesystem.hpp"
+#include "vc/core/types/Exceptions.hpp"
+#include "vc/core/types/Volume.hpp"
+#include "vc/core/types/VolumeBlockStatistics.hpp"
+
+using namespace volcart;
+namespace fs = volcart::filesystem;
+
+namespace
+{
+// 10x10 slice which is 7 for x < 8 and 100 * z + y otherwise
+auto TestSlice(int z) -> cv::Mat
+{
+    cv::Mat slice(10, 10, CV_16UC1, cv::Scalar(7));
+    for (int y = 0; y < 10; y++) {
+        for (int x = 8; x < 10; x++) {
+            slice.at<std::uint16_t>(y, x) = 100 * z + y;
+        }
+    }
+    return slice;
+}
+}  // namespace
+
+TEST(VolumeBlockStatistics, AddSlices)
+{
+    VolumeBlockStatistics s({10, 10, 10}, 4);
+    EXPECT_EQ(s.gridSize(), cv::Vec3i(3, 3, 3));
+    EXPECT_FALSE(s.complete());
+
+    for (int z = 0; z < 10; z++) {
+        s.addSlice(z, TestSlice(z));
+    }
+    EXPECT_TRUE(s.complete());
+
+    auto b = s.block(0, 1, 2);
+    EXPECT_EQ(b.min, 7);
+    EXPECT_EQ(b.max, 7);
+    EXPECT_DOUBLE_EQ(b.mean, 7);
+    EXPECT_TRUE(s.isConstant(1, 2, 2));
+
+    // Edge block: x in [8, 10), y in [8, 10), z in [8, 10)
+    b = s.block(2, 2, 2);
+    EXPECT_EQ(b.min, 808);
+    EXPECT_EQ(b.max, 909);
+    EXPECT_DOUBLE_EQ(b.mean, 858.5);
+    EXPECT_FALSE(s.isConstant(2, 2, 2));
+
+    EXPECT_TRUE(s.mayContain(0, 0, 0, 0, 10));
+    EXPECT_FALSE(s.mayContain(0, 0, 0, 8, 65535));
+    EXPECT_TRUE(s.mayContain(2, 0, 0, 300, 400));
+    EXPECT_FALSE(s.mayContain(2, 0, 0, 400, 800));
+    EXPECT_TRUE(s.mayContain(5, 0, 0, 400, 800));
+
+    EXPECT_FALSE(s.mayContain({0, 0, 0}, {8, 10, 10}, 8, 65535));
+    EXPECT_TRUE(s.mayContain({0, 0, 0}, {9, 10, 10}, 8, 65535));
+    EXPECT_FALSE(s.mayContain({0, 0, 0}, {0, 10, 10}, 0, 65535));
+
+    EXPECT_THROW(s.block(3, 0, 0), std::out_of_range);
+    EXPECT_THROW(
+        s.addSlice(0, cv::Mat(10, 10, CV_8UC1)), std::invalid_argument);
+    EXPECT_THROW(
+        s.addSlice(0, cv::Mat(5, 10, CV_16UC1)), std::invalid_argument);
+    EXPECT_THROW(s.addSlice(10, TestSlice(0)), std::out_of_range);
+}
+
+TEST(VolumeBlockStatistics, IncompleteLayers)
+{
+    VolumeBlockStatistics s({10, 10, 10}, 4);
+    s.addSlice(0, TestSlice(0));
+    EXPECT_FALSE(s.isComplete(0, 0, 0));
+    EXPECT_TRUE(s.mayContain(0, 0, 0, 8, 65535));
+    EXPECT_FALSE(s.isConstant(0, 0, 0));
+    EXPECT_EQ(s.block(0, 0, 0).max, 7);
+
+    // Layer 2 is the last layer and only has two slices
+    s.addSlice(8, TestSlice(8));
+    s.addSlice(9, TestSlice(9));
+    EXPECT_TRUE(s.isComplete(0, 0, 2));
+    EXPECT_FALSE(s.mayContain(0, 0, 2, 8, 65535));
+}
+
+TEST(VolumeBlockStatistics, Merge)
+{
+    VolumeBlockStatistics a({10, 10, 10}, 4);
+    VolumeBlockStatistics b({10, 10, 10}, 4);
+    for (int z = 0; z < 10; z++) {
+        (z % 2 == 0 ? a : b).addSlice(z, TestSlice(z));
+    }
+    EXPECT_FALSE(a.complete());
+    a.merge(b);
+    EXPECT_TRUE(a.complete());
+    EXPECT_EQ(a.block(2, 0, 0).min, 0);
+    EXPECT_EQ(a.block(2, 0, 0).max, 303);
+
+    VolumeBlockStatistics c({10, 10, 10}, 5);
+    EXPECT_THROW(a.merge(c), std::invalid_argument);
+}
+
+TEST(VolumeBlockStatistics, WriteRead)
+{
+    VolumeBlockStatistics s({10, 10, 10}, 4);
+    for (int z = 0; z < 10; z++) {
+        s.addSlice(z, TestSlice(z));
+    }
+
+    fs::path path{"vc_core_VolumeBlockStatistics.bin"};
+    s.write(path);
+    auto result = VolumeBlockStatistics::Read(path);
+    EXPECT_EQ(result.volumeShape(), s.volumeShape());
+    EXPECT_EQ(result.blockSize(), 4);
+    EXPECT_TRUE(result.complete());
+    EXPECT_EQ(result.block(2, 2, 2).min, 808);
+    EXPECT_DOUBLE_EQ(result.block(2, 2, 2).mean, 858.5);
+
+    EXPECT_THROW(
+        VolumeBlockStatistics::Read("vc_core_VolumeBlockStatistics.missing"),
+        IOException);
+}
+
+TEST(VolumeBlockStatistics, ConstantBlocks)
+{
+    fs::path volPath{"vc_core_VolumeBlockStatistics"};
+    fs::remove_all(volPath);
+    fs::create_directory(volPath);
+
+    auto vol = Volume::New(volPath, "BlockStats", "BlockStats");
+    vol->setSliceWidth(10);
+    vol->setSliceHeight(10);
+    vol->setNumberOfSlices(10);
+    vol->setFormat(Volume::Format::Blocks, 4);
+    vol->saveMetadata();
+    for (int z = 0; z < 10; z++) {
+        vol->setSliceData(z, TestSlice(z));
+    }
+    EXPECT_FALSE(vol->hasBlockStatistics());
+
+    auto stats = VolumeBlockStatistics::Compute(*vol, 4);
+    EXPECT_TRUE(stats.complete());
+    EXPECT_EQ(stats.block(2, 2, 2).max, 909);
+    vol->setBlockStatistics(stats);
+
+    // Constant blocks are filled without being read
+    fs::remove(vol->getBlockPath(1, 2, 2));
+    auto loaded = Volume::New(volPath);
+    ASSERT_TRUE(loaded->hasBlockStatistics());
+    auto block = loaded->getBlockData(1, 2, 2);
+    ASSERT_EQ(block.type(), CV_16UC1);
+    for (int z = 0; z < 4; z++) {
+        for (int y = 0; y < 4; y++) {
+            for (int x = 0; x < 4; x++) {
+                auto expected = (z < 2 and y < 2) ? 7 : 0;
+                EXPECT_EQ(block.at<std::uint16_t>(z * 4 + y, x), expected);
+            }
+        }
+    }
+    EXPECT_EQ(loaded->getSliceData(9).at<std::uint16_t>(9, 7), 7);
+    EXPECT_EQ(loaded->getSliceData(9).at<std::uint16_t>(9, 9), 909);
+
+    // Writing a slice removes the statistics
+    loaded->setSliceData(0, TestSlice(0));
+    EXPECT_FALSE(loaded->hasBlockStatistics());
+    EXPECT_FALSE(Volume::New(volPath)->hasBlockStatistics());
+
+    EXPECT_THROW(
+        vol->setBlockStatistics(VolumeBlockStatistics({5, 5, 5}, 4)),
+        std::invalid_argument);
+}
@@ -98,4 +98,90 @@ TEST(VolumeMask, Performance_EightThousandVoxelSubvolume)
 
     // Retrieval
     EXPECT_THAT(subvolume.as_vector(), testing::ContainerEq(key));
-}
\ No newline at end of file
+}
+
+TEST(VolumeMask, OutOfBounds)
+{
+    VolumeMask mask(5, 5, 5);
+    mask.setVoxelState({5, 0, 0}, State::Segmented);
+    mask.setVoxelState({-1, 0, 0}, State::Segmented);
+    EXPECT_EQ(mask.getVoxelState({5, 0, 0}), State::Unsegmented);
+    EXPECT_EQ(mask.getVoxelState({-1, 0, 0}), State::Unsegmented);
+    EXPECT_EQ(mask.countSegmented(), 0);
+
+    // Subvolumes are clipped to the mask
+    mask.setSubvolumeState({3, 3, 3}, {4, 4, 4}, State::Segmented);
+    EXPECT_EQ(mask.countSegmented(), 8);
+    auto subvolume = mask.getSubvolumeState({4, 4, 4}, {2, 2, 2});
+    EXPECT_EQ(subvolume(0, 0, 0), State::Segmented);
+    EXPECT_EQ(subvolume(1, 1, 1), State::Unsegmented);
+}
+
+TEST(VolumeMask, SubvolumeAcrossBricks)
+{
+    VolumeMask mask(100, 80, 70);
+
+    // Covers whole bricks and partial bricks on every side
+    cv::Vec3i origin(10, 20, 5);
+    cv::Vec3i dims(70, 45, 60);
+    mask.setSubvolumeState(origin, dims, State::Segmented);
+    EXPECT_EQ(mask.countSegmented(), 70 * 45 * 60);
+
+    // Read a region which overlaps the border of the set region
+    cv::Vec3i readOrigin(5, 15, 0);
+    cv::Vec3i readDims(80, 55, 70);
+    auto subvolume = mask.getSubvolumeState(readOrigin, readDims);
+    size_t segmented{0};
+    for (int z = 0; z < readDims[2]; z++) {
+        for (int y = 0; y < readDims[1]; y++) {
+            for (int x = 0; x < readDims[0]; x++) {
+                cv::Vec3i p = readOrigin + cv::Vec3i(x, y, z);
+                auto inside = true;
+                for (int i = 0; i < 3; i++) {
+                    inside &= p[i] >= origin[i] and p[i] < origin[i] + dims[i];
+                }
+                auto expected = inside ? State::Segmented : State::Unsegmented;
+                EXPECT_EQ(subvolume(z, y, x), expected);
+                EXPECT_EQ(mask.getVoxelState(p), expected);
+                segmented += inside ? 1 : 0;
+            }
+        }
+    }
+    EXPECT_EQ(mask.countSegmented(readOrigin, readDims), segmented);
+
+    // Unsegment a region which splits full bricks
+    mask.setSubvolumeState({40, 40, 40}, {10, 10, 10}, State::Unsegmented);
+    EXPECT_EQ(mask.countSegmented(), 70 * 45 * 60 - 1000);
+    EXPECT_EQ(mask.getVoxelState({45, 45, 45}), State::Unsegmented);
+    EXPECT_EQ(mask.getVoxelState({39, 45, 45}), State::Segmented);
+    EXPECT_EQ(mask.countSegmented({40, 40, 40}, {10, 10, 10}), 0);
+
+    // Clear everything
+    mask.setSubvolumeState({0, 0, 0}, {100, 80, 70}, State::Unsegmented);
+    EXPECT_EQ(mask.countSegmented(), 0);
+}
+
+TEST(VolumeMask, MergeAndIntersect)
+{
+    VolumeMask a(64, 64, 64);
+    VolumeMask b(64, 64, 64);
+    a.setSubvolumeState({0, 0, 0}, {40, 64, 64}, State::Segmented);
+    b.setSubvolumeState({30, 0, 0}, {34, 64, 64}, State::Segmented);
+    b.setVoxelState({0, 0, 0}, State::Unsegmented);
+
+    auto merged = a;
+    merged.merge(b);
+    EXPECT_EQ(merged.countSegmented(), 64 * 64 * 64);
+    EXPECT_EQ(merged.getVoxelState({63, 10, 10}), State::Segmented);
+
+    auto intersected = a;
+    intersected.intersect(b);
+    EXPECT_EQ(intersected.countSegmented(), 10 * 64 * 64);
+    EXPECT_EQ(intersected.getVoxelState({29, 0, 0}), State::Unsegmented);
+    EXPECT_EQ(intersected.getVoxelState({30, 0, 0}), State::Segmented);
+    EXPECT_EQ(intersected.getVoxelState({40, 0, 0}), State::Unsegmented);
+
+    VolumeMask c(64, 64, 63);
+    EXPECT_THROW(a.merge(c), std::invalid_argument);
+    EXPECT_THROW(a.intersect(c), std::invalid_argument);
+}
@@ -0,0 +1,147 @@
+#include <fstream>
+
+#include <gtest/gtest.h>
+
+#include "vc/core/filesystem.hpp"
+#include "vc/core/types/VolumePkg.hpp"
+
+using namespace volcart;
+namespace fs = volcart::filesystem;
+
+class IndexedVolumePkg : public ::testing::Test
+{
+public:
+    fs::path pkgPath{"vc_core_VolumePkg_Indexed.volpkg"};
+
+    IndexedVolumePkg()
+    {
+        fs::remove_all(pkgPath);
+        auto pkg = VolumePkg::New(pkgPath, VOLPKG_VERSION_LATEST);
+        pkg->newVolume("vol");
+        pkg->newSegmentation("seg");
+        pkg->newRender("render");
+    }
+
+    ~IndexedVolumePkg() override { fs::remove_all(pkgPath); }
+};
+
+TEST_F(IndexedVolumePkg, ReopenFromIndex)
+{
+    EXPECT_TRUE(fs::exists(pkgPath / "index.json"));
+
+    VolumePkg pkg(pkgPath);
+    EXPECT_EQ(pkg.numberOfVolumes(), 1);
+    EXPECT_EQ(pkg.numberOfSegmentations(), 1);
+    EXPECT_EQ(pkg.numberOfRenders(), 1);
+    EXPECT_EQ(pkg.volumeNames(), std::vector<std::string>{"vol"});
+    EXPECT_EQ(pkg.segmentationNames(), std::vector<std::string>{"seg"});
+    EXPECT_EQ(pkg.renderNames(), std::vector<std::string>{"render"});
+
+    // Objects are constructed on access and match their index entries
+    for (const auto& id : pkg.segmentationIDs()) {
+        auto seg = pkg.segmentation(id);
+        EXPECT_EQ(seg->id(), id);
+        EXPECT_EQ(seg, pkg.segmentation(id));
+    }
+    EXPECT_EQ(pkg.volume()->name(), "vol");
+}
+
+TEST_F(IndexedVolumePkg, UnindexedObjects)
+{
+    // Add a segmentation without going through the VolumePkg
+    auto segDir = pkgPath / "paths" / "external";
+    fs::create_directory(segDir);
+    Segmentation::New(segDir, "ext", "ext");
+
+    VolumePkg pkg(pkgPath);
+    EXPECT_EQ(pkg.numberOfSegmentations(), 2);
+    EXPECT_EQ(pkg.segmentation("ext")->name(), "ext");
+
+    // Removed objects are dropped from the index
+    fs::remove_all(segDir);
+    VolumePkg reopened(pkgPath);
+    EXPECT_EQ(reopened.numberOfSegmentations(), 1);
+    EXPECT_THROW(reopened.segmentation("ext"), std::out_of_range);
+}
+
+TEST_F(IndexedVolumePkg, InvalidIndex)
+{
+    {
+        std::ofstream file((pkgPath / "index.json").string());
+        file << "not json";
+    }
+
+    VolumePkg pkg(pkgPath);
+    EXPECT_EQ(pkg.numberOfVolumes(), 1);
+    EXPECT_EQ(pkg.numberOfSegmentations(), 1);
+    EXPECT_EQ(pkg.numberOfRenders(), 1);
+}
+
+TEST(VolumePkg, NewVolumeFromRegion)
+{
+    // Volume IDs are timestamps, so each volume goes in its own package
+    fs::path srcPath{"vc_core_VolumePkg_CropSource.volpkg"};
+    fs::path cropPath{"vc_core_VolumePkg_Crop.volpkg"};
+    fs::path nestedPath{"vc_core_VolumePkg_NestedCrop.volpkg"};
+    for (const auto& p : {srcPath, cropPath, nestedPath}) {
+        fs::remove_all(p);
+    }
+
+    auto srcPkg = VolumePkg::New(srcPath, VOLPKG_VERSION_LATEST);
+    auto src = srcPkg->newVolume("src");
+    src->setSliceWidth(20);
+    src->setSliceHeight(12);
+    src->setNumberOfSlices(10);
+    src->setVoxelSize(5.0);
+    src->saveMetadata();
+    for (int z = 0; z < 10; z++) {
+        cv::Mat slice(12, 20, CV_16UC1);
+        for (int y = 0; y < 12; y++) {
+            for (int x = 0; x < 20; x++) {
+                slice.at<uint16_t>(y, x) = z * 1000 + y * 20 + x;
+            }
+        }
+        src->setSliceData(z, slice);
+    }
+
+    // The region is clipped to the source volume
+    auto cropPkg = VolumePkg::New(cropPath, VOLPKG_VERSION_LATEST);
+    auto crop = cropPkg->newVolumeFromRegion(
+        src, {15, 4, 10, 4}, {8, 12}, "crop", Volume::Format::Blocks, 4);
+    EXPECT_EQ(crop->sliceWidth(), 5);
+    EXPECT_EQ(crop->sliceHeight(), 4);
+    EXPECT_EQ(crop->numSlices(), 2);
+    EXPECT_EQ(crop->voxelSize(), 5.0);
+    EXPECT_EQ(crop->cropSourceID(), src->id());
+    EXPECT_EQ(crop->cropOffset(), cv::Vec3i(15, 4, 8));
+    EXPECT_FALSE(src->hasCropOrigin());
+
+    // Voxels and the crop origin are read back from disk
+    VolumePkg reopened(cropPath);
+    auto loaded = reopened.volume();
+    ASSERT_TRUE(loaded->hasCropOrigin());
+    EXPECT_EQ(loaded->cropOffset(), cv::Vec3i(15, 4, 8));
+    for (int z = 0; z < 2; z++) {
+        for (int y = 0; y < 4; y++) {
+            for (int x = 0; x < 5; x++) {
+                EXPECT_EQ(
+                    loaded->intensityAt(x, y, z),
+                    (z + 8) * 1000 + (y + 4) * 20 + x + 15);
+            }
+        }
+    }
+
+    // Crops of crops map back to the original volume
+    auto nestedPkg = VolumePkg::New(nestedPath, VOLPKG_VERSION_LATEST);
+    auto nested = nestedPkg->newVolumeFromRegion(loaded, {1, 1, 2, 2}, {1, 2});
+    EXPECT_EQ(nested->cropSourceID(), src->id());
+    EXPECT_EQ(nested->cropOffset(), cv::Vec3i(16, 5, 9));
+
+    EXPECT_THROW(
+        nestedPkg->newVolumeFromRegion(src, {30, 0, 5, 5}, {0, 1}),
+        std::invalid_argument);
+
+    for (const auto& p : {srcPath, cropPath, nestedPath}) {
+        fs::remove_all(p);
+    }
+}
@@ -0,0 +1,86 @@
+#include <fstream>
+
+#include <gtest/gtest.h>
+
+#include "vc/core/filesystem.hpp"
+#include "vc/core/io/HTTPVolumeSource.hpp"
+#include "vc/core/io/VolumeSource.hpp"
+
+using namespace volcart;
+using namespace volcart::io;
+namespace fs = volcart::filesystem;
+
+class LocalVolumeSource_Dir : public ::testing::Test
+{
+public:
+    LocalVolumeSource_Dir()
+    {
+        fs::remove_all(dir);
+        fs::create_directories(dir / "blocks");
+        std::ofstream((dir / "0.tif").string(), std::ios::binary) << "slice";
+        std::ofstream(
+            (dir / "blocks" / "0_0_0.tif").string(), std::ios::binary)
+            << "block";
+    }
+
+    ~LocalVolumeSource_Dir() override { fs::remove_all(dir); }
+
+    fs::path dir{"vc_core_LocalVolumeSource"};
+};
+
+TEST_F(LocalVolumeSource_Dir, Read)
+{
+    auto source = LocalVolumeSource::New(dir);
+    auto slice = source->read("0.tif");
+    ASSERT_TRUE(slice.has_value());
+    EXPECT_EQ(std::string(slice->begin(), slice->end()), "slice");
+    auto block = source->read("blocks/0_0_0.tif");
+    ASSERT_TRUE(block.has_value());
+    EXPECT_EQ(std::string(block->begin(), block->end()), "block");
+    EXPECT_FALSE(source->read("1.tif").has_value());
+}
+
+TEST_F(LocalVolumeSource_Dir, Stamp)
+{
+    auto source = LocalVolumeSource::New(dir);
+    EXPECT_EQ(source->stamp("0.tif").size, 5);
+    EXPECT_EQ(source->stamp("1.tif").size, 0);
+}
+
+TEST_F(LocalVolumeSource_Dir, Open)
+{
+    // Relative paths are resolved against the base directory
+    auto source = VolumeSource::Open(dir.string(), fs::current_path());
+    EXPECT_TRUE(source->read("0.tif").has_value());
+
+    source = VolumeSource::Open("file://" + fs::absolute(dir).string());
+    EXPECT_NE(std::dynamic_pointer_cast<LocalVolumeSource>(source), nullptr);
+    EXPECT_TRUE(source->read("0.tif").has_value());
+}
+
+TEST(HTTPVolumeSource, ResolveURL)
+{
+    EXPECT_EQ(
+        HTTPVolumeSource::ResolveURL("s3://bucket/path/to/volume"),
+        "https://bucket.s3.amazonaws.com/path/to/volume");
+    EXPECT_EQ(
+        HTTPVolumeSource::ResolveURL("s3://bucket"),
+        "https://bucket.s3.amazonaws.com");
+    EXPECT_EQ(
+        HTTPVolumeSource::ResolveURL("https://example.com/volume"),
+        "https://example.com/volume");
+}
+
+TEST(HTTPVolumeSource, Open)
+{
+    if (not HTTPVolumeSource::Available()) {
+        EXPECT_THROW(
+            VolumeSource::Open("https://example.com/volume"),
+            std::runtime_error);
+        return;
+    }
+
+    // Opening does not contact the server
+    auto source = VolumeSource::Open("s3://bucket/volume/");
+    EXPECT_EQ(source->uri(), "https://bucket.s3.amazonaws.com/volume");
+}
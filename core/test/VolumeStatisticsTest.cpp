@@ -0,0 +1,94 @@
+#include <gtest/gtest.h>
+
+#include <opencv2/core.hpp>
+
+#include "vc/core/filesystem.hpp"
+#include "vc/core/types/Volume.hpp"
+#include "vc/core/types/VolumeStatistics.hpp"
+
+using namespace volcart;
+namespace fs = volcart::filesystem;
+
+TEST(VolumeStatistics, Empty)
+{
+    VolumeStatistics s;
+    EXPECT_EQ(s.count(), 0);
+    EXPECT_EQ(s.min(), 0);
+    EXPECT_EQ(s.max(), 0);
+    EXPECT_EQ(s.mean(), 0);
+    EXPECT_EQ(s.percentile(50), 0);
+    EXPECT_TRUE(s.slices().empty());
+}
+
+TEST(VolumeStatistics, AddSlices)
+{
+    // Slice z contains the values [100 * z, 100 * z + 99]
+    VolumeStatistics s;
+    for (int z = 0; z < 3; z++) {
+        cv::Mat slice(10, 10, CV_16UC1);
+        for (int i = 0; i < 100; i++) {
+            slice.at<uint16_t>(i / 10, i % 10) = 100 * z + i;
+        }
+        s.addSlice(z, slice);
+    }
+
+    EXPECT_EQ(s.count(), 300);
+    EXPECT_EQ(s.min(), 0);
+    EXPECT_EQ(s.max(), 299);
+    EXPECT_DOUBLE_EQ(s.mean(), 149.5);
+    EXPECT_EQ(s.percentile(0), 0);
+    EXPECT_EQ(s.percentile(50), 149);
+    EXPECT_EQ(s.percentile(100), 299);
+
+    ASSERT_EQ(s.slices().size(), 3);
+    EXPECT_EQ(s.slices()[1].min, 100);
+    EXPECT_EQ(s.slices()[1].max, 199);
+    EXPECT_DOUBLE_EQ(s.slices()[1].mean, 149.5);
+
+    EXPECT_THROW(
+        s.addSlice(3, cv::Mat(2, 2, CV_8UC1)), std::invalid_argument);
+}
+
+TEST(VolumeStatistics, Merge)
+{
+    VolumeStatistics a;
+    VolumeStatistics b;
+    a.addSlice(0, cv::Mat(2, 2, CV_16UC1, cv::Scalar(10)));
+    b.addSlice(2, cv::Mat(2, 2, CV_16UC1, cv::Scalar(30)));
+    a.merge(b);
+
+    EXPECT_EQ(a.count(), 8);
+    EXPECT_EQ(a.min(), 10);
+    EXPECT_EQ(a.max(), 30);
+    ASSERT_EQ(a.slices().size(), 3);
+    EXPECT_TRUE(a.slices()[0].valid);
+    EXPECT_FALSE(a.slices()[1].valid);
+    EXPECT_EQ(a.slices()[2].mean, 30);
+}
+
+TEST(VolumeStatistics, VolumeMetadata)
+{
+    fs::path volPath{"vc_core_VolumeStatistics"};
+    fs::remove_all(volPath);
+    fs::create_directory(volPath);
+
+    VolumeStatistics s;
+    s.addSlice(0, cv::Mat(4, 4, CV_16UC1, cv::Scalar(5)));
+    s.addSlice(2, cv::Mat(4, 4, CV_16UC1, cv::Scalar(500)));
+
+    auto vol = Volume::New(volPath, "Statistics", "Statistics");
+    EXPECT_FALSE(vol->hasStatistics());
+    EXPECT_THROW(vol->statistics(), std::runtime_error);
+    vol->setStatistics(s);
+    vol->saveMetadata();
+
+    auto loaded = Volume::New(volPath);
+    ASSERT_TRUE(loaded->hasStatistics());
+    auto result = loaded->statistics();
+    EXPECT_EQ(result.histogram(), s.histogram());
+    EXPECT_EQ(result.percentile(50), 5);
+    ASSERT_EQ(result.slices().size(), 3);
+    EXPECT_EQ(result.slices()[0].max, 5);
+    EXPECT_FALSE(result.slices()[1].valid);
+    EXPECT_EQ(result.slices()[2].min, 500);
+}
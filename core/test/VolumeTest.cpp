@@ -0,0 +1,995 @@
+#include <chrono>
+#include <fstream>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include <opencv2/core.hpp>
+
+#include "vc/core/filesystem.hpp"
+#include "vc/core/io/TIFFIO.hpp"
+#include "vc/core/types/Volume.hpp"
+#include "vc/testing/TestingUtils.hpp"
+
+using namespace volcart;
+namespace fs = volcart::filesystem;
+
+class BlocksVolume : public ::testing::Test
+{
+public:
+    fs::path volPath{"vc_core_Volume_Blocks"};
+    std::vector<cv::Mat> slices;
+
+    static constexpr int WIDTH = 20;
+    static constexpr int HEIGHT = 12;
+    static constexpr int SLICES = 10;
+    static constexpr int BLOCK_SIZE = 8;
+
+    BlocksVolume()
+    {
+        fs::remove_all(volPath);
+        fs::create_directory(volPath);
+
+        Volume vol(volPath, "BlocksVolume", "BlocksVolume");
+        vol.setSliceWidth(WIDTH);
+        vol.setSliceHeight(HEIGHT);
+        vol.setNumberOfSlices(SLICES);
+        vol.setFormat(Volume::Format::Blocks, BLOCK_SIZE);
+        vol.saveMetadata();
+
+        for (int z = 0; z < SLICES; z++) {
+            cv::Mat slice(HEIGHT, WIDTH, CV_16UC1);
+            for (int y = 0; y < HEIGHT; y++) {
+                for (int x = 0; x < WIDTH; x++) {
+                    slice.at<uint16_t>(y, x) = z * 1000 + y * WIDTH + x;
+                }
+            }
+            slices.push_back(slice);
+        }
+
+        // Write out of order to exercise the layer buffer
+        for (int z = SLICES - 1; z >= 0; z--) {
+            vol.setSliceData(z, slices[z]);
+        }
+    }
+};
+
+TEST_F(BlocksVolume, Metadata)
+{
+    auto vol = Volume::New(volPath);
+    EXPECT_EQ(vol->format(), Volume::Format::Blocks);
+    EXPECT_EQ(vol->blockSize(), BLOCK_SIZE);
+    EXPECT_EQ(vol->blockGridSize(), cv::Vec3i(3, 2, 2));
+    EXPECT_TRUE(fs::exists(vol->getBlockPath(2, 1, 1)));
+}
+
+TEST_F(BlocksVolume, ReadSlices)
+{
+    auto vol = Volume::New(volPath);
+    for (int z = 0; z < SLICES; z++) {
+        auto slice = vol->getSliceData(z);
+        ASSERT_EQ(slice.size(), slices[z].size());
+        EXPECT_TRUE(volcart::testing::CvMatEqual<uint16_t>(slice, slices[z]));
+    }
+}
+
+TEST_F(BlocksVolume, ReadVoxels)
+{
+    auto vol = Volume::New(volPath);
+    for (int z = 0; z < SLICES; z++) {
+        for (int y = 0; y < HEIGHT; y++) {
+            for (int x = 0; x < WIDTH; x++) {
+                EXPECT_EQ(
+                    vol->intensityAt(x, y, z), slices[z].at<uint16_t>(y, x));
+            }
+        }
+    }
+}
+
+TEST_F(BlocksVolume, ReadBlockPadding)
+{
+    auto vol = Volume::New(volPath);
+    auto block = vol->getBlockData(2, 1, 1);
+    EXPECT_EQ(block.rows, BLOCK_SIZE * BLOCK_SIZE);
+    EXPECT_EQ(block.cols, BLOCK_SIZE);
+
+    // Voxel (19, 11, 9) is at block-local (3, 3, 1)
+    EXPECT_EQ(block.at<uint16_t>(1 * BLOCK_SIZE + 3, 3), 9000 + 11 * 20 + 19);
+    // Padding outside of the volume is zeroed
+    EXPECT_EQ(block.at<uint16_t>(1 * BLOCK_SIZE + 3, 4), 0);
+    EXPECT_EQ(block.at<uint16_t>(2 * BLOCK_SIZE, 0), 0);
+
+    EXPECT_THROW(vol->getBlockData(3, 0, 0), std::out_of_range);
+}
+
+TEST_F(BlocksVolume, ReadSliceRegion)
+{
+    auto vol = Volume::New(volPath);
+    cv::Rect roi(5, 3, 10, 7);
+    auto region = vol->getSliceRegion(9, roi);
+    ASSERT_EQ(region.size(), roi.size());
+    EXPECT_TRUE(
+        volcart::testing::CvMatEqual<uint16_t>(region, slices[9](roi)));
+
+    // Regions are clipped to the slice
+    cv::Rect edge(15, 10, 10, 10);
+    region = vol->getSliceRegion(0, edge);
+    cv::Rect clipped(15, 10, 5, 2);
+    ASSERT_EQ(region.size(), clipped.size());
+    EXPECT_TRUE(
+        volcart::testing::CvMatEqual<uint16_t>(region, slices[0](clipped)));
+}
+
+TEST_F(BlocksVolume, AsyncReads)
+{
+    auto vol = Volume::New(volPath);
+    vol->setAsyncReader(io::AsyncReader::New(4, 2));
+    for (int z = 0; z < SLICES; z++) {
+        auto slice = vol->getSliceData(z);
+        ASSERT_EQ(slice.size(), slices[z].size());
+        EXPECT_TRUE(volcart::testing::CvMatEqual<uint16_t>(slice, slices[z]));
+    }
+
+    // Every block of a layer is read at once, and each only once
+    auto stats = vol->cacheStats();
+    EXPECT_EQ(stats.misses, 12);
+    EXPECT_EQ(vol->asyncReader()->pending(), 0);
+}
+
+TEST(Volume, CachedMetadata)
+{
+    fs::path volPath{"vc_core_Volume_CachedMetadata"};
+    fs::remove_all(volPath);
+    fs::create_directory(volPath);
+
+    auto vol = Volume::New(volPath, "CachedMetadata", "CachedMetadata");
+    vol->setSliceWidth(4);
+    vol->setSliceHeight(4);
+    vol->setNumberOfSlices(2);
+    EXPECT_DOUBLE_EQ(vol->voxelSize(), 0);
+    EXPECT_FALSE(vol->hasStatistics());
+    EXPECT_FALSE(vol->hasCropOrigin());
+    EXPECT_THROW(vol->statistics(), std::runtime_error);
+    EXPECT_THROW(vol->cropOffset(), std::runtime_error);
+
+    // Setters update the getters before the metadata is saved
+    vol->setVoxelSize(7.91);
+    vol->setMin(10);
+    vol->setMax(200);
+    VolumeStatistics stats;
+    stats.addSlice(0, cv::Mat(4, 4, CV_16UC1, cv::Scalar(10)));
+    vol->setStatistics(stats);
+    vol->setCropOrigin("source", {1, 2, 3});
+    EXPECT_DOUBLE_EQ(vol->voxelSize(), 7.91);
+    EXPECT_DOUBLE_EQ(vol->min(), 10);
+    EXPECT_DOUBLE_EQ(vol->max(), 200);
+    EXPECT_TRUE(vol->hasStatistics());
+    EXPECT_EQ(vol->statistics().count(), 16U);
+    EXPECT_EQ(vol->cropSourceID(), "source");
+    EXPECT_EQ(vol->cropOffset(), cv::Vec3i(1, 2, 3));
+    vol->saveMetadata();
+
+    // The saved values are loaded
+    auto loaded = Volume::New(volPath);
+    EXPECT_DOUBLE_EQ(loaded->voxelSize(), 7.91);
+    EXPECT_DOUBLE_EQ(loaded->min(), 10);
+    EXPECT_DOUBLE_EQ(loaded->max(), 200);
+    EXPECT_EQ(loaded->statistics().count(), 16U);
+    EXPECT_EQ(loaded->cropSourceID(), "source");
+    EXPECT_EQ(loaded->cropOffset(), cv::Vec3i(1, 2, 3));
+    EXPECT_EQ(loaded->numLevels(), 1);
+}
+
+TEST(Volume, ResolutionLevels)
+{
+    fs::path volPath{"vc_core_Volume_Levels"};
+    fs::remove_all(volPath);
+    fs::create_directory(volPath);
+
+    // 5x4x3 volume where every voxel is its slice index times 10
+    auto vol = Volume::New(volPath, "Levels", "Levels");
+    vol->setSliceWidth(5);
+    vol->setSliceHeight(4);
+    vol->setNumberOfSlices(3);
+    vol->setVoxelSize(1);
+    vol->saveMetadata();
+    for (int z = 0; z < 3; z++) {
+        vol->setSliceData(z, cv::Mat(4, 5, CV_16UC1, cv::Scalar(z * 10)));
+    }
+    EXPECT_EQ(vol->numLevels(), 1);
+
+    vol->generateLevels(2, Volume::LevelFilter::Mean);
+    EXPECT_EQ(vol->numLevels(), 3);
+    EXPECT_EQ(vol->level(0), vol);
+    EXPECT_THROW(vol->level(3), std::out_of_range);
+
+    auto lvl1 = vol->level(1);
+    EXPECT_EQ(lvl1->sliceWidth(), 3);
+    EXPECT_EQ(lvl1->sliceHeight(), 2);
+    EXPECT_EQ(lvl1->numSlices(), 2);
+    EXPECT_DOUBLE_EQ(lvl1->voxelSize(), 2);
+    EXPECT_EQ(lvl1->intensityAt(0, 0, 0), 5);
+    EXPECT_EQ(lvl1->intensityAt(2, 1, 1), 20);
+
+    auto lvl2 = vol->level(2);
+    EXPECT_EQ(lvl2->sliceWidth(), 2);
+    EXPECT_EQ(lvl2->sliceHeight(), 1);
+    EXPECT_EQ(lvl2->numSlices(), 1);
+
+    // Reload from disk
+    auto loaded = Volume::New(volPath);
+    EXPECT_EQ(loaded->numLevels(), 3);
+    EXPECT_EQ(loaded->levelForSamplingInterval(0.5), 0);
+    EXPECT_EQ(loaded->levelForSamplingInterval(2.5), 1);
+    EXPECT_EQ(loaded->levelForSamplingInterval(100), 2);
+}
+
+TEST(Volume, BatchInterpolation)
+{
+    fs::path volPath{"vc_core_Volume_Interpolation"};
+    fs::remove_all(volPath);
+    fs::create_directory(volPath);
+
+    // Linear gradient so that trilinear interpolation is exact
+    auto vol = Volume::New(volPath, "Interpolation", "Interpolation");
+    vol->setSliceWidth(10);
+    vol->setSliceHeight(10);
+    vol->setNumberOfSlices(10);
+    vol->saveMetadata();
+    for (int z = 0; z < 10; z++) {
+        cv::Mat slice(10, 10, CV_16UC1);
+        for (int y = 0; y < 10; y++) {
+            for (int x = 0; x < 10; x++) {
+                slice.at<uint16_t>(y, x) = x + 10 * y + 100 * z;
+            }
+        }
+        vol->setSliceData(z, slice);
+    }
+
+    std::vector<cv::Vec3d> pts;
+    cv::RNG rng(42);
+    for (int i = 0; i < 1000; i++) {
+        pts.emplace_back(
+            rng.uniform(-1., 11.), rng.uniform(-1., 11.),
+            rng.uniform(-1., 11.));
+    }
+    auto batch = vol->interpolateAt(pts);
+    ASSERT_EQ(batch.size(), pts.size());
+
+    for (size_t i = 0; i < pts.size(); i++) {
+        const auto& p = pts[i];
+        EXPECT_EQ(batch[i], vol->interpolateAt(p));
+
+        // Interior points match the analytic gradient
+        if (p[0] >= 0 and p[0] < 9 and p[1] >= 0 and p[1] < 9 and
+            p[2] >= 0 and p[2] < 9) {
+            auto expected = cvRound(p[0] + 10 * p[1] + 100 * p[2]);
+            EXPECT_EQ(batch[i], expected);
+        }
+    }
+}
+
+TEST(Volume, BatchReslice)
+{
+    fs::path volPath{"vc_core_Volume_BatchReslice"};
+    fs::remove_all(volPath);
+    fs::create_directory(volPath);
+
+    auto vol = Volume::New(volPath, "BatchReslice", "BatchReslice");
+    vol->setSliceWidth(16);
+    vol->setSliceHeight(16);
+    vol->setNumberOfSlices(16);
+    vol->saveMetadata();
+    cv::RNG rng(7);
+    for (int z = 0; z < 16; z++) {
+        cv::Mat slice(16, 16, CV_16UC1);
+        rng.fill(slice, cv::RNG::UNIFORM, 0, 65535);
+        vol->setSliceData(z, slice);
+    }
+
+    // Oblique planes which partly leave the volume
+    std::vector<Volume::ResliceFrame> frames;
+    for (int i = 0; i < 5; i++) {
+        frames.push_back(
+            {{3. * i + 0.5, 8.25, 7.75}, {1, 0.5, 0.25}, {0, -0.5, 1}});
+    }
+    auto batch = vol->reslice(frames, 9, 7);
+    ASSERT_EQ(batch.size(), frames.size());
+    std::vector<uint16_t> raw(frames.size() * 9 * 7);
+    vol->reslice(frames.data(), frames.size(), 9, 7, raw.data());
+
+    for (std::size_t i = 0; i < frames.size(); i++) {
+        const auto& f = frames[i];
+        auto x = cv::normalize(f.xvec);
+        auto y = cv::normalize(f.yvec);
+        auto origin = f.center - (4 * x + 3 * y);
+        const auto& img = batch[i].sliceData();
+        ASSERT_EQ(img.size(), cv::Size(9, 7));
+        cv::Mat r(7, 9, CV_16UC1, raw.data() + i * 9 * 7);
+        EXPECT_TRUE(volcart::testing::CvMatEqual<uint16_t>(r, img));
+        for (int h = 0; h < 7; h++) {
+            for (int w = 0; w < 9; w++) {
+                // Positions are stepped incrementally, so allow for rounding
+                auto expected = vol->interpolateAt(origin + h * y + w * x);
+                EXPECT_NEAR(img.at<uint16_t>(h, w), expected, 1);
+            }
+        }
+        auto corner = batch[i].sliceToVoxelCoord<double>(cv::Point2d{0, 0});
+        EXPECT_LT(cv::norm(corner - origin), 1e-9);
+    }
+
+    fs::remove_all(volPath);
+}
+
+TEST(Volume, InterpolationKernels)
+{
+    fs::path volPath{"vc_core_Volume_Kernels"};
+    fs::remove_all(volPath);
+    fs::create_directory(volPath);
+
+    // Linear gradient, which both trilinear and tricubic reproduce exactly
+    auto vol = Volume::New(volPath, "Kernels", "Kernels");
+    vol->setSliceWidth(10);
+    vol->setSliceHeight(10);
+    vol->setNumberOfSlices(10);
+    vol->saveMetadata();
+    for (int z = 0; z < 10; z++) {
+        cv::Mat slice(10, 10, CV_16UC1);
+        for (int y = 0; y < 10; y++) {
+            for (int x = 0; x < 10; x++) {
+                slice.at<uint16_t>(y, x) = x + 10 * y + 100 * z;
+            }
+        }
+        vol->setSliceData(z, slice);
+    }
+
+    using Interpolation = Volume::Interpolation;
+    std::vector<cv::Vec3d> pts;
+    cv::RNG rng(42);
+    for (int i = 0; i < 1000; i++) {
+        pts.emplace_back(
+            rng.uniform(-1., 11.), rng.uniform(-1., 11.),
+            rng.uniform(-1., 11.));
+    }
+    for (auto method :
+         {Interpolation::Nearest, Interpolation::Trilinear,
+          Interpolation::Tricubic}) {
+        auto batch = vol->interpolateAt(pts, method);
+        for (size_t i = 0; i < pts.size(); i++) {
+            const auto& p = pts[i];
+            EXPECT_EQ(batch[i], vol->interpolateAt(p, method));
+
+            if (method == Interpolation::Nearest) {
+                auto x = static_cast<int>(std::floor(p[0] + 0.5));
+                auto y = static_cast<int>(std::floor(p[1] + 0.5));
+                auto z = static_cast<int>(std::floor(p[2] + 0.5));
+                EXPECT_EQ(batch[i], vol->intensityAt(x, y, z));
+            } else if (
+                p[0] >= 1 and p[0] < 8 and p[1] >= 1 and p[1] < 8 and
+                p[2] >= 1 and p[2] < 8) {
+                auto expected = cvRound(p[0] + 10 * p[1] + 100 * p[2]);
+                EXPECT_NEAR(batch[i], expected, 1);
+            }
+        }
+    }
+    const cv::Vec3d p{2.5, 3.5, 4.5};
+    EXPECT_EQ(
+        vol->interpolateAt(p, Interpolation::Trilinear),
+        vol->interpolateAt(p));
+
+    // Tricubic samples voxels exactly and repeats the edge voxels
+    const cv::Vec3d corner{0, 9, 9};
+    EXPECT_EQ(vol->interpolateAt(corner, Interpolation::Tricubic), 990);
+    EXPECT_EQ(
+        vol->interpolateAt(cv::Vec3d{9.5, 0, 0}, Interpolation::Tricubic),
+        vol->interpolateAt(cv::Vec3d{9, 0, 0}, Interpolation::Tricubic));
+
+    fs::remove_all(volPath);
+}
+
+TEST(Volume, CopyLattice)
+{
+    fs::path volPath{"vc_core_Volume_Lattice"};
+    fs::remove_all(volPath);
+    fs::create_directory(volPath);
+
+    auto vol = Volume::New(volPath, "Lattice", "Lattice");
+    vol->setSliceWidth(12);
+    vol->setSliceHeight(9);
+    vol->setNumberOfSlices(7);
+    vol->saveMetadata();
+    for (int z = 0; z < 7; z++) {
+        cv::Mat slice(9, 12, CV_16UC1);
+        for (int y = 0; y < 9; y++) {
+            for (int x = 0; x < 12; x++) {
+                slice.at<uint16_t>(y, x) = x + 12 * y + 108 * z;
+            }
+        }
+        vol->setSliceData(z, slice);
+    }
+
+    struct Case {
+        cv::Vec3i origin;
+        std::array<cv::Vec3i, 3> steps;
+        std::array<size_t, 3> extent;
+    };
+    std::vector<Case> cases{
+        // Identity, fully inside
+        {{1, 2, 3}, {{{0, 0, 1}, {0, 1, 0}, {1, 0, 0}}}, {3, 4, 5}},
+        // Partially outside on every side
+        {{-3, -2, -1}, {{{0, 0, 1}, {0, 1, 0}, {1, 0, 0}}}, {9, 13, 18}},
+        // Permuted, negative, and strided axes
+        {{11, 0, 6}, {{{1, 0, 0}, {0, 0, -1}, {0, 2, 0}}}, {6, 8, 5}},
+        {{10, 8, 0}, {{{0, -1, 0}, {0, 0, 3}, {-2, 0, 0}}}, {9, 3, 7}}};
+
+    for (const auto& c : cases) {
+        std::vector<uint16_t> out(c.extent[0] * c.extent[1] * c.extent[2]);
+        vol->copyLattice(c.origin, c.steps, c.extent, out.data());
+
+        size_t idx{0};
+        for (size_t k = 0; k < c.extent[0]; k++) {
+            for (size_t j = 0; j < c.extent[1]; j++) {
+                for (size_t i = 0; i < c.extent[2]; i++) {
+                    cv::Vec3i p = c.origin + int(k) * c.steps[0] +
+                                  int(j) * c.steps[1] + int(i) * c.steps[2];
+                    EXPECT_EQ(out[idx++], vol->interpolateAt(cv::Vec3d(p)));
+                }
+            }
+        }
+    }
+}
+
+TEST(Volume, CacheStats)
+{
+    fs::path volPath{"vc_core_Volume_CacheStats"};
+    fs::remove_all(volPath);
+    fs::create_directory(volPath);
+
+    auto vol = Volume::New(volPath, "CacheStats", "CacheStats");
+    vol->setSliceWidth(4);
+    vol->setSliceHeight(4);
+    vol->setNumberOfSlices(4);
+    vol->saveMetadata();
+    for (int z = 0; z < 4; z++) {
+        vol->setSliceData(z, cv::Mat(4, 4, CV_16UC1, cv::Scalar(z)));
+    }
+
+    // Room for two slices
+    auto loaded = Volume::New(volPath);
+    loaded->setCache(Volume::DefaultCache::New(2));
+    for (int z = 0; z < 4; z++) {
+        loaded->getSliceData(z);
+    }
+    loaded->getSliceData(3);
+
+    auto stats = loaded->cacheStats();
+    EXPECT_EQ(stats.lookups, 5);
+    EXPECT_EQ(stats.misses, 4);
+    EXPECT_EQ(stats.hits, 1);
+    EXPECT_EQ(stats.evictions, 2);
+    EXPECT_EQ(stats.bytesRead, 4 * 4 * 4 * sizeof(uint16_t));
+    EXPECT_EQ(stats.loadLatency.count, 4);
+
+    loaded->resetCacheStats();
+    stats = loaded->cacheStats();
+    EXPECT_EQ(stats.lookups, 0);
+    EXPECT_EQ(stats.evictions, 0);
+    EXPECT_EQ(stats.loadLatency.count, 0);
+}
+
+TEST(Volume, CachePolicy)
+{
+    fs::path volPath{"vc_core_Volume_CachePolicy"};
+    fs::remove_all(volPath);
+    fs::create_directory(volPath);
+
+    auto vol = Volume::New(volPath, "CachePolicy", "CachePolicy");
+    vol->setSliceWidth(8);
+    vol->setSliceHeight(8);
+    vol->setNumberOfSlices(16);
+    vol->saveMetadata();
+    for (int z = 0; z < 16; z++) {
+        vol->setSliceData(z, cv::Mat(8, 8, CV_16UC1, cv::Scalar(z)));
+    }
+
+    // Room for four slices. Changing the policy keeps the capacity.
+    auto loaded = Volume::New(volPath);
+    const size_t sliceBytes = 8 * 8 * sizeof(uint16_t);
+    loaded->setCacheMemoryInBytes(4 * sliceBytes);
+    loaded->setCachePolicy(Volume::CachePolicy::TwoQ);
+    EXPECT_EQ(loaded->getCachePolicy(), Volume::CachePolicy::TwoQ);
+    EXPECT_EQ(loaded->getCacheCapacity(), 4 * sliceBytes);
+
+    // Reuse slice 0, then scan past it
+    loaded->getSliceData(0);
+    loaded->getSliceData(0);
+    for (int z = 1; z < 16; z++) {
+        loaded->getSliceData(z);
+    }
+    EXPECT_LE(loaded->getCacheMemoryInBytes(), 4 * sliceBytes);
+    loaded->resetCacheStats();
+    loaded->getSliceData(0);
+    EXPECT_EQ(loaded->cacheStats().hits, 1);
+
+    // Changing the policy discards the cached slices
+    loaded->setCachePolicy(Volume::CachePolicy::LRU);
+    EXPECT_EQ(loaded->getCacheCapacity(), 4 * sliceBytes);
+    EXPECT_EQ(loaded->getCacheSize(), 0);
+}
+
+TEST(Volume, NUMAPartitioning)
+{
+    fs::path volPath{"vc_core_Volume_NUMAPartitioning"};
+    fs::remove_all(volPath);
+    fs::create_directory(volPath);
+
+    auto vol = Volume::New(volPath, "NUMA", "NUMA");
+    vol->setSliceWidth(8);
+    vol->setSliceHeight(8);
+    vol->setNumberOfSlices(8);
+    vol->saveMetadata();
+    for (int z = 0; z < 8; z++) {
+        vol->setSliceData(z, cv::Mat(8, 8, CV_16UC1, cv::Scalar(z)));
+    }
+
+    // Alternate slices between two nodes with room for two slices each
+    auto loaded = Volume::New(volPath);
+    EXPECT_EQ(loaded->numaPartitions(), 1);
+    EXPECT_EQ(loaded->numaNode(5), 0);
+    EXPECT_THROW(loaded->setNUMAPartitioning(-1), std::invalid_argument);
+    loaded->setNUMAPartitioning(1, 2);
+    EXPECT_EQ(loaded->numaPartitions(), 2);
+    EXPECT_EQ(loaded->numaNode(4), 0);
+    EXPECT_EQ(loaded->numaNode(5), 1);
+    const size_t sliceBytes = 8 * 8 * sizeof(uint16_t);
+    loaded->setCacheMemoryInBytes(4 * sliceBytes);
+
+    // Node 0's slices do not evict node 1's slices
+    loaded->getSliceData(1);
+    for (int z = 0; z < 8; z += 2) {
+        loaded->getSliceData(z);
+    }
+    loaded->resetCacheStats();
+    loaded->getSliceData(1);
+    loaded->getSliceData(6);
+    loaded->getSliceData(0);
+    auto stats = loaded->cacheStats();
+    EXPECT_EQ(stats.hits, 2);
+    EXPECT_EQ(stats.misses, 1);
+
+    // Disabling partitioning keeps the capacity
+    loaded->setNUMAPartitioning(0);
+    EXPECT_EQ(loaded->numaPartitions(), 1);
+    EXPECT_EQ(loaded->getCacheCapacity(), 4 * sliceBytes);
+
+    fs::remove_all(volPath);
+}
+
+TEST(Volume, DiskCache)
+{
+    fs::path volPath{"vc_core_Volume_DiskCache"};
+    fs::path cachePath{"vc_core_Volume_DiskCache_cache"};
+    fs::remove_all(volPath);
+    fs::remove_all(cachePath);
+    fs::create_directory(volPath);
+
+    auto vol = Volume::New(volPath, "DiskCache", "DiskCache");
+    vol->setSliceWidth(4);
+    vol->setSliceHeight(4);
+    vol->setNumberOfSlices(2);
+    vol->saveMetadata();
+    for (int z = 0; z < 2; z++) {
+        vol->setSliceData(z, cv::Mat(4, 4, CV_16UC1, cv::Scalar(z + 1)));
+    }
+
+    // The first read decodes the slice and adds it to the disk cache
+    auto diskCache = DiskCache::New(cachePath);
+    auto loaded = Volume::New(volPath);
+    loaded->setDiskCache(diskCache);
+    loaded->getSliceData(1);
+    EXPECT_EQ(diskCache->hits(), 0);
+    EXPECT_GT(diskCache->bytes(), 0);
+
+    // Another volume object reads the decoded slice from the disk cache
+    auto other = Volume::New(volPath);
+    other->setDiskCache(diskCache);
+    auto slice = other->getSliceData(1);
+    EXPECT_EQ(diskCache->hits(), 1);
+    EXPECT_EQ(slice.at<uint16_t>(2, 2), 2);
+
+    fs::remove_all(cachePath);
+}
+
+TEST(Volume, Source)
+{
+    fs::path dataPath{"vc_core_Volume_Source_data"};
+    fs::path volPath{"vc_core_Volume_Source"};
+    fs::remove_all(dataPath);
+    fs::remove_all(volPath);
+    fs::create_directory(dataPath);
+    fs::create_directory(volPath);
+
+    auto vol = Volume::New(dataPath, "Source", "Source");
+    vol->setSliceWidth(4);
+    vol->setSliceHeight(4);
+    vol->setNumberOfSlices(2);
+    vol->saveMetadata();
+    for (int z = 0; z < 2; z++) {
+        vol->setSliceData(z, cv::Mat(4, 4, CV_16UC1, cv::Scalar(z + 1)));
+    }
+
+    // A volume with only metadata reads its slices from the source
+    Metadata meta(dataPath / "meta.json");
+    meta.set("source", "../" + dataPath.string());
+    meta.save(volPath / "meta.json");
+    auto loaded = Volume::New(volPath);
+    ASSERT_NE(loaded->getSource(), nullptr);
+    EXPECT_EQ(loaded->getSliceData(1).at<uint16_t>(2, 2), 2);
+    EXPECT_EQ(
+        loaded->getSliceRegion(0, {1, 1, 2, 2}).at<uint16_t>(1, 1), 1);
+    EXPECT_EQ(loaded->intensityAt(3, 3, 1), 2);
+
+    // Volumes with a source are read-only
+    EXPECT_THROW(
+        loaded->setSliceData(0, cv::Mat::zeros(4, 4, CV_16UC1)),
+        std::logic_error);
+
+    fs::remove_all(dataPath);
+    fs::remove_all(volPath);
+}
+
+TEST(Volume, AsyncPrefetching)
+{
+    fs::path volPath{"vc_core_Volume_AsyncPrefetching"};
+    fs::remove_all(volPath);
+    fs::create_directory(volPath);
+
+    auto vol = Volume::New(volPath, "AsyncPrefetching", "AsyncPrefetching");
+    vol->setSliceWidth(4);
+    vol->setSliceHeight(4);
+    vol->setNumberOfSlices(8);
+    vol->saveMetadata();
+    for (int z = 0; z < 8; z++) {
+        vol->setSliceData(z, cv::Mat(4, 4, CV_16UC1, cv::Scalar(z + 1)));
+    }
+
+    auto loaded = Volume::New(volPath);
+    loaded->setAsyncReader(io::AsyncReader::New(2, 2));
+    loaded->setPrefetching(4);
+    EXPECT_EQ(loaded->getSliceData(0).at<uint16_t>(0, 0), 1);
+
+    // Slices 1-4 are read in the background
+    using namespace std::chrono_literals;
+    auto deadline = std::chrono::steady_clock::now() + 10s;
+    while (loaded->getCacheSize() < 5 and
+           std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(1ms);
+    }
+    ASSERT_EQ(loaded->getCacheSize(), 5);
+    loaded->disablePrefetching();
+
+    loaded->resetCacheStats();
+    for (int z = 1; z <= 4; z++) {
+        EXPECT_EQ(loaded->getSliceData(z).at<uint16_t>(3, 3), z + 1);
+    }
+    EXPECT_EQ(loaded->cacheStats().misses, 0);
+
+    fs::remove_all(volPath);
+}
+
+TEST(Volume, Zarr)
+{
+    fs::path volPath{"vc_core_Volume_Zarr"};
+    fs::remove_all(volPath);
+    fs::create_directory(volPath);
+
+    // Uncompressed 2x3x4 (z, y, x) array in 2x2x4 chunks
+    auto vol = Volume::New(volPath, "Zarr", "Zarr");
+    vol->saveMetadata();
+    Metadata meta(volPath / "meta.json");
+    meta.set("format", "zarr");
+    meta.save();
+    std::ofstream((volPath / ".zarray").string())
+        << R"({"zarr_format": 2, "shape": [2, 3, 4], "chunks": [2, 2, 4],)"
+        << R"( "dtype": "<u2", "compressor": null, "fill_value": 0,)"
+        << R"( "order": "C", "filters": null})";
+    for (int cy = 0; cy < 2; cy++) {
+        std::vector<uint16_t> chunk(16);
+        for (int z = 0; z < 2; z++) {
+            for (int y = 0; y < 2; y++) {
+                for (int x = 0; x < 4; x++) {
+                    chunk[(z * 2 + y) * 4 + x] =
+                        z * 100 + (cy * 2 + y) * 10 + x;
+                }
+            }
+        }
+        std::ofstream(
+            (volPath / ("0.0" + std::string(cy ? ".1" : ".0"))).string(),
+            std::ios::binary)
+            .write(
+                reinterpret_cast<const char*>(chunk.data()),
+                chunk.size() * sizeof(uint16_t));
+    }
+
+    auto loaded = Volume::New(volPath);
+    EXPECT_EQ(loaded->format(), Volume::Format::Zarr);
+    EXPECT_EQ(loaded->sliceWidth(), 4);
+    EXPECT_EQ(loaded->sliceHeight(), 3);
+    EXPECT_EQ(loaded->numSlices(), 2);
+    EXPECT_EQ(loaded->blockShape(), cv::Vec3i(4, 2, 2));
+    auto slice = loaded->getSliceData(1);
+    ASSERT_EQ(slice.size(), cv::Size(4, 3));
+    EXPECT_EQ(slice.at<uint16_t>(2, 3), 123);
+    EXPECT_EQ(loaded->intensityAt(1, 1, 0), 11);
+
+    // Zarr volumes are read-only
+    EXPECT_THROW(
+        loaded->setSliceData(0, cv::Mat::zeros(3, 4, CV_16UC1)),
+        std::logic_error);
+
+    fs::remove_all(volPath);
+}
+
+TEST(Volume, Compression)
+{
+    fs::path volPath{"vc_core_Volume_Compression"};
+    fs::remove_all(volPath);
+    fs::create_directory(volPath);
+
+    auto vol = Volume::New(volPath, "Compression", "Compression");
+    EXPECT_EQ(vol->compression(), tiffio::Compression::LZW);
+    vol->setSliceWidth(8);
+    vol->setSliceHeight(8);
+    vol->setNumberOfSlices(2);
+    vol->setCompression(tiffio::Compression::ADOBE_DEFLATE);
+    vol->saveMetadata();
+    cv::Mat slice(8, 8, CV_16UC1);
+    cv::randu(slice, 0, 65535);
+    vol->setSliceData(0, slice);
+    vol->setSliceData(1, slice);
+    vol->generateLevels(1);
+
+    // The scheme is stored in the metadata and used by the levels
+    auto loaded = Volume::New(volPath);
+    EXPECT_EQ(loaded->compression(), tiffio::Compression::ADOBE_DEFLATE);
+    EXPECT_EQ(
+        loaded->level(1)->compression(), tiffio::Compression::ADOBE_DEFLATE);
+    EXPECT_TRUE(
+        volcart::testing::CvMatEqual<uint16_t>(loaded->getSliceData(1), slice));
+
+    fs::remove_all(volPath);
+}
+
+TEST(Volume, VoxelTypes)
+{
+    fs::path volPath{"vc_core_Volume_VoxelTypes"};
+    fs::remove_all(volPath);
+    fs::create_directory(volPath);
+
+    auto vol = Volume::New(volPath, "VoxelTypes", "VoxelTypes");
+    EXPECT_EQ(vol->voxelType(), Volume::VoxelType::UInt16);
+    vol->setSliceWidth(4);
+    vol->setSliceHeight(4);
+    vol->setNumberOfSlices(2);
+    vol->setVoxelType(Volume::VoxelType::UInt8);
+    vol->saveMetadata();
+    for (int z = 0; z < 2; z++) {
+        cv::Mat slice(4, 4, CV_8UC1);
+        for (int x = 0; x < 4; x++) {
+            slice.col(x).setTo(10 * z + x);
+        }
+        vol->setSliceData(z, slice);
+    }
+
+    // 8-bit voxels are cached as 8-bit slices
+    auto loaded = Volume::New(volPath);
+    EXPECT_EQ(loaded->voxelType(), Volume::VoxelType::UInt8);
+    loaded->setCacheMemoryInBytes(1024);
+    EXPECT_EQ(loaded->getSliceData(0).type(), CV_8UC1);
+    loaded->getSliceData(1);
+    EXPECT_EQ(loaded->getCacheMemoryInBytes(), 2 * 4 * 4 * sizeof(uint8_t));
+
+    // 16-bit outputs are scaled, and float outputs are not
+    EXPECT_EQ(loaded->intensityAt(3, 0, 1), 13 * 257);
+    const cv::Vec3d p{1.5, 2, 0.25};
+    EXPECT_EQ(loaded->interpolateAt(p), 4 * 257);
+    EXPECT_EQ(
+        loaded->interpolateAt(p, Volume::Interpolation::Nearest), 2 * 257);
+    float raw{0};
+    loaded->interpolateAt(&p, 1, &raw);
+    EXPECT_FLOAT_EQ(raw, 4.F);
+    std::vector<uint16_t> row(4);
+    loaded->copyLattice(
+        {0, 1, 1}, {{{0, 0, 1}, {0, 1, 0}, {1, 0, 0}}}, {1, 1, 4},
+        row.data());
+    EXPECT_EQ(row, (std::vector<uint16_t>{2570, 2827, 3084, 3341}));
+
+    // Float voxels are rounded and clamped by the 16-bit outputs
+    vol->setVoxelType(Volume::VoxelType::Float32);
+    vol->saveMetadata();
+    vol->setSliceData(0, cv::Mat(4, 4, CV_32FC1, cv::Scalar(2.25)));
+    vol->setSliceData(1, cv::Mat(4, 4, CV_32FC1, cv::Scalar(-3)));
+    loaded = Volume::New(volPath);
+    EXPECT_EQ(loaded->intensityAt(0, 0, 0), 2);
+    EXPECT_EQ(loaded->intensityAt(0, 0, 1), 0);
+    const cv::Vec3d mid{0, 0, 0.5};
+    loaded->interpolateAt(&mid, 1, &raw, Volume::Interpolation::Trilinear);
+    EXPECT_FLOAT_EQ(raw, -0.375F);
+
+    fs::remove_all(volPath);
+}
+
+TEST(Volume, ConformVoxelType)
+{
+    fs::path volPath{"vc_core_Volume_ConformVoxelType"};
+    fs::remove_all(volPath);
+    fs::create_directory(volPath);
+
+    // 8-bit slices of a 16-bit volume are read as 16-bit slices
+    auto vol = Volume::New(volPath, "Conform", "Conform");
+    vol->setSliceWidth(2);
+    vol->setSliceHeight(2);
+    vol->setNumberOfSlices(1);
+    vol->saveMetadata();
+    vol->setSliceData(0, cv::Mat(2, 2, CV_8UC1, cv::Scalar(255)));
+
+    auto loaded = Volume::New(volPath);
+    auto slice = loaded->getSliceData(0);
+    EXPECT_EQ(slice.type(), CV_16UC1);
+    EXPECT_EQ(slice.at<uint16_t>(1, 1), 65535);
+    EXPECT_EQ(loaded->intensityAt(0, 0, 0), 65535);
+
+    fs::remove_all(volPath);
+}
+
+TEST(Volume, SliceView)
+{
+    fs::path volPath{"vc_core_Volume_SliceView"};
+    fs::remove_all(volPath);
+    fs::create_directory(volPath);
+
+    auto vol = Volume::New(volPath, "SliceView", "SliceView");
+    vol->setSliceWidth(4);
+    vol->setSliceHeight(4);
+    vol->setNumberOfSlices(3);
+    vol->saveMetadata();
+    for (int z = 0; z < 3; z++) {
+        vol->setSliceData(z, cv::Mat(4, 4, CV_16UC1, cv::Scalar(z)));
+    }
+
+    // The view shares the cached slice
+    auto loaded = Volume::New(volPath);
+    loaded->setCache(Volume::DefaultCache::New(1));
+    auto view = loaded->getSliceView(1);
+    EXPECT_EQ(view.mat().data, loaded->getSliceData(1).data);
+    EXPECT_NE(view.clone().data, view.mat().data);
+
+    // The view keeps the slice valid after it is evicted
+    loaded->getSliceData(2);
+    const cv::Mat& slice = view;
+    EXPECT_EQ(slice.at<uint16_t>(3, 3), 1);
+}
+
+TEST(Volume, SliceRegion)
+{
+    fs::path volPath{"vc_core_Volume_SliceRegion"};
+    fs::remove_all(volPath);
+    fs::create_directory(volPath);
+
+    constexpr int WIDTH = 40;
+    constexpr int HEIGHT = 30;
+    auto vol = Volume::New(volPath, "SliceRegion", "SliceRegion");
+    vol->setSliceWidth(WIDTH);
+    vol->setSliceHeight(HEIGHT);
+    vol->setNumberOfSlices(3);
+    vol->saveMetadata();
+
+    // Write slices with many strips
+    std::vector<cv::Mat> slices;
+    for (int z = 0; z < 3; z++) {
+        cv::Mat slice(HEIGHT, WIDTH, CV_16UC1);
+        for (int y = 0; y < HEIGHT; y++) {
+            for (int x = 0; x < WIDTH; x++) {
+                slice.at<uint16_t>(y, x) = x + WIDTH * y + 2000 * z;
+            }
+        }
+        tiffio::WriteTIFF(
+            vol->getSlicePath(z), slice, tiffio::Compression::LZW, 4);
+        slices.push_back(slice);
+    }
+
+    auto loaded = Volume::New(volPath);
+    loaded->setCacheSlices(false);
+    for (size_t threads : {1, 3, 0}) {
+        loaded->setSliceDecodeThreads(threads);
+
+        // Whole slices
+        auto slice = loaded->getSliceData(1);
+        EXPECT_TRUE(volcart::testing::CvMatEqual<uint16_t>(slice, slices[1]));
+
+        // Regions which start and end inside of a strip
+        cv::Rect roi(33, 6, 7, 13);
+        auto region = loaded->getSliceRegion(2, roi);
+        ASSERT_EQ(region.size(), roi.size());
+        EXPECT_TRUE(
+            volcart::testing::CvMatEqual<uint16_t>(region, slices[2](roi)));
+    }
+    EXPECT_THROW(loaded->getSliceRegion(3, {0, 0, 1, 1}), std::out_of_range);
+
+    // Batch interpolation near an edge only decodes a region of each slice
+    std::vector<cv::Vec3d> pts;
+    cv::RNG rng(42);
+    for (int i = 0; i < 100; i++) {
+        pts.emplace_back(
+            rng.uniform(35., 40.), rng.uniform(0., 5.), rng.uniform(0., 3.));
+    }
+    loaded->resetCacheStats();
+    auto batch = loaded->interpolateAt(pts);
+    EXPECT_LT(
+        loaded->cacheStats().bytesRead, WIDTH * HEIGHT * sizeof(uint16_t));
+    for (size_t i = 0; i < pts.size(); i++) {
+        EXPECT_EQ(batch[i], loaded->interpolateAt(pts[i]));
+    }
+}
+
+TEST(Volume, AsyncWrites)
+{
+    fs::path volPath{"vc_core_Volume_AsyncWrites"};
+    fs::remove_all(volPath);
+    fs::create_directory(volPath);
+
+    auto vol = Volume::New(volPath, "AsyncWrites", "AsyncWrites");
+    vol->setSliceWidth(8);
+    vol->setSliceHeight(6);
+    vol->setNumberOfSlices(10);
+    vol->saveMetadata();
+
+    // Room for less than one slice, so every write waits for the last
+    vol->setAsyncWrites(1, 2);
+    EXPECT_TRUE(vol->asyncWritesEnabled());
+    cv::Mat slice(6, 8, CV_16UC1);
+    for (int z = 0; z < 10; z++) {
+        // The queued slice is a copy, so the buffer can be reused
+        slice.setTo(z);
+        vol->setSliceData(z, slice);
+    }
+    vol->flushSliceWrites();
+
+    auto loaded = Volume::New(volPath);
+    for (int z = 0; z < 10; z++) {
+        auto s = loaded->getSliceData(z);
+        ASSERT_EQ(s.size(), slice.size());
+        EXPECT_EQ(s.at<uint16_t>(5, 7), z);
+    }
+
+    vol->disableAsyncWrites();
+    EXPECT_FALSE(vol->asyncWritesEnabled());
+}
+
+TEST(Volume, AsyncWriteErrors)
+{
+    fs::path volPath{"vc_core_Volume_AsyncWriteErrors"};
+    fs::remove_all(volPath);
+    fs::create_directory(volPath);
+
+    auto vol = Volume::New(volPath, "AsyncWriteErrors", "AsyncWriteErrors");
+    vol->setSliceWidth(8);
+    vol->setSliceHeight(8);
+    vol->setNumberOfSlices(8);
+    vol->setFormat(Volume::Format::Blocks, 4);
+    vol->saveMetadata();
+
+    // Errors are reported by flushSliceWrites()
+    vol->setAsyncWrites();
+    EXPECT_NO_THROW(vol->setSliceData(0, cv::Mat(2, 2, CV_16UC1)));
+    EXPECT_THROW(vol->flushSliceWrites(), std::invalid_argument);
+    EXPECT_NO_THROW(vol->flushSliceWrites());
+
+    // ...or by the next call to setSliceData(). With room for a single
+    // slice, the second call waits for the failed write.
+    vol->setAsyncWrites(1);
+    cv::Mat slice(8, 8, CV_16UC1, cv::Scalar(1));
+    EXPECT_NO_THROW(vol->setSliceData(8, slice));
+    EXPECT_THROW(vol->setSliceData(0, slice), std::out_of_range);
+    EXPECT_NO_THROW(vol->disableAsyncWrites());
+}
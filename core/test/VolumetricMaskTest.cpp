@@ -0,0 +1,160 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <set>
+
+#include "vc/core/io/VolumetricMaskIO.hpp"
+#include "vc/core/types/Exceptions.hpp"
+#include "vc/core/types/VolumetricMask.hpp"
+
+using namespace volcart;
+
+using Voxel = VolumetricMask::Voxel;
+
+namespace
+{
+// Comparable key for voxel sets
+auto Key(const Voxel& v) { return std::make_tuple(v[0], v[1], v[2]); }
+
+auto ToSet(const VolumetricMask& mask)
+{
+    std::set<std::tuple<int, int, int>> s;
+    for (const auto& v : mask) {
+        s.insert(Key(v));
+    }
+    return s;
+}
+
+auto TestVoxels() -> std::vector<Voxel>
+{
+    // Spans multiple blocks, including negative block coordinates
+    return {{0, 0, 0},   {1, 2, 3},     {15, 15, 15}, {16, 0, 0},
+            {-1, -1, -1}, {-16, 5, -17}, {100, 200, 300}};
+}
+}  // namespace
+
+TEST(VolumetricMask, SetAndQuery)
+{
+    VolumetricMask mask;
+    EXPECT_TRUE(mask.empty());
+
+    auto voxels = TestVoxels();
+    mask.setIn(voxels);
+    EXPECT_FALSE(mask.empty());
+    EXPECT_EQ(mask.size(), voxels.size());
+    for (const auto& v : voxels) {
+        EXPECT_TRUE(mask.isIn(v));
+        EXPECT_FALSE(mask.isOut(v));
+    }
+
+    // Neighbors are not in the mask
+    EXPECT_TRUE(mask.isOut(Voxel{2, 2, 3}));
+    EXPECT_TRUE(mask.isOut(Voxel{-2, -1, -1}));
+    EXPECT_TRUE(mask.isOut(Voxel{1000, 0, 0}));
+
+    // Sub-voxel queries floor to the containing voxel
+    EXPECT_TRUE(mask.isIn(cv::Vec3d{1.9, 2.1, 3.5}));
+    EXPECT_TRUE(mask.isIn(cv::Vec3d{-0.5, -0.1, -0.9}));
+    EXPECT_TRUE(mask.isOut(cv::Vec3d{-1.5, -0.1, -0.9}));
+
+    // Repeated inserts don't change the size
+    mask.setIn(voxels[0]);
+    EXPECT_EQ(mask.size(), voxels.size());
+}
+
+TEST(VolumetricMask, SetOutReleasesBlocks)
+{
+    VolumetricMask mask(TestVoxels());
+    auto blocks = mask.numBlocks();
+
+    mask.setOut(Voxel{100, 200, 300});
+    EXPECT_TRUE(mask.isOut(Voxel{100, 200, 300}));
+    EXPECT_EQ(mask.size(), TestVoxels().size() - 1);
+    EXPECT_EQ(mask.numBlocks(), blocks - 1);
+
+    // Removing a missing voxel is a no-op
+    mask.setOut(Voxel{100, 200, 300});
+    EXPECT_EQ(mask.size(), TestVoxels().size() - 1);
+
+    mask.setOut(TestVoxels());
+    EXPECT_TRUE(mask.empty());
+    EXPECT_EQ(mask.numBlocks(), 0);
+}
+
+TEST(VolumetricMask, Iteration)
+{
+    auto voxels = TestVoxels();
+    VolumetricMask mask(voxels);
+
+    std::set<std::tuple<int, int, int>> expected;
+    for (const auto& v : voxels) {
+        expected.insert(Key(v));
+    }
+    EXPECT_EQ(ToSet(mask), expected);
+    EXPECT_EQ(mask.as_vector().size(), voxels.size());
+    EXPECT_EQ(std::distance(mask.begin(), mask.end()), voxels.size());
+
+    // Empty masks have no elements
+    VolumetricMask empty;
+    EXPECT_EQ(empty.begin(), empty.end());
+}
+
+TEST(VolumetricMask, SetInFromSlice)
+{
+    cv::Mat slice = cv::Mat::zeros(20, 40, CV_8UC1);
+    slice.at<uint8_t>(0, 0) = 255;
+    slice.at<uint8_t>(10, 30) = 1;
+    slice.at<uint8_t>(19, 39) = 255;
+
+    VolumetricMask mask;
+    mask.setIn(slice, 7);
+    EXPECT_EQ(mask.size(), 3);
+    EXPECT_TRUE(mask.isIn(Voxel{0, 0, 7}));
+    EXPECT_TRUE(mask.isIn(Voxel{30, 10, 7}));
+    EXPECT_TRUE(mask.isIn(Voxel{39, 19, 7}));
+    EXPECT_TRUE(mask.isOut(Voxel{0, 0, 6}));
+}
+
+TEST(VolumetricMask, Merge)
+{
+    auto voxels = TestVoxels();
+    std::vector<Voxel> a(voxels.begin(), voxels.begin() + 4);
+    std::vector<Voxel> b(voxels.begin() + 2, voxels.end());
+
+    VolumetricMask mask(a);
+    mask.merge(VolumetricMask(b));
+    EXPECT_EQ(mask.size(), voxels.size());
+    EXPECT_EQ(ToSet(mask), ToSet(VolumetricMask(voxels)));
+
+    // Merging is idempotent
+    mask.merge(VolumetricMask(b));
+    EXPECT_EQ(mask.size(), voxels.size());
+    mask.merge(VolumetricMask());
+    EXPECT_EQ(mask.size(), voxels.size());
+}
+
+TEST(VolumetricMask, WriteThenRead)
+{
+    VolumetricMask mask(TestVoxels());
+    // Fill a dense block
+    for (int z = 32; z < 48; z++) {
+        for (int y = 32; y < 48; y++) {
+            for (int x = 32; x < 48; x++) {
+                mask.setIn({x, y, z});
+            }
+        }
+    }
+
+    io::WriteVolumetricMask("vc_core_VolumetricMask.vcvm", mask);
+    auto read = io::ReadVolumetricMask("vc_core_VolumetricMask.vcvm");
+    EXPECT_EQ(read.size(), mask.size());
+    EXPECT_EQ(read.numBlocks(), mask.numBlocks());
+    EXPECT_EQ(ToSet(read), ToSet(mask));
+}
+
+TEST(VolumetricMask, ReadMissingFile)
+{
+    EXPECT_THROW(
+        io::ReadVolumetricMask("vc_core_VolumetricMask_missing.vcvm"),
+        IOException);
+}
@@ -0,0 +1,248 @@
+#include <cstdint>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "vc/core/filesystem.hpp"
+#include "vc/core/io/ZarrArray.hpp"
+#include "vc/core/io/ZarrWriter.hpp"
+#include "vc/core/types/Exceptions.hpp"
+
+using namespace volcart;
+using namespace volcart::io;
+namespace fs = volcart::filesystem;
+
+namespace
+{
+void WriteFile(const fs::path& path, const std::string& data)
+{
+    fs::create_directories(path.parent_path());
+    std::ofstream(path.string(), std::ios::binary) << data;
+}
+
+// Samples of a chunk as bytes in the given byte order
+auto Samples(const std::vector<std::uint16_t>& values, bool bigEndian)
+    -> std::string
+{
+    std::string bytes;
+    for (auto v : values) {
+        auto lo = static_cast<char>(v & 0xFF);
+        auto hi = static_cast<char>(v >> 8);
+        if (bigEndian) {
+            bytes += {hi, lo};
+        } else {
+            bytes += {lo, hi};
+        }
+    }
+    return bytes;
+}
+
+// An N5 default block header for a block of size (x, y, z)
+auto N5Header(std::uint32_t x, std::uint32_t y, std::uint32_t z)
+    -> std::string
+{
+    std::string header{0, 0, 0, 3};
+    for (auto d : {x, y, z}) {
+        header += {
+            static_cast<char>(d >> 24), static_cast<char>(d >> 16),
+            static_cast<char>(d >> 8), static_cast<char>(d)};
+    }
+    return header;
+}
+}  // namespace
+
+class ZarrArray_Dir : public ::testing::Test
+{
+public:
+    ZarrArray_Dir()
+    {
+        fs::remove_all(dir);
+        fs::create_directories(dir);
+        source = LocalVolumeSource::New(dir);
+    }
+
+    ~ZarrArray_Dir() override { fs::remove_all(dir); }
+
+    fs::path dir{"vc_core_ZarrArray"};
+    VolumeSource::Pointer source;
+};
+
+TEST_F(ZarrArray_Dir, Zarr)
+{
+    // A 2x3x4 (z, y, x) array in 2x2x4 chunks with a missing chunk
+    WriteFile(
+        dir / "0" / ".zarray",
+        R"({"zarr_format": 2, "shape": [2, 3, 4], "chunks": [2, 2, 4],)"
+        R"( "dtype": "<u2", "compressor": null, "fill_value": 7,)"
+        R"( "order": "C", "filters": null})");
+    std::vector<std::uint16_t> values(16);
+    for (std::size_t i = 0; i < values.size(); i++) {
+        values[i] = static_cast<std::uint16_t>(i + 1000);
+    }
+    WriteFile(dir / "0" / "0.0.0", Samples(values, false));
+
+    ZarrArray array(source, "0");
+    EXPECT_EQ(array.layout(), ZarrArray::Layout::Zarr);
+    EXPECT_EQ(array.shape(), cv::Vec3i(4, 3, 2));
+    EXPECT_EQ(array.chunkShape(), cv::Vec3i(4, 2, 2));
+    EXPECT_EQ(array.chunkGridSize(), cv::Vec3i(1, 2, 1));
+    EXPECT_EQ(array.chunkName(0, 1, 0), "0/0.1.0");
+
+    auto chunk = array.readChunk(0, 0, 0);
+    ASSERT_EQ(chunk.type(), CV_16UC1);
+    ASSERT_EQ(chunk.size(), cv::Size(4, 4));
+    // Row z * 2 + y, column x
+    EXPECT_EQ(chunk.at<std::uint16_t>(0, 0), 1000);
+    EXPECT_EQ(chunk.at<std::uint16_t>(1, 3), 1007);
+    EXPECT_EQ(chunk.at<std::uint16_t>(3, 2), 1014);
+
+    auto missing = array.readChunk(0, 1, 0);
+    EXPECT_EQ(missing.at<std::uint16_t>(0, 0), 7);
+    EXPECT_EQ(missing.at<std::uint16_t>(3, 3), 7);
+}
+
+TEST_F(ZarrArray_Dir, ZarrLeadingDims)
+{
+    // OME-Zarr TCZYX array with "/" separators and 8-bit samples
+    WriteFile(
+        dir / ".zarray",
+        R"({"zarr_format": 2, "shape": [1, 1, 1, 2, 2],)"
+        R"( "chunks": [1, 1, 1, 2, 2], "dtype": "|u1", "compressor": null,)"
+        R"( "dimension_separator": "/", "order": "C"})");
+    WriteFile(dir / "0" / "0" / "0" / "0" / "0", std::string{0, 1, 2, '\xFF'});
+
+    ZarrArray array(source, "");
+    EXPECT_EQ(array.shape(), cv::Vec3i(2, 2, 1));
+    EXPECT_EQ(array.chunkName(0, 0, 0), "0/0/0/0/0");
+    auto chunk = array.readChunk(0, 0, 0);
+    EXPECT_EQ(chunk.at<std::uint16_t>(0, 0), 0);
+    EXPECT_EQ(chunk.at<std::uint16_t>(1, 1), 65535);
+}
+
+TEST_F(ZarrArray_Dir, Zarr8BitFillValue)
+{
+    // A 2x2x2 array of 8-bit samples in 1x2x2 chunks with a missing chunk
+    WriteFile(
+        dir / "0" / ".zarray",
+        R"({"zarr_format": 2, "shape": [2, 2, 2], "chunks": [1, 2, 2],)"
+        R"( "dtype": "|u1", "compressor": null, "fill_value": 255,)"
+        R"( "order": "C", "filters": null})");
+    WriteFile(dir / "0" / "0.0.0", std::string{0, 1, 2, '\xFF'});
+
+    // Missing chunks match stored samples with the fill value
+    ZarrArray array(source, "0");
+    auto chunk = array.readChunk(0, 0, 0);
+    EXPECT_EQ(chunk.at<std::uint16_t>(1, 1), 65535);
+    auto missing = array.readChunk(0, 0, 1);
+    EXPECT_EQ(missing.at<std::uint16_t>(0, 0), 65535);
+    EXPECT_EQ(missing.at<std::uint16_t>(1, 1), 65535);
+}
+
+TEST_F(ZarrArray_Dir, N5)
+{
+    // A 3x2x1 (x, y, z) array in 2x2x1 blocks. The edge block is smaller.
+    WriteFile(
+        dir / "s0" / "attributes.json",
+        R"({"dimensions": [3, 2, 1], "blockSize": [2, 2, 1],)"
+        R"( "dataType": "uint16", "compression": {"type": "raw"}})");
+    WriteFile(
+        dir / "s0" / "0" / "0" / "0",
+        N5Header(2, 2, 1) + Samples({1, 2, 3, 4}, true));
+    WriteFile(
+        dir / "s0" / "1" / "0" / "0",
+        N5Header(1, 2, 1) + Samples({5, 6}, true));
+
+    ZarrArray array(source, "s0");
+    EXPECT_EQ(array.layout(), ZarrArray::Layout::N5);
+    EXPECT_EQ(array.shape(), cv::Vec3i(3, 2, 1));
+    EXPECT_EQ(array.chunkGridSize(), cv::Vec3i(2, 1, 1));
+    EXPECT_EQ(array.chunkName(1, 0, 0), "s0/1/0/0");
+
+    auto chunk = array.readChunk(0, 0, 0);
+    EXPECT_EQ(chunk.at<std::uint16_t>(0, 1), 2);
+    EXPECT_EQ(chunk.at<std::uint16_t>(1, 0), 3);
+
+    auto edge = array.readChunk(1, 0, 0);
+    ASSERT_EQ(edge.size(), cv::Size(2, 2));
+    EXPECT_EQ(edge.at<std::uint16_t>(0, 0), 5);
+    EXPECT_EQ(edge.at<std::uint16_t>(1, 0), 6);
+    EXPECT_EQ(edge.at<std::uint16_t>(1, 1), 0);
+}
+
+TEST_F(ZarrArray_Dir, MultiscaleArrays)
+{
+    EXPECT_EQ(
+        ZarrArray::MultiscaleArrays(*source, "vol"),
+        std::vector<std::string>{"vol"});
+
+    WriteFile(
+        dir / "vol" / ".zattrs",
+        R"({"multiscales": [{"datasets": [{"path": "0"}, {"path": "1"}]}]})");
+    EXPECT_EQ(
+        ZarrArray::MultiscaleArrays(*source, "vol"),
+        (std::vector<std::string>{"vol/0", "vol/1"}));
+
+    WriteFile(
+        dir / "n5" / "attributes.json",
+        R"({"scales": [[1, 1, 1], [2, 2, 2], [4, 4, 4]]})");
+    EXPECT_EQ(
+        ZarrArray::MultiscaleArrays(*source, "n5"),
+        (std::vector<std::string>{"n5/s0", "n5/s1", "n5/s2"}));
+}
+
+TEST_F(ZarrArray_Dir, Unsupported)
+{
+    EXPECT_THROW(ZarrArray(source, "none"), IOException);
+
+    WriteFile(
+        dir / "f" / ".zarray",
+        R"({"zarr_format": 2, "shape": [2, 2, 2], "chunks": [2, 2, 2],)"
+        R"( "dtype": "<f4", "compressor": null, "order": "C"})");
+    EXPECT_THROW(ZarrArray(source, "f"), IOException);
+}
+
+TEST_F(ZarrArray_Dir, WriterRoundTrip)
+{
+    // A 5x3x2 (x, y, z) array in 4x2x2 chunks with partial edge chunks
+    for (auto c : {ZarrArray::Compressor::None, ZarrArray::Compressor::Zlib}) {
+        fs::remove_all(dir / "w");
+        ZarrWriter writer(dir / "w", {5, 3, 2}, {4, 2, 2}, c);
+        EXPECT_EQ(writer.chunkGridSize(), cv::Vec3i(2, 2, 1));
+
+        cv::Mat chunk(4, 4, CV_16UC1);
+        for (int i = 0; i < 16; i++) {
+            chunk.at<std::uint16_t>(i / 4, i % 4) =
+                static_cast<std::uint16_t>(i + 2000);
+        }
+        writer.writeChunk(0, 0, 0, chunk);
+        writer.writeChunk(1, 1, 0, chunk);
+
+        ZarrArray array(source, "w");
+        EXPECT_EQ(array.shape(), cv::Vec3i(5, 3, 2));
+        EXPECT_EQ(array.chunkShape(), cv::Vec3i(4, 2, 2));
+        auto read = array.readChunk(1, 1, 0);
+        EXPECT_EQ(cv::countNonZero(read != chunk), 0);
+        auto missing = array.readChunk(0, 1, 0);
+        EXPECT_EQ(cv::countNonZero(missing), 0);
+    }
+}
+
+TEST_F(ZarrArray_Dir, WriterInvalid)
+{
+    EXPECT_THROW(
+        ZarrWriter(dir / "w", {0, 1, 1}, {1, 1, 1}), std::invalid_argument);
+    EXPECT_THROW(
+        ZarrWriter(
+            dir / "w", {1, 1, 1}, {1, 1, 1}, ZarrArray::Compressor::Blosc),
+        std::invalid_argument);
+
+    ZarrWriter writer(dir / "w", {4, 4, 4}, {2, 2, 2});
+    cv::Mat chunk(4, 2, CV_16UC1, cv::Scalar(1));
+    EXPECT_THROW(writer.writeChunk(2, 0, 0, chunk), std::invalid_argument);
+    EXPECT_THROW(
+        writer.writeChunk(0, 0, 0, cv::Mat(2, 2, CV_16UC1)),
+        std::invalid_argument);
+}
@@ -3,7 +3,10 @@
 /** @file */
 
 #include "vc/graph/core.hpp"
+#include "vc/graph/memoization.hpp"
 #include "vc/graph/meshing.hpp"
+#include "vc/graph/profiling.hpp"
+#include "vc/graph/scheduling.hpp"
 #include "vc/graph/texturing.hpp"
 
 namespace volcart
@@ -14,6 +14,8 @@
 #include "vc/core/types/Volume.hpp"
 #include "vc/core/types/VolumePkg.hpp"
 #include "vc/core/types/VolumetricMask.hpp"
+#include "vc/core/util/MemoryUsage.hpp"
+#include "vc/graph/memoization.hpp"
 
 namespace volcart
 {
@@ -254,6 +256,8 @@ private:
     bool cacheArgs_{false};
     /** Loaded file(s) */
     MeshReaderResult loaded_{};
+    /** Memory held by the loaded mesh */
+    memory::TrackedBytes meshMemory_{MemoryCategory::Mesh};
 
 public:
     /** @brief Input path */
@@ -300,8 +304,17 @@ private:
     cv::Mat texture_{};
     /** Include the saved file in the graph cache */
     bool cacheArgs_{false};
+    /** PLY body encoding */
+    io::PLYWriter::Format plyFormat_{io::PLYWriter::Format::ASCII};
+    /** PLY vertex precision */
+    io::PLYWriter::Precision plyPrecision_{io::PLYWriter::Precision::Float32};
 
 public:
+    /** @copydoc io::PLYWriter::Format */
+    using PLYFormat = io::PLYWriter::Format;
+    /** @copydoc io::PLYWriter::Precision */
+    using PLYPrecision = io::PLYWriter::Precision;
+
     /** @brief Output file */
     smgl::InputPort<filesystem::path> path;
     /** @brief Mesh */
@@ -312,6 +325,10 @@ public:
     smgl::InputPort<cv::Mat> texture;
     /** @brief Include the saved file in the graph cache */
     smgl::InputPort<bool> cacheArgs;
+    /** @brief PLY body encoding. Ignored for other file types. */
+    smgl::InputPort<PLYFormat> plyFormat;
+    /** @brief PLY vertex precision. Ignored for other file types. */
+    smgl::InputPort<PLYPrecision> plyPrecision;
 
     /** Constructor */
     WriteMeshNode();
@@ -344,7 +361,7 @@ private:
     /** Rotation angle (degrees) */
     double theta_{0};
     /** Output UVMap */
-    UVMap::Pointer uvMapOut_;
+    LazyValue<UVMap::Pointer> uvMapOut_;
 
 public:
     /** @brief Input UVMap */
@@ -382,7 +399,7 @@ private:
     /** Flip axis */
     UVMap::FlipAxis axis_{UVMap::FlipAxis::Vertical};
     /** Output UVMap */
-    UVMap::Pointer uvMapOut_;
+    LazyValue<UVMap::Pointer> uvMapOut_;
 
 public:
     /** @copydoc UVMap::FlipAxis */
@@ -421,7 +438,7 @@ private:
     /** Input mesh */
     ITKMesh::Pointer uvMesh_;
     /** Output image */
-    cv::Mat plot_;
+    LazyValue<cv::Mat> plot_;
 
 public:
     /** @brief Input UVMap */
@@ -520,6 +537,49 @@ private:
         const filesystem::path& /*cacheDir*/) override;
 };
 
+/**
+ * @brief Write a list of images, such as the outputs of MultiTextureNode
+ *
+ * Image `i` is written to `<stem>_<i><extension>` next to `path`, with `i`
+ * zero-padded to the same width for every image. The images are encoded in
+ * parallel by an AsyncImageWriter. Attach the node to an AsyncNodeExecutor
+ * to write them while the rest of the graph continues.
+ *
+ * @see AsyncImageWriter
+ * @ingroup Graph
+ */
+class WriteImagesNode : public smgl::Node
+{
+private:
+    /** File path */
+    filesystem::path path_{};
+    /** Images */
+    std::vector<cv::Mat> images_{};
+    /** Number of writer threads */
+    std::size_t numThreads_{0};
+
+public:
+    /** @brief Output file path, to which the image index is appended */
+    smgl::InputPort<filesystem::path> path;
+    /** @brief Output images */
+    smgl::InputPort<std::vector<cv::Mat>> images;
+    /** @brief Number of writer threads. If 0, uses all hardware threads. */
+    smgl::InputPort<std::size_t> numThreads;
+
+    /** Constructor */
+    WriteImagesNode();
+
+private:
+    /** Smeagol custom serialization */
+    auto serialize_(bool useCache, const filesystem::path& cacheDir)
+        -> smgl::Metadata override;
+
+    /** Smeagol custom deserialization */
+    void deserialize_(
+        const smgl::Metadata& meta,
+        const filesystem::path& /*cacheDir*/) override;
+};
+
 /**
  * @copybrief PerPixelMap::ReadPPM()
  *
@@ -623,9 +683,10 @@ public:
 };
 
 /**
- * @brief Load a VolumetricMask from a .vcps file
+ * @brief Load a VolumetricMask from a .vcvm or .vcps file
  *
- * Given file must be of type=int, dim=3.
+ * Files with the .vcvm extension are read with io::ReadVolumetricMask().
+ * Otherwise, the file is read as a PointSet and must be of type=int, dim=3.
  *
  * @ingroup Graph
  */
@@ -637,7 +698,7 @@ private:
     /** Include the loaded file in the graph cache */
     bool cacheArgs_{false};
     /** Loaded VolumetricMask */
-    VolumetricMask::Pointer mask_{};
+    LazyValue<VolumetricMask::Pointer> mask_;
 
 public:
     /** @brief Input path */
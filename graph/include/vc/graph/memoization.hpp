@@ -0,0 +1,360 @@
+#pragma once
+
+/** @file */
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "vc/core/filesystem.hpp"
+#include "vc/core/types/ITKMesh.hpp"
+#include "vc/core/types/OrderedPointSet.hpp"
+#include "vc/core/types/UVMap.hpp"
+
+namespace volcart
+{
+
+/**
+ * @brief Incremental 64-bit content hash
+ *
+ * Computes the FNV-1a hash of a sequence of values. Container types are
+ * hashed by their size and contents, so that the hash of a node's inputs
+ * changes whenever the data changes, regardless of which object holds it.
+ *
+ * @ingroup Graph
+ */
+class ContentHash
+{
+public:
+    /** @brief Add raw bytes to the hash */
+    auto update(const void* data, std::size_t size) -> ContentHash&;
+
+    /** @brief Add an arithmetic or enum value to the hash */
+    template <typename T>
+    auto update(const T& v) -> std::enable_if_t<
+        std::is_arithmetic_v<T> or std::is_enum_v<T>,
+        ContentHash&>
+    {
+        return update(&v, sizeof(T));
+    }
+
+    /** @brief Add a string to the hash */
+    auto update(const std::string& s) -> ContentHash&;
+
+    /** @brief Add a mesh's points, normals, and faces to the hash */
+    auto update(const ITKMesh::Pointer& mesh) -> ContentHash&;
+
+    /** @brief Add a UV map's coordinates, origin, and ratio to the hash */
+    auto update(const UVMap::Pointer& uvMap) -> ContentHash&;
+
+    /** @brief Add an ordered point set to the hash */
+    auto update(const OrderedPointSet<cv::Vec3d>& ps) -> ContentHash&;
+
+    /** @brief Get the hash value */
+    [[nodiscard]] auto value() const -> std::uint64_t;
+
+    /** @brief Get the hash value as a hexadecimal string */
+    [[nodiscard]] auto hex() const -> std::string;
+
+private:
+    /** Current hash state */
+    std::uint64_t state_{14695981039346656037ULL};
+};
+
+/**
+ * @brief Persistent store of graph node outputs, keyed by content hash
+ *
+ * Nodes write their outputs as files into a temporary directory. When the
+ * entry is stored, every file is split into CHUNK_SIZE chunks, and each chunk
+ * is compressed and stored under `chunks/` by the hash of its contents.
+ * Chunks are shared between entries, so outputs which are mostly identical
+ * between renders, e.g. the PPMs of overlapping tiles or the meshes of
+ * repeated renders, are only stored once. The entry itself is a small
+ * manifest file (`<key>.vcno`) which lists the chunks of each file. Chunks
+ * and manifests are written to temporary files and moved into place once
+ * complete, so an interrupted or concurrent render never leaves a partial
+ * entry behind.
+ *
+ * The cache is limited to capacity() bytes on disk. After every store, the
+ * least recently used entries are removed until the cache fits in 90% of
+ * its capacity, and chunks which are no longer used by any entry are
+ * deleted. Entries in the directory-per-entry layout of earlier releases are
+ * still loaded and are removed by the same policy.
+ *
+ * All member functions are safe to call concurrently, including from
+ * different processes which share the cache root.
+ *
+ * @ingroup Graph
+ */
+class NodeOutputCache
+{
+public:
+    /** Pointer type */
+    using Pointer = std::shared_ptr<NodeOutputCache>;
+
+    /** Callback which reads or writes a node's outputs in a directory */
+    using IOFunction = std::function<void(const filesystem::path&)>;
+
+    /** Default capacity: 64 GiB */
+    static constexpr std::size_t DEFAULT_CAPACITY_BYTES{64ULL << 30};
+
+    /** Size of the chunks files are split into: 4 MiB */
+    static constexpr std::size_t CHUNK_SIZE{4ULL << 20};
+
+    /** @brief Summary of a cache entry */
+    struct Entry {
+        /** Entry key */
+        std::string key;
+        /** Number of files in the entry */
+        std::size_t files{0};
+        /** Uncompressed size of the entry's files in bytes */
+        std::size_t bytes{0};
+        /** Last time the entry was stored or loaded, in ns since the epoch */
+        std::int64_t lastUsed{0};
+    };
+
+    /** @brief Constructor */
+    explicit NodeOutputCache(
+        filesystem::path root, std::size_t capacity = DEFAULT_CAPACITY_BYTES);
+
+    /** @copydoc NodeOutputCache(filesystem::path, std::size_t) */
+    static auto New(
+        filesystem::path root, std::size_t capacity = DEFAULT_CAPACITY_BYTES)
+        -> Pointer;
+
+    /** @brief Get the cache root directory */
+    [[nodiscard]] auto root() const -> filesystem::path;
+
+    /**
+     * @brief Set the maximum size of the cache in bytes
+     *
+     * If the cache is larger than the new capacity, it is trimmed
+     * immediately.
+     */
+    void setCapacity(std::size_t capacity);
+
+    /** @brief Get the maximum size of the cache in bytes */
+    [[nodiscard]] auto capacity() const -> std::size_t;
+
+    /** @brief Get the size of the cache on disk in bytes */
+    [[nodiscard]] auto bytes() const -> std::size_t;
+
+    /** @brief List the entries in the cache */
+    [[nodiscard]] auto entries() const -> std::vector<Entry>;
+
+    /**
+     * @brief Load the entry for a key
+     *
+     * Calls `reader` with a directory which contains the entry's files. The
+     * directory is removed once `reader` returns. If the entry does not exist,
+     * is damaged, or `reader` throws, the entry is removed and false is
+     * returned.
+     */
+    auto load(const std::string& key, const IOFunction& reader) -> bool;
+
+    /**
+     * @brief Store the entry for a key
+     *
+     * Calls `writer` with an empty directory into which the outputs should be
+     * written. Replaces any existing entry for the key, then trims the cache
+     * to its capacity.
+     */
+    void store(const std::string& key, const IOFunction& writer);
+
+    /**
+     * @brief Remove the entry for a key
+     *
+     * Chunks which are no longer used are deleted by the next trim().
+     */
+    void remove(const std::string& key);
+
+    /** @brief Trim the cache to its capacity */
+    void trim();
+
+    /**
+     * @brief Trim the cache to `target` bytes
+     *
+     * Removes the least recently used entries until the cache is no larger
+     * than `target`, then deletes the chunks and temporary files which are
+     * no longer used. Chunks are not deleted while the cache contains a
+     * manifest which cannot be read, since its chunks are unknown.
+     */
+    void trimTo(std::size_t target);
+
+    /** @brief Remove every entry and chunk from the cache */
+    void purge();
+
+private:
+    /** Cache root directory */
+    filesystem::path root_;
+    /** Maximum size in bytes */
+    std::atomic<std::size_t> capacity_;
+    /** Serializes trims within this process */
+    mutable std::mutex mutex_;
+
+    /** Get the path of a key's manifest */
+    [[nodiscard]] auto entry_path_(const std::string& key) const
+        -> filesystem::path;
+};
+
+/**
+ * @brief Mixin for graph nodes whose outputs can be reused between renders
+ *
+ * A node which derives from this class computes through memoize_(). If an
+ * output cache has been assigned with setOutputCache(), the node's outputs
+ * are keyed by a hash of its type, parameters, and input data. When the key
+ * is already in the cache, the outputs are loaded instead of recomputed.
+ * Otherwise, the outputs are computed and added to the cache.
+ *
+ * @ingroup Graph
+ */
+class MemoizedNode
+{
+public:
+    /** @brief Default destructor */
+    virtual ~MemoizedNode() = default;
+
+    /** @brief Set the cache used to store this node's outputs */
+    void setOutputCache(NodeOutputCache::Pointer cache);
+
+    /** @brief Get the cache used to store this node's outputs */
+    [[nodiscard]] auto outputCache() const -> NodeOutputCache::Pointer;
+
+protected:
+    /**
+     * @brief Compute the node's outputs or load them from the cache
+     *
+     * On a cache miss, the outputs are computed, stored, and then reloaded
+     * from the cache. The reload guarantees that a node produces exactly the
+     * same outputs whether or not it was computed, which keeps the keys of
+     * downstream nodes stable when the file formats are lossy.
+     *
+     * @param name Unique name of the node type
+     * @param inputs Hash of the node's parameters and input data
+     * @param compute Computes the outputs
+     * @param save Writes the outputs into a directory
+     * @param load Reads the outputs from a directory
+     */
+    void memoize_(
+        const std::string& name,
+        const ContentHash& inputs,
+        const std::function<void()>& compute,
+        const NodeOutputCache::IOFunction& save,
+        const NodeOutputCache::IOFunction& load);
+
+private:
+    /** Output cache */
+    NodeOutputCache::Pointer cache_;
+};
+
+/**
+ * @brief Node output which is read from a graph's cache when first used
+ *
+ * When a saved graph is loaded, a node's cached outputs are only needed if a
+ * downstream node is recomputed. Instead of reading them, deserialize_()
+ * calls setFile() with the cached file and a loader, and the file is read
+ * the first time get() is called, e.g. when a downstream node pulls the
+ * output port. Assigning a value replaces the file.
+ *
+ * serialize_() should call save(), which does not read a file which was
+ * never used: the file is left in place if it is already at the target path
+ * and copied there otherwise.
+ *
+ * All member functions are safe to call concurrently.
+ *
+ * @ingroup Graph
+ */
+template <typename T>
+class LazyValue
+{
+public:
+    /** Reads the value from a file */
+    using Loader = std::function<T(const filesystem::path&)>;
+    /**
+     * Writes the value to a file. Returns false if there was nothing to
+     * write.
+     */
+    using Writer = std::function<bool(const filesystem::path&, const T&)>;
+
+    /** @brief Default constructor */
+    LazyValue() = default;
+
+    /** @brief Set the value */
+    auto operator=(T value) -> LazyValue&
+    {
+        const std::lock_guard<std::mutex> lock(mutex_);
+        value_ = std::move(value);
+        file_.clear();
+        loader_ = nullptr;
+        return *this;
+    }
+
+    /** @brief Read the value from `file` with `loader` when first used */
+    void setFile(filesystem::path file, Loader loader)
+    {
+        const std::lock_guard<std::mutex> lock(mutex_);
+        value_ = T{};
+        file_ = std::move(file);
+        loader_ = std::move(loader);
+    }
+
+    /** @brief Whether the value is in memory */
+    [[nodiscard]] auto loaded() const -> bool
+    {
+        const std::lock_guard<std::mutex> lock(mutex_);
+        return not loader_;
+    }
+
+    /** @brief Get the value, reading it first if needed */
+    auto get() -> T&
+    {
+        const std::lock_guard<std::mutex> lock(mutex_);
+        if (loader_) {
+            value_ = loader_(file_);
+            file_.clear();
+            loader_ = nullptr;
+        }
+        return value_;
+    }
+
+    /**
+     * @brief Save the value to `file`
+     *
+     * If the value has not been read, its file is copied to `file`, or left
+     * in place if it is already there. Otherwise, calls `writer`.
+     *
+     * @return Whether `file` holds the value
+     */
+    auto save(const filesystem::path& file, const Writer& writer) -> bool
+    {
+        const std::lock_guard<std::mutex> lock(mutex_);
+        if (not loader_) {
+            return writer(file, value_);
+        }
+        if (not filesystem::exists(file) or
+            not filesystem::equivalent(file, file_)) {
+            filesystem::copy_file(
+                file_, file, filesystem::copy_options::overwrite_existing);
+        }
+        return true;
+    }
+
+private:
+    /** Value, if loaded */
+    T value_{};
+    /** File to read the value from */
+    filesystem::path file_;
+    /** Reads file_, or nullptr once the value is loaded */
+    Loader loader_;
+    /** Guards all members */
+    mutable std::mutex mutex_;
+};
+
+}  // namespace volcart
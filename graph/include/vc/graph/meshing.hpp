@@ -7,10 +7,13 @@
 #include "vc/core/filesystem.hpp"
 #include "vc/core/types/ITKMesh.hpp"
 #include "vc/core/types/Volume.hpp"
+#include "vc/core/util/MemoryUsage.hpp"
 #include "vc/core/util/MeshMath.hpp"
+#include "vc/graph/memoization.hpp"
 #include "vc/meshing/ACVD.hpp"
 #include "vc/meshing/LaplacianSmooth.hpp"
 #include "vc/meshing/OrderedPointSetMesher.hpp"
+#include "vc/meshing/QuadricDecimation.hpp"
 #include "vc/meshing/UVMapToITKMesh.hpp"
 
 namespace volcart
@@ -29,8 +32,10 @@ private:
     using Mesher = meshing::OrderedPointSetMesher;
     /** Meshing */
     Mesher mesher_;
-    /** Input mesh */
-    ITKMesh::Pointer mesh_;
+    /** Output mesh */
+    LazyValue<ITKMesh::Pointer> mesh_;
+    /** Memory held by the output mesh */
+    memory::TrackedBytes meshMemory_{MemoryCategory::Mesh};
 
 public:
     /** @brief Input point set */
@@ -65,7 +70,9 @@ private:
     /** Linear scale factor */
     double scaleFactor_{1};
     /** Output mesh */
-    ITKMesh::Pointer output_;
+    LazyValue<ITKMesh::Pointer> output_;
+    /** Memory held by the output mesh */
+    memory::TrackedBytes meshMemory_{MemoryCategory::Mesh};
 
 public:
     /** @brief Input mesh */
@@ -153,7 +160,9 @@ private:
     /** Mesh smoother */
     Smoother smoother_;
     /** Smoothed mesh */
-    ITKMesh::Pointer mesh_;
+    LazyValue<ITKMesh::Pointer> mesh_;
+    /** Memory held by the output mesh */
+    memory::TrackedBytes meshMemory_{MemoryCategory::Mesh};
 
 public:
     /** @brief Input mesh */
@@ -175,20 +184,39 @@ private:
 };
 
 /**
- * @copybrief meshing::ACVD
+ * @brief Reduce the number of vertices of a mesh
+ *
+ * Resamples the mesh with meshing::ACVD (default), or decimates it with the
+ * much faster meshing::QuadricDecimation. The ACVD-specific ports are
+ * ignored by quadric decimation.
  *
  * @see meshing::ACVD
+ * @see meshing::QuadricDecimation
  * @ingroup Graph
  */
-class ResampleMeshNode : public smgl::Node
+class ResampleMeshNode : public smgl::Node, public MemoizedNode
 {
+public:
+    /** @brief Resampling methods */
+    enum class Method { ACVD, QuadricEdgeCollapse };
+
 private:
     /** Resampler class type */
     using ACVD = meshing::ACVD;
+    /** Decimator class type */
+    using QuadricDecimation = meshing::QuadricDecimation;
+    /** Resampling method */
+    Method method_{Method::ACVD};
     /** Mesh resampler */
     ACVD acvd_;
+    /** Mesh decimator */
+    QuadricDecimation decimator_;
+    /** Input mesh */
+    ITKMesh::Pointer input_;
     /** Output mesh */
-    ITKMesh::Pointer mesh_;
+    LazyValue<ITKMesh::Pointer> mesh_;
+    /** Memory held by the output mesh */
+    memory::TrackedBytes meshMemory_{MemoryCategory::Mesh};
 
 public:
     /** @copydoc ACVD::Mode */
@@ -196,6 +224,8 @@ public:
 
     /** @brief Input mesh */
     smgl::InputPort<ITKMesh::Pointer> input;
+    /** @brief Resampling method */
+    smgl::InputPort<Method> method;
     /** @copydoc ACVD::setMode(Mode) */
     smgl::InputPort<Mode> mode;
     /** @copydoc ACVD::setNumberOfClusters(std::size_t) */
@@ -206,6 +236,8 @@ public:
     smgl::InputPort<std::size_t> subsampleThreshold;
     /** @copydoc ACVD::setQuadricsOptimizationLevel(std::size_t) */
     smgl::InputPort<std::size_t> quadricsOptimizationLevel;
+    /** @copybrief ACVD::setNumThreads(std::size_t) */
+    smgl::InputPort<std::size_t> numThreads;
     /** @brief Resampled mesh */
     smgl::OutputPort<ITKMesh::Pointer> output;
 
@@ -236,7 +268,9 @@ private:
     /** Scale the output mesh to the dims of the UVMap */
     bool scaleDims_{false};
     /** Output mesh */
-    ITKMesh::Pointer output_{nullptr};
+    LazyValue<ITKMesh::Pointer> output_;
+    /** Memory held by the output mesh */
+    memory::TrackedBytes meshMemory_{MemoryCategory::Mesh};
 
 public:
     /** @brief Input mesh */
@@ -0,0 +1,111 @@
+#pragma once
+
+/** @file */
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <typeinfo>
+#include <utility>
+#include <vector>
+
+#include <smgl/Graph.hpp>
+#include <smgl/Node.hpp>
+
+namespace volcart
+{
+
+/**
+ * @brief Resource usage of a single graph node
+ *
+ * @ingroup Graph
+ */
+struct NodeProfile {
+    /** Node type name */
+    std::string name;
+    /** Number of times the node was computed */
+    std::size_t calls{0};
+    /** Total wall time */
+    std::chrono::duration<double> wallTime{0};
+    /** Total process CPU time (user + system) */
+    std::chrono::duration<double> cpuTime{0};
+    /**
+     * Growth of the process's peak resident set size in bytes. This is 0 if
+     * the node did not use more memory than the process had already used.
+     */
+    std::uint64_t peakRSSDelta{0};
+    /**
+     * Memory tracked by volcart::memory in bytes, sampled after the node's
+     * most recent compute
+     */
+    std::uint64_t trackedBytes{0};
+};
+
+/**
+ * @brief Records per-node timing and memory usage of a render graph
+ *
+ * Nodes inserted with insertNode() or registered with attach() have their
+ * `compute` function wrapped so that every graph update records the wall
+ * time, process CPU time, and growth of the process's peak resident set
+ * size. CPU time and memory are measured for the whole process, so they
+ * include the work of any other nodes which run at the same time.
+ *
+ * After every compute, the profiler also samples the memory accounts of
+ * volcart::memory, which applies the memory soft limit at node boundaries,
+ * and logs the tracked usage at the debug level.
+ *
+ * @warning The profiler must outlive every update of the profiled nodes.
+ *
+ * @ingroup Graph
+ */
+class GraphProfiler
+{
+public:
+    /** @brief Constructor */
+    explicit GraphProfiler(std::shared_ptr<smgl::Graph> graph);
+
+    /**
+     * @brief Insert a new node into the graph and profile it
+     *
+     * @copydetails smgl::Graph::insertNode()
+     */
+    template <class NodeType, typename... Args>
+    auto insertNode(Args&&... args) -> std::shared_ptr<NodeType>
+    {
+        auto node = graph_->insertNode<NodeType>(std::forward<Args>(args)...);
+        attach(node, NodeTypeName(typeid(NodeType)));
+        return node;
+    }
+
+    /** @brief Profile a node which is already in the graph */
+    void attach(const smgl::Node::Pointer& node, std::string name);
+
+    /** @brief Get the profiles of every computed node in execution order */
+    [[nodiscard]] auto profiles() const -> std::vector<NodeProfile>;
+
+    /** @brief Get the profiles as serializable metadata */
+    [[nodiscard]] auto metadata() const -> smgl::Metadata;
+
+    /** @brief Get a human-readable table of the profiles */
+    [[nodiscard]] auto summary() const -> std::string;
+
+    /** @brief Get a readable type name, without the `volcart` namespace */
+    static auto NodeTypeName(const std::type_info& t) -> std::string;
+
+private:
+    /** Profiled graph */
+    std::shared_ptr<smgl::Graph> graph_;
+    /** Profile of every attached node */
+    std::vector<NodeProfile> profiles_;
+    /** Order in which the nodes were first computed */
+    std::vector<std::size_t> order_;
+    /** Guards profiles_ and order_ */
+    mutable std::mutex mutex_;
+
+    /** Record a compute call */
+    void record_(std::size_t idx, const NodeProfile& p);
+};
+
+}  // namespace volcart
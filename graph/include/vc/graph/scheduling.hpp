@@ -0,0 +1,89 @@
+#pragma once
+
+/** @file */
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+
+#include <smgl/Node.hpp>
+
+namespace volcart
+{
+
+/**
+ * @brief Runs the sink nodes of a graph in the background
+ *
+ * smgl updates a graph's nodes one at a time on the calling thread. Nodes
+ * attached to this executor instead have their `compute` function queued on
+ * the global ThreadPool, so that the graph update continues with the next
+ * node immediately. This lets slow side branches, such as writing
+ * intermediate meshes, PPMs, and plots to disk, overlap with the rest of the
+ * graph.
+ *
+ * Only nodes whose outputs are not connected to other nodes may be attached.
+ * smgl passes a node's outputs to its consumers as soon as `compute` returns,
+ * so a consumer of a background node would receive stale values.
+ *
+ * The inputs of an attached node must not be modified until its background
+ * computation has finished. Call wait() after updating the graph and before
+ * saving it or updating it again.
+ *
+ * @ingroup Graph
+ */
+class AsyncNodeExecutor
+{
+public:
+    /**
+     * @brief Constructor
+     *
+     * @param numThreads Maximum number of nodes computed at once. If 0, uses
+     * the number of threads in the global ThreadPool.
+     */
+    explicit AsyncNodeExecutor(std::size_t numThreads = 0);
+
+    /** @brief Destructor. Waits for all queued nodes to finish. */
+    ~AsyncNodeExecutor();
+
+    /** Disallow copies */
+    AsyncNodeExecutor(const AsyncNodeExecutor&) = delete;
+    /** Disallow copies */
+    auto operator=(const AsyncNodeExecutor&) -> AsyncNodeExecutor& = delete;
+
+    /** @brief Run a node's computation in the background */
+    void attach(const smgl::Node::Pointer& node);
+
+    /**
+     * @brief Wait for all queued nodes to finish
+     *
+     * If any background computation threw, the first exception is rethrown
+     * after all other queued nodes have finished.
+     */
+    void wait();
+
+private:
+    /** Maximum number of pool tasks running computations */
+    std::size_t maxRunners_{1};
+    /** Number of pool tasks running computations */
+    std::size_t runners_{0};
+    /** Queued computations */
+    std::deque<std::function<void()>> queue_;
+    /** Number of queued or running computations */
+    std::size_t pending_{0};
+    /** First exception thrown by a computation */
+    std::exception_ptr error_;
+    /** Guards the queue and counters */
+    std::mutex mutex_;
+    /** Signals finished work to wait() */
+    std::condition_variable doneCv_;
+
+    /** Pool task loop. Runs queued computations until the queue is empty. */
+    void run_();
+    /** Queue a computation */
+    void enqueue_(std::function<void()> task);
+};
+
+}  // namespace volcart
@@ -14,13 +14,19 @@
 #include "vc/core/types/UVMap.hpp"
 #include "vc/core/types/Volume.hpp"
 #include "vc/core/types/VolumePkg.hpp"
+#include "vc/graph/memoization.hpp"
 #include "vc/texturing/AngleBasedFlattening.hpp"
+#include "vc/texturing/ChartFlattening.hpp"
 #include "vc/texturing/CompositeTexture.hpp"
 #include "vc/texturing/FlatteningError.hpp"
+#include "vc/texturing/HierarchicalFlattening.hpp"
 #include "vc/texturing/IntegralTexture.hpp"
 #include "vc/texturing/IntersectionTexture.hpp"
+#include "vc/texturing/MultiTexture.hpp"
 #include "vc/texturing/OrthographicProjectionFlattening.hpp"
 #include "vc/texturing/PPMGenerator.hpp"
+#include "vc/texturing/TextureCheckpoint.hpp"
+#include "vc/texturing/TextureParts.hpp"
 #include "vc/texturing/ThicknessTexture.hpp"
 
 namespace volcart
@@ -32,23 +38,29 @@ namespace volcart
  * @see texturing::AngleBasedFlattening
  * @ingroup Graph
  */
-class ABFNode : public smgl::Node
+class ABFNode : public smgl::Node, public MemoizedNode
 {
 private:
     /** Flattening class type */
     using ABF = texturing::AngleBasedFlattening;
     /** Flattening class */
     ABF abf_{};
+    /** Input mesh */
+    ITKMesh::Pointer input_{nullptr};
     /** Output UV Map */
-    UVMap::Pointer uvMap_{};
+    LazyValue<UVMap::Pointer> uvMap_;
     /** Output flattened mesh */
-    ITKMesh::Pointer mesh_{nullptr};
+    LazyValue<ITKMesh::Pointer> mesh_;
 
 public:
     /** @brief Input mesh */
     smgl::InputPort<ITKMesh::Pointer> input;
     /** @copydoc ABF::setUseABF(bool) */
     smgl::InputPort<bool> useABF;
+    /** @copydoc ABF::setSeedUVMap(const UVMap::Pointer&) */
+    smgl::InputPort<UVMap::Pointer> seedUVMap;
+    /** @copydoc ABF::setSolver() */
+    smgl::InputPort<ABF::Solver> solver;
     /** @brief Flattened mesh */
     smgl::OutputPort<ITKMesh::Pointer> output;
     /** @brief UVMap generated from flattened mesh */
@@ -67,6 +79,102 @@ private:
         const smgl::Metadata& meta, const filesystem::path& cacheDir) override;
 };
 
+/**
+ * @copybrief texturing::HierarchicalFlattening
+ *
+ * @see texturing::HierarchicalFlattening
+ * @ingroup Graph
+ */
+class HierarchicalFlatteningNode : public smgl::Node, public MemoizedNode
+{
+private:
+    /** Flattening class type */
+    using Flattening = texturing::HierarchicalFlattening;
+    /** Flattening class */
+    Flattening flatten_{};
+    /** Input mesh */
+    ITKMesh::Pointer input_{nullptr};
+    /** Output UV Map */
+    LazyValue<UVMap::Pointer> uvMap_;
+    /** Output flattened mesh */
+    LazyValue<ITKMesh::Pointer> mesh_;
+
+public:
+    /** @brief Input mesh */
+    smgl::InputPort<ITKMesh::Pointer> input;
+    /** @copydoc Flattening::setUseABF(bool) */
+    smgl::InputPort<bool> useABF;
+    /** @copydoc Flattening::setProxyVertices(std::size_t) */
+    smgl::InputPort<std::size_t> proxyVertices;
+    /** @copydoc Flattening::setRelaxationIterations(std::size_t) */
+    smgl::InputPort<std::size_t> relaxationIterations;
+    /** @copydoc Flattening::setSolver() */
+    smgl::InputPort<texturing::AngleBasedFlattening::Solver> solver;
+    /** @brief Flattened mesh */
+    smgl::OutputPort<ITKMesh::Pointer> output;
+    /** @brief UVMap generated from flattened mesh */
+    smgl::OutputPort<UVMap::Pointer> uvMap;
+
+    /** Constructor */
+    HierarchicalFlatteningNode();
+
+private:
+    /** Smeagol custom serialization */
+    auto serialize_(bool useCache, const filesystem::path& cacheDir)
+        -> smgl::Metadata override;
+
+    /** Smeagol custom deserialization */
+    void deserialize_(
+        const smgl::Metadata& meta, const filesystem::path& cacheDir) override;
+};
+
+/**
+ * @copybrief texturing::ChartFlattening
+ *
+ * @see texturing::ChartFlattening
+ * @ingroup Graph
+ */
+class ChartFlatteningNode : public smgl::Node, public MemoizedNode
+{
+private:
+    /** Flattening class type */
+    using Flattening = texturing::ChartFlattening;
+    /** Flattening class */
+    Flattening flatten_{};
+    /** Input mesh */
+    ITKMesh::Pointer input_{nullptr};
+    /** Output UV Map */
+    LazyValue<UVMap::Pointer> uvMap_;
+    /** Output flattened mesh */
+    LazyValue<ITKMesh::Pointer> mesh_;
+
+public:
+    /** @brief Input mesh */
+    smgl::InputPort<ITKMesh::Pointer> input;
+    /** @copydoc Flattening::setUseABF(bool) */
+    smgl::InputPort<bool> useABF;
+    /** @copydoc Flattening::setSolver() */
+    smgl::InputPort<texturing::AngleBasedFlattening::Solver> solver;
+    /** @copydoc Flattening::setPadding(double) */
+    smgl::InputPort<double> padding;
+    /** @brief Flattened mesh */
+    smgl::OutputPort<ITKMesh::Pointer> output;
+    /** @brief UVMap generated from flattened mesh */
+    smgl::OutputPort<UVMap::Pointer> uvMap;
+
+    /** Constructor */
+    ChartFlatteningNode();
+
+private:
+    /** Smeagol custom serialization */
+    auto serialize_(bool useCache, const filesystem::path& cacheDir)
+        -> smgl::Metadata override;
+
+    /** Smeagol custom deserialization */
+    void deserialize_(
+        const smgl::Metadata& meta, const filesystem::path& cacheDir) override;
+};
+
 /**
  * @copybrief texturing::OrthographicProjectionFlattening
  *
@@ -81,9 +189,9 @@ private:
     /** Flattening class */
     Ortho ortho_{};
     /** Output UVMap */
-    UVMap::Pointer uvMap_{};
+    LazyValue<UVMap::Pointer> uvMap_;
     /** Output mesh */
-    ITKMesh::Pointer mesh_{nullptr};
+    LazyValue<ITKMesh::Pointer> mesh_;
 
 public:
     /** @brief Input mesh */
@@ -203,17 +311,27 @@ private:
  * @see texturing::PPMGenerator
  * @ingroup Graph
  */
-class PPMGeneratorNode : public smgl::Node
+class PPMGeneratorNode : public smgl::Node, public MemoizedNode
 {
 private:
     /** Generator class type */
     using PPMGen = texturing::PPMGenerator;
     /** Generator */
     PPMGen ppmGen_;
+    /** Input mesh */
+    ITKMesh::Pointer mesh_;
+    /** Input UV map */
+    UVMap::Pointer uvMap_;
     /** Shading method */
     PPMGen::Shading shading_{PPMGen::Shading::Smooth};
+    /** Index of the generated part */
+    std::size_t partIndex_{0};
+    /** Number of parts */
+    std::size_t partCount_{1};
+    /** Generated part */
+    texturing::TexturePart part_;
     /** Output PPM */
-    PerPixelMap::Pointer ppm_;
+    LazyValue<PerPixelMap::Pointer> ppm_;
 
 public:
     /**
@@ -227,8 +345,23 @@ public:
     smgl::InputPort<UVMap::Pointer> uvMap;
     /** @brief Pixel normal shading method */
     smgl::InputPort<Shading> shading;
+    /**
+     * @brief Index of the part of the PPM to generate
+     *
+     * @see texturing::TexturePart::Make()
+     */
+    smgl::InputPort<std::size_t> partIndex;
+    /**
+     * @brief Number of parts the PPM is divided into
+     *
+     * If greater than 1, only the region of part partIndex is generated.
+     * Default: 1
+     */
+    smgl::InputPort<std::size_t> partCount;
     /** @brief Output PerPixelMap */
     smgl::OutputPort<PerPixelMap::Pointer> ppm;
+    /** @brief The generated part of the full PPM */
+    smgl::OutputPort<texturing::TexturePart> part;
 
     /** Constructor */
     PPMGeneratorNode();
@@ -360,7 +493,7 @@ private:
     /** Composite filter */
     TAlgo::Filter filter_{TAlgo::Filter::Maximum};
     /** Output image */
-    cv::Mat texture_;
+    LazyValue<cv::Mat> texture_;
 
 public:
     /** @copydoc texturing::CompositeTexture::Filter */
@@ -374,6 +507,12 @@ public:
     smgl::InputPort<Generator> generator;
     /** @brief Composite filter type */
     smgl::InputPort<Filter> filter;
+    /** @copybrief texturing::TexturingAlgorithm::setNumThreads() */
+    smgl::InputPort<size_t> numThreads;
+    /** @copybrief texturing::TexturingAlgorithm::setUseGPU() */
+    smgl::InputPort<bool> useGPU;
+    /** @copybrief texturing::TexturingAlgorithm::setCheckpoint() */
+    smgl::InputPort<texturing::TextureCheckpoint::Pointer> checkpoint;
     /** @brief Generated texture image */
     smgl::OutputPort<cv::Mat> texture;
 
@@ -403,7 +542,7 @@ private:
     /** Texturing algorithm */
     TAlgo textureGen_;
     /** Output image */
-    cv::Mat texture_;
+    LazyValue<cv::Mat> texture_;
 
 public:
     /** @brief Input PerPixelMap */
@@ -441,7 +580,7 @@ private:
     /** Texturing algorithm */
     TAlgo textureGen_;
     /** Output image */
-    cv::Mat texture_;
+    LazyValue<cv::Mat> texture_;
 
 public:
     /**
@@ -482,6 +621,12 @@ public:
     smgl::InputPort<double> exponentialDiffBaseValue;
     /** @copybrief TAlgo::setExponentialDiffSuppressBelowBase() */
     smgl::InputPort<bool> exponentialDiffSuppressBelowBase;
+    /** @copybrief texturing::TexturingAlgorithm::setNumThreads() */
+    smgl::InputPort<size_t> numThreads;
+    /** @copybrief texturing::TexturingAlgorithm::setUseGPU() */
+    smgl::InputPort<bool> useGPU;
+    /** @copybrief texturing::TexturingAlgorithm::setCheckpoint() */
+    smgl::InputPort<texturing::TextureCheckpoint::Pointer> checkpoint;
     /** @brief Generated texture image */
     smgl::OutputPort<cv::Mat> texture;
 
@@ -498,6 +643,64 @@ private:
         const smgl::Metadata& meta, const filesystem::path& cacheDir) override;
 };
 
+/**
+ * @copybrief texturing::MultiTexture
+ *
+ * The `texture` output is the first generated image, so that this node can
+ * be used anywhere a single texture is expected. All generated images are
+ * available from the `textures` output.
+ *
+ * @see texturing::MultiTexture
+ * @ingroup Graph
+ */
+class MultiTextureNode : public smgl::Node
+{
+private:
+    /** Algorithm class type */
+    using TAlgo = texturing::MultiTexture;
+    /** Generator class type */
+    using Generator = NeighborhoodGenerator::Pointer;
+    /** Texturing algorithm */
+    TAlgo textureGen_;
+    /** Requested outputs */
+    std::vector<TAlgo::Output> outputs_;
+    /** Output images */
+    std::vector<cv::Mat> textures_;
+    /** First output image */
+    cv::Mat texture_;
+
+public:
+    /** @copydoc texturing::MultiTexture::Output */
+    using Output = TAlgo::Output;
+
+    /** @brief Input PerPixelMap */
+    smgl::InputPort<PerPixelMap::Pointer> ppm;
+    /** @brief Input Volume */
+    smgl::InputPort<Volume::Pointer> volume;
+    /** @brief Neighborhood generator */
+    smgl::InputPort<Generator> generator;
+    /** @copybrief texturing::MultiTexture::setOutputs() */
+    smgl::InputPort<std::vector<Output>> outputs;
+    /** @copybrief texturing::TexturingAlgorithm::setNumThreads() */
+    smgl::InputPort<size_t> numThreads;
+    /** @brief Generated texture images */
+    smgl::OutputPort<std::vector<cv::Mat>> textures;
+    /** @brief First generated texture image */
+    smgl::OutputPort<cv::Mat> texture;
+
+    /** Constructor */
+    MultiTextureNode();
+
+private:
+    /** Smeagol custom serialization */
+    auto serialize_(bool useCache, const filesystem::path& cacheDir)
+        -> smgl::Metadata override;
+
+    /** Smeagol custom deserialization */
+    void deserialize_(
+        const smgl::Metadata& meta, const filesystem::path& cacheDir) override;
+};
+
 /**
  * @copybrief texturing::ThicknessTexture
  * @see texturing::ThicknessTexture
@@ -511,7 +714,7 @@ private:
     /** Texturing algorithm */
     TAlgo textureGen_;
     /** Output image */
-    cv::Mat texture_;
+    LazyValue<cv::Mat> texture_;
 
 public:
     /** @brief Input PerPixelMap */
@@ -524,12 +727,53 @@ public:
     smgl::InputPort<double> samplingInterval;
     /** @copybrief texturing::ThicknessTexture::setNormalizeOutput() */
     smgl::InputPort<bool> normalizeOutput;
+    /** @copybrief texturing::ThicknessTexture::setUseDistanceField() */
+    smgl::InputPort<bool> useDistanceField;
+    /** @copybrief texturing::TexturingAlgorithm::setNumThreads() */
+    smgl::InputPort<size_t> numThreads;
     /** @brief Generated texture image */
     smgl::OutputPort<cv::Mat> texture;
 
     /** Constructor */
     ThicknessTextureNode();
 
+private:
+    /** Smeagol custom serialization */
+    auto serialize_(bool useCache, const filesystem::path& cacheDir)
+        -> smgl::Metadata override;
+
+    /** Smeagol custom deserialization */
+    void deserialize_(
+        const smgl::Metadata& meta, const filesystem::path& cacheDir) override;
+};
+
+/**
+ * @copybrief texturing::WriteTexturePart()
+ *
+ * @see texturing::WriteTexturePart()
+ * @ingroup Graph
+ */
+class WriteTexturePartNode : public smgl::Node
+{
+private:
+    /** File path */
+    filesystem::path path_;
+    /** Texture part */
+    texturing::TexturePart part_;
+    /** Part image */
+    cv::Mat image_;
+
+public:
+    /** @brief Output file. Must have a TIFF extension. */
+    smgl::InputPort<filesystem::path> path;
+    /** @brief Texture part, e.g. from PPMGeneratorNode */
+    smgl::InputPort<texturing::TexturePart> part;
+    /** @brief Texture image of the part */
+    smgl::InputPort<cv::Mat> image;
+
+    /** Constructor */
+    WriteTexturePartNode();
+
 private:
     /** Smeagol custom serialization */
     auto serialize_(bool useCache, const filesystem::path& cacheDir)
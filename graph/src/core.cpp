@@ -2,14 +2,40 @@
 
 #include <nlohmann/json.hpp>
 
+#include "vc/core/io/AsyncImageWriter.hpp"
 #include "vc/core/io/ImageIO.hpp"
 #include "vc/core/io/PointSetIO.hpp"
 #include "vc/core/io/UVMapIO.hpp"
+#include "vc/core/io/VolumetricMaskIO.hpp"
 #include "vc/core/util/FloatComparison.hpp"
+#include "vc/core/util/MeshMath.hpp"
+#include "vc/core/util/String.hpp"
 
 using namespace volcart;
 namespace fs = volcart::filesystem;
 
+namespace
+{
+// Write a UV map output into a node's cache. Returns false if it is empty.
+auto WriteUVMapOutput(const fs::path& path, const UVMap::Pointer& uvMap)
+    -> bool
+{
+    if (not uvMap or uvMap->empty()) {
+        return false;
+    }
+    io::WriteUVMap(path, *uvMap);
+    return true;
+}
+
+// Read a UV map output from a node's cache when it is first used
+void ReadUVMapOutput(LazyValue<UVMap::Pointer>& uvMap, const fs::path& path)
+{
+    uvMap.setFile(path, [](const fs::path& p) {
+        return UVMap::New(io::ReadUVMap(p));
+    });
+}
+}  // namespace
+
 // Enum conversions
 namespace volcart
 {
@@ -23,6 +49,23 @@ NLOHMANN_JSON_SERIALIZE_ENUM(FlipAxis, {
 // clang-format on
 }  // namespace volcart
 
+namespace volcart::io
+{
+// clang-format off
+using PLYFormat = PLYWriter::Format;
+NLOHMANN_JSON_SERIALIZE_ENUM(PLYFormat, {
+    {PLYFormat::ASCII, "ascii"},
+    {PLYFormat::BinaryLittleEndian, "binary_little_endian"}
+})
+
+using PLYPrecision = PLYWriter::Precision;
+NLOHMANN_JSON_SERIALIZE_ENUM(PLYPrecision, {
+    {PLYPrecision::Float32, "float32"},
+    {PLYPrecision::Float64, "float64"}
+})
+// clang-format on
+}  // namespace volcart::io
+
 LoadVolumePkgNode::LoadVolumePkgNode() : path{&path_}, volpkg{&vpkg_}
 {
     registerInputPort("path", path);
@@ -167,7 +210,10 @@ LoadMeshNode::LoadMeshNode()
     registerOutputPort("mesh", mesh);
     registerOutputPort("uvMap", uvMap);
     registerOutputPort("texture", texture);
-    compute = [=]() { loaded_ = ReadMesh(path_); };
+    compute = [=]() {
+        loaded_ = ReadMesh(path_);
+        meshMemory_.set(meshmath::MemoryInBytes(loaded_.mesh));
+    };
     usesCacheDir = [this]() { return cacheArgs_; };
 }
 
@@ -197,20 +243,33 @@ WriteMeshNode::WriteMeshNode()
     , uvMap{&uv_}
     , texture{&texture_}
     , cacheArgs{&cacheArgs_}
+    , plyFormat{&plyFormat_}
+    , plyPrecision{&plyPrecision_}
 {
     registerInputPort("path", path);
     registerInputPort("mesh", mesh);
     registerInputPort("uvMap", uvMap);
     registerInputPort("texture", texture);
     registerInputPort("cacheArgs", cacheArgs);
-    compute = [=]() { WriteMesh(path_, mesh_, uv_, texture_); };
+    registerInputPort("plyFormat", plyFormat);
+    registerInputPort("plyPrecision", plyPrecision);
+    compute = [=]() {
+        MeshWriterOpts opts;
+        opts.plyFormat = plyFormat_;
+        opts.plyPrecision = plyPrecision_;
+        WriteMesh(path_, mesh_, uv_, texture_, opts);
+    };
     usesCacheDir = [this]() { return cacheArgs_; };
 }
 
 auto WriteMeshNode::serialize_(bool useCache, const fs::path& cacheDir)
     -> smgl::Metadata
 {
-    smgl::Metadata meta{{"path", path_.string()}, {"cacheArgs", cacheArgs_}};
+    smgl::Metadata meta{
+        {"path", path_.string()},
+        {"cacheArgs", cacheArgs_},
+        {"plyFormat", plyFormat_},
+        {"plyPrecision", plyPrecision_}};
 
     if (useCache and cacheArgs_) {
         auto file = path_.filename().replace_extension(".obj");
@@ -226,10 +285,20 @@ void WriteMeshNode::deserialize_(
 {
     path_ = meta["path"].get<std::string>();
     cacheArgs_ = meta["cacheArgs"].get<bool>();
+    // Graphs saved before the PLY options were added
+    if (meta.contains("plyFormat")) {
+        plyFormat_ = meta["plyFormat"].get<io::PLYWriter::Format>();
+    }
+    if (meta.contains("plyPrecision")) {
+        plyPrecision_ = meta["plyPrecision"].get<io::PLYWriter::Precision>();
+    }
 }
 
 RotateUVMapNode::RotateUVMapNode()
-    : Node{true}, uvMapIn{&uvMapIn_}, theta{&theta_}, uvMapOut{&uvMapOut_}
+    : Node{true}
+    , uvMapIn{&uvMapIn_}
+    , theta{&theta_}
+    , uvMapOut{[=]() { return uvMapOut_.get(); }}
 {
     registerInputPort("uvMapIn", uvMapIn);
     registerInputPort("theta", theta);
@@ -238,11 +307,12 @@ RotateUVMapNode::RotateUVMapNode()
     compute = [=]() {
         static constexpr double PI_CONST{3.1415926535897932385L};
         static constexpr double DEG_TO_RAD{PI_CONST / 180.0};
-        uvMapOut_ = UVMap::New(*uvMapIn_);
+        auto uvMap = UVMap::New(*uvMapIn_);
         if (not AlmostEqual(theta_, 0.0)) {
             auto radians = theta_ * DEG_TO_RAD;
-            UVMap::Rotate(*uvMapOut_, radians);
+            UVMap::Rotate(*uvMap, radians);
         }
+        uvMapOut_ = uvMap;
     };
 }
 
@@ -251,8 +321,8 @@ auto RotateUVMapNode::serialize_(bool useCache, const fs::path& cacheDir)
 {
     smgl::Metadata meta;
     meta["theta"] = theta_;
-    if (useCache and uvMapOut_ and not uvMapOut_->empty()) {
-        io::WriteUVMap(cacheDir / "uvMap_rot.uvm", *uvMapOut_);
+    if (useCache and
+        uvMapOut_.save(cacheDir / "uvMap_rot.uvm", WriteUVMapOutput)) {
         meta["uvMap"] = "uvMap_rot.uvm";
     }
     return meta;
@@ -264,20 +334,24 @@ void RotateUVMapNode::deserialize_(
     theta_ = meta["theta"].get<double>();
     if (meta.contains("uvMap")) {
         auto uvMapFile = meta["uvMap"].get<std::string>();
-        uvMapOut_ = UVMap::New(io::ReadUVMap(cacheDir / uvMapFile));
+        ReadUVMapOutput(uvMapOut_, cacheDir / uvMapFile);
     }
 }
 
 FlipUVMapNode::FlipUVMapNode()
-    : Node{true}, uvMapIn{&uvMapIn_}, flipAxis{&axis_}, uvMapOut{&uvMapOut_}
+    : Node{true}
+    , uvMapIn{&uvMapIn_}
+    , flipAxis{&axis_}
+    , uvMapOut{[=]() { return uvMapOut_.get(); }}
 {
     registerInputPort("uvMapIn", uvMapIn);
     registerInputPort("flipAxis", flipAxis);
     registerOutputPort("uvMapOut", uvMapOut);
 
     compute = [=]() {
-        uvMapOut_ = UVMap::New(*uvMapIn_);
-        UVMap::Flip(*uvMapOut_, axis_);
+        auto uvMap = UVMap::New(*uvMapIn_);
+        UVMap::Flip(*uvMap, axis_);
+        uvMapOut_ = uvMap;
     };
 }
 
@@ -286,8 +360,8 @@ auto FlipUVMapNode::serialize_(bool useCache, const fs::path& cacheDir)
 {
     smgl::Metadata meta;
     meta["flipAxis"] = axis_;
-    if (useCache and uvMapOut_ and not uvMapOut_->empty()) {
-        io::WriteUVMap(cacheDir / "uvMap_flip.uvm", *uvMapOut_);
+    if (useCache and
+        uvMapOut_.save(cacheDir / "uvMap_flip.uvm", WriteUVMapOutput)) {
         meta["uvMap"] = "uvMap_flip.uvm";
     }
     return meta;
@@ -299,12 +373,15 @@ void FlipUVMapNode::deserialize_(
     axis_ = meta["flipAxis"].get<FlipAxis>();
     if (meta.contains("uvMap")) {
         auto uvMapFile = meta["uvMap"].get<std::string>();
-        uvMapOut_ = UVMap::New(io::ReadUVMap(cacheDir / uvMapFile));
+        ReadUVMapOutput(uvMapOut_, cacheDir / uvMapFile);
     }
 }
 
 PlotUVMapNode::PlotUVMapNode()
-    : Node{true}, uvMap{&uvMap_}, uvMesh{&uvMesh_}, plot{&plot_}
+    : Node{true}
+    , uvMap{&uvMap_}
+    , uvMesh{&uvMesh_}
+    , plot{[=]() { return plot_.get(); }}
 {
     registerInputPort("uvMap", uvMap);
     registerInputPort("uvMesh", uvMesh);
@@ -321,8 +398,14 @@ auto PlotUVMapNode::serialize_(bool useCache, const fs::path& cacheDir)
     -> smgl::Metadata
 {
     smgl::Metadata meta;
-    if (useCache and not plot_.empty()) {
-        WriteImage(cacheDir / "uvPlot.tif", plot_);
+    auto writePlot = [](const fs::path& path, const cv::Mat& plot) {
+        if (plot.empty()) {
+            return false;
+        }
+        WriteImage(path, plot);
+        return true;
+    };
+    if (useCache and plot_.save(cacheDir / "uvPlot.tif", writePlot)) {
         meta["plot"] = "uvPlot.tif";
     }
     return meta;
@@ -333,7 +416,9 @@ void PlotUVMapNode::deserialize_(
 {
     if (meta.contains("plot")) {
         auto file = meta["plot"].get<std::string>();
-        plot_ = ReadImage(cacheDir / file);
+        plot_.setFile(cacheDir / file, [](const fs::path& p) {
+            return ReadImage(p);
+        });
     }
 }
 
@@ -396,6 +481,42 @@ void WriteImageNode::deserialize_(
     cacheArgs_ = meta["cacheArgs"].get<bool>();
 }
 
+WriteImagesNode::WriteImagesNode()
+    : smgl::Node{true}
+    , path{&path_}
+    , images{&images_}
+    , numThreads{&numThreads_}
+{
+    registerInputPort("path", path);
+    registerInputPort("images", images);
+    registerInputPort("numThreads", numThreads);
+    compute = [=]() {
+        auto parent = path_.parent_path();
+        auto stem = path_.stem().string();
+        auto ext = path_.extension().string();
+        auto padding = static_cast<int>(std::to_string(images_.size()).size());
+        AsyncImageWriter writer(numThreads_);
+        for (std::size_t i = 0; i < images_.size(); i++) {
+            auto name = stem + "_" + to_padded_string(i, padding) + ext;
+            writer.write(parent / name, images_[i]);
+        }
+        writer.flush();
+    };
+}
+
+auto WriteImagesNode::serialize_(
+    bool /*useCache*/, const fs::path& /*cacheDir*/) -> smgl::Metadata
+{
+    return {{"path", path_.string()}, {"numThreads", numThreads_}};
+}
+
+void WriteImagesNode::deserialize_(
+    const smgl::Metadata& meta, const fs::path& /*cacheDir*/)
+{
+    path_ = meta["path"].get<std::string>();
+    numThreads_ = meta["numThreads"].get<std::size_t>();
+}
+
 LoadPPMNode::LoadPPMNode()
     : smgl::Node{true}, path{&path_}, cacheArgs{&cacheArgs_}, ppm{&ppm_}
 {
@@ -465,19 +586,29 @@ PPMPropertiesNode::PPMPropertiesNode()
     registerOutputPort("cellMap", cellMap);
 }
 
+namespace
+{
+// Read a VolumetricMask from a .vcvm file or a legacy .vcps file
+auto ReadMask(const fs::path& path) -> VolumetricMask::Pointer
+{
+    if (path.extension() == ".vcvm") {
+        return VolumetricMask::New(io::ReadVolumetricMask(path));
+    }
+    using psio = PointSetIO<cv::Vec3i>;
+    return VolumetricMask::New(psio::ReadPointSet(path));
+}
+}  // namespace
+
 LoadVolumetricMaskNode::LoadVolumetricMaskNode()
     : smgl::Node{true}
     , path{&path_}
     , cacheArgs{&cacheArgs_}
-    , volumetricMask{&mask_}
+    , volumetricMask{[=]() { return mask_.get(); }}
 {
     registerInputPort("path", path);
     registerInputPort("cacheArgs", cacheArgs);
     registerOutputPort("volumetricMask", volumetricMask);
-    compute = [=]() {
-        using psio = PointSetIO<cv::Vec3i>;
-        mask_ = VolumetricMask::New(psio::ReadPointSet(path_));
-    };
+    compute = [=]() { mask_ = ReadMask(path_); };
     usesCacheDir = [this]() { return cacheArgs_; };
 }
 
@@ -485,13 +616,15 @@ auto LoadVolumetricMaskNode::serialize_(bool useCache, const fs::path& cacheDir)
     -> smgl::Metadata
 {
     smgl::Metadata meta{{"path", path_.string()}, {"cacheArgs", cacheArgs_}};
-    if (useCache and cacheArgs_ and mask_) {
-        using psio = PointSetIO<cv::Vec3i>;
-        PointSet<cv::Vec3i> ps;
-        ps.append(*mask_);
-
-        auto file = path_.filename().replace_extension(".vcps");
-        psio::WritePointSet(cacheDir / file, ps);
+    auto writeMask = [](const fs::path& p, const VolumetricMask::Pointer& m) {
+        if (not m) {
+            return false;
+        }
+        io::WriteVolumetricMask(p, *m);
+        return true;
+    };
+    auto file = path_.filename().replace_extension(".vcvm");
+    if (useCache and cacheArgs_ and mask_.save(cacheDir / file, writeMask)) {
         meta["cachedFile"] = file.string();
     }
     return meta;
@@ -504,8 +637,7 @@ void LoadVolumetricMaskNode::deserialize_(
     cacheArgs_ = meta["cacheArgs"].get<bool>();
 
     if (meta.contains("cachedFile")) {
-        using psio = PointSetIO<cv::Vec3i>;
         auto file = meta["cachedFile"].get<std::string>();
-        mask_ = VolumetricMask::New(psio::ReadPointSet(cacheDir / file));
+        mask_.setFile(cacheDir / file, ReadMask);
     }
 }
\ No newline at end of file
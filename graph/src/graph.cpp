@@ -25,6 +25,7 @@ static auto RegisterNodesImpl() -> bool
         PlotUVMapNode,
         LoadImageNode,
         WriteImageNode,
+        WriteImagesNode,
         LoadPPMNode,
         WritePPMNode,
         PPMPropertiesNode,
@@ -44,6 +45,8 @@ static auto RegisterNodesImpl() -> bool
     // Texturing
     registered &= smgl::RegisterNode<
         ABFNode,
+        HierarchicalFlatteningNode,
+        ChartFlatteningNode,
         OrthographicFlatteningNode,
         FlatteningErrorNode,
         PlotLStretchErrorNode,
@@ -53,7 +56,9 @@ static auto RegisterNodesImpl() -> bool
         CompositeTextureNode,
         IntersectionTextureNode,
         IntegralTextureNode,
-        ThicknessTextureNode
+        MultiTextureNode,
+        ThicknessTextureNode,
+        WriteTexturePartNode
     >();
     // clang-format on
 
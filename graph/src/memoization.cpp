@@ -0,0 +1,845 @@
+#include "vc/graph/memoization.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <unordered_map>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#include "vc/core/Version.hpp"
+#include "vc/core/util/Iteration.hpp"
+#include "vc/core/util/Logging.hpp"
+#include "vc/core/util/ThreadPool.hpp"
+
+using namespace volcart;
+namespace fs = volcart::filesystem;
+
+///// Manifest file format /////
+// All values are stored in native byte order:
+//   ManifestHeader
+//   For each file:
+//     uint32_t nameLength
+//     char name[nameLength]: Path relative to the entry directory
+//     uint64_t size: Size of the file in bytes
+//     uint64_t chunks[ceil(size / chunkSize)]: Chunk IDs
+//
+///// Chunk file format /////
+//   uint8_t encoding: ChunkEncoding
+//   uint8_t data[]: The chunk's bytes, compressed with zlib if encoded
+static constexpr std::array<char, 8> MANIFEST_MAGIC{'V', 'C', 'N', 'O',
+                                                    'D', 'E', '\r', '\n'};
+static constexpr std::uint32_t MANIFEST_VERSION{1};
+static const std::string MANIFEST_EXT{".vcno"};
+static const std::string CHUNK_DIR{"chunks"};
+static const std::string TMP_MARKER{".tmp-"};
+
+// Unused chunks and temporary files younger than this may belong to a store
+// which is still in progress
+static constexpr std::int64_t GRACE_PERIOD_NS{600'000'000'000};
+
+namespace
+{
+// FNV-1a 64-bit prime
+constexpr std::uint64_t FNV_PRIME{1099511628211ULL};
+
+struct ManifestHeader {
+    std::array<char, 8> magic{MANIFEST_MAGIC};
+    std::uint32_t version{MANIFEST_VERSION};
+    std::uint32_t numFiles{0};
+    std::uint64_t chunkSize{NodeOutputCache::CHUNK_SIZE};
+};
+
+// A file in an entry's manifest
+struct ManifestFile {
+    std::string name;
+    std::uint64_t size{0};
+    std::vector<std::uint64_t> chunks;
+};
+
+// The contents of an entry's manifest
+struct Manifest {
+    std::uint64_t chunkSize{NodeOutputCache::CHUNK_SIZE};
+    std::vector<ManifestFile> files;
+};
+
+enum class ChunkEncoding : std::uint8_t { Raw = 0, Deflate };
+
+// An entry found while scanning the cache root
+struct EntryInfo {
+    fs::path path;
+    std::string key;
+    // Size on disk, not including chunks
+    std::size_t size{0};
+    std::int64_t mtime{0};
+    // False for entries in the directory-per-entry layout
+    bool packed{true};
+    // False if the manifest could not be read
+    bool readable{true};
+    Manifest manifest;
+};
+
+// A file found while scanning the cache root
+struct FileInfo {
+    fs::path path;
+    std::size_t size{0};
+    std::int64_t mtime{0};
+};
+
+// The contents of the cache root
+struct CacheScan {
+    std::vector<EntryInfo> entries;
+    std::unordered_map<std::uint64_t, FileInfo> chunks;
+    std::vector<FileInfo> temps;
+};
+
+// Unique suffix for temporary entry directories
+auto TempSuffix() -> std::string
+{
+    static std::atomic<std::uint64_t> counter{0};
+    static const auto seed = std::random_device{}();
+    std::stringstream ss;
+    ss << TMP_MARKER << std::hex << seed << "-" << counter++;
+    return ss.str();
+}
+
+// Whether a path is a temporary file or directory
+auto IsTemp(const fs::path& path) -> bool
+{
+    return path.filename().string().find(TMP_MARKER) != std::string::npos;
+}
+
+auto Hex(std::uint64_t v) -> std::string
+{
+    std::stringstream ss;
+    ss << std::hex << std::setw(16) << std::setfill('0') << v;
+    return ss.str();
+}
+
+// Chunks are spread between 256 subdirectories by the first byte of their ID
+auto ChunkPath(const fs::path& root, std::uint64_t id) -> fs::path
+{
+    auto name = Hex(id);
+    return root / CHUNK_DIR / name.substr(0, 2) / name;
+}
+
+// Get the modification time of a file in nanoseconds
+auto MTime(const struct stat& st) -> std::int64_t
+{
+#ifdef __APPLE__
+    const auto& ts = st.st_mtimespec;
+#else
+    const auto& ts = st.st_mtim;
+#endif
+    return static_cast<std::int64_t>(ts.tv_sec) * 1'000'000'000 + ts.tv_nsec;
+}
+
+auto Now() -> std::int64_t
+{
+    using namespace std::chrono;
+    return duration_cast<nanoseconds>(system_clock::now().time_since_epoch())
+        .count();
+}
+
+// Mark a file as recently used. Returns whether the file exists.
+auto Touch(const fs::path& path) -> bool
+{
+    return ::utimensat(AT_FDCWD, path.c_str(), nullptr, 0) == 0;
+}
+
+// Remove a file or directory, ignoring errors
+void RemoveAll(const fs::path& path)
+{
+    try {
+        fs::remove_all(path);
+    } catch (const std::exception&) {
+        // Another process may have removed it
+    }
+}
+
+// Get the combined size of the files in a directory
+auto DirectorySize(const fs::path& dir) -> std::pair<std::size_t, std::size_t>
+{
+    std::size_t files{0};
+    std::size_t bytes{0};
+    for (const auto& it : fs::recursive_directory_iterator(dir)) {
+        if (fs::is_regular_file(it.path())) {
+            files++;
+            bytes += fs::file_size(it.path());
+        }
+    }
+    return {files, bytes};
+}
+
+// Write a file to a temporary path and move it into place
+void WriteAtomic(const fs::path& path, const void* data, std::size_t size)
+{
+    auto tmp = path;
+    tmp += TempSuffix();
+    {
+        std::ofstream file(tmp.string(), std::ios::binary);
+        file.write(static_cast<const char*>(data), size);
+        file.close();
+        if (file.fail()) {
+            RemoveAll(tmp);
+            throw std::runtime_error("Failed to write: " + path.string());
+        }
+    }
+    fs::rename(tmp, path);
+}
+
+void WriteManifest(const fs::path& path, const Manifest& manifest)
+{
+    ManifestHeader header;
+    header.numFiles = static_cast<std::uint32_t>(manifest.files.size());
+    header.chunkSize = manifest.chunkSize;
+
+    std::string buffer(
+        reinterpret_cast<const char*>(&header), sizeof(header));
+    auto append = [&buffer](const auto& v) {
+        buffer.append(reinterpret_cast<const char*>(&v), sizeof(v));
+    };
+    for (const auto& f : manifest.files) {
+        append(static_cast<std::uint32_t>(f.name.size()));
+        buffer += f.name;
+        append(f.size);
+        for (const auto& c : f.chunks) {
+            append(c);
+        }
+    }
+    WriteAtomic(path, buffer.data(), buffer.size());
+}
+
+auto ReadManifest(const fs::path& path) -> Manifest
+{
+    std::ifstream file(path.string(), std::ios::binary);
+    auto read = [&file, &path](void* v, std::size_t size) {
+        file.read(static_cast<char*>(v), static_cast<std::streamsize>(size));
+        if (file.gcount() != static_cast<std::streamsize>(size)) {
+            throw std::runtime_error("Truncated manifest: " + path.string());
+        }
+    };
+
+    ManifestHeader header;
+    read(&header, sizeof(header));
+    if (header.magic != MANIFEST_MAGIC or
+        header.version != MANIFEST_VERSION or header.chunkSize == 0) {
+        throw std::runtime_error("Invalid manifest: " + path.string());
+    }
+
+    Manifest manifest;
+    manifest.chunkSize = header.chunkSize;
+    manifest.files.resize(header.numFiles);
+    for (auto& f : manifest.files) {
+        std::uint32_t len{0};
+        read(&len, sizeof(len));
+        f.name.resize(len);
+        read(f.name.data(), len);
+        read(&f.size, sizeof(f.size));
+        f.chunks.resize((f.size + header.chunkSize - 1) / header.chunkSize);
+        read(f.chunks.data(), f.chunks.size() * sizeof(std::uint64_t));
+    }
+    return manifest;
+}
+
+// Read exactly `size` bytes at `offset`
+void ReadAt(int fd, void* data, std::size_t size, std::size_t offset)
+{
+    auto* bytes = static_cast<char*>(data);
+    while (size > 0) {
+        auto n = ::pread(fd, bytes, size, static_cast<off_t>(offset));
+        if (n <= 0) {
+            throw std::runtime_error("Failed to read cache file");
+        }
+        bytes += n;
+        size -= static_cast<std::size_t>(n);
+        offset += static_cast<std::size_t>(n);
+    }
+}
+
+// Write exactly `size` bytes at `offset`
+void WriteAt(int fd, const void* data, std::size_t size, std::size_t offset)
+{
+    const auto* bytes = static_cast<const char*>(data);
+    while (size > 0) {
+        auto n = ::pwrite(fd, bytes, size, static_cast<off_t>(offset));
+        if (n <= 0) {
+            throw std::runtime_error("Failed to write cache file");
+        }
+        bytes += n;
+        size -= static_cast<std::size_t>(n);
+        offset += static_cast<std::size_t>(n);
+    }
+}
+
+// Closes a file descriptor when it goes out of scope
+struct FileDescriptor {
+    explicit FileDescriptor(int fd) : fd{fd} {}
+    ~FileDescriptor()
+    {
+        if (fd >= 0) {
+            ::close(fd);
+        }
+    }
+    FileDescriptor(const FileDescriptor&) = delete;
+    auto operator=(const FileDescriptor&) -> FileDescriptor& = delete;
+    int fd;
+};
+
+// Compress and store a chunk unless an identical chunk is already stored.
+// Returns the chunk's ID.
+auto StoreChunk(const fs::path& root, const std::vector<char>& data)
+    -> std::uint64_t
+{
+    ContentHash h;
+    h.update(data.size()).update(data.data(), data.size());
+    const auto id = h.value();
+
+    // Refreshing the existing chunk protects it from a concurrent trim
+    auto path = ChunkPath(root, id);
+    if (Touch(path)) {
+        return id;
+    }
+
+    // Keep the raw bytes if they do not compress, e.g. for encoded images
+    auto bound = ::compressBound(static_cast<uLong>(data.size()));
+    std::vector<char> encoded(1 + bound);
+    auto size = static_cast<uLongf>(bound);
+    auto res = ::compress2(
+        reinterpret_cast<Bytef*>(encoded.data() + 1), &size,
+        reinterpret_cast<const Bytef*>(data.data()),
+        static_cast<uLong>(data.size()), Z_BEST_SPEED);
+    if (res == Z_OK and size < data.size()) {
+        encoded[0] = static_cast<char>(ChunkEncoding::Deflate);
+        encoded.resize(1 + size);
+    } else {
+        encoded[0] = static_cast<char>(ChunkEncoding::Raw);
+        encoded.resize(1);
+        encoded.insert(encoded.end(), data.begin(), data.end());
+    }
+
+    fs::create_directories(path.parent_path());
+    WriteAtomic(path, encoded.data(), encoded.size());
+    return id;
+}
+
+// Load a chunk and check it against its ID
+auto LoadChunk(const fs::path& root, std::uint64_t id, std::size_t size)
+    -> std::vector<char>
+{
+    auto path = ChunkPath(root, id);
+    std::ifstream file(path.string(), std::ios::binary);
+    std::vector<char> encoded(
+        (std::istreambuf_iterator<char>(file)),
+        std::istreambuf_iterator<char>());
+    if (not file.good() and not file.eof()) {
+        throw std::runtime_error("Failed to read chunk: " + path.string());
+    }
+    if (encoded.empty()) {
+        throw std::runtime_error("Missing chunk: " + path.string());
+    }
+
+    std::vector<char> data(size);
+    auto encoding = static_cast<ChunkEncoding>(encoded[0]);
+    if (encoding == ChunkEncoding::Deflate) {
+        auto len = static_cast<uLongf>(size);
+        auto res = ::uncompress(
+            reinterpret_cast<Bytef*>(data.data()), &len,
+            reinterpret_cast<const Bytef*>(encoded.data() + 1),
+            static_cast<uLong>(encoded.size() - 1));
+        if (res != Z_OK or len != size) {
+            throw std::runtime_error("Corrupt chunk: " + path.string());
+        }
+    } else if (encoding == ChunkEncoding::Raw and encoded.size() == 1 + size) {
+        std::copy(encoded.begin() + 1, encoded.end(), data.begin());
+    } else {
+        throw std::runtime_error("Corrupt chunk: " + path.string());
+    }
+
+    ContentHash h;
+    h.update(data.size()).update(data.data(), data.size());
+    if (h.value() != id) {
+        throw std::runtime_error("Corrupt chunk: " + path.string());
+    }
+    return data;
+}
+
+// Split a file into stored chunks
+auto PackFile(const fs::path& root, const fs::path& path, std::string name)
+    -> ManifestFile
+{
+    ManifestFile file;
+    file.name = std::move(name);
+    file.size = fs::file_size(path);
+    const auto chunkSize = NodeOutputCache::CHUNK_SIZE;
+    file.chunks.resize((file.size + chunkSize - 1) / chunkSize);
+
+    FileDescriptor fd(::open(path.c_str(), O_RDONLY));
+    if (fd.fd < 0) {
+        throw std::runtime_error("Failed to open: " + path.string());
+    }
+    ParallelFor(range(file.chunks.size()), [&](auto i) {
+        auto offset = i * chunkSize;
+        std::vector<char> data(std::min(chunkSize, file.size - offset));
+        ReadAt(fd.fd, data.data(), data.size(), offset);
+        file.chunks[i] = StoreChunk(root, data);
+    });
+    return file;
+}
+
+// Reassemble a file from its chunks
+void UnpackFile(
+    const fs::path& root,
+    const ManifestFile& file,
+    std::size_t chunkSize,
+    const fs::path& path)
+{
+    fs::create_directories(path.parent_path());
+    FileDescriptor fd(::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644));
+    if (fd.fd < 0) {
+        throw std::runtime_error("Failed to create: " + path.string());
+    }
+    ParallelFor(range(file.chunks.size()), [&](auto i) {
+        auto offset = i * chunkSize;
+        auto size = std::min<std::size_t>(chunkSize, file.size - offset);
+        auto data = LoadChunk(root, file.chunks[i], size);
+        WriteAt(fd.fd, data.data(), data.size(), offset);
+    });
+}
+
+// List the entries, chunks, and temporary files in the cache root
+auto ScanCache(const fs::path& root) -> CacheScan
+{
+    CacheScan scan;
+    auto statFile = [](const fs::path& path, FileInfo& info) {
+        struct stat st{};
+        if (::stat(path.c_str(), &st) != 0) {
+            return false;
+        }
+        info = {path, static_cast<std::size_t>(st.st_size), MTime(st)};
+        return true;
+    };
+
+    for (const auto& it : fs::directory_iterator(root)) {
+        const auto& path = it.path();
+        FileInfo info;
+        if (not statFile(path, info)) {
+            continue;
+        }
+
+        if (IsTemp(path)) {
+            scan.temps.push_back(info);
+            continue;
+        }
+
+        if (path.filename() == CHUNK_DIR) {
+            for (const auto& c : fs::recursive_directory_iterator(path)) {
+                const auto& cp = c.path();
+                if (not fs::is_regular_file(cp) or not statFile(cp, info)) {
+                    continue;
+                }
+                if (IsTemp(cp)) {
+                    scan.temps.push_back(info);
+                    continue;
+                }
+                try {
+                    auto id = std::stoull(cp.filename().string(), nullptr, 16);
+                    scan.chunks[id] = info;
+                } catch (const std::exception&) {
+                    // Not a chunk
+                }
+            }
+            continue;
+        }
+
+        EntryInfo entry;
+        entry.path = path;
+        entry.mtime = info.mtime;
+        if (path.extension().string() == MANIFEST_EXT) {
+            entry.key = path.stem().string();
+            entry.size = info.size;
+            try {
+                entry.manifest = ReadManifest(path);
+            } catch (const std::exception&) {
+                // Unreadable entries are kept until they are evicted
+                entry.readable = false;
+            }
+        } else if (fs::is_directory(path)) {
+            entry.key = path.filename().string();
+            entry.packed = false;
+            entry.size = DirectorySize(path).second;
+        } else {
+            continue;
+        }
+        scan.entries.emplace_back(std::move(entry));
+    }
+    return scan;
+}
+}  // namespace
+
+auto ContentHash::update(const void* data, std::size_t size) -> ContentHash&
+{
+    const auto* bytes = static_cast<const unsigned char*>(data);
+    for (std::size_t i = 0; i < size; i++) {
+        state_ ^= bytes[i];
+        state_ *= FNV_PRIME;
+    }
+    return *this;
+}
+
+auto ContentHash::update(const std::string& s) -> ContentHash&
+{
+    update(s.size());
+    return update(s.data(), s.size());
+}
+
+auto ContentHash::update(const ITKMesh::Pointer& mesh) -> ContentHash&
+{
+    if (not mesh) {
+        return update(std::size_t{0});
+    }
+
+    update(static_cast<std::size_t>(mesh->GetNumberOfPoints()));
+    for (auto pt = mesh->GetPoints()->Begin(); pt != mesh->GetPoints()->End();
+         ++pt) {
+        update(pt.Value().GetDataPointer(), 3 * sizeof(double));
+        ITKPixel normal;
+        if (mesh->GetPointData(pt.Index(), &normal)) {
+            update(normal.GetDataPointer(), 3 * sizeof(double));
+        }
+    }
+
+    update(static_cast<std::size_t>(mesh->GetNumberOfCells()));
+    for (auto cell = mesh->GetCells()->Begin(); cell != mesh->GetCells()->End();
+         ++cell) {
+        update(static_cast<std::size_t>(cell.Value()->GetNumberOfPoints()));
+        for (auto id = cell.Value()->PointIdsBegin();
+             id != cell.Value()->PointIdsEnd(); ++id) {
+            update(*id);
+        }
+    }
+    return *this;
+}
+
+auto ContentHash::update(const UVMap::Pointer& uvMap) -> ContentHash&
+{
+    if (not uvMap) {
+        return update(std::size_t{0});
+    }
+
+    update(uvMap->size());
+    update(uvMap->origin());
+    auto ratio = uvMap->ratio();
+    update(ratio.width).update(ratio.height).update(ratio.aspect);
+    for (const auto& [id, uv] : enumerate(uvMap->as_vector())) {
+        if (uv != NULL_MAPPING) {
+            update(id).update(uv[0]).update(uv[1]);
+        }
+    }
+    return *this;
+}
+
+auto ContentHash::update(const OrderedPointSet<cv::Vec3d>& ps) -> ContentHash&
+{
+    update(ps.width()).update(ps.height());
+    for (const auto& p : ps) {
+        update(p.val, sizeof(p.val));
+    }
+    return *this;
+}
+
+auto ContentHash::value() const -> std::uint64_t { return state_; }
+
+auto ContentHash::hex() const -> std::string { return Hex(state_); }
+
+NodeOutputCache::NodeOutputCache(fs::path root, std::size_t capacity)
+    : root_{std::move(root)}, capacity_{capacity}
+{
+    fs::create_directories(root_ / CHUNK_DIR);
+}
+
+auto NodeOutputCache::New(fs::path root, std::size_t capacity) -> Pointer
+{
+    return std::make_shared<NodeOutputCache>(std::move(root), capacity);
+}
+
+auto NodeOutputCache::root() const -> fs::path { return root_; }
+
+void NodeOutputCache::setCapacity(std::size_t capacity)
+{
+    capacity_ = capacity;
+    trim();
+}
+
+auto NodeOutputCache::capacity() const -> std::size_t { return capacity_; }
+
+auto NodeOutputCache::bytes() const -> std::size_t
+{
+    auto scan = ScanCache(root_);
+    std::size_t bytes{0};
+    for (const auto& e : scan.entries) {
+        bytes += e.size;
+    }
+    for (const auto& [id, c] : scan.chunks) {
+        bytes += c.size;
+    }
+    return bytes;
+}
+
+auto NodeOutputCache::entries() const -> std::vector<Entry>
+{
+    std::vector<Entry> entries;
+    for (const auto& e : ScanCache(root_).entries) {
+        Entry entry{e.key, 0, e.size, e.mtime};
+        if (e.packed) {
+            entry.files = e.manifest.files.size();
+            entry.bytes = 0;
+            for (const auto& f : e.manifest.files) {
+                entry.bytes += f.size;
+            }
+        } else {
+            entry.files = DirectorySize(e.path).first;
+        }
+        entries.emplace_back(entry);
+    }
+    return entries;
+}
+
+auto NodeOutputCache::load(const std::string& key, const IOFunction& reader)
+    -> bool
+{
+    // Earlier releases stored every entry as a directory
+    auto dir = root_ / key;
+    auto manifestPath = entry_path_(key);
+    auto packed = fs::exists(manifestPath);
+    if (not packed and not fs::is_directory(dir)) {
+        return false;
+    }
+
+    auto tmp = root_ / (key + TempSuffix());
+    try {
+        if (packed) {
+            auto manifest = ReadManifest(manifestPath);
+            Touch(manifestPath);
+            fs::create_directories(tmp);
+            for (const auto& f : manifest.files) {
+                UnpackFile(root_, f, manifest.chunkSize, tmp / f.name);
+            }
+            reader(tmp);
+        } else {
+            Touch(dir);
+            reader(dir);
+        }
+    } catch (const std::exception& e) {
+        Logger()->warn(
+            "Discarding unreadable cache entry {}: {}", key, e.what());
+        RemoveAll(tmp);
+        // Another render may have replaced the entry
+        RemoveAll(packed ? manifestPath : dir);
+        return false;
+    }
+    RemoveAll(tmp);
+    return true;
+}
+
+void NodeOutputCache::store(const std::string& key, const IOFunction& writer)
+{
+    auto tmp = root_ / (key + TempSuffix());
+    fs::create_directories(tmp);
+    try {
+        writer(tmp);
+
+        // Sort the files so that identical outputs have identical manifests
+        std::vector<fs::path> paths;
+        for (const auto& it : fs::recursive_directory_iterator(tmp)) {
+            if (fs::is_regular_file(it.path())) {
+                paths.emplace_back(it.path());
+            }
+        }
+        std::sort(paths.begin(), paths.end());
+
+        Manifest manifest;
+        for (const auto& p : paths) {
+            auto name = fs::relative(p, tmp).generic_string();
+            manifest.files.emplace_back(PackFile(root_, p, name));
+        }
+        WriteManifest(entry_path_(key), manifest);
+    } catch (...) {
+        RemoveAll(tmp);
+        throw;
+    }
+    RemoveAll(tmp);
+    RemoveAll(root_ / key);
+
+    // Leave some room so that every store does not trigger a trim
+    if (bytes() > capacity_) {
+        trimTo(capacity_ / 10 * 9);
+    }
+}
+
+void NodeOutputCache::remove(const std::string& key)
+{
+    RemoveAll(entry_path_(key));
+    RemoveAll(root_ / key);
+}
+
+void NodeOutputCache::trim() { trimTo(capacity_); }
+
+void NodeOutputCache::trimTo(std::size_t target)
+{
+    const std::lock_guard<std::mutex> lock(mutex_);
+    auto scan = ScanCache(root_);
+    const auto now = Now();
+
+    // Count the references to each chunk
+    std::unordered_map<std::uint64_t, std::size_t> refs;
+    std::size_t total{0};
+    std::size_t unreadable{0};
+    for (const auto& e : scan.entries) {
+        total += e.size;
+        if (not e.readable) {
+            unreadable++;
+        }
+        for (const auto& f : e.manifest.files) {
+            for (const auto& c : f.chunks) {
+                refs[c]++;
+            }
+        }
+    }
+    for (const auto& [id, c] : scan.chunks) {
+        total += c.size;
+    }
+
+    // Chunks are only referenced once their entry's manifest is written, so
+    // recent chunks are kept until the grace period has passed. The chunks
+    // of an unreadable manifest are unknown, so no chunk is removed while one
+    // remains.
+    auto removeChunk = [&](std::uint64_t id) {
+        auto it = scan.chunks.find(id);
+        if (unreadable > 0 or it == scan.chunks.end() or
+            now - it->second.mtime < GRACE_PERIOD_NS) {
+            return;
+        }
+        if (::unlink(it->second.path.c_str()) == 0) {
+            total -= std::min(total, it->second.size);
+        }
+        scan.chunks.erase(it);
+    };
+
+    // Remove the leftovers of interrupted stores and loads
+    for (const auto& t : scan.temps) {
+        if (now - t.mtime >= GRACE_PERIOD_NS) {
+            RemoveAll(t.path);
+        }
+    }
+
+    if (unreadable > 0) {
+        Logger()->warn(
+            "Not removing cache chunks: {} entries are unreadable",
+            unreadable);
+    }
+
+    // Remove the unused chunks
+    std::vector<std::uint64_t> unused;
+    for (const auto& [id, c] : scan.chunks) {
+        if (refs.count(id) == 0) {
+            unused.push_back(id);
+        }
+    }
+    for (const auto& id : unused) {
+        removeChunk(id);
+    }
+
+    // Remove the least recently used entries and the chunks only they used
+    std::sort(
+        scan.entries.begin(), scan.entries.end(),
+        [](const auto& a, const auto& b) { return a.mtime < b.mtime; });
+    for (const auto& e : scan.entries) {
+        if (total <= target) {
+            break;
+        }
+        RemoveAll(e.path);
+        total -= std::min(total, e.size);
+        if (not e.readable) {
+            unreadable--;
+            continue;
+        }
+        for (const auto& f : e.manifest.files) {
+            for (const auto& c : f.chunks) {
+                if (--refs[c] == 0) {
+                    removeChunk(c);
+                }
+            }
+        }
+    }
+}
+
+void NodeOutputCache::purge()
+{
+    const std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& it : fs::directory_iterator(root_)) {
+        RemoveAll(it.path());
+    }
+    fs::create_directories(root_ / CHUNK_DIR);
+}
+
+auto NodeOutputCache::entry_path_(const std::string& key) const -> fs::path
+{
+    return root_ / (key + MANIFEST_EXT);
+}
+
+void MemoizedNode::setOutputCache(NodeOutputCache::Pointer cache)
+{
+    cache_ = std::move(cache);
+}
+
+auto MemoizedNode::outputCache() const -> NodeOutputCache::Pointer
+{
+    return cache_;
+}
+
+void MemoizedNode::memoize_(
+    const std::string& name,
+    const ContentHash& inputs,
+    const std::function<void()>& compute,
+    const NodeOutputCache::IOFunction& save,
+    const NodeOutputCache::IOFunction& load)
+{
+    if (not cache_) {
+        compute();
+        return;
+    }
+
+    // Outputs may change between releases, so the version is part of the key
+    ContentHash h;
+    h.update(ProjectInfo::VersionString()).update(name).update(inputs.value());
+    auto key = name + "-" + h.hex();
+
+    if (cache_->load(key, load)) {
+        Logger()->info("{}: Loaded cached outputs", name);
+        return;
+    }
+
+    compute();
+    try {
+        cache_->store(key, save);
+    } catch (const std::exception& e) {
+        Logger()->warn("{}: Failed to cache outputs: {}", name, e.what());
+        return;
+    }
+
+    // Use exactly what later renders will load
+    if (not cache_->load(key, load)) {
+        Logger()->warn("{}: Failed to reload cached outputs", name);
+        compute();
+    }
+}
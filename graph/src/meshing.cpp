@@ -21,20 +21,62 @@ NLOHMANN_JSON_SERIALIZE_ENUM(ResampleMode, {
 // clang-format on
 }  // namespace volcart::meshing
 
+namespace volcart
+{
+// clang-format off
+using ResampleMethod = ResampleMeshNode::Method;
+NLOHMANN_JSON_SERIALIZE_ENUM(ResampleMethod, {
+    {ResampleMethod::ACVD, "acvd"},
+    {ResampleMethod::QuadricEdgeCollapse, "quadric"}
+})
+// clang-format on
+}  // namespace volcart
+
+namespace
+{
+// Write a mesh output into a node's cache. Returns false if it is unset.
+auto WriteMeshOutput(const fs::path& path, const ITKMesh::Pointer& mesh)
+    -> bool
+{
+    if (not mesh) {
+        return false;
+    }
+    WriteMesh(path, mesh);
+    return true;
+}
+
+// Read a mesh output from a node's cache when it is first used
+void ReadMeshOutput(
+    LazyValue<ITKMesh::Pointer>& mesh,
+    const fs::path& path,
+    memory::TrackedBytes& memory)
+{
+    mesh.setFile(path, [&memory](const fs::path& p) {
+        auto m = ReadMesh(p).mesh;
+        memory.set(meshmath::MemoryInBytes(m));
+        return m;
+    });
+}
+}  // namespace
+
 MeshingNode::MeshingNode()
-    : Node{true}, points{&mesher_, &Mesher::setPointSet}, mesh{&mesh_}
+    : Node{true}
+    , points{&mesher_, &Mesher::setPointSet}
+    , mesh{[=]() { return mesh_.get(); }}
 {
     registerInputPort("points", points);
     registerOutputPort("mesh", mesh);
-    compute = [=]() { mesh_ = mesher_.compute(); };
+    compute = [=]() {
+        mesh_ = mesher_.compute();
+        meshMemory_.set(meshmath::MemoryInBytes(mesh_.get()));
+    };
 }
 
 auto MeshingNode::serialize_(bool useCache, const fs::path& cacheDir)
     -> smgl::Metadata
 {
     smgl::Metadata meta;
-    if (useCache and mesh_) {
-        WriteMesh(cacheDir / "mesh.obj", mesh_);
+    if (useCache and mesh_.save(cacheDir / "mesh.obj", WriteMeshOutput)) {
         meta["mesh"] = "mesh.obj";
     }
     return meta;
@@ -45,12 +87,15 @@ void MeshingNode::deserialize_(
 {
     if (meta.contains("mesh")) {
         auto meshFile = meta["mesh"].get<std::string>();
-        mesh_ = ReadMesh(cacheDir / meshFile).mesh;
+        ReadMeshOutput(mesh_, cacheDir / meshFile, meshMemory_);
     }
 }
 
 ScaleMeshNode::ScaleMeshNode()
-    : Node{true}, input{&input_}, scaleFactor{&scaleFactor_}, output{&output_}
+    : Node{true}
+    , input{&input_}
+    , scaleFactor{&scaleFactor_}
+    , output{[=]() { return output_.get(); }}
 {
     registerInputPort("input", input);
     registerInputPort("scaleFactor", scaleFactor);
@@ -59,6 +104,7 @@ ScaleMeshNode::ScaleMeshNode()
     compute = [=]() {
         if (input_) {
             output_ = ScaleMesh(input_, scaleFactor_);
+            meshMemory_.set(meshmath::MemoryInBytes(output_.get()));
         }
     };
 }
@@ -67,8 +113,7 @@ auto ScaleMeshNode::serialize_(bool useCache, const fs::path& cacheDir)
     -> smgl::Metadata
 {
     smgl::Metadata meta{{"scaleFactor", scaleFactor_}};
-    if (useCache and output_) {
-        WriteMesh(cacheDir / "scaled.obj", output_);
+    if (useCache and output_.save(cacheDir / "scaled.obj", WriteMeshOutput)) {
         meta["output"] = "scaled.obj";
     }
     return meta;
@@ -80,7 +125,7 @@ void ScaleMeshNode::deserialize_(
     scaleFactor_ = meta["scaleFactor"].get<double>();
     if (meta.contains("output")) {
         auto meshFile = meta["output"].get<std::string>();
-        output_ = ReadMesh(cacheDir / meshFile).mesh;
+        ReadMeshOutput(output_, cacheDir / meshFile, meshMemory_);
     }
 }
 
@@ -123,11 +168,16 @@ void CalculateNumVertsNode::deserialize_(
 }
 
 LaplacianSmoothMeshNode::LaplacianSmoothMeshNode()
-    : Node{true}, input{&smoother_, &Smoother::setInputMesh}, output{&mesh_}
+    : Node{true}
+    , input{&smoother_, &Smoother::setInputMesh}
+    , output{[=]() { return mesh_.get(); }}
 {
     registerInputPort("input", input);
     registerOutputPort("output", output);
-    compute = [=]() { mesh_ = smoother_.compute(); };
+    compute = [=]() {
+        mesh_ = smoother_.compute();
+        meshMemory_.set(meshmath::MemoryInBytes(mesh_.get()));
+    };
 }
 
 auto LaplacianSmoothMeshNode::serialize_(
@@ -140,8 +190,7 @@ auto LaplacianSmoothMeshNode::serialize_(
         {"featureAngle", smoother_.featureAngle()},
         {"edgeAngle", smoother_.edgeAngle()},
         {"boundarySmoothing", smoother_.boundarySmoothing()}};
-    if (useCache and mesh_) {
-        WriteMesh(cacheDir / "smoothed.obj", mesh_);
+    if (useCache and mesh_.save(cacheDir / "smoothed.obj", WriteMeshOutput)) {
         meta["mesh"] = "smoothed.obj";
     }
     return meta;
@@ -159,41 +208,81 @@ void LaplacianSmoothMeshNode::deserialize_(
 
     if (meta.contains("mesh")) {
         auto meshFile = meta["mesh"].get<std::string>();
-        mesh_ = ReadMesh(cacheDir / meshFile).mesh;
+        ReadMeshOutput(mesh_, cacheDir / meshFile, meshMemory_);
     }
 }
 
 ResampleMeshNode::ResampleMeshNode()
     : Node{true}
-    , input{&acvd_, &ACVD::setInputMesh}
+    , input{[=](const auto& m) {
+        input_ = m;
+        acvd_.setInputMesh(m);
+    }}
+    , method{&method_}
     , mode{&acvd_, &ACVD::setMode}
-    , numVertices{&acvd_, &ACVD::setNumberOfClusters}
+    , numVertices{[=](const auto& n) {
+        acvd_.setNumberOfClusters(n);
+        decimator_.setTargetVertices(n);
+    }}
     , gradation{&acvd_, &ACVD::setGradation}
     , subsampleThreshold{&acvd_, &ACVD::setSubsampleThreshold}
     , quadricsOptimizationLevel{&acvd_, &ACVD::setQuadricsOptimizationLevel}
-    , output{&mesh_}
+    , numThreads{[=](const auto& n) {
+        acvd_.setNumThreads(n);
+        decimator_.setNumThreads(n);
+    }}
+    , output{[=]() { return mesh_.get(); }}
 {
     registerInputPort("input", input);
+    registerInputPort("method", method);
     registerInputPort("mode", mode);
     registerInputPort("numVertices", numVertices);
     registerInputPort("gradation", gradation);
     registerInputPort("subsampleThreshold", subsampleThreshold);
     registerInputPort("quadricsOptimizationLevel", quadricsOptimizationLevel);
+    registerInputPort("numThreads", numThreads);
     registerOutputPort("output", output);
-    compute = [=]() { mesh_ = acvd_.compute(); };
+    compute = [=]() {
+        ContentHash inputs;
+        inputs.update(input_)
+            .update(method_)
+            .update(acvd_.mode())
+            .update(acvd_.numberOfClusters())
+            .update(acvd_.gradation())
+            .update(acvd_.subsampleThreshold())
+            .update(acvd_.quadricsOptimizationLevel());
+        auto resample = [=]() {
+            if (method_ == Method::QuadricEdgeCollapse) {
+                decimator_.setInputMesh(input_);
+                mesh_ = decimator_.compute();
+            } else {
+                mesh_ = acvd_.compute();
+            }
+        };
+        memoize_(
+            "ResampleMeshNode", inputs, resample,
+            [=](const fs::path& dir) {
+                WriteMesh(dir / "mesh.obj", mesh_.get());
+            },
+            [=](const fs::path& dir) {
+                mesh_ = ReadMesh(dir / "mesh.obj").mesh;
+            });
+        meshMemory_.set(meshmath::MemoryInBytes(mesh_.get()));
+    };
 }
 
 auto ResampleMeshNode::serialize_(bool useCache, const fs::path& cacheDir)
     -> smgl::Metadata
 {
     smgl::Metadata meta{
+        {"method", method_},
         {"mode", acvd_.mode()},
         {"numVertices", acvd_.numberOfClusters()},
         {"gradation", acvd_.gradation()},
         {"subsampleThreshold", acvd_.subsampleThreshold()},
         {"quadricsOptimizationLevel", acvd_.quadricsOptimizationLevel()}};
-    if (useCache and mesh_) {
-        WriteMesh(cacheDir / "resampled.obj", mesh_);
+    if (useCache and
+        mesh_.save(cacheDir / "resampled.obj", WriteMeshOutput)) {
         meta["mesh"] = "resampled.obj";
     }
     return meta;
@@ -202,8 +291,11 @@ auto ResampleMeshNode::serialize_(bool useCache, const fs::path& cacheDir)
 void ResampleMeshNode::deserialize_(
     const smgl::Metadata& meta, const fs::path& cacheDir)
 {
+    // Graphs saved before quadric decimation was added always used ACVD
+    method_ = meta.value("method", Method::ACVD);
     acvd_.setMode(meta["mode"].get<Mode>());
     acvd_.setNumberOfClusters(meta["numVertices"].get<std::size_t>());
+    decimator_.setTargetVertices(acvd_.numberOfClusters());
     acvd_.setGradation(meta["gradation"].get<double>());
     acvd_.setSubsampleThreshold(meta["subsampleThreshold"].get<std::size_t>());
     acvd_.setQuadricsOptimizationLevel(
@@ -211,7 +303,7 @@ void ResampleMeshNode::deserialize_(
 
     if (meta.contains("mesh")) {
         auto meshFile = meta["mesh"].get<std::string>();
-        mesh_ = ReadMesh(cacheDir / meshFile).mesh;
+        ReadMeshOutput(mesh_, cacheDir / meshFile, meshMemory_);
     }
 }
 
@@ -220,7 +312,7 @@ UVMapToMeshNode::UVMapToMeshNode()
     , inputMesh{&mesher_, &UVMapToITKMesh::setMesh}
     , uvMap{&mesher_, &UVMapToITKMesh::setUVMap}
     , scaleToUVDimensions{&scaleDims_}
-    , outputMesh{&output_}
+    , outputMesh{[=]() { return output_.get(); }}
 {
     registerInputPort("inputMesh", inputMesh);
     registerInputPort("uvMap", uvMap);
@@ -230,6 +322,7 @@ UVMapToMeshNode::UVMapToMeshNode()
     compute = [=]() {
         mesher_.setScaleToUVDimensions(scaleDims_);
         output_ = mesher_.compute();
+        meshMemory_.set(meshmath::MemoryInBytes(output_.get()));
     };
 }
 
@@ -237,8 +330,7 @@ auto UVMapToMeshNode::serialize_(bool useCache, const fs::path& cacheDir)
     -> smgl::Metadata
 {
     smgl::Metadata meta{{"scaleToUVDims", scaleDims_}};
-    if (useCache and output_) {
-        WriteMesh(cacheDir / "uvMesh.obj", output_);
+    if (useCache and output_.save(cacheDir / "uvMesh.obj", WriteMeshOutput)) {
         meta["mesh"] = "uvMesh.obj";
     }
     return meta;
@@ -250,6 +342,6 @@ void UVMapToMeshNode::deserialize_(
     scaleDims_ = meta["scaleToUVDims"].get<bool>();
     if (meta.contains("mesh")) {
         auto file = meta["mesh"].get<std::string>();
-        output_ = ReadMesh(cacheDir / file).mesh;
+        ReadMeshOutput(output_, cacheDir / file, meshMemory_);
     }
 }
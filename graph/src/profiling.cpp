@@ -0,0 +1,185 @@
+#include "vc/graph/profiling.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iomanip>
+#include <sstream>
+
+#include <cxxabi.h>
+#include <sys/resource.h>
+
+#include "vc/core/util/Logging.hpp"
+#include "vc/core/util/MemoryUsage.hpp"
+#include "vc/core/util/Tracing.hpp"
+
+using namespace volcart;
+
+namespace
+{
+using Clock = std::chrono::steady_clock;
+
+// Resource usage of the process at a point in time
+struct Usage {
+    Clock::time_point wall;
+    std::chrono::duration<double> cpu;
+    std::uint64_t peakRSS;
+};
+
+auto Now() -> Usage
+{
+    rusage r{};
+    getrusage(RUSAGE_SELF, &r);
+    auto seconds = [](const timeval& t) {
+        return static_cast<double>(t.tv_sec) + t.tv_usec / 1e6;
+    };
+    // ru_maxrss is in bytes on macOS and in kilobytes elsewhere
+#ifdef __APPLE__
+    auto peak = static_cast<std::uint64_t>(r.ru_maxrss);
+#else
+    auto peak = static_cast<std::uint64_t>(r.ru_maxrss) * 1024;
+#endif
+    return {
+        Clock::now(),
+        std::chrono::duration<double>(
+            seconds(r.ru_utime) + seconds(r.ru_stime)),
+        peak};
+}
+}  // namespace
+
+GraphProfiler::GraphProfiler(std::shared_ptr<smgl::Graph> graph)
+    : graph_{std::move(graph)}
+{
+}
+
+void GraphProfiler::attach(const smgl::Node::Pointer& node, std::string name)
+{
+    if (not node->compute) {
+        return;
+    }
+
+    std::size_t idx;
+    {
+        const std::lock_guard<std::mutex> lock(mutex_);
+        idx = profiles_.size();
+        NodeProfile p;
+        p.name = name;
+        profiles_.push_back(p);
+    }
+
+    auto compute = node->compute;
+    node->compute = [this, idx, compute, name = std::move(name)]() {
+        VC_TRACE_SPAN_CAT("graph", name);
+        auto before = Now();
+        auto record = [&]() {
+            auto after = Now();
+            NodeProfile p;
+            p.wallTime = after.wall - before.wall;
+            p.cpuTime = after.cpu - before.cpu;
+            p.peakRSSDelta = after.peakRSS - before.peakRSS;
+            Logger()->debug("Memory after {}: {}", name, memory::Summary());
+            p.trackedBytes = memory::Total();
+            record_(idx, p);
+        };
+        try {
+            compute();
+        } catch (...) {
+            record();
+            throw;
+        }
+        record();
+    };
+}
+
+void GraphProfiler::record_(std::size_t idx, const NodeProfile& p)
+{
+    const std::lock_guard<std::mutex> lock(mutex_);
+    auto& profile = profiles_[idx];
+    if (profile.calls == 0) {
+        order_.push_back(idx);
+    }
+    profile.calls++;
+    profile.wallTime += p.wallTime;
+    profile.cpuTime += p.cpuTime;
+    profile.peakRSSDelta += p.peakRSSDelta;
+    profile.trackedBytes = p.trackedBytes;
+}
+
+auto GraphProfiler::profiles() const -> std::vector<NodeProfile>
+{
+    const std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<NodeProfile> result;
+    result.reserve(order_.size());
+    for (auto idx : order_) {
+        result.push_back(profiles_[idx]);
+    }
+    return result;
+}
+
+auto GraphProfiler::metadata() const -> smgl::Metadata
+{
+    auto nodes = smgl::Metadata::array();
+    for (const auto& p : profiles()) {
+        nodes.push_back(
+            {{"node", p.name},
+             {"calls", p.calls},
+             {"wallSeconds", p.wallTime.count()},
+             {"cpuSeconds", p.cpuTime.count()},
+             {"peakRSSDeltaBytes", p.peakRSSDelta},
+             {"trackedBytes", p.trackedBytes}});
+    }
+    return {{"nodes", nodes}};
+}
+
+auto GraphProfiler::summary() const -> std::string
+{
+    auto profiles = this->profiles();
+    std::size_t width{4};
+    for (const auto& p : profiles) {
+        width = std::max(width, p.name.size());
+    }
+
+    std::stringstream ss;
+    ss << std::fixed << std::setprecision(2) << std::left;
+    ss << std::setw(width) << "Node" << std::right << std::setw(12)
+       << "Wall (s)" << std::setw(12) << "CPU (s)" << std::setw(16)
+       << "RSS growth (MB)" << std::setw(14) << "Tracked (MB)" << "\n";
+
+    std::chrono::duration<double> wall{0};
+    std::chrono::duration<double> cpu{0};
+    std::uint64_t rss{0};
+    std::uint64_t tracked{0};
+    auto row = [&](const std::string& name, double w, double c, double r,
+                   double t) {
+        ss << std::left << std::setw(width) << name << std::right
+           << std::setw(12) << w << std::setw(12) << c << std::setw(16)
+           << r / (1024. * 1024.) << std::setw(14) << t / (1024. * 1024.)
+           << "\n";
+    };
+    for (const auto& p : profiles) {
+        row(p.name, p.wallTime.count(), p.cpuTime.count(),
+            double(p.peakRSSDelta), double(p.trackedBytes));
+        wall += p.wallTime;
+        cpu += p.cpuTime;
+        rss += p.peakRSSDelta;
+        tracked = std::max(tracked, p.trackedBytes);
+    }
+
+    // The tracked total is a snapshot, so report its maximum
+    row("Total", wall.count(), cpu.count(), double(rss), double(tracked));
+    return ss.str();
+}
+
+auto GraphProfiler::NodeTypeName(const std::type_info& t) -> std::string
+{
+    int status{0};
+    std::unique_ptr<char, void (*)(void*)> demangled{
+        abi::__cxa_demangle(t.name(), nullptr, nullptr, &status), std::free};
+    std::string name = (status == 0) ? demangled.get() : t.name();
+
+    // Strip the project namespace
+    const std::string prefix{"volcart::"};
+    if (name.rfind(prefix, 0) == 0) {
+        name = name.substr(prefix.size());
+    }
+    return name;
+}
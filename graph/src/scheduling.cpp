@@ -0,0 +1,86 @@
+#include "vc/graph/scheduling.hpp"
+
+#include "vc/core/util/ThreadPool.hpp"
+
+using namespace volcart;
+
+AsyncNodeExecutor::AsyncNodeExecutor(std::size_t numThreads)
+    : maxRunners_{numThreads}
+{
+    if (maxRunners_ == 0) {
+        maxRunners_ = ThreadPool::Global().numThreads();
+    }
+}
+
+AsyncNodeExecutor::~AsyncNodeExecutor()
+{
+    try {
+        wait();
+    } catch (...) {
+        // Errors are only reported by wait()
+    }
+}
+
+void AsyncNodeExecutor::attach(const smgl::Node::Pointer& node)
+{
+    if (not node->compute) {
+        return;
+    }
+
+    auto compute = node->compute;
+    node->compute = [this, compute]() { enqueue_(compute); };
+}
+
+void AsyncNodeExecutor::wait()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    doneCv_.wait(lock, [this]() { return pending_ == 0; });
+    if (error_) {
+        auto error = error_;
+        error_ = nullptr;
+        std::rethrow_exception(error);
+    }
+}
+
+void AsyncNodeExecutor::enqueue_(std::function<void()> task)
+{
+    {
+        const std::lock_guard<std::mutex> lock(mutex_);
+        queue_.push_back(std::move(task));
+        pending_++;
+        if (runners_ >= maxRunners_) {
+            return;
+        }
+        runners_++;
+    }
+    // Nobody waits on the future: wait() tracks completion through pending_
+    ThreadPool::Global().submit([this]() { run_(); });
+}
+
+void AsyncNodeExecutor::run_()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (not queue_.empty()) {
+        auto task = std::move(queue_.front());
+        queue_.pop_front();
+        lock.unlock();
+
+        std::exception_ptr error;
+        try {
+            task();
+        } catch (...) {
+            error = std::current_exception();
+        }
+
+        lock.lock();
+        if (error and not error_) {
+            error_ = error;
+        }
+        pending_--;
+        doneCv_.notify_all();
+    }
+
+    // The lock is held until this task returns, so wait() cannot return and
+    // let the executor be destroyed while it is still in use
+    runners_--;
+}
@@ -1,16 +1,24 @@
 #include "vc/graph/texturing.hpp"
 
+#include <cstdint>
+#include <future>
+#include <map>
+#include <mutex>
+
 #include <nlohmann/json.hpp>
 
+#include "vc/core/io/AsyncImageWriter.hpp"
 #include "vc/core/io/ImageIO.hpp"
 #include "vc/core/io/MeshIO.hpp"
 #include "vc/core/io/PointSetIO.hpp"
 #include "vc/core/io/UVMapIO.hpp"
 #include "vc/core/neighborhood/CuboidGenerator.hpp"
 #include "vc/core/neighborhood/LineGenerator.hpp"
+#include "vc/core/types/FlatMesh.hpp"
 #include "vc/core/types/PointSet.hpp"
 #include "vc/core/util/FloatComparison.hpp"
 #include "vc/core/util/Logging.hpp"
+#include "vc/texturing/MeshBVH.hpp"
 
 using namespace volcart;
 using namespace volcart::texturing;
@@ -37,6 +45,14 @@ NLOHMANN_JSON_SERIALIZE_ENUM(Direction, {
 namespace volcart::texturing
 {
 // clang-format off
+using Solver = AngleBasedFlattening::Solver;
+NLOHMANN_JSON_SERIALIZE_ENUM(Solver, {
+    {Solver::SparseLU, "sparse_lu"},
+    {Solver::SimplicialLDLT, "simplicial_ldlt"},
+    {Solver::ConjugateGradient, "conjugate_gradient"},
+    {Solver::Cholmod, "cholmod"}
+})
+
 using Shading = PPMGeneratorNode::Shading;
 NLOHMANN_JSON_SERIALIZE_ENUM(Shading, {
     {Shading::Flat, "flat"},
@@ -52,6 +68,17 @@ NLOHMANN_JSON_SERIALIZE_ENUM(Filter, {
     {Filter::MedianAverage, "median_average"}
 })
 
+using Output = MultiTextureNode::Output;
+NLOHMANN_JSON_SERIALIZE_ENUM(Output, {
+    {Output::Minimum, "minimum"},
+    {Output::Maximum, "maximum"},
+    {Output::Median, "median"},
+    {Output::Mean, "mean"},
+    {Output::MedianAverage, "median_average"},
+    {Output::Integral, "integral"},
+    {Output::Layers, "layers"}
+})
+
 using WeightMethod = IntegralTextureNode::WeightMethod;
 NLOHMANN_JSON_SERIALIZE_ENUM(WeightMethod, {
     {WeightMethod::None, "none"},
@@ -74,21 +101,169 @@ NLOHMANN_JSON_SERIALIZE_ENUM(ExpoDiffBaseMethod, {
 // clang-format on
 }  // namespace volcart::texturing
 
+namespace
+{
+// Write a mesh output into a node's cache. Returns false if it is unset.
+auto WriteMeshOutput(const fs::path& path, const ITKMesh::Pointer& mesh)
+    -> bool
+{
+    if (not mesh) {
+        return false;
+    }
+    WriteMesh(path, mesh);
+    return true;
+}
+
+// Read a mesh output from a node's cache when it is first used
+void ReadMeshOutput(LazyValue<ITKMesh::Pointer>& mesh, const fs::path& path)
+{
+    mesh.setFile(path, [](const fs::path& p) { return ReadMesh(p).mesh; });
+}
+
+// Write a UV map output into a node's cache. Returns false if it is empty.
+auto WriteUVMapOutput(const fs::path& path, const UVMap::Pointer& uvMap)
+    -> bool
+{
+    if (not uvMap or uvMap->empty()) {
+        return false;
+    }
+    io::WriteUVMap(path, *uvMap);
+    return true;
+}
+
+// Read a UV map output from a node's cache when it is first used
+void ReadUVMapOutput(LazyValue<UVMap::Pointer>& uvMap, const fs::path& path)
+{
+    uvMap.setFile(path, [](const fs::path& p) {
+        return UVMap::New(io::ReadUVMap(p));
+    });
+}
+
+// Write an image output into a node's cache. Returns false if it is empty.
+auto WriteImageOutput(const fs::path& path, const cv::Mat& image) -> bool
+{
+    if (image.empty()) {
+        return false;
+    }
+    WriteImage(path, image);
+    return true;
+}
+
+// Read an image output from a node's cache when it is first used
+void ReadImageOutput(LazyValue<cv::Mat>& image, const fs::path& path)
+{
+    image.setFile(path, [](const fs::path& p) { return ReadImage(p); });
+}
+
+// Get the UV-space BVH of a mesh. The parts of a multi-part render each have
+// their own PPMGeneratorNode, so BVHs are shared in-process by the hash of
+// the mesh and UV map, and concurrent requests for the same BVH wait for a
+// single build. A BVH is released once no node holds it. If an output cache
+// is available, BVHs are also stored in it so that later renders only read
+// them.
+auto SharedUVBVH(
+    const ContentHash& geometry,
+    const ITKMesh::Pointer& mesh,
+    const UVMap::Pointer& uvMap,
+    const NodeOutputCache::Pointer& cache) -> MeshBVH::Pointer
+{
+    using Future = std::shared_future<MeshBVH::Pointer>;
+    static std::mutex mutex;
+    static std::map<std::uint64_t, std::weak_ptr<const MeshBVH>> shared;
+    static std::map<std::uint64_t, Future> building;
+
+    const auto id = geometry.value();
+    std::unique_lock<std::mutex> lock(mutex);
+    if (auto it = shared.find(id); it != shared.end()) {
+        if (auto bvh = it->second.lock()) {
+            return bvh;
+        }
+        shared.erase(it);
+    }
+    if (auto it = building.find(id); it != building.end()) {
+        auto future = it->second;
+        lock.unlock();
+        return future.get();
+    }
+    std::promise<MeshBVH::Pointer> promise;
+    building[id] = promise.get_future().share();
+    lock.unlock();
+
+    MeshBVH::Pointer bvh;
+    try {
+        const auto key = "MeshBVH-" + geometry.hex();
+        if (cache) {
+            cache->load(key, [&](const fs::path& dir) {
+                bvh = MeshBVH::Read(dir / "MeshBVH.bvh");
+            });
+        }
+        if (not bvh) {
+            bvh = MeshBVH::NewUV(ToFlatMesh(mesh), *uvMap);
+            if (cache) {
+                cache->store(key, [&](const fs::path& dir) {
+                    MeshBVH::Write(dir / "MeshBVH.bvh", *bvh);
+                });
+            }
+        }
+    } catch (...) {
+        lock.lock();
+        building.erase(id);
+        lock.unlock();
+        promise.set_exception(std::current_exception());
+        throw;
+    }
+
+    lock.lock();
+    shared[id] = bvh;
+    building.erase(id);
+    lock.unlock();
+    promise.set_value(bvh);
+    return bvh;
+}
+}  // namespace
+
 ABFNode::ABFNode()
     : Node{true}
-    , input{&abf_, &ABF::setMesh}
+    , input{[=](const auto& m) {
+        input_ = m;
+        abf_.setMesh(m);
+    }}
     , useABF{&abf_, &ABF::setUseABF}
-    , output{&mesh_}
-    , uvMap{&uvMap_}
+    , seedUVMap{&abf_, &ABF::setSeedUVMap}
+    , solver{&abf_, &ABF::setSolver}
+    , output{[=]() { return mesh_.get(); }}
+    , uvMap{[=]() { return uvMap_.get(); }}
 {
     registerInputPort("input", input);
     registerInputPort("useABF", useABF);
+    registerInputPort("seedUVMap", seedUVMap);
+    registerInputPort("solver", solver);
     registerOutputPort("output", output);
     registerOutputPort("uvMap", uvMap);
 
     compute = [=]() {
-        mesh_ = abf_.compute();
-        uvMap_ = abf_.getUVMap();
+        ContentHash inputs;
+        inputs.update(input_)
+            .update(abf_.useABF())
+            .update(abf_.abfMaxIterations())
+            .update(abf_.solver());
+        if (auto seed = abf_.seedUVMap()) {
+            inputs.update(seed);
+        }
+        memoize_(
+            "ABFNode", inputs,
+            [=]() {
+                mesh_ = abf_.compute();
+                uvMap_ = abf_.getUVMap();
+            },
+            [=](const fs::path& dir) {
+                io::WriteUVMap(dir / "uvMap.uvm", *uvMap_.get());
+                WriteMesh(dir / "uvMesh.obj", mesh_.get());
+            },
+            [=](const fs::path& dir) {
+                uvMap_ = UVMap::New(io::ReadUVMap(dir / "uvMap.uvm"));
+                mesh_ = ReadMesh(dir / "uvMesh.obj").mesh;
+            });
     };
 }
 
@@ -97,13 +272,15 @@ auto ABFNode::serialize_(bool useCache, const fs::path& cacheDir)
 {
     smgl::Metadata meta{
         {"useABF", abf_.useABF()},
-        {"abfMaxIterations", abf_.abfMaxIterations()}};
+        {"abfMaxIterations", abf_.abfMaxIterations()},
+        {"solver", abf_.solver()}};
 
-    if (useCache and uvMap_ and not uvMap_->empty()) {
-        io::WriteUVMap(cacheDir / "uvMap.uvm", *uvMap_);
+    if (useCache and
+        uvMap_.save(cacheDir / "uvMap.uvm", WriteUVMapOutput)) {
         meta["uvMap"] = "uvMap.uvm";
-        WriteMesh(cacheDir / "uvMesh.obj", mesh_);
-        meta["mesh"] = "uvMesh.obj";
+        if (mesh_.save(cacheDir / "uvMesh.obj", WriteMeshOutput)) {
+            meta["mesh"] = "uvMesh.obj";
+        }
     }
     return meta;
 }
@@ -112,23 +289,195 @@ void ABFNode::deserialize_(const smgl::Metadata& meta, const fs::path& cacheDir)
 {
     abf_.setUseABF(meta["useABF"].get<bool>());
     abf_.setABFMaxIterations(meta["abfMaxIterations"].get<std::size_t>());
+    // Graphs saved before the solver option was added
+    abf_.setSolver(meta.value("solver", ABF::Solver::SparseLU));
+
+    if (meta.contains("uvMap")) {
+        auto file = meta["uvMap"].get<std::string>();
+        ReadUVMapOutput(uvMap_, cacheDir / file);
+    }
+
+    if (meta.contains("mesh")) {
+        auto file = meta["mesh"].get<std::string>();
+        ReadMeshOutput(mesh_, cacheDir / file);
+    }
+}
+
+HierarchicalFlatteningNode::HierarchicalFlatteningNode()
+    : Node{true}
+    , input{[=](const auto& m) {
+        input_ = m;
+        flatten_.setMesh(m);
+    }}
+    , useABF{&flatten_, &Flattening::setUseABF}
+    , proxyVertices{&flatten_, &Flattening::setProxyVertices}
+    , relaxationIterations{&flatten_, &Flattening::setRelaxationIterations}
+    , solver{&flatten_, &Flattening::setSolver}
+    , output{[=]() { return mesh_.get(); }}
+    , uvMap{[=]() { return uvMap_.get(); }}
+{
+    registerInputPort("input", input);
+    registerInputPort("useABF", useABF);
+    registerInputPort("proxyVertices", proxyVertices);
+    registerInputPort("relaxationIterations", relaxationIterations);
+    registerInputPort("solver", solver);
+    registerOutputPort("output", output);
+    registerOutputPort("uvMap", uvMap);
+
+    compute = [=]() {
+        ContentHash inputs;
+        inputs.update(input_)
+            .update(flatten_.useABF())
+            .update(flatten_.abfMaxIterations())
+            .update(flatten_.proxyVertices())
+            .update(flatten_.relaxationIterations())
+            .update(flatten_.solver());
+        memoize_(
+            "HierarchicalFlatteningNode", inputs,
+            [=]() {
+                mesh_ = flatten_.compute();
+                uvMap_ = flatten_.getUVMap();
+            },
+            [=](const fs::path& dir) {
+                io::WriteUVMap(dir / "uvMap.uvm", *uvMap_.get());
+                WriteMesh(dir / "uvMesh.obj", mesh_.get());
+            },
+            [=](const fs::path& dir) {
+                uvMap_ = UVMap::New(io::ReadUVMap(dir / "uvMap.uvm"));
+                mesh_ = ReadMesh(dir / "uvMesh.obj").mesh;
+            });
+    };
+}
+
+auto HierarchicalFlatteningNode::serialize_(
+    bool useCache, const fs::path& cacheDir) -> smgl::Metadata
+{
+    smgl::Metadata meta{
+        {"useABF", flatten_.useABF()},
+        {"abfMaxIterations", flatten_.abfMaxIterations()},
+        {"proxyVertices", flatten_.proxyVertices()},
+        {"relaxationIterations", flatten_.relaxationIterations()},
+        {"solver", flatten_.solver()}};
+
+    if (useCache and
+        uvMap_.save(cacheDir / "uvMap.uvm", WriteUVMapOutput)) {
+        meta["uvMap"] = "uvMap.uvm";
+        if (mesh_.save(cacheDir / "uvMesh.obj", WriteMeshOutput)) {
+            meta["mesh"] = "uvMesh.obj";
+        }
+    }
+    return meta;
+}
+
+void HierarchicalFlatteningNode::deserialize_(
+    const smgl::Metadata& meta, const fs::path& cacheDir)
+{
+    flatten_.setUseABF(meta["useABF"].get<bool>());
+    flatten_.setABFMaxIterations(meta["abfMaxIterations"].get<std::size_t>());
+    flatten_.setProxyVertices(meta["proxyVertices"].get<std::size_t>());
+    flatten_.setRelaxationIterations(
+        meta["relaxationIterations"].get<std::size_t>());
+    // Graphs saved before the solver option was added
+    flatten_.setSolver(meta.value("solver", Solver::SparseLU));
+
+    if (meta.contains("uvMap")) {
+        auto file = meta["uvMap"].get<std::string>();
+        ReadUVMapOutput(uvMap_, cacheDir / file);
+    }
+
+    if (meta.contains("mesh")) {
+        auto file = meta["mesh"].get<std::string>();
+        ReadMeshOutput(mesh_, cacheDir / file);
+    }
+}
+
+ChartFlatteningNode::ChartFlatteningNode()
+    : Node{true}
+    , input{[=](const auto& m) {
+        input_ = m;
+        flatten_.setMesh(m);
+    }}
+    , useABF{&flatten_, &Flattening::setUseABF}
+    , solver{&flatten_, &Flattening::setSolver}
+    , padding{&flatten_, &Flattening::setPadding}
+    , output{[=]() { return mesh_.get(); }}
+    , uvMap{[=]() { return uvMap_.get(); }}
+{
+    registerInputPort("input", input);
+    registerInputPort("useABF", useABF);
+    registerInputPort("solver", solver);
+    registerInputPort("padding", padding);
+    registerOutputPort("output", output);
+    registerOutputPort("uvMap", uvMap);
+
+    compute = [=]() {
+        ContentHash inputs;
+        inputs.update(input_)
+            .update(flatten_.useABF())
+            .update(flatten_.abfMaxIterations())
+            .update(flatten_.solver())
+            .update(flatten_.padding());
+        memoize_(
+            "ChartFlatteningNode", inputs,
+            [=]() {
+                mesh_ = flatten_.compute();
+                uvMap_ = flatten_.getUVMap();
+            },
+            [=](const fs::path& dir) {
+                io::WriteUVMap(dir / "uvMap.uvm", *uvMap_.get());
+                WriteMesh(dir / "uvMesh.obj", mesh_.get());
+            },
+            [=](const fs::path& dir) {
+                uvMap_ = UVMap::New(io::ReadUVMap(dir / "uvMap.uvm"));
+                mesh_ = ReadMesh(dir / "uvMesh.obj").mesh;
+            });
+    };
+}
+
+auto ChartFlatteningNode::serialize_(bool useCache, const fs::path& cacheDir)
+    -> smgl::Metadata
+{
+    smgl::Metadata meta{
+        {"useABF", flatten_.useABF()},
+        {"abfMaxIterations", flatten_.abfMaxIterations()},
+        {"solver", flatten_.solver()},
+        {"padding", flatten_.padding()}};
+
+    if (useCache and
+        uvMap_.save(cacheDir / "uvMap.uvm", WriteUVMapOutput)) {
+        meta["uvMap"] = "uvMap.uvm";
+        if (mesh_.save(cacheDir / "uvMesh.obj", WriteMeshOutput)) {
+            meta["mesh"] = "uvMesh.obj";
+        }
+    }
+    return meta;
+}
+
+void ChartFlatteningNode::deserialize_(
+    const smgl::Metadata& meta, const fs::path& cacheDir)
+{
+    flatten_.setUseABF(meta["useABF"].get<bool>());
+    flatten_.setABFMaxIterations(meta["abfMaxIterations"].get<std::size_t>());
+    // Graphs saved before the solver option was added
+    flatten_.setSolver(meta.value("solver", Solver::SparseLU));
+    flatten_.setPadding(meta["padding"].get<double>());
 
     if (meta.contains("uvMap")) {
         auto file = meta["uvMap"].get<std::string>();
-        uvMap_ = UVMap::New(io::ReadUVMap(cacheDir / file));
+        ReadUVMapOutput(uvMap_, cacheDir / file);
     }
 
-    if (meta.contains("uvMesh")) {
-        auto file = meta["uvMesh"].get<std::string>();
-        mesh_ = ReadMesh(cacheDir / file).mesh;
+    if (meta.contains("mesh")) {
+        auto file = meta["mesh"].get<std::string>();
+        ReadMeshOutput(mesh_, cacheDir / file);
     }
 }
 
 OrthographicFlatteningNode::OrthographicFlatteningNode()
     : Node{true}
     , input{&ortho_, &Ortho::setMesh}
-    , output{&mesh_}
-    , uvMap{&uvMap_}
+    , output{[=]() { return mesh_.get(); }}
+    , uvMap{[=]() { return uvMap_.get(); }}
 {
     registerInputPort("input", input);
     registerOutputPort("output", output);
@@ -144,11 +493,12 @@ auto OrthographicFlatteningNode::serialize_(
     bool useCache, const fs::path& cacheDir) -> smgl::Metadata
 {
     smgl::Metadata meta;
-    if (useCache and uvMap_ and not uvMap_->empty()) {
-        io::WriteUVMap(cacheDir / "uvMap.uvm", *uvMap_);
+    if (useCache and
+        uvMap_.save(cacheDir / "uvMap.uvm", WriteUVMapOutput)) {
         meta["uvMap"] = "uvMap.uvm";
-        WriteMesh(cacheDir / "uvMesh.obj", mesh_);
-        meta["mesh"] = "uvMesh.obj";
+        if (mesh_.save(cacheDir / "uvMesh.obj", WriteMeshOutput)) {
+            meta["mesh"] = "uvMesh.obj";
+        }
     }
     return meta;
 }
@@ -158,12 +508,12 @@ void OrthographicFlatteningNode::deserialize_(
 {
     if (meta.contains("uvMap")) {
         auto file = meta["uvMap"].get<std::string>();
-        uvMap_ = UVMap::New(io::ReadUVMap(cacheDir / file));
+        ReadUVMapOutput(uvMap_, cacheDir / file);
     }
 
-    if (meta.contains("uvMesh")) {
-        auto file = meta["uvMesh"].get<std::string>();
-        mesh_ = ReadMesh(cacheDir / file).mesh;
+    if (meta.contains("mesh")) {
+        auto file = meta["mesh"].get<std::string>();
+        ReadMeshOutput(mesh_, cacheDir / file);
     }
 }
 
@@ -265,10 +615,14 @@ void PlotLStretchErrorNode::deserialize_(
 
 PPMGeneratorNode::PPMGeneratorNode()
     : Node{true}
-    , mesh{&ppmGen_, &PPMGen::setMesh}
+    , mesh{[=](const auto& m) {
+        mesh_ = m;
+        ppmGen_.setMesh(m);
+    }}
     , uvMap{[=](const auto& uv) {
         auto width = static_cast<size_t>(std::ceil(uv->ratio().width));
         auto height = static_cast<size_t>(std::ceil(uv->ratio().height));
+        uvMap_ = uv;
         ppmGen_.setUVMap(uv);
         ppmGen_.setDimensions(height, width);
     }}
@@ -276,21 +630,71 @@ PPMGeneratorNode::PPMGeneratorNode()
         shading_ = s;
         ppmGen_.setShading(s);
     }}
-    , ppm{&ppm_}
+    , partIndex{&partIndex_}
+    , partCount{&partCount_}
+    , ppm{[=]() { return ppm_.get(); }}
+    , part{&part_}
 {
     registerInputPort("mesh", mesh);
     registerInputPort("uvMap", uvMap);
     registerInputPort("shading", shading);
+    registerInputPort("partIndex", partIndex);
+    registerInputPort("partCount", partCount);
     registerOutputPort("ppm", ppm);
-    compute = [=]() { ppm_ = ppmGen_.compute(); };
+    registerOutputPort("part", part);
+    compute = [=]() {
+        // Only generate the region of the selected part
+        const auto width = ppmGen_.width();
+        const auto height = ppmGen_.height();
+        part_ = TexturePart();
+        part_.width = width;
+        part_.height = height;
+        part_.region = cv::Rect(
+            0, 0, static_cast<int>(width), static_cast<int>(height));
+        if (partCount_ > 1) {
+            part_ = TexturePart::Make(width, height, partIndex_, partCount_);
+        }
+        ppmGen_.setRegion(partCount_ > 1 ? part_.region : cv::Rect());
+
+        ContentHash geometry;
+        geometry.update(mesh_).update(uvMap_);
+        auto inputs = geometry;
+        inputs.update(shading_);
+        if (partCount_ > 1) {
+            inputs.update(partIndex_).update(partCount_);
+        }
+        memoize_(
+            "PPMGeneratorNode", inputs,
+            [=]() {
+                // Every part of the PPM shares one BVH
+                ppmGen_.setBVH(
+                    SharedUVBVH(geometry, mesh_, uvMap_, outputCache()));
+                ppm_ = ppmGen_.compute();
+            },
+            [=](const fs::path& dir) {
+                PerPixelMap::WritePPM(dir / "PerPixelMap.ppm", *ppm_.get());
+            },
+            [=](const fs::path& dir) {
+                ppm_ = PerPixelMap::New(
+                    PerPixelMap::ReadPPM(dir / "PerPixelMap.ppm"));
+            });
+    };
 }
 
 auto PPMGeneratorNode::serialize_(bool useCache, const fs::path& cacheDir)
     -> smgl::Metadata
 {
     smgl::Metadata meta{{"shading", shading_}};
-    if (useCache and ppm_ and ppm_->initialized()) {
-        PerPixelMap::WritePPM(cacheDir / "PerPixelMap.ppm", *ppm_);
+    meta["partIndex"] = partIndex_;
+    meta["partCount"] = partCount_;
+    auto writePPM = [](const fs::path& path, const PerPixelMap::Pointer& p) {
+        if (not p or not p->initialized()) {
+            return false;
+        }
+        PerPixelMap::WritePPM(path, *p);
+        return true;
+    };
+    if (useCache and ppm_.save(cacheDir / "PerPixelMap.ppm", writePPM)) {
         meta["ppm"] = "PerPixelMap.ppm";
     }
     return meta;
@@ -300,9 +704,15 @@ void PPMGeneratorNode::deserialize_(
     const smgl::Metadata& meta, const fs::path& cacheDir)
 {
     shading_ = meta["shading"].get<Shading>();
+    if (meta.contains("partCount")) {
+        partIndex_ = meta["partIndex"].get<std::size_t>();
+        partCount_ = meta["partCount"].get<std::size_t>();
+    }
     if (meta.contains("ppm")) {
         auto ppmFile = meta["ppm"].get<std::string>();
-        ppm_ = PerPixelMap::New(PerPixelMap::ReadPPM(cacheDir / ppmFile));
+        ppm_.setFile(cacheDir / ppmFile, [](const fs::path& p) {
+            return PerPixelMap::New(PerPixelMap::ReadPPM(p));
+        });
     }
 }
 
@@ -396,12 +806,18 @@ CompositeTextureNode::CompositeTextureNode()
         filter_ = f;
         textureGen_.setFilter(filter_);
     }}
-    , texture{&texture_}
+    , numThreads{&textureGen_, &TAlgo::setNumThreads}
+    , useGPU{&textureGen_, &TAlgo::setUseGPU}
+    , checkpoint{&textureGen_, &TAlgo::setCheckpoint}
+    , texture{[=]() { return texture_.get(); }}
 {
     registerInputPort("ppm", ppm);
     registerInputPort("volume", volume);
     registerInputPort("generator", generator);
     registerInputPort("filter", filter);
+    registerInputPort("numThreads", numThreads);
+    registerInputPort("useGPU", useGPU);
+    registerInputPort("checkpoint", checkpoint);
     registerOutputPort("texture", texture);
     compute = [=]() { texture_ = textureGen_.compute().at(0); };
 }
@@ -411,8 +827,8 @@ auto CompositeTextureNode::serialize_(bool useCache, const fs::path& cacheDir)
 {
     smgl::Metadata meta;
     meta["filter"] = filter_;
-    if (useCache and not texture_.empty()) {
-        WriteImage(cacheDir / "composite.tif", texture_);
+    if (useCache and
+        texture_.save(cacheDir / "composite.tif", WriteImageOutput)) {
         meta["texture"] = "composite.tif";
     }
     return meta;
@@ -425,7 +841,7 @@ void CompositeTextureNode::deserialize_(
     textureGen_.setFilter(filter_);
     if (meta.contains("texture")) {
         auto imgFile = meta["texture"].get<std::string>();
-        texture_ = ReadImage(cacheDir / imgFile);
+        ReadImageOutput(texture_, cacheDir / imgFile);
     }
 }
 
@@ -433,7 +849,7 @@ IntersectionTextureNode::IntersectionTextureNode()
     : Node{true}
     , ppm{&textureGen_, &TAlgo::setPerPixelMap}
     , volume{&textureGen_, &TAlgo::setVolume}
-    , texture{&texture_}
+    , texture{[=]() { return texture_.get(); }}
 {
     registerInputPort("ppm", ppm);
     registerInputPort("volume", volume);
@@ -445,8 +861,8 @@ auto IntersectionTextureNode::serialize_(
     bool useCache, const fs::path& cacheDir) -> smgl::Metadata
 {
     smgl::Metadata meta;
-    if (useCache and not texture_.empty()) {
-        WriteImage(cacheDir / "intersection.tif", texture_);
+    if (useCache and
+        texture_.save(cacheDir / "intersection.tif", WriteImageOutput)) {
         meta["texture"] = "intersection.tif";
     }
     return meta;
@@ -457,7 +873,7 @@ void IntersectionTextureNode::deserialize_(
 {
     if (meta.contains("texture")) {
         auto imgFile = meta["texture"].get<std::string>();
-        texture_ = ReadImage(cacheDir / imgFile);
+        ReadImageOutput(texture_, cacheDir / imgFile);
     }
 }
 
@@ -474,7 +890,10 @@ IntegralTextureNode::IntegralTextureNode()
     , exponentialDiffBaseMethod{&textureGen_, &TAlgo::setExponentialDiffBaseMethod}
     , exponentialDiffBaseValue{&textureGen_, &TAlgo::setExponentialDiffBaseValue}
     , exponentialDiffSuppressBelowBase{&textureGen_, &TAlgo::setExponentialDiffSuppressBelowBase}
-    , texture{&texture_}
+    , numThreads{&textureGen_, &TAlgo::setNumThreads}
+    , useGPU{&textureGen_, &TAlgo::setUseGPU}
+    , checkpoint{&textureGen_, &TAlgo::setCheckpoint}
+    , texture{[=]() { return texture_.get(); }}
 {
     registerInputPort("ppm", ppm);
     registerInputPort("volume", volume);
@@ -488,6 +907,9 @@ IntegralTextureNode::IntegralTextureNode()
     registerInputPort("exponentialDiffBaseValue", exponentialDiffBaseValue);
     registerInputPort(
         "exponentialDiffSuppressBelowBase", exponentialDiffSuppressBelowBase);
+    registerInputPort("numThreads", numThreads);
+    registerInputPort("useGPU", useGPU);
+    registerInputPort("checkpoint", checkpoint);
     registerOutputPort("texture", texture);
 
     compute = [=]() { texture_ = textureGen_.compute().at(0); };
@@ -506,8 +928,8 @@ auto IntegralTextureNode::serialize_(bool useCache, const fs::path& cacheDir)
         {"diffBaseVal", textureGen_.exponentialDiffBaseValue()},
         {"diffSuppressBelowBase",
          textureGen_.exponentialDiffSuppressBelowBase()}};
-    if (useCache and not texture_.empty()) {
-        WriteImage(cacheDir / "integral.tif", texture_);
+    if (useCache and
+        texture_.save(cacheDir / "integral.tif", WriteImageOutput)) {
         meta["texture"] = "integral.tif";
     }
     return meta;
@@ -529,7 +951,67 @@ void IntegralTextureNode::deserialize_(
         meta["diffSuppressBelowBase"].get<bool>());
     if (meta.contains("texture")) {
         auto imgFile = meta["texture"].get<std::string>();
-        texture_ = ReadImage(cacheDir / imgFile);
+        ReadImageOutput(texture_, cacheDir / imgFile);
+    }
+}
+
+MultiTextureNode::MultiTextureNode()
+    : Node{true}
+    , ppm{&textureGen_, &TAlgo::setPerPixelMap}
+    , volume{&textureGen_, &TAlgo::setVolume}
+    , generator{&textureGen_, &TAlgo::setGenerator}
+    , outputs{[=](const auto& o) {
+        outputs_ = o;
+        textureGen_.setOutputs(outputs_);
+    }}
+    , numThreads{&textureGen_, &TAlgo::setNumThreads}
+    , textures{&textures_}
+    , texture{&texture_}
+{
+    registerInputPort("ppm", ppm);
+    registerInputPort("volume", volume);
+    registerInputPort("generator", generator);
+    registerInputPort("outputs", outputs);
+    registerInputPort("numThreads", numThreads);
+    registerOutputPort("textures", textures);
+    registerOutputPort("texture", texture);
+    compute = [=]() {
+        textures_ = textureGen_.compute();
+        texture_ = textures_.at(0);
+    };
+}
+
+auto MultiTextureNode::serialize_(bool useCache, const fs::path& cacheDir)
+    -> smgl::Metadata
+{
+    smgl::Metadata meta;
+    meta["outputs"] = outputs_;
+    if (useCache and not textures_.empty()) {
+        meta["textures"] = smgl::Metadata::array();
+        AsyncImageWriter writer;
+        for (std::size_t i = 0; i < textures_.size(); i++) {
+            auto file = "multi_" + std::to_string(i) + ".tif";
+            writer.write(cacheDir / file, textures_[i]);
+            meta["textures"].push_back(file);
+        }
+        writer.flush();
+    }
+    return meta;
+}
+
+void MultiTextureNode::deserialize_(
+    const smgl::Metadata& meta, const fs::path& cacheDir)
+{
+    outputs_ = meta["outputs"].get<std::vector<Output>>();
+    textureGen_.setOutputs(outputs_);
+    if (meta.contains("textures")) {
+        textures_.clear();
+        for (const auto& file : meta["textures"]) {
+            textures_.push_back(ReadImage(cacheDir / file.get<std::string>()));
+        }
+        if (not textures_.empty()) {
+            texture_ = textures_.front();
+        }
     }
 }
 
@@ -540,13 +1022,17 @@ ThicknessTextureNode::ThicknessTextureNode()
     , volumetricMask{&textureGen_, &TAlgo::setVolumetricMask}
     , samplingInterval{&textureGen_, &TAlgo::setSamplingInterval}
     , normalizeOutput{&textureGen_, &TAlgo::setNormalizeOutput}
-    , texture{&texture_}
+    , useDistanceField{&textureGen_, &TAlgo::setUseDistanceField}
+    , numThreads{&textureGen_, &TAlgo::setNumThreads}
+    , texture{[=]() { return texture_.get(); }}
 {
     registerInputPort("ppm", ppm);
     registerInputPort("volume", volume);
     registerInputPort("volumetricMask", volumetricMask);
     registerInputPort("samplingInterval", samplingInterval);
     registerInputPort("normalizeOutput", normalizeOutput);
+    registerInputPort("useDistanceField", useDistanceField);
+    registerInputPort("numThreads", numThreads);
     registerOutputPort("texture", texture);
 
     compute = [=]() { texture_ = textureGen_.compute().at(0); };
@@ -558,12 +1044,11 @@ auto ThicknessTextureNode::serialize_(
     smgl::Metadata meta{
         {"samplingInterval", textureGen_.samplingInterval()},
         {"normalizeOutput", textureGen_.normalizeOutput()},
+        {"useDistanceField", textureGen_.useDistanceField()},
     };
-    if (useCache) {
-        if (not texture_.empty()) {
-            WriteImage(cacheDir / "thickness.tif", texture_);
-            meta["texture"] = "thickness.tif";
-        }
+    if (useCache and
+        texture_.save(cacheDir / "thickness.tif", WriteImageOutput)) {
+        meta["texture"] = "thickness.tif";
     }
 
     return meta;
@@ -574,8 +1059,37 @@ void ThicknessTextureNode::deserialize_(
 {
     textureGen_.setSamplingInterval(meta["samplingInterval"].get<double>());
     textureGen_.setNormalizeOutput(meta["normalizeOutput"].get<bool>());
+    if (meta.contains("useDistanceField")) {
+        textureGen_.setUseDistanceField(
+            meta["useDistanceField"].get<bool>());
+    }
     if (meta.contains("texture")) {
         auto imgFile = meta["texture"].get<std::string>();
-        texture_ = ReadImage(cacheDir / imgFile);
+        ReadImageOutput(texture_, cacheDir / imgFile);
     }
 }
+
+WriteTexturePartNode::WriteTexturePartNode()
+    : smgl::Node{true}, path{&path_}, part{&part_}, image{&image_}
+{
+    registerInputPort("path", path);
+    registerInputPort("part", part);
+    registerInputPort("image", image);
+    compute = [=]() {
+        auto p = part_;
+        p.image = path_;
+        WriteTexturePart(p, image_);
+    };
+}
+
+auto WriteTexturePartNode::serialize_(
+    bool /*useCache*/, const fs::path& /*cacheDir*/) -> smgl::Metadata
+{
+    return {{"path", path_.string()}};
+}
+
+void WriteTexturePartNode::deserialize_(
+    const smgl::Metadata& meta, const fs::path& /*cacheDir*/)
+{
+    path_ = meta["path"].get<std::string>();
+}
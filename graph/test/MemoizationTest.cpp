@@ -0,0 +1,216 @@
+#include <gtest/gtest.h>
+
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#include "vc/core/filesystem.hpp"
+#include "vc/graph/memoization.hpp"
+
+using namespace volcart;
+namespace fs = volcart::filesystem;
+
+namespace
+{
+// Three chunks, the last of which is partial
+constexpr std::size_t FILE_SIZE{2 * NodeOutputCache::CHUNK_SIZE + 1000};
+
+auto RandomBytes(std::size_t size, unsigned seed) -> std::string
+{
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> dist(0, 255);
+    std::string bytes(size, '\0');
+    for (auto& b : bytes) {
+        b = static_cast<char>(dist(rng));
+    }
+    return bytes;
+}
+
+void WriteFile(const fs::path& path, const std::string& bytes)
+{
+    fs::create_directories(path.parent_path());
+    std::ofstream file(path.string(), std::ios::binary);
+    file.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+}
+
+auto ReadFile(const fs::path& path) -> std::string
+{
+    std::ifstream file(path.string(), std::ios::binary);
+    return std::string(
+        (std::istreambuf_iterator<char>(file)),
+        std::istreambuf_iterator<char>());
+}
+
+// Store an entry with one file
+void Store(
+    NodeOutputCache& cache, const std::string& key, const std::string& bytes)
+{
+    cache.store(
+        key, [&](const fs::path& dir) { WriteFile(dir / "data.bin", bytes); });
+}
+
+// Load an entry's file. Returns an empty string if the entry did not load.
+auto Load(NodeOutputCache& cache, const std::string& key) -> std::string
+{
+    std::string bytes;
+    cache.load(
+        key, [&](const fs::path& dir) { bytes = ReadFile(dir / "data.bin"); });
+    return bytes;
+}
+
+auto NumChunks(const NodeOutputCache& cache) -> std::size_t
+{
+    std::size_t n{0};
+    for (const auto& it :
+         fs::recursive_directory_iterator(cache.root() / "chunks")) {
+        if (fs::is_regular_file(it.path())) {
+            n++;
+        }
+    }
+    return n;
+}
+
+// Move every file in the cache out of the trim grace period
+void Age(const NodeOutputCache& cache)
+{
+    timespec times[2];
+    times[0].tv_sec = times[1].tv_sec = 0;
+    times[0].tv_nsec = times[1].tv_nsec = UTIME_OMIT;
+    struct stat st{};
+    for (const auto& it : fs::recursive_directory_iterator(cache.root())) {
+        if (::stat(it.path().c_str(), &st) != 0) {
+            continue;
+        }
+        times[1].tv_sec = st.st_mtime - 3600;
+        times[1].tv_nsec = 0;
+        ::utimensat(AT_FDCWD, it.path().c_str(), times, 0);
+    }
+}
+
+auto NewCache(const std::string& name) -> NodeOutputCache::Pointer
+{
+    fs::path root{name};
+    fs::remove_all(root);
+    return NodeOutputCache::New(root);
+}
+}  // namespace
+
+TEST(NodeOutputCache, StoreLoadRoundTrip)
+{
+    auto cache = NewCache("vc_graph_Memoization_RoundTrip");
+    auto large = RandomBytes(FILE_SIZE, 1);
+    std::string small{"small file"};
+    cache->store("entry", [&](const fs::path& dir) {
+        WriteFile(dir / "large.bin", large);
+        WriteFile(dir / "sub" / "small.txt", small);
+        WriteFile(dir / "empty", "");
+    });
+
+    auto entries = cache->entries();
+    ASSERT_EQ(entries.size(), 1U);
+    EXPECT_EQ(entries[0].key, "entry");
+    EXPECT_EQ(entries[0].files, 3U);
+    EXPECT_EQ(entries[0].bytes, large.size() + small.size());
+
+    bool loaded{false};
+    EXPECT_TRUE(cache->load("entry", [&](const fs::path& dir) {
+        EXPECT_EQ(ReadFile(dir / "large.bin"), large);
+        EXPECT_EQ(ReadFile(dir / "sub" / "small.txt"), small);
+        EXPECT_TRUE(fs::exists(dir / "empty"));
+        EXPECT_EQ(fs::file_size(dir / "empty"), 0U);
+        loaded = true;
+    }));
+    EXPECT_TRUE(loaded);
+
+    // Missing entries do not call the reader
+    EXPECT_FALSE(cache->load("missing", [](const fs::path&) { FAIL(); }));
+
+    // Removed entries no longer load
+    cache->remove("entry");
+    EXPECT_TRUE(cache->entries().empty());
+    EXPECT_TRUE(Load(*cache, "entry").empty());
+}
+
+TEST(NodeOutputCache, ChunksAreSharedBetweenEntries)
+{
+    auto cache = NewCache("vc_graph_Memoization_Dedup");
+    auto bytes = RandomBytes(FILE_SIZE, 2);
+    Store(*cache, "a", bytes);
+    EXPECT_EQ(NumChunks(*cache), 3U);
+
+    // Identical outputs add no chunks
+    Store(*cache, "b", bytes);
+    EXPECT_EQ(NumChunks(*cache), 3U);
+
+    // Outputs which differ in one chunk add one chunk
+    auto changed = bytes;
+    changed.back() = static_cast<char>(changed.back() + 1);
+    Store(*cache, "c", changed);
+    EXPECT_EQ(NumChunks(*cache), 4U);
+
+    EXPECT_EQ(Load(*cache, "a"), bytes);
+    EXPECT_EQ(Load(*cache, "b"), bytes);
+    EXPECT_EQ(Load(*cache, "c"), changed);
+}
+
+TEST(NodeOutputCache, TrimRemovesLeastRecentlyUsed)
+{
+    auto cache = NewCache("vc_graph_Memoization_Trim");
+    auto a = RandomBytes(FILE_SIZE, 3);
+    auto b = RandomBytes(FILE_SIZE, 4);
+    Store(*cache, "a", a);
+    Store(*cache, "b", b);
+    EXPECT_EQ(NumChunks(*cache), 6U);
+
+    // Recent chunks and entries are kept by a trim which removes nothing
+    cache->trim();
+    EXPECT_EQ(cache->entries().size(), 2U);
+    EXPECT_EQ(NumChunks(*cache), 6U);
+
+    // Loading b makes a the least recently used entry. Random data does not
+    // compress, so only one entry fits.
+    Age(*cache);
+    EXPECT_EQ(Load(*cache, "b"), b);
+    cache->trimTo(FILE_SIZE + FILE_SIZE / 2);
+
+    auto entries = cache->entries();
+    ASSERT_EQ(entries.size(), 1U);
+    EXPECT_EQ(entries[0].key, "b");
+    EXPECT_EQ(NumChunks(*cache), 3U);
+    EXPECT_LE(cache->bytes(), FILE_SIZE + FILE_SIZE / 2);
+    EXPECT_TRUE(Load(*cache, "a").empty());
+    EXPECT_EQ(Load(*cache, "b"), b);
+
+    // Trimming to nothing removes every entry and chunk
+    Age(*cache);
+    cache->trimTo(0);
+    EXPECT_TRUE(cache->entries().empty());
+    EXPECT_EQ(NumChunks(*cache), 0U);
+}
+
+TEST(NodeOutputCache, UnreadableManifestKeepsChunks)
+{
+    auto cache = NewCache("vc_graph_Memoization_Unreadable");
+    auto bytes = RandomBytes(FILE_SIZE, 5);
+    Store(*cache, "a", bytes);
+    Store(*cache, "b", bytes);
+
+    // b's chunks are unknown once its manifest is damaged, so the chunks
+    // which were shared with a are kept
+    WriteFile(cache->root() / "b.vcno", "not a manifest");
+    cache->remove("a");
+    Age(*cache);
+    cache->trim();
+    EXPECT_EQ(cache->entries().size(), 1U);
+    EXPECT_EQ(NumChunks(*cache), 3U);
+
+    // Once the damaged entry is evicted, its chunks are removed
+    cache->trimTo(0);
+    EXPECT_TRUE(cache->entries().empty());
+    cache->trim();
+    EXPECT_EQ(NumChunks(*cache), 0U);
+}
@@ -2,6 +2,8 @@
 
 /** @file */
 
+#include <cstddef>
+
 #include "vc/core/types/ITKMesh.hpp"
 
 namespace volcart::meshing
@@ -94,6 +96,18 @@ public:
     /** @copydoc setQuadricsOptimizationLevel(std::size_t) */
     [[nodiscard]] auto quadricsOptimizationLevel() const -> std::size_t;
 
+    /**
+     * @brief Number of threads used for quadrics optimization
+     *
+     * Clusters are optimized in parallel on the global ThreadPool. The
+     * result does not depend on the number of threads. If set to 0 (default),
+     * uses every thread in the global ThreadPool.
+     */
+    void setNumThreads(std::size_t n);
+
+    /** @copydoc setNumThreads(std::size_t) */
+    [[nodiscard]] auto numThreads() const -> std::size_t;
+
     /** @brief Compute the resampled mesh */
     auto compute() -> ITKMesh::Pointer;
 
@@ -120,5 +134,7 @@ private:
     std::size_t subsampleThreshold_{10};
     /** Quadrics optimization level */
     std::size_t quadricsOptLevel_{1};
+    /** Number of threads */
+    std::size_t numThreads_{0};
 };
 }  // namespace volcart::meshing
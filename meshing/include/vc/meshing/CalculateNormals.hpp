@@ -2,12 +2,13 @@
 
 /** @file */
 
+#include <cstddef>
 #include <iostream>
 
 #include <opencv2/core.hpp>
 
+#include "vc/core/types/FlatMesh.hpp"
 #include "vc/core/types/ITKMesh.hpp"
-#include "vc/meshing/DeepCopy.hpp"
 
 namespace volcart::meshing
 {
@@ -19,7 +20,9 @@ namespace volcart::meshing
  * @brief Calculate vertex normals for ITK Meshes.
  *
  * Given an ITK mesh, generates a copy of that mesh with embedded vertex
- * normals.
+ * normals. If in-place mode is enabled, the normals are instead written to
+ * the point data of the input mesh, which avoids copying the mesh geometry.
+ * Only enable in-place mode when the caller owns the input mesh.
  *
  * @ingroup Meshing
  */
@@ -33,11 +36,7 @@ public:
     /**
      * @param mesh Input Mesh whose normals you want computed
      */
-    explicit CalculateNormals(const ITKMesh::Pointer& mesh)
-        : input_{mesh}, output_{ITKMesh::New()}
-    {
-        DeepCopy(input_, output_);
-    }
+    explicit CalculateNormals(const ITKMesh::Pointer& mesh) : input_{mesh} {}
     //@}
 
     //** @name Input/Output */
@@ -54,6 +53,31 @@ public:
     ITKMesh::Pointer getMesh() const { return output_; }
     //@}
 
+    //** @name Parameters */
+    //@{
+    /**
+     * @brief Write normals to the input mesh instead of a copy
+     *
+     * When enabled, compute() replaces the point data of the input mesh and
+     * returns the input mesh. Default: false
+     */
+    void setInPlace(bool b) { inPlace_ = b; }
+
+    /** @copydoc setInPlace() */
+    bool inPlace() const { return inPlace_; }
+
+    /**
+     * @brief Set the number of threads used to compute normals
+     *
+     * If `0`, uses every thread in the global ThreadPool. The result does not
+     * depend on the number of threads. Default: 0
+     */
+    void setNumThreads(std::size_t n) { numThreads_ = n; }
+
+    /** @copydoc setNumThreads() */
+    std::size_t numThreads() const { return numThreads_; }
+    //@}
+
     /**
      * @brief Compute vertex normals for the mesh.
      */
@@ -64,15 +88,16 @@ private:
      * @brief Compute normals for each vertex.
      *
      * For each face, computes the normal to that face and adds the resulting
-     * vector to a sum vector for each vertex in that face.
+     * vector to a sum vector for each vertex in that face. The sums are then
+     * normalized. See FlatMesh::computeNormals().
      */
     void compute_normals_();
 
     /**
-     * @brief Assign the summed normals to the output mesh.
+     * @brief Assign the normals to the output mesh.
      *
-     * Takes the summed normals for each vertex and assigns them to the
-     * corresponding vertex in the output mesh.
+     * Copies the vertices, faces, and computed normals into a new output
+     * mesh, or only the normals into the input mesh in in-place mode.
      */
     void assign_to_mesh_();
 
@@ -82,7 +107,13 @@ private:
     /** Mesh with calculated normals. */
     ITKMesh::Pointer output_;
 
-    /** Storage for summed normals, organized by vertex ID */
-    std::vector<cv::Vec3d> vertexNormals_;
+    /** Flat copy of the input mesh used for computation */
+    FlatMesh mesh_;
+
+    /** Write normals to the input mesh */
+    bool inPlace_{false};
+
+    /** Number of threads */
+    std::size_t numThreads_{0};
 };
 }  // namespace volcart::meshing
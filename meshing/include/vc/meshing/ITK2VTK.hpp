@@ -14,20 +14,37 @@ namespace volcart::meshing
  *
  * Copy vertices, vertex normals, and faces (cells) from input to output.
  *
+ * ITKMesh stores its vertices and vertex normals in contiguous arrays of
+ * doubles, which is also the layout of VTK's point and normal arrays. If
+ * `shareBuffers` is `true`, the output's point and normal arrays reference
+ * the input's memory rather than copying it. Normals are only shared when
+ * every vertex has a normal. Faces are always copied.
+ *
+ * @warning When sharing buffers, the input mesh must outlive the output, and
+ * vertices must not be added to or removed from the input while the output
+ * is in use. Only share buffers for VTK meshes that are temporary, e.g. the
+ * input to a VTK filter.
+ *
  * @see  examples/src/ITK2VTKExample.cpp
  *       meshing/test/ITK2VTKTest.cpp
  *
  * @ingroup Meshing
  */
-void ITK2VTK(ITKMesh::Pointer input, vtkSmartPointer<vtkPolyData> output);
+void ITK2VTK(
+    ITKMesh::Pointer input,
+    vtkSmartPointer<vtkPolyData> output,
+    bool shareBuffers = false);
 
 /** @copydoc ITK2VTK */
-auto ITK2VTK(ITKMesh::Pointer input) -> vtkSmartPointer<vtkPolyData>;
+auto ITK2VTK(ITKMesh::Pointer input, bool shareBuffers = false)
+    -> vtkSmartPointer<vtkPolyData>;
 
 /**
  * @brief Convert from a VTK PolyData to an ITKMesh.
  *
  * Copy vertices, vertex normals, and faces (cells) from input to output.
+ * ITKMesh cannot reference external memory, but double-precision point and
+ * normal arrays are copied as whole buffers.
  *
  * @see  examples/src/ITK2VTKExample.cpp
  *       meshing/test/ITK2VTKTest.cpp
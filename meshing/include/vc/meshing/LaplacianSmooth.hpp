@@ -1,5 +1,9 @@
 #pragma once
 
+/** @file */
+
+#include <cstddef>
+
 #include "vc/core/types/ITKMesh.hpp"
 
 namespace volcart::meshing
@@ -8,7 +12,25 @@ namespace volcart::meshing
 /**
  * @brief Apply Laplacian smoothing to a mesh
  *
- * A wrapper around vtkSmoothPolyDataFilter
+ * Each iteration moves every vertex towards the average of its neighbors by
+ * the relaxation factor. Vertices are classified using the same rules as
+ * vtkSmoothPolyDataFilter:
+ *
+ * - Boundary vertices (on an edge used by one face) are smoothed along the
+ *   boundary only, or are fixed if boundary smoothing is disabled.
+ * - If feature edge smoothing is enabled, edges whose adjacent faces meet at
+ *   more than the feature angle are feature edges. Vertices on feature edges
+ *   and non-manifold edges are smoothed along those edges only.
+ * - Boundary and feature edge vertices are fixed unless they have exactly
+ *   two such edges and those edges deviate from a straight line by less than
+ *   the edge angle.
+ *
+ * Vertex positions are updated from the previous iteration's positions, so
+ * the vertices of an iteration are smoothed in parallel and the result does
+ * not depend on the number of threads. Vertex normals are recomputed for the
+ * output mesh.
+ *
+ * @ingroup Meshing
  */
 class LaplacianSmooth
 {
@@ -28,6 +50,8 @@ public:
     void setEdgeAngle(double a);
     /** @copydoc boundarySmoothing() const */
     void setBoundarySmoothing(bool b);
+    /** @copydoc numThreads() const */
+    void setNumThreads(std::size_t n);
 
     /** @brief The number of smoothing interations */
     [[nodiscard]] auto iterations() const -> std::size_t;
@@ -41,6 +65,12 @@ public:
     [[nodiscard]] auto edgeAngle() const -> double;
     /** @brief Smoothing vertices on the mesh boundary */
     [[nodiscard]] auto boundarySmoothing() const -> bool;
+    /**
+     * @brief Number of threads
+     *
+     * If `0` (default), uses every thread in the global ThreadPool.
+     */
+    [[nodiscard]] auto numThreads() const -> std::size_t;
 
     /** @brief Compute the smoothed mesh */
     auto compute() -> ITKMesh::Pointer;
@@ -65,5 +95,7 @@ private:
     double edgeAngle_{15};
     /** Smooth boundary vertices */
     bool boundarySmooth_{true};
+    /** Number of threads */
+    std::size_t numThreads_{0};
 };
 }  // namespace volcart::meshing
\ No newline at end of file
@@ -0,0 +1,109 @@
+#pragma once
+
+/** @file */
+
+#include <array>
+#include <cstddef>
+#include <limits>
+#include <memory>
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+#include "vc/core/types/FlatMesh.hpp"
+
+namespace volcart::meshing
+{
+/**
+ * @brief Intersect triangle meshes with a sequence of z-planes
+ *
+ * Triangles are sorted by their minimum z-value when the sweep is
+ * constructed. As the plane advances, triangles which start below the plane
+ * are added to an active set and triangles which end below the plane are
+ * removed from it, so each call to intersect() only visits the triangles
+ * which can cross the plane.
+ *
+ * The sorted triangles are shared between copies of a sweep, while each copy
+ * has its own active set. Copy a sweep to intersect different ranges of
+ * z-values in parallel.
+ *
+ * @ingroup Meshing
+ *
+ * @see test/MeshSliceSweepTest.cpp
+ */
+class MeshSliceSweep
+{
+public:
+    /** Triangle vertices */
+    using Triangle = std::array<cv::Vec3d, 3>;
+
+    /** Line segment in the xy-plane */
+    using Segment = std::array<cv::Vec2d, 2>;
+
+    /** Construct a sweep over no triangles */
+    MeshSliceSweep();
+
+    /** Construct a sweep over the faces of one or more meshes */
+    explicit MeshSliceSweep(const std::vector<FlatMesh>& meshes);
+
+    /** @copydoc MeshSliceSweep(const std::vector<FlatMesh>&) */
+    explicit MeshSliceSweep(const FlatMesh& mesh);
+
+    /** @brief Number of triangles in the sweep */
+    [[nodiscard]] auto numTriangles() const -> std::size_t;
+
+    /** @brief Minimum z-value of the triangles */
+    [[nodiscard]] auto zMin() const -> double;
+
+    /** @brief Maximum z-value of the triangles */
+    [[nodiscard]] auto zMax() const -> double;
+
+    /**
+     * @brief Intersect the triangles with the plane at z
+     *
+     * Returns one segment per triangle which crosses the plane. Moving the
+     * plane upward only updates the active set. Moving it downward restarts
+     * the sweep from the lowest triangle.
+     *
+     * The returned reference is valid until the next call.
+     */
+    auto intersect(double z) -> const std::vector<Segment>&;
+
+    /** @brief Number of triangles active at the current plane */
+    [[nodiscard]] auto numActive() const -> std::size_t;
+
+    /** @brief Clear the active set */
+    void reset();
+
+    /**
+     * @brief Intersect a triangle with the plane at z
+     *
+     * Vertices on the plane count as above it, so a triangle which crosses
+     * the plane has exactly two edges with an end on each side.
+     *
+     * @return Whether the triangle crosses the plane
+     */
+    static auto IntersectTriangle(const Triangle& t, double z, Segment& s)
+        -> bool;
+
+private:
+    /** Triangles sorted by their minimum z-value */
+    struct SortedTriangles {
+        std::vector<Triangle> triangles;
+        std::vector<double> lo;
+        std::vector<double> hi;
+    };
+
+    /** Shared, immutable triangle data */
+    std::shared_ptr<const SortedTriangles> data_;
+    /** Indices of the triangles which may cross the plane */
+    std::vector<std::size_t> active_;
+    /** Index of the next triangle to activate */
+    std::size_t next_{0};
+    /** z-value of the previous plane */
+    double lastZ_{-std::numeric_limits<double>::infinity()};
+    /** Segments of the previous plane */
+    std::vector<Segment> segments_;
+};
+
+}  // namespace volcart::meshing
@@ -2,8 +2,12 @@
 
 /** @file */
 
+#include <cstddef>
+
 #include <opencv2/core.hpp>
 
+#include "vc/core/filesystem.hpp"
+#include "vc/core/types/FlatMesh.hpp"
 #include "vc/core/types/ITKMesh.hpp"
 #include "vc/core/types/OrderedPointSet.hpp"
 
@@ -23,6 +27,12 @@ namespace volcart::meshing
  *
  * Vertex normals are computed using CalculateNormals.
  *
+ * For very large point sets, the ITKMesh produced by compute() uses several
+ * times the memory of the point set itself. computeFlatMesh() produces the
+ * same mesh as a FlatMesh, and writePLY() streams the mesh to disk without
+ * building a mesh in memory at all. Both compute vertex and face indices
+ * arithmetically from the ordering.
+ *
  * @ingroup Meshing
  *
  * @see common/types/OrderedPointSet.h
@@ -68,6 +78,28 @@ public:
      * @brief Compute the mesh triangulation.
      */
     ITKMesh::Pointer compute();
+
+    /**
+     * @brief Compute the mesh as a FlatMesh
+     *
+     * Produces the same vertices, faces, and vertex normals as compute().
+     */
+    FlatMesh computeFlatMesh();
+
+    /**
+     * @brief Mesh the point set and stream it to a binary PLY file
+     *
+     * Vertices and faces are generated and written in chunks of
+     * `rowsPerChunk` rows, so memory use beyond the input point set is
+     * bounded by the chunk size. The file is identical to writing the output
+     * of compute() with io::PLYWriter in binary, 32-bit float mode.
+     *
+     * @throws volcart::IOException If the file cannot be written
+     * @throws std::overflow_error If the point set has more vertices than can
+     * be indexed by a PLY face
+     */
+    void writePLY(
+        const filesystem::path& path, std::size_t rowsPerChunk = 1024);
     /**@}*/
 
 private:
@@ -84,5 +116,13 @@ private:
      * @param c ID for the third vertex in the face
      */
     void add_cell_(size_t a, size_t b, size_t c);
+
+    /**
+     * @brief Compute the normal of a vertex from its adjacent faces
+     *
+     * Sums the face normals in the same order as FlatMesh::computeNormals(),
+     * so the result is identical to the normals computed for the whole mesh.
+     */
+    cv::Vec3d vertex_normal_(size_t row, size_t col) const;
 };
 }  // namespace volcart::meshing
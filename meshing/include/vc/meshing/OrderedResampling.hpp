@@ -2,6 +2,7 @@
 
 /** @file */
 
+#include <cstddef>
 #include <iostream>
 #include <stdexcept>
 #include <vector>
@@ -22,6 +23,10 @@ namespace volcart::meshing
  * width and height parameters. Assumes the input mesh was constructed from an
  * OrderedPointSet using OrderedPointSetMesher.
  *
+ * Since the ordering matrix is regular, the position of every output vertex
+ * and face is computed directly from its row and column. Output rows are
+ * resampled in parallel.
+ *
  * @warning This function assumes the input mesh was constructed from an
  * OrderedPointSet using OrderedPointSetMesher, and will produce undesired
  * results for any other type of triangulation.
@@ -77,6 +82,16 @@ public:
      * @brief Get the height of the resampled mesh.
      */
     int getOutputHeight() const { return outHeight_; }
+
+    /**
+     * @brief Set the number of threads
+     *
+     * If `0` (default), uses every thread in the global ThreadPool.
+     */
+    void setNumThreads(std::size_t n) { numThreads_ = n; }
+
+    /** @brief Get the number of threads */
+    std::size_t numThreads() const { return numThreads_; }
     //@}
 
     /** @name Processing */
@@ -98,14 +113,7 @@ private:
     int outWidth_;
     /** The number of rows in the output ordering matrix */
     int outHeight_;
-
-    /**
-     * @brief Add a face to the output mesh.
-     *
-     * @param a ID for the first vertex in the face
-     * @param b ID for the second vertex in the face
-     * @param c ID for the third vertex in the face
-     */
-    void add_cell_(uint32_t a, uint32_t b, uint32_t c);
+    /** Number of threads */
+    std::size_t numThreads_{0};
 };
 }  // namespace volcart::meshing
@@ -0,0 +1,108 @@
+#pragma once
+
+/** @file */
+
+#include <cstddef>
+
+#include "vc/core/types/FlatMesh.hpp"
+#include "vc/core/types/ITKMesh.hpp"
+
+namespace volcart::meshing
+{
+/**
+ * @brief Decimate a mesh by quadric error edge collapse
+ *
+ * Reduces the number of vertices of a mesh by repeatedly collapsing edges
+ * into a single vertex, placed to minimize the quadric error metric of:
+ *      Garland, Michael, and Paul S. Heckbert. "Surface simplification
+ *      using quadric error metrics." SIGGRAPH 1997.
+ *
+ * Rather than keeping every edge in a priority queue, collapses are applied
+ * in passes: each pass collapses every edge whose error is below a threshold
+ * which grows from pass to pass, skipping the faces touched by an earlier
+ * collapse in the same pass. This is much faster than ACVD on large meshes
+ * and is suitable for preview renders, though the output triangles are less
+ * regular. The vertex quadrics and initial edge errors are computed in
+ * parallel on the global ThreadPool. The collapses themselves are applied
+ * sequentially, so the result does not depend on the number of threads.
+ *
+ * Vertices on the mesh boundary are never moved or removed. Since a UV seam
+ * is a boundary in a mesh with per-vertex UVs, seams are also preserved, and
+ * the UVs of collapsed interior vertices are interpolated along the edge.
+ * Collapses which would flip a face or make the mesh non-manifold are
+ * skipped, so the output can have more vertices than the target if the mesh
+ * has few collapsible edges.
+ *
+ * Vertex normals are recomputed if the input mesh has normals.
+ *
+ * @ingroup Meshing
+ */
+class QuadricDecimation
+{
+public:
+    /** Default aggressiveness */
+    static constexpr double DEFAULT_AGGRESSIVENESS{7};
+
+    /** @brief Set the input mesh */
+    void setInputMesh(const ITKMesh::Pointer& m);
+
+    /** @brief Set the input mesh, including its UV coordinates */
+    void setInputMesh(FlatMesh m);
+
+    /**
+     * @brief The target number of vertices in the output mesh
+     *
+     * If set to 0 (default), the number of vertices in the input mesh will
+     * be used.
+     */
+    void setTargetVertices(std::size_t n);
+
+    /** @copydoc setTargetVertices(std::size_t) */
+    [[nodiscard]] auto targetVertices() const -> std::size_t;
+
+    /**
+     * @brief How quickly the error threshold grows between passes
+     *
+     * The threshold of pass `i` is proportional to `(i + 3)^a`. Lower values
+     * collapse edges closer to error order and give a better mesh, but take
+     * more passes. Default: DEFAULT_AGGRESSIVENESS
+     */
+    void setAggressiveness(double a);
+
+    /** @copydoc setAggressiveness(double) */
+    [[nodiscard]] auto aggressiveness() const -> double;
+
+    /**
+     * @brief Number of threads
+     *
+     * If `0` (default), uses every thread in the global ThreadPool.
+     */
+    void setNumThreads(std::size_t n);
+
+    /** @copydoc setNumThreads(std::size_t) */
+    [[nodiscard]] auto numThreads() const -> std::size_t;
+
+    /** @brief Compute the decimated mesh */
+    auto compute() -> ITKMesh::Pointer;
+
+    /** @brief Get the output mesh */
+    [[nodiscard]] auto getOutputMesh() const -> ITKMesh::Pointer;
+
+    /** @brief Get the output mesh, including its UV coordinates */
+    [[nodiscard]] auto getOutputFlatMesh() const -> const FlatMesh&;
+
+private:
+    /** Input mesh */
+    FlatMesh input_;
+    /** Output mesh */
+    FlatMesh output_;
+    /** Output mesh as an ITKMesh */
+    ITKMesh::Pointer outputMesh_;
+    /** Target number of vertices */
+    std::size_t targetVertices_{0};
+    /** Growth of the error threshold */
+    double aggressiveness_{DEFAULT_AGGRESSIVENESS};
+    /** Number of threads */
+    std::size_t numThreads_{0};
+};
+}  // namespace volcart::meshing
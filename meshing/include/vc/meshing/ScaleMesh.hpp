@@ -32,4 +32,13 @@ void ScaleMesh(
  * factor). Initializes a new ITKMesh.
  */
 ITKMesh::Pointer ScaleMesh(const ITKMesh::Pointer& input, double scaleFactor);
+
+/**
+ * @brief Scale an ITKMesh by a linear scale factor in place.
+ *
+ * Multiplies the vertices of `mesh` by the scale factor without copying the
+ * mesh. Use this instead of ScaleMesh() when the caller owns the mesh and
+ * does not need the unscaled vertices.
+ */
+void ScaleMeshInPlace(const ITKMesh::Pointer& mesh, double scaleFactor);
 }  // namespace volcart::meshing
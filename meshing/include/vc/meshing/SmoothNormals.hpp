@@ -2,23 +2,48 @@
 
 /** @file */
 
+#include <cstddef>
+
 #include "vc/core/types/ITKMesh.hpp"
 
 namespace volcart::meshing
 {
+/**
+ * @brief Neighbor weighting used by SmoothNormals()
+ *
+ * @ingroup Meshing
+ */
+enum class NormalWeighting {
+    /** Every neighbor has the same weight */
+    Uniform,
+    /**
+     * Neighbors are weighted by a Gaussian of their distance to the vertex,
+     * with a standard deviation of one third of the smoothing radius
+     */
+    Gaussian
+};
+
 /**
  * @author Abigail Coleman
  * @date June 2015
  *
  * @brief Smooth vertex normals within a specified radius.
  *
- * Uses ITK's neighborhood locator to get the list of neighboring vertices
- * within the provided spherical radius. Returns a DeepCopy of the
- * original mesh, with smoothed vertex normals.
+ * Uses a KD-tree to get the list of neighboring vertices within the provided
+ * spherical radius. Returns a DeepCopy of the original mesh, with smoothed
+ * vertex normals. Vertices are processed in parallel on the global
+ * ThreadPool, and the result does not depend on the number of threads.
  *
  * @ingroup Meshing
  *
  * @param radius Size of the spherical neighborhood
+ * @param weighting Neighbor weighting
+ * @param numThreads Number of threads. If `0`, uses every thread in the
+ * global ThreadPool.
  */
-ITKMesh::Pointer SmoothNormals(const ITKMesh::Pointer& input, double radius);
+ITKMesh::Pointer SmoothNormals(
+    const ITKMesh::Pointer& input,
+    double radius,
+    NormalWeighting weighting = NormalWeighting::Uniform,
+    std::size_t numThreads = 0);
 }  // namespace volcart::meshing
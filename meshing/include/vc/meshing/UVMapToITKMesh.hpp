@@ -12,7 +12,11 @@ namespace volcart::meshing
  * @brief Convert a UVMap to a mesh
  *
  * Combines the UV coordinates from a UVMap and the face information from an
- * ITKMesh to produce a meshed UVMap.
+ * ITKMesh to produce a meshed UVMap. The output mesh shares its cells with
+ * the input mesh rather than copying them, so the cells of the output must
+ * not be modified.
+ *
+ * @see UVMeshView to read a mesh in UV space without building a new mesh
  */
 class UVMapToITKMesh
 {
@@ -1,6 +1,7 @@
 #include "vc/meshing/ACVD.hpp"
 
 #include <array>
+#include <vector>
 
 #include <vtkAnisotropicDiscreteRemeshing.h>
 #include <vtkCleanPolyData.h>
@@ -10,6 +11,7 @@
 #include <vtkPolyDataNormals.h>
 
 #include "vc/core/util/Logging.hpp"
+#include "vc/core/util/ThreadPool.hpp"
 #include "vc/meshing/ITK2VTK.hpp"
 
 using namespace volcart;
@@ -30,6 +32,8 @@ void ACVD::setSubsampleThreshold(size_t t) { subsampleThreshold_ = t; }
 
 void ACVD::setQuadricsOptimizationLevel(size_t l) { quadricsOptLevel_ = l; }
 
+void ACVD::setNumThreads(std::size_t n) { numThreads_ = n; }
+
 ITKMesh::Pointer ACVD::getOutputMesh() const { return outputMesh_; }
 
 ITKMesh::Pointer ACVD::compute()
@@ -84,34 +88,34 @@ void ACVD::compute_isotropic_()
     if (quadricsOptLevel_ != 0) {
         Logger()->info("ACVD: Computing quadrics optimization...");
         vtkIntArray* clustering = remesh->GetClustering();
-
-        int cluster = 0;
+        auto* input = remesh->GetInput();
+        auto* output = remesh->GetOutput();
+        const auto numClusters = static_cast<std::size_t>(clusters);
+        const auto faceItems = remesh->GetClusteringType() == 0;
+
+        // Group the items by cluster, keeping each cluster's items in order
+        const auto numItems = remesh->GetNumberOfItems();
+        std::vector<std::size_t> offsets(numClusters + 1, 0);
         int numMisclassedItems = 0;
-
-        std::vector<std::array<double, 9>> clusterQuadrics(
-            clusters, std::array<double, 9>{});
-        auto* fList = vtkIdList::New();
-
-        for (int i = 0; i < remesh->GetNumberOfItems(); i++) {
-            cluster = clustering->GetValue(i);
+        for (int i = 0; i < numItems; i++) {
+            auto cluster = clustering->GetValue(i);
             if (cluster >= 0 && cluster < clusters) {
-                if (remesh->GetClusteringType() == 0) {
-                    vtkQuadricTools::AddTriangleQuadric(
-                        clusterQuadrics[cluster].data(), remesh->GetInput(), i,
-                        false);
-                } else {
-                    remesh->GetInput()->GetVertexNeighbourFaces(i, fList);
-                    for (int j = 0; j < fList->GetNumberOfIds(); j++) {
-                        vtkQuadricTools::AddTriangleQuadric(
-                            clusterQuadrics[cluster].data(), remesh->GetInput(),
-                            fList->GetId(j), false);
-                    }
-                }
+                offsets[cluster + 1]++;
             } else {
                 numMisclassedItems++;
             }
         }
-        fList->Delete();
+        for (std::size_t c = 0; c < numClusters; c++) {
+            offsets[c + 1] += offsets[c];
+        }
+        std::vector<vtkIdType> items(offsets.back());
+        auto next = offsets;
+        for (int i = 0; i < numItems; i++) {
+            auto cluster = clustering->GetValue(i);
+            if (cluster >= 0 && cluster < clusters) {
+                items[next[cluster]++] = i;
+            }
+        }
 
         if (numMisclassedItems != 0) {
             Logger()->warn(
@@ -119,13 +123,36 @@ void ACVD::compute_isotropic_()
                 numMisclassedItems);
         }
 
-        std::array<double, 3> pt{};
-        for (int idx = 0; idx < clusters; idx++) {
-            remesh->GetOutput()->GetPoint(idx, pt.data());
-            vtkQuadricTools::ComputeRepresentativePoint(
-                clusterQuadrics[idx].data(), pt.data(),
-                static_cast<int>(quadricsOptLevel_));
-            remesh->GetOutput()->SetPointCoordinates(idx, pt.data());
+        // Each task accumulates and solves the quadrics of a range of
+        // clusters. Items are added in the same order as a serial sweep.
+        std::vector<std::array<double, 3>> points(numClusters);
+        for (std::size_t c = 0; c < numClusters; c++) {
+            output->GetPoint(static_cast<vtkIdType>(c), points[c].data());
+        }
+        const auto level = static_cast<int>(quadricsOptLevel_);
+        ParallelChunks(numClusters, numThreads_, [&](auto begin, auto end) {
+            vtkNew<vtkIdList> fList;
+            for (auto c = begin; c < end; c++) {
+                std::array<double, 9> quadric{};
+                for (auto i = offsets[c]; i < offsets[c + 1]; i++) {
+                    if (faceItems) {
+                        vtkQuadricTools::AddTriangleQuadric(
+                            quadric.data(), input, items[i], false);
+                        continue;
+                    }
+                    input->GetVertexNeighbourFaces(items[i], fList);
+                    for (int j = 0; j < fList->GetNumberOfIds(); j++) {
+                        vtkQuadricTools::AddTriangleQuadric(
+                            quadric.data(), input, fList->GetId(j), false);
+                    }
+                }
+                vtkQuadricTools::ComputeRepresentativePoint(
+                    quadric.data(), points[c].data(), level);
+            }
+        });
+        for (std::size_t c = 0; c < numClusters; c++) {
+            output->SetPointCoordinates(
+                static_cast<vtkIdType>(c), points[c].data());
         }
 
         mesh->GetPoints()->Modified();
@@ -208,3 +235,5 @@ auto ACVD::quadricsOptimizationLevel() const -> std::size_t
 {
     return quadricsOptLevel_;
 }
+
+auto ACVD::numThreads() const -> std::size_t { return numThreads_; }
@@ -2,6 +2,8 @@
 
 #include "vc/meshing/DeepCopy.hpp"
 
+#include "vc/core/util/ThreadPool.hpp"
+
 namespace volcart::meshing
 {
 
@@ -11,35 +13,35 @@ void DeepCopy(
     bool copyVertices,
     bool copyFaces)
 {
-    // Copy the points and their normals
+    // Copy the points and their normals as whole containers
     if (copyVertices) {
-        ITKPoint p;
-        ITKPixel n;
-        for (auto pt = input->GetPoints()->Begin();
-             pt != input->GetPoints()->End(); ++pt) {
-            p = pt->Value();
-            input->GetPointData(pt.Index(), &n);
+        auto points = ITKPointsContainer::New();
+        points->CastToSTLContainer() =
+            input->GetPoints()->CastToSTLConstContainer();
+        output->SetPoints(points);
 
-            output->SetPoint(pt.Index(), p);
-            output->SetPointData(pt.Index(), n);
+        auto pointData = ITKMesh::PointDataContainer::New();
+        if (const auto* inData = input->GetPointData(); inData != nullptr) {
+            pointData->CastToSTLContainer() = inData->CastToSTLConstContainer();
         }
+        output->SetPointData(pointData);
     }
 
-    // Copy the faces
+    // Copy the faces. Every cell is a separate allocation, so allocate them
+    // in parallel and hand the whole container to the output mesh.
     if (copyFaces) {
-        ITKCell::CellAutoPointer c;
-        for (auto cell = input->GetCells()->Begin();
-             cell != input->GetCells()->End(); ++cell) {
-
-            c.TakeOwnership(new ITKTriangle);
-            for (uint32_t pointId = 0;
-                 pointId < cell.Value()->GetNumberOfPoints(); ++pointId) {
-                c->SetPointId(
-                    pointId, cell.Value()->GetPointIdsContainer()[pointId]);
+        const auto& inCells = input->GetCells()->CastToSTLConstContainer();
+        auto cells = ITKMesh::CellsContainer::New();
+        auto& outCells = cells->CastToSTLContainer();
+        outCells.resize(inCells.size(), nullptr);
+        ParallelChunks(inCells.size(), 0, [&](auto begin, auto end) {
+            for (auto i = begin; i < end; ++i) {
+                auto* tri = new ITKTriangle;
+                tri->SetPointIds(inCells[i]->PointIdsBegin());
+                outCells[i] = tri;
             }
-
-            output->SetCell(cell->Index(), c);
-        }
+        });
+        output->SetCells(cells);
     }
 }
 }  // namespace volcart::meshing
@@ -1,4 +1,9 @@
+#include <algorithm>
+#include <vector>
+
+#include <vtkCellArray.h>
 #include <vtkDoubleArray.h>
+#include <vtkIdTypeArray.h>
 #include <vtkPointData.h>
 
 #include "vc/meshing/ITK2VTK.hpp"
@@ -6,48 +11,109 @@
 namespace volcart::meshing
 {
 
-///// ITK Mesh -> VTK Polydata /////
-void ITK2VTK(ITKMesh::Pointer input, vtkSmartPointer<vtkPolyData> output)
+namespace
+{
+// ITK stores points and pixels as contiguous arrays of doubles
+static_assert(sizeof(ITKPoint) == 3 * sizeof(double));
+static_assert(sizeof(ITKPixel) == 3 * sizeof(double));
+
+// Wrap or copy a contiguous array of 3-component elements
+template <typename T>
+auto ToVTKArray(const std::vector<T>& data, bool share)
+    -> vtkSmartPointer<vtkDoubleArray>
 {
+    auto array = vtkSmartPointer<vtkDoubleArray>::New();
+    array->SetNumberOfComponents(3);
+    if (data.empty()) {
+        return array;
+    }
+    const auto size = static_cast<vtkIdType>(3 * data.size());
+    // ITK's containers don't give mutable access, but VTK filters never
+    // modify their inputs
+    auto* ptr = const_cast<double*>(data.data()->GetDataPointer());
+    if (share) {
+        array->SetArray(ptr, size, 1);
+    } else {
+        array->SetNumberOfTuples(static_cast<vtkIdType>(data.size()));
+        std::copy(ptr, ptr + size, array->GetPointer(0));
+    }
+    return array;
+}
 
-    // points + normals
+// Copy a 3-component VTK array into a contiguous ITK container
+template <typename T>
+void FromVTKArray(vtkDataArray* input, std::vector<T>& output)
+{
+    const auto num = static_cast<std::size_t>(input->GetNumberOfTuples());
+    output.resize(num);
+    if (num == 0) {
+        return;
+    }
+    auto* doubles = vtkDoubleArray::FastDownCast(input);
+    if (doubles != nullptr and doubles->GetNumberOfComponents() == 3) {
+        const auto* src = doubles->GetPointer(0);
+        std::copy(src, src + 3 * num, output.data()->GetDataPointer());
+        return;
+    }
+    for (std::size_t i = 0; i < num; ++i) {
+        const auto* v = input->GetTuple3(static_cast<vtkIdType>(i));
+        std::copy(v, v + 3, output[i].GetDataPointer());
+    }
+}
+}  // namespace
+
+///// ITK Mesh -> VTK Polydata /////
+void ITK2VTK(
+    ITKMesh::Pointer input,
+    vtkSmartPointer<vtkPolyData> output,
+    bool shareBuffers)
+{
+    // points
+    const auto& inPoints = input->GetPoints()->CastToSTLConstContainer();
     auto points = vtkSmartPointer<vtkPoints>::New();
-    auto pointNormals = vtkSmartPointer<vtkDoubleArray>::New();
-    pointNormals->SetNumberOfComponents(3);  // 3d normals (ie x,y,z)
-
-    for (auto point = input->GetPoints()->Begin();
-         point != input->GetPoints()->End(); ++point) {
-        // assign the point
-        points->InsertPoint(
-            point->Index(), point->Value()[0], point->Value()[1],
-            point->Value()[2]);
-
-        // assign the normal
-        ITKPixel normal;
-        if (input->GetPointData(point.Index(), &normal)) {
-            std::array<double, 3> ptNorm = {normal[0], normal[1], normal[2]};
-            pointNormals->InsertTuple(point->Index(), ptNorm.data());
+    points->SetData(ToVTKArray(inPoints, shareBuffers));
+
+    // normals
+    vtkSmartPointer<vtkDoubleArray> pointNormals;
+    const auto* inNormals = input->GetPointData();
+    if (inNormals != nullptr and not inPoints.empty() and
+        inNormals->Size() == inPoints.size()) {
+        pointNormals =
+            ToVTKArray(inNormals->CastToSTLConstContainer(), shareBuffers);
+    } else if (inNormals != nullptr and inNormals->Size() > 0) {
+        // Only some vertices have normals
+        pointNormals = vtkSmartPointer<vtkDoubleArray>::New();
+        pointNormals->SetNumberOfComponents(3);
+        for (auto n = inNormals->Begin(); n != inNormals->End(); ++n) {
+            if (n.Index() < inPoints.size()) {
+                pointNormals->InsertTuple(
+                    static_cast<vtkIdType>(n.Index()),
+                    n.Value().GetDataPointer());
+            }
         }
     }
 
     // cells
-    auto polys = vtkSmartPointer<vtkCellArray>::New();
+    auto offsets = vtkSmartPointer<vtkIdTypeArray>::New();
+    auto connectivity = vtkSmartPointer<vtkIdTypeArray>::New();
+    offsets->Allocate(input->GetNumberOfCells() + 1);
+    connectivity->Allocate(3 * input->GetNumberOfCells());
+    offsets->InsertNextValue(0);
     for (auto cell = input->GetCells()->Begin();
          cell != input->GetCells()->End(); ++cell) {
-
-        auto poly = vtkSmartPointer<vtkIdList>::New();
         for (auto point = cell.Value()->PointIdsBegin();
              point != cell.Value()->PointIdsEnd(); ++point) {
-            poly->InsertNextId(*point);
+            connectivity->InsertNextValue(static_cast<vtkIdType>(*point));
         }
-
-        polys->InsertNextCell(poly);
+        offsets->InsertNextValue(connectivity->GetNumberOfValues());
     }
+    auto polys = vtkSmartPointer<vtkCellArray>::New();
+    polys->SetData(offsets, connectivity);
 
     // assign to the mesh
     output->SetPoints(points);
     output->SetPolys(polys);
-    if (pointNormals->GetNumberOfTuples() > 0) {
+    if (pointNormals and pointNormals->GetNumberOfTuples() > 0) {
         output->GetPointData()->SetNormals(pointNormals);
     }
 }
@@ -57,20 +123,42 @@ void VTK2ITK(vtkSmartPointer<vtkPolyData> input, ITKMesh::Pointer output)
 {
 
     // points + normals
-    auto pointNormals = input->GetPointData()->GetNormals();
-    for (vtkIdType pointId = 0; pointId < input->GetNumberOfPoints();
-         ++pointId) {
-        auto point = input->GetPoint(pointId);
-        output->SetPoint(pointId, point);
+    const auto numPoints = input->GetNumberOfPoints();
+    if (numPoints > 0) {
+        auto points = ITKPointsContainer::New();
+        auto& pointsData = points->CastToSTLContainer();
+        FromVTKArray(input->GetPoints()->GetData(), pointsData);
+        output->SetPoints(points);
+
+        auto pointNormals = input->GetPointData()->GetNormals();
         if (pointNormals != nullptr) {
-            auto normal = pointNormals->GetTuple(pointId);
-            output->SetPointData(pointId, normal);
+            auto normals = ITKMesh::PointDataContainer::New();
+            FromVTKArray(pointNormals, normals->CastToSTLContainer());
+            output->SetPointData(normals);
         }
     }
 
     // cells
     ITKCell::CellAutoPointer cell;
-    for (vtkIdType cellId = 0; cellId < input->GetNumberOfCells(); ++cellId) {
+    const auto numCells = input->GetNumberOfCells();
+    if (numCells == input->GetNumberOfPolys()) {
+        // Read the cell array directly rather than building vtkCell objects
+        vtkIdType cellId{0};
+        vtkIdType numIds{0};
+        const vtkIdType* ids{nullptr};
+        auto* polys = input->GetPolys();
+        for (polys->InitTraversal(); polys->GetNextCell(numIds, ids) != 0;
+             ++cellId) {
+            cell.TakeOwnership(new ITKTriangle);
+            for (vtkIdType pointId = 0; pointId < numIds; ++pointId) {
+                cell->SetPointId(pointId, ids[pointId]);
+            }
+            output->SetCell(cellId, cell);
+        }
+        return;
+    }
+
+    for (vtkIdType cellId = 0; cellId < numCells; ++cellId) {
         auto inputCell = input->GetCell(cellId);  // input cell
         cell.TakeOwnership(new ITKTriangle);      // output cell
 
@@ -84,10 +172,11 @@ void VTK2ITK(vtkSmartPointer<vtkPolyData> input, ITKMesh::Pointer output)
         output->SetCell(cellId, cell);
     }
 }
-auto ITK2VTK(ITKMesh::Pointer input) -> vtkSmartPointer<vtkPolyData>
+auto ITK2VTK(ITKMesh::Pointer input, bool shareBuffers)
+    -> vtkSmartPointer<vtkPolyData>
 {
     auto result = vtkSmartPointer<vtkPolyData>::New();
-    ITK2VTK(std::move(input), result);
+    ITK2VTK(std::move(input), result, shareBuffers);
     return result;
 }
 
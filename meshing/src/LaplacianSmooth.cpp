@@ -1,13 +1,166 @@
 #include "vc/meshing/LaplacianSmooth.hpp"
 
-#include <vtkSmoothPolyDataFilter.h>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <tuple>
+#include <utility>
+#include <vector>
 
-#include "vc/meshing/CalculateNormals.hpp"
-#include "vc/meshing/ITK2VTK.hpp"
+#include "vc/core/types/FlatMesh.hpp"
+#include "vc/core/util/ThreadPool.hpp"
 
 using namespace volcart;
 using namespace volcart::meshing;
 
+using Index = FlatMesh::Index;
+
+namespace
+{
+// Ordered so that a vertex takes the highest type of its edges
+enum class VertexType : std::uint8_t { Simple, Fixed, Feature, Boundary };
+
+struct Edge {
+    Index a;
+    Index b;
+    std::size_t face;
+};
+
+// Smoothing neighbors of every vertex, stored contiguously
+struct Neighborhoods {
+    std::vector<VertexType> types;
+    std::vector<std::size_t> offsets;
+    std::vector<Index> neighbors;
+};
+
+auto DegToCos(double deg) -> double { return std::cos(deg * M_PI / 180.0); }
+
+auto BuildNeighborhoods(
+    const FlatMesh& mesh,
+    bool featureEdges,
+    double featureAngle,
+    double edgeAngle,
+    bool boundarySmoothing) -> Neighborhoods
+{
+    const auto& vertices = mesh.vertices();
+    const auto& faces = mesh.faces();
+    const auto numVerts = vertices.size();
+
+    // Unit face normals for feature edge detection
+    std::vector<cv::Vec3d> faceNormals;
+    if (featureEdges) {
+        faceNormals.reserve(faces.size());
+        for (const auto& f : faces) {
+            const auto& v0 = vertices[f[0]];
+            const auto n = (vertices[f[1]] - v0).cross(vertices[f[2]] - v0);
+            faceNormals.push_back(cv::normalize(n));
+        }
+    }
+
+    // Sort the face edges so that each unique edge is a contiguous run
+    std::vector<Edge> edges;
+    edges.reserve(3 * faces.size());
+    for (std::size_t i = 0; i < faces.size(); ++i) {
+        const auto& f = faces[i];
+        for (std::size_t k = 0; k < 3; ++k) {
+            const auto a = f[k];
+            const auto b = f[(k + 1) % 3];
+            edges.push_back({std::min(a, b), std::max(a, b), i});
+        }
+    }
+    std::sort(edges.begin(), edges.end(), [](const auto& l, const auto& r) {
+        return std::tie(l.a, l.b, l.face) < std::tie(r.a, r.b, r.face);
+    });
+
+    // Call f(a, b, type) for each unique edge
+    const auto cosFeature = DegToCos(featureAngle);
+    auto forEachEdge = [&](auto f) {
+        for (std::size_t i = 0; i < edges.size();) {
+            auto j = i + 1;
+            while (j < edges.size() and edges[j].a == edges[i].a and
+                   edges[j].b == edges[i].b) {
+                ++j;
+            }
+            auto type = VertexType::Simple;
+            if (j - i == 1) {
+                type = VertexType::Boundary;
+            } else if (j - i > 2) {
+                type = VertexType::Feature;
+            } else if (
+                featureEdges and faceNormals[edges[i].face].dot(
+                                     faceNormals[edges[i + 1].face]) <
+                                     cosFeature) {
+                type = VertexType::Feature;
+            }
+            f(edges[i].a, edges[i].b, type);
+            i = j;
+        }
+    };
+
+    // Classify vertices and count their neighbors. Simple vertices are
+    // smoothed using all of their neighbors, while boundary and feature
+    // vertices only use the neighbors along boundary and feature edges.
+    Neighborhoods result;
+    auto& types = result.types;
+    types.assign(numVerts, VertexType::Simple);
+    std::vector<std::size_t> numAll(numVerts, 0);
+    std::vector<std::size_t> numEdge(numVerts, 0);
+    forEachEdge([&](auto a, auto b, auto type) {
+        for (const auto v : {a, b}) {
+            ++numAll[v];
+            if (type != VertexType::Simple) {
+                ++numEdge[v];
+                types[v] = std::max(types[v], type);
+            }
+        }
+    });
+
+    auto& offsets = result.offsets;
+    offsets.assign(numVerts + 1, 0);
+    for (std::size_t v = 0; v < numVerts; ++v) {
+        const auto simple = types[v] == VertexType::Simple;
+        offsets[v + 1] = offsets[v] + (simple ? numAll[v] : numEdge[v]);
+    }
+
+    auto& neighbors = result.neighbors;
+    neighbors.resize(offsets.back());
+    auto next = offsets;
+    forEachEdge([&](auto a, auto b, auto type) {
+        for (const auto& [v, n] : {std::pair{a, b}, std::pair{b, a}}) {
+            if (types[v] == VertexType::Simple or type != VertexType::Simple) {
+                neighbors[next[v]++] = n;
+            }
+        }
+    });
+
+    // Fix boundary and feature vertices at corners and junctions
+    const auto cosEdge = DegToCos(edgeAngle);
+    for (std::size_t v = 0; v < numVerts; ++v) {
+        if (types[v] == VertexType::Simple) {
+            continue;
+        }
+        const auto count = offsets[v + 1] - offsets[v];
+        if (types[v] == VertexType::Boundary and not boundarySmoothing) {
+            types[v] = VertexType::Fixed;
+        } else if (count != 2) {
+            types[v] = VertexType::Fixed;
+        } else {
+            const auto& p = vertices[v];
+            const auto& p0 = vertices[neighbors[offsets[v]]];
+            const auto& p1 = vertices[neighbors[offsets[v] + 1]];
+            const auto l0 = cv::normalize(p - p0);
+            const auto l1 = cv::normalize(p1 - p);
+            if (l0.dot(l1) < cosEdge) {
+                types[v] = VertexType::Fixed;
+            }
+        }
+    }
+
+    return result;
+}
+}  // namespace
+
 void LaplacianSmooth::setInputMesh(const ITKMesh::Pointer& m) { input_ = m; }
 void LaplacianSmooth::setIterations(std::size_t i) { iters_ = i; }
 void LaplacianSmooth::setRelaxationFactor(double f) { relax_ = f; }
@@ -15,6 +168,7 @@ void LaplacianSmooth::setFeatureEdgeSmoothing(bool b) { edgeSmooth_ = b; }
 void LaplacianSmooth::setFeatureAngle(double a) { featureAngle_ = a; }
 void LaplacianSmooth::setEdgeAngle(double a) { edgeAngle_ = a; }
 void LaplacianSmooth::setBoundarySmoothing(bool b) { boundarySmooth_ = b; }
+void LaplacianSmooth::setNumThreads(std::size_t n) { numThreads_ = n; }
 
 auto LaplacianSmooth::iterations() const -> std::size_t { return iters_; }
 auto LaplacianSmooth::relaxationFactor() const -> double { return relax_; }
@@ -28,25 +182,50 @@ auto LaplacianSmooth::boundarySmoothing() const -> bool
 {
     return boundarySmooth_;
 }
+auto LaplacianSmooth::numThreads() const -> std::size_t { return numThreads_; }
 
 auto LaplacianSmooth::compute() -> ITKMesh::Pointer
 {
-    auto vtkMesh = ITK2VTK(input_);
-    auto smoother = vtkSmartPointer<vtkSmoothPolyDataFilter>::New();
-    smoother->SetInputData(vtkMesh);
-    smoother->SetNumberOfIterations(static_cast<int>(iters_));
-    smoother->SetRelaxationFactor(relax_);
-    smoother->SetFeatureEdgeSmoothing(static_cast<vtkTypeBool>(edgeSmooth_));
-    smoother->SetFeatureAngle(featureAngle_);
-    smoother->SetEdgeAngle(edgeAngle_);
-    smoother->SetBoundarySmoothing(static_cast<vtkTypeBool>(boundarySmooth_));
-    smoother->Update();
-    output_ = VTK2ITK(smoother->GetOutput());
+    auto mesh = ToFlatMesh(input_);
+    const auto hood = BuildNeighborhoods(
+        mesh, edgeSmooth_, featureAngle_, edgeAngle_, boundarySmooth_);
+
+    // Jacobi iterations between two position buffers
+    auto current = mesh.vertices();
+    auto next = current;
+    for (std::size_t it = 0; it < iters_; ++it) {
+        std::atomic<bool> moved{false};
+        ParallelChunks(current.size(), numThreads_, [&](auto begin, auto end) {
+            bool chunkMoved{false};
+            for (auto v = begin; v < end; ++v) {
+                const auto first = hood.offsets[v];
+                const auto last = hood.offsets[v + 1];
+                if (hood.types[v] == VertexType::Fixed or first == last) {
+                    next[v] = current[v];
+                    continue;
+                }
+                FlatMesh::Vertex delta(0, 0, 0);
+                for (auto i = first; i < last; ++i) {
+                    delta += current[hood.neighbors[i]] - current[v];
+                }
+                delta *= relax_ / static_cast<double>(last - first);
+                next[v] = current[v] + delta;
+                chunkMoved = chunkMoved or next[v] != current[v];
+            }
+            if (chunkMoved) {
+                moved = true;
+            }
+        });
+        std::swap(current, next);
+        if (not moved) {
+            break;
+        }
+    }
 
     // Recalculate the normals on the mesh
-    CalculateNormals normals;
-    normals.setMesh(output_);
-    output_ = normals.compute();
+    mesh.vertices() = std::move(current);
+    mesh.computeNormals(numThreads_);
+    output_ = ToITKMesh(mesh);
 
     return output_;
 }
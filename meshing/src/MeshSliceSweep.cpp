@@ -0,0 +1,138 @@
+#include "vc/meshing/MeshSliceSweep.hpp"
+
+#include <algorithm>
+#include <numeric>
+
+#include "vc/core/util/Iteration.hpp"
+
+using namespace volcart;
+using namespace volcart::meshing;
+
+MeshSliceSweep::MeshSliceSweep()
+    : data_{std::make_shared<const SortedTriangles>()}
+{
+}
+
+MeshSliceSweep::MeshSliceSweep(const FlatMesh& mesh)
+    : MeshSliceSweep(std::vector<FlatMesh>{mesh})
+{
+}
+
+MeshSliceSweep::MeshSliceSweep(const std::vector<FlatMesh>& meshes)
+{
+    // Gather the triangles
+    std::vector<Triangle> triangles;
+    for (const auto& mesh : meshes) {
+        const auto& vs = mesh.vertices();
+        for (const auto& f : mesh.faces()) {
+            triangles.push_back({vs[f[0]], vs[f[1]], vs[f[2]]});
+        }
+    }
+
+    // Sort them by their lowest vertex
+    std::vector<double> lo(triangles.size());
+    std::vector<double> hi(triangles.size());
+    for (auto [i, t] : enumerate(triangles)) {
+        lo[i] = std::min({t[0][2], t[1][2], t[2][2]});
+        hi[i] = std::max({t[0][2], t[1][2], t[2][2]});
+    }
+    std::vector<std::size_t> order(triangles.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&lo](auto a, auto b) {
+        return lo[a] < lo[b];
+    });
+
+    auto data = std::make_shared<SortedTriangles>();
+    data->triangles.reserve(order.size());
+    data->lo.reserve(order.size());
+    data->hi.reserve(order.size());
+    for (const auto& i : order) {
+        data->triangles.push_back(triangles[i]);
+        data->lo.push_back(lo[i]);
+        data->hi.push_back(hi[i]);
+    }
+    data_ = data;
+}
+
+auto MeshSliceSweep::numTriangles() const -> std::size_t
+{
+    return data_->triangles.size();
+}
+
+auto MeshSliceSweep::zMin() const -> double
+{
+    if (data_->lo.empty()) {
+        return 0;
+    }
+    return data_->lo.front();
+}
+
+auto MeshSliceSweep::zMax() const -> double
+{
+    if (data_->hi.empty()) {
+        return 0;
+    }
+    return *std::max_element(data_->hi.begin(), data_->hi.end());
+}
+
+auto MeshSliceSweep::intersect(double z) -> const std::vector<Segment>&
+{
+    if (z < lastZ_) {
+        reset();
+    }
+    lastZ_ = z;
+
+    // Drop the triangles which end below the plane
+    const auto& data = *data_;
+    active_.erase(
+        std::remove_if(
+            active_.begin(), active_.end(),
+            [&data, z](auto i) { return data.hi[i] < z; }),
+        active_.end());
+
+    // Add the triangles which start below the plane
+    for (; next_ < data.lo.size() and data.lo[next_] <= z; next_++) {
+        if (data.hi[next_] >= z) {
+            active_.push_back(next_);
+        }
+    }
+
+    segments_.clear();
+    Segment s;
+    for (const auto& i : active_) {
+        if (IntersectTriangle(data.triangles[i], z, s)) {
+            segments_.push_back(s);
+        }
+    }
+    return segments_;
+}
+
+auto MeshSliceSweep::numActive() const -> std::size_t
+{
+    return active_.size();
+}
+
+void MeshSliceSweep::reset()
+{
+    active_.clear();
+    next_ = 0;
+    lastZ_ = -std::numeric_limits<double>::infinity();
+}
+
+auto MeshSliceSweep::IntersectTriangle(
+    const Triangle& t, double z, Segment& s) -> bool
+{
+    int n{0};
+    for (int i = 0; i < 3; i++) {
+        const auto& p = t[i];
+        const auto& q = t[(i + 1) % 3];
+        auto dp = p[2] - z;
+        auto dq = q[2] - z;
+        if ((dp < 0) == (dq < 0)) {
+            continue;
+        }
+        auto f = dp / (dp - dq);
+        s[n++] = {p[0] + f * (q[0] - p[0]), p[1] + f * (q[1] - p[1])};
+    }
+    return n == 2;
+}
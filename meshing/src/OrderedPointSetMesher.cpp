@@ -1,11 +1,48 @@
 /** @file OrderedPointSetMesher.cpp */
 
 #include "vc/meshing/OrderedPointSetMesher.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
 #include <iostream>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+#include "vc/core/types/Exceptions.hpp"
+#include "vc/core/util/ThreadPool.hpp"
 #include "vc/meshing/CalculateNormals.hpp"
 
+using namespace volcart;
 using namespace volcart::meshing;
 
+namespace
+{
+// Write a value to a buffer in little-endian byte order and return the
+// position after it
+template <typename T>
+inline auto PutLE(char* out, T value) -> char*
+{
+    using Bits = std::conditional_t<
+        sizeof(T) == 4, std::uint32_t,
+        std::conditional_t<sizeof(T) == 2, std::uint16_t, std::uint8_t>>;
+    Bits bits{0};
+    std::memcpy(&bits, &value, sizeof(T));
+    for (std::size_t i = 0; i < sizeof(T); i++) {
+        *out++ = static_cast<char>((bits >> (8 * i)) & 0xFF);
+    }
+    return out;
+}
+
+// Size of a vertex record: 3 position and 3 normal floats
+constexpr std::size_t VERTEX_BYTES{6 * sizeof(float)};
+// Size of a face record: vertex count and 3 vertex indices
+constexpr std::size_t FACE_BYTES{1 + 3 * sizeof(std::int32_t)};
+}  // namespace
+
 volcart::ITKMesh::Pointer OrderedPointSetMesher::compute()
 {
     // Verify before computation
@@ -61,12 +98,197 @@ volcart::ITKMesh::Pointer OrderedPointSetMesher::compute()
 
     // Sets the normals for the points and faces
     volcart::meshing::CalculateNormals calcNorm(output_);
+    calcNorm.setInPlace(true);
     calcNorm.compute();
     output_ = calcNorm.getMesh();
 
     return output_;
 }
 
+FlatMesh OrderedPointSetMesher::computeFlatMesh()
+{
+    // Verify before computation
+    if (input_.empty()) {
+        throw std::invalid_argument("Attempted to mesh empty point set.");
+    }
+    if (input_.size() > std::numeric_limits<FlatMesh::Index>::max()) {
+        throw std::overflow_error("Point set has too many points for FlatMesh");
+    }
+
+    const auto width = input_.width();
+    const auto height = input_.height();
+    FlatMesh mesh;
+    auto& vertices = mesh.vertices();
+    vertices.assign(input_.begin(), input_.end());
+
+    // Return early if we're not triangulating
+    if (!generateTriangles_) {
+        return mesh;
+    }
+
+    // Faces are generated in the same order as compute()
+    auto& faces = mesh.faces();
+    faces.reserve(2 * (width - 1) * (height - 1));
+    for (size_t i = 0; i + 1 < height; i++) {
+        for (size_t j = 0; j + 1 < width; j++) {
+            auto p0 = static_cast<FlatMesh::Index>(i * width + j);
+            auto p1 = p0 + 1;
+            auto p2 = static_cast<FlatMesh::Index>(p1 + width);
+            auto p3 = p2 - 1;
+            faces.push_back({p1, p2, p3});
+            faces.push_back({p0, p1, p3});
+        }
+    }
+    mesh.computeNormals(0);
+
+    return mesh;
+}
+
+void OrderedPointSetMesher::writePLY(
+    const filesystem::path& path, std::size_t rowsPerChunk)
+{
+    // Verify before computation
+    if (input_.empty()) {
+        throw std::invalid_argument("Attempted to mesh empty point set.");
+    }
+    if (input_.size() >
+        static_cast<size_t>(std::numeric_limits<std::int32_t>::max())) {
+        throw std::overflow_error("Point set has too many points for PLY");
+    }
+    rowsPerChunk = std::max<std::size_t>(rowsPerChunk, 1);
+
+    std::ofstream file(path.string(), std::ios::out | std::ios::binary);
+    if (!file.is_open()) {
+        throw IOException("Failed to open file for writing: " + path.string());
+    }
+
+    // Header, as written by io::PLYWriter
+    const auto width = input_.width();
+    const auto height = input_.height();
+    std::size_t numFaces{0};
+    if (generateTriangles_) {
+        numFaces = 2 * (width - 1) * (height - 1);
+    }
+    file << "ply\n";
+    file << "format binary_little_endian 1.0\n";
+    file << "comment VC PLY Exporter v1.0\n";
+    file << "element vertex " << input_.size() << "\n";
+    file << "property float x\n";
+    file << "property float y\n";
+    file << "property float z\n";
+    file << "property float nx\n";
+    file << "property float ny\n";
+    file << "property float nz\n";
+    if (numFaces != 0) {
+        file << "element face " << numFaces << "\n";
+        file << "property list uchar int vertex_indices\n";
+    }
+    file << "end_header\n";
+
+    // Vertices, one chunk of rows at a time
+    std::vector<char> buffer;
+    for (size_t r0 = 0; r0 < height; r0 += rowsPerChunk) {
+        const auto r1 = std::min(r0 + rowsPerChunk, height);
+        buffer.resize((r1 - r0) * width * VERTEX_BYTES);
+        ParallelChunks(r1 - r0, 0, [&](auto begin, auto end) {
+            for (auto r = r0 + begin; r < r0 + end; r++) {
+                auto* out = buffer.data() + (r - r0) * width * VERTEX_BYTES;
+                for (size_t c = 0; c < width; c++) {
+                    const auto& p = input_(r, c);
+                    cv::Vec3d n(0, 0, 0);
+                    if (generateTriangles_) {
+                        n = vertex_normal_(r, c);
+                    }
+                    for (const auto& v : {p[0], p[1], p[2], n[0], n[1], n[2]}) {
+                        out = PutLE(out, static_cast<float>(v));
+                    }
+                }
+            }
+        });
+        file.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    }
+
+    // Faces, one chunk of rows at a time
+    const auto cellRows = (numFaces == 0) ? 0 : height - 1;
+    const auto rowBytes = 2 * (width - 1) * FACE_BYTES;
+    for (size_t r0 = 0; r0 < cellRows; r0 += rowsPerChunk) {
+        const auto r1 = std::min(r0 + rowsPerChunk, cellRows);
+        buffer.resize((r1 - r0) * rowBytes);
+        ParallelChunks(r1 - r0, 0, [&](auto begin, auto end) {
+            for (auto i = r0 + begin; i < r0 + end; i++) {
+                auto* out = buffer.data() + (i - r0) * rowBytes;
+                for (size_t j = 0; j + 1 < width; j++) {
+                    auto p0 = static_cast<std::int32_t>(i * width + j);
+                    auto p1 = p0 + 1;
+                    auto p2 = p1 + static_cast<std::int32_t>(width);
+                    auto p3 = p2 - 1;
+                    for (const auto& f : {std::array{p1, p2, p3},
+                                          std::array{p0, p1, p3}}) {
+                        out = PutLE(out, std::uint8_t{3});
+                        for (const auto& v : f) {
+                            out = PutLE(out, v);
+                        }
+                    }
+                }
+            }
+        });
+        file.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    }
+
+    if (!file) {
+        throw IOException("Failed to write file: " + path.string());
+    }
+}
+
+cv::Vec3d OrderedPointSetMesher::vertex_normal_(size_t row, size_t col) const
+{
+    const auto width = input_.width();
+    const auto height = input_.height();
+    auto faceNormal = [this](auto a, auto b, auto c) {
+        const auto& v0 = input_(a[0], a[1]);
+        const auto e0 = input_(c[0], c[1]) - v0;
+        const auto e1 = input_(b[0], b[1]) - v0;
+        return e1.cross(e0);
+    };
+
+    // A cell (i, j) has the faces (p1, p2, p3) and (p0, p1, p3), where p0 is
+    // (i, j), p1 is (i, j + 1), p2 is (i + 1, j + 1), and p3 is (i + 1, j).
+    // Sum the adjacent faces in the order they appear in the mesh.
+    using Cell = std::array<size_t, 2>;
+    const auto hasUp = row > 0;
+    const auto hasDown = row + 1 < height;
+    const auto hasLeft = col > 0;
+    const auto hasRight = col + 1 < width;
+    cv::Vec3d n(0, 0, 0);
+    if (hasUp and hasLeft) {
+        // Vertex is p2
+        const auto i = row - 1;
+        const auto j = col - 1;
+        n += faceNormal(Cell{i, j + 1}, Cell{i + 1, j + 1}, Cell{i + 1, j});
+    }
+    if (hasUp and hasRight) {
+        // Vertex is p3
+        const auto i = row - 1;
+        const auto j = col;
+        n += faceNormal(Cell{i, j + 1}, Cell{i + 1, j + 1}, Cell{i + 1, j});
+        n += faceNormal(Cell{i, j}, Cell{i, j + 1}, Cell{i + 1, j});
+    }
+    if (hasDown and hasLeft) {
+        // Vertex is p1
+        const auto i = row;
+        const auto j = col - 1;
+        n += faceNormal(Cell{i, j + 1}, Cell{i + 1, j + 1}, Cell{i + 1, j});
+        n += faceNormal(Cell{i, j}, Cell{i, j + 1}, Cell{i + 1, j});
+    }
+    if (hasDown and hasRight) {
+        // Vertex is p0
+        const auto i = row;
+        const auto j = col;
+        n += faceNormal(Cell{i, j}, Cell{i, j + 1}, Cell{i + 1, j});
+    }
+    return cv::normalize(n);
+}
+
 void OrderedPointSetMesher::add_cell_(size_t a, size_t b, size_t c)
 {
     ITKCell::CellAutoPointer currentC;
@@ -1,9 +1,14 @@
 /* @file OrderedResampling.cpp*/
 
 #include "vc/meshing/OrderedResampling.hpp"
+
+#include <limits>
+
+#include "vc/core/types/FlatMesh.hpp"
 #include "vc/core/util/Logging.hpp"
-#include "vc/meshing/CalculateNormals.hpp"
+#include "vc/core/util/ThreadPool.hpp"
 
+using namespace volcart;
 using namespace volcart::meshing;
 
 //// Set Inputs/Get Output ////
@@ -28,80 +33,66 @@ volcart::ITKMesh::Pointer OrderedResampling::getOutputMesh() const
 ///// Processing /////
 void OrderedResampling::compute()
 {
-    output_ = ITKMesh::New();
-
     // Dimensions of resampled, ordered mesh
     outWidth_ = (inWidth_ + 1) / 2;
     outHeight_ = (inHeight_ + 1) / 2;
 
-    // Tells the loop whether or not the points in that line should be added to
-    // the new mesh
-    bool lineSkip = false;
-
-    // Loop iterator
-    int k = 0;
-    // Adds certain points from old mesh into the new mesh
-    for (auto pointsIt = input_->GetPoints()->Begin();
-         pointsIt != input_->GetPoints()->End(); pointsIt++, k++) {
-
-        // If we've reached the end of a row, reset k and flip the lineSkip
-        // bool
-        if (k == inWidth_) {
-            k = 0;
-            lineSkip = !lineSkip;
-        }
-
-        // Skip this point if we're skipping this line
-        if (lineSkip) {
-            continue;
-        }
-
-        // Only add every other point
-        if (k % 2 == 0) {
-            output_->SetPoint(output_->GetNumberOfPoints(), pointsIt.Value());
-        }
+    // Every output vertex is looked up by its position in the input ordering
+    // matrix, so the matrix must cover the input mesh exactly
+    const auto inWidth = static_cast<std::size_t>(inWidth_);
+    const auto inHeight = static_cast<std::size_t>(inHeight_);
+    if (inWidth_ < 0 or inHeight_ < 0 or
+        input_->GetNumberOfPoints() != inWidth * inHeight) {
+        throw std::out_of_range(
+            "Ordering matrix dimensions do not match number of points in "
+            "mesh.");
     }
 
-    // Something went wrong with resampling. Number of points aren't what we
-    // expect...
-    assert(
-        static_cast<int>(output_->GetNumberOfPoints()) ==
-            outWidth_ * outHeight_ &&
-        "Error resampling. Output and expected output don't match.");
-
-    // Vertices for each face in the new mesh
-    uint32_t point1, point2, point3, point4;
-
-    // Create two new faces each iteration based on new set of points and keeps
-    // normals same as original
-    for (int i = 0; i < outHeight_ - 1; i++) {
-        for (int j = 0; j < outWidth_ - 1; j++) {
-
-            // 4 points allows us to create the upper and lower faces at the
-            // same time
-            point1 = i * outWidth_ + j;
-            point2 = point1 + 1;
-            point3 = point2 + outWidth_;
-            point4 = point3 - 1;
-
-            if (point1 >= output_->GetNumberOfPoints() ||
-                point2 >= output_->GetNumberOfPoints() ||
-                point3 >= output_->GetNumberOfPoints() ||
-                point4 >= output_->GetNumberOfPoints()) {
-                throw std::out_of_range(
-                    "Predicted vertex index for face generation out of range "
-                    "of point set.");
+    FlatMesh mesh;
+    const auto outWidth = static_cast<std::size_t>(outWidth_);
+    const auto outHeight = static_cast<std::size_t>(outHeight_);
+    const auto numVerts = outWidth * outHeight;
+    if (numVerts > std::numeric_limits<FlatMesh::Index>::max()) {
+        throw std::overflow_error("Resampled mesh has too many vertices");
+    }
+    const auto numCells =
+        (outWidth > 1 and outHeight > 1) ? (outWidth - 1) * (outHeight - 1) : 0;
+    auto& vertices = mesh.vertices();
+    auto& faces = mesh.faces();
+    vertices.resize(numVerts);
+    faces.resize(2 * numCells);
+
+    // Keep every other point of every other row. Each output row, and the row
+    // of faces below it, is independent of the others.
+    const auto* points = input_->GetPoints();
+    ParallelChunks(outHeight, numThreads_, [&](auto begin, auto end) {
+        for (auto i = begin; i < end; ++i) {
+            for (std::size_t j = 0; j < outWidth; ++j) {
+                const auto& p = points->ElementAt(2 * i * inWidth + 2 * j);
+                vertices[i * outWidth + j] = {p[0], p[1], p[2]};
             }
 
-            // Add both these faces to the mesh
-            add_cell_(point2, point3, point4);
-            add_cell_(point1, point2, point4);
+            // Create two new faces for each cell below this row
+            if (i + 1 >= outHeight) {
+                continue;
+            }
+            for (std::size_t j = 0; j + 1 < outWidth; ++j) {
+                // 4 points allows us to create the upper and lower faces at
+                // the same time
+                auto point1 = static_cast<FlatMesh::Index>(i * outWidth + j);
+                auto point2 = point1 + 1;
+                auto point3 = static_cast<FlatMesh::Index>(point2 + outWidth);
+                auto point4 = point3 - 1;
+
+                const auto f = 2 * (i * (outWidth - 1) + j);
+                faces[f] = {point2, point3, point4};
+                faces[f + 1] = {point1, point2, point4};
+            }
         }
-    }
+    });
 
-    volcart::meshing::CalculateNormals calcNorm(output_);
-    calcNorm.compute();
-    output_ = calcNorm.getMesh();
+    mesh.computeNormals(numThreads_);
+    output_ = ToITKMesh(mesh);
 
     Logger()->info(
         "OrderedResampling: Points in resampled mesh" +
@@ -110,16 +101,3 @@ void OrderedResampling::compute()
         "OrderedResampling: Cells in resampled mesh " +
         std::to_string(output_->GetNumberOfCells()));
 }
-
-void OrderedResampling::add_cell_(uint32_t a, uint32_t b, uint32_t c)
-{
-    ITKCell::CellAutoPointer currentCell;
-
-    currentCell.TakeOwnership(new ITKTriangle);
-
-    currentCell->SetPointId(0, a);
-    currentCell->SetPointId(1, b);
-    currentCell->SetPointId(2, c);
-
-    output_->SetCell(output_->GetNumberOfCells(), currentCell);
-}
@@ -0,0 +1,579 @@
+#include "vc/meshing/QuadricDecimation.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <iterator>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include "vc/core/util/Logging.hpp"
+#include "vc/core/util/ThreadPool.hpp"
+
+using namespace volcart;
+using namespace volcart::meshing;
+
+using Index = FlatMesh::Index;
+
+namespace
+{
+// Maximum number of collapse passes
+constexpr int MAX_PASSES{100};
+// Number of passes between compactions of the face list
+constexpr int COMPACT_INTERVAL{5};
+// Base error threshold, relative to the squared mean edge length
+constexpr double BASE_THRESHOLD{1e-9};
+// Minimum cosine between a face normal before and after a collapse
+constexpr double MIN_NORMAL_COS{0.2};
+// Maximum cosine between the edges of a face after a collapse
+constexpr double MAX_EDGE_COS{0.999};
+// Relative determinant below which a quadric is treated as singular
+constexpr double SINGULAR_DET{1e-9};
+// Error of an edge which may not be collapsed
+constexpr double NO_COLLAPSE{std::numeric_limits<double>::infinity()};
+
+// Symmetric 4x4 quadric error matrix, stored as its upper triangle
+class Quadric
+{
+public:
+    Quadric() = default;
+
+    // Quadric of the distance to the plane ax + by + cz + d = 0
+    Quadric(double a, double b, double c, double d)
+        : m_{a * a, a * b, a * c, a * d, b * b,
+             b * c, b * d, c * c, c * d, d * d}
+    {
+    }
+
+    auto operator+=(const Quadric& o) -> Quadric&
+    {
+        for (std::size_t i = 0; i < m_.size(); i++) {
+            m_[i] += o.m_[i];
+        }
+        return *this;
+    }
+
+    auto operator+(const Quadric& o) const -> Quadric
+    {
+        auto r = *this;
+        r += o;
+        return r;
+    }
+
+    // Quadric error of a position
+    [[nodiscard]] auto error(const cv::Vec3d& p) const -> double
+    {
+        const auto x = p[0];
+        const auto y = p[1];
+        const auto z = p[2];
+        return m_[0] * x * x + 2 * m_[1] * x * y + 2 * m_[2] * x * z +
+               2 * m_[3] * x + m_[4] * y * y + 2 * m_[5] * y * z +
+               2 * m_[6] * y + m_[7] * z * z + 2 * m_[8] * z + m_[9];
+    }
+
+    // Position with the least error. Returns false if it is not unique.
+    auto minimizer(cv::Vec3d& p) const -> bool
+    {
+        cv::Matx33d a(
+            m_[0], m_[1], m_[2], m_[1], m_[4], m_[5], m_[2], m_[5], m_[7]);
+        const auto scale = m_[0] + m_[4] + m_[7];
+        const auto minDet = SINGULAR_DET * scale * scale * scale;
+        if (std::abs(cv::determinant(a)) <= minDet) {
+            return false;
+        }
+        p = a.solve(cv::Vec3d(-m_[3], -m_[6], -m_[8]), cv::DECOMP_LU);
+        return true;
+    }
+
+private:
+    std::array<double, 10> m_{};
+};
+
+struct Face {
+    std::array<Index, 3> v;
+    // Error of each edge, and the least of them
+    std::array<double, 4> err{};
+    cv::Vec3d n;
+    bool deleted{false};
+    // Touched by a collapse in the current pass
+    bool dirty{false};
+};
+
+struct Vertex {
+    cv::Vec3d p;
+    Quadric q;
+    // Range of the vertex's faces in the reference list
+    std::size_t start{0};
+    std::size_t count{0};
+    bool border{false};
+};
+
+// A face which uses a vertex, and the vertex's corner of that face
+struct Ref {
+    std::size_t face;
+    std::size_t corner;
+};
+
+auto FaceNormal(const cv::Vec3d& a, const cv::Vec3d& b, const cv::Vec3d& c)
+    -> cv::Vec3d
+{
+    return cv::normalize((b - a).cross(c - a));
+}
+
+class Decimator
+{
+public:
+    Decimator(const FlatMesh& mesh, std::size_t numThreads)
+        : numThreads_{numThreads}
+    {
+        const auto& vertices = mesh.vertices();
+        verts_.resize(vertices.size());
+        for (std::size_t i = 0; i < vertices.size(); i++) {
+            verts_[i].p = vertices[i];
+        }
+        if (mesh.hasUVs()) {
+            uvs_ = mesh.uvs();
+        }
+
+        // Degenerate faces would corrupt the vertex rings
+        faces_.reserve(mesh.numFaces());
+        for (const auto& f : mesh.faces()) {
+            if (f[0] != f[1] and f[1] != f[2] and f[2] != f[0]) {
+                faces_.emplace_back().v = f;
+            }
+        }
+        init_();
+    }
+
+    // Collapse edges until there are at most `target` vertices
+    void run(std::size_t target, double aggressiveness)
+    {
+        std::vector<bool> deleted0;
+        std::vector<bool> deleted1;
+        for (int pass = 0; pass < MAX_PASSES; pass++) {
+            if (liveVerts_ <= target) {
+                break;
+            }
+            if (pass > 0 and pass % COMPACT_INTERVAL == 0) {
+                compact_faces_();
+                update_refs_();
+            }
+            for (auto& f : faces_) {
+                f.dirty = false;
+            }
+
+            auto threshold = BASE_THRESHOLD *
+                             std::pow(pass + 3, aggressiveness) * errorScale_;
+            for (auto& f : faces_) {
+                if (f.deleted or f.dirty or f.err[3] > threshold) {
+                    continue;
+                }
+                for (std::size_t j = 0; j < 3; j++) {
+                    if (f.err[j] > threshold) {
+                        continue;
+                    }
+                    auto i0 = f.v[j];
+                    auto i1 = f.v[(j + 1) % 3];
+                    if (collapse_(i0, i1, deleted0, deleted1)) {
+                        break;
+                    }
+                }
+                if (liveVerts_ <= target) {
+                    break;
+                }
+            }
+        }
+    }
+
+    // Convert the remaining faces and their vertices to a FlatMesh
+    [[nodiscard]] auto toFlatMesh() const -> FlatMesh
+    {
+        FlatMesh out;
+        std::vector<Index> ids(verts_.size(), 0);
+        std::vector<bool> used(verts_.size(), false);
+        for (const auto& f : faces_) {
+            if (not f.deleted) {
+                for (auto v : f.v) {
+                    used[v] = true;
+                }
+            }
+        }
+        for (std::size_t i = 0; i < verts_.size(); i++) {
+            if (used[i]) {
+                ids[i] = out.addVertex(verts_[i].p);
+                if (not uvs_.empty()) {
+                    out.uvs().push_back(uvs_[i]);
+                }
+            }
+        }
+        for (const auto& f : faces_) {
+            if (not f.deleted) {
+                out.addFace(ids[f.v[0]], ids[f.v[1]], ids[f.v[2]]);
+            }
+        }
+        return out;
+    }
+
+private:
+    std::vector<Vertex> verts_;
+    std::vector<Face> faces_;
+    std::vector<Ref> refs_;
+    std::vector<FlatMesh::UV> uvs_;
+    std::size_t numThreads_;
+    std::size_t liveVerts_{0};
+    double errorScale_{1};
+
+    // Compute the vertex quadrics, borders, and initial edge errors
+    void init_()
+    {
+        update_refs_();
+
+        ParallelChunks(faces_.size(), numThreads_, [&](auto begin, auto end) {
+            for (auto i = begin; i < end; i++) {
+                auto& f = faces_[i];
+                f.n = FaceNormal(
+                    verts_[f.v[0]].p, verts_[f.v[1]].p, verts_[f.v[2]].p);
+            }
+        });
+
+        // An edge used by other than two faces is on the border
+        ParallelChunks(verts_.size(), numThreads_, [&](auto begin, auto end) {
+            std::vector<std::pair<Index, int>> neighbors;
+            for (auto i = begin; i < end; i++) {
+                auto& v = verts_[i];
+                neighbors.clear();
+                for (auto k = v.start; k < v.start + v.count; k++) {
+                    const auto& r = refs_[k];
+                    const auto& f = faces_[r.face];
+                    for (auto c : {(r.corner + 1) % 3, (r.corner + 2) % 3}) {
+                        auto it = std::find_if(
+                            neighbors.begin(), neighbors.end(),
+                            [&](auto& n) { return n.first == f.v[c]; });
+                        if (it == neighbors.end()) {
+                            neighbors.emplace_back(f.v[c], 1);
+                        } else {
+                            it->second++;
+                        }
+                    }
+                }
+                v.border = std::any_of(
+                    neighbors.begin(), neighbors.end(),
+                    [](auto& n) { return n.second != 2; });
+
+                for (auto k = v.start; k < v.start + v.count; k++) {
+                    const auto& f = faces_[refs_[k].face];
+                    const auto& n = f.n;
+                    const auto d = -n.dot(verts_[f.v[0]].p);
+                    v.q += Quadric(n[0], n[1], n[2], d);
+                }
+            }
+        });
+
+        // Scale the error threshold to the size of the faces
+        double sumSq{0};
+        for (const auto& f : faces_) {
+            for (std::size_t j = 0; j < 3; j++) {
+                auto d = verts_[f.v[j]].p - verts_[f.v[(j + 1) % 3]].p;
+                sumSq += d.dot(d);
+            }
+        }
+        if (not faces_.empty() and sumSq > 0) {
+            errorScale_ = sumSq / static_cast<double>(3 * faces_.size());
+        }
+
+        ParallelChunks(faces_.size(), numThreads_, [&](auto begin, auto end) {
+            for (auto i = begin; i < end; i++) {
+                update_errors_(faces_[i]);
+            }
+        });
+
+        liveVerts_ = static_cast<std::size_t>(std::count_if(
+            verts_.begin(), verts_.end(),
+            [](const auto& v) { return v.count > 0; }));
+    }
+
+    // Rebuild the face references of every vertex
+    void update_refs_()
+    {
+        for (auto& v : verts_) {
+            v.start = 0;
+            v.count = 0;
+        }
+        for (const auto& f : faces_) {
+            for (auto v : f.v) {
+                verts_[v].count++;
+            }
+        }
+        std::size_t start{0};
+        for (auto& v : verts_) {
+            v.start = start;
+            start += v.count;
+            v.count = 0;
+        }
+        refs_.resize(start);
+        for (std::size_t i = 0; i < faces_.size(); i++) {
+            for (std::size_t c = 0; c < 3; c++) {
+                auto& v = verts_[faces_[i].v[c]];
+                refs_[v.start + v.count++] = {i, c};
+            }
+        }
+    }
+
+    // Remove deleted faces
+    void compact_faces_()
+    {
+        faces_.erase(
+            std::remove_if(
+                faces_.begin(), faces_.end(),
+                [](const auto& f) { return f.deleted; }),
+            faces_.end());
+    }
+
+    // Error of collapsing an edge, and the position of the new vertex
+    auto edge_error_(Index i0, Index i1, cv::Vec3d& p) const -> double
+    {
+        const auto& v0 = verts_[i0];
+        const auto& v1 = verts_[i1];
+        if (v0.border or v1.border) {
+            return NO_COLLAPSE;
+        }
+        auto q = v0.q + v1.q;
+        if (q.minimizer(p)) {
+            return q.error(p);
+        }
+
+        // Take the best of the end points and the midpoint
+        double best{NO_COLLAPSE};
+        for (const auto& c : {v0.p, v1.p, 0.5 * (v0.p + v1.p)}) {
+            auto e = q.error(c);
+            if (e < best) {
+                best = e;
+                p = c;
+            }
+        }
+        return best;
+    }
+
+    void update_errors_(Face& f) const
+    {
+        cv::Vec3d p;
+        for (std::size_t j = 0; j < 3; j++) {
+            f.err[j] = edge_error_(f.v[j], f.v[(j + 1) % 3], p);
+        }
+        f.err[3] = std::min({f.err[0], f.err[1], f.err[2]});
+    }
+
+    // Whether collapsing an edge keeps the mesh manifold: the vertices may
+    // only share the neighbors of the faces on the edge
+    [[nodiscard]] auto link_ok_(Index i0, Index i1) const -> bool
+    {
+        auto ring = [&](Index i, std::size_t& numShared) {
+            std::vector<Index> r;
+            const auto& v = verts_[i];
+            for (auto k = v.start; k < v.start + v.count; k++) {
+                const auto& f = faces_[refs_[k].face];
+                if (f.deleted) {
+                    continue;
+                }
+                if (f.v[0] == i1 or f.v[1] == i1 or f.v[2] == i1) {
+                    numShared++;
+                }
+                for (auto n : f.v) {
+                    if (n != i0 and n != i1) {
+                        r.push_back(n);
+                    }
+                }
+            }
+            std::sort(r.begin(), r.end());
+            r.erase(std::unique(r.begin(), r.end()), r.end());
+            return r;
+        };
+        std::size_t shared{0};
+        std::size_t ignored{0};
+        auto r0 = ring(i0, shared);
+        auto r1 = ring(i1, ignored);
+        std::vector<Index> common;
+        std::set_intersection(
+            r0.begin(), r0.end(), r1.begin(), r1.end(),
+            std::back_inserter(common));
+        return shared == 2 and common.size() == 2;
+    }
+
+    // Whether moving vertex i0 to p flips or degenerates one of its faces
+    // which doesn't contain i1. Marks the faces which contain i1.
+    auto flipped_(
+        const cv::Vec3d& p, Index i0, Index i1, std::vector<bool>& deleted)
+        -> bool
+    {
+        const auto& v = verts_[i0];
+        deleted.assign(v.count, false);
+        for (std::size_t k = 0; k < v.count; k++) {
+            const auto& r = refs_[v.start + k];
+            const auto& f = faces_[r.face];
+            if (f.deleted) {
+                continue;
+            }
+            auto id1 = f.v[(r.corner + 1) % 3];
+            auto id2 = f.v[(r.corner + 2) % 3];
+            if (id1 == i1 or id2 == i1) {
+                deleted[k] = true;
+                continue;
+            }
+            auto d1 = verts_[id1].p - p;
+            auto d2 = verts_[id2].p - p;
+            auto l1 = cv::norm(d1);
+            auto l2 = cv::norm(d2);
+            if (l1 <= 0 or l2 <= 0) {
+                return true;
+            }
+            d1 /= l1;
+            d2 /= l2;
+            if (std::abs(d1.dot(d2)) > MAX_EDGE_COS) {
+                return true;
+            }
+            auto n = cv::normalize(d1.cross(d2));
+            if (n.dot(f.n) < MIN_NORMAL_COS) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Move the faces of a vertex to i0, deleting the faces of the edge
+    void update_faces_(
+        Index i0, std::size_t start, std::size_t count,
+        const std::vector<bool>& deleted)
+    {
+        for (std::size_t k = 0; k < count; k++) {
+            const auto r = refs_[start + k];
+            auto& f = faces_[r.face];
+            if (f.deleted) {
+                continue;
+            }
+            if (deleted[k]) {
+                f.deleted = true;
+                continue;
+            }
+            f.v[r.corner] = i0;
+            f.dirty = true;
+            f.n = FaceNormal(
+                verts_[f.v[0]].p, verts_[f.v[1]].p, verts_[f.v[2]].p);
+            update_errors_(f);
+            refs_.push_back(r);
+        }
+    }
+
+    // Collapse i1 into i0, if it keeps the mesh valid
+    auto collapse_(
+        Index i0,
+        Index i1,
+        std::vector<bool>& deleted0,
+        std::vector<bool>& deleted1) -> bool
+    {
+        if (not link_ok_(i0, i1)) {
+            return false;
+        }
+        cv::Vec3d p;
+        edge_error_(i0, i1, p);
+        if (flipped_(p, i0, i1, deleted0) or flipped_(p, i1, i0, deleted1)) {
+            return false;
+        }
+
+        auto& v0 = verts_[i0];
+        auto& v1 = verts_[i1];
+        if (not uvs_.empty()) {
+            // Interpolate along the edge at the new vertex's projection
+            auto e = v1.p - v0.p;
+            auto len2 = e.dot(e);
+            auto t = len2 > 0 ? std::clamp((p - v0.p).dot(e) / len2, 0., 1.)
+                              : 0.5;
+            uvs_[i0] = (1 - t) * uvs_[i0] + t * uvs_[i1];
+        }
+        v0.p = p;
+        v0.q += v1.q;
+
+        // Append the merged face references, then move them into the
+        // range of i0 if they fit
+        const auto start = refs_.size();
+        update_faces_(i0, v0.start, v0.count, deleted0);
+        update_faces_(i0, v1.start, v1.count, deleted1);
+        const auto count = refs_.size() - start;
+        if (count <= v0.count) {
+            std::copy(
+                refs_.begin() + static_cast<std::ptrdiff_t>(start),
+                refs_.end(),
+                refs_.begin() + static_cast<std::ptrdiff_t>(v0.start));
+            refs_.resize(start);
+        } else {
+            v0.start = start;
+        }
+        v0.count = count;
+        v1.count = 0;
+        liveVerts_--;
+        return true;
+    }
+};
+}  // namespace
+
+void QuadricDecimation::setInputMesh(const ITKMesh::Pointer& m)
+{
+    input_ = ToFlatMesh(m);
+}
+
+void QuadricDecimation::setInputMesh(FlatMesh m) { input_ = std::move(m); }
+
+void QuadricDecimation::setTargetVertices(std::size_t n)
+{
+    targetVertices_ = n;
+}
+
+auto QuadricDecimation::targetVertices() const -> std::size_t
+{
+    return targetVertices_;
+}
+
+void QuadricDecimation::setAggressiveness(double a) { aggressiveness_ = a; }
+
+auto QuadricDecimation::aggressiveness() const -> double
+{
+    return aggressiveness_;
+}
+
+void QuadricDecimation::setNumThreads(std::size_t n) { numThreads_ = n; }
+
+auto QuadricDecimation::numThreads() const -> std::size_t
+{
+    return numThreads_;
+}
+
+auto QuadricDecimation::compute() -> ITKMesh::Pointer
+{
+    auto target = targetVertices_;
+    if (target == 0) {
+        target = input_.numVertices();
+    }
+
+    Decimator decimator(input_, numThreads_);
+    decimator.run(target, aggressiveness_);
+    output_ = decimator.toFlatMesh();
+    if (input_.hasNormals()) {
+        output_.computeNormals(numThreads_);
+    }
+    Logger()->debug(
+        "Decimated mesh from {} to {} vertices", input_.numVertices(),
+        output_.numVertices());
+
+    outputMesh_ = ToITKMesh(output_);
+    return outputMesh_;
+}
+
+auto QuadricDecimation::getOutputMesh() const -> ITKMesh::Pointer
+{
+    return outputMesh_;
+}
+
+auto QuadricDecimation::getOutputFlatMesh() const -> const FlatMesh&
+{
+    return output_;
+}
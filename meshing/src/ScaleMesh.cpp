@@ -1,6 +1,8 @@
 /**@file ScaleMesh.cpp  */
 
 #include "vc/meshing/ScaleMesh.hpp"
+
+#include "vc/core/util/ThreadPool.hpp"
 #include "vc/meshing/DeepCopy.hpp"
 
 namespace volcart::meshing
@@ -11,16 +13,28 @@ void ScaleMesh(
     const ITKMesh::Pointer& output,
     double scaleFactor)
 {
-    // Copies the input mesh onto the output mesh
-    DeepCopy(input, output);
-
-    // Multiplies each component of each vertex by the scale factor
-    for (auto v = output->GetPoints()->Begin(); v != output->GetPoints()->End();
-         ++v) {
-        v->Value()[0] *= scaleFactor;
-        v->Value()[1] *= scaleFactor;
-        v->Value()[2] *= scaleFactor;
+    // Copy the faces and normals, then write the scaled points directly
+    // rather than copying the points and scaling them in a second pass
+    DeepCopy(input, output, false, true);
+
+    auto pointData = ITKMesh::PointDataContainer::New();
+    if (const auto* inData = input->GetPointData(); inData != nullptr) {
+        pointData->CastToSTLContainer() = inData->CastToSTLConstContainer();
     }
+    output->SetPointData(pointData);
+
+    const auto& inPts = input->GetPoints()->CastToSTLConstContainer();
+    auto points = ITKPointsContainer::New();
+    auto& outPts = points->CastToSTLContainer();
+    outPts.resize(inPts.size());
+    ParallelChunks(inPts.size(), 0, [&](auto begin, auto end) {
+        for (auto i = begin; i < end; ++i) {
+            outPts[i][0] = inPts[i][0] * scaleFactor;
+            outPts[i][1] = inPts[i][1] * scaleFactor;
+            outPts[i][2] = inPts[i][2] * scaleFactor;
+        }
+    });
+    output->SetPoints(points);
 }
 
 ITKMesh::Pointer ScaleMesh(const ITKMesh::Pointer& input, double scaleFactor)
@@ -29,4 +43,17 @@ ITKMesh::Pointer ScaleMesh(const ITKMesh::Pointer& input, double scaleFactor)
     ScaleMesh(input, output, scaleFactor);
     return output;
 }
+
+void ScaleMeshInPlace(const ITKMesh::Pointer& mesh, double scaleFactor)
+{
+    auto& pts = mesh->GetPoints()->CastToSTLContainer();
+    ParallelChunks(pts.size(), 0, [&](auto begin, auto end) {
+        for (auto i = begin; i < end; ++i) {
+            pts[i][0] *= scaleFactor;
+            pts[i][1] *= scaleFactor;
+            pts[i][2] *= scaleFactor;
+        }
+    });
+    mesh->Modified();
+}
 }  // namespace volcart::meshing
@@ -2,74 +2,87 @@
 // Abigail Coleman June 2015
 
 /** @file SmoothNormals.cpp*/
-#include <fstream>
-#include <iostream>
+#include <algorithm>
+#include <cmath>
 #include <vector>
 
 #include <opencv2/core.hpp>
 
+#include "vc/core/types/KDTree.hpp"
+#include "vc/core/util/ThreadPool.hpp"
 #include "vc/meshing/DeepCopy.hpp"
 #include "vc/meshing/SmoothNormals.hpp"
 
 namespace volcart::meshing
 {
 
-ITKMesh::Pointer SmoothNormals(const ITKMesh::Pointer& input, double radius)
+ITKMesh::Pointer SmoothNormals(
+    const ITKMesh::Pointer& input,
+    double radius,
+    NormalWeighting weighting,
+    std::size_t numThreads)
 {
     // declare pointer to new Mesh object to be returned
     auto outputMesh = ITKMesh::New();
     volcart::meshing::DeepCopy(input, outputMesh);
 
-    // Variables for normal smoothing
-    cv::Vec3d neighborAvg;
-    double neighborCount;
-
-    // Use pointsLocator to find neighborhood within given radius
-    auto pointsLocator = ITKPointsLocator::New();
-    pointsLocator->SetPoints(input->GetPoints());
-    pointsLocator->Initialize();
-    typename ITKPointsLocator::NeighborsIdentifierType neighborhood;
-
-    // Iterate over all of the cells to lay out the faces in the output texture
-    for (auto point = input->GetPoints()->Begin();
-         point != input->GetPoints()->End(); ++point) {
-
-        // Empty our averaging variables
-        if (!neighborhood.empty()) {
-            neighborhood.clear();
+    // Flat copies of the vertex positions and normals
+    const auto numPts = input->GetNumberOfPoints();
+    std::vector<cv::Vec3d> points(numPts);
+    for (auto pt = input->GetPoints()->Begin(); pt != input->GetPoints()->End();
+         ++pt) {
+        const auto& p = pt.Value();
+        points[pt.Index()] = {p[0], p[1], p[2]};
+    }
+    std::vector<cv::Vec3d> normals(numPts, {0, 0, 0});
+    if (const auto* data = input->GetPointData(); data != nullptr) {
+        for (auto n = data->Begin(); n != data->End(); ++n) {
+            if (n.Index() < numPts) {
+                const auto& v = n.Value();
+                normals[n.Index()] = {v[0], v[1], v[2]};
+            }
         }
-        neighborCount = 0;
-        neighborAvg = cv::Vec3d(0, 0, 0);
-
-        // Get the current normal and add it to the summed normal
-        ITKPixel currentNormal;
-        input->GetPointData(point.Index(), &currentNormal);
-        neighborAvg[0] += currentNormal[0];
-        neighborAvg[1] += currentNormal[1];
-        neighborAvg[2] += currentNormal[2];
-        ++neighborCount;
+    }
 
-        // find neighborhood for current point within radius
-        pointsLocator->FindPointsWithinRadius(
-            point->Value(), radius, neighborhood);
+    // Use a KD-tree to find neighborhoods within the given radius
+    const KDTree tree(points);
+    const auto sigma = radius / 3;
+    const auto gaussian = weighting == NormalWeighting::Gaussian and sigma > 0;
+    std::vector<cv::Vec3d> smoothed(numPts);
+    ParallelChunks(numPts, numThreads, [&](auto begin, auto end) {
+        // Reuse the neighborhood buffer for every vertex in the chunk
+        std::vector<std::size_t> neighborhood;
+        for (auto i = begin; i < end; ++i) {
+            // Start with the current normal. The neighborhood includes the
+            // current vertex as well.
+            auto neighborAvg = normals[i];
+            double neighborCount{1};
 
-        // Sum the normals of the neighbors
-        for (auto nb : neighborhood) {
-            ITKPixel neighborNormal;
-            input->GetPointData(nb, &neighborNormal);
+            // Sum the normals of the neighbors. Sorting keeps the sum
+            // independent of the tree layout.
+            tree.radiusSearch(points[i], radius, neighborhood);
+            std::sort(neighborhood.begin(), neighborhood.end());
+            for (const auto nb : neighborhood) {
+                double w{1};
+                if (gaussian) {
+                    const auto d = points[nb] - points[i];
+                    w = std::exp(-d.dot(d) / (2 * sigma * sigma));
+                }
+                neighborAvg += w * normals[nb];
+                neighborCount += w;
+            }
 
-            neighborAvg[0] += neighborNormal[0];
-            neighborAvg[1] += neighborNormal[1];
-            neighborAvg[2] += neighborNormal[2];
-            ++neighborCount;
+            // Average the sum normal
+            smoothed[i] = neighborAvg / neighborCount;
         }
+    });
 
-        // Average the sum normal
-        currentNormal[0] = neighborAvg[0] / neighborCount;
-        currentNormal[1] = neighborAvg[1] / neighborCount;
-        currentNormal[2] = neighborAvg[2] / neighborCount;
-        outputMesh->SetPointData(point.Index(), currentNormal);
+    auto pointData = ITKMesh::PointDataContainer::New();
+    pointData->Reserve(numPts);
+    for (std::size_t i = 0; i < numPts; ++i) {
+        pointData->SetElement(i, ITKPixel(smoothed[i].val));
     }
+    outputMesh->SetPointData(pointData);
 
     return outputMesh;
 }
@@ -1,5 +1,6 @@
 #include <gtest/gtest.h>
 
+#include "vc/core/shapes/Arch.hpp"
 #include "vc/core/shapes/Plane.hpp"
 #include "vc/meshing/CalculateNormals.hpp"
 
@@ -30,3 +31,37 @@ TEST_F(PlaneFixture, ComputePlaneNormalsTest)
         EXPECT_DOUBLE_EQ(outNormal[2], inNormal[2]);
     }
 }
+
+TEST_F(PlaneFixture, InPlace)
+{
+    volcart::meshing::CalculateNormals calcNorm(inMesh);
+    calcNorm.setInPlace(true);
+    outMesh = calcNorm.compute();
+    EXPECT_EQ(outMesh, inMesh);
+    EXPECT_EQ(outMesh->GetPointData()->Size(), inMesh->GetNumberOfPoints());
+}
+
+TEST(CalculateNormals, ThreadCountInvariant)
+{
+    // Large enough to use the parallel path
+    auto mesh = volcart::shapes::Arch(100, 100).itkMesh();
+
+    volcart::meshing::CalculateNormals serial(mesh);
+    serial.setNumThreads(1);
+    auto expected = serial.compute();
+
+    volcart::meshing::CalculateNormals parallel(mesh);
+    parallel.setNumThreads(4);
+    auto result = parallel.compute();
+
+    ASSERT_EQ(result->GetNumberOfPoints(), expected->GetNumberOfPoints());
+    for (auto p = expected->GetPoints()->Begin();
+         p != expected->GetPoints()->End(); ++p) {
+        volcart::ITKPixel n0, n1;
+        expected->GetPointData(p.Index(), &n0);
+        result->GetPointData(p.Index(), &n1);
+        EXPECT_EQ(n1[0], n0[0]);
+        EXPECT_EQ(n1[1], n0[1]);
+        EXPECT_EQ(n1[2], n0[2]);
+    }
+}
@@ -861,6 +861,50 @@ TEST_F(
     }
 }
 
+/* SHARED BUFFER TESTS */
+TEST(ITK2VTK, SharedBuffers)
+{
+    auto itkMesh = volcart::shapes::Arch().itkMesh();
+    auto copied = volcart::meshing::ITK2VTK(itkMesh);
+    auto shared = volcart::meshing::ITK2VTK(itkMesh, true);
+
+    // The shared arrays point at the ITK containers
+    const auto& points = itkMesh->GetPoints()->CastToSTLConstContainer();
+    const auto& normals = itkMesh->GetPointData()->CastToSTLConstContainer();
+    EXPECT_EQ(
+        shared->GetPoints()->GetData()->GetVoidPointer(0),
+        points.data()->GetDataPointer());
+    EXPECT_EQ(
+        shared->GetPointData()->GetNormals()->GetVoidPointer(0),
+        normals.data()->GetDataPointer());
+    EXPECT_NE(
+        copied->GetPoints()->GetData()->GetVoidPointer(0),
+        points.data()->GetDataPointer());
+
+    // Both conversions have the same contents
+    ASSERT_EQ(shared->GetNumberOfPoints(), copied->GetNumberOfPoints());
+    ASSERT_EQ(shared->GetNumberOfCells(), copied->GetNumberOfCells());
+    for (vtkIdType i = 0; i < shared->GetNumberOfPoints(); i++) {
+        std::array<double, 3> p0{};
+        std::array<double, 3> p1{};
+        copied->GetPoint(i, p0.data());
+        shared->GetPoint(i, p1.data());
+        EXPECT_EQ(p1, p0);
+        copied->GetPointData()->GetNormals()->GetTuple(i, p0.data());
+        shared->GetPointData()->GetNormals()->GetTuple(i, p1.data());
+        EXPECT_EQ(p1, p0);
+    }
+
+    // Round trip back to ITK
+    auto result = volcart::meshing::VTK2ITK(shared);
+    ASSERT_EQ(result->GetNumberOfPoints(), itkMesh->GetNumberOfPoints());
+    ASSERT_EQ(result->GetNumberOfCells(), itkMesh->GetNumberOfCells());
+    for (auto pt = itkMesh->GetPoints()->Begin();
+         pt != itkMesh->GetPoints()->End(); ++pt) {
+        EXPECT_EQ(result->GetPoint(pt.Index()), pt.Value());
+    }
+}
+
 /* EDGE CASE TESTS */
 // Test whether things fail if the meshes don't have normals
 TEST_F(NoNormalsFixture, MeshWithNoNormals)
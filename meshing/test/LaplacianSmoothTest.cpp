@@ -0,0 +1,83 @@
+#include <gtest/gtest.h>
+
+#include "vc/core/shapes/Arch.hpp"
+#include "vc/core/shapes/Plane.hpp"
+#include "vc/meshing/LaplacianSmooth.hpp"
+
+using namespace volcart;
+using namespace volcart::meshing;
+
+TEST(LaplacianSmooth, PlaneStaysPlanar)
+{
+    auto input = shapes::Plane(10, 10).itkMesh();
+    LaplacianSmooth smoother;
+    smoother.setInputMesh(input);
+    smoother.setRelaxationFactor(0.5);
+    auto output = smoother.compute();
+
+    ASSERT_EQ(output->GetNumberOfPoints(), input->GetNumberOfPoints());
+    ASSERT_EQ(output->GetNumberOfCells(), input->GetNumberOfCells());
+    for (auto pt = output->GetPoints()->Begin();
+         pt != output->GetPoints()->End(); ++pt) {
+        EXPECT_DOUBLE_EQ(pt.Value()[1], 0);
+        ITKPixel n;
+        ASSERT_TRUE(output->GetPointData(pt.Index(), &n));
+        EXPECT_NEAR(std::abs(n[1]), 1, 1e-9);
+    }
+
+    // Corners are fixed
+    for (auto id : {0, 9, 90, 99}) {
+        auto p0 = input->GetPoint(id);
+        auto p1 = output->GetPoint(id);
+        for (int i = 0; i < 3; i++) {
+            EXPECT_DOUBLE_EQ(p1[i], p0[i]);
+        }
+    }
+}
+
+TEST(LaplacianSmooth, FixedBoundary)
+{
+    const int width = 20;
+    const int height = 10;
+    auto input = shapes::Arch(width, height).itkMesh();
+    LaplacianSmooth smoother;
+    smoother.setInputMesh(input);
+    smoother.setRelaxationFactor(0.5);
+    smoother.setBoundarySmoothing(false);
+    auto output = smoother.compute();
+
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            auto boundary =
+                x == 0 or y == 0 or x == width - 1 or y == height - 1;
+            auto id = y * width + x;
+            auto p0 = input->GetPoint(id);
+            auto p1 = output->GetPoint(id);
+            if (boundary) {
+                EXPECT_EQ(p1, p0);
+            } else {
+                // Interior vertices are pulled inside the arch
+                EXPECT_LT(p1[0] * p1[0] + p1[1] * p1[1], 25);
+            }
+        }
+    }
+}
+
+TEST(LaplacianSmooth, ThreadCountInvariant)
+{
+    auto input = shapes::Arch(100, 100).itkMesh();
+    LaplacianSmooth smoother;
+    smoother.setInputMesh(input);
+    smoother.setFeatureEdgeSmoothing(true);
+
+    smoother.setNumThreads(1);
+    auto expected = smoother.compute();
+    smoother.setNumThreads(4);
+    auto result = smoother.compute();
+
+    ASSERT_EQ(result->GetNumberOfPoints(), expected->GetNumberOfPoints());
+    for (auto pt = expected->GetPoints()->Begin();
+         pt != expected->GetPoints()->End(); ++pt) {
+        EXPECT_EQ(result->GetPoint(pt.Index()), pt.Value());
+    }
+}
@@ -0,0 +1,117 @@
+#include <algorithm>
+
+#include <gtest/gtest.h>
+
+#include "vc/core/shapes/Cube.hpp"
+#include "vc/core/shapes/Sphere.hpp"
+#include "vc/core/types/FlatMesh.hpp"
+#include "vc/meshing/MeshSliceSweep.hpp"
+
+using namespace volcart;
+using namespace volcart::meshing;
+
+namespace
+{
+// Intersect every triangle of a mesh with the plane at z
+auto BruteForce(const FlatMesh& mesh, double z)
+    -> std::vector<MeshSliceSweep::Segment>
+{
+    std::vector<MeshSliceSweep::Segment> segments;
+    const auto& vs = mesh.vertices();
+    MeshSliceSweep::Segment s;
+    for (const auto& f : mesh.faces()) {
+        MeshSliceSweep::Triangle t{vs[f[0]], vs[f[1]], vs[f[2]]};
+        if (MeshSliceSweep::IntersectTriangle(t, z, s)) {
+            segments.push_back(s);
+        }
+    }
+    return segments;
+}
+
+// Order-independent comparison of two sets of segments
+void ExpectSameSegments(
+    std::vector<MeshSliceSweep::Segment> a,
+    std::vector<MeshSliceSweep::Segment> b)
+{
+    auto less = [](const auto& l, const auto& r) {
+        return std::lexicographical_compare(
+            l[0].val, l[0].val + 2, r[0].val, r[0].val + 2);
+    };
+    std::sort(a.begin(), a.end(), less);
+    std::sort(b.begin(), b.end(), less);
+    ASSERT_EQ(a.size(), b.size());
+    for (std::size_t i = 0; i < a.size(); i++) {
+        for (int e = 0; e < 2; e++) {
+            EXPECT_DOUBLE_EQ(a[i][e][0], b[i][e][0]);
+            EXPECT_DOUBLE_EQ(a[i][e][1], b[i][e][1]);
+        }
+    }
+}
+}  // namespace
+
+TEST(MeshSliceSweep, IntersectTriangle)
+{
+    MeshSliceSweep::Triangle t{
+        cv::Vec3d{0, 0, 0}, cv::Vec3d{4, 0, 2}, cv::Vec3d{0, 4, 2}};
+    MeshSliceSweep::Segment s;
+
+    // Crosses the plane
+    EXPECT_TRUE(MeshSliceSweep::IntersectTriangle(t, 1, s));
+    EXPECT_DOUBLE_EQ(s[0][0], 2);
+    EXPECT_DOUBLE_EQ(s[0][1], 0);
+    EXPECT_DOUBLE_EQ(s[1][0], 0);
+    EXPECT_DOUBLE_EQ(s[1][1], 2);
+
+    // Above and below the triangle
+    EXPECT_FALSE(MeshSliceSweep::IntersectTriangle(t, -1, s));
+    EXPECT_FALSE(MeshSliceSweep::IntersectTriangle(t, 3, s));
+
+    // Vertices on the plane count as above it
+    EXPECT_FALSE(MeshSliceSweep::IntersectTriangle(t, 0, s));
+    EXPECT_TRUE(MeshSliceSweep::IntersectTriangle(t, 2, s));
+}
+
+TEST(MeshSliceSweep, EmptySweep)
+{
+    MeshSliceSweep sweep;
+    EXPECT_EQ(sweep.numTriangles(), 0);
+    EXPECT_TRUE(sweep.intersect(0).empty());
+    EXPECT_EQ(sweep.numActive(), 0);
+}
+
+TEST(MeshSliceSweep, MatchesBruteForce)
+{
+    auto mesh = ToFlatMesh(shapes::Sphere(10, 3).itkMesh());
+    MeshSliceSweep sweep(mesh);
+    EXPECT_EQ(sweep.numTriangles(), mesh.numFaces());
+
+    // Upward sweep
+    for (auto z = sweep.zMin() - 1; z <= sweep.zMax() + 1; z += 0.5) {
+        ExpectSameSegments(sweep.intersect(z), BruteForce(mesh, z));
+        EXPECT_LE(sweep.numActive(), mesh.numFaces());
+    }
+    EXPECT_EQ(sweep.numActive(), 0);
+
+    // Moving the plane down restarts the sweep
+    for (auto z = sweep.zMax() + 1; z >= sweep.zMin() - 1; z -= 0.5) {
+        ExpectSameSegments(sweep.intersect(z), BruteForce(mesh, z));
+    }
+}
+
+TEST(MeshSliceSweep, CopiesAreIndependent)
+{
+    auto mesh = ToFlatMesh(shapes::Cube(5).itkMesh());
+    MeshSliceSweep a(mesh);
+    EXPECT_EQ(a.zMin(), 0);
+    EXPECT_EQ(a.zMax(), 5);
+
+    // Each of the four sides has two crossing triangles
+    EXPECT_EQ(a.intersect(2.5).size(), 8);
+    auto b = a;
+    b.reset();
+    EXPECT_EQ(b.numActive(), 0);
+    EXPECT_EQ(a.intersect(4).size(), 8);
+    EXPECT_EQ(b.intersect(1).size(), 8);
+    EXPECT_EQ(a.intersect(6).size(), 0);
+    EXPECT_EQ(b.intersect(2).size(), 8);
+}
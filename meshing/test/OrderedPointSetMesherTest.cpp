@@ -1,8 +1,13 @@
 #include <gtest/gtest.h>
 
+#include <fstream>
+#include <iterator>
+
 #include <opencv2/core.hpp>
 
 #include "vc/core/io/OBJWriter.hpp"
+#include "vc/core/io/PLYWriter.hpp"
+#include "vc/core/shapes/Arch.hpp"
 #include "vc/core/types/OrderedPointSet.hpp"
 #include "vc/core/types/SimpleMesh.hpp"
 #include "vc/meshing/OrderedPointSetMesher.hpp"
@@ -173,4 +178,59 @@ TEST_F(OrderedArchFixture, MeshedArchTest)
         EXPECT_EQ(current_C->GetPointIds()[1], _SavedCells[cell_id].v2);
         EXPECT_EQ(current_C->GetPointIds()[2], _SavedCells[cell_id].v3);
     }
-}
\ No newline at end of file
+}
+
+TEST(OrderedPointSetMesher, FlatMeshMatchesITKMesh)
+{
+    auto points = shapes::Arch(20, 30).orderedPoints();
+    volcart::meshing::OrderedPointSetMesher mesher(points);
+    auto itkMesh = mesher.compute();
+    auto flat = mesher.computeFlatMesh();
+
+    ASSERT_EQ(flat.numVertices(), itkMesh->GetNumberOfPoints());
+    ASSERT_EQ(flat.numFaces(), itkMesh->GetNumberOfCells());
+    ASSERT_TRUE(flat.hasNormals());
+    for (std::size_t i = 0; i < flat.numVertices(); i++) {
+        auto p = itkMesh->GetPoint(i);
+        ITKPixel n;
+        itkMesh->GetPointData(i, &n);
+        for (int d = 0; d < 3; d++) {
+            EXPECT_DOUBLE_EQ(flat.vertices()[i][d], p[d]);
+            EXPECT_NEAR(flat.normals()[i][d], n[d], 1e-12);
+        }
+    }
+    for (std::size_t i = 0; i < flat.numFaces(); i++) {
+        ITKCell::CellAutoPointer cell;
+        itkMesh->GetCell(i, cell);
+        for (unsigned v = 0; v < 3; v++) {
+            EXPECT_EQ(flat.faces()[i][v], cell->GetPointIds()[v]);
+        }
+    }
+}
+
+TEST(OrderedPointSetMesher, StreamedPLYMatchesPLYWriter)
+{
+    auto readFile = [](const filesystem::path& path) {
+        std::ifstream file(path.string(), std::ios::binary);
+        return std::string(
+            std::istreambuf_iterator<char>(file),
+            std::istreambuf_iterator<char>());
+    };
+
+    auto points = shapes::Arch(20, 30).orderedPoints();
+    volcart::meshing::OrderedPointSetMesher mesher(points);
+
+    io::PLYWriter writer;
+    writer.setPath("OrderedPointSetMesher_Expected.ply");
+    writer.setMesh(mesher.compute());
+    writer.setFormat(io::PLYWriter::Format::BinaryLittleEndian);
+    writer.setPrecision(io::PLYWriter::Precision::Float32);
+    writer.write();
+
+    // Use a chunk size that doesn't divide the number of rows
+    mesher.writePLY("OrderedPointSetMesher_Streamed.ply", 7);
+
+    EXPECT_EQ(
+        readFile("OrderedPointSetMesher_Streamed.ply"),
+        readFile("OrderedPointSetMesher_Expected.ply"));
+}
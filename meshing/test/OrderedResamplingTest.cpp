@@ -121,4 +121,47 @@ TEST_F(OrderedArchFixture, ResampledArchTest)
         EXPECT_EQ(current_C->GetPointIds()[1], _SavedCells[cell_id].v2);
         EXPECT_EQ(current_C->GetPointIds()[2], _SavedCells[cell_id].v3);
     }
-}
\ No newline at end of file
+}
+
+TEST(OrderedResampling, ThreadCountInvariant)
+{
+    volcart::shapes::Arch arch(101, 75);
+    volcart::meshing::OrderedResampling resample(
+        arch.itkMesh(), arch.orderedWidth(), arch.orderedHeight());
+    resample.setNumThreads(1);
+    resample.compute();
+    auto expected = resample.getOutputMesh();
+    resample.setNumThreads(4);
+    resample.compute();
+    auto result = resample.getOutputMesh();
+
+    ASSERT_EQ(result->GetNumberOfPoints(), expected->GetNumberOfPoints());
+    ASSERT_EQ(result->GetNumberOfCells(), expected->GetNumberOfCells());
+    for (std::size_t i = 0; i < result->GetNumberOfPoints(); i++) {
+        ITKPixel n0;
+        ITKPixel n1;
+        expected->GetPointData(i, &n0);
+        result->GetPointData(i, &n1);
+        for (int d = 0; d < 3; d++) {
+            EXPECT_EQ(result->GetPoint(i)[d], expected->GetPoint(i)[d]);
+            EXPECT_EQ(n1[d], n0[d]);
+        }
+    }
+    for (std::size_t i = 0; i < result->GetNumberOfCells(); i++) {
+        ITKCell::CellAutoPointer c0;
+        ITKCell::CellAutoPointer c1;
+        expected->GetCell(i, c0);
+        result->GetCell(i, c1);
+        for (unsigned v = 0; v < 3; v++) {
+            EXPECT_EQ(c1->GetPointIds()[v], c0->GetPointIds()[v]);
+        }
+    }
+}
+
+TEST(OrderedResampling, MismatchedDimensions)
+{
+    volcart::shapes::Plane plane(10, 10);
+    volcart::meshing::OrderedResampling resample(
+        plane.itkMesh(), plane.orderedWidth() + 1, plane.orderedHeight());
+    EXPECT_THROW(resample.compute(), std::out_of_range);
+}
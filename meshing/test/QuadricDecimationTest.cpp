@@ -0,0 +1,143 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <utility>
+
+#include "vc/core/shapes/Arch.hpp"
+#include "vc/core/shapes/Plane.hpp"
+#include "vc/core/types/FlatMesh.hpp"
+#include "vc/meshing/QuadricDecimation.hpp"
+
+using namespace volcart;
+using namespace volcart::meshing;
+
+namespace
+{
+// Number of faces using each edge
+auto EdgeUses(const FlatMesh& mesh)
+    -> std::map<std::pair<FlatMesh::Index, FlatMesh::Index>, int>
+{
+    std::map<std::pair<FlatMesh::Index, FlatMesh::Index>, int> uses;
+    for (const auto& f : mesh.faces()) {
+        for (std::size_t j = 0; j < 3; j++) {
+            auto a = f[j];
+            auto b = f[(j + 1) % 3];
+            uses[{std::min(a, b), std::max(a, b)}]++;
+        }
+    }
+    return uses;
+}
+
+// Grid in the XY plane with UVs proportional to XY
+auto UVGrid(int width, int height) -> FlatMesh
+{
+    FlatMesh mesh;
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            mesh.addVertex({double(x), double(y), 0});
+            mesh.uvs().emplace_back(
+                x / (width - 1.0), y / (height - 1.0));
+        }
+    }
+    for (int y = 0; y < height - 1; y++) {
+        for (int x = 0; x < width - 1; x++) {
+            auto i = static_cast<FlatMesh::Index>(y * width + x);
+            auto w = static_cast<FlatMesh::Index>(width);
+            mesh.addFace(i, i + 1, i + w);
+            mesh.addFace(i + 1, i + w + 1, i + w);
+        }
+    }
+    return mesh;
+}
+}  // namespace
+
+TEST(QuadricDecimation, PlaneKeepsBoundary)
+{
+    const int size = 20;
+    auto input = shapes::Plane(size, size).itkMesh();
+    QuadricDecimation decimator;
+    decimator.setInputMesh(input);
+    decimator.setTargetVertices(150);
+    auto output = decimator.compute();
+
+    EXPECT_EQ(output->GetNumberOfPoints(), 150U);
+    for (auto pt = output->GetPoints()->Begin();
+         pt != output->GetPoints()->End(); ++pt) {
+        EXPECT_NEAR(pt.Value()[1], 0, 1e-9);
+    }
+
+    // Every boundary vertex is kept in place
+    std::size_t found{0};
+    for (int y = 0; y < size; y++) {
+        for (int x = 0; x < size; x++) {
+            if (x > 0 and y > 0 and x < size - 1 and y < size - 1) {
+                continue;
+            }
+            auto p0 = input->GetPoint(y * size + x);
+            for (auto pt = output->GetPoints()->Begin();
+                 pt != output->GetPoints()->End(); ++pt) {
+                if (pt.Value().EuclideanDistanceTo(p0) < 1e-9) {
+                    found++;
+                    break;
+                }
+            }
+        }
+    }
+    EXPECT_EQ(found, 4U * (size - 1));
+
+    // Output is manifold with the same number of boundary edges
+    const auto& flat = decimator.getOutputFlatMesh();
+    std::size_t boundary{0};
+    for (const auto& [edge, uses] : EdgeUses(flat)) {
+        EXPECT_LE(uses, 2);
+        boundary += uses == 1 ? 1 : 0;
+    }
+    EXPECT_EQ(boundary, 4U * (size - 1));
+}
+
+TEST(QuadricDecimation, ArchHasNormals)
+{
+    auto input = shapes::Arch(40, 20).itkMesh();
+    QuadricDecimation decimator;
+    decimator.setInputMesh(input);
+    decimator.setTargetVertices(400);
+    auto output = decimator.compute();
+
+    EXPECT_LE(output->GetNumberOfPoints(), 400U);
+    EXPECT_LT(output->GetNumberOfCells(), input->GetNumberOfCells());
+    ASSERT_EQ(
+        output->GetPointData()->Size(), output->GetNumberOfPoints());
+    for (const auto& [edge, uses] : EdgeUses(decimator.getOutputFlatMesh())) {
+        EXPECT_LE(uses, 2);
+    }
+}
+
+TEST(QuadricDecimation, InterpolatesUVs)
+{
+    QuadricDecimation decimator;
+    decimator.setInputMesh(UVGrid(30, 20));
+    decimator.setTargetVertices(200);
+    decimator.compute();
+
+    const auto& output = decimator.getOutputFlatMesh();
+    EXPECT_EQ(output.numVertices(), 200U);
+    ASSERT_TRUE(output.hasUVs());
+    for (std::size_t i = 0; i < output.numVertices(); i++) {
+        const auto& p = output.vertices()[i];
+        const auto& uv = output.uvs()[i];
+        EXPECT_NEAR(uv[0] * 29, p[0], 1e-6);
+        EXPECT_NEAR(uv[1] * 19, p[1], 1e-6);
+    }
+}
+
+TEST(QuadricDecimation, DefaultTargetKeepsMesh)
+{
+    auto input = shapes::Plane(10, 10).itkMesh();
+    QuadricDecimation decimator;
+    decimator.setInputMesh(input);
+    auto output = decimator.compute();
+    EXPECT_EQ(output->GetNumberOfPoints(), input->GetNumberOfPoints());
+    EXPECT_EQ(output->GetNumberOfCells(), input->GetNumberOfCells());
+}
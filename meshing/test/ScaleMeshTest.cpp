@@ -793,4 +793,43 @@ TEST_F(ScaledConeFixture, CompareSavedAndFixtureScaledConeMesh)
         ++_out_ConeMeshUsedForRegressionTestCell;
         ++c;
     }
-}
\ No newline at end of file
+}
+
+TEST_F(ScaledSphereFixture, InPlaceMatchesCopy)
+{
+    auto expected = volcart::meshing::ScaleMesh(_in_SphereMesh, _ScaleFactor);
+
+    auto mesh = _Sphere.itkMesh();
+    volcart::meshing::ScaleMeshInPlace(mesh, _ScaleFactor);
+
+    EXPECT_EQ(mesh->GetNumberOfPoints(), expected->GetNumberOfPoints());
+    EXPECT_EQ(mesh->GetNumberOfCells(), expected->GetNumberOfCells());
+    for (size_t point = 0; point < mesh->GetNumberOfPoints(); ++point) {
+        EXPECT_EQ(mesh->GetPoint(point), expected->GetPoint(point));
+    }
+}
+
+TEST_F(ScaledSphereFixture, CopyIsIndependentOfInput)
+{
+    auto scaled = volcart::meshing::ScaleMesh(_in_SphereMesh, _ScaleFactor);
+    EXPECT_EQ(scaled->GetNumberOfCells(), _in_SphereMesh->GetNumberOfCells());
+
+    // Changing the copy does not change the input
+    volcart::meshing::ScaleMeshInPlace(scaled, 2);
+    auto original = _Sphere.itkMesh();
+    for (size_t point = 0; point < original->GetNumberOfPoints(); ++point) {
+        EXPECT_EQ(_in_SphereMesh->GetPoint(point), original->GetPoint(point));
+    }
+
+    // Copied cells are separate objects with the same vertices
+    auto inCell = _in_SphereMesh->GetCells()->Begin();
+    auto outCell = scaled->GetCells()->Begin();
+    for (; inCell != _in_SphereMesh->GetCells()->End(); ++inCell, ++outCell) {
+        EXPECT_NE(inCell.Value(), outCell.Value());
+        for (unsigned i = 0; i < 3; ++i) {
+            EXPECT_EQ(
+                inCell.Value()->GetPointIds()[i],
+                outCell.Value()->GetPointIds()[i]);
+        }
+    }
+}
@@ -552,4 +552,43 @@ TEST_F(SmoothNormalsFixture, SmoothWithZeroRadiusTest)
         ++in_ArchCell;
         ++ZeroRadiusSmoothedCell;
     }
-}
\ No newline at end of file
+}
+
+TEST(SmoothNormals, ThreadCountInvariant)
+{
+    auto mesh = volcart::shapes::Arch(50, 50).itkMesh();
+    auto expected = volcart::meshing::SmoothNormals(
+        mesh, 3, volcart::meshing::NormalWeighting::Uniform, 1);
+    auto result = volcart::meshing::SmoothNormals(
+        mesh, 3, volcart::meshing::NormalWeighting::Uniform, 4);
+    for (auto pt = mesh->GetPoints()->Begin(); pt != mesh->GetPoints()->End();
+         ++pt) {
+        ITKPixel n0, n1;
+        expected->GetPointData(pt.Index(), &n0);
+        result->GetPointData(pt.Index(), &n1);
+        EXPECT_EQ(n1, n0);
+    }
+}
+
+TEST(SmoothNormals, GaussianWeighting)
+{
+    // Down-weighting distant neighbors keeps normals closer to the input
+    auto mesh = volcart::shapes::Arch(20, 20).itkMesh();
+    auto uniform = volcart::meshing::SmoothNormals(mesh, 5);
+    auto gaussian = volcart::meshing::SmoothNormals(
+        mesh, 5, volcart::meshing::NormalWeighting::Gaussian);
+
+    double uniformDiff{0};
+    double gaussianDiff{0};
+    for (auto pt = mesh->GetPoints()->Begin(); pt != mesh->GetPoints()->End();
+         ++pt) {
+        ITKPixel n, u, g;
+        mesh->GetPointData(pt.Index(), &n);
+        uniform->GetPointData(pt.Index(), &u);
+        gaussian->GetPointData(pt.Index(), &g);
+        uniformDiff += (u - n).GetNorm();
+        gaussianDiff += (g - n).GetNorm();
+    }
+    EXPECT_GT(uniformDiff, 0);
+    EXPECT_LT(gaussianDiff, uniformDiff);
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+/** @file */
+
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <opencv2/core.hpp>
+#include <pybind11/numpy.h>
+
+namespace volcart
+{
+namespace python
+{
+
+/**
+ * @brief Wrap a cv::Mat in a read-only NumPy array without copying
+ *
+ * The returned array shares memory with `m` and keeps it alive for as long
+ * as the array exists. Because the memory may be shared with other objects,
+ * such as a Volume's slice cache, the array is not writeable. Only
+ * single-channel images are supported.
+ */
+inline pybind11::array MatView(const cv::Mat& m)
+{
+    namespace py = pybind11;
+
+    py::dtype dtype;
+    switch (m.depth()) {
+        case CV_8U:
+            dtype = py::dtype::of<uint8_t>();
+            break;
+        case CV_8S:
+            dtype = py::dtype::of<int8_t>();
+            break;
+        case CV_16U:
+            dtype = py::dtype::of<uint16_t>();
+            break;
+        case CV_16S:
+            dtype = py::dtype::of<int16_t>();
+            break;
+        case CV_32S:
+            dtype = py::dtype::of<int32_t>();
+            break;
+        case CV_32F:
+            dtype = py::dtype::of<float>();
+            break;
+        case CV_64F:
+            dtype = py::dtype::of<double>();
+            break;
+        default:
+            throw std::runtime_error("unsupported image type");
+    }
+    if (m.dims != 2 or m.channels() != 1) {
+        throw std::runtime_error("unsupported number of dims");
+    }
+
+    // The capsule owns a reference to the Mat's data
+    auto* owner = new cv::Mat(m);
+    py::capsule base(
+        owner, [](void* p) { delete reinterpret_cast<cv::Mat*>(p); });
+    std::vector<ssize_t> shape{m.rows, m.cols};
+    std::vector<ssize_t> strides{
+        static_cast<ssize_t>(m.step[0]), static_cast<ssize_t>(m.step[1])};
+    py::array a(dtype, shape, strides, owner->data, base);
+    a.attr("setflags")(py::arg("write") = false);
+    return a;
+}
+
+/**
+ * @brief Move a contiguous container into a NumPy array without copying
+ *
+ * The array takes ownership of `c`, which is interpreted as a C-contiguous
+ * array of the given shape.
+ *
+ * @tparam T Element type
+ * @tparam Container Type with a `data()` member returning `T*`
+ */
+template <typename T, typename Container>
+pybind11::array_t<T> MoveToArray(Container&& c, std::vector<ssize_t> shape)
+{
+    namespace py = pybind11;
+    auto* owner = new std::decay_t<Container>(std::forward<Container>(c));
+    py::capsule base(owner, [](void* p) {
+        delete reinterpret_cast<std::decay_t<Container>*>(p);
+    });
+    return py::array_t<T>(std::move(shape), owner->data(), base);
+}
+
+}  // namespace python
+}  // namespace volcart
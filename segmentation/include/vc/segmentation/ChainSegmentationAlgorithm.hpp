@@ -2,10 +2,13 @@
 
 /** @file */
 
+#include <atomic>
+
 #include "vc/core/types/BoundingBox.hpp"
 #include "vc/core/types/Mixins.hpp"
 #include "vc/core/types/OrderedPointSet.hpp"
 #include "vc/core/types/Volume.hpp"
+#include "vc/core/util/Signals.hpp"
 
 namespace volcart::segmentation
 {
@@ -31,7 +34,7 @@ public:
     /** Bounding Box type */
     using Bounds = volcart::BoundingBox<double, 3>;
     /** Computation result status */
-    enum class Status { Success, Failure, ReturnedEarly };
+    enum class Status { Success, Failure, ReturnedEarly, Cancelled };
 
     /**@{*/
     /** @brief Set the input Volume */
@@ -75,6 +78,19 @@ public:
 
     /** @brief Get the status of the previous computation */
     auto getStatus() const -> Status { return status_; }
+
+    /**
+     * @brief Request that compute() stop early
+     *
+     * May be called from any thread while compute() is running. The
+     * computation stops before its next propagation step and returns the
+     * rows computed so far with Status::Cancelled. The request is not
+     * cleared, so a cancelled algorithm cannot be computed again.
+     */
+    void cancel() { cancelled_ = true; }
+
+    /** @brief Whether cancel() has been called */
+    auto cancelRequested() const -> bool { return cancelled_; }
     /**@}*/
 
     /**@{*/
@@ -91,6 +107,14 @@ public:
     /** @brief Returns the maximum progress value */
     auto progressIterations() const -> size_t override { return numSteps_; }
 
+    /**
+     * @brief Emitted with each row of the result as soon as it is computed
+     *
+     * Rows are emitted in order, starting with the seed chain, so a
+     * connected AsyncPointSetWriter can checkpoint a long computation.
+     */
+    Signal<Chain> chainUpdated;
+
 protected:
     /** Default constructor */
     ChainSegmentationAlgorithm() = default;
@@ -108,5 +132,7 @@ protected:
     PointSet result_;
     /** Computation status */
     Status status_{Status::Success};
+    /** Cancellation flag */
+    std::atomic<bool> cancelled_{false};
 };
 }  // namespace volcart::segmentation
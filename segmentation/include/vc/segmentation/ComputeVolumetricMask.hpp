@@ -2,7 +2,9 @@
 
 /** @file */
 
+#include <cstddef>
 #include <limits>
+#include <vector>
 
 #include "vc/core/types/Mixins.hpp"
 #include "vc/core/types/PointSet.hpp"
@@ -19,6 +21,15 @@ namespace volcart::segmentation
  * compute a per-voxel mask for a segmented layer in a volume. For each slice
  * in the Z-range of the input PointSet, the points which intersect that slice
  * are used as the seeds for running the flood fill algorithm.
+ *
+ * Slices are independent of one another and are computed in parallel on the
+ * global ThreadPool. Each slice is masked into its own VolumetricMask, and
+ * these are merged into the output mask in slice order.
+ *
+ * If the volume has block statistics (see Volume::blockStatistics()), a
+ * slice is skipped without being read when none of its seeds lie in a block
+ * which can contain the threshold range, since the flood fill cannot start
+ * from any of them.
  */
 class ComputeVolumetricMask : public IterationsProgress
 {
@@ -60,6 +71,17 @@ public:
      */
     void setMaxRadius(size_t radius);
 
+    /**
+     * @brief Set the maximum number of slices computed concurrently
+     *
+     * If `n == 1`, slices are computed serially. If `n == 0` (default), uses
+     * the number of threads in the global ThreadPool.
+     */
+    void setNumThreads(std::size_t n);
+
+    /** @brief Get the maximum number of slices computed concurrently */
+    std::size_t numThreads() const;
+
     /** @brief Computes the segmentation. */
     VolumetricMask::Pointer compute();
 
@@ -86,8 +108,14 @@ private:
     bool measureVertically_{false};
     /** Maximum layer thickness to consider for a single seed point */
     size_t maxRadius_{std::numeric_limits<size_t>::max()};
+    /** Maximum number of concurrent slices */
+    std::size_t numThreads_{0};
     /** Mask */
     VolumetricMask::Pointer mask_;
+
+    /** Compute the mask for a single slice */
+    VolumetricMask::Pointer compute_slice_(
+        size_t zIndex, const std::vector<cv::Vec3i>& seeds) const;
 };
 
 }  // namespace volcart::segmentation
\ No newline at end of file
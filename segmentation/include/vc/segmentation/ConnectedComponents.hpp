@@ -0,0 +1,136 @@
+#pragma once
+
+/** @file */
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "vc/core/types/Mixins.hpp"
+#include "vc/core/types/Volume.hpp"
+#include "vc/core/types/VolumetricMask.hpp"
+
+namespace volcart::segmentation
+{
+
+/**
+ * @brief Label the 3D connected components of a whole volume
+ *
+ * Voxels with intensities in the range `[low, high]` are foreground, the same
+ * thresholds used by DoFloodFill(). Foreground voxels are grouped into
+ * components which are 6-connected (face neighbors) or 26-connected (face,
+ * edge, and corner neighbors), and the voxels of every component with at
+ * least minComponentSize() voxels are written to a VolumetricMask.
+ *
+ * The volume is processed in slabs of slabSize() slices, which are labeled in
+ * parallel on the global ThreadPool. Each slice of a slab is labeled as
+ * run-length encoded rows, and the 2D components of consecutive slices are
+ * merged with a union-find structure. Each slab also labels the last slice of
+ * the previous slab, so the slabs can be merged afterwards without keeping
+ * any slice labels in memory. Component sizes are only known once every slab
+ * is merged, so the slabs are labeled a second time to write the mask. Memory
+ * use is therefore bounded by the slices of the slabs in flight plus a few
+ * words per 2D component, rather than by the volume size.
+ *
+ * Components are numbered in the order of their first voxel in z, y, x
+ * order, so the result does not depend on the slab size or the number of
+ * threads.
+ */
+class ConnectedComponents3D : public IterationsProgress
+{
+public:
+    /** @brief Voxel neighborhood of a component */
+    enum class Connectivity {
+        /** 6-connected: voxels which share a face */
+        Face = 0,
+        /** 26-connected: voxels which share a face, edge, or corner */
+        Full
+    };
+
+    /** @brief Set the input Volume */
+    void setVolume(const Volume::Pointer& v);
+
+    /** @brief Set the low foreground threshold */
+    void setLowThreshold(std::uint16_t t);
+
+    /** @brief Set the high foreground threshold */
+    void setHighThreshold(std::uint16_t t);
+
+    /** @brief Set the voxel neighborhood. Default: Connectivity::Full */
+    void setConnectivity(Connectivity c);
+
+    /**
+     * @brief Set the minimum number of voxels of a component in the output
+     * mask
+     *
+     * Smaller components are counted in componentSizes(), but are not
+     * written to the mask. Default: 1
+     */
+    void setMinComponentSize(std::size_t n);
+
+    /** @copydoc setMinComponentSize() */
+    [[nodiscard]] auto minComponentSize() const -> std::size_t;
+
+    /**
+     * @brief Set the number of slices in a slab
+     *
+     * Multiples of VolumetricMask::BLOCK_SIZE keep the mask blocks of
+     * different slabs apart, which makes merging them cheaper. Default: 64
+     */
+    void setSlabSize(std::size_t n);
+
+    /** @copydoc setSlabSize() */
+    [[nodiscard]] auto slabSize() const -> std::size_t;
+
+    /**
+     * @brief Set the maximum number of slabs labeled concurrently
+     *
+     * If `n == 1`, slabs are labeled serially. If `n == 0` (default), uses
+     * the number of threads in the global ThreadPool.
+     */
+    void setNumThreads(std::size_t n);
+
+    /** @brief Get the maximum number of slabs labeled concurrently */
+    [[nodiscard]] auto numThreads() const -> std::size_t;
+
+    /** @brief Label the volume and compute the mask */
+    auto compute() -> VolumetricMask::Pointer;
+
+    /** @brief Get the mask of the last compute() */
+    [[nodiscard]] auto getMask() const -> VolumetricMask::Pointer;
+
+    /** @brief Get the number of components found by the last compute() */
+    [[nodiscard]] auto numComponents() const -> std::size_t;
+
+    /**
+     * @brief Get the number of voxels in each component found by the last
+     * compute()
+     */
+    [[nodiscard]] auto componentSizes() const
+        -> const std::vector<std::size_t>&;
+
+    /** @brief Returns the maximum progress value */
+    [[nodiscard]] auto progressIterations() const -> std::size_t override;
+
+private:
+    /** Input volume */
+    Volume::Pointer vol_;
+    /** Low foreground threshold */
+    std::uint16_t low_{14135};
+    /** High foreground threshold */
+    std::uint16_t high_{65535};
+    /** Voxel neighborhood */
+    Connectivity connectivity_{Connectivity::Full};
+    /** Minimum size of an output component */
+    std::size_t minSize_{1};
+    /** Slices per slab */
+    std::size_t slabSize_{64};
+    /** Maximum number of concurrent slabs */
+    std::size_t numThreads_{0};
+    /** Output mask */
+    VolumetricMask::Pointer mask_;
+    /** Voxels per component */
+    std::vector<std::size_t> sizes_;
+};
+
+}  // namespace volcart::segmentation
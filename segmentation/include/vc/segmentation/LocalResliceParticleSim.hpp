@@ -2,13 +2,18 @@
 
 /** @file */
 
+#include <cstddef>
 #include <iostream>
+#include <optional>
+#include <vector>
 
 #include "vc/core/types/OrderedPointSet.hpp"
+#include "vc/core/types/Reslice.hpp"
 #include "vc/core/types/VolumePkg.hpp"
 #include "vc/segmentation/ChainSegmentationAlgorithm.hpp"
 #include "vc/segmentation/lrps/Common.hpp"
 #include "vc/segmentation/lrps/FittedCurve.hpp"
+#include "vc/segmentation/lrps/IntensityMap.hpp"
 
 namespace volcart::segmentation
 {
@@ -86,6 +91,19 @@ public:
      */
     void setDelta(double d) { delta_ = d; }
 
+    /**
+     * @brief Set the fit radius of the candidate energy evaluation
+     *
+     * If `0` (default), the energy of every candidate position is evaluated
+     * by refitting a FittedCurve to the whole chain. Otherwise, only the
+     * particles within `r` positions of the moved particle are refit, which
+     * makes each evaluation independent of the length of the chain at the
+     * cost of approximating the energy. Must not be `1`.
+     *
+     * @see IncrementalEnergy
+     */
+    void setEnergyFitRadius(std::size_t r) { energyFitRadius_ = r; }
+
     /**
      * @brief Set the estimated thickness of the substrate (in um)
      *
@@ -103,6 +121,17 @@ public:
      */
     void setConsiderPrevious(bool b) { considerPrevious_ = b; }
 
+    /**
+     * @brief Set the number of worker threads
+     *
+     * Candidate positions are generated for each particle in parallel. If
+     * `n == 0` (default), uses every thread in the global ThreadPool.
+     */
+    void setNumThreads(std::size_t n) { numThreads_ = n; }
+
+    /** @brief Get the number of worker threads */
+    [[nodiscard]] auto numThreads() const -> std::size_t;
+
     /** @brief Compute the segmentation */
     auto compute() -> PointSet override;
 
@@ -121,8 +150,23 @@ private:
      * @param currentCurve Input curve
      * @param index Index of point on curve
      */
-    auto estimate_normal_at_index_(const FittedCurve& currentCurve, int index)
-        -> cv::Vec3d;
+    auto estimate_normal_at_index_(
+        const FittedCurve& currentCurve, int index) const -> cv::Vec3d;
+
+    /**
+     * @brief Generate the sorted candidate positions of every particle
+     *
+     * Particles are processed in parallel. Candidates are appended to the
+     * (empty) vectors of `nextPositions`, which are reused across
+     * iterations. If `maps` is not empty, the
+     * intensity map and reslice of each particle are stored in `maps` and
+     * `reslices`, which must have one element per particle.
+     */
+    void generate_candidates_(
+        const FittedCurve& currentCurve,
+        std::vector<std::vector<Voxel>>& nextPositions,
+        std::vector<std::optional<IntensityMap>>& maps,
+        std::vector<std::optional<Reslice>>& reslices) const;
 
     /**
      * @brief Debug: Draw curve on slice image
@@ -170,5 +214,9 @@ private:
     double materialThickness_{100};
     /** Window size for reslice */
     int resliceSize_{32};
+    /** Number of worker threads */
+    std::size_t numThreads_{0};
+    /** Fit radius of the candidate energy evaluation */
+    std::size_t energyFitRadius_{0};
 };
 }  // namespace volcart::segmentation
\ No newline at end of file
@@ -2,6 +2,7 @@
 
 /** @file */
 
+#include <memory>
 #include <optional>
 
 #include "vc/core/types/OrderedPointSet.hpp"
@@ -83,12 +84,60 @@ public:
      */
     void setMaterialThickness(double m);
 
-    /** @brief Set the maximum number of threads */
+    /**
+     * @brief Set the maximum number of threads
+     *
+     * Curve segments are computed on the shared ThreadPool. This limits the
+     * number of threads, and therefore segments, used for each slice.
+     */
     void setMaxThreads(std::uint32_t t);
 
     /** @brief Clear the maximum number of threads */
     void resetMaxThreads();
 
+    /**
+     * @brief Set the number of curve segments computed per thread
+     *
+     * Values larger than 1 (default) split the curve into more, smaller
+     * segments than there are threads, so that idle threads can pick up the
+     * remaining segments when segment costs are uneven. Because optical flow
+     * is computed over each segment's own region of interest, this can
+     * slightly change the result.
+     */
+    void setSegmentsPerThread(std::uint32_t n);
+
+    /**
+     * @brief Compute optical flow on the GPU
+     *
+     * If enabled and GPUAvailable(), the dense optical flow of each curve
+     * segment is computed with OpenCV's CUDA Farneback implementation. The
+     * slices stay resident on the device between steps, so each slice is
+     * only uploaded once. Otherwise the flow is computed on the CPU. The GPU
+     * implementation is not bit-identical to the CPU one, so results differ
+     * slightly between the two. Default: false
+     */
+    void setUseGPU(bool b);
+
+    /**
+     * @brief Whether the GPU optical flow backend was compiled and a CUDA
+     * device is available
+     *
+     * The backend is only compiled if the project is configured with
+     * `VC_WITH_OPENCV_CUDA`.
+     */
+    static auto GPUAvailable() -> bool;
+
+    /**
+     * @brief Compute the dense optical flow between two CV_8UC1 images
+     *
+     * Uses the same Farneback parameters as compute(). If `useGPU` and
+     * GPUAvailable(), the flow is computed on the GPU.
+     *
+     * @return CV_32FC2 flow from `gray1` to `gray2`
+     */
+    static auto OpticalFlow(
+        const cv::Mat& gray1, const cv::Mat& gray2, bool useGPU) -> cv::Mat;
+
     /** Debug: Shows intensity maps in GUI window */
     void setVisualize(bool b);
 
@@ -102,12 +151,50 @@ public:
     [[nodiscard]] auto progressIterations() const -> size_t override;
 
 private:
+    /** Slices resident on the GPU. Defined by the implementation. */
+    struct GPUSlices;
+    /** GPU optical flow state of a segment. Defined by the implementation. */
+    struct GPUSegment;
+
+    /**
+     * @brief Working buffers of a curve segment
+     *
+     * Each segment index keeps its buffers between iterations, so that
+     * iterations only allocate when a buffer must grow.
+     */
+    struct SegmentBuffers {
+        /** Points of the segment on z */
+        std::vector<Voxel> points;
+        /** Curve fit to points */
+        FittedCurve curve;
+        /** Storage of the normalized slice ROIs */
+        cv::Mat gray1, gray2;
+        /** Storage of the integral image of gray2 */
+        cv::Mat integral;
+        /** Storage of the optical flow from gray1 to gray2 */
+        cv::Mat flow;
+        /** Points of the segment on z + 1 */
+        std::vector<Voxel> nextVs;
+        /** GPU buffers. Only allocated when computing flow on the GPU. */
+        std::shared_ptr<GPUSegment> gpu;
+    };
+
     /**
      * @brief Compute the curve for z + 1 given a curve on z using the optical
      * flow between the two slices
+     *
+     * Fits `segment.curve` to `segment.points` and writes the curve for
+     * z + 1 to `segment.nextVs`. `slice1` and `slice2` are the slice images at
+     * z and z + 1. They are only read, so they can be shared between
+     * concurrent calls. If `gpuSlices` is not null, it holds the same slices
+     * on the GPU and the optical flow is computed there.
      */
-    auto compute_curve_(const FittedCurve& currentCurve, int zIndex)
-        -> std::vector<Voxel>;
+    void compute_curve_(
+        int zIndex,
+        const cv::Mat& slice1,
+        const cv::Mat& slice2,
+        const GPUSlices* gpuSlices,
+        SegmentBuffers& segment);
 
     /**
      * @brief Debug: Draw curve on slice image
@@ -164,6 +251,10 @@ private:
     double materialThickness_{100};
     /** Maximum number of threads */
     std::optional<std::uint32_t> maxThreads_;
+    /** Number of curve segments per thread */
+    std::uint32_t segmentsPerThread_{1};
+    /** Compute optical flow on the GPU */
+    bool useGPU_{false};
     /** Dump visualization to disk flag */
     bool dumpVis_{false};
     /** Show visualization in GUI flag */
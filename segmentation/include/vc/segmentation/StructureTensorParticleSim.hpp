@@ -2,8 +2,13 @@
 
 /** @file */
 
+#include <utility>
+#include <vector>
+
 #include <opencv2/core.hpp>
 
+#include "vc/core/math/OrientationField.hpp"
+#include "vc/core/math/StructureTensorField.hpp"
 #include "vc/segmentation/ChainSegmentationAlgorithm.hpp"
 #include "vc/segmentation/stps/Particle.hpp"
 #include "vc/segmentation/stps/ParticleChain.hpp"
@@ -48,6 +53,29 @@ public:
      * RK iterations per output step is determined by `stepSize_ / rkStepSize_`.
      */
     void setRKStepSize(double s) { rkStepSize_ = s; }
+
+    /**
+     * @brief Use a cached StructureTensorField for the propagation force
+     *
+     * When enabled (default), structure tensors are computed block-wise and
+     * interpolated at the particle positions. When disabled, every particle
+     * computes its structure tensor from scratch with
+     * ComputeSubvoxelEigenPairs().
+     */
+    void setUseTensorField(bool b) { useTensorField_ = b; }
+
+    /**
+     * @brief Use a precomputed OrientationField for the propagation force
+     *
+     * When set, the principal directions are interpolated from the field
+     * instead of being computed from the structure tensor, and
+     * setMaterialThickness() and setUseTensorField() have no effect. The
+     * field should have been computed from the segmentation volume.
+     */
+    void setOrientationField(OrientationField::Pointer f)
+    {
+        orientationField_ = std::move(f);
+    }
     /**@}*/
 
     /**@{*/
@@ -67,6 +95,12 @@ private:
     double materialThickness_{100};
     /** Radius for structure tensor calculation kernel */
     int radius_{5};
+    /** Use the cached structure tensor field */
+    bool useTensorField_{true};
+    /** Cached structure tensor field */
+    volcart::StructureTensorField::Pointer tensorField_;
+    /** Precomputed orientation field */
+    volcart::OrientationField::Pointer orientationField_;
 
     /** Most recent version of the chain */
     ParticleChain currentChain_;
@@ -77,11 +111,26 @@ private:
      */
     double rkStepSize_{0.5};
 
-    /** Calculate the propagation force direction for each point in the chain */
-    ForceChain calc_prop_forces_(ParticleChain c);
+    /** Particle positions of a batched structure tensor query */
+    std::vector<cv::Vec3d> positions_;
 
-    /** Calculate the corrective spring force for each point in the chain */
-    ForceChain calc_spring_forces_(ParticleChain c);
+    /**
+     * Calculate the normalized sum of the propagation and spring forces for
+     * each point in the chain
+     */
+    void calc_forces_(const ParticleChain& c, ForceChain& res);
+
+    /**
+     * Calculate the propagation force direction for each point in the chain.
+     * Overwrites the forces in `res`, which must be the size of the chain.
+     */
+    void calc_prop_forces_(const ParticleChain& c, ForceChain& res);
+
+    /**
+     * Calculate the corrective spring force for each point in the chain. Adds
+     * to the forces in `res`, which must be the size of the chain.
+     */
+    void calc_spring_forces_(const ParticleChain& c, ForceChain& res);
 
     /** Add the current chain to the final result point set */
     void add_chain_to_result_();
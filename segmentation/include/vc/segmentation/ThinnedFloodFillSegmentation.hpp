@@ -2,7 +2,9 @@
 
 /** @file */
 
+#include <cstddef>
 #include <limits>
+#include <vector>
 
 #include "vc/core/types/PointSet.hpp"
 #include "vc/core/types/VolumetricMask.hpp"
@@ -29,6 +31,15 @@ namespace volcart::segmentation
  * Note: This algorithm operates solely on two-dimensional slices and does not
  * use any 3D subvolumes.
  *
+ * Because the seeds for each slice come from the skeleton of the previous
+ * slice, slices are processed in order. When more than one thread is
+ * available, the work within each slice is parallelized and pipelined: the
+ * next slice is loaded in the background, page thickness is measured for the
+ * seed points in parallel, and the mask is saved while the distance transform
+ * and thinning run. Thinning and spur pruning operate directly on the mask
+ * image (see ThinMask() and PruneSpurs()), and each thinning pass is split
+ * into row bands which run in parallel.
+ *
  * Implements the thinning algorithm described in section 8.6 of
  * "Computer Vision: Principles, Algorithms, Applications, Learning" by
  * E.R. Davies \cite davies2017computervision.
@@ -95,12 +106,32 @@ public:
      */
     void setMaxRadius(size_t radius);
 
+    /**
+     * @brief Set the number of worker threads
+     *
+     * If `n == 1`, slices are processed serially on the calling thread. If
+     * `n == 0` (default), uses every thread in the global ThreadPool.
+     */
+    void setNumThreads(std::size_t n);
+
+    /** @brief Get the number of worker threads */
+    std::size_t numThreads() const;
+
     /** @brief Computes the segmentation. */
     PointSet compute() override;
 
-    /** @brief Return the full, 3D mask. */
+    /**
+     * @brief Return the full, 3D mask as a list of voxels.
+     *
+     * The mask is stored internally as a VolumetricMask, so this copies every
+     * masked voxel into a new list. Prefer getVolumetricMask() for large
+     * masks.
+     */
     VoxelMask getMask() const;
 
+    /** @brief Return the full, 3D mask. */
+    VolumetricMask::Pointer getVolumetricMask() const;
+
     /**
      * @brief Debug: Dumps visualizations of the mask and skeleton for each
      * slice to disk.
@@ -131,6 +162,12 @@ private:
     /** Maximum layer thickness to consider for a single seed point */
     size_t maxRadius_{std::numeric_limits<size_t>::max()};
     /** Mask */
-    VoxelMask volMask_;
+    VolumetricMask::Pointer volMask_{VolumetricMask::New()};
+    /** Number of worker threads */
+    std::size_t numThreads_{0};
+
+    /** Estimate the page thickness at each seed point */
+    std::vector<std::size_t> measure_thickness_(
+        const std::vector<cv::Vec3i>& seeds, const cv::Mat& slice) const;
 };
 }  // namespace volcart::segmentation
@@ -27,6 +27,8 @@ private:
     std::vector<Voxel> points_;
     /** Spline representation of curve */
     CubicSpline<double> spline_;
+    /** X and Y components of the fit points */
+    std::vector<double> xs_, ys_;
 
 public:
     /** @name Constructors */
@@ -44,6 +46,13 @@ public:
     FittedCurve(const std::vector<Voxel>& vs, int zIndex);
     /**@}*/
 
+    /**
+     * @brief Refit the curve to a new set of points and z-Index
+     *
+     * Equivalent to constructing a new curve, but reuses the curve's buffers.
+     */
+    void fit(const std::vector<Voxel>& vs, int zIndex);
+
     /** @brief Return the current number of resampled points in the spline */
     size_t size() const { return npoints_; }
 
@@ -69,6 +78,12 @@ public:
     /** @brief Resample the curve to have numPoints of evenly spaced points */
     std::vector<Voxel> sample(size_t numPoints) const;
 
+    /**
+     * @brief Resample the curve to have numPoints of evenly spaced points,
+     * writing them to a preallocated buffer
+     */
+    void sample(size_t numPoints, std::vector<Voxel>& points) const;
+
     /** @brief Returns the voxel located at index */
     Voxel operator()(int index) const;
 
@@ -0,0 +1,185 @@
+#pragma once
+
+/** @file */
+
+#include <cstddef>
+#include <set>
+#include <vector>
+
+#include "vc/segmentation/lrps/Common.hpp"
+#include "vc/segmentation/lrps/FittedCurve.hpp"
+
+namespace volcart::segmentation
+{
+/**
+ * @class IncrementalEnergy
+ * @brief Evaluates EnergyMetrics::TotalEnergy() of a particle chain as
+ * single particles are moved
+ *
+ * Evaluating the energy of a candidate position with EnergyMetrics requires
+ * fitting a FittedCurve to the whole chain and recomputing every metric over
+ * every resampled point, which makes each evaluation at least linear in the
+ * length of the chain. This class caches the resampled curve along with the
+ * per-point derivative, curvature and arc length terms of each metric.
+ *
+ * When the fit radius is non-zero, moving a particle only refits the spline
+ * through the particles within `fitRadius` of the moved particle and
+ * replaces the resampled points which fall within the inner half of that
+ * window. Only the metric terms which depend on the replaced points are
+ * recomputed. Because the spline of a FittedCurve is fit globally, this is
+ * an approximation of refitting the whole chain: the influence of a moved
+ * knot on an interpolating cubic spline decays quickly with distance, but
+ * the chord-length parameterization of particles outside of the window is
+ * not updated.
+ *
+ * When the fit radius is zero, or when the chain is too short for the
+ * window to be local, every evaluation refits the full chain and the result
+ * is identical to EnergyMetrics::TotalEnergy().
+ *
+ * @ingroup lrps
+ */
+class IncrementalEnergy
+{
+public:
+    /** Default fit radius */
+    static constexpr std::size_t DEFAULT_FIT_RADIUS{10};
+
+    /**
+     * @brief Construct from a particle chain
+     *
+     * The initial curve is always fit to the whole chain.
+     *
+     * @param vs Particle positions
+     * @param zIndex z-position of the curve
+     * @param alpha ActiveContourInternal() total weight factor
+     * @param k1 ActiveContourInternal() stretch weight factor
+     * @param k2 ActiveContourInternal() curvature weight factor
+     * @param beta AbsCurvatureSum() total weight factor
+     * @param delta WindowedArcLength() total weight factor
+     * @param fitRadius Number of neighboring particles on each side of a
+     * moved particle which are refit. If `0`, the full chain is refit.
+     * @throws std::invalid_argument if `fitRadius` is `1`
+     */
+    IncrementalEnergy(
+        std::vector<Voxel> vs,
+        int zIndex,
+        double alpha,
+        double k1,
+        double k2,
+        double beta,
+        double delta,
+        std::size_t fitRadius = DEFAULT_FIT_RADIUS);
+
+    /** @brief Get the energy of the current chain */
+    [[nodiscard]] auto energy() const -> double;
+
+    /** @brief Get the current particle positions */
+    [[nodiscard]] auto particles() const -> const std::vector<Voxel>&;
+
+    /** @brief Get the current resampled curve points */
+    [[nodiscard]] auto points() const -> const std::vector<Voxel>&;
+
+    /**
+     * @brief Get the energy of the chain if a particle were moved
+     *
+     * Does not change the chain. The move can be kept with acceptMove().
+     *
+     * @throws std::out_of_range if `index` is not a particle index
+     */
+    auto evaluateMove(std::size_t index, const Voxel& v) -> double;
+
+    /**
+     * @brief Apply the move of the last call to evaluateMove()
+     *
+     * Does nothing if the move was already accepted.
+     */
+    void acceptMove();
+
+private:
+    /** Replacement values for a range of the cached state */
+    struct Move {
+        /** Index of the moved particle */
+        std::size_t particle{0};
+        /** Position of the moved particle */
+        Voxel position;
+        /** Index of the first replaced particle parameter */
+        std::size_t firstParam{0};
+        /** Replaced particle parameters */
+        std::vector<double> params;
+        /** Index of the first replaced point */
+        std::size_t firstPoint{0};
+        /** Replaced points */
+        std::vector<Voxel> points;
+    };
+
+    /** Whether moves refit the full chain */
+    [[nodiscard]] auto exact_() const -> bool;
+    /**
+     * Compute the state for moving a particle with a local refit. Reuses the
+     * buffers of `move`.
+     */
+    void local_move_(std::size_t index, const Voxel& v, Move& move);
+    /** Swap the state of a Move with the cached state */
+    void swap_(Move& move);
+    /** Add or subtract the metric terms of a range of points */
+    void update_terms_(std::size_t first, std::size_t last, bool add);
+    /** Compute the energy from the cached sums */
+    [[nodiscard]] auto energy_from_sums_() const -> double;
+
+    /** z-position of the curve */
+    int zIndex_;
+    /** Weight factors */
+    double alpha_, k1_, k2_, beta_, delta_;
+    /** Fit radius */
+    std::size_t radius_;
+
+    /** Particle positions */
+    std::vector<Voxel> particles_;
+    /** Chord-length parameter of each particle */
+    std::vector<double> params_;
+    /** Parameter of each resampled point */
+    std::vector<double> ts_;
+    /** Resampled points */
+    std::vector<Voxel> points_;
+    /** X and Y components of points_ */
+    std::vector<double> xs_, ys_;
+
+    /** ActiveContourInternal() term of each point */
+    std::vector<double> aci_;
+    /** Absolute curvature of each point */
+    std::vector<double> curv_;
+    /** Length of the segment following each point */
+    std::vector<double> seg_;
+    /** Sorted absolute curvatures, excluding NaN */
+    std::multiset<double> sortedCurv_;
+    /** Nodes removed from sortedCurv_, reused by later insertions */
+    std::vector<std::multiset<double>::node_type> curvNodes_;
+    /** Number of NaN curvatures */
+    std::size_t nanCurv_{0};
+    /** Sum of aci_ */
+    double aciSum_{0};
+    /** Sum of curv_ */
+    double curvSum_{0};
+    /** Sum of seg_ */
+    double segSum_{0};
+
+    /** Particle positions of the last exact refit */
+    std::vector<Voxel> moved_;
+    /** Curve of the last exact refit */
+    FittedCurve exactCurve_;
+
+    /** Local refit buffers */
+    std::vector<Voxel> window_;
+    std::vector<double> windowXs_, windowYs_, windowParams_;
+    CubicSpline<double> windowSpline_;
+
+    /** Energy of the current chain */
+    double energy_{0};
+    /** Last evaluated move */
+    Move pending_;
+    /** Energy of pending_ */
+    double pendingEnergy_{0};
+    /** Whether pending_ can be accepted */
+    bool hasPending_{false};
+};
+}  // namespace volcart::segmentation
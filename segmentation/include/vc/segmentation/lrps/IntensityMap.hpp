@@ -18,7 +18,9 @@ namespace volcart::segmentation
  * matrix, normalized to the range [0, 1]
  *
  * Attempts to classify and sort maxima relative to the horizontal center of
- * the matrix.
+ * the matrix. The matrix is histogram equalized before it is normalized.
+ * 16-bit matrices are equalized directly, without an intermediate 8-bit
+ * copy, and only the selected row is normalized.
  * @ingroup lrps
  */
 class IntensityMap
@@ -76,16 +78,13 @@ private:
     /** Unsorted intensity plot of selected row */
     cv::Mat_<double> intensities_;
 
-    /** Input matrix */
-    cv::Mat_<uint8_t> resliceData_;
-
     /** Width of the image returned by draw() */
     int displayWidth_;
 
     /** Height of the image returned by draw() */
     int displayHeight_;
 
-    /** Image returned by draw() */
+    /** Image returned by draw(). Only allocated when drawn. */
     cv::Mat drawTarget_;
 
     /** Width of the bin to hold the image */
@@ -2,7 +2,10 @@
 
 /** @file */
 
+#include <algorithm>
 #include <cassert>
+#include <cmath>
+#include <cstddef>
 #include <vector>
 
 #include <unsupported/Eigen/Splines>
@@ -15,6 +18,17 @@ namespace volcart::segmentation
  * @class Spline
  * @brief Simple spline wrapper around Eigen::Spline
  *
+ * Fits an interpolating spline with chord-length parameters and averaged
+ * knots, like Eigen::SplineFitting::Interpolate. Eigen solves the fitting
+ * system as a dense matrix, which makes every fit cubic in the number of
+ * points. Because each row of the system only has `Degree + 1` non-zero
+ * B-spline basis values, this class stores it as a band matrix and solves it
+ * in linear time instead. Small systems, and systems which are not banded
+ * because of repeated points, fall back to Eigen's dense solver.
+ *
+ * The fitting buffers are kept between calls to fit(), so refitting a spline
+ * to the same number of points does not allocate.
+ *
  * @ingroup lrps
  */
 template <typename Scalar = double, int Degree = 3>
@@ -32,11 +46,26 @@ public:
      * @param xs Vector of X values
      * @param ys Vector of Y values
      */
-    Spline(const ScalarVector& xs, const ScalarVector& ys) : npoints_{xs.size()}
+    Spline(const ScalarVector& xs, const ScalarVector& ys) { fit(xs, ys); }
+
+    /**
+     * @brief Refit the spline to a new set of points
+     *
+     * @param xs Vector of X values
+     * @param ys Vector of Y values
+     */
+    void fit(const ScalarVector& xs, const ScalarVector& ys)
     {
         assert(xs.size() == ys.size() && "xs and ys must be same length");
-        auto points = make_wide_matrix_(xs, ys);
-        spline_ = Eigen::SplineFitting<SplineType>::Interpolate(points, Degree);
+        npoints_ = xs.size();
+        auto n = static_cast<Eigen::DenseIndex>(npoints_);
+        points_.resize(2, n);
+        points_.row(0) = Eigen::Map<const RowVector>(xs.data(), n);
+        points_.row(1) = Eigen::Map<const RowVector>(ys.data(), n);
+        if (not fit_banded_()) {
+            spline_ = Eigen::SplineFitting<SplineType>::Interpolate(
+                points_, Degree);
+        }
     }
 
     /**
@@ -50,21 +79,97 @@ public:
     }
 
 private:
+    using RowVector = Eigen::Matrix<Scalar, 1, Eigen::Dynamic>;
+    using Matrix = Eigen::Matrix<Scalar, Eigen::Dynamic, Eigen::Dynamic>;
+    using KnotVector = typename SplineType::KnotVectorType;
+
+    /** Number of diagonals on each side of the band matrix's diagonal */
+    static constexpr Eigen::DenseIndex BAND{Degree};
+
+    /** Below this many points, splines are fit by Eigen */
+    static constexpr std::size_t MIN_BANDED_POINTS{4 * (Degree + 1)};
+
     /** Number of points on the spline */
-    size_t npoints_;
+    size_t npoints_{0};
 
     SplineType spline_;
 
+    /** Fitting buffers */
+    Matrix points_;
+    KnotVector params_;
+    KnotVector knots_;
+    Matrix band_;
+    Matrix ctrls_;
+
     /**
-     * @brief Combine X and Y values into an npoints_ x 2 matrix
+     * @brief Fit the spline with a banded solver
+     *
+     * Returns false if the system is too small or is not banded.
      */
-    Eigen::MatrixXd make_wide_matrix_(
-        const ScalarVector& xs, const ScalarVector& ys)
+    auto fit_banded_() -> bool
     {
-        Eigen::MatrixXd mat{2, xs.size()};
-        mat.row(0) = Eigen::VectorXd::Map(xs.data(), xs.size());
-        mat.row(1) = Eigen::VectorXd::Map(ys.data(), ys.size());
-        return mat;
+        if (npoints_ < MIN_BANDED_POINTS) {
+            return false;
+        }
+
+        // Same parameters and knots as Eigen::SplineFitting::Interpolate
+        const auto n = static_cast<Eigen::DenseIndex>(npoints_);
+        Eigen::ChordLengths(points_, params_);
+        if (not params_.allFinite()) {
+            return false;
+        }
+        Eigen::KnotAveraging(params_, Degree, knots_);
+
+        // Row i of the band matrix holds columns [i - BAND, i + BAND]
+        band_.setZero(n, 2 * BAND + 1);
+        band_(0, BAND) = 1;
+        band_(n - 1, BAND) = 1;
+        for (Eigen::DenseIndex i = 1; i < n - 1; ++i) {
+            auto span = SplineType::Span(params_[i], Degree, knots_);
+            auto basis =
+                SplineType::BasisFunctions(params_[i], Degree, knots_);
+            for (Eigen::DenseIndex j = 0; j <= Degree; ++j) {
+                auto col = span - Degree + j - i;
+                if (basis[j] == 0) {
+                    continue;
+                }
+                if (std::abs(col) > BAND) {
+                    return false;
+                }
+                band_(i, col + BAND) = basis[j];
+            }
+        }
+
+        // Gaussian elimination without pivoting, which is stable for the
+        // totally positive collocation matrices of interpolating B-splines
+        ctrls_ = points_.transpose();
+        for (Eigen::DenseIndex k = 0; k < n; ++k) {
+            auto pivot = band_(k, BAND);
+            if (std::abs(pivot) < 1e-12) {
+                return false;
+            }
+            auto last = std::min(k + BAND, n - 1);
+            for (auto i = k + 1; i <= last; ++i) {
+                auto f = band_(i, k - i + BAND) / pivot;
+                if (f == 0) {
+                    continue;
+                }
+                for (auto j = k; j <= std::min(k + BAND, n - 1); ++j) {
+                    band_(i, j - i + BAND) -= f * band_(k, j - k + BAND);
+                }
+                ctrls_.row(i) -= f * ctrls_.row(k);
+            }
+        }
+        for (auto k = n - 1; k >= 0; --k) {
+            auto last = std::min(k + BAND, n - 1);
+            for (auto j = k + 1; j <= last; ++j) {
+                ctrls_.row(k) -= band_(k, j - k + BAND) * ctrls_.row(j);
+            }
+            ctrls_.row(k) /= band_(k, BAND);
+        }
+
+        spline_ = SplineType(knots_, ctrls_.transpose());
+        return true;
     }
 };
 
@@ -17,19 +17,27 @@ using Force = cv::Vec3d;
  * Vectors in this class are assumed to be 3D offsets to the position of
  * elements in a ParticleChain.
  *
+ * Components are stored as a structure of arrays: one contiguous array each
+ * for the x, y, and z components. Operations over the whole chain are plain
+ * loops over these arrays, which the compiler can vectorize, and the arrays
+ * can be passed directly to other kernels with x(), y(), and z().
+ *
  * @ingroup stps
  */
 class ForceChain
 {
 public:
-    /** Data storage type */
+    /** Initialization list type */
     using Chain = std::vector<Force>;
 
     /** @brief Default constructor */
     ForceChain() = default;
 
+    /** @brief Constructor for a chain of `n` zero forces */
+    explicit ForceChain(size_t n) : x_(n, 0), y_(n, 0), z_(n, 0) {}
+
     /** @brief Constructor with chain initialization */
-    explicit ForceChain(Chain c) : data_{std::move(c)} {}
+    explicit ForceChain(const Chain& c);
 
     /**
      * @brief Add a list of offset vectors to each element in the chain
@@ -43,53 +51,81 @@ public:
     /** @brief Multiply each element of chain by a constant scale factor */
     ForceChain& operator*=(const double& rhs);
 
-    /** @brief Element access operator */
-    auto operator[](size_t i) { return data_[i]; }
-
-    /** @copydoc operator[](size_t) */
-    auto operator[](size_t i) const { return data_[i]; }
-
-    /** @brief Returns an iterator to the beginning of the chain */
-    auto begin() { return data_.begin(); }
-
-    /** @copydoc begin() */
-    auto begin() const { return data_.begin(); }
+    /**
+     * @brief Add a scaled list of offset vectors to each element in the chain
+     *
+     * Equivalent to `*this += s * rhs` without a temporary chain. Throws
+     * `std::domain_error` if the chain sizes don't match.
+     */
+    ForceChain& addScaled(const ForceChain& rhs, double s);
 
-    /** @brief Returns an iterator to the end of the chain */
-    auto end() { return data_.end(); }
+    /** @brief Get an element of the chain */
+    Force operator[](size_t i) const { return {x_[i], y_[i], z_[i]}; }
 
-    /** @copydoc end() */
-    auto end() const { return data_.end(); }
+    /** @brief Set an element of the chain */
+    void set(size_t i, const Force& f)
+    {
+        x_[i] = f[0];
+        y_[i] = f[1];
+        z_[i] = f[2];
+    }
 
     /** @brief Constructs an element at the end of the chain */
     template <class... Args>
     void emplace_back(Args&&... args)
     {
-        data_.emplace_back(std::forward<Args>(args)...);
+        push_back(Force(std::forward<Args>(args)...));
     }
 
     /** @brief Adds an element to the end of the chain */
-    void push_back(const Force& val) { data_.push_back(val); }
+    void push_back(const Force& val)
+    {
+        x_.push_back(val[0]);
+        y_.push_back(val[1]);
+        z_.push_back(val[2]);
+    }
 
     /** @brief Returns the number of elements in the chain */
-    size_t size() { return data_.size(); }
+    size_t size() const { return x_.size(); }
 
-    /** @copydoc size() */
-    size_t size() const { return data_.size(); }
+    /** @brief Resize the chain, filling new elements with zero forces */
+    void resize(size_t n);
 
     /** @brief Empties and resets the chain */
-    void clear() { data_.clear(); }
+    void clear();
+
+    /**@{*/
+    /** @brief Get the x components of the chain */
+    double* x() { return x_.data(); }
+    /** @copydoc x() */
+    const double* x() const { return x_.data(); }
+    /** @brief Get the y components of the chain */
+    double* y() { return y_.data(); }
+    /** @copydoc y() */
+    const double* y() const { return y_.data(); }
+    /** @brief Get the z components of the chain */
+    double* z() { return z_.data(); }
+    /** @copydoc z() */
+    const double* z() const { return z_.data(); }
+    /**@}*/
 
     /**
      * @brief Normalize the magnitude of each Force in the chain
      *
+     * Forces with a magnitude smaller than `DBL_EPSILON` are set to zero, as
+     * with `cv::normalize()`.
+     *
      * @param alpha Upper value to which the magnitude is normalized
      */
     static void Normalize(ForceChain& c, double alpha = 1.0);
 
 private:
-    /** Data storage vector */
-    Chain data_;
+    /** x components */
+    std::vector<double> x_;
+    /** y components */
+    std::vector<double> y_;
+    /** z components */
+    std::vector<double> z_;
 };
 
 /** Free function operator for per-element ForceChain addition */
@@ -16,19 +16,24 @@ namespace volcart::segmentation
  * @brief A simple class for keeping track of a connected chain of Particle
  * objects
  *
+ * Like ForceChain, particle state is stored as a structure of arrays: the
+ * x, y, and z components of the particle positions and the left and right
+ * resting lengths are each kept in a contiguous array. Particle objects are
+ * only created when elements are read with operator[].
+ *
  * @ingroup stps
  */
 class ParticleChain
 {
 public:
-    /** Data storage type */
+    /** Initialization list type */
     using Chain = std::vector<Particle>;
 
     /** @brief Default constructor */
     ParticleChain() = default;
 
     /** @brief Constructor with chain initialization */
-    explicit ParticleChain(Chain c) : data_{std::move(c)} {}
+    explicit ParticleChain(const Chain& c);
 
     /**
      * @brief Add a list of offset vectors to each element in the chain
@@ -42,46 +47,77 @@ public:
     /** @brief Multiply each element of chain by a constant scale factor */
     ParticleChain& operator*=(const double& rhs);
 
-    /** @brief Element access operator */
-    auto operator[](size_t i) { return data_[i]; }
-
-    /** @copydoc operator[](size_t) */
-    auto operator[](size_t i) const { return data_[i]; }
+    /**
+     * @brief Add a scaled list of offset vectors to each element in the chain
+     *
+     * Equivalent to `*this += s * rhs` without a temporary chain. Throws
+     * `std::domain_error` if the chain sizes don't match.
+     */
+    ParticleChain& addScaled(const ForceChain& rhs, double s);
 
-    /** @brief Returns an iterator to the beginning of the chain */
-    auto begin() { return data_.begin(); }
+    /** @brief Get an element of the chain */
+    Particle operator[](size_t i) const;
 
-    /** @copydoc begin() */
-    auto begin() const { return data_.begin(); }
+    /** @brief Get the position of an element of the chain */
+    cv::Vec3d pos(size_t i) const { return {x_[i], y_[i], z_[i]}; }
 
-    /** @brief Returns an iterator to the end of the chain */
-    auto end() { return data_.end(); }
+    /** @brief Set the position of an element of the chain */
+    void setPos(size_t i, const cv::Vec3d& p)
+    {
+        x_[i] = p[0];
+        y_[i] = p[1];
+        z_[i] = p[2];
+    }
 
-    /** @copydoc end() */
-    auto end() const { return data_.end(); }
+    /**
+     * @brief Set the resting lengths of every element from the current
+     * distances between neighboring particles
+     *
+     * The left resting length of the first particle and the right resting
+     * length of the last particle are set to zero.
+     */
+    void updateRestingLengths();
 
     /** @brief Constructs an element at the end of the chain */
     template <class... Args>
     void emplace_back(Args&&... args)
     {
-        data_.emplace_back(std::forward<Args>(args)...);
+        push_back(Particle(std::forward<Args>(args)...));
     }
 
     /** @brief Adds an element to the end of the chain */
-    void push_back(const Particle& val) { data_.push_back(val); }
+    void push_back(const Particle& val);
 
     /** @brief Returns the number of elements in the chain */
-    size_t size() { return data_.size(); }
-
-    /** @copydoc size() */
-    size_t size() const { return data_.size(); }
+    size_t size() const { return x_.size(); }
 
     /** @brief Empties and resets the chain */
-    void clear() { data_.clear(); }
+    void clear();
+
+    /**@{*/
+    /** @brief Get the x components of the particle positions */
+    const double* x() const { return x_.data(); }
+    /** @brief Get the y components of the particle positions */
+    const double* y() const { return y_.data(); }
+    /** @brief Get the z components of the particle positions */
+    const double* z() const { return z_.data(); }
+    /** @brief Get the left resting lengths */
+    const double* restingL() const { return restingL_.data(); }
+    /** @brief Get the right resting lengths */
+    const double* restingR() const { return restingR_.data(); }
+    /**@}*/
 
 private:
-    /** Data storage vector */
-    Chain data_;
+    /** Position x components */
+    std::vector<double> x_;
+    /** Position y components */
+    std::vector<double> y_;
+    /** Position z components */
+    std::vector<double> z_;
+    /** Resting lengths to the "left" */
+    std::vector<double> restingL_;
+    /** Resting lengths to the "right" */
+    std::vector<double> restingR_;
 };
 
 /** Free function operator for ParticleChain and ForceChain addition */
@@ -53,4 +53,21 @@ std::vector<cv::Vec3i> DoFloodFill(
     uint16_t low,
     uint16_t high);
 
+/**
+ * Run flood fill using the provided set of seed points and rasterize the
+ * result
+ *
+ * Fills the same pixels as DoFloodFill(), but returns them as a CV_8UC1 mask
+ * image the size of `img`, in which filled pixels are 255 and all other pixels
+ * are 0. Visited pixels are tracked in the mask image itself and distances are
+ * compared as integer squared distances, so this is considerably faster than
+ * collecting the filled voxels.
+ */
+cv::Mat FloodFillMask(
+    const std::vector<cv::Vec3i>& pts,
+    int bound,
+    const cv::Mat& img,
+    uint16_t low,
+    uint16_t high);
+
 }  // namespace volcart::segmentation
\ No newline at end of file
@@ -0,0 +1,48 @@
+#pragma once
+
+/** @file */
+
+#include <cstddef>
+
+#include <opencv2/core.hpp>
+
+namespace volcart::segmentation
+{
+
+/**
+ * @brief Skeletonize a binary mask image by thinning
+ *
+ * Thins the non-zero pixels of the CV_8UC1 mask, in place, to a centered,
+ * 8-connected skeleton. Implements the directional thinning algorithm of
+ * section 8.6.2 of "Computer Vision" by E.R. Davies: each pass removes the
+ * north, south, east, or west boundary pixels whose removal does not change
+ * the local connectivity, and passes repeat until no pixel is removed.
+ *
+ * Each pixel's eight neighbors are packed into a byte which indexes a
+ * precomputed table of removable neighborhoods. The candidates of a pass
+ * only depend on the mask at the start of the pass, so every pass is split
+ * into row bands which are searched on the global ThreadPool.
+ *
+ * @param mask Binary mask image
+ * @param numThreads Number of row bands searched concurrently. If `1`,
+ * thinning is serial.
+ */
+void ThinMask(cv::Mat& mask, std::size_t numThreads = 1);
+
+/**
+ * @brief Remove short spurs from a skeleton image
+ *
+ * Intersections are skeleton pixels with more than two 8-connected neighbors.
+ * From each intersection, the skeleton reachable through each neighboring
+ * pixel, without passing through the intersection, is measured. If that
+ * branch has more than one and at most `spurLength` pixels, the branch and
+ * the intersection are removed from the skeleton. Intersections are
+ * processed in row-major order. Branches are only measured up to
+ * `spurLength` pixels, so long skeletons are not traversed.
+ *
+ * @param skeleton Binary CV_8UC1 skeleton image, modified in place
+ * @param spurLength Maximum length of a removed spur
+ */
+void PruneSpurs(cv::Mat& skeleton, std::size_t spurLength);
+
+}  // namespace volcart::segmentation
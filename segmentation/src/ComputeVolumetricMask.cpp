@@ -1,9 +1,13 @@
 #include "vc/segmentation/ComputeVolumetricMask.hpp"
 
+#include <algorithm>
+#include <deque>
+#include <exception>
+#include <future>
 #include <map>
 #include <opencv2/imgproc.hpp>
 
-#include "vc/core/util/Iteration.hpp"
+#include "vc/core/util/ThreadPool.hpp"
 #include "vc/segmentation/tff/FloodFill.hpp"
 
 using namespace volcart;
@@ -27,6 +31,16 @@ void ComputeVolumetricMask::setMeasureVertical(bool b)
 
 void ComputeVolumetricMask::setMaxRadius(size_t radius) { maxRadius_ = radius; }
 
+void ComputeVolumetricMask::setNumThreads(std::size_t n) { numThreads_ = n; }
+
+std::size_t ComputeVolumetricMask::numThreads() const
+{
+    if (numThreads_ > 0) {
+        return numThreads_;
+    }
+    return ThreadPool::Global().numThreads();
+}
+
 VolumetricMask::Pointer ComputeVolumetricMask::compute()
 {
     // Setup the output
@@ -47,64 +61,106 @@ VolumetricMask::Pointer ComputeVolumetricMask::compute()
     // Signal progress has begun
     progressStarted();
 
-    // Iterate over z-slices
-    for (auto zIndex : range(startSlice, endSlice + 1)) {
-        // Update progress
+    // Slices are queued on the shared pool. At most numThreads() slices are
+    // in flight at once, which also bounds the number of slice images held
+    // in memory.
+    auto& pool = ThreadPool::Global();
+    const auto maxPending = numThreads();
+    using SliceResult = std::pair<size_t, std::future<VolumetricMask::Pointer>>;
+    std::deque<SliceResult> pending;
+
+    // Merge finished slices in order. Keep waiting after an error so that no
+    // task outlives this function.
+    std::exception_ptr error;
+    auto mergeNext = [&]() {
+        auto [zIndex, result] = std::move(pending.front());
+        pending.pop_front();
+        try {
+            mask_->merge(*pool.wait(result));
+        } catch (...) {
+            if (not error) {
+                error = std::current_exception();
+            }
+        }
         progressUpdated(zIndex - startSlice);
+    };
 
-        // Get this slice's seed points
-        VoxelList seedPoints;
-        try {
-            seedPoints = seedsBySlice.at(zIndex);
-        } catch (const std::out_of_range& e) {
-            // No seeds for this slice. Skip.
-            continue;
+    // Iterate over z-slices with seed points
+    for (const auto& [zIndex, seeds] : seedsBySlice) {
+        if (error) {
+            break;
+        }
+        pending.emplace_back(
+            zIndex, pool.submit([this, zIndex = zIndex, &seeds = seeds]() {
+                return compute_slice_(zIndex, seeds);
+            }));
+        if (pending.size() >= maxPending) {
+            mergeNext();
         }
+    }
+    while (not pending.empty()) {
+        mergeNext();
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
 
-        // Get the current (single) slice image (Of type Mat)
-        auto slice = vol_->getSliceDataCopy(zIndex);
+    progressComplete();
+    return mask_;
+}
 
-        // Estimate thickness of page from every seed point.
-        std::vector<size_t> estimates;
-        for (const auto& v : seedPoints) {
-            estimates.emplace_back(MeasureThickness(
-                v, slice, low_, high_, measureVertically_, maxRadius_));
+VolumetricMask::Pointer ComputeVolumetricMask::compute_slice_(
+    size_t zIndex, const VoxelList& seedPoints) const
+{
+    auto sliceMask = VolumetricMask::New();
+
+    // The flood fill only starts from seeds in the threshold range. Skip the
+    // slice without reading it if no seed's block can contain that range.
+    if (auto stats = vol_->blockStatistics()) {
+        auto bs = stats->blockSize();
+        auto z = static_cast<int>(zIndex);
+        auto inRange = std::any_of(
+            seedPoints.begin(), seedPoints.end(), [&](const auto& v) {
+                return stats->mayContain(
+                    v[0] / bs, v[1] / bs, z / bs, low_, high_);
+            });
+        if (not inRange) {
+            return sliceMask;
         }
+    }
 
-        // Calculate the median thickness.
-        // Choose the median of the measurements to be the boundary for every
-        // point.
-        auto bound = Median(estimates);
-
-        // Do flood-fill with the given seed points to the estimated thickness.
-        auto sliceMask = DoFloodFill(seedPoints, bound, slice, low_, high_);
+    // Get the current (single) slice image (Of type Mat)
+    auto slice = vol_->getSliceView(zIndex);
 
-        // Apply closing to fill holes and gaps.
-        if (enableClosing_) {
-            // Convert mask to a binary image so we can apply closing
-            cv::Mat binaryImg = cv::Mat::zeros(slice.size(), CV_8UC1);
-            for (const Voxel& v : sliceMask) {
-                binaryImg.at<uint8_t>(v[1], v[0]) = 255;
-            }
+    // Estimate thickness of page from every seed point.
+    std::vector<size_t> estimates;
+    for (const auto& v : seedPoints) {
+        estimates.emplace_back(MeasureThickness(
+            v, slice, low_, high_, measureVertically_, maxRadius_));
+    }
 
-            cv::Mat kernel = cv::Mat::ones(kernel_, kernel_, CV_8U);
-            cv::Mat closedImg;
-            cv::morphologyEx(binaryImg, closedImg, cv::MORPH_CLOSE, kernel);
-
-            // Save to the full volume mask
-            for (const auto p : range2D(closedImg.rows, closedImg.cols)) {
-                const auto& x = p.second;
-                const auto& y = p.first;
-                if (closedImg.at<uint8_t>(y, x) > 0) {
-                    mask_->setIn({x, y, zIndex});
-                }
-            }
-        } else {
-            mask_->setIn(sliceMask);
-        }
+    // Calculate the median thickness.
+    // Choose the median of the measurements to be the boundary for every
+    // point.
+    auto bound = Median(estimates);
+
+    // Apply closing to fill holes and gaps.
+    if (enableClosing_) {
+        // Flood fill directly into a binary image so we can apply closing
+        auto binaryImg = FloodFillMask(seedPoints, bound, slice, low_, high_);
+
+        cv::Mat kernel = cv::Mat::ones(kernel_, kernel_, CV_8U);
+        cv::Mat closedImg;
+        cv::morphologyEx(binaryImg, closedImg, cv::MORPH_CLOSE, kernel);
+
+        // Save to the slice mask
+        sliceMask->setIn(closedImg, static_cast<int>(zIndex));
+    } else {
+        // Do flood-fill with the given seed points to the estimated
+        // thickness.
+        sliceMask->setIn(DoFloodFill(seedPoints, bound, slice, low_, high_));
     }
-    progressComplete();
-    return mask_;
+    return sliceMask;
 }
 
 void ComputeVolumetricMask::setPointSet(const PointSet& ps) { input_ = ps; }
@@ -0,0 +1,474 @@
+#include "vc/segmentation/ConnectedComponents.hpp"
+
+#include <algorithm>
+#include <deque>
+#include <exception>
+#include <future>
+#include <numeric>
+#include <stdexcept>
+#include <type_traits>
+
+#include <opencv2/core.hpp>
+
+#include "vc/core/util/ThreadPool.hpp"
+
+using namespace volcart;
+using namespace volcart::segmentation;
+
+using Connectivity = ConnectedComponents3D::Connectivity;
+
+namespace
+{
+// Union-find over component indices. Roots are always the smallest index of
+// their set.
+class DisjointSet
+{
+public:
+    explicit DisjointSet(std::size_t n = 0) : parent_(n)
+    {
+        std::iota(parent_.begin(), parent_.end(), 0);
+    }
+
+    // Add a new singleton set and return its index
+    auto add() -> std::size_t
+    {
+        parent_.push_back(parent_.size());
+        return parent_.size() - 1;
+    }
+
+    auto find(std::size_t a) -> std::size_t
+    {
+        while (parent_[a] != a) {
+            parent_[a] = parent_[parent_[a]];
+            a = parent_[a];
+        }
+        return a;
+    }
+
+    void unite(std::size_t a, std::size_t b)
+    {
+        a = find(a);
+        b = find(b);
+        if (a != b) {
+            parent_[std::max(a, b)] = std::min(a, b);
+        }
+    }
+
+    [[nodiscard]] auto size() const -> std::size_t { return parent_.size(); }
+
+private:
+    std::vector<std::size_t> parent_;
+};
+
+// Run of foreground pixels [x0, x1) in a row
+struct Run {
+    int x0;
+    int x1;
+    std::size_t label;
+};
+
+// Run-length encoded 2D components of a slice. Labels are numbered in the
+// order of each component's first run, so equal slices always get equal
+// labels.
+struct PlaneLabels {
+    // Runs, in row-major order
+    std::vector<Run> runs;
+    // Index of the first run of each row, plus the total number of runs
+    std::vector<std::size_t> rowStart;
+    // Number of pixels of each label
+    std::vector<std::size_t> areas;
+};
+
+// Whether two runs touch. Diagonal neighbors touch if `d == 1`.
+auto Touch(const Run& a, const Run& b, int d) -> bool
+{
+    return a.x0 < b.x1 + d and b.x0 < a.x1 + d;
+}
+
+// Call f(a, b) for every pair of touching runs of two rows
+template <typename F>
+void ForEachTouching(
+    const PlaneLabels& pa,
+    int ya,
+    const PlaneLabels& pb,
+    int yb,
+    int d,
+    F f)
+{
+    auto a = pa.rowStart[ya];
+    auto aEnd = pa.rowStart[ya + 1];
+    auto b = pb.rowStart[yb];
+    auto bEnd = pb.rowStart[yb + 1];
+    while (a < aEnd and b < bEnd) {
+        const auto& ra = pa.runs[a];
+        const auto& rb = pb.runs[b];
+        if (Touch(ra, rb, d)) {
+            f(a, b);
+        }
+        // Advance the run which ends first
+        if (ra.x1 < rb.x1) {
+            a++;
+        } else {
+            b++;
+        }
+    }
+}
+
+// Label the foreground pixels of a slice
+auto LabelPlane(
+    const cv::Mat& slice,
+    std::uint16_t low,
+    std::uint16_t high,
+    Connectivity connectivity) -> PlaneLabels
+{
+    cv::Mat fg;
+    cv::inRange(slice, cv::Scalar(low), cv::Scalar(high), fg);
+    const int d = connectivity == Connectivity::Full ? 1 : 0;
+
+    PlaneLabels plane;
+    plane.rowStart.reserve(fg.rows + 1);
+    DisjointSet sets;
+    for (int y = 0; y < fg.rows; y++) {
+        plane.rowStart.push_back(plane.runs.size());
+        const auto* row = fg.ptr<std::uint8_t>(y);
+        int x = 0;
+        while (x < fg.cols) {
+            if (row[x] == 0) {
+                x++;
+                continue;
+            }
+            const auto x0 = x;
+            while (x < fg.cols and row[x] != 0) {
+                x++;
+            }
+            plane.runs.push_back({x0, x, sets.add()});
+        }
+        if (y == 0) {
+            continue;
+        }
+
+        // Merge with the touching runs of the previous row. Runs of the
+        // current row are past rowStart[y].
+        plane.rowStart.push_back(plane.runs.size());
+        ForEachTouching(
+            plane, y - 1, plane, y, d, [&](auto a, auto b) {
+                sets.unite(plane.runs[a].label, plane.runs[b].label);
+            });
+        plane.rowStart.pop_back();
+    }
+    plane.rowStart.push_back(plane.runs.size());
+
+    // Number the components in the order of their first run. Roots are the
+    // first run of their component.
+    std::vector<std::size_t> labels(plane.runs.size());
+    for (std::size_t i = 0; i < plane.runs.size(); i++) {
+        auto root = sets.find(i);
+        if (root == i) {
+            labels[i] = plane.areas.size();
+            plane.areas.push_back(0);
+        } else {
+            labels[i] = labels[root];
+        }
+        auto& run = plane.runs[i];
+        run.label = labels[i];
+        plane.areas[run.label] += static_cast<std::size_t>(run.x1 - run.x0);
+    }
+    return plane;
+}
+
+// Call f(a, b) for every pair of touching labels of two consecutive slices
+template <typename F>
+void ConnectPlanes(
+    const PlaneLabels& prev,
+    const PlaneLabels& cur,
+    Connectivity connectivity,
+    F f)
+{
+    const auto rows = static_cast<int>(cur.rowStart.size()) - 1;
+    const int d = connectivity == Connectivity::Full ? 1 : 0;
+    for (int y = 0; y < rows; y++) {
+        for (int dy = -d; dy <= d; dy++) {
+            auto py = y + dy;
+            if (py < 0 or py >= rows) {
+                continue;
+            }
+            ForEachTouching(prev, py, cur, y, d, [&](auto a, auto b) {
+                f(prev.runs[a].label, cur.runs[b].label);
+            });
+        }
+    }
+}
+
+// 2D components of a slab and their slab-level components
+struct SlabLabels {
+    // Whether the first slice is the last slice of the previous slab
+    bool overlap{false};
+    // Index of the first 2D component of each slice
+    std::vector<std::size_t> planeStart;
+    // Slab-level root of each 2D component
+    std::vector<std::size_t> roots;
+    // Number of voxels of each 2D component
+    std::vector<std::size_t> areas;
+};
+
+// Run tasks for slabs [0, numSlabs) on the global pool with at most
+// maxPending in flight, and pass their results to done() in slab order
+template <typename Task, typename Done>
+void ForEachSlab(
+    std::size_t numSlabs, std::size_t maxPending, Task task, Done done)
+{
+    auto& pool = ThreadPool::Global();
+    using Result = std::invoke_result_t<Task, std::size_t>;
+    std::deque<std::pair<std::size_t, std::future<Result>>> pending;
+
+    // Keep waiting after an error so that no task outlives this function
+    std::exception_ptr error;
+    auto finishNext = [&]() {
+        auto [slab, result] = std::move(pending.front());
+        pending.pop_front();
+        try {
+            auto r = pool.wait(result);
+            if (not error) {
+                done(slab, std::move(r));
+            }
+        } catch (...) {
+            if (not error) {
+                error = std::current_exception();
+            }
+        }
+    };
+
+    for (std::size_t slab = 0; slab < numSlabs and not error; slab++) {
+        pending.emplace_back(slab, pool.submit([&task, slab]() {
+            return task(slab);
+        }));
+        if (pending.size() >= maxPending) {
+            finishNext();
+        }
+    }
+    while (not pending.empty()) {
+        finishNext();
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+}  // namespace
+
+void ConnectedComponents3D::setVolume(const Volume::Pointer& v) { vol_ = v; }
+
+void ConnectedComponents3D::setLowThreshold(std::uint16_t t) { low_ = t; }
+
+void ConnectedComponents3D::setHighThreshold(std::uint16_t t) { high_ = t; }
+
+void ConnectedComponents3D::setConnectivity(Connectivity c)
+{
+    connectivity_ = c;
+}
+
+void ConnectedComponents3D::setMinComponentSize(std::size_t n)
+{
+    minSize_ = n;
+}
+
+auto ConnectedComponents3D::minComponentSize() const -> std::size_t
+{
+    return minSize_;
+}
+
+void ConnectedComponents3D::setSlabSize(std::size_t n)
+{
+    slabSize_ = std::max<std::size_t>(n, 1);
+}
+
+auto ConnectedComponents3D::slabSize() const -> std::size_t
+{
+    return slabSize_;
+}
+
+void ConnectedComponents3D::setNumThreads(std::size_t n) { numThreads_ = n; }
+
+auto ConnectedComponents3D::numThreads() const -> std::size_t
+{
+    if (numThreads_ > 0) {
+        return numThreads_;
+    }
+    return ThreadPool::Global().numThreads();
+}
+
+auto ConnectedComponents3D::compute() -> VolumetricMask::Pointer
+{
+    if (not vol_) {
+        throw std::logic_error("Volume not set");
+    }
+
+    mask_ = VolumetricMask::New();
+    sizes_.clear();
+    const auto numSlices = static_cast<std::size_t>(vol_->numSlices());
+    const auto numSlabs = (numSlices + slabSize_ - 1) / slabSize_;
+    const auto maxPending = numThreads();
+    progressStarted();
+    std::size_t progress{0};
+
+    // Pass 1: Label each slab, including the last slice of the previous slab
+    std::vector<SlabLabels> slabs(numSlabs);
+    ForEachSlab(
+        numSlabs, maxPending,
+        [this, numSlices](std::size_t slab) {
+            SlabLabels result;
+            auto z0 = slab * slabSize_;
+            auto z1 = std::min(z0 + slabSize_, numSlices);
+            result.overlap = slab > 0;
+            if (result.overlap) {
+                z0--;
+            }
+
+            DisjointSet sets;
+            PlaneLabels prev;
+            for (auto z = z0; z < z1; z++) {
+                auto plane = LabelPlane(
+                    vol_->getSliceView(static_cast<int>(z)), low_, high_,
+                    connectivity_);
+                auto start = result.areas.size();
+                result.planeStart.push_back(start);
+                result.areas.insert(
+                    result.areas.end(), plane.areas.begin(),
+                    plane.areas.end());
+                for (std::size_t i = 0; i < plane.areas.size(); i++) {
+                    sets.add();
+                }
+                if (z > z0) {
+                    auto prevStart = result.planeStart[z - z0 - 1];
+                    ConnectPlanes(
+                        prev, plane, connectivity_, [&](auto a, auto b) {
+                            sets.unite(prevStart + a, start + b);
+                        });
+                }
+                prev = std::move(plane);
+            }
+
+            result.roots.resize(sets.size());
+            for (std::size_t i = 0; i < sets.size(); i++) {
+                result.roots[i] = sets.find(i);
+            }
+            return result;
+        },
+        [&](std::size_t slab, SlabLabels result) {
+            slabs[slab] = std::move(result);
+            progressUpdated(++progress);
+        });
+
+    // Merge the slabs. The first slice of every slab after the first is
+    // labeled exactly like the last slice of the previous slab.
+    std::vector<std::size_t> base(numSlabs + 1, 0);
+    for (std::size_t s = 0; s < numSlabs; s++) {
+        base[s + 1] = base[s] + slabs[s].areas.size();
+    }
+    DisjointSet sets(base.back());
+    for (std::size_t s = 0; s < numSlabs; s++) {
+        const auto& slab = slabs[s];
+        for (std::size_t i = 0; i < slab.roots.size(); i++) {
+            sets.unite(base[s] + i, base[s] + slab.roots[i]);
+        }
+        if (not slab.overlap) {
+            continue;
+        }
+        const auto& prevSlab = slabs[s - 1];
+        auto prevLast = base[s - 1] + prevSlab.planeStart.back();
+        for (std::size_t j = 0; j < slab.planeStart[1]; j++) {
+            sets.unite(base[s] + j, prevLast + j);
+        }
+    }
+
+    // Number the components in the order of their first voxel and count
+    // their voxels. Overlap slices are counted by their own slab.
+    std::vector<std::size_t> component(base.back());
+    for (std::size_t s = 0; s < numSlabs; s++) {
+        const auto& slab = slabs[s];
+        auto first = slab.overlap ? slab.planeStart[1] : 0;
+        for (std::size_t i = 0; i < slab.areas.size(); i++) {
+            auto idx = base[s] + i;
+            auto root = sets.find(idx);
+            if (root == idx) {
+                component[idx] = sizes_.size();
+                sizes_.push_back(0);
+            } else {
+                component[idx] = component[root];
+            }
+            if (i >= first) {
+                sizes_[component[idx]] += slab.areas[i];
+            }
+        }
+    }
+
+    // Pass 2: Relabel the slabs and write the large components to the mask
+    ForEachSlab(
+        numSlabs, maxPending,
+        [&, numSlices](std::size_t s) {
+            auto slabMask = VolumetricMask::New();
+            const auto& slab = slabs[s];
+            auto z0 = s * slabSize_;
+            auto z1 = std::min(z0 + slabSize_, numSlices);
+            auto planeOffset = slab.overlap ? 1 : 0;
+            cv::Mat planeMask(
+                vol_->sliceHeight(), vol_->sliceWidth(), CV_8UC1);
+            for (auto z = z0; z < z1; z++) {
+                auto plane = LabelPlane(
+                    vol_->getSliceView(static_cast<int>(z)), low_, high_,
+                    connectivity_);
+                auto start =
+                    base[s] + slab.planeStart[z - z0 + planeOffset];
+                planeMask.setTo(0);
+                bool any{false};
+                auto rows = static_cast<int>(plane.rowStart.size()) - 1;
+                for (int y = 0; y < rows; y++) {
+                    auto* row = planeMask.ptr<std::uint8_t>(y);
+                    for (auto r = plane.rowStart[y]; r < plane.rowStart[y + 1];
+                         r++) {
+                        const auto& run = plane.runs[r];
+                        if (sizes_[component[start + run.label]] < minSize_) {
+                            continue;
+                        }
+                        std::fill(row + run.x0, row + run.x1, 255);
+                        any = true;
+                    }
+                }
+                if (any) {
+                    slabMask->setIn(planeMask, static_cast<int>(z));
+                }
+            }
+            return slabMask;
+        },
+        [&](std::size_t /*slab*/, const VolumetricMask::Pointer& slabMask) {
+            mask_->merge(*slabMask);
+            progressUpdated(++progress);
+        });
+
+    progressComplete();
+    return mask_;
+}
+
+auto ConnectedComponents3D::getMask() const -> VolumetricMask::Pointer
+{
+    return mask_;
+}
+
+auto ConnectedComponents3D::numComponents() const -> std::size_t
+{
+    return sizes_.size();
+}
+
+auto ConnectedComponents3D::componentSizes() const
+    -> const std::vector<std::size_t>&
+{
+    return sizes_;
+}
+
+auto ConnectedComponents3D::progressIterations() const -> std::size_t
+{
+    if (not vol_) {
+        return 0;
+    }
+    const auto numSlices = static_cast<std::size_t>(vol_->numSlices());
+    return 2 * ((numSlices + slabSize_ - 1) / slabSize_);
+}
@@ -7,52 +7,74 @@
 
 using namespace volcart::segmentation;
 
+void GenerateTVals(size_t count, std::vector<double>& ts);
 std::vector<double> GenerateTVals(size_t count);
 
 FittedCurve::FittedCurve(const std::vector<Voxel>& vs, int zIndex)
-    : npoints_(vs.size()), zIndex_(zIndex), ts_(GenerateTVals(npoints_))
 {
-    std::vector<double> xs, ys;
-    std::tie(xs, ys) = Unzip(vs);
+    fit(vs, zIndex);
+}
 
-    spline_ = CubicSpline<double>(xs, ys);
+void FittedCurve::fit(const std::vector<Voxel>& vs, int zIndex)
+{
+    npoints_ = vs.size();
+    zIndex_ = zIndex;
+    GenerateTVals(npoints_, ts_);
+
+    xs_.resize(npoints_);
+    ys_.resize(npoints_);
+    for (size_t i = 0; i < npoints_; ++i) {
+        xs_[i] = vs[i][0];
+        ys_[i] = vs[i][1];
+    }
+    spline_.fit(xs_, ys_);
 
     // Calculate new voxel positions from the spline
-    points_.reserve(vs.size());
-    for (const auto t : ts_) {
-        auto p = spline_(t);
-        points_.emplace_back(p(0), p(1), zIndex_);
+    points_.resize(npoints_);
+    for (size_t i = 0; i < npoints_; ++i) {
+        auto p = spline_(ts_[i]);
+        points_[i] = {p(0), p(1), double(zIndex_)};
     }
 }
 
 std::vector<Voxel> FittedCurve::resample(double resamplePerc)
 {
-    npoints_ = size_t(std::round(resamplePerc * npoints_));
-
-    // If we're resampling at 100%, re-use last tvals
-    if (resamplePerc != 1.0) {
-        ts_ = GenerateTVals(npoints_);
+    // If we're resampling at 100%, the points are already sampled at the
+    // last tvals
+    if (resamplePerc == 1.0) {
+        return points_;
     }
 
     // Get new voxel positions
-    points_ = sample(npoints_);
+    npoints_ = size_t(std::round(resamplePerc * npoints_));
+    GenerateTVals(npoints_, ts_);
+    sample(npoints_, points_);
     return points_;
 }
 
 std::vector<Voxel> FittedCurve::sample(size_t numPoints) const
 {
-    std::vector<Voxel> newPoints(numPoints);
-    newPoints.reserve(numPoints);
-    auto ts = GenerateTVals(numPoints);
-    std::transform(
-        std::begin(ts), std::end(ts), std::begin(newPoints),
-        [this](auto t) -> Voxel {
-            auto p = spline_(t);
-            return {p(0), p(1), zIndex_};
-        });
+    std::vector<Voxel> newPoints;
+    sample(numPoints, newPoints);
     return newPoints;
 }
 
+void FittedCurve::sample(size_t numPoints, std::vector<Voxel>& points) const
+{
+    // Same t-values as GenerateTVals()
+    points.resize(numPoints);
+    double t = 0;
+    for (size_t i = 0; i < numPoints; ++i) {
+        if (i + 1 == numPoints) {
+            t = 1;
+        } else if (i > 0) {
+            t += 1.0 / (numPoints - 1);
+        }
+        auto p = spline_(t);
+        points[i] = {p(0), p(1), double(zIndex_)};
+    }
+}
+
 Voxel FittedCurve::operator()(int index) const
 {
     assert(index >= 0 && index < int(ts_.size()) && "out of bounds");
@@ -91,9 +113,9 @@ double FittedCurve::arclength() const
     return length;
 }
 
-std::vector<double> GenerateTVals(size_t count)
+void GenerateTVals(size_t count, std::vector<double>& ts)
 {
-    std::vector<double> ts(count);
+    ts.resize(count);
     if (count > 0) {
         ts[0] = 0;
         double sum = 0;
@@ -102,5 +124,11 @@ std::vector<double> GenerateTVals(size_t count)
         });
         ts.back() = 1;
     }
+}
+
+std::vector<double> GenerateTVals(size_t count)
+{
+    std::vector<double> ts;
+    GenerateTVals(count, ts);
     return ts;
 }
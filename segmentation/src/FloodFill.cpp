@@ -1,5 +1,6 @@
 #include "vc/segmentation/tff/FloodFill.hpp"
 
+#include <cstdint>
 #include <queue>
 #include <unordered_set>
 
@@ -12,14 +13,6 @@ using Voxel = cv::Vec3i;
 using VoxelList = std::vector<cv::Vec3i>;
 using VoxelSet = std::unordered_set<Voxel, Vec3iHash>;
 
-struct VoxelPair {
-    VoxelPair() = default;
-    VoxelPair(const Voxel& v, const Voxel& parent) : v{v}, parent{parent} {}
-
-    Voxel v;
-    Voxel parent;
-};
-
 std::vector<cv::Vec3i> vcs::GetNeighbors(const cv::Vec3i& v)
 {
     return {{v[0] - 1, v[1] - 1, v[2]}, {v[0], v[1] - 1, v[2]},
@@ -90,56 +83,107 @@ size_t vcs::MeasureThickness(
     return length;
 }
 
-VoxelList vcs::DoFloodFill(
-    const VoxelList& pts, int bound, cv::Mat img, uint16_t low, uint16_t high)
+namespace
+{
+// Value of filled pixels in the mask image
+constexpr std::uint8_t FILLED{255};
+
+// Pixel in the fill queue and the index of the seed it was reached from
+struct FillPixel {
+    int x;
+    int y;
+    std::size_t seed;
+};
+
+// Breadth-first flood fill into a dense mask image. The mask doubles as the
+// visited set. Calls visit(x, y, seed) for every filled pixel in fill order.
+template <class Visitor>
+void FloodFillImpl(
+    const VoxelList& pts,
+    int bound,
+    const cv::Mat& img,
+    std::uint16_t low,
+    std::uint16_t high,
+    cv::Mat& mask,
+    Visitor visit)
 {
-    std::queue<VoxelPair> q;
-    VoxelList mask;
-    VoxelSet visited;
+    mask = cv::Mat::zeros(img.size(), CV_8UC1);
+
+    // floor(sqrt(d2)) <= bound if and only if d2 < (bound + 1)^2
+    const auto maxDist = static_cast<std::int64_t>(bound) + 1;
+    const auto maxDist2 = maxDist * maxDist;
 
     // Push all the initial points onto the queue.
     // Initial points are their own 'parents'.
-    for (const auto& pt : pts) {
-        auto greyVal = img.at<uint16_t>(pt[1], pt[0]);
-        if (greyVal >= low && greyVal <= high) {
-            q.emplace(pt, pt);
-            visited.insert(pt);
+    std::queue<FillPixel> q;
+    for (std::size_t idx = 0; idx < pts.size(); idx++) {
+        const auto& pt = pts[idx];
+        if (pt[0] < 0 or pt[0] >= img.cols or pt[1] < 0 or pt[1] >= img.rows) {
+            continue;
+        }
+        auto greyVal = img.at<std::uint16_t>(pt[1], pt[0]);
+        auto& m = mask.at<std::uint8_t>(pt[1], pt[0]);
+        if (greyVal >= low and greyVal <= high and m == 0) {
+            q.push({pt[0], pt[1], idx});
+            m = FILLED;
         }
     }
 
-    while (!q.empty()) {
-        // Pick a VoxelPair off the queue
-        auto pair = q.front();
+    while (not q.empty()) {
+        auto p = q.front();
         q.pop();
+        visit(p.x, p.y, p.seed);
 
-        //'color'/record that cv::Vec3i as part of the mask
-        mask.push_back(pair.v);
-
-        // check neighbors; if they're valid according to the user-defined
-        // threshold AND they are not outside the original(/parent) seed point's
-        // boundary, add them to the queue
-        for (const auto& neighbor : GetNeighbors(pair.v)) {
-            // Make sure this cv::Vec3i hasn't already been added to the
-            // visited list: (We don't want to add it to the queue
-            // twice...)
-            if (visited.find(neighbor) != visited.end()) {
-                continue;
-            }
-
-            // Make sure this neighbor is in the image bounds
-            if (neighbor[0] < 0 or neighbor[0] >= img.cols or neighbor[1] < 0 or
-                neighbor[1] >= img.rows) {
+        // Check the 8-connected neighbors in the same order as GetNeighbors()
+        const auto& seed = pts[p.seed];
+        for (int dy = -1; dy <= 1; dy++) {
+            auto y = p.y + dy;
+            if (y < 0 or y >= img.rows) {
                 continue;
             }
-
-            // Add the valid neighbor to the queue and mark it as visited.
-            auto val = img.at<uint16_t>(neighbor[1], neighbor[0]);
-            auto dist = EuclideanDistance(neighbor, pair.parent);
-            if (val >= low && val <= high && dist <= bound) {
-                q.emplace(neighbor, pair.parent);
-                visited.insert(neighbor);
+            const auto* imgRow = img.ptr<std::uint16_t>(y);
+            auto* maskRow = mask.ptr<std::uint8_t>(y);
+            auto sy = static_cast<std::int64_t>(y - seed[1]);
+            for (int dx = -1; dx <= 1; dx++) {
+                auto x = p.x + dx;
+                if ((dx == 0 and dy == 0) or x < 0 or x >= img.cols or
+                    maskRow[x] != 0) {
+                    continue;
+                }
+                auto val = imgRow[x];
+                auto sx = static_cast<std::int64_t>(x - seed[0]);
+                if (val >= low and val <= high and
+                    sx * sx + sy * sy < maxDist2) {
+                    q.push({x, y, p.seed});
+                    maskRow[x] = FILLED;
+                }
             }
         }
     }
+}
+}  // namespace
+
+VoxelList vcs::DoFloodFill(
+    const VoxelList& pts, int bound, cv::Mat img, uint16_t low, uint16_t high)
+{
+    VoxelList filled;
+    cv::Mat mask;
+    FloodFillImpl(
+        pts, bound, img, low, high, mask,
+        [&filled, &pts](int x, int y, std::size_t seed) {
+            filled.emplace_back(x, y, pts[seed][2]);
+        });
+    return filled;
+}
+
+cv::Mat vcs::FloodFillMask(
+    const VoxelList& pts,
+    int bound,
+    const cv::Mat& img,
+    uint16_t low,
+    uint16_t high)
+{
+    cv::Mat mask;
+    FloodFillImpl(pts, bound, img, low, high, mask, [](int, int, auto) {});
     return mask;
-}
\ No newline at end of file
+}
@@ -1,27 +1,70 @@
 #include "vc/segmentation/stps/ForceChain.hpp"
 
+#include <cfloat>
+#include <cmath>
+#include <stdexcept>
+
 using namespace volcart::segmentation;
 namespace vcs = volcart::segmentation;
 
+ForceChain::ForceChain(const Chain& c)
+{
+    x_.reserve(c.size());
+    y_.reserve(c.size());
+    z_.reserve(c.size());
+    for (const auto& f : c) {
+        push_back(f);
+    }
+}
+
 ForceChain& ForceChain::operator+=(const ForceChain& rhs)
 {
-    if (data_.size() != rhs.size()) {
+    return addScaled(rhs, 1.0);
+}
+
+ForceChain& ForceChain::operator*=(const double& rhs)
+{
+    const auto n = size();
+    for (size_t i = 0; i < n; i++) {
+        x_[i] *= rhs;
+        y_[i] *= rhs;
+        z_[i] *= rhs;
+    }
+
+    return *this;
+}
+
+ForceChain& ForceChain::addScaled(const ForceChain& rhs, double s)
+{
+    if (size() != rhs.size()) {
         throw std::domain_error("Vector sizes don't match");
     }
 
-    auto fIt = rhs.begin();
-    std::for_each(
-        data_.begin(), data_.end(), [&fIt](Force& f) { f += *fIt++; });
+    const auto n = size();
+    const auto* rx = rhs.x();
+    const auto* ry = rhs.y();
+    const auto* rz = rhs.z();
+    for (size_t i = 0; i < n; i++) {
+        x_[i] += s * rx[i];
+        y_[i] += s * ry[i];
+        z_[i] += s * rz[i];
+    }
 
     return *this;
 }
 
-ForceChain& ForceChain::operator*=(const double& rhs)
+void ForceChain::resize(size_t n)
 {
-    std::for_each(
-        std::begin(data_), std::end(data_), [rhs](Force& p) { p *= rhs; });
+    x_.resize(n, 0);
+    y_.resize(n, 0);
+    z_.resize(n, 0);
+}
 
-    return *this;
+void ForceChain::clear()
+{
+    x_.clear();
+    y_.clear();
+    z_.clear();
 }
 
 ForceChain vcs::operator+(ForceChain lhs, const ForceChain& rhs)
@@ -41,6 +84,15 @@ ForceChain vcs::operator*(const double& rhs, ForceChain lhs)
 
 void ForceChain::Normalize(ForceChain& c, double alpha)
 {
-    std::for_each(
-        c.begin(), c.end(), [alpha](auto& f) { cv::normalize(f, f, alpha); });
-}
\ No newline at end of file
+    const auto n = c.size();
+    auto* x = c.x();
+    auto* y = c.y();
+    auto* z = c.z();
+    for (size_t i = 0; i < n; i++) {
+        const auto norm = std::sqrt(x[i] * x[i] + y[i] * y[i] + z[i] * z[i]);
+        const auto scale = norm > DBL_EPSILON ? alpha / norm : 0.0;
+        x[i] *= scale;
+        y[i] *= scale;
+        z[i] *= scale;
+    }
+}
@@ -0,0 +1,328 @@
+#include "vc/segmentation/lrps/IncrementalEnergy.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <tuple>
+
+#include "vc/segmentation/lrps/Derivative.hpp"
+#include "vc/segmentation/lrps/EnergyMetrics.hpp"
+#include "vc/segmentation/lrps/FittedCurve.hpp"
+#include "vc/segmentation/lrps/Spline.hpp"
+
+using namespace volcart::segmentation;
+
+namespace
+{
+// Chord-length parameterization of a set of points, as used by
+// Eigen::ChordLengths
+void ChordLengths(const std::vector<Voxel>& vs, std::vector<double>& params)
+{
+    params.assign(vs.size(), 0);
+    for (std::size_t i = 1; i < vs.size(); i++) {
+        auto dx = vs[i][0] - vs[i - 1][0];
+        auto dy = vs[i][1] - vs[i - 1][1];
+        params[i] = params[i - 1] + std::sqrt(dx * dx + dy * dy);
+    }
+    for (auto& p : params) {
+        p /= params.back();
+    }
+    if (not params.empty()) {
+        params.front() = 0;
+        params.back() = 1;
+    }
+}
+
+auto ChordLengths(const std::vector<Voxel>& vs) -> std::vector<double>
+{
+    std::vector<double> params;
+    ChordLengths(vs, params);
+    return params;
+}
+
+// Same values as the t-values of FittedCurve
+auto UniformTValues(std::size_t count) -> std::vector<double>
+{
+    std::vector<double> ts(count);
+    if (count > 0) {
+        double sum = 0;
+        for (std::size_t i = 1; i + 1 < count; i++) {
+            ts[i] = sum += 1.0 / (count - 1);
+        }
+        ts.back() = 1;
+    }
+    return ts;
+}
+
+// Squared norm of a vector normalized as by NormalizeVector()
+auto NormalizedNorm2(const Voxel& v) -> double
+{
+    auto n = cv::norm(v);
+    if (n < 1e-5) {
+        return n * n;
+    }
+    return std::pow(cv::norm(v / n), 2);
+}
+}  // namespace
+
+IncrementalEnergy::IncrementalEnergy(
+    std::vector<Voxel> vs,
+    int zIndex,
+    double alpha,
+    double k1,
+    double k2,
+    double beta,
+    double delta,
+    std::size_t fitRadius)
+    : zIndex_{zIndex}
+    , alpha_{alpha}
+    , k1_{k1}
+    , k2_{k2}
+    , beta_{beta}
+    , delta_{delta}
+    , radius_{fitRadius}
+    , particles_{std::move(vs)}
+{
+    if (radius_ == 1) {
+        throw std::invalid_argument("fit radius must be 0 or at least 2");
+    }
+
+    FittedCurve curve(particles_, zIndex_);
+    points_ = curve.points();
+    energy_ =
+        EnergyMetrics::TotalEnergy(curve, alpha_, k1_, k2_, beta_, delta_);
+    if (exact_()) {
+        return;
+    }
+
+    params_ = ChordLengths(particles_);
+    ts_ = UniformTValues(points_.size());
+    std::tie(xs_, ys_) = Unzip(points_);
+    aci_.resize(points_.size());
+    curv_.resize(points_.size());
+    seg_.resize(points_.size() - 1);
+    update_terms_(0, points_.size(), true);
+}
+
+auto IncrementalEnergy::energy() const -> double { return energy_; }
+
+auto IncrementalEnergy::particles() const -> const std::vector<Voxel>&
+{
+    return particles_;
+}
+
+auto IncrementalEnergy::points() const -> const std::vector<Voxel>&
+{
+    return points_;
+}
+
+auto IncrementalEnergy::evaluateMove(std::size_t index, const Voxel& v)
+    -> double
+{
+    hasPending_ = false;
+    if (index >= particles_.size()) {
+        throw std::out_of_range("particle index out of range");
+    }
+
+    if (exact_()) {
+        // Refit the whole chain, reusing the buffers of the last refit
+        moved_ = particles_;
+        moved_[index] = v;
+        exactCurve_.fit(moved_, zIndex_);
+        pending_.particle = index;
+        pending_.position = v;
+        pending_.points = exactCurve_.points();
+        pendingEnergy_ = EnergyMetrics::TotalEnergy(
+            exactCurve_, alpha_, k1_, k2_, beta_, delta_);
+        hasPending_ = true;
+        return pendingEnergy_;
+    }
+
+    // Apply the move, measure it, and swap the old state back. Restore the
+    // sums rather than subtracting the new terms so that evaluating a move
+    // leaves the cached energy bit-for-bit unchanged.
+    auto sums = std::make_tuple(aciSum_, curvSum_, segSum_);
+    local_move_(index, v, pending_);
+    swap_(pending_);
+    pendingEnergy_ = energy_from_sums_();
+    swap_(pending_);
+    std::tie(aciSum_, curvSum_, segSum_) = sums;
+    hasPending_ = true;
+    return pendingEnergy_;
+}
+
+void IncrementalEnergy::acceptMove()
+{
+    if (not hasPending_) {
+        return;
+    }
+    hasPending_ = false;
+
+    if (exact_()) {
+        particles_[pending_.particle] = pending_.position;
+        std::swap(points_, pending_.points);
+    } else {
+        swap_(pending_);
+    }
+    energy_ = pendingEnergy_;
+}
+
+auto IncrementalEnergy::exact_() const -> bool
+{
+    return radius_ == 0 or particles_.size() <= 2 * radius_ + 1;
+}
+
+void IncrementalEnergy::local_move_(
+    std::size_t index, const Voxel& v, Move& move)
+{
+    move.particle = index;
+    move.position = v;
+    move.params.clear();
+    move.points.clear();
+
+    // Fit a spline to the window of particles around the moved particle
+    auto last = particles_.size() - 1;
+    auto first = index > radius_ ? index - radius_ : 0;
+    auto end = std::min(index + radius_, last);
+    window_.assign(particles_.begin() + first, particles_.begin() + end + 1);
+    window_[index - first] = v;
+    windowXs_.resize(window_.size());
+    windowYs_.resize(window_.size());
+    for (std::size_t i = 0; i < window_.size(); i++) {
+        windowXs_[i] = window_[i][0];
+        windowYs_[i] = window_[i][1];
+    }
+    windowSpline_.fit(windowXs_, windowYs_);
+
+    // Rescale the window's own chord-length parameters into the range of
+    // the window in the full chain. The end particles keep their parameters.
+    auto u0 = params_[first];
+    auto u1 = params_[end];
+    auto& local = windowParams_;
+    ChordLengths(window_, local);
+    move.firstParam = first + 1;
+    for (std::size_t i = 1; i + 1 < local.size(); i++) {
+        move.params.push_back(u0 + (u1 - u0) * local[i]);
+    }
+
+    // Replace the points in the inner half of the window. The ends of the
+    // local spline are free, so points near them do not match the full fit.
+    // Nothing is replaced at the ends of the chain, which are free as well.
+    auto margin = radius_ / 2;
+    auto lo = first == 0 ? 0.0 : move.params[margin - 1];
+    auto hi = end == last ? 1.0 : move.params[local.size() - 2 - margin];
+    auto p0 = std::lower_bound(ts_.begin(), ts_.end(), lo);
+    auto p1 = std::upper_bound(ts_.begin(), ts_.end(), hi);
+    move.firstPoint = static_cast<std::size_t>(p0 - ts_.begin());
+    for (auto t = p0; t < p1; t++) {
+        auto s = std::clamp((*t - u0) / (u1 - u0), 0.0, 1.0);
+        auto p = windowSpline_(s);
+        move.points.emplace_back(p(0), p(1), zIndex_);
+    }
+}
+
+void IncrementalEnergy::swap_(Move& move)
+{
+    std::swap(particles_[move.particle], move.position);
+    std::swap_ranges(
+        move.params.begin(), move.params.end(),
+        params_.begin() + move.firstParam);
+
+    auto first = move.firstPoint;
+    auto last = first + move.points.size();
+    update_terms_(first, last, false);
+    for (std::size_t i = first; i < last; i++) {
+        std::swap(points_[i], move.points[i - first]);
+        xs_[i] = points_[i][0];
+        ys_[i] = points_[i][1];
+    }
+    update_terms_(first, last, true);
+}
+
+void IncrementalEnergy::update_terms_(
+    std::size_t first, std::size_t last, bool add)
+{
+    if (first >= last) {
+        return;
+    }
+
+    // Derivatives use at most two neighbors on each side
+    auto size = points_.size();
+    auto dFirst = first > 2 ? first - 2 : 0;
+    auto dLast = std::min(last + 2, size);
+    for (auto i = dFirst; i < dLast; i++) {
+        if (add) {
+            auto idx = static_cast<int>(i);
+            aci_[i] = k1_ * NormalizedNorm2(D1At(points_, idx)) +
+                      k2_ * NormalizedNorm2(D2At(points_, idx));
+
+            // See FittedCurve::curvature()
+            auto dx1 = D1At(xs_, idx);
+            auto dy1 = D1At(ys_, idx);
+            auto dx2 = D2At(xs_, idx);
+            auto dy2 = D2At(ys_, idx);
+            curv_[i] = std::abs(
+                (dx1 * dy2 - dy1 * dx2) /
+                std::pow(dx1 * dx1 + dy1 * dy1, 3.0 / 2.0));
+        }
+
+        auto sign = add ? 1.0 : -1.0;
+        aciSum_ += sign * aci_[i];
+        if (std::isnan(curv_[i])) {
+            nanCurv_ = add ? nanCurv_ + 1 : nanCurv_ - 1;
+            continue;
+        }
+        curvSum_ += sign * curv_[i];
+        // Recycle the nodes of removed curvatures
+        if (add and curvNodes_.empty()) {
+            sortedCurv_.insert(curv_[i]);
+        } else if (add) {
+            curvNodes_.back().value() = curv_[i];
+            sortedCurv_.insert(std::move(curvNodes_.back()));
+            curvNodes_.pop_back();
+        } else {
+            curvNodes_.push_back(
+                sortedCurv_.extract(sortedCurv_.find(curv_[i])));
+        }
+    }
+
+    // Segments which end at a changed point
+    auto sFirst = first > 0 ? first - 1 : 0;
+    auto sLast = std::min(last, size - 1);
+    for (auto i = sFirst; i < sLast; i++) {
+        if (add) {
+            seg_[i] = cv::norm(points_[i], points_[i + 1]);
+            segSum_ += seg_[i];
+        } else {
+            segSum_ -= seg_[i];
+        }
+    }
+}
+
+auto IncrementalEnergy::energy_from_sums_() const -> double
+{
+    auto n = static_cast<double>(points_.size());
+    auto intE = aciSum_ / (2 * n);
+
+    // AbsCurvatureSum() normalizes the curvatures to [0, 1] unless they are
+    // already in that range
+    auto kE = std::numeric_limits<double>::quiet_NaN();
+    if (nanCurv_ == 0) {
+        auto min = *sortedCurv_.begin();
+        auto max = *sortedCurv_.rbegin();
+        if (max <= 1) {
+            kE = curvSum_ / n;
+        } else {
+            kE = (curvSum_ - n * min) / (max - min) / n;
+        }
+    }
+
+    // WindowedArcLength(3) counts every segment twice, except for the end
+    // segments, which are counted three times
+    auto sum = 2 * segSum_ + seg_.front() + seg_.back();
+    auto avgDist = segSum_ / (n - 1);
+    auto sE = sum / avgDist / n;
+
+    return alpha_ * intE + beta_ * kE + delta_ * sE;
+}
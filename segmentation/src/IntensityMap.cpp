@@ -1,3 +1,6 @@
+#include <algorithm>
+#include <array>
+#include <cfloat>
 #include <limits>
 
 #include <opencv2/core.hpp>
@@ -7,25 +10,99 @@
 
 using namespace volcart::segmentation;
 
+namespace
+{
+// Number of 8-bit intensity bins
+constexpr int NUM_BINS{std::numeric_limits<uint8_t>::max() + 1};
+
+// Map a 16-bit intensity to the nearest 8-bit intensity, matching
+// cv::Mat::convertTo with a scale factor of 1/255
+inline auto ToBin(uint16_t v) -> uint8_t
+{
+    constexpr int MAX = std::numeric_limits<uint8_t>::max();
+    return static_cast<uint8_t>(std::min((v + MAX / 2) / MAX, MAX));
+}
+
+// Intensities which are already 8-bit bins
+inline auto ToBin(uint8_t v) -> uint8_t { return v; }
+
+// Add the 8-bit bin of every pixel to a histogram
+template <typename T>
+void AccumulateBins(const cv::Mat& r, std::array<int, NUM_BINS>& hist)
+{
+    for (int y = 0; y < r.rows; ++y) {
+        const auto* src = r.ptr<T>(y);
+        for (int x = 0; x < r.cols; ++x) {
+            hist[ToBin(src[x])]++;
+        }
+    }
+}
+}  // namespace
+
 IntensityMap::IntensityMap(
     cv::Mat r, int stepSize, int peakDistanceWeight, bool shouldIncludeMiddle)
     : stepSize_(stepSize)
     , peakDistanceWeight_(peakDistanceWeight)
     , displayWidth_(200)
     , displayHeight_(200)
-    , drawTarget_(displayWidth_, displayHeight_, CV_8UC3, BGR_BLACK)
     , chosenMaximaIndex_(-1)
     , shouldIncludeMiddle_(shouldIncludeMiddle)
 {
     assert(r.rows > 2);
-    // DEBUG - need to convert to 8 bit before we can do anything
-    r.convertTo(r, CV_8UC1, 1.0 / std::numeric_limits<uint8_t>::max());
-    cv::equalizeHist(r, r);
-    resliceData_ = r;
-
-    cv::Mat normReslice(r.rows, r.cols, CV_64F);
-    cv::normalize(r, normReslice, 0, 1, cv::NORM_MINMAX, CV_64F);
-    intensities_ = normReslice.row(normReslice.rows / 2 + stepSize);
+
+    // Histogram equalize and normalize the reslice to [0, 1], but only
+    // compute the values of the selected row. The selected row depends on
+    // the histogram of the whole reslice, which is gathered directly from the
+    // 16-bit intensities without converting the reslice. Other types are
+    // converted to 8-bit bins first.
+    std::array<int, NUM_BINS> hist{};
+    cv::Mat bins = r;
+    const bool is16 = r.type() == CV_16UC1;
+    if (is16) {
+        AccumulateBins<uint16_t>(bins, hist);
+    } else {
+        cv::Mat converted;
+        r.convertTo(
+            converted, CV_8UC1, 1.0 / std::numeric_limits<uint8_t>::max());
+        bins = converted;
+        AccumulateBins<uint8_t>(bins, hist);
+    }
+
+    // Equalization lookup table. Matches cv::equalizeHist.
+    std::array<uint8_t, NUM_BINS> lut{};
+    const auto total = static_cast<int>(bins.total());
+    int minBin = 0;
+    while (hist[minBin] == 0) {
+        ++minBin;
+    }
+    int maxBin = NUM_BINS - 1;
+    while (hist[maxBin] == 0) {
+        --maxBin;
+    }
+    if (hist[minBin] == total) {
+        lut.fill(static_cast<uint8_t>(minBin));
+    } else {
+        auto scale = (NUM_BINS - 1.f) / float(total - hist[minBin]);
+        int sum = 0;
+        for (int i = minBin + 1; i < NUM_BINS; ++i) {
+            sum += hist[i];
+            lut[i] = cv::saturate_cast<uint8_t>(float(sum) * scale);
+        }
+    }
+
+    // Min-max normalization. Matches cv::normalize with cv::NORM_MINMAX.
+    const double lo = lut[minBin];
+    const double hi = lut[maxBin];
+    const double scale = hi - lo > DBL_EPSILON ? 1.0 / (hi - lo) : 0.0;
+    const double shift = -lo * scale;
+
+    const int y = bins.rows / 2 + stepSize;
+    intensities_.create(1, bins.cols);
+    for (int x = 0; x < bins.cols; ++x) {
+        auto bin =
+            is16 ? ToBin(bins.at<uint16_t>(y, x)) : bins.at<uint8_t>(y, x);
+        intensities_(x) = lut[bin] * scale + shift;
+    }
     mapWidth_ = intensities_.cols;
     binWidth_ = cvRound(float(displayWidth_) / mapWidth_);
 }
@@ -33,6 +110,7 @@ IntensityMap::IntensityMap(
 cv::Mat IntensityMap::draw()
 {
     // Repaint the drawTarget_ so we don't draw over others
+    drawTarget_.create(displayHeight_, displayWidth_, CV_8UC3);
     drawTarget_ = BGR_BLACK;
 
     // Build intensity map
@@ -85,31 +163,27 @@ cv::Mat IntensityMap::draw()
 // Finds the top 'N' maxima in the row being processed
 std::deque<std::pair<int, double>> IntensityMap::sortedMaxima()
 {
+    // Only maxima within peakRadius_ of the center are candidates
+    const int mid = mapWidth_ / 2;
+    const int first = std::max(1, mid - peakRadius_);
+    const int last = std::min(mapWidth_ - 2, mid + peakRadius_);
+
     bool includesMiddle = false;
     std::deque<std::pair<int, double>> crossings;
-    for (int i = 1; i < intensities_.cols - 1; ++i) {
+    for (int i = first; i <= last; ++i) {
         if (intensities_(i) >= intensities_(i - 1) &&
             intensities_(i) >= intensities_(i + 1)) {
             crossings.emplace_back(i, intensities_(i));
-            if (i == intensities_.cols / 2) {
+            if (i == mid) {
                 includesMiddle = true;
             }
         }
     }
 
-    // Filter out any crossings that are more than N voxels away from the center
-    crossings.erase(
-        std::remove_if(
-            std::begin(crossings), std::end(crossings),
-            [this](auto v) {
-                return std::abs(v.first - mapWidth_ / 2) > peakRadius_;
-            }),
-        std::end(crossings));
-
     // Sort by distance from middle
     std::sort(
         std::begin(crossings), std::end(crossings), [this](auto lhs, auto rhs) {
-            const int centerX = resliceData_.cols / 2;
+            const int centerX = mapWidth_ / 2;
             const auto ldist = std::sqrt(
                 (lhs.first - centerX) * (lhs.first - centerX) +
                 stepSize_ * stepSize_);
@@ -1,7 +1,11 @@
+#include <atomic>
 #include <deque>
+#include <exception>
+#include <future>
 #include <iomanip>
 #include <limits>
 #include <list>
+#include <optional>
 #include <tuple>
 
 #include <opencv2/core.hpp>
@@ -11,11 +15,12 @@
 
 #include "vc/core/filesystem.hpp"
 #include "vc/core/math/StructureTensor.hpp"
+#include "vc/core/util/ThreadPool.hpp"
 #include "vc/segmentation/LocalResliceParticleSim.hpp"
 #include "vc/segmentation/lrps/Common.hpp"
 #include "vc/segmentation/lrps/Derivative.hpp"
-#include "vc/segmentation/lrps/EnergyMetrics.hpp"
 #include "vc/segmentation/lrps/FittedCurve.hpp"
+#include "vc/segmentation/lrps/IncrementalEnergy.hpp"
 #include "vc/segmentation/lrps/IntensityMap.hpp"
 
 using namespace volcart::segmentation;
@@ -23,6 +28,9 @@ namespace fs = volcart::filesystem;
 using std::begin;
 using std::end;
 
+// Number of particle batches per worker thread
+static constexpr std::size_t BATCHES_PER_THREAD{4};
+
 size_t LocalResliceSegmentation::progressIterations() const
 {
     auto minZPoint = std::min_element(
@@ -74,11 +82,34 @@ LocalResliceSegmentation::PointSet LocalResliceSegmentation::compute()
     points.reserve(
         (endIndex_ - startIndex + 1) / static_cast<uint64_t>(stepSize_));
     points.push_back(currentVs);
+    chainUpdated(currentVs);
+
+    // Buffers reused by every iteration. They grow to fit the largest chain,
+    // after which iterations don't reallocate them.
+    FittedCurve currentCurve;
+    std::vector<std::vector<Voxel>> nextPositions;
+    std::vector<std::size_t> nextCandidate;
+    std::vector<Voxel> nextVs;
+    std::vector<std::pair<int, double>> pairs;
+    std::vector<double> normDeriv2;
+
+    // Squared norm of the second derivative of nextVs at index i
+    auto sqD2At = [&nextVs](std::size_t i) {
+        auto d = D2At(nextVs, static_cast<int>(i));
+        return cv::norm(d) * cv::norm(d);
+    };
 
     // Iterate over z-slices
     auto stepSize = static_cast<int>(stepSize_);
     size_t iteration{0};
     for (int zIndex = startIndex; zIndex < endIndex_; zIndex += stepSize) {
+        // Stop with the rows computed so far if cancelled
+        if (cancelRequested()) {
+            status_ = Status::Cancelled;
+            progressComplete();
+            return create_final_pointset_(points);
+        }
+
         // Update progress
         progressUpdated(iteration++);
 
@@ -90,8 +121,9 @@ LocalResliceSegmentation::PointSet LocalResliceSegmentation::compute()
 
         //////////////////////////////////////////////////////////
         // 0. Resample current positions so they are evenly spaced
-        FittedCurve currentCurve(currentVs, zIndex);
-        currentVs = currentCurve.evenlySpacePoints();
+        currentCurve.fit(currentVs, zIndex);
+        currentVs.assign(
+            currentCurve.points().begin(), currentCurve.points().end());
 
         // Dump entire curve for easy viewing
         if (dumpVis_) {
@@ -106,59 +138,33 @@ LocalResliceSegmentation::PointSet LocalResliceSegmentation::compute()
 
         /////////////////////////////////////////////////////////
         // 1. Generate all candidate positions for all particles
-        std::vector<std::deque<Voxel>> nextPositions;
-        nextPositions.reserve(currentCurve.size());
-        // XXX DEBUG
-        std::vector<IntensityMap> maps;
-        std::vector<Reslice> reslices;
-        maps.reserve(currentCurve.size());
-        reslices.reserve(currentCurve.size());
-        // XXX DEBUG
-        for (int i = 0; i < int(currentCurve.size()); ++i) {
-            // Estimate normal and reslice along it
-            const auto normal = estimate_normal_at_index_(currentCurve, i);
-            const auto reslice = vol_->reslice(
-                currentCurve(i), normal, {0, 0, 1}, resliceSize_, resliceSize_);
-            reslices.push_back(reslice);
-            auto resliceIntensities = reslice.sliceData();
-
-            // Make the intensity map `stepSize_` layers down from current
-            // position and find the maxima
-            const cv::Point2i center{
-                resliceIntensities.cols / 2, resliceIntensities.rows / 2};
-            const int nextLayerIndex = center.y + static_cast<int>(stepSize_);
-            IntensityMap map(
-                resliceIntensities, static_cast<int>(stepSize_),
-                peakDistanceWeight_, considerPrevious_);
-            const auto allMaxima = map.sortedMaxima();
-            maps.push_back(map);
-
-            // Handle case where there's no maxima - go straight down
-            if (allMaxima.empty()) {
-                nextPositions.emplace_back(
-                    std::deque<Voxel>{reslice.sliceToVoxelCoord<int>(
-                        {center.x, nextLayerIndex})});
-                continue;
-            }
-
-            // Convert maxima to voxel positions
-            std::deque<Voxel> maximaQueue;
-            for (auto&& maxima : allMaxima) {
-                maximaQueue.emplace_back(reslice.sliceToVoxelCoord<double>(
-                    {maxima.first, nextLayerIndex}));
-            }
-            nextPositions.push_back(maximaQueue);
+        // Reslices and intensity maps are only kept for dumping
+        nextPositions.resize(currentCurve.size());
+        for (auto& candidates : nextPositions) {
+            candidates.clear();
+        }
+        std::vector<std::optional<IntensityMap>> maps;
+        std::vector<std::optional<Reslice>> reslices;
+        if (dumpVis_) {
+            maps.resize(currentCurve.size());
+            reslices.resize(currentCurve.size());
         }
+        generate_candidates_(currentCurve, nextPositions, maps, reslices);
 
         /////////////////////////////////////////////////////////
         // 2. Construct initial guess using top maxima for each next position
-        std::vector<Voxel> nextVs;
-        nextVs.reserve(currentVs.size());
+        // Each particle's candidates are consumed in order from nextCandidate
+        nextVs.clear();
+        nextCandidate.assign(nextPositions.size(), 0);
         for (int i = 0; i < int(nextPositions.size()); ++i) {
             nextVs.push_back(nextPositions[i].front());
-            maps[i].setChosenMaximaIndex(0);
+            if (dumpVis_) {
+                maps[i]->setChosenMaximaIndex(0);
+            }
         }
-        FittedCurve nextCurve(nextVs, zIndex + 1);
+        IncrementalEnergy energy(
+            nextVs, zIndex + 1, alpha_, k1_, k2_, beta_, delta_,
+            energyFitRadius_);
 
         // Calculate energy of the current curve
         double minEnergy = std::numeric_limits<double>::max();
@@ -171,9 +177,6 @@ LocalResliceSegmentation::PointSet LocalResliceSegmentation::compute()
 
         /////////////////////////////////////////////////////////
         // 3. Optimize
-        std::vector<int> indices(currentVs.size());
-        std::iota(begin(indices), end(indices), 0);
-
         // - Go until either some hard limit or change in energy is minimal
         int n = 0;
 
@@ -191,7 +194,10 @@ LocalResliceSegmentation::PointSet LocalResliceSegmentation::compute()
             }
 
             // - Sort paired index-Voxel in increasing local internal energy
-            auto pairs = Zip(indices, SquareDiff(currentVs, nextVs));
+            pairs.clear();
+            for (int i = 0; i < int(currentVs.size()); ++i) {
+                pairs.emplace_back(i, cv::norm(currentVs[i], nextVs[i]));
+            }
             std::sort(begin(pairs), end(pairs), [](auto p1, auto p2) {
                 return p1.second < p2.second;
             });
@@ -209,20 +215,20 @@ LocalResliceSegmentation::PointSet LocalResliceSegmentation::compute()
                 // Go through each combination for the maximal difference
                 // particle, iterate until you find a new optimum or don't find
                 // anything.
-                while (!nextPositions[maxDiffIdx].empty()) {
-                    std::vector<Voxel> combVs(begin(nextVs), end(nextVs));
-                    combVs[maxDiffIdx] = nextPositions[maxDiffIdx].front();
-                    nextPositions[maxDiffIdx].pop_front();
-                    FittedCurve combCurve(combVs, zIndex + 1);
+                const auto& candidates = nextPositions[maxDiffIdx];
+                auto& cursor = nextCandidate[maxDiffIdx];
+                while (cursor < candidates.size()) {
+                    auto candidate = candidates[cursor++];
 
                     // Found a new optimum?
-                    double newE = EnergyMetrics::TotalEnergy(
-                        combCurve, alpha_, k1_, k2_, beta_, delta_);
+                    double newE = energy.evaluateMove(maxDiffIdx, candidate);
                     if (newE < minEnergy) {
                         minEnergy = newE;
-                        maps[maxDiffIdx].incrementMaximaIndex();
-                        nextVs = combVs;
-                        nextCurve = combCurve;
+                        if (dumpVis_) {
+                            maps[maxDiffIdx]->incrementMaximaIndex();
+                        }
+                        energy.acceptMove();
+                        nextVs[maxDiffIdx] = candidate;
                     }
                 }
                 goto iters_start;
@@ -241,11 +247,10 @@ LocalResliceSegmentation::PointSet LocalResliceSegmentation::compute()
         // their two closest neighbors.
 
         // Take initial second derivative
-        auto secondDeriv = D2(nextVs);
-        std::vector<double> normDeriv2(secondDeriv.size());
-        std::transform(
-            begin(secondDeriv) + 1, end(secondDeriv) - 1, begin(normDeriv2),
-            [](auto d) { return cv::norm(d) * cv::norm(d); });
+        normDeriv2.assign(nextVs.size(), 0);
+        for (std::size_t i = 1; i + 1 < nextVs.size(); ++i) {
+            normDeriv2[i - 1] = sqD2At(i);
+        }
 
         // Don't resettle points at the beginning or end of the chain
         auto maxVal =
@@ -261,10 +266,9 @@ LocalResliceSegmentation::PointSet LocalResliceSegmentation::compute()
             nextVs[i] = newPoint;
 
             // Re-evaluate second derivative of new curve
-            secondDeriv = D2(nextVs);
-            std::transform(
-                begin(secondDeriv), end(secondDeriv), begin(normDeriv2),
-                [](auto d) { return cv::norm(d) * cv::norm(d); });
+            for (std::size_t j = 0; j < nextVs.size(); ++j) {
+                normDeriv2[j] = sqD2At(j);
+            }
 
             // Don't resettle points at the beginning or end of the chain
             maxVal =
@@ -305,8 +309,8 @@ LocalResliceSegmentation::PointSet LocalResliceSegmentation::compute()
             for (size_t i = 0; i < nextVs.size(); ++i) {
                 cv::Mat chain =
                     draw_particle_on_slice_(currentCurve, zIndex, i);
-                cv::Mat resliceMat = reslices[i].draw();
-                cv::Mat map = maps[i].draw();
+                cv::Mat resliceMat = reslices[i]->draw();
+                cv::Mat map = maps[i]->draw();
                 std::stringstream stream;
                 stream << std::setw(nchars) << std::setfill('0') << zIndex
                        << "_" << std::setw(nchars) << std::setfill('0') << i;
@@ -321,6 +325,7 @@ LocalResliceSegmentation::PointSet LocalResliceSegmentation::compute()
         // 5. Set up for next iteration
         currentVs = nextVs;
         points.push_back(nextVs);
+        chainUpdated(nextVs);
     }
 
     /////////////////////////////////////////////////////////
@@ -331,8 +336,113 @@ LocalResliceSegmentation::PointSet LocalResliceSegmentation::compute()
     return create_final_pointset_(points);
 }
 
+auto LocalResliceSegmentation::numThreads() const -> std::size_t
+{
+    if (numThreads_ > 0) {
+        return numThreads_;
+    }
+    return ThreadPool::Global().numThreads();
+}
+
+void LocalResliceSegmentation::generate_candidates_(
+    const FittedCurve& currentCurve,
+    std::vector<std::vector<Voxel>>& nextPositions,
+    std::vector<std::optional<IntensityMap>>& maps,
+    std::vector<std::optional<Reslice>>& reslices) const
+{
+    // Particles are claimed in contiguous batches, and the particles of a
+    // batch are resliced together. Neighboring particles intersect mostly the
+    // same slices, so the batch shares its slice fetches. Several batches per
+    // thread keep the threads balanced.
+    const auto numParticles = currentCurve.size();
+    if (numParticles == 0) {
+        return;
+    }
+    const auto threadCount = std::min(numThreads(), numParticles);
+    const auto batchSize = std::max<std::size_t>(
+        1, numParticles / (threadCount * BATCHES_PER_THREAD));
+    std::atomic<std::size_t> next{0};
+    std::atomic<bool> failed{false};
+    auto work = [&]() {
+        std::vector<Volume::ResliceFrame> frames;
+        for (auto b = next++; b * batchSize < numParticles and not failed;
+             b = next++) {
+            // Estimate normals and reslice along them
+            const auto first = b * batchSize;
+            const auto last = std::min(first + batchSize, numParticles);
+            frames.clear();
+            for (auto i = first; i < last; i++) {
+                const auto idx = static_cast<int>(i);
+                frames.push_back(
+                    {currentCurve(idx),
+                     estimate_normal_at_index_(currentCurve, idx),
+                     {0, 0, 1}});
+            }
+            auto batch = vol_->reslice(frames, resliceSize_, resliceSize_);
+
+            for (auto i = first; i < last; i++) {
+                auto& reslice = batch[i - first];
+                auto resliceIntensities = reslice.sliceData();
+
+                // Make the intensity map `stepSize_` layers down from current
+                // position and find the maxima
+                const cv::Point2i center{
+                    resliceIntensities.cols / 2,
+                    resliceIntensities.rows / 2};
+                const int nextLayerIndex =
+                    center.y + static_cast<int>(stepSize_);
+                IntensityMap map(
+                    resliceIntensities, static_cast<int>(stepSize_),
+                    peakDistanceWeight_, considerPrevious_);
+                const auto allMaxima = map.sortedMaxima();
+
+                // Handle case where there's no maxima - go straight down
+                auto& candidates = nextPositions[i];
+                if (allMaxima.empty()) {
+                    candidates.emplace_back(reslice.sliceToVoxelCoord<int>(
+                        {center.x, nextLayerIndex}));
+                }
+
+                // Convert maxima to voxel positions
+                for (auto&& maxima : allMaxima) {
+                    candidates.emplace_back(reslice.sliceToVoxelCoord<double>(
+                        {maxima.first, nextLayerIndex}));
+                }
+
+                if (not maps.empty()) {
+                    maps[i].emplace(std::move(map));
+                    reslices[i].emplace(std::move(reslice));
+                }
+            }
+        }
+    };
+
+    // Run the workers and rethrow the first error
+    std::vector<std::exception_ptr> errors(threadCount);
+    auto& pool = ThreadPool::Global();
+    std::vector<std::future<void>> workers;
+    for (std::size_t t = 0; t < threadCount; ++t) {
+        workers.emplace_back(pool.submit([&, t]() {
+            try {
+                work();
+            } catch (...) {
+                errors[t] = std::current_exception();
+                failed = true;
+            }
+        }));
+    }
+    for (auto& w : workers) {
+        pool.wait(w);
+    }
+    for (const auto& e : errors) {
+        if (e) {
+            std::rethrow_exception(e);
+        }
+    }
+}
+
 cv::Vec3d LocalResliceSegmentation::estimate_normal_at_index_(
-    const FittedCurve& currentCurve, int index)
+    const FittedCurve& currentCurve, int index) const
 {
     auto currentVoxel = currentCurve(index);
     auto radius = static_cast<int>(
@@ -356,6 +466,7 @@ LocalResliceSegmentation::create_final_pointset_(
     std::vector<cv::Vec3d> tempRow;
     result_.clear();
     result_.setWidth(cols);
+    result_.reserveRows(rows);
 
     for (size_t i = 0; i < rows; ++i) {
         for (size_t j = 0; j < cols; ++j) {
@@ -374,8 +485,8 @@ cv::Mat LocalResliceSegmentation::draw_particle_on_slice_(
     int particleIndex,
     bool showSpline) const
 {
-    auto pkgSlice = vol_->getSliceDataCopy(sliceIndex);
-    pkgSlice.convertTo(
+    cv::Mat pkgSlice;
+    vol_->getSliceView(sliceIndex).mat().convertTo(
         pkgSlice, CV_8UC3, 1.0 / std::numeric_limits<uint8_t>::max());
     cv::cvtColor(pkgSlice, pkgSlice, cv::COLOR_GRAY2BGR);
 
@@ -1,20 +1,28 @@
 #include <algorithm>
+#include <exception>
+#include <future>
 #include <iomanip>
 #include <limits>
-#include <thread>
 #include <tuple>
 
 #include <opencv2/core.hpp>
 #include <opencv2/highgui.hpp>
 #include <opencv2/imgproc.hpp>
 #include <opencv2/video/tracking.hpp>
+#ifdef VC_HAS_OPENCV_CUDA
+#include <opencv2/core/cuda.hpp>
+#include <opencv2/cudaarithm.hpp>
+#include <opencv2/cudaoptflow.hpp>
+#endif
 
 #include "vc/core/filesystem.hpp"
 #include "vc/core/io/ImageIO.hpp"
 #include "vc/core/math/StructureTensor.hpp"
 #include "vc/core/types/Color.hpp"
 #include "vc/core/util/Iteration.hpp"
+#include "vc/core/util/Logging.hpp"
 #include "vc/core/util/String.hpp"
+#include "vc/core/util/ThreadPool.hpp"
 #include "vc/segmentation/OpticalFlowSegmentation.hpp"
 #include "vc/segmentation/lrps/Derivative.hpp"
 #include "vc/segmentation/lrps/FittedCurve.hpp"
@@ -71,8 +79,69 @@ auto IsInBounds(const cv::Point2f& p, const cv::Mat& img)
 {
     return p.x >= 0 and p.x < img.cols and p.y >= 0 and p.y < img.rows;
 }
+
+// Dense Farneback optical flow on the CPU
+void CPUFlow(const cv::Mat& gray1, const cv::Mat& gray2, cv::Mat& flow)
+{
+    cv::calcOpticalFlowFarneback(gray1, gray2, flow, 0.5, 3, 15, 3, 7, 1.2, 0);
+}
+
+// Get a rows x cols image over a reusable storage buffer. The storage only
+// grows, so the image can be written by OpenCV functions without allocating
+// once the storage is as large as the largest image.
+auto ReuseImage(cv::Mat& storage, int rows, int cols, int type) -> cv::Mat
+{
+    const auto bytes = static_cast<std::size_t>(rows) *
+                       static_cast<std::size_t>(cols) * CV_ELEM_SIZE(type);
+    if (storage.total() < bytes) {
+        storage.create(1, static_cast<int>(bytes), CV_8UC1);
+    }
+    return cv::Mat(rows, cols, type, storage.data);
+}
 }  // namespace
 
+struct OpticalFlowSegmentation::GPUSlices {
+#ifdef VC_HAS_OPENCV_CUDA
+    /** Slices at z and z + 1 */
+    cv::cuda::GpuMat slice1, slice2;
+
+    /**
+     * Upload the slices of a step. If `shifted`, the slice at z is the slice
+     * at z + 1 of the last step, which is already on the device.
+     */
+    void upload(const cv::Mat& s1, const cv::Mat& s2, bool shifted)
+    {
+        if (shifted) {
+            std::swap(slice1, slice2);
+        } else {
+            slice1.upload(s1);
+        }
+        slice2.upload(s2);
+    }
+#endif
+};
+
+struct OpticalFlowSegmentation::GPUSegment {
+#ifdef VC_HAS_OPENCV_CUDA
+    /** Same parameters as the CPU cv::calcOpticalFlowFarneback() call */
+    cv::Ptr<cv::cuda::FarnebackOpticalFlow> farneback{
+        cv::cuda::FarnebackOpticalFlow::create(
+            3, 0.5, false, 15, 3, 7, 1.2, 0)};
+    /** Stream of the segment, so that segments run concurrently */
+    cv::cuda::Stream stream;
+    /** Normalized slice ROIs and the flow between them */
+    cv::cuda::GpuMat gray1, gray2, flow;
+
+    /** Compute the flow from gray1 to gray2 and download it */
+    void calc(cv::Mat& out)
+    {
+        farneback->calc(gray1, gray2, flow, stream);
+        flow.download(out, stream);
+        stream.waitForCompletion();
+    }
+#endif
+};
+
 void OpticalFlowSegmentation::setTargetZIndex(int z) { endIndex_ = z; }
 
 void OpticalFlowSegmentation::setOutsideThreshold(std::uint8_t outside)
@@ -108,6 +177,41 @@ void OpticalFlowSegmentation::setMaxThreads(std::uint32_t t)
 
 void OpticalFlowSegmentation::resetMaxThreads() { maxThreads_.reset(); }
 
+void OpticalFlowSegmentation::setSegmentsPerThread(std::uint32_t n)
+{
+    segmentsPerThread_ = std::max(1U, n);
+}
+
+void OpticalFlowSegmentation::setUseGPU(bool b) { useGPU_ = b; }
+
+auto OpticalFlowSegmentation::GPUAvailable() -> bool
+{
+#ifdef VC_HAS_OPENCV_CUDA
+    return cv::cuda::getCudaEnabledDeviceCount() > 0;
+#else
+    return false;
+#endif
+}
+
+auto OpticalFlowSegmentation::OpticalFlow(
+    const cv::Mat& gray1, const cv::Mat& gray2, bool useGPU) -> cv::Mat
+{
+    cv::Mat flow;
+#ifdef VC_HAS_OPENCV_CUDA
+    if (useGPU and GPUAvailable()) {
+        GPUSegment gpu;
+        gpu.gray1.upload(gray1);
+        gpu.gray2.upload(gray2);
+        gpu.calc(flow);
+        return flow;
+    }
+#else
+    static_cast<void>(useGPU);
+#endif
+    ::CPUFlow(gray1, gray2, flow);
+    return flow;
+}
+
 void OpticalFlowSegmentation::setVisualize(bool b) { visualize_ = b; }
 
 void OpticalFlowSegmentation::setDumpVis(bool b) { dumpVis_ = b; }
@@ -122,12 +226,15 @@ auto OpticalFlowSegmentation::progressIterations() const -> size_t
 }
 
 // Multithreaded computation of split curve segment
-auto OpticalFlowSegmentation::compute_curve_(
-    const FittedCurve& currentCurve, int zIndex) -> std::vector<Voxel>
+void OpticalFlowSegmentation::compute_curve_(
+    int zIndex,
+    const cv::Mat& slice1,
+    const cv::Mat& slice2,
+    const GPUSlices* gpuSlices,
+    SegmentBuffers& segment)
 {
-    // Extract 2D image slices at zIndex and zIndex+1
-    const auto slice1 = vol_->getSliceDataCopy(zIndex);
-    const auto slice2 = vol_->getSliceDataCopy(zIndex + 1);
+    segment.curve.fit(segment.points, zIndex);
+    const auto& currentCurve = segment.curve;
 
     // Calculate the bounding box of the curve to define the region of interest
     int xMin = std::numeric_limits<int>::max();
@@ -155,21 +262,42 @@ auto OpticalFlowSegmentation::compute_curve_(
     const cv::Mat roiSlice2 = slice2(roi);
 
     // Convert to grayscale and normalize the slices
-    cv::Mat gray1;
-    cv::Mat gray2;
-    cv::normalize(roiSlice1, gray1, 0, 255, cv::NORM_MINMAX, CV_8UC1);
+    auto gray1 = ::ReuseImage(segment.gray1, roi.height, roi.width, CV_8UC1);
+    auto gray2 = ::ReuseImage(segment.gray2, roi.height, roi.width, CV_8UC1);
+    if (gpuSlices == nullptr) {
+        cv::normalize(roiSlice1, gray1, 0, 255, cv::NORM_MINMAX, CV_8UC1);
+    }
     cv::normalize(roiSlice2, gray2, 0, 255, cv::NORM_MINMAX, CV_8UC1);
-    cv::Mat integralImg;
+    auto integralImg = ::ReuseImage(
+        segment.integral, roi.height + 1, roi.width + 1, CV_32SC1);
     cv::integral(gray2, integralImg, CV_32S);
 
     // Compute dense optical flow using Farneback method
-    cv::Mat flow;
-    cv::calcOpticalFlowFarneback(gray1, gray2, flow, 0.5, 3, 15, 3, 7, 1.2, 0);
+    auto flow = ::ReuseImage(segment.flow, roi.height, roi.width, CV_32FC2);
+#ifdef VC_HAS_OPENCV_CUDA
+    if (gpuSlices != nullptr) {
+        if (not segment.gpu) {
+            segment.gpu = std::make_shared<GPUSegment>();
+        }
+        auto& gpu = *segment.gpu;
+        cv::cuda::normalize(
+            gpuSlices->slice1(roi), gpu.gray1, 0, 255, cv::NORM_MINMAX,
+            CV_8UC1, cv::noArray(), gpu.stream);
+        cv::cuda::normalize(
+            gpuSlices->slice2(roi), gpu.gray2, 0, 255, cv::NORM_MINMAX,
+            CV_8UC1, cv::noArray(), gpu.stream);
+        gpu.calc(flow);
+    } else
+#endif
+    {
+        ::CPUFlow(gray1, gray2, flow);
+    }
 
     // Calculate the average flow around a 5x5 window
     int windowSize = 5;
     const cv::Point2f minPt(static_cast<float>(xMin), static_cast<float>(yMin));
-    std::vector<Voxel> nextVs;
+    auto& nextVs = segment.nextVs;
+    nextVs.clear();
     for (int i = 0; i < currentCurve.size(); ++i) {
         // Get the current point
         auto cp = currentCurve(i);
@@ -248,9 +376,6 @@ auto OpticalFlowSegmentation::compute_curve_(
             nextVs[i] = Voxel(proj[0], proj[1], zIndex + 1);
         }
     }
-
-    // Return the updated vector of Voxel points
-    return nextVs;
 }
 
 auto OpticalFlowSegmentation::compute() -> PointSet
@@ -295,12 +420,41 @@ auto OpticalFlowSegmentation::compute() -> PointSet
     points.reserve(
         (endIndex_ - startIndex + 1) / static_cast<std::size_t>(stepSize_));
     points.push_back(currentVs);
+    chainUpdated(currentVs);
+
+    // Rolling two-slice cache. When stepping by one slice, the next slice
+    // of this step is the current slice of the next step.
+    int cachedZ{-1};
+    SliceView cachedSlice;
+
+    // Slices resident on the GPU, if computing flow there
+    std::unique_ptr<GPUSlices> gpuSlices;
+    if (useGPU_ and GPUAvailable()) {
+        gpuSlices = std::make_unique<GPUSlices>();
+    } else if (useGPU_) {
+        Logger()->warn(
+            "GPU optical flow is not available. Computing flow on the CPU.");
+    }
+
+    // Buffers reused by every iteration
+    FittedCurve currentCurve;
+    std::vector<SegmentBuffers> segments;
+    std::vector<Voxel> stitched;
+    FittedCurve stitchedFittedCurve;
+    std::vector<Voxel> nextVs;
 
     // Iterate over z-slices
     std::size_t iteration{0};
     auto stepSize = static_cast<int>(stepSize_);
     const int padding = vol_->numSlices();
     for (int zIndex = startIndex; zIndex < endIndex_; zIndex += stepSize) {
+        // Stop with the rows computed so far if cancelled
+        if (cancelRequested()) {
+            status_ = Status::Cancelled;
+            progressComplete();
+            return create_final_pointset_(points);
+        }
+
         // Update progress
         progressUpdated(iteration++);
 
@@ -310,8 +464,9 @@ auto OpticalFlowSegmentation::compute() -> PointSet
 
         //////////////////////////////////////////////////////////
         // 0. Resample current positions so they are evenly spaced
-        FittedCurve currentCurve(currentVs, zIndex);
-        currentVs = currentCurve.evenlySpacePoints();
+        currentCurve.fit(currentVs, zIndex);
+        currentVs.assign(
+            currentCurve.points().begin(), currentCurve.points().end());
 
         // Dump entire curve for easy viewing
         if (dumpVis_) {
@@ -322,79 +477,106 @@ auto OpticalFlowSegmentation::compute() -> PointSet
         }
 
         // Set up the maximum number of threads
-        auto maxThreads = std::thread::hardware_concurrency() - 1;
+        auto& pool = ThreadPool::Global();
+        auto maxThreads = static_cast<std::uint32_t>(pool.numThreads());
         if (maxThreads_.has_value()) {
             maxThreads = std::min(maxThreads, maxThreads_.value());
         }
 
-        // Calculate the num threads we're going to use
-        const std::uint32_t minPointsPerThread{15};
+        // Calculate the num segments we're going to use
+        const std::uint32_t minPointsPerSegment{15};
         const auto numPts = currentVs.size();
-        const auto ptsPerThread = static_cast<std::uint32_t>(std::floor(
+        const auto maxSegments = static_cast<std::uint32_t>(std::floor(
             static_cast<float>(numPts) /
-            static_cast<float>(minPointsPerThread)));
-        const auto numThreads =
-            std::max(1U, std::min(ptsPerThread, maxThreads));
+            static_cast<float>(minPointsPerSegment)));
+        const auto numSegments = std::max(
+            1U, std::min(maxSegments, maxThreads * segmentsPerThread_));
         const auto baseSegmentLength = static_cast<std::uint32_t>(std::floor(
-            static_cast<float>(numPts) / static_cast<float>(numThreads)));
-        const auto numThreadsWithExtraPoint = numPts % numThreads;
+            static_cast<float>(numPts) / static_cast<float>(numSegments)));
+        const auto numSegmentsWithExtraPoint = numPts % numSegments;
 
         // Parallel computation of curve segments
-        std::vector<std::vector<Voxel>> subsegmentVectors;
+        if (segments.size() < numSegments) {
+            segments.resize(numSegments);
+        }
         std::size_t startIdx{0};
-        for (const auto& i : range(numThreads)) {
+        for (const auto& i : range(numSegments)) {
             auto segmentLength =
-                baseSegmentLength + (i < numThreadsWithExtraPoint ? 1 : 0);
+                baseSegmentLength + (i < numSegmentsWithExtraPoint ? 1 : 0);
             auto endIdx = startIdx + segmentLength;
 
             // Change start_idx and end_idx to include overlap
             auto startIdxPadded =
                 static_cast<std::int64_t>((i == 0) ? 0 : (startIdx - 2));
             auto endIdxPadded = static_cast<std::int64_t>(
-                (i == numThreads - 1) ? numPts : (endIdx + 2));
+                (i == numSegments - 1) ? numPts : (endIdx + 2));
 
             // Copy from currentVs to our vector
             auto startIt = std::next(currentVs.begin(), startIdxPadded);
             auto endIt = std::next(currentVs.begin(), endIdxPadded);
-            subsegmentVectors.emplace_back(startIt, endIt);
+            segments[i].points.assign(startIt, endIt);
             startIdx = endIdx;
         }
 
-        // Initialize the threads
-        std::vector<std::thread> threads;
-        std::vector<std::vector<Voxel>> subsegmentPoints(numThreads);
-        for (const auto& i : range(numThreads)) {
-            threads.emplace_back(
-                [this, &subsegmentVectors, &zIndex, &subsegmentPoints, i]() {
-                    const Chain subsegmentChain(subsegmentVectors[i]);
-                    const FittedCurve curve(subsegmentChain, zIndex);
-                    subsegmentPoints[i] = compute_curve_(curve, zIndex);
-                });
+        // Load the slices once and share them between segments
+        const auto shifted = zIndex == cachedZ;
+        const auto slice1 =
+            shifted ? cachedSlice : vol_->getSliceView(zIndex);
+        const auto slice2 = vol_->getSliceView(zIndex + 1);
+        cachedZ = zIndex + 1;
+        cachedSlice = slice2;
+#ifdef VC_HAS_OPENCV_CUDA
+        if (gpuSlices) {
+            gpuSlices->upload(slice1, slice2, shifted);
+        }
+#endif
+
+        // Queue the segments on the shared pool. Idle workers steal
+        // segments from busy ones, which balances segments of uneven cost.
+        std::vector<std::future<void>> segmentResults;
+        segmentResults.reserve(numSegments);
+        for (const auto& i : range(numSegments)) {
+            segmentResults.emplace_back(pool.submit([&, zIndex, i]() {
+                compute_curve_(
+                    zIndex, slice1, slice2, gpuSlices.get(), segments[i]);
+            }));
         }
 
-        // Join threads and stitch curve segments together
-        for (auto& thread : threads) {
-            thread.join();
+        // Wait for all segments before rethrowing any errors
+        std::exception_ptr error;
+        for (auto& result : segmentResults) {
+            try {
+                pool.wait(result);
+            } catch (...) {
+                if (not error) {
+                    error = std::current_exception();
+                }
+            }
+        }
+        if (error) {
+            std::rethrow_exception(error);
         }
 
         // Stitch curve segments together, discarding overlapping points
-        std::vector<Voxel> stitched;
-        stitched.reserve(currentVs.size());
-        for (auto [i, segment] : enumerate(subsegmentPoints)) {
+        stitched.clear();
+        for (const auto& i : range(numSegments)) {
+            const auto& segment = segments[i].nextVs;
             auto startIt = segment.begin();
             auto endIt = segment.end();
             if (i > 0) {
                 startIt = std::next(segment.begin(), 2);
             }
-            if (i < numThreads - 1) {
+            if (i < numSegments - 1) {
                 endIt = std::next(segment.end(), -2);
             }
             stitched.insert(stitched.end(), startIt, endIt);
         }
 
         // Generate nextVs by evenly spacing points in the stitched curve
-        FittedCurve stitchedFittedCurve(stitched, zIndex + 1);
-        auto nextVs = stitchedFittedCurve.evenlySpacePoints();
+        stitchedFittedCurve.fit(stitched, zIndex + 1);
+        nextVs.assign(
+            stitchedFittedCurve.points().begin(),
+            stitchedFittedCurve.points().end());
 
         // Check if any points in nextVs are outside volume boundaries. If so,
         // stop iterating and dump the resulting point cloud.
@@ -421,6 +603,7 @@ auto OpticalFlowSegmentation::compute() -> PointSet
         // 5. Set up for next iteration
         currentVs = nextVs;
         points.push_back(nextVs);
+        chainUpdated(nextVs);
     }
 
     /////////////////////////////////////////////////////////
@@ -439,6 +622,7 @@ auto OpticalFlowSegmentation::create_final_pointset_(
     std::vector<cv::Vec3d> tempRow;
     result_.clear();
     result_.setWidth(cols);
+    result_.reserveRows(rows);
 
     for (size_t i = 0; i < rows; ++i) {
         for (size_t j = 0; j < cols; ++j) {
@@ -457,8 +641,8 @@ auto OpticalFlowSegmentation::draw_particle_on_slice_(
     int particleIndex,
     bool showSpline) const -> cv::Mat
 {
-    auto pkgSlice = vol_->getSliceDataCopy(sliceIndex);
-    pkgSlice.convertTo(
+    cv::Mat pkgSlice;
+    vol_->getSliceView(sliceIndex).mat().convertTo(
         pkgSlice, CV_8UC3, 1.0 / std::numeric_limits<uint8_t>::max());
     cv::cvtColor(pkgSlice, pkgSlice, cv::COLOR_GRAY2BGR);
 
@@ -1,29 +1,99 @@
 #include "vc/segmentation/stps/ParticleChain.hpp"
 
+#include <cmath>
 #include <exception>
+#include <stdexcept>
 
 using namespace volcart::segmentation;
 namespace vcs = volcart::segmentation;
 
+ParticleChain::ParticleChain(const Chain& c)
+{
+    for (const auto& p : c) {
+        push_back(p);
+    }
+}
+
 ParticleChain& ParticleChain::operator+=(const ForceChain& rhs)
 {
-    if (data_.size() != rhs.size()) {
+    return addScaled(rhs, 1.0);
+}
+
+ParticleChain& ParticleChain::operator*=(const double& rhs)
+{
+    const auto n = size();
+    for (size_t i = 0; i < n; i++) {
+        x_[i] *= rhs;
+        y_[i] *= rhs;
+        z_[i] *= rhs;
+    }
+
+    return *this;
+}
+
+ParticleChain& ParticleChain::addScaled(const ForceChain& rhs, double s)
+{
+    if (size() != rhs.size()) {
         throw std::domain_error("Vector sizes don't match");
     }
 
-    auto fIt = rhs.begin();
-    std::for_each(
-        data_.begin(), data_.end(), [&fIt](Particle& p) { p += *fIt++; });
+    const auto n = size();
+    const auto* fx = rhs.x();
+    const auto* fy = rhs.y();
+    const auto* fz = rhs.z();
+    for (size_t i = 0; i < n; i++) {
+        x_[i] += s * fx[i];
+        y_[i] += s * fy[i];
+        z_[i] += s * fz[i];
+    }
 
     return *this;
 }
 
-ParticleChain& ParticleChain::operator*=(const double& rhs)
+Particle ParticleChain::operator[](size_t i) const
 {
-    std::for_each(
-        std::begin(data_), std::end(data_), [rhs](Particle& p) { p *= rhs; });
+    Particle p(pos(i));
+    p.restingL() = restingL_[i];
+    p.restingR() = restingR_[i];
+    return p;
+}
 
-    return *this;
+void ParticleChain::updateRestingLengths()
+{
+    const auto n = size();
+    if (n == 0) {
+        return;
+    }
+
+    restingL_[0] = 0;
+    for (size_t i = 1; i < n; i++) {
+        const auto dx = x_[i] - x_[i - 1];
+        const auto dy = y_[i] - y_[i - 1];
+        const auto dz = z_[i] - z_[i - 1];
+        restingL_[i] = std::sqrt(dx * dx + dy * dy + dz * dz);
+    }
+    for (size_t i = 0; i + 1 < n; i++) {
+        restingR_[i] = restingL_[i + 1];
+    }
+    restingR_[n - 1] = 0;
+}
+
+void ParticleChain::push_back(const Particle& val)
+{
+    x_.push_back(val.pos()[0]);
+    y_.push_back(val.pos()[1]);
+    z_.push_back(val.pos()[2]);
+    restingL_.push_back(val.restingL());
+    restingR_.push_back(val.restingR());
+}
+
+void ParticleChain::clear()
+{
+    x_.clear();
+    y_.clear();
+    z_.clear();
+    restingL_.clear();
+    restingR_.clear();
 }
 
 ParticleChain vcs::operator+(ParticleChain lhs, const ForceChain& rhs)
@@ -44,4 +114,4 @@ ParticleChain vcs::operator*(ParticleChain lhs, const double& rhs)
 ParticleChain vcs::operator*(const double& rhs, ParticleChain lhs)
 {
     return lhs *= rhs;
-}
\ No newline at end of file
+}
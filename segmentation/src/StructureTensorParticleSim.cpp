@@ -1,6 +1,10 @@
 #include "vc/segmentation/StructureTensorParticleSim.hpp"
 
+#include <cfloat>
+#include <cmath>
+
 #include "vc/core/math/StructureTensor.hpp"
+#include "vc/core/util/ThreadPool.hpp"
 
 namespace vc = volcart;
 using namespace vc::segmentation;
@@ -24,17 +28,7 @@ StructureTensorParticleSim::PointSet StructureTensorParticleSim::compute()
     }
 
     // Calculate the resting lengths
-    for (auto it = currentChain_.begin(); it != currentChain_.end(); it++) {
-        // Calculate left resting
-        if (it != currentChain_.begin()) {
-            it->restingL() = cv::norm(it->pos() - std::prev(it)->pos());
-        }
-
-        // Calculate right resting
-        if (it != currentChain_.end() - 1) {
-            it->restingR() = cv::norm(std::next(it)->pos() - it->pos());
-        }
-    }
+    currentChain_.updateRestingLengths();
 
     // Reset the result vector and add the starting chain to it
     result_.clear();
@@ -43,6 +37,10 @@ StructureTensorParticleSim::PointSet StructureTensorParticleSim::compute()
     // Other params
     radius_ = static_cast<int>(
         std::ceil(materialThickness_ / vol_->voxelSize()) * 0.5);
+    tensorField_.reset();
+    if (useTensorField_ and not orientationField_) {
+        tensorField_ = vc::StructureTensorField::New(vol_, radius_);
+    }
 
     // Output iterations
     auto outIters = static_cast<size_t>(std::ceil(numSteps_ / stepSize_));
@@ -50,31 +48,34 @@ StructureTensorParticleSim::PointSet StructureTensorParticleSim::compute()
     auto rkIters = static_cast<size_t>(std::ceil(stepSize_ / rkStepSize_));
 
     // Sampled output iterations
+    ParticleChain chain;
+    ForceChain k1, k2, k3, k4;
     for (size_t it = 0; it < outIters; it++) {
         // Update progress
         progressUpdated(it);
 
-        // Run Runge-Kutta multiple times to accumulate one full output step
+        // Run Runge-Kutta multiple times to accumulate one full output step.
+        // The intermediate chains and forces are reused between iterations.
         for (size_t rkIt = 0; rkIt < rkIters; rkIt++) {
             // K1
-            auto chainK1 = currentChain_;
-            auto k1 = calc_prop_forces_(chainK1) + calc_spring_forces_(chainK1);
-            ForceChain::Normalize(k1);
+            calc_forces_(currentChain_, k1);
             // K2
-            auto chainK2 = currentChain_ + (rkStepSize_ * 0.5 * k1);
-            auto k2 = calc_prop_forces_(chainK2) + calc_spring_forces_(chainK2);
-            ForceChain::Normalize(k2);
+            chain = currentChain_;
+            chain.addScaled(k1, rkStepSize_ * 0.5);
+            calc_forces_(chain, k2);
             // K3
-            auto chainK3 = currentChain_ + (rkStepSize_ * 0.5 * k2);
-            auto k3 = calc_prop_forces_(chainK3) + calc_spring_forces_(chainK3);
-            ForceChain::Normalize(k3);
+            chain = currentChain_;
+            chain.addScaled(k2, rkStepSize_ * 0.5);
+            calc_forces_(chain, k3);
             // K4
-            auto chainK4 = currentChain_ + (rkStepSize_ * k3);
-            auto k4 = calc_prop_forces_(chainK4) + calc_spring_forces_(chainK4);
-            ForceChain::Normalize(k4);
-
-            currentChain_ +=
-                (rkStepSize_ * RK_STEP_SCALE * (k1 + (2 * k2) + (2 * k3) + k4));
+            chain = currentChain_;
+            chain.addScaled(k3, rkStepSize_);
+            calc_forces_(chain, k4);
+
+            k1.addScaled(k2, 2);
+            k1.addScaled(k3, 2);
+            k1 += k4;
+            currentChain_.addScaled(k1, rkStepSize_ * RK_STEP_SCALE);
         }
 
         if (chain_stopped_()) {
@@ -84,6 +85,8 @@ StructureTensorParticleSim::PointSet StructureTensorParticleSim::compute()
 
         add_chain_to_result_();
     }
+    tensorField_.reset();
+
     // Update progress
     progressComplete();
 
@@ -92,63 +95,134 @@ StructureTensorParticleSim::PointSet StructureTensorParticleSim::compute()
 
 bool StructureTensorParticleSim::chain_stopped_()
 {
-    return std::any_of(
-        std::begin(currentChain_), std::end(currentChain_), [this](auto v) {
-            return !bb_.isInBounds(v.pos()) || !vol_->isInBounds(v.pos());
-        });
+    for (size_t i = 0; i < currentChain_.size(); i++) {
+        auto p = currentChain_.pos(i);
+        if (!bb_.isInBounds(p) || !vol_->isInBounds(p)) {
+            return true;
+        }
+    }
+    return false;
 }
 
 void StructureTensorParticleSim::add_chain_to_result_()
 {
     std::vector<cv::Vec3d> row;
-    for (const auto& p : currentChain_) {
-        row.emplace_back(p.pos());
+    row.reserve(currentChain_.size());
+    for (size_t i = 0; i < currentChain_.size(); i++) {
+        row.emplace_back(currentChain_.pos(i));
     }
 
     result_.pushRow(row);
 }
 
-ForceChain StructureTensorParticleSim::calc_prop_forces_(ParticleChain c)
+void StructureTensorParticleSim::calc_forces_(
+    const ParticleChain& c, ForceChain& res)
 {
-    ForceChain res;
-    Force zDir{0, 0, 1};
-
-    for (const auto& p : c) {
-        auto ep = ComputeSubvoxelEigenPairs(vol_, p.pos(), radius_);
-        auto offset = ep[0].second;
-        offset = zDir - (zDir.dot(offset)) / (offset.dot(offset)) * offset;
-        cv::normalize(offset, offset);
-        res.push_back(offset * propagationScaleFactor_);
+    res.resize(c.size());
+    calc_prop_forces_(c, res);
+    calc_spring_forces_(c, res);
+    ForceChain::Normalize(res);
+}
+
+void StructureTensorParticleSim::calc_prop_forces_(
+    const ParticleChain& c, ForceChain& res)
+{
+    // Sample the principal directions of every particle at once
+    const auto n = c.size();
+    std::vector<cv::Vec3d> dirs;
+    if (orientationField_ or tensorField_) {
+        positions_.resize(n);
+        for (size_t i = 0; i < n; i++) {
+            positions_[i] = c.pos(i);
+        }
+    }
+    if (orientationField_) {
+        dirs = orientationField_->directionsAt(positions_);
+    } else {
+        std::vector<EigenPairs> eps;
+        if (tensorField_) {
+            eps = tensorField_->eigenPairsAt(positions_);
+        } else {
+            eps.resize(n);
+            ParallelChunks(n, 0, [&](auto begin, auto end) {
+                for (auto i = begin; i < end; i++) {
+                    eps[i] =
+                        ComputeSubvoxelEigenPairs(vol_, c.pos(i), radius_);
+                }
+            });
+        }
+        dirs.resize(n);
+        for (size_t i = 0; i < n; i++) {
+            dirs[i] = eps[i][0].second;
+        }
     }
 
-    return res;
+    // Project the z-axis onto the plane normal to the principal direction
+    auto* fx = res.x();
+    auto* fy = res.y();
+    auto* fz = res.z();
+    for (size_t i = 0; i < n; i++) {
+        const auto& e = dirs[i];
+        const auto d = e[2] / e.dot(e);
+        auto ox = -d * e[0];
+        auto oy = -d * e[1];
+        auto oz = 1 - d * e[2];
+        const auto norm = std::sqrt(ox * ox + oy * oy + oz * oz);
+        const auto inv = norm > DBL_EPSILON ? 1.0 / norm : 0.0;
+        fx[i] = ox * inv * propagationScaleFactor_;
+        fy[i] = oy * inv * propagationScaleFactor_;
+        fz[i] = oz * inv * propagationScaleFactor_;
+    }
 }
 
-ForceChain StructureTensorParticleSim::calc_spring_forces_(ParticleChain c)
+void StructureTensorParticleSim::calc_spring_forces_(
+    const ParticleChain& c, ForceChain& res)
 {
-    ForceChain res;
-    for (auto it = c.begin(); it != c.end(); it++) {
-        // Setup an empty force vector
-        Force f{0, 0, 0};
+    const auto n = c.size();
+    const auto* x = c.x();
+    const auto* y = c.y();
+    const auto* z = c.z();
+    const auto* restL = c.restingL();
+    const auto* restR = c.restingR();
+    auto* fx = res.x();
+    auto* fy = res.y();
+    auto* fz = res.z();
+
+    // Scale which turns the separation of two particles into their spring
+    // force. Matches cv::normalize(), which zeroes tiny vectors.
+    auto spring = [k = springConstantK_](double dist, double rest) {
+        return dist > DBL_EPSILON ? k * (dist - rest) / dist : 0.0;
+    };
+
+    for (size_t i = 0; i < n; i++) {
+        double sx{0}, sy{0}, sz{0};
 
         // Calculate left spring
-        if (it != c.begin()) {
-            auto vec = it->pos() - std::prev(it)->pos();
-            auto dist = cv::norm(vec);
-            cv::normalize(vec, vec, springConstantK_ * (dist - it->restingL()));
-            f += vec;
+        if (i > 0) {
+            const auto dx = x[i] - x[i - 1];
+            const auto dy = y[i] - y[i - 1];
+            const auto dz = z[i] - z[i - 1];
+            const auto s =
+                spring(std::sqrt(dx * dx + dy * dy + dz * dz), restL[i]);
+            sx += s * dx;
+            sy += s * dy;
+            sz += s * dz;
         }
 
-        // Calculate right resting
-        if (it != c.end() - 1) {
-            auto vec = std::next(it)->pos() - it->pos();
-            auto dist = cv::norm(vec);
-            cv::normalize(vec, vec, springConstantK_ * (dist - it->restingR()));
-            f += vec;
+        // Calculate right spring
+        if (i + 1 < n) {
+            const auto dx = x[i + 1] - x[i];
+            const auto dy = y[i + 1] - y[i];
+            const auto dz = z[i + 1] - z[i];
+            const auto s =
+                spring(std::sqrt(dx * dx + dy * dy + dz * dz), restR[i]);
+            sx += s * dx;
+            sy += s * dy;
+            sz += s * dz;
         }
 
-        res.push_back(f);
+        fx[i] += sx;
+        fy[i] += sy;
+        fz[i] += sz;
     }
-
-    return res;
-}
\ No newline at end of file
+}
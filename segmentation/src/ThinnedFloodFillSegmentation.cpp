@@ -1,8 +1,9 @@
 #include "vc/segmentation/ThinnedFloodFillSegmentation.hpp"
 
+#include <atomic>
+#include <exception>
+#include <future>
 #include <iomanip>
-#include <queue>
-#include <unordered_set>
 
 #include <opencv2/core.hpp>
 #include <opencv2/imgcodecs.hpp>
@@ -10,11 +11,12 @@
 
 #include "vc/core/filesystem.hpp"
 #include "vc/core/types/Color.hpp"
-#include "vc/core/util/HashFunctions.hpp"
 #include "vc/core/util/ImageConversion.hpp"
 #include "vc/core/util/Iteration.hpp"
 #include "vc/core/util/Logging.hpp"
+#include "vc/core/util/ThreadPool.hpp"
 #include "vc/segmentation/tff/FloodFill.hpp"
+#include "vc/segmentation/tff/Thinning.hpp"
 
 namespace fs = volcart::filesystem;
 
@@ -22,211 +24,8 @@ using namespace volcart;
 using namespace volcart::segmentation;
 
 using TFF = ThinnedFloodFillSegmentation;
-using Voxel = cv::Vec3i;
 
 using VoxelList = std::vector<cv::Vec3i>;
-using VoxelSet = std::unordered_set<Voxel, Vec3iHash>;
-
-static VoxelSet FindIntersections(const VoxelSet& pts)
-{
-    VoxelSet intersections;
-    for (const auto& v : pts) {
-        int branchCtr = 0;
-        for (const auto& n : GetNeighbors(v)) {
-            if (pts.find(n) != pts.end()) {
-                branchCtr++;
-            }
-        }
-        if (branchCtr > 2) {
-            // Add the voxel as an 'intersection point' that has at least one
-            // branch to prune.
-            intersections.insert(v);
-        }
-    }
-    return intersections;
-}
-
-/*
- * Search the skeleton for spurs.
- * An 'intersection' where more than two paths are available contains a spur.
- * */
-static VoxelSet PruneSpurs(VoxelSet skeleton, size_t spurLength)
-{
-    auto intersections = FindIntersections(skeleton);
-
-    // Prune the shortest branch of all intersections (alternatively, use a
-    // user-defined threshold to determine if a spur should be pruned.)
-    VoxelSet visited;
-    for (const auto& intPt : intersections) {
-        // For each intersection, check all directly adjacent points that are
-        // part of the skeleton. Search the paths connected to all adjacent
-        // points (independently of each other) to find the size of
-        // the possible spur (If pruning by user-defined threshold, BFS does not
-        // have to complete if the size of the segment is > the user-defined
-        // threshold. Don't prune in that case.)
-        // If not pruning by user-defined threshold, remove the shortest
-        // branch (probably the spur.) Make sure the intersection point is only
-        // connected to 2 other points now.
-        for (const auto& n : GetNeighbors(intPt)) {
-            // Skip this neighbor if it's not in the skeleton
-            if (skeleton.find(n) == skeleton.end()) {
-                continue;
-            }
-
-            // Begin BFS from this point, moving away from the intersection
-            // point along the branch.
-            std::queue<Voxel> q;
-            // Visited list ensures we don't travel in the wrong direction:
-            visited.clear();
-
-            // Queue the voxel and mark parent and voxel as visited
-            q.push(n);
-            visited.insert(intPt);
-            visited.insert(n);
-
-            while (!q.empty()) {
-                // pick a voxel off the queue
-                auto vox = q.front();
-                q.pop();
-
-                // check neighbors; if they're in the skeleton, add to queue
-                for (const auto& neighbor : GetNeighbors(vox)) {
-                    // If the point is in the skeleton and the point
-                    // has not already been visited, add it to the
-                    // queue:
-                    auto inSkeleton = skeleton.find(neighbor) != skeleton.end();
-                    auto inVisited = visited.find(neighbor) != visited.end();
-                    if (inSkeleton and not inVisited) {
-                        q.push(neighbor);
-                        visited.insert(neighbor);
-                    }
-                }
-            }
-
-            // Measure the 'length' or number of points that we can get
-            // to via this branch. We can get this from the visited
-            // vector, just account for the parent being in the visited
-            // vector.
-            auto length = visited.size() - 1;
-            // TODO: for now, the user needs to provide a fixed number.
-            // TODO: later, try just pruning the shortest of the branches.
-            if (length > 1 && length <= spurLength) {
-                Logger()->debug("Removing a {}-voxel spur.", length);
-                for (const Voxel& v : visited) {
-                    skeleton.erase(v);
-                }
-            }
-        }
-        // TODO: prune the shortest of the branches. Do only 2 branches remain?
-        // If not, repeat...
-    }
-    return skeleton;
-}
-
-static bool ThinPts(int dir, VoxelSet& pts)
-{
-    std::vector<Voxel> ptsToRemove;
-    for (const Voxel& v : pts) {
-        int x = v[0];
-        int y = v[1];
-        int z = v[2];
-
-        bool a1 = pts.find({x, y + 1, z}) != pts.end();
-        bool a2 = pts.find({x + 1, y + 1, z}) != pts.end();
-        bool a3 = pts.find({x + 1, y, z}) != pts.end();
-        bool a4 = pts.find({x + 1, y - 1, z}) != pts.end();
-        bool a5 = pts.find({x, y - 1, z}) != pts.end();
-        bool a6 = pts.find({x - 1, y - 1, z}) != pts.end();
-        bool a7 = pts.find({x - 1, y, z}) != pts.end();
-        bool a8 = pts.find({x - 1, y + 1, z}) != pts.end();
-
-        // Calculate 'chi', the crossing number.
-        int chi = (a1 != a3) + (a3 != a5) + (a5 != a7) + int(a7 != a1) +
-                  (2 * (a2 > a1) && (a2 > a3)) + ((a4 > a3) && (a4 > a5)) +
-                  ((a6 > a5) && (a6 > a7)) + ((a8 > a7) && (a8 > a1));
-
-        // Obtain sigma -- a count of the number of 8-connected neighbors of
-        // this pixel that are also in the mask.
-        int sigma = a1 + a2 + a3 + a4 + a5 + a6 + a7 + a8;
-
-        // Skip this unless chi == 2 and sigma != 1
-        if (chi != 2 || sigma == 1) {
-            continue;
-        }
-
-        // Directional thinning
-        Voxel shouldntFind(x, y, z);
-        Voxel shouldFind(x, y, z);
-
-        // "North" points
-        if (dir == 0) {
-            shouldntFind[1] += 1;
-            shouldFind[1] -= 1;
-        }
-        // "South" points
-        else if (dir == 1) {
-            shouldntFind[1] -= 1;
-            shouldFind[1] += 1;
-        }
-        // "East" points
-        else if (dir == 2) {
-            shouldntFind[0] += 1;
-            shouldFind[0] -= 1;
-        }
-        // "West" points
-        else if (dir == 3) {
-            shouldntFind[0] -= 1;
-            shouldFind[0] += 1;
-        }
-
-        // Remove this point if my shouldntFind neighbor IS NOT in the points
-        // and my shouldFind neighbor IS in the points
-        if (pts.find(shouldntFind) == pts.end() &&
-            pts.find(shouldFind) != pts.end()) {
-            ptsToRemove.emplace_back(v);
-        }
-    }
-
-    // Remove all points marked for removal
-    for (const Voxel& v : ptsToRemove) {
-        pts.erase(v);
-    }
-
-    // Report the number of removed points
-    Logger()->debug("Removed {} points in this pass.", ptsToRemove.size());
-
-    return !ptsToRemove.empty();
-}
-
-/*
- * Skeletonize the mask by thinning.
- * This simple algorithm is described in section 8.6.2 of "Computer Vision", 5th
- * Edition, by E.R. Davies. This thinning algorithm produces a centered,
- * continuous skeleton. (So long as the mask it is thinning is continuous.)
- * */
-static VoxelSet ThinMask(VoxelSet& pts)
-{
-    bool nThinned{true};
-    bool sThinned{true};
-    bool eThinned{true};
-    bool wThinned{true};
-    while (nThinned || sThinned || eThinned || wThinned) {
-        nThinned = ThinPts(0, pts);
-        sThinned = ThinPts(1, pts);
-        eThinned = ThinPts(2, pts);
-        wThinned = ThinPts(3, pts);
-    }
-    return pts;
-}
-
-static TFF::PointSet AppendVoxelSetToPointSet(
-    const VoxelSet& points, TFF::PointSet result)
-{
-    for (const auto& v : points) {
-        result.emplace_back(v[0], v[1], v[2]);
-    }
-    return result;
-}
 
 void TFF::setFFLowThreshold(uint16_t t) { low_ = t; }
 void TFF::setFFHighThreshold(uint16_t t) { high_ = t; }
@@ -235,8 +34,23 @@ void TFF::setClosingKernelSize(int s) { kernel_ = s; }
 void TFF::setMeasureVertical(bool b) { measureVertically_ = b; }
 void TFF::setSpurLengthThreshold(int length) { spurLength_ = length; }
 void TFF::setMaxRadius(size_t radius) { maxRadius_ = radius; }
-TFF::VoxelMask TFF::getMask() const { return volMask_; }
+TFF::VoxelMask TFF::getMask() const
+{
+    VoxelMask mask(volMask_->size());
+    mask.append(*volMask_);
+    return mask;
+}
+VolumetricMask::Pointer TFF::getVolumetricMask() const { return volMask_; }
 void TFF::setDumpVis(bool b) { dumpVis_ = b; }
+void TFF::setNumThreads(std::size_t n) { numThreads_ = n; }
+
+std::size_t TFF::numThreads() const
+{
+    if (numThreads_ > 0) {
+        return numThreads_;
+    }
+    return ThreadPool::Global().numThreads();
+}
 
 TFF::PointSet TFF::compute()
 {
@@ -252,7 +66,7 @@ TFF::PointSet TFF::compute()
 
     // Clear the outputs
     result_.clear();
-    volMask_.clear();
+    volMask_ = VolumetricMask::New();
 
     // Signal progress has begun
     progressStarted();
@@ -266,6 +80,17 @@ TFF::PointSet TFF::compute()
         seedPoints.emplace_back(pt[0], pt[1], pt[2]);
     }
 
+    // Start loading slice images in the background
+    const auto parallel = numThreads() > 1;
+    auto loadSlice = [this](std::size_t z) {
+        return vol_->getSliceView(z);
+    };
+    std::future<SliceView> nextSlice;
+    if (parallel and iterations_ > 0 and not seedPoints.empty() and
+        startSlice < vol_->numSlices()) {
+        nextSlice = std::async(std::launch::async, loadSlice, startSlice);
+    }
+
     // Iterate over z-slices
     for (auto it : range(iterations_)) {
         // Update progress
@@ -283,15 +108,31 @@ TFF::PointSet TFF::compute()
             break;
         }
 
+        // Quit early if we reached the end of the volume. The next slice is
+        // only loaded if it exists.
+        if (zIndex >= vol_->numSlices()) {
+            Logger()->warn(
+                "Reached the end of the volume. Terminating segmentation on "
+                "slice {}",
+                zIndex);
+            break;
+        }
+
         // Get the current (single) slice image (Of type Mat)
-        auto slice = vol_->getSliceDataCopy(zIndex);
+        SliceView slice;
+        if (parallel) {
+            slice = nextSlice.get();
+            // Load the next slice while this one is processed
+            auto nextZ = zIndex + 1;
+            if (it + 1 < iterations_ and nextZ < vol_->numSlices()) {
+                nextSlice = std::async(std::launch::async, loadSlice, nextZ);
+            }
+        } else {
+            slice = vol_->getSliceView(zIndex);
+        }
 
         // Estimate thickness of page from every seed point.
-        std::vector<size_t> estimates;
-        for (const auto& v : seedPoints) {
-            estimates.emplace_back(MeasureThickness(
-                v, slice, low_, high_, measureVertically_, maxRadius_));
-        }
+        auto estimates = measure_thickness_(seedPoints, slice);
 
         // Calculate the median thickness.
         // Choose the median of the measurements to be the boundary for every
@@ -299,34 +140,24 @@ TFF::PointSet TFF::compute()
         auto bound = Median(estimates);
 
         // Do flood-fill with the given seed points to the estimated thickness.
-        auto sliceMask = DoFloodFill(seedPoints, bound, slice, low_, high_);
-
-        // Convert mask to a binary image so we can apply closing and distance
-        // transform operations:
-        cv::Mat binaryImg = cv::Mat::zeros(slice.size(), CV_8UC1);
-
-        // Each voxel in the mask should be assigned 'white' in the binary
-        // image.
-        for (const Voxel& v : sliceMask) {
-            binaryImg.at<uint8_t>(v[1], v[0]) = 255;
-        }
+        // The mask is a binary image so we can apply closing and distance
+        // transform operations.
+        auto binaryImg = FloodFillMask(seedPoints, bound, slice, low_, high_);
 
         // Apply closing to fill holes and gaps.
         cv::Mat kernel = cv::Mat::ones(kernel_, kernel_, CV_8U);
         cv::Mat closedImg;
         cv::morphologyEx(binaryImg, closedImg, cv::MORPH_CLOSE, kernel);
 
-        // Save to the full volume mask
-        for (const auto p : range2D(closedImg.rows, closedImg.cols)) {
-            const auto& x = p.second;
-            const auto& y = p.first;
-            if (closedImg.at<uint8_t>(y, x) > 0) {
-                volMask_.emplace_back(x, y, zIndex);
+        // Save to the full volume mask and dump image of mask on slice.
+        // Only reads the closed image, so it can overlap with the distance
+        // transform and thinning.
+        auto saveMask = [&]() {
+            volMask_->setIn(closedImg, static_cast<int>(zIndex));
+            if (not dumpVis_) {
+                return;
             }
-        }
 
-        // Dump image of mask on slice
-        if (dumpVis_) {
             auto i = QuantizeImage(slice, CV_8U);
             cv::cvtColor(i, i, cv::COLOR_GRAY2BGR);
             for (const auto v : range2D(closedImg.rows, closedImg.cols)) {
@@ -342,6 +173,12 @@ TFF::PointSet TFF::compute()
                << std::setfill('0') << zIndex << "_mask.png";
             const auto wholeMaskPath = maskDir / ss.str();
             cv::imwrite(wholeMaskPath.string(), i);
+        };
+        std::future<void> maskSaved;
+        if (parallel) {
+            maskSaved = std::async(std::launch::async, saveMask);
+        } else {
+            saveMask();
         }
 
         // Do the distance transform.
@@ -350,46 +187,43 @@ TFF::PointSet TFF::compute()
         cv::normalize(dtImg, dtImg, 1, 0, cv::NORM_MINMAX);
 
         // Thin the mask slightly based on the distance transform threshold set.
-        // Convert smaller mask back to a vector.
-        VoxelSet dtMask;
-        int imgHeight = slice.rows;
-        int imgWidth = slice.cols;
-        for (int j = 0; j < imgHeight; j++) {
-            for (int i = 0; i < imgWidth; i++) {
-                auto val = dtImg.at<float>(j, i);
-                if (val > dtt_) {
-                    // Add back to the mask vector all points that are greater
-                    // than the set distance transform threshold.
-                    dtMask.emplace(i, j, zIndex);
-                }
-            }
-        }
+        // Keeps all points that are greater than the threshold.
+        cv::Mat skeletonImg = dtImg > dtt_;
 
         // Do the thinning algorithm
-        auto thinnedMask = ThinMask(dtMask);
+        ThinMask(skeletonImg, numThreads());
 
         // Prune spurs
-        auto skeleton = PruneSpurs(thinnedMask, spurLength_);
+        PruneSpurs(skeletonImg, spurLength_);
 
-        // Update seed points for the next iteration
+        // Update seed points for the next iteration and save the skeleton
+        // points to the final results
+        std::vector<cv::Point> skeleton;
+        cv::findNonZero(skeletonImg, skeleton);
         seedPoints.clear();
         for (const auto& s : skeleton) {
-            seedPoints.emplace_back(s[0], s[1], zIndex + 1);
+            seedPoints.emplace_back(s.x, s.y, zIndex + 1);
+            result_.emplace_back(s.x, s.y, zIndex);
         }
 
-        // Save the skeleton points to the final results
-        result_ = AppendVoxelSetToPointSet(skeleton, result_);
+        // Wait for the mask to be saved
+        if (maskSaved.valid()) {
+            maskSaved.get();
+        }
 
         // Signal changes
         pointsetUpdated.send(result_);
-        maskUpdated.send(volMask_);
+        if (maskUpdated.numConnections() > 0) {
+            // Only expand the compact mask if someone is listening
+            maskUpdated.send(getMask());
+        }
 
         // Visualize the pruned skeleton if applicable
         if (dumpVis_) {
             auto i = QuantizeImage(slice, CV_8U);
             cv::cvtColor(i, i, cv::COLOR_GRAY2BGR);
-            for (const Voxel& v : skeleton) {
-                i.at<cv::Vec3b>(v[1], v[0]) = color::GREEN;
+            for (const auto& p : skeleton) {
+                i.at<cv::Vec3b>(p) = color::GREEN;
             }
 
             std::stringstream ss;
@@ -402,3 +236,60 @@ TFF::PointSet TFF::compute()
     progressComplete();
     return result_;
 }
+
+std::vector<std::size_t> TFF::measure_thickness_(
+    const VoxelList& seeds, const cv::Mat& slice) const
+{
+    std::vector<std::size_t> estimates(seeds.size());
+    auto measure = [&](std::size_t i) {
+        estimates[i] = MeasureThickness(
+            seeds[i], slice, low_, high_, measureVertically_, maxRadius_);
+    };
+
+    // Serial
+    const auto threadCount = std::min(numThreads(), seeds.size());
+    if (threadCount <= 1) {
+        for (std::size_t i = 0; i < seeds.size(); ++i) {
+            measure(i);
+        }
+        return estimates;
+    }
+
+    // Seeds are claimed in small batches to limit contention on the counter
+    constexpr std::size_t BATCH_SIZE{64};
+    std::atomic<std::size_t> next{0};
+    std::atomic<bool> failed{false};
+    auto work = [&]() {
+        for (auto b = next.fetch_add(BATCH_SIZE);
+             b < seeds.size() and not failed; b = next.fetch_add(BATCH_SIZE)) {
+            auto e = std::min(b + BATCH_SIZE, seeds.size());
+            for (auto i = b; i < e; ++i) {
+                measure(i);
+            }
+        }
+    };
+
+    // Run the workers and rethrow the first error
+    std::vector<std::exception_ptr> errors(threadCount);
+    auto& pool = ThreadPool::Global();
+    std::vector<std::future<void>> workers;
+    for (std::size_t t = 0; t < threadCount; ++t) {
+        workers.emplace_back(pool.submit([&, t]() {
+            try {
+                work();
+            } catch (...) {
+                errors[t] = std::current_exception();
+                failed = true;
+            }
+        }));
+    }
+    for (auto& w : workers) {
+        pool.wait(w);
+    }
+    for (const auto& e : errors) {
+        if (e) {
+            std::rethrow_exception(e);
+        }
+    }
+    return estimates;
+}
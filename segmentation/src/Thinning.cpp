@@ -0,0 +1,282 @@
+#include "vc/segmentation/tff/Thinning.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bitset>
+#include <cstdint>
+#include <exception>
+#include <future>
+#include <iterator>
+#include <vector>
+
+#include <opencv2/imgproc.hpp>
+
+#include "vc/core/util/Logging.hpp"
+#include "vc/core/util/ThreadPool.hpp"
+
+using namespace volcart;
+
+namespace vcs = volcart::segmentation;
+
+namespace
+{
+// Thinning directions
+enum Direction { North = 0, South, East, West };
+
+// Removable neighborhoods of each direction. The neighbors a1-a8 of pixel
+// (x, y) are packed into bits 0-7 in the order (x, y+1), (x+1, y+1),
+// (x+1, y), (x+1, y-1), (x, y-1), (x-1, y-1), (x-1, y), (x-1, y+1).
+using ThinningLUT = std::array<bool, 256>;
+
+auto MakeThinningLUTs() -> std::array<ThinningLUT, 4>
+{
+    std::array<ThinningLUT, 4> luts{};
+    for (int code = 0; code < 256; code++) {
+        auto bit = [code](int i) { return ((code >> i) & 1) != 0; };
+        bool a1 = bit(0);
+        bool a2 = bit(1);
+        bool a3 = bit(2);
+        bool a4 = bit(3);
+        bool a5 = bit(4);
+        bool a6 = bit(5);
+        bool a7 = bit(6);
+        bool a8 = bit(7);
+
+        // Calculate 'chi', the crossing number.
+        int chi = (a1 != a3) + (a3 != a5) + (a5 != a7) + int(a7 != a1) +
+                  ((a2 > a1) && (a2 > a3)) + ((a4 > a3) && (a4 > a5)) +
+                  ((a6 > a5) && (a6 > a7)) + ((a8 > a7) && (a8 > a1));
+
+        // Obtain sigma -- a count of the number of 8-connected neighbors of
+        // this pixel that are also in the mask.
+        int sigma = a1 + a2 + a3 + a4 + a5 + a6 + a7 + a8;
+
+        // Only pixels with chi == 2 and sigma != 1 can be removed
+        if (chi != 2 or sigma == 1) {
+            continue;
+        }
+
+        // Remove the pixel if its neighbor on the thinned side is not in the
+        // mask and its opposite neighbor is
+        luts[North][code] = not a1 and a5;
+        luts[South][code] = not a5 and a1;
+        luts[East][code] = not a3 and a7;
+        luts[West][code] = not a7 and a3;
+    }
+    return luts;
+}
+
+const auto THINNING_LUTS = MakeThinningLUTs();
+
+// Neighborhood code of pixel x in a padded image row and its neighbor rows
+inline auto NeighborCode(
+    const std::uint8_t* up,
+    const std::uint8_t* mid,
+    const std::uint8_t* down,
+    int x) -> std::uint8_t
+{
+    return static_cast<std::uint8_t>(
+        (down[x] != 0) | (down[x + 1] != 0) << 1 | (mid[x + 1] != 0) << 2 |
+        (up[x + 1] != 0) << 3 | (up[x] != 0) << 4 | (up[x - 1] != 0) << 5 |
+        (mid[x - 1] != 0) << 6 | (down[x - 1] != 0) << 7);
+}
+
+// Call f(band, rowBegin, rowEnd) for bands of rows [begin, end). Bands run
+// on the global pool if there is more than one.
+template <typename F>
+void ForEachBand(int begin, int end, std::size_t numBands, F f)
+{
+    const auto rows = static_cast<std::size_t>(end - begin);
+    numBands = std::max<std::size_t>(1, std::min(numBands, rows));
+    if (numBands == 1) {
+        f(0, begin, end);
+        return;
+    }
+
+    const auto bandSize = (rows + numBands - 1) / numBands;
+    auto& pool = ThreadPool::Global();
+    std::vector<std::future<void>> results;
+    for (std::size_t b = 0; b < numBands; b++) {
+        auto r0 = begin + static_cast<int>(b * bandSize);
+        auto r1 = std::min(end, r0 + static_cast<int>(bandSize));
+        results.emplace_back(
+            pool.submit([&f, b, r0, r1]() { f(b, r0, r1); }));
+    }
+
+    // Wait for all bands before rethrowing any errors
+    std::exception_ptr error;
+    for (auto& r : results) {
+        try {
+            pool.wait(r);
+        } catch (...) {
+            if (not error) {
+                error = std::current_exception();
+            }
+        }
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+// Copy the bounding box of a mask's non-zero pixels into an image with a
+// one-pixel zero border, so that neighbors never leave the image
+auto PadBoundingBox(const cv::Mat& mask, cv::Rect& box) -> cv::Mat
+{
+    int x0 = mask.cols;
+    int x1 = -1;
+    int y0 = mask.rows;
+    int y1 = -1;
+    for (int y = 0; y < mask.rows; y++) {
+        const auto* row = mask.ptr<std::uint8_t>(y);
+        auto nz = [](auto v) { return v != 0; };
+        const auto* first = std::find_if(row, row + mask.cols, nz);
+        if (first == row + mask.cols) {
+            continue;
+        }
+        const auto* last = std::find_if(
+            std::make_reverse_iterator(row + mask.cols),
+            std::make_reverse_iterator(row), nz);
+        x0 = std::min(x0, static_cast<int>(first - row));
+        x1 = std::max(x1, static_cast<int>(last.base() - row) - 1);
+        y0 = std::min(y0, y);
+        y1 = y;
+    }
+    box = cv::Rect(x0, y0, x1 - x0 + 1, y1 - y0 + 1);
+
+    cv::Mat padded;
+    if (x1 >= 0) {
+        cv::copyMakeBorder(
+            mask(box), padded, 1, 1, 1, 1, cv::BORDER_CONSTANT, 0);
+    }
+    return padded;
+}
+
+// One directional thinning pass. Returns the number of removed pixels.
+auto ThinPass(cv::Mat& img, Direction dir, std::size_t numThreads)
+    -> std::size_t
+{
+    const auto& lut = THINNING_LUTS[dir];
+    std::vector<std::vector<cv::Point>> removed(
+        std::max<std::size_t>(numThreads, 1));
+    ForEachBand(1, img.rows - 1, numThreads, [&](auto band, int r0, int r1) {
+        auto& out = removed[band];
+        for (int y = r0; y < r1; y++) {
+            const auto* up = img.ptr<std::uint8_t>(y - 1);
+            const auto* mid = img.ptr<std::uint8_t>(y);
+            const auto* down = img.ptr<std::uint8_t>(y + 1);
+            for (int x = 1; x < img.cols - 1; x++) {
+                if (mid[x] != 0 and lut[NeighborCode(up, mid, down, x)]) {
+                    out.emplace_back(x, y);
+                }
+            }
+        }
+    });
+
+    // Remove all pixels marked for removal
+    std::size_t count{0};
+    for (const auto& band : removed) {
+        for (const auto& p : band) {
+            img.at<std::uint8_t>(p) = 0;
+        }
+        count += band.size();
+    }
+    Logger()->debug("Removed {} points in this pass.", count);
+    return count;
+}
+
+// Offsets of the 8 neighbors, in the order of GetNeighbors()
+const std::array<cv::Point, 8> NEIGHBORS{
+    cv::Point{-1, -1}, cv::Point{0, -1}, cv::Point{1, -1}, cv::Point{-1, 0},
+    cv::Point{1, 0},   cv::Point{-1, 1}, cv::Point{0, 1},  cv::Point{1, 1}};
+}  // namespace
+
+void vcs::ThinMask(cv::Mat& mask, std::size_t numThreads)
+{
+    cv::Rect box;
+    auto img = PadBoundingBox(mask, box);
+    if (img.empty()) {
+        return;
+    }
+
+    std::size_t removed{1};
+    while (removed > 0) {
+        removed = 0;
+        for (auto dir : {North, South, East, West}) {
+            removed += ThinPass(img, dir, numThreads);
+        }
+    }
+    img(cv::Rect(1, 1, box.width, box.height)).copyTo(mask(box));
+}
+
+void vcs::PruneSpurs(cv::Mat& skeleton, std::size_t spurLength)
+{
+    cv::Rect box;
+    auto img = PadBoundingBox(skeleton, box);
+    if (img.empty()) {
+        return;
+    }
+
+    // An 'intersection' where more than two paths are available contains a
+    // spur
+    std::vector<cv::Point> intersections;
+    for (int y = 1; y < img.rows - 1; y++) {
+        const auto* up = img.ptr<std::uint8_t>(y - 1);
+        const auto* mid = img.ptr<std::uint8_t>(y);
+        const auto* down = img.ptr<std::uint8_t>(y + 1);
+        for (int x = 1; x < img.cols - 1; x++) {
+            if (mid[x] == 0) {
+                continue;
+            }
+            auto code = NeighborCode(up, mid, down, x);
+            if (std::bitset<8>(code).count() > 2) {
+                intersections.emplace_back(x, y);
+            }
+        }
+    }
+
+    // Search the branch through each neighbor of each intersection. Pixels
+    // visited by the current search are stamped with its index, so the
+    // visited set never has to be cleared.
+    cv::Mat visited(img.size(), CV_32SC1, cv::Scalar(0));
+    std::int32_t stamp{0};
+    std::vector<cv::Point> branch;
+    for (const auto& intPt : intersections) {
+        for (const auto& offset : NEIGHBORS) {
+            auto n = intPt + offset;
+            if (img.at<std::uint8_t>(n) == 0) {
+                continue;
+            }
+
+            // Breadth-first search away from the intersection. Stop once the
+            // branch is too long to be a spur.
+            stamp++;
+            visited.at<std::int32_t>(intPt) = stamp;
+            visited.at<std::int32_t>(n) = stamp;
+            branch.assign({n});
+            for (std::size_t i = 0;
+                 i < branch.size() and branch.size() <= spurLength; i++) {
+                auto vox = branch[i];
+                for (const auto& o : NEIGHBORS) {
+                    auto p = vox + o;
+                    auto& v = visited.at<std::int32_t>(p);
+                    if (img.at<std::uint8_t>(p) != 0 and v != stamp) {
+                        branch.push_back(p);
+                        v = stamp;
+                    }
+                }
+            }
+
+            // Remove the spur and the intersection
+            auto length = branch.size();
+            if (length > 1 and length <= spurLength) {
+                Logger()->debug("Removing a {}-voxel spur.", length);
+                img.at<std::uint8_t>(intPt) = 0;
+                for (const auto& p : branch) {
+                    img.at<std::uint8_t>(p) = 0;
+                }
+            }
+        }
+    }
+    img(cv::Rect(1, 1, box.width, box.height)).copyTo(skeleton(box));
+}
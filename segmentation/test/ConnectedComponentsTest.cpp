@@ -0,0 +1,191 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstdlib>
+#include <queue>
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+#include "vc/core/filesystem.hpp"
+#include "vc/core/types/Volume.hpp"
+#include "vc/segmentation/ConnectedComponents.hpp"
+
+using namespace volcart;
+using namespace volcart::segmentation;
+namespace fs = volcart::filesystem;
+
+using Connectivity = ConnectedComponents3D::Connectivity;
+
+namespace
+{
+constexpr int WIDTH{23};
+constexpr int HEIGHT{19};
+constexpr int SLICES{37};
+constexpr std::uint16_t FOREGROUND{1000};
+
+// Volume with sparse random foreground voxels
+auto MakeVolume(const fs::path& path, double density) -> Volume::Pointer
+{
+    fs::remove_all(path);
+    fs::create_directory(path);
+    auto vol = Volume::New(path, "CCL", "CCL");
+    vol->setSliceWidth(WIDTH);
+    vol->setSliceHeight(HEIGHT);
+    vol->setNumberOfSlices(SLICES);
+    vol->saveMetadata();
+    cv::RNG rng(4321);
+    for (int z = 0; z < SLICES; z++) {
+        cv::Mat slice = cv::Mat::zeros(HEIGHT, WIDTH, CV_16UC1);
+        for (int y = 0; y < HEIGHT; y++) {
+            for (int x = 0; x < WIDTH; x++) {
+                if (rng.uniform(0., 1.) < density) {
+                    slice.at<std::uint16_t>(y, x) = FOREGROUND;
+                }
+            }
+        }
+        vol->setSliceData(z, slice);
+    }
+    return vol;
+}
+
+// Reference labeling: breadth-first search from every unlabeled foreground
+// voxel in z, y, x order
+auto ReferenceSizes(const Volume::Pointer& vol, Connectivity connectivity)
+    -> std::pair<std::vector<std::size_t>, std::vector<int>>
+{
+    std::vector<cv::Mat> slices;
+    for (int z = 0; z < SLICES; z++) {
+        slices.push_back(vol->getSliceData(z));
+    }
+    auto idx = [](int x, int y, int z) { return (z * HEIGHT + y) * WIDTH + x; };
+    std::vector<int> labels(WIDTH * HEIGHT * SLICES, -1);
+    std::vector<std::size_t> sizes;
+    for (int z = 0; z < SLICES; z++) {
+        for (int y = 0; y < HEIGHT; y++) {
+            for (int x = 0; x < WIDTH; x++) {
+                if (slices[z].at<std::uint16_t>(y, x) != FOREGROUND or
+                    labels[idx(x, y, z)] >= 0) {
+                    continue;
+                }
+                auto label = static_cast<int>(sizes.size());
+                sizes.push_back(0);
+                std::queue<cv::Vec3i> q;
+                q.push({x, y, z});
+                labels[idx(x, y, z)] = label;
+                while (not q.empty()) {
+                    auto v = q.front();
+                    q.pop();
+                    sizes.back()++;
+                    for (int dz = -1; dz <= 1; dz++) {
+                        for (int dy = -1; dy <= 1; dy++) {
+                            for (int dx = -1; dx <= 1; dx++) {
+                                auto n = std::abs(dx) + std::abs(dy) +
+                                         std::abs(dz);
+                                if (n == 0 or
+                                    (connectivity == Connectivity::Face and
+                                     n > 1)) {
+                                    continue;
+                                }
+                                auto nx = v[0] + dx;
+                                auto ny = v[1] + dy;
+                                auto nz = v[2] + dz;
+                                if (nx < 0 or nx >= WIDTH or ny < 0 or
+                                    ny >= HEIGHT or nz < 0 or nz >= SLICES or
+                                    slices[nz].at<std::uint16_t>(ny, nx) !=
+                                        FOREGROUND or
+                                    labels[idx(nx, ny, nz)] >= 0) {
+                                    continue;
+                                }
+                                labels[idx(nx, ny, nz)] = label;
+                                q.push({nx, ny, nz});
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+    return {sizes, labels};
+}
+
+// Compare against the reference labeling for several slab sizes
+void ExpectMatchesReference(
+    Connectivity connectivity, double density, std::size_t minSize)
+{
+    auto vol = MakeVolume("vc_segmentation_ConnectedComponents", density);
+    auto [sizes, labels] = ReferenceSizes(vol, connectivity);
+    std::size_t expectedVoxels{0};
+    for (auto s : sizes) {
+        expectedVoxels += s >= minSize ? s : 0;
+    }
+
+    for (std::size_t slabSize : {1, 5, 16, 64}) {
+        ConnectedComponents3D ccl;
+        ccl.setVolume(vol);
+        ccl.setLowThreshold(FOREGROUND);
+        ccl.setHighThreshold(FOREGROUND);
+        ccl.setConnectivity(connectivity);
+        ccl.setMinComponentSize(minSize);
+        ccl.setSlabSize(slabSize);
+        ccl.setNumThreads(4);
+        auto mask = ccl.compute();
+
+        // Same components, numbered in the same order
+        EXPECT_EQ(ccl.componentSizes(), sizes) << "slab size " << slabSize;
+
+        // Exactly the voxels of the large components
+        EXPECT_EQ(mask->size(), expectedVoxels) << "slab size " << slabSize;
+        for (const auto& v : *mask) {
+            auto label = labels[(v[2] * HEIGHT + v[1]) * WIDTH + v[0]];
+            ASSERT_GE(label, 0);
+            EXPECT_GE(sizes[label], minSize);
+        }
+    }
+}
+}  // namespace
+
+TEST(ConnectedComponents3D, FaceConnectivity)
+{
+    ExpectMatchesReference(Connectivity::Face, 0.35, 1);
+}
+
+TEST(ConnectedComponents3D, FullConnectivity)
+{
+    ExpectMatchesReference(Connectivity::Full, 0.1, 1);
+}
+
+TEST(ConnectedComponents3D, MinComponentSize)
+{
+    ExpectMatchesReference(Connectivity::Face, 0.3, 5);
+}
+
+TEST(ConnectedComponents3D, DiagonalVoxels)
+{
+    // Two voxels which only share a corner, on either side of a slab boundary
+    const fs::path path{"vc_segmentation_ConnectedComponents_diagonal"};
+    fs::remove_all(path);
+    fs::create_directory(path);
+    auto vol = Volume::New(path, "CCL", "CCL");
+    vol->setSliceWidth(4);
+    vol->setSliceHeight(4);
+    vol->setNumberOfSlices(2);
+    vol->saveMetadata();
+    cv::Mat slice0 = cv::Mat::zeros(4, 4, CV_16UC1);
+    slice0.at<std::uint16_t>(1, 1) = FOREGROUND;
+    vol->setSliceData(0, slice0);
+    cv::Mat slice1 = cv::Mat::zeros(4, 4, CV_16UC1);
+    slice1.at<std::uint16_t>(2, 2) = FOREGROUND;
+    vol->setSliceData(1, slice1);
+
+    ConnectedComponents3D ccl;
+    ccl.setVolume(vol);
+    ccl.setLowThreshold(FOREGROUND);
+    ccl.setSlabSize(1);
+    ccl.compute();
+    EXPECT_EQ(ccl.numComponents(), 1);
+
+    ccl.setConnectivity(Connectivity::Face);
+    ccl.compute();
+    EXPECT_EQ(ccl.numComponents(), 2);
+}
@@ -1,5 +1,6 @@
 #include <gtest/gtest.h>
 
+#include <algorithm>
 #include <cmath>
 #include <iostream>
 #include <numeric>
@@ -140,6 +141,40 @@ TEST(CubicSplineTest, YEqualsXSquaredValues)
     }
 }
 
+////////////////////////////////////////////////////////////////////////////////
+// Test that the banded fit of long splines matches Eigen's dense fit
+TEST(CubicSplineTest, BandedFitMatchesDenseFit)
+{
+    for (size_t count : {5, 16, 17, 100, 500}) {
+        std::vector<double> xs(count), ys(count);
+        Eigen::MatrixXd pts(2, count);
+        for (size_t i = 0; i < count; ++i) {
+            xs[i] = i + 0.3 * std::sin(i * 1.7);
+            ys[i] = 10 * std::sin(i * 0.1) + 0.3 * std::cos(i * 2.3);
+            pts(0, i) = xs[i];
+            pts(1, i) = ys[i];
+        }
+        CubicSpline<double> spline(xs, ys);
+        auto expected =
+            Eigen::SplineFitting<Eigen::Spline<double, 2>>::Interpolate(pts, 3);
+
+        for (auto t : generateTVals(count * 3)) {
+            auto p = spline(t);
+            Eigen::Vector2d e = expected(t);
+            EXPECT_NEAR(p(0), e(0), 1e-9);
+            EXPECT_NEAR(p(1), e(1), 1e-9);
+        }
+
+        // Refitting reuses the spline
+        std::reverse(xs.begin(), xs.end());
+        std::reverse(ys.begin(), ys.end());
+        spline.fit(xs, ys);
+        auto p = spline(0);
+        EXPECT_NEAR(p(0), xs.front(), 1e-9);
+        EXPECT_NEAR(p(1), ys.front(), 1e-9);
+    }
+}
+
 std::vector<double> generateTVals(size_t count)
 {
     std::vector<double> ts(count);
@@ -188,6 +188,28 @@ TEST(CircleFittedCurve, EvenlySampledCircleCurveHasEvenlySpacedPoints)
     }
 }
 
+TEST(CircleFittedCurve, RefitMatchesNewCurve)
+{
+    auto curve = CircleFittedCurve(10)._curve;
+    auto expected = CircleFittedCurve(5, 2)._curve;
+    std::vector<Voxel> vs;
+    for (size_t deg = 0; deg < 360; deg += 2) {
+        vs.emplace_back(
+            5 * std::cos(deg * M_PI / 180.0), 5 * std::sin(deg * M_PI / 180.0),
+            -1);
+    }
+    curve.fit(vs, -1);
+    ASSERT_EQ(curve.size(), expected.size());
+    for (size_t i = 0; i < curve.size(); ++i) {
+        EXPECT_EQ(curve.points()[i], expected.points()[i]);
+    }
+
+    // Sampling into a buffer matches sampling into a new vector
+    std::vector<Voxel> buffer(3);
+    curve.sample(720, buffer);
+    EXPECT_EQ(buffer, curve.sample(720));
+}
+
 std::vector<double> makeTVals(size_t count)
 {
     std::vector<double> ts(count);
@@ -0,0 +1,64 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+#include "vc/segmentation/tff/FloodFill.hpp"
+
+using namespace volcart::segmentation;
+
+// Image with a bright horizontal band in rows [20, 30)
+static auto MakeBandImage() -> cv::Mat
+{
+    cv::Mat img = cv::Mat::zeros(50, 50, CV_16UC1);
+    img.rowRange(20, 30).setTo(1000);
+    return img;
+}
+
+TEST(FloodFill, MaskMatchesVoxelList)
+{
+    auto img = MakeBandImage();
+    std::vector<cv::Vec3i> seeds{{10, 25, 7}, {40, 22, 7}};
+    const int bound{4};
+
+    auto voxels = DoFloodFill(seeds, bound, img, 500, 2000);
+    auto mask = FloodFillMask(seeds, bound, img, 500, 2000);
+    ASSERT_EQ(mask.size(), img.size());
+    ASSERT_EQ(mask.type(), CV_8UC1);
+
+    // Same pixels in both representations
+    EXPECT_EQ(static_cast<std::size_t>(cv::countNonZero(mask)), voxels.size());
+    for (const auto& v : voxels) {
+        EXPECT_EQ(v[2], 7);
+        EXPECT_EQ(mask.at<uint8_t>(v[1], v[0]), 255);
+    }
+}
+
+TEST(FloodFill, DistanceAndThresholdBounds)
+{
+    auto img = MakeBandImage();
+    const cv::Vec3i seed{25, 25, 0};
+    const int bound{3};
+    auto mask = FloodFillMask({seed}, bound, img, 500, 2000);
+
+    // Filled pixels are in the band and within the (truncated) distance bound
+    for (int y = 0; y < img.rows; y++) {
+        for (int x = 0; x < img.cols; x++) {
+            auto inBand = y >= 20 and y < 30;
+            auto dist = static_cast<int>(
+                std::sqrt((x - seed[0]) * (x - seed[0]) +
+                          (y - seed[1]) * (y - seed[1])));
+            auto expected = (inBand and dist <= bound) ? 255 : 0;
+            EXPECT_EQ(mask.at<uint8_t>(y, x), expected) << x << ", " << y;
+        }
+    }
+}
+
+TEST(FloodFill, SeedOutsideRange)
+{
+    auto img = MakeBandImage();
+    auto mask = FloodFillMask({{25, 5, 0}, {-1, 25, 0}}, 10, img, 500, 2000);
+    EXPECT_EQ(cv::countNonZero(mask), 0);
+}
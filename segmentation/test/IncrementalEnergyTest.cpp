@@ -0,0 +1,138 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <vector>
+
+#include "vc/segmentation/lrps/EnergyMetrics.hpp"
+#include "vc/segmentation/lrps/IncrementalEnergy.hpp"
+
+using namespace volcart::segmentation;
+
+// Testing constants
+const double kAlpha = 1.0 / 3.0;
+const double kBeta = 1.0 / 3.0;
+const double kDelta = 1.0 / 3.0;
+const double kK1 = 0.5;
+const double kK2 = 0.5;
+const int kZIndex = 5;
+
+// Fixture for a gently curving chain, like a layer in a reslice
+class CurvedChain : public ::testing::Test
+{
+public:
+    std::vector<Voxel> _vs;
+
+    CurvedChain()
+    {
+        for (int i = 0; i < 200; ++i) {
+            double t = i / 199.0;
+            _vs.emplace_back(
+                3.0 * i, 40.0 * std::sin(3.0 * t) + 5.0 * std::cos(7.0 * t),
+                kZIndex);
+        }
+    }
+
+    static double FullEnergy(const std::vector<Voxel>& vs)
+    {
+        FittedCurve curve(vs, kZIndex);
+        return EnergyMetrics::TotalEnergy(
+            curve, kAlpha, kK1, kK2, kBeta, kDelta);
+    }
+
+    IncrementalEnergy MakeEnergy(std::size_t radius) const
+    {
+        return {_vs, kZIndex, kAlpha, kK1, kK2, kBeta, kDelta, radius};
+    }
+};
+
+TEST_F(CurvedChain, InitialEnergyMatchesTotalEnergy)
+{
+    auto expected = FullEnergy(_vs);
+    EXPECT_DOUBLE_EQ(MakeEnergy(0).energy(), expected);
+    EXPECT_DOUBLE_EQ(MakeEnergy(10).energy(), expected);
+}
+
+TEST_F(CurvedChain, ExactMovesMatchTotalEnergy)
+{
+    auto energy = MakeEnergy(0);
+    auto vs = _vs;
+    for (std::size_t i : {0, 1, 57, 198, 199}) {
+        Voxel v = vs[i] + Voxel{1.5, -2.0, 0};
+        auto e = energy.evaluateMove(i, v);
+        vs[i] = v;
+        EXPECT_DOUBLE_EQ(e, FullEnergy(vs));
+        energy.acceptMove();
+        EXPECT_DOUBLE_EQ(energy.energy(), e);
+    }
+    EXPECT_EQ(energy.particles(), vs);
+}
+
+TEST_F(CurvedChain, LocalMovesApproximateTotalEnergy)
+{
+    auto energy = MakeEnergy(10);
+    auto vs = _vs;
+    for (std::size_t i : {0, 2, 11, 57, 100, 188, 197, 199}) {
+        Voxel v = vs[i] + Voxel{1.5, -2.0, 0};
+        auto e = energy.evaluateMove(i, v);
+        auto moved = vs;
+        moved[i] = v;
+        auto expected = FullEnergy(moved);
+        EXPECT_NEAR(e, expected, 1e-3 * expected) << "Particle " << i;
+    }
+
+    // Accepted moves accumulate
+    for (std::size_t i : {20, 21, 90, 150}) {
+        Voxel v = vs[i] + Voxel{-1.0, 1.0, 0};
+        energy.evaluateMove(i, v);
+        energy.acceptMove();
+        vs[i] = v;
+    }
+    auto expected = FullEnergy(vs);
+    EXPECT_NEAR(energy.energy(), expected, 1e-3 * expected);
+    EXPECT_EQ(energy.particles(), vs);
+}
+
+TEST_F(CurvedChain, EvaluateDoesNotChangeChain)
+{
+    auto energy = MakeEnergy(10);
+    auto initial = energy.energy();
+    auto points = energy.points();
+
+    Voxel v = _vs[80] + Voxel{0, 3.0, 0};
+    auto e = energy.evaluateMove(80, v);
+    EXPECT_DOUBLE_EQ(energy.energy(), initial);
+    EXPECT_EQ(energy.points(), points);
+    EXPECT_EQ(energy.particles(), _vs);
+
+    // Re-evaluating gives the same result
+    EXPECT_DOUBLE_EQ(energy.evaluateMove(80, v), e);
+
+    // Only the last evaluated move is accepted
+    energy.evaluateMove(81, _vs[81] + Voxel{0, 1.0, 0});
+    energy.evaluateMove(80, v);
+    energy.acceptMove();
+    EXPECT_DOUBLE_EQ(energy.energy(), e);
+    EXPECT_EQ(energy.particles()[80], v);
+    EXPECT_EQ(energy.particles()[81], _vs[81]);
+
+    // Accepting again does nothing
+    energy.acceptMove();
+    EXPECT_DOUBLE_EQ(energy.energy(), e);
+}
+
+TEST_F(CurvedChain, ShortChainsAreExact)
+{
+    std::vector<Voxel> vs(_vs.begin(), _vs.begin() + 15);
+    IncrementalEnergy energy(vs, kZIndex, kAlpha, kK1, kK2, kBeta, kDelta, 10);
+    Voxel v = vs[7] + Voxel{0, 2.0, 0};
+    auto e = energy.evaluateMove(7, v);
+    vs[7] = v;
+    EXPECT_DOUBLE_EQ(e, FullEnergy(vs));
+}
+
+TEST_F(CurvedChain, InvalidArguments)
+{
+    EXPECT_THROW(MakeEnergy(1), std::invalid_argument);
+    auto energy = MakeEnergy(10);
+    EXPECT_THROW(energy.evaluateMove(200, _vs[0]), std::out_of_range);
+}
@@ -158,4 +158,27 @@ TEST_F(ResliceFixture, TwoMaximaOneCloserToMiddleButShorter)
     ASSERT_EQ(result.size(), 2);
     EXPECT_EQ(result[0].first, WIDTH / 2 - 3);
     EXPECT_EQ(result[1].first, WIDTH / 2 + 2);
-}
\ No newline at end of file
+}
+
+TEST_F(ResliceFixture, SameMaximaForAllInputTypes)
+{
+    std::vector<uint16_t> rowVec{0,  0,  0,  0,  2,  4, 8,  10, 12, 14, 16,
+                                 18, 20, 32, 20, 10, 0, 32, 28, 24, 20, 18,
+                                 16, 14, 12, 10, 8,  4, 2,  0,  0,  0};
+    cv::Mat_<uint16_t> row = cv::Mat_<uint16_t>(rowVec).t();
+    row *= 1000;
+    row.copyTo(_reslice.row(HEIGHT / 2 + 1));
+    _reslice.row(0).setTo(40000);
+
+    // 16-bit input is equalized directly; other types are converted first
+    cv::Mat floatReslice;
+    _reslice.convertTo(floatReslice, CV_32F);
+    auto expected = IntensityMap(_reslice, 1, 50, false).sortedMaxima();
+    auto result = IntensityMap(floatReslice, 1, 50, false).sortedMaxima();
+
+    ASSERT_EQ(result.size(), expected.size());
+    for (std::size_t i = 0; i < result.size(); ++i) {
+        EXPECT_EQ(result[i].first, expected[i].first);
+        EXPECT_DOUBLE_EQ(result[i].second, expected[i].second);
+    }
+}
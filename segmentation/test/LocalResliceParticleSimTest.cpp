@@ -116,6 +116,29 @@ TEST_F(LocalResliceSegmentationFix, DefaultSegmentationTest)
     EXPECT_TRUE(diffCount < maxAllowedDiffCount);
 }
 
+// Candidate generation is parallel, but must not change the result
+TEST_F(LocalResliceSegmentationFix, ThreadCountDoesNotChangeResult)
+{
+    auto pathSeed = pkg_.segmentation("starting-path")->getPointSet().getRow(0);
+
+    auto run = [this, &pathSeed](std::size_t threads) {
+        LocalResliceSegmentation segmenter;
+        segmenter.setChain(pathSeed);
+        segmenter.setVolume(pkg_.volume());
+        segmenter.setTargetZIndex(182);
+        segmenter.setMaterialThickness(pkg_.materialThickness());
+        segmenter.setNumThreads(threads);
+        return segmenter.compute();
+    };
+
+    auto serial = run(1);
+    auto parallel = run(4);
+    ASSERT_EQ(serial.size(), parallel.size());
+    for (size_t i = 0; i < serial.size(); ++i) {
+        EXPECT_EQ(serial[i], parallel[i]);
+    }
+}
+
 std::ostream& operator<<(std::ostream& s, PointXYZ p)
 {
     return s << "[" << p.x << ", " << p.y << ", " << p.z << "]";
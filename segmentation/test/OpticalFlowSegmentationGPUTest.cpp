@@ -0,0 +1,87 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <iostream>
+
+#include <opencv2/core.hpp>
+
+#include "vc/core/types/VolumePkg.hpp"
+#include "vc/segmentation/OpticalFlowSegmentation.hpp"
+
+using namespace volcart::segmentation;
+
+namespace
+{
+auto HasGPU() -> bool
+{
+    if (not OpticalFlowSegmentation::GPUAvailable()) {
+        std::cout << "No CUDA device available. Skipping." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+auto Normalized(const cv::Mat& slice) -> cv::Mat
+{
+    cv::Mat gray;
+    cv::normalize(slice, gray, 0, 255, cv::NORM_MINMAX, CV_8UC1);
+    return gray;
+}
+}  // namespace
+
+TEST(OpticalFlowSegmentationGPU, FlowMatchesCPU)
+{
+    if (not HasGPU()) {
+        return;
+    }
+    volcart::VolumePkg pkg{"Testing.volpkg"};
+    auto vol = pkg.volume();
+    for (int z = 50; z < 55; z++) {
+        auto gray1 = Normalized(vol->getSliceDataCopy(z));
+        auto gray2 = Normalized(vol->getSliceDataCopy(z + 1));
+        auto cpu = OpticalFlowSegmentation::OpticalFlow(gray1, gray2, false);
+        auto gpu = OpticalFlowSegmentation::OpticalFlow(gray1, gray2, true);
+        ASSERT_EQ(cpu.size(), gpu.size());
+        ASSERT_EQ(cpu.type(), CV_32FC2);
+        ASSERT_EQ(gpu.type(), CV_32FC2);
+
+        // The implementations differ slightly, but not in displacement
+        cv::Mat diff;
+        cv::absdiff(cpu, gpu, diff);
+        EXPECT_LT(cv::mean(diff)[0], 0.1);
+        EXPECT_LT(cv::mean(diff)[1], 0.1);
+    }
+}
+
+TEST(OpticalFlowSegmentationGPU, SegmentationMatchesCPU)
+{
+    if (not HasGPU()) {
+        return;
+    }
+    volcart::VolumePkg pkg{"Testing.volpkg"};
+    auto chain = pkg.segmentation("starting-path")->getPointSet().getRow(0);
+    auto minZ = std::min_element(
+        chain.begin(), chain.end(),
+        [](const auto& a, const auto& b) { return a[2] < b[2]; });
+    auto target = static_cast<int>((*minZ)[2]) + 10;
+
+    auto run = [&](bool useGPU) {
+        OpticalFlowSegmentation segmenter;
+        segmenter.setVolume(pkg.volume());
+        segmenter.setChain(chain);
+        segmenter.setTargetZIndex(target);
+        segmenter.setUseGPU(useGPU);
+        return segmenter.compute();
+    };
+    auto cpu = run(false);
+    auto gpu = run(true);
+    ASSERT_EQ(cpu.width(), gpu.width());
+    ASSERT_EQ(cpu.height(), gpu.height());
+
+    // Points stay within a voxel of the CPU result on average
+    double dist{0};
+    for (std::size_t i = 0; i < cpu.size(); i++) {
+        dist += cv::norm(cpu[i] - gpu[i]);
+    }
+    EXPECT_LT(dist / static_cast<double>(cpu.size()), 1.0);
+}
@@ -0,0 +1,110 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <stdexcept>
+
+#include "vc/segmentation/stps/ForceChain.hpp"
+#include "vc/segmentation/stps/ParticleChain.hpp"
+
+using namespace volcart::segmentation;
+
+// Fixture for a bent chain of particles
+class BentParticleChain : public ::testing::Test
+{
+public:
+    ParticleChain _chain;
+    ForceChain _forces;
+
+    BentParticleChain()
+    {
+        for (int i = 0; i < 10; ++i) {
+            _chain.emplace_back(cv::Vec3d(i, 0.5 * i * i, 2));
+            _forces.emplace_back(1.0, -i, 0.5 * i);
+        }
+    }
+};
+
+TEST_F(BentParticleChain, ElementAccess)
+{
+    ASSERT_EQ(_chain.size(), 10);
+    ASSERT_EQ(_forces.size(), 10);
+    EXPECT_EQ(_chain[3].pos(), cv::Vec3d(3, 4.5, 2));
+    EXPECT_EQ(_chain.pos(3), cv::Vec3d(3, 4.5, 2));
+    EXPECT_EQ(_forces[4], Force(1, -4, 2));
+
+    _chain.setPos(3, {1, 2, 3});
+    EXPECT_EQ(_chain.pos(3), cv::Vec3d(1, 2, 3));
+    _forces.set(4, {3, 2, 1});
+    EXPECT_EQ(_forces[4], Force(3, 2, 1));
+
+    _chain.clear();
+    _forces.clear();
+    EXPECT_EQ(_chain.size(), 0);
+    EXPECT_EQ(_forces.size(), 0);
+}
+
+TEST_F(BentParticleChain, RestingLengths)
+{
+    _chain.updateRestingLengths();
+    for (size_t i = 0; i < _chain.size(); ++i) {
+        auto p = _chain[i];
+        if (i > 0) {
+            EXPECT_DOUBLE_EQ(
+                p.restingL(), cv::norm(_chain.pos(i) - _chain.pos(i - 1)));
+        } else {
+            EXPECT_EQ(p.restingL(), 0);
+        }
+
+        if (i + 1 < _chain.size()) {
+            EXPECT_DOUBLE_EQ(
+                p.restingR(), cv::norm(_chain.pos(i + 1) - _chain.pos(i)));
+        } else {
+            EXPECT_EQ(p.restingR(), 0);
+        }
+    }
+
+    // Resting lengths are copied with the chain
+    ParticleChain copy(ParticleChain::Chain{_chain[0], _chain[1]});
+    EXPECT_EQ(copy[1].restingL(), _chain[1].restingL());
+    EXPECT_EQ(copy[0].restingR(), _chain[0].restingR());
+}
+
+TEST_F(BentParticleChain, AddForces)
+{
+    auto moved = _chain + 0.5 * _forces;
+    auto scaled = _chain;
+    scaled.addScaled(_forces, 0.5);
+    for (size_t i = 0; i < _chain.size(); ++i) {
+        auto expected = _chain.pos(i) + 0.5 * _forces[i];
+        EXPECT_EQ(moved.pos(i), expected);
+        EXPECT_EQ(scaled.pos(i), expected);
+    }
+
+    auto sum = _forces + _forces;
+    auto axpy = _forces;
+    axpy.addScaled(_forces, 2);
+    for (size_t i = 0; i < _forces.size(); ++i) {
+        EXPECT_EQ(sum[i], 2 * _forces[i]);
+        EXPECT_EQ(axpy[i], 3 * _forces[i]);
+    }
+
+    ForceChain shorter(ForceChain::Chain{{1, 2, 3}});
+    EXPECT_THROW(_chain += shorter, std::domain_error);
+    EXPECT_THROW(_forces += shorter, std::domain_error);
+}
+
+TEST_F(BentParticleChain, NormalizeForces)
+{
+    _forces.push_back({0, 0, 0});
+    ForceChain::Normalize(_forces, 2.0);
+    for (size_t i = 0; i + 1 < _forces.size(); ++i) {
+        EXPECT_NEAR(cv::norm(_forces[i]), 2.0, 1e-12);
+    }
+
+    // Zero forces stay zero
+    EXPECT_EQ(_forces[_forces.size() - 1], Force(0, 0, 0));
+
+    ForceChain zeros(3);
+    ForceChain::Normalize(zeros);
+    EXPECT_EQ(zeros[2], Force(0, 0, 0));
+}
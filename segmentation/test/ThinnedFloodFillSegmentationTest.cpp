@@ -0,0 +1,55 @@
+#include <gtest/gtest.h>
+
+#include "vc/core/types/VolumePkg.hpp"
+#include "vc/segmentation/ThinnedFloodFillSegmentation.hpp"
+
+using namespace volcart::segmentation;
+
+// Slice processing is pipelined and parallel, but must not change the result
+TEST(ThinnedFloodFillSegmentation, ThreadCountDoesNotChangeResult)
+{
+    volcart::VolumePkg pkg{"Testing.volpkg"};
+    auto pathSeed = pkg.segmentation("starting-path")->getPointSet().getRow(0);
+
+    auto run = [&pkg, &pathSeed](std::size_t threads) {
+        ThinnedFloodFillSegmentation segmenter;
+        segmenter.setSeedPoints(pathSeed);
+        segmenter.setVolume(pkg.volume());
+        segmenter.setIterations(10);
+        segmenter.setNumThreads(threads);
+        auto result = segmenter.compute();
+        return std::make_pair(result, segmenter.getVolumetricMask());
+    };
+
+    auto [serial, serialMask] = run(1);
+    auto [parallel, parallelMask] = run(4);
+    ASSERT_EQ(serial.size(), parallel.size());
+    for (std::size_t i = 0; i < serial.size(); ++i) {
+        EXPECT_EQ(serial[i], parallel[i]);
+    }
+
+    ASSERT_EQ(serialMask->size(), parallelMask->size());
+    for (const auto& v : *serialMask) {
+        EXPECT_TRUE(parallelMask->isIn(v));
+    }
+}
+
+// Segmentation stops at the last slice instead of reading past the volume
+TEST(ThinnedFloodFillSegmentation, StopsAtEndOfVolume)
+{
+    volcart::VolumePkg pkg{"Testing.volpkg"};
+    auto vol = pkg.volume();
+    auto pathSeed = pkg.segmentation("starting-path")->getPointSet().getRow(0);
+
+    for (std::size_t threads : {1, 4}) {
+        ThinnedFloodFillSegmentation segmenter;
+        segmenter.setSeedPoints(pathSeed);
+        segmenter.setVolume(vol);
+        segmenter.setIterations(vol->numSlices() + 10);
+        segmenter.setNumThreads(threads);
+        auto result = segmenter.compute();
+        for (const auto& v : result) {
+            EXPECT_LT(v[2], static_cast<double>(vol->numSlices()));
+        }
+    }
+}
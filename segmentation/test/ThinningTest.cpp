@@ -0,0 +1,94 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+
+#include "vc/segmentation/tff/Thinning.hpp"
+
+using namespace volcart::segmentation;
+
+// Mask with a thick horizontal band and a blob attached to it
+static auto MakeMask() -> cv::Mat
+{
+    cv::Mat mask = cv::Mat::zeros(60, 80, CV_8UC1);
+    mask(cv::Rect(5, 20, 70, 10)).setTo(255);
+    cv::circle(mask, {40, 40}, 8, 255, cv::FILLED);
+    return mask;
+}
+
+// Horizontal line in row 25 from x = 5 to x = 44
+static auto MakeLine() -> cv::Mat
+{
+    cv::Mat img = cv::Mat::zeros(50, 50, CV_8UC1);
+    img(cv::Rect(5, 25, 40, 1)).setTo(255);
+    return img;
+}
+
+static auto NumComponents(const cv::Mat& img) -> int
+{
+    cv::Mat labels;
+    return cv::connectedComponents(img, labels, 8) - 1;
+}
+
+TEST(Thinning, ThinsToConnectedSkeleton)
+{
+    auto mask = MakeMask();
+    auto skeleton = mask.clone();
+    ThinMask(skeleton);
+
+    // Skeleton is much smaller and lies inside the mask
+    EXPECT_GT(cv::countNonZero(skeleton), 0);
+    EXPECT_LT(cv::countNonZero(skeleton), cv::countNonZero(mask) / 4);
+    cv::Mat outside = skeleton & ~mask;
+    EXPECT_EQ(cv::countNonZero(outside), 0);
+
+    // Thinning keeps the mask connected
+    EXPECT_EQ(NumComponents(skeleton), NumComponents(mask));
+
+    // The skeleton is already thin
+    auto again = skeleton.clone();
+    ThinMask(again);
+    EXPECT_EQ(cv::countNonZero(again != skeleton), 0);
+}
+
+TEST(Thinning, ThreadCountDoesNotChangeResult)
+{
+    auto serial = MakeMask();
+    ThinMask(serial, 1);
+    for (std::size_t threads : {2, 4, 7}) {
+        auto parallel = MakeMask();
+        ThinMask(parallel, threads);
+        EXPECT_EQ(cv::countNonZero(parallel != serial), 0)
+            << threads << " threads";
+    }
+}
+
+TEST(Thinning, EmptyMask)
+{
+    cv::Mat mask = cv::Mat::zeros(10, 10, CV_8UC1);
+    ThinMask(mask, 4);
+    PruneSpurs(mask, 6);
+    EXPECT_EQ(cv::countNonZero(mask), 0);
+}
+
+TEST(Thinning, PruneShortSpur)
+{
+    auto line = MakeLine();
+    auto skeleton = line.clone();
+    skeleton(cv::Rect(25, 22, 1, 3)).setTo(255);
+    PruneSpurs(skeleton, 6);
+
+    // The spur is removed and the line is unchanged
+    EXPECT_EQ(cv::countNonZero(skeleton != line), 0);
+}
+
+TEST(Thinning, KeepLongBranch)
+{
+    auto skeleton = MakeLine();
+    skeleton(cv::Rect(25, 10, 1, 15)).setTo(255);
+    auto expected = skeleton.clone();
+    PruneSpurs(skeleton, 6);
+    EXPECT_EQ(cv::countNonZero(skeleton != expected), 0);
+}
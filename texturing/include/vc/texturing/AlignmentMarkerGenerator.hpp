@@ -20,6 +20,9 @@ namespace volcart::texturing
  *
  * @note Output images will be 8bpc and 3-channel (BGR)
  *
+ * Meshes, and the line segments of each mesh, are intersected in parallel on
+ * the global ThreadPool.
+ *
  * @warning Line segments do not have to be parallel to each other, nor do they
  * have to be perpendicular to the surfaces of the meshes. Improperly setting
  * the position of segment end points can result in alignment markers that make
@@ -70,6 +73,9 @@ public:
     std::vector<cv::Mat> getMarkedImages() const;
 
 private:
+    /** Draw the markers on a single mesh's texture */
+    cv::Mat mark_mesh_(const TexturedMesh& m) const;
+
     /** Input meshes */
     std::vector<volcart::TexturedMesh> input_;
     /** Intersection line segments */
@@ -23,6 +23,10 @@ namespace volcart::texturing
  * Implementation provided by the
  * [OpenABF library](https://gitlab.com/educelab/OpenABF).
  *
+ * A mesh which has changed only slightly since it was last flattened can be
+ * re-flattened much faster by seeding the solver with its previous UV map.
+ * See setSeedUVMap().
+ *
  * @ingroup UV
  */
 class AngleBasedFlattening : public FlatteningAlgorithm
@@ -31,6 +35,41 @@ public:
     /** Default maximum number of ABF iterations */
     static const std::size_t DEFAULT_ITERATIONS{10};
 
+    /**
+     * Minimum fraction of faces which must be mapped by the seed UV map for
+     * it to be used
+     */
+    static constexpr double MIN_SEED_COVERAGE{0.5};
+
+    /**
+     * Maximum difference in radians between a face's angles in the seed UV
+     * map and its current 3D angles for its seeded angles to be used
+     */
+    static constexpr double MAX_SEED_ANGLE_CHANGE{0.1};
+
+    /**
+     * @brief Sparse solvers for the LSCM system
+     *
+     * The LSCM system is symmetric positive definite, so all of these
+     * produce the same parameterization up to solver precision.
+     */
+    enum class Solver {
+        /** Eigen sparse LU decomposition */
+        SparseLU = 0,
+        /** Eigen simplicial Cholesky (LDL^T) decomposition */
+        SimplicialLDLT,
+        /**
+         * Eigen conjugate gradient. Multithreaded if Eigen is compiled with
+         * OpenMP.
+         */
+        ConjugateGradient,
+        /**
+         * CHOLMOD supernodal Cholesky decomposition. Only available if
+         * built with SuiteSparse.
+         */
+        Cholmod
+    };
+
     /** Pointer */
     using Pointer = std::shared_ptr<AngleBasedFlattening>;
 
@@ -70,6 +109,60 @@ public:
 
     /** @copydoc setABFMaxIterations(std::size_t) */
     [[nodiscard]] auto abfMaxIterations() const -> std::size_t;
+
+    /**
+     * @brief Seed the parameterization with a prior UV map
+     *
+     * `uv` must be indexed by the vertices of the input mesh, e.g. the UV map
+     * of an earlier version of the mesh whose vertices have since been moved.
+     * Every face whose vertices all have a coordinate in `uv`, and whose
+     * interior angles in `uv` are within MAX_SEED_ANGLE_CHANGE of its current
+     * 3D angles, keeps its angles from `uv`. The remaining faces, including
+     * those whose geometry has changed since `uv` was computed, are re-solved
+     * from their current 3D angles. LSCM is then solved directly from these
+     * angles, and ABF++ is skipped, since the seeded angles have already been
+     * optimized. The number of re-solved changed faces is reported by
+     * seedChangedFaces().
+     *
+     * If less than MIN_SEED_COVERAGE of the faces are mapped and unchanged,
+     * the seed is ignored with a warning and the mesh is flattened as if
+     * unseeded. Pass `nullptr` to clear the seed.
+     */
+    void setSeedUVMap(const UVMap::Pointer& uv);
+
+    /** @copydoc setSeedUVMap(const UVMap::Pointer&) */
+    [[nodiscard]] auto seedUVMap() const -> UVMap::Pointer;
+
+    /**
+     * @brief Set the sparse solver used by LSCM
+     *
+     * If the selected solver is not available in this build, SparseLU is used
+     * instead. Default: Solver::SparseLU
+     */
+    void setSolver(Solver s);
+
+    /** @copydoc setSolver(Solver) */
+    [[nodiscard]] auto solver() const -> Solver;
+
+    /** @brief Whether a solver is available in this build */
+    static auto SolverAvailable(Solver s) -> bool;
+    /**@}*/
+
+    /**@{*/
+    /** @brief Number of ABF++ iterations performed by the last compute() */
+    [[nodiscard]] auto abfIterations() const -> std::size_t;
+
+    /** @brief Final ABF++ gradient norm of the last compute() */
+    [[nodiscard]] auto abfGradientNorm() const -> double;
+
+    /** @brief Whether the last compute() was seeded by the seed UV map */
+    [[nodiscard]] auto seeded() const -> bool;
+
+    /**
+     * @brief Number of seeded faces whose geometry had changed and which
+     * were re-solved by the last compute()
+     */
+    [[nodiscard]] auto seedChangedFaces() const -> std::size_t;
     /**@}*/
 
     /**@{*/
@@ -82,5 +175,17 @@ private:
     bool useABF_{true};
     /** Maximum number of ABF minimization iterations */
     std::size_t maxABFIterations_{DEFAULT_ITERATIONS};
+    /** LSCM solver */
+    Solver solver_{Solver::SparseLU};
+    /** Prior UV map used to seed the face angles */
+    UVMap::Pointer seed_;
+    /** ABF iterations performed by the last compute() */
+    std::size_t abfIters_{0};
+    /** Final ABF gradient norm of the last compute() */
+    double abfGrad_{0};
+    /** Whether the last compute() used the seed */
+    bool seeded_{false};
+    /** Number of changed seeded faces in the last compute() */
+    std::size_t seedChangedFaces_{0};
 };
 }  // namespace volcart::texturing
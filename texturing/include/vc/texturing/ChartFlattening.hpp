@@ -0,0 +1,124 @@
+#pragma once
+
+/** @file */
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "vc/texturing/AngleBasedFlattening.hpp"
+#include "vc/texturing/FlatteningAlgorithm.hpp"
+
+namespace volcart::texturing
+{
+/**
+ * @brief Computes a 2D parameterization of a mesh made of several charts
+ *
+ * AngleBasedFlattening solves the whole mesh as a single system, and fails
+ * if the mesh has more than one connected component. This class instead
+ * splits the mesh into charts, the sets of faces connected by shared
+ * vertices, and flattens every chart independently with
+ * AngleBasedFlattening. Charts are flattened in parallel on the global
+ * ThreadPool, largest first. Solving several small systems is considerably
+ * faster than solving one large one.
+ *
+ * The flattened charts keep their relative scale and are packed into rows
+ * (shelves) of a single, roughly square atlas, tallest chart first, with a
+ * gap of setPadding() between neighbouring charts. Vertices which do not
+ * belong to any face are placed at the origin of the atlas.
+ *
+ * A mesh with a single chart is flattened exactly like AngleBasedFlattening.
+ * Each chart must still be manifold.
+ *
+ * @ingroup UV
+ */
+class ChartFlattening : public FlatteningAlgorithm
+{
+public:
+    /** Default gap between charts, as a fraction of the atlas size */
+    static constexpr double DEFAULT_PADDING{0.01};
+
+    /** Shared pointer type */
+    using Pointer = std::shared_ptr<ChartFlattening>;
+
+    /**@{*/
+    /** @brief Default constructor */
+    ChartFlattening() = default;
+
+    /** @brief Construct and set the input mesh */
+    explicit ChartFlattening(const ITKMesh::Pointer& m);
+
+    /** Make a new shared instance */
+    template <typename... Args>
+    static auto New(Args... args) -> Pointer
+    {
+        return std::make_shared<ChartFlattening>(std::forward<Args>(args)...);
+    }
+
+    /** Default destructor */
+    ~ChartFlattening() override = default;
+    /**@}*/
+
+    /**@{*/
+    /** @copydoc AngleBasedFlattening::setUseABF(bool) */
+    void setUseABF(bool a);
+
+    /** @copydoc AngleBasedFlattening::setUseABF(bool) */
+    [[nodiscard]] auto useABF() const -> bool;
+
+    /** @copydoc AngleBasedFlattening::setABFMaxIterations(std::size_t) */
+    void setABFMaxIterations(std::size_t i);
+
+    /** @copydoc AngleBasedFlattening::setABFMaxIterations(std::size_t) */
+    [[nodiscard]] auto abfMaxIterations() const -> std::size_t;
+
+    /** @copydoc AngleBasedFlattening::setSolver() */
+    void setSolver(AngleBasedFlattening::Solver s);
+
+    /** @copydoc AngleBasedFlattening::setSolver() */
+    [[nodiscard]] auto solver() const -> AngleBasedFlattening::Solver;
+
+    /**
+     * @brief Set the gap between packed charts
+     *
+     * Relative to the square root of the total area of the chart bounding
+     * boxes. Default: DEFAULT_PADDING
+     */
+    void setPadding(double p);
+
+    /** @copydoc setPadding(double) */
+    [[nodiscard]] auto padding() const -> double;
+    /**@}*/
+
+    /**@{*/
+    /** @brief Compute the parameterization */
+    auto compute() -> ITKMesh::Pointer override;
+
+    /** @brief Number of charts found by the last compute() */
+    [[nodiscard]] auto numCharts() const -> std::size_t;
+
+    /**
+     * @brief Chart index of every face, as found by the last compute()
+     *
+     * Charts are numbered in order of their first face.
+     */
+    [[nodiscard]] auto faceCharts() const -> const std::vector<std::size_t>&;
+    /**@}*/
+
+private:
+    /** Use ABF++ when flattening each chart */
+    bool useABF_{true};
+    /** Maximum number of ABF++ iterations */
+    std::size_t maxABFIterations_{AngleBasedFlattening::DEFAULT_ITERATIONS};
+    /** LSCM solver */
+    AngleBasedFlattening::Solver solver_{
+        AngleBasedFlattening::Solver::SparseLU};
+    /** Gap between charts */
+    double padding_{DEFAULT_PADDING};
+    /** Number of charts */
+    std::size_t numCharts_{0};
+    /** Chart index of every face */
+    std::vector<std::size_t> faceCharts_;
+};
+
+}  // namespace volcart::texturing
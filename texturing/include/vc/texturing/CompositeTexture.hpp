@@ -66,29 +66,38 @@ public:
     /**@{*/
     /** @brief Compute the Texture */
     Texture compute() override;
+
+    /**
+     * @brief Filter a 1D neighborhood with the given filter
+     *
+     * This is the per-pixel operation used by compute(). The neighborhood is
+     * not copied, except into a reused buffer for the selection-based
+     * filters. Returns `0` for an empty neighborhood.
+     */
+    static uint16_t FilterNeighborhood(const Neighborhood& n, Filter f);
+
+    /** @overload FilterNeighborhood(const Neighborhood&, Filter) */
+    static uint16_t FilterNeighborhood(
+        NDArrayView<const uint16_t> n, Filter f);
     /**@}*/
 
 private:
     /** Neighborhood shape */
     NeighborhoodGenerator::Pointer gen_;
-    /** Get neighborhood */
-    Neighborhood get_neighborhood_(const cv::Vec3d& p, const cv::Vec3d& n);
 
     /** Filter method */
     Filter filter_{Filter::Maximum};
 
-    /** Filter a neighborhood based on filter_ */
-    uint16_t filter_neighborhood_(const Neighborhood& n);
     /** Return the minimum value */
-    uint16_t min_(Neighborhood n);
+    static uint16_t min_(NDArrayView<const uint16_t> n);
     /** Return the maximum value */
-    uint16_t max_(Neighborhood n);
+    static uint16_t max_(NDArrayView<const uint16_t> n);
     /** Return the median value */
-    uint16_t median_(Neighborhood n);
+    static uint16_t median_(NDArrayView<const uint16_t> n);
     /** Return the average value */
-    uint16_t mean_(Neighborhood n);
+    static uint16_t mean_(NDArrayView<const uint16_t> n);
     /** Return the average of the median `range`. `range` is [0, 1] and is
      * a percent of the neighborhood. */
-    uint16_t median_mean_(Neighborhood n, double range);
+    static uint16_t median_mean_(NDArrayView<const uint16_t> n, double range);
 };
 }  // namespace volcart::texturing
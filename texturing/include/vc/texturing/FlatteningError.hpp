@@ -6,7 +6,7 @@
 
 #include "vc/core/types/ITKMesh.hpp"
 #include "vc/core/util/ColorMaps.hpp"
-#include "vc/core/util/Iteration.hpp"
+#include "vc/core/util/ThreadPool.hpp"
 
 namespace volcart::texturing
 {
@@ -20,6 +20,9 @@ namespace volcart::texturing
  * @param defaultValue Default pixel value if it doesn't have a cell mapping
  * @return Image of error plot with type `CV_32FC1`
  *
+ * Rows are plotted in parallel, so `errorMap.at()` must be safe to call
+ * concurrently.
+ *
  * @ingroup UV Parameterization
  */
 template <typename ErrContainer>
@@ -29,14 +32,18 @@ cv::Mat PlotPerFaceError(
     float defaultValue = 0)
 {
     cv::Mat output(cellMap.rows, cellMap.cols, CV_32FC1);
-    output = cv::Scalar::all(defaultValue);
-    for (const auto& [y, x] : range2D(cellMap.rows, cellMap.cols)) {
-        auto cell = cellMap.at<int32_t>(y, x);
-        if (cell >= 0) {
-            auto error = errorMap.at(cell);
-            output.at<float>(y, x) = static_cast<float>(error);
+    auto rows = static_cast<std::size_t>(cellMap.rows);
+    ParallelChunks(rows, 0, [&](std::size_t begin, std::size_t end) {
+        for (auto y = static_cast<int>(begin); y < static_cast<int>(end); y++) {
+            const auto* cells = cellMap.ptr<int32_t>(y);
+            auto* out = output.ptr<float>(y);
+            for (int x = 0; x < cellMap.cols; x++) {
+                auto cell = cells[x];
+                out[x] = (cell >= 0) ? static_cast<float>(errorMap.at(cell))
+                                     : defaultValue;
+            }
         }
-    }
+    });
     return output;
 }
 
@@ -89,10 +96,20 @@ struct LStretchMetrics {
  * more info on these metrics. Meshes are assumed to be pre-scaled to have the
  * same surface area.
  *
+ * Faces are processed in parallel. The global metrics are reduced in a fixed
+ * order, so the result does not depend on the number of threads.
+ *
+ * @param mesh3D Original mesh
+ * @param mesh2D Flattened mesh
+ * @param numThreads Number of threads. If `0`, uses every thread in the global
+ * ThreadPool.
+ *
  * @ingroup UV Parameterization
  */
 LStretchMetrics LStretch(
-    const ITKMesh::Pointer& mesh3D, const ITKMesh::Pointer& mesh2D);
+    const ITKMesh::Pointer& mesh3D,
+    const ITKMesh::Pointer& mesh2D,
+    std::size_t numThreads = 0);
 
 /**
  * @brief Calculates the inverse LStretchMetrics plotting error relative to the
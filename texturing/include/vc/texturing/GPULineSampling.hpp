@@ -0,0 +1,123 @@
+#pragma once
+
+/** @file */
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+#include "vc/core/neighborhood/NeighborhoodGenerator.hpp"
+#include "vc/core/types/PerPixelMap.hpp"
+#include "vc/core/types/Volume.hpp"
+
+/**
+ * @brief GPU backend for line neighborhood texturing
+ *
+ * Most texturing algorithms sample a line along the surface normal of every
+ * PPM pixel and reduce the samples to a single value. These functions run
+ * that loop on a CUDA device. The mapped pixels are processed in batches.
+ * For each batch, the subvolume which contains every sample of the batch is
+ * copied from the Volume with Volume::copyLattice() and uploaded to the
+ * device, and one device thread samples and reduces each pixel.
+ *
+ * Sample positions and trilinear interpolation are computed in double
+ * precision in the same order as LineGenerator and Volume::interpolateAt(),
+ * so the samples match the CPU path.
+ *
+ * The backend is only compiled if the project is configured with
+ * `VC_WITH_CUDA`. Use Available() to check for it at runtime.
+ *
+ * @ingroup Texture
+ */
+namespace volcart::texturing::gpu
+{
+/** @brief Maximum number of samples per line supported by the kernels */
+constexpr std::size_t MAX_LINE_SAMPLES{256};
+
+/** @brief Line sampled at every pixel */
+struct LineParams {
+    /** Offset along the normal of the first sample */
+    double start{0};
+    /** Offset between samples */
+    double interval{1};
+    /** Number of samples */
+    std::size_t count{1};
+};
+
+/** @brief Per-pixel reductions of the line samples */
+enum class LineReduction {
+    /** Minimum sample */
+    Minimum = 0,
+    /** Maximum sample */
+    Maximum,
+    /** Median sample */
+    Median,
+    /** Rounded mean of the samples */
+    Mean,
+    /** Rounded mean of the middle samples. See CompositeLines(). */
+    MedianAverage
+};
+
+/** @brief Progress callback. Called with the number of pixels completed. */
+using Progress = std::function<void(std::size_t)>;
+
+/**
+ * @brief Whether the CUDA backend was compiled and a device is available
+ */
+auto Available() -> bool;
+
+/**
+ * @brief Get the line sampled by a neighborhood generator
+ *
+ * Returns false, and logs the reason, if the backend is not available or
+ * cannot sample the neighborhoods of `gen`. Only LineGenerator neighborhoods
+ * of at most MAX_LINE_SAMPLES samples are supported.
+ */
+auto GetLineParams(const NeighborhoodGenerator& gen, LineParams& line) -> bool;
+
+/**
+ * @brief Reduce the line at every mapped pixel to an intensity
+ *
+ * Produces the same values as CompositeTexture with a LineGenerator. For
+ * LineReduction::MedianAverage, the mean is taken over the middle
+ * `medianRange` fraction of the sorted samples.
+ *
+ * @param image Output image. Must be CV_16UC1 and the size of the PPM.
+ *
+ * @throws std::runtime_error If the backend is not available or the line has
+ * more than MAX_LINE_SAMPLES samples
+ */
+void CompositeLines(
+    const Volume& vol,
+    const PerPixelMap& ppm,
+    const LineParams& line,
+    LineReduction reduction,
+    double medianRange,
+    cv::Mat& image,
+    const Progress& progress = nullptr);
+
+/**
+ * @brief Weighted sum of the line at every mapped pixel
+ *
+ * Each pixel is the sum of `weights[i] * lut[v[i]]` over its samples `v`.
+ *
+ * @param weights One weight per sample
+ * @param lut Value of each possible intensity. Must have 65536 entries.
+ * @param image Output image. Must be CV_32FC1 and the size of the PPM.
+ *
+ * @throws std::invalid_argument If `weights` or `lut` has the wrong size
+ * @throws std::runtime_error If the backend is not available or the line has
+ * more than MAX_LINE_SAMPLES samples
+ */
+void IntegrateLines(
+    const Volume& vol,
+    const PerPixelMap& ppm,
+    const LineParams& line,
+    const std::vector<double>& weights,
+    const std::vector<double>& lut,
+    cv::Mat& image,
+    const Progress& progress = nullptr);
+}  // namespace volcart::texturing::gpu
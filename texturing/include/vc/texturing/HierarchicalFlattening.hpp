@@ -0,0 +1,125 @@
+#pragma once
+
+/** @file */
+
+#include <cstddef>
+#include <memory>
+
+#include "vc/texturing/AngleBasedFlattening.hpp"
+#include "vc/texturing/FlatteningAlgorithm.hpp"
+
+namespace volcart::texturing
+{
+/**
+ * @brief Computes a 2D parameterization of a large triangular mesh by
+ * flattening a resampled proxy mesh
+ *
+ * The cost of ABF++ and LSCM grows quickly with the number of faces. This
+ * class instead flattens an ACVD-resampled proxy of the input mesh with
+ * AngleBasedFlattening. Each vertex of the full-resolution mesh is then
+ * projected onto the closest proxy face, and its UV position is interpolated
+ * from that face's flattened vertices. Finally, the interior vertices are
+ * locally relaxed with a few Gauss-Seidel iterations of the cotangent
+ * (harmonic) Laplacian, which removes the small distortions introduced by
+ * interpolation.
+ *
+ * Meshes which are not larger than the proxy are flattened directly.
+ *
+ * @ingroup UV
+ */
+class HierarchicalFlattening : public FlatteningAlgorithm
+{
+public:
+    /** Default number of vertices in the proxy mesh */
+    static constexpr std::size_t DEFAULT_PROXY_VERTICES{50000};
+    /** Default number of relaxation iterations */
+    static constexpr std::size_t DEFAULT_RELAX_ITERATIONS{10};
+
+    /** Shared pointer type */
+    using Pointer = std::shared_ptr<HierarchicalFlattening>;
+
+    /**@{*/
+    /** @brief Default constructor */
+    HierarchicalFlattening() = default;
+
+    /** @brief Construct and set the input mesh */
+    explicit HierarchicalFlattening(const ITKMesh::Pointer& m);
+
+    /** Make a new shared instance */
+    template <typename... Args>
+    static auto New(Args... args) -> Pointer
+    {
+        return std::make_shared<HierarchicalFlattening>(
+            std::forward<Args>(args)...);
+    }
+
+    /** Default destructor */
+    ~HierarchicalFlattening() override = default;
+    /**@}*/
+
+    /**@{*/
+    /** @brief Set the target number of vertices in the proxy mesh */
+    void setProxyVertices(std::size_t n);
+
+    /** @copydoc setProxyVertices(std::size_t) */
+    [[nodiscard]] auto proxyVertices() const -> std::size_t;
+
+    /**
+     * @brief Set the number of relaxation iterations applied to the
+     * full-resolution UVs
+     *
+     * If 0, UVs are only interpolated from the proxy.
+     */
+    void setRelaxationIterations(std::size_t n);
+
+    /** @copydoc setRelaxationIterations(std::size_t) */
+    [[nodiscard]] auto relaxationIterations() const -> std::size_t;
+
+    /** @copydoc AngleBasedFlattening::setUseABF(bool) */
+    void setUseABF(bool a);
+
+    /** @copydoc AngleBasedFlattening::setUseABF(bool) */
+    [[nodiscard]] auto useABF() const -> bool;
+
+    /** @copydoc AngleBasedFlattening::setABFMaxIterations(std::size_t) */
+    void setABFMaxIterations(std::size_t i);
+
+    /** @copydoc AngleBasedFlattening::setABFMaxIterations(std::size_t) */
+    [[nodiscard]] auto abfMaxIterations() const -> std::size_t;
+
+    /** @copydoc AngleBasedFlattening::setSolver() */
+    void setSolver(AngleBasedFlattening::Solver s);
+
+    /** @copydoc AngleBasedFlattening::setSolver() */
+    [[nodiscard]] auto solver() const -> AngleBasedFlattening::Solver;
+    /**@}*/
+
+    /**@{*/
+    /** @brief Compute the parameterization */
+    auto compute() -> ITKMesh::Pointer override;
+
+    /**
+     * @brief Get the proxy mesh used by the last compute()
+     *
+     * Returns the input mesh if it was flattened directly.
+     */
+    [[nodiscard]] auto getProxyMesh() const -> ITKMesh::Pointer;
+    /**@}*/
+
+private:
+    /** Target number of proxy vertices */
+    std::size_t proxyVerts_{DEFAULT_PROXY_VERTICES};
+    /** Number of relaxation iterations */
+    std::size_t relaxIters_{DEFAULT_RELAX_ITERATIONS};
+    /** Use ABF++ when flattening the proxy */
+    bool useABF_{true};
+    /** Maximum number of ABF++ iterations */
+    std::size_t maxABFIterations_{AngleBasedFlattening::DEFAULT_ITERATIONS};
+    /** LSCM solver */
+    AngleBasedFlattening::Solver solver_{
+        AngleBasedFlattening::Solver::SparseLU};
+    /** Proxy mesh */
+    ITKMesh::Pointer proxy_;
+};
+
+}  // namespace volcart::texturing
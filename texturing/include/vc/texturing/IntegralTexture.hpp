@@ -2,6 +2,9 @@
 
 /** @file */
 
+#include <cstdint>
+#include <vector>
+
 #include "vc/texturing/TexturingAlgorithm.hpp"
 
 #include "vc/core/neighborhood/NeighborhoodGenerator.hpp"
@@ -12,6 +15,10 @@ namespace volcart::texturing
  * @brief Generate a Texture by taking the discrete integral (summation) of the
  * neighborhood adjacent to a point
  *
+ * The weights depend only on the neighborhood size and the weighting
+ * settings, so they are computed once per call to compute(). Each pixel is
+ * then a single pass over its neighborhood samples.
+ *
  * @ingroup Texture
  */
 class IntegralTexture : public TexturingAlgorithm
@@ -177,21 +184,27 @@ private:
     /** Setup the selected weighting method */
     void setup_weights_();
 
-    /** Apply the selected weighting method */
-    auto apply_weights_(NDArray<double>& n) -> NDArray<double>;
+    /**
+     * Integrate a neighborhood of `size` samples with the weights computed
+     * by setup_weights_()
+     */
+    auto integrate_(const uint16_t* n, std::size_t size) const -> double;
+
+    /** Per-sample weights of integrate_() for the GPU backend */
+    auto gpu_weights_(std::size_t size) const -> std::vector<double>;
+
+    /** Per-intensity values of integrate_() for the GPU backend */
+    auto gpu_lut_() const -> std::vector<double>;
 
     /** Linear weighting direction */
     LinearWeightDirection linearWeight_{LinearWeightDirection::Positive};
 
-    /** Linear weights vector */
-    NDArray<double> linearWeights_{1};
+    /** Linear weights, one per neighborhood sample */
+    std::vector<double> linearWeights_;
 
     /** Setup the linear weights vector */
     void setup_linear_weights_();
 
-    /** Apply the linear weights vector to a neighborhood */
-    auto apply_linear_weights_(NDArray<double>& n) -> NDArray<double>;
-
     /** Exponential diff exponent */
     int expoDiffExponent_{2};
 
@@ -210,17 +223,23 @@ private:
     /** Setup the expo diff weights */
     void setup_expodiff_weights_();
 
-    /** Get the list of intensities on the surface of the mesh */
-    auto expodiff_intersection_pts_() -> std::vector<uint16_t>;
+    /**
+     * Histogram of the (unclamped) intensities on the surface of the mesh,
+     * with one bin per uint16_t value
+     */
+    auto expodiff_histogram_() -> std::vector<uint64_t>;
 
     /** Calculate the mean base value */
-    auto expodiff_mean_base_() -> double;
+    auto expodiff_mean_base_(const std::vector<uint64_t>& hist) -> double;
 
     /** Calculate the mode base value */
-    auto expodiff_mode_base_() -> double;
+    auto expodiff_mode_base_(const std::vector<uint64_t>& hist) -> double;
 
-    /** Apply the expo diff weights to a neighborhood */
-    auto apply_expodiff_weights_(NDArray<double>& n) const -> NDArray<double>;
+    /**
+     * Weighted value of each possible (unclamped) intensity, with clamping
+     * already applied
+     */
+    std::vector<double> expoDiffValues_;
 };
 
 }  // namespace volcart::texturing
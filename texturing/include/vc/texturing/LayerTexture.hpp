@@ -2,8 +2,15 @@
 
 /** @file */
 
+#include <cstddef>
+#include <functional>
+#include <optional>
+
+#include <opencv2/core.hpp>
+
 #include "vc/texturing/TexturingAlgorithm.hpp"
 
+#include "vc/core/filesystem.hpp"
 #include "vc/core/neighborhood/LineGenerator.hpp"
 
 namespace volcart::texturing
@@ -21,6 +28,17 @@ namespace volcart::texturing
  * this amounts to resampling the Volume into a flattened subvolume with the
  * segmentation mesh forming a straight line at its center.
  *
+ * Layer stacks can be larger than the available memory. If a layer writer is
+ * set with setLayerWriter(), the layers are computed in bands of
+ * setBandSize() layers. Each completed layer is passed to the writer and then
+ * released, so only one band is held in memory at a time.
+ *
+ * Alternatively, the layer stack can be written to a chunked, zlib-compressed
+ * Zarr array with setChunkedOutput(). The PPM is split into tiles the width
+ * and height of a chunk, and each tile's column of chunks is computed and
+ * written by one thread, so only one column of chunks per thread is held in
+ * memory and the stack is written in a single pass over the PPM.
+ *
  * @ingroup Texture
  */
 class LayerTexture : public TexturingAlgorithm
@@ -29,6 +47,12 @@ public:
     /** Pointer type */
     using Pointer = std::shared_ptr<LayerTexture>;
 
+    /** Receives each completed layer and its index */
+    using LayerWriter = std::function<void(std::size_t, const cv::Mat&)>;
+
+    /** Default chunk shape (x, y, z) of chunked output */
+    static inline const cv::Vec3i DEFAULT_CHUNK_SHAPE{64, 64, 0};
+
     /** Make shared pointer */
     static Pointer New() { return std::make_shared<LayerTexture>(); }
 
@@ -42,13 +66,78 @@ public:
      */
     void setGenerator(LineGenerator::Pointer g) { gen_ = std::move(g); }
 
+    /**
+     * @brief Set a function which receives each layer once it is complete
+     *
+     * The writer is called from the thread which called compute(), in layer
+     * order. When a writer is set, layers are released after they are
+     * written and compute() returns an empty Texture.
+     */
+    void setLayerWriter(LayerWriter writer) { writer_ = std::move(writer); }
+
+    /**
+     * @brief Set the number of layers computed at a time
+     *
+     * Only used when a layer writer is set. Each band makes a pass over the
+     * PerPixelMap, so smaller bands use less memory but read the Volume
+     * more often. If `0` (default), all layers are computed in one band.
+     */
+    void setBandSize(std::size_t n) { bandSize_ = n; }
+
+    /** @copydoc setBandSize() */
+    std::size_t bandSize() const { return bandSize_; }
+
+    /**
+     * @brief Write the layers to a chunked Zarr array
+     *
+     * The array at `path` has the shape (x, y, z) = (PPM width, PPM height,
+     * number of layers), so that layer `i` is the Z-plane `i` of the array,
+     * and is read by io::ZarrArray and by Volume. A chunk size of `0` along
+     * an axis uses the full size of the array along that axis. The default
+     * chunks hold every layer of a 64x64 pixel patch, so that a patch of the
+     * stack is read from only a few chunks.
+     *
+     * Chunks which contain no mapped pixels are not written. When chunked
+     * output is set, the layer writer and band size are ignored and
+     * compute() returns an empty Texture. Pass std::nullopt to disable.
+     * Default: None
+     *
+     * @see io::ZarrWriter
+     */
+    void setChunkedOutput(
+        std::optional<filesystem::path> path,
+        const cv::Vec3i& chunkShape = DEFAULT_CHUNK_SHAPE)
+    {
+        arrayPath_ = std::move(path);
+        arrayChunks_ = chunkShape;
+    }
+
     /**@{*/
     /** @brief Compute the Texture */
     Texture compute() override;
     /**@}*/
+
+    /** @brief Returns the maximum progress value */
+    size_t progressIterations() const override;
+
 private:
+    /** Number of layers per band */
+    std::size_t band_size_() const;
+    /** Chunk shape of chunked output, with 0 replaced by the array size */
+    cv::Vec3i chunk_shape_() const;
+    /** Compute the layers into the chunked output */
+    void compute_chunked_();
+
     /** Neighborhood Generator */
     LineGenerator::Pointer gen_;
+    /** Layer writer */
+    LayerWriter writer_;
+    /** Number of layers per band when streaming */
+    std::size_t bandSize_{0};
+    /** Path of the chunked output array */
+    std::optional<filesystem::path> arrayPath_;
+    /** Chunk shape of the output array */
+    cv::Vec3i arrayChunks_{DEFAULT_CHUNK_SHAPE};
 };
 
 }  // namespace volcart::texturing
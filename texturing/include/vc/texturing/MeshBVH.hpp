@@ -0,0 +1,131 @@
+#pragma once
+
+/** @file */
+
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+#include "vc/core/filesystem.hpp"
+#include "vc/core/types/FlatMesh.hpp"
+#include "vc/core/types/UVMap.hpp"
+
+namespace volcart::texturing
+{
+/**
+ * @brief Bounding volume hierarchy for ray queries against mesh faces
+ *
+ * Wraps a BVH from the [bvh library](https://github.com/madmann91/bvh) and
+ * the triangles it was built over, so that a single hierarchy can be built
+ * once and shared by every class which intersects rays with the same
+ * faces. PPMGenerator intersects the faces in UV space (see NewUV()), while
+ * ProjectMesh and AlignmentMarkerGenerator intersect them in 3D (see
+ * New()).
+ *
+ * The hierarchy is built top-down with a binned surface area heuristic
+ * (SAH). Large nodes are binned in parallel, and the subtrees below them
+ * are built in parallel on the global ThreadPool. The result does not
+ * depend on the number of threads.
+ *
+ * A built hierarchy can be written to disk with Write() and read with
+ * Read(), which is much faster than building it for large meshes.
+ *
+ * All query functions are safe to call concurrently.
+ *
+ * @ingroup Texture
+ */
+class MeshBVH
+{
+public:
+    /** Pointer type */
+    using Pointer = std::shared_ptr<const MeshBVH>;
+
+    /** Triangle vertex positions */
+    using Triangle = std::array<cv::Vec3d, 3>;
+
+    /** @brief Closest intersection of a ray */
+    struct Hit {
+        /** Index of the intersected face */
+        std::size_t face{0};
+        /** Ray parameter of the intersection */
+        double t{0};
+        /**
+         * Barycentric coordinates of the intersection, weighting the face's
+         * second and third vertices
+         */
+        double u{0};
+        /** @copydoc u */
+        double v{0};
+    };
+
+    /** Maximum number of faces in a leaf node */
+    static constexpr std::size_t MAX_LEAF_SIZE{16};
+
+    /**
+     * @brief Build a hierarchy over a list of triangles
+     *
+     * Face indices reported by intersect() are indices into `triangles`. If
+     * `numThreads` is 0, every thread in the global ThreadPool is used.
+     */
+    static auto New(std::vector<Triangle> triangles, std::size_t numThreads = 0)
+        -> Pointer;
+
+    /** @brief Build a hierarchy over the 3D faces of a mesh */
+    static auto New(const FlatMesh& mesh, std::size_t numThreads = 0)
+        -> Pointer;
+
+    /**
+     * @brief Build a hierarchy over the UV faces of a mesh
+     *
+     * Faces are placed in the Z = 0 plane at their UV coordinates.
+     */
+    static auto NewUV(
+        const FlatMesh& mesh, const UVMap& uvMap, std::size_t numThreads = 0)
+        -> Pointer;
+
+    /** @brief Write a hierarchy to a binary file */
+    static void Write(const filesystem::path& path, const MeshBVH& bvh);
+
+    /**
+     * @brief Read a hierarchy from a binary file
+     *
+     * @throws IOException if the file cannot be read or is not a BVH file
+     */
+    static auto Read(const filesystem::path& path) -> Pointer;
+
+    /** @brief Destructor */
+    ~MeshBVH();
+
+    /** @brief Get the number of faces */
+    [[nodiscard]] auto numFaces() const -> std::size_t;
+
+    /** @brief Get the number of nodes in the hierarchy */
+    [[nodiscard]] auto numNodes() const -> std::size_t;
+
+    /**
+     * @brief Find the closest intersection of a ray with the faces
+     *
+     * Only intersections with a ray parameter in `[tmin, tmax]` are
+     * considered. The direction does not need to be normalized.
+     */
+    [[nodiscard]] auto intersect(
+        const cv::Vec3d& origin,
+        const cv::Vec3d& direction,
+        double tmin,
+        double tmax) const -> std::optional<Hit>;
+
+private:
+    /** Private constructor. Use the static constructors. */
+    MeshBVH();
+
+    /** Hierarchy and triangles */
+    struct Impl;
+    /** Implementation */
+    std::unique_ptr<Impl> impl_;
+};
+
+}  // namespace volcart::texturing
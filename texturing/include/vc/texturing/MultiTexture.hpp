@@ -0,0 +1,93 @@
+#pragma once
+
+/** @file */
+
+#include <vector>
+
+#include "vc/texturing/CompositeTexture.hpp"
+#include "vc/texturing/TexturingAlgorithm.hpp"
+
+namespace volcart::texturing
+{
+
+/**
+ * @brief Generate several texture images from a single neighborhood pass
+ *
+ * Producing multiple textures for the same PerPixelMap with separate
+ * texturing algorithms samples the same Volume neighborhoods once per
+ * algorithm. This class samples each pixel's neighborhood once and reduces
+ * it with every requested Output, returning all of the images together.
+ *
+ * Each output produces the same image as the corresponding single texturing
+ * algorithm run with the same neighborhood generator:
+ *
+ * - Minimum, Maximum, Median, Mean, MedianAverage: CompositeTexture with the
+ *   matching CompositeTexture::Filter
+ * - Integral: IntegralTexture with no weighting or clamping
+ * - Layers: LayerTexture. Produces one image per neighborhood sample.
+ *
+ * Images are returned in the order the outputs were given to setOutputs().
+ *
+ * @ingroup Texture
+ */
+class MultiTexture : public TexturingAlgorithm
+{
+public:
+    /** Pointer type */
+    using Pointer = std::shared_ptr<MultiTexture>;
+
+    /** Make shared pointer */
+    static Pointer New() { return std::make_shared<MultiTexture>(); }
+
+    /** Default destructor */
+    ~MultiTexture() override = default;
+
+    /** Output types */
+    enum class Output {
+        /** @copydoc CompositeTexture::Filter::Minimum */
+        Minimum = 0,
+        /** @copydoc CompositeTexture::Filter::Maximum */
+        Maximum,
+        /** @copydoc CompositeTexture::Filter::Median */
+        Median,
+        /** @copydoc CompositeTexture::Filter::Mean */
+        Mean,
+        /** @copydoc CompositeTexture::Filter::MedianAverage */
+        MedianAverage,
+        /** @brief Sum of the neighborhood, normalized to [0, 1] */
+        Integral,
+        /** @brief One image per neighborhood sample */
+        Layers
+    };
+
+    /**@{*/
+    /**
+     * @brief Set the Neighborhood generator
+     *
+     * This class supports generators of dimension >= 1. The Layers output
+     * requires a generator of dimension 1.
+     */
+    void setGenerator(NeighborhoodGenerator::Pointer g) { gen_ = std::move(g); }
+
+    /** @brief Set the outputs to generate */
+    void setOutputs(std::vector<Output> o) { outputs_ = std::move(o); }
+
+    /** @brief Get the outputs to generate */
+    [[nodiscard]] auto outputs() const -> const std::vector<Output>&
+    {
+        return outputs_;
+    }
+    /**@}*/
+
+    /**@{*/
+    /** @brief Compute the Texture */
+    Texture compute() override;
+    /**@}*/
+
+private:
+    /** Neighborhood shape */
+    NeighborhoodGenerator::Pointer gen_;
+    /** Requested outputs */
+    std::vector<Output> outputs_;
+};
+}  // namespace volcart::texturing
@@ -2,10 +2,16 @@
 
 /** @file */
 
+#include <cstddef>
+#include <vector>
+
+#include <opencv2/core.hpp>
+
 #include "vc/core/types/ITKMesh.hpp"
 #include "vc/core/types/Mixins.hpp"
 #include "vc/core/types/PerPixelMap.hpp"
 #include "vc/core/types/UVMap.hpp"
+#include "vc/texturing/MeshBVH.hpp"
 
 namespace volcart::texturing
 {
@@ -17,8 +23,23 @@ namespace volcart::texturing
  * correspond to the 3D position and normal vector associated with that pixel:
  * `{x, y, z, nx, ny, nz}`
  *
- * This class uses raytracing functionality provided by the
- * [bvh library](https://github.com/madmann91/bvh).
+ * By default, this class intersects a ray with a MeshBVH of the UV faces to
+ * find the face under each pixel. Since every ray is parallel in UV space,
+ * the UV faces can instead be rasterized directly, which is considerably
+ * faster. See setEngine().
+ *
+ * Every generated PPM also stores the face and barycentric coordinate of each
+ * mapped pixel (see PerPixelMap::cellMap() and
+ * PerPixelMap::barycentricMap()). When a mesh is deformed without changing
+ * its faces or UV map, a PPM generated for the original mesh can be provided
+ * with setReferencePPM(), and the new PPM is interpolated from those samples
+ * without locating any faces. If a few faces were edited as well, they can be
+ * listed with setChangedFaces(), and only the pixels they cover are located
+ * again.
+ *
+ * Rows of the output are divided into tiles which are processed in parallel.
+ * By default, one worker thread is used per hardware thread. See
+ * setNumThreads().
  *
  * @see volcart::PerPixelMap
  * @ingroup Texture
@@ -38,6 +59,21 @@ public:
         Smooth
     };
 
+    /** @brief Method used to locate the face under each pixel */
+    enum class Engine {
+        /** @brief Cast a ray through a BVH for every pixel */
+        RayCast = 0,
+        /**
+         * @brief Scanline rasterize the UV faces
+         *
+         * Mapped pixels have the same values as with RayCast. Pixels which
+         * lie exactly on an edge shared by multiple faces are always assigned
+         * to the face with the lowest index, which may differ from the face
+         * chosen by RayCast.
+         */
+        Rasterize
+    };
+
     /** Default constructor */
     PPMGenerator() = default;
 
@@ -57,8 +93,121 @@ public:
     /** @brief Set the dimensions of the output PPM */
     void setDimensions(size_t h, size_t w);
 
+    /** @brief Get the width of the output PPM */
+    [[nodiscard]] auto width() const -> size_t;
+
+    /** @brief Get the height of the output PPM */
+    [[nodiscard]] auto height() const -> size_t;
+
     /** @brief Set the normal shading method */
     void setShading(Shading s);
+
+    /**
+     * @brief Set the face location engine
+     *
+     * Default: Engine::RayCast
+     */
+    void setEngine(Engine e);
+
+    /** @brief Get the face location engine */
+    [[nodiscard]] auto engine() const -> Engine;
+
+    /**
+     * @brief Set a prebuilt BVH of the UV faces
+     *
+     * Used by the RayCast engine. The BVH must have been built from the input
+     * mesh and UV map with MeshBVH::NewUV(). Sharing one BVH avoids
+     * rebuilding it when several regions of the same PPM are generated. If
+     * not set, a BVH is built by compute(), which throws
+     * `std::invalid_argument` if the BVH's face count does not match the
+     * mesh.
+     */
+    void setBVH(MeshBVH::Pointer bvh);
+
+    /** @brief Get the prebuilt BVH of the UV faces */
+    [[nodiscard]] auto bvh() const -> MeshBVH::Pointer;
+
+    /**
+     * @brief Only generate a region of the output PPM
+     *
+     * The generated PPM has the dimensions of the region, and its pixels are
+     * identical to the corresponding pixels of the PPM generated for the full
+     * output dimensions. This allows a very large PPM to be generated and
+     * processed in tiles. If the region is empty (default), the full PPM is
+     * generated.
+     *
+     * compute() throws `std::invalid_argument` if the region is not within
+     * the output dimensions.
+     */
+    void setRegion(const cv::Rect& r);
+
+    /** @brief Get the output region */
+    [[nodiscard]] auto region() const -> cv::Rect;
+
+    /**
+     * @brief Reuse the face samples of a previously generated PPM
+     *
+     * The reference PPM must have been generated from a mesh with the same
+     * faces and UV map as the input mesh, and for the same output region.
+     * Only the vertex positions (and normals) of the input mesh may differ.
+     * Rather than locating the face under each pixel, compute() takes the
+     * face from the reference's cell map and interpolates the input mesh at
+     * the reference's barycentric coordinates. This is much faster than
+     * either engine and the mapped pixels are identical to those of a full
+     * compute().
+     *
+     * If the reference has no barycentric map, the coordinates are
+     * recomputed from the UV map, which must then be set. Set to `nullptr`
+     * (default) to generate the PPM from scratch.
+     *
+     * compute() throws `std::invalid_argument` if the reference does not
+     * have a cell map, does not match the dimensions of the output region,
+     * or (unless changed faces are set) references a face which is not in
+     * the input mesh.
+     */
+    void setReferencePPM(const PerPixelMap::Pointer& ppm);
+
+    /** @brief Get the reference PPM */
+    [[nodiscard]] auto referencePPM() const -> PerPixelMap::Pointer;
+
+    /**
+     * @brief Set the faces which changed since the reference PPM was made
+     *
+     * Enables incremental regeneration of a locally edited mesh. Face
+     * indices refer to the input mesh. Listed faces may have new vertices,
+     * positions or UV coordinates, and new faces must be appended to the
+     * mesh and listed. Every other face must keep its index, vertices and UV
+     * coordinates, though its vertex positions may still move. Reference
+     * faces past the end of the input mesh are treated as deleted.
+     *
+     * compute() copies the samples of every pixel whose reference face did
+     * not change, then rasterizes only the changed faces into the remaining
+     * pixels, so the cost is proportional to the size of the edit rather
+     * than the size of the mesh. The UV map must be set. Assumes the UV map
+     * has no overlapping faces: pixels on an edge between a changed and an
+     * unchanged face keep the unchanged face. Ignored if no reference PPM is
+     * set.
+     *
+     * compute() throws `std::invalid_argument` if a face is not in the input
+     * mesh.
+     *
+     * @see ChangedFaces()
+     */
+    void setChangedFaces(std::vector<std::size_t> faces);
+
+    /** @brief Get the changed faces */
+    [[nodiscard]] auto changedFaces() const -> const std::vector<std::size_t>&;
+
+    /**
+     * @brief Set the number of worker threads
+     *
+     * Work is run on the global ThreadPool. If `n == 0` (default), uses every
+     * thread in the pool.
+     */
+    void setNumThreads(size_t n);
+
+    /** @brief Get the number of worker threads */
+    [[nodiscard]] auto numThreads() const -> size_t;
     /**@}*/
 
     /**@{*/
@@ -80,18 +229,43 @@ private:
     /** Input UV Map */
     UVMap::Pointer uvMap_;
 
-    /** Working mesh */
-    ITKMesh::Pointer workingMesh_;
     /** Output PerPixelMap */
     PerPixelMap::Pointer ppm_;
     /** Output shading */
     Shading shading_{Shading::Smooth};
+    /** Face location engine */
+    Engine engine_{Engine::RayCast};
+    /** Prebuilt BVH of the UV faces */
+    MeshBVH::Pointer bvh_;
+    /** Output region. Empty for the full output. */
+    cv::Rect region_;
+    /** PPM whose face samples are reused. Null to locate faces. */
+    PerPixelMap::Pointer reference_;
+    /** Faces changed since the reference was generated */
+    std::vector<std::size_t> changedFaces_;
     /** Output width of the PerPixelMap */
     size_t width_{0};
     /** Output height of the PerPixelMap */
     size_t height_{0};
+    /** Number of worker threads. 0 uses all hardware threads. */
+    size_t numThreads_{0};
 };
 
+/**
+ * @brief List the faces of a mesh which differ from a previous version
+ *
+ * Returns, in increasing order, the index of every face in `mesh` which is
+ * not in `prevMesh` or whose vertex indices or vertex UV coordinates differ
+ * from those of the same face in `prevMesh`. Vertex positions are not
+ * compared, since the samples of a moved face can still be reused. The
+ * result can be passed to PPMGenerator::setChangedFaces().
+ */
+auto ChangedFaces(
+    const ITKMesh::Pointer& prevMesh,
+    const UVMap::Pointer& prevUV,
+    const ITKMesh::Pointer& mesh,
+    const UVMap::Pointer& uv) -> std::vector<std::size_t>;
+
 /**
  * @brief Generate a cell map image
  *
@@ -100,6 +274,10 @@ private:
  * of running a PPMGenerator. However, older PPM files may not have a cell map,
  * so this method is provided as a convenience.
  *
+ * Faces are rasterized in parallel with the same method as
+ * PPMGenerator::Engine::Rasterize: where faces overlap, the face with the
+ * lowest index is assigned to the pixel.
+ *
  * @note Cell maps have always been generated, but were not serialized until
  * version 2.22. That version also introduced a more reliable method for
  * generating cell maps which may not produce the exact same results as the
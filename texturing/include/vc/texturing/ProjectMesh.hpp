@@ -2,10 +2,13 @@
 
 /** @file */
 
+#include <cstddef>
+
 #include <itkCompositeTransform.h>
 
 #include "vc/core/types/ITKMesh.hpp"
 #include "vc/core/types/PerPixelMap.hpp"
+#include "vc/texturing/MeshBVH.hpp"
 
 namespace volcart::texturing
 {
@@ -32,8 +35,8 @@ namespace volcart::texturing
  * By default, the last mesh intersection point is used for each ray, optionally
  * this may be changed to the first intersection point.
  *
- * This class uses raytracing functionality provided by the
- * [bvh library](https://github.com/madmann91/bvh).
+ * Rays are intersected with the mesh using a MeshBVH, and are traced in
+ * parallel over the rows of the PPM.
  *
  * @see volcart::PerPixelMap
  * @ingroup Texture
@@ -82,6 +85,26 @@ public:
     /**@{*/
     /** @brief Use the first mesh intersection rather than the last */
     void setUseFirstIntersection(bool useFirstIntersection);
+
+    /**
+     * @brief Set a prebuilt BVH of the input mesh
+     *
+     * The BVH must have been built over the 3D faces of the input mesh with
+     * MeshBVH::New(). If not set, a BVH is built by compute(), which throws
+     * std::invalid_argument if the BVH's face count does not match the mesh.
+     */
+    void setBVH(MeshBVH::Pointer bvh);
+
+    /**
+     * @brief Set the number of threads used to project the mesh
+     *
+     * PPM rows are split between threads. If `0` (default), uses every
+     * thread in the global ThreadPool.
+     */
+    void setNumThreads(std::size_t n);
+
+    /** @copydoc setNumThreads(std::size_t) */
+    [[nodiscard]] auto numThreads() const -> std::size_t;
     /**@}*/
 
     /**@{*/
@@ -116,6 +139,10 @@ private:
     double sampleRateY_{1.0};
 
     /** Use the first mesh intersection rather than the last */
-    bool useFirstIntersection_;
+    bool useFirstIntersection_{false};
+    /** Prebuilt BVH of the input mesh */
+    MeshBVH::Pointer bvh_;
+    /** Number of projection threads */
+    std::size_t numThreads_{0};
 };
 }  // namespace volcart::texturing
@@ -0,0 +1,116 @@
+#pragma once
+
+/** @file */
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "vc/core/filesystem.hpp"
+#include "vc/core/neighborhood/LineGenerator.hpp"
+#include "vc/core/types/PerPixelMap.hpp"
+#include "vc/core/types/Volume.hpp"
+
+namespace volcart::texturing
+{
+/**
+ * @class SamplePlan
+ * @brief Precomputed sample coordinates of a line-textured PerPixelMap
+ *
+ * Records the voxel coordinates sampled by a LineGenerator along the normal
+ * of every mapped pixel of a PPM: the base voxel of each sample and its
+ * trilinear weights along each axis, quantized to 1/WEIGHT_SCALE of a voxel.
+ * A plan is computed once and can then be replayed against any Volume with
+ * the same geometry, e.g. the co-registered volumes of a multi-energy scan
+ * or the same volume with different filter parameters, without recomputing
+ * any sample positions.
+ *
+ * Replayed samples are trilinearly interpolated, and match the samples of
+ * the LineGenerator to within one intensity level.
+ *
+ * @ingroup Texture
+ */
+class SamplePlan
+{
+public:
+    /** Pointer type */
+    using Pointer = std::shared_ptr<SamplePlan>;
+
+    /** Scale of the quantized trilinear weights */
+    static constexpr double WEIGHT_SCALE{65536.0};
+
+    /** Base voxel of a sample which lies outside of any volume */
+    static constexpr int32_t NO_VOXEL{INT32_MIN};
+
+    /** @brief Default constructor. Creates an empty plan. */
+    SamplePlan() = default;
+
+    /**
+     * @brief Compute the sample plan of a PPM
+     *
+     * Pixels are stored in PerPixelMap::MappingOrder::Slice order. Samples
+     * are computed in parallel with numThreads threads of the global
+     * ThreadPool, or with every thread if `numThreads == 0`.
+     *
+     * @throws std::invalid_argument If the generator does not use trilinear
+     * interpolation
+     */
+    static auto Build(
+        const PerPixelMap& ppm,
+        const LineGenerator& gen,
+        std::size_t numThreads = 0) -> Pointer;
+
+    /** @brief Width of the planned PPM */
+    [[nodiscard]] auto width() const -> std::size_t { return width_; }
+
+    /** @brief Height of the planned PPM */
+    [[nodiscard]] auto height() const -> std::size_t { return height_; }
+
+    /** @brief Number of samples of every pixel */
+    [[nodiscard]] auto samplesPerPixel() const -> std::size_t
+    {
+        return samplesPerPixel_;
+    }
+
+    /** @brief Linear indices (`y * width + x`) of the planned pixels */
+    [[nodiscard]] auto pixels() const
+        -> const std::vector<PerPixelMap::PixelIndex>&
+    {
+        return pixels_;
+    }
+
+    /**
+     * @brief Gather the samples of planned pixel `i` from a Volume
+     *
+     * Writes samplesPerPixel() values to `out`. Samples outside of the Volume
+     * are 0. Safe to call concurrently.
+     */
+    void gather(const Volume& v, std::size_t i, uint16_t* out) const;
+
+    /** @brief Write a plan to a file */
+    static void Write(const filesystem::path& path, const SamplePlan& plan);
+
+    /**
+     * @brief Read a plan from a file
+     *
+     * @throws IOException If the file is not a valid sample plan
+     */
+    static auto Read(const filesystem::path& path) -> Pointer;
+
+private:
+    /** Width of the PPM */
+    std::size_t width_{0};
+    /** Height of the PPM */
+    std::size_t height_{0};
+    /** Number of samples per pixel */
+    std::size_t samplesPerPixel_{0};
+    /** Planned pixels */
+    std::vector<PerPixelMap::PixelIndex> pixels_;
+    /** Base voxel (x, y, z) of each sample, pixel-major */
+    std::vector<std::array<int32_t, 3>> bases_;
+    /** Quantized trilinear weight of each sample along each axis */
+    std::vector<std::array<uint16_t, 3>> weights_;
+};
+}  // namespace volcart::texturing
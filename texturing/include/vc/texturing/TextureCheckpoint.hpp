@@ -0,0 +1,117 @@
+#pragma once
+
+/** @file */
+
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+#include "vc/core/filesystem.hpp"
+
+namespace volcart::texturing
+{
+/**
+ * @class TextureCheckpoint
+ * @brief Saves and restores the partial output of a texturing algorithm
+ *
+ * Texturing algorithms which support checkpoints (see
+ * TexturingAlgorithm::setCheckpoint()) texture the PPM's mappings in
+ * order, in chunks. After every chunk, if at least interval() seconds have
+ * passed since the last save, the output images and the number of textured
+ * mappings are written to the checkpoint directory. The final state is
+ * always saved. If the process is interrupted, a new texturing run with a
+ * checkpoint on the same directory loads the saved images and continues
+ * with the first mapping which was not textured.
+ *
+ * A checkpoint is only loaded if it was saved with the same key(), number
+ * of mappings, and number, size, and type of images. Otherwise it is
+ * ignored and overwritten. The key should identify the texturing run, e.g.
+ * the input and the texturing parameters.
+ *
+ * Images are first written to temporary files and then renamed, so an
+ * interrupted save leaves the previous checkpoint usable. The checkpoint is
+ * not removed when texturing completes, since the texture may not have been
+ * written yet. Call clear() once the output is safe.
+ *
+ * @ingroup Texture
+ */
+class TextureCheckpoint
+{
+public:
+    /** Pointer type */
+    using Pointer = std::shared_ptr<TextureCheckpoint>;
+
+    /** Images of a checkpoint */
+    using Texture = std::vector<cv::Mat>;
+
+    /** Default save interval: 5 minutes */
+    static constexpr double DEFAULT_INTERVAL{300};
+
+    /** @brief Construct a checkpoint in a directory */
+    explicit TextureCheckpoint(filesystem::path dir);
+
+    /** @copydoc TextureCheckpoint(filesystem::path) */
+    static auto New(filesystem::path dir) -> Pointer;
+
+    /** @brief Get the checkpoint directory */
+    [[nodiscard]] auto directory() const -> const filesystem::path&;
+
+    /**
+     * @brief Set the minimum time between saves, in seconds
+     *
+     * Default: DEFAULT_INTERVAL
+     */
+    void setInterval(double seconds);
+
+    /** @copydoc setInterval() */
+    [[nodiscard]] auto interval() const -> double;
+
+    /** @brief Set the key which identifies the texturing run */
+    void setKey(std::string key);
+
+    /** @copydoc setKey() */
+    [[nodiscard]] auto key() const -> const std::string&;
+
+    /**
+     * @brief Load the saved images into `images`
+     *
+     * The saved images are copied into the existing images, which must have
+     * the size and type of the output. If there is no matching checkpoint,
+     * `images` is not changed.
+     *
+     * @return The number of textured mappings, or `0` if there is no
+     * matching checkpoint
+     */
+    auto load(Texture& images, std::size_t numMappings) -> std::size_t;
+
+    /** @brief Whether interval() has passed since the last save or load */
+    [[nodiscard]] auto due() const -> bool;
+
+    /**
+     * @brief Save the images and the number of textured mappings
+     *
+     * @throws std::runtime_error If the checkpoint cannot be written
+     */
+    void save(const Texture& images, std::size_t done, std::size_t numMappings);
+
+    /** @brief Remove the saved checkpoint, if any */
+    void clear();
+
+private:
+    /** Clock type */
+    using Clock = std::chrono::steady_clock;
+
+    /** Checkpoint directory */
+    filesystem::path dir_;
+    /** Minimum time between saves */
+    double interval_{DEFAULT_INTERVAL};
+    /** Texturing run key */
+    std::string key_;
+    /** Time of the last save or load */
+    Clock::time_point last_{Clock::now()};
+};
+}  // namespace volcart::texturing
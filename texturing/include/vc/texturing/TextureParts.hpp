@@ -0,0 +1,114 @@
+#pragma once
+
+/** @file */
+
+#include <cstddef>
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+#include "vc/core/filesystem.hpp"
+#include "vc/core/io/TIFFIO.hpp"
+
+namespace volcart::texturing
+{
+/**
+ * @brief Part of a texture which is rendered separately from the rest
+ *
+ * A texture can be split into `count` horizontal bands, each of which is
+ * rendered by a separate process (see PPMGenerator::setRegion()), e.g. by the
+ * tasks of a cluster job array. The parts are then assembled into the full
+ * texture with MergeTextureParts().
+ *
+ * Bands are whole multiples of PART_ROW_MULTIPLE rows, except for the last
+ * band, so that every band starts on a tile boundary of the merged image.
+ *
+ * @ingroup Texture
+ */
+struct TexturePart {
+    /** @brief Band rows are a multiple of this value */
+    static constexpr int PART_ROW_MULTIPLE{256};
+
+    /** @brief Index of the part */
+    std::size_t index{0};
+    /** @brief Number of parts in the texture */
+    std::size_t count{1};
+    /** @brief Width of the full texture */
+    std::size_t width{0};
+    /** @brief Height of the full texture */
+    std::size_t height{0};
+    /** @brief Region of the full texture covered by the part */
+    cv::Rect region;
+    /** @brief Path of the part's texture image */
+    filesystem::path image;
+
+    /**
+     * @brief Get part `index` of `count` of a `width` x `height` texture
+     *
+     * The PART_ROW_MULTIPLE row blocks of the texture are divided as evenly
+     * as possible between the parts.
+     *
+     * @throws std::invalid_argument If `index >= count`, or if the texture
+     * has fewer row blocks than there are parts
+     */
+    static auto Make(
+        std::size_t width,
+        std::size_t height,
+        std::size_t index,
+        std::size_t count) -> TexturePart;
+
+    /** @brief Path of the descriptor written alongside a part's image */
+    static auto DescriptorPath(const filesystem::path& image)
+        -> filesystem::path;
+};
+
+/**
+ * @brief Write a rendered texture part
+ *
+ * Writes `img` to `part.image` as a TIFF and writes a JSON descriptor of the
+ * part to TexturePart::DescriptorPath().
+ *
+ * @throws std::invalid_argument If the image path does not have a TIFF
+ * extension or the image does not match the part's region
+ */
+void WriteTexturePart(const TexturePart& part, const cv::Mat& img);
+
+/**
+ * @brief Read a texture part descriptor
+ *
+ * `path` may be the path of the descriptor or of the part's image.
+ */
+auto ReadTexturePart(const filesystem::path& path) -> TexturePart;
+
+/**
+ * @brief Check that texture parts cover a texture exactly once
+ *
+ * @return The parts sorted by index
+ *
+ * @throws std::runtime_error If the parts are from different textures, if a
+ * part is duplicated or missing, or if a part's image is missing
+ */
+auto VerifyTextureParts(std::vector<TexturePart> parts)
+    -> std::vector<TexturePart>;
+
+/**
+ * @brief Assemble texture parts into the full texture
+ *
+ * The parts are verified with VerifyTextureParts(), then copied into `output`
+ * PART_ROW_MULTIPLE rows at a time, so the full texture never has to fit in
+ * memory. A `.dzi` output is written as a Deep Zoom tile pyramid with
+ * DeepZoomWriter. Otherwise, the output must have a TIFF extension and is
+ * written as a tiled TIFF with tiffio::TiledTIFFWriter.
+ *
+ * @param parts Texture parts
+ * @param output Output path
+ * @param compression TIFF compression. Ignored for Deep Zoom output.
+ * @param numThreads Number of threads used to decode and encode tiles. If
+ * `0`, uses every thread in the global ThreadPool.
+ */
+void MergeTextureParts(
+    const std::vector<TexturePart>& parts,
+    const filesystem::path& output,
+    tiffio::Compression compression = tiffio::Compression::LZW,
+    std::size_t numThreads = 0);
+}  // namespace volcart::texturing
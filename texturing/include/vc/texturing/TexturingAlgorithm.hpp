@@ -2,12 +2,26 @@
 
 /** @file */
 
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <future>
 #include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
 
 #include "vc/core/neighborhood/NeighborhoodGenerator.hpp"
 #include "vc/core/types/Mixins.hpp"
 #include "vc/core/types/PerPixelMap.hpp"
 #include "vc/core/types/Volume.hpp"
+#include "vc/core/util/MemoryUsage.hpp"
+#include "vc/core/util/NUMA.hpp"
+#include "vc/core/util/ProgressCounter.hpp"
+#include "vc/core/util/ThreadPool.hpp"
+#include "vc/core/util/Tracing.hpp"
+#include "vc/texturing/SamplePlan.hpp"
+#include "vc/texturing/TextureCheckpoint.hpp"
 
 namespace volcart::texturing
 {
@@ -29,6 +43,103 @@ public:
     /** @brief Set the input Volume */
     void setVolume(Volume::Pointer vol) { vol_ = std::move(vol); }
 
+    /**
+     * @brief Set the number of worker threads
+     *
+     * Work is run on the global ThreadPool. If `n == 0` (default), uses every
+     * thread in the pool. Algorithms which are not multithreaded ignore this
+     * setting.
+     */
+    void setNumThreads(size_t n) { numThreads_ = n; }
+
+    /** @brief Get the number of worker threads */
+    size_t numThreads() const
+    {
+        if (numThreads_ > 0) {
+            return numThreads_;
+        }
+        return ThreadPool::Global().numThreads();
+    }
+
+    /**
+     * @brief Use the GPU backend when possible
+     *
+     * Only CompositeTexture and IntegralTexture have a GPU backend (see
+     * gpu::Available()), and only for LineGenerator neighborhoods. They fall
+     * back to the CPU if the GPU backend cannot be used. Default: false
+     */
+    void setUseGPU(bool b) { useGPU_ = b; }
+
+    /** @brief Whether to use the GPU backend when possible */
+    bool useGPU() const { return useGPU_; }
+
+    /**
+     * @brief Bind the worker threads to the NUMA nodes of the Volume's slices
+     *
+     * If the Volume's slice cache is partitioned between NUMA nodes (see
+     * Volume::setNUMAPartitioning()), the PPM's mappings are processed by
+     * threads bound to the node of the slices they sample, so that each
+     * node mostly reads slices from its own memory. Threads which run out of
+     * their node's work help the other nodes. Has no effect if the cache is
+     * not partitioned. Default: false
+     */
+    void setNUMABinding(bool b) { numaBinding_ = b; }
+
+    /** @brief Whether to bind the worker threads to NUMA nodes */
+    bool numaBinding() const { return numaBinding_; }
+
+    /**
+     * @brief Set the order in which the PPM's pixels are textured
+     *
+     * If unset (default), the order is matched to the Volume's storage:
+     * slice volumes are textured in PerPixelMap::MappingOrder::Slice order
+     * and blocked volumes in PerPixelMap::MappingOrder::Hilbert order of
+     * their blocks, so that neighboring pixels share cached slices or
+     * blocks.
+     */
+    void setMappingOrder(std::optional<PerPixelMap::MappingOrder> o)
+    {
+        mappingOrder_ = o;
+    }
+
+    /** @brief Get the order in which the PPM's pixels are textured */
+    PerPixelMap::MappingOrder mappingOrder() const
+    {
+        if (mappingOrder_) {
+            return *mappingOrder_;
+        }
+        if (vol_ and vol_->format() != Volume::Format::Slices) {
+            return PerPixelMap::MappingOrder::Hilbert;
+        }
+        return PerPixelMap::MappingOrder::Slice;
+    }
+
+    /**
+     * @brief Gather the neighborhoods from a precomputed SamplePlan
+     *
+     * If set, CompositeTexture, IntegralTexture and MultiTexture gather the
+     * samples of each pixel from the plan instead of computing them with
+     * their LineGenerator. The plan must have been built for the input PPM
+     * and a generator with the same number of samples. The GPU backend is
+     * not used with a plan. Default: None
+     */
+    void setSamplePlan(SamplePlan::Pointer p) { plan_ = std::move(p); }
+
+    /**
+     * @brief Periodically save the partial texture to a checkpoint
+     *
+     * If set, CompositeTexture, IntegralTexture and MultiTexture texture the
+     * PPM's mappings in chunks and save their partial output to the
+     * checkpoint between chunks (see TextureCheckpoint). compute() first
+     * loads a matching checkpoint and skips the mappings which it has
+     * already textured. The GPU backend is not used with a checkpoint.
+     * Default: None
+     */
+    void setCheckpoint(TextureCheckpoint::Pointer c)
+    {
+        checkpoint_ = std::move(c);
+    }
+
     /** @brief Compute the Texture */
     virtual Texture compute() = 0;
 
@@ -38,7 +149,7 @@ public:
     /** @brief Returns the maximum progress value */
     size_t progressIterations() const override
     {
-        return ppm_->getMappings().size();
+        return ppm_->numMappings();
     }
 
 protected:
@@ -52,5 +163,311 @@ protected:
 
     /** Result */
     Texture result_;
+    /** Memory held by result_ */
+    memory::TrackedBytes resultMemory_{MemoryCategory::Texture};
+
+    /** Update the memory counted for result_. Call when compute() ends. */
+    void track_result_()
+    {
+        std::size_t bytes{0};
+        for (const auto& image : result_) {
+            bytes += image.total() * image.elemSize();
+        }
+        resultMemory_.set(bytes);
+    }
+
+    /** Whether compute() should use the GPU backend, if it supports it */
+    bool use_gpu_() const { return useGPU_ and not plan_ and not checkpoint_; }
+
+    /**
+     * @brief Get the indices of the PPM's mapped pixels in mappingOrder()
+     *
+     * Curve orders group the pixels by the Volume's blocks.
+     */
+    std::vector<PerPixelMap::PixelIndex> mapping_indices_() const
+    {
+        cv::Vec3i cell{1, 1, 1};
+        if (vol_ and vol_->format() != Volume::Format::Slices) {
+            cell = vol_->blockShape();
+        }
+        return ppm_->getMappingIndices(mappingOrder(), cell);
+    }
+
+    /**
+     * @brief Call `fn(x, y, samples)` with the neighborhood of every mapped
+     * pixel of the PPM
+     *
+     * The neighborhoods are computed by `gen` in mappingOrder(), or gathered
+     * from the sample plan if one is set. `samples` holds `gen.size()`
+     * values and is only valid during the call. Uses checkpointed_for_(), so
+     * `fn` must only write to the images in result_.
+     *
+     * @throws std::invalid_argument If the sample plan does not match the
+     * PPM or the generator
+     */
+    template <typename Fn>
+    void for_each_neighborhood_(const NeighborhoodGenerator& gen, Fn fn)
+    {
+        const auto size = gen.size();
+        if (plan_) {
+            if (gen.dim() != 1 or plan_->samplesPerPixel() != size or
+                plan_->width() != ppm_->width() or
+                plan_->height() != ppm_->height()) {
+                throw std::invalid_argument(
+                    "Sample plan does not match the PPM and generator");
+            }
+            const auto width = plan_->width();
+            const auto& pixels = plan_->pixels();
+            checkpointed_for_(pixels, [&](size_t i) {
+                thread_local std::vector<uint16_t> samples;
+                samples.resize(size);
+                plan_->gather(*vol_, i, samples.data());
+                fn(static_cast<int>(pixels[i] % width),
+                   static_cast<int>(pixels[i] / width), samples.data());
+            });
+            return;
+        }
+
+        const auto& ppm = *ppm_;
+        auto mappings = mapping_indices_();
+        checkpointed_for_(mappings, [&](size_t i) {
+            auto pixel = ppm.getAsPixelMap(mappings[i]);
+
+            // Generate the neighborhood into a reused per-thread buffer
+            thread_local std::vector<uint16_t> samples;
+            samples.resize(size);
+            gen.computeInto(vol_, pixel.pos, pixel.normal, samples.data());
+            fn(static_cast<int>(pixel.x), static_cast<int>(pixel.y),
+               samples.data());
+        });
+    }
+
+    /** Number of consecutive items claimed by a worker thread at a time */
+    static constexpr size_t SLAB_SIZE{1024};
+
+    /** Number of slabs per thread between checkpoints */
+    static constexpr size_t CHECKPOINT_SLABS{16};
+
+    /**
+     * @brief Call `fn(i)` for every `i` in `[0, n)` using numThreads()
+     * threads of the global ThreadPool
+     *
+     * Items are claimed in order in slabs of SLAB_SIZE consecutive items. When
+     * the items are sorted by Z, the workers sample neighboring regions of the
+     * Volume at the same time and share its cached slices. `fn` must be safe
+     * to call concurrently for different items.
+     *
+     * progressUpdated() is emitted from the calling thread only, at most
+     * once per ProgressCounter::DEFAULT_INTERVAL, with the number of
+     * completed items plus `progressOffset`. If `fn` throws, the
+     * remaining items are skipped and the first exception is rethrown once
+     * all workers have finished.
+     */
+    template <typename Fn>
+    void parallel_for_(size_t n, Fn fn, size_t progressOffset = 0)
+    {
+        auto slab = [&fn](size_t begin, size_t end) {
+            for (auto i = begin; i < end; i++) {
+                fn(i);
+            }
+        };
+        parallel_slabs_(n, slab, {}, progressOffset);
+    }
+
+    /**
+     * @brief Call `fn(i)` for every index `i` of a list of PPM mappings
+     *
+     * Like parallel_for_(size_t, Fn, size_t), but if NUMA binding is
+     * enabled, each slab is processed by a thread bound to the NUMA node of
+     * the slice sampled by the slab's first mapping. `mappings` should be in
+     * PerPixelMap::MappingOrder::Slice order for the binding to be
+     * effective.
+     */
+    template <typename Fn>
+    void parallel_for_(
+        const std::vector<PerPixelMap::PixelIndex>& mappings,
+        Fn fn,
+        size_t progressOffset = 0)
+    {
+        auto slab = [&fn](size_t begin, size_t end) {
+            for (auto i = begin; i < end; i++) {
+                fn(i);
+            }
+        };
+        parallel_slabs_(
+            mappings.size(), slab, slab_nodes_(mappings), progressOffset);
+    }
+
+    /**
+     * @brief Call `fn(begin, end)` for every slab of a list of PPM mappings
+     *
+     * Like parallel_for_(const std::vector<PerPixelMap::PixelIndex>&, Fn,
+     * size_t), but `fn` is called once per slab with the range of at most
+     * SLAB_SIZE consecutive indices in the slab, so that it can sample the
+     * whole slab in one batch.
+     */
+    template <typename Fn>
+    void parallel_for_slabs_(
+        const std::vector<PerPixelMap::PixelIndex>& mappings,
+        Fn fn,
+        size_t progressOffset = 0)
+    {
+        parallel_slabs_(
+            mappings.size(), fn, slab_nodes_(mappings), progressOffset);
+    }
+
+    /**
+     * @brief Call `fn(i)` for every index `i` of a list of PPM mappings,
+     * saving the images in result_ to the checkpoint
+     *
+     * Without a checkpoint, the same as parallel_for_(). Otherwise, loads
+     * the checkpoint into result_, which must already hold the output
+     * images, and skips the mappings which it has textured. The remaining
+     * mappings are processed in order in chunks of CHECKPOINT_SLABS slabs per
+     * thread. The checkpoint is saved after every chunk once it is due, and
+     * after the last chunk.
+     */
+    template <typename Fn>
+    void checkpointed_for_(
+        const std::vector<PerPixelMap::PixelIndex>& mappings, Fn fn)
+    {
+        if (not checkpoint_) {
+            parallel_for_(mappings, fn);
+            return;
+        }
+
+        const auto n = mappings.size();
+        auto begin = std::min(checkpoint_->load(result_, n), n);
+        if (begin > 0) {
+            progressUpdated(begin);
+        }
+        const auto chunkSize = CHECKPOINT_SLABS * SLAB_SIZE * numThreads();
+        std::vector<PerPixelMap::PixelIndex> chunk;
+        while (begin < n) {
+            auto end = std::min(begin + chunkSize, n);
+            chunk.assign(mappings.begin() + begin, mappings.begin() + end);
+            parallel_for_(chunk, [&](size_t i) { fn(begin + i); }, begin);
+            begin = end;
+            if (begin == n or checkpoint_->due()) {
+                checkpoint_->save(result_, begin, n);
+            }
+        }
+    }
+
+private:
+    /**
+     * NUMA node of the slice sampled by the first mapping of each slab, or
+     * empty if NUMA binding is not in effect
+     */
+    std::vector<size_t> slab_nodes_(
+        const std::vector<PerPixelMap::PixelIndex>& mappings) const
+    {
+        std::vector<size_t> slabNodes;
+        if (numaBinding_ and vol_ and vol_->numaPartitions() > 1) {
+            for (size_t i = 0; i < mappings.size(); i += SLAB_SIZE) {
+                auto z = ppm_->getAsPixelMap(mappings[i]).pos[2];
+                slabNodes.push_back(vol_->numaNode(static_cast<int>(z)));
+            }
+        }
+        return slabNodes;
+    }
+
+    /**
+     * Call `fn(begin, end)` for the slabs of `[0, n)`. If `slabNodes` is not
+     * empty, slab `s` is processed by a thread bound to NUMA node
+     * `slabNodes[s]` when possible.
+     */
+    template <typename Fn>
+    void parallel_slabs_(
+        size_t n,
+        Fn& fn,
+        const std::vector<size_t>& slabNodes,
+        size_t progressOffset)
+    {
+        // The slabs of each node, in order
+        struct Queue {
+            std::vector<size_t> slabs;
+            std::atomic<size_t> next{0};
+        };
+        auto numSlabs = (n + SLAB_SIZE - 1) / SLAB_SIZE;
+        auto numNodes = slabNodes.empty() ? size_t{1} : vol_->numaPartitions();
+        std::vector<Queue> queues(numNodes);
+        for (size_t s = 0; s < numSlabs; s++) {
+            queues[slabNodes.empty() ? 0 : slabNodes[s]].slabs.push_back(s);
+        }
+
+        // Claim the next slab of a node, or of the other nodes once the node
+        // has none left
+        std::atomic<bool> stop{false};
+        auto claim = [&](size_t node, size_t& slab) {
+            for (size_t k = 0; k < numNodes and not stop; k++) {
+                auto& q = queues[(node + k) % numNodes];
+                auto idx = q.next.fetch_add(1);
+                if (idx < q.slabs.size()) {
+                    slab = q.slabs[idx];
+                    return true;
+                }
+            }
+            return false;
+        };
+
+        ProgressCounter done(n);
+        std::exception_ptr error;
+        std::mutex errorMutex;
+        auto worker = [&](size_t node, bool reportProgress) {
+            std::optional<numa::ScopedBinding> binding;
+            if (numNodes > 1) {
+                binding.emplace(node);
+            }
+            try {
+                size_t slab;
+                while (claim(node, slab)) {
+                    VC_TRACE_SPAN_CAT("texturing", "Texturing slab");
+                    auto begin = slab * SLAB_SIZE;
+                    auto end = std::min(begin + SLAB_SIZE, n);
+                    fn(begin, end);
+                    done.add(end - begin);
+                    if (reportProgress and done.shouldReport()) {
+                        progressUpdated(progressOffset + done.count());
+                    }
+                }
+            } catch (...) {
+                const std::lock_guard<std::mutex> lock(errorMutex);
+                if (not error) {
+                    error = std::current_exception();
+                }
+                stop = true;
+            }
+        };
+
+        // Spread the threads evenly between the nodes
+        auto threadCount = std::min(numThreads(), numSlabs);
+        auto& pool = ThreadPool::Global();
+        std::vector<std::future<void>> helpers;
+        for (size_t i = 1; i < threadCount; i++) {
+            helpers.emplace_back(pool.submit(
+                [&worker, node = i % numNodes]() { worker(node, false); }));
+        }
+        worker(0, true);
+        for (auto& h : helpers) {
+            pool.wait(h);
+        }
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+
+    /** Precomputed neighborhood samples */
+    SamplePlan::Pointer plan_;
+    /** Partial texture checkpoint */
+    TextureCheckpoint::Pointer checkpoint_;
+    /** Pixel traversal order. Unset matches the Volume's storage. */
+    std::optional<PerPixelMap::MappingOrder> mappingOrder_;
+    /** Number of worker threads. 0 uses all hardware threads. */
+    size_t numThreads_{0};
+    /** Use the GPU backend */
+    bool useGPU_{false};
+    /** Bind the worker threads to NUMA nodes */
+    bool numaBinding_{false};
 };
 }  // namespace volcart::texturing
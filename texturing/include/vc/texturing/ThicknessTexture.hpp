@@ -19,7 +19,8 @@ namespace volcart::texturing
  * setNormalizeOutput is true (default), the returned image will be normalized
  * between [0, 1]. Otherwise, raw distances will be returned.
  *
- * Returned image is single-channel, 32-bit floating point.
+ * Returned image is single-channel, 32-bit floating point. Pixels are
+ * computed in parallel.
  *
  * @ingroup Texture
  */
@@ -64,6 +65,21 @@ public:
     /** @copydetails setNormalizeOutput(bool) */
     [[nodiscard]] auto normalizeOutput() const -> bool;
 
+    /**
+     * @brief Skip through the mask interior using a block distance field
+     *
+     * If true (default), a distance field is computed over the blocks of the
+     * VolumetricMask before texturing. Each march along the normal uses it to
+     * skip the samples which cannot leave the mask, and only tests individual
+     * samples near the mask boundary. The skipped samples are exactly those
+     * which would have been found in the mask, so the result is identical.
+     * Most useful for thick layers.
+     */
+    void setUseDistanceField(bool b);
+
+    /** @copydetails setUseDistanceField(bool) */
+    [[nodiscard]] auto useDistanceField() const -> bool;
+
     /** @brief Set the VolumetricMask */
     void setVolumetricMask(const VolumetricMask::Pointer& m);
 
@@ -80,5 +96,7 @@ private:
     double interval_{1.0};
     /** Normalize output */
     bool normalize_{true};
+    /** Use the block distance field */
+    bool useDistance_{true};
 };
 }  // namespace volcart::texturing
@@ -0,0 +1,130 @@
+#pragma once
+
+/** @file */
+
+#include <cstddef>
+#include <vector>
+
+#include "vc/core/filesystem.hpp"
+#include "vc/core/io/TIFFIO.hpp"
+#include "vc/core/types/Mixins.hpp"
+#include "vc/texturing/PPMGenerator.hpp"
+#include "vc/texturing/TexturingAlgorithm.hpp"
+
+namespace volcart::texturing
+{
+/**
+ * @brief Generate a texture one tile at a time
+ *
+ * PPMGenerator and the texturing algorithms normally hold the PerPixelMap and
+ * texture images for the whole output in memory, which limits the size of
+ * the texture which can be rendered. This class instead divides the output
+ * into square tiles. For each tile, it generates the PPM for just that tile
+ * (see PPMGenerator::setRegion()), textures it with the texturing algorithm,
+ * writes the result to a tiled TIFF (see tiffio::TiledTIFFWriter), and then
+ * frees the tile. Peak memory use is therefore proportional to the tile size
+ * rather than the output size. The tiles of the output TIFF are compressed
+ * in parallel using the thread count of the texturing algorithm.
+ *
+ * Configure the mesh, UV map, output dimensions, and shading of the PPM with
+ * ppmGenerator(). PPMGenerator::Engine::Rasterize is recommended, since the
+ * ray casting engine builds an acceleration structure for every tile.
+ *
+ * Texturing algorithms only see the pixels of the current tile. Algorithms
+ * which compute each pixel from its own mapping, such as CompositeTexture,
+ * produce the same result as texturing the full PPM.
+ *
+ * @ingroup Texture
+ */
+class TiledTexturing : public IterationsProgress
+{
+public:
+    /**
+     * @brief Approximate peak memory used per pixel of a tile, in bytes
+     *
+     * Covers the PPM mappings, mask, and cell map of a tile, plus headroom for
+     * the output texture and the copies made while writing it.
+     */
+    static constexpr std::size_t BYTES_PER_PIXEL{64};
+
+    /** @brief Tile sizes are a multiple of this value */
+    static constexpr std::size_t TILE_MULTIPLE{16};
+
+    /** Default constructor */
+    TiledTexturing() = default;
+
+    /**@{*/
+    /** @brief PPM generator used to generate each tile */
+    auto ppmGenerator() -> PPMGenerator&;
+
+    /** @brief Set the texturing algorithm applied to each tile */
+    void setTexturingAlgorithm(TexturingAlgorithm::Pointer a);
+
+    /**
+     * @brief Set the width and height of each tile
+     *
+     * Rounded up to a multiple of TILE_MULTIPLE. Default: 1024
+     */
+    void setTileSize(std::size_t s);
+
+    /**
+     * @brief Set the tile size from a memory budget
+     *
+     * Chooses the largest tile size whose estimated memory use fits within
+     * `bytes`. See TileSizeForBudget().
+     */
+    void setMemoryBudget(std::size_t bytes);
+
+    /** @brief Get the width and height of each tile */
+    [[nodiscard]] auto tileSize() const -> std::size_t;
+
+    /**
+     * @brief Set the output path
+     *
+     * Must have a TIFF extension. If the texturing algorithm produces more
+     * than one image, each image is written to a separate file with a
+     * zero-padded index appended to the file stem (e.g. `out_0.tif`).
+     */
+    void setOutputPath(const filesystem::path& path);
+
+    /** @brief Set the output compression. Default: LZW */
+    void setCompression(tiffio::Compression c);
+    /**@}*/
+
+    /**@{*/
+    /**
+     * @brief Render and write the texture
+     *
+     * @return The paths of the written images
+     *
+     * @throws std::invalid_argument If the texturing algorithm or output
+     * path is not set
+     * @throws std::runtime_error If the texturing algorithm does not produce
+     * the same number and type of images for every tile
+     */
+    auto compute() -> std::vector<filesystem::path>;
+    /**@}*/
+
+    /** @brief Returns the maximum progress value */
+    [[nodiscard]] auto progressIterations() const -> std::size_t override;
+
+    /**
+     * @brief Largest tile size whose tiles use at most `bytes` of memory
+     *
+     * Assumes BYTES_PER_PIXEL bytes per pixel. Never less than TILE_MULTIPLE.
+     */
+    static auto TileSizeForBudget(std::size_t bytes) -> std::size_t;
+
+private:
+    /** PPM generator */
+    PPMGenerator ppmGen_;
+    /** Texturing algorithm */
+    TexturingAlgorithm::Pointer algorithm_;
+    /** Tile width and height */
+    std::size_t tileSize_{1024};
+    /** Output path */
+    filesystem::path outputPath_;
+    /** Output compression */
+    tiffio::Compression compression_{tiffio::Compression::LZW};
+};
+}  // namespace volcart::texturing
@@ -0,0 +1,137 @@
+#pragma once
+
+/** @file */
+
+#include <cstddef>
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+#include "vc/core/types/ITKMesh.hpp"
+#include "vc/core/types/UVMap.hpp"
+
+namespace volcart::texturing
+{
+/**
+ * @brief Shelf-pack rectangles into a single, roughly square area
+ *
+ * Rectangles are placed into rows (shelves), tallest first, with a gap of
+ * `padding` times the square root of their total area between neighbours.
+ *
+ * @return The top-left corner of each rectangle
+ */
+auto PackRectangles(const std::vector<cv::Vec2d>& sizes, double padding)
+    -> std::vector<cv::Vec2d>;
+
+/**
+ * @class UVAtlas
+ * @brief Packs the UV maps of several segments into a single atlas
+ *
+ * Texturing many adjacent segments separately repeats the PPM setup, the
+ * face search structure and the volume warm-up for every segment. This class
+ * instead merges the segments into a single mesh, and packs their UV maps
+ * into a single UV map with PackRectangles(). The segments keep their
+ * relative scale, so that a PPM generated for the merged mesh has the same
+ * resolution as the PPMs of the individual segments. The whole atlas can
+ * then be generated and textured in a single pass, which reads the slices
+ * shared by adjacent segments only once.
+ *
+ * Use segmentRegion() to find each segment in the atlas image.
+ *
+ * @ingroup UV
+ */
+class UVAtlas
+{
+public:
+    /** Default gap between segments, as a fraction of the atlas size */
+    static constexpr double DEFAULT_PADDING{0.01};
+
+    /**@{*/
+    /**
+     * @brief Add a segment
+     *
+     * Only the vertices of `mesh` which are in `uvMap` are placed in the
+     * atlas. The size of the segment in the atlas is the size of its mapped
+     * region, in the units of the UV map's ratio().
+     *
+     * @return The index of the segment
+     */
+    auto addSegment(const ITKMesh::Pointer& mesh, const UVMap::Pointer& uvMap)
+        -> std::size_t;
+
+    /** @brief Get the number of segments */
+    [[nodiscard]] auto numSegments() const -> std::size_t;
+
+    /**
+     * @brief Set the gap between packed segments
+     *
+     * Relative to the square root of the total area of the segments.
+     * Default: DEFAULT_PADDING
+     */
+    void setPadding(double p);
+
+    /** @copydoc setPadding(double) */
+    [[nodiscard]] auto padding() const -> double;
+    /**@}*/
+
+    /**@{*/
+    /**
+     * @brief Pack the segments and build the merged mesh and UV map
+     *
+     * @throws std::invalid_argument if there are no segments or a segment
+     * has no UV map
+     */
+    void compute();
+
+    /**
+     * @brief Get the merged mesh
+     *
+     * The vertices and faces of segment `i` follow those of segment `i - 1`.
+     */
+    [[nodiscard]] auto getMesh() const -> ITKMesh::Pointer;
+
+    /** @brief Get the merged UV map, with the size of the atlas as ratio() */
+    [[nodiscard]] auto getUVMap() const -> UVMap::Pointer;
+
+    /** @brief Get the ID of the first vertex of a segment in getMesh() */
+    [[nodiscard]] auto vertexOffset(std::size_t i) const -> std::size_t;
+
+    /** @brief Get the ID of the first face of a segment in getMesh() */
+    [[nodiscard]] auto faceOffset(std::size_t i) const -> std::size_t;
+
+    /** @brief Get the bounds of a segment, in the units of the atlas ratio */
+    [[nodiscard]] auto segmentBounds(std::size_t i) const -> cv::Rect2d;
+
+    /**
+     * @brief Get the pixels of a segment in an atlas image of the given size
+     *
+     * The region is rounded outwards and clipped to the image.
+     */
+    [[nodiscard]] auto segmentRegion(
+        std::size_t i, std::size_t width, std::size_t height) const
+        -> cv::Rect;
+    /**@}*/
+
+private:
+    /** Input segment */
+    struct Segment {
+        ITKMesh::Pointer mesh;
+        UVMap::Pointer uvMap;
+    };
+
+    /** Input segments */
+    std::vector<Segment> segments_;
+    /** Gap between segments */
+    double padding_{DEFAULT_PADDING};
+    /** Bounds of each segment */
+    std::vector<cv::Rect2d> bounds_;
+    /** First vertex and face of each segment */
+    std::vector<std::size_t> vertexOffsets_;
+    std::vector<std::size_t> faceOffsets_;
+    /** Merged mesh */
+    ITKMesh::Pointer mesh_;
+    /** Merged UV map */
+    UVMap::Pointer uvMap_;
+};
+
+}  // namespace volcart::texturing
@@ -4,19 +4,19 @@
 #include <random>
 
 #include <opencv2/imgproc.hpp>
-#include <vtkIdList.h>
-#include <vtkOBBTree.h>
-#include <vtkPoints.h>
 
+#include "vc/core/types/FlatMesh.hpp"
 #include "vc/core/util/BarycentricCoordinates.hpp"
 #include "vc/core/util/ImageConversion.hpp"
-#include "vc/meshing/ITK2VTK.hpp"
-#include "vc/meshing/UVMapToITKMesh.hpp"
+#include "vc/core/util/Iteration.hpp"
+#include "vc/core/util/ThreadPool.hpp"
+#include "vc/texturing/MeshBVH.hpp"
 
 using namespace volcart;
 using namespace volcart::texturing;
 
-namespace vcm = volcart::meshing;
+// Distance, relative to the segment length, to advance past each hit
+static constexpr double HIT_EPSILON{1e-9};
 
 // Convert HSV values to RGB
 cv::Scalar HSVtoRGB(float h, float s, float v);
@@ -66,84 +66,80 @@ std::vector<cv::Mat> AlignmentMarkerGenerator::compute()
         }
     }
 
-    // For each mesh...
-    vcm::UVMapToITKMesh uv2mesh;
-    auto obb = vtkSmartPointer<vtkOBBTree>::New();
-    for (const auto& m : input_) {
-        // Convert image to 8bpc, 3-channel
-        auto marked = QuantizeImage(m.img, CV_8U);
-        marked = ColorConvertImage(marked, 3);
-        auto w = marked.cols;
-        auto h = marked.rows;
-
-        // Convert UVMap -> mesh -> vtkMesh (for convenience)
-        uv2mesh.setMesh(m.mesh);
-        uv2mesh.setUVMap(m.uv);
-        auto uvMesh = uv2mesh.compute();
-        auto vtkUVMesh = vtkSmartPointer<vtkPolyData>::New();
-        vcm::ITK2VTK(uvMesh, vtkUVMesh);
-
-        // Convert input mesh to vtkPolydata for OBBTree
-        auto vtkMesh = vtkSmartPointer<vtkPolyData>::New();
-        vcm::ITK2VTK(m.mesh, vtkMesh);
-
-        // Build obbtree for original mesh
-        cv::Vec3d origin, b0, b1, b2;
-        double size[3];
-        obb->ComputeOBB(vtkMesh, origin.val, b0.val, b1.val, b2.val, size);
-        obb->SetDataSet(vtkMesh);
-        obb->BuildLocator();
-
-        // For each line segment...
-        for (const auto& seg : lineSegments_) {
-            // Intersect seg with mesh
-            auto iPts = vtkSmartPointer<vtkPoints>::New();
-            auto iCells = vtkSmartPointer<vtkIdList>::New();
-            int ret =
-                obb->IntersectWithLine(seg.a.val, seg.b.val, iPts, iCells);
-
-            // No intersections, skip this seg
-            if (ret == 0) {
-                continue;
-            }
+    // Mark each mesh in parallel
+    output_.resize(input_.size());
+    ParallelFor(range(input_.size()), [this](auto i) {
+        output_[i] = mark_mesh_(input_[i]);
+    });
 
-            // For each intersection...
-            for (vtkIdType iID = 0; iID < iPts->GetNumberOfPoints(); iID++) {
-                // Get the 3D point and the face vert positions
-                cv::Vec3d pt_3D, v0_3D, v1_3D, v2_3D;
-                iPts->GetPoint(iID, pt_3D.val);
-                auto cellPts =
-                    vtkMesh->GetCell(iCells->GetId(iID))->GetPoints();
-                cellPts->GetPoint(0, v0_3D.val);
-                cellPts->GetPoint(1, v1_3D.val);
-                cellPts->GetPoint(2, v2_3D.val);
-
-                // Get the 2D face vert positions
-                cv::Vec3d pt_2D, v0_2D, v1_2D, v2_2D;
-                cellPts = vtkUVMesh->GetCell(iCells->GetId(iID))->GetPoints();
-                cellPts->GetPoint(0, v0_2D.val);
-                cellPts->GetPoint(1, v1_2D.val);
-                cellPts->GetPoint(2, v2_2D.val);
-
-                // Convert 3D -> UV
-                auto b = CartesianToBarycentric(pt_3D, v0_3D, v1_3D, v2_3D);
-                pt_2D = BarycentricToCartesian(b, v0_2D, v1_2D, v2_2D);
-
-                // Convert UV -> 2D
-                cv::Point center(
-                    static_cast<int>(pt_2D[0] * w),
-                    static_cast<int>(pt_2D[2] * h));
-
-                // Draw intersection point
-                cv::circle(
-                    marked, center, markerRadius_, seg.color, cv::FILLED);
+    return output_;
+}
+
+cv::Mat AlignmentMarkerGenerator::mark_mesh_(const TexturedMesh& m) const
+{
+    // Convert image to 8bpc, 3-channel
+    auto marked = QuantizeImage(m.img, CV_8U);
+    marked = ColorConvertImage(marked, 3);
+    auto w = marked.cols;
+    auto h = marked.rows;
+
+    // Build a BVH for the mesh
+    auto mesh = ToFlatMesh(m.mesh);
+    const auto& vertices = mesh.vertices();
+    const auto& faces = mesh.faces();
+    if (faces.empty()) {
+        return marked;
+    }
+    auto bvh = MeshBVH::New(mesh);
+
+    // Intersect the line segments in parallel. Each segment collects its own
+    // marker positions.
+    std::vector<std::vector<cv::Point>> markers(lineSegments_.size());
+    ParallelFor(range(lineSegments_.size()), [&](auto s) {
+        const auto& seg = lineSegments_[s];
+
+        // Find every intersection, nearest first, by restarting the ray
+        // past the previous hit
+        auto dir = seg.b - seg.a;
+        double tmin{0};
+        for (std::size_t n = 0; n < faces.size(); n++) {
+            auto hit = bvh->intersect(seg.a, dir, tmin, 1.0);
+            if (not hit) {
+                break;
             }
+            auto t = hit->t;
+            tmin = t + HIT_EPSILON;
+
+            // Get the 3D point and the face vert positions
+            const auto& face = faces[hit->face];
+            cv::Vec3d pt3D = seg.a + t * dir;
+            const auto& v0 = vertices[face[0]];
+            const auto& v1 = vertices[face[1]];
+            const auto& v2 = vertices[face[2]];
+
+            // Convert 3D -> UV
+            auto b = CartesianToBarycentric(pt3D, v0, v1, v2);
+            auto uv0 = m.uv->get(face[0]);
+            auto uv1 = m.uv->get(face[1]);
+            auto uv2 = m.uv->get(face[2]);
+            auto uv = b[0] * uv0 + b[1] * uv1 + b[2] * uv2;
+
+            // Convert UV -> 2D
+            markers[s].emplace_back(
+                static_cast<int>(uv[0] * w), static_cast<int>(uv[1] * h));
+        }
+    });
+
+    // Draw the intersection points in segment order
+    for (std::size_t s = 0; s < lineSegments_.size(); s++) {
+        for (const auto& center : markers[s]) {
+            cv::circle(
+                marked, center, markerRadius_, lineSegments_[s].color,
+                cv::FILLED);
         }
-
-        output_.push_back(marked);
     }
 
-    return output_;
+    return marked;
 }
 
 cv::Scalar HSVtoRGB(float h, float s, float v)
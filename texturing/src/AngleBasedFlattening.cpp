@@ -1,9 +1,21 @@
 #include "vc/texturing/AngleBasedFlattening.hpp"
 
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <vector>
+
+#include <Eigen/IterativeLinearSolvers>
+#include <Eigen/SparseCholesky>
+#include <Eigen/SparseLU>
 #include <OpenABF/OpenABF.hpp>
+#ifdef VC_HAS_CHOLMOD
+#include <Eigen/CholmodSupport>
+#endif
 
 #include "vc/core/util/Logging.hpp"
 #include "vc/core/util/MeshMath.hpp"
+#include "vc/core/util/Tracing.hpp"
 #include "vc/meshing/DeepCopy.hpp"
 #include "vc/meshing/ScaleMesh.hpp"
 
@@ -14,7 +26,159 @@ using namespace volcart::texturing;
 
 using ABF = OpenABF::ABFPlusPlus<double>;
 using HalfEdgeMesh = ABF::Mesh;
-using LSCM = OpenABF::AngleBasedLSCM<double, HalfEdgeMesh>;
+using SparseMatrix = Eigen::SparseMatrix<double>;
+using Solver = AngleBasedFlattening::Solver;
+
+// Whether CHOLMOD support was compiled in
+#ifdef VC_HAS_CHOLMOD
+constexpr bool HAS_CHOLMOD{true};
+#else
+constexpr bool HAS_CHOLMOD{false};
+#endif
+
+// LSCM with a specific sparse solver
+template <class SolverType>
+using LSCM = OpenABF::AngleBasedLSCM<double, HalfEdgeMesh, SolverType>;
+
+namespace
+{
+// Interior angle at a of the triangle abc. Negative if degenerate.
+template <int N>
+auto InteriorAngle(
+    const cv::Vec<double, N>& a,
+    const cv::Vec<double, N>& b,
+    const cv::Vec<double, N>& c) -> double
+{
+    auto ab = b - a;
+    auto ac = c - a;
+    auto denom = cv::norm(ab) * cv::norm(ac);
+    if (denom <= 0 or not std::isfinite(denom)) {
+        return -1;
+    }
+    return std::acos(std::clamp(ab.dot(ac) / denom, -1.0, 1.0));
+}
+
+// Number of faces in each state after seeding
+struct SeedCounts {
+    // Faces mapped by the seed
+    std::size_t mapped{0};
+    // Mapped faces whose 3D angles no longer match their seeded angles
+    std::size_t changed{0};
+};
+
+// Set the face angles of a half-edge mesh from a UV map. Faces whose seeded
+// angles differ from their current 3D angles by more than maxChange keep
+// their 3D angles. Angles are only modified if at least minCoverage of the
+// faces are mapped and unchanged.
+auto SeedAngles(
+    HalfEdgeMesh::Pointer& hem,
+    const UVMap& uvMap,
+    double minCoverage,
+    double maxChange) -> SeedCounts
+{
+    // UV coordinates are normalized separately in each dimension
+    auto ratio = uvMap.ratio();
+    auto width = (ratio.width > 0) ? ratio.width : ratio.aspect;
+    auto height = (ratio.height > 0) ? ratio.height : 1.0;
+    auto toPlane = [&uvMap, width, height](std::size_t idx) {
+        auto uv = uvMap.get(idx);
+        return cv::Vec2d{uv[0] * width, uv[1] * height};
+    };
+    auto toSpace = [](const auto& v) {
+        return cv::Vec3d{v->pos[0], v->pos[1], v->pos[2]};
+    };
+
+    // Compute the seeded angles of every face
+    const auto& faces = hem->faces();
+    std::vector<std::array<double, 3>> angles(faces.size());
+    std::vector<bool> valid(faces.size(), false);
+    SeedCounts counts;
+    for (std::size_t i = 0; i < faces.size(); i++) {
+        auto e0 = faces[i]->head;
+        auto e1 = e0->next;
+        auto e2 = e1->next;
+        std::array<std::size_t, 3> ids{
+            e0->vertex->idx, e1->vertex->idx, e2->vertex->idx};
+        if (not std::all_of(ids.begin(), ids.end(), [&uvMap](auto id) {
+                return uvMap.contains(id);
+            })) {
+            continue;
+        }
+
+        auto a = toPlane(ids[0]);
+        auto b = toPlane(ids[1]);
+        auto c = toPlane(ids[2]);
+        angles[i] = {
+            InteriorAngle(a, b, c), InteriorAngle(b, c, a),
+            InteriorAngle(c, a, b)};
+        if (not std::all_of(angles[i].begin(), angles[i].end(), [](auto v) {
+                return v > 0;
+            })) {
+            continue;
+        }
+        counts.mapped++;
+
+        // Compare with the current geometry of the face
+        auto p = toSpace(e0->vertex);
+        auto q = toSpace(e1->vertex);
+        auto r = toSpace(e2->vertex);
+        std::array<double, 3> current{
+            InteriorAngle(p, q, r), InteriorAngle(q, r, p),
+            InteriorAngle(r, p, q)};
+        auto changed = false;
+        for (std::size_t j = 0; j < 3; j++) {
+            changed |= std::abs(angles[i][j] - current[j]) > maxChange;
+        }
+        if (changed) {
+            counts.changed++;
+        } else {
+            valid[i] = true;
+        }
+    }
+
+    auto unchanged = counts.mapped - counts.changed;
+    if (static_cast<double>(unchanged) <
+        minCoverage * static_cast<double>(faces.size())) {
+        return counts;
+    }
+
+    // Replace the 3D angles of the unchanged faces
+    for (std::size_t i = 0; i < faces.size(); i++) {
+        if (not valid[i]) {
+            continue;
+        }
+        auto e0 = faces[i]->head;
+        auto e1 = e0->next;
+        auto e2 = e1->next;
+        e0->alpha = angles[i][0];
+        e1->alpha = angles[i][1];
+        e2->alpha = angles[i][2];
+    }
+    return counts;
+}
+
+// Solve LSCM with the selected solver
+void ComputeLSCM(HalfEdgeMesh::Pointer& hem, Solver solver)
+{
+    switch (solver) {
+        case Solver::SimplicialLDLT:
+            LSCM<Eigen::SimplicialLDLT<SparseMatrix>>::Compute(hem);
+            break;
+        case Solver::ConjugateGradient:
+            LSCM<Eigen::ConjugateGradient<
+                SparseMatrix, Eigen::Lower | Eigen::Upper>>::Compute(hem);
+            break;
+#ifdef VC_HAS_CHOLMOD
+        case Solver::Cholmod:
+            LSCM<Eigen::CholmodSupernodalLLT<SparseMatrix>>::Compute(hem);
+            break;
+#endif
+        default:
+            LSCM<Eigen::SparseLU<SparseMatrix, Eigen::COLAMDOrdering<int>>>::
+                Compute(hem);
+    }
+}
+}  // namespace
 
 AngleBasedFlattening::AngleBasedFlattening(const ITKMesh::Pointer& m)
     : FlatteningAlgorithm(m)
@@ -28,6 +192,18 @@ void AngleBasedFlattening::setABFMaxIterations(std::size_t i)
     maxABFIterations_ = i;
 }
 
+void AngleBasedFlattening::setSeedUVMap(const UVMap::Pointer& uv)
+{
+    seed_ = uv;
+}
+
+void AngleBasedFlattening::setSolver(Solver s) { solver_ = s; }
+
+auto AngleBasedFlattening::SolverAvailable(Solver s) -> bool
+{
+    return s != Solver::Cholmod or HAS_CHOLMOD;
+}
+
 ///// Process //////
 ITKMesh::Pointer AngleBasedFlattening::compute()
 {
@@ -63,24 +239,62 @@ ITKMesh::Pointer AngleBasedFlattening::compute()
         throw std::runtime_error("Input mesh is not manifold.");
     }
 
+    // Seed the face angles
+    abfIters_ = 0;
+    abfGrad_ = 0;
+    seeded_ = false;
+    seedChangedFaces_ = 0;
+    if (seed_ and not seed_->empty()) {
+        Logger()->info("Seeding face angles from prior UV map");
+        auto numFaces = hem->faces().size();
+        auto counts = SeedAngles(
+            hem, *seed_, MIN_SEED_COVERAGE, MAX_SEED_ANGLE_CHANGE);
+        auto unchanged = counts.mapped - counts.changed;
+        seeded_ = static_cast<double>(unchanged) >=
+                  MIN_SEED_COVERAGE * static_cast<double>(numFaces);
+        if (seeded_) {
+            seedChangedFaces_ = counts.changed;
+            Logger()->info(
+                "Seeded {} of {} faces. Re-solving {} changed faces.",
+                unchanged, numFaces, counts.changed);
+        } else if (counts.changed > 0) {
+            Logger()->warn(
+                "Geometry of {} of {} seeded faces has changed since the seed "
+                "UV map was computed. Ignoring seed.",
+                counts.changed, counts.mapped);
+        } else {
+            Logger()->warn(
+                "Seed UV map only maps {} of {} faces. Ignoring seed.",
+                counts.mapped, numFaces);
+        }
+    }
+
     // ABF
-    if (useABF_) {
+    if (useABF_ and not seeded_) {
         Logger()->info("Solving ABF++");
-        std::size_t iters{0};
-        double grad{0};
+        VC_TRACE_SPAN_CAT("flattening", "ABF++");
         try {
-            ABF::Compute(hem, iters, grad, maxABFIterations_);
+            ABF::Compute(hem, abfIters_, abfGrad_, maxABFIterations_);
         } catch (const OpenABF::SolverException& e) {
             Logger()->warn("Failed to solve ABF++. Falling back to LSCM.");
             Logger()->debug("SolverException: {}", e.what());
         }
         Logger()->info(
-            "ABF++ Iterations: {} || Final norm: {:.5g}", iters, grad);
+            "ABF++ Iterations: {} || Final norm: {:.5g}", abfIters_,
+            abfGrad_);
     }
 
     // LSCM
+    auto solver = solver_;
+    if (not SolverAvailable(solver)) {
+        Logger()->warn("Selected LSCM solver is unavailable. Using SparseLU.");
+        solver = Solver::SparseLU;
+    }
     Logger()->info("Solving LSCM");
-    LSCM::Compute(hem);
+    {
+        VC_TRACE_SPAN_CAT("flattening", "LSCM");
+        ComputeLSCM(hem, solver);
+    }
 
     // Fill output
     // OpenABF flattens to XY, but we want it on XZ
@@ -100,8 +314,8 @@ ITKMesh::Pointer AngleBasedFlattening::compute()
     // Scale mesh surface area to same as original
     auto scale = std::sqrt(SurfaceArea(mesh_) / SurfaceArea(flatMesh));
     Logger()->debug("Scaling output mesh by scale factor {:.5g}", scale);
-    output_ = ITKMesh::New();
-    ScaleMesh(flatMesh, output_, scale);
+    ScaleMeshInPlace(flatMesh, scale);
+    output_ = flatMesh;
 
     return output_;
 }
@@ -112,3 +326,24 @@ auto AngleBasedFlattening::abfMaxIterations() const -> std::size_t
 {
     return maxABFIterations_;
 }
+
+auto AngleBasedFlattening::seedUVMap() const -> UVMap::Pointer { return seed_; }
+
+auto AngleBasedFlattening::solver() const -> Solver { return solver_; }
+
+auto AngleBasedFlattening::abfIterations() const -> std::size_t
+{
+    return abfIters_;
+}
+
+auto AngleBasedFlattening::abfGradientNorm() const -> double
+{
+    return abfGrad_;
+}
+
+auto AngleBasedFlattening::seeded() const -> bool { return seeded_; }
+
+auto AngleBasedFlattening::seedChangedFaces() const -> std::size_t
+{
+    return seedChangedFaces_;
+}
@@ -0,0 +1,252 @@
+#include "vc/texturing/ChartFlattening.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+#include "vc/core/util/Logging.hpp"
+#include "vc/core/util/ThreadPool.hpp"
+#include "vc/core/util/Tracing.hpp"
+#include "vc/meshing/DeepCopy.hpp"
+#include "vc/texturing/UVAtlas.hpp"
+
+using namespace volcart;
+using namespace volcart::meshing;
+using namespace volcart::texturing;
+
+namespace
+{
+// A chart extracted from the input mesh
+struct Chart {
+    // Chart mesh, with local vertex ids
+    ITKMesh::Pointer mesh;
+    // Input vertex id of each local vertex
+    std::vector<std::size_t> vertices;
+    // Flattened position of each local vertex
+    std::vector<cv::Vec2d> uvs;
+    // Bounds of the flattened chart
+    cv::Vec2d min{0, 0};
+    cv::Vec2d max{0, 0};
+};
+
+// Disjoint-set forest over vertex ids
+class DisjointSet
+{
+public:
+    explicit DisjointSet(std::size_t n) : parent_(n)
+    {
+        std::iota(parent_.begin(), parent_.end(), 0);
+    }
+
+    auto find(std::size_t a) -> std::size_t
+    {
+        while (parent_[a] != a) {
+            parent_[a] = parent_[parent_[a]];
+            a = parent_[a];
+        }
+        return a;
+    }
+
+    void merge(std::size_t a, std::size_t b)
+    {
+        a = find(a);
+        b = find(b);
+        if (a != b) {
+            parent_[std::max(a, b)] = std::min(a, b);
+        }
+    }
+
+private:
+    std::vector<std::size_t> parent_;
+};
+
+// Shelf-pack the charts' bounding boxes. Returns the offset of each chart.
+auto PackCharts(const std::vector<Chart>& charts, double padding)
+    -> std::vector<cv::Vec2d>
+{
+    std::vector<cv::Vec2d> sizes;
+    sizes.reserve(charts.size());
+    for (const auto& c : charts) {
+        sizes.push_back(c.max - c.min);
+    }
+    auto offsets = PackRectangles(sizes, padding);
+    for (std::size_t i = 0; i < charts.size(); i++) {
+        offsets[i] -= charts[i].min;
+    }
+    return offsets;
+}
+}  // namespace
+
+ChartFlattening::ChartFlattening(const ITKMesh::Pointer& m)
+    : FlatteningAlgorithm(m)
+{
+}
+
+void ChartFlattening::setUseABF(bool a) { useABF_ = a; }
+
+auto ChartFlattening::useABF() const -> bool { return useABF_; }
+
+void ChartFlattening::setABFMaxIterations(std::size_t i)
+{
+    maxABFIterations_ = i;
+}
+
+auto ChartFlattening::abfMaxIterations() const -> std::size_t
+{
+    return maxABFIterations_;
+}
+
+void ChartFlattening::setSolver(AngleBasedFlattening::Solver s)
+{
+    solver_ = s;
+}
+
+auto ChartFlattening::solver() const -> AngleBasedFlattening::Solver
+{
+    return solver_;
+}
+
+void ChartFlattening::setPadding(double p) { padding_ = p; }
+
+auto ChartFlattening::padding() const -> double { return padding_; }
+
+auto ChartFlattening::numCharts() const -> std::size_t { return numCharts_; }
+
+auto ChartFlattening::faceCharts() const -> const std::vector<std::size_t>&
+{
+    return faceCharts_;
+}
+
+auto ChartFlattening::compute() -> ITKMesh::Pointer
+{
+    const auto numVerts = mesh_->GetNumberOfPoints();
+    const auto numFaces = mesh_->GetNumberOfCells();
+
+    // Label the charts: faces connected by shared vertices
+    std::vector<std::array<std::size_t, 3>> faces;
+    faces.reserve(numFaces);
+    DisjointSet sets(numVerts);
+    for (auto cell = mesh_->GetCells()->Begin();
+         cell != mesh_->GetCells()->End(); ++cell) {
+        const auto& ids = cell.Value()->GetPointIdsContainer();
+        faces.push_back({ids[0], ids[1], ids[2]});
+        sets.merge(ids[0], ids[1]);
+        sets.merge(ids[0], ids[2]);
+    }
+
+    constexpr auto NONE = std::numeric_limits<std::size_t>::max();
+    std::vector<std::size_t> rootChart(numVerts, NONE);
+    faceCharts_.assign(numFaces, 0);
+    numCharts_ = 0;
+    for (std::size_t f = 0; f < numFaces; f++) {
+        auto root = sets.find(faces[f][0]);
+        if (rootChart[root] == NONE) {
+            rootChart[root] = numCharts_++;
+        }
+        faceCharts_[f] = rootChart[root];
+    }
+    Logger()->info("Found {} chart(s)", numCharts_);
+
+    // Configure a flattener
+    auto newFlattener = [this](const ITKMesh::Pointer& m) {
+        AngleBasedFlattening abf(m);
+        abf.setUseABF(useABF_);
+        abf.setABFMaxIterations(maxABFIterations_);
+        abf.setSolver(solver_);
+        return abf;
+    };
+
+    // A single chart is flattened directly
+    if (numCharts_ <= 1) {
+        auto abf = newFlattener(mesh_);
+        output_ = abf.compute();
+        return output_;
+    }
+
+    // Extract the charts
+    std::vector<Chart> charts(numCharts_);
+    std::vector<std::size_t> localId(numVerts, NONE);
+    for (std::size_t c = 0; c < numCharts_; c++) {
+        charts[c].mesh = ITKMesh::New();
+    }
+    ITKCell::CellAutoPointer cell;
+    std::vector<std::size_t> numChartFaces(numCharts_, 0);
+    for (std::size_t f = 0; f < numFaces; f++) {
+        auto& chart = charts[faceCharts_[f]];
+        cell.TakeOwnership(new ITKTriangle);
+        for (unsigned int i = 0; i < 3; i++) {
+            auto v = faces[f][i];
+            if (localId[v] == NONE) {
+                localId[v] = chart.vertices.size();
+                chart.mesh->SetPoint(localId[v], mesh_->GetPoint(v));
+                chart.vertices.push_back(v);
+            }
+            cell->SetPointId(i, localId[v]);
+        }
+        chart.mesh->SetCell(numChartFaces[faceCharts_[f]]++, cell);
+    }
+
+    // Flatten the charts in parallel, largest first
+    std::vector<std::size_t> order(numCharts_);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](auto a, auto b) {
+        return numChartFaces[a] > numChartFaces[b];
+    });
+    ParallelChunks(numCharts_, numCharts_, [&](auto begin, auto end) {
+        for (auto i = begin; i < end; i++) {
+            VC_TRACE_SPAN_CAT("flattening", "Chart");
+            auto& chart = charts[order[i]];
+            auto abf = newFlattener(chart.mesh);
+            auto flat = abf.compute();
+
+            // Flattened charts are on the XZ plane
+            chart.uvs.resize(chart.vertices.size());
+            chart.min = {
+                std::numeric_limits<double>::max(),
+                std::numeric_limits<double>::max()};
+            chart.max = {
+                std::numeric_limits<double>::lowest(),
+                std::numeric_limits<double>::lowest()};
+            for (std::size_t v = 0; v < chart.vertices.size(); v++) {
+                auto pt = flat->GetPoint(v);
+                chart.uvs[v] = {pt[0], pt[2]};
+                for (int d = 0; d < 2; d++) {
+                    chart.min[d] = std::min(chart.min[d], chart.uvs[v][d]);
+                    chart.max[d] = std::max(chart.max[d], chart.uvs[v][d]);
+                }
+            }
+            chart.mesh = nullptr;
+        }
+    });
+
+    // Pack the charts into one atlas
+    Logger()->debug("Packing charts");
+    auto offsets = PackCharts(charts, padding_);
+
+    // Fill output. Unused vertices stay at the origin.
+    output_ = ITKMesh::New();
+    DeepCopy(mesh_, output_);
+    ITKPoint pt;
+    pt.Fill(0);
+    cv::Vec3d norm{0.0, 1.0, 0.0};
+    for (std::size_t id = 0; id < numVerts; id++) {
+        output_->SetPoint(id, pt);
+        output_->SetPointData(id, norm.val);
+    }
+    for (std::size_t c = 0; c < numCharts_; c++) {
+        const auto& chart = charts[c];
+        for (std::size_t v = 0; v < chart.vertices.size(); v++) {
+            auto uv = chart.uvs[v] + offsets[c];
+            pt[0] = uv[0];
+            pt[2] = uv[1];
+            output_->SetPoint(chart.vertices[v], pt);
+        }
+    }
+
+    return output_;
+}
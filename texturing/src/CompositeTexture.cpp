@@ -1,14 +1,80 @@
 #include "vc/texturing/CompositeTexture.hpp"
 
 #include <algorithm>
+#include <array>
+#include <cmath>
+#include <numeric>
+#include <vector>
 
 #include "vc/core/util/FloatComparison.hpp"
+#include "vc/texturing/GPULineSampling.hpp"
 
 static constexpr double MEDIAN_MEAN_PERCENT_RANGE = 0.70;
 
 using namespace volcart;
 using namespace volcart::texturing;
 
+namespace
+{
+// Neighborhoods up to these lengths are filtered in stack buffers
+constexpr std::size_t SMALL_NEIGHBORHOOD{16};
+constexpr std::size_t LARGE_NEIGHBORHOOD{64};
+
+// Rounded mean of a contiguous range of samples
+auto Mean(const uint16_t* v, std::size_t size) -> uint16_t
+{
+    auto sum = std::accumulate(v, v + size, double{0});
+    return static_cast<uint16_t>(std::round(sum / size));
+}
+
+// Copy the samples into a fixed-size buffer and apply fn to the copy
+template <std::size_t N, typename Fn>
+auto WithBuffer(const uint16_t* v, std::size_t size, Fn fn) -> uint16_t
+{
+    std::array<uint16_t, N> buffer;
+    std::copy_n(v, size, buffer.begin());
+    return fn(buffer.data(), size);
+}
+
+// Apply fn to a modifiable copy of the neighborhood samples. Selection
+// reorders the samples, so it can't operate on the neighborhood itself.
+// Common neighborhood lengths use a stack buffer. Longer neighborhoods reuse
+// a per-thread buffer, so no filter allocates on every pixel.
+template <typename Fn>
+auto WithScratch(NDArrayView<const uint16_t> n, Fn fn) -> uint16_t
+{
+    const auto* v = n.data();
+    const auto size = n.size();
+    if (size <= SMALL_NEIGHBORHOOD) {
+        return WithBuffer<SMALL_NEIGHBORHOOD>(v, size, fn);
+    }
+    if (size <= LARGE_NEIGHBORHOOD) {
+        return WithBuffer<LARGE_NEIGHBORHOOD>(v, size, fn);
+    }
+    thread_local std::vector<uint16_t> scratch;
+    scratch.assign(v, v + size);
+    return fn(scratch.data(), size);
+}
+
+auto ToLineReduction(CompositeTexture::Filter f) -> gpu::LineReduction
+{
+    using Filter = CompositeTexture::Filter;
+    switch (f) {
+        case Filter::Minimum:
+            return gpu::LineReduction::Minimum;
+        case Filter::Maximum:
+            return gpu::LineReduction::Maximum;
+        case Filter::Median:
+            return gpu::LineReduction::Median;
+        case Filter::Mean:
+            return gpu::LineReduction::Mean;
+        case Filter::MedianAverage:
+            return gpu::LineReduction::MedianAverage;
+    }
+    return gpu::LineReduction::Mean;
+}
+}  // namespace
+
 using Texture = CompositeTexture::Texture;
 
 Texture CompositeTexture::compute()
@@ -24,41 +90,47 @@ Texture CompositeTexture::compute()
 
     // Output image
     cv::Mat image = cv::Mat::zeros(height, width, CV_16UC1);
+    result_.push_back(image);
 
-    // Get the mappings
-    auto mappings = ppm_->getMappings();
-
-    // Sort the mappings by Z-value
-    std::sort(
-        mappings.begin(), mappings.end(), [](const auto& lhs, const auto& rhs) {
-            return lhs.pos[2] < rhs.pos[2];
-        });
+    // Sample on the GPU if requested and supported
+    gpu::LineParams line;
+    if (use_gpu_() and gpu::GetLineParams(*gen_, line)) {
+        progressStarted();
+        gpu::CompositeLines(
+            *vol_, *ppm_, line, ToLineReduction(filter_),
+            MEDIAN_MEAN_PERCENT_RANGE, image,
+            [this](std::size_t n) { progressUpdated(n); });
+        progressComplete();
+        track_result_();
+        return result_;
+    }
 
-    // Iterate through the mappings
-    size_t counter = 0;
+    // Filter the neighborhood of every mapping
+    const auto size = gen_->size();
     progressStarted();
-    for (const auto& pixel : mappings) {
-        progressUpdated(counter++);
-
-        // Generate the neighborhood
-        auto neighborhood = get_neighborhood_(pixel.pos, pixel.normal);
-
-        // Assign the intensity value at the UV position
-        image.at<uint16_t>(
-            static_cast<int>(pixel.y), static_cast<int>(pixel.x)) =
-            filter_neighborhood_(neighborhood);
-    }
+    for_each_neighborhood_(*gen_, [&](int x, int y, const uint16_t* samples) {
+        image.at<uint16_t>(y, x) = FilterNeighborhood(
+            NDArrayView<const uint16_t>(samples, {size}), filter_);
+    });
     progressComplete();
 
-    // Set output
-    result_.push_back(image);
-
+    track_result_();
     return result_;
 }
 
-uint16_t CompositeTexture::filter_neighborhood_(const Neighborhood& n)
+uint16_t CompositeTexture::FilterNeighborhood(const Neighborhood& n, Filter f)
+{
+    return FilterNeighborhood(n.view(), f);
+}
+
+uint16_t CompositeTexture::FilterNeighborhood(
+    NDArrayView<const uint16_t> n, Filter f)
 {
-    switch (filter_) {
+    if (n.size() == 0) {
+        return 0;
+    }
+
+    switch (f) {
         case Filter::Minimum:
             return min_(n);
         case Filter::Maximum:
@@ -72,29 +144,31 @@ uint16_t CompositeTexture::filter_neighborhood_(const Neighborhood& n)
     }
 }
 
-uint16_t CompositeTexture::min_(Neighborhood n)
+uint16_t CompositeTexture::min_(NDArrayView<const uint16_t> n)
 {
     return *std::min_element(n.begin(), n.end());
 }
 
-uint16_t CompositeTexture::max_(Neighborhood n)
+uint16_t CompositeTexture::max_(NDArrayView<const uint16_t> n)
 {
     return *std::max_element(n.begin(), n.end());
 }
 
-uint16_t CompositeTexture::median_(Neighborhood n)
+uint16_t CompositeTexture::median_(NDArrayView<const uint16_t> n)
 {
-    std::nth_element(n.begin(), n.begin() + n.size() / 2, n.end());
-    return n(n.size() / 2);
+    return WithScratch(n, [](uint16_t* v, std::size_t size) {
+        std::nth_element(v, v + size / 2, v + size);
+        return v[size / 2];
+    });
 }
 
-uint16_t CompositeTexture::mean_(Neighborhood n)
+uint16_t CompositeTexture::mean_(NDArrayView<const uint16_t> n)
 {
-    auto sum = std::accumulate(std::begin(n), std::end(n), double{0});
-    return static_cast<uint16_t>(std::round(sum / n.size()));
+    return Mean(n.data(), n.size());
 }
 
-uint16_t CompositeTexture::median_mean_(Neighborhood n, double range)
+uint16_t CompositeTexture::median_mean_(
+    NDArrayView<const uint16_t> n, double range)
 {
     // If the range is 1.0, it's just a normal mean operation
     if (AlmostEqual<double>(range, 1.0)) {
@@ -103,27 +177,21 @@ uint16_t CompositeTexture::median_mean_(Neighborhood n, double range)
         return 0;
     }
 
-    // Sort
-    std::sort(n.begin(), n.end());
-
     // The number of things we're going to sum
     auto count = static_cast<size_t>(std::ceil(n.size() * range));
     // The number of things before we start summing
     auto offset = static_cast<size_t>(std::floor((n.size() - count) / 2.0));
 
-    // Sum
-    auto sum = std::accumulate(
-        n.begin() + offset, n.begin() + offset + count, double{0});
-
-    // Average
-    return static_cast<uint16_t>(std::round(sum / count));
+    return WithScratch(n, [offset, count](uint16_t* v, std::size_t size) {
+        // Move the smallest `offset` values to the front, then the next
+        // `count` values after them. The summed range holds the same values
+        // as it would after a full sort.
+        auto first = v + offset;
+        auto last = first + count;
+        std::nth_element(v, first, v + size);
+        if (last < v + size) {
+            std::nth_element(first, last, v + size);
+        }
+        return Mean(first, count);
+    });
 }
-
-Neighborhood CompositeTexture::get_neighborhood_(
-    const cv::Vec3d& p, const cv::Vec3d& n)
-{
-    auto neighborhood = gen_->compute(vol_, p, {n});
-    Neighborhood::Flatten(neighborhood, 1);
-
-    return neighborhood;
-}
\ No newline at end of file
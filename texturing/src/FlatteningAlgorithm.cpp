@@ -1,7 +1,14 @@
 #include "vc/texturing/FlatteningAlgorithm.hpp"
 
+#include <algorithm>
+#include <limits>
+#include <mutex>
+#include <vector>
+
 #include "vc/core/util/FloatComparison.hpp"
+#include "vc/core/util/Iteration.hpp"
 #include "vc/core/util/MeshMath.hpp"
+#include "vc/core/util/ThreadPool.hpp"
 
 using namespace volcart;
 using namespace volcart::texturing;
@@ -12,16 +19,31 @@ UVMap::Pointer FlatteningAlgorithm::getUVMap()
 {
     // Setup uvMap
     auto uvMap = UVMap::New();
+    const auto& points = output_->GetPoints()->CastToSTLConstContainer();
 
     // Get bounds
-    auto bb = ITKMesh::BoundingBoxType::New();
-    bb->SetPoints(output_->GetPoints());
-    bb->ComputeBoundingBox();
-
-    auto uMin = bb->GetBounds()[0];
-    auto uMax = bb->GetBounds()[1];
-    auto vMin = bb->GetBounds()[4];
-    auto vMax = bb->GetBounds()[5];
+    auto uMin = std::numeric_limits<double>::max();
+    auto uMax = std::numeric_limits<double>::lowest();
+    auto vMin = uMin;
+    auto vMax = uMax;
+    std::mutex boundsMutex;
+    ParallelChunks(points.size(), 0, [&](auto begin, auto end) {
+        auto u0 = std::numeric_limits<double>::max();
+        auto u1 = std::numeric_limits<double>::lowest();
+        auto v0 = u0;
+        auto v1 = u1;
+        for (auto i = begin; i < end; i++) {
+            u0 = std::min(u0, points[i][0]);
+            u1 = std::max(u1, points[i][0]);
+            v0 = std::min(v0, points[i][2]);
+            v1 = std::max(v1, points[i][2]);
+        }
+        const std::lock_guard<std::mutex> lock(boundsMutex);
+        uMin = std::min(uMin, u0);
+        uMax = std::max(uMax, u1);
+        vMin = std::min(vMin, v0);
+        vMax = std::max(vMax, v1);
+    });
 
     // Set the UV map ratio and get linear scale factor
     auto scale = sqrt(mm::SurfaceArea(mesh_) / mm::SurfaceArea(output_));
@@ -29,16 +51,14 @@ UVMap::Pointer FlatteningAlgorithm::getUVMap()
     auto aspectHeight = std::abs(vMax - vMin);
     uvMap->ratio(aspectWidth * scale, aspectHeight * scale);
 
-    // Calculate uv coordinates
-    cv::Vec2d uv;
-    for (auto it = output_->GetPoints()->Begin();
-         it != output_->GetPoints()->End(); ++it) {
-        uv[0] = (it->Value()[0] - uMin) / (uMax - uMin);
-        uv[1] = (it->Value()[2] - vMin) / (vMax - vMin);
-
-        // Add the uv coordinates into our map at the point index specified
-        uvMap->set(it->Index(), uv);
-    }
+    // Calculate uv coordinates directly into the map's storage, which is
+    // indexed by point ID and relative to the top-left origin
+    std::vector<cv::Vec2d> uvs(points.size());
+    ParallelFor(range(points.size()), [&](auto i) {
+        uvs[i][0] = (points[i][0] - uMin) / (uMax - uMin);
+        uvs[i][1] = (points[i][2] - vMin) / (vMax - vMin);
+    });
+    uvMap->from_vector(std::move(uvs));
 
     return uvMap;
 }
@@ -5,31 +5,20 @@
 #include <opencv2/imgproc.hpp>
 
 #include "vc/core/types/Color.hpp"
+#include "vc/core/types/FlatMesh.hpp"
 #include "vc/core/util/ApplyLUT.hpp"
 #include "vc/core/util/FloatComparison.hpp"
 #include "vc/core/util/Logging.hpp"
 #include "vc/core/util/MeshMath.hpp"
+#include "vc/core/util/ThreadPool.hpp"
 
 using namespace volcart;
 using namespace volcart::texturing;
 namespace vct = volcart::texturing;
 
-std::vector<cv::Vec3d> GetCellVertices(
-    const ITKMesh::Pointer& mesh,
-    const ITKCell::PointIdentifierContainerType& ids)
-{
-
-    // Output vector
-    std::vector<cv::Vec3d> pts;
-
-    // For each id, add a new vec3d
-    for (const auto& id : ids) {
-        auto p = mesh->GetPoint(id);
-        pts.emplace_back(p[0], p[1], p[2]);
-    }
-
-    return pts;
-}
+// Faces per block of the parallel reduction. The global metrics are summed
+// block-by-block in a fixed order, so they don't depend on the thread count.
+static constexpr std::size_t REDUCE_BLOCK_FACES{4096};
 
 static std::tuple<double, double, double, double, double> CalculateGammas(
     const cv::Vec3d& p1,
@@ -84,7 +73,9 @@ static std::pair<double, double> TriLStretch(
 }
 
 LStretchMetrics vct::LStretch(
-    const ITKMesh::Pointer& mesh3D, const ITKMesh::Pointer& mesh2D)
+    const ITKMesh::Pointer& mesh3D,
+    const ITKMesh::Pointer& mesh2D,
+    std::size_t numThreads)
 {
     if (mesh3D->GetNumberOfCells() != mesh2D->GetNumberOfCells()) {
         throw std::runtime_error(
@@ -96,39 +87,69 @@ LStretchMetrics vct::LStretch(
             "Original and flattened meshes have mismatched number of vertices");
     }
 
-    // Iterate over the faces
-    auto cell = mesh3D->GetCells()->Begin();
-    auto end = mesh3D->GetCells()->End();
+    // Contiguous copies of the vertices. Faces are taken from the 3D mesh.
+    auto flat3D = ToFlatMesh(mesh3D);
+    const auto& faces = flat3D.faces();
+    const auto& verts3D = flat3D.vertices();
+    std::vector<cv::Vec3d> verts2D(mesh2D->GetNumberOfPoints());
+    for (auto pt = mesh2D->GetPoints()->Begin();
+         pt != mesh2D->GetPoints()->End(); ++pt) {
+        const auto& p = pt.Value();
+        verts2D.at(pt.Index()) = {p[0], p[1], p[2]};
+    }
+
+    // Per-block partial sums of the global metrics
+    const auto numFaces = faces.size();
+    const auto numBlocks =
+        (numFaces + REDUCE_BLOCK_FACES - 1) / REDUCE_BLOCK_FACES;
+    std::vector<double> blockSumL2(numBlocks, 0);
+    std::vector<double> blockArea(numBlocks, 0);
+    std::vector<double> blockLInf(numBlocks, 0);
 
     // Calculate metrics
     LStretchMetrics metrics;
+    metrics.faceL2.resize(numFaces);
+    metrics.faceLInf.resize(numFaces);
+    ParallelChunks(numBlocks, numThreads, [&](auto begin, auto end) {
+        for (auto block = begin; block < end; block++) {
+            auto faceEnd = std::min((block + 1) * REDUCE_BLOCK_FACES, numFaces);
+            for (auto i = block * REDUCE_BLOCK_FACES; i < faceEnd; i++) {
+                // Get the vertices
+                const auto& f = faces[i];
+                const auto& q0 = verts3D[f[0]];
+                const auto& q1 = verts3D[f[1]];
+                const auto& q2 = verts3D[f[2]];
+
+                // Calculate LStretch(T) for this face
+                const auto& [l2, lInf] = TriLStretch(
+                    verts2D[f[0]], verts2D[f[1]], verts2D[f[2]], q0, q1, q2);
+                metrics.faceL2[i] = l2;
+                metrics.faceLInf[i] = lInf;
+
+                // Update block LInf
+                blockLInf[block] = std::max(blockLInf[block], lInf);
+
+                // A'(T)
+                auto a = cv::norm(q1 - q0);
+                auto b = cv::norm(q2 - q0);
+                auto c = cv::norm(q2 - q1);
+                auto area3D = meshmath::TriangleArea(a, b, c);
+
+                // sum L2Stretch(T)^2 * A'(T)
+                blockSumL2[block] += l2 * l2 * area3D;
+                // sum A'(T)
+                blockArea[block] += area3D;
+            }
+        }
+    });
+
+    // Reduce the blocks
     double sumL2{0};
     double area3DTotal{0};
-    for (; cell != end; ++cell) {
-        // Get the vertices
-        auto vIds = cell.Value()->GetPointIdsContainer();
-        auto p = GetCellVertices(mesh2D, vIds);
-        auto q = GetCellVertices(mesh3D, vIds);
-
-        // Calculate LStretch(T) for this face
-        const auto& [l2, lInf] =
-            TriLStretch(p[0], p[1], p[2], q[0], q[1], q[2]);
-        metrics.faceL2.push_back(l2);
-        metrics.faceLInf.push_back(lInf);
-
-        // Update global LInf
-        metrics.lInf = std::max(metrics.lInf, lInf);
-
-        // A'(T)
-        auto a = cv::norm(q[1] - q[0]);
-        auto b = cv::norm(q[2] - q[0]);
-        auto c = cv::norm(q[2] - q[1]);
-        auto area3D = meshmath::TriangleArea(a, b, c);
-
-        // sum L2Stretch(T)^2 * A'(T)
-        sumL2 += l2 * l2 * area3D;
-        // sum A'(T)
-        area3DTotal += area3D;
+    for (std::size_t block = 0; block < numBlocks; block++) {
+        sumL2 += blockSumL2[block];
+        area3DTotal += blockArea[block];
+        metrics.lInf = std::max(metrics.lInf, blockLInf[block]);
     }
 
     // Calculate global L2
@@ -257,15 +278,31 @@ std::vector<cv::Mat> vct::PlotLStretchError(
     const auto& faceL2 = metrics.faceL2;
     const auto& faceLInf = metrics.faceLInf;
 
-    // Plot raw L stretch
-    auto l2Plot = PlotPerFaceError(cellMap, faceL2, 1);
-    auto lInfPlot = PlotPerFaceError(cellMap, faceLInf, 1);
-
-    // Generate mask
-    cv::Mat mask;
-    cellMap.convertTo(mask, CV_32F);
-    cv::threshold(mask, mask, -1, 255, cv::THRESH_BINARY);
-    mask.convertTo(mask, CV_8U);
+    // Plot raw L stretch and generate the mask in a single pass over the
+    // cell map
+    cv::Mat l2Plot(cellMap.rows, cellMap.cols, CV_32FC1);
+    cv::Mat lInfPlot(cellMap.rows, cellMap.cols, CV_32FC1);
+    cv::Mat mask(cellMap.rows, cellMap.cols, CV_8UC1);
+    auto rows = static_cast<std::size_t>(cellMap.rows);
+    ParallelChunks(rows, 0, [&](auto begin, auto end) {
+        for (auto y = static_cast<int>(begin); y < static_cast<int>(end); y++) {
+            const auto* cells = cellMap.ptr<int32_t>(y);
+            auto* l2Row = l2Plot.ptr<float>(y);
+            auto* lInfRow = lInfPlot.ptr<float>(y);
+            auto* maskRow = mask.ptr<uint8_t>(y);
+            for (int x = 0; x < cellMap.cols; x++) {
+                auto cell = cells[x];
+                if (cell >= 0) {
+                    l2Row[x] = static_cast<float>(faceL2.at(cell));
+                    lInfRow[x] = static_cast<float>(faceLInf.at(cell));
+                    maskRow[x] = 255;
+                } else {
+                    l2Row[x] = lInfRow[x] = 1;
+                    maskRow[x] = 0;
+                }
+            }
+        }
+    });
 
     // Apply LUT
     auto lut = GetColorMapLUT(cm);
@@ -0,0 +1,334 @@
+#include "vc/texturing/GPULineSampling.hpp"
+
+#include <stdexcept>
+
+#include "vc/core/neighborhood/LineGenerator.hpp"
+#include "vc/core/util/Logging.hpp"
+
+#ifdef VC_HAS_CUDA
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+
+#include "GPULineSamplingKernels.hpp"
+#include "vc/core/util/FloatComparison.hpp"
+#endif
+
+using namespace volcart;
+using namespace volcart::texturing;
+
+namespace tg = volcart::texturing::gpu;
+
+auto tg::GetLineParams(const NeighborhoodGenerator& gen, LineParams& line)
+    -> bool
+{
+    if (not Available()) {
+        Logger()->warn("GPU texturing is not available. Using the CPU.");
+        return false;
+    }
+    const auto* lineGen = dynamic_cast<const LineGenerator*>(&gen);
+    if (lineGen == nullptr) {
+        Logger()->warn(
+            "GPU texturing only supports line neighborhoods. Using the CPU.");
+        return false;
+    }
+    auto count = lineGen->extents()[0];
+    if (count == 0 or count > MAX_LINE_SAMPLES or
+        not(lineGen->samplingInterval() > 0)) {
+        Logger()->warn(
+            "GPU texturing does not support this neighborhood. Using the "
+            "CPU.");
+        return false;
+    }
+    line.start = lineGen->lineStart();
+    line.interval = lineGen->samplingInterval();
+    line.count = count;
+    return true;
+}
+
+#ifdef VC_HAS_CUDA
+namespace
+{
+// Maximum number of pixels in a batch
+constexpr std::size_t BATCH_PIXELS{std::size_t{1} << 20};
+// Maximum number of voxels uploaded for a batch (256 MiB)
+constexpr std::size_t MAX_BRICK_VOXELS{std::size_t{1} << 27};
+// Number of possible intensity values
+constexpr std::size_t INTENSITY_VALUES{
+    std::numeric_limits<uint16_t>::max() + std::size_t{1}};
+
+// Voxel index range [min, max) along each axis
+struct Bounds {
+    cv::Vec3i min{0, 0, 0};
+    cv::Vec3i max{0, 0, 0};
+
+    [[nodiscard]] auto empty() const -> bool
+    {
+        return max[0] <= min[0] or max[1] <= min[1] or max[2] <= min[2];
+    }
+
+    [[nodiscard]] auto voxels() const -> std::size_t
+    {
+        if (empty()) {
+            return 0;
+        }
+        return std::size_t(max[0] - min[0]) * std::size_t(max[1] - min[1]) *
+               std::size_t(max[2] - min[2]);
+    }
+
+    [[nodiscard]] auto merged(const Bounds& o) const -> Bounds
+    {
+        if (empty()) {
+            return o;
+        }
+        if (o.empty()) {
+            return *this;
+        }
+        Bounds b;
+        for (int i = 0; i < 3; i++) {
+            b.min[i] = std::min(min[i], o.min[i]);
+            b.max[i] = std::max(max[i], o.max[i]);
+        }
+        return b;
+    }
+};
+
+// Voxel index clamped to [0, dim]. NaN is 0.
+auto ClampIndex(double v, int dim) -> int
+{
+    if (not(v > 0)) {
+        return 0;
+    }
+    if (v >= dim) {
+        return dim;
+    }
+    return static_cast<int>(v);
+}
+
+// Voxels of the volume which are used to interpolate the samples of a line
+auto LineBounds(
+    const cv::Vec3d& pos,
+    const cv::Vec3d& normal,
+    const tg::LineParams& line,
+    const cv::Vec3i& dims) -> Bounds
+{
+    cv::Vec3d a = pos + normal * line.start;
+    cv::Vec3d b = a + normal * (line.interval * double(line.count - 1));
+    Bounds bounds;
+    for (int i = 0; i < 3; i++) {
+        // Interpolation reads the voxels at floor(v) and floor(v) + 1. The
+        // extra voxel on each side covers the rounding error of stepping
+        // along the line.
+        auto lo = std::floor(std::min(a[i], b[i])) - 1;
+        auto hi = std::floor(std::max(a[i], b[i])) + 3;
+        bounds.min[i] = ClampIndex(lo, dims[i]);
+        bounds.max[i] = ClampIndex(hi, dims[i]);
+    }
+    return bounds;
+}
+
+void CheckLine(const tg::LineParams& line)
+{
+    if (not tg::Available()) {
+        throw std::runtime_error("No CUDA device is available");
+    }
+    if (line.count == 0 or line.count > tg::MAX_LINE_SAMPLES) {
+        throw std::runtime_error("Unsupported number of line samples");
+    }
+}
+
+void CheckImage(const PerPixelMap& ppm, const cv::Mat& image, int type)
+{
+    cv::Size size(
+        static_cast<int>(ppm.width()), static_cast<int>(ppm.height()));
+    if (image.type() != type or image.size() != size) {
+        throw std::invalid_argument("Output image does not match the PPM");
+    }
+}
+
+auto ToDetail(const tg::LineParams& line) -> tg::detail::Line
+{
+    return {line.start, line.interval, static_cast<int>(line.count)};
+}
+
+// Group the mapped pixels into batches whose samples fit in a subvolume of
+// at most MAX_BRICK_VOXELS voxels, copy each subvolume from the Volume, and
+// call fn(brick, pos, normals, pixels) for each batch
+template <typename Fn>
+void ForEachBatch(
+    const Volume& vol,
+    const PerPixelMap& ppm,
+    const tg::LineParams& line,
+    const tg::Progress& progress,
+    Fn fn)
+{
+    const cv::Vec3i dims(vol.sliceWidth(), vol.sliceHeight(), vol.numSlices());
+    const std::array<cv::Vec3i, 3> steps{
+        cv::Vec3i{0, 0, 1}, cv::Vec3i{0, 1, 0}, cv::Vec3i{1, 0, 0}};
+    auto mappings = ppm.getMappingIndices(PerPixelMap::MappingOrder::Slice);
+
+    std::vector<double> pos;
+    std::vector<double> normals;
+    std::vector<cv::Point> pixels;
+    std::vector<uint16_t> voxels;
+    std::size_t i{0};
+    while (i < mappings.size()) {
+        // Gather the batch
+        Bounds bounds;
+        pos.clear();
+        normals.clear();
+        pixels.clear();
+        for (; i < mappings.size() and pixels.size() < BATCH_PIXELS; i++) {
+            auto pixel = ppm.getAsPixelMap(mappings[i]);
+            auto merged =
+                bounds.merged(LineBounds(pixel.pos, pixel.normal, line, dims));
+            if (not pixels.empty() and merged.voxels() > MAX_BRICK_VOXELS) {
+                break;
+            }
+            bounds = merged;
+            pos.insert(pos.end(), pixel.pos.val, pixel.pos.val + 3);
+            normals.insert(
+                normals.end(), pixel.normal.val, pixel.normal.val + 3);
+            pixels.emplace_back(
+                static_cast<int>(pixel.x), static_cast<int>(pixel.y));
+        }
+
+        // Copy the subvolume
+        tg::detail::Brick brick;
+        voxels.resize(bounds.voxels());
+        if (not voxels.empty()) {
+            std::array<std::size_t, 3> extent{
+                std::size_t(bounds.max[2] - bounds.min[2]),
+                std::size_t(bounds.max[1] - bounds.min[1]),
+                std::size_t(bounds.max[0] - bounds.min[0])};
+            vol.copyLattice(bounds.min, steps, extent, voxels.data());
+            for (int a = 0; a < 3; a++) {
+                brick.origin[a] = bounds.min[a];
+                brick.size[a] = bounds.max[a] - bounds.min[a];
+            }
+        }
+        brick.voxels = voxels.data();
+        for (int a = 0; a < 3; a++) {
+            brick.volume[a] = dims[a];
+        }
+
+        fn(brick, pos.data(), normals.data(), pixels);
+        if (progress) {
+            progress(i);
+        }
+    }
+}
+}  // namespace
+
+auto tg::Available() -> bool
+{
+    static const bool available = detail::DeviceAvailable();
+    return available;
+}
+
+void tg::CompositeLines(
+    const Volume& vol,
+    const PerPixelMap& ppm,
+    const LineParams& line,
+    LineReduction reduction,
+    double medianRange,
+    cv::Mat& image,
+    const Progress& progress)
+{
+    CheckLine(line);
+    CheckImage(ppm, image, CV_16UC1);
+
+    // Summed range of the median mean, as in CompositeTexture
+    detail::Reduction r;
+    r.method = static_cast<int>(reduction);
+    if (reduction == LineReduction::MedianAverage) {
+        if (AlmostEqual<double>(medianRange, 1.0)) {
+            r.method = static_cast<int>(LineReduction::Mean);
+        } else if (not AlmostEqual<double>(medianRange, 0.0)) {
+            auto n = line.count;
+            auto count = static_cast<std::size_t>(std::ceil(n * medianRange));
+            r.rangeCount = static_cast<int>(count);
+            r.rangeOffset = static_cast<int>(std::floor((n - count) / 2.0));
+        }
+    }
+
+    std::vector<uint16_t> out;
+    ForEachBatch(
+        vol, ppm, line, progress,
+        [&](const auto& brick, const auto* pos, const auto* normals,
+            const auto& pixels) {
+            out.resize(pixels.size());
+            detail::CompositeLines(
+                brick, pos, normals, pixels.size(), ToDetail(line), r,
+                out.data());
+            for (std::size_t i = 0; i < pixels.size(); i++) {
+                image.at<uint16_t>(pixels[i]) = out[i];
+            }
+        });
+}
+
+void tg::IntegrateLines(
+    const Volume& vol,
+    const PerPixelMap& ppm,
+    const LineParams& line,
+    const std::vector<double>& weights,
+    const std::vector<double>& lut,
+    cv::Mat& image,
+    const Progress& progress)
+{
+    CheckLine(line);
+    CheckImage(ppm, image, CV_32FC1);
+    if (weights.size() != line.count) {
+        throw std::invalid_argument("Need one weight per line sample");
+    }
+    if (lut.size() != INTENSITY_VALUES) {
+        throw std::invalid_argument("Need one LUT value per intensity");
+    }
+
+    std::vector<double> out;
+    ForEachBatch(
+        vol, ppm, line, progress,
+        [&](const auto& brick, const auto* pos, const auto* normals,
+            const auto& pixels) {
+            out.resize(pixels.size());
+            detail::IntegrateLines(
+                brick, pos, normals, pixels.size(), ToDetail(line),
+                weights.data(), lut.data(), out.data());
+            for (std::size_t i = 0; i < pixels.size(); i++) {
+                image.at<float>(pixels[i]) = static_cast<float>(out[i]);
+            }
+        });
+}
+#else
+namespace
+{
+constexpr auto NO_CUDA = "Built without CUDA support (VC_WITH_CUDA)";
+}  // namespace
+
+auto tg::Available() -> bool { return false; }
+
+void tg::CompositeLines(
+    const Volume& /*vol*/,
+    const PerPixelMap& /*ppm*/,
+    const LineParams& /*line*/,
+    LineReduction /*reduction*/,
+    double /*medianRange*/,
+    cv::Mat& /*image*/,
+    const Progress& /*progress*/)
+{
+    throw std::runtime_error(NO_CUDA);
+}
+
+void tg::IntegrateLines(
+    const Volume& /*vol*/,
+    const PerPixelMap& /*ppm*/,
+    const LineParams& /*line*/,
+    const std::vector<double>& /*weights*/,
+    const std::vector<double>& /*lut*/,
+    cv::Mat& /*image*/,
+    const Progress& /*progress*/)
+{
+    throw std::runtime_error(NO_CUDA);
+}
+#endif
@@ -0,0 +1,319 @@
+#include "GPULineSamplingKernels.hpp"
+
+#include <stdexcept>
+#include <string>
+
+#include <cuda_runtime.h>
+
+namespace detail = volcart::texturing::gpu::detail;
+
+namespace
+{
+// Must match gpu::MAX_LINE_SAMPLES
+constexpr int MAX_SAMPLES{256};
+// Threads per block
+constexpr int BLOCK_SIZE{128};
+// Number of possible intensity values
+constexpr std::size_t INTENSITY_VALUES{65536};
+
+// Reduction methods. Must match gpu::LineReduction.
+constexpr int MINIMUM{0};
+constexpr int MAXIMUM{1};
+constexpr int MEDIAN{2};
+constexpr int MEAN{3};
+constexpr int MEDIAN_AVERAGE{4};
+
+void Check(cudaError_t e, const char* what)
+{
+    if (e != cudaSuccess) {
+        throw std::runtime_error(
+            std::string(what) + ": " + cudaGetErrorString(e));
+    }
+}
+
+// Device allocation which is freed when it goes out of scope
+template <typename T>
+class DeviceBuffer
+{
+public:
+    explicit DeviceBuffer(std::size_t n) : size_{n}
+    {
+        if (n > 0) {
+            Check(cudaMalloc(&ptr_, n * sizeof(T)), "cudaMalloc");
+        }
+    }
+
+    DeviceBuffer(const T* host, std::size_t n) : DeviceBuffer(n)
+    {
+        if (n > 0) {
+            Check(
+                cudaMemcpy(ptr_, host, n * sizeof(T), cudaMemcpyHostToDevice),
+                "cudaMemcpy");
+        }
+    }
+
+    ~DeviceBuffer() { cudaFree(ptr_); }
+
+    DeviceBuffer(const DeviceBuffer&) = delete;
+    auto operator=(const DeviceBuffer&) -> DeviceBuffer& = delete;
+
+    [[nodiscard]] auto get() const -> T* { return ptr_; }
+
+    void copyTo(T* host) const
+    {
+        if (size_ > 0) {
+            Check(
+                cudaMemcpy(
+                    host, ptr_, size_ * sizeof(T), cudaMemcpyDeviceToHost),
+                "cudaMemcpy");
+        }
+    }
+
+private:
+    T* ptr_{nullptr};
+    std::size_t size_{0};
+};
+
+// Voxel of the brick. Voxels outside of the brick are 0.
+__device__ auto Voxel(const detail::Brick& b, int x, int y, int z) -> double
+{
+    x -= b.origin[0];
+    y -= b.origin[1];
+    z -= b.origin[2];
+    if (x < 0 or x >= b.size[0] or y < 0 or y >= b.size[1] or z < 0 or
+        z >= b.size[2]) {
+        return 0;
+    }
+    auto idx = (std::size_t(z) * b.size[1] + y) * b.size[0] + x;
+    return b.voxels[idx];
+}
+
+// Trilinear interpolation, in the same order of operations as
+// Volume::interpolateAt(). This file is compiled without FMA contraction so
+// that the results match.
+__device__ auto Interpolate(
+    const detail::Brick& b, double x, double y, double z) -> std::uint16_t
+{
+    if (not(x >= 0 and x < b.volume[0] and y >= 0 and y < b.volume[1] and
+            z >= 0 and z < b.volume[2])) {
+        return 0;
+    }
+
+    double intPart;
+    double dx = modf(x, &intPart);
+    auto x0 = static_cast<int>(intPart);
+    int x1 = x0 + 1;
+    double dy = modf(y, &intPart);
+    auto y0 = static_cast<int>(intPart);
+    int y1 = y0 + 1;
+    double dz = modf(z, &intPart);
+    auto z0 = static_cast<int>(intPart);
+    int z1 = z0 + 1;
+
+    auto c00 = Voxel(b, x0, y0, z0) * (1 - dx) + Voxel(b, x1, y0, z0) * dx;
+    auto c10 = Voxel(b, x0, y1, z0) * (1 - dx) + Voxel(b, x1, y1, z0) * dx;
+    auto c01 = Voxel(b, x0, y0, z1) * (1 - dx) + Voxel(b, x1, y0, z1) * dx;
+    auto c11 = Voxel(b, x0, y1, z1) * (1 - dx) + Voxel(b, x1, y1, z1) * dx;
+
+    auto c0 = c00 * (1 - dy) + c10 * dy;
+    auto c1 = c01 * (1 - dy) + c11 * dy;
+
+    auto c = c0 * (1 - dz) + c1 * dz;
+    return static_cast<std::uint16_t>(__double2int_rn(c));
+}
+
+// Sample the line of pixel i, stepping along it like LineGenerator
+__device__ void SampleLine(
+    const detail::Brick& b,
+    const double* pos,
+    const double* normals,
+    std::size_t i,
+    const detail::Line& line,
+    std::uint16_t* v)
+{
+    const double* n = normals + 3 * i;
+    double p[3];
+    double step[3];
+    for (int a = 0; a < 3; a++) {
+        p[a] = pos[3 * i + a] + n[a] * line.start;
+        step[a] = n[a] * line.interval;
+    }
+    for (int s = 0; s < line.count; s++) {
+        v[s] = Interpolate(b, p[0], p[1], p[2]);
+        for (int a = 0; a < 3; a++) {
+            p[a] += step[a];
+        }
+    }
+}
+
+__device__ void Sort(std::uint16_t* v, int n)
+{
+    for (int i = 1; i < n; i++) {
+        auto x = v[i];
+        int j = i - 1;
+        for (; j >= 0 and v[j] > x; j--) {
+            v[j + 1] = v[j];
+        }
+        v[j + 1] = x;
+    }
+}
+
+// Rounded mean, as in CompositeTexture
+__device__ auto Mean(const std::uint16_t* v, int n) -> std::uint16_t
+{
+    double sum{0};
+    for (int i = 0; i < n; i++) {
+        sum += v[i];
+    }
+    return static_cast<std::uint16_t>(round(sum / n));
+}
+
+__global__ void CompositeKernel(
+    detail::Brick b,
+    const double* pos,
+    const double* normals,
+    std::size_t n,
+    detail::Line line,
+    detail::Reduction r,
+    std::uint16_t* out)
+{
+    auto i = std::size_t(blockIdx.x) * blockDim.x + threadIdx.x;
+    if (i >= n) {
+        return;
+    }
+
+    std::uint16_t v[MAX_SAMPLES];
+    SampleLine(b, pos, normals, i, line, v);
+
+    std::uint16_t result{0};
+    switch (r.method) {
+        case MINIMUM:
+            result = v[0];
+            for (int s = 1; s < line.count; s++) {
+                if (v[s] < result) {
+                    result = v[s];
+                }
+            }
+            break;
+        case MAXIMUM:
+            result = v[0];
+            for (int s = 1; s < line.count; s++) {
+                if (v[s] > result) {
+                    result = v[s];
+                }
+            }
+            break;
+        case MEDIAN:
+            Sort(v, line.count);
+            result = v[line.count / 2];
+            break;
+        case MEAN:
+            result = Mean(v, line.count);
+            break;
+        case MEDIAN_AVERAGE:
+            if (r.rangeCount > 0) {
+                Sort(v, line.count);
+                result = Mean(v + r.rangeOffset, r.rangeCount);
+            }
+            break;
+        default:
+            break;
+    }
+    out[i] = result;
+}
+
+__global__ void IntegrateKernel(
+    detail::Brick b,
+    const double* pos,
+    const double* normals,
+    std::size_t n,
+    detail::Line line,
+    const double* weights,
+    const double* lut,
+    double* out)
+{
+    auto i = std::size_t(blockIdx.x) * blockDim.x + threadIdx.x;
+    if (i >= n) {
+        return;
+    }
+
+    std::uint16_t v[MAX_SAMPLES];
+    SampleLine(b, pos, normals, i, line, v);
+
+    double sum{0};
+    for (int s = 0; s < line.count; s++) {
+        sum += weights[s] * lut[v[s]];
+    }
+    out[i] = sum;
+}
+
+auto NumBlocks(std::size_t n) -> unsigned
+{
+    return static_cast<unsigned>((n + BLOCK_SIZE - 1) / BLOCK_SIZE);
+}
+
+auto BrickVoxels(const detail::Brick& b) -> std::size_t
+{
+    return std::size_t(b.size[0]) * b.size[1] * b.size[2];
+}
+}  // namespace
+
+auto detail::DeviceAvailable() -> bool
+{
+    int count{0};
+    return cudaGetDeviceCount(&count) == cudaSuccess and count > 0;
+}
+
+void detail::CompositeLines(
+    const Brick& brick,
+    const double* pos,
+    const double* normals,
+    std::size_t n,
+    const Line& line,
+    const Reduction& reduction,
+    std::uint16_t* out)
+{
+    if (n == 0) {
+        return;
+    }
+    DeviceBuffer<std::uint16_t> voxels(brick.voxels, BrickVoxels(brick));
+    DeviceBuffer<double> dPos(pos, 3 * n);
+    DeviceBuffer<double> dNormals(normals, 3 * n);
+    DeviceBuffer<std::uint16_t> dOut(n);
+
+    auto b = brick;
+    b.voxels = voxels.get();
+    CompositeKernel<<<NumBlocks(n), BLOCK_SIZE>>>(
+        b, dPos.get(), dNormals.get(), n, line, reduction, dOut.get());
+    Check(cudaGetLastError(), "Composite kernel");
+    dOut.copyTo(out);
+}
+
+void detail::IntegrateLines(
+    const Brick& brick,
+    const double* pos,
+    const double* normals,
+    std::size_t n,
+    const Line& line,
+    const double* weights,
+    const double* lut,
+    double* out)
+{
+    if (n == 0) {
+        return;
+    }
+    DeviceBuffer<std::uint16_t> voxels(brick.voxels, BrickVoxels(brick));
+    DeviceBuffer<double> dPos(pos, 3 * n);
+    DeviceBuffer<double> dNormals(normals, 3 * n);
+    DeviceBuffer<double> dWeights(weights, std::size_t(line.count));
+    DeviceBuffer<double> dLUT(lut, INTENSITY_VALUES);
+    DeviceBuffer<double> dOut(n);
+
+    auto b = brick;
+    b.voxels = voxels.get();
+    IntegrateKernel<<<NumBlocks(n), BLOCK_SIZE>>>(
+        b, dPos.get(), dNormals.get(), n, line, dWeights.get(), dLUT.get(),
+        dOut.get());
+    Check(cudaGetLastError(), "Integral kernel");
+    dOut.copyTo(out);
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+// Interface between the host-side batching in GPULineSampling.cpp and the
+// CUDA kernels in GPULineSampling.cu. Kept free of OpenCV and VC types so
+// that it can be compiled by nvcc.
+
+#include <cstddef>
+#include <cstdint>
+
+namespace volcart::texturing::gpu::detail
+{
+// Subvolume uploaded for a batch of pixels. Voxels are stored z-major, and
+// voxels outside of the brick are 0.
+struct Brick {
+    const std::uint16_t* voxels{nullptr};
+    int origin[3]{0, 0, 0};
+    int size[3]{0, 0, 0};
+    // Full volume dimensions, for the bounds test
+    int volume[3]{0, 0, 0};
+};
+
+// Line sampled at every pixel
+struct Line {
+    double start{0};
+    double interval{1};
+    int count{1};
+};
+
+// Reduction of a line. Matches gpu::LineReduction. The MedianAverage range
+// is given as the offset and size of the summed range of sorted samples.
+struct Reduction {
+    int method{0};
+    int rangeOffset{0};
+    int rangeCount{0};
+};
+
+// Whether a CUDA device is available
+auto DeviceAvailable() -> bool;
+
+// Sample and reduce n lines. pos and normals hold 3 doubles per line.
+void CompositeLines(
+    const Brick& brick,
+    const double* pos,
+    const double* normals,
+    std::size_t n,
+    const Line& line,
+    const Reduction& reduction,
+    std::uint16_t* out);
+
+// Sample n lines and sum weights[i] * lut[v[i]]
+void IntegrateLines(
+    const Brick& brick,
+    const double* pos,
+    const double* normals,
+    std::size_t n,
+    const Line& line,
+    const double* weights,
+    const double* lut,
+    double* out);
+}  // namespace volcart::texturing::gpu::detail
@@ -0,0 +1,406 @@
+#include "vc/texturing/HierarchicalFlattening.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+#include "vc/core/util/Logging.hpp"
+#include "vc/core/util/MeshMath.hpp"
+#include "vc/meshing/ACVD.hpp"
+#include "vc/meshing/DeepCopy.hpp"
+#include "vc/meshing/ScaleMesh.hpp"
+
+using namespace volcart;
+using namespace volcart::meshmath;
+using namespace volcart::meshing;
+using namespace volcart::texturing;
+
+namespace
+{
+// Number of nearby proxy vertices whose faces are searched for each vertex
+constexpr std::size_t NUM_NEAREST = 3;
+
+// Smallest edge weight used during relaxation. Keeps the weights of obtuse
+// triangles positive.
+constexpr double MIN_WEIGHT = 1e-6;
+
+// Faces as a list of vertex ids
+using Faces = std::vector<std::array<std::size_t, 3>>;
+
+// Compressed vertex adjacency list
+struct Adjacency {
+    std::vector<std::size_t> offsets;
+    std::vector<std::size_t> ids;
+    std::vector<double> weights;
+};
+
+// Weighted, undirected edge
+struct Edge {
+    std::size_t a;
+    std::size_t b;
+    double w;
+};
+
+auto GetPoint(const ITKMesh::Pointer& mesh, std::size_t id) -> cv::Vec3d
+{
+    auto p = mesh->GetPoint(id);
+    return {p[0], p[1], p[2]};
+}
+
+auto GetFaces(const ITKMesh::Pointer& mesh) -> Faces
+{
+    Faces faces;
+    faces.reserve(mesh->GetNumberOfCells());
+    for (auto cell = mesh->GetCells()->Begin(); cell != mesh->GetCells()->End();
+         ++cell) {
+        const auto& ids = cell.Value()->GetPointIdsContainer();
+        faces.push_back({ids[0], ids[1], ids[2]});
+    }
+    return faces;
+}
+
+// Closest point on the triangle abc to p, as barycentric coordinates.
+// From Ericson, Real-Time Collision Detection, Sec. 5.1.5.
+auto ClosestPointBarycentric(
+    const cv::Vec3d& p,
+    const cv::Vec3d& a,
+    const cv::Vec3d& b,
+    const cv::Vec3d& c) -> cv::Vec3d
+{
+    auto ab = b - a;
+    auto ac = c - a;
+    auto ap = p - a;
+    auto d1 = ab.dot(ap);
+    auto d2 = ac.dot(ap);
+    if (d1 <= 0 and d2 <= 0) {
+        return {1, 0, 0};
+    }
+
+    auto bp = p - b;
+    auto d3 = ab.dot(bp);
+    auto d4 = ac.dot(bp);
+    if (d3 >= 0 and d4 <= d3) {
+        return {0, 1, 0};
+    }
+
+    auto wc = d1 * d4 - d3 * d2;
+    if (wc <= 0 and d1 >= 0 and d3 <= 0) {
+        auto v = d1 / (d1 - d3);
+        return {1 - v, v, 0};
+    }
+
+    auto cp = p - c;
+    auto d5 = ab.dot(cp);
+    auto d6 = ac.dot(cp);
+    if (d6 >= 0 and d5 <= d6) {
+        return {0, 0, 1};
+    }
+
+    auto wb = d5 * d2 - d1 * d6;
+    if (wb <= 0 and d2 >= 0 and d6 <= 0) {
+        auto w = d2 / (d2 - d6);
+        return {1 - w, 0, w};
+    }
+
+    auto wa = d3 * d6 - d5 * d4;
+    if (wa <= 0 and (d4 - d3) >= 0 and (d5 - d6) >= 0) {
+        auto w = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+        return {0, 1 - w, w};
+    }
+
+    auto denom = wa + wb + wc;
+    if (denom <= 0) {
+        // Degenerate triangle
+        return {1, 0, 0};
+    }
+    auto v = wb / denom;
+    auto w = wc / denom;
+    return {1 - v - w, v, w};
+}
+
+// Faces incident to each vertex
+auto VertexFaces(const Faces& faces, std::size_t numVerts) -> Adjacency
+{
+    Adjacency adj;
+    adj.offsets.assign(numVerts + 1, 0);
+    for (const auto& f : faces) {
+        for (auto v : f) {
+            adj.offsets[v + 1]++;
+        }
+    }
+    for (std::size_t i = 0; i < numVerts; i++) {
+        adj.offsets[i + 1] += adj.offsets[i];
+    }
+    adj.ids.resize(adj.offsets.back());
+    auto next = adj.offsets;
+    for (std::size_t i = 0; i < faces.size(); i++) {
+        for (auto v : faces[i]) {
+            adj.ids[next[v]++] = i;
+        }
+    }
+    return adj;
+}
+
+// Cotangent of the angle at a in the triangle abc
+auto Cotangent(const cv::Vec3d& a, const cv::Vec3d& b, const cv::Vec3d& c)
+    -> double
+{
+    auto ab = b - a;
+    auto ac = c - a;
+    auto sin = cv::norm(ab.cross(ac));
+    if (sin <= 0) {
+        return 0;
+    }
+    return ab.dot(ac) / sin;
+}
+
+// Cotangent-weighted vertex neighbors. Vertices on a boundary edge are
+// flagged in boundary.
+auto CotanAdjacency(
+    const ITKMesh::Pointer& mesh,
+    const Faces& faces,
+    std::vector<bool>& boundary) -> Adjacency
+{
+    auto numVerts = mesh->GetNumberOfPoints();
+
+    // Half of the cotangent of the opposite corner for every face edge
+    std::vector<Edge> edges;
+    edges.reserve(3 * faces.size());
+    for (const auto& f : faces) {
+        std::array<cv::Vec3d, 3> p{
+            GetPoint(mesh, f[0]), GetPoint(mesh, f[1]), GetPoint(mesh, f[2])};
+        for (std::size_t i = 0; i < 3; i++) {
+            auto a = f[(i + 1) % 3];
+            auto b = f[(i + 2) % 3];
+            auto w = 0.5 * Cotangent(p[i], p[(i + 1) % 3], p[(i + 2) % 3]);
+            edges.push_back({std::min(a, b), std::max(a, b), w});
+        }
+    }
+    std::sort(edges.begin(), edges.end(), [](const auto& l, const auto& r) {
+        return l.a < r.a or (l.a == r.a and l.b < r.b);
+    });
+
+    // Merge the duplicate edges of adjacent faces. An edge which belongs to
+    // only one face is on the boundary.
+    boundary.assign(numVerts, false);
+    std::vector<Edge> merged;
+    merged.reserve(edges.size() / 2 + 1);
+    for (std::size_t i = 0; i < edges.size();) {
+        auto e = edges[i];
+        auto j = i + 1;
+        for (; j < edges.size() and edges[j].a == e.a and edges[j].b == e.b;
+             j++) {
+            e.w += edges[j].w;
+        }
+        if (j - i == 1) {
+            boundary[e.a] = true;
+            boundary[e.b] = true;
+        }
+        e.w = std::max(e.w, MIN_WEIGHT);
+        merged.push_back(e);
+        i = j;
+    }
+
+    // Build the symmetric adjacency list
+    Adjacency adj;
+    adj.offsets.assign(numVerts + 1, 0);
+    for (const auto& e : merged) {
+        adj.offsets[e.a + 1]++;
+        adj.offsets[e.b + 1]++;
+    }
+    for (std::size_t i = 0; i < numVerts; i++) {
+        adj.offsets[i + 1] += adj.offsets[i];
+    }
+    adj.ids.resize(adj.offsets.back());
+    adj.weights.resize(adj.offsets.back());
+    auto next = adj.offsets;
+    for (const auto& e : merged) {
+        adj.ids[next[e.a]] = e.b;
+        adj.weights[next[e.a]++] = e.w;
+        adj.ids[next[e.b]] = e.a;
+        adj.weights[next[e.b]++] = e.w;
+    }
+    return adj;
+}
+}  // namespace
+
+HierarchicalFlattening::HierarchicalFlattening(const ITKMesh::Pointer& m)
+    : FlatteningAlgorithm(m)
+{
+}
+
+void HierarchicalFlattening::setProxyVertices(std::size_t n)
+{
+    proxyVerts_ = n;
+}
+
+auto HierarchicalFlattening::proxyVertices() const -> std::size_t
+{
+    return proxyVerts_;
+}
+
+void HierarchicalFlattening::setRelaxationIterations(std::size_t n)
+{
+    relaxIters_ = n;
+}
+
+auto HierarchicalFlattening::relaxationIterations() const -> std::size_t
+{
+    return relaxIters_;
+}
+
+void HierarchicalFlattening::setUseABF(bool a) { useABF_ = a; }
+
+auto HierarchicalFlattening::useABF() const -> bool { return useABF_; }
+
+void HierarchicalFlattening::setABFMaxIterations(std::size_t i)
+{
+    maxABFIterations_ = i;
+}
+
+auto HierarchicalFlattening::abfMaxIterations() const -> std::size_t
+{
+    return maxABFIterations_;
+}
+
+void HierarchicalFlattening::setSolver(AngleBasedFlattening::Solver s)
+{
+    solver_ = s;
+}
+
+auto HierarchicalFlattening::solver() const -> AngleBasedFlattening::Solver
+{
+    return solver_;
+}
+
+auto HierarchicalFlattening::getProxyMesh() const -> ITKMesh::Pointer
+{
+    return proxy_;
+}
+
+auto HierarchicalFlattening::compute() -> ITKMesh::Pointer
+{
+    AngleBasedFlattening abf;
+    abf.setUseABF(useABF_);
+    abf.setABFMaxIterations(maxABFIterations_);
+    abf.setSolver(solver_);
+
+    // Small meshes are flattened directly
+    auto numVerts = mesh_->GetNumberOfPoints();
+    if (proxyVerts_ == 0 or numVerts <= proxyVerts_) {
+        Logger()->debug("Mesh is smaller than proxy. Flattening directly.");
+        proxy_ = mesh_;
+        abf.setMesh(mesh_);
+        output_ = abf.compute();
+        return output_;
+    }
+
+    // Resample and flatten the proxy
+    Logger()->info(
+        "Resampling proxy mesh ({} -> {} vertices)", numVerts, proxyVerts_);
+    ACVD resampler;
+    resampler.setInputMesh(mesh_);
+    resampler.setNumberOfClusters(proxyVerts_);
+    proxy_ = resampler.compute();
+
+    Logger()->info("Flattening proxy mesh");
+    abf.setMesh(proxy_);
+    auto proxyFlat = abf.compute();
+
+    // Interpolate the UVs of the full mesh from the closest proxy face
+    Logger()->info("Interpolating full-resolution UVs");
+    auto proxyFaces = GetFaces(proxy_);
+    auto proxyAdj = VertexFaces(proxyFaces, proxy_->GetNumberOfPoints());
+    auto locator = ITKPointsLocator::New();
+    locator->SetPoints(proxy_->GetPoints());
+    locator->Initialize();
+    ITKPointsLocator::NeighborsIdentifierType neighbors;
+
+    std::vector<cv::Vec2d> uvs(numVerts);
+    for (std::size_t id = 0; id < numVerts; id++) {
+        auto itkPt = mesh_->GetPoint(id);
+        cv::Vec3d p{itkPt[0], itkPt[1], itkPt[2]};
+        neighbors.clear();
+        locator->FindClosestNPoints(itkPt, NUM_NEAREST, neighbors);
+
+        auto minDist = std::numeric_limits<double>::max();
+        for (auto n : neighbors) {
+            for (auto i = proxyAdj.offsets[n]; i < proxyAdj.offsets[n + 1];
+                 i++) {
+                const auto& f = proxyFaces[proxyAdj.ids[i]];
+                auto bary = ClosestPointBarycentric(
+                    p, GetPoint(proxy_, f[0]), GetPoint(proxy_, f[1]),
+                    GetPoint(proxy_, f[2]));
+                auto closest = bary[0] * GetPoint(proxy_, f[0]) +
+                               bary[1] * GetPoint(proxy_, f[1]) +
+                               bary[2] * GetPoint(proxy_, f[2]);
+                auto dist = cv::norm(p - closest);
+                if (dist >= minDist) {
+                    continue;
+                }
+                minDist = dist;
+                cv::Vec2d uv{0, 0};
+                for (std::size_t v = 0; v < 3; v++) {
+                    auto flat = proxyFlat->GetPoint(f[v]);
+                    uv += bary[v] * cv::Vec2d{flat[0], flat[2]};
+                }
+                uvs[id] = uv;
+            }
+        }
+
+        // None of the nearby proxy vertices belong to a face
+        if (minDist == std::numeric_limits<double>::max() and
+            not neighbors.empty()) {
+            auto flat = proxyFlat->GetPoint(neighbors.front());
+            uvs[id] = {flat[0], flat[2]};
+        }
+    }
+
+    // Relax the interior vertices
+    if (relaxIters_ > 0) {
+        Logger()->info("Relaxing full-resolution UVs");
+        std::vector<bool> boundary;
+        auto adj = CotanAdjacency(mesh_, GetFaces(mesh_), boundary);
+        for (std::size_t iter = 0; iter < relaxIters_; iter++) {
+            for (std::size_t id = 0; id < numVerts; id++) {
+                if (boundary[id]) {
+                    continue;
+                }
+                cv::Vec2d sum{0, 0};
+                double wSum{0};
+                for (auto i = adj.offsets[id]; i < adj.offsets[id + 1]; i++) {
+                    sum += adj.weights[i] * uvs[adj.ids[i]];
+                    wSum += adj.weights[i];
+                }
+                if (wSum > 0) {
+                    uvs[id] = sum / wSum;
+                }
+            }
+        }
+    }
+
+    // Fill output
+    auto flatMesh = ITKMesh::New();
+    DeepCopy(mesh_, flatMesh);
+    ITKPoint pt;
+    cv::Vec3d norm{0.0, 1.0, 0.0};
+    for (std::size_t id = 0; id < numVerts; id++) {
+        pt[0] = uvs[id][0];
+        pt[1] = 0.0;
+        pt[2] = uvs[id][1];
+        flatMesh->SetPoint(id, pt);
+        flatMesh->SetPointData(id, norm.val);
+    }
+
+    // Scale mesh surface area to same as original
+    auto scale = std::sqrt(SurfaceArea(mesh_) / SurfaceArea(flatMesh));
+    Logger()->debug("Scaling output mesh by scale factor {:.5g}", scale);
+    ScaleMeshInPlace(flatMesh, scale);
+    output_ = flatMesh;
+
+    return output_;
+}
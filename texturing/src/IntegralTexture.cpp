@@ -1,16 +1,74 @@
 #include "vc/texturing/IntegralTexture.hpp"
 
 #include <algorithm>
-#include <map>
-#include <set>
+#include <array>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <numeric>
 
 #include <opencv2/core.hpp>
 
+#include "vc/core/util/ThreadPool.hpp"
+#include "vc/texturing/GPULineSampling.hpp"
+
 using namespace volcart;
 using namespace volcart::texturing;
 
 using Texture = IntegralTexture::Texture;
 
+namespace
+{
+// Number of possible intensity values
+constexpr std::size_t INTENSITY_VALUES{
+    std::numeric_limits<uint16_t>::max() + std::size_t{1}};
+// Clamp value which doesn't clamp
+constexpr uint16_t MAX_INTENSITY{std::numeric_limits<uint16_t>::max()};
+
+// The kernels below are kept as plain loops over contiguous memory so that
+// the compiler can vectorize them.
+
+// Sum of min(v[i], max). Integer sums are exact and reassociate freely.
+auto ClampedSum(const uint16_t* v, std::size_t n, uint16_t max) -> double
+{
+    uint64_t sum{0};
+    for (std::size_t i = 0; i < n; i++) {
+        sum += std::min(v[i], max);
+    }
+    return static_cast<double>(sum);
+}
+
+// Dot product of w and min(v, max). Floating-point sums can't be
+// reassociated by the compiler, so use independent partial sums instead.
+auto WeightedSum(
+    const uint16_t* v, const double* w, std::size_t n, uint16_t max) -> double
+{
+    constexpr std::size_t LANES{4};
+    std::array<double, LANES> sums{};
+    std::size_t i = 0;
+    for (; i + LANES <= n; i += LANES) {
+        for (std::size_t l = 0; l < LANES; l++) {
+            sums[l] += w[i + l] * std::min(v[i + l], max);
+        }
+    }
+    for (; i < n; i++) {
+        sums[0] += w[i] * std::min(v[i], max);
+    }
+    return (sums[0] + sums[1]) + (sums[2] + sums[3]);
+}
+
+// Sum of lut[v[i]]
+auto LookupSum(const uint16_t* v, std::size_t n, const double* lut) -> double
+{
+    double sum{0};
+    for (std::size_t i = 0; i < n; i++) {
+        sum += lut[v[i]];
+    }
+    return sum;
+}
+}  // namespace
+
 auto IntegralTexture::compute() -> Texture
 {
     // Setup
@@ -24,52 +82,30 @@ auto IntegralTexture::compute() -> Texture
 
     // Output image
     cv::Mat image = cv::Mat::zeros(height, width, CV_32FC1);
+    result_.push_back(image);
 
-    // Get the mappings
-    auto mappings = ppm_->getMappings();
-
-    // Sort the mappings by Z-value
-    std::sort(
-        mappings.begin(), mappings.end(), [](const auto& lhs, const auto& rhs) {
-            return lhs.pos[2] < rhs.pos[2];
-        });
-
-    // Iterate through the mappings
-    size_t counter = 0;
+    // Sample on the GPU if requested and supported
+    gpu::LineParams gpuLine;
     progressStarted();
-    for (const auto& pixel : mappings) {
-        progressUpdated(counter++);
-
-        // Generate the neighborhood
-        auto n = gen_->compute(vol_, pixel.pos, {pixel.normal});
-
-        // Clamp values
-        if (clampToMax_) {
-            std::replace_if(
-                n.begin(), n.end(),
-                [this](uint16_t v) { return v > clampMax_; }, clampMax_);
-        }
-
-        // Convert to double and weight the neighborhood
-        NDArray<double> neighborhoodD(
-            n.dims(), n.extents(), n.begin(), n.end());
-        auto weighted = apply_weights_(neighborhoodD);
-
-        // Sum the neighborhood
-        auto value = std::accumulate(weighted.begin(), weighted.end(), 0.0);
-
-        // Assign the intensity value at the UV position
-        auto x = static_cast<int>(pixel.x);
-        auto y = static_cast<int>(pixel.y);
-        image.at<float>(y, x) = static_cast<float>(value);
+    if (use_gpu_() and gpu::GetLineParams(*gen_, gpuLine)) {
+        gpu::IntegrateLines(
+            *vol_, *ppm_, gpuLine, gpu_weights_(gpuLine.count), gpu_lut_(),
+            image, [this](std::size_t n) { progressUpdated(n); });
+    } else {
+        // Integrate the neighborhood of every mapping
+        const auto size = gen_->size();
+        for_each_neighborhood_(
+            *gen_, [&](int x, int y, const uint16_t* samples) {
+                auto value = integrate_(samples, size);
+                image.at<float>(y, x) = static_cast<float>(value);
+            });
     }
     progressComplete();
 
+    // Normalized in place, so result_ still shares the image
     cv::normalize(image, image, 0.0, 1.0, cv::NORM_MINMAX);
 
-    // Set output
-    result_.push_back(image);
-
+    track_result_();
     return result_;
 }
 
@@ -86,16 +122,45 @@ void IntegralTexture::setup_weights_()
     }
 }
 
-auto IntegralTexture::apply_weights_(NDArray<double>& n) -> NDArray<double>
+auto IntegralTexture::integrate_(const uint16_t* n, std::size_t size) const
+    -> double
 {
+    const auto max = clampToMax_ ? clampMax_ : MAX_INTENSITY;
     switch (weight_) {
         case WeightMethod::None:
-            return n;
+            return ClampedSum(n, size, max);
         case WeightMethod::Linear:
-            return apply_linear_weights_(n);
+            if (size != linearWeights_.size()) {
+                throw std::runtime_error(
+                    "Neighborhood size does not match the linear weights");
+            }
+            return WeightedSum(n, linearWeights_.data(), size, max);
         case WeightMethod::ExpoDiff:
-            return apply_expodiff_weights_(n);
+            return LookupSum(n, size, expoDiffValues_.data());
+    }
+    return 0;
+}
+
+auto IntegralTexture::gpu_weights_(std::size_t size) const
+    -> std::vector<double>
+{
+    if (weight_ == WeightMethod::Linear) {
+        return linearWeights_;
     }
+    return std::vector<double>(size, 1.0);
+}
+
+auto IntegralTexture::gpu_lut_() const -> std::vector<double>
+{
+    if (weight_ == WeightMethod::ExpoDiff) {
+        return expoDiffValues_;
+    }
+    std::vector<double> lut(INTENSITY_VALUES);
+    const auto max = clampToMax_ ? clampMax_ : MAX_INTENSITY;
+    for (std::size_t i = 0; i < INTENSITY_VALUES; i++) {
+        lut[i] = std::min(static_cast<uint16_t>(i), max);
+    }
+    return lut;
 }
 
 ///// Linear weighting /////
@@ -103,7 +168,10 @@ void IntegralTexture::setup_linear_weights_()
 {
     // Neighborhood size
     auto extents = gen_->extents();
-    linearWeights_ = NDArray<double>(gen_->dim(), extents);
+    auto size = std::accumulate(
+        extents.begin(), extents.end(), std::size_t{1},
+        std::multiplies<std::size_t>());
+    linearWeights_.resize(size);
 
     // Linear Weighted Sum Setup
     double weight;
@@ -128,98 +196,80 @@ void IntegralTexture::setup_linear_weights_()
     }
 }
 
-auto IntegralTexture::apply_linear_weights_(NDArray<double>& n)
-    -> NDArray<double>
-{
-    std::vector<double> weighted;
-    cv::multiply(n.as_vector(), linearWeights_.as_vector(), weighted);
-    return NDArray<double>(
-        n.dims(), n.extents(), weighted.begin(), weighted.end());
-}
-
 ///// Exponential Difference weighting /////
 void IntegralTexture::setup_expodiff_weights_()
 {
     switch (expoDiffBaseMethod_) {
         case ExpoDiffBaseMethod::Manual:
             expoDiffBase_ = expoDiffManualBase_;
-            return;
+            break;
         case ExpoDiffBaseMethod::Mean:
-            expoDiffBase_ = expodiff_mean_base_();
-            return;
+            expoDiffBase_ = expodiff_mean_base_(expodiff_histogram_());
+            break;
         case ExpoDiffBaseMethod::Mode:
-            expoDiffBase_ = expodiff_mode_base_();
-            return;
+            expoDiffBase_ = expodiff_mode_base_(expodiff_histogram_());
+            break;
     }
-}
 
-auto IntegralTexture::expodiff_intersection_pts_() -> std::vector<uint16_t>
-{
-    // Get all of the intensity values
-    std::vector<uint16_t> values;
-    for (const auto& m : ppm_->getMappings()) {
-        values.emplace_back(vol_->interpolateAt(m.pos));
+    // The weighted value only depends on the intensity, so precompute it for
+    // every intensity
+    expoDiffValues_.resize(INTENSITY_VALUES);
+    const auto max = clampToMax_ ? clampMax_ : MAX_INTENSITY;
+    for (std::size_t i = 0; i < INTENSITY_VALUES; i++) {
+        auto val = static_cast<double>(std::min(static_cast<uint16_t>(i), max));
+        if (suppressBelowBase_ && expoDiffBase_ >= val) {
+            expoDiffValues_[i] = 0;
+            continue;
+        }
+        double diff = std::abs(val - expoDiffBase_);
+        expoDiffValues_[i] = std::pow(diff, expoDiffExponent_);
     }
-
-    return values;
 }
 
-auto IntegralTexture::expodiff_mean_base_() -> double
+auto IntegralTexture::expodiff_histogram_() -> std::vector<uint64_t>
 {
-    // Get intersection points
-    auto values = expodiff_intersection_pts_();
-
-    // Calculate the mean
-    size_t n = 0;
-    double mean = 0.0;
-    for (const auto& v : values) {
-        double delta = v - mean;
-        mean += delta / static_cast<double>(++n);
-    }
+    // Sample the intensity at every mapped pixel, accumulating a histogram
+    // per chunk of pixels
+    const auto& ppm = *ppm_;
+    auto mappings = mapping_indices_();
+    std::vector<uint64_t> histogram(INTENSITY_VALUES, 0);
+    std::mutex mutex;
+    ParallelChunks(mappings.size(), numThreads(), [&](auto begin, auto end) {
+        std::vector<uint64_t> local(INTENSITY_VALUES, 0);
+        for (auto i = begin; i < end; i++) {
+            local[vol_->interpolateAt(ppm.getAsPixelMap(mappings[i]).pos)]++;
+        }
+        const std::lock_guard<std::mutex> lock(mutex);
+        for (std::size_t v = 0; v < INTENSITY_VALUES; v++) {
+            histogram[v] += local[v];
+        }
+    });
 
-    return mean;
+    return histogram;
 }
 
-auto IntegralTexture::expodiff_mode_base_() -> double
+auto IntegralTexture::expodiff_mean_base_(const std::vector<uint64_t>& hist)
+    -> double
 {
-    // Get intersection points
-    auto values = expodiff_intersection_pts_();
-
-    // Generate a histogram
-    std::map<uint16_t, int> histogram;
-    for (const auto& v : values) {
-        try {
-            histogram.at(v) += 1;
-        } catch (const std::out_of_range&) {
-            histogram[v] = 1;
-        }
+    // Integer sums are exact
+    uint64_t n{0};
+    uint64_t sum{0};
+    for (std::size_t v = 0; v < hist.size(); v++) {
+        n += hist[v];
+        sum += v * hist[v];
     }
-
-    // Sort by frequency high to low
-    using KVPair = std::pair<uint16_t, int>;
-    using Comparator = std::function<bool(KVPair, KVPair)>;
-    Comparator compare = [](KVPair a, KVPair b) { return a.second > b.second; };
-    std::set<KVPair, Comparator> sorter(
-        histogram.begin(), histogram.end(), compare);
-
-    // Return the top candidate
-    return sorter.begin()->first;
+    if (n == 0) {
+        return 0;
+    }
+    return static_cast<double>(sum) / static_cast<double>(n);
 }
 
-auto IntegralTexture::apply_expodiff_weights_(NDArray<double>& n) const
-    -> NDArray<double>
+auto IntegralTexture::expodiff_mode_base_(const std::vector<uint64_t>& hist)
+    -> double
 {
-    std::vector<double> vals;
-    for (const auto& val : n) {
-        if (suppressBelowBase_ && expoDiffBase_ >= val) {
-            vals.emplace_back(0);
-            continue;
-        }
-        double diff = std::abs(val - expoDiffBase_);
-        vals.emplace_back(std::pow(diff, expoDiffExponent_));
-    }
-
-    return NDArray<double>(n.dims(), n.extents(), vals.begin(), vals.end());
+    // Most frequent value. Ties go to the lowest value.
+    auto mode = std::max_element(hist.begin(), hist.end());
+    return static_cast<double>(std::distance(hist.begin(), mode));
 }
 
 auto IntegralTexture::New() -> IntegralTexture::Pointer
@@ -1,6 +1,6 @@
 #include "vc/texturing/IntersectionTexture.hpp"
 
-#include <algorithm>
+#include <vector>
 
 using namespace volcart;
 using namespace volcart::texturing;
@@ -17,30 +17,35 @@ Texture IntersectionTexture::compute()
     // Output image
     cv::Mat image = cv::Mat::zeros(height, width, CV_16UC1);
 
-    // Get the mappings
-    auto mappings = ppm_->getMappings();
+    // Get the mappings in traversal order
+    const auto& ppm = *ppm_;
+    auto mappings = mapping_indices_();
 
-    // Sort the mappings by Z-value
-    std::sort(
-        mappings.begin(), mappings.end(), [](const auto& lhs, const auto& rhs) {
-            return lhs.pos[2] < rhs.pos[2];
-        });
-
-    // Iterate through the mappings
-    size_t counter{0};
+    // Sample each slab of mappings in one batch. Every mapping is a
+    // different pixel, so the slabs write to disjoint parts of the image.
     progressStarted();
-    for (const auto& pixel : mappings) {
-        progressUpdated(counter++);
-
-        // Assign the intensity value at the XY position
-        image.at<uint16_t>(
-            static_cast<int>(pixel.y), static_cast<int>(pixel.x)) =
-            vol_->interpolateAt(pixel.pos);
-    }
+    parallel_for_slabs_(mappings, [&](size_t begin, size_t end) {
+        thread_local std::vector<cv::Vec3d> pts;
+        thread_local std::vector<uint16_t> values;
+        pts.resize(end - begin);
+        values.resize(end - begin);
+        for (auto i = begin; i < end; i++) {
+            pts[i - begin] = ppm.getAsPixelMap(mappings[i]).pos;
+        }
+        vol_->interpolateAt(pts.data(), pts.size(), values.data());
+
+        // Assign the intensity values at the XY positions
+        for (auto i = begin; i < end; i++) {
+            auto y = static_cast<int>(mappings[i] / ppm.width());
+            auto x = static_cast<int>(mappings[i] % ppm.width());
+            image.at<uint16_t>(y, x) = values[i - begin];
+        }
+    });
     progressComplete();
 
     // Set output
     result_.push_back(image);
 
+    track_result_();
     return result_;
-}
\ No newline at end of file
+}
@@ -1,7 +1,12 @@
 #include "vc/texturing/LayerTexture.hpp"
 
+#include <algorithm>
+#include <vector>
+
 #include <opencv2/core.hpp>
 
+#include "vc/core/io/ZarrWriter.hpp"
+
 using namespace volcart;
 using namespace volcart::texturing;
 
@@ -11,35 +16,165 @@ Texture LayerTexture::compute()
 {
     // Setup
     result_.clear();
+    if (arrayPath_) {
+        compute_chunked_();
+        track_result_();
+        return result_;
+    }
     auto height = static_cast<int>(ppm_->height());
     auto width = static_cast<int>(ppm_->width());
+    const auto numLayers = gen_->extents()[0];
+    const auto bandSize = band_size_();
 
-    // Setup output images
-    for (size_t i = 0; i < gen_->extents()[0]; i++) {
-        result_.emplace_back(cv::Mat::zeros(height, width, CV_16UC1));
-    }
+    // Get the mappings in traversal order
+    const auto& ppm = *ppm_;
+    auto mappings = mapping_indices_();
+
+    // Compute the layers one band at a time
+    progressStarted();
+    for (size_t first = 0; first < numLayers; first += bandSize) {
+        const auto count = std::min(bandSize, numLayers - first);
+
+        // Setup output images
+        Texture band;
+        for (size_t i = 0; i < count; i++) {
+            band.emplace_back(cv::Mat::zeros(height, width, CV_16UC1));
+        }
+
+        // Iterate through the mappings
+        auto progressOffset = (first / bandSize) * mappings.size();
+        parallel_for_(
+            mappings,
+            [&](size_t i) {
+                auto pixel = ppm.getAsPixelMap(mappings[i]);
 
-    // Get the mappings
-    auto mappings = ppm_->getMappings();
-
-    // Sort the mappings by Z-value
-    std::sort(
-        mappings.begin(), mappings.end(), [](const auto& lhs, const auto& rhs) {
-            return lhs.pos[2] < rhs.pos[2];
-        });
-
-    // Iterate through the mappings
-    for (const auto& pixel : mappings) {
-        // Generate the neighborhood
-        auto neighborhood = gen_->compute(vol_, pixel.pos, {pixel.normal});
-
-        // Assign to the output images
-        size_t it = 0;
-        for (const auto& v : neighborhood) {
-            result_.at(it++).at<uint16_t>(
-                static_cast<int>(pixel.y), static_cast<int>(pixel.x)) = v;
+                // Generate the band's part of the neighborhood
+                thread_local std::vector<uint16_t> neighborhood;
+                neighborhood.resize(count);
+                gen_->computeRangeInto(
+                    vol_, pixel.pos, pixel.normal, first, count,
+                    neighborhood.data());
+
+                // Assign to the output images
+                size_t it = 0;
+                for (const auto& v : neighborhood) {
+                    band[it++].at<uint16_t>(
+                        static_cast<int>(pixel.y), static_cast<int>(pixel.x)) =
+                        v;
+                }
+            },
+            progressOffset);
+
+        // Hand off the completed layers, or keep them
+        if (writer_) {
+            for (size_t i = 0; i < count; i++) {
+                writer_(first + i, band[i]);
+            }
+        } else {
+            result_ = std::move(band);
         }
     }
+    progressComplete();
 
+    track_result_();
     return result_;
-}
\ No newline at end of file
+}
+
+void LayerTexture::compute_chunked_()
+{
+    const auto numLayers = gen_->extents()[0];
+    const auto width = static_cast<int>(ppm_->width());
+    const auto height = static_cast<int>(ppm_->height());
+    const auto chunks = chunk_shape_();
+    io::ZarrWriter writer(
+        *arrayPath_, {width, height, static_cast<int>(numLayers)}, chunks);
+    const auto grid = writer.chunkGridSize();
+
+    // Compute and write the column of chunks under each tile of the PPM
+    const auto& ppm = *ppm_;
+    progressStarted();
+    parallel_for_(static_cast<size_t>(grid[0]) * grid[1], [&](size_t t) {
+        const auto cx = static_cast<int>(t % grid[0]);
+        const auto cy = static_cast<int>(t / grid[0]);
+        const auto x0 = cx * chunks[0];
+        const auto y0 = cy * chunks[1];
+        const auto x1 = std::min(x0 + chunks[0], width);
+        const auto y1 = std::min(y0 + chunks[1], height);
+
+        thread_local std::vector<cv::Mat> column;
+        thread_local std::vector<uint16_t> neighborhood;
+        column.resize(grid[2]);
+        for (auto& chunk : column) {
+            chunk.create(chunks[1] * chunks[2], chunks[0], CV_16UC1);
+            chunk.setTo(0);
+        }
+        neighborhood.resize(numLayers);
+
+        bool mapped{false};
+        for (auto y = y0; y < y1; y++) {
+            for (auto x = x0; x < x1; x++) {
+                if (not ppm.hasMapping(y, x)) {
+                    continue;
+                }
+                mapped = true;
+                auto pixel = ppm.getAsPixelMap(y, x);
+                gen_->computeRangeInto(
+                    vol_, pixel.pos, pixel.normal, 0, numLayers,
+                    neighborhood.data());
+
+                // Z-planes are stacked vertically in each chunk
+                for (size_t z = 0; z < numLayers; z++) {
+                    const auto lz = static_cast<int>(z) % chunks[2];
+                    column[z / chunks[2]].at<uint16_t>(
+                        lz * chunks[1] + y - y0, x - x0) = neighborhood[z];
+                }
+            }
+        }
+
+        // Unwritten chunks are read as zeros
+        if (not mapped) {
+            return;
+        }
+        for (int cz = 0; cz < grid[2]; cz++) {
+            writer.writeChunk(cx, cy, cz, column[cz]);
+        }
+    });
+    progressComplete();
+}
+
+size_t LayerTexture::progressIterations() const
+{
+    if (arrayPath_) {
+        const auto chunks = chunk_shape_();
+        const auto cols = (ppm_->width() + chunks[0] - 1) / chunks[0];
+        const auto rows = (ppm_->height() + chunks[1] - 1) / chunks[1];
+        return cols * rows;
+    }
+    const auto numLayers = gen_->extents()[0];
+    const auto bandSize = band_size_();
+    const auto numBands = (numLayers + bandSize - 1) / bandSize;
+    return ppm_->numMappings() * numBands;
+}
+
+size_t LayerTexture::band_size_() const
+{
+    const auto numLayers = gen_->extents()[0];
+    if (writer_ and bandSize_ > 0) {
+        return std::min(bandSize_, numLayers);
+    }
+    return numLayers;
+}
+
+cv::Vec3i LayerTexture::chunk_shape_() const
+{
+    const cv::Vec3i shape{
+        static_cast<int>(ppm_->width()), static_cast<int>(ppm_->height()),
+        static_cast<int>(gen_->extents()[0])};
+    auto chunks = arrayChunks_;
+    for (int i = 0; i < 3; i++) {
+        if (chunks[i] <= 0) {
+            chunks[i] = shape[i];
+        }
+    }
+    return chunks;
+}
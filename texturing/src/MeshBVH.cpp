@@ -0,0 +1,683 @@
+#include "vc/texturing/MeshBVH.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <limits>
+#include <mutex>
+#include <string>
+
+#include <bvh/bvh.hpp>
+#include <bvh/primitive_intersectors.hpp>
+#include <bvh/ray.hpp>
+#include <bvh/single_ray_traverser.hpp>
+#include <bvh/triangle.hpp>
+#include <bvh/vector.hpp>
+
+#include "vc/core/types/Exceptions.hpp"
+#include "vc/core/util/ThreadPool.hpp"
+
+using namespace volcart;
+using namespace volcart::texturing;
+
+namespace fs = volcart::filesystem;
+
+using Scalar = double;
+using Vector3 = bvh::Vector3<Scalar>;
+using BVHTriangle = bvh::Triangle<Scalar>;
+using Ray = bvh::Ray<Scalar>;
+using Bvh = bvh::Bvh<Scalar>;
+using Node = Bvh::Node;
+using NodeIndex = decltype(Node::first_child_or_primitive);
+using Intersector = bvh::ClosestPrimitiveIntersector<Bvh, BVHTriangle>;
+using Traverser = bvh::SingleRayTraverser<Bvh>;
+
+struct MeshBVH::Impl {
+    /** Faces, in the order of the face indices */
+    std::vector<BVHTriangle> triangles;
+    /** Hierarchy */
+    Bvh bvh;
+};
+
+namespace
+{
+// Number of SAH bins per axis
+constexpr std::size_t NUM_BINS{16};
+
+// Nodes with at least this many faces are binned in parallel
+constexpr std::size_t PARALLEL_BIN_SIZE{std::size_t{1} << 16};
+
+// Subtrees with at most this many faces are built by a single thread
+constexpr std::size_t SERIAL_SUBTREE_SIZE{std::size_t{1} << 14};
+
+// Nodes at this depth and below are split at the object median, which bounds
+// the depth of the tree for the fixed-size traversal stack
+constexpr int MAX_SAH_DEPTH{32};
+
+// Cost of traversing a node relative to intersecting a face
+constexpr double TRAVERSAL_COST{1};
+
+constexpr std::array<char, 8> MAGIC{'V', 'C', 'B', 'V', 'H', '\0', '\0', '\0'};
+constexpr std::uint32_t VERSION{1};
+
+// Fixed-size file header
+struct Header {
+    std::array<char, 8> magic{MAGIC};
+    std::uint32_t version{VERSION};
+    std::uint32_t reserved{0};
+    std::uint64_t numFaces{0};
+    std::uint64_t numNodes{0};
+};
+
+// Axis-aligned bounding box
+struct Box {
+    cv::Vec3d min{cv::Vec3d::all(std::numeric_limits<double>::max())};
+    cv::Vec3d max{cv::Vec3d::all(std::numeric_limits<double>::lowest())};
+
+    void extend(const cv::Vec3d& p)
+    {
+        for (int d = 0; d < 3; d++) {
+            min[d] = std::min(min[d], p[d]);
+            max[d] = std::max(max[d], p[d]);
+        }
+    }
+
+    void extend(const Box& b)
+    {
+        extend(b.min);
+        extend(b.max);
+    }
+
+    [[nodiscard]] auto empty() const -> bool { return min[0] > max[0]; }
+
+    [[nodiscard]] auto halfArea() const -> double
+    {
+        if (empty()) {
+            return 0;
+        }
+        auto d = max - min;
+        return d[0] * d[1] + d[1] * d[2] + d[2] * d[0];
+    }
+};
+
+// SAH bin of one axis
+struct Bin {
+    Box box;
+    std::size_t count{0};
+};
+
+using Bins = std::array<std::array<Bin, NUM_BINS>, 3>;
+
+void SetBounds(Node& node, const Box& box)
+{
+    node.bounding_box_proxy() = bvh::BoundingBox<Scalar>(
+        Vector3(box.min[0], box.min[1], box.min[2]),
+        Vector3(box.max[0], box.max[1], box.max[2]));
+}
+
+void SetLeaf(Node& node, std::size_t first, std::size_t count)
+{
+    node.is_leaf = true;
+    node.primitive_count = static_cast<NodeIndex>(count);
+    node.first_child_or_primitive = static_cast<NodeIndex>(first);
+}
+
+void SetInner(Node& node, std::size_t firstChild)
+{
+    node.is_leaf = false;
+    node.primitive_count = 0;
+    node.first_child_or_primitive = static_cast<NodeIndex>(firstChild);
+}
+
+// Top-down binned SAH builder. Nodes are stored with both children of a node
+// next to each other, as expected by the bvh library's traversers.
+class Builder
+{
+public:
+    Builder(
+        const std::vector<Box>& boxes,
+        const std::vector<cv::Vec3d>& centers,
+        std::size_t numThreads)
+        : boxes_{boxes}
+        , centers_{centers}
+        , indices_(boxes.size())
+        , numThreads_{numThreads}
+    {
+        for (std::size_t i = 0; i < indices_.size(); i++) {
+            indices_[i] = i;
+        }
+    }
+
+    auto build() -> Bvh
+    {
+        Bvh result;
+        const auto numFaces = indices_.size();
+        if (numFaces == 0) {
+            return result;
+        }
+
+        // Split the large nodes at the top of the tree on this thread, and
+        // collect the small subtrees below them
+        struct Task {
+            std::size_t node;
+            std::size_t begin;
+            std::size_t end;
+            int depth;
+        };
+        std::vector<Node> nodes(1);
+        std::vector<Task> subtrees;
+        std::vector<Task> stack{{0, 0, numFaces, 0}};
+        while (not stack.empty()) {
+            auto t = stack.back();
+            stack.pop_back();
+            if (t.end - t.begin <= SERIAL_SUBTREE_SIZE) {
+                subtrees.push_back(t);
+                continue;
+            }
+            SetBounds(nodes[t.node], bounds_(t.begin, t.end));
+            auto mid = split_(t.begin, t.end, t.depth);
+            if (mid == t.end) {
+                SetLeaf(nodes[t.node], t.begin, t.end - t.begin);
+                continue;
+            }
+            auto left = nodes.size();
+            nodes.resize(left + 2);
+            SetInner(nodes[t.node], left);
+            stack.push_back({left + 1, mid, t.end, t.depth + 1});
+            stack.push_back({left, t.begin, mid, t.depth + 1});
+        }
+
+        // Build the subtrees in parallel. Each covers its own range of the
+        // face indices.
+        std::vector<std::vector<Node>> local(subtrees.size());
+        ParallelChunks(
+            subtrees.size(), numThreads_, [&](auto begin, auto end) {
+                for (auto i = begin; i < end; i++) {
+                    const auto& t = subtrees[i];
+                    local[i].resize(1);
+                    build_subtree_(local[i], 0, t.begin, t.end, t.depth);
+                }
+            });
+
+        // Append the subtrees. Local child indices are offset so that the
+        // subtree's first pair lands at the end of the node list.
+        for (std::size_t i = 0; i < subtrees.size(); i++) {
+            const auto offset = nodes.size() - 1;
+            auto shift = [offset](Node n) {
+                if (not n.is_leaf) {
+                    n.first_child_or_primitive += offset;
+                }
+                return n;
+            };
+            nodes[subtrees[i].node] = shift(local[i][0]);
+            for (std::size_t n = 1; n < local[i].size(); n++) {
+                nodes.push_back(shift(local[i][n]));
+            }
+            local[i] = {};
+        }
+
+        result.node_count = nodes.size();
+        result.nodes = std::make_unique<Node[]>(nodes.size());
+        std::copy(nodes.begin(), nodes.end(), result.nodes.get());
+        result.primitive_indices = std::make_unique<std::size_t[]>(numFaces);
+        std::copy(
+            indices_.begin(), indices_.end(), result.primitive_indices.get());
+        return result;
+    }
+
+private:
+    const std::vector<Box>& boxes_;
+    const std::vector<cv::Vec3d>& centers_;
+    std::vector<std::size_t> indices_;
+    std::size_t numThreads_;
+
+    // Recursively build a subtree on the calling thread
+    void build_subtree_(
+        std::vector<Node>& nodes,
+        std::size_t node,
+        std::size_t begin,
+        std::size_t end,
+        int depth)
+    {
+        SetBounds(nodes[node], bounds_(begin, end));
+        auto mid = split_(begin, end, depth);
+        if (mid == end) {
+            SetLeaf(nodes[node], begin, end - begin);
+            return;
+        }
+        auto left = nodes.size();
+        nodes.resize(left + 2);
+        SetInner(nodes[node], left);
+        build_subtree_(nodes, left, begin, mid, depth + 1);
+        build_subtree_(nodes, left + 1, mid, end, depth + 1);
+    }
+
+    // Run f(begin, end) over a range of faces, in parallel if it is large,
+    // and combine the per-chunk results with merge(into, from)
+    template <typename T, typename F, typename M>
+    auto reduce_(std::size_t begin, std::size_t end, F f, M merge) -> T
+    {
+        if (end - begin < PARALLEL_BIN_SIZE) {
+            return f(begin, end);
+        }
+        T result{};
+        std::mutex mutex;
+        ParallelChunks(end - begin, numThreads_, [&](auto b, auto e) {
+            auto local = f(begin + b, begin + e);
+            const std::lock_guard<std::mutex> lock(mutex);
+            merge(result, local);
+        });
+        return result;
+    }
+
+    // Bounds of a range of faces
+    auto bounds_(std::size_t begin, std::size_t end) -> Box
+    {
+        return reduce_<Box>(
+            begin, end,
+            [this](auto b, auto e) {
+                Box box;
+                for (auto i = b; i < e; i++) {
+                    box.extend(boxes_[indices_[i]]);
+                }
+                return box;
+            },
+            [](Box& into, const Box& from) { into.extend(from); });
+    }
+
+    // Bounds of the centers of a range of faces
+    auto center_bounds_(std::size_t begin, std::size_t end) -> Box
+    {
+        return reduce_<Box>(
+            begin, end,
+            [this](auto b, auto e) {
+                Box box;
+                for (auto i = b; i < e; i++) {
+                    box.extend(centers_[indices_[i]]);
+                }
+                return box;
+            },
+            [](Box& into, const Box& from) { into.extend(from); });
+    }
+
+    // Partition a range of faces. Returns the first face of the right child,
+    // or `end` if the range should be a leaf.
+    auto split_(std::size_t begin, std::size_t end, int depth) -> std::size_t
+    {
+        const auto count = end - begin;
+        if (count <= 1) {
+            return end;
+        }
+
+        // Faces with the same center can only be split arbitrarily
+        auto centers = center_bounds_(begin, end);
+        auto extent = centers.max - centers.min;
+        auto axis = 0;
+        for (int d = 1; d < 3; d++) {
+            if (extent[d] > extent[axis]) {
+                axis = d;
+            }
+        }
+        if (extent[axis] <= 0) {
+            return count <= MeshBVH::MAX_LEAF_SIZE ? end : begin + count / 2;
+        }
+        if (depth >= MAX_SAH_DEPTH) {
+            return median_split_(begin, end, axis);
+        }
+
+        // Bin the faces by their centers along each axis
+        auto binOf = [&centers, &extent](const cv::Vec3d& c, int d) {
+            auto b = static_cast<std::size_t>(
+                (c[d] - centers.min[d]) / extent[d] * NUM_BINS);
+            return std::min(b, NUM_BINS - 1);
+        };
+        auto bins = reduce_<Bins>(
+            begin, end,
+            [&](auto b, auto e) {
+                Bins local{};
+                for (auto i = b; i < e; i++) {
+                    auto f = indices_[i];
+                    for (int d = 0; d < 3; d++) {
+                        if (extent[d] <= 0) {
+                            continue;
+                        }
+                        auto& bin = local[d][binOf(centers_[f], d)];
+                        bin.box.extend(boxes_[f]);
+                        bin.count++;
+                    }
+                }
+                return local;
+            },
+            [](Bins& into, const Bins& from) {
+                for (std::size_t d = 0; d < 3; d++) {
+                    for (std::size_t b = 0; b < NUM_BINS; b++) {
+                        into[d][b].box.extend(from[d][b].box);
+                        into[d][b].count += from[d][b].count;
+                    }
+                }
+            });
+
+        // Find the split with the lowest SAH cost. The bins on the right of
+        // each split are accumulated first.
+        auto bestCost = std::numeric_limits<double>::max();
+        int bestAxis{-1};
+        std::size_t bestBin{0};
+        for (int d = 0; d < 3; d++) {
+            if (extent[d] <= 0) {
+                continue;
+            }
+            std::array<double, NUM_BINS> rightCost{};
+            Box right;
+            std::size_t rightCount{0};
+            for (auto b = NUM_BINS - 1; b > 0; b--) {
+                right.extend(bins[d][b].box);
+                rightCount += bins[d][b].count;
+                rightCost[b] = right.halfArea() * rightCount;
+            }
+            Box left;
+            std::size_t leftCount{0};
+            for (std::size_t b = 1; b < NUM_BINS; b++) {
+                left.extend(bins[d][b - 1].box);
+                leftCount += bins[d][b - 1].count;
+                if (leftCount == 0 or leftCount == count) {
+                    continue;
+                }
+                auto cost = left.halfArea() * leftCount + rightCost[b];
+                if (cost < bestCost) {
+                    bestCost = cost;
+                    bestAxis = d;
+                    bestBin = b;
+                }
+            }
+        }
+        if (bestAxis < 0) {
+            return median_split_(begin, end, axis);
+        }
+
+        // Make a leaf if it is cheaper than splitting
+        auto area = bounds_(begin, end).halfArea();
+        auto leafCost = area * count;
+        auto splitCost = area * TRAVERSAL_COST + bestCost;
+        if (count <= MeshBVH::MAX_LEAF_SIZE and leafCost <= splitCost) {
+            return end;
+        }
+
+        auto first = indices_.begin() + begin;
+        auto mid = std::partition(
+            first, indices_.begin() + end, [&](std::size_t f) {
+                return binOf(centers_[f], bestAxis) < bestBin;
+            });
+        return static_cast<std::size_t>(mid - indices_.begin());
+    }
+
+    // Split a range of faces in half along an axis
+    auto median_split_(std::size_t begin, std::size_t end, int axis)
+        -> std::size_t
+    {
+        auto mid = begin + (end - begin) / 2;
+        std::nth_element(
+            indices_.begin() + begin, indices_.begin() + mid,
+            indices_.begin() + end, [this, axis](auto a, auto b) {
+                return centers_[a][axis] < centers_[b][axis];
+            });
+        return mid;
+    }
+};
+
+template <typename T>
+void WriteValue(std::ofstream& file, const T& v)
+{
+    file.write(reinterpret_cast<const char*>(&v), sizeof(T));
+}
+
+template <typename T>
+void ReadValue(std::ifstream& file, T& v)
+{
+    file.read(reinterpret_cast<char*>(&v), sizeof(T));
+}
+
+void WriteVector3(std::ofstream& file, const Vector3& v)
+{
+    for (std::size_t d = 0; d < 3; d++) {
+        WriteValue(file, v[d]);
+    }
+}
+
+auto ReadVector3(std::ifstream& file) -> Vector3
+{
+    std::array<double, 3> v{};
+    for (auto& c : v) {
+        ReadValue(file, c);
+    }
+    return {v[0], v[1], v[2]};
+}
+}  // namespace
+
+MeshBVH::MeshBVH() : impl_{std::make_unique<Impl>()} {}
+
+MeshBVH::~MeshBVH() = default;
+
+auto MeshBVH::New(std::vector<Triangle> triangles, std::size_t numThreads)
+    -> Pointer
+{
+    auto result = std::shared_ptr<MeshBVH>(new MeshBVH());
+    auto& impl = *result->impl_;
+
+    // Per-face bounds and centers
+    const auto numFaces = triangles.size();
+    impl.triangles.resize(numFaces);
+    std::vector<Box> boxes(numFaces);
+    std::vector<cv::Vec3d> centers(numFaces);
+    ParallelChunks(numFaces, numThreads, [&](auto begin, auto end) {
+        for (auto i = begin; i < end; i++) {
+            const auto& [a, b, c] = triangles[i];
+            impl.triangles[i] = BVHTriangle(
+                Vector3(a[0], a[1], a[2]), Vector3(b[0], b[1], b[2]),
+                Vector3(c[0], c[1], c[2]));
+            boxes[i].extend(a);
+            boxes[i].extend(b);
+            boxes[i].extend(c);
+            centers[i] = (a + b + c) / 3;
+        }
+    });
+    triangles = {};
+
+    impl.bvh = Builder(boxes, centers, numThreads).build();
+    return result;
+}
+
+auto MeshBVH::New(const FlatMesh& mesh, std::size_t numThreads) -> Pointer
+{
+    const auto& vertices = mesh.vertices();
+    std::vector<Triangle> triangles;
+    triangles.reserve(mesh.numFaces());
+    for (const auto& f : mesh.faces()) {
+        triangles.push_back({vertices[f[0]], vertices[f[1]], vertices[f[2]]});
+    }
+    return New(std::move(triangles), numThreads);
+}
+
+auto MeshBVH::NewUV(
+    const FlatMesh& mesh, const UVMap& uvMap, std::size_t numThreads)
+    -> Pointer
+{
+    std::vector<Triangle> triangles;
+    triangles.reserve(mesh.numFaces());
+    for (const auto& f : mesh.faces()) {
+        Triangle t;
+        for (std::size_t i = 0; i < 3; i++) {
+            auto uv = uvMap.get(f[i]);
+            t[i] = {uv[0], uv[1], 0.0};
+        }
+        triangles.push_back(t);
+    }
+    return New(std::move(triangles), numThreads);
+}
+
+void MeshBVH::Write(const fs::path& path, const MeshBVH& bvh)
+{
+    std::ofstream file(path.string(), std::ios::binary);
+    if (not file.is_open()) {
+        throw IOException("Failed to open file for writing: " + path.string());
+    }
+
+    const auto& impl = *bvh.impl_;
+    Header header;
+    header.numFaces = impl.triangles.size();
+    header.numNodes = impl.bvh.node_count;
+    WriteValue(file, header);
+
+    // Triangles are stored as their precomputed members, so that a loaded
+    // hierarchy intersects rays exactly like the one which was written
+    for (const auto& t : impl.triangles) {
+        WriteVector3(file, t.p0);
+        WriteVector3(file, t.e1);
+        WriteVector3(file, t.e2);
+        WriteVector3(file, t.n);
+    }
+    for (std::size_t i = 0; i < impl.bvh.node_count; i++) {
+        const auto& node = impl.bvh.nodes[i];
+        for (const auto& b : node.bounds) {
+            WriteValue(file, static_cast<double>(b));
+        }
+        WriteValue(file, static_cast<std::uint64_t>(node.is_leaf));
+        WriteValue(file, static_cast<std::uint64_t>(node.primitive_count));
+        WriteValue(
+            file, static_cast<std::uint64_t>(node.first_child_or_primitive));
+    }
+    for (std::size_t i = 0; i < impl.triangles.size(); i++) {
+        auto idx = impl.bvh.primitive_indices[i];
+        WriteValue(file, static_cast<std::uint64_t>(idx));
+    }
+
+    if (file.fail()) {
+        throw IOException("Failed to write file: " + path.string());
+    }
+}
+
+auto MeshBVH::Read(const fs::path& path) -> Pointer
+{
+    std::ifstream file(path.string(), std::ios::binary);
+    if (not file.is_open()) {
+        throw IOException("Failed to open file for reading: " + path.string());
+    }
+
+    Header header;
+    ReadValue(file, header);
+    if (file.fail() or header.magic != MAGIC) {
+        throw IOException("Not a BVH file: " + path.string());
+    }
+    if (header.version != VERSION) {
+        throw IOException(
+            "Unsupported BVH version: " + std::to_string(header.version));
+    }
+    const auto numFaces = header.numFaces;
+    const auto numNodes = header.numNodes;
+    if ((numFaces == 0) != (numNodes == 0)) {
+        throw IOException("Invalid BVH header: " + path.string());
+    }
+
+    // Compare the counts with the faces and nodes which fit in the rest of
+    // the file before allocating, so that a damaged header cannot overflow
+    // or request huge allocations
+    constexpr std::size_t faceBytes{
+        4 * 3 * sizeof(double) + sizeof(std::uint64_t)};
+    constexpr std::size_t nodeBytes{
+        sizeof(Node::bounds) / sizeof(Scalar) * sizeof(double) +
+        3 * sizeof(std::uint64_t)};
+    const auto start = file.tellg();
+    file.seekg(0, std::ios::end);
+    auto available = static_cast<std::uint64_t>(file.tellg() - start);
+    file.seekg(start);
+    if (numFaces > available / faceBytes or
+        numNodes > (available - numFaces * faceBytes) / nodeBytes) {
+        throw IOException("BVH file is truncated: " + path.string());
+    }
+
+    auto result = std::shared_ptr<MeshBVH>(new MeshBVH());
+    auto& impl = *result->impl_;
+    impl.triangles.resize(numFaces);
+    for (auto& t : impl.triangles) {
+        t.p0 = ReadVector3(file);
+        t.e1 = ReadVector3(file);
+        t.e2 = ReadVector3(file);
+        t.n = ReadVector3(file);
+    }
+
+    // Child and face indices are checked so that a damaged file cannot
+    // cause out-of-bounds reads during traversal
+    auto& bvh = impl.bvh;
+    bvh.node_count = numNodes;
+    bvh.nodes = std::make_unique<Node[]>(numNodes);
+    for (std::size_t i = 0; i < numNodes; i++) {
+        auto& node = bvh.nodes[i];
+        for (auto& b : node.bounds) {
+            double v{0};
+            ReadValue(file, v);
+            b = static_cast<Scalar>(v);
+        }
+        std::uint64_t leaf{0};
+        std::uint64_t count{0};
+        std::uint64_t first{0};
+        ReadValue(file, leaf);
+        ReadValue(file, count);
+        ReadValue(file, first);
+        auto valid = leaf != 0 ? count > 0 and count <= numFaces and
+                                     first <= numFaces - count
+                               : first > i and first < numNodes - 1;
+        if (file.fail() or not valid) {
+            throw IOException("Invalid BVH node in file: " + path.string());
+        }
+        if (leaf != 0) {
+            SetLeaf(node, first, count);
+        } else {
+            SetInner(node, first);
+        }
+    }
+    bvh.primitive_indices = std::make_unique<std::size_t[]>(numFaces);
+    for (std::size_t i = 0; i < numFaces; i++) {
+        std::uint64_t idx{0};
+        ReadValue(file, idx);
+        if (idx >= numFaces) {
+            throw IOException(
+                "Invalid BVH face index in file: " + path.string());
+        }
+        bvh.primitive_indices[i] = idx;
+    }
+
+    if (file.fail()) {
+        throw IOException("Failed to read file: " + path.string());
+    }
+    return result;
+}
+
+auto MeshBVH::numFaces() const -> std::size_t
+{
+    return impl_->triangles.size();
+}
+
+auto MeshBVH::numNodes() const -> std::size_t { return impl_->bvh.node_count; }
+
+auto MeshBVH::intersect(
+    const cv::Vec3d& origin,
+    const cv::Vec3d& direction,
+    double tmin,
+    double tmax) const -> std::optional<Hit>
+{
+    if (impl_->triangles.empty()) {
+        return std::nullopt;
+    }
+
+    Ray ray(
+        Vector3(origin[0], origin[1], origin[2]),
+        Vector3(direction[0], direction[1], direction[2]), tmin, tmax);
+    Traverser traverser(impl_->bvh);
+    Intersector intersector(impl_->bvh, impl_->triangles.data());
+    auto hit = traverser.traverse(ray, intersector);
+    if (not hit) {
+        return std::nullopt;
+    }
+    return Hit{
+        hit->primitive_index, hit->intersection.t, hit->intersection.u,
+        hit->intersection.v};
+}
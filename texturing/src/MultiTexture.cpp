@@ -0,0 +1,112 @@
+#include "vc/texturing/MultiTexture.hpp"
+
+#include <algorithm>
+#include <numeric>
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+using namespace volcart;
+using namespace volcart::texturing;
+
+using Texture = MultiTexture::Texture;
+using Filter = CompositeTexture::Filter;
+
+namespace
+{
+// Composite filter of a composite output
+auto ToFilter(MultiTexture::Output o) -> Filter
+{
+    using Output = MultiTexture::Output;
+    switch (o) {
+        case Output::Minimum:
+            return Filter::Minimum;
+        case Output::Maximum:
+            return Filter::Maximum;
+        case Output::Median:
+            return Filter::Median;
+        case Output::Mean:
+            return Filter::Mean;
+        case Output::MedianAverage:
+            return Filter::MedianAverage;
+        default:
+            throw std::invalid_argument("Output is not a composite filter");
+    }
+}
+}  // namespace
+
+Texture MultiTexture::compute()
+{
+    if (not gen_ or gen_->dim() < 1) {
+        throw std::runtime_error("Generator dimension below required");
+    }
+    if (outputs_.empty()) {
+        throw std::invalid_argument("No outputs requested");
+    }
+    auto layers = std::find(outputs_.begin(), outputs_.end(), Output::Layers);
+    if (layers != outputs_.end() and gen_->dim() != 1) {
+        throw std::runtime_error("Layers output requires a 1D generator");
+    }
+
+    // Setup
+    result_.clear();
+    auto height = static_cast<int>(ppm_->height());
+    auto width = static_cast<int>(ppm_->width());
+
+    // Output images. first[i] is the index of output i's first image.
+    std::vector<std::size_t> first;
+    for (const auto& o : outputs_) {
+        first.push_back(result_.size());
+        if (o == Output::Integral) {
+            result_.emplace_back(cv::Mat::zeros(height, width, CV_32FC1));
+        } else if (o == Output::Layers) {
+            for (std::size_t i = 0; i < gen_->extents()[0]; i++) {
+                result_.emplace_back(cv::Mat::zeros(height, width, CV_16UC1));
+            }
+        } else {
+            result_.emplace_back(cv::Mat::zeros(height, width, CV_16UC1));
+        }
+    }
+
+    // Generate the neighborhood of every mapping once for every output
+    const auto size = gen_->size();
+    progressStarted();
+    for_each_neighborhood_(*gen_, [&](int x, int y, const uint16_t* samples) {
+        const NDArrayView<const uint16_t> neighborhood(samples, {size});
+        for (std::size_t o = 0; o < outputs_.size(); o++) {
+            auto& image = result_[first[o]];
+            switch (outputs_[o]) {
+                case Output::Integral: {
+                    auto sum = std::accumulate(
+                        neighborhood.begin(), neighborhood.end(), 0.0);
+                    image.at<float>(y, x) = static_cast<float>(sum);
+                    break;
+                }
+                case Output::Layers: {
+                    auto it = first[o];
+                    for (const auto& v : neighborhood) {
+                        result_[it++].at<uint16_t>(y, x) = v;
+                    }
+                    break;
+                }
+                default:
+                    image.at<uint16_t>(y, x) =
+                        CompositeTexture::FilterNeighborhood(
+                            neighborhood, ToFilter(outputs_[o]));
+                    break;
+            }
+        }
+    });
+    progressComplete();
+
+    // Integral images are normalized over the whole image
+    for (std::size_t o = 0; o < outputs_.size(); o++) {
+        if (outputs_[o] == Output::Integral) {
+            auto& image = result_[first[o]];
+            cv::normalize(image, image, 0.0, 1.0, cv::NORM_MINMAX);
+        }
+    }
+
+    track_result_();
+    return result_;
+}
@@ -1,18 +1,46 @@
 #include "vc/texturing/OrthographicProjectionFlattening.hpp"
 
+#include <algorithm>
 #include <array>
+#include <limits>
+#include <vector>
 
-#include <vtkOBBTree.h>
-#include <vtkPolyData.h>
-#include <vtkSmartPointer.h>
+#include <opencv2/core.hpp>
 
+#include "vc/core/util/Iteration.hpp"
+#include "vc/core/util/ThreadPool.hpp"
 #include "vc/meshing/DeepCopy.hpp"
-#include "vc/meshing/ITK2VTK.hpp"
 
 using namespace volcart;
 using namespace texturing;
 namespace vcm = volcart::meshing;
 
+namespace
+{
+// Number of chunks in a parallel reduction. Fixed so that the result does not
+// depend on the number of threads.
+constexpr std::size_t NUM_CHUNKS{64};
+
+// Accumulate f(i, partial) over [0, n) in parallel chunks, then combine the
+// partial results in chunk order
+template <typename T, class F, class C>
+auto ChunkedReduce(std::size_t n, const T& init, F f, C combine) -> T
+{
+    std::vector<T> partials(NUM_CHUNKS, init);
+    ParallelFor(range(NUM_CHUNKS), [&](auto c) {
+        auto& partial = partials[c];
+        for (auto i = n * c / NUM_CHUNKS; i < n * (c + 1) / NUM_CHUNKS; i++) {
+            f(i, partial);
+        }
+    });
+    auto result = init;
+    for (const auto& p : partials) {
+        combine(result, p);
+    }
+    return result;
+}
+}  // namespace
+
 OrthographicProjectionFlattening::Pointer
 OrthographicProjectionFlattening::New()
 {
@@ -24,38 +52,65 @@ ITKMesh::Pointer OrthographicProjectionFlattening::compute()
     // Setup output
     output_ = ITKMesh::New();
     vcm::DeepCopy(mesh_, output_);
+    const auto& inPts = mesh_->GetPoints()->CastToSTLConstContainer();
+    auto& outPts = output_->GetPoints()->CastToSTLContainer();
+    const auto n = inPts.size();
+    if (n == 0) {
+        return output_;
+    }
+    auto point = [&inPts](auto i) {
+        return cv::Vec3d(inPts[i].GetDataPointer());
+    };
+
+    // Compute the OBB axes from the covariance of the vertices. Matches
+    // vtkOBBTree::ComputeOBB.
+    auto add = [](auto& a, const auto& b) { a += b; };
+    auto mean = ChunkedReduce(
+        n, cv::Vec3d(), [&](auto i, auto& sum) { sum += point(i); }, add);
+    mean /= static_cast<double>(n);
+    auto cov = ChunkedReduce(
+        n, cv::Matx33d(),
+        [&](auto i, auto& sum) {
+            auto d = point(i) - mean;
+            sum += d * d.t();
+        },
+        add);
+    cov *= 1.0 / static_cast<double>(n);
+    cv::Mat eigenvalues;
+    cv::Mat eigenvectors;
+    cv::eigen(cv::Mat(cov), eigenvalues, eigenvectors);
 
-    // convert input mesh to vtkMesh
-    vtkSmartPointer<vtkPolyData> vtkMesh = vtkSmartPointer<vtkPolyData>::New();
-    vcm::ITK2VTK(mesh_, vtkMesh);
-    cv::Vec3d origin, xAxis, yAxis, zAxis;
+    // The eigenvectors are the rows, largest first. Pick the sign with the
+    // most positive components, as vtkMath::Jacobi does.
+    std::array<cv::Vec3d, 2> axes;
+    for (int a = 0; a < 2; a++) {
+        cv::Vec3d axis(eigenvectors.ptr<double>(a));
+        auto numPos = (axis[0] >= 0) + (axis[1] >= 0) + (axis[2] >= 0);
+        axes[a] = numPos < 2 ? -axis : axis;
+    }
 
-    // Computes the OBB and returns the 3 axes
-    std::array<double, 3> size;
-    auto obbTree = vtkSmartPointer<vtkOBBTree>::New();
-    obbTree->ComputeOBB(
-        vtkMesh, origin.val, xAxis.val, yAxis.val, zAxis.val, size.data());
+    // The corner of the OBB is the origin of the projection plane
+    using Bounds = cv::Vec2d;
+    auto minimum = [](auto& a, const auto& b) {
+        a = {std::min(a[0], b[0]), std::min(a[1], b[1])};
+    };
+    auto tMin = ChunkedReduce(
+        n, Bounds::all(std::numeric_limits<double>::max()),
+        [&](auto i, auto& m) {
+            auto d = point(i) - mean;
+            minimum(m, Bounds(d.dot(axes[0]), d.dot(axes[1])));
+        },
+        minimum);
 
     // Calculate UV positions
     // Largest two BB axes are the projection plane
-    auto uLen = cv::norm(xAxis);
-    auto vLen = cv::norm(yAxis);
-    auto uVec = xAxis / uLen;
-    auto vVec = yAxis / vLen;
-    ITKPoint oldPt;
-    ITKPoint newPt;
-    for (size_t i = 0; i < mesh_->GetNumberOfPoints(); ++i) {
-        // Get the original point
-        mesh_->GetPoint(i, &oldPt);
-        cv::Vec3d pt(oldPt.GetDataPointer());
-
-        // Project point onto bb plane and calculate relative position
-        newPt[0] = (pt - origin).dot(uVec);
+    ParallelFor(range(n), [&](auto i) {
+        auto d = point(i) - mean;
+        auto& newPt = outPts[i];
+        newPt[0] = d.dot(axes[0]) - tMin[0];
         newPt[1] = 0;
-        newPt[2] = (pt - origin).dot(vVec);
-
-        output_->SetPoint(i, newPt);
-    }
+        newPt[2] = d.dot(axes[1]) - tMin[1];
+    });
 
     return output_;
 }
@@ -1,36 +1,178 @@
 #include "vc/texturing/PPMGenerator.hpp"
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
 #include <exception>
+#include <memory>
+#include <future>
+#include <mutex>
+#include <utility>
+#include <vector>
 
-#include <bvh/bvh.hpp>
-#include <bvh/primitive_intersectors.hpp>
-#include <bvh/ray.hpp>
-#include <bvh/single_ray_traverser.hpp>
-#include <bvh/sweep_sah_builder.hpp>
-#include <bvh/triangle.hpp>
-#include <bvh/vector.hpp>
 #include <opencv2/core.hpp>
 
+#include "vc/core/types/FlatMesh.hpp"
 #include "vc/core/util/BarycentricCoordinates.hpp"
-#include "vc/core/util/Iteration.hpp"
-#include "vc/meshing/CalculateNormals.hpp"
-#include "vc/meshing/DeepCopy.hpp"
+#include "vc/core/util/ProgressCounter.hpp"
+#include "vc/core/util/ThreadPool.hpp"
+#include "vc/core/util/Tracing.hpp"
 
 using namespace volcart;
 using namespace texturing;
 
-namespace vcm = volcart::meshing;
 namespace vct = volcart::texturing;
 
 static constexpr uint8_t MASK_TRUE{255};
 
-using Scalar = double;
-using Vector3 = bvh::Vector3<Scalar>;
-using Triangle = bvh::Triangle<Scalar>;
-using Ray = bvh::Ray<Scalar>;
-using Bvh = bvh::Bvh<Scalar>;
-using Intersector = bvh::ClosestPrimitiveIntersector<Bvh, Triangle>;
-using Traverser = bvh::SingleRayTraverser<Bvh>;
+// Number of output rows claimed by a worker at a time
+static constexpr size_t TILE_ROWS{16};
+
+// Barycentric tolerance for rasterized pixels on the edge of a face
+static constexpr double RASTER_EPSILON{1e-12};
+
+namespace
+{
+// UV coordinates of a face's vertices
+using UVTriangle = std::array<cv::Vec3d, 3>;
+
+// Per-face data extracted from the mesh before tracing
+struct Face {
+    std::array<cv::Vec3d, 3> xyz;
+    std::array<cv::Vec3d, 3> normal;
+};
+
+// UV coordinate of pixel (x, y) in a width x height image
+auto PixelUV(size_t y, size_t x, size_t width, size_t height) -> cv::Vec3d
+{
+    return {
+        static_cast<double>(x) / static_cast<double>(width - 1),
+        static_cast<double>(y) / static_cast<double>(height - 1), 0};
+}
+
+// Scanline rasterizer for UV triangles. Faces are binned by the tiles of
+// TILE_ROWS rows they overlap, then the pixels in the bounding box of each
+// face in a tile are visited. Faces are stored in bins in index order, so the
+// lowest index face wins a pixel.
+class UVRasterizer
+{
+public:
+    // Rasterize the faces into region of a width x height image. Faces
+    // outside of the region, including those with invalid UVs, are skipped.
+    UVRasterizer(
+        const std::vector<UVTriangle>& uvs,
+        size_t width,
+        size_t height,
+        const cv::Rect& region)
+        : uvs_{uvs}
+        , width_{width}
+        , height_{height}
+        , offX_{static_cast<size_t>(region.x)}
+        , offY_{static_cast<size_t>(region.y)}
+    {
+        const auto outW = static_cast<size_t>(region.width);
+        const auto outH = static_cast<size_t>(region.height);
+        const auto numTiles = (outH + TILE_ROWS - 1) / TILE_ROWS;
+
+        // Pixel bounds of each face, clamped to the region and relative to
+        // its origin
+        const auto scaleX = static_cast<double>(width_ - 1);
+        const auto scaleY = static_cast<double>(height_ - 1);
+        faceBounds_.reserve(uvs_.size());
+        binOffsets_.assign(numTiles + 1, 0);
+        for (const auto& uv : uvs_) {
+            auto [uMin, uMax] = std::minmax({uv[0][0], uv[1][0], uv[2][0]});
+            auto [vMin, vMax] = std::minmax({uv[0][1], uv[1][1], uv[2][1]});
+            std::array<int, 4> bounds{0, -1, 0, -1};
+            auto x0 = std::floor(uMin * scaleX) - static_cast<double>(offX_);
+            auto x1 = std::ceil(uMax * scaleX) - static_cast<double>(offX_);
+            auto y0 = std::floor(vMin * scaleY) - static_cast<double>(offY_);
+            auto y1 = std::ceil(vMax * scaleY) - static_cast<double>(offY_);
+            const auto lastX = static_cast<double>(outW - 1);
+            const auto lastY = static_cast<double>(outH - 1);
+            if (x1 >= 0 and y1 >= 0 and x0 <= lastX and y0 <= lastY) {
+                bounds = {
+                    static_cast<int>(std::max(x0, 0.0)),
+                    static_cast<int>(std::min(x1, lastX)),
+                    static_cast<int>(std::max(y0, 0.0)),
+                    static_cast<int>(std::min(y1, lastY))};
+                auto tileMax = bounds[3] / TILE_ROWS;
+                for (size_t t = bounds[2] / TILE_ROWS; t <= tileMax; t++) {
+                    binOffsets_[t + 1]++;
+                }
+            }
+            faceBounds_.push_back(bounds);
+        }
+        for (size_t t = 0; t < numTiles; t++) {
+            binOffsets_[t + 1] += binOffsets_[t];
+        }
+        bins_.resize(binOffsets_.back());
+        auto next = binOffsets_;
+        for (size_t cellId = 0; cellId < uvs_.size(); cellId++) {
+            const auto& bounds = faceBounds_[cellId];
+            if (bounds[2] > bounds[3]) {
+                continue;
+            }
+            auto tileMax = bounds[3] / TILE_ROWS;
+            for (size_t t = bounds[2] / TILE_ROWS; t <= tileMax; t++) {
+                bins_[next[t]++] = cellId;
+            }
+        }
+    }
+
+    // Call fn(y, x, cellId, baryCoord) for every pixel in rows [y0, y1) that
+    // is covered by a face and is still unassigned (-1) in cellMap. fn must
+    // assign the pixel in cellMap. y0 must be the first row of a tile, and
+    // y1 no further than the end of that tile.
+    template <class Fn>
+    void rasterizeRows(
+        size_t y0, size_t y1, const cv::Mat& cellMap, Fn&& fn) const
+    {
+        const auto tile = y0 / TILE_ROWS;
+        for (auto b = binOffsets_[tile]; b < binOffsets_[tile + 1]; b++) {
+            const auto cellId = bins_[b];
+            const auto& uv = uvs_[cellId];
+            const auto& [xMin, xMax, yMin, yMax] = faceBounds_[cellId];
+            auto yBegin = std::max(static_cast<size_t>(yMin), y0);
+            auto yEnd = std::min(static_cast<size_t>(yMax) + 1, y1);
+            for (auto y = yBegin; y < yEnd; y++) {
+                for (auto x = static_cast<size_t>(xMin);
+                     x <= static_cast<size_t>(xMax); x++) {
+                    auto intX = static_cast<int>(x);
+                    auto intY = static_cast<int>(y);
+                    if (cellMap.at<int32_t>(intY, intX) != -1) {
+                        continue;
+                    }
+                    auto pixel = PixelUV(y + offY_, x + offX_, width_, height_);
+                    auto baryCoord =
+                        CartesianToBarycentric(pixel, uv[0], uv[1], uv[2]);
+                    if (baryCoord[0] >= -RASTER_EPSILON and
+                        baryCoord[1] >= -RASTER_EPSILON and
+                        baryCoord[2] >= -RASTER_EPSILON) {
+                        fn(y, x, cellId, baryCoord);
+                    }
+                }
+            }
+        }
+    }
+
+private:
+    // Face UV coordinates
+    const std::vector<UVTriangle>& uvs_;
+    // Full image dimensions
+    size_t width_;
+    size_t height_;
+    // Region origin
+    size_t offX_;
+    size_t offY_;
+    // Per-face pixel bounds: x min, x max, y min, y max
+    std::vector<std::array<int, 4>> faceBounds_;
+    // Faces binned by tile, stored in compressed row format
+    std::vector<size_t> binOffsets_;
+    std::vector<size_t> bins_;
+};
+}  // namespace
 
 static auto PhongNormal(
     const cv::Vec3d& nUVW,
@@ -51,135 +193,213 @@ void PPMGenerator::setDimensions(size_t h, size_t w)
     width_ = w;
 }
 
+auto PPMGenerator::width() const -> size_t { return width_; }
+
+auto PPMGenerator::height() const -> size_t { return height_; }
+
 void PPMGenerator::setShading(PPMGenerator::Shading s) { shading_ = s; }
 
+void PPMGenerator::setEngine(PPMGenerator::Engine e) { engine_ = e; }
+
+void PPMGenerator::setRegion(const cv::Rect& r) { region_ = r; }
+
+auto PPMGenerator::region() const -> cv::Rect { return region_; }
+
+auto PPMGenerator::engine() const -> PPMGenerator::Engine { return engine_; }
+
+void PPMGenerator::setBVH(MeshBVH::Pointer bvh) { bvh_ = std::move(bvh); }
+
+auto PPMGenerator::bvh() const -> MeshBVH::Pointer { return bvh_; }
+
+void PPMGenerator::setReferencePPM(const PerPixelMap::Pointer& ppm)
+{
+    reference_ = ppm;
+}
+
+auto PPMGenerator::referencePPM() const -> PerPixelMap::Pointer
+{
+    return reference_;
+}
+
+void PPMGenerator::setChangedFaces(std::vector<std::size_t> faces)
+{
+    changedFaces_ = std::move(faces);
+}
+
+auto PPMGenerator::changedFaces() const -> const std::vector<std::size_t>&
+{
+    return changedFaces_;
+}
+
+void PPMGenerator::setNumThreads(size_t n) { numThreads_ = n; }
+
+auto PPMGenerator::numThreads() const -> size_t
+{
+    if (numThreads_ > 0) {
+        return numThreads_;
+    }
+    return ThreadPool::Global().numThreads();
+}
+
 auto PPMGenerator::getPPM() const -> PerPixelMap::Pointer { return ppm_; }
 
 auto PPMGenerator::progressIterations() const -> size_t
 {
+    if (not region_.empty()) {
+        return static_cast<size_t>(region_.area());
+    }
     return width_ * height_;
 }
 
 // Compute
 auto PPMGenerator::compute() -> PerPixelMap::Pointer
 {
+    // The UV map is only unused when reusing reference barycentric coords
+    // for every face
+    const auto incremental = reference_ and not changedFaces_.empty();
+    const auto reuseBary =
+        reference_ and not reference_->barycentricMap().empty();
+    const auto hasUVs = uvMap_ and not uvMap_->empty();
     if (inputMesh_.IsNull() || inputMesh_->GetNumberOfPoints() == 0 ||
-        inputMesh_->GetNumberOfCells() == 0 || not uvMap_ || uvMap_->empty() ||
-        width_ == 0 || height_ == 0) {
+        inputMesh_->GetNumberOfCells() == 0 ||
+        (not hasUVs and (incremental or not reuseBary)) || width_ == 0 ||
+        height_ == 0) {
         const auto* msg = "Invalid input parameters";
         throw std::invalid_argument(msg);
     }
 
-    // Generate normals
-    if (shading_ == Shading::Smooth &&
-        inputMesh_->GetPointData()->Size() != inputMesh_->GetNumberOfPoints()) {
-        vcm::CalculateNormals normCalc(inputMesh_);
-        workingMesh_ = normCalc.compute();
-    } else {
-        workingMesh_ = inputMesh_;
+    // Region of the full output to generate
+    cv::Rect bounds(0, 0, static_cast<int>(width_), static_cast<int>(height_));
+    auto region = region_.empty() ? bounds : region_;
+    if ((region & bounds) != region) {
+        throw std::invalid_argument("Region is outside of the output bounds");
+    }
+    const auto offX = static_cast<size_t>(region.x);
+    const auto offY = static_cast<size_t>(region.y);
+    const auto outW = static_cast<size_t>(region.width);
+    const auto outH = static_cast<size_t>(region.height);
+
+    // Validate the reference samples
+    cv::Mat refCells;
+    cv::Mat refBary;
+    if (reference_) {
+        refCells = reference_->cellMap();
+        refBary = reference_->barycentricMap();
+        if (refCells.empty()) {
+            throw std::invalid_argument("Reference PPM has no cell map");
+        }
+        if (reference_->width() != outW or reference_->height() != outH or
+            refCells.cols != region.width or refCells.rows != region.height or
+            (not refBary.empty() and refBary.size() != refCells.size())) {
+            throw std::invalid_argument(
+                "Reference PPM does not match the output dimensions");
+        }
+        if (refCells.type() != CV_32SC1) {
+            refCells.convertTo(refCells, CV_32SC1);
+        }
+        if (not refBary.empty() and refBary.type() != CV_64FC3) {
+            refBary.convertTo(refBary, CV_64FC3);
+        }
+        // Without changed faces, every reference face must still exist
+        double maxCell{0};
+        cv::minMaxLoc(refCells, nullptr, &maxCell);
+        if (not incremental and
+            maxCell >= static_cast<double>(inputMesh_->GetNumberOfCells())) {
+            throw std::invalid_argument(
+                "Reference PPM references a face not in the input mesh");
+        }
     }
 
-    // Setup the output
-    ppm_ = PerPixelMap::New(height_, width_);
-    cv::Mat mask = cv::Mat::zeros(height_, width_, CV_8UC1);
-    cv::Mat cellMap = cv::Mat(height_, width_, CV_32SC1);
-    cellMap = cv::Scalar::all(-1);
+    // Flag the changed faces. Reference faces past the end of the mesh were
+    // deleted.
+    const auto numFaces = static_cast<size_t>(inputMesh_->GetNumberOfCells());
+    std::vector<bool> changed;
+    std::vector<size_t> changedIds;
+    if (incremental) {
+        changed.assign(numFaces, false);
+        for (auto f : changedFaces_) {
+            if (f >= numFaces) {
+                throw std::invalid_argument(
+                    "Changed face is not in the input mesh");
+            }
+            changed[f] = true;
+        }
+        for (size_t f = 0; f < numFaces; f++) {
+            if (changed[f]) {
+                changedIds.push_back(f);
+            }
+        }
+    }
 
-    // Create BVH for mesh
-    std::vector<Triangle> triangles;
-    for (auto cell = workingMesh_->GetCells()->Begin();
-         cell != workingMesh_->GetCells()->End(); ++cell) {
-        // Get the vertex IDs
-        auto a = cell->Value()->GetPointIdsContainer().GetElement(0);
-        auto b = cell->Value()->GetPointIdsContainer().GetElement(1);
-        auto c = cell->Value()->GetPointIdsContainer().GetElement(2);
-
-        auto uvA = uvMap_->get(a);
-        auto uvB = uvMap_->get(b);
-        auto uvC = uvMap_->get(c);
-
-        // Add the face to the BVH tree
-        triangles.emplace_back(
-            Vector3(uvA[0], uvA[1], 0), Vector3(uvB[0], uvB[1], 0),
-            Vector3(uvC[0], uvC[1], 0));
+    // Flatten the mesh so that face extraction is a linear sweep over
+    // contiguous arrays. Generate normals if they're missing.
+    auto mesh = ToFlatMesh(inputMesh_);
+    if (shading_ == Shading::Smooth and not mesh.hasNormals()) {
+        mesh.computeNormals();
     }
-    Bvh bvh;
-    bvh::SweepSahBuilder<Bvh> builder(bvh);
-    auto [bboxes, centers] = bvh::compute_bounding_boxes_and_centers(
-        triangles.data(), triangles.size());
-    auto meshBBox =
-        bvh::compute_bounding_boxes_union(bboxes.get(), triangles.size());
-    builder.build(meshBBox, bboxes.get(), centers.get(), triangles.size());
-    Intersector intersector(bvh, triangles.data());
-    Traverser traverser(bvh);
 
-    // Iterate over all of the pixels
-    progressStarted();
-    ITKCell::CellAutoPointer cell;
-    for (const auto [y, x] : range2D(height_, width_)) {
-        progressUpdated(y * width_ + x);
-        // This pixel's uv coordinate
-        cv::Vec3d uv{0, 0, 0};
-        uv[0] = static_cast<double>(x) / static_cast<double>(width_ - 1);
-        uv[1] = static_cast<double>(y) / static_cast<double>(height_ - 1);
-
-        // Intersect a ray with the data structure
-        Ray ray(Vector3(uv[0], uv[1], 0), Vector3(uv[0], uv[1], 1.0), 0.0, 1.0);
-        auto hit = traverser.traverse(ray, intersector);
-        if (not hit) {
-            continue;
+    // Setup the output
+    ppm_ = PerPixelMap::New(outH, outW);
+    cv::Mat mask = cv::Mat::zeros(outH, outW, CV_8UC1);
+    cv::Mat cellMap = cv::Mat(outH, outW, CV_32SC1);
+    cellMap = cv::Scalar::all(-1);
+    cv::Mat baryMap = cv::Mat::zeros(outH, outW, CV_64FC3);
+
+    // Extract the face data
+    std::vector<UVTriangle> uvs;
+    std::vector<Face> faces;
+    uvs.reserve(mesh.numFaces());
+    faces.reserve(mesh.numFaces());
+    const auto& vertices = mesh.vertices();
+    const auto& normals = mesh.normals();
+    for (const auto& meshFace : mesh.faces()) {
+        UVTriangle uv;
+        Face face;
+        for (unsigned int i = 0; i < 3; i++) {
+            auto idx = meshFace[i];
+            if (hasUVs) {
+                auto uvPt = uvMap_->get(idx);
+                uv[i] = {uvPt[0], uvPt[1], 0.0};
+            }
+            face.xyz[i] = vertices[idx];
+            if (shading_ == Shading::Smooth) {
+                face.normal[i] = normals[idx];
+            }
         }
 
-        // Cell info
-        auto cellId = hit->primitive_index;
-        cell.TakeOwnership(new ITKTriangle);
-        workingMesh_->GetCell(cellId, cell);
-        auto a = cell->GetPointIdsContainer().GetElement(0);
-        auto b = cell->GetPointIdsContainer().GetElement(1);
-        auto c = cell->GetPointIdsContainer().GetElement(2);
-
-        // Get the 2D and 3D pts
-        std::vector<cv::Vec3d> uvPts;
-        std::vector<cv::Vec3d> xyzPts;
-        for (const auto& idx : {a, b, c}) {
-            auto uvPt = uvMap_->get(idx);
-            auto xyzPt = workingMesh_->GetPoint(idx);
-            uvPts.emplace_back(uvPt[0], uvPt[1], 0.0);
-            xyzPts.emplace_back(xyzPt[0], xyzPt[1], xyzPt[2]);
+        // Flat shading uses the face normal for every vertex
+        if (shading_ == Shading::Flat) {
+            auto v1v0 = face.xyz[1] - face.xyz[0];
+            auto v2v0 = face.xyz[2] - face.xyz[0];
+            face.normal.fill(cv::normalize(v1v0.cross(v2v0)));
         }
 
+        uvs.push_back(uv);
+        faces.push_back(face);
+    }
+
+    // Map a single pixel to a point on a face
+    auto mapPixel = [&](size_t y, size_t x, size_t cellId,
+                        const cv::Vec3d& baryCoord) {
         // Find the xyz coordinate of the original point
-        auto baryCoord =
-            CartesianToBarycentric(uv, uvPts[0], uvPts[1], uvPts[2]);
-        auto xyz =
-            BarycentricToCartesian(baryCoord, xyzPts[0], xyzPts[1], xyzPts[2]);
+        const auto& face = faces[cellId];
+        auto xyz = BarycentricToCartesian(
+            baryCoord, face.xyz[0], face.xyz[1], face.xyz[2]);
 
         // Get this corresponding normal
         cv::Vec3d xyzNorm;
         if (shading_ == Shading::Flat) {
-            auto v1v0 = xyzPts[1] - xyzPts[0];
-            auto v2v0 = xyzPts[2] - xyzPts[0];
-            xyzNorm = cv::normalize(v1v0.cross(v2v0));
+            xyzNorm = face.normal[0];
         } else {
-            ITKPixel nA;
-            ITKPixel nB;
-            ITKPixel nC;
-            auto found = workingMesh_->GetPointData(a, &nA);
-            found &= workingMesh_->GetPointData(b, &nB);
-            found &= workingMesh_->GetPointData(c, &nC);
-            if (not found) {
-                throw std::runtime_error(
-                    "Performing smooth shading but missing vertex normal");
-            }
             xyzNorm = PhongNormal(
-                baryCoord, {nA[0], nA[1], nA[2]}, {nB[0], nB[1], nB[2]},
-                {nC[0], nC[1], nC[2]});
+                baryCoord, face.normal[0], face.normal[1], face.normal[2]);
         }
 
         // Assign the cell index to the cell map
         auto intX = static_cast<int>(x);
         auto intY = static_cast<int>(y);
-        cellMap.at<int32_t>(intY, intX) = cellId;
+        cellMap.at<int32_t>(intY, intX) = static_cast<int32_t>(cellId);
+        baryMap.at<cv::Vec3d>(intY, intX) = baryCoord;
 
         // Assign the intensity value at the UV position
         mask.at<uint8_t>(intY, intX) = MASK_TRUE;
@@ -187,12 +407,148 @@ auto PPMGenerator::compute() -> PerPixelMap::Pointer
         // Assign 3D position to the lookup map
         ppm_->getMapping(y, x) = cv::Vec6d(
             xyz(0), xyz(1), xyz(2), xyzNorm(0), xyzNorm(1), xyzNorm(2));
+    };
+
+    // Ray casting: trace every pixel through the BVH of the UV faces
+    MeshBVH::Pointer bvh;
+    auto rayCastRows = [&](size_t y0, size_t y1) {
+        for (auto y = y0; y < y1; y++) {
+            for (size_t x = 0; x < outW; x++) {
+                // Intersect a ray with the data structure
+                auto uv = PixelUV(y + offY, x + offX, width_, height_);
+                auto hit = bvh->intersect(
+                    {uv[0], uv[1], 0}, {uv[0], uv[1], 1.0}, 0.0, 1.0);
+                if (not hit) {
+                    continue;
+                }
+
+                auto cellId = hit->face;
+                const auto& face = uvs[cellId];
+                auto baryCoord =
+                    CartesianToBarycentric(uv, face[0], face[1], face[2]);
+                mapPixel(y, x, cellId, baryCoord);
+            }
+        }
+    };
+
+    // Reference samples: reuse the face under every pixel
+    auto resampleRows = [&](size_t y0, size_t y1) {
+        for (auto y = y0; y < y1; y++) {
+            const auto* cells = refCells.ptr<int32_t>(static_cast<int>(y));
+            for (size_t x = 0; x < outW; x++) {
+                if (cells[x] < 0) {
+                    continue;
+                }
+                auto cellId = static_cast<size_t>(cells[x]);
+                if (incremental and (cellId >= numFaces or changed[cellId])) {
+                    continue;
+                }
+                cv::Vec3d baryCoord;
+                if (reuseBary) {
+                    baryCoord = refBary.at<cv::Vec3d>(
+                        static_cast<int>(y), static_cast<int>(x));
+                } else {
+                    auto uv = PixelUV(y + offY, x + offX, width_, height_);
+                    const auto& face = uvs[cellId];
+                    baryCoord =
+                        CartesianToBarycentric(uv, face[0], face[1], face[2]);
+                }
+                mapPixel(y, x, cellId, baryCoord);
+            }
+        }
+    };
+
+    // Incremental: rasterize only the changed faces into the pixels which
+    // weren't resampled from the reference. Faces are kept in index order so
+    // that the lowest index still wins.
+    std::vector<UVTriangle> changedUVs;
+    auto mapChanged = [&](size_t y, size_t x, size_t i,
+                          const cv::Vec3d& baryCoord) {
+        mapPixel(y, x, changedIds[i], baryCoord);
+    };
+
+    std::unique_ptr<UVRasterizer> rasterizer;
+    if (incremental) {
+        changedUVs.reserve(changedIds.size());
+        for (auto f : changedIds) {
+            changedUVs.push_back(uvs[f]);
+        }
+        rasterizer =
+            std::make_unique<UVRasterizer>(changedUVs, width_, height_, region);
+    } else if (reference_) {
+        // Faces are not located
+    } else if (engine_ == Engine::RayCast) {
+        bvh = bvh_;
+        if (not bvh) {
+            bvh = MeshBVH::NewUV(mesh, *uvMap_, numThreads());
+        } else if (bvh->numFaces() != mesh.numFaces()) {
+            throw std::invalid_argument("BVH does not match the input mesh");
+        }
+    } else {
+        rasterizer =
+            std::make_unique<UVRasterizer>(uvs, width_, height_, region);
+    }
+
+    // Workers claim tiles of rows until every row has been processed. Each
+    // worker writes a disjoint set of rows in the outputs.
+    std::atomic<size_t> nextRow{0};
+    ProgressCounter rowsDone(outH);
+    std::exception_ptr error;
+    std::mutex errorMutex;
+    auto worker = [&](bool reportProgress) {
+        try {
+            size_t y0;
+            while ((y0 = nextRow.fetch_add(TILE_ROWS)) < outH) {
+                VC_TRACE_SPAN_CAT("texturing", "PPM tile");
+                auto y1 = std::min(y0 + TILE_ROWS, outH);
+                if (incremental) {
+                    resampleRows(y0, y1);
+                    rasterizer->rasterizeRows(y0, y1, cellMap, mapChanged);
+                } else if (reference_) {
+                    resampleRows(y0, y1);
+                } else if (engine_ == Engine::Rasterize) {
+                    rasterizer->rasterizeRows(y0, y1, cellMap, mapPixel);
+                } else {
+                    rayCastRows(y0, y1);
+                }
+                rowsDone.add(y1 - y0);
+
+                // Signals are only emitted from the calling thread
+                if (reportProgress and rowsDone.shouldReport()) {
+                    progressUpdated(rowsDone.count() * outW);
+                }
+            }
+        } catch (...) {
+            const std::lock_guard<std::mutex> lock(errorMutex);
+            if (not error) {
+                error = std::current_exception();
+            }
+            nextRow = outH;
+        }
+    };
+
+    // Iterate over all of the pixels
+    progressStarted();
+    const auto numTiles = (outH + TILE_ROWS - 1) / TILE_ROWS;
+    auto threadCount = std::min(numThreads(), numTiles);
+    auto& pool = ThreadPool::Global();
+    std::vector<std::future<void>> helpers;
+    for (size_t i = 1; i < threadCount; i++) {
+        helpers.emplace_back(pool.submit([&worker]() { worker(false); }));
+    }
+    worker(true);
+    for (auto& h : helpers) {
+        pool.wait(h);
+    }
+    if (error) {
+        std::rethrow_exception(error);
     }
     progressComplete();
 
     // Finish setting up the output
     ppm_->setMask(mask);
     ppm_->setCellMap(cellMap);
+    ppm_->setBarycentricMap(baryMap);
 
     return ppm_;
 }
@@ -208,6 +564,40 @@ auto PhongNormal(
         (1 - nUVW[0] - nUVW[1]) * nA + nUVW[1] * nB + nUVW[2] * nC);
 }
 
+auto vct::ChangedFaces(
+    const ITKMesh::Pointer& prevMesh,
+    const UVMap::Pointer& prevUV,
+    const ITKMesh::Pointer& mesh,
+    const UVMap::Pointer& uv) -> std::vector<std::size_t>
+{
+    auto sameUV = [&](std::size_t prevId, std::size_t id) {
+        return prevUV->get(prevId) == uv->get(id);
+    };
+
+    std::vector<std::size_t> changed;
+    const auto numPrev = prevMesh->GetNumberOfCells();
+    auto prevCell = prevMesh->GetCells()->Begin();
+    auto cell = mesh->GetCells()->Begin();
+    for (std::size_t f = 0; cell != mesh->GetCells()->End(); ++cell, ++f) {
+        if (f >= numPrev) {
+            changed.push_back(f);
+            continue;
+        }
+        const auto& prevIds = prevCell->Value()->GetPointIdsContainer();
+        const auto& ids = cell->Value()->GetPointIdsContainer();
+        for (unsigned int i = 0; i < 3; i++) {
+            auto prevId = prevIds.GetElement(i);
+            auto id = ids.GetElement(i);
+            if (prevId != id or not sameUV(prevId, id)) {
+                changed.push_back(f);
+                break;
+            }
+        }
+        ++prevCell;
+    }
+    return changed;
+}
+
 auto vct::GenerateCellMap(
     const ITKMesh::Pointer& mesh,
     const UVMap::Pointer& uvMap,
@@ -218,54 +608,35 @@ auto vct::GenerateCellMap(
     auto cellMap = cv::Mat(height, width, CV_32SC1);
     cellMap = cv::Scalar::all(-1);
 
-    // Create BVH for mesh
-    std::vector<Triangle> triangles;
+    // Get the UV coordinates of each face
+    std::vector<UVTriangle> uvs;
+    uvs.reserve(mesh->GetNumberOfCells());
     for (auto cell = mesh->GetCells()->Begin(); cell != mesh->GetCells()->End();
          ++cell) {
-        // Get the vertex IDs
-        auto a = cell->Value()->GetPointIdsContainer().GetElement(0);
-        auto b = cell->Value()->GetPointIdsContainer().GetElement(1);
-        auto c = cell->Value()->GetPointIdsContainer().GetElement(2);
-
-        auto uvA = uvMap->get(a);
-        auto uvB = uvMap->get(b);
-        auto uvC = uvMap->get(c);
-
-        // Add the face to the BVH tree
-        triangles.emplace_back(
-            Vector3(uvA[0], uvA[1], 0), Vector3(uvB[0], uvB[1], 0),
-            Vector3(uvC[0], uvC[1], 0));
-    }
-    Bvh bvh;
-    bvh::SweepSahBuilder<Bvh> builder(bvh);
-    auto [bboxes, centers] = bvh::compute_bounding_boxes_and_centers(
-        triangles.data(), triangles.size());
-    auto meshBBox =
-        bvh::compute_bounding_boxes_union(bboxes.get(), triangles.size());
-    builder.build(meshBBox, bboxes.get(), centers.get(), triangles.size());
-    Intersector intersector(bvh, triangles.data());
-    Traverser traverser(bvh);
-
-    ITKCell::CellAutoPointer cell;
-    for (const auto [y, x] : range2D(height, width)) {
-        // This pixel's uv coordinate
-        cv::Vec3d uv{0, 0, 0};
-        uv[0] = static_cast<double>(x) / static_cast<double>(width - 1);
-        uv[1] = static_cast<double>(y) / static_cast<double>(height - 1);
-
-        // Intersect a ray with the data structure
-        Ray ray(Vector3(uv[0], uv[1], 0), Vector3(uv[0], uv[1], 1.0), 0.0, 1.0);
-        auto hit = traverser.traverse(ray, intersector);
-        if (not hit) {
-            continue;
+        UVTriangle uv;
+        for (unsigned int i = 0; i < 3; i++) {
+            auto id = cell->Value()->GetPointIdsContainer().GetElement(i);
+            auto uvPt = uvMap->get(id);
+            uv[i] = {uvPt[0], uvPt[1], 0.0};
         }
-
-        // Assign the cell index to the cell map
-        auto intX = static_cast<int>(x);
-        auto intY = static_cast<int>(y);
-        cellMap.at<int32_t>(intY, intX) =
-            static_cast<int>(hit->primitive_index);
+        uvs.push_back(uv);
     }
 
+    // Rasterize the faces. Threads write disjoint tiles of rows.
+    cv::Rect region(0, 0, static_cast<int>(width), static_cast<int>(height));
+    UVRasterizer rasterizer(uvs, width, height, region);
+    auto assign = [&cellMap](size_t y, size_t x, size_t cellId, const auto&) {
+        cellMap.at<int32_t>(static_cast<int>(y), static_cast<int>(x)) =
+            static_cast<int32_t>(cellId);
+    };
+    const auto numTiles = (height + TILE_ROWS - 1) / TILE_ROWS;
+    ParallelChunks(numTiles, 0, [&](size_t begin, size_t end) {
+        for (auto t = begin; t < end; t++) {
+            auto y0 = t * TILE_ROWS;
+            auto y1 = std::min(y0 + TILE_ROWS, height);
+            rasterizer.rasterizeRows(y0, y1, cellMap, assign);
+        }
+    });
+
     return cellMap;
 }
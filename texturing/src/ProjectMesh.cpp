@@ -1,31 +1,17 @@
 #include "vc/texturing/ProjectMesh.hpp"
 
+#include <stdexcept>
 #include <utility>
 
-#include <bvh/bvh.hpp>
-#include <bvh/primitive_intersectors.hpp>
-#include <bvh/ray.hpp>
-#include <bvh/single_ray_traverser.hpp>
-#include <bvh/sweep_sah_builder.hpp>
-#include <bvh/triangle.hpp>
-#include <bvh/vector.hpp>
 #include <vtkOBBTree.h>
-#include <vtkPointData.h>
 
+#include "vc/core/types/FlatMesh.hpp"
 #include "vc/core/util/BarycentricCoordinates.hpp"
-#include "vc/core/util/Iteration.hpp"
+#include "vc/core/util/ThreadPool.hpp"
 #include "vc/meshing/ITK2VTK.hpp"
 
 static constexpr uint8_t MASK_TRUE{255};
 
-using Scalar = double;
-using Vector3 = bvh::Vector3<Scalar>;
-using Triangle = bvh::Triangle<Scalar>;
-using Ray = bvh::Ray<Scalar>;
-using Bvh = bvh::Bvh<Scalar>;
-using Intersector = bvh::ClosestPrimitiveIntersector<Bvh, Triangle>;
-using Traverser = bvh::SingleRayTraverser<Bvh>;
-
 namespace vc = volcart;
 namespace vcm = vc::meshing;
 namespace vct = vc::texturing;
@@ -69,6 +55,15 @@ void vct::ProjectMesh::setUseFirstIntersection(bool useFirstIntersection)
     useFirstIntersection_ = useFirstIntersection;
 }
 
+void vct::ProjectMesh::setBVH(MeshBVH::Pointer bvh) { bvh_ = std::move(bvh); }
+
+void vct::ProjectMesh::setNumThreads(std::size_t n) { numThreads_ = n; }
+
+auto vct::ProjectMesh::numThreads() const -> std::size_t
+{
+    return numThreads_;
+}
+
 auto vct::ProjectMesh::compute() -> vc::PerPixelMap
 {
     if (!inputMesh_) {
@@ -83,17 +78,22 @@ auto vct::ProjectMesh::compute() -> vc::PerPixelMap
         }
     }
 
-    // Convert input mesh to VTK
-    auto vtkMesh = vtkSmartPointer<vtkPolyData>::New();
-    vcm::ITK2VTK(inputMesh_, vtkMesh);
+    // Contiguous copy of the mesh for lookups during projection
+    auto mesh = ToFlatMesh(inputMesh_);
+    if (not mesh.hasNormals()) {
+        mesh.computeNormals(numThreads_);
+    }
+    const auto& vertices = mesh.vertices();
+    const auto& faces = mesh.faces();
+    const auto& normals = mesh.normals();
 
     // Computes the OBB and returns the 3 axes relative to the box
+    auto vtkMesh = vtkSmartPointer<vtkPolyData>::New();
+    vcm::ITK2VTK(inputMesh_, vtkMesh, true);
     cv::Vec3d origin, b0, b1, b2;
     double size[3];
     auto obbTree = vtkSmartPointer<vtkOBBTree>::New();
     obbTree->ComputeOBB(vtkMesh, origin.val, b0.val, b1.val, b2.val, size);
-    obbTree->SetDataSet(vtkMesh);
-    obbTree->BuildLocator();
 
     // Set the marching parameters
     if (mode_ == SampleMode::Rate) {
@@ -116,32 +116,13 @@ auto vct::ProjectMesh::compute() -> vc::PerPixelMap
         b2 = normedY.cross(normedX);
     }
 
-    // Create BVH for mesh
-    std::vector<Triangle> triangles;
-    for (auto cell = inputMesh_->GetCells()->Begin();
-         cell != inputMesh_->GetCells()->End(); ++cell) {
-        auto aIdx = cell.Value()->GetPointIdsContainer()[0];
-        auto bIdx = cell.Value()->GetPointIdsContainer()[1];
-        auto cIdx = cell.Value()->GetPointIdsContainer()[2];
-
-        auto a = inputMesh_->GetPoint(aIdx);
-        auto b = inputMesh_->GetPoint(bIdx);
-        auto c = inputMesh_->GetPoint(cIdx);
-
-        // Add the face to the BVH tree
-        triangles.emplace_back(
-            Vector3(a[0], a[1], a[2]), Vector3(b[0], b[1], b[2]),
-            Vector3(c[0], c[1], c[2]));
+    // Use the shared BVH if one was provided
+    auto bvh = bvh_;
+    if (not bvh) {
+        bvh = MeshBVH::New(mesh, numThreads_);
+    } else if (bvh->numFaces() != faces.size()) {
+        throw std::invalid_argument("BVH does not match the input mesh");
     }
-    Bvh bvh;
-    bvh::SweepSahBuilder<Bvh> builder(bvh);
-    auto [bboxes, centers] = bvh::compute_bounding_boxes_and_centers(
-        triangles.data(), triangles.size());
-    auto meshBBox =
-        bvh::compute_bounding_boxes_union(bboxes.get(), triangles.size());
-    builder.build(meshBBox, bboxes.get(), centers.get(), triangles.size());
-    Intersector intersector(bvh, triangles.data());
-    Traverser traverser(bvh);
 
     auto tfm = tfm_;
     if (useInverse_) {
@@ -149,83 +130,74 @@ auto vct::ProjectMesh::compute() -> vc::PerPixelMap
             tfm_->GetInverseTransform().GetPointer());
     }
 
-    // Loop over every pixel of the image
-    for (const auto uv : vc::range2D(ppmHeight_, ppmWidth_)) {
-        const auto& u = uv.second;
-        const auto& v = uv.first;
-
-        cv::Vec3d uOffset;
-        cv::Vec3d vOffset;
-        if (tfm) {
-            Point p;
-            p[0] = u;
-            p[1] = v;
-            auto pT = tfm->TransformPoint(p);
-            uOffset = pT[0] / textureWidth_ * b0;
-            vOffset = pT[1] / textureHeight_ * b1;
-        } else {
-            // Convert pixel position to offset in mesh's XY space
-            uOffset = u * sampleRateX_ * normedX;
-            vOffset = v * sampleRateY_ * normedY;
-        }
-
-        auto a0 = origin + uOffset + vOffset;
-        auto a1 = b2;
-        if (not useFirstIntersection_) {
-            a0 += b2 * cv::norm(b2);
-            a1 *= -1;
+    // Project every pixel of the image. Rows are split between threads, and
+    // each thread writes only to its own rows.
+    auto projectRows = [&](std::size_t v0, std::size_t v1) {
+        for (auto v = v0; v < v1; v++) {
+            for (std::size_t u = 0; u < static_cast<std::size_t>(ppmWidth_);
+                 u++) {
+                cv::Vec3d uOffset;
+                cv::Vec3d vOffset;
+                if (tfm) {
+                    Point p;
+                    p[0] = static_cast<double>(u);
+                    p[1] = static_cast<double>(v);
+                    auto pT = tfm->TransformPoint(p);
+                    uOffset = pT[0] / textureWidth_ * b0;
+                    vOffset = pT[1] / textureHeight_ * b1;
+                } else {
+                    // Convert pixel position to offset in mesh's XY space
+                    uOffset = u * sampleRateX_ * normedX;
+                    vOffset = v * sampleRateY_ * normedY;
+                }
+
+                auto a0 = origin + uOffset + vOffset;
+                auto a1 = b2;
+                if (not useFirstIntersection_) {
+                    a0 += b2 * cv::norm(b2);
+                    a1 *= -1;
+                }
+
+                // Intersect a ray with the data structure
+                auto hit = bvh->intersect(a0, a1, 0.0, cv::norm(b2) * 2);
+                if (not hit) {
+                    continue;
+                }
+
+                // Get the 3D positions of each vertex
+                auto cellId = hit->face;
+                const auto& face = faces[cellId];
+                const auto& A = vertices[face[0]];
+                const auto& B = vertices[face[1]];
+                const auto& C = vertices[face[2]];
+
+                // Intersection point UV coords
+                cv::Vec3d bCoord{hit->u, hit->v, 1 - hit->u - hit->v};
+
+                // Get the 3D position of the intersection pt
+                auto xyz = BarycentricToCartesian(bCoord, A, B, C);
+
+                // Interpolate the vertex normal for this point
+                auto bary = CartesianToBarycentric(xyz, A, B, C);
+                auto xyzNorm = BarycentricNormalInterpolation(
+                    bary, normals[face[0]], normals[face[1]],
+                    normals[face[2]]);
+
+                // Assign the cell index to the cell map
+                auto intU = static_cast<int>(u);
+                auto intV = static_cast<int>(v);
+                cellMap.at<int32_t>(intV, intU) = static_cast<int>(cellId);
+
+                // Assign 3D position to the lookup map and update the mask
+                outputPPM_(v, u) =
+                    cv::Vec6d{xyz(0),     xyz(1),     xyz(2),
+                              xyzNorm(0), xyzNorm(1), xyzNorm(2)};
+                mask.at<uint8_t>(intV, intU) = MASK_TRUE;
+            }
         }
-
-        // Intersect a ray with the data structure
-        Vector3 start(a0[0], a0[1], a0[2]);
-        Vector3 dir(a1[0], a1[1], a1[2]);
-        Ray ray(start, dir, 0.0, cv::norm(b2) * 2);
-        auto hit = traverser.traverse(ray, intersector);
-        if (not hit) {
-            continue;
-        }
-
-        // Cell info
-        auto cellId = static_cast<vtkIdType>(hit->primitive_index);
-        auto pointIds = vtkSmartPointer<vtkIdList>::New();
-        vtkMesh->GetCellPoints(cellId, pointIds);
-
-        // Make sure we only have three vertices
-        assert(pointIds->GetNumberOfIds() == 3);
-        auto v_id0 = pointIds->GetId(0);
-        auto v_id1 = pointIds->GetId(1);
-        auto v_id2 = pointIds->GetId(2);
-
-        // Get the 3D positions of each vertex
-        cv::Vec3d A{vtkMesh->GetPoint(v_id0)};
-        cv::Vec3d B{vtkMesh->GetPoint(v_id1)};
-        cv::Vec3d C{vtkMesh->GetPoint(v_id2)};
-
-        // Intersection point UV coords
-        auto inter = hit->intersection;
-        cv::Vec3d bCoord{inter.u, inter.v, 1 - inter.u - inter.v};
-
-        // Get the 3D position of the intersection pt
-        auto xyz = BarycentricToCartesian(bCoord, A, B, C);
-
-        // Interpolate the vertex normal for this point
-        cv::Vec3d n0, n1, n2;
-        auto bary = CartesianToBarycentric(xyz, A, B, C);
-        vtkMesh->GetPointData()->GetNormals()->GetTuple(v_id0, n0.val);
-        vtkMesh->GetPointData()->GetNormals()->GetTuple(v_id1, n1.val);
-        vtkMesh->GetPointData()->GetNormals()->GetTuple(v_id2, n2.val);
-        auto xyzNorm = BarycentricNormalInterpolation(bary, n0, n1, n2);
-
-        // Assign the cell index to the cell map
-        auto intU = static_cast<int>(u);
-        auto intV = static_cast<int>(v);
-        cellMap.at<int32_t>(intV, intU) = static_cast<int>(cellId);
-
-        // Assign 3D position to the lookup map and update the mask
-        outputPPM_(v, u) = cv::Vec6d{xyz(0),     xyz(1),     xyz(2),
-                                     xyzNorm(0), xyzNorm(1), xyzNorm(2)};
-        mask.at<uint8_t>(v, u) = MASK_TRUE;
-    }
+    };
+    ParallelChunks(
+        static_cast<std::size_t>(ppmHeight_), numThreads_, projectRows);
 
     outputPPM_.setMask(mask);
     outputPPM_.setCellMap(cellMap);
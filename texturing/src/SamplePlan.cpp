@@ -0,0 +1,202 @@
+#include "vc/texturing/SamplePlan.hpp"
+
+#include <cmath>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+
+#include "vc/core/types/Exceptions.hpp"
+#include "vc/core/util/FloatComparison.hpp"
+#include "vc/core/util/Iteration.hpp"
+#include "vc/core/util/ThreadPool.hpp"
+
+using namespace volcart;
+using namespace volcart::texturing;
+namespace fs = volcart::filesystem;
+
+///// File format /////
+// All values are stored in native byte order:
+//   PlanHeader
+//   uint64_t pixels[count]: linear pixel index
+//   int32_t bases[count * samplesPerPixel][3]: base voxel (x, y, z)
+//   uint16_t weights[count * samplesPerPixel][3]: quantized weights
+static constexpr std::array<char, 8> PLAN_MAGIC{'V', 'C', 'S', 'P',
+                                                'L', 'A', 'N', '\n'};
+static constexpr uint32_t PLAN_VERSION{1};
+
+namespace
+{
+struct PlanHeader {
+    std::array<char, 8> magic{PLAN_MAGIC};
+    uint32_t version{PLAN_VERSION};
+    uint32_t samplesPerPixel{0};
+    uint64_t width{0};
+    uint64_t height{0};
+    uint64_t count{0};
+};
+
+// Quantize a sample position to its base voxel and trilinear weights
+void Quantize(
+    const cv::Vec3d& p,
+    std::array<int32_t, 3>& base,
+    std::array<uint16_t, 3>& weight)
+{
+    constexpr auto maxBase = double{std::numeric_limits<int32_t>::max() - 1};
+    for (int a = 0; a < 3; a++) {
+        auto b = std::floor(p[a]);
+        if (not std::isfinite(b) or b <= SamplePlan::NO_VOXEL or b > maxBase) {
+            base.fill(SamplePlan::NO_VOXEL);
+            weight.fill(0);
+            return;
+        }
+        auto w = std::round((p[a] - b) * SamplePlan::WEIGHT_SCALE);
+        if (w >= SamplePlan::WEIGHT_SCALE) {
+            b += 1;
+            w = 0;
+        }
+        base[a] = static_cast<int32_t>(b);
+        weight[a] = static_cast<uint16_t>(w);
+    }
+}
+
+template <typename T>
+void WriteArray(std::ofstream& file, const std::vector<T>& v)
+{
+    file.write(
+        reinterpret_cast<const char*>(v.data()),
+        static_cast<std::streamsize>(v.size() * sizeof(T)));
+}
+
+template <typename T>
+void ReadArray(std::ifstream& file, std::vector<T>& v, std::size_t n)
+{
+    v.resize(n);
+    file.read(
+        reinterpret_cast<char*>(v.data()),
+        static_cast<std::streamsize>(n * sizeof(T)));
+}
+}  // namespace
+
+auto SamplePlan::Build(
+    const PerPixelMap& ppm, const LineGenerator& gen, std::size_t numThreads)
+    -> Pointer
+{
+    if (gen.interpolation() != Volume::Interpolation::Trilinear) {
+        throw std::invalid_argument(
+            "Sample plans require trilinear interpolation");
+    }
+    if (AlmostEqual(gen.samplingInterval(), 0.0)) {
+        throw std::domain_error("Sampling interval too small");
+    }
+
+    auto plan = std::make_shared<SamplePlan>();
+    plan->width_ = ppm.width();
+    plan->height_ = ppm.height();
+    plan->samplesPerPixel_ = gen.extents()[0];
+    plan->pixels_ = ppm.getMappingIndices(PerPixelMap::MappingOrder::Slice);
+
+    // Sample positions are generated as in LineGenerator::computeInto()
+    const auto n = plan->samplesPerPixel_;
+    const auto lineStart = gen.lineStart();
+    const auto interval = gen.samplingInterval();
+    plan->bases_.resize(plan->pixels_.size() * n);
+    plan->weights_.resize(plan->pixels_.size() * n);
+    ParallelFor(
+        range(plan->pixels_.size()),
+        [&](auto i) {
+            auto pixel = ppm.getAsPixelMap(plan->pixels_[i]);
+            const cv::Vec3d start = pixel.pos + pixel.normal * lineStart;
+            const cv::Vec3d step = pixel.normal * interval;
+            for (std::size_t s = 0; s < n; s++) {
+                Quantize(
+                    start + step * static_cast<double>(s),
+                    plan->bases_[i * n + s], plan->weights_[i * n + s]);
+            }
+        },
+        numThreads);
+    return plan;
+}
+
+void SamplePlan::gather(const Volume& v, std::size_t i, uint16_t* out) const
+{
+    // Reconstruct the quantized positions. The interpolation kernel then
+    // uses the quantized weights as they are.
+    const auto n = samplesPerPixel_;
+    const auto* bases = bases_.data() + i * n;
+    const auto* weights = weights_.data() + i * n;
+    thread_local std::vector<cv::Vec3d> pts;
+    pts.resize(n);
+    for (std::size_t s = 0; s < n; s++) {
+        for (int a = 0; a < 3; a++) {
+            pts[s][a] = (bases[s][0] == NO_VOXEL)
+                            ? 0
+                            : bases[s][a] + weights[s][a] / WEIGHT_SCALE;
+        }
+    }
+    v.interpolateAt(pts.data(), n, out, Volume::Interpolation::Trilinear);
+    for (std::size_t s = 0; s < n; s++) {
+        if (bases[s][0] == NO_VOXEL) {
+            out[s] = 0;
+        }
+    }
+}
+
+void SamplePlan::Write(const fs::path& path, const SamplePlan& plan)
+{
+    std::ofstream file(path.string(), std::ios::binary);
+    if (not file.is_open()) {
+        throw IOException("Failed to open file for writing: " + path.string());
+    }
+
+    PlanHeader header;
+    header.samplesPerPixel = static_cast<uint32_t>(plan.samplesPerPixel_);
+    header.width = plan.width_;
+    header.height = plan.height_;
+    header.count = plan.pixels_.size();
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    std::vector<uint64_t> pixels(plan.pixels_.begin(), plan.pixels_.end());
+    WriteArray(file, pixels);
+    WriteArray(file, plan.bases_);
+    WriteArray(file, plan.weights_);
+    if (file.fail()) {
+        throw IOException("Failed to write file: " + path.string());
+    }
+}
+
+auto SamplePlan::Read(const fs::path& path) -> Pointer
+{
+    std::ifstream file(path.string(), std::ios::binary);
+    if (not file.is_open()) {
+        throw IOException("Failed to open file: " + path.string());
+    }
+
+    PlanHeader header;
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (not file or header.magic != PLAN_MAGIC or
+        header.version != PLAN_VERSION) {
+        throw IOException("Invalid sample plan file: " + path.string());
+    }
+
+    // Check the file size before allocating
+    auto n = header.count * header.samplesPerPixel;
+    auto expected = sizeof(PlanHeader) + header.count * sizeof(uint64_t) +
+                    n * (3 * sizeof(int32_t) + 3 * sizeof(uint16_t));
+    if (fs::file_size(path) < expected) {
+        throw IOException("Truncated sample plan file: " + path.string());
+    }
+
+    auto plan = std::make_shared<SamplePlan>();
+    plan->width_ = header.width;
+    plan->height_ = header.height;
+    plan->samplesPerPixel_ = header.samplesPerPixel;
+    std::vector<uint64_t> pixels;
+    ReadArray(file, pixels, header.count);
+    plan->pixels_.assign(pixels.begin(), pixels.end());
+    ReadArray(file, plan->bases_, n);
+    ReadArray(file, plan->weights_, n);
+    if (not file) {
+        throw IOException("Failed to read file: " + path.string());
+    }
+    return plan;
+}
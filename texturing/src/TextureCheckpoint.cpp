@@ -0,0 +1,152 @@
+#include "vc/texturing/TextureCheckpoint.hpp"
+
+#include <exception>
+#include <stdexcept>
+
+#include "vc/core/io/TIFFIO.hpp"
+#include "vc/core/types/Metadata.hpp"
+#include "vc/core/util/Logging.hpp"
+
+using namespace volcart;
+using namespace volcart::texturing;
+
+namespace fs = volcart::filesystem;
+namespace tio = volcart::tiffio;
+
+namespace
+{
+// Checkpoint metadata file
+constexpr auto META_FILE = "checkpoint.json";
+
+// Path of checkpoint image i. Temporary files have a ".partial" stem.
+auto ImagePath(const fs::path& dir, std::size_t i, bool partial = false)
+    -> fs::path
+{
+    auto name = "image_" + std::to_string(i);
+    if (partial) {
+        name += ".partial";
+    }
+    return dir / (name + ".tif");
+}
+}  // namespace
+
+TextureCheckpoint::TextureCheckpoint(fs::path dir) : dir_{std::move(dir)} {}
+
+auto TextureCheckpoint::New(fs::path dir) -> Pointer
+{
+    return std::make_shared<TextureCheckpoint>(std::move(dir));
+}
+
+auto TextureCheckpoint::directory() const -> const fs::path& { return dir_; }
+
+void TextureCheckpoint::setInterval(double seconds) { interval_ = seconds; }
+
+auto TextureCheckpoint::interval() const -> double { return interval_; }
+
+void TextureCheckpoint::setKey(std::string key) { key_ = std::move(key); }
+
+auto TextureCheckpoint::key() const -> const std::string& { return key_; }
+
+auto TextureCheckpoint::load(Texture& images, std::size_t numMappings)
+    -> std::size_t
+{
+    const auto metaPath = dir_ / META_FILE;
+    if (not fs::exists(metaPath)) {
+        return 0;
+    }
+
+    // Check that the checkpoint belongs to this run
+    std::size_t done{0};
+    Texture loaded;
+    try {
+        const Metadata meta(metaPath);
+        if (meta.get<std::string>("key") != key_ or
+            meta.get<std::size_t>("mappings") != numMappings or
+            meta.get<std::size_t>("images") != images.size()) {
+            Logger()->warn(
+                "Ignoring checkpoint for a different texture: {}",
+                dir_.string());
+            return 0;
+        }
+        done = meta.get<std::size_t>("done");
+
+        for (std::size_t i = 0; i < images.size(); i++) {
+            loaded.push_back(tio::ReadTIFF(ImagePath(dir_, i)));
+            if (loaded[i].size() != images[i].size() or
+                loaded[i].type() != images[i].type()) {
+                Logger()->warn(
+                    "Ignoring checkpoint with mismatched images: {}",
+                    dir_.string());
+                return 0;
+            }
+        }
+    } catch (const std::exception& e) {
+        Logger()->warn("Ignoring unreadable checkpoint: {}", e.what());
+        return 0;
+    }
+
+    // Copy into the existing images, which may be shared with the caller
+    for (std::size_t i = 0; i < images.size(); i++) {
+        loaded[i].copyTo(images[i]);
+    }
+    last_ = Clock::now();
+    Logger()->info(
+        "Resuming texturing from checkpoint at {} of {} mappings", done,
+        numMappings);
+    return done;
+}
+
+auto TextureCheckpoint::due() const -> bool
+{
+    const std::chrono::duration<double> elapsed = Clock::now() - last_;
+    return elapsed.count() >= interval_;
+}
+
+void TextureCheckpoint::save(
+    const Texture& images, std::size_t done, std::size_t numMappings)
+{
+    fs::create_directories(dir_);
+
+    // Write everything to temporary files first. Renaming the images before
+    // the metadata is safe: the new images are a superset of the textured
+    // pixels recorded by the old metadata.
+    for (std::size_t i = 0; i < images.size(); i++) {
+        tio::WriteTIFF(ImagePath(dir_, i, true), images[i]);
+    }
+    Metadata meta;
+    meta.set("key", key_);
+    meta.set("mappings", numMappings);
+    meta.set("images", images.size());
+    meta.set("done", done);
+    const auto metaPath = dir_ / META_FILE;
+    auto partialMeta = metaPath;
+    partialMeta.replace_extension(".partial.json");
+    meta.save(partialMeta);
+
+    for (std::size_t i = 0; i < images.size(); i++) {
+        fs::rename(ImagePath(dir_, i, true), ImagePath(dir_, i));
+    }
+    fs::rename(partialMeta, metaPath);
+    last_ = Clock::now();
+    Logger()->debug(
+        "Saved texturing checkpoint at {} of {} mappings", done, numMappings);
+}
+
+void TextureCheckpoint::clear()
+{
+    if (not fs::exists(dir_)) {
+        return;
+    }
+    auto metaPath = dir_ / META_FILE;
+    fs::remove(metaPath);
+    fs::remove(metaPath.replace_extension(".partial.json"));
+    for (std::size_t i = 0;; i++) {
+        auto path = ImagePath(dir_, i);
+        auto partial = ImagePath(dir_, i, true);
+        auto removed = fs::remove(path);
+        removed = fs::remove(partial) or removed;
+        if (not removed) {
+            break;
+        }
+    }
+}
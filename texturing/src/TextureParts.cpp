@@ -0,0 +1,238 @@
+#include "vc/texturing/TextureParts.hpp"
+
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+#include "vc/core/io/DeepZoomWriter.hpp"
+#include "vc/core/io/FileExtensionFilter.hpp"
+#include "vc/core/types/Metadata.hpp"
+#include "vc/core/util/ThreadPool.hpp"
+
+using namespace volcart;
+using namespace volcart::texturing;
+
+namespace fs = volcart::filesystem;
+namespace tio = volcart::tiffio;
+
+namespace
+{
+// Descriptor type key
+constexpr auto DESCRIPTOR_TYPE = "texture_part";
+}  // namespace
+
+auto TexturePart::Make(
+    std::size_t width, std::size_t height, std::size_t index, std::size_t count)
+    -> TexturePart
+{
+    if (index >= count) {
+        throw std::invalid_argument(
+            "Part index " + std::to_string(index) + " is not less than the " +
+            "number of parts (" + std::to_string(count) + ")");
+    }
+
+    const auto rows = static_cast<std::size_t>(PART_ROW_MULTIPLE);
+    const auto blocks = (height + rows - 1) / rows;
+    if (blocks < count) {
+        throw std::invalid_argument(
+            "Texture with " + std::to_string(height) + " rows cannot be " +
+            "split into " + std::to_string(count) + " parts");
+    }
+
+    auto first = index * blocks / count;
+    auto last = (index + 1) * blocks / count;
+    auto y0 = first * rows;
+    auto y1 = std::min(last * rows, height);
+
+    TexturePart part;
+    part.index = index;
+    part.count = count;
+    part.width = width;
+    part.height = height;
+    part.region = cv::Rect(
+        0, static_cast<int>(y0), static_cast<int>(width),
+        static_cast<int>(y1 - y0));
+    return part;
+}
+
+auto TexturePart::DescriptorPath(const fs::path& image) -> fs::path
+{
+    auto path = image;
+    path += ".json";
+    return path;
+}
+
+void texturing::WriteTexturePart(const TexturePart& part, const cv::Mat& img)
+{
+    if (not IsFileType(part.image, {"tif", "tiff"})) {
+        throw std::invalid_argument(
+            "Texture part is not a TIFF: " + part.image.string());
+    }
+    if (img.size() != part.region.size()) {
+        throw std::invalid_argument("Image does not match the part's region");
+    }
+
+    tio::WriteTIFF(part.image, img);
+
+    Metadata meta;
+    meta.set("type", std::string(DESCRIPTOR_TYPE));
+    meta.set("index", part.index);
+    meta.set("count", part.count);
+    meta.set("width", part.width);
+    meta.set("height", part.height);
+    meta.set(
+        "region", std::vector<int>{
+                      part.region.x, part.region.y, part.region.width,
+                      part.region.height});
+    meta.set("image", part.image.filename().string());
+    meta.save(TexturePart::DescriptorPath(part.image));
+}
+
+auto texturing::ReadTexturePart(const fs::path& path) -> TexturePart
+{
+    auto descPath =
+        IsFileType(path, {"json"}) ? path : TexturePart::DescriptorPath(path);
+    Metadata meta(descPath);
+    if (not meta.hasKey("type") or
+        meta.get<std::string>("type") != DESCRIPTOR_TYPE) {
+        throw std::runtime_error(
+            "Not a texture part descriptor: " + descPath.string());
+    }
+
+    TexturePart part;
+    part.index = meta.get<std::size_t>("index");
+    part.count = meta.get<std::size_t>("count");
+    part.width = meta.get<std::size_t>("width");
+    part.height = meta.get<std::size_t>("height");
+    auto r = meta.get<std::vector<int>>("region");
+    if (r.size() != 4) {
+        throw std::runtime_error("Invalid region in: " + descPath.string());
+    }
+    part.region = cv::Rect(r[0], r[1], r[2], r[3]);
+    part.image = descPath.parent_path() / meta.get<std::string>("image");
+    return part;
+}
+
+auto texturing::VerifyTextureParts(std::vector<TexturePart> parts)
+    -> std::vector<TexturePart>
+{
+    if (parts.empty()) {
+        throw std::runtime_error("No texture parts");
+    }
+
+    // Every part must belong to the same texture
+    const auto& ref = parts.front();
+    for (const auto& p : parts) {
+        if (p.count != ref.count or p.width != ref.width or
+            p.height != ref.height) {
+            throw std::runtime_error(
+                "Texture parts are from different textures: " +
+                ref.image.string() + ", " + p.image.string());
+        }
+    }
+
+    std::sort(parts.begin(), parts.end(), [](const auto& a, const auto& b) {
+        return a.index < b.index;
+    });
+
+    // Every part must be present exactly once and cover its expected region
+    std::string missing;
+    std::size_t next{0};
+    for (const auto& p : parts) {
+        if (p.index < next) {
+            throw std::runtime_error(
+                "Duplicate texture part " + std::to_string(p.index) + ": " +
+                p.image.string());
+        }
+        for (; next < p.index; next++) {
+            missing += (missing.empty() ? "" : ", ") + std::to_string(next);
+        }
+        next = p.index + 1;
+
+        if (p.index >= p.count) {
+            throw std::runtime_error(
+                "Texture part index out of range: " + p.image.string());
+        }
+        auto expected = TexturePart::Make(p.width, p.height, p.index, p.count);
+        if (p.region != expected.region) {
+            throw std::runtime_error(
+                "Texture part " + std::to_string(p.index) +
+                " does not cover its expected region: " + p.image.string());
+        }
+        if (not fs::exists(p.image)) {
+            throw std::runtime_error(
+                "Texture part image not found: " + p.image.string());
+        }
+    }
+    for (; next < ref.count; next++) {
+        missing += (missing.empty() ? "" : ", ") + std::to_string(next);
+    }
+    if (not missing.empty()) {
+        throw std::runtime_error(
+            "Missing texture parts of " + std::to_string(ref.count) + ": " +
+            missing);
+    }
+
+    return parts;
+}
+
+void texturing::MergeTextureParts(
+    const std::vector<TexturePart>& parts,
+    const fs::path& output,
+    tio::Compression compression,
+    std::size_t numThreads)
+{
+    auto dzi = IsFileType(output, {"dzi"});
+    if (not dzi and not IsFileType(output, {"tif", "tiff"})) {
+        throw std::invalid_argument(
+            "Unsupported merged texture format: " + output.string());
+    }
+
+    auto sorted = VerifyTextureParts(parts);
+    const auto width = static_cast<int>(sorted.front().width);
+    const auto height = static_cast<int>(sorted.front().height);
+    const auto rows = TexturePart::PART_ROW_MULTIPLE;
+    const auto readThreads =
+        numThreads == 0 ? ThreadPool::Global().numThreads() : numThreads;
+
+    // Writers are opened once the first rows show the image type
+    std::unique_ptr<tio::TiledTIFFWriter> tiff;
+    std::unique_ptr<DeepZoomWriter> deepZoom;
+    for (const auto& p : sorted) {
+        for (int r = 0; r < p.region.height; r += rows) {
+            cv::Rect roi(
+                0, r, p.region.width, std::min(rows, p.region.height - r));
+            auto img = tio::ReadTIFF(p.image, roi, readThreads);
+            if (img.size() != roi.size()) {
+                throw std::runtime_error(
+                    "Texture part image does not match its region: " +
+                    p.image.string());
+            }
+
+            if (dzi and not deepZoom) {
+                deepZoom = std::make_unique<DeepZoomWriter>(
+                    output, width, height, img.type(), rows);
+                deepZoom->setNumThreads(numThreads);
+            } else if (not dzi and not tiff) {
+                tiff = std::make_unique<tio::TiledTIFFWriter>(
+                    output, width, height, img.type(), rows, compression);
+                tiff->setNumThreads(numThreads);
+            }
+
+            cv::Point origin(0, p.region.y + r);
+            if (deepZoom) {
+                deepZoom->writeRegion(origin, img);
+            } else {
+                tiff->writeRegion(origin, img);
+            }
+        }
+    }
+
+    if (deepZoom) {
+        deepZoom->close();
+    }
+    if (tiff) {
+        tiff->close();
+    }
+}
@@ -1,16 +1,113 @@
 #include "vc/texturing/ThicknessTexture.hpp"
 
-#include "vc/core/util/Iteration.hpp"
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+#include <vector>
+
+#include "vc/core/util/HashFunctions.hpp"
 
 using namespace volcart;
 using namespace volcart::texturing;
 
 using Texture = ThicknessTexture::Texture;
 
+namespace
+{
+using Voxel = VolumetricMask::Voxel;
+constexpr int BLOCK_SIZE{VolumetricMask::BLOCK_SIZE};
+
+// Chessboard distance, in blocks, from each full mask block to the nearest
+// block which is not full
+using BlockDistanceMap = std::unordered_map<Voxel, int, Vec3iHash>;
+
+// Floor division by the block size, correct for negative coordinates
+auto BlockIndex(int v) -> int
+{
+    return (v >= 0) ? v / BLOCK_SIZE : -((-v + BLOCK_SIZE - 1) / BLOCK_SIZE);
+}
+
+auto BlockDistances(const VolumetricMask& mask) -> BlockDistanceMap
+{
+    // Full blocks start unassigned
+    BlockDistanceMap dist;
+    for (const auto& pos : mask.blockPositions()) {
+        const auto* block = mask.getBlock(pos);
+        if (block->count == VolumetricMask::BLOCK_VOXELS) {
+            dist[pos] = 0;
+        }
+    }
+
+    std::vector<Voxel> offsets;
+    for (int z = -1; z <= 1; z++) {
+        for (int y = -1; y <= 1; y++) {
+            for (int x = -1; x <= 1; x++) {
+                if (x != 0 or y != 0 or z != 0) {
+                    offsets.emplace_back(x, y, z);
+                }
+            }
+        }
+    }
+
+    // Full blocks next to a block which isn't full are at distance 1
+    std::vector<Voxel> frontier;
+    for (auto& [pos, d] : dist) {
+        for (const auto& o : offsets) {
+            if (dist.count(pos + o) == 0) {
+                d = 1;
+                frontier.push_back(pos);
+                break;
+            }
+        }
+    }
+
+    // Grow inward one block at a time
+    for (int d = 2; not frontier.empty(); d++) {
+        std::vector<Voxel> next;
+        for (const auto& pos : frontier) {
+            for (const auto& o : offsets) {
+                auto it = dist.find(pos + o);
+                if (it != dist.end() and it->second == 0) {
+                    it->second = d;
+                    next.push_back(it->first);
+                }
+            }
+        }
+        frontier = std::move(next);
+    }
+    return dist;
+}
+
+// Lower bound on the chessboard distance, in voxels, from the voxel
+// containing p to the nearest voxel outside the mask. Assumes p is in the
+// mask.
+auto DistanceToOut(const BlockDistanceMap& dist, const cv::Vec3d& p) -> int
+{
+    Voxel v{
+        static_cast<int>(std::floor(p[0])), static_cast<int>(std::floor(p[1])),
+        static_cast<int>(std::floor(p[2]))};
+    Voxel b{BlockIndex(v[0]), BlockIndex(v[1]), BlockIndex(v[2])};
+    auto it = dist.find(b);
+    if (it == dist.end()) {
+        return 1;
+    }
+
+    // Distance to the nearest face of this block
+    auto edge = BLOCK_SIZE;
+    for (int i = 0; i < 3; i++) {
+        auto l = v[i] - b[i] * BLOCK_SIZE;
+        edge = std::min({edge, l + 1, BLOCK_SIZE - l});
+    }
+    return (it->second - 1) * BLOCK_SIZE + edge;
+}
+}  // namespace
+
 void ThicknessTexture::setSamplingInterval(double i) { interval_ = i; }
 
 void ThicknessTexture::setNormalizeOutput(bool b) { normalize_ = b; }
 
+void ThicknessTexture::setUseDistanceField(bool b) { useDistance_ = b; }
+
 void ThicknessTexture::setVolumetricMask(const VolumetricMask::Pointer& m)
 {
     mask_ = m;
@@ -26,50 +123,57 @@ auto ThicknessTexture::compute() -> Texture
     // Output image
     cv::Mat image = cv::Mat::zeros(height, width, CV_32FC1);
 
-    // Get the mappings
-    auto mappings = ppm_->getMappings();
+    // Distance field over the mask blocks
+    BlockDistanceMap blockDist;
+    if (useDistance_) {
+        blockDist = BlockDistances(*mask_);
+    }
+
+    // Get the mappings in traversal order
+    const auto& ppm = *ppm_;
+    auto mappings = mapping_indices_();
+
+    // March from pos along dir, returning the last sample in the mask
+    auto march = [&](const cv::Vec3d& pos, const cv::Vec3d& dir) {
+        // Largest per-axis displacement of a single step
+        auto maxComp =
+            std::max({std::abs(dir[0]), std::abs(dir[1]), std::abs(dir[2])});
+        auto stepLen = interval_ * maxComp;
+        cv::Vec3d last{pos};
+        double offset{0};
+        while (true) {
+            // Every voxel closer than d is in the mask. Samples displaced
+            // less than d - 1 from the last sample can't leave the mask.
+            if (not blockDist.empty() and stepLen > 0) {
+                auto d = DistanceToOut(blockDist, last);
+                auto skip = std::floor((d - 2) / stepLen);
+                if (skip >= 1) {
+                    for (auto i = static_cast<std::size_t>(skip); i > 0; i--) {
+                        offset += interval_;
+                    }
+                    last = pos + offset * dir;
+                }
+            }
 
-    // Sort the mappings by Z-value
-    std::sort(
-        mappings.begin(), mappings.end(), [](const auto& lhs, const auto& rhs) {
-            return lhs.pos[2] < rhs.pos[2];
-        });
+            offset += interval_;
+            auto next = pos + offset * dir;
+            if (mask_->isOut(next)) {
+                return last;
+            }
+            last = next;
+        }
+    };
 
     // Iterate through the mappings
     progressStarted();
-    for (const auto it : enumerate(mappings)) {
-        progressUpdated(it.first);
-        const auto& pixel = it.second;
+    parallel_for_(mappings, [&](size_t i) {
+        auto pixel = ppm.getAsPixelMap(mappings[i]);
 
         // Starting voxel must be in mask
         if (mask_->isIn(pixel.pos)) {
-            // Setup bidirectional search
-            bool foundMin{false};
-            bool foundMax{false};
-            cv::Vec3d min{pixel.pos};
-            cv::Vec3d max{pixel.pos};
-            double offset{0};
-
             // Find the edges of the layer from this point
-            while (!foundMin || !foundMax) {
-                // Calculate offset
-                offset += interval_;
-                auto delta = offset * pixel.normal;
-
-                // Check the negative direction
-                if (!foundMin) {
-                    auto neg = pixel.pos - delta;
-                    foundMin = mask_->isOut(neg);
-                    min = (foundMin) ? min : neg;
-                }
-
-                // Check the positive direction
-                if (!foundMax) {
-                    auto pos = pixel.pos + delta;
-                    foundMax = mask_->isOut(pos);
-                    max = (foundMax) ? max : pos;
-                }
-            }
+            auto min = march(pixel.pos, -pixel.normal);
+            auto max = march(pixel.pos, pixel.normal);
 
             // Assign the intensity value at the UV position
             auto x = static_cast<int>(pixel.x);
@@ -84,7 +188,7 @@ auto ThicknessTexture::compute() -> Texture
                 image.at<float>(y, x) = static_cast<float>(dist);
             }
         }
-    }
+    });
     progressComplete();
 
     if (normalize_) {
@@ -94,6 +198,7 @@ auto ThicknessTexture::compute() -> Texture
     // Set output
     result_.push_back(image);
 
+    track_result_();
     return result_;
 }
 
@@ -101,6 +206,11 @@ auto ThicknessTexture::samplingInterval() const -> double { return interval_; }
 
 auto ThicknessTexture::normalizeOutput() const -> bool { return normalize_; }
 
+auto ThicknessTexture::useDistanceField() const -> bool
+{
+    return useDistance_;
+}
+
 auto ThicknessTexture::volumetricMask() const -> VolumetricMask::Pointer
 {
     return mask_;
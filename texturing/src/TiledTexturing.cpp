@@ -0,0 +1,157 @@
+#include "vc/texturing/TiledTexturing.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <string>
+
+using namespace volcart;
+using namespace volcart::texturing;
+
+namespace fs = volcart::filesystem;
+namespace tio = volcart::tiffio;
+
+namespace
+{
+// Tile size of the output TIFFs. Smaller than the texturing tiles so that
+// each texturing tile is compressed in parallel.
+constexpr int TIFF_TILE_SIZE{256};
+
+// Round up to a multiple of m
+auto RoundUp(std::size_t v, std::size_t m) -> std::size_t
+{
+    return ((v + m - 1) / m) * m;
+}
+
+// Output path of image i of n
+auto ImagePath(const fs::path& path, std::size_t i, std::size_t n) -> fs::path
+{
+    if (n == 1) {
+        return path;
+    }
+    auto idx = std::to_string(i);
+    auto width = std::to_string(n - 1).size();
+    idx.insert(0, width - idx.size(), '0');
+    auto out = path;
+    out.replace_filename(
+        path.stem().string() + "_" + idx + path.extension().string());
+    return out;
+}
+}  // namespace
+
+auto TiledTexturing::ppmGenerator() -> PPMGenerator& { return ppmGen_; }
+
+void TiledTexturing::setTexturingAlgorithm(TexturingAlgorithm::Pointer a)
+{
+    algorithm_ = std::move(a);
+}
+
+void TiledTexturing::setTileSize(std::size_t s)
+{
+    tileSize_ = RoundUp(std::max<std::size_t>(s, 1), TILE_MULTIPLE);
+}
+
+void TiledTexturing::setMemoryBudget(std::size_t bytes)
+{
+    tileSize_ = TileSizeForBudget(bytes);
+}
+
+auto TiledTexturing::tileSize() const -> std::size_t { return tileSize_; }
+
+void TiledTexturing::setOutputPath(const fs::path& path)
+{
+    outputPath_ = path;
+}
+
+void TiledTexturing::setCompression(tio::Compression c) { compression_ = c; }
+
+auto TiledTexturing::progressIterations() const -> std::size_t
+{
+    auto tilesX = (ppmGen_.width() + tileSize_ - 1) / tileSize_;
+    auto tilesY = (ppmGen_.height() + tileSize_ - 1) / tileSize_;
+    return tilesX * tilesY;
+}
+
+auto TiledTexturing::TileSizeForBudget(std::size_t bytes) -> std::size_t
+{
+    auto side = static_cast<std::size_t>(
+        std::sqrt(static_cast<double>(bytes / BYTES_PER_PIXEL)));
+    side -= side % TILE_MULTIPLE;
+    return std::max(side, TILE_MULTIPLE);
+}
+
+auto TiledTexturing::compute() -> std::vector<fs::path>
+{
+    if (not algorithm_) {
+        throw std::invalid_argument("Texturing algorithm not set");
+    }
+    if (outputPath_.empty()) {
+        throw std::invalid_argument("Output path not set");
+    }
+
+    const auto width = static_cast<int>(ppmGen_.width());
+    const auto height = static_cast<int>(ppmGen_.height());
+    const auto tile = static_cast<int>(tileSize_);
+    const auto tiffTile = (tile % TIFF_TILE_SIZE == 0) ? TIFF_TILE_SIZE : tile;
+
+    // Writers are opened once the first tile shows the number and type of
+    // the output images
+    std::vector<fs::path> paths;
+    std::vector<int> types;
+    std::vector<std::unique_ptr<tio::TiledTIFFWriter>> writers;
+    std::size_t done{0};
+    progressStarted();
+    for (int y = 0; y < height; y += tile) {
+        for (int x = 0; x < width; x += tile) {
+            cv::Rect region(
+                x, y, std::min(tile, width - x), std::min(tile, height - y));
+
+            // Generate and texture this tile
+            ppmGen_.setRegion(region);
+            algorithm_->setPerPixelMap(ppmGen_.compute());
+            auto texture = algorithm_->compute();
+            algorithm_->setPerPixelMap(nullptr);
+
+            if (writers.empty()) {
+                if (texture.empty()) {
+                    throw std::runtime_error("Texture has no images");
+                }
+                for (std::size_t i = 0; i < texture.size(); i++) {
+                    paths.push_back(
+                        ImagePath(outputPath_, i, texture.size()));
+                    types.push_back(texture[i].type());
+                    writers.push_back(std::make_unique<tio::TiledTIFFWriter>(
+                        paths.back(), width, height, texture[i].type(),
+                        tiffTile, compression_));
+                    writers.back()->setNumThreads(algorithm_->numThreads());
+                }
+            }
+            if (texture.size() != writers.size()) {
+                throw std::runtime_error(
+                    "Texture image count changed between tiles");
+            }
+
+            // Write this tile
+            for (std::size_t i = 0; i < texture.size(); i++) {
+                if (texture[i].type() != types[i]) {
+                    throw std::runtime_error(
+                        "Texture image type changed between tiles");
+                }
+                if (texture[i].size() != region.size()) {
+                    throw std::runtime_error(
+                        "Texture image does not match tile size");
+                }
+                writers[i]->writeRegion(region.tl(), texture[i]);
+            }
+            progressUpdated(++done);
+        }
+    }
+    ppmGen_.setRegion({});
+
+    // Finish writing
+    for (auto& w : writers) {
+        w->close();
+    }
+    progressComplete();
+    return paths;
+}
@@ -0,0 +1,227 @@
+#include "vc/texturing/UVAtlas.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+
+#include "vc/core/util/Logging.hpp"
+
+using namespace volcart;
+using namespace volcart::texturing;
+
+auto texturing::PackRectangles(
+    const std::vector<cv::Vec2d>& sizes, double padding)
+    -> std::vector<cv::Vec2d>
+{
+    // Size of the atlas
+    double area{0};
+    for (const auto& s : sizes) {
+        area += s[0] * s[1];
+    }
+    auto gap = padding * std::sqrt(area);
+    double paddedArea{0};
+    for (const auto& s : sizes) {
+        paddedArea += (s[0] + gap) * (s[1] + gap);
+    }
+    auto atlasWidth = std::sqrt(paddedArea);
+
+    // Place the tallest rectangles first
+    std::vector<std::size_t> order(sizes.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&sizes](auto a, auto b) {
+        return sizes[a][1] > sizes[b][1];
+    });
+
+    std::vector<cv::Vec2d> corners(sizes.size());
+    double x{0};
+    double y{0};
+    double shelfHeight{0};
+    for (auto i : order) {
+        const auto& s = sizes[i];
+        if (x > 0 and x + s[0] > atlasWidth) {
+            x = 0;
+            y += shelfHeight + gap;
+            shelfHeight = 0;
+        }
+        corners[i] = {x, y};
+        x += s[0] + gap;
+        shelfHeight = std::max(shelfHeight, s[1]);
+    }
+    return corners;
+}
+
+auto UVAtlas::addSegment(
+    const ITKMesh::Pointer& mesh, const UVMap::Pointer& uvMap) -> std::size_t
+{
+    segments_.push_back({mesh, uvMap});
+    return segments_.size() - 1;
+}
+
+auto UVAtlas::numSegments() const -> std::size_t { return segments_.size(); }
+
+void UVAtlas::setPadding(double p) { padding_ = p; }
+
+auto UVAtlas::padding() const -> double { return padding_; }
+
+void UVAtlas::compute()
+{
+    if (segments_.empty()) {
+        throw std::invalid_argument("UVAtlas has no segments");
+    }
+
+    // Bounds of the mapped region of each segment, in ratio units
+    std::vector<cv::Vec2d> mins;
+    std::vector<cv::Vec2d> sizes;
+    std::size_t numVerts{0};
+    std::size_t numFaces{0};
+    bool normals{true};
+    for (const auto& seg : segments_) {
+        if (not seg.mesh or not seg.uvMap) {
+            throw std::invalid_argument("UVAtlas segment has no UV map");
+        }
+        auto ratio = seg.uvMap->ratio();
+        cv::Vec2d min{
+            std::numeric_limits<double>::max(),
+            std::numeric_limits<double>::max()};
+        cv::Vec2d max{
+            std::numeric_limits<double>::lowest(),
+            std::numeric_limits<double>::lowest()};
+        const auto n = seg.mesh->GetNumberOfPoints();
+        for (std::size_t v = 0; v < n; v++) {
+            if (not seg.uvMap->contains(v)) {
+                continue;
+            }
+            auto uv = seg.uvMap->get(v, UVMap::Origin::TopLeft);
+            cv::Vec2d pos{uv[0] * ratio.width, uv[1] * ratio.height};
+            for (int d = 0; d < 2; d++) {
+                min[d] = std::min(min[d], pos[d]);
+                max[d] = std::max(max[d], pos[d]);
+            }
+        }
+        if (min[0] > max[0]) {
+            min = max = {0, 0};
+        }
+        mins.push_back(min);
+        sizes.push_back(max - min);
+
+        numVerts += n;
+        numFaces += seg.mesh->GetNumberOfCells();
+        const auto* data = seg.mesh->GetPointData();
+        normals = normals and data != nullptr and data->Size() == n;
+    }
+
+    // Pack the segments and get the size of the atlas
+    auto corners = PackRectangles(sizes, padding_);
+    cv::Vec2d atlas{0, 0};
+    bounds_.clear();
+    for (std::size_t i = 0; i < segments_.size(); i++) {
+        const auto& c = corners[i];
+        const auto& s = sizes[i];
+        bounds_.emplace_back(c[0], c[1], s[0], s[1]);
+        atlas[0] = std::max(atlas[0], c[0] + s[0]);
+        atlas[1] = std::max(atlas[1], c[1] + s[1]);
+    }
+    if (atlas[0] <= 0 or atlas[1] <= 0) {
+        throw std::invalid_argument("UVAtlas segments have an empty UV map");
+    }
+    Logger()->debug(
+        "Packed {} segments into a {}x{} atlas", segments_.size(), atlas[0],
+        atlas[1]);
+
+    // Merge the meshes and UV maps
+    mesh_ = ITKMesh::New();
+    auto points = ITKPointsContainer::New();
+    auto& outPoints = points->CastToSTLContainer();
+    outPoints.reserve(numVerts);
+    auto pointData = ITKMesh::PointDataContainer::New();
+    auto& outData = pointData->CastToSTLContainer();
+    if (normals) {
+        outData.reserve(numVerts);
+    }
+    auto cells = ITKMesh::CellsContainer::New();
+    auto& outCells = cells->CastToSTLContainer();
+    outCells.reserve(numFaces);
+    uvMap_ = UVMap::New();
+    vertexOffsets_.clear();
+    faceOffsets_.clear();
+    for (std::size_t i = 0; i < segments_.size(); i++) {
+        const auto& seg = segments_[i];
+        const auto first = outPoints.size();
+        vertexOffsets_.push_back(first);
+        faceOffsets_.push_back(outCells.size());
+
+        const auto& inPoints = seg.mesh->GetPoints()->CastToSTLConstContainer();
+        outPoints.insert(outPoints.end(), inPoints.begin(), inPoints.end());
+        if (normals) {
+            const auto& inData =
+                seg.mesh->GetPointData()->CastToSTLConstContainer();
+            outData.insert(outData.end(), inData.begin(), inData.end());
+        }
+
+        const auto& inCells = seg.mesh->GetCells()->CastToSTLConstContainer();
+        for (const auto* cell : inCells) {
+            auto* tri = new ITKTriangle;
+            for (unsigned int v = 0; v < 3; v++) {
+                tri->SetPointId(v, first + cell->GetPointIds()[v]);
+            }
+            outCells.push_back(tri);
+        }
+
+        // Move the segment's UVs to its place in the atlas
+        auto ratio = seg.uvMap->ratio();
+        cv::Vec2d offset{bounds_[i].x, bounds_[i].y};
+        for (std::size_t v = 0; v < inPoints.size(); v++) {
+            if (not seg.uvMap->contains(v)) {
+                continue;
+            }
+            auto uv = seg.uvMap->get(v, UVMap::Origin::TopLeft);
+            cv::Vec2d pos{uv[0] * ratio.width, uv[1] * ratio.height};
+            pos = pos - mins[i] + offset;
+            uvMap_->set(
+                first + v, {pos[0] / atlas[0], pos[1] / atlas[1]},
+                UVMap::Origin::TopLeft);
+        }
+    }
+    mesh_->SetPoints(points);
+    if (normals) {
+        mesh_->SetPointData(pointData);
+    }
+    mesh_->SetCells(cells);
+    uvMap_->ratio(atlas[0], atlas[1]);
+}
+
+auto UVAtlas::getMesh() const -> ITKMesh::Pointer { return mesh_; }
+
+auto UVAtlas::getUVMap() const -> UVMap::Pointer { return uvMap_; }
+
+auto UVAtlas::vertexOffset(std::size_t i) const -> std::size_t
+{
+    return vertexOffsets_.at(i);
+}
+
+auto UVAtlas::faceOffset(std::size_t i) const -> std::size_t
+{
+    return faceOffsets_.at(i);
+}
+
+auto UVAtlas::segmentBounds(std::size_t i) const -> cv::Rect2d
+{
+    return bounds_.at(i);
+}
+
+auto UVAtlas::segmentRegion(
+    std::size_t i, std::size_t width, std::size_t height) const -> cv::Rect
+{
+    const auto& b = bounds_.at(i);
+    auto ratio = uvMap_->ratio();
+    auto sx = static_cast<double>(width) / ratio.width;
+    auto sy = static_cast<double>(height) / ratio.height;
+    auto x0 = static_cast<int>(std::floor(b.x * sx));
+    auto y0 = static_cast<int>(std::floor(b.y * sy));
+    auto x1 = static_cast<int>(std::ceil((b.x + b.width) * sx)) + 1;
+    auto y1 = static_cast<int>(std::ceil((b.y + b.height) * sy)) + 1;
+    cv::Rect image(0, 0, static_cast<int>(width), static_cast<int>(height));
+    return cv::Rect(x0, y0, x1 - x0, y1 - y0) & image;
+}
@@ -205,4 +205,122 @@ TEST_F(CreateArchABFLSCMOnlyUVFixture, ArchABFLSCMOnlyUVTest)
         volcart::testing::SmallOrClose(
             _out_Mesh->GetPoint(point)[2], _SavedPoints[point].z);
     }
-}
\ No newline at end of file
+}
+
+TEST(ABF, SeedFromPriorUVMap)
+{
+    volcart::shapes::Arch arch;
+    auto mesh = arch.itkMesh();
+
+    // Initial flattening
+    volcart::texturing::AngleBasedFlattening abf(mesh);
+    abf.compute();
+    auto prior = abf.getUVMap();
+    EXPECT_FALSE(abf.seeded());
+
+    // Re-flatten from the prior UV map
+    abf.setSeedUVMap(prior);
+    abf.compute();
+    auto seeded = abf.getUVMap();
+    EXPECT_TRUE(abf.seeded());
+    EXPECT_EQ(abf.seedChangedFaces(), std::size_t{0});
+    EXPECT_EQ(abf.abfIterations(), std::size_t{0});
+    EXPECT_EQ(seeded->size(), prior->size());
+    EXPECT_NEAR(seeded->ratio().aspect, prior->ratio().aspect, 1e-3);
+}
+
+TEST(ABF, ResolveChangedSeedFaces)
+{
+    volcart::shapes::Arch arch;
+    auto mesh = arch.itkMesh();
+
+    volcart::texturing::AngleBasedFlattening abf(mesh);
+    abf.compute();
+    auto prior = abf.getUVMap();
+
+    // Move one vertex so that the angles of its faces change
+    auto id = mesh->GetNumberOfPoints() / 2;
+    auto pt = mesh->GetPoint(id);
+    pt[1] += 10;
+    mesh->SetPoint(id, pt);
+
+    abf.setSeedUVMap(prior);
+    abf.compute();
+    EXPECT_TRUE(abf.seeded());
+    EXPECT_GT(abf.seedChangedFaces(), std::size_t{0});
+    EXPECT_EQ(abf.getUVMap()->size(), mesh->GetNumberOfPoints());
+}
+
+TEST(ABF, IgnoreStaleSeed)
+{
+    volcart::shapes::Arch arch;
+    auto mesh = arch.itkMesh();
+
+    volcart::texturing::AngleBasedFlattening abf(mesh);
+    abf.compute();
+    auto prior = abf.getUVMap();
+
+    // Stretch the whole mesh so that every face changes
+    for (auto pt = mesh->GetPoints()->Begin(); pt != mesh->GetPoints()->End();
+         ++pt) {
+        pt.Value()[0] *= 3;
+    }
+
+    // A stale seed gives the same result as an unseeded flattening
+    volcart::texturing::AngleBasedFlattening unseeded(mesh);
+    auto expected = unseeded.compute();
+    abf.setSeedUVMap(prior);
+    auto result = abf.compute();
+    EXPECT_FALSE(abf.seeded());
+    ASSERT_EQ(result->GetNumberOfPoints(), expected->GetNumberOfPoints());
+    for (size_t i = 0; i < result->GetNumberOfPoints(); ++i) {
+        EXPECT_NEAR(result->GetPoint(i)[0], expected->GetPoint(i)[0], 1e-6);
+        EXPECT_NEAR(result->GetPoint(i)[2], expected->GetPoint(i)[2], 1e-6);
+    }
+}
+
+TEST(ABF, IgnoreSparseSeed)
+{
+    volcart::shapes::Plane plane;
+    auto mesh = plane.itkMesh();
+
+    // A seed which maps almost none of the faces
+    auto seed = UVMap::New();
+    seed->set(0, {0, 0});
+    seed->set(1, {1, 0});
+
+    volcart::texturing::AngleBasedFlattening abf(mesh);
+    abf.setSeedUVMap(seed);
+    abf.compute();
+    EXPECT_FALSE(abf.seeded());
+    EXPECT_EQ(abf.getUVMap()->size(), mesh->GetNumberOfPoints());
+}
+
+TEST(ABF, LSCMSolvers)
+{
+    using Solver = volcart::texturing::AngleBasedFlattening::Solver;
+    volcart::shapes::Arch arch;
+    auto mesh = arch.itkMesh();
+
+    // Reference solve
+    volcart::texturing::AngleBasedFlattening abf(mesh);
+    abf.setUseABF(false);
+    auto expected = abf.compute();
+
+    for (auto solver : {Solver::SimplicialLDLT, Solver::ConjugateGradient,
+                        Solver::Cholmod}) {
+        if (not volcart::texturing::AngleBasedFlattening::SolverAvailable(
+                solver)) {
+            continue;
+        }
+        abf.setSolver(solver);
+        auto result = abf.compute();
+        ASSERT_EQ(result->GetNumberOfPoints(), expected->GetNumberOfPoints());
+        for (size_t id = 0; id < result->GetNumberOfPoints(); ++id) {
+            EXPECT_NEAR(
+                result->GetPoint(id)[0], expected->GetPoint(id)[0], 1e-4);
+            EXPECT_NEAR(
+                result->GetPoint(id)[2], expected->GetPoint(id)[2], 1e-4);
+        }
+    }
+}
@@ -0,0 +1,124 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <array>
+#include <limits>
+
+#include "vc/core/shapes/Arch.hpp"
+#include "vc/core/shapes/Plane.hpp"
+#include "vc/testing/TestingUtils.hpp"
+#include "vc/texturing/AngleBasedFlattening.hpp"
+#include "vc/texturing/ChartFlattening.hpp"
+
+using namespace volcart;
+using namespace volcart::shapes;
+using namespace volcart::texturing;
+using namespace volcart::testing;
+
+namespace
+{
+// Append the vertices and faces of b to a, offset in 3D
+void AppendMesh(
+    ITKMesh::Pointer& a, const ITKMesh::Pointer& b, double offset)
+{
+    auto base = a->GetNumberOfPoints();
+    for (std::size_t id = 0; id < b->GetNumberOfPoints(); id++) {
+        auto pt = b->GetPoint(id);
+        pt[0] += offset;
+        a->SetPoint(base + id, pt);
+    }
+    auto faceBase = a->GetNumberOfCells();
+    ITKCell::CellAutoPointer cell;
+    for (auto c = b->GetCells()->Begin(); c != b->GetCells()->End(); ++c) {
+        cell.TakeOwnership(new ITKTriangle);
+        const auto& ids = c.Value()->GetPointIdsContainer();
+        for (unsigned int i = 0; i < 3; i++) {
+            cell->SetPointId(i, base + ids[i]);
+        }
+        a->SetCell(faceBase++, cell);
+    }
+}
+
+// UV bounds of the vertices [begin, end) of a flat mesh: uMin, uMax, vMin, vMax
+auto Bounds(const ITKMesh::Pointer& flat, std::size_t begin, std::size_t end)
+    -> std::array<double, 4>
+{
+    std::array<double, 4> b{
+        std::numeric_limits<double>::max(),
+        std::numeric_limits<double>::lowest(),
+        std::numeric_limits<double>::max(),
+        std::numeric_limits<double>::lowest()};
+    for (auto id = begin; id < end; id++) {
+        auto pt = flat->GetPoint(id);
+        b[0] = std::min(b[0], pt[0]);
+        b[1] = std::max(b[1], pt[0]);
+        b[2] = std::min(b[2], pt[2]);
+        b[3] = std::max(b[3], pt[2]);
+    }
+    return b;
+}
+}  // namespace
+
+TEST(ChartFlattening, SingleChartMatchesABF)
+{
+    Plane plane;
+    auto mesh = plane.itkMesh();
+
+    AngleBasedFlattening abf(mesh);
+    auto expected = abf.compute();
+
+    ChartFlattening flatten(mesh);
+    auto result = flatten.compute();
+    EXPECT_EQ(flatten.numCharts(), 1);
+    ASSERT_EQ(result->GetNumberOfPoints(), expected->GetNumberOfPoints());
+    for (std::size_t id = 0; id < result->GetNumberOfPoints(); id++) {
+        SmallOrClose(result->GetPoint(id)[0], expected->GetPoint(id)[0]);
+        SmallOrClose(result->GetPoint(id)[2], expected->GetPoint(id)[2]);
+    }
+}
+
+TEST(ChartFlattening, PackDisconnectedCharts)
+{
+    // Three disconnected components
+    Plane plane(10, 10);
+    Arch arch(20, 20);
+    auto mesh = ITKMesh::New();
+    AppendMesh(mesh, plane.itkMesh(), 0);
+    auto numPlane = mesh->GetNumberOfPoints();
+    AppendMesh(mesh, arch.itkMesh(), 100);
+    auto numArch = mesh->GetNumberOfPoints();
+    AppendMesh(mesh, plane.itkMesh(), 200);
+
+    ChartFlattening flatten(mesh);
+    auto result = flatten.compute();
+    ASSERT_EQ(flatten.numCharts(), 3);
+    ASSERT_EQ(flatten.faceCharts().size(), mesh->GetNumberOfCells());
+    EXPECT_EQ(flatten.faceCharts().front(), 0);
+    EXPECT_EQ(flatten.faceCharts().back(), 2);
+
+    // Every chart keeps the shape of a direct flattening
+    AngleBasedFlattening abf(plane.itkMesh());
+    auto expected = abf.compute();
+    auto eb = Bounds(expected, 0, expected->GetNumberOfPoints());
+    auto pb = Bounds(result, 0, numPlane);
+    SmallOrClose(pb[1] - pb[0], eb[1] - eb[0]);
+    SmallOrClose(pb[3] - pb[2], eb[3] - eb[2]);
+
+    // Charts don't overlap
+    std::array<std::array<double, 4>, 3> bounds{
+        Bounds(result, 0, numPlane), Bounds(result, numPlane, numArch),
+        Bounds(result, numArch, result->GetNumberOfPoints())};
+    for (std::size_t a = 0; a < 3; a++) {
+        for (auto b = a + 1; b < 3; b++) {
+            auto overlapU = bounds[a][0] < bounds[b][1] and
+                            bounds[b][0] < bounds[a][1];
+            auto overlapV = bounds[a][2] < bounds[b][3] and
+                            bounds[b][2] < bounds[a][3];
+            EXPECT_FALSE(overlapU and overlapV);
+        }
+    }
+
+    // UV map covers every vertex
+    auto uvMap = flatten.getUVMap();
+    EXPECT_EQ(uvMap->size(), mesh->GetNumberOfPoints());
+}
@@ -0,0 +1,71 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+#include <opencv2/core.hpp>
+
+#include "vc/texturing/CompositeTexture.hpp"
+
+using namespace volcart;
+using namespace volcart::texturing;
+
+using Filter = CompositeTexture::Filter;
+
+namespace
+{
+// Reference implementation of the filters using a fully sorted copy
+auto SortedFilter(Neighborhood n, Filter f) -> uint16_t
+{
+    std::sort(n.begin(), n.end());
+    auto mean = [](auto b, auto e) {
+        auto sum = std::accumulate(b, e, double{0});
+        return static_cast<uint16_t>(std::round(sum / std::distance(b, e)));
+    };
+    switch (f) {
+        case Filter::Minimum:
+            return n(0);
+        case Filter::Maximum:
+            return n(n.size() - 1);
+        case Filter::Median:
+            return n(n.size() / 2);
+        case Filter::Mean:
+            return mean(n.begin(), n.end());
+        case Filter::MedianAverage: {
+            auto count = static_cast<size_t>(std::ceil(n.size() * 0.7));
+            auto offset =
+                static_cast<size_t>(std::floor((n.size() - count) / 2.0));
+            return mean(n.begin() + offset, n.begin() + offset + count);
+        }
+    }
+    return 0;
+}
+}  // namespace
+
+TEST(CompositeTexture, FilterNeighborhoodMatchesSort)
+{
+    // Covers the stack buffer and per-thread buffer neighborhood lengths
+    cv::RNG rng(1234);
+    for (std::size_t size = 1; size <= 130; size++) {
+        Neighborhood n(1, size);
+        for (auto& v : n) {
+            v = static_cast<uint16_t>(rng.uniform(0, 65536));
+        }
+        const auto original = n;
+        for (auto f :
+             {Filter::Minimum, Filter::Maximum, Filter::Median, Filter::Mean,
+              Filter::MedianAverage}) {
+            EXPECT_EQ(
+                CompositeTexture::FilterNeighborhood(n, f),
+                SortedFilter(n, f));
+        }
+        EXPECT_TRUE(std::equal(n.begin(), n.end(), original.begin()));
+    }
+}
+
+TEST(CompositeTexture, FilterEmptyNeighborhood)
+{
+    Neighborhood n(1);
+    EXPECT_EQ(CompositeTexture::FilterNeighborhood(n, Filter::Median), 0);
+}
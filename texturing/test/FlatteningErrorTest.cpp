@@ -65,6 +65,31 @@ TEST(FlatteningError, MetricsScale)
     EXPECT_THAT(metrics.faceLInf, Each(DoubleNear(expected, 1e-7)));
 }
 
+TEST(FlatteningError, MetricsThreadIndependent)
+{
+    // Enough faces for several reduction blocks
+    Plane plane(100, 100);
+    auto mesh3D = plane.itkMesh();
+
+    // Jitter the flattened vertices so every face has a different stretch
+    auto mesh2D = plane.itkMesh();
+    cv::RNG rng(1234);
+    for (auto pt = mesh2D->GetPoints()->Begin();
+         pt != mesh2D->GetPoints()->End(); ++pt) {
+        pt.Value()[0] += rng.uniform(-0.2, 0.2);
+        pt.Value()[2] += rng.uniform(-0.2, 0.2);
+    }
+
+    auto expected = LStretch(mesh3D, mesh2D, 1);
+    for (auto threads : {2, 3, 8}) {
+        auto metrics = LStretch(mesh3D, mesh2D, threads);
+        EXPECT_EQ(metrics.l2, expected.l2);
+        EXPECT_EQ(metrics.lInf, expected.lInf);
+        EXPECT_EQ(metrics.faceL2, expected.faceL2);
+        EXPECT_EQ(metrics.faceLInf, expected.faceLInf);
+    }
+}
+
 int main(int argc, char** argv)
 {
     ::testing::InitGoogleTest(&argc, argv);
@@ -0,0 +1,146 @@
+#include <gtest/gtest.h>
+
+#include <iostream>
+
+#include <opencv2/core.hpp>
+
+#include "vc/core/filesystem.hpp"
+#include "vc/core/neighborhood/LineGenerator.hpp"
+#include "vc/core/types/PerPixelMap.hpp"
+#include "vc/core/types/Volume.hpp"
+#include "vc/texturing/CompositeTexture.hpp"
+#include "vc/texturing/GPULineSampling.hpp"
+#include "vc/texturing/IntegralTexture.hpp"
+
+using namespace volcart;
+using namespace volcart::texturing;
+namespace fs = volcart::filesystem;
+
+using Filter = CompositeTexture::Filter;
+using WeightMethod = IntegralTexture::WeightMethod;
+
+namespace
+{
+class GPULineSamplingFixture : public ::testing::Test
+{
+public:
+    void SetUp() override
+    {
+        // Random volume
+        const fs::path volPath{"vc_texturing_GPULineSampling_volume"};
+        fs::remove_all(volPath);
+        fs::create_directory(volPath);
+        vol_ = Volume::New(volPath, "GPULineSampling", "GPULineSampling");
+        vol_->setSliceWidth(40);
+        vol_->setSliceHeight(40);
+        vol_->setNumberOfSlices(40);
+        vol_->saveMetadata();
+        cv::RNG rng(1234);
+        for (int z = 0; z < 40; z++) {
+            cv::Mat slice(40, 40, CV_16UC1);
+            rng.fill(slice, cv::RNG::UNIFORM, 0, 65536);
+            vol_->setSliceData(z, slice);
+        }
+
+        // Mappings with random positions and normals. Some lines leave the
+        // volume.
+        ppm_ = PerPixelMap::New(30, 35);
+        for (size_t y = 0; y < ppm_->height(); y++) {
+            for (size_t x = 0; x < ppm_->width(); x++) {
+                auto n = cv::normalize(cv::Vec3d{
+                    rng.uniform(-1., 1.), rng.uniform(-1., 1.),
+                    rng.uniform(-1., 1.)});
+                (*ppm_)(y, x) = {
+                    rng.uniform(2., 38.), rng.uniform(2., 38.),
+                    rng.uniform(2., 38.), n[0], n[1], n[2]};
+            }
+        }
+
+        line_ = LineGenerator::New();
+        line_->setSamplingRadius(5);
+        line_->setSamplingInterval(0.5);
+    }
+
+    // Whether the GPU backend can be tested on this machine
+    static auto HasGPU() -> bool
+    {
+        if (not gpu::Available()) {
+            std::cout << "No CUDA device available. Skipping." << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    auto composite(Filter f, bool useGPU) -> cv::Mat
+    {
+        CompositeTexture t;
+        t.setVolume(vol_);
+        t.setPerPixelMap(ppm_);
+        t.setGenerator(line_);
+        t.setFilter(f);
+        t.setUseGPU(useGPU);
+        return t.compute().at(0);
+    }
+
+    auto integral(WeightMethod w, bool useGPU) -> cv::Mat
+    {
+        IntegralTexture t;
+        t.setVolume(vol_);
+        t.setPerPixelMap(ppm_);
+        t.setGenerator(line_);
+        t.setWeightMethod(w);
+        t.setClampValuesToMax(true);
+        t.setClampMax(50000);
+        t.setUseGPU(useGPU);
+        return t.compute().at(0);
+    }
+
+    Volume::Pointer vol_;
+    PerPixelMap::Pointer ppm_;
+    LineGenerator::Pointer line_;
+};
+}  // namespace
+
+TEST_F(GPULineSamplingFixture, SupportsLineGenerator)
+{
+    if (not HasGPU()) {
+        return;
+    }
+    gpu::LineParams line;
+    ASSERT_TRUE(gpu::GetLineParams(*line_, line));
+    EXPECT_EQ(line.count, line_->size());
+    EXPECT_DOUBLE_EQ(line.interval, 0.5);
+}
+
+TEST_F(GPULineSamplingFixture, CompositeMatchesCPU)
+{
+    if (not HasGPU()) {
+        return;
+    }
+    for (auto f :
+         {Filter::Minimum, Filter::Maximum, Filter::Median, Filter::Mean,
+          Filter::MedianAverage}) {
+        auto cpu = composite(f, false);
+        auto gpu = composite(f, true);
+        ASSERT_EQ(cpu.size(), gpu.size());
+        ASSERT_EQ(cpu.type(), gpu.type());
+
+        // Interpolation matches, so intensities differ by at most rounding
+        EXPECT_LE(cv::norm(cpu, gpu, cv::NORM_INF), 1);
+    }
+}
+
+TEST_F(GPULineSamplingFixture, IntegralMatchesCPU)
+{
+    if (not HasGPU()) {
+        return;
+    }
+    for (auto w :
+         {WeightMethod::None, WeightMethod::Linear, WeightMethod::ExpoDiff}) {
+        auto cpu = integral(w, false);
+        auto gpu = integral(w, true);
+        ASSERT_EQ(cpu.size(), gpu.size());
+        ASSERT_EQ(cpu.type(), gpu.type());
+        EXPECT_LE(cv::norm(cpu, gpu, cv::NORM_INF), 1e-5);
+    }
+}
@@ -0,0 +1,58 @@
+#include <gtest/gtest.h>
+
+#include "vc/core/shapes/Arch.hpp"
+#include "vc/core/shapes/Plane.hpp"
+#include "vc/testing/TestingUtils.hpp"
+#include "vc/texturing/AngleBasedFlattening.hpp"
+#include "vc/texturing/FlatteningError.hpp"
+#include "vc/texturing/HierarchicalFlattening.hpp"
+
+using namespace volcart;
+using namespace volcart::shapes;
+using namespace volcart::texturing;
+using namespace volcart::testing;
+
+TEST(HierarchicalFlattening, SmallMeshFlattenedDirectly)
+{
+    Plane plane;
+    auto mesh = plane.itkMesh();
+
+    // Reference flattening
+    AngleBasedFlattening abf(mesh);
+    auto expected = abf.compute();
+
+    // Mesh is smaller than the proxy
+    HierarchicalFlattening flatten(mesh);
+    auto result = flatten.compute();
+    EXPECT_EQ(flatten.getProxyMesh(), mesh);
+    ASSERT_EQ(result->GetNumberOfPoints(), expected->GetNumberOfPoints());
+    for (std::size_t id = 0; id < result->GetNumberOfPoints(); id++) {
+        SmallOrClose(result->GetPoint(id)[0], expected->GetPoint(id)[0]);
+        SmallOrClose(result->GetPoint(id)[2], expected->GetPoint(id)[2]);
+    }
+}
+
+TEST(HierarchicalFlattening, FlattenFromProxy)
+{
+    Arch arch(40, 40);
+    auto mesh = arch.itkMesh();
+
+    HierarchicalFlattening flatten(mesh);
+    flatten.setProxyVertices(400);
+    auto result = flatten.compute();
+
+    // Proxy is smaller, but the output covers the full mesh
+    EXPECT_LT(
+        flatten.getProxyMesh()->GetNumberOfPoints(), mesh->GetNumberOfPoints());
+    EXPECT_EQ(result->GetNumberOfPoints(), mesh->GetNumberOfPoints());
+    EXPECT_EQ(result->GetNumberOfCells(), mesh->GetNumberOfCells());
+
+    // UV map covers every vertex
+    auto uvMap = flatten.getUVMap();
+    EXPECT_EQ(uvMap->size(), mesh->GetNumberOfPoints());
+
+    // Arch is developable, so the interpolated flattening should have little
+    // distortion
+    auto metrics = LStretch(mesh, result);
+    EXPECT_LT(metrics.l2, 1.1);
+}
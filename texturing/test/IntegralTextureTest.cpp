@@ -0,0 +1,296 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <numeric>
+#include <string>
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+#include "vc/core/filesystem.hpp"
+#include "vc/core/neighborhood/CuboidGenerator.hpp"
+#include "vc/core/neighborhood/LineGenerator.hpp"
+#include "vc/core/types/PerPixelMap.hpp"
+#include "vc/core/types/Volume.hpp"
+#include "vc/texturing/IntegralTexture.hpp"
+
+using namespace volcart;
+using namespace volcart::texturing;
+namespace fs = volcart::filesystem;
+
+using WeightMethod = IntegralTexture::WeightMethod;
+using WeightDirection = IntegralTexture::LinearWeightDirection;
+using BaseMethod = IntegralTexture::ExpoDiffBaseMethod;
+
+namespace
+{
+// Settings of one IntegralTexture run
+struct Settings {
+    WeightMethod weight{WeightMethod::None};
+    bool clamp{false};
+    uint16_t clampMax{std::numeric_limits<uint16_t>::max()};
+    WeightDirection direction{WeightDirection::Positive};
+    int exponent{2};
+    BaseMethod base{BaseMethod::Mean};
+    double manualBase{0};
+    bool suppress{true};
+};
+
+// Mapped intensity of every mapped pixel, in raster order
+auto SurfaceValues(const Volume::Pointer& vol, const PerPixelMap& ppm)
+    -> std::vector<uint16_t>
+{
+    std::vector<uint16_t> values;
+    for (const auto& idx : ppm.getMappingIndices()) {
+        values.push_back(vol->interpolateAt(ppm.getAsPixelMap(idx).pos));
+    }
+    return values;
+}
+
+// Running mean of the surface intensities
+auto ReferenceMean(const std::vector<uint16_t>& values) -> double
+{
+    double mean{0};
+    std::size_t n{0};
+    for (const auto& v : values) {
+        mean += (v - mean) / static_cast<double>(++n);
+    }
+    return mean;
+}
+
+// Most frequent surface intensity. Ties go to the lowest value.
+auto ReferenceMode(const std::vector<uint16_t>& values) -> double
+{
+    std::map<uint16_t, int> histogram;
+    for (const auto& v : values) {
+        histogram[v]++;
+    }
+    auto mode = histogram.begin();
+    for (auto it = histogram.begin(); it != histogram.end(); ++it) {
+        if (it->second > mode->second) {
+            mode = it;
+        }
+    }
+    return mode->first;
+}
+
+// Straightforward implementation of each weighting: clamp, weight every
+// sample, then sum in order
+auto Reference(
+    const Volume::Pointer& vol,
+    const PerPixelMap& ppm,
+    NeighborhoodGenerator& gen,
+    const Settings& s) -> cv::Mat
+{
+    double base{s.manualBase};
+    if (s.base == BaseMethod::Mean) {
+        base = ReferenceMean(SurfaceValues(vol, ppm));
+    } else if (s.base == BaseMethod::Mode) {
+        base = ReferenceMode(SurfaceValues(vol, ppm));
+    }
+
+    cv::Mat image = cv::Mat::zeros(
+        static_cast<int>(ppm.height()), static_cast<int>(ppm.width()),
+        CV_32FC1);
+    for (const auto& idx : ppm.getMappingIndices()) {
+        auto pixel = ppm.getAsPixelMap(idx);
+        auto n = gen.compute(vol, pixel.pos, {pixel.normal});
+        std::vector<double> values(n.begin(), n.end());
+        if (s.clamp) {
+            for (auto& v : values) {
+                v = std::min(v, static_cast<double>(s.clampMax));
+            }
+        }
+
+        if (s.weight == WeightMethod::Linear) {
+            auto extent = static_cast<double>(gen.extents()[0]);
+            auto positive = s.direction == WeightDirection::Positive;
+            double w = positive ? 0.0 : 1.0;
+            double step = positive ? 1.0 / extent : -1.0 / extent;
+            for (auto& v : values) {
+                v *= w;
+                w += step;
+            }
+        } else if (s.weight == WeightMethod::ExpoDiff) {
+            for (auto& v : values) {
+                if (s.suppress and base >= v) {
+                    v = 0;
+                } else {
+                    v = std::pow(std::abs(v - base), s.exponent);
+                }
+            }
+        }
+
+        auto sum = std::accumulate(values.begin(), values.end(), 0.0);
+        image.at<float>(static_cast<int>(pixel.y), static_cast<int>(pixel.x)) =
+            static_cast<float>(sum);
+    }
+    cv::normalize(image, image, 0.0, 1.0, cv::NORM_MINMAX);
+    return image;
+}
+
+class IntegralTextureFixture : public ::testing::Test
+{
+public:
+    void SetUp() override
+    {
+        // Random volume with a narrow intensity range, so that the surface
+        // intensities have a distinct mode
+        const fs::path volPath{"vc_texturing_IntegralTexture_volume"};
+        fs::remove_all(volPath);
+        fs::create_directory(volPath);
+        vol_ = Volume::New(volPath, "IntegralTexture", "IntegralTexture");
+        vol_->setSliceWidth(30);
+        vol_->setSliceHeight(30);
+        vol_->setNumberOfSlices(30);
+        vol_->saveMetadata();
+        cv::RNG rng(1234);
+        for (int z = 0; z < 30; z++) {
+            cv::Mat slice(30, 30, CV_16UC1);
+            rng.fill(slice, cv::RNG::UNIFORM, 1000, 1200);
+            vol_->setSliceData(z, slice);
+        }
+
+        // Pixels in the middle of the volume with random normals. Every
+        // fourth pixel has no mapping.
+        ppm_ = PerPixelMap::New(14, 11);
+        cv::Mat mask = cv::Mat::zeros(14, 11, CV_8UC1);
+        for (size_t y = 0; y < ppm_->height(); y++) {
+            for (size_t x = 0; x < ppm_->width(); x++) {
+                auto n = cv::normalize(cv::Vec3d{
+                    rng.uniform(-1., 1.), rng.uniform(-1., 1.),
+                    rng.uniform(-1., 1.)});
+                (*ppm_)(y, x) = {
+                    rng.uniform(8., 22.), rng.uniform(8., 22.),
+                    rng.uniform(8., 22.), n[0], n[1], n[2]};
+                if ((x + y) % 4 != 0) {
+                    mask.at<uint8_t>(y, x) = 255;
+                }
+            }
+        }
+        ppm_->setMask(mask);
+
+        // 17 samples, so the weighted sum has a partial set of lanes
+        line_ = LineGenerator::New();
+        line_->setSamplingRadius(4);
+        line_->setSamplingInterval(0.5);
+        line_->setSamplingDirection(Direction::Bidirectional);
+
+        // 27 samples, for weights over a multidimensional neighborhood
+        cuboid_ = CuboidGenerator::New();
+        cuboid_->setSamplingRadius(1, 1, 1);
+    }
+
+    auto integral(NeighborhoodGenerator::Pointer gen, const Settings& s)
+        -> cv::Mat
+    {
+        IntegralTexture t;
+        t.setVolume(vol_);
+        t.setPerPixelMap(ppm_);
+        t.setGenerator(std::move(gen));
+        t.setWeightMethod(s.weight);
+        t.setClampValuesToMax(s.clamp);
+        t.setClampMax(s.clampMax);
+        t.setLinearWeightDirection(s.direction);
+        t.setExponentialDiffExponent(s.exponent);
+        t.setExponentialDiffBaseMethod(s.base);
+        t.setExponentialDiffBaseValue(s.manualBase);
+        t.setExponentialDiffSuppressBelowBase(s.suppress);
+        return t.compute().at(0);
+    }
+
+    // Compare with the reference for both generators
+    void expectMatches(const Settings& s, const std::string& name)
+    {
+        for (const auto& gen :
+             {NeighborhoodGenerator::Pointer{line_},
+              NeighborhoodGenerator::Pointer{cuboid_}}) {
+            auto result = integral(gen, s);
+            auto expected = Reference(vol_, *ppm_, *gen, s);
+            ASSERT_EQ(result.size(), expected.size()) << name;
+            ASSERT_EQ(result.type(), expected.type()) << name;
+
+            // Sums are accumulated in a different order
+            EXPECT_LE(cv::norm(result, expected, cv::NORM_INF), 1e-5)
+                << name << ", " << gen->size() << " samples";
+        }
+    }
+
+    Volume::Pointer vol_;
+    PerPixelMap::Pointer ppm_;
+    LineGenerator::Pointer line_;
+    CuboidGenerator::Pointer cuboid_;
+};
+}  // namespace
+
+TEST_F(IntegralTextureFixture, NoWeighting)
+{
+    Settings s;
+    expectMatches(s, "None");
+    s.clamp = true;
+    s.clampMax = 1100;
+    expectMatches(s, "None, clamped");
+}
+
+TEST_F(IntegralTextureFixture, LinearWeighting)
+{
+    Settings s;
+    s.weight = WeightMethod::Linear;
+    for (auto d : {WeightDirection::Positive, WeightDirection::Negative}) {
+        s.direction = d;
+        s.clamp = false;
+        expectMatches(s, "Linear");
+        s.clamp = true;
+        s.clampMax = 1100;
+        expectMatches(s, "Linear, clamped");
+    }
+}
+
+TEST_F(IntegralTextureFixture, ExpoDiffLookupTable)
+{
+    Settings s;
+    s.weight = WeightMethod::ExpoDiff;
+    s.base = BaseMethod::Manual;
+    s.manualBase = 1090.5;
+    for (auto exponent : {1, 2, 3}) {
+        s.exponent = exponent;
+        for (auto suppress : {true, false}) {
+            s.suppress = suppress;
+            s.clamp = false;
+            expectMatches(s, "ExpoDiff, manual base");
+            s.clamp = true;
+            s.clampMax = 1150;
+            expectMatches(s, "ExpoDiff, manual base, clamped");
+        }
+    }
+}
+
+TEST_F(IntegralTextureFixture, ExpoDiffHistogramBase)
+{
+    Settings s;
+    s.weight = WeightMethod::ExpoDiff;
+    for (auto base : {BaseMethod::Mean, BaseMethod::Mode}) {
+        s.base = base;
+        for (auto suppress : {true, false}) {
+            s.suppress = suppress;
+            expectMatches(s, "ExpoDiff, surface base");
+        }
+    }
+
+    // The histogram base equals the base of the surface intensities
+    auto values = SurfaceValues(vol_, *ppm_);
+    for (const auto& [method, value] :
+         {std::make_pair(BaseMethod::Mean, ReferenceMean(values)),
+          std::make_pair(BaseMethod::Mode, ReferenceMode(values))}) {
+        s.base = method;
+        auto fromHistogram = integral(line_, s);
+        s.base = BaseMethod::Manual;
+        s.manualBase = value;
+        auto manual = integral(line_, s);
+        EXPECT_LE(cv::norm(fromHistogram, manual, cv::NORM_INF), 1e-5);
+    }
+}
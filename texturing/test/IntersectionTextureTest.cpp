@@ -0,0 +1,85 @@
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include <opencv2/core.hpp>
+
+#include "vc/core/filesystem.hpp"
+#include "vc/core/types/PerPixelMap.hpp"
+#include "vc/core/types/Volume.hpp"
+#include "vc/texturing/IntersectionTexture.hpp"
+
+using namespace volcart;
+using namespace volcart::texturing;
+namespace fs = volcart::filesystem;
+
+namespace
+{
+auto RandomVolume(const fs::path& path) -> Volume::Pointer
+{
+    fs::remove_all(path);
+    fs::create_directory(path);
+    auto vol = Volume::New(path, "Intersection", "Intersection");
+    vol->setSliceWidth(30);
+    vol->setSliceHeight(30);
+    vol->setNumberOfSlices(30);
+    vol->saveMetadata();
+    cv::RNG rng(1234);
+    for (int z = 0; z < 30; z++) {
+        cv::Mat slice(30, 30, CV_16UC1);
+        rng.fill(slice, cv::RNG::UNIFORM, 0, 65536);
+        vol->setSliceData(z, slice);
+    }
+    return vol;
+}
+
+// PPM with more mappings than a slab and a few unmapped pixels
+auto RandomPPM() -> PerPixelMap::Pointer
+{
+    cv::RNG rng(5678);
+    auto ppm = PerPixelMap::New(40, 60);
+    cv::Mat mask = cv::Mat::ones(40, 60, CV_8UC1) * 255;
+    for (int y = 0; y < 40; y++) {
+        for (int x = 0; x < 60; x++) {
+            if ((x + y) % 17 == 0) {
+                mask.at<uint8_t>(y, x) = 0;
+                continue;
+            }
+            (*ppm)(y, x) = {
+                rng.uniform(0., 29.), rng.uniform(0., 29.),
+                rng.uniform(0., 29.), 0, 0, 1};
+        }
+    }
+    ppm->setMask(mask);
+    return ppm;
+}
+}  // namespace
+
+TEST(IntersectionTexture, MatchesSerialSampling)
+{
+    auto vol = RandomVolume("vc_texturing_IntersectionTexture");
+    auto ppm = RandomPPM();
+
+    IntersectionTexture texture;
+    texture.setVolume(vol);
+    texture.setPerPixelMap(ppm);
+    auto image = texture.compute().at(0);
+    ASSERT_EQ(image.rows, 40);
+    ASSERT_EQ(image.cols, 60);
+
+    const auto& mask = ppm->mask();
+    for (int y = 0; y < 40; y++) {
+        for (int x = 0; x < 60; x++) {
+            uint16_t expected{0};
+            if (mask.at<uint8_t>(y, x) != 0) {
+                expected = vol->interpolateAt(ppm->getAsPixelMap(y, x).pos);
+            }
+            EXPECT_EQ(image.at<uint16_t>(y, x), expected) << x << ", " << y;
+        }
+    }
+
+    // The thread count doesn't change the result
+    texture.setNumThreads(1);
+    auto serial = texture.compute().at(0);
+    EXPECT_EQ(cv::countNonZero(serial != image), 0);
+}
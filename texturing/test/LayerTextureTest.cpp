@@ -0,0 +1,143 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+#include "vc/core/filesystem.hpp"
+#include "vc/core/io/ZarrArray.hpp"
+#include "vc/core/neighborhood/LineGenerator.hpp"
+#include "vc/core/types/PerPixelMap.hpp"
+#include "vc/core/types/Volume.hpp"
+#include "vc/texturing/LayerTexture.hpp"
+
+using namespace volcart;
+using namespace volcart::texturing;
+namespace fs = volcart::filesystem;
+
+TEST(LayerTexture, BandsMatchFullStack)
+{
+    fs::path volPath{"vc_texturing_LayerTexture"};
+    fs::remove_all(volPath);
+    fs::create_directory(volPath);
+
+    auto vol = Volume::New(volPath, "LayerTexture", "LayerTexture");
+    vol->setSliceWidth(30);
+    vol->setSliceHeight(30);
+    vol->setNumberOfSlices(30);
+    vol->saveMetadata();
+    cv::RNG rng(1234);
+    for (int z = 0; z < 30; z++) {
+        cv::Mat slice(30, 30, CV_16UC1);
+        rng.fill(slice, cv::RNG::UNIFORM, 0, 65536);
+        vol->setSliceData(z, slice);
+    }
+
+    // Pixels in the middle of the volume with random normals
+    auto ppm = PerPixelMap::New(8, 8);
+    for (size_t y = 0; y < 8; y++) {
+        for (size_t x = 0; x < 8; x++) {
+            cv::Vec3d n{
+                rng.uniform(-1., 1.), rng.uniform(-1., 1.),
+                rng.uniform(-1., 1.)};
+            n = cv::normalize(n);
+            (*ppm)(y, x) = {
+                rng.uniform(10., 20.), rng.uniform(10., 20.),
+                rng.uniform(10., 20.), n[0], n[1], n[2]};
+        }
+    }
+
+    auto line = LineGenerator::New();
+    line->setSamplingRadius(4);
+    line->setSamplingInterval(0.5);
+    line->setSamplingDirection(Direction::Bidirectional);
+
+    LayerTexture layers;
+    layers.setVolume(vol);
+    layers.setPerPixelMap(ppm);
+    layers.setGenerator(line);
+    auto expected = layers.compute();
+    ASSERT_EQ(expected.size(), line->extents()[0]);
+    EXPECT_EQ(layers.progressIterations(), ppm->numMappings());
+
+    // Bands which do and do not divide the stack evenly
+    for (size_t bandSize : {0, 1, 4, 5, 100}) {
+        std::vector<cv::Mat> written;
+        layers.setBandSize(bandSize);
+        layers.setLayerWriter([&](auto i, const auto& img) {
+            EXPECT_EQ(i, written.size());
+            written.push_back(img.clone());
+        });
+        EXPECT_TRUE(layers.compute().empty());
+        ASSERT_EQ(written.size(), expected.size());
+        for (size_t i = 0; i < expected.size(); i++) {
+            EXPECT_EQ(cv::countNonZero(written[i] != expected[i]), 0);
+        }
+    }
+}
+
+TEST(LayerTexture, ChunkedOutputMatchesLayers)
+{
+    fs::path volPath{"vc_texturing_LayerTexture_Chunked"};
+    fs::remove_all(volPath);
+    fs::create_directory(volPath);
+
+    auto vol = Volume::New(volPath, "LayerTexture", "LayerTexture");
+    vol->setSliceWidth(30);
+    vol->setSliceHeight(30);
+    vol->setNumberOfSlices(30);
+    vol->saveMetadata();
+    cv::RNG rng(1234);
+    for (int z = 0; z < 30; z++) {
+        cv::Mat slice(30, 30, CV_16UC1);
+        rng.fill(slice, cv::RNG::UNIFORM, 0, 65536);
+        vol->setSliceData(z, slice);
+    }
+
+    // A 7x5 PPM with an unmapped corner
+    auto ppm = PerPixelMap::New(5, 7);
+    cv::Mat mask = cv::Mat::ones(5, 7, CV_8UC1) * 255;
+    mask(cv::Rect(4, 3, 3, 2)) = 0;
+    ppm->setMask(mask);
+    for (size_t y = 0; y < 5; y++) {
+        for (size_t x = 0; x < 7; x++) {
+            (*ppm)(y, x) = {
+                rng.uniform(10., 20.), rng.uniform(10., 20.),
+                rng.uniform(10., 20.), 0, 0, 1};
+        }
+    }
+
+    auto line = LineGenerator::New();
+    line->setSamplingRadius(2);
+    line->setSamplingInterval(1);
+    line->setSamplingDirection(Direction::Bidirectional);
+
+    LayerTexture layers;
+    layers.setVolume(vol);
+    layers.setPerPixelMap(ppm);
+    layers.setGenerator(line);
+    auto expected = layers.compute();
+    const auto numLayers = static_cast<int>(expected.size());
+
+    // Chunks which do not divide the stack evenly
+    auto arrayPath = volPath / "layers.zarr";
+    layers.setChunkedOutput(arrayPath, {3, 3, 2});
+    EXPECT_EQ(layers.progressIterations(), size_t{6});
+    EXPECT_TRUE(layers.compute().empty());
+
+    io::ZarrArray array(LocalVolumeSource::New(volPath), "layers.zarr");
+    ASSERT_EQ(array.shape(), cv::Vec3i(7, 5, numLayers));
+    ASSERT_EQ(array.chunkShape(), cv::Vec3i(3, 3, 2));
+    for (int z = 0; z < numLayers; z++) {
+        for (int y = 0; y < 5; y++) {
+            for (int x = 0; x < 7; x++) {
+                auto chunk = array.readChunk(x / 3, y / 3, z / 2);
+                auto value = chunk.at<uint16_t>((z % 2) * 3 + y % 3, x % 3);
+                EXPECT_EQ(value, expected[z].at<uint16_t>(y, x));
+            }
+        }
+    }
+
+    // The tile of the unmapped corner is not written
+    EXPECT_FALSE(fs::exists(arrayPath / "0.1.2"));
+}
@@ -0,0 +1,237 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <optional>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "vc/core/filesystem.hpp"
+#include "vc/core/shapes/Plane.hpp"
+#include "vc/core/types/Exceptions.hpp"
+#include "vc/core/types/FlatMesh.hpp"
+#include "vc/core/util/Iteration.hpp"
+#include "vc/texturing/MeshBVH.hpp"
+#include "vc/texturing/PPMGenerator.hpp"
+
+namespace vc = volcart;
+namespace vct = volcart::texturing;
+namespace fs = volcart::filesystem;
+
+using Triangle = vct::MeshBVH::Triangle;
+
+namespace
+{
+// Small random triangles in the unit cube
+auto RandomTriangles(std::size_t n) -> std::vector<Triangle>
+{
+    std::mt19937 gen(1);
+    std::uniform_real_distribution<double> dist(0, 1);
+    std::vector<Triangle> tris;
+    for (std::size_t i = 0; i < n; i++) {
+        cv::Vec3d a{dist(gen), dist(gen), dist(gen)};
+        cv::Vec3d b = a + cv::Vec3d{0.05 * dist(gen), 0.05, 0};
+        cv::Vec3d c = a + cv::Vec3d{0, 0.05 * dist(gen), 0.05};
+        tris.push_back({a, b, c});
+    }
+    return tris;
+}
+
+// Closest intersection by testing every triangle
+auto BruteForce(
+    const std::vector<Triangle>& tris,
+    const cv::Vec3d& o,
+    const cv::Vec3d& d,
+    double tmax) -> std::optional<std::pair<std::size_t, double>>
+{
+    std::optional<std::pair<std::size_t, double>> best;
+    for (std::size_t i = 0; i < tris.size(); i++) {
+        const auto& t = tris[i];
+        auto e1 = t[1] - t[0];
+        auto e2 = t[2] - t[0];
+        auto p = d.cross(e2);
+        auto det = e1.dot(p);
+        if (std::abs(det) < 1e-15) {
+            continue;
+        }
+        auto s = o - t[0];
+        auto u = s.dot(p) / det;
+        auto q = s.cross(e1);
+        auto v = d.dot(q) / det;
+        auto dist = e2.dot(q) / det;
+        if (u >= 0 and v >= 0 and u + v <= 1 and dist >= 0 and
+            dist <= tmax and (not best or dist < best->second)) {
+            best = {i, dist};
+        }
+    }
+    return best;
+}
+}  // namespace
+
+TEST(MeshBVH, MatchesBruteForce)
+{
+    auto tris = RandomTriangles(5000);
+    auto bvh = vct::MeshBVH::New(tris);
+    EXPECT_EQ(bvh->numFaces(), tris.size());
+    EXPECT_GT(bvh->numNodes(), 1U);
+
+    std::mt19937 gen(2);
+    std::uniform_real_distribution<double> dist(0, 1);
+    std::size_t hits{0};
+    for (int i = 0; i < 500; i++) {
+        cv::Vec3d o{dist(gen), dist(gen), -1};
+        cv::Vec3d d{0.1 * dist(gen), 0.1 * dist(gen), 1};
+        auto expected = BruteForce(tris, o, d, 10);
+        auto hit = bvh->intersect(o, d, 0, 10);
+        ASSERT_EQ(hit.has_value(), expected.has_value());
+        if (not hit) {
+            continue;
+        }
+        hits++;
+        EXPECT_EQ(hit->face, expected->first);
+        EXPECT_NEAR(hit->t, expected->second, 1e-9);
+
+        // Barycentric coordinates reproduce the hit point
+        const auto& t = tris[hit->face];
+        cv::Vec3d p = (1 - hit->u - hit->v) * t[0] + hit->u * t[1] +
+                      hit->v * t[2];
+        EXPECT_LT(cv::norm(p - (o + hit->t * d)), 1e-9);
+    }
+    EXPECT_GT(hits, 0U);
+}
+
+TEST(MeshBVH, ThreadCountDoesNotChangeResult)
+{
+    auto tris = RandomTriangles(20000);
+    auto serial = vct::MeshBVH::New(tris, 1);
+    auto parallel = vct::MeshBVH::New(tris);
+    EXPECT_EQ(serial->numNodes(), parallel->numNodes());
+
+    std::mt19937 gen(3);
+    std::uniform_real_distribution<double> dist(0, 1);
+    for (int i = 0; i < 200; i++) {
+        cv::Vec3d o{dist(gen), -1, dist(gen)};
+        cv::Vec3d d{0, 1, 0};
+        auto a = serial->intersect(o, d, 0, 10);
+        auto b = parallel->intersect(o, d, 0, 10);
+        ASSERT_EQ(a.has_value(), b.has_value());
+        if (a) {
+            EXPECT_EQ(a->face, b->face);
+            EXPECT_EQ(a->t, b->t);
+        }
+    }
+}
+
+TEST(MeshBVH, WriteRead)
+{
+    auto tris = RandomTriangles(1000);
+    auto bvh = vct::MeshBVH::New(tris);
+    fs::path path{"vc_texturing_MeshBVH.bvh"};
+    vct::MeshBVH::Write(path, *bvh);
+    auto result = vct::MeshBVH::Read(path);
+    EXPECT_EQ(result->numFaces(), bvh->numFaces());
+    EXPECT_EQ(result->numNodes(), bvh->numNodes());
+
+    std::mt19937 gen(4);
+    std::uniform_real_distribution<double> dist(0, 1);
+    for (int i = 0; i < 200; i++) {
+        cv::Vec3d o{-1, dist(gen), dist(gen)};
+        cv::Vec3d d{1, 0, 0};
+        auto a = bvh->intersect(o, d, 0, 10);
+        auto b = result->intersect(o, d, 0, 10);
+        ASSERT_EQ(a.has_value(), b.has_value());
+        if (a) {
+            EXPECT_EQ(a->face, b->face);
+            EXPECT_EQ(a->t, b->t);
+        }
+    }
+
+    EXPECT_THROW(
+        vct::MeshBVH::Read("vc_texturing_MeshBVH.missing"), vc::IOException);
+}
+
+TEST(MeshBVH, ReadDamagedFile)
+{
+    // A single face, so the root is the only node and a leaf
+    auto bvh = vct::MeshBVH::New(RandomTriangles(1));
+    ASSERT_EQ(bvh->numNodes(), 1U);
+    fs::path path{"vc_texturing_MeshBVH_Damaged.bvh"};
+    vct::MeshBVH::Write(path, *bvh);
+    std::ifstream in(path.string(), std::ios::binary);
+    std::string bytes(
+        (std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    in.close();
+
+    // Header: magic[8], version, reserved, then uint64_t numFaces and
+    // numNodes. The leaf's face count and first face are the last two
+    // fields of the node, which is followed by one face index.
+    constexpr std::size_t numFacesOffset{16};
+    constexpr std::size_t numNodesOffset{24};
+    const auto firstOffset = bytes.size() - 2 * sizeof(std::uint64_t);
+    const auto countOffset = firstOffset - sizeof(std::uint64_t);
+    auto readDamaged = [&](std::size_t offset, std::uint64_t value) {
+        auto damaged = bytes;
+        std::memcpy(&damaged[offset], &value, sizeof(value));
+        fs::path damagedPath{"vc_texturing_MeshBVH_Damaged2.bvh"};
+        std::ofstream out(damagedPath.string(), std::ios::binary);
+        out.write(damaged.data(), static_cast<std::streamsize>(damaged.size()));
+        out.close();
+        return vct::MeshBVH::Read(damagedPath);
+    };
+
+    // The undamaged file reads
+    EXPECT_NO_THROW(readDamaged(countOffset, 1));
+
+    // Counts larger than the file
+    auto huge = std::numeric_limits<std::uint64_t>::max() / 2;
+    EXPECT_THROW(readDamaged(numFacesOffset, huge), vc::IOException);
+    EXPECT_THROW(readDamaged(numNodesOffset, huge), vc::IOException);
+
+    // Leaves whose face range wraps around or ends past the faces
+    auto max = std::numeric_limits<std::uint64_t>::max();
+    EXPECT_THROW(readDamaged(firstOffset, max), vc::IOException);
+    EXPECT_THROW(readDamaged(firstOffset, 1), vc::IOException);
+    EXPECT_THROW(readDamaged(countOffset, max), vc::IOException);
+}
+
+TEST(MeshBVH, EmptyMesh)
+{
+    auto bvh = vct::MeshBVH::New(std::vector<Triangle>{});
+    EXPECT_EQ(bvh->numFaces(), 0U);
+    EXPECT_FALSE(bvh->intersect({0, 0, 0}, {0, 0, 1}, 0, 1));
+}
+
+TEST(MeshBVH, SharedWithPPMGenerator)
+{
+    vc::shapes::Plane plane(5, 5);
+    auto mesh = plane.itkMesh();
+    auto uvMap = vc::UVMap::New();
+    std::size_t id{0};
+    for (const auto uv : vc::range2D(5, 5)) {
+        uvMap->set(id++, {uv.first / 4.0, uv.second / 4.0});
+    }
+    auto bvh = vct::MeshBVH::NewUV(vc::ToFlatMesh(mesh), *uvMap);
+    EXPECT_EQ(bvh->numFaces(), mesh->GetNumberOfCells());
+
+    vct::PPMGenerator gen;
+    gen.setDimensions(50, 50);
+    gen.setMesh(mesh);
+    gen.setUVMap(uvMap);
+    auto expected = gen.compute();
+
+    gen.setBVH(bvh);
+    auto result = gen.compute();
+    EXPECT_EQ(cv::countNonZero(result->cellMap() != expected->cellMap()), 0);
+    for (const auto [y, x] : vc::range2D(50, 50)) {
+        EXPECT_EQ(result->getMapping(y, x), expected->getMapping(y, x));
+    }
+
+    // A BVH of a different mesh is rejected
+    gen.setBVH(vct::MeshBVH::New(RandomTriangles(3)));
+    EXPECT_THROW(gen.compute(), std::invalid_argument);
+}
@@ -0,0 +1,202 @@
+#include <gtest/gtest.h>
+
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+#include "vc/core/filesystem.hpp"
+#include "vc/core/neighborhood/CuboidGenerator.hpp"
+#include "vc/core/neighborhood/LineGenerator.hpp"
+#include "vc/core/types/PerPixelMap.hpp"
+#include "vc/core/types/Volume.hpp"
+#include "vc/texturing/CompositeTexture.hpp"
+#include "vc/texturing/IntegralTexture.hpp"
+#include "vc/texturing/LayerTexture.hpp"
+#include "vc/texturing/MultiTexture.hpp"
+
+using namespace volcart;
+using namespace volcart::texturing;
+namespace fs = volcart::filesystem;
+
+using Output = MultiTexture::Output;
+using Filter = CompositeTexture::Filter;
+
+namespace
+{
+class MultiTextureFixture : public ::testing::Test
+{
+public:
+    void SetUp() override
+    {
+        // Random volume
+        const fs::path volPath{"vc_texturing_MultiTexture_volume"};
+        fs::remove_all(volPath);
+        fs::create_directory(volPath);
+        vol_ = Volume::New(volPath, "MultiTexture", "MultiTexture");
+        vol_->setSliceWidth(30);
+        vol_->setSliceHeight(30);
+        vol_->setNumberOfSlices(30);
+        vol_->saveMetadata();
+        cv::RNG rng(1234);
+        for (int z = 0; z < 30; z++) {
+            cv::Mat slice(30, 30, CV_16UC1);
+            rng.fill(slice, cv::RNG::UNIFORM, 0, 65536);
+            vol_->setSliceData(z, slice);
+        }
+
+        // Pixels in the middle of the volume with random normals. Every
+        // third pixel has no mapping.
+        ppm_ = PerPixelMap::New(12, 10);
+        cv::Mat mask = cv::Mat::zeros(12, 10, CV_8UC1);
+        for (size_t y = 0; y < ppm_->height(); y++) {
+            for (size_t x = 0; x < ppm_->width(); x++) {
+                auto n = cv::normalize(cv::Vec3d{
+                    rng.uniform(-1., 1.), rng.uniform(-1., 1.),
+                    rng.uniform(-1., 1.)});
+                (*ppm_)(y, x) = {
+                    rng.uniform(10., 20.), rng.uniform(10., 20.),
+                    rng.uniform(10., 20.), n[0], n[1], n[2]};
+                if ((x + y) % 3 != 0) {
+                    mask.at<uint8_t>(y, x) = 255;
+                }
+            }
+        }
+        ppm_->setMask(mask);
+
+        line_ = LineGenerator::New();
+        line_->setSamplingRadius(4);
+        line_->setSamplingInterval(0.5);
+        line_->setSamplingDirection(Direction::Bidirectional);
+    }
+
+    auto multi(const std::vector<Output>& outputs) -> MultiTexture::Texture
+    {
+        MultiTexture t;
+        t.setVolume(vol_);
+        t.setPerPixelMap(ppm_);
+        t.setGenerator(line_);
+        t.setOutputs(outputs);
+        return t.compute();
+    }
+
+    auto composite(Filter f) -> cv::Mat
+    {
+        CompositeTexture t;
+        t.setVolume(vol_);
+        t.setPerPixelMap(ppm_);
+        t.setGenerator(line_);
+        t.setFilter(f);
+        return t.compute().at(0);
+    }
+
+    auto integral() -> cv::Mat
+    {
+        IntegralTexture t;
+        t.setVolume(vol_);
+        t.setPerPixelMap(ppm_);
+        t.setGenerator(line_);
+        t.setWeightMethod(IntegralTexture::WeightMethod::None);
+        t.setClampValuesToMax(false);
+        return t.compute().at(0);
+    }
+
+    auto layers() -> LayerTexture::Texture
+    {
+        LayerTexture t;
+        t.setVolume(vol_);
+        t.setPerPixelMap(ppm_);
+        t.setGenerator(line_);
+        return t.compute();
+    }
+
+    Volume::Pointer vol_;
+    PerPixelMap::Pointer ppm_;
+    LineGenerator::Pointer line_;
+};
+
+auto Equal(const cv::Mat& a, const cv::Mat& b) -> bool
+{
+    return a.size() == b.size() and a.type() == b.type() and
+           cv::norm(a, b, cv::NORM_INF) == 0;
+}
+}  // namespace
+
+TEST_F(MultiTextureFixture, CompositeOutputsMatchCompositeTexture)
+{
+    const std::vector<std::pair<Output, Filter>> pairs{
+        {Output::Minimum, Filter::Minimum},
+        {Output::Maximum, Filter::Maximum},
+        {Output::Median, Filter::Median},
+        {Output::Mean, Filter::Mean},
+        {Output::MedianAverage, Filter::MedianAverage}};
+    std::vector<Output> outputs;
+    for (const auto& p : pairs) {
+        outputs.push_back(p.first);
+    }
+
+    auto result = multi(outputs);
+    ASSERT_EQ(result.size(), pairs.size());
+    for (std::size_t i = 0; i < pairs.size(); i++) {
+        EXPECT_TRUE(Equal(result[i], composite(pairs[i].second)))
+            << "Output " << i;
+    }
+}
+
+TEST_F(MultiTextureFixture, IntegralMatchesIntegralTexture)
+{
+    auto result = multi({Output::Integral});
+    ASSERT_EQ(result.size(), 1U);
+    auto expected = integral();
+    ASSERT_EQ(result[0].size(), expected.size());
+    ASSERT_EQ(result[0].type(), expected.type());
+
+    // The sums may be accumulated in a different order
+    EXPECT_LE(cv::norm(result[0], expected, cv::NORM_INF), 1e-5);
+}
+
+TEST_F(MultiTextureFixture, LayersMatchLayerTexture)
+{
+    auto result = multi({Output::Layers});
+    auto expected = layers();
+    ASSERT_EQ(result.size(), line_->extents()[0]);
+    ASSERT_EQ(result.size(), expected.size());
+    for (std::size_t i = 0; i < result.size(); i++) {
+        EXPECT_TRUE(Equal(result[i], expected[i])) << "Layer " << i;
+    }
+}
+
+TEST_F(MultiTextureFixture, OutputsAreInRequestedOrder)
+{
+    auto result = multi({Output::Maximum, Output::Layers, Output::Minimum});
+    const auto numLayers = line_->extents()[0];
+    ASSERT_EQ(result.size(), numLayers + 2);
+    EXPECT_TRUE(Equal(result.front(), composite(Filter::Maximum)));
+    EXPECT_TRUE(Equal(result.back(), composite(Filter::Minimum)));
+    auto expected = layers();
+    for (std::size_t i = 0; i < numLayers; i++) {
+        EXPECT_TRUE(Equal(result[i + 1], expected[i])) << "Layer " << i;
+    }
+}
+
+TEST_F(MultiTextureFixture, InvalidOutputs)
+{
+    EXPECT_THROW(multi({}), std::invalid_argument);
+
+    // Layers need a line
+    auto cuboid = CuboidGenerator::New();
+    cuboid->setSamplingRadius(1, 1, 1);
+    MultiTexture t;
+    t.setVolume(vol_);
+    t.setPerPixelMap(ppm_);
+    t.setGenerator(cuboid);
+    t.setOutputs({Output::Layers});
+    EXPECT_THROW(t.compute(), std::runtime_error);
+
+    // Composite outputs accept any generator
+    t.setOutputs({Output::Mean});
+    auto result = t.compute();
+    ASSERT_EQ(result.size(), 1U);
+    EXPECT_EQ(result[0].type(), CV_16UC1);
+}
@@ -1,6 +1,8 @@
 #include <gtest/gtest.h>
 
 #include <chrono>
+#include <cmath>
+#include <vector>
 
 #include "vc/core/shapes/Plane.hpp"
 #include "vc/core/util/Iteration.hpp"
@@ -53,6 +55,260 @@ TEST(PPMGeneratorTest, RegressionTest)
     }
 }
 
+TEST(PPMGeneratorTest, MultithreadedMatchesSingleThreaded)
+{
+    // Build Plane UVMap
+    vc::shapes::Plane plane(10, 10);
+    auto mesh = plane.itkMesh();
+    auto uvMap = vc::UVMap::New();
+    std::size_t id{0};
+    for (const auto uv : vc::range2D(10, 10)) {
+        auto u = double(uv.first) / 9.0;
+        auto v = double(uv.second) / 9.0;
+        uvMap->set(id++, {u, v});
+    }
+
+    // Setup PPM Generator
+    vct::PPMGenerator ppmGenerator;
+    ppmGenerator.setDimensions(101, 67);
+    ppmGenerator.setMesh(mesh);
+    ppmGenerator.setUVMap(uvMap);
+
+    // Generate PPMs
+    ppmGenerator.setNumThreads(1);
+    auto expected = ppmGenerator.compute();
+    ppmGenerator.setNumThreads(4);
+    EXPECT_EQ(ppmGenerator.numThreads(), 4);
+    auto ppm = ppmGenerator.compute();
+
+    // Compare mappings
+    for (const auto [y, x] : vc::range2D(101, 67)) {
+        EXPECT_EQ(ppm->hasMapping(y, x), expected->hasMapping(y, x));
+        EXPECT_EQ(ppm->getMapping(y, x), expected->getMapping(y, x));
+        EXPECT_EQ(
+            ppm->cellMap().at<int32_t>(y, x),
+            expected->cellMap().at<int32_t>(y, x));
+    }
+}
+
+TEST(PPMGeneratorTest, RasterizeMatchesRayCast)
+{
+    // Build Plane UVMap
+    vc::shapes::Plane plane(10, 10);
+    auto mesh = plane.itkMesh();
+    auto uvMap = vc::UVMap::New();
+    std::size_t id{0};
+    for (const auto uv : vc::range2D(10, 10)) {
+        auto u = double(uv.first) / 9.0;
+        auto v = double(uv.second) / 9.0;
+        uvMap->set(id++, {u, v});
+    }
+
+    // Setup PPM Generator
+    vct::PPMGenerator ppmGenerator;
+    ppmGenerator.setDimensions(101, 67);
+    ppmGenerator.setMesh(mesh);
+    ppmGenerator.setUVMap(uvMap);
+
+    // Generate PPMs
+    auto expected = ppmGenerator.compute();
+    ppmGenerator.setEngine(vct::PPMGenerator::Engine::Rasterize);
+    ppmGenerator.setNumThreads(1);
+    auto ppm = ppmGenerator.compute();
+    ppmGenerator.setNumThreads(4);
+    auto threaded = ppmGenerator.compute();
+
+    // Pixels on shared edges may be assigned to a different face, but map to
+    // the same position
+    for (const auto [y, x] : vc::range2D(101, 67)) {
+        EXPECT_EQ(threaded->hasMapping(y, x), ppm->hasMapping(y, x));
+        EXPECT_EQ(threaded->getMapping(y, x), ppm->getMapping(y, x));
+        EXPECT_EQ(
+            threaded->cellMap().at<int32_t>(y, x),
+            ppm->cellMap().at<int32_t>(y, x));
+
+        if (not expected->hasMapping(y, x)) {
+            continue;
+        }
+        ASSERT_TRUE(ppm->hasMapping(y, x));
+        const auto& a = ppm->getMapping(y, x);
+        const auto& b = expected->getMapping(y, x);
+        for (int i = 0; i < 6; i++) {
+            EXPECT_NEAR(a[i], b[i], 1e-9);
+        }
+    }
+}
+
+TEST(PPMGeneratorTest, RegionMatchesFullPPM)
+{
+    // Build Plane UVMap
+    vc::shapes::Plane plane(10, 10);
+    auto mesh = plane.itkMesh();
+    auto uvMap = vc::UVMap::New();
+    std::size_t id{0};
+    for (const auto uv : vc::range2D(10, 10)) {
+        auto u = double(uv.first) / 9.0;
+        auto v = double(uv.second) / 9.0;
+        uvMap->set(id++, {u, v});
+    }
+
+    // Setup PPM Generator
+    vct::PPMGenerator ppmGenerator;
+    ppmGenerator.setDimensions(101, 67);
+    ppmGenerator.setMesh(mesh);
+    ppmGenerator.setUVMap(uvMap);
+
+    using Engine = vct::PPMGenerator::Engine;
+    for (auto engine : {Engine::RayCast, Engine::Rasterize}) {
+        ppmGenerator.setEngine(engine);
+        ppmGenerator.setRegion({});
+        auto expected = ppmGenerator.compute();
+
+        cv::Rect region(13, 40, 30, 61);
+        ppmGenerator.setRegion(region);
+        auto ppm = ppmGenerator.compute();
+        ASSERT_EQ(ppm->height(), 61);
+        ASSERT_EQ(ppm->width(), 30);
+        for (const auto [y, x] : vc::range2D(61, 30)) {
+            auto fy = y + 40;
+            auto fx = x + 13;
+            EXPECT_EQ(ppm->hasMapping(y, x), expected->hasMapping(fy, fx));
+            EXPECT_EQ(ppm->getMapping(y, x), expected->getMapping(fy, fx));
+            EXPECT_EQ(
+                ppm->cellMap().at<int32_t>(y, x),
+                expected->cellMap().at<int32_t>(fy, fx));
+        }
+
+        ppmGenerator.setRegion({50, 0, 30, 10});
+        EXPECT_THROW(ppmGenerator.compute(), std::invalid_argument);
+    }
+}
+
+TEST(PPMGeneratorTest, ReferencePPMMatchesFullPPM)
+{
+    // Build Plane UVMap
+    vc::shapes::Plane plane(10, 10);
+    auto mesh = plane.itkMesh();
+    auto uvMap = vc::UVMap::New();
+    std::size_t id{0};
+    for (const auto uv : vc::range2D(10, 10)) {
+        auto u = double(uv.first) / 9.0;
+        auto v = double(uv.second) / 9.0;
+        uvMap->set(id++, {u, v});
+    }
+
+    // Generate the reference PPM
+    vct::PPMGenerator ppmGenerator;
+    ppmGenerator.setDimensions(101, 67);
+    ppmGenerator.setMesh(mesh);
+    ppmGenerator.setUVMap(uvMap);
+    auto reference = ppmGenerator.compute();
+    ASSERT_FALSE(reference->barycentricMap().empty());
+
+    // Deform the mesh without changing its faces
+    auto deformed = plane.itkMesh();
+    for (auto pt = deformed->GetPoints()->Begin();
+         pt != deformed->GetPoints()->End(); ++pt) {
+        auto& p = pt->Value();
+        p[2] += std::sin(p[0]) * 2.0 + p[1] * 0.5;
+    }
+    ppmGenerator.setMesh(deformed);
+    auto expected = ppmGenerator.compute();
+
+    // Regenerate from the reference, with and without barycentric samples
+    ppmGenerator.setReferencePPM(reference);
+    auto ppm = ppmGenerator.compute();
+    auto noBary = vc::PerPixelMap::New(*reference);
+    noBary->setBarycentricMap(cv::Mat());
+    ppmGenerator.setReferencePPM(noBary);
+    auto recomputed = ppmGenerator.compute();
+    for (const auto [y, x] : vc::range2D(101, 67)) {
+        EXPECT_EQ(ppm->hasMapping(y, x), expected->hasMapping(y, x));
+        EXPECT_EQ(ppm->getMapping(y, x), expected->getMapping(y, x));
+        EXPECT_EQ(recomputed->getMapping(y, x), expected->getMapping(y, x));
+        EXPECT_EQ(
+            ppm->cellMap().at<int32_t>(y, x),
+            expected->cellMap().at<int32_t>(y, x));
+    }
+
+    // The reference must match the output
+    ppmGenerator.setReferencePPM(reference);
+    ppmGenerator.setDimensions(100, 67);
+    EXPECT_THROW(ppmGenerator.compute(), std::invalid_argument);
+}
+
+TEST(PPMGeneratorTest, IncrementalMatchesFullPPM)
+{
+    // Build Plane UVMap
+    vc::shapes::Plane plane(10, 10);
+    auto mesh = plane.itkMesh();
+    auto uvMap = vc::UVMap::New();
+    std::size_t id{0};
+    for (const auto uv : vc::range2D(10, 10)) {
+        auto u = double(uv.first) / 9.0;
+        auto v = double(uv.second) / 9.0;
+        uvMap->set(id++, {u, v});
+    }
+
+    // Generate the reference PPM
+    vct::PPMGenerator ppmGenerator;
+    ppmGenerator.setDimensions(101, 67);
+    ppmGenerator.setEngine(vct::PPMGenerator::Engine::Rasterize);
+    ppmGenerator.setMesh(mesh);
+    ppmGenerator.setUVMap(uvMap);
+    auto reference = ppmGenerator.compute();
+
+    // Edit one vertex: move it and its UV
+    const std::size_t edited{44};
+    auto editedMesh = plane.itkMesh();
+    auto pt = editedMesh->GetPoint(edited);
+    pt[2] += 3.0;
+    editedMesh->SetPoint(edited, pt);
+    auto editedUV = vc::UVMap::New(*uvMap);
+    editedUV->set(edited, uvMap->get(edited) + cv::Vec2d(0.02, -0.03));
+
+    // Only the faces around the edited vertex changed
+    auto changed = vct::ChangedFaces(mesh, uvMap, editedMesh, editedUV);
+    std::vector<std::size_t> expectedChanged;
+    for (auto cell = editedMesh->GetCells()->Begin();
+         cell != editedMesh->GetCells()->End(); ++cell) {
+        const auto& ids = cell->Value()->GetPointIdsContainer();
+        for (unsigned int i = 0; i < 3; i++) {
+            if (ids.GetElement(i) == edited) {
+                expectedChanged.push_back(cell->Index());
+                break;
+            }
+        }
+    }
+    ASSERT_FALSE(changed.empty());
+    EXPECT_EQ(changed, expectedChanged);
+
+    // Full regeneration of the edited mesh
+    ppmGenerator.setMesh(editedMesh);
+    ppmGenerator.setUVMap(editedUV);
+    auto expected = ppmGenerator.compute();
+
+    // Incremental regeneration. Pixels on the edges of the changed faces may
+    // be assigned to a different face, but map to the same position.
+    ppmGenerator.setReferencePPM(reference);
+    ppmGenerator.setChangedFaces(changed);
+    auto ppm = ppmGenerator.compute();
+    for (const auto [y, x] : vc::range2D(101, 67)) {
+        ASSERT_EQ(ppm->hasMapping(y, x), expected->hasMapping(y, x));
+        if (not expected->hasMapping(y, x)) {
+            continue;
+        }
+        const auto& a = ppm->getMapping(y, x);
+        const auto& b = expected->getMapping(y, x);
+        for (int i = 0; i < 6; i++) {
+            EXPECT_NEAR(a[i], b[i], 1e-9);
+        }
+    }
+
+    ppmGenerator.setChangedFaces({editedMesh->GetNumberOfCells()});
+    EXPECT_THROW(ppmGenerator.compute(), std::invalid_argument);
+}
+
 TEST_P(PPMGeneratorTest, PerformanceTest)
 {
     // Build Plane
@@ -0,0 +1,111 @@
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+#include "vc/core/filesystem.hpp"
+#include "vc/core/neighborhood/LineGenerator.hpp"
+#include "vc/core/types/PerPixelMap.hpp"
+#include "vc/core/types/Volume.hpp"
+#include "vc/texturing/CompositeTexture.hpp"
+#include "vc/texturing/SamplePlan.hpp"
+
+using namespace volcart;
+using namespace volcart::texturing;
+namespace fs = volcart::filesystem;
+
+namespace
+{
+auto RandomVolume(const fs::path& path, uint64_t seed) -> Volume::Pointer
+{
+    fs::remove_all(path);
+    fs::create_directory(path);
+    auto vol = Volume::New(path, "SamplePlan", "SamplePlan");
+    vol->setSliceWidth(30);
+    vol->setSliceHeight(30);
+    vol->setNumberOfSlices(30);
+    vol->saveMetadata();
+    cv::RNG rng(seed);
+    for (int z = 0; z < 30; z++) {
+        cv::Mat slice(30, 30, CV_16UC1);
+        rng.fill(slice, cv::RNG::UNIFORM, 0, 65536);
+        vol->setSliceData(z, slice);
+    }
+    return vol;
+}
+}  // namespace
+
+TEST(SamplePlan, ReplayMatchesGenerator)
+{
+    // Pixels with random normals, one of which samples outside the volume
+    cv::RNG rng(1234);
+    auto ppm = PerPixelMap::New(6, 7);
+    for (size_t y = 0; y < 6; y++) {
+        for (size_t x = 0; x < 7; x++) {
+            auto n = cv::normalize(cv::Vec3d{
+                rng.uniform(-1., 1.), rng.uniform(-1., 1.),
+                rng.uniform(-1., 1.)});
+            (*ppm)(y, x) = {
+                rng.uniform(5., 25.), rng.uniform(5., 25.),
+                rng.uniform(5., 25.), n[0], n[1], n[2]};
+        }
+    }
+    (*ppm)(0, 0) = {1, 1, 1, 0, 0, 1};
+
+    auto line = LineGenerator::New();
+    line->setSamplingRadius(4);
+    line->setSamplingInterval(0.5);
+    auto plan = SamplePlan::Build(*ppm, *line);
+    ASSERT_EQ(plan->pixels().size(), ppm->numMappings());
+    ASSERT_EQ(plan->samplesPerPixel(), line->size());
+
+    // Round trip through a file
+    fs::path planPath{"vc_texturing_SamplePlan.plan"};
+    SamplePlan::Write(planPath, *plan);
+    auto read = SamplePlan::Read(planPath);
+    EXPECT_EQ(read->pixels(), plan->pixels());
+    EXPECT_EQ(read->samplesPerPixel(), plan->samplesPerPixel());
+
+    // Replay against two volumes with the same geometry
+    for (auto seed : {1, 2}) {
+        auto vol = RandomVolume(
+            "vc_texturing_SamplePlan_" + std::to_string(seed), seed);
+        std::vector<uint16_t> expected(line->size());
+        std::vector<uint16_t> replayed(line->size());
+        for (size_t i = 0; i < read->pixels().size(); i++) {
+            auto pixel = ppm->getAsPixelMap(read->pixels()[i]);
+            line->computeInto(vol, pixel.pos, pixel.normal, expected.data());
+            read->gather(*vol, i, replayed.data());
+            for (size_t s = 0; s < expected.size(); s++) {
+                EXPECT_LE(std::abs(expected[s] - replayed[s]), 1);
+            }
+        }
+
+        // Texturing with the plan matches texturing without it
+        CompositeTexture composite;
+        composite.setVolume(vol);
+        composite.setPerPixelMap(ppm);
+        composite.setGenerator(line);
+        composite.setFilter(CompositeTexture::Filter::Mean);
+        auto live = composite.compute()[0].clone();
+        composite.setSamplePlan(read);
+        auto planned = composite.compute()[0];
+        cv::Mat diff;
+        cv::absdiff(live, planned, diff);
+        double maxDiff{0};
+        cv::minMaxLoc(diff, nullptr, &maxDiff);
+        EXPECT_LE(maxDiff, 1);
+    }
+
+    // The plan must match the generator
+    CompositeTexture composite;
+    composite.setVolume(RandomVolume("vc_texturing_SamplePlan_3", 3));
+    composite.setPerPixelMap(ppm);
+    line->setSamplingRadius(2);
+    composite.setGenerator(line);
+    composite.setSamplePlan(plan);
+    EXPECT_THROW(composite.compute(), std::invalid_argument);
+}
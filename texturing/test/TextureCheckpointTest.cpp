@@ -0,0 +1,137 @@
+#include <gtest/gtest.h>
+
+#include <opencv2/core.hpp>
+
+#include "vc/core/filesystem.hpp"
+#include "vc/core/neighborhood/LineGenerator.hpp"
+#include "vc/core/types/PerPixelMap.hpp"
+#include "vc/core/types/Volume.hpp"
+#include "vc/texturing/CompositeTexture.hpp"
+#include "vc/texturing/TextureCheckpoint.hpp"
+
+using namespace volcart;
+using namespace volcart::texturing;
+namespace fs = volcart::filesystem;
+
+using Order = PerPixelMap::MappingOrder;
+
+namespace
+{
+class TextureCheckpointFixture : public ::testing::Test
+{
+public:
+    void SetUp() override
+    {
+        // Random volume
+        const fs::path volPath{"vc_texturing_TextureCheckpoint_volume"};
+        fs::remove_all(volPath);
+        fs::create_directory(volPath);
+        vol_ = Volume::New(volPath, "Checkpoint", "Checkpoint");
+        vol_->setSliceWidth(30);
+        vol_->setSliceHeight(30);
+        vol_->setNumberOfSlices(30);
+        vol_->saveMetadata();
+        cv::RNG rng(1234);
+        for (int z = 0; z < 30; z++) {
+            cv::Mat slice(30, 30, CV_16UC1);
+            rng.fill(slice, cv::RNG::UNIFORM, 0, 65536);
+            vol_->setSliceData(z, slice);
+        }
+
+        // Mappings with random positions and normals
+        ppm_ = PerPixelMap::New(20, 25);
+        for (size_t y = 0; y < ppm_->height(); y++) {
+            for (size_t x = 0; x < ppm_->width(); x++) {
+                auto n = cv::normalize(cv::Vec3d{
+                    rng.uniform(-1., 1.), rng.uniform(-1., 1.),
+                    rng.uniform(-1., 1.)});
+                (*ppm_)(y, x) = {
+                    rng.uniform(5., 25.), rng.uniform(5., 25.),
+                    rng.uniform(5., 25.), n[0], n[1], n[2]};
+            }
+        }
+
+        line_ = LineGenerator::New();
+        line_->setSamplingRadius(3);
+        expected_ = texture(nullptr);
+
+        dir_ = "vc_texturing_TextureCheckpoint";
+        fs::remove_all(dir_);
+    }
+
+    // Texture the PPM, optionally with a checkpoint
+    auto texture(const TextureCheckpoint::Pointer& checkpoint) -> cv::Mat
+    {
+        CompositeTexture composite;
+        composite.setVolume(vol_);
+        composite.setPerPixelMap(ppm_);
+        composite.setGenerator(line_);
+        composite.setMappingOrder(Order::Slice);
+        composite.setCheckpoint(checkpoint);
+        return composite.compute().at(0);
+    }
+
+    Volume::Pointer vol_;
+    PerPixelMap::Pointer ppm_;
+    LineGenerator::Pointer line_;
+    cv::Mat expected_;
+    fs::path dir_;
+};
+
+auto Equal(const cv::Mat& a, const cv::Mat& b) -> bool
+{
+    return a.size() == b.size() and a.type() == b.type() and
+           cv::countNonZero(a != b) == 0;
+}
+}  // namespace
+
+TEST_F(TextureCheckpointFixture, SavesCompletedTexture)
+{
+    auto checkpoint = TextureCheckpoint::New(dir_);
+    checkpoint->setKey("run");
+    EXPECT_TRUE(Equal(texture(checkpoint), expected_));
+
+    // The final state is always saved
+    TextureCheckpoint::Texture images{
+        cv::Mat::zeros(expected_.size(), expected_.type())};
+    auto reader = TextureCheckpoint::New(dir_);
+    reader->setKey("run");
+    EXPECT_EQ(reader->load(images, ppm_->numMappings()), ppm_->numMappings());
+    EXPECT_TRUE(Equal(images[0], expected_));
+
+    // Cleared checkpoints are not loaded
+    reader->clear();
+    EXPECT_EQ(reader->load(images, ppm_->numMappings()), 0);
+}
+
+TEST_F(TextureCheckpointFixture, ResumeMatchesFullTexture)
+{
+    // Checkpoint of the first half of the mappings. The other pixels hold
+    // values which must be overwritten.
+    auto mappings = ppm_->getMappingIndices(Order::Slice, {1, 1, 1});
+    auto done = mappings.size() / 2;
+    cv::Mat partial(expected_.size(), expected_.type(), cv::Scalar(7));
+    for (size_t i = 0; i < done; i++) {
+        auto pixel = ppm_->getAsPixelMap(mappings[i]);
+        auto x = static_cast<int>(pixel.x);
+        auto y = static_cast<int>(pixel.y);
+        partial.at<uint16_t>(y, x) = expected_.at<uint16_t>(y, x);
+    }
+    auto checkpoint = TextureCheckpoint::New(dir_);
+    checkpoint->setKey("run");
+    checkpoint->save({partial}, done, mappings.size());
+
+    EXPECT_TRUE(Equal(texture(checkpoint), expected_));
+}
+
+TEST_F(TextureCheckpointFixture, IgnoreOtherCheckpoints)
+{
+    // A complete checkpoint of a different run
+    cv::Mat other(expected_.size(), expected_.type(), cv::Scalar(7));
+    auto checkpoint = TextureCheckpoint::New(dir_);
+    checkpoint->setKey("other");
+    checkpoint->save({other}, ppm_->numMappings(), ppm_->numMappings());
+
+    checkpoint->setKey("run");
+    EXPECT_TRUE(Equal(texture(checkpoint), expected_));
+}
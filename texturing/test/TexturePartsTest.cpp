@@ -0,0 +1,107 @@
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+#include "vc/core/filesystem.hpp"
+#include "vc/core/io/TIFFIO.hpp"
+#include "vc/texturing/TextureParts.hpp"
+
+namespace fs = volcart::filesystem;
+namespace tio = volcart::tiffio;
+namespace vct = volcart::texturing;
+
+using Part = vct::TexturePart;
+
+TEST(TextureParts, PartsCoverTexture)
+{
+    const int width{300};
+    const int height{1100};
+    for (std::size_t count = 1; count <= 5; count++) {
+        int next{0};
+        for (std::size_t i = 0; i < count; i++) {
+            auto part = Part::Make(width, height, i, count);
+            EXPECT_EQ(part.region.x, 0);
+            EXPECT_EQ(part.region.y, next);
+            EXPECT_EQ(part.region.width, width);
+            EXPECT_GT(part.region.height, 0);
+            EXPECT_EQ(part.region.y % Part::PART_ROW_MULTIPLE, 0);
+            next += part.region.height;
+        }
+        EXPECT_EQ(next, height);
+    }
+
+    EXPECT_THROW(Part::Make(width, height, 2, 2), std::invalid_argument);
+    EXPECT_THROW(Part::Make(width, height, 0, 6), std::invalid_argument);
+}
+
+TEST(TextureParts, WriteAndMerge)
+{
+    const int width{301};
+    const int height{700};
+    cv::Mat full(height, width, CV_16UC1);
+    cv::randu(full, 0, 65535);
+
+    fs::path dir{"vc_texturing_TextureParts"};
+    fs::remove_all(dir);
+    fs::create_directory(dir);
+
+    // Write the parts out of order
+    const std::size_t count{3};
+    std::vector<Part> parts;
+    for (auto i : {2, 0, 1}) {
+        auto part = Part::Make(width, height, i, count);
+        part.image = dir / ("part_" + std::to_string(i) + ".tif");
+        vct::WriteTexturePart(part, full(part.region));
+        parts.emplace_back(vct::ReadTexturePart(part.image));
+        EXPECT_EQ(parts.back().region, part.region);
+        EXPECT_EQ(parts.back().image, part.image);
+    }
+
+    for (const auto& ext : {".tif", ".dzi"}) {
+        auto output = dir / (std::string("merged") + ext);
+        vct::MergeTextureParts(parts, output);
+        EXPECT_TRUE(fs::exists(output));
+    }
+    auto merged = tio::ReadTIFF(dir / "merged.tif");
+    ASSERT_EQ(merged.size(), full.size());
+    EXPECT_EQ(cv::countNonZero(merged != full), 0);
+}
+
+TEST(TextureParts, VerifyCoverage)
+{
+    fs::path dir{"vc_texturing_TexturePartsVerify"};
+    fs::remove_all(dir);
+    fs::create_directory(dir);
+
+    std::vector<Part> parts;
+    for (std::size_t i = 0; i < 3; i++) {
+        auto part = Part::Make(64, 600, i, 3);
+        part.image = dir / ("part_" + std::to_string(i) + ".tif");
+        cv::Mat img(part.region.size(), CV_8UC1, cv::Scalar(i));
+        vct::WriteTexturePart(part, img);
+        parts.emplace_back(part);
+    }
+    EXPECT_EQ(vct::VerifyTextureParts(parts).size(), 3);
+
+    // Missing part
+    auto missing = parts;
+    missing.erase(missing.begin() + 1);
+    EXPECT_THROW(vct::VerifyTextureParts(missing), std::runtime_error);
+
+    // Duplicate part
+    auto duplicate = parts;
+    duplicate.emplace_back(parts[1]);
+    EXPECT_THROW(vct::VerifyTextureParts(duplicate), std::runtime_error);
+
+    // Part of a different texture
+    auto other = parts;
+    other[2].height = 1000;
+    EXPECT_THROW(vct::VerifyTextureParts(other), std::runtime_error);
+
+    // Missing image
+    fs::remove(parts[0].image);
+    EXPECT_THROW(vct::VerifyTextureParts(parts), std::runtime_error);
+}
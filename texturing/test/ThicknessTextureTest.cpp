@@ -0,0 +1,56 @@
+#include <gtest/gtest.h>
+
+#include <opencv2/core.hpp>
+
+#include "vc/core/types/PerPixelMap.hpp"
+#include "vc/core/types/VolumetricMask.hpp"
+#include "vc/texturing/ThicknessTexture.hpp"
+
+using namespace volcart;
+using namespace volcart::texturing;
+
+TEST(ThicknessTexture, DistanceFieldMatchesMarch)
+{
+    // Ball thick enough to contain full mask blocks
+    auto mask = VolumetricMask::New();
+    const cv::Vec3i center{40, 40, 40};
+    for (int z = 0; z < 80; z++) {
+        for (int y = 0; y < 80; y++) {
+            for (int x = 0; x < 80; x++) {
+                cv::Vec3i v{x, y, z};
+                if (cv::norm(v - center) < 35) {
+                    mask->setIn(v);
+                }
+            }
+        }
+    }
+
+    // Pixels start near the center of the ball with random normals
+    auto ppm = PerPixelMap::New(10, 10);
+    cv::RNG rng(1234);
+    for (size_t y = 0; y < 10; y++) {
+        for (size_t x = 0; x < 10; x++) {
+            cv::Vec3d n{
+                rng.uniform(-1., 1.), rng.uniform(-1., 1.),
+                rng.uniform(-1., 1.)};
+            n = cv::normalize(n);
+            (*ppm)(y, x) = {
+                rng.uniform(30., 50.), rng.uniform(30., 50.),
+                rng.uniform(30., 50.), n[0], n[1], n[2]};
+        }
+    }
+
+    ThicknessTexture texture;
+    texture.setPerPixelMap(ppm);
+    texture.setVolumetricMask(mask);
+    texture.setNormalizeOutput(false);
+    for (auto interval : {1.0, 0.3}) {
+        texture.setSamplingInterval(interval);
+        texture.setUseDistanceField(false);
+        auto expected = texture.compute().at(0).clone();
+        texture.setUseDistanceField(true);
+        auto result = texture.compute().at(0);
+        EXPECT_EQ(cv::countNonZero(expected != result), 0);
+        EXPECT_GT(cv::countNonZero(result > 40), 0);
+    }
+}
@@ -0,0 +1,155 @@
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <stdexcept>
+
+#include <opencv2/core.hpp>
+
+#include "vc/core/filesystem.hpp"
+#include "vc/core/io/TIFFIO.hpp"
+#include "vc/core/neighborhood/LineGenerator.hpp"
+#include "vc/core/shapes/Plane.hpp"
+#include "vc/core/types/Volume.hpp"
+#include "vc/core/util/Iteration.hpp"
+#include "vc/texturing/CompositeTexture.hpp"
+#include "vc/texturing/PPMGenerator.hpp"
+#include "vc/texturing/TiledTexturing.hpp"
+
+using namespace volcart;
+using namespace volcart::texturing;
+namespace fs = volcart::filesystem;
+
+namespace
+{
+// Returns an 8-bit image for the first tile and 16-bit images afterwards
+class ChangingType : public TexturingAlgorithm
+{
+public:
+    auto compute() -> Texture override
+    {
+        auto type = (calls_++ == 0) ? CV_8UC1 : CV_16UC1;
+        return {cv::Mat::zeros(
+            static_cast<int>(ppm_->height()), static_cast<int>(ppm_->width()),
+            type)};
+    }
+
+private:
+    int calls_{0};
+};
+
+class TiledTexturingFixture : public ::testing::Test
+{
+public:
+    void SetUp() override
+    {
+        // Random volume
+        const fs::path volPath{"vc_texturing_TiledTexturing_volume"};
+        fs::remove_all(volPath);
+        fs::create_directory(volPath);
+        vol_ = Volume::New(volPath, "TiledTexturing", "TiledTexturing");
+        vol_->setSliceWidth(40);
+        vol_->setSliceHeight(40);
+        vol_->setNumberOfSlices(40);
+        vol_->saveMetadata();
+        cv::RNG rng(1234);
+        for (int z = 0; z < 40; z++) {
+            cv::Mat slice(40, 40, CV_16UC1);
+            rng.fill(slice, cv::RNG::UNIFORM, 0, 65536);
+            vol_->setSliceData(z, slice);
+        }
+
+        // Plane through the middle of the volume
+        shapes::Plane plane(5, 5);
+        mesh_ = plane.itkMesh();
+        for (auto it = mesh_->GetPoints()->Begin();
+             it != mesh_->GetPoints()->End(); ++it) {
+            auto& pt = it.Value();
+            pt[0] = 4 + 8 * pt[0];
+            pt[1] = 20;
+            pt[2] = 4 + 8 * pt[2];
+        }
+        uvMap_ = UVMap::New();
+        std::size_t id{0};
+        for (const auto uv : range2D(5, 5)) {
+            auto u = double(uv.first) / 4.0;
+            auto v = double(uv.second) / 4.0;
+            uvMap_->set(id++, {u, v});
+        }
+    }
+
+    void setupPPMGenerator(PPMGenerator& gen) const
+    {
+        gen.setDimensions(HEIGHT, WIDTH);
+        gen.setMesh(mesh_);
+        gen.setUVMap(uvMap_);
+        gen.setEngine(PPMGenerator::Engine::Rasterize);
+    }
+
+    auto compositeTexture() const -> CompositeTexture::Pointer
+    {
+        auto line = LineGenerator::New();
+        line->setSamplingRadius(2);
+        line->setSamplingInterval(0.5);
+        auto t = CompositeTexture::New();
+        t->setVolume(vol_);
+        t->setGenerator(line);
+        t->setFilter(CompositeTexture::Filter::Maximum);
+        return t;
+    }
+
+    // Not a multiple of the tile size, so the last tiles are partial
+    static constexpr int HEIGHT{100};
+    static constexpr int WIDTH{90};
+
+    Volume::Pointer vol_;
+    ITKMesh::Pointer mesh_;
+    UVMap::Pointer uvMap_;
+};
+}  // namespace
+
+TEST_F(TiledTexturingFixture, MatchesUntiledTexture)
+{
+    // Texture the whole PPM
+    PPMGenerator gen;
+    setupPPMGenerator(gen);
+    auto untiled = compositeTexture();
+    untiled->setPerPixelMap(gen.compute());
+    auto expected = untiled->compute().at(0);
+
+    // Texture one tile at a time
+    TiledTexturing tiled;
+    setupPPMGenerator(tiled.ppmGenerator());
+    tiled.setTexturingAlgorithm(compositeTexture());
+    tiled.setTileSize(32);
+    tiled.setOutputPath("vc_texturing_TiledTexturing.tif");
+    auto paths = tiled.compute();
+    ASSERT_EQ(paths.size(), 1U);
+    EXPECT_EQ(tiled.progressIterations(), 12U);
+
+    auto result = tiffio::ReadTIFF(paths[0]);
+    ASSERT_EQ(result.size(), expected.size());
+    ASSERT_EQ(result.type(), expected.type());
+    EXPECT_EQ(cv::norm(result, expected, cv::NORM_INF), 0);
+}
+
+TEST_F(TiledTexturingFixture, ImageTypeMustNotChange)
+{
+    TiledTexturing tiled;
+    setupPPMGenerator(tiled.ppmGenerator());
+    tiled.setTexturingAlgorithm(std::make_shared<ChangingType>());
+    tiled.setTileSize(64);
+    tiled.setOutputPath("vc_texturing_TiledTexturing_ChangingType.tif");
+    EXPECT_THROW(tiled.compute(), std::runtime_error);
+}
+
+TEST(TiledTexturing, TileSize)
+{
+    TiledTexturing tiled;
+    tiled.setTileSize(100);
+    EXPECT_EQ(tiled.tileSize(), 112U);
+    EXPECT_EQ(
+        TiledTexturing::TileSizeForBudget(
+            64 * 64 * TiledTexturing::BYTES_PER_PIXEL),
+        64U);
+    EXPECT_EQ(TiledTexturing::TileSizeForBudget(0), 16U);
+}
@@ -0,0 +1,120 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+#include "vc/core/shapes/Plane.hpp"
+#include "vc/texturing/AngleBasedFlattening.hpp"
+#include "vc/texturing/UVAtlas.hpp"
+
+using namespace volcart;
+using namespace volcart::shapes;
+using namespace volcart::texturing;
+
+namespace
+{
+struct Flattened {
+    ITKMesh::Pointer mesh;
+    UVMap::Pointer uvMap;
+};
+
+auto FlatPlane(int width, int height) -> Flattened
+{
+    Plane plane(width, height);
+    auto mesh = plane.itkMesh();
+    AngleBasedFlattening abf(mesh);
+    abf.compute();
+    return {mesh, abf.getUVMap()};
+}
+}  // namespace
+
+TEST(UVAtlas, PackRectanglesWithoutOverlap)
+{
+    std::vector<cv::Vec2d> sizes{{4, 2}, {1, 5}, {3, 3}, {2, 1}, {6, 1}};
+    auto corners = PackRectangles(sizes, 0.05);
+    ASSERT_EQ(corners.size(), sizes.size());
+    for (std::size_t i = 0; i < sizes.size(); i++) {
+        cv::Rect2d a(corners[i][0], corners[i][1], sizes[i][0], sizes[i][1]);
+        EXPECT_GE(a.x, 0);
+        EXPECT_GE(a.y, 0);
+        for (std::size_t j = i + 1; j < sizes.size(); j++) {
+            cv::Rect2d b(
+                corners[j][0], corners[j][1], sizes[j][0], sizes[j][1]);
+            EXPECT_LE((a & b).area(), 0) << i << ", " << j;
+        }
+    }
+}
+
+TEST(UVAtlas, MergeSegments)
+{
+    auto small = FlatPlane(5, 5);
+    auto large = FlatPlane(10, 8);
+
+    UVAtlas atlas;
+    EXPECT_EQ(atlas.addSegment(small.mesh, small.uvMap), 0U);
+    EXPECT_EQ(atlas.addSegment(large.mesh, large.uvMap), 1U);
+    EXPECT_EQ(atlas.numSegments(), 2U);
+    atlas.compute();
+
+    // Meshes are concatenated
+    auto mesh = atlas.getMesh();
+    auto uvMap = atlas.getUVMap();
+    auto numSmall = small.mesh->GetNumberOfPoints();
+    EXPECT_EQ(
+        mesh->GetNumberOfPoints(),
+        numSmall + large.mesh->GetNumberOfPoints());
+    EXPECT_EQ(
+        mesh->GetNumberOfCells(),
+        small.mesh->GetNumberOfCells() + large.mesh->GetNumberOfCells());
+    EXPECT_EQ(atlas.vertexOffset(1), numSmall);
+    EXPECT_EQ(atlas.faceOffset(1), small.mesh->GetNumberOfCells());
+    EXPECT_EQ(uvMap->size(), mesh->GetNumberOfPoints());
+    for (std::size_t v = 0; v < numSmall; v++) {
+        EXPECT_EQ(mesh->GetPoint(v), small.mesh->GetPoint(v));
+    }
+
+    // Segments keep their scale and don't overlap
+    auto ratio = uvMap->ratio();
+    std::vector<Flattened> segments{small, large};
+    for (std::size_t i = 0; i < segments.size(); i++) {
+        auto b = atlas.segmentBounds(i);
+        auto r = segments[i].uvMap->ratio();
+        EXPECT_NEAR(b.width, r.width, 1e-6 * r.width);
+        EXPECT_NEAR(b.height, r.height, 1e-6 * r.height);
+        EXPECT_LE(b.x + b.width, ratio.width + 1e-9);
+        EXPECT_LE(b.y + b.height, ratio.height + 1e-9);
+    }
+    auto overlap = atlas.segmentBounds(0) & atlas.segmentBounds(1);
+    EXPECT_LE(overlap.area(), 0);
+
+    // Every UV is in the bounds of its segment
+    for (std::size_t v = 0; v < mesh->GetNumberOfPoints(); v++) {
+        auto b = atlas.segmentBounds(v < numSmall ? 0 : 1);
+        auto uv = uvMap->get(v, UVMap::Origin::TopLeft);
+        auto x = uv[0] * ratio.width;
+        auto y = uv[1] * ratio.height;
+        EXPECT_GE(x, b.x - 1e-9);
+        EXPECT_LE(x, b.x + b.width + 1e-9);
+        EXPECT_GE(y, b.y - 1e-9);
+        EXPECT_LE(y, b.y + b.height + 1e-9);
+    }
+
+    // Pixel regions cover the bounds and stay in the image
+    auto w = static_cast<std::size_t>(ratio.width * 2);
+    auto h = static_cast<std::size_t>(ratio.height * 2);
+    for (std::size_t i = 0; i < segments.size(); i++) {
+        auto region = atlas.segmentRegion(i, w, h);
+        auto b = atlas.segmentBounds(i);
+        EXPECT_GE(region.width, static_cast<int>(b.width * 2));
+        EXPECT_GE(region.height, static_cast<int>(b.height * 2));
+        EXPECT_LE(region.x + region.width, static_cast<int>(w));
+        EXPECT_LE(region.y + region.height, static_cast<int>(h));
+    }
+}
+
+TEST(UVAtlas, NoSegments)
+{
+    UVAtlas atlas;
+    EXPECT_THROW(atlas.compute(), std::invalid_argument);
+}
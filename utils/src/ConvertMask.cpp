@@ -1,9 +1,13 @@
 // vc_convert_mask: Bidirectional conversion between Point Mask (.vcps) and
 // Volume Mask (Image sequence)
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <map>
 #include <regex>
 #include <sstream>
+#include <vector>
 
 #include <boost/program_options.hpp>
 #include <opencv2/core.hpp>
@@ -12,11 +16,14 @@
 #include "vc/app_support/ProgressIndicator.hpp"
 #include "vc/core/filesystem.hpp"
 #include "vc/core/io/FileExtensionFilter.hpp"
+#include "vc/core/io/MappedPointSet.hpp"
 #include "vc/core/io/PointSetIO.hpp"
 #include "vc/core/types/VolumePkg.hpp"
 #include "vc/core/util/FormatStrToRegexStr.hpp"
 #include "vc/core/util/Iteration.hpp"
 #include "vc/core/util/Logging.hpp"
+#include "vc/core/util/ProgressCounter.hpp"
+#include "vc/core/util/ThreadPool.hpp"
 
 namespace fs = volcart::filesystem;
 namespace po = boost::program_options;
@@ -42,7 +49,10 @@ int main(int argc, char* argv[])
     all.add_options()
         ("help,h", "Show this message")
         ("input,i", po::value<std::string>()->required(), "Path to the input mask")
-        ("output,o", po::value<std::string>()->required(), "Path to the output mask");
+        ("output,o", po::value<std::string>()->required(), "Path to the output mask")
+        ("threads", po::value<std::size_t>()->default_value(0), "Number of "
+            "threads used to write mask slices. If 0, uses one thread per CPU "
+            "core.");
 
     po::options_description ps2vmOpts("PointSet to Volume Mask Options");
     ps2vmOpts.add_options()
@@ -70,6 +80,8 @@ int main(int argc, char* argv[])
         return EXIT_FAILURE;
     }
 
+    vc::ThreadPool::SetGlobalThreads(parsed["threads"].as<std::size_t>());
+
     // Get the input and output paths
     fs::path inPath = parsed["input"].as<std::string>();
     fs::path outPath = parsed["output"].as<std::string>();
@@ -122,37 +134,116 @@ void PointMaskToVolumeMask(
     const fs::path& outDir,
     const vc::Volume::Pointer& volume)
 {
-    // Read the points
+    // Map the points instead of reading them into memory
     vc::Logger()->info("Loading point mask");
-    auto ptsRaw = vc::PointSetIO<cv::Vec3i>::ReadPointSet(ptsPath);
-
-    // Sort the points
-    vc::Logger()->info("Sorting points");
-    auto pts = ptsRaw.as_vector();
-    std::sort(pts.begin(), pts.end(), [](const auto& a, const auto& b) {
-        return a[2] < b[2];
+    const vc::MappedPointSet<cv::Vec3i> mapped{ptsPath};
+    const auto pts = mapped.begin();
+    const auto numSlices = static_cast<std::size_t>(volume->numSlices());
+    const cv::Size sliceSize(volume->sliceWidth(), volume->sliceHeight());
+    const cv::Rect bounds({0, 0}, sliceSize);
+    const auto n = mapped.size();
+
+    // Count the points of each slice in contiguous chunks of the point set.
+    // Points are usually stored in slice order, in which case every slice is
+    // already a contiguous range of points.
+    vc::Logger()->info("Counting points");
+    const auto numChunks = std::min<std::size_t>(
+        std::max<std::size_t>(n, 1), 4 * vc::ThreadPool::Global().numThreads());
+    auto chunkBegin = [&](std::size_t c) { return n * c / numChunks; };
+    std::vector<std::vector<std::size_t>> counts(numChunks);
+    std::vector<char> chunkSorted(numChunks, 1);
+    std::atomic<std::size_t> skipped{0};
+    vc::ParallelFor(vc::range(numChunks), [&](auto c) {
+        auto& count = counts[c];
+        count.assign(numSlices, 0);
+        int lastZ{-1};
+        for (auto i = chunkBegin(c); i < chunkBegin(c + 1); i++) {
+            auto p = pts[i];
+            if (p[2] < 0 or static_cast<std::size_t>(p[2]) >= numSlices or
+                not bounds.contains({p[0], p[1]})) {
+                skipped++;
+                continue;
+            }
+            chunkSorted[c] &= static_cast<char>(p[2] >= lastZ);
+            lastZ = p[2];
+            count[p[2]]++;
+        }
     });
+    if (skipped > 0) {
+        vc::Logger()->warn(
+            "Skipping {} points outside of the volume", skipped.load());
+    }
 
-    // Mask the images
-    vc::Logger()->info("Converting mask");
-    size_t pad = std::to_string(volume->numSlices()).size();
-    int sliceNum{pts[0][2]};
-    cv::Size sliceSize(volume->sliceWidth(), volume->sliceHeight());
-    cv::Mat slice = cv::Mat::zeros(sliceSize, CV_8UC1);
-    for (const auto& p : vc::ProgressWrap(pts, "Masking voxels")) {
-        // If the slice number changes...
-        if (p[2] > sliceNum) {
-            // Write mask
-            WriteMaskImage(sliceNum, pad, outDir, slice);
-
-            // Set the new slice number and clear the slice
-            sliceNum = p[2];
-            slice = cv::Mat::zeros(sliceSize, CV_8UC1);
+    // Offset of each slice's points, and of each chunk's points within them
+    std::vector<std::size_t> sliceBegin(numSlices + 1, 0);
+    std::vector<std::vector<std::size_t>> offsets(
+        numChunks, std::vector<std::size_t>(numSlices));
+    for (std::size_t z = 0; z < numSlices; z++) {
+        auto offset = sliceBegin[z];
+        for (std::size_t c = 0; c < numChunks; c++) {
+            offsets[c][z] = offset;
+            offset += counts[c][z];
         }
+        sliceBegin[z + 1] = offset;
+    }
+    counts.clear();
+
+    // Sorted point sets are sliced in place. Otherwise, the points are
+    // bucketed by slice, keeping only their xy-coordinates.
+    auto sorted = skipped == 0 and
+                  std::all_of(chunkSorted.begin(), chunkSorted.end(),
+                              [](auto s) { return s != 0; });
+    for (std::size_t c = 1; c < numChunks and sorted; c++) {
+        sorted = pts[chunkBegin(c) - 1][2] <= pts[chunkBegin(c)][2];
+    }
+    std::vector<cv::Vec2i> buckets;
+    if (not sorted) {
+        vc::Logger()->info("Bucketing points by slice");
+        buckets.resize(sliceBegin.back());
+        vc::ParallelFor(vc::range(numChunks), [&](auto c) {
+            auto& offset = offsets[c];
+            for (auto i = chunkBegin(c); i < chunkBegin(c + 1); i++) {
+                auto p = pts[i];
+                if (p[2] < 0 or static_cast<std::size_t>(p[2]) >= numSlices or
+                    not bounds.contains({p[0], p[1]})) {
+                    continue;
+                }
+                buckets[offset[p[2]]++] = {p[0], p[1]};
+            }
+        });
+    }
+    offsets.clear();
 
-        slice.at<uint8_t>(p[1], p[0]) = 255;
+    // Rasterize and write the slices in parallel
+    std::vector<std::size_t> slices;
+    for (std::size_t z = 0; z < numSlices; z++) {
+        if (sliceBegin[z + 1] > sliceBegin[z]) {
+            slices.emplace_back(z);
+        }
     }
-    WriteMaskImage(sliceNum, pad, outDir, slice);
+    vc::Logger()->info("Writing {} mask slices", slices.size());
+    auto pad = std::to_string(numSlices).size();
+    vc::ProgressCounter progress(slices.size(), std::chrono::seconds(5));
+    vc::ParallelFor(vc::range(slices.size()), [&](auto s) {
+        auto z = slices[s];
+        cv::Mat slice = cv::Mat::zeros(sliceSize, CV_8UC1);
+        for (auto i = sliceBegin[z]; i < sliceBegin[z + 1]; i++) {
+            if (sorted) {
+                auto p = pts[i];
+                slice.at<uint8_t>(p[1], p[0]) = 255;
+            } else {
+                const auto& p = buckets[i];
+                slice.at<uint8_t>(p[1], p[0]) = 255;
+            }
+        }
+        WriteMaskImage(static_cast<int>(z), pad, outDir, slice);
+
+        progress.add();
+        if (progress.shouldReport()) {
+            vc::Logger()->info(
+                "Wrote {}/{} mask slices", progress.count(), progress.total());
+        }
+    });
 }
 
 void WriteMaskImage(
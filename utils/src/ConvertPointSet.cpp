@@ -1,4 +1,7 @@
+#include <algorithm>
 #include <cmath>
+#include <numeric>
+#include <vector>
 
 #include <boost/program_options.hpp>
 
@@ -10,19 +13,31 @@
 #include "vc/core/io/PLYReader.hpp"
 #include "vc/core/io/PLYWriter.hpp"
 #include "vc/core/io/PointSetIO.hpp"
+#include "vc/core/io/PointSetReader.hpp"
 #include "vc/core/types/ITKMesh.hpp"
 #include "vc/core/types/VolumePkg.hpp"
 #include "vc/core/util/Iteration.hpp"
 #include "vc/core/util/Logging.hpp"
+#include "vc/core/util/ThreadPool.hpp"
 
 namespace fs = volcart::filesystem;
 namespace po = boost::program_options;
 namespace vc = volcart;
 
 using psio = vc::PointSetIO<cv::Vec3d>;
-using vc::enumerate;
+
+// Number of points read at a time when streaming a PointSet
+constexpr std::size_t POINTS_PER_CHUNK = 1 << 16;
+// Number of z-sorted points sampled in parallel at a time. Keeps the workers
+// in neighboring slices so that they share the slice cache.
+constexpr std::size_t POINTS_PER_WINDOW = 1 << 20;
+// Number of points interpolated in one batch
+constexpr std::size_t POINTS_PER_BATCH = 1 << 10;
 
 void PointSetToMesh(const fs::path& inputPath, const fs::path& outputPath);
+auto SampleIntensities(
+    const vc::Volume& volume, const vc::ITKMesh::Pointer& mesh)
+    -> std::vector<uint16_t>;
 void MeshToPointSet(const fs::path& inputPath, const fs::path& outputPath);
 
 po::variables_map PARSED;
@@ -76,10 +91,25 @@ int main(int argc, char* argv[])
 
 void PointSetToMesh(const fs::path& inputPath, const fs::path& outputPath)
 {
-    // Load the file
+    vc::ITKPoint tmpPt;
+    auto mesh = vc::ITKMesh::New();
+
+    // Stream the file into the ITKMesh without holding a second copy of the
+    // points in memory
     vc::Logger()->info("Loading file...");
-    auto inputCloud = psio::ReadPointSet(inputPath);
-    vc::Logger()->info("Loaded PointSet with {} points", inputCloud.size());
+    vc::PointSetReader<cv::Vec3d> reader(inputPath);
+    std::vector<cv::Vec3d> chunk;
+    while (reader.read(chunk, POINTS_PER_CHUNK) > 0) {
+        for (const auto& pt : chunk) {
+            tmpPt[0] = pt[0];
+            tmpPt[1] = pt[1];
+            tmpPt[2] = pt[2];
+
+            mesh->SetPoint(mesh->GetNumberOfPoints(), tmpPt);
+        }
+    }
+    vc::Logger()->info(
+        "Loaded PointSet with {} points", mesh->GetNumberOfPoints());
 
     // Add vertex intensity
     std::vector<uint16_t> intensities;
@@ -97,26 +127,7 @@ void PointSetToMesh(const fs::path& inputPath, const fs::path& outputPath)
             volume = volpkg.volume();
         }
 
-        // Sort cloud by z-index to avoid cache thrashing
-        std::sort(
-            inputCloud.begin(), inputCloud.end(),
-            [](const auto& l, const auto& r) { return l[2] < r[2]; });
-
-        // Get color info
-        for (const auto& pt : inputCloud) {
-            intensities.emplace_back(volume->interpolateAt(pt));
-        }
-    }
-
-    // Convert to ITKMesh
-    vc::ITKPoint tmpPt;
-    auto mesh = vc::ITKMesh::New();
-    for (const auto it : enumerate(inputCloud)) {
-        tmpPt[0] = it.second[0];
-        tmpPt[1] = it.second[1];
-        tmpPt[2] = it.second[2];
-
-        mesh->SetPoint(it.first, tmpPt);
+        intensities = SampleIntensities(*volume, mesh);
     }
 
     // Write the file
@@ -139,6 +150,55 @@ void PointSetToMesh(const fs::path& inputPath, const fs::path& outputPath)
     }
 }
 
+auto SampleIntensities(
+    const vc::Volume& volume, const vc::ITKMesh::Pointer& mesh)
+    -> std::vector<uint16_t>
+{
+    // Sample the points in z order to avoid cache thrashing
+    const auto numPoints = static_cast<std::size_t>(mesh->GetNumberOfPoints());
+    std::vector<double> zs(numPoints);
+    for (std::size_t i = 0; i < numPoints; i++) {
+        zs[i] = mesh->GetPoint(i)[2];
+    }
+    std::vector<std::size_t> order(numPoints);
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&zs](auto l, auto r) {
+        return zs[l] < zs[r];
+    });
+    std::vector<double>().swap(zs);
+
+    // Interpolate each window of sorted points in parallel batches
+    std::vector<uint16_t> intensities(numPoints);
+    const auto numWindows =
+        (numPoints + POINTS_PER_WINDOW - 1) / POINTS_PER_WINDOW;
+    for (auto w : vc::ProgressWrap(vc::range(numWindows), "Sampling:")) {
+        const auto first = w * POINTS_PER_WINDOW;
+        const auto last = std::min(first + POINTS_PER_WINDOW, numPoints);
+        const auto numBatches =
+            (last - first + POINTS_PER_BATCH - 1) / POINTS_PER_BATCH;
+        vc::ParallelChunks(numBatches, 0, [&](auto begin, auto end) {
+            std::vector<cv::Vec3d> pts;
+            std::vector<uint16_t> values;
+            for (auto b = begin; b < end; b++) {
+                const auto bFirst = first + b * POINTS_PER_BATCH;
+                const auto bLast = std::min(bFirst + POINTS_PER_BATCH, last);
+                pts.clear();
+                for (auto i = bFirst; i < bLast; i++) {
+                    auto p = mesh->GetPoint(order[i]);
+                    pts.emplace_back(p[0], p[1], p[2]);
+                }
+                values.resize(pts.size());
+                volume.interpolateAt(pts.data(), pts.size(), values.data());
+                for (auto i = bFirst; i < bLast; i++) {
+                    intensities[order[i]] = values[i - bFirst];
+                }
+            }
+        });
+    }
+
+    return intensities;
+}
+
 void MeshToPointSet(const fs::path& inputPath, const fs::path& outputPath)
 {
     // Load the file
@@ -1,7 +1,5 @@
-#include <algorithm>
 #include <fstream>
 #include <iostream>
-#include <numeric>
 #include <string>
 #include <vector>
 
@@ -11,15 +9,17 @@
 
 #include "vc/app_support/ProgressIndicator.hpp"
 #include "vc/core/filesystem.hpp"
+#include "vc/core/types/ImageStatistics.hpp"
+#include "vc/core/types/VolumePkg.hpp"
+#include "vc/core/util/ImageConversion.hpp"
 #include "vc/core/util/Iteration.hpp"
 #include "vc/core/util/Logging.hpp"
+#include "vc/core/util/ThreadPool.hpp"
 
 namespace fs = volcart::filesystem;
 namespace po = boost::program_options;
 namespace vc = volcart;
 
-float GetValue(int x, int y, const cv::Mat& m);
-
 int main(int argc, char* argv[])
 {
     ///// Parse the command line options /////
@@ -28,13 +28,20 @@ int main(int argc, char* argv[])
     po::options_description all("Usage");
     all.add_options()
         ("help,h", "Show this message")
-        ("input,i", po::value<std::string>()->required(),
+        ("input,i", po::value<std::string>(),
              "Path to a texture image.")
+        ("volpkg,v", po::value<std::string>(),
+             "Compute the statistics of a volume in this VolumePkg instead "
+             "of an image.")
+        ("volume", po::value<std::string>(),
+             "Volume to use with --volpkg. Default: The first volume.")
         ("output,o", po::value<std::string>()->required(),
              "Path to an output CSV file.")
         ("mask,m", po::value<std::string>(),
              "Path to the mask file.")
-        ("class,c", po::value<std::vector<std::string>>(), "Path to a class mask file.");
+        ("class,c", po::value<std::vector<std::string>>(), "Path to a class mask file.")
+        ("threads", po::value<size_t>()->default_value(0),
+             "Number of worker threads. If 0, uses one thread per CPU core.");
     // clang-format on
 
     // parsed will hold the values of all parsed options as a Map
@@ -55,136 +62,88 @@ int main(int argc, char* argv[])
         return EXIT_FAILURE;
     }
 
+    auto useVolume = parsed.count("volpkg") > 0;
+    if (useVolume == (parsed.count("input") > 0)) {
+        vc::Logger()->error("Provide exactly one of --input or --volpkg");
+        return EXIT_FAILURE;
+    }
+    if (useVolume and (parsed.count("mask") > 0 or parsed.count("class") > 0)) {
+        vc::Logger()->error("Masks are only supported with --input");
+        return EXIT_FAILURE;
+    }
+    vc::ThreadPool::SetGlobalThreads(parsed["threads"].as<size_t>());
+
     // Get paths
-    fs::path inputPath = parsed["input"].as<std::string>();
     fs::path outputPath = parsed["output"].as<std::string>();
 
-    // Load the input image
-    auto img = cv::imread(inputPath.string(), cv::IMREAD_UNCHANGED);
-    std::vector<float> allVals;
-
-    // Load mask
-    cv::Mat mask;
-    if (parsed.count("mask") > 0) {
-        auto maskPath = parsed["mask"].as<std::string>();
-        mask = cv::imread(maskPath, cv::IMREAD_GRAYSCALE);
-    }
-
-    // Load the class masks
+    // Class names. "all" covers every (masked) pixel.
     std::vector<std::string> classNames{"all"};
-    std::vector<cv::Mat> classMasks;
-    std::vector<std::vector<float>> classVals;
-    for (const auto& p : parsed["class"].as<std::vector<std::string>>()) {
-        auto m = cv::imread(p, cv::IMREAD_GRAYSCALE);
-        if (m.empty()) {
-            continue;
+    std::vector<vc::ImageStatistics> stats(1);
+
+    if (useVolume) {
+        // Stream the volume one slice at a time
+        auto vpkg = vc::VolumePkg::New(parsed["volpkg"].as<std::string>());
+        auto volume = parsed.count("volume") > 0
+                          ? vpkg->volume(parsed["volume"].as<std::string>())
+                          : vpkg->volume();
+        volume->setCacheCapacity(1);
+        auto bar = vc::NewProgressBar(volume->numSlices(), "Slices");
+        for (const auto z : vc::range(volume->numSlices())) {
+            stats[0].add(volume->getSliceData(z));
+            bar->tick();
         }
-        classNames.push_back(fs::path(p).stem().string());
-        classMasks.push_back(m);
-        classVals.emplace_back();
-    }
-
-    // Iterate over the image pixels
-    using vc::ProgressWrap;
-    using vc::range2D;
-    for (const auto pixel :
-         ProgressWrap(range2D(img.rows, img.cols), "Collecting values")) {
-        const auto& x = pixel.second;
-        const auto& y = pixel.first;
-
-        // Skip if we have a mask and this pixel isn't in it
-        if (not mask.empty() and mask.at<uint8_t>(y, x) == 0) {
-            continue;
+        bar->mark_as_completed();
+    } else {
+        // Load the input image
+        fs::path inputPath = parsed["input"].as<std::string>();
+        auto img = cv::imread(inputPath.string(), cv::IMREAD_UNCHANGED);
+        if (img.empty()) {
+            vc::Logger()->error("Failed to read image: {}", inputPath.string());
+            return EXIT_FAILURE;
+        }
+        if (img.channels() > 1) {
+            img = vc::ColorConvertImage(img, 1);
         }
 
-        // Get the pixel value
-        auto val = GetValue(x, y, img);
-
-        // Add to the all values list
-        allVals.push_back(val);
+        // Load mask
+        cv::Mat mask;
+        if (parsed.count("mask") > 0) {
+            auto maskPath = parsed["mask"].as<std::string>();
+            mask = cv::imread(maskPath, cv::IMREAD_GRAYSCALE);
+        }
+        stats[0].add(img, mask);
 
-        // Add to the class lists
-        using vc::enumerate;
-        for (const auto it : enumerate(classMasks)) {
-            const auto& idx = it.first;
-            const auto& cmask = it.second;
-            if (cmask.at<uint8_t>(y, x) > 0) {
-                classVals[idx].push_back(val);
+        // Each class only covers the pixels in both its mask and the mask
+        std::vector<std::string> classPaths;
+        if (parsed.count("class") > 0) {
+            classPaths = parsed["class"].as<std::vector<std::string>>();
+        }
+        for (const auto& p : classPaths) {
+            auto m = cv::imread(p, cv::IMREAD_GRAYSCALE);
+            if (m.empty()) {
+                continue;
             }
+            if (not mask.empty()) {
+                m.setTo(0, mask == 0);
+            }
+            classNames.push_back(fs::path(p).stem().string());
+            stats.emplace_back().add(img, m);
         }
     }
 
-    // Calculate metrics
-    classVals.insert(classVals.begin(), allVals);
-    using MetricMap = std::map<std::string, float>;
-    std::vector<MetricMap> metrics;
-    for (auto& c : classVals) {
-        MetricMap m;
-
-        // Sample count
-        m["count"] = c.size();
-
-        // Mean
-        auto mean = std::accumulate(
-            c.begin(), c.end(), 0.F,
-            [size = float(c.size())](float r, float v) {
-                return r + (v / size);
-            });
-        m["mean"] = mean;
-
-        // Variance
-        auto var =
-            std::accumulate(
-                c.begin(), c.end(), 0.F,
-                [mean](auto c, auto r) { return c + std::pow(r - mean, 2); }) /
-            c.size();
-        m["var"] = var;
-
-        // Std. deviation
-        m["std_dev"] = std::sqrt(var);
-
-        // Median
-        std::nth_element(c.begin(), c.begin() + c.size() / 2, c.end());
-        m["median"] = c[c.size() / 2];
-
-        metrics.push_back(m);
-    }
-
     // Write metrics
     std::ofstream file(outputPath.string());
     if (not file.is_open()) {
         throw std::runtime_error("Couldn't open output file");
     }
     file << "class,count,mean,var,std_dev,median" << std::endl;
-    for (const auto it : vc::enumerate(metrics)) {
-        file << classNames[it.first] << ",";
-        file << static_cast<size_t>(it.second.at("count")) << ",";
-        file << it.second.at("mean") << ",";
-        file << it.second.at("var") << ",";
-        file << it.second.at("std_dev") << ",";
-        file << it.second.at("median") << std::endl;
+    for (const auto [idx, s] : vc::enumerate(stats)) {
+        file << classNames[idx] << ",";
+        file << s.count() << ",";
+        file << s.mean() << ",";
+        file << s.variance() << ",";
+        file << s.stdDev() << ",";
+        file << s.median() << std::endl;
     }
     file.close();
 }
-
-float GetValue(int x, int y, const cv::Mat& m)
-{
-    switch (m.depth()) {
-        case CV_8U:
-            return m.at<uint8_t>(y, x);
-        case CV_8S:
-            return m.at<int8_t>(y, x);
-        case CV_16U:
-            return m.at<uint16_t>(y, x);
-        case CV_16S:
-            return m.at<int16_t>(y, x);
-        case CV_32S:
-            return m.at<int32_t>(y, x);
-        case CV_32F:
-            return m.at<float>(y, x);
-        case CV_64F:
-            return m.at<double>(y, x);
-        default:
-            throw std::invalid_argument("Unsupported image depth");
-    }
-}
\ No newline at end of file
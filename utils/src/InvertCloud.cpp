@@ -40,9 +40,10 @@ int main(int argc, char** argv)
 
     // Flip the rows
     vc::OrderedPointSet<cv::Vec3d> output(input.width());
+    output.reserveRows(input.height());
     for (size_t r = 0; r < input.height(); r++) {
         size_t index = input.height() - 1 - r;
-        output.pushRow(input.getRow(index));
+        output.pushRow(input.row(index));
     }
 
     // Flip the z-indices of the pts
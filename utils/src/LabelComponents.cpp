@@ -0,0 +1,136 @@
+#include <algorithm>
+#include <iostream>
+
+#include <boost/program_options.hpp>
+
+#include "vc/app_support/GeneralOptions.hpp"
+#include "vc/app_support/ProgressIndicator.hpp"
+#include "vc/core/filesystem.hpp"
+#include "vc/core/io/VolumetricMaskIO.hpp"
+#include "vc/core/types/VolumePkg.hpp"
+#include "vc/core/util/Logging.hpp"
+#include "vc/core/util/MemorySizeStringParser.hpp"
+#include "vc/core/util/ThreadPool.hpp"
+#include "vc/segmentation/ConnectedComponents.hpp"
+
+namespace fs = volcart::filesystem;
+namespace po = boost::program_options;
+namespace vc = volcart;
+namespace vcs = volcart::segmentation;
+
+using Connectivity = vcs::ConnectedComponents3D::Connectivity;
+
+int main(int argc, char* argv[])
+{
+    ///// Parse the command line options /////
+    // clang-format off
+    po::options_description required("Required arguments");
+    required.add_options()
+        ("volpkg,v", po::value<std::string>()->required(), "VolumePkg path")
+        ("volume", po::value<std::string>(), "Volume to label. "
+            "Default: The first volume in the volume package.")
+        ("output,o", po::value<std::string>()->required(),
+            "Path to the output mask (.vcvm)");
+
+    po::options_description labelOptions("Labeling Options");
+    labelOptions.add_options()
+        ("low-thresh,l", po::value<uint16_t>()->default_value(14135),
+            "Low foreground threshold [0-65535]")
+        ("high-thresh,t", po::value<uint16_t>()->default_value(65535),
+            "High foreground threshold [0-65535]")
+        ("connectivity", po::value<int>()->default_value(26),
+            "Voxel connectivity of a component: 6 or 26")
+        ("min-size", po::value<std::size_t>()->default_value(1),
+            "Minimum number of voxels of a component in the output mask")
+        ("slab-size", po::value<std::size_t>()->default_value(64),
+            "Number of slices labeled together by each thread");
+    // clang-format on
+    po::options_description all("Usage");
+    all.add(GetGeneralOpts()).add(required).add(labelOptions);
+
+    po::variables_map parsed;
+    po::store(po::command_line_parser(argc, argv).options(all).run(), parsed);
+
+    // Show the help message
+    if (parsed.count("help") > 0 or argc < 2) {
+        std::cout << all << std::endl;
+        return EXIT_SUCCESS;
+    }
+
+    // Warn of missing options
+    try {
+        po::notify(parsed);
+    } catch (po::error& e) {
+        vc::Logger()->error(e.what());
+        return EXIT_FAILURE;
+    }
+    vc::logging::SetLogLevel(parsed["log-level"].as<std::string>());
+    vc::ThreadPool::SetGlobalThreads(parsed["threads"].as<std::size_t>());
+
+    Connectivity connectivity;
+    switch (parsed["connectivity"].as<int>()) {
+        case 6:
+            connectivity = Connectivity::Face;
+            break;
+        case 26:
+            connectivity = Connectivity::Full;
+            break;
+        default:
+            vc::Logger()->error("Connectivity must be 6 or 26");
+            return EXIT_FAILURE;
+    }
+
+    fs::path outPath = parsed["output"].as<std::string>();
+    if (outPath.extension() != ".vcvm") {
+        vc::Logger()->error("Output mask must be a .vcvm file");
+        return EXIT_FAILURE;
+    }
+
+    ///// Load the volume package /////
+    fs::path volpkgPath = parsed["volpkg"].as<std::string>();
+    auto vpkg = vc::VolumePkg::New(volpkgPath);
+
+    // Load the Volume
+    vc::Volume::Pointer volume;
+    try {
+        if (parsed.count("volume") > 0) {
+            volume = vpkg->volume(parsed["volume"].as<std::string>());
+        } else {
+            volume = vpkg->volume();
+        }
+    } catch (const std::exception& e) {
+        vc::Logger()->error("Cannot load volume: {}", e.what());
+        return EXIT_FAILURE;
+    }
+    if (parsed.count("cache-memory-limit") > 0) {
+        volume->setCacheMemoryInBytes(vc::MemorySizeStringParser(
+            parsed["cache-memory-limit"].as<std::string>()));
+    }
+
+    ///// Label the components /////
+    vcs::ConnectedComponents3D ccl;
+    ccl.setVolume(volume);
+    ccl.setLowThreshold(parsed["low-thresh"].as<uint16_t>());
+    ccl.setHighThreshold(parsed["high-thresh"].as<uint16_t>());
+    ccl.setConnectivity(connectivity);
+    ccl.setMinComponentSize(parsed["min-size"].as<std::size_t>());
+    ccl.setSlabSize(parsed["slab-size"].as<std::size_t>());
+    if (parsed["progress"].as<bool>()) {
+        vc::ReportProgress(ccl, "Labeling components");
+    }
+    auto mask = ccl.compute();
+
+    const auto& sizes = ccl.componentSizes();
+    auto minSize = ccl.minComponentSize();
+    auto kept = std::count_if(sizes.begin(), sizes.end(), [minSize](auto s) {
+        return s >= minSize;
+    });
+    vc::Logger()->info(
+        "Found {} components. Kept {} components ({} voxels).", sizes.size(),
+        kept, mask->size());
+
+    ///// Save the mask /////
+    vc::Logger()->info("Saving mask");
+    vc::io::WriteVolumetricMask(outPath, *mask);
+    return EXIT_SUCCESS;
+}
@@ -1,14 +1,23 @@
 #include <algorithm>
 #include <cctype>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <queue>
 #include <unordered_set>
+#include <utility>
+#include <vector>
 
 #include <boost/program_options.hpp>
 
 #include "vc/core/filesystem.hpp"
 #include "vc/core/io/FileExtensionFilter.hpp"
-#include "vc/core/io/PointSetIO.hpp"
+#include "vc/core/io/MappedPointSet.hpp"
+#include "vc/core/io/PointSetWriter.hpp"
 #include "vc/core/util/HashFunctions.hpp"
+#include "vc/core/util/Iteration.hpp"
 #include "vc/core/util/Logging.hpp"
+#include "vc/core/util/ThreadPool.hpp"
 
 namespace fs = volcart::filesystem;
 namespace po = boost::program_options;
@@ -17,7 +26,79 @@ namespace vc = volcart;
 // TODO: make this dynamic (int or double should work)
 using Voxel = cv::Vec3d;
 using VoxelHash = vc::Vec3Hash<Voxel>;
-using psio = vc::PointSetIO<Voxel>;
+using psw = vc::PointSetWriter<Voxel>;
+
+// A z-sorted stream of the points of an input pointset
+struct Input {
+    explicit Input(fs::path p) : path{std::move(p)}, mapped{path} {}
+
+    // Find the points to merge and their z-range. Points are streamed from
+    // the mapped file if they are already sorted by z. Otherwise, the points
+    // to merge are copied and sorted.
+    void scan(bool prune)
+    {
+        // The file name is the last slice to keep
+        auto limit = std::numeric_limits<double>::infinity();
+        auto filename = path.stem().string();
+        pruned = prune and not filename.empty() and
+                 std::all_of(filename.begin(), filename.end(), ::isdigit);
+        if (pruned) {
+            limit = std::stoi(filename);
+        }
+
+        auto byZ = [](const auto& l, const auto& r) { return l[2] < r[2]; };
+        sorted = std::is_sorted(mapped.begin(), mapped.end(), byZ);
+        if (sorted) {
+            auto last = std::upper_bound(
+                mapped.begin(), mapped.end(), limit,
+                [](auto z, const auto& p) { return z < p[2]; });
+            end = static_cast<std::size_t>(last - mapped.begin());
+        } else {
+            std::copy_if(
+                mapped.begin(), mapped.end(), std::back_inserter(points),
+                [limit](const auto& p) { return p[2] <= limit; });
+            std::stable_sort(points.begin(), points.end(), byZ);
+            end = points.size();
+        }
+        if (end > 0) {
+            minZ = pointAt(0)[2];
+            maxZ = pointAt(end - 1)[2];
+        }
+    }
+
+    // Number of points to merge
+    [[nodiscard]] auto size() const -> std::size_t { return end; }
+    // Whether every point has been merged
+    [[nodiscard]] auto done() const -> bool { return pos >= end; }
+    // Whether z is within the z-range of the points to merge
+    [[nodiscard]] auto contains(double z) const -> bool
+    {
+        return end > 0 and z >= minZ and z <= maxZ;
+    }
+    // Current point
+    [[nodiscard]] auto point() const -> Voxel { return pointAt(pos); }
+    // z-value of the current point
+    [[nodiscard]] auto z() const -> double { return pointAt(pos)[2]; }
+    // Move to the next point
+    void next() { pos++; }
+
+    fs::path path;
+    vc::MappedPointSet<Voxel> mapped;
+    // Sorted copy of the points to merge, if the file is not sorted by z
+    std::vector<Voxel> points;
+    bool sorted{true};
+    bool pruned{false};
+    std::size_t pos{0};
+    std::size_t end{0};
+    double minZ{0};
+    double maxZ{0};
+
+private:
+    [[nodiscard]] auto pointAt(std::size_t i) const -> Voxel
+    {
+        return sorted ? mapped.begin()[i] : points[i];
+    }
+};
 
 /*
  * Does a very simple merge--merges all .vcps files in a certain directory.
@@ -41,7 +122,10 @@ int main(int argc, char* argv[])
             "Path for the output merged pointset")
         ("prune,p", "Prune each pointset using its name (name the vcps file the "
             "last slice you want to keep)")
-        ("overwrite-overlap", "Overwrite overlapping z-regions with the most recent ps");
+        ("overwrite-overlap", "Overwrite overlapping z-regions with the most recent ps")
+        ("threads", po::value<std::size_t>()->default_value(0), "Number of "
+            "threads used to scan the input pointsets. If 0, uses one thread "
+            "per CPU core.");
     // clang-format on
 
     // parsed will hold the values of all parsed options as a Map
@@ -105,76 +189,102 @@ int main(int argc, char* argv[])
         }
     }
 
-    // Handle duplicates by using unordered_set
-    std::unordered_set<Voxel, VoxelHash> pts;
-
-    // Read all vcps files in the directory:
-    for (const auto& p : resolvedPaths) {
-        // Load the file
-        vc::Logger()->info("Loading file: \"{}\"", p.string());
-        auto tmpCloud = psio::ReadPointSet(p);
-        vc::Logger()->info("Loaded pointset with {} points", tmpCloud.size());
-
-        // Prune as needed
-        if (parsed.count("prune")) {
-            auto filename = p.stem().string();
-            if (std::all_of(filename.begin(), filename.end(), ::isdigit)) {
-                int maxSliceNum = std::stoi(filename);
-
-                volcart::PointSet<Voxel> prunedCloud;
-                for (auto& pt : tmpCloud) {
-                    // Check the z-value. Only add it to prunedCloud if z is
-                    // less than the vcps name.
-                    if (pt[2] <= maxSliceNum) {
-                        prunedCloud.push_back(pt);
-                    }
+    vc::ThreadPool::SetGlobalThreads(parsed["threads"].as<std::size_t>());
+    auto prune = parsed.count("prune") > 0;
+    auto overwrite = parsed.count("overwrite-overlap") > 0;
+
+    // Map the input files
+    std::vector<Input> inputs;
+    try {
+        for (const auto& p : resolvedPaths) {
+            inputs.emplace_back(p);
+        }
+    } catch (const std::exception& e) {
+        vc::Logger()->error(e.what());
+        return EXIT_FAILURE;
+    }
+
+    // Scan the inputs in parallel
+    vc::ParallelFor(vc::range(inputs.size()), [&](auto i) {
+        inputs[i].scan(prune);
+    });
+    for (const auto& in : inputs) {
+        vc::Logger()->info(
+            "Loaded pointset with {} points: \"{}\"", in.mapped.size(),
+            in.path.string());
+        if (prune and not in.pruned) {
+            vc::Logger()->warn(
+                "Filename contains characters other than digits. File will "
+                "not be pruned: \"{}\"",
+                in.path.string());
+        } else if (prune) {
+            vc::Logger()->info("Pruned pointset to {} points", in.size());
+        }
+        if (not in.sorted) {
+            vc::Logger()->warn(
+                "Points are not sorted by slice. Loaded into memory: \"{}\"",
+                in.path.string());
+        }
+    }
+
+    // Merge the inputs slice by slice, starting at the lowest z-value
+    using Head = std::pair<double, std::size_t>;
+    std::priority_queue<Head, std::vector<Head>, std::greater<>> heads;
+    for (std::size_t i = 0; i < inputs.size(); i++) {
+        if (not inputs[i].done()) {
+            heads.emplace(inputs[i].z(), i);
+        }
+    }
+
+    vc::Logger()->info("Writing merged pointset...");
+    std::size_t removed{0};
+    psw writer(outputPath);
+    std::vector<std::size_t> merging;
+    std::unordered_set<Voxel, VoxelHash> slice;
+    while (not heads.empty()) {
+        // Collect the inputs which have points on this slice
+        auto z = heads.top().first;
+        merging.clear();
+        while (not heads.empty() and heads.top().first == z) {
+            merging.emplace_back(heads.top().second);
+            heads.pop();
+        }
+        std::sort(merging.begin(), merging.end());
+
+        // With --overwrite-overlap, the last input whose z-range contains
+        // this slice replaces every earlier input
+        std::size_t first{0};
+        if (overwrite) {
+            for (auto i = inputs.size(); i-- > 0;) {
+                if (inputs[i].contains(z)) {
+                    first = i;
+                    break;
                 }
-                tmpCloud = prunedCloud;
-                vc::Logger()->info(
-                    "Pruned pointset to {} points", tmpCloud.size());
-            } else {
-                vc::Logger()->warn(
-                    "Filename contains characters other than digits. File will "
-                    "not be pruned: \"{}\"",
-                    p.string());
             }
         }
 
-        // Overwrite overlap
-        if (parsed.count("overwrite-overlap")) {
-            auto minMax = std::minmax_element(
-                tmpCloud.begin(), tmpCloud.end(),
-                [](const auto& l, const auto& r) { return l[2] < r[2]; });
-            auto minZ = (*minMax.first)[2];
-            auto maxZ = (*minMax.second)[2];
-            auto origSize = pts.size();
-            for (auto i = pts.begin(), last = pts.end(); i != last;) {
-                auto z = (*i)[2];
-                if (z >= minZ and z <= maxZ) {
-                    i = pts.erase(i);
-                } else {
-                    ++i;
+        // Write each unique point once
+        slice.clear();
+        for (auto i : merging) {
+            auto& in = inputs[i];
+            for (; not in.done() and in.z() == z; in.next()) {
+                auto pt = in.point();
+                if (i < first) {
+                    removed++;
+                } else if (slice.insert(pt).second) {
+                    writer.write(pt);
                 }
             }
-            vc::Logger()->info(
-                "Removing {} points from overlapping region.",
-                origSize - pts.size());
+            if (not in.done()) {
+                heads.emplace(in.z(), i);
+            }
         }
-
-        // Add all the points in the smaller cloud to the set
-        auto origSize = pts.size();
-        pts.reserve(pts.size() + tmpCloud.size());
-        pts.insert(tmpCloud.begin(), tmpCloud.end());
-        vc::Logger()->info("Merged {} new points", pts.size() - origSize);
     }
-
-    // Main cloud will hold the merged result
-    vc::PointSet<Voxel> cloud(pts.size());
-    std::copy(pts.begin(), pts.end(), std::back_inserter(cloud));
-    vc::Logger()->info("Final pointset size: {} points", cloud.size());
-
-    // Save the merged pointset
-    vc::Logger()->info("Writing final pointset...");
-    psio::WritePointSet(outputPath, cloud);
+    writer.flush();
+    if (overwrite) {
+        vc::Logger()->info(
+            "Removed {} points from overlapping regions", removed);
+    }
+    vc::Logger()->info("Final pointset size: {} points", writer.size());
     vc::Logger()->info("Done.");
 }
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <iostream>
 #include <regex>
 #include <vector>
@@ -83,21 +84,34 @@ auto main(int argc, char* argv[]) -> int
     // Setup output mesh
     auto mesh = vc::ITKMesh::New();
 
-    // Iterate over the ROI
+    // Gather the mappings in the ROI
     std::cout << "Generating point set..." << std::endl;
-    for (auto y = minY; y < maxY; y++) {
-        for (auto x = minX; x < maxX; x++) {
-            // Skip unmapped pixels
-            if (!ppm.hasMapping(y, x)) {
-                continue;
-            }
-
-            auto id = mesh->GetNumberOfPoints();
-            auto pt = ppm.getAsPixelMap(y, x);
-            mesh->SetPoint(id, pt.pos.val);
-            mesh->SetPointData(id, pt.normal.val);
-        }
+    const auto& cppm = ppm;
+    auto indices = cppm.getMappingIndices();
+    auto inROI = [&](auto idx) {
+        auto y = idx / cppm.width();
+        auto x = idx % cppm.width();
+        return y >= minY and y < maxY and x >= minX and x < maxX;
+    };
+    indices.erase(
+        std::remove_if(
+            indices.begin(), indices.end(),
+            [&](auto idx) { return not inROI(idx); }),
+        indices.end());
+    auto values = cppm.getMappingValues(indices);
+
+    // Fill the preallocated point containers
+    auto points = vc::ITKPointsContainer::New();
+    points->Reserve(values.size());
+    auto normals = vc::ITKMesh::PointDataContainer::New();
+    normals->Reserve(values.size());
+    for (size_t id = 0; id < values.size(); id++) {
+        const auto& m = values[id];
+        points->SetElement(id, vc::ITKPoint(m.val));
+        normals->SetElement(id, vc::ITKPixel(m.val + 3));
     }
+    mesh->SetPoints(points);
+    mesh->SetPointData(normals);
 
     // Write the mesh
     std::cout << "Write OBJ file..." << std::endl;
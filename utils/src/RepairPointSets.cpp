@@ -57,7 +57,7 @@ auto main(int argc, char* argv[]) -> int
     auto cols = cloud.width();
     auto rows = cloud.height();
     auto startZ = static_cast<std::size_t>(cloud[0][2]);
-    auto endZ = static_cast<std::size_t>(cloud.getRow(rows - 1)[0][2]);
+    auto endZ = static_cast<std::size_t>(cloud.row(rows - 1)[0][2]);
     vc::Logger()->info(
         "Original pointset :: Shape: ({}, {}), Z-Range: [{}, {}]", rows, cols,
         startZ, endZ);
@@ -92,7 +92,7 @@ auto main(int argc, char* argv[]) -> int
     cols = cloud.width();
     rows = cloud.height();
     startZ = static_cast<std::size_t>(cloud[0][2]);
-    endZ = static_cast<std::size_t>(cloud.getRow(rows - 1)[0][2]);
+    endZ = static_cast<std::size_t>(cloud.row(rows - 1)[0][2]);
     vc::Logger()->info(
         "New pointset :: Shape: ({}, {}), Z-Range: [{}, {}]", rows, cols,
         startZ, endZ);
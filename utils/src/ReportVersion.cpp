@@ -1,6 +1,7 @@
 #include <iostream>
 
 #include "vc/core/Version.hpp"
+#include "vc/core/util/CPUFeatures.hpp"
 
 using namespace volcart;
 
@@ -8,4 +9,7 @@ auto main() -> int
 {
     std::cout << ProjectInfo::NameAndVersion();
     std::cout << " (" << ProjectInfo::RepositoryHash() << ")\n";
+    std::cout << "SIMD path: " << simd::PathName(simd::ActivePath());
+    std::cout << " (detected: " << simd::PathName(simd::DetectPath());
+    std::cout << ")\n";
 }
\ No newline at end of file
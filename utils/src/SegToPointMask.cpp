@@ -4,6 +4,7 @@
 #include "vc/app_support/ProgressIndicator.hpp"
 #include "vc/core/filesystem.hpp"
 #include "vc/core/io/PointSetIO.hpp"
+#include "vc/core/io/VolumetricMaskIO.hpp"
 #include "vc/core/types/PointSet.hpp"
 #include "vc/core/types/VolumePkg.hpp"
 #include "vc/core/util/Logging.hpp"
@@ -31,7 +32,8 @@ int main(int argc, char* argv[])
         ("input-pts,i", po::value<std::string>()->required(),
             "Path to an input point set representing a segmentation")
         ("output-pts,o", po::value<std::string>()->required(),
-         "Path to a directory to store the output point mask");
+         "Path to the output point mask. Masks with the .vcvm extension are "
+         "saved in the compact VolumetricMask format.");
 
     // TFF options
     po::options_description tffOptions("Thinned Flood Fill Segmentation Options");
@@ -122,7 +124,11 @@ int main(int argc, char* argv[])
 
     // Save the mask
     vc::Logger()->info("Saving mask");
-    vc::PointSet<cv::Vec3i> maskPts;
-    maskPts.append(mask->as_vector());
-    vc::PointSetIO<cv::Vec3i>::WritePointSet(outPath, maskPts);
+    if (outPath.extension() == ".vcvm") {
+        vc::io::WriteVolumetricMask(outPath, *mask);
+    } else {
+        vc::PointSet<cv::Vec3i> maskPts(mask->size());
+        maskPts.append(*mask);
+        vc::PointSetIO<cv::Vec3i>::WritePointSet(outPath, maskPts);
+    }
 }
\ No newline at end of file
@@ -4,12 +4,13 @@
 #include <fstream>
 #include <iostream>
 
-#include <vtkMassProperties.h>
 #include <vtkPolyData.h>
 #include <vtkSmoothPolyDataFilter.h>
 
 #include "vc/core/io/PLYReader.hpp"
+#include "vc/core/types/FlatMesh.hpp"
 #include "vc/core/types/VolumePkg.hpp"
+#include "vc/core/util/MeshMath.hpp"
 #include "vc/meshing/ITK2VTK.hpp"
 #include "vc/meshing/OrderedPointSetMesher.hpp"
 
@@ -42,10 +43,12 @@ int main(int argc, char** argv)
     smooth->SetRelaxationFactor(0.3);
     smooth->Update();
 
-    auto massProperties = vtkMassProperties::New();
-    massProperties->AddInputData(smooth->GetOutput());
+    auto smoothed = volcart::ToFlatMesh(
+        volcart::meshing::VTK2ITK(smooth->GetOutput()));
 
-    auto areaVoxels = massProperties->GetSurfaceArea();
+    auto areaVoxels = volcart::meshmath::SurfaceArea(smoothed);
+    auto edges = volcart::meshmath::EdgeLengths(smoothed);
+    auto bounds = volcart::meshmath::Bounds(smoothed);
     auto voxelSize = vpkg.volume()->voxelSize();
 
     long double umArea = areaVoxels * std::pow(voxelSize, 2);
@@ -60,6 +63,15 @@ int main(int argc, char** argv)
     std::cout << "     mm^2: " << mmArea << std::endl;
     std::cout << "     cm^2: " << cmArea << std::endl;
     std::cout << "     in^2: " << inArea << std::endl;
+    std::cout << std::endl;
+    std::cout << "Mesh (voxels)" << std::endl;
+    std::cout << "-----------------------" << std::endl;
+    std::cout << " vertices: " << smoothed.numVertices() << std::endl;
+    std::cout << "    faces: " << smoothed.numFaces() << std::endl;
+    std::cout << "   bounds: " << bounds.getLowerBound() << " - "
+              << bounds.getUpperBound() << std::endl;
+    std::cout << "    edges: " << edges.mean << " +/- " << edges.stddev
+              << " [" << edges.min << ", " << edges.max << "]" << std::endl;
 
     return 0;
 }  // end main
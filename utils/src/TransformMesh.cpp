@@ -1,14 +1,19 @@
+#include <deque>
+#include <future>
 #include <iostream>
+#include <vector>
 
 #include <boost/program_options.hpp>
 #include <itkAffineTransform.h>
 #include <itkCompositeTransform.h>
 #include <itkTransformFileReader.h>
 #include <itkTransformFileWriter.h>
-#include <itkTransformMeshFilter.h>
 
 #include "vc/core/filesystem.hpp"
 #include "vc/core/io/MeshIO.hpp"
+#include "vc/core/util/Iteration.hpp"
+#include "vc/core/util/Logging.hpp"
+#include "vc/core/util/ThreadPool.hpp"
 
 namespace fs = volcart::filesystem;
 namespace po = boost::program_options;
@@ -18,11 +23,22 @@ namespace vc = volcart;
 using AffineTransform = itk::AffineTransform<double, 3>;
 using Displacement = AffineTransform::OutputVectorType;
 using CompositeTransform = itk::CompositeTransform<double, 3>;
-using MeshTransformer =
-    itk::TransformMeshFilter<vc::ITKMesh, vc::ITKMesh, CompositeTransform>;
 using TransformWriter = itk::TransformFileWriterTemplate<double>;
 using TransformReader = itk::TransformFileReaderTemplate<double>;
 
+// Number of meshes read ahead of and written behind the transformed mesh
+static constexpr std::size_t PIPELINE_DEPTH{2};
+
+// Transform the points of a mesh in place. Normals are not modified.
+static void TransformPoints(
+    const vc::ITKMesh::Pointer& mesh, const CompositeTransform* tfm)
+{
+    auto& points = mesh->GetPoints()->CastToSTLContainer();
+    vc::ParallelFor(vc::range(points.size()), [&](auto i) {
+        points[i] = tfm->TransformPoint(points[i]);
+    });
+}
+
 int main(int argc, char** argv)
 {
     ///// Parse the command line options /////
@@ -31,12 +47,17 @@ int main(int argc, char** argv)
     po::options_description required("General Options");
     required.add_options()
         ("help,h", "Show this message")
-        ("input-mesh,i", po::value<std::string>()->required(),
-           "Input mesh file")
-        ("output-mesh,o", po::value<std::string>()->required(),
-           "Output mesh file")
+        ("input-mesh,i", po::value<std::vector<std::string>>()
+            ->multitoken()->required(), "Input mesh file. Several meshes "
+            "are transformed in a batch and require --output-dir.")
+        ("output-mesh,o", po::value<std::string>(), "Output mesh file")
+        ("output-dir", po::value<std::string>(), "Output directory for a "
+            "batch. Each mesh is written with its input file name.")
         ("input-tfm", po::value<std::string>(), "Input transformation file")
-        ("output-tfm,t", po::value<std::string>(), "Output transformation file");
+        ("output-tfm,t", po::value<std::string>(), "Output transformation file")
+        ("threads", po::value<std::size_t>()->default_value(0), "Number of "
+            "threads used to transform points. If 0, uses one thread per CPU "
+            "core.");
 
     po::options_description transformOpts("Transformations");
     transformOpts.add_options()
@@ -68,11 +89,28 @@ int main(int argc, char** argv)
         return EXIT_FAILURE;
     }
 
-    // Load mesh
-    std::cout << "Loading mesh..." << std::endl;
-    fs::path inputPath = parsed["input-mesh"].as<std::string>();
-    auto meshGroup = vc::ReadMesh(inputPath);
-    auto mesh = meshGroup.mesh;
+    // Pair the inputs with their outputs
+    std::vector<fs::path> inputs;
+    for (const auto& p : parsed["input-mesh"].as<std::vector<std::string>>()) {
+        inputs.emplace_back(p);
+    }
+    std::vector<fs::path> outputs;
+    if (parsed.count("output-dir") > 0) {
+        fs::path outputDir = parsed["output-dir"].as<std::string>();
+        fs::create_directories(outputDir);
+        for (const auto& input : inputs) {
+            outputs.emplace_back(outputDir / input.filename());
+        }
+    } else if (parsed.count("output-mesh") > 0 and inputs.size() == 1) {
+        outputs.emplace_back(parsed["output-mesh"].as<std::string>());
+    } else {
+        std::cerr << "ERROR: Provide --output-mesh for one input or "
+                     "--output-dir for several"
+                  << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    vc::ThreadPool::SetGlobalThreads(parsed["threads"].as<std::size_t>());
 
     // Setup composite transform
     auto compositeTrans = CompositeTransform::New();
@@ -110,18 +148,63 @@ int main(int argc, char** argv)
     // Simplify the transform
     compositeTrans->FlattenTransformQueue();
 
-    // Apply the composite transform to the mesh
-    std::cout << "Applying transform..." << std::endl;
-    auto transformer = MeshTransformer::New();
-    transformer->SetInput(mesh);
-    transformer->SetTransform(compositeTrans);
-    transformer->Update();
-    auto output = transformer->GetOutput();
-
-    // Write the new mesh
-    std::cout << "Writing mesh..." << std::endl;
-    fs::path outputPath = parsed["output-mesh"].as<std::string>();
-    vc::WriteMesh(outputPath, output, meshGroup.uv, meshGroup.texture);
+    // Read ahead and write behind the mesh being transformed
+    auto& pool = vc::ThreadPool::Global();
+    std::deque<std::future<vc::MeshReaderResult>> reads;
+    std::deque<std::future<void>> writes;
+    std::size_t nextRead{0};
+    auto readAhead = [&]() {
+        while (nextRead < inputs.size() and reads.size() < PIPELINE_DEPTH) {
+            reads.emplace_back(pool.submit(
+                [path = inputs[nextRead]]() { return vc::ReadMesh(path); }));
+            nextRead++;
+        }
+    };
+
+    std::size_t failed{0};
+    auto finishWrite = [&]() {
+        try {
+            pool.wait(writes.front());
+        } catch (const std::exception& e) {
+            vc::Logger()->error("Failed to write mesh: {}", e.what());
+            failed++;
+        }
+        writes.pop_front();
+    };
+
+    for (std::size_t i = 0; i < inputs.size(); i++) {
+        readAhead();
+        vc::MeshReaderResult meshGroup;
+        try {
+            meshGroup = pool.wait(reads.front());
+        } catch (const std::exception& e) {
+            vc::Logger()->error(
+                "Failed to read mesh {}: {}", inputs[i].string(), e.what());
+            reads.pop_front();
+            failed++;
+            continue;
+        }
+        reads.pop_front();
+        readAhead();
+
+        // Apply the composite transform to the mesh
+        vc::Logger()->info(
+            "[{}/{}] Transforming {}", i + 1, inputs.size(),
+            inputs[i].string());
+        TransformPoints(meshGroup.mesh, compositeTrans.GetPointer());
+
+        // Write the new mesh
+        if (writes.size() == PIPELINE_DEPTH) {
+            finishWrite();
+        }
+        writes.emplace_back(pool.submit(
+            [path = outputs[i], group = std::move(meshGroup)]() {
+                vc::WriteMesh(path, group.mesh, group.uv, group.texture);
+            }));
+    }
+    while (not writes.empty()) {
+        finishWrite();
+    }
 
     ///// Write the final transformations /////
     if (parsed.count("output-tfm") > 0) {
@@ -134,5 +217,9 @@ int main(int argc, char** argv)
         transformWriter->Update();
     }
 
+    if (failed > 0) {
+        vc::Logger()->error("Failed to transform {} meshes", failed);
+        return EXIT_FAILURE;
+    }
     return EXIT_SUCCESS;
 }
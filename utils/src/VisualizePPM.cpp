@@ -5,7 +5,9 @@
 #include "vc/core/io/TIFFIO.hpp"
 #include "vc/core/types/PerPixelMap.hpp"
 #include "vc/core/types/VolumePkg.hpp"
+#include "vc/core/util/Iteration.hpp"
 #include "vc/core/util/Logging.hpp"
+#include "vc/core/util/ThreadPool.hpp"
 
 namespace fs = volcart::filesystem;
 namespace po = boost::program_options;
@@ -99,11 +101,17 @@ auto main(int argc, char* argv[]) -> int
 
     // Fill the outputs
     vc::Logger()->info("Converting mappings...");
-    for (const auto& m : ppm.getMappings()) {
-
+    const auto& cppm = ppm;
+    const auto indices = cppm.getMappingIndices();
+    const auto values = cppm.getMappingValues(indices);
+    vc::ParallelFor(vc::range(indices.size()), [&](auto i) {
         // Get values
-        auto p = m.pos;
-        auto n = m.normal;
+        const auto& m = values[i];
+        auto y = indices[i] / cppm.width();
+        auto x = indices[i] % cppm.width();
+        const cv::Vec3d mpos{m[0], m[1], m[2]};
+        auto p = mpos;
+        cv::Vec3d n{m[3], m[4], m[5]};
 
         // Normalize position and surface normal
         // Surface normal is now +/- unit vector
@@ -115,24 +123,24 @@ auto main(int argc, char* argv[]) -> int
         if (tspace) {
             // Get tangent and bitangent vectors
             cv::Vec3d tan{-1, -1, -1};
-            if (ppm.hasMapping(m.y + 1, m.x)) {
-                tan = ppm.getAsPixelMap(m.y + 1, m.x).pos - m.pos;
-            } else if (ppm.hasMapping(m.y - 1, m.x)) {
-                tan = m.pos - ppm.getAsPixelMap(m.y - 1, m.x).pos;
+            if (cppm.hasMapping(y + 1, x)) {
+                tan = cppm.getAsPixelMap(y + 1, x).pos - mpos;
+            } else if (cppm.hasMapping(y - 1, x)) {
+                tan = mpos - cppm.getAsPixelMap(y - 1, x).pos;
             }
 
             cv::Vec3d bitan{-1, -1, -1};
-            if (ppm.hasMapping(m.y, m.x + 1)) {
-                bitan = ppm.getAsPixelMap(m.y, m.x + 1).pos - m.pos;
-            } else if (ppm.hasMapping(m.y, m.x - 1)) {
-                bitan = m.pos - ppm.getAsPixelMap(m.y, m.x - 1).pos;
+            if (cppm.hasMapping(y, x + 1)) {
+                bitan = cppm.getAsPixelMap(y, x + 1).pos - mpos;
+            } else if (cppm.hasMapping(y, x - 1)) {
+                bitan = mpos - cppm.getAsPixelMap(y, x - 1).pos;
             }
 
             // Skip this pixel if we don't have the
             if (tan == cv::Vec3d{-1, -1, -1} ||
                 bitan == cv::Vec3d{-1, -1, -1}) {
                 vc::Logger()->warn(
-                    "Can't calculate tangent/bitangent for ({},{})", m.x, m.y);
+                    "Can't calculate tangent/bitangent for ({},{})", x, y);
                 n = cv::Vec3d::all(0);
             } else {
                 cv::Mat w = cv::Mat::eye(3, 3, CV_64FC1);
@@ -145,10 +153,12 @@ auto main(int argc, char* argv[]) -> int
             }
         }
 
-        // Assign to output images
-        pos.at<cv::Vec3f>(m.y, m.x) = cv::Vec3f{p};
-        norm.at<cv::Vec3f>(m.y, m.x) = cv::Vec3f{n};
-    }
+        // Assign to output images. Each pixel is written by one task.
+        auto r = static_cast<int>(y);
+        auto c = static_cast<int>(x);
+        pos.at<cv::Vec3f>(r, c) = cv::Vec3f{p};
+        norm.at<cv::Vec3f>(r, c) = cv::Vec3f{n};
+    });
 
     // Scale and shift the normal map to [0, 1]
     if (normalize) {
@@ -1,15 +1,107 @@
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
 #include "vc/core/filesystem.hpp"
 #include "vc/core/types/Metadata.hpp"
 #include "vc/core/types/Volume.hpp"
 #include "vc/core/types/VolumePkg.hpp"
 #include "vc/core/util/DateTime.hpp"
+#include "vc/core/util/Iteration.hpp"
+#include "vc/core/util/ThreadPool.hpp"
 
 namespace fs = volcart::filesystem;
 namespace vc = volcart;
 
-void volpkgV3ToV4(const fs::path& path);
-void volpkgV4ToV5(const fs::path& path);
-void volpkgV5ToV6(const fs::path& path);
+// Records the migrated objects so that an interrupted upgrade can resume
+// without repeating them
+class Journal
+{
+public:
+    explicit Journal(fs::path path) : path_{std::move(path)}
+    {
+        std::ifstream file(path_.string());
+        std::string line;
+        while (std::getline(file, line)) {
+            done_.insert(line);
+        }
+        file_.open(path_.string(), std::ios::app);
+    }
+
+    [[nodiscard]] auto done(const std::string& key) const -> bool
+    {
+        std::unique_lock lock(mutex_);
+        return done_.count(key) > 0;
+    }
+
+    // Get the value recorded by set(), or an empty string
+    [[nodiscard]] auto get(const std::string& key) const -> std::string
+    {
+        std::unique_lock lock(mutex_);
+        for (const auto& entry : done_) {
+            if (entry.rfind(key + " ", 0) == 0) {
+                return entry.substr(key.size() + 1);
+            }
+        }
+        return {};
+    }
+
+    void record(const std::string& key)
+    {
+        std::unique_lock lock(mutex_);
+        done_.insert(key);
+        file_ << key << std::endl;
+    }
+
+    void set(const std::string& key, const std::string& value)
+    {
+        record(key + " " + value);
+    }
+
+    void remove()
+    {
+        file_.close();
+        fs::remove(path_);
+    }
+
+private:
+    fs::path path_;
+    std::ofstream file_;
+    std::unordered_set<std::string> done_;
+    mutable std::mutex mutex_;
+};
+
+void volpkgV3ToV4(const fs::path& path, Journal& journal);
+void volpkgV4ToV5(const fs::path& path, Journal& journal);
+void volpkgV5ToV6(const fs::path& path, Journal& journal);
+
+// Write metadata through a temporary file, so that an interrupted upgrade
+// never leaves a partially written file
+static void SaveAtomic(vc::Metadata& meta, const fs::path& path)
+{
+    auto tmp = path;
+    tmp += ".tmp";
+    meta.save(tmp);
+    fs::rename(tmp, path);
+    meta.setPath(path);
+}
+
+// Subdirectories of dir, in a stable order
+static auto Subdirectories(const fs::path& dir) -> std::vector<fs::path>
+{
+    std::vector<fs::path> dirs;
+    for (const auto& entry : fs::directory_iterator(dir)) {
+        if (fs::is_directory(entry)) {
+            dirs.emplace_back(entry);
+        }
+    }
+    std::sort(dirs.begin(), dirs.end());
+    return dirs;
+}
 
 int main(int argc, char* argv[])
 {
@@ -38,10 +130,23 @@ int main(int argc, char* argv[])
         }
     }
 
+    // Resume an interrupted upgrade
+    auto journalPath = path / "upgrade.journal";
+    if (fs::exists(journalPath)) {
+        std::cout << "Resuming interrupted upgrade." << std::endl;
+    }
+    Journal journal(journalPath);
+
     // Upgrade tasks
-    volpkgV3ToV4(path);
-    volpkgV4ToV5(path);
-    volpkgV5ToV6(path);
+    try {
+        volpkgV3ToV4(path, journal);
+        volpkgV4ToV5(path, journal);
+        volpkgV5ToV6(path, journal);
+    } catch (const std::exception& e) {
+        std::cerr << "Upgrade interrupted: " << e.what() << "\n";
+        std::cerr << "Run the upgrade again to resume." << std::endl;
+        return EXIT_FAILURE;
+    }
 
     // Try to load as a volpkg
     try {
@@ -51,12 +156,13 @@ int main(int argc, char* argv[])
         std::cerr << "Restoring original metadata." << std::endl;
         origMeta.save();
     }
+    journal.remove();
 
     // Done
     std::cout << "Upgrades complete." << std::endl;
 }
 
-void volpkgV3ToV4(const fs::path& path)
+void volpkgV3ToV4(const fs::path& path, Journal& journal)
 {
     // Copy the current metadata
     vc::Metadata oldMeta(path / "config.json");
@@ -67,24 +173,24 @@ void volpkgV3ToV4(const fs::path& path)
     }
     std::cout << "Upgrading to version 4..." << std::endl;
 
-    // Write the new volpkg metadata
-    vc::Metadata vpkgMeta;
-    vpkgMeta.set("version", 4);
-    vpkgMeta.set("name", oldMeta.get<std::string>("volumepkg name"));
-    vpkgMeta.set("materialthickness", oldMeta.get<double>("materialthickness"));
-    vpkgMeta.save(path / "config.json");
-
     // Make the "volumes" directory
     fs::path volumesDir = path / "volumes";
     if (!fs::exists(volumesDir)) {
         fs::create_directory(volumesDir);
     }
 
-    // Setup a new Volume name and make a new folder for it
-    // Move the slices
-    auto id = vc::DateTime();
+    // Setup a new Volume name, reusing the one from an interrupted upgrade
+    auto id = journal.get("v4-volume");
+    if (id.empty()) {
+        id = vc::DateTime();
+        journal.set("v4-volume", id);
+    }
     auto newVolDir = volumesDir / id;
-    fs::rename(path / "slices", newVolDir);
+
+    // Move the slices. Renaming the directory moves them without copying.
+    if (fs::exists(path / "slices")) {
+        fs::rename(path / "slices", newVolDir);
+    }
 
     // Setup and save the metadata to the new Volume folder
     vc::Metadata volMeta;
@@ -96,10 +202,18 @@ void volpkgV3ToV4(const fs::path& path)
     volMeta.set("voxelsize", oldMeta.get<double>("voxelsize"));
     volMeta.set("min", oldMeta.get<double>("min"));
     volMeta.set("max", oldMeta.get<double>("max"));
-    volMeta.save(newVolDir / "meta.json");
+    SaveAtomic(volMeta, newVolDir / "meta.json");
+
+    // Write the new volpkg metadata last, so that the old fields are
+    // available until the volume has been migrated
+    vc::Metadata vpkgMeta;
+    vpkgMeta.set("version", 4);
+    vpkgMeta.set("name", oldMeta.get<std::string>("volumepkg name"));
+    vpkgMeta.set("materialthickness", oldMeta.get<double>("materialthickness"));
+    SaveAtomic(vpkgMeta, path / "config.json");
 }
 
-void volpkgV4ToV5(const fs::path& path)
+void volpkgV4ToV5(const fs::path& path, Journal& journal)
 {
     // Copy the current metadata
     vc::Metadata volpkgMeta(path / "config.json");
@@ -111,30 +225,31 @@ void volpkgV4ToV5(const fs::path& path)
     std::cout << "Upgrading to version 5..." << std::endl;
 
     // Add metadata to all of the segmentations
-    fs::path seg;
-    fs::path segsDir = path / "paths";
-    for (const auto& entry : fs::directory_iterator(segsDir)) {
-        if (fs::is_directory(entry)) {
-            // Get the folder as an fs::path
-            seg = entry;
-
-            // Generate basic metadata
-            vc::Metadata segMeta;
-            segMeta.set("uuid", seg.stem().string());
-            segMeta.set("name", seg.stem().string());
-            segMeta.set("type", "seg");
-
-            // Link the metadata to the vcps file
-            if (fs::exists(seg / "pointset.vcps")) {
-                segMeta.set("vcps", "pointset.vcps");
-            } else {
-                segMeta.set("vcps", std::string{});
-            }
+    auto segs = Subdirectories(path / "paths");
+    vc::ParallelFor(vc::range(segs.size()), [&](auto i) {
+        const auto& seg = segs[i];
+        auto key = "v5 paths/" + seg.filename().string();
+        if (journal.done(key)) {
+            return;
+        }
 
-            // Save the new metadata
-            segMeta.save(seg / "meta.json");
+        // Generate basic metadata
+        vc::Metadata segMeta;
+        segMeta.set("uuid", seg.stem().string());
+        segMeta.set("name", seg.stem().string());
+        segMeta.set("type", "seg");
+
+        // Link the metadata to the vcps file
+        if (fs::exists(seg / "pointset.vcps")) {
+            segMeta.set("vcps", "pointset.vcps");
+        } else {
+            segMeta.set("vcps", std::string{});
         }
-    }
+
+        // Save the new metadata
+        SaveAtomic(segMeta, seg / "meta.json");
+        journal.record(key);
+    });
 
     // Add renders folder
     fs::path rendersDir = path / "renders";
@@ -146,10 +261,10 @@ void volpkgV4ToV5(const fs::path& path)
 
     // Update the version
     volpkgMeta.set("version", 5);
-    volpkgMeta.save();
+    SaveAtomic(volpkgMeta, path / "config.json");
 }
 
-void volpkgV5ToV6(const fs::path& path)
+void volpkgV5ToV6(const fs::path& path, Journal& journal)
 {
     // Copy the current metadata
     vc::Metadata volpkgMeta(path / "config.json");
@@ -161,31 +276,32 @@ void volpkgV5ToV6(const fs::path& path)
     std::cout << "Upgrading to version 6..." << std::endl;
 
     // Add metadata to all of the volumes
-    fs::path vol;
-    fs::path volsDir = path / "volumes";
-    for (const auto& entry : fs::directory_iterator(volsDir)) {
-        if (fs::is_directory(entry)) {
-            // Get the folder as an fs::path
-            vol = entry;
-
-            // Generate basic metadata
-            vc::Metadata volMeta(vol / "meta.json");
-            if (!volMeta.hasKey("uuid")) {
-                volMeta.set("uuid", vol.stem().string());
-            }
-            if (!volMeta.hasKey("name")) {
-                volMeta.set("name", vol.stem().string());
-            }
-            if (!volMeta.hasKey("type")) {
-                volMeta.set("type", "vol");
-            }
+    auto vols = Subdirectories(path / "volumes");
+    vc::ParallelFor(vc::range(vols.size()), [&](auto i) {
+        const auto& vol = vols[i];
+        auto key = "v6 volumes/" + vol.filename().string();
+        if (journal.done(key)) {
+            return;
+        }
 
-            // Save the new metadata
-            volMeta.save();
+        // Generate basic metadata
+        vc::Metadata volMeta(vol / "meta.json");
+        if (!volMeta.hasKey("uuid")) {
+            volMeta.set("uuid", vol.stem().string());
         }
-    }
+        if (!volMeta.hasKey("name")) {
+            volMeta.set("name", vol.stem().string());
+        }
+        if (!volMeta.hasKey("type")) {
+            volMeta.set("type", "vol");
+        }
+
+        // Save the new metadata
+        SaveAtomic(volMeta, vol / "meta.json");
+        journal.record(key);
+    });
 
     // Update the version
     volpkgMeta.set("version", 6);
-    volpkgMeta.save();
+    SaveAtomic(volpkgMeta, path / "config.json");
 }
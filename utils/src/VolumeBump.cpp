@@ -1,8 +1,9 @@
+#include <algorithm>
 #include <cmath>
 #include <iomanip>
 #include <limits>
-#include <map>
 #include <sstream>
+#include <vector>
 
 #include <boost/program_options.hpp>
 #include <opencv2/core.hpp>
@@ -16,6 +17,7 @@
 #include "vc/core/types/VolumePkg.hpp"
 #include "vc/core/util/Logging.hpp"
 #include "vc/core/util/MemorySizeStringParser.hpp"
+#include "vc/core/util/ThreadPool.hpp"
 
 namespace po = boost::program_options;
 namespace fs = volcart::filesystem;
@@ -28,6 +30,13 @@ static const double MAX_16BPC = std::numeric_limits<uint16_t>::max();
 fs::path g_outputDir;
 size_t g_numSliceChars;
 
+// A voxel of a slice and the value added to it
+struct BumpedVoxel {
+    int x;
+    int y;
+    double bump;
+};
+
 void WriteBumpedSlice(const cv::Mat& slice, int index);
 
 int main(int argc, char* argv[])
@@ -44,7 +53,10 @@ int main(int argc, char* argv[])
         ("output-dir,o", po::value<std::string>()->required(),"Output directory")
         ("cache-memory-limit", po::value<std::string>(), "Maximum size of the "
             "slice cache in bytes. Accepts the suffixes: (K|M|G|T)(B). "
-            "Default: 50% of the total system memory.");
+            "Default: 50% of the total system memory.")
+        ("threads", po::value<size_t>()->default_value(0),
+            "Number of slices to bump in parallel. If 0, uses one thread per "
+            "CPU core.");
 
 
     po::options_description visOptions("Visualization Options");
@@ -73,6 +85,8 @@ int main(int argc, char* argv[])
         return EXIT_FAILURE;
     }
 
+    vc::ThreadPool::SetGlobalThreads(parsed["threads"].as<size_t>());
+
     ///// Load the volume package /////
     fs::path volpkgPath = parsed["volpkg"].as<std::string>();
     auto vpkg = vc::VolumePkg::New(volpkgPath);
@@ -125,20 +139,10 @@ int main(int argc, char* argv[])
     auto bumpVal = (volume->max() - volume->min()) * bumpPerc;
 
     ///// Perform the bump /////
-    // Get the mappings
-    auto mappings = ppm.getMappings();
-
-    // Sort the mappings by Z-value
-    std::sort(
-        mappings.begin(), mappings.end(), [](const auto& lhs, const auto& rhs) {
-            return lhs.pos[2] < rhs.pos[2];
-        });
-
-    // Iterate through the mappings
-    int currentZ = -1;
-    cv::Mat currentSlice;
-    std::map<int, cv::Mat> bumpedSlices;
-    for (const auto& pixel : mappings) {
+    // Bucket the mapped voxels by slice so that each slice only visits its
+    // own voxels. The bump mask is an opacity function on the bumpVal.
+    std::vector<std::vector<BumpedVoxel>> voxelsByZ(volume->numSlices());
+    for (const auto& pixel : ppm.getMappings()) {
         // Get integer coordinates
         auto x = static_cast<int>(std::floor(pixel.pos[0]));
         auto y = static_cast<int>(std::floor(pixel.pos[1]));
@@ -149,35 +153,36 @@ int main(int argc, char* argv[])
             continue;
         }
 
-        // Check if our slice index has changed
-        if (z != currentZ) {
-            if (!currentSlice.empty()) {
-                // Add this to our image writing queue
-                bumpedSlices[currentZ] = currentSlice;
-
-                // Clear the queue if it's big enough
-                if (bumpedSlices.size() == 100) {
-                    for (const auto& s : bumpedSlices) {
-                        WriteBumpedSlice(s.second, s.first);
-                    }
-                    bumpedSlices.clear();
-                }
-            }
+        auto bumpOpacity = bumpMask.at<uint16_t>(pixel.y, pixel.x) / MAX_16BPC;
+        voxelsByZ[z].push_back({x, y, bumpOpacity * bumpVal});
+    }
 
-            // Get the slice image for this PPM mapping
-            currentZ = z;
-            currentSlice = volume->getSliceDataCopy(currentZ);
+    // Only slices with mapped voxels are written
+    std::vector<int> bumpedZ;
+    for (int z = 0; z < volume->numSlices(); z++) {
+        if (!voxelsByZ[z].empty()) {
+            bumpedZ.push_back(z);
         }
-
-        // Use the bump mask as an opacity function on the bumpVal
-        auto bumpOpacity = bumpMask.at<uint16_t>(pixel.y, pixel.x) / MAX_16BPC;
-        auto bumped = currentSlice.at<uint16_t>(y, x) + bumpOpacity * bumpVal;
-        currentSlice.at<uint16_t>(y, x) =
-            static_cast<uint16_t>(std::min(bumped, MAX_16BPC));
     }
 
-    // Write the last slice image
-    WriteBumpedSlice(currentSlice, currentZ);
+    // Bump and write the slices in parallel. Each worker writes its own
+    // slices as soon as they are bumped, so encoding and writing overlap
+    // with the other workers' bumping.
+    vc::ParallelChunks(bumpedZ.size(), 0, [&](auto begin, auto end) {
+        for (auto i = begin; i < end; i++) {
+            auto z = bumpedZ[i];
+            auto slice = volume->getSliceDataCopy(z);
+            for (const auto& v : voxelsByZ[z]) {
+                auto bumped = slice.at<uint16_t>(v.y, v.x) + v.bump;
+                slice.at<uint16_t>(v.y, v.x) =
+                    static_cast<uint16_t>(std::min(bumped, MAX_16BPC));
+            }
+            WriteBumpedSlice(slice, z);
+
+            // Release the bucket
+            std::vector<BumpedVoxel>().swap(voxelsByZ[z]);
+        }
+    });
 }
 
 void WriteBumpedSlice(const cv::Mat& slice, int index)